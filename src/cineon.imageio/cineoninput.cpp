@@ -25,6 +25,8 @@ public:
     bool close() override;
     bool read_native_scanline(int subimage, int miplevel, int y, int z,
                               void* data) override;
+    bool read_native_scanlines(int subimage, int miplevel, int ybegin,
+                               int yend, int z, void* data) override;
 
 private:
     InStream* m_stream = nullptr;
@@ -368,14 +370,24 @@ CineonInput::close()
 
 
 bool
-CineonInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
+CineonInput::read_native_scanline(int subimage, int miplevel, int y, int z,
                                   void* data)
+{
+    return read_native_scanlines(subimage, miplevel, y, y + 1, z, data);
+}
+
+
+
+bool
+CineonInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
+                                   int yend, int /*z*/, void* data)
 {
     lock_guard lock(*this);
     if (!seek_subimage(subimage, miplevel))
         return false;
 
-    cineon::Block block(0, y, m_cin.header.Width() - 1, y);
+    cineon::Block block(0, ybegin, m_cin.header.Width() - 1, yend - 1);
+    m_cin.SetThreads(threads());
 
     // FIXME: un-hardcode the channel from 0
     if (!m_cin.ReadBlock(data, m_cin.header.ComponentDataSize(0), block))
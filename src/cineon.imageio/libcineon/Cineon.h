@@ -248,12 +248,20 @@ namespace cineon
 		 */
 		bool ReadUserData(unsigned char *data);
 
+		/*!
+		 * \brief Set the number of threads used to unpack 10-bit image data
+		 *
+		 * \param n number of threads, 0 to use all of them
+		 */
+		void SetThreads(const int n) { this->threads = n; }
+
 
 	protected:
 		InStream *fd;
 
 		Codec *codec;
 		ElementReadStream *rio;
+		int threads;
 	};
 
 
@@ -36,6 +36,9 @@
 #include <cstring>
 #include <ctime>
 #include <cassert>
+#include <vector>
+
+#include <OpenImageIO/parallel.h>
 
 #include "Cineon.h"
 #include "EndianSwap.h"
@@ -44,7 +47,7 @@
 #include "Codec.h"
 
 
-cineon::Reader::Reader() : fd(0), rio(0)
+cineon::Reader::Reader() : fd(0), rio(0), threads(0)
 {
 	// initialize all of the Codec* to NULL
 	this->codec = 0;
@@ -106,6 +109,47 @@ bool cineon::Reader::ReadImage(void *data, const DataSize size)
 
 */
 
+// read whole lines of 10-bit longword filled data in one go, and unpack them a band
+// of lines at a time in parallel
+static bool Read10bitFilledLines(const cineon::Header &header, cineon::InStream *fd, const cineon::Block &block,
+	cineon::U16 *data, const int threads)
+{
+	const int datums = header.Width() * header.NumberOfElements();
+	const int height = block.y2 - block.y1 + 1;
+
+	// line length in words, and from one line to the next with the end of line padding
+	const size_t words = (datums + 2) / 3;
+	const size_t stride = words + header.EndOfLinePadding() / sizeof(cineon::U32);
+
+	const int paddingBits = (header.ImagePacking() == cineon::kLongWordLeft ?
+		PADDINGBITS_10BITFILLEDMETHODA : PADDINGBITS_10BITFILLEDMETHODB);
+
+	// seek to the beginning of the image block
+	if (fd->Seek(header.ImageOffset() + block.y1 * stride * sizeof(cineon::U32), cineon::InStream::kStart) == false)
+		return false;
+
+	std::vector<cineon::U32> buf(stride * (height - 1) + words);
+	const size_t bufByteSize = buf.size() * sizeof(cineon::U32);
+	if (fd->ReadDirect(buf.data(), bufByteSize) != bufByteSize)
+		return false;
+
+	const bool swap = header.RequiresByteSwap();
+	OIIO::parallel_for_chunked(0, height, 0, [&](int64_t ybegin, int64_t yend)
+	{
+		for (int64_t line = ybegin; line < yend; line++)
+		{
+			cineon::U32 *src = buf.data() + line * stride;
+			if (swap)
+				cineon::EndianSwapImageBuffer<cineon::kInt>(src, int(words));
+			cineon::Unpack10bitFilledLine(src, data + line * datums, datums, paddingBits);
+		}
+	}, OIIO::paropt(threads, OIIO::paropt::SplitDir::Y, 8));
+
+	return true;
+}
+
+
+
 bool cineon::Reader::ReadBlock(void *data, const DataSize size, Block &block)
 {
 	int i;
@@ -161,6 +205,14 @@ bool cineon::Reader::ReadBlock(void *data, const DataSize size, Block &block)
 		return true;
 	}
 
+	// 10-bit longword filled data is read in one go too, and unpacked in parallel
+	const Packing packing = this->header.ImagePacking();
+	if (consistentDepth && consistentWidth && bitDepth == 10 && size == cineon::kWord &&
+		(packing == kLongWordLeft || packing == kLongWordRight) &&
+		this->header.EndOfLinePadding() % sizeof(U32) == 0 &&
+		block.x1 == 0 && block.x2 == (int)(this->header.Width()-1))
+		return Read10bitFilledLines(this->header, this->fd, block, reinterpret_cast<U16 *>(data), this->threads);
+
 
 	// determine if the encoding system is loaded
 	if (this->codec == 0)
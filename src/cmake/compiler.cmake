@@ -361,6 +361,16 @@ if (NOT USE_SIMD STREQUAL "")
     add_compile_options (${SIMD_COMPILE_FLAGS})
 endif ()
 
+# SIMD_DISPATCH additionally compiles the hot kernels marked with
+# OIIO_SIMD_DISPATCH_CLONES (pixel value conversion, resize, texture
+# sampling) for AVX2 and AVX-512, choosing the best that the CPU supports
+# when the library is loaded. It needs GCC 12 or newer on x86_64 Linux,
+# and is ignored elsewhere.
+option (SIMD_DISPATCH "Also compile hot kernels for newer CPUs than USE_SIMD, chosen at runtime" ON)
+if (NOT SIMD_DISPATCH)
+    add_compile_definitions (OIIO_SIMD_DISPATCH=0)
+endif ()
+
 
 ###########################################################################
 # Preparation to test for compiler/language features
@@ -4,6 +4,8 @@
 
 
 set_option (OIIO_USE_CUDA "Include Cuda support if found" OFF)
+set_option (OIIO_CUDA_IBA_EXPERIMENTAL
+            "Run some IBA pixel math with Cuda (experimental, untested)" OFF)
 set_cache (CUDA_TARGET_ARCH "sm_60" "CUDA GPU architecture (e.g. sm_60)")
 set_cache (CUDAToolkit_ROOT "" "Path to CUDA toolkit")
 
@@ -20,6 +22,16 @@ if (OIIO_USE_CUDA)
     if (CUDAToolkit_FOUND)
         add_compile_definitions (OIIO_USE_CUDA=1)
     endif ()
+    if (CUDAToolkit_FOUND AND OIIO_CUDA_IBA_EXPERIMENTAL)
+        # For the IBA kernels in libOpenImageIO/imagebufalgo_cuda.cu
+        add_compile_definitions (OIIO_CUDA_IBA_EXPERIMENTAL=1)
+        if (NOT CMAKE_CUDA_ARCHITECTURES)
+            string (REGEX REPLACE "^sm_" "" CMAKE_CUDA_ARCHITECTURES
+                    "${CUDA_TARGET_ARCH}")
+        endif ()
+        set (CMAKE_CUDA_STANDARD ${CMAKE_CXX_STANDARD})
+        enable_language (CUDA)
+    endif ()
 endif ()
 
 
@@ -125,6 +125,16 @@ endif ()
 # Dependencies for optional formats and features. If these are not found,
 # we will continue building, but the related functionality will be disabled.
 
+# libdeflate, for faster whole-buffer decompression of zip/deflate data
+checked_find_package (libdeflate CONFIG
+                      VERSION_MIN 1.18
+                      DEFINITIONS USE_LIBDEFLATE=1)
+if (TARGET libdeflate::libdeflate_shared)
+    alias_library_if_not_exists (Deflate::Deflate libdeflate::libdeflate_shared)
+elseif (TARGET libdeflate::libdeflate_static)
+    alias_library_if_not_exists (Deflate::Deflate libdeflate::libdeflate_static)
+endif ()
+
 checked_find_package (PNG VERSION_MIN 1.6.0)
 if (TARGET PNG::png_static)
     set (PNG_TARGET PNG::png_static)
@@ -176,6 +186,9 @@ checked_find_package (OpenJPEG VERSION_MIN 2.0
 # Note: Recent OpenJPEG versions have exported cmake configs, but we don't
 # find them reliable at all, so we stick to our FindOpenJPEG.cmake module.
 
+# OpenJPH is used by the jpeg2000 plugin for HTJ2K codestreams
+checked_find_package (openjph CONFIG VERSION_MIN 0.18)
+
 checked_find_package (OpenVDB
                       VERSION_MIN  9.0
                       DEPS         TBB
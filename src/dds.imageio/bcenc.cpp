@@ -0,0 +1,519 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+/// \file
+/// BCn block compression (BC1, BC3, BC4, BC5 and BC7) for the DDS writer.
+///
+/// Each block's colors are fit with a line: the endpoints are where the
+/// pixels, projected onto their principal axis, begin and end. Then each
+/// pixel takes the nearest entry of the palette the quantized endpoints
+/// decode to, and the endpoints are refit by least squares to those
+/// choices, keeping whichever of the two encodings is closer. BC7 blocks
+/// are all written in mode 6 (one RGBA subset with 4-bit indices), which
+/// is the mode that a single line fits.
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
+#include <OpenImageIO/simd.h>
+
+#include "dds_pvt.h"
+
+OIIO_PLUGIN_NAMESPACE_BEGIN
+
+namespace DDS_pvt {
+
+using simd::vfloat4;
+
+namespace {
+
+constexpr int kBlockSize = 4;
+constexpr int kBlockPixels = kBlockSize * kBlockSize;
+
+
+// Up to 16 palette colors, kept four entries to a vfloat4 per channel, so
+// that the distances from a pixel to four entries are found together.
+struct Palette {
+    vfloat4 ch[4][4];  // [group of four entries][channel]
+    int ngroups;
+
+    explicit Palette(int n)
+        : ngroups((n + 3) / 4)
+    {
+        // Unused entries are too far away to ever be nearest
+        for (auto& group : ch)
+            for (auto& c : group)
+                c = vfloat4(1.0e6f);
+    }
+
+    void set(int i, const vfloat4& color)
+    {
+        for (int c = 0; c < 4; ++c)
+            ch[i / 4][c][i % 4] = color[c];
+    }
+
+    // Return the index of the entry nearest to p, and add its squared
+    // distance to err.
+    int nearest(const vfloat4& p, float& err) const
+    {
+        vfloat4 r(p[0]), g(p[1]), b(p[2]), a(p[3]);
+        float best = std::numeric_limits<float>::max();
+        int index  = 0;
+        for (int group = 0; group < ngroups; ++group) {
+            vfloat4 dr = ch[group][0] - r, dg = ch[group][1] - g;
+            vfloat4 db = ch[group][2] - b, da = ch[group][3] - a;
+            vfloat4 d  = dr * dr + dg * dg + db * db + da * da;
+            for (int i = 0; i < 4; ++i) {
+                if (d[i] < best) {
+                    best  = d[i];
+                    index = group * 4 + i;
+                }
+            }
+        }
+        err += best;
+        return index;
+    }
+};
+
+
+
+// Find the ends lo and hi of the segment of the principal axis of the n
+// pixels px that their projections onto it cover.
+void
+FitLine(const vfloat4* px, int n, vfloat4& lo, vfloat4& hi)
+{
+    vfloat4 mean = px[0];
+    for (int i = 1; i < n; ++i)
+        mean += px[i];
+    mean *= 1.0f / float(n);
+    vfloat4 cov[4] = { vfloat4::Zero(), vfloat4::Zero(), vfloat4::Zero(),
+                       vfloat4::Zero() };
+    for (int i = 0; i < n; ++i) {
+        vfloat4 d = px[i] - mean;
+        cov[0] += d * simd::shuffle<0>(d);
+        cov[1] += d * simd::shuffle<1>(d);
+        cov[2] += d * simd::shuffle<2>(d);
+        cov[3] += d * simd::shuffle<3>(d);
+    }
+
+    // Power iteration, from the column of the channel that varies most
+    int c = 0;
+    for (int i = 1; i < 4; ++i)
+        if (cov[i][i] > cov[c][c])
+            c = i;
+    lo = hi = mean;
+    if (!(cov[c][c] > 0.0f))
+        return;  // All the pixels are the same
+    vfloat4 axis = cov[c];
+    for (int iter = 0; iter < 8; ++iter) {
+        vfloat4 next = cov[0] * simd::shuffle<0>(axis)
+                       + cov[1] * simd::shuffle<1>(axis)
+                       + cov[2] * simd::shuffle<2>(axis)
+                       + cov[3] * simd::shuffle<3>(axis);
+        float m = std::max(std::max(std::abs(next[0]), std::abs(next[1])),
+                           std::max(std::abs(next[2]), std::abs(next[3])));
+        if (!(m > 0.0f))
+            break;
+        axis = next * (1.0f / m);
+    }
+    float len2 = simd::dot(axis, axis);
+    float tmin = std::numeric_limits<float>::max(), tmax = -tmin;
+    for (int i = 0; i < n; ++i) {
+        float t = simd::dot(px[i] - mean, axis);
+        tmin    = std::min(tmin, t);
+        tmax    = std::max(tmax, t);
+    }
+    lo = mean + axis * (tmin / len2);
+    hi = mean + axis * (tmax / len2);
+}
+
+
+
+// Refit the endpoints e0 and e1 to the n pixels px, each of which is to be
+// reproduced as the blend (1 - t) * e0 + t * e1, in the least-squares
+// sense. Return false, leaving them alone, if the blends don't determine
+// them (e.g., every pixel has the same t).
+bool
+RefitLine(const vfloat4* px, const float* t, int n, vfloat4& e0, vfloat4& e1)
+{
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    vfloat4 ax = vfloat4::Zero(), bx = vfloat4::Zero();
+    for (int i = 0; i < n; ++i) {
+        float a = 1.0f - t[i], b = t[i];
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        ax += px[i] * a;
+        bx += px[i] * b;
+    }
+    float det = aa * bb - ab * ab;
+    if (!(std::abs(det) > 1.0e-6f))
+        return false;
+    float invdet = 1.0f / det;
+    e0           = (ax * bb - bx * ab) * invdet;
+    e1           = (bx * aa - ax * ab) * invdet;
+    return true;
+}
+
+
+
+inline int
+Quantize(float v, int maxval)
+{
+    return std::min(std::max(int(v * maxval / 255.0f + 0.5f), 0), maxval);
+}
+
+
+
+//
+// BC1 (and the color half of BC3)
+//
+
+inline uint16_t
+Pack565(const vfloat4& c)
+{
+    return uint16_t(Quantize(c[0], 31) << 11 | Quantize(c[1], 63) << 5
+                    | Quantize(c[2], 31));
+}
+
+
+
+// The color a 565 endpoint decodes to, as bcdec expands it
+inline void
+Unpack565(uint16_t c, int rgb[3])
+{
+    rgb[0] = (((c >> 11) & 0x1f) * 527 + 23) >> 6;
+    rgb[1] = (((c >> 5) & 0x3f) * 259 + 33) >> 6;
+    rgb[2] = ((c & 0x1f) * 527 + 23) >> 6;
+}
+
+
+
+// The palette of a color block with endpoints c0 and c1, as decoded in
+// four-color mode (c2 and c3 are the 1/3 and 2/3 blends) or three-color
+// mode (c2 is the midpoint, c3 is transparent and not in the palette).
+Palette
+ColorPalette(uint16_t c0, uint16_t c1, bool threecolor, float t[4])
+{
+    int e0[3], e1[3];
+    Unpack565(c0, e0);
+    Unpack565(c1, e1);
+    Palette pal(threecolor ? 3 : 4);
+    pal.set(0, vfloat4(float(e0[0]), float(e0[1]), float(e0[2]), 0.0f));
+    pal.set(1, vfloat4(float(e1[0]), float(e1[1]), float(e1[2]), 0.0f));
+    int c2[3], c3[3];
+    for (int c = 0; c < 3; ++c) {
+        if (threecolor) {
+            c2[c] = (e0[c] + e1[c] + 1) >> 1;
+        } else {
+            c2[c] = (2 * e0[c] + e1[c] + 1) / 3;
+            c3[c] = (e0[c] + 2 * e1[c] + 1) / 3;
+        }
+    }
+    pal.set(2, vfloat4(float(c2[0]), float(c2[1]), float(c2[2]), 0.0f));
+    if (!threecolor)
+        pal.set(3, vfloat4(float(c3[0]), float(c3[1]), float(c3[2]), 0.0f));
+    t[0] = 0.0f;
+    t[1] = 1.0f;
+    t[2] = threecolor ? 0.5f : 1.0f / 3.0f;
+    t[3] = 2.0f / 3.0f;
+    return pal;
+}
+
+
+
+// Encode a color block of 16 RGBA pixels. If punchthrough is true, pixels
+// with alpha below 128 are made transparent; otherwise alpha is ignored.
+void
+EncodeColorBlock(const uint8_t* rgba, uint8_t* block, bool punchthrough)
+{
+    vfloat4 px[kBlockPixels];
+    int opaque[kBlockPixels];
+    int n = 0;
+    for (int i = 0; i < kBlockPixels; ++i) {
+        if (punchthrough && rgba[i * 4 + 3] < 128)
+            continue;
+        px[n] = vfloat4(float(rgba[i * 4 + 0]), float(rgba[i * 4 + 1]),
+                        float(rgba[i * 4 + 2]), 0.0f);
+        opaque[n++] = i;
+    }
+    const bool threecolor = n < kBlockPixels;
+
+    uint16_t c0 = 0, c1 = 0;
+    uint8_t index[kBlockPixels] = {};
+    if (n) {
+        vfloat4 e0, e1;
+        FitLine(px, n, e0, e1);
+        float besterr = std::numeric_limits<float>::max();
+        for (int pass = 0; pass < 2; ++pass) {
+            uint16_t q0 = Pack565(e0), q1 = Pack565(e1);
+            float t[4], err = 0.0f, pt[kBlockPixels];
+            uint8_t idx[kBlockPixels];
+            Palette pal = ColorPalette(q0, q1, threecolor, t);
+            for (int i = 0; i < n; ++i) {
+                idx[i] = uint8_t(pal.nearest(px[i], err));
+                pt[i]  = t[idx[i]];
+            }
+            if (err < besterr) {
+                besterr = err;
+                c0      = q0;
+                c1      = q1;
+                std::copy(idx, idx + n, index);
+            }
+            if (!RefitLine(px, pt, n, e0, e1))
+                break;
+        }
+    }
+
+    // The order of the endpoints selects the mode: c0 > c1 for four
+    // colors, c0 <= c1 for three colors and transparent.
+    uint32_t bits = threecolor ? 0xffffffffu : 0u;  // transparent is 3
+    if ((c0 < c1 && !threecolor) || (c0 > c1 && threecolor)) {
+        std::swap(c0, c1);
+        for (int i = 0; i < n; ++i)
+            index[i] ^= threecolor ? (index[i] < 2) : 1;
+    }
+    for (int i = 0; i < n; ++i) {
+        int shift = 2 * opaque[i];
+        // With c0 == c1, decoding is in three-color mode, but 0 is c0.
+        uint32_t v = c0 == c1 ? 0u : index[i];
+        bits       = (bits & ~(3u << shift)) | (v << shift);
+    }
+    uint8_t out[8] = { uint8_t(c0),         uint8_t(c0 >> 8),
+                       uint8_t(c1),         uint8_t(c1 >> 8),
+                       uint8_t(bits),       uint8_t(bits >> 8),
+                       uint8_t(bits >> 16), uint8_t(bits >> 24) };
+    memcpy(block, out, 8);
+}
+
+
+
+//
+// BC4 (and the alpha half of BC3, and each half of BC5)
+//
+
+// Encode the 16 values found every `stride` bytes from `values`. The
+// endpoints are the extremes, in the eight-value mode.
+void
+EncodeValueBlock(const uint8_t* values, int stride, uint8_t* block)
+{
+    uint8_t lo = 255, hi = 0;
+    for (int i = 0; i < kBlockPixels; ++i) {
+        lo = std::min(lo, values[i * stride]);
+        hi = std::max(hi, values[i * stride]);
+    }
+    uint64_t bits = uint64_t(hi) | uint64_t(lo) << 8;
+    if (hi > lo) {
+        Palette pal(8);
+        pal.set(0, vfloat4(float(hi), 0.0f, 0.0f, 0.0f));
+        pal.set(1, vfloat4(float(lo), 0.0f, 0.0f, 0.0f));
+        for (int i = 1; i < 7; ++i)
+            pal.set(i + 1, vfloat4(float(((7 - i) * hi + i * lo + 1) / 7),
+                                   0.0f, 0.0f, 0.0f));
+        float err = 0.0f;
+        for (int i = 0; i < kBlockPixels; ++i) {
+            vfloat4 v(float(values[i * stride]), 0.0f, 0.0f, 0.0f);
+            bits |= uint64_t(pal.nearest(v, err)) << (16 + 3 * i);
+        }
+    }
+    // With hi == lo, every index is 0, which is hi in either mode.
+    for (int i = 0; i < 8; ++i)
+        block[i] = uint8_t(bits >> (8 * i));
+}
+
+
+
+//
+// BC7, mode 6
+//
+
+constexpr int kBC7Weights[16] = { 0,  4,  9,  13, 17, 21, 26, 30,
+                                  34, 38, 43, 47, 51, 55, 60, 64 };
+
+
+// Quantize an endpoint to 7 bits per channel and a shared low bit p,
+// choosing the p that comes closer (or p = 1, if alpha must stay 255).
+void
+QuantizeBC7(const vfloat4& e, bool opaque, int q[4], int& p)
+{
+    float besterr = std::numeric_limits<float>::max();
+    for (int pbit = opaque ? 1 : 0; pbit < 2; ++pbit) {
+        int qq[4];
+        float err = 0.0f;
+        for (int c = 0; c < 4; ++c) {
+            qq[c]   = std::min(std::max(int((e[c] - pbit) * 0.5f + 0.5f), 0),
+                               127);
+            float d = float(qq[c] << 1 | pbit) - e[c];
+            err += d * d;
+        }
+        if (opaque)
+            qq[3] = 127;
+        if (err < besterr) {
+            besterr = err;
+            p       = pbit;
+            std::copy(qq, qq + 4, q);
+        }
+    }
+}
+
+
+
+// Accumulates the bits of a block, least significant first
+struct BitWriter {
+    uint64_t bits[2] = { 0, 0 };
+    int pos          = 0;
+
+    void put(uint32_t value, int nbits)
+    {
+        for (int i = 0; i < nbits; ++i, ++pos)
+            bits[pos / 64] |= uint64_t((value >> i) & 1) << (pos % 64);
+    }
+};
+
+
+
+void
+EncodeBC7Block(const uint8_t* rgba, uint8_t* block)
+{
+    vfloat4 px[kBlockPixels];
+    bool opaque = true;
+    for (int i = 0; i < kBlockPixels; ++i) {
+        px[i] = vfloat4(float(rgba[i * 4 + 0]), float(rgba[i * 4 + 1]),
+                        float(rgba[i * 4 + 2]), float(rgba[i * 4 + 3]));
+        opaque &= rgba[i * 4 + 3] == 255;
+    }
+
+    vfloat4 e[2];
+    FitLine(px, kBlockPixels, e[0], e[1]);
+    int q[2][4] = {}, p[2] = {};
+    uint8_t index[kBlockPixels] = {};
+    float besterr = std::numeric_limits<float>::max();
+    for (int pass = 0; pass < 2; ++pass) {
+        int qq[2][4], pp[2];
+        vfloat4 v[2];
+        for (int j = 0; j < 2; ++j) {
+            QuantizeBC7(e[j], opaque, qq[j], pp[j]);
+            v[j] = vfloat4(float(qq[j][0] << 1 | pp[j]),
+                           float(qq[j][1] << 1 | pp[j]),
+                           float(qq[j][2] << 1 | pp[j]),
+                           float(qq[j][3] << 1 | pp[j]));
+        }
+        Palette pal(16);
+        for (int k = 0; k < 16; ++k) {
+            int w = kBC7Weights[k];
+            vfloat4 c;
+            for (int ch = 0; ch < 4; ++ch)
+                c[ch] = float(
+                    (int((64 - w) * v[0][ch] + w * v[1][ch]) + 32) >> 6);
+            pal.set(k, c);
+        }
+        float err = 0.0f, pt[kBlockPixels];
+        uint8_t idx[kBlockPixels];
+        for (int i = 0; i < kBlockPixels; ++i) {
+            idx[i] = uint8_t(pal.nearest(px[i], err));
+            pt[i]  = kBC7Weights[idx[i]] / 64.0f;
+        }
+        if (err < besterr) {
+            besterr = err;
+            memcpy(q, qq, sizeof(q));
+            memcpy(p, pp, sizeof(p));
+            memcpy(index, idx, sizeof(index));
+        }
+        if (!RefitLine(px, pt, kBlockPixels, e[0], e[1]))
+            break;
+    }
+
+    // The first pixel's index is stored without its high bit, which must
+    // be zero; since the weights are symmetric, swapping the endpoints
+    // and reversing the indices makes it so.
+    if (index[0] >= 8) {
+        std::swap(q[0], q[1]);
+        std::swap(p[0], p[1]);
+        for (auto& i : index)
+            i = uint8_t(15 - i);
+    }
+    BitWriter bw;
+    bw.put(1 << 6, 7);  // mode 6
+    for (int ch = 0; ch < 4; ++ch) {
+        bw.put(q[0][ch], 7);
+        bw.put(q[1][ch], 7);
+    }
+    bw.put(p[0], 1);
+    bw.put(p[1], 1);
+    bw.put(index[0], 3);
+    for (int i = 1; i < kBlockPixels; ++i)
+        bw.put(index[i], 4);
+    for (int i = 0; i < 16; ++i)
+        block[i] = uint8_t(bw.bits[i / 8] >> (8 * (i % 8)));
+}
+
+}  // namespace
+
+
+
+void
+CompressImage(const uint8_t* pixels, int width, int height, uint8_t* blocks,
+              Compression cmp, int nthreads)
+{
+    const int channelCount = cmp == Compression::BC4   ? 1
+                             : cmp == Compression::BC5 ? 2
+                                                       : 4;
+    const size_t blockSize = cmp == Compression::DXT1
+                                     || cmp == Compression::BC4
+                                 ? 8
+                                 : 16;
+    const int widthInBlocks  = (width + kBlockSize - 1) / kBlockSize;
+    const int heightInBlocks = (height + kBlockSize - 1) / kBlockSize;
+    parallel_for_chunked(
+        0, heightInBlocks, 0,
+        [&](int64_t ybb, int64_t ybe) {
+            uint8_t src[kBlockPixels * 4];
+            uint8_t* dstBlocks = blocks + ybb * widthInBlocks * blockSize;
+            for (int by = int(ybb); by < int(ybe); ++by) {
+                for (int bx = 0; bx < widthInBlocks; ++bx) {
+                    // Gather the block, repeating the last row and column
+                    // of the image to fill out partial blocks.
+                    for (int py = 0; py < kBlockSize; ++py) {
+                        int y = std::min(by * kBlockSize + py, height - 1);
+                        for (int px = 0; px < kBlockSize; ++px) {
+                            int x = std::min(bx * kBlockSize + px, width - 1);
+                            memcpy(src + (py * kBlockSize + px) * channelCount,
+                                   pixels
+                                       + (size_t(y) * width + x) * channelCount,
+                                   channelCount);
+                        }
+                    }
+                    switch (cmp) {
+                    case Compression::DXT1:
+                        EncodeColorBlock(src, dstBlocks, true);
+                        break;
+                    case Compression::DXT5:
+                        EncodeValueBlock(src + 3, 4, dstBlocks);
+                        EncodeColorBlock(src, dstBlocks + 8, false);
+                        break;
+                    case Compression::BC4:
+                        EncodeValueBlock(src, 1, dstBlocks);
+                        break;
+                    case Compression::BC5:
+                        EncodeValueBlock(src, 2, dstBlocks);
+                        EncodeValueBlock(src + 1, 2, dstBlocks + 8);
+                        break;
+                    case Compression::BC7:
+                        EncodeBC7Block(src, dstBlocks);
+                        break;
+                    default: memset(dstBlocks, 0, blockSize); break;
+                    }
+                    dstBlocks += blockSize;
+                }
+            }
+        },
+        paropt(nthreads, paropt::SplitDir::Y, 8));
+}
+
+}  // namespace DDS_pvt
+
+OIIO_PLUGIN_NAMESPACE_END
@@ -154,6 +154,13 @@ typedef struct {
 } dds_header_dx10;
 
 
+/// Compress a `width` x `height` image into BCn blocks of type `cmp`
+/// (DXT1, DXT5, BC4, BC5 or BC7), in parallel over rows of blocks. The
+/// pixels are uint8 with 1 channel for BC4, 2 for BC5, and RGBA otherwise.
+void
+CompressImage(const uint8_t* pixels, int width, int height, uint8_t* blocks,
+              Compression cmp, int nthreads);
+
 }  // namespace DDS_pvt
 
 
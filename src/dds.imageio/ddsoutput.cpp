@@ -0,0 +1,366 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <OpenImageIO/color.h>
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/fmath.h>
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/strutil.h>
+
+#include "dds_pvt.h"
+
+OIIO_PLUGIN_NAMESPACE_BEGIN
+
+using namespace DDS_pvt;
+
+
+class DDSOutput final : public ImageOutput {
+public:
+    DDSOutput() { init(); }
+    ~DDSOutput() override { close(); }
+    const char* format_name(void) const override { return "dds"; }
+    int supports(string_view feature) const override;
+    bool open(const std::string& name, const ImageSpec& spec,
+              OpenMode mode) override;
+    bool close() override;
+    bool write_scanline(int y, int z, TypeDesc format, const void* data,
+                        stride_t xstride) override;
+    bool write_tile(int x, int y, int z, TypeDesc format, const void* data,
+                    stride_t xstride, stride_t ystride,
+                    stride_t zstride) override;
+
+private:
+    std::string m_filename;
+    Compression m_compression;
+    bool m_srgb;
+    int m_nlevels;  ///< MIP levels opened so far
+    int m_width0, m_height0;  ///< The size of the first level
+    unsigned int m_dither;
+    std::vector<unsigned char> m_buf;  ///< The pixels of the current level
+    std::vector<unsigned char> m_scratch;
+
+    void init(void)
+    {
+        m_filename.clear();
+        m_compression = Compression::None;
+        m_srgb        = false;
+        m_nlevels     = 0;
+        m_width0      = 0;
+        m_height0     = 0;
+        m_dither      = 0;
+        m_buf.clear();
+        ioproxy_clear();
+    }
+
+    /// Write the header, saying there are `m_nlevels` MIP levels.
+    bool write_header();
+
+    /// The size in the file of a level of the given dimensions.
+    size_t level_bytes(int width, int height) const;
+
+    /// Compress (if needed) and write the buffered level.
+    bool write_level();
+};
+
+
+
+// Obligatory material to make this a recognizable imageio plugin
+OIIO_PLUGIN_EXPORTS_BEGIN
+
+OIIO_EXPORT ImageOutput*
+dds_output_imageio_create()
+{
+    return new DDSOutput;
+}
+
+OIIO_EXPORT const char* dds_output_extensions[] = { "dds", nullptr };
+
+OIIO_PLUGIN_EXPORTS_END
+
+
+
+int
+DDSOutput::supports(string_view feature) const
+{
+    return (feature == "alpha" || feature == "ioproxy" || feature == "mipmap"
+            || feature == "tiles");
+}
+
+
+
+bool
+DDSOutput::open(const std::string& name, const ImageSpec& spec, OpenMode mode)
+{
+    if (mode == AppendMIPLevel) {
+        if (!ioproxy_opened()) {
+            errorfmt("Cannot append a MIP level if no file has been opened");
+            return false;
+        }
+        // Each level is half the size of the one before, rounded down
+        int w = std::max(m_spec.width / 2, 1);
+        int h = std::max(m_spec.height / 2, 1);
+        if (spec.width != w || spec.height != h
+            || spec.nchannels != m_spec.nchannels) {
+            errorfmt("DDS MIP level {} must be {}x{} with {} channels",
+                     m_nlevels, w, h, m_spec.nchannels);
+            return false;
+        }
+        if (!write_level())
+            return false;
+        m_spec.width = m_spec.full_width = w;
+        m_spec.height = m_spec.full_height = h;
+        m_spec.tile_width                  = spec.tile_width;
+        m_spec.tile_height                 = spec.tile_height;
+        ++m_nlevels;
+        m_buf.assign(m_spec.image_bytes(), 0);
+        return true;
+    }
+
+    if (!check_open(mode, spec, { 0, 65535, 0, 65535, 0, 1, 0, 4 }))
+        return false;
+
+    m_filename = name;
+    m_spec.set_format(TypeDesc::UINT8);
+    m_dither = m_spec.get_int_attribute("oiio:dither", 0);
+
+    std::string comp = Strutil::lower(
+        m_spec.decode_compression_metadata("none").first);
+    if (comp == "bc1" || comp == "dxt1")
+        m_compression = Compression::DXT1;
+    else if (comp == "bc3" || comp == "dxt5")
+        m_compression = Compression::DXT5;
+    else if (comp == "bc4" || comp == "ati1")
+        m_compression = Compression::BC4;
+    else if (comp == "bc5" || comp == "ati2")
+        m_compression = Compression::BC5;
+    else if (comp == "bc7")
+        m_compression = Compression::BC7;
+    else
+        m_compression = Compression::None;  // including BC2 and BC6H
+    string_view colorspace = m_spec.get_string_attribute("oiio:ColorSpace");
+    m_srgb = ColorConfig::default_colorconfig().equivalent(colorspace, "sRGB");
+
+    ioproxy_retrieve_from_config(m_spec);
+    if (!ioproxy_use_or_open(name))
+        return false;
+
+    m_nlevels = 1;
+    m_width0  = m_spec.width;
+    m_height0 = m_spec.height;
+    m_buf.assign(m_spec.image_bytes(), 0);
+    return write_header();
+}
+
+
+
+bool
+DDSOutput::write_header()
+{
+    dds_header dds;
+    dds_header_dx10 dx10;
+    memset(&dds, 0, sizeof(dds));
+    memset(&dx10, 0, sizeof(dx10));
+    dds.fourCC      = DDS_MAKE4CC('D', 'D', 'S', ' ');
+    dds.size        = 124;
+    dds.flags       = DDS_CAPS | DDS_HEIGHT | DDS_WIDTH | DDS_PIXELFORMAT;
+    dds.height      = m_height0;
+    dds.width       = m_width0;
+    dds.depth       = 1;
+    dds.fmt.size    = 32;
+    dds.caps.flags1 = DDS_CAPS1_TEXTURE;
+    if (m_nlevels > 1) {
+        dds.flags |= DDS_MIPMAPCOUNT;
+        dds.mipmaps = m_nlevels;
+        dds.caps.flags1 |= DDS_CAPS1_COMPLEX | DDS_CAPS1_MIPMAP;
+    }
+
+    bool dx10header = false;
+    if (m_compression == Compression::None) {
+        // Channels are stored in order, 8 bits each, with alpha (if any)
+        // in the second or fourth.
+        const int nchannels = m_spec.nchannels;
+        const int ncolor    = nchannels == 2 || nchannels == 4 ? nchannels - 1
+                                                               : nchannels;
+        dds.flags |= DDS_PITCH;
+        dds.pitch     = m_width0 * nchannels;
+        dds.fmt.bpp   = 8 * nchannels;
+        dds.fmt.flags = ncolor == 1 ? DDS_PF_LUMINANCE : DDS_PF_RGB;
+        for (int c = 0; c < ncolor; ++c)
+            dds.fmt.masks[c] = 0xffu << (8 * c);
+        if (ncolor < nchannels) {
+            dds.fmt.flags |= DDS_PF_ALPHA;
+            dds.fmt.masks[3] = 0xffu << (8 * ncolor);
+        }
+    } else {
+        dds.flags |= DDS_LINEARSIZE;
+        dds.pitch     = uint32_t(level_bytes(m_width0, m_height0));
+        dds.fmt.flags = DDS_PF_FOURCC;
+        // BC7, and the sRGB variants of BC1 and BC3, need the DX10 header.
+        switch (m_compression) {
+        case Compression::DXT1:
+            dds.fmt.fourCC  = DDS_4CC_DXT1;
+            dx10.dxgiFormat = m_srgb ? DDS_FORMAT_BC1_UNORM_SRGB
+                                     : DDS_FORMAT_BC1_UNORM;
+            dx10header      = m_srgb;
+            break;
+        case Compression::DXT5:
+            dds.fmt.fourCC  = DDS_4CC_DXT5;
+            dx10.dxgiFormat = m_srgb ? DDS_FORMAT_BC3_UNORM_SRGB
+                                     : DDS_FORMAT_BC3_UNORM;
+            dx10header      = m_srgb;
+            break;
+        case Compression::BC4: dds.fmt.fourCC = DDS_4CC_ATI1; break;
+        case Compression::BC5: dds.fmt.fourCC = DDS_4CC_ATI2; break;
+        default:
+            dx10.dxgiFormat = m_srgb ? DDS_FORMAT_BC7_UNORM_SRGB
+                                     : DDS_FORMAT_BC7_UNORM;
+            dx10header      = true;
+            break;
+        }
+        if (dx10header) {
+            dds.fmt.fourCC         = DDS_4CC_DX10;
+            dx10.resourceDimension = 3;  // 2D texture
+            dx10.arraySize         = 1;
+        }
+    }
+
+    if (bigendian()) {
+        // DDS files are little-endian; swap what the reader swaps back
+        swap_endian(&dds.size);
+        swap_endian(&dds.height);
+        swap_endian(&dds.width);
+        swap_endian(&dds.pitch);
+        swap_endian(&dds.depth);
+        swap_endian(&dds.mipmaps);
+        swap_endian(&dds.fmt.size);
+        swap_endian(&dds.fmt.bpp);
+    }
+    if (!ioseek(0) || !iowrite(&dds, sizeof(dds), 1))
+        return false;
+    return !dx10header || iowrite(&dx10, sizeof(dx10), 1);
+}
+
+
+
+size_t
+DDSOutput::level_bytes(int width, int height) const
+{
+    if (m_compression == Compression::None)
+        return size_t(width) * height * m_spec.nchannels;
+    size_t blockSize = m_compression == Compression::DXT1
+                               || m_compression == Compression::BC4
+                           ? 8
+                           : 16;
+    return size_t((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+
+
+bool
+DDSOutput::write_level()
+{
+    if (m_compression == Compression::None)
+        return iowrite(m_buf.data(), m_buf.size());
+
+    // Arrange the pixels as the encoder wants them: the first channel for
+    // BC4, the first two for BC5, and otherwise RGBA, expanding gray to
+    // RGB and filling in opaque alpha.
+    const int nchannels = m_spec.nchannels;
+    const int nout      = m_compression == Compression::BC4   ? 1
+                          : m_compression == Compression::BC5 ? 2
+                                                              : 4;
+    const size_t npixels = m_spec.image_pixels();
+    std::vector<unsigned char> pixels;
+    const unsigned char* src = m_buf.data();
+    if (nout != nchannels) {
+        pixels.resize(npixels * nout);
+        const bool grayalpha = nchannels == 2 && m_spec.alpha_channel == 1;
+        for (size_t i = 0; i < npixels; ++i) {
+            const unsigned char* in = src + i * nchannels;
+            unsigned char* out      = pixels.data() + i * nout;
+            if (nout < 4) {
+                for (int c = 0; c < nout; ++c)
+                    out[c] = c < nchannels ? in[c] : 0;
+            } else if (nchannels < 3) {
+                out[0] = out[1] = out[2] = in[0];
+                out[3] = grayalpha ? in[1] : 255;
+                if (nchannels == 2 && !grayalpha) {
+                    out[1] = in[1];
+                    out[2] = 0;
+                }
+            } else {
+                memcpy(out, in, 3);
+                out[3] = 255;
+            }
+        }
+        src = pixels.data();
+    }
+    std::vector<unsigned char> blocks(level_bytes(m_spec.width, m_spec.height));
+    CompressImage(src, m_spec.width, m_spec.height, blocks.data(),
+                  m_compression, threads());
+    return iowrite(blocks.data(), blocks.size());
+}
+
+
+
+bool
+DDSOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
+                          stride_t xstride)
+{
+    if (!ioproxy_opened()) {
+        errorfmt("write_scanline called but file is not open.");
+        return false;
+    }
+    if (y < m_spec.y || y >= m_spec.y + m_spec.height) {
+        errorfmt("Attempt to write scanline {} outside of the image", y);
+        return false;
+    }
+
+    m_scratch.clear();
+    data = to_native_scanline(format, data, xstride, m_scratch, m_dither, y, z);
+    memcpy(m_buf.data() + (y - m_spec.y) * m_spec.scanline_bytes(), data,
+           m_spec.scanline_bytes());
+    return true;
+}
+
+
+
+bool
+DDSOutput::write_tile(int x, int y, int z, TypeDesc format, const void* data,
+                      stride_t xstride, stride_t ystride, stride_t zstride)
+{
+    if (!ioproxy_opened()) {
+        errorfmt("write_tile called but file is not open.");
+        return false;
+    }
+
+    // Emulate tiles by buffering the whole level
+    return copy_tile_to_image_buffer(x, y, z, format, data, xstride, ystride,
+                                     zstride, m_buf.data());
+}
+
+
+
+bool
+DDSOutput::close()
+{
+    if (!ioproxy_opened()) {  // already closed
+        init();
+        return true;
+    }
+
+    // The header already written says there is one level; if more were
+    // added, rewrite it now that we know how many.
+    bool ok = write_level();
+    if (ok && m_nlevels > 1)
+        ok = write_header();
+    init();
+    return ok;
+}
+
+OIIO_PLUGIN_NAMESPACE_END
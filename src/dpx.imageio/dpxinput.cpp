@@ -591,6 +591,7 @@ DPXInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
 
     dpx::Block block(0, ybegin - m_spec.y, m_dpx.header.Width() - 1,
                      yend - 1 - m_spec.y);
+    m_dpx.SetThreads(threads());
 
     if (m_rawcolor) {
         // fast path - just read the scanline in
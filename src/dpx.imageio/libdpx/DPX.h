@@ -245,6 +245,13 @@ namespace dpx
 		 * \return success true/false
 		 */	
 		bool ReadUserData(unsigned char *data);
+
+		/*!
+		 * \brief Set the number of threads used to unpack 10-bit image data
+		 *
+		 * \param n number of threads, 0 to use all of them
+		 */
+		void SetThreads(const int n) { this->threads = n; }
 		
 
 	protected:			
@@ -252,6 +259,7 @@ namespace dpx
 		
 		Codec *codex[DPX_MAX_ELEMENTS];
 		ElementReadStream *rio;
+		int threads;
 	};
 	
 
@@ -410,10 +418,18 @@ namespace dpx
 		 */			
 		bool Finish();
 
+		/*!
+		 * \brief Set the number of threads used to pack 10-bit image data
+		 *
+		 * \param n number of threads, 0 to use all of them
+		 */
+		void SetThreads(const int n) { this->threads = n; }
+
 
 	protected:
 		long fileLoc;
 		OutStream *fd;
+		int threads;
 		
 		bool WriteThrough(void *, const U32, const U32, const int, const int, const U32, const U32, char *);
 		
@@ -35,6 +35,9 @@
 #include <cstdio>
 #include <cstring>
 #include <ctime>
+#include <vector>
+
+#include <OpenImageIO/parallel.h>
 
 #include "DPX.h"
 #include "EndianSwap.h"
@@ -45,7 +48,7 @@
 
 
 
-dpx::Reader::Reader() : fd(0), rio(0)
+dpx::Reader::Reader() : fd(0), rio(0), threads(0)
 {
 	// initialize all of the Codec* to NULL
 	for (int i = 0; i < DPX_MAX_ELEMENTS; i++)
@@ -102,6 +105,48 @@ bool dpx::Reader::ReadImage(const int element, void *data)
 
 
 
+// read whole lines of 10-bit filled method A/B data in one go, and unpack them a band
+// of lines at a time in parallel
+static bool Read10bitFilledLines(const dpx::Header &header, InStream *fd, const int element,
+	const dpx::Block &block, dpx::U16 *data, const int threads)
+{
+	const int numberOfComponents = header.ImageElementComponentCount(element);
+	const int datums = header.Width() * numberOfComponents;
+	const int height = block.y2 - block.y1 + 1;
+
+	// line length in words, and from one line to the next with the end of line padding
+	const size_t words = (datums + 2) / 3;
+	const size_t stride = words + header.EndOfLinePadding(element) / sizeof(dpx::U32);
+
+	const int paddingBits = (header.ImagePacking(element) == dpx::kFilledMethodA ?
+		PADDINGBITS_10BITFILLEDMETHODA : PADDINGBITS_10BITFILLEDMETHODB);
+
+	// seek to the beginning of the image block
+	if (fd->Seek(header.DataOffset(element) + block.y1 * stride * sizeof(dpx::U32), InStream::kStart) == false)
+		return false;
+
+	std::vector<dpx::U32> buf(stride * (height - 1) + words);
+	const size_t bufByteSize = buf.size() * sizeof(dpx::U32);
+	if (fd->ReadDirect(buf.data(), bufByteSize) != bufByteSize)
+		return false;
+
+	const bool swap = header.RequiresByteSwap();
+	OIIO::parallel_for_chunked(0, height, 0, [&](int64_t ybegin, int64_t yend)
+	{
+		for (int64_t line = ybegin; line < yend; line++)
+		{
+			dpx::U32 *src = buf.data() + line * stride;
+			if (swap)
+				dpx::EndianSwapImageBuffer<dpx::kInt>(src, int(words));
+			dpx::Unpack10bitFilledLine(src, data + line * datums, datums, paddingBits, numberOfComponents == 1);
+		}
+	}, OIIO::paropt(threads, OIIO::paropt::SplitDir::Y, 8));
+
+	return true;
+}
+
+
+
 /* 
     implementation notes:
 
@@ -160,6 +205,15 @@ bool dpx::Reader::ReadBlock(const int element, unsigned char *data, Block &block
         return true;
     }
 
+    // 10-bit filled words are read in one go too, and unpacked in parallel
+    const Packing packing = this->header.ImagePacking(element);
+    if (!rle && bitDepth == 10 && size == dpx::kWord &&
+        (packing == kFilledMethodA || packing == kFilledMethodB) &&
+        this->header.EndOfLinePadding(element) % sizeof(U32) == 0 &&
+        block.x1 == 0 && block.x2 == (int)(this->header.Width()-1))
+        return Read10bitFilledLines(this->header, this->fd, element, block,
+                                    reinterpret_cast<U16 *>(data), this->threads);
+
     // determine if the encoding system is loaded
     if (this->codex[element] == 0)
     {
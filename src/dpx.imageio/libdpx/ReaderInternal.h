@@ -60,6 +60,37 @@
 namespace dpx 
 {
 
+	// unpack one line of 10-bit filled method A/B words, three datums to a word, into 16 bits each
+	// the first datum of a word is its high one, except in 1-channel images where it is the low one
+	// whole words are unpacked without any per-datum division, so that the compiler can vectorize it
+	inline void Unpack10bitFilledLine(const U32 *src, U16 *dst, const int datums, const int paddingBits, const bool lowFirst)
+	{
+		const int shift0 = (lowFirst ? 0 : 20) + paddingBits;
+		const int shift1 = 10 + paddingBits;
+		const int shift2 = (lowFirst ? 20 : 0) + paddingBits;
+		const int words = datums / 3;
+
+		for (int w = 0; w < words; w++)
+		{
+			const U32 word = src[w];
+			const U16 d0 = U16((word >> shift0) & 0x3ff);
+			const U16 d1 = U16((word >> shift1) & 0x3ff);
+			const U16 d2 = U16((word >> shift2) & 0x3ff);
+			dst[3 * w] = U16((d0 << 6) | (d0 >> 4));
+			dst[3 * w + 1] = U16((d1 << 6) | (d1 >> 4));
+			dst[3 * w + 2] = U16((d2 << 6) | (d2 >> 4));
+		}
+
+		// the last word may be partly filled
+		const int shifts[3] = { shift0, shift1, shift2 };
+		for (int i = words * 3; i < datums; i++)
+		{
+			U16 d = U16((src[words] >> shifts[i - words * 3]) & 0x3ff);
+			BaseTypeConvertU10ToU16(d, dst[i]);
+		}
+	}
+
+
 	// this function is called when the DataSize is 10 bit and the packing method is kFilledMethodA or kFilledMethodB
 	template<typename BUF, int PADDINGBITS>
 	void Unfill10bitFilled(U32 *readBuf, const int x, BUF *data, int count, int bufoff, const int numberOfComponents)
@@ -46,7 +46,7 @@
 
 
 
-dpx::Writer::Writer() : fileLoc(0)
+dpx::Writer::Writer() : fileLoc(0), threads(0)
 {
 }
 
@@ -316,7 +316,9 @@ bool dpx::Writer::WriteElement(const int element, void *data, const DataSize siz
 			if (this->header.ImageDescriptor(element) == kRGB && this->header.DatumSwap(element) && bitDepth == 10)
 				reverse = true;
 
-			if (size == dpx::kWord)
+			if (!rle && size == dpx::kWord && (packing == kFilledMethodA || packing == kFilledMethodB))
+				this->fileLoc += Write10bitFilled(this->fd, reinterpret_cast<U16 *>(data), width, height, noc, packing, reverse, eolnPad, blank, status, this->header.RequiresByteSwap(), this->threads);
+			else if (size == dpx::kWord)
 				this->fileLoc += WriteBuffer<U16, 10, true>(this->fd, size, data, width, height, noc, packing, rle, reverse, eolnPad, blank, status, this->header.RequiresByteSwap());
 			else
 				this->fileLoc += WriteBuffer<U16, 10, false>(this->fd, size, data, width, height, noc, packing, rle, reverse, eolnPad, blank, status, this->header.RequiresByteSwap());
@@ -37,6 +37,10 @@
 #define _DPX_WRITERINTERNAL_H 1
 
 
+#include <vector>
+
+#include <OpenImageIO/parallel.h>
+
 #include "BaseTypeConverter.h"
 
 
@@ -257,6 +261,80 @@ namespace dpx
 	
 			
 	
+	// pack one line of 16-bit datums into 10-bit filled method A/B words, three datums to a word
+	// the first datum of a word is its low one, or its high one if reverse
+	// whole words are packed without any per-datum division, so that the compiler can vectorize it
+	inline void Pack10bitFilledLine(const U16 *src, U32 *dst, const int datums, const int paddingBits, const bool reverse)
+	{
+		const int shift0 = (reverse ? 20 : 0) + paddingBits;
+		const int shift1 = 10 + paddingBits;
+		const int shift2 = (reverse ? 0 : 20) + paddingBits;
+		const int words = datums / 3;
+
+		for (int w = 0; w < words; w++)
+			dst[w] = (U32(src[3 * w] >> 6) << shift0) | (U32(src[3 * w + 1] >> 6) << shift1)
+				| (U32(src[3 * w + 2] >> 6) << shift2);
+
+		// the last word may be partly filled
+		if (words * 3 < datums)
+		{
+			const int shifts[3] = { shift0, shift1, shift2 };
+			U32 value = 0;
+			for (int i = words * 3; i < datums; i++)
+				value |= U32(src[i] >> 6) << shifts[i - words * 3];
+			dst[words] = value;
+		}
+	}
+
+
+	// write an image of 16-bit datums as 10-bit filled method A/B words, packing all of
+	// it a band of lines at a time in parallel, and then writing it out line by line
+	inline int Write10bitFilled(OutStream *fd, const U16 *src_buf, const U32 width, const U32 height, const int noc,
+					const Packing packing, bool reverse, const int eolnPad, char *blank, bool &status, bool swapEndian,
+					const int threads)
+	{
+		// same datum order as WriteBuffer()
+		if (noc == 4)
+			reverse = !reverse;
+
+		const int datums = width * noc;
+		const size_t words = (datums + 2) / 3;
+		const int paddingBits = (packing == kFilledMethodA ? 2 : 0);
+
+		std::vector<U32> dst(words * height);
+		OIIO::parallel_for_chunked(0, height, 0, [&](int64_t ybegin, int64_t yend)
+		{
+			for (int64_t h = ybegin; h < yend; h++)
+			{
+				U32 *line = dst.data() + h * words;
+				Pack10bitFilledLine(src_buf + h * datums, line, datums, paddingBits, reverse);
+				if (swapEndian)
+					dpx::EndianSwapImageBuffer<dpx::kInt>(line, int(words));
+			}
+		}, OIIO::paropt(threads, OIIO::paropt::SplitDir::Y, 8));
+
+		// without end of line padding, the whole image can be written at once
+		const size_t lineBytes = words * sizeof(U32);
+		if (!eolnPad)
+		{
+			status = fd->WriteCheck(dst.data(), lineBytes * height);
+			return status ? int(lineBytes * height) : 0;
+		}
+
+		int fileOffset = 0;
+		for (U32 h = 0; h < height; h++)
+		{
+			if (!fd->WriteCheck(dst.data() + h * words, lineBytes) || !fd->WriteCheck(blank, eolnPad))
+			{
+				status = false;
+				break;
+			}
+			fileOffset += int(lineBytes) + eolnPad;
+		}
+		return fileOffset;
+	}
+
+
 	template <typename IB, int BITDEPTH, bool SAMEBUFTYPE>
 	int WriteBuffer(OutStream *fd, DataSize src_size, void *src_buf, const U32 width, const U32 height, const int noc, const Packing packing, 
 					const bool rle, bool reverse, const int eolnPad, char *blank, bool &status, bool swapEndian)
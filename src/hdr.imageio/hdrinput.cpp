@@ -9,6 +9,8 @@
 
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
+#include <OpenImageIO/simd.h>
 
 
 OIIO_PLUGIN_NAMESPACE_BEGIN
@@ -47,6 +49,8 @@ public:
               const ImageSpec& config) override;
     bool read_native_scanline(int subimage, int miplevel, int y, int z,
                               void* data) override;
+    bool read_native_scanlines(int subimage, int miplevel, int ybegin, int yend,
+                               int z, void* data) override;
     bool close() override;
     int current_subimage(void) const override { return m_subimage; }
     bool seek_subimage(int subimage, int miplevel) override;
@@ -54,21 +58,23 @@ public:
 private:
     std::string m_filename;  // File name
     int m_subimage;          // What subimage are we looking at?
-    int m_next_scanline;     // Next scanline to read
-    std::vector<int64_t> m_scanline_offsets;  // Cached scanline offsets
+    // Where each scanline starts in the file, and the last one ends, for
+    // as many as have been found so far.
+    std::vector<int64_t> m_scanline_offsets;
 
     void init()
     {
-        m_subimage      = -1;
-        m_next_scanline = 0;
+        m_subimage = -1;
         m_scanline_offsets.clear();
         ioproxy_clear();
     }
 
     bool RGBE_ReadHeader();
-    bool RGBE_ReadPixels(float* data, int y, uint64_t numpixels);
-    bool RGBE_ReadPixels_RLE(float* data, int y, uint64_t scanline_width,
-                             int num_scanlines);
+    // Find the offsets of the scanlines through yend. Scanlines can't be
+    // found without walking through the encoding of all the ones before,
+    // but that's much quicker than decoding them, which can then be done
+    // in parallel.
+    bool index_scanlines(int yend);
 
     // helper: fgets reads a "line" from the proxy, akin to std fgets. The
     // bytes go in the buffer, and part up to and including the new line is
@@ -187,22 +193,124 @@ static const float exponent_table[256] = {
 };
 
 
-/* standard conversion from rgbe to float pixels */
-inline void
-rgbe2float(float& red, float& green, float& blue, unsigned char rgbe[4])
+// Convert `width` pixels from separate planes of R, G, B, and E bytes (as
+// a run length encoded scanline is stored) to float RGB.
+static void
+rgbe_planes_to_float(const unsigned char* planes, int width, float* data)
 {
-    if (rgbe[3]) { /*nonzero pixel*/
-        float f = exponent_table[rgbe[3]];
-        red     = rgbe[0] * f;
-        green   = rgbe[1] * f;
-        blue    = rgbe[2] * f;
-    } else {
-        red = green = blue = 0.0f;
+    using namespace simd;
+    const unsigned char* r = planes;
+    const unsigned char* g = planes + width;
+    const unsigned char* b = planes + 2 * width;
+    const unsigned char* e = planes + 3 * width;
+    int x                  = 0;
+    for (; x + 4 <= width; x += 4, data += 12) {
+        vint4 exps(e + x);
+        vfloat4 f;
+        f.gather(exponent_table, exps);
+        f = select(exps != vint4::Zero(), f, vfloat4::Zero());
+        vfloat4 red(vfloat4(r + x) * f), green(vfloat4(g + x) * f);
+        vfloat4 blue(vfloat4(b + x) * f), unused(vfloat4::Zero());
+        transpose(red, green, blue, unused);
+        // Each store of 4 floats spills into the next pixel, which is then
+        // overwritten.
+        red.store(data);
+        green.store(data + 3);
+        blue.store(data + 6);
+        unused.store(data + 9, 3);
+    }
+    for (; x < width; ++x, data += 3) {
+        float f = e[x] ? exponent_table[e[x]] : 0.0f;
+        data[0] = r[x] * f;
+        data[1] = g[x] * f;
+        data[2] = b[x] * f;
     }
 }
 
 
 
+// Is the scanline starting at p run length encoded, for an image `width`
+// pixels wide? (Otherwise it's flat RGBE pixels.)
+static bool
+scanline_is_rle(const unsigned char* p, int width)
+{
+    return width >= 8 && width <= 0x7fff && p[0] == 2 && p[1] == 2
+           && !(p[2] & 0x80);
+}
+
+
+
+// The size in bytes of the encoded scanline starting at p, of which
+// `avail` bytes are at hand, or 0 if it doesn't all fit in them, or -1 if
+// it's corrupt.
+static int64_t
+encoded_scanline_size(const unsigned char* p, size_t avail, int width)
+{
+    if (width >= 8 && width <= 0x7fff && avail < 4)
+        return 0;
+    size_t flat = 4 * size_t(width);
+    if (!scanline_is_rle(p, width))
+        return avail >= flat ? int64_t(flat) : 0;
+    if ((int(p[2]) << 8 | p[3]) != width)
+        return -1;
+    size_t pos = 4;
+    for (int c = 0; c < 4; ++c) {
+        for (int left = width; left > 0;) {
+            if (pos + 2 > avail)
+                return 0;
+            int count = p[pos];
+            if (count > 128) {  // A run of the same value
+                count -= 128;
+                pos += 2;
+            } else {  // A non-run
+                pos += 1 + count;
+            }
+            if (count == 0 || count > left)
+                return -1;
+            left -= count;
+        }
+        if (pos > avail)
+            return 0;
+    }
+    return int64_t(pos);
+}
+
+
+
+// Decode the scanline of `size` bytes (as measured by
+// encoded_scanline_size) at p to float RGB.
+static void
+decode_scanline(const unsigned char* p, size_t size, int width, float* data)
+{
+    if (!scanline_is_rle(p, width)) {
+        for (int x = 0; x < width; ++x, p += 4, data += 3) {
+            float f = p[3] ? exponent_table[p[3]] : 0.0f;
+            data[0] = p[0] * f;
+            data[1] = p[1] * f;
+            data[2] = p[2] * f;
+        }
+        return;
+    }
+    unsigned char* planes;
+    OIIO_ALLOCATE_STACK_OR_HEAP(planes, unsigned char, 4 * size_t(width));
+    unsigned char* ptr = planes;
+    for (size_t pos = 4; pos < size;) {
+        int count = p[pos];
+        if (count > 128) {
+            memset(ptr, p[pos + 1], count - 128);
+            ptr += count - 128;
+            pos += 2;
+        } else {
+            memcpy(ptr, p + pos + 1, count);
+            ptr += count;
+            pos += 1 + count;
+        }
+    }
+    rgbe_planes_to_float(planes, width, data);
+}
+
+
+
 bool
 HdrInput::valid_file(Filesystem::IOProxy* ioproxy) const
 {
@@ -250,7 +358,6 @@ HdrInput::open(const std::string& name, ImageSpec& newspec)
     // FIXME -- should we do anything about exposure, software,
     // pixaspect, primaries?  (N.B. rgbe.c doesn't even handle most of them)
 
-    m_next_scanline = 0;
     m_scanline_offsets.clear();
     m_scanline_offsets.push_back(iotell());
 
@@ -369,102 +476,44 @@ HdrInput::RGBE_ReadHeader()
 
 
 
-/* simple read routine.  will not correctly handle run length encoding */
-bool
-HdrInput::RGBE_ReadPixels(float* data, int y, uint64_t numpixels)
-{
-    size_t size = 4 * numpixels;
-    unsigned char* rgbe;
-    OIIO_ALLOCATE_STACK_OR_HEAP(rgbe, unsigned char, size);
-    if (ioproxy()->read(rgbe, size) != size) {
-        errorfmt("Read error reading pixels on scanline {}", y);
-        return false;
-    }
-    for (uint64_t i = 0; i < numpixels; ++i)
-        rgbe2float(data[3 * i], data[3 * i + 1], data[3 * i + 2], &rgbe[4 * i]);
-    return true;
-}
-
-
-
 bool
-HdrInput::RGBE_ReadPixels_RLE(float* data, int y, uint64_t scanline_width,
-                              int num_scanlines)
+HdrInput::index_scanlines(int yend)
 {
-    if ((scanline_width < 8) || (scanline_width > 0x7fff))
-        /* run length encoding is not allowed so read flat*/
-        return RGBE_ReadPixels(data, y, scanline_width * num_scanlines);
-
-    unsigned char rgbe[4], *ptr, *ptr_end;
-    int count;
-    unsigned char buf[2];
-    std::vector<unsigned char> scanline_buffer;
-    Filesystem::IOProxy* m_io = ioproxy();
-
-    /* read in each successive scanline */
-    while (num_scanlines > 0) {
-        if (m_io->read(rgbe, sizeof(rgbe)) < sizeof(rgbe)) {
+    Filesystem::IOProxy* io = ioproxy();
+    int width               = m_spec.width;
+    // Big enough for any one scanline, however it's encoded.
+    size_t blocksize = std::max(size_t(1) << 20, 8 * size_t(width) + 16);
+    std::vector<unsigned char> block;
+    while (m_scanline_offsets.size() <= size_t(yend)) {
+        int y       = int(m_scanline_offsets.size()) - 1;
+        int64_t pos = m_scanline_offsets.back();
+        size_t n    = size_t(
+            std::max(int64_t(0),
+                     std::min(int64_t(blocksize), int64_t(io->size()) - pos)));
+        block.resize(n);
+        if (!n || io->pread(block.data(), n, pos) != n) {
             errorfmt("Read error on scanline {}", y);
             return false;
         }
-        if ((rgbe[0] != 2) || (rgbe[1] != 2) || (rgbe[2] & 0x80)) {
-            /* this file is not run length encoded */
-            rgbe2float(data[0], data[1], data[2], rgbe);
-            data += 3;
-            return RGBE_ReadPixels(data, y, scanline_width * num_scanlines - 1);
-        }
-        if ((((uint64_t)rgbe[2]) << 8 | rgbe[3]) != scanline_width) {
-            errorfmt("wrong scanline width for scanline {}", y);
-            return false;
-        }
-        scanline_buffer.resize(4 * scanline_width);
-
-        ptr = scanline_buffer.data();
-        /* read each of the four channels for the scanline into the buffer */
-        for (int i = 0; i < 4; i++) {
-            ptr_end = scanline_buffer.data() + (i + 1) * scanline_width;
-            while (ptr < ptr_end) {
-                if (m_io->read(buf, 2) < 2) {
-                    errorfmt("Read error on scanline {}", y);
-                    return false;
-                }
-                if (buf[0] > 128) {
-                    /* a run of the same value */
-                    count = buf[0] - 128;
-                    if ((count == 0) || (count > ptr_end - ptr)) {
-                        errorfmt("bad scanline {} data", y);
-                        return false;
-                    }
-                    while (count-- > 0)
-                        *ptr++ = buf[1];
-                } else {
-                    /* a non-run */
-                    count = buf[0];
-                    if ((count == 0) || (count > ptr_end - ptr)) {
-                        errorfmt("bad scanline {} data", y);
-                        return false;
-                    }
-                    *ptr++ = buf[1];
-                    if (--count > 0) {
-                        if (m_io->read(ptr, count) < uint64_t(count)) {
-                            errorfmt("Read error on scanline {}", y);
-                            return false;
-                        }
-                        ptr += count;
-                    }
-                }
+        // Walk through as many scanlines as are wholly in the block.
+        size_t used = 0;
+        while (m_scanline_offsets.size() <= size_t(m_spec.height)) {
+            int64_t size = encoded_scanline_size(block.data() + used,
+                                                 n - used, width);
+            if (size < 0) {
+                errorfmt("bad scanline {} data", y);
+                return false;
             }
+            if (size == 0)
+                break;
+            used += size_t(size);
+            m_scanline_offsets.push_back(pos + int64_t(used));
+            ++y;
         }
-        /* now convert data from buffer into floats */
-        for (uint64_t i = 0; i < scanline_width; i++) {
-            rgbe[0] = scanline_buffer[i];
-            rgbe[1] = scanline_buffer[i + scanline_width];
-            rgbe[2] = scanline_buffer[i + 2 * scanline_width];
-            rgbe[3] = scanline_buffer[i + 3 * scanline_width];
-            rgbe2float(data[0], data[1], data[2], rgbe);
-            data += 3;
+        if (!used) {  // Not even one, so the file ends partway through it
+            errorfmt("Read error on scanline {}", y);
+            return false;
         }
-        num_scanlines--;
     }
     return true;
 }
@@ -472,30 +521,46 @@ HdrInput::RGBE_ReadPixels_RLE(float* data, int y, uint64_t scanline_width,
 
 
 bool
-HdrInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
+HdrInput::read_native_scanline(int subimage, int miplevel, int y, int z,
                                void* data)
+{
+    return read_native_scanlines(subimage, miplevel, y, y + 1, z, data);
+}
+
+
+
+bool
+HdrInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
+                                int yend, int /*z*/, void* data)
 {
     lock_guard lock(*this);
     if (!seek_subimage(subimage, miplevel))
         return false;
+    yend = std::min(yend, m_spec.height);
+    if (ybegin < 0 || ybegin >= yend)
+        return ybegin == yend;
+    if (!index_scanlines(yend))
+        return false;
 
-    if (m_next_scanline != y) {
-        // For random access, use cached file offsets of scanlines. This avoids
-        // re-reading the same pixels many times over.
-        m_next_scanline = std::min((size_t)y, m_scanline_offsets.size() - 1);
-        ioseek(m_scanline_offsets[m_next_scanline]);
-    }
-
-    while (m_next_scanline <= y) {
-        // Keep reading until we've read the scanline we really need
-        bool ok = RGBE_ReadPixels_RLE((float*)data, y, m_spec.width, 1);
-        ++m_next_scanline;
-        if ((size_t)m_next_scanline == m_scanline_offsets.size()) {
-            m_scanline_offsets.push_back(iotell());
-        }
-        if (!ok)
-            return false;
+    // Read the encoded scanlines all at once, then decode them in
+    // parallel.
+    int64_t begin = m_scanline_offsets[ybegin];
+    size_t size   = size_t(m_scanline_offsets[yend] - begin);
+    std::unique_ptr<unsigned char[]> encoded(new unsigned char[size]);
+    if (ioproxy()->pread(encoded.get(), size, begin) != size) {
+        errorfmt("Read error on scanline {}", ybegin);
+        return false;
     }
+    int width = m_spec.width;
+    parallel_for(
+        int64_t(ybegin), int64_t(yend),
+        [&](int64_t y) {
+            decode_scanline(encoded.get() + (m_scanline_offsets[y] - begin),
+                            size_t(m_scanline_offsets[y + 1]
+                                   - m_scanline_offsets[y]),
+                            width, (float*)data + 3 * (y - ybegin) * width);
+        },
+        threads());
     return true;
 }
 
@@ -9,6 +9,8 @@
 
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
+#include <OpenImageIO/simd.h>
 #include <OpenImageIO/strutil.h>
 
 OIIO_PLUGIN_NAMESPACE_BEGIN
@@ -26,6 +28,9 @@ public:
               OpenMode mode) override;
     bool write_scanline(int y, int z, TypeDesc format, const void* data,
                         stride_t xstride) override;
+    bool write_scanlines(int ybegin, int yend, int z, TypeDesc format,
+                         const void* data, stride_t xstride = AutoStride,
+                         stride_t ystride = AutoStride) override;
     bool write_tile(int x, int y, int z, TypeDesc format, const void* data,
                     stride_t xstride, stride_t ystride,
                     stride_t zstride) override;
@@ -36,11 +41,6 @@ private:
     std::vector<unsigned char> m_tilebuffer;
 
     void init(void) { ioproxy_clear(); }
-
-    bool RGBE_WritePixels(float* data, int64_t numpixels);
-    bool RGBE_WriteBytes_RLE(unsigned char* data, int numbytes);
-    bool RGBE_WritePixels_RLE(float* data, int scanline_width,
-                              int num_scanlines);
 };
 
 
@@ -79,10 +79,46 @@ float2rgbe(unsigned char* rgbe, float red, float green, float blue)
 }
 
 
-inline void
-float2rgbe(unsigned char* rgbe, const float* rgb)
+
+// Convert `width` float RGB pixels to separate planes of R, G, B, and E
+// bytes, as a run length encoded scanline stores them. Four pixels at a
+// time give the same bytes as float2rgbe: frexpf(v)*256/v is exactly
+// 2^(8-e), which is made straight from the exponent bits of v.
+static void
+float_to_rgbe_planes(const float* data, int width, unsigned char* planes)
 {
-    return float2rgbe(rgbe, rgb[0], rgb[1], rgb[2]);
+    using namespace simd;
+    unsigned char* r = planes;
+    unsigned char* g = planes + width;
+    unsigned char* b = planes + 2 * width;
+    unsigned char* e = planes + 3 * width;
+    int x            = 0;
+    for (; x + 4 <= width; x += 4, data += 12) {
+        vfloat4 red(data[0], data[3], data[6], data[9]);
+        vfloat4 green(data[1], data[4], data[7], data[10]);
+        vfloat4 blue(data[2], data[5], data[8], data[11]);
+        vfloat4 v     = max(max(red, green), blue);
+        vbool4 zero   = !(v >= vfloat4(1e-32f));  // Also catches NaN
+        vint4 biased  = srl(bitcast_to_int(v), 23) & vint4(0xff);
+        vint4 exp     = biased - vint4(126);  // As frexpf would give
+        vfloat4 scale = bitcast_to_float((vint4(8 + 127) - exp) << 23);
+        auto tobyte   = [&](const vfloat4& c) {
+            vint4 i = min(max(vint4(c * scale), vint4::Zero()), vint4(255));
+            return select(zero, vint4::Zero(), i);
+        };
+        tobyte(red).store(r + x);
+        tobyte(green).store(g + x);
+        tobyte(blue).store(b + x);
+        select(zero, vint4::Zero(), exp + vint4(128)).store(e + x);
+    }
+    for (; x < width; ++x, data += 3) {
+        unsigned char rgbe[4];
+        float2rgbe(rgbe, data[0], data[1], data[2]);
+        r[x] = rgbe[0];
+        g[x] = rgbe[1];
+        b[x] = rgbe[2];
+        e[x] = rgbe[3];
+    }
 }
 
 
@@ -90,13 +126,14 @@ float2rgbe(unsigned char* rgbe, const float* rgb)
 // The code below is only needed for the run-length encoded files.
 // Run length encoding adds considerable complexity but does
 // save some space.  For each scanline, each channel (r,g,b,e) is
-// encoded separately for better compression.
-bool
-HdrOutput::RGBE_WriteBytes_RLE(unsigned char* data, int numbytes)
+// encoded separately for better compression. The encoding is appended to
+// `out`.
+static void
+RGBE_WriteBytes_RLE(const unsigned char* data, int numbytes,
+                    std::vector<unsigned char>& out)
 {
     static const int MINRUNLENGTH = 4;
     int cur, beg_run, run_count, old_run_count, nonrun_count;
-    unsigned char buf[2];
 
     cur = 0;
     while (cur < numbytes) {
@@ -113,10 +150,8 @@ HdrOutput::RGBE_WriteBytes_RLE(unsigned char* data, int numbytes)
         }
         /* if data before next big run is a short run then write it as such */
         if ((old_run_count > 1) && (old_run_count == beg_run - cur)) {
-            buf[0] = 128 + old_run_count; /*write short run*/
-            buf[1] = data[cur];
-            if (!iowrite(buf, 2))
-                return false;
+            out.push_back(128 + old_run_count); /*write short run*/
+            out.push_back(data[cur]);
             cur = beg_run;
         }
         /* write out bytes until we reach the start of the next run */
@@ -124,78 +159,46 @@ HdrOutput::RGBE_WriteBytes_RLE(unsigned char* data, int numbytes)
             nonrun_count = beg_run - cur;
             if (nonrun_count > 128)
                 nonrun_count = 128;
-            buf[0] = nonrun_count;
-            if (!iowrite(buf, 1))
-                return false;
-            if (!iowrite(&data[cur], nonrun_count))
-                return false;
+            out.push_back(nonrun_count);
+            out.insert(out.end(), data + cur, data + cur + nonrun_count);
             cur += nonrun_count;
         }
         /* write out next run if one was found */
         if (run_count >= MINRUNLENGTH) {
-            buf[0] = 128 + run_count;
-            buf[1] = data[beg_run];
-            if (!iowrite(buf, 2))
-                return false;
+            out.push_back(128 + run_count);
+            out.push_back(data[beg_run]);
             cur += run_count;
         }
     }
-    return true;
 }
 
 
 
-bool
-HdrOutput::RGBE_WritePixels_RLE(float* data, int scanline_width,
-                                int num_scanlines)
+// Encode one scanline of float RGB pixels, replacing the contents of `out`.
+static void
+RGBE_EncodeScanline(const float* data, int scanline_width,
+                    std::vector<unsigned char>& out)
 {
-    if (scanline_width < 8 || scanline_width > 0x7fff)
+    out.clear();
+    if (scanline_width < 8 || scanline_width > 0x7fff) {
         // run length encoding is not allowed so write flat
-        return RGBE_WritePixels(data, scanline_width * num_scanlines);
+        out.resize(4 * size_t(scanline_width));
+        for (int i = 0; i < scanline_width; ++i)
+            float2rgbe(&out[4 * i], data[3 * i], data[3 * i + 1],
+                       data[3 * i + 2]);
+        return;
+    }
     unsigned char* buffer;
     OIIO_ALLOCATE_STACK_OR_HEAP(buffer, unsigned char, scanline_width * 4);
-    while (num_scanlines-- > 0) {
-        unsigned char rgbe[4];
-        rgbe[0] = 2;
-        rgbe[1] = 2;
-        rgbe[2] = scanline_width >> 8;
-        rgbe[3] = scanline_width & 0xFF;
-        if (!iowrite(rgbe, 4))
-            return false;
-        for (int i = 0; i < scanline_width; i++) {
-            float2rgbe(rgbe, data);
-            buffer[i]                      = rgbe[0];
-            buffer[i + scanline_width]     = rgbe[1];
-            buffer[i + 2 * scanline_width] = rgbe[2];
-            buffer[i + 3 * scanline_width] = rgbe[3];
-            data += 3;
-        }
-        // write out each of the four channels separately run length encoded
-        // first red, then green, then blue, then exponent
-        for (int i = 0; i < 4; i++) {
-            if (!RGBE_WriteBytes_RLE(&buffer[i * scanline_width],
-                                     scanline_width))
-                return false;
-        }
-    }
-    return true;
-}
-
-
-
-// Simple write routine that does not use run length encoding.
-// These routines can be made faster by allocating a larger buffer and
-// fread-ing and fwrite-ing the data in larger chunks.
-bool
-HdrOutput::RGBE_WritePixels(float* data, int64_t numpixels)
-{
-    unsigned char* rgbe;
-    OIIO_ALLOCATE_STACK_OR_HEAP(rgbe, unsigned char, 4 * numpixels);
-    for (int64_t i = 0; i < numpixels; ++i)
-        float2rgbe(&rgbe[4 * i], data + 3 * i);
-    if (!iowrite(rgbe, 4 * numpixels))
-        return false;
-    return true;
+    float_to_rgbe_planes(data, scanline_width, buffer);
+    out.push_back(2);
+    out.push_back(2);
+    out.push_back(scanline_width >> 8);
+    out.push_back(scanline_width & 0xFF);
+    // write out each of the four channels separately run length encoded
+    // first red, then green, then blue, then exponent
+    for (int i = 0; i < 4; i++)
+        RGBE_WriteBytes_RLE(&buffer[i * scanline_width], scanline_width, out);
 }
 
 
@@ -241,7 +244,48 @@ HdrOutput::write_scanline(int /*y*/, int /*z*/, TypeDesc format,
                           const void* data, stride_t xstride)
 {
     data = to_native_scanline(format, data, xstride, scratch);
-    return RGBE_WritePixels_RLE((float*)data, m_spec.width, 1);
+    std::vector<unsigned char> encoded;
+    RGBE_EncodeScanline((const float*)data, m_spec.width, encoded);
+    return iowrite(encoded.data(), encoded.size());
+}
+
+
+
+bool
+HdrOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
+                           const void* data, stride_t xstride,
+                           stride_t ystride)
+{
+    yend = std::min(yend, m_spec.y + m_spec.height);
+    if (yend - ybegin <= 1)
+        return ImageOutput::write_scanlines(ybegin, yend, z, format, data,
+                                            xstride, ystride);
+    stride_t zstride = AutoStride;
+    m_spec.auto_stride(xstride, ystride, zstride,
+                       format.is_unknown() ? m_spec.format : format,
+                       m_spec.nchannels, m_spec.width, m_spec.height);
+    // Encode bands of scanlines in parallel, and write each band in order.
+    const int bandsize = 64;
+    std::vector<std::vector<unsigned char>> encoded(bandsize);
+    for (int yb = ybegin; yb < yend; yb += bandsize) {
+        int ye            = std::min(yb + bandsize, yend);
+        const void* band  = (const char*)data + (yb - ybegin) * ystride;
+        const float* rgbf = (const float*)to_native_rectangle(
+            m_spec.x, m_spec.x + m_spec.width, yb, ye, z, z + 1, format, band,
+            xstride, ystride, zstride, scratch);
+        int width = m_spec.width;
+        parallel_for(
+            int64_t(yb), int64_t(ye),
+            [&](int64_t y) {
+                RGBE_EncodeScanline(rgbf + 3 * (y - yb) * width, width,
+                                    encoded[y - yb]);
+            },
+            threads());
+        for (int y = yb; y < ye; ++y)
+            if (!iowrite(encoded[y - yb].data(), encoded[y - yb].size()))
+                return false;
+    }
+    return true;
 }
 
 
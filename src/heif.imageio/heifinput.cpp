@@ -58,6 +58,7 @@ private:
     bool m_keep_unassociated_alpha = false;
     bool m_do_associate            = false;
     bool m_reorient                = true;
+    int m_reduce_factor            = 1;  // Requested reduction of resolution
     std::unique_ptr<heif::Context> m_ctx;
     heif_item_id m_primary_id;             // id of primary image
     std::vector<heif_item_id> m_item_ids;  // ids of all other images
@@ -140,6 +141,7 @@ HeifInput::open(const std::string& name, ImageSpec& newspec,
     m_keep_unassociated_alpha
         = (config.get_int_attribute("oiio:UnassociatedAlpha") != 0);
     m_reorient = config.get_int_attribute("oiio:reorient", 1);
+    m_reduce_factor = config.get_int_attribute("oiio:reduce_factor", 1);
 
     try {
         m_ctx->read_from_file(name);
@@ -203,9 +205,27 @@ HeifInput::seek_subimage(int subimage, int miplevel)
         return false;
     }
 
-    auto id     = (subimage == 0) ? m_primary_id : m_item_ids[subimage - 1];
-    m_ihandle   = m_ctx->get_image_handle(id);
-    m_has_alpha = m_ihandle.has_alpha_channel();
+    auto id   = (subimage == 0) ? m_primary_id : m_item_ids[subimage - 1];
+    m_ihandle = m_ctx->get_image_handle(id);
+
+    // For a reduced resolution, decode instead the smallest of the image's
+    // thumbnails that's no smaller than asked for, if it has one.
+    heif::ImageHandle dhandle = m_ihandle;
+    if (m_reduce_factor > 1) {
+        int want = (m_ihandle.get_width() + m_reduce_factor - 1)
+                   / m_reduce_factor;
+        try {
+            for (auto t : m_ihandle.get_list_of_thumbnail_IDs()) {
+                heif::ImageHandle thumb = m_ihandle.get_thumbnail(t);
+                if (thumb.get_width() >= want
+                    && thumb.get_width() < dhandle.get_width())
+                    dhandle = thumb;
+            }
+        } catch (const heif::Error&) {
+            // Not a usable thumbnail; decode the full image
+        }
+    }
+    m_has_alpha = dhandle.has_alpha_channel();
     auto chroma = m_has_alpha ? heif_chroma_interleaved_RGBA
                               : heif_chroma_interleaved_RGB;
 #if 0
@@ -226,7 +246,7 @@ HeifInput::seek_subimage(int subimage, int miplevel)
     options->ignore_transformations = !m_reorient;
     // print("Got decoding options version {}\n", options->version);
     struct heif_image* img_tmp = nullptr;
-    struct heif_error herr = heif_decode_image(m_ihandle.get_raw_image_handle(),
+    struct heif_error herr = heif_decode_image(dhandle.get_raw_image_handle(),
                                                &img_tmp, heif_colorspace_RGB,
                                                chroma, options.get());
     if (img_tmp)
@@ -3,10 +3,14 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <algorithm>
 #include <cmath>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
 #include <iterator>
+#include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -17,6 +21,7 @@
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/thread.h>
 
 
 using namespace OIIO;
@@ -47,6 +52,10 @@ static bool rotcw = false, rotccw = false, rot180 = false;
 static bool sRGB     = false;
 static bool separate = false, contig = false;
 static bool noclobber  = false;
+static std::string outdir;
+static std::string outext;
+static int jobs        = 0;  // default: one per core, for several files
+static int max_memory  = 0;  // MB; default: half the physical memory
 static int return_code = EXIT_SUCCESS;
 static ArgParse ap;
 
@@ -70,7 +79,8 @@ getargs(int argc, char* argv[])
     ap.options ("iconvert -- copy images with format conversions and other alterations\n"
                 OIIO_INTRO_STRING "\n"
                 "Usage:  iconvert [options] inputfile outputfile\n"
-                "   or:  iconvert --inplace [options] file...\n",
+                "   or:  iconvert --inplace [options] file...\n"
+                "   or:  iconvert --outdir DIR [options] file...\n",
                 "%*", parse_files, "",
                 "--help", &help, "Print help message",
                 "-v", &verbose, "Verbose status messages",
@@ -98,6 +108,10 @@ getargs(int argc, char* argv[])
                 "--separate", &separate, "Force planarconfig separate",
                 "--contig", &contig, "Force planarconfig contig",
                 "--no-clobber", &noclobber, "Do not overwrite existing files",
+                "--outdir %s:DIR", &outdir, "Convert every file into DIR, under its own name",
+                "--outext %s:EXT", &outext, "With --outdir, change the file extension to EXT (e.g. exr)",
+                "--jobs %d:N", &jobs, "Convert N files at once (default 0 = one per core)",
+                "--max-memory %d:MB", &max_memory, "Limit the pixels of the files being converted at once to MB (default 0 = half the memory)",
 //FIXME         "-z", &zfile, "Treat input as a depth file",
 //FIXME         "-c %s", &channellist, "Restrict/shuffle channels",
                 nullptr);
@@ -116,7 +130,21 @@ getargs(int argc, char* argv[])
         return;
     }
 
-    if (filenames.size() != 2 && !inplace) {
+    if (outdir.size() && inplace) {
+        print(stderr, "iconvert: --outdir and --inplace are exclusive\n");
+        ap.usage();
+        ap.abort();
+        return_code = EXIT_FAILURE;
+        return;
+    }
+    if (outext.size() && outdir.empty()) {
+        print(stderr, "iconvert: --outext requires --outdir\n");
+        ap.usage();
+        ap.abort();
+        return_code = EXIT_FAILURE;
+        return;
+    }
+    if (filenames.size() != 2 && !inplace && outdir.empty()) {
         print(
             stderr,
             "iconvert: Must have both an input and output filename specified.\n");
@@ -125,7 +153,7 @@ getargs(int argc, char* argv[])
         return_code = EXIT_FAILURE;
         return;
     }
-    if (filenames.size() == 0 && inplace) {
+    if (filenames.size() == 0 && (inplace || outdir.size())) {
         print(stderr, "iconvert: Must have at least one filename\n");
         ap.usage();
         ap.abort();
@@ -265,16 +293,17 @@ adjust_spec(ImageInput* in, ImageOutput* out, const ImageSpec& inspec,
     if (orientation >= 1)
         outspec.attribute("Orientation", orientation);
     else {
-        orientation = outspec.get_int_attribute("Orientation", 1);
-        if (orientation >= 1 && orientation <= 8) {
+        // (Not in the global, which would carry over to the next file.)
+        int orient = outspec.get_int_attribute("Orientation", 1);
+        if (orient >= 1 && orient <= 8) {
             static int cw[] = { 0, 6, 7, 8, 5, 2, 3, 4, 1 };
             if (rotcw || rotccw || rot180)
-                orientation = cw[orientation];
+                orient = cw[orient];
             if (rotccw || rot180)
-                orientation = cw[orientation];
+                orient = cw[orient];
             if (rotccw)
-                orientation = cw[orientation];
-            outspec.attribute("Orientation", orientation);
+                orient = cw[orient];
+            outspec.attribute("Orientation", orient);
         }
     }
 
@@ -310,8 +339,48 @@ adjust_spec(ImageInput* in, ImageOutput* out, const ImageSpec& inspec,
 
 
 
+// The bytes of pixels that the files being converted at once may hold in
+// memory. A conversion waits to start reading until its share fits, but a
+// file bigger than the whole budget still gets converted, by itself.
+class MemoryBudget {
+public:
+    MemoryBudget(imagesize_t limit)
+        : m_limit(limit)
+    {
+    }
+
+    // Reserve the bytes (clamped to the limit), waiting for them if need
+    // be, and return how many were reserved.
+    imagesize_t acquire(imagesize_t bytes)
+    {
+        bytes = std::min(bytes, m_limit);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_released.wait(lock, [&]() { return m_used + bytes <= m_limit; });
+        m_used += bytes;
+        return bytes;
+    }
+
+    void release(imagesize_t bytes)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_used -= bytes;
+        }
+        m_released.notify_all();
+    }
+
+private:
+    imagesize_t m_limit;
+    imagesize_t m_used = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_released;
+};
+
+
+
 static bool
-convert_file(const std::string& in_filename, const std::string& out_filename)
+convert_file(const std::string& in_filename, const std::string& out_filename,
+             MemoryBudget* budget = nullptr)
 {
     if (noclobber && Filesystem::exists(out_filename)) {
         print(stderr, "iconvert ERROR: Output file already exists \"{}\"\n",
@@ -352,6 +421,17 @@ convert_file(const std::string& in_filename, const std::string& out_filename)
         return false;
     }
 
+    // Whether it's copied or read and written, the biggest image of the
+    // file is held in memory, one at a time. Its first level will do.
+    imagesize_t reserved = 0;
+    if (budget) {
+        imagesize_t bytes = inspec.image_bytes(true);
+        for (int s = 1; in->seek_subimage(s, 0); ++s)
+            bytes = std::max(bytes, in->spec().image_bytes(true));
+        in->seek_subimage(0, 0);
+        reserved = budget->acquire(bytes);
+    }
+
     // In order to deal with formats that support subimages, but not
     // subimage appending, we gather them all first.
     std::vector<ImageSpec> subimagespecs;
@@ -476,6 +556,8 @@ convert_file(const std::string& in_filename, const std::string& out_filename)
 
     out->close();
     in->close();
+    if (budget)
+        budget->release(reserved);
 
     // Figure out a time for the input file -- either one supplied by
     // the metadata, or the actual time stamp of the input file.
@@ -502,6 +584,48 @@ convert_file(const std::string& in_filename, const std::string& out_filename)
 
 
 
+// Convert each of the files in -> out, several at a time, each on a thread
+// of its own: while some files wait for their reads and writes, others
+// can (de)compress. An error with one file is reported, and the others
+// carry on. Return the number of files that failed.
+static size_t
+convert_files(const std::vector<std::pair<std::string, std::string>>& files)
+{
+    size_t nworkers = size_t(jobs > 0 ? jobs : Sysutil::hardware_concurrency());
+    nworkers        = std::max(size_t(1), std::min(nworkers, files.size()));
+    MemoryBudget budget(max_memory > 0 ? imagesize_t(max_memory) << 20
+                                       : Sysutil::physical_memory() / 2);
+
+    std::mutex mutex;
+    size_t next = 0, nfailed = 0;
+    auto worker = [&]() {
+        for (;;) {
+            size_t i;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (next >= files.size())
+                    return;
+                i = next++;
+            }
+            if (!convert_file(files[i].first, files[i].second, &budget)) {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++nfailed;
+            }
+        }
+    };
+    if (nworkers == 1) {
+        worker();
+    } else {
+        thread_group workers;
+        for (size_t w = 0; w < nworkers; ++w)
+            workers.create_thread(worker);
+        workers.join_all();
+    }
+    return nfailed;
+}
+
+
+
 int
 main(int argc, char* argv[])
 {
@@ -518,9 +642,38 @@ main(int argc, char* argv[])
 
     bool ok = true;
 
-    if (inplace) {
-        for (auto&& s : filenames)
-            ok &= convert_file(s, s);
+    if (inplace || outdir.size()) {
+        std::vector<std::pair<std::string, std::string>> files;
+        std::map<std::string, std::string> outputs;  // out -> in
+        if (outdir.size() && !Filesystem::is_directory(outdir)
+            && !Filesystem::create_directory(outdir)) {
+            print(stderr, "iconvert ERROR: Could not create directory \"{}\"\n",
+                  outdir);
+            return EXIT_FAILURE;
+        }
+        for (auto&& s : filenames) {
+            std::string out = s;
+            if (outdir.size()) {
+                out = Filesystem::filename(s);
+                if (outext.size())
+                    out = Filesystem::replace_extension(out, outext);
+                out = outdir + "/" + out;
+            }
+            auto dup = outputs.emplace(out, s);
+            if (!dup.second) {
+                print(stderr,
+                      "iconvert ERROR: \"{}\" and \"{}\" would both be written to \"{}\"\n",
+                      dup.first->second, s, out);
+                ok = false;
+                continue;
+            }
+            files.emplace_back(s, out);
+        }
+        size_t nfailed = convert_files(files);
+        if (nfailed && files.size() > 1)
+            print(stderr, "iconvert: {} of {} files failed\n", nfailed,
+                  files.size());
+        ok &= !nfailed;
     } else {
         ok = convert_file(filenames[0], filenames[1]);
     }
@@ -3,6 +3,8 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -10,6 +12,8 @@
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <mutex>
+#include <thread>
 
 #include <OpenImageIO/argparse.h>
 #include <OpenImageIO/dassert.h>
@@ -36,6 +40,65 @@ enum idiffErrors {
 
 
 
+// Everything on the command line that says how to compare a pair.
+struct Options {
+    bool verbose, quiet, compareall, outdiffonly, diffabs, perceptual;
+    std::string diffimage;
+    float diffscale;
+    float failthresh, failrelative, failpercent, hardfail;
+    float warnthresh, warnrelative, warnpercent, hardwarn;
+    int allowfailures;
+    bool stopearly;  // Only pass or fail matters, not how the images differ
+};
+
+
+
+// What was found comparing one pair of files, for the summary.
+struct PairResult {
+    std::string file0, file1;
+    int status = ErrOK;
+    double totalerror = 0, totalsqrerror = 0, maxerror = 0;
+    imagesize_t nvalues = 0, nwarn = 0, nfail = 0;
+    bool stoppedearly = false;
+};
+
+
+
+// The messages of one pair's comparison, held until they can be printed
+// without interleaving with those of pairs being compared at the same time.
+class Report {
+public:
+    template<typename Str, typename... Args>
+    void out(const Str& fmt, Args&&... args)
+    {
+        add(false, Strutil::fmt::format(fmt, args...));
+    }
+    template<typename Str, typename... Args>
+    void err(const Str& fmt, Args&&... args)
+    {
+        add(true, Strutil::fmt::format(fmt, args...));
+    }
+
+    // Print the messages, each to stdout or stderr, in order.
+    void print() const
+    {
+        for (auto& m : m_messages)
+            Strutil::print(m.first ? stderr : stdout, "{}", m.second);
+    }
+
+private:
+    void add(bool err, std::string text)
+    {
+        if (m_messages.size() && m_messages.back().first == err)
+            m_messages.back().second += text;
+        else
+            m_messages.emplace_back(err, std::move(text));
+    }
+    std::vector<std::pair<bool, std::string>> m_messages;
+};
+
+
+
 static ArgParse
 getargs(int argc, char* argv[])
 {
@@ -43,7 +106,9 @@ getargs(int argc, char* argv[])
     ArgParse ap;
     ap.intro("idiff -- compare two images\n"
              OIIO_INTRO_STRING)
-      .usage("idiff [options] <image1> <image2 | directory>")
+      .usage("idiff [options] <image1> <image2 | directory>\n"
+             "       idiff [options] <image1> ... <directory>\n"
+             "       idiff [options] <directory1> <directory2>")
       .add_version(OIIO_VERSION_STRING)
       .print_defaults(true);
 
@@ -56,6 +121,17 @@ getargs(int argc, char* argv[])
       .help("Quiet (minimal messages)");
     ap.arg("-a")
       .help("Compare all subimages/miplevels");
+    ap.arg("--threads")
+      .help("Number of threads (default: #cores)")
+      .metavar("N")
+      .defaultval(0);
+    ap.arg("--parallel-files")
+      .help("With several pairs of files, compare up to N pairs at once (default: 1 per 2 threads)")
+      .metavar("N")
+      .defaultval(0);
+    ap.arg("--summary")
+      .help("Write a JSON summary of the results of every pair to this file")
+      .metavar("FILENAME");
 
     ap.separator("Thresholding and comparison options");
     ap.arg("-fail")
@@ -120,8 +196,8 @@ getargs(int argc, char* argv[])
 
 static bool
 read_input(const std::string& filename, ImageBuf& img,
-           std::shared_ptr<ImageCache> cache, int subimage = 0,
-           int miplevel = 0)
+           std::shared_ptr<ImageCache> cache, Report& report,
+           int subimage = 0, int miplevel = 0)
 {
     if (img.subimage() >= 0 && img.subimage() == subimage
         && img.miplevel() == miplevel)
@@ -131,8 +207,8 @@ read_input(const std::string& filename, ImageBuf& img,
     if (img.read(subimage, miplevel, false, TypeFloat))
         return true;
 
-    print(stderr, "idiff ERROR: Could not read {}:\n\t{}\n", filename,
-          img.geterror());
+    report.err("idiff ERROR: Could not read {}:\n\t{}\n", filename,
+               img.geterror());
     return false;
 }
 
@@ -142,31 +218,31 @@ read_input(const std::string& filename, ImageBuf& img,
 // Windows (where they are in 1.#INF, 1.#NAN format) and all
 // others platform
 inline void
-safe_double_print(double val)
+safe_double_print(Report& report, double val)
 {
     if (std::isnan(val))
-        print("nan\n");
+        report.out("nan\n");
     else if (std::isinf(val))
-        print("inf\n");
+        report.out("inf\n");
     else
-        print("{:g}\n", val);
+        report.out("{:g}\n", val);
 }
 
 
 
 inline void
-print_subimage(ImageBuf& img0, int subimage, int miplevel)
+print_subimage(Report& report, ImageBuf& img0, int subimage, int miplevel)
 {
     if (img0.nsubimages() > 1)
-        print("Subimage {} ", subimage);
+        report.out("Subimage {} ", subimage);
     if (img0.nmiplevels() > 1)
-        print(" MIP level {} ", miplevel);
+        report.out(" MIP level {} ", miplevel);
     if (img0.nsubimages() > 1 || img0.nmiplevels() > 1)
-        print(": ");
-    print("{} x {}", img0.spec().width, img0.spec().height);
+        report.out(": ");
+    report.out("{} x {}", img0.spec().width, img0.spec().height);
     if (img0.spec().depth > 1)
-        print(" x {}", img0.spec().depth);
-    print(", {} channels\n", img0.spec().nchannels);
+        report.out(" x {}", img0.spec().depth);
+    report.out(", {} channels\n", img0.spec().nchannels);
 }
 
 
@@ -189,64 +265,94 @@ add_filename_to_directory(const std::string& first, std::string& second)
 }
 
 
-int
-main(int argc, char* argv[])
+
+
+// Would a comparison with these results fail, however the pixels not yet
+// compared turn out?
+inline bool
+failed(const ImageBufAlgo::CompareResults& cr, const Options& opt,
+       imagesize_t npels)
 {
-    // Helpful for debugging to make sure that any crashes dump a stack
-    // trace.
-    Sysutil::setup_crash_stacktrace("stdout");
+    return cr.nfail > imagesize_t(opt.allowfailures)
+           && (cr.nfail > (opt.failpercent / 100.0 * npels)
+               || cr.maxerror > opt.hardfail);
+}
 
-    Filesystem::convert_native_arguments(argc, (const char**)argv);
-    ArgParse ap = getargs(argc, argv);
 
-    std::vector<std::string> filenames = ap["filename"].as_vec<std::string>();
-    if (filenames.size() == 2) {
-        add_filename_to_directory(filenames[0], filenames[1]);
-    } else {
-        print(stderr, "idiff: Must have two input filenames.\n");
-        print(stderr, "> {}\n", Strutil::join(filenames, ", "));
-        ap.usage();
-        return EXIT_FAILURE;
-    }
-    bool verbose          = ap["v"].get<int>();
-    bool quiet            = ap["q"].get<int>();
-    bool compareall       = ap["a"].get<int>();
-    bool outdiffonly      = ap["od"].get<int>();
-    bool diffabs          = ap["abs"].get<int>();
-    bool perceptual       = ap["p"].get<int>();
-    std::string diffimage = ap["o"].get();
-    float diffscale       = ap["scale"].get<float>();
-    float failthresh      = ap["fail"].get<float>();
-    float failrelative    = ap["failrelative"].get<float>();
-    float failpercent     = ap["failpercent"].get<float>();
-    float hardfail        = ap["hardfail"].get<float>();
-    float warnthresh      = ap["warn"].get<float>();
-    float warnrelative    = ap["warnrelative"].get<float>();
-    float warnpercent     = ap["warnpercent"].get<float>();
-    float hardwarn        = ap["hardwarn"].get<float>();
-    int allowfailures     = ap["allowfailures"].get<int>();
-
-    if (!quiet) {
-        print("Comparing \"{}\" and \"{}\"\n", filenames[0], filenames[1]);
-        fflush(stdout);
+
+// Compare the images a strip of tiles at a time, stopping as soon as the
+// comparison is sure to fail, so that the tiles after it needn't even be
+// read. The results are those of the strips that were compared; stopped
+// says whether that was less than the whole image. (The PSNR is not
+// merged, but the statistics that decide pass or fail are.)
+static ImageBufAlgo::CompareResults
+compare_until_failed(const ImageBuf& img0, const ImageBuf& img1,
+                     const Options& opt, imagesize_t npels, bool& stopped)
+{
+    ROI roi   = roi_union(get_roi(img0.spec()), get_roi(img1.spec()));
+    roi.chend = std::min(roi.chend,
+                         std::max(img0.nchannels(), img1.nchannels()));
+    // As tall as the tiles (the cache autotiles untiled files), starting
+    // where the tiles do.
+    int striprows = img0.spec().tile_height > 1 ? img0.spec().tile_height
+                                                : 256;
+
+    ImageBufAlgo::CompareResults total {};
+    double totalerror = 0, totalsqrerror = 0;
+    imagesize_t nvalues = 0;
+    stopped             = false;
+    for (int y = roi.ybegin; y < roi.yend; y += striprows) {
+        if (failed(total, opt, npels)) {
+            stopped = true;
+            break;
+        }
+        ROI strip    = roi;
+        strip.ybegin = y;
+        strip.yend   = std::min(y + striprows, roi.yend);
+        auto cr = ImageBufAlgo::compare(img0, img1, opt.failthresh,
+                                        opt.warnthresh, opt.failrelative,
+                                        opt.warnrelative, strip);
+        imagesize_t n = strip.npixels() * strip.nchannels();
+        totalerror += cr.meanerror * n;
+        totalsqrerror += cr.rms_error * cr.rms_error * n;
+        nvalues += n;
+        total.nwarn += cr.nwarn;
+        total.nfail += cr.nfail;
+        if (cr.maxerror > total.maxerror) {
+            total.maxerror = cr.maxerror;
+            total.maxx     = cr.maxx;
+            total.maxy     = cr.maxy;
+            total.maxz     = cr.maxz;
+            total.maxc     = cr.maxc;
+        }
     }
+    total.meanerror = nvalues ? totalerror / nvalues : 0.0;
+    total.rms_error = nvalues ? sqrt(totalsqrerror / nvalues) : 0.0;
+    total.PSNR      = std::numeric_limits<double>::quiet_NaN();
+    return total;
+}
 
-    // Create a private ImageCache so we can customize its cache size
-    // and instruct it store everything internally as floats.
-    std::shared_ptr<ImageCache> imagecache = ImageCache::create(true);
-    imagecache->attribute("forcefloat", 1);
-    if (sizeof(void*) == 4)  // 32 bit or 64?
-        imagecache->attribute("max_memory_MB", 512.0);
-    else
-        imagecache->attribute("max_memory_MB", 2048.0);
-    imagecache->attribute("autotile", 256);
-    // force a full diff, even for files tagged with the same
-    // fingerprint, just in case some mistake has been made.
-    imagecache->attribute("deduplicate", 0);
+
+
+// Compare two files, as idiff compares a pair, writing its messages to the
+// report and returning one of idiffErrors.
+static int
+compare_pair(const Options& opt, std::shared_ptr<ImageCache> imagecache,
+             const std::string& file0, const std::string& file1,
+             Report& report, PairResult& result)
+{
+    const bool quiet = opt.quiet, verbose = opt.verbose;
+    const bool compareall = opt.compareall, perceptual = opt.perceptual;
+    std::string diffimage = opt.diffimage;
+    result.file0          = file0;
+    result.file1          = file1;
+
+    if (!quiet)
+        report.out("Comparing \"{}\" and \"{}\"\n", file0, file1);
 
     ImageBuf img0, img1;
-    if (!read_input(filenames[0], img0, imagecache)
-        || !read_input(filenames[1], img1, imagecache))
+    if (!read_input(file0, img0, imagecache, report)
+        || !read_input(file1, img1, imagecache, report))
         return ErrFile;
     //    ImageSpec spec0 = img0.spec();  // stash it
 
@@ -257,34 +363,35 @@ main(int argc, char* argv[])
         if (subimage >= img1.nsubimages())
             break;
 
-        if (!read_input(filenames[0], img0, imagecache, subimage)
-            || !read_input(filenames[1], img1, imagecache, subimage)) {
-            print(stderr, "Failed to read subimage {}\n", subimage);
+        if (!read_input(file0, img0, imagecache, report, subimage)
+            || !read_input(file1, img1, imagecache, report, subimage)) {
+            report.err("Failed to read subimage {}\n", subimage);
             return ErrFile;
         }
 
         if (img0.nmiplevels() != img1.nmiplevels()) {
             if (!quiet)
-                print("Files do not match in their number of MIPmap levels\n");
+                report.out(
+                    "Files do not match in their number of MIPmap levels\n");
         }
 
         for (int m = 0; m < img0.nmiplevels(); ++m) {
             if (m > 0 && !compareall)
                 break;
             if (m > 0 && img0.nmiplevels() != img1.nmiplevels()) {
-                print(stderr,
-                      "Files do not match in their number of MIPmap levels\n");
+                report.err(
+                    "Files do not match in their number of MIPmap levels\n");
                 ret = ErrDifferentSize;
                 break;
             }
 
-            if (!read_input(filenames[0], img0, imagecache, subimage, m)
-                || !read_input(filenames[1], img1, imagecache, subimage, m))
+            if (!read_input(file0, img0, imagecache, report, subimage, m)
+                || !read_input(file1, img1, imagecache, report, subimage, m))
                 return ErrFile;
 
             if (img0.deep() != img1.deep()) {
-                print(stderr,
-                      "One image contains deep data, the other does not\n");
+                report.err(
+                    "One image contains deep data, the other does not\n");
                 ret = ErrDifferentSize;
                 break;
             }
@@ -297,91 +404,117 @@ main(int argc, char* argv[])
 
             // Compare the two images.
             //
-            auto cr = ImageBufAlgo::compare(img0, img1, failthresh, warnthresh,
-                                            failrelative, warnrelative);
+            ImageBufAlgo::CompareResults cr;
+            bool stopped = false;
+            if (opt.stopearly && !img0.deep())
+                cr = compare_until_failed(img0, img1, opt, npels, stopped);
+            else
+                cr = ImageBufAlgo::compare(img0, img1, opt.failthresh,
+                                           opt.warnthresh, opt.failrelative,
+                                           opt.warnrelative);
 
             int yee_failures = 0;
             if (perceptual && !img0.deep()) {
-                cr           = {};
-                yee_failures = ImageBufAlgo::compare_Yee(img0, img1, cr);
+                cr = {};
+                if (opt.stopearly) {
+                    // Enough failures to fail is all we need to know
+                    imagesize_t maxfail = std::max(
+                        imagesize_t(opt.allowfailures),
+                        imagesize_t(opt.failpercent / 100.0 * npels));
+                    yee_failures = ImageBufAlgo::compare_Yee(img0, img1, cr,
+                                                             100.0f, 45.0f,
+                                                             {}, 0, maxfail);
+                } else {
+                    yee_failures = ImageBufAlgo::compare_Yee(img0, img1, cr);
+                }
             }
 
-            if (cr.nfail <= imagesize_t(allowfailures)) {
+            if (cr.nfail <= imagesize_t(opt.allowfailures)) {
                 // Pass if users set allowfailures and we are within that
                 // limit.
-            } else if (cr.nfail > (failpercent / 100.0 * npels)
-                       || cr.maxerror > hardfail
-                       || yee_failures > (failpercent / 100.0 * npels)) {
+            } else if (cr.nfail > (opt.failpercent / 100.0 * npels)
+                       || cr.maxerror > opt.hardfail
+                       || yee_failures > (opt.failpercent / 100.0 * npels)) {
                 ret = ErrFail;
-            } else if (cr.nwarn > (warnpercent / 100.0 * npels)
-                       || cr.maxerror > hardwarn) {
+            } else if (cr.nwarn > (opt.warnpercent / 100.0 * npels)
+                       || cr.maxerror > opt.hardwarn) {
                 if (ret != ErrFail)
                     ret = ErrWarn;
             }
 
+            imagesize_t nvalues = imagesize_t(npels) * img0.nchannels();
+            result.totalerror += cr.meanerror * nvalues;
+            result.totalsqrerror += cr.rms_error * cr.rms_error * nvalues;
+            result.nvalues += nvalues;
+            result.maxerror = std::max(result.maxerror, cr.maxerror);
+            result.nwarn += cr.nwarn;
+            result.nfail += cr.nfail;
+            result.stoppedearly |= stopped;
+
             // Print the report
             //
             if (verbose || (ret != ErrOK && !quiet)) {
                 if (compareall)
-                    print_subimage(img0, subimage, m);
-                print("  Mean error = ");
-                safe_double_print(cr.meanerror);
-                print("  RMS error = ");
-                safe_double_print(cr.rms_error);
-                print("  Peak SNR = ");
-                safe_double_print(cr.PSNR);
-                print("  Max error  = {:g}", cr.maxerror);
+                    print_subimage(report, img0, subimage, m);
+                report.out("  Mean error = ");
+                safe_double_print(report, cr.meanerror);
+                report.out("  RMS error = ");
+                safe_double_print(report, cr.rms_error);
+                report.out("  Peak SNR = ");
+                safe_double_print(report, cr.PSNR);
+                report.out("  Max error  = {:g}", cr.maxerror);
                 if (cr.maxerror != 0) {
-                    print(" @ ({}, {}", cr.maxx, cr.maxy);
+                    report.out(" @ ({}, {}", cr.maxx, cr.maxy);
                     if (img0.spec().depth > 1)
-                        print(", {}", cr.maxz);
+                        report.out(", {}", cr.maxz);
                     if (cr.maxc < (int)img0.spec().channelnames.size())
-                        print(", {})", img0.spec().channelnames[cr.maxc]);
+                        report.out(", {})", img0.spec().channelnames[cr.maxc]);
                     else if (cr.maxc < (int)img1.spec().channelnames.size())
-                        print(", {})", img1.spec().channelnames[cr.maxc]);
+                        report.out(", {})", img1.spec().channelnames[cr.maxc]);
                     else
-                        print(", channel {})", cr.maxc);
+                        report.out(", channel {})", cr.maxc);
                     if (!img0.deep()) {
-                        print("  values are ");
+                        report.out("  values are ");
                         for (int c = 0; c < img0.spec().nchannels; ++c)
-                            print("{}{}", (c ? ", " : ""),
-                                  img0.getchannel(cr.maxx, cr.maxy, 0, c));
-                        ;
-                        print(" vs ");
+                            report.out("{}{}", (c ? ", " : ""),
+                                       img0.getchannel(cr.maxx, cr.maxy, 0,
+                                                       c));
+                        report.out(" vs ");
                         for (int c = 0; c < img1.spec().nchannels; ++c)
-                            print("{}{}", (c ? ", " : ""),
-                                  img1.getchannel(cr.maxx, cr.maxy, 0, c));
-                        ;
+                            report.out("{}{}", (c ? ", " : ""),
+                                       img1.getchannel(cr.maxx, cr.maxy, 0,
+                                                       c));
                     }
                 }
-                print("\n");
+                report.out("\n");
 #if OIIO_MSVS_BEFORE_2015
                 // When older Visual Studio is used, float values in
                 // scientific format are printed with three digit exponent.
                 // We change this behaviour to fit Linux way.
                 _set_output_format(_TWO_DIGIT_EXPONENT);
 #endif
-                print("  {} pixels ({:1.3g}%) over {}\n", cr.nwarn,
-                      (100.0 * cr.nwarn / npels), warnthresh);
-                print("  {} pixels ({:1.3g}%) over {}\n", cr.nfail,
-                      (100.0 * cr.nfail / npels), failthresh);
+                report.out("  {} pixels ({:1.3g}%) over {}\n", cr.nwarn,
+                           (100.0 * cr.nwarn / npels), opt.warnthresh);
+                report.out("  {} pixels ({:1.3g}%) over {}\n", cr.nfail,
+                           (100.0 * cr.nfail / npels), opt.failthresh);
                 if (perceptual)
-                    print("  {} pixels ({:3g}%) failed the perceptual test\n",
-                          yee_failures, (100.0 * yee_failures / npels));
+                    report.out(
+                        "  {} pixels ({:3g}%) failed the perceptual test\n",
+                        yee_failures, (100.0 * yee_failures / npels));
             }
 
             // If the user requested that a difference image be output,
             // do that.  N.B. we only do this for the first subimage
             // right now, because ImageBuf doesn't really know how to
             // write subimages.
-            if (diffimage.size() && (cr.maxerror != 0 || !outdiffonly)) {
+            if (diffimage.size() && (cr.maxerror != 0 || !opt.outdiffonly)) {
                 ImageBuf diff;
-                if (diffabs)
+                if (opt.diffabs)
                     ImageBufAlgo::absdiff(diff, img0, img1);
                 else
                     ImageBufAlgo::sub(diff, img0, img1);
-                if (diffscale != 1.0f)
-                    ImageBufAlgo::mul(diff, diff, diffscale);
+                if (opt.diffscale != 1.0f)
+                    ImageBufAlgo::mul(diff, diff, opt.diffscale);
                 diff.write(diffimage);
 
                 // Clear diff image name so we only save the first
@@ -393,29 +526,259 @@ main(int argc, char* argv[])
 
     if (compareall && img0.nsubimages() != img1.nsubimages()) {
         if (!quiet)
-            print(stderr,
-                  "Images had differing numbers of subimages ({} vs {})\n",
-                  img0.nsubimages(), img1.nsubimages());
+            report.err(
+                "Images had differing numbers of subimages ({} vs {})\n",
+                img0.nsubimages(), img1.nsubimages());
         ret = ErrFail;
     }
     if (!compareall && (img0.nsubimages() > 1 || img1.nsubimages() > 1)) {
         if (!quiet)
-            print(
+            report.out(
                 "Only compared the first subimage (of {} and {}, respectively)\n",
                 img0.nsubimages(), img1.nsubimages());
     }
+    return ret;
+}
 
-    if (ret == ErrOK) {
-        if (!quiet)
-            print("PASS\n");
-    } else if (ret == ErrWarn) {
-        if (!quiet)
-            print("WARNING\n");
-    } else if (ret) {
-        if (quiet)
-            print(stderr, "FAILURE\n");
+
+
+// List the pairs of files to compare: two files; files and a directory
+// holding same-named files to compare them with; or two directories, each
+// file of the first being compared with its namesake in the second.
+static bool
+list_pairs(const std::vector<std::string>& filenames,
+           std::vector<std::pair<std::string, std::string>>& pairs)
+{
+    if (filenames.size() < 2) {
+        print(stderr, "idiff: Must have two input filenames.\n");
+        return false;
+    }
+    const std::string& last(filenames.back());
+    if (filenames.size() == 2 && Filesystem::is_directory(filenames[0])
+        && Filesystem::is_directory(last)) {
+        std::vector<std::string> files;
+        if (!Filesystem::get_directory_entries(filenames[0], files)) {
+            print(stderr, "idiff: Could not read the directory {}\n",
+                  filenames[0]);
+            return false;
+        }
+        std::sort(files.begin(), files.end());
+        for (auto& f : files) {
+            if (!Filesystem::is_regular(f))
+                continue;
+            std::string second = last;
+            add_filename_to_directory(f, second);
+            pairs.emplace_back(f, second);
+        }
+        return true;
+    }
+    if (filenames.size() > 2 && !Filesystem::is_directory(last)) {
+        print(stderr, "idiff: To compare more than two files, the last must "
+                      "be a directory.\n");
+        return false;
+    }
+    for (size_t i = 0; i + 1 < filenames.size(); ++i) {
+        std::string second = last;
+        add_filename_to_directory(filenames[i], second);
+        pairs.emplace_back(filenames[i], second);
+    }
+    return true;
+}
+
+
+
+// Quote s as a JSON string.
+static std::string
+json_string(string_view s)
+{
+    std::string r = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            r += '\\';
+        if ((unsigned char)c < 0x20)
+            r += Strutil::fmt::format("\\u{:04x}", int(c));
         else
-            print("FAILURE\n");
+            r += c;
+    }
+    return r + "\"";
+}
+
+
+
+// A number as JSON, which has no infinities or NaNs.
+static std::string
+json_number(double val)
+{
+    return std::isfinite(val) ? Strutil::fmt::format("{:g}", val) : "null";
+}
+
+
+
+// Write a JSON summary of the results of all the pairs.
+static bool
+write_summary(const std::string& filename, cspan<PairResult> results,
+              int ret)
+{
+    static const char* status_names[] = { "PASS", "WARNING", "FAILURE",
+                                          "DIFFERENTSIZE", "FILEERROR" };
+    imagesize_t counts[ErrLast] = {};
+    std::string out             = "{\n  \"pairs\": [\n";
+    for (auto& r : results) {
+        ++counts[r.status];
+        out += Strutil::fmt::format(
+            "    {{\"image1\": {}, \"image2\": {}, \"result\": \"{}\", "
+            "\"code\": {}, \"meanerror\": {}, \"rmserror\": {}, "
+            "\"maxerror\": {}, \"nwarn\": {}, \"nfail\": {}, "
+            "\"stoppedearly\": {}}}{}\n",
+            json_string(r.file0), json_string(r.file1),
+            status_names[r.status], r.status,
+            json_number(r.nvalues ? r.totalerror / r.nvalues : 0.0),
+            json_number(r.nvalues ? sqrt(r.totalsqrerror / r.nvalues) : 0.0),
+            json_number(r.maxerror), r.nwarn, r.nfail,
+            r.stoppedearly ? "true" : "false",
+            &r == &results.back() ? "" : ",");
+    }
+    out += Strutil::fmt::format(
+        "  ],\n  \"npairs\": {}, \"pass\": {}, \"warning\": {}, "
+        "\"failure\": {}, \"code\": {}\n}}\n",
+        results.size(), counts[ErrOK], counts[ErrWarn],
+        results.size() - counts[ErrOK] - counts[ErrWarn], ret);
+    return Filesystem::write_text_file(filename, out);
+}
+
+
+
+int
+main(int argc, char* argv[])
+{
+    // Helpful for debugging to make sure that any crashes dump a stack
+    // trace.
+    Sysutil::setup_crash_stacktrace("stdout");
+
+    Filesystem::convert_native_arguments(argc, (const char**)argv);
+    ArgParse ap = getargs(argc, argv);
+
+    std::vector<std::string> filenames = ap["filename"].as_vec<std::string>();
+    std::vector<std::pair<std::string, std::string>> pairs;
+    if (!list_pairs(filenames, pairs)) {
+        print(stderr, "> {}\n", Strutil::join(filenames, ", "));
+        ap.usage();
+        return EXIT_FAILURE;
+    }
+    Options opt;
+    opt.verbose       = ap["v"].get<int>();
+    opt.quiet         = ap["q"].get<int>();
+    opt.compareall    = ap["a"].get<int>();
+    opt.outdiffonly   = ap["od"].get<int>();
+    opt.diffabs       = ap["abs"].get<int>();
+    opt.perceptual    = ap["p"].get<int>();
+    opt.diffimage     = ap["o"].get();
+    opt.diffscale     = ap["scale"].get<float>();
+    opt.failthresh    = ap["fail"].get<float>();
+    opt.failrelative  = ap["failrelative"].get<float>();
+    opt.failpercent   = ap["failpercent"].get<float>();
+    opt.hardfail      = ap["hardfail"].get<float>();
+    opt.warnthresh    = ap["warn"].get<float>();
+    opt.warnrelative  = ap["warnrelative"].get<float>();
+    opt.warnpercent   = ap["warnpercent"].get<float>();
+    opt.hardwarn      = ap["hardwarn"].get<float>();
+    opt.allowfailures = ap["allowfailures"].get<int>();
+    // Quietly, with no difference image, a pair fails the same however
+    // much more it differs than it takes to fail.
+    opt.stopearly = opt.quiet && !opt.verbose && opt.diffimage.empty()
+                    && !opt.perceptual;
+    std::string summary = ap["summary"].get();
+    int nparallel       = ap["parallel-files"].get<int>();
+    OIIO::attribute("threads", ap["threads"].get<int>());
+
+    if (opt.diffimage.size() && pairs.size() > 1) {
+        print(stderr, "idiff: -o can only be used comparing one pair of "
+                      "files.\n");
+        return EXIT_FAILURE;
+    }
+
+    // Create a private ImageCache so we can customize its cache size
+    // and instruct it store everything internally as floats.
+    std::shared_ptr<ImageCache> imagecache = ImageCache::create(true);
+    imagecache->attribute("forcefloat", 1);
+    if (sizeof(void*) == 4)  // 32 bit or 64?
+        imagecache->attribute("max_memory_MB", 512.0);
+    else
+        imagecache->attribute("max_memory_MB", 2048.0);
+    imagecache->attribute("autotile", 256);
+    // force a full diff, even for files tagged with the same
+    // fingerprint, just in case some mistake has been made.
+    imagecache->attribute("deduplicate", 0);
+
+    // Compare the pairs, several at a time, printing each one's report as
+    // soon as those of the pairs before it have been printed.
+    std::vector<PairResult> results(pairs.size());
+    std::vector<Report> reports(pairs.size());
+    std::vector<bool> done(pairs.size(), false);
+    size_t nprinted = 0;
+    std::mutex mutex;
+    std::atomic<size_t> next(0);
+    auto compare_pairs = [&]() {
+        for (size_t i = next++; i < pairs.size(); i = next++) {
+            const std::string& file0(pairs[i].first);
+            const std::string& file1(pairs[i].second);
+            Report& report(reports[i]);
+            int ret = compare_pair(opt, imagecache, file0, file1, report,
+                                   results[i]);
+            results[i].status = ret;
+            if (ret == ErrOK) {
+                if (!opt.quiet)
+                    report.out("PASS\n");
+            } else if (ret == ErrWarn) {
+                if (!opt.quiet)
+                    report.out("WARNING\n");
+            } else if (opt.quiet && pairs.size() > 1) {
+                report.err("FAILURE \"{}\" vs \"{}\"\n", file0, file1);
+            } else if (opt.quiet) {
+                report.err("FAILURE\n");
+            } else {
+                report.out("FAILURE\n");
+            }
+            // Its tiles won't be needed again
+            imagecache->invalidate(ustring(file0));
+            imagecache->invalidate(ustring(file1));
+
+            std::lock_guard<std::mutex> lock(mutex);
+            done[i] = true;
+            for (; nprinted < pairs.size() && done[nprinted]; ++nprinted) {
+                reports[nprinted].print();
+                reports[nprinted] = Report();
+            }
+        }
+    };
+    if (nparallel < 1)
+        nparallel = std::max(1, OIIO::get_int_attribute("threads") / 2);
+    nparallel = std::min(nparallel, int(pairs.size()));
+    if (nparallel > 1) {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < nparallel; ++t)
+            workers.emplace_back(compare_pairs);
+        for (auto& w : workers)
+            w.join();
+    } else {
+        compare_pairs();
+    }
+
+    int ret = ErrOK;
+    size_t npassed = 0, nwarned = 0;
+    for (auto& r : results) {
+        ret = std::max(ret, r.status);
+        npassed += (r.status == ErrOK);
+        nwarned += (r.status == ErrWarn);
+    }
+    if (pairs.size() > 1 && !opt.quiet)
+        print("Compared {} pairs: {} passed, {} with warnings, {} failed\n",
+              pairs.size(), npassed, nwarned,
+              pairs.size() - npassed - nwarned);
+    if (summary.size() && !write_summary(summary, results, ret)) {
+        print(stderr, "idiff ERROR: Could not write {}\n", summary);
+        if (ret < ErrFile)
+            ret = ErrFile;
     }
 
     imagecache->invalidate_all(true);
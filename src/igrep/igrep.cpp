@@ -3,14 +3,19 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <regex>
+#include <thread>
 
 #include <OpenImageIO/argparse.h>
 #include <OpenImageIO/filesystem.h>
@@ -27,39 +32,223 @@ static bool recursive     = false;
 static bool file_match    = false;
 static bool print_dirs    = false;
 static bool all_subimages = false;
+static bool use_index     = false;
+static int nparallel      = 0;  // files at once; default: one per thread
 static std::string pattern;
 static std::vector<std::string> filenames;
 
+// The name of the index igrep --index keeps in each directory it searches.
+static const char* index_name = ".igrep-index";
 
 
-static bool
-grep_file(const std::string& filename, std::regex& re,
-          bool ignore_nonimage_files = false)
-{
-    if (!Filesystem::exists(filename)) {
-        std::cerr << "igrep: " << filename << ": No such file or directory\n";
-        return false;
+
+// The string metadata of a file: for each subimage, the name of each
+// attribute with a string value, and the value (one of each for each
+// element of a string array).
+struct FileMetadata {
+    std::string error;  // Why it couldn't be opened, if it isn't an image
+    std::vector<std::vector<std::pair<std::string, std::string>>> subimages;
+};
+
+
+
+// The metadata of the files in one directory, saved between searches in
+// a text file there. An entry is current as long as the file's
+// modification time and size are what they were when it was read.
+class DirectoryIndex {
+public:
+    explicit DirectoryIndex(const std::string& dir)
+        : m_dir(dir)
+        , m_filename(dir + "/" + index_name)
+    {
+        load();
     }
 
-    if (Filesystem::is_directory(filename)) {
-        if (!recursive)
+    // Look up the file (named within the directory), returning true if its
+    // entry is current.
+    bool find(const std::string& name, std::time_t mtime, uint64_t size,
+              FileMetadata& md)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto e = m_entries.find(name);
+        if (e == m_entries.end() || e->second.mtime != mtime
+            || e->second.size != size)
             return false;
-        if (print_dirs) {
-            std::cout << "(" << filename << "/)\n";
-            std::cout.flush();
+        e->second.used = true;
+        md             = e->second.md;
+        return true;
+    }
+
+    void add(const std::string& name, std::time_t mtime, uint64_t size,
+             const FileMetadata& md)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries[name] = { mtime, size, md, true };
+        m_changed       = true;
+    }
+
+    // Write the index if it changed, keeping the entries of files that
+    // weren't searched this time for as long as they exist.
+    void save();
+
+private:
+    struct Entry {
+        std::time_t mtime;
+        uint64_t size;
+        FileMetadata md;
+        bool used;  // Looked up or added this time
+    };
+    void load();
+
+    std::string m_dir, m_filename;
+    std::map<std::string, Entry> m_entries;
+    bool m_changed = false;
+    std::mutex m_mutex;
+};
+
+
+
+// The index file is "igrep-index 1" and then, for each file, a line
+//     F <name> <mtime> <size> <nsubimages> <error>
+// followed by a line for each string value of its metadata,
+//     A <subimage> <attribute name> <value>
+// with the fields separated by tabs, and the strings escaped.
+void
+DirectoryIndex::load()
+{
+    std::string text;
+    if (!Filesystem::read_text_file(m_filename, text))
+        return;
+    std::vector<string_view> lines = Strutil::splitsv(text, "\n");
+    if (lines.empty() || lines[0] != "igrep-index 1")
+        return;  // Not an index we understand; it'll be replaced
+    Entry* entry = nullptr;
+    for (string_view line : cspan<string_view>(lines).subspan(1)) {
+        std::vector<string_view> f = Strutil::splitsv(line, "\t");
+        if (f.size() == 6 && f[0] == "F") {
+            Entry& e(m_entries[Strutil::unescape_chars(f[1])]);
+            e.mtime    = Strutil::from_string<int64_t>(f[2]);
+            e.size     = Strutil::from_string<uint64_t>(f[3]);
+            e.md.error = Strutil::unescape_chars(f[5]);
+            e.md.subimages.resize(Strutil::from_string<int>(f[4]));
+            e.used = false;
+            entry  = &e;
+        } else if (f.size() == 4 && f[0] == "A" && entry) {
+            size_t subimage = Strutil::from_string<int>(f[1]);
+            if (subimage < entry->md.subimages.size())
+                entry->md.subimages[subimage].emplace_back(
+                    Strutil::unescape_chars(f[2]),
+                    Strutil::unescape_chars(f[3]));
         }
-        bool r = false;
-        std::vector<std::string> directory_entries;
-        Filesystem::get_directory_entries(filename, directory_entries);
-        for (const auto& d : directory_entries)
-            r |= grep_file(d, re, true);
-        return r;
     }
+}
+
 
+
+void
+DirectoryIndex::save()
+{
+    if (!m_changed)
+        return;
+    std::string text = "igrep-index 1\n";
+    for (auto& e : m_entries) {
+        if (!e.second.used && !Filesystem::exists(m_dir + "/" + e.first))
+            continue;
+        const FileMetadata& md(e.second.md);
+        text += Strutil::fmt::format("F\t{}\t{}\t{}\t{}\t{}\n",
+                                     Strutil::escape_chars(e.first),
+                                     int64_t(e.second.mtime), e.second.size,
+                                     md.subimages.size(),
+                                     Strutil::escape_chars(md.error));
+        for (size_t s = 0; s < md.subimages.size(); ++s)
+            for (auto& a : md.subimages[s])
+                text += Strutil::fmt::format("A\t{}\t{}\t{}\n", s,
+                                             Strutil::escape_chars(a.first),
+                                             Strutil::escape_chars(a.second));
+    }
+    // Write it whole and then move it into place, so that a search
+    // running at the same time never reads half of it.
+    std::string tmp = m_filename + ".tmp";
+    if (Filesystem::write_text_file(tmp, text)) {
+        std::string err;
+        if (!Filesystem::rename(tmp, m_filename, err)) {
+            Strutil::sync::print(std::cerr, "igrep: {}\n", err);
+            Filesystem::remove(tmp);
+        }
+    }
+}
+
+
+
+// The indices of the directories searched, by directory.
+static std::map<std::string, std::unique_ptr<DirectoryIndex>> indices;
+static std::mutex indices_mutex;
+
+static DirectoryIndex&
+directory_index(const std::string& dir)
+{
+    std::lock_guard<std::mutex> lock(indices_mutex);
+    auto& index = indices[dir];
+    if (!index)
+        index.reset(new DirectoryIndex(dir));
+    return *index;
+}
+
+
+
+// Read the string metadata of a file -- of all of its subimages if
+// they'll be searched or the metadata is going into an index.
+static void
+read_metadata(const std::string& filename, FileMetadata& md)
+{
     auto in = ImageInput::open(filename);
-    if (!in.get()) {
+    if (!in) {
+        md.error = geterror();
+        return;
+    }
+    int subimage = 0;
+    do {
+        if (!all_subimages && !use_index && subimage > 0)
+            break;
+        md.subimages.emplace_back();
+        ImageSpec spec = in->spec(subimage);
+        for (auto&& p : spec.extra_attribs) {
+            TypeDesc t = p.type();
+            if (t.elementtype() == TypeDesc::STRING) {
+                int n = t.numelements();
+                for (int i = 0; i < n; ++i)
+                    md.subimages.back().emplace_back(
+                        p.name().string(), ((const char**)p.data())[i]);
+            }
+        }
+    } while (in->seek_subimage(++subimage, 0));
+}
+
+
+
+// Search one file, writing what igrep prints for it to out, and returning
+// whether it was a match.
+static bool
+grep_file(const std::string& filename, const std::regex& re,
+          bool ignore_nonimage_files, std::string& out)
+{
+    FileMetadata md;
+    if (use_index) {
+        std::string dir = Filesystem::parent_path(filename);
+        std::string name(Filesystem::filename(filename));
+        std::time_t mtime = Filesystem::last_write_time(filename);
+        uint64_t size     = Filesystem::file_size(filename);
+        DirectoryIndex& index(directory_index(dir.size() ? dir : "."));
+        if (!index.find(name, mtime, size, md)) {
+            read_metadata(filename, md);
+            index.add(name, mtime, size, md);
+        }
+    } else {
+        read_metadata(filename, md);
+    }
+    if (md.subimages.empty()) {
         if (!ignore_nonimage_files)
-            std::cerr << geterror() << "\n";
+            Strutil::sync::print(std::cerr, "{}\n", md.error);
         return false;
     }
 
@@ -68,58 +257,87 @@ grep_file(const std::string& filename, std::regex& re,
         try {
             match = std::regex_search(filename, re);
         } catch (const std::regex_error& e) {
-            std::cerr << "igrep: " << e.what() << "\n";
+            Strutil::sync::print(std::cerr, "igrep: {}\n", e.what());
             return false;
         }
         if (match && !invert_match) {
-            std::cout << filename << "\n";
+            out += filename + "\n";
             return true;
         }
     }
 
-    bool found   = false;
-    int subimage = 0;
-    do {
+    bool found = false;
+    for (size_t subimage = 0; subimage < md.subimages.size(); ++subimage) {
         if (!all_subimages && subimage > 0)
             break;
-        ImageSpec spec = in->spec(subimage);
-        for (auto&& p : spec.extra_attribs) {
-            TypeDesc t = p.type();
-            if (t.elementtype() == TypeDesc::STRING) {
-                int n = t.numelements();
-                for (int i = 0; i < n; ++i) {
-                    bool match = false;
-                    try {
-                        match = std::regex_search(((const char**)p.data())[i],
-                                                  re);
-                    } catch (const std::regex_error& e) {
-                        std::cerr << "igrep: " << e.what() << "\n";
-                        return false;
-                    }
-                    found |= match;
-                    if (match && !invert_match) {
-                        if (list_files) {
-                            std::cout << filename << "\n";
-                            return found;
-                        }
-                        std::cout << filename << ": " << p.name() << " = "
-                                  << ((const char**)p.data())[i] << "\n";
-                    }
+        for (auto&& a : md.subimages[subimage]) {
+            bool match = false;
+            try {
+                match = std::regex_search(a.second, re);
+            } catch (const std::regex_error& e) {
+                Strutil::sync::print(std::cerr, "igrep: {}\n", e.what());
+                return false;
+            }
+            found |= match;
+            if (match && !invert_match) {
+                if (list_files) {
+                    out += filename + "\n";
+                    return found;
                 }
+                out += Strutil::fmt::format("{}: {} = {}\n", filename,
+                                            a.first, a.second);
             }
         }
-    } while (in->seek_subimage(++subimage, 0));
+    }
 
     if (invert_match) {
         found = !found;
         if (found)
-            std::cout << filename << "\n";
+            out += filename + "\n";
     }
     return found;
 }
 
 
 
+// One thing to search: a file, or a directory to print the name of.
+struct Job {
+    std::string filename;
+    bool directory;
+    bool ignore_nonimage_files;
+};
+
+
+
+// List the files to search (and the directories to print), in the order
+// they would be searched one at a time.
+static void
+list_jobs(const std::string& filename, bool ignore_nonimage_files,
+          std::vector<Job>& jobs)
+{
+    if (!Filesystem::exists(filename)) {
+        std::cerr << "igrep: " << filename << ": No such file or directory\n";
+        return;
+    }
+
+    if (Filesystem::is_directory(filename)) {
+        if (!recursive)
+            return;
+        if (print_dirs)
+            jobs.push_back({ filename, true, false });
+        std::vector<std::string> directory_entries;
+        Filesystem::get_directory_entries(filename, directory_entries);
+        std::sort(directory_entries.begin(), directory_entries.end());
+        for (const auto& d : directory_entries)
+            if (!Strutil::starts_with(Filesystem::filename(d), index_name))
+                list_jobs(d, true, jobs);
+        return;
+    }
+    jobs.push_back({ filename, false, ignore_nonimage_files });
+}
+
+
+
 static int
 parse_files(int argc, const char* argv[])
 {
@@ -167,6 +385,10 @@ main(int argc, const char* argv[])
       .help("Print directories (when recursive)");
     ap.arg("-a", &all_subimages)
       .help("Search all subimages of each file");
+    ap.arg("--index", &use_index)
+      .help("Index the metadata of each directory searched, to search it faster next time");
+    ap.arg("--parallel-files %d:N", &nparallel)
+      .help("Search up to N files at once (default: 1 per thread)");
 
     // clang-format on
     ap.parse(argc, argv);
@@ -182,16 +404,62 @@ main(int argc, const char* argv[])
     if (ap["i"].get<int>())
         flag |= std::regex_constants::icase;
 
-    bool ok = true;
-
+    std::regex re;
     try {
-        std::regex re(pattern, flag);
-        for (auto&& s : filenames)
-            grep_file(s, re);
+        re = std::regex(pattern, flag);
     } catch (const std::regex_error& e) {
         std::cerr << "igrep: " << e.what() << "\n";
-        ok = false;
+        shutdown();
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Job> jobs;
+    for (auto&& s : filenames)
+        list_jobs(s, false, jobs);
+
+    // Search several files at once, as opening them is mostly waiting on
+    // the disk or network. What is found in each file is printed as soon
+    // as everything before it has been, so the output is in the same order
+    // as searching them one at a time.
+    std::vector<std::string> outputs(jobs.size());
+    std::vector<bool> done(jobs.size(), false);
+    size_t nprinted = 0;
+    std::mutex mutex;
+    std::atomic<size_t> next(0);
+    auto search_files = [&]() {
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            std::string out;
+            if (jobs[i].directory)
+                out = Strutil::fmt::format("({}/)\n", jobs[i].filename);
+            else
+                grep_file(jobs[i].filename, re, jobs[i].ignore_nonimage_files,
+                          out);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            outputs[i] = std::move(out);
+            done[i]    = true;
+            for (; nprinted < jobs.size() && done[nprinted]; ++nprinted) {
+                std::cout << outputs[nprinted];
+                std::string().swap(outputs[nprinted]);
+            }
+            std::cout.flush();
+        }
+    };
+    if (nparallel < 1)
+        nparallel = std::max(1, OIIO::get_int_attribute("threads"));
+    nparallel = std::min(nparallel, int(jobs.size()));
+    if (nparallel > 1) {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < nparallel; ++t)
+            workers.emplace_back(search_files);
+        for (auto& w : workers)
+            w.join();
+    } else {
+        search_files();
     }
+
+    for (auto& index : indices)
+        index.second->save();
     shutdown();
-    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    return EXIT_SUCCESS;
 }
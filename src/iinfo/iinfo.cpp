@@ -3,6 +3,7 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <atomic>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -10,7 +11,10 @@
 #include <iostream>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <regex>
+#include <sstream>
+#include <thread>
 
 #include <OpenImageIO/argparse.h>
 #include <OpenImageIO/deepdata.h>
@@ -38,17 +42,19 @@ static std::regex field_re;
 static bool subimages     = false;
 static bool compute_sha1  = false;
 static bool compute_stats = false;
+static int nthreads       = 0;  // default: use #cores threads if available
+static int nparallel      = 0;  // files at once; default: one per thread
 
 using OIIO::print;
 
 
 
 static void
-print_sha1(ImageInput* input, int subimage, int miplevel)
+print_sha1(std::ostream& out, ImageInput* input, int subimage, int miplevel)
 {
     std::string err;
     std::string s1 = pvt::compute_sha1(input, subimage, miplevel, err);
-    print("    SHA-1: {}\n", err.size() ? err : s1);
+    print(out, "    SHA-1: {}\n", err.size() ? err : s1);
 }
 
 
@@ -63,16 +69,17 @@ read_input(const std::string& filename, ImageBuf& img, int subimage = 0,
     if (img.read(subimage, miplevel, false, TypeDesc::FLOAT))
         return true;
 
-    std::cerr << "iinfo ERROR: Could not read " << filename << ":\n\t"
-              << img.geterror() << "\n";
+    Strutil::sync::print(std::cerr, "iinfo ERROR: Could not read {}:\n\t{}\n",
+                         filename, img.geterror());
     return false;
 }
 
 
 
 static void
-print_stats(const std::string& filename, const ImageSpec& originalspec,
-            int subimage = 0, int miplevel = 0, bool indentmip = false)
+print_stats(std::ostream& out, const std::string& filename,
+            const ImageSpec& originalspec, int subimage = 0, int miplevel = 0,
+            bool indentmip = false)
 {
     const char* indent = indentmip ? "      " : "    ";
 
@@ -83,10 +90,10 @@ print_stats(const std::string& filename, const ImageSpec& originalspec,
     }
 
     std::string err;
-    if (!pvt::print_stats(std::cout, indent, input, originalspec, ROI(), err)) {
-        print("{}Stats: (unable to compute)\n", indent);
+    if (!pvt::print_stats(out, indent, input, originalspec, ROI(), err)) {
+        print(out, "{}Stats: (unable to compute)\n", indent);
         if (err.size())
-            std::cerr << "Error: " << err << "\n";
+            Strutil::sync::print(std::cerr, "Error: {}\n", err);
         return;
     }
 }
@@ -94,36 +101,37 @@ print_stats(const std::string& filename, const ImageSpec& originalspec,
 
 
 static void
-print_metadata(const ImageSpec& spec, const std::string& filename)
+print_metadata(std::ostream& out, const ImageSpec& spec,
+               const std::string& filename)
 {
     bool printed = false;
     if (metamatch.empty() || std::regex_search("channels", field_re)
         || std::regex_search("channel list", field_re)) {
         if (filenameprefix)
-            print("{} : ", filename);
-        print("    channel list: ");
+            print(out, "{} : ", filename);
+        print(out, "    channel list: ");
         for (int i = 0; i < spec.nchannels; ++i) {
             if (i < (int)spec.channelnames.size())
-                print("{}", spec.channelnames[i]);
+                print(out, "{}", spec.channelnames[i]);
             else
-                print("unknown");
+                print(out, "unknown");
             if (i < (int)spec.channelformats.size())
-                print(" ({})", spec.channelformats[i]);
+                print(out, " ({})", spec.channelformats[i]);
             if (i < spec.nchannels - 1)
-                print(", ");
+                print(out, ", ");
         }
-        print("\n");
+        print(out, "\n");
         printed = true;
     }
     if (spec.x || spec.y || spec.z) {
         if (metamatch.empty()
             || std::regex_search("pixel data origin", field_re)) {
             if (filenameprefix)
-                print("{} : ", filename);
-            print("    pixel data origin: x={}, y={}", spec.x, spec.y);
+                print(out, "{} : ", filename);
+            print(out, "    pixel data origin: x={}, y={}", spec.x, spec.y);
             if (spec.depth > 1)
-                print(", z={}", spec.z);
-            print("\n");
+                print(out, ", z={}", spec.z);
+            print(out, "\n");
             printed = true;
         }
     }
@@ -134,33 +142,35 @@ print_metadata(const ImageSpec& spec, const std::string& filename)
         if (metamatch.empty()
             || std::regex_search("full/display size", field_re)) {
             if (filenameprefix)
-                print("{} : ", filename);
-            print("    full/display size: {} x {}", spec.full_width,
+                print(out, "{} : ", filename);
+            print(out, "    full/display size: {} x {}", spec.full_width,
                   spec.full_height);
             if (spec.depth > 1)
-                print(" x {}", spec.full_depth);
-            print("\n");
+                print(out, " x {}", spec.full_depth);
+            print(out, "\n");
             printed = true;
         }
         if (metamatch.empty()
             || std::regex_search("full/display origin", field_re)) {
             if (filenameprefix)
-                print("{} : ", filename);
-            print("    full/display origin: {}, {}", spec.full_x, spec.full_y);
+                print(out, "{} : ", filename);
+            print(out, "    full/display origin: {}, {}", spec.full_x,
+                  spec.full_y);
             if (spec.depth > 1)
-                print(", {}", spec.full_z);
-            print("\n");
+                print(out, ", {}", spec.full_z);
+            print(out, "\n");
             printed = true;
         }
     }
     if (spec.tile_width) {
         if (metamatch.empty() || std::regex_search("tile", field_re)) {
             if (filenameprefix)
-                print("{} : ", filename);
-            print("    tile size: {} x {}", spec.tile_width, spec.tile_height);
+                print(out, "{} : ", filename);
+            print(out, "    tile size: {} x {}", spec.tile_width,
+                  spec.tile_height);
             if (spec.depth > 1)
-                print(" x {}", spec.tile_depth);
-            print("\n");
+                print(out, " x {}", spec.tile_depth);
+            print(out, "\n");
             printed = true;
         }
     }
@@ -176,20 +186,20 @@ print_metadata(const ImageSpec& spec, const std::string& filename)
             continue;
         std::string s = spec.metadata_val(p, true);
         if (filenameprefix)
-            print("{} : ", filename);
-        print("    {}: ", p.name());
+            print(out, "{} : ", filename);
+        print(out, "    {}: ", p.name());
         if (s == "1.#INF")
-            print("inf");
+            print(out, "inf");
         else
-            print("{}", s);
-        print("\n");
+            print(out, "{}", s);
+        print(out, "\n");
         printed = true;
     }
 
     if (!printed && !metamatch.empty()) {
         if (filenameprefix)
-            print("{} : ", filename);
-        print("    {}: <unknown>\n", metamatch);
+            print(out, "{} : ", filename);
+        print(out, "    {}: <unknown>\n", metamatch);
     }
 }
 
@@ -237,8 +247,9 @@ brief_format_name(TypeDesc type, int bits = 0)
 // prints basic info (resolution, width, height, depth, channels, data format,
 // and format name) about given subimage.
 static void
-print_info_subimage(int current_subimage, int max_subimages, ImageSpec& spec,
-                    ImageInput* input, const std::string& filename)
+print_info_subimage(std::ostream& out, int current_subimage, int max_subimages,
+                    ImageSpec& spec, ImageInput* input,
+                    const std::string& filename)
 {
     if (!input->seek_subimage(current_subimage, 0))
         return;
@@ -260,53 +271,54 @@ print_info_subimage(int current_subimage, int max_subimages, ImageSpec& spec,
               || std::regex_search("resolution, width, height, depth, channels",
                                    field_re));
     if (printres && max_subimages > 1 && subimages) {
-        print(" subimage {:2}: ", current_subimage);
-        print("{:4} x {:4}", spec.width, spec.height);
+        print(out, " subimage {:2}: ", current_subimage);
+        print(out, "{:4} x {:4}", spec.width, spec.height);
         if (spec.depth > 1)
-            print(" x {:4}", spec.depth);
+            print(out, " x {:4}", spec.depth);
         int bits = spec.get_int_attribute("oiio:BitsPerSample", 0);
-        print(", {} channel, {}{}{}", spec.nchannels, spec.deep ? "deep " : "",
-              spec.depth > 1 ? "volume " : "",
+        print(out, ", {} channel, {}{}{}", spec.nchannels,
+              spec.deep ? "deep " : "", spec.depth > 1 ? "volume " : "",
               extended_format_name(spec.format, bits));
-        print(" {}", input->format_name());
-        print("\n");
+        print(out, " {}", input->format_name());
+        print(out, "\n");
     }
     // Count MIP levels
     while (input->seek_subimage(current_subimage, nmip)) {
         if (printres) {
             ImageSpec mipspec = input->spec_dimensions(current_subimage, nmip);
             if (nmip == 1)
-                print("    MIP-map levels: {}x{}", spec.width, spec.height);
-            print(" {}x{}", mipspec.width, mipspec.height);
+                print(out, "    MIP-map levels: {}x{}", spec.width,
+                      spec.height);
+            print(out, " {}x{}", mipspec.width, mipspec.height);
         }
         ++nmip;
     }
     if (printres && nmip > 1)
-        print("\n");
+        print(out, "\n");
 
     if (compute_sha1
         && (metamatch.empty() || std::regex_search("sha-1", field_re))) {
         if (filenameprefix)
-            print("{} : ", filename);
+            print(out, "{} : ", filename);
         // Before sha-1, be sure to point back to the highest-res MIP level
         input->seek_subimage(current_subimage, 0);
-        print_sha1(input, current_subimage, 0);
+        print_sha1(out, input, current_subimage, 0);
     }
 
     if (verbose)
-        print_metadata(spec, filename);
+        print_metadata(out, spec, filename);
 
     if (compute_stats
         && (metamatch.empty() || std::regex_search("stats", field_re))) {
         for (int m = 0; m < nmip; ++m) {
             ImageSpec mipspec = input->spec_dimensions(current_subimage, m);
             if (filenameprefix)
-                print("{} : ", filename);
+                print(out, "{} : ", filename);
             if (nmip > 1 && (subimages || m == 0)) {
-                print("    MIP {} of {} ({} x {}):\n", m, nmip, mipspec.width,
-                      mipspec.height);
+                print(out, "    MIP {} of {} ({} x {}):\n", m, nmip,
+                      mipspec.width, mipspec.height);
             }
-            print_stats(filename, spec, current_subimage, m, nmip > 1);
+            print_stats(out, filename, spec, current_subimage, m, nmip > 1);
         }
     }
 
@@ -317,9 +329,9 @@ print_info_subimage(int current_subimage, int max_subimages, ImageSpec& spec,
 
 
 static void
-print_info(const std::string& filename, size_t namefieldlength,
-           ImageInput* input, ImageSpec& spec, bool verbose, bool sum,
-           long long& totalsize)
+print_info(std::ostream& out, const std::string& filename,
+           size_t namefieldlength, ImageInput* input, ImageSpec& spec,
+           bool verbose, bool sum, long long& totalsize)
 {
     int padlen = std::max(0, (int)namefieldlength - (int)filename.length());
     std::string padding(padlen, ' ');
@@ -352,57 +364,58 @@ print_info(const std::string& filename, size_t namefieldlength,
     if (metamatch.empty()
         || std::regex_search("resolution, width, height, depth, channels",
                              field_re)) {
-        print("{}{} : {:4} x {:4}", filename, padding, spec.width, spec.height);
+        print(out, "{}{} : {:4} x {:4}", filename, padding, spec.width,
+              spec.height);
         if (spec.depth > 1)
-            print(" x {:4}", spec.depth);
-        print(", {} channel, {}{}", spec.nchannels, spec.deep ? "deep " : "",
-              spec.depth > 1 ? "volume " : "");
+            print(out, " x {:4}", spec.depth);
+        print(out, ", {} channel, {}{}", spec.nchannels,
+              spec.deep ? "deep " : "", spec.depth > 1 ? "volume " : "");
         if (spec.channelformats.size()) {
             for (size_t c = 0; c < spec.channelformats.size(); ++c)
-                print("{}{}", c ? "/" : "", spec.channelformat(c));
+                print(out, "{}{}", c ? "/" : "", spec.channelformat(c));
         } else {
             int bits = spec.get_int_attribute("oiio:BitsPerSample", 0);
-            print("{}", extended_format_name(spec.format, bits));
+            print(out, "{}", extended_format_name(spec.format, bits));
         }
-        print(" {}", input->format_name());
+        print(out, " {}", input->format_name());
         if (sum) {
             imagesize_t imagebytes = spec.image_bytes(true);
             totalsize += imagebytes;
-            print(" ({:.2f} MB)", (float)imagebytes / (1024.0 * 1024.0));
+            print(out, " ({:.2f} MB)", (float)imagebytes / (1024.0 * 1024.0));
         }
         // we print info about how many subimages are stored in file
         // only when we have more then one subimage
         if (!verbose && num_of_subimages != 1)
-            print(" ({} subimages{})", num_of_subimages,
+            print(out, " ({} subimages{})", num_of_subimages,
                   any_mipmapping ? " +mipmap)" : "");
         if (!verbose && num_of_subimages == 1 && any_mipmapping)
-            print(" (+mipmap)");
-        print("\n");
+            print(out, " (+mipmap)");
+        print(out, "\n");
     }
 
     int movie = spec.get_int_attribute("oiio:Movie");
     if (verbose && num_of_subimages != 1) {
         // info about num of subimages and their resolutions
-        print("    {} subimages: ", num_of_subimages);
+        print(out, "    {} subimages: ", num_of_subimages);
         for (int i = 0; i < num_of_subimages; ++i) {
             spec     = input->spec(i, 0);
             int bits = spec.get_int_attribute("oiio:BitsPerSample",
                                               spec.format.size() * 8);
             if (i)
-                print(", ");
+                print(out, ", ");
             if (spec.depth > 1)
-                print("{}x{}x{} ", spec.width, spec.height, spec.depth);
+                print(out, "{}x{}x{} ", spec.width, spec.height, spec.depth);
             else
-                print("{}x{} ", spec.width, spec.height);
-            // print("[");
+                print(out, "{}x{} ", spec.width, spec.height);
+            // print(out, "[");
             for (int c = 0; c < spec.nchannels; ++c)
-                print("{:c}{}", c ? ',' : '[',
+                print(out, "{:c}{}", c ? ',' : '[',
                       brief_format_name(spec.channelformat(c), bits));
-            print("]");
+            print(out, "]");
             if (movie)
                 break;
         }
-        print("\n");
+        print(out, "\n");
     }
 
     // if the '-a' flag is not set we print info
@@ -410,7 +423,7 @@ print_info(const std::string& filename, size_t namefieldlength,
     if (!subimages)
         num_of_subimages = 1;
     for (int i = 0; i < num_of_subimages; ++i) {
-        print_info_subimage(i, num_of_subimages, spec, input, filename);
+        print_info_subimage(out, i, num_of_subimages, spec, input, filename);
     }
 }
 
@@ -448,6 +461,10 @@ main(int argc, const char* argv[])
       .action(ArgParse::store_true());
     ap.arg("--stats", &compute_stats)
       .help("Print image pixel statistics (data window)");
+    ap.arg("--threads %d:NUMTHREADS", &nthreads)
+      .help("Number of threads (default: #cores)");
+    ap.arg("--parallel-files %d:N", &nparallel)
+      .help("Open and describe up to N files at once (default: 1 per thread)");
     // clang-format on
     if (ap.parse(argc, argv) < 0 || filenames.empty()) {
         std::cerr << ap.geterror() << std::endl;
@@ -466,19 +483,67 @@ main(int argc, const char* argv[])
         longestname = std::max(longestname, s.length());
     longestname = std::min(longestname, (size_t)40);
 
+    // The one-line summaries need none of the metadata, so don't spend
+    // time decoding it.
+    ImageSpec config;
+    if (!verbose && metamatch.empty() && !compute_sha1 && !compute_stats)
+        config.attribute("oiio:headeronly", 1);
+
+    OIIO::attribute("threads", nthreads);
+
+    // Describe several files at once, as opening them is mostly waiting
+    // on the disk or network. Each file's description is printed as soon
+    // as those of all the files before it have been, so the output is in
+    // the order of the command line no matter which files finish first.
     int returncode      = EXIT_SUCCESS;
     long long totalsize = 0;
-    for (auto&& s : filenames) {
-        auto in = ImageInput::open(s);
-        if (!in) {
-            std::string err = geterror();
-            print(std::cerr, "iinfo ERROR: \"{}\" : {}\n", s,
-                  err.size() ? err : std::string("Could not open file."));
-            returncode = EXIT_FAILURE;
-            continue;
+    std::vector<std::string> descriptions(filenames.size());
+    std::vector<bool> done(filenames.size(), false);
+    size_t nprinted = 0;
+    std::mutex mutex;
+    std::atomic<size_t> next(0);
+    auto describe_files = [&]() {
+        for (size_t i = next++; i < filenames.size(); i = next++) {
+            const std::string& s(filenames[i]);
+            std::ostringstream out;
+            long long size = 0;
+            bool ok        = true;
+            if (auto in = ImageInput::open(s, &config)) {
+                ImageSpec spec = in->spec();
+                print_info(out, s, longestname, in.get(), spec, verbose, sum,
+                           size);
+            } else {
+                std::string err = geterror();
+                if (err.empty())
+                    err = "Could not open file.";
+                Strutil::sync::print(std::cerr, "iinfo ERROR: \"{}\" : {}\n",
+                                     s, err);
+                ok = false;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!ok)
+                returncode = EXIT_FAILURE;
+            totalsize += size;
+            descriptions[i] = out.str();
+            done[i]         = true;
+            for (; nprinted < filenames.size() && done[nprinted]; ++nprinted) {
+                print("{}", descriptions[nprinted]);
+                std::string().swap(descriptions[nprinted]);
+            }
         }
-        ImageSpec spec = in->spec();
-        print_info(s, longestname, in.get(), spec, verbose, sum, totalsize);
+    };
+    if (nparallel < 1)
+        nparallel = std::max(1, OIIO::get_int_attribute("threads"));
+    nparallel = std::min(nparallel, int(filenames.size()));
+    if (nparallel > 1) {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < nparallel; ++t)
+            workers.emplace_back(describe_files);
+        for (auto& w : workers)
+            w.join();
+    } else {
+        describe_files();
     }
 
     if (sum)
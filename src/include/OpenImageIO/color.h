@@ -371,6 +371,14 @@ public:
     /// Return a filename or other identifier for the config we're using.
     std::string configname() const;
 
+    /// Return an identifier of the contents of the config we're using
+    /// (OCIO's cache ID), which differs for configs that could transform
+    /// colors differently even if they have the same name. It's suitable
+    /// for the keys of anything persisted that depends on the config.
+    ///
+    /// @version 3.1
+    std::string cacheid() const;
+
     /// Set the spec's metadata to presume that color space is `name` (or to
     /// assume nothing about the color space if `name` is empty). The core
     /// operation is to set the "oiio:ColorSpace" attribute, but it also removes
@@ -425,12 +433,19 @@ sRGB_to_linear(float x)
 
 
 #ifndef __CUDA_ARCH__
-inline simd::vfloat4
-sRGB_to_linear(const simd::vfloat4& x)
+/// SIMD sRGB_to_linear, for any of vfloat4, vfloat8, or vfloat16, using
+/// fast_pow_pos. It is exact at 0 and 1, and everywhere on [0,1] within
+/// 7e-6 (about 130 ulp) of the exact result.
+template<typename VF, OIIO_ENABLE_IF(simd::SimdSize<VF>::size > 1
+                                     && std::is_same<typename VF::value_t,
+                                                     float>::value)>
+inline VF
+sRGB_to_linear(const VF& x)
 {
-    return simd::select(
-        x <= 0.04045f, x * (1.0f / 12.92f),
-        fast_pow_pos(madd(x, (1.0f / 1.055f), 0.055f * (1.0f / 1.055f)), 2.4f));
+    // (x + 0.055) / 1.055, written so that it is exactly 1 when x is
+    return simd::select(x <= 0.04045f, x * (1.0f / 12.92f),
+                        fast_pow_pos(madd(x - 1.0f, 1.0f / 1.055f, 1.0f),
+                                     2.4f));
 }
 #endif
 
@@ -445,14 +460,19 @@ linear_to_sRGB(float x)
 
 
 #ifndef __CUDA_ARCH__
-/// Utility -- convert linear value to sRGB transfer function, without
-/// any change in color primaries.
-inline simd::vfloat4
-linear_to_sRGB(const simd::vfloat4& x)
+/// SIMD linear_to_sRGB, for any of vfloat4, vfloat8, or vfloat16, using
+/// fast_pow_pos. It is exact at 0 and 1, and everywhere on [0,1] within
+/// 7.5e-6 (about 250 ulp) of the exact result.
+template<typename VF, OIIO_ENABLE_IF(simd::SimdSize<VF>::size > 1
+                                     && std::is_same<typename VF::value_t,
+                                                     float>::value)>
+inline VF
+linear_to_sRGB(const VF& x)
 {
-    // x = simd::max (x, simd::vfloat4::Zero());
+    // 1.055 * x^(1/2.4) - 0.055, written so that it is exactly 1 when x is
     return simd::select(x <= 0.0031308f, 12.92f * x,
-                        madd(1.055f, fast_pow_pos(x, 1.f / 2.4f), -0.055f));
+                        madd(1.055f, fast_pow_pos(x, 1.f / 2.4f) - 1.0f,
+                             1.0f));
 }
 #endif
 
@@ -481,4 +501,34 @@ linear_to_Rec709(float x)
 }
 
 
+#ifndef __CUDA_ARCH__
+/// SIMD Rec709_to_linear, for any of vfloat4, vfloat8, or vfloat16, using
+/// fast_pow_pos. It is exact at 0 and 1, and everywhere on [0,1] within
+/// 7e-6 (about 125 ulp) of the exact result.
+template<typename VF, OIIO_ENABLE_IF(simd::SimdSize<VF>::size > 1
+                                     && std::is_same<typename VF::value_t,
+                                                     float>::value)>
+inline VF
+Rec709_to_linear(const VF& x)
+{
+    return simd::select(x < 0.081f, x * (1.0f / 4.5f),
+                        fast_pow_pos(madd(x - 1.0f, 1.0f / 1.099f, 1.0f),
+                                     1.0f / 0.45f));
+}
+
+/// SIMD linear_to_Rec709, for any of vfloat4, vfloat8, or vfloat16, using
+/// fast_pow_pos. It is exact at 0 and 1, and everywhere on [0,1] within
+/// 8e-6 (about 260 ulp) of the exact result.
+template<typename VF, OIIO_ENABLE_IF(simd::SimdSize<VF>::size > 1
+                                     && std::is_same<typename VF::value_t,
+                                                     float>::value)>
+inline VF
+linear_to_Rec709(const VF& x)
+{
+    return simd::select(x < 0.018f, 4.5f * x,
+                        madd(1.099f, fast_pow_pos(x, 0.45f) - 1.0f, 1.0f));
+}
+#endif
+
+
 OIIO_NAMESPACE_END
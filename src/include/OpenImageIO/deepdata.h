@@ -121,6 +121,20 @@ public:
     /// pixel index.
     int capacity(int64_t pixel) const;
 
+    /// Set the capacity of samples for all pixels (never less than the
+    /// samples they already have). The capacity.size() is required to match
+    /// pixels(). If the data is already allocated, capacities are only
+    /// expanded, and the samples are moved just once for all the pixels,
+    /// rather than once for each pixel whose capacity is raised.
+    void set_all_capacity(cspan<unsigned int> capacity);
+
+    /// Reserve room for a total of `nsamples` samples (for all pixels), so
+    /// that raising capacities after the data is allocated doesn't
+    /// reallocate all the samples until that total is exceeded. This helps
+    /// callers that know about how many samples there will be in all,
+    /// before they know how many each pixel will have.
+    void reserve(size_t nsamples);
+
     /// Insert `n` samples of the specified pixel, betinning at the sample
     /// position index. After insertion, the new samples will have
     /// uninitialized values.
@@ -137,6 +151,14 @@ public:
     /// cast to a `uint32`.
     uint32_t deep_value_uint(int64_t pixel, int channel, int sample) const;
 
+    /// Retrieve the values of channel `channel` of the pixel's samples,
+    /// cast to `float`, into the contiguous array `values` (of at most
+    /// `values.size()` samples). Gathering one channel of all the samples
+    /// at once, rather than one sample of all the channels, is the fast way
+    /// to examine a few channels (such as alpha and depth) of every sample.
+    /// Return the number of samples retrieved.
+    int deep_values(int64_t pixel, int channel, span<float> values) const;
+
     /// Set the value of the given pixel, channel, and sample index, for
     /// floating-point channels.
     void set_deep_value(int64_t pixel, int channel, int sample, float value);
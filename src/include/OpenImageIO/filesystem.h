@@ -18,10 +18,12 @@
 
 #define OIIO_FILESYSTEM_H
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdio>
 #include <ctime>
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -129,7 +131,9 @@ OIIO_UTIL_API std::string find_program(string_view program);
 /// non-empty, only filenames matching the regular expression will be
 /// returned.  Return true if ok, false if there was an error (such as
 /// dirname not being found or not actually being a directory). All file
-/// and directory names are presumed to be UTF-8 encoded.
+/// and directory names are presumed to be UTF-8 encoded. A recursive
+/// listing reads the subdirectories in parallel, but still lists each
+/// subdirectory just before its contents.
 OIIO_UTIL_API bool get_directory_entries (const std::string &dirname,
                                std::vector<std::string> &filenames,
                                bool recursive = false,
@@ -395,6 +399,14 @@ OIIO_UTIL_API bool scan_for_matching_filenames (const std::string &pattern,
                                            std::vector<int> &numbers,
                                            std::vector<std::string> &filenames);
 
+/// Turn on or off (the default) an in-process cache of the directory
+/// listings read by scan_for_matching_filenames(), which saves reading a
+/// large directory again for each of repeated sequence expansions, and
+/// forget any listings cached so far. A cached listing is only used while
+/// the directory's modification time is unchanged -- but beware that a
+/// network file system client may itself cache that time for a while.
+OIIO_UTIL_API void cache_directory_listings(bool enable);
+
 /// Convert a UTF-8 encoded filename into a regex-safe pattern -- any special
 /// regex characters `.`, `(`, `)`, `[`, `]`, `{`, `}` are backslashed. If
 /// `simple_glob` is also true, then replace `?` with `.?` and `*` with `.*`.
@@ -448,6 +460,36 @@ public:
     /// other function of IOProxy.
     virtual size_t pwrite (const void *buf, size_t size, int64_t offset);
 
+    /// One of the reads for pread_many(): `size` bytes starting at the
+    /// `offset` position into `buf[]`. Upon return, `nread` is the number
+    /// of bytes that were successfully read.
+    struct ReadRequest {
+        void* buf      = nullptr;
+        size_t size    = 0;
+        int64_t offset = 0;
+        size_t nread   = 0;
+
+        /// Were all the bytes read that a file of `filesize` bytes has
+        /// there? (So a read running past the end is complete when it
+        /// stops at the end, as pread() would, but one starting past the
+        /// end isn't.)
+        bool complete(int64_t filesize) const
+        {
+            if (offset < 0 || offset >= filesize)
+                return size == 0;
+            return nread == size_t(std::min(int64_t(size), filesize - offset));
+        }
+    };
+
+    /// Do all of the `requests`, as pread() would, returning true if every
+    /// one of them is complete(). Proxies that can have many reads
+    /// outstanding at once (an IOFile, where the OS allows it) submit them
+    /// all together, which keeps a fast device busy in a way that one
+    /// pread() at a time can't; the default just calls pread() for each.
+    /// As with pread(), this does not alter the current file position,
+    /// and is thread-safe against other calls to pread() and pread_many().
+    virtual bool pread_many (span<ReadRequest> requests);
+
     // Return the total size of the proxy data, in bytes.
     virtual size_t size () const { return 0; }
     virtual void flush() { }
@@ -500,6 +542,8 @@ public:
     size_t write(const void* buf, size_t size) override;
     size_t pread(void* buf, size_t size, int64_t offset) override;
     size_t pwrite(const void* buf, size_t size, int64_t offset) override;
+    // Uses io_uring on Linux and overlapped I/O on Windows, if available.
+    bool pread_many(span<ReadRequest> requests) override;
     size_t size() const override;
     void flush() override;
 
@@ -578,6 +622,127 @@ protected:
     cspan<unsigned char> m_buf;
 };
 
+
+
+/// IOProxy subclass for reading a file by mapping it into memory. Since it
+/// is an IOMemReader of the mapped bytes, readers that can work from a
+/// pointer to the whole file may use `buffer()` to access it without any
+/// copying, and read() and pread() copy straight out of the mapping. The
+/// mapping is hinted to the OS as being read sequentially, and read()
+/// asks for the pages ahead of the current position to be read in advance.
+///
+/// If the file can't be mapped, the proxy is not opened() and error()
+/// explains why. Note that the file must not be truncated while mapped,
+/// which would crash the process reading it on most systems.
+class OIIO_UTIL_API IOMMap : public IOMemReader {
+public:
+    IOMMap(string_view filename);
+    IOMMap(const std::wstring& filename)
+        : IOMMap(Strutil::utf16_to_utf8(filename)) {}
+    ~IOMMap() override;
+    const char* proxytype() const override { return "mmap"; }
+    void close() override;
+    size_t read(void* buf, size_t size) override;
+
+protected:
+    void* m_map             = nullptr;  // Start of the mapping, if any
+    void* m_mapping         = nullptr;  // Windows file mapping handle
+    int64_t m_readahead_end = 0;        // End of the range hinted so far
+};
+
+
+
+/// IOProxy subclass for reading that wraps another IOProxy, for which each
+/// read is expensive no matter how small it is -- a file on a high-latency
+/// network file system, or an object in a cloud store, for example. It
+/// reads the wrapped proxy only in whole blocks of `blocksize` bytes,
+/// keeping up to `maxblocks` of the most recently used blocks, so that the
+/// many small reads of a file's headers or chunk tables become a few
+/// large ones. Runs of adjacent missing blocks are fetched by a single
+/// read, and while the file is being read sequentially, the next
+/// `prefetch` blocks are read in advance by the default thread pool.
+/// Reads too large to benefit from the cache go straight to the wrapped
+/// proxy, as do the reads of a pread_many() that aren't all cached, which
+/// are passed on together to the wrapped proxy's pread_many().
+///
+/// The wrapped proxy must be opened for reading, and must stay valid for
+/// the lifetime of the IOReadAhead unless it is owned by it, and its
+/// pread() must be thread-safe as required of all IOProxy subclasses.
+class OIIO_UTIL_API IOReadAhead : public IOProxy {
+public:
+    IOReadAhead(IOProxy* src, size_t blocksize = 1 << 20, int maxblocks = 16,
+                int prefetch = 2);
+    /// Construct an IOReadAhead that takes ownership of `src`.
+    IOReadAhead(std::unique_ptr<IOProxy> src, size_t blocksize = 1 << 20,
+                int maxblocks = 16, int prefetch = 2);
+    ~IOReadAhead() override;
+    const char* proxytype() const override { return "readahead"; }
+    void close() override;
+    size_t read(void* buf, size_t size) override;
+    size_t pread(void* buf, size_t size, int64_t offset) override;
+    bool pread_many(span<ReadRequest> requests) override;
+    size_t size() const override;
+
+    /// The wrapped proxy.
+    IOProxy* source() const;
+    /// The number of reads of the wrapped proxy so far.
+    int64_t source_reads() const;
+
+protected:
+    struct Impl;
+    // Shared with any prefetches in flight
+    std::shared_ptr<Impl> m_impl;
+};
+
+
+
+/// IOProxy subclass for reading a file served over HTTP, such as an object
+/// in a cloud store, without downloading all of it: each read is an HTTP
+/// "Range" request for just the bytes wanted, sent on one of a pool of
+/// connections kept open for the next ones. The first 64 KB, which holds
+/// the headers of most image files, are fetched when it's opened, along
+/// with the size. pread_many() merges requests for nearby bytes into one
+/// range, and sends the ranges for the rest at once from the I/O thread
+/// pool, so that reading many tiles of a file costs about one round trip.
+///
+/// The URL is "http://host[:port]/path[?query]", or "s3://bucket/key",
+/// which is read from `$AWS_ENDPOINT_URL/bucket/key` if that's set, or
+/// else from "http://bucket.s3.amazonaws.com/key". Requests are not signed,
+/// so the objects must be public, or the URLs presigned. There is no TLS:
+/// "https" URLs fail to open with an explanatory error(). If the server
+/// doesn't support range requests, the proxy is not opened().
+class OIIO_UTIL_API IOHTTP : public IOProxy {
+public:
+    IOHTTP(string_view url, int timeout_ms = 30000);
+    ~IOHTTP() override;
+    const char* proxytype() const override { return "http"; }
+    void close() override;
+    size_t read(void* buf, size_t size) override;
+    size_t pread(void* buf, size_t size, int64_t offset) override;
+    bool pread_many(span<ReadRequest> requests) override;
+    size_t size() const override;
+
+    /// The number of HTTP requests made so far.
+    int64_t requests() const;
+
+protected:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+
+
+/// Is `name` a URL, rather than a file name: does it start with "http://",
+/// "https://", or "s3://"?
+OIIO_UTIL_API bool is_url(string_view name);
+
+/// Open `url` for reading as an image file: an IOHTTP, behind an
+/// IOReadAhead which keeps the most recently read blocks of it, so that
+/// the many small reads of a file's headers and its tile and strip offsets
+/// are made only once. The result is not opened() if the URL can't be
+/// read, and its error() says why.
+OIIO_UTIL_API std::unique_ptr<IOProxy> open_url(string_view url);
+
 };  // namespace Filesystem
 
 OIIO_NAMESPACE_END
@@ -5,10 +5,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include <OpenImageIO/export.h>
 #include <OpenImageIO/oiioversion.h>
+#include <OpenImageIO/span.h>
 #include <OpenImageIO/string_view.h>
 
 
@@ -156,4 +159,71 @@ protected:
 };
 
 
+
+/// FilterTable1D is a table of the values of a 1D filter (or of a separable
+/// 2D filter's horizontal or vertical part), sampled finely enough that
+/// linearly interpolating it is as good as evaluating the filter itself,
+/// but without a virtual call or any transcendental math. It's meant for
+/// inner loops that evaluate the same filter at many arbitrary offsets.
+///
+/// The table covers [-width/2, width/2] with evenly spaced samples that
+/// include both ends (and the center). Evaluating it anywhere outside that
+/// range gives 0. SIMD code may gather from `table()` directly: entry `i`
+/// is the filter's value at `i / scale() - offset()`.
+class OIIO_UTIL_API FilterTable1D {
+public:
+    /// The default number of table entries per unit of x.
+    static constexpr int default_resolution = 1024;
+
+    /// An empty table, which evaluates to 0 everywhere.
+    FilterTable1D() {}
+
+    /// Tabulate a 1D filter, with `resolution` entries per unit of x.
+    FilterTable1D(const Filter1D& filter,
+                  int resolution = default_resolution);
+
+    /// Tabulate a 2D filter's `xfilt()` (or, if `vertical` is true, its
+    /// `yfilt()`), which for a separable filter is one of its two factors.
+    FilterTable1D(const Filter2D& filter, bool vertical = false,
+                  int resolution = default_resolution);
+
+    /// The width of the tabulated filter.
+    float width() const { return 2.0f * m_offset; }
+
+    /// Evaluate the filter at x (relative to the filter center).
+    float operator()(float x) const
+    {
+        float t = (x + m_offset) * m_scale;
+        if (!(t >= 0.0f && t <= m_tmax))  // Also rejects NaN
+            return 0.0f;
+        int i   = std::min(int(t), int(m_table.size()) - 2);
+        float f = t - float(i);
+        return m_table[i] + f * (m_table[i + 1] - m_table[i]);
+    }
+
+    /// Evaluate the filter at each of the `x` values, into `result`, which
+    /// must be at least as long.
+    void operator()(cspan<float> x, span<float> result) const
+    {
+        for (size_t i = 0, n = x.size(); i < n; ++i)
+            result[i] = (*this)(x[i]);
+    }
+
+    /// The table's entries, of which there are `size()`.
+    const float* table() const { return m_table.data(); }
+    int size() const { return int(m_table.size()); }
+    /// The table index of x is `(x + offset()) * scale()`.
+    float offset() const { return m_offset; }
+    float scale() const { return m_scale; }
+
+private:
+    std::vector<float> m_table;
+    float m_offset = 0.0f;  // Half the width
+    float m_scale  = 0.0f;  // Entries per unit of x
+    float m_tmax   = -1.0f;  // Index of the last entry (<0 if empty)
+
+    template<class FUNC> void init(float width, int resolution, FUNC&& f);
+};
+
+
 OIIO_NAMESPACE_END
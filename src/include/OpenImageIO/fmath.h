@@ -826,6 +826,13 @@ inline void convert_type<uint8_t,float> (const uint8_t *src,
                                          float /*_min*/, float /*_max*/)
 {
     float scale (1.0f/std::numeric_limits<uint8_t>::max());
+#if OIIO_SIMD_AVX >= 2
+    simd::vfloat8 scale_simd8 (scale);
+    for ( ; n >= 8; n -= 8, src += 8, dst += 8) {
+        simd::vfloat8 d_simd = simd::vfloat8(src) * scale_simd8;
+        d_simd.store (dst);
+    }
+#endif
     simd::vfloat4 scale_simd (scale);
     for ( ; n >= 4; n -= 4, src += 4, dst += 4) {
         simd::vfloat4 s_simd (src);
@@ -844,6 +851,13 @@ inline void convert_type<uint16_t,float> (const uint16_t *src,
                                           float /*_min*/, float /*_max*/)
 {
     float scale (1.0f/std::numeric_limits<uint16_t>::max());
+#if OIIO_SIMD_AVX >= 2
+    simd::vfloat8 scale_simd8 (scale);
+    for ( ; n >= 8; n -= 8, src += 8, dst += 8) {
+        simd::vfloat8 d_simd = simd::vfloat8(src) * scale_simd8;
+        d_simd.store (dst);
+    }
+#endif
     simd::vfloat4 scale_simd (scale);
     for ( ; n >= 4; n -= 4, src += 4, dst += 4) {
         simd::vfloat4 s_simd (src);
@@ -863,6 +877,15 @@ convert_type<float,uint16_t> (const float *src, uint16_t *dst, size_t n,
     float min = std::numeric_limits<uint16_t>::min();
     float max = std::numeric_limits<uint16_t>::max();
     float scale = max;
+#if OIIO_SIMD_AVX >= 2
+    simd::vfloat8 max_simd8 (max);
+    simd::vfloat8 zero_simd8 (0.0f);
+    for ( ; n >= 8; n -= 8, src += 8, dst += 8) {
+        simd::vfloat8 scaled = simd::round (simd::vfloat8(src) * max_simd8);
+        simd::vint8 i (clamp (scaled, zero_simd8, max_simd8));
+        i.store (dst);
+    }
+#endif
     simd::vfloat4 max_simd (max);
     simd::vfloat4 zero_simd (0.0f);
     for ( ; n >= 4; n -= 4, src += 4, dst += 4) {
@@ -884,6 +907,15 @@ convert_type<float,uint8_t> (const float *src, uint8_t *dst, size_t n,
     float min = std::numeric_limits<uint8_t>::min();
     float max = std::numeric_limits<uint8_t>::max();
     float scale = max;
+#if OIIO_SIMD_AVX >= 2
+    simd::vfloat8 max_simd8 (max);
+    simd::vfloat8 zero_simd8 (0.0f);
+    for ( ; n >= 8; n -= 8, src += 8, dst += 8) {
+        simd::vfloat8 scaled = simd::round (simd::vfloat8(src) * max_simd8);
+        simd::vint8 i (clamp (scaled, zero_simd8, max_simd8));
+        i.store (dst);
+    }
+#endif
     simd::vfloat4 max_simd (max);
     simd::vfloat4 zero_simd (0.0f);
     for ( ; n >= 4; n -= 4, src += 4, dst += 4) {
@@ -2046,7 +2078,9 @@ OIIO_FORCEINLINE OIIO_HOSTDEVICE float fast_safe_pow (float x, float y) {
 }
 
 
-// Fast simd pow that only needs to work for positive x
+// Fast simd pow that only needs to work for positive x. For any of float,
+// vfloat4, vfloat8, or vfloat16, the relative error is about 1.5e-5 as long
+// as the result is a normal float (|y * log2(x)| < 126).
 template<typename T, typename U>
 OIIO_FORCEINLINE OIIO_HOSTDEVICE T fast_pow_pos (const T& x, const U& y) {
     return fast_exp2(y * fast_log2(x));
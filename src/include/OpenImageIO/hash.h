@@ -16,6 +16,8 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -616,4 +618,57 @@ private:
 };
 
 
+
+/// Class that encapsulates a fast 128-bit hash for fingerprinting large
+/// amounts of data, such as the pixels of whole images. It's not
+/// cryptographic-strength, but is many times faster than SHA-1 and has a
+/// negligible chance of accidental collisions. The hash depends only on
+/// the bytes appended, not how they were divided among calls to append(),
+/// and it's the same on all platforms and in all builds (it's the seeded
+/// 128-bit CityHash of each 64 KB chunk, chained through the seeds), so it
+/// is suitable for storing in files.
+class OIIO_API FastHash128 {
+public:
+    /// Create FastHash128, optionally read data
+    FastHash128 (const void *data=NULL, size_t size=0);
+    ~FastHash128 ();
+
+    /// Append more data
+    void append (const void *data, size_t size);
+
+    /// Append more data from a string_view
+    void append (string_view s) {
+        append(s.data(), s.size());
+    }
+
+    /// Append more data from a span, without thinking about sizes.
+    template<typename T> void append (span<T> v) {
+        append (v.data(), v.size()*sizeof(T));
+    }
+
+    /// Type for storing the raw bits of the hash
+    struct Hash {
+        uint64_t lo, hi;
+    };
+
+    /// Return the hash of all the data appended so far. More data may
+    /// still be appended afterwards.
+    Hash gethash () const;
+
+    /// Return the hash as a hex string of 32 digits
+    std::string digest () const;
+
+    /// Roll the whole thing into one functor, return the string digest.
+    static std::string digest (const void *data, size_t size) {
+        FastHash128 h (data, size);  return h.digest();
+    }
+
+private:
+    std::unique_ptr<char[]> m_buffer;  // Partial chunk not yet hashed
+    size_t m_buffered = 0;
+    uint64_t m_length = 0;             // Total bytes appended
+    uint64_t m_state[2];               // Hash of the chunks so far
+};
+
+
 OIIO_NAMESPACE_END
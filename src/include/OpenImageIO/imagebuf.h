@@ -147,13 +147,21 @@ public:
             /// owned by the calling application. The caller will continue
             /// to own that memory and be responsible for freeing it after
             /// the ImageBuf is destroyed.
-        IMAGECACHE
+        IMAGECACHE,
             ///< The ImageBuf is "backed" by an ImageCache, which will
             /// automatically be used to retrieve pixels when requested, but
             /// the ImageBuf will not allocate separate storage for it. 
             /// This brings all the advantages of the ImageCache, but can
             /// only be used for read-only ImageBuf's that reference a
             /// stored image file.
+        DEVICEBUFFER
+            ///< The current pixels are in compute device (GPU) memory,
+            /// where a GPU-accelerated ImageBufAlgo function left them for
+            /// the next one to use. Any access to them from the host
+            /// copies them back to the local buffer, and the storage
+            /// becomes `LOCALBUFFER` again. This is experimental, and only
+            /// happens in builds with the `OIIO_CUDA_IBA_EXPERIMENTAL`
+            /// option.
         // clang-format on
     };
 
@@ -287,7 +295,15 @@ public:
     ImageBuf(const ImageSpec& spec, void* buffer, stride_t xstride = AutoStride,
              stride_t ystride = AutoStride, stride_t zstride = AutoStride);
 
-    /// Construct a copy of an ImageBuf.
+    /// Construct a copy of an ImageBuf. If "imagebuf:copy_on_write" is
+    /// turned on, a copy of an image holding its own pixels shares them
+    /// until either is written.
+    ///
+    /// @warning With copy on write on, a pointer obtained from the
+    ///     non-const `localpixels()` or `pixeladdr()` (or an `Iterator`)
+    ///     *before* the copy was made still points into the shared
+    ///     buffer, so writing through it afterwards changes the copy too.
+    ///     Ask for writable access again after copying.
     ImageBuf(const ImageBuf& src);
 
     /// Move the contents of an ImageBuf to another ImageBuf.
@@ -511,6 +527,81 @@ public:
               TypeDesc convert, ProgressCallback progress_callback = nullptr,
               void* progress_callback_data = nullptr);
 
+    /// Read the pixels of a subimage and MIP level of the file `filename`
+    /// straight into the pixel memory this ImageBuf already has (its own
+    /// or, most usefully, an app buffer it wraps), converting them to that
+    /// memory's data type and strides as they are decoded, so that they
+    /// are written only once. The buffer keeps its type and layout, and
+    /// the rest of the spec (metadata, data window, channel names) becomes
+    /// that of the file. This is the cheapest way to read a sequence of
+    /// frames into the same buffer, in whatever form the app needs them:
+    ///
+    ///     ImageBuf frame(spec, span(mybuffer), nullptr, xstride, ystride);
+    ///     for (auto& name : filenames)
+    ///         ok &= frame.read_into(name);
+    ///
+    /// @param filename
+    ///             The file to read.
+    /// @param subimage/miplevel
+    ///             The subimage and MIP level to read.
+    /// @param chbegin/chend
+    ///             The range of channels to read (by default, all of
+    ///             them). Their number must be the number of channels of
+    ///             the ImageBuf.
+    /// @param config/ioproxy
+    ///             Optional configuration hints and IOProxy for opening
+    ///             the file, as for the ImageBuf constructor.
+    /// @param  progress_callback/progress_callback_data
+    ///             As for `read()`.
+    ///
+    /// @returns
+    ///             `true` upon success, or `false` if the read failed, in
+    ///             which case the contents of the buffer are undefined.
+    ///             It is an error for the ImageBuf not to hold writable
+    ///             local or app pixels, or for the resolution of the file
+    ///             to differ from that of the ImageBuf.
+    bool read_into(string_view filename, int subimage = 0, int miplevel = 0,
+                   int chbegin = 0, int chend = -1,
+                   const ImageSpec* config            = nullptr,
+                   Filesystem::IOProxy* ioproxy       = nullptr,
+                   ProgressCallback progress_callback = nullptr,
+                   void* progress_callback_data       = nullptr);
+
+    /// Read several subimages (at MIP level 0) of the file `filename`
+    /// concurrently, each into a new ImageBuf with local pixels, as
+    /// `read(subimage, 0, true, convert)` would. The parts of a multi-part
+    /// OpenEXR or the directories of a multi-image TIFF are otherwise read
+    /// one after another, since a single ImageInput can only seek to one
+    /// subimage at a time; here, a few ImageInputs on the same file are
+    /// shared among the threads, so that the parts are decompressed in
+    /// parallel without reopening the file for each of them:
+    ///
+    ///     std::vector<ImageBuf> parts = ImageBuf::read_subimages("aovs.exr");
+    ///
+    /// @param filename
+    ///             The file to read.
+    /// @param subimages
+    ///             The subimages to read, or all of them if empty.
+    /// @param convert
+    ///             The data type of the pixels, or `TypeUnknown` (the
+    ///             default) for that of each subimage.
+    /// @param config
+    ///             Optional configuration hints for opening the file.
+    /// @param nthreads
+    ///             The number of threads to use (0 means the global
+    ///             `threads` attribute).
+    ///
+    /// @returns
+    ///             One ImageBuf per requested subimage, in the same order.
+    ///             An ImageBuf that could not be read is uninitialized and
+    ///             holds the error. If the file could not be opened at
+    ///             all, the result is empty and the error may be retrieved
+    ///             with the global `OIIO::geterror()`.
+    static std::vector<ImageBuf>
+    read_subimages(string_view filename, cspan<int> subimages = {},
+                   TypeDesc convert = TypeUnknown,
+                   const ImageSpec* config = nullptr, int nthreads = 0);
+
     /// Read the ImageSpec for the given file, subimage, and MIP level into
     /// the ImageBuf, but will not read the pixels or allocate any local
     /// storage (until a subsequent call to `read()`).  This is helpful if
@@ -696,6 +787,12 @@ public:
     /// channels.  The data type of the pixels will be converted
     /// automatically to the data type of the app buffer.
     ///
+    /// If "imagebuf:copy_on_write" is turned on, copying the pixels of an
+    /// image that holds its own, without changing their type, takes
+    /// constant time: the two share them until either is written (with
+    /// the same caution about earlier writable pointers as for the copy
+    /// constructor).
+    ///
     /// @param  src
     ///             Another ImageBuf from which to copy the pixels and
     ///             metadata.
@@ -709,6 +806,22 @@ public:
     ///             `true` upon success or `false` upon error/failure.
     bool copy(const ImageBuf& src, TypeDesc format = TypeUnknown);
 
+    /// Make `*this` a copy of just channels `[chbegin, chend)` of `src`
+    /// (with the same metadata, and the names of those channels), in
+    /// constant time: a view that shares the pixel memory of `src`, as
+    /// `copy()` does, until either is written, at which point this one
+    /// gets its own compact copy of those channels. Until then, its pixel
+    /// stride is that of `src` and so it is not `contiguous()`.
+    ///
+    /// @returns
+    ///             `true` upon success, or `false` (with no error) if
+    ///             this isn't possible because `src` isn't an image whose
+    ///             pixels it holds in memory, is deep, or has per-channel
+    ///             data formats, `*this` wraps an application buffer, or
+    ///             "imagebuf:copy_on_write" is turned off. The caller can
+    ///             then copy the channels instead.
+    bool share_channels(const ImageBuf& src, int chbegin, int chend);
+
     /// Return a full copy of `this` ImageBuf (optionally with an explicit
     /// data format conversion).
     ImageBuf copy(TypeDesc format /*= TypeDesc::UNKNOWN*/) const;
@@ -1055,8 +1168,9 @@ public:
     /// enumerated type describing the type of storage currently employed by
     /// the ImageBuf: `UNINITIALIZED` (no storage), `LOCALBUFFER` (the
     /// ImageBuf has allocated and owns the pixel memory), `APPBUFFER` (the
-    /// ImageBuf "wraps" memory owned by the calling application), or
-    /// `IMAGECACHE` (the image is backed by an ImageCache).
+    /// ImageBuf "wraps" memory owned by the calling application),
+    /// `IMAGECACHE` (the image is backed by an ImageCache), or
+    /// `DEVICEBUFFER` (the pixels are in compute device memory).
     IBStorage storage() const;
 
     /// Return a read-only (const) reference to the image spec that
@@ -1239,9 +1353,30 @@ public:
     /// `pixel_stride()`, `scanline_stride()`, and `z_stride()` methods
     /// to find out the spacing between pixels, scanlines, and volumetric
     /// planes, respectively.
+    ///
+    /// If "imagebuf:copy_on_write" is on, the non-const version first
+    /// gives this ImageBuf its own pixels if it shares them with copies,
+    /// but the pointer must not be used to write after this ImageBuf is
+    /// copied again, because the copy would then share that memory.
     void* localpixels();
     const void* localpixels() const;
 
+    /// Return a raw pointer to the pixels in compute device memory, laid
+    /// out contiguously, if the storage is `DEVICEBUFFER`, or `nullptr`
+    /// otherwise. Unlike `localpixels()`, this doesn't move the pixels.
+    void* devicepixels();
+    const void* devicepixels() const;
+
+    /// Move the pixels of a contiguous `LOCALBUFFER` image to compute
+    /// device memory, making the storage `DEVICEBUFFER`, and return their
+    /// address there (or just return it, if they already are). If `copy`
+    /// is false, for a caller that will overwrite all of them, the device
+    /// pixels start out undefined. Return `nullptr`, changing nothing, if
+    /// the image doesn't qualify or there is no compute device (which is
+    /// always the case unless OIIO was built with the experimental
+    /// `OIIO_CUDA_IBA_EXPERIMENTAL` option).
+    void* to_device(bool copy = true);
+
     /// Pixel-to-pixel stride within the localpixels memory.
     stride_t pixel_stride() const;
     /// Scanline-to-scanline stride within the localpixels memory.
@@ -1566,6 +1701,57 @@ public:
         /// Increment to the next pixel in the region.
         void operator++(int) { ++(*this); }
 
+        /// The number of pixels, starting with the current one and going in
+        /// +x, that are in both this scanline of the iteration range and
+        /// the data window, and also adjacent in memory, `pixel_stride()`
+        /// bytes apart, which for an image backed by an ImageCache means
+        /// in the same tile. It is 0 for deep images, or if the current
+        /// pixel is outside the data window (so its values come from the
+        /// wrap mode), where only pixel-at-a-time access applies.
+        ///
+        /// Along with `run()` and `advance()`, this lets an inner loop work
+        /// directly on a run of pixels in the buffer:
+        ///
+        ///     for (ImageBuf::ConstIterator<float> s(src, roi); !s.done();) {
+        ///         if (int n = s.run_length()) {
+        ///             cspan<float> vals = s.run();  // n pixels, contiguous
+        ///             ...
+        ///             s.advance(n);
+        ///         } else {
+        ///             ...  // just the pixel s[c]
+        ///             ++s;
+        ///         }
+        ///     }
+        ///
+        int run_length() const
+        {
+            if (!m_valid || !m_exists || m_deep || !m_proxydata
+                || (!m_localpixels && !m_tile))
+                return 0;
+            int end = std::min(m_rng_xend, m_img_xend);
+            if (!m_localpixels)
+                end = std::min(end, m_tilexend);
+            return end - m_x;
+        }
+
+        /// The distance in bytes between successive pixels of a run.
+        stride_t pixel_stride() const { return m_pixel_stride; }
+
+        /// Advance by `n` pixels in the iteration range, as `n` increments
+        /// would, but skipping straight over the (rest of the) run if `n` is
+        /// no more than `run_length()`.
+        void advance(int n)
+        {
+            if (n > 1 && n <= run_length()) {
+                m_x += n - 1;
+                m_proxydata += (n - 1) * m_pixel_stride;
+                ++(*this);
+            } else {
+                for (; n > 0; --n)
+                    ++(*this);
+            }
+        }
+
         /// Return the iteration range
         ROI range() const
         {
@@ -1820,6 +2006,26 @@ public:
 
         void* rawptr() const { return m_proxydata; }
 
+        /// The channel values of the `run_length()` pixels starting with the
+        /// current one, in place in the buffer, whose pixel type must be
+        /// `BUFT`. Pixel `i` of the run starts at element `i *
+        /// pixel_stride() / sizeof(BUFT)`, so for an image without extra
+        /// space between its pixels, the values are all contiguous. It is
+        /// empty if `run_length()` is 0, and valid only until the iterator
+        /// moves. An image backed by an ImageCache is made writable first,
+        /// as `set()` would.
+        span<BUFT> run()
+        {
+            OIIO_DASSERT(TypeDescFromC<BUFT>::value().basetype == m_pixeltype);
+            ensure_writable();
+            int n = run_length();
+            if (!n)
+                return {};
+            return { (BUFT*)m_proxydata,
+                     size_t((n - 1) * m_pixel_stride / stride_t(sizeof(BUFT))
+                            + m_nchannels) };
+        }
+
         // Load values from `span<T> src` into the pixel the iterator refers
         // to, doing any conversions necessary.
         template<typename T = float> void load(cspan<T> src)
@@ -1882,6 +2088,24 @@ public:
             ConstDataArrayProxy<BUFT, USERT> proxy((BUFT*)m_proxydata);
             return proxy[i];
         }
+
+        /// The channel values of the `run_length()` pixels starting with the
+        /// current one, in place in the buffer (or the ImageCache tile),
+        /// whose pixel type must be `BUFT`. Pixel `i` of the run starts at
+        /// element `i * pixel_stride() / sizeof(BUFT)`, so for an image
+        /// without extra space between its pixels, the values are all
+        /// contiguous. It is empty if `run_length()` is 0, and valid only
+        /// until the iterator moves.
+        cspan<BUFT> run() const
+        {
+            OIIO_DASSERT(TypeDescFromC<BUFT>::value().basetype == m_pixeltype);
+            int n = run_length();
+            if (!n)
+                return {};
+            return { (const BUFT*)m_proxydata,
+                     size_t((n - 1) * m_pixel_stride / stride_t(sizeof(BUFT))
+                            + m_nchannels) };
+        }
     };
 
 
@@ -81,6 +81,16 @@ class Filter2D;
 /// (for example, add(A,A,B) adds B into existing image A, with no third
 /// image allocated at all).
 ///
+/// Operations that compute each pixel from the same pixel of their inputs
+/// (arithmetic, color transforms, and so on) work truly in place when `dst`
+/// is also an input, with no copy. So do flip(), flop(), and rotate180() of
+/// a whole in-memory image whose data window is centered in its display
+/// window, by swapping pixels. Other operations given `dst` as their input
+/// (resize, warp, convolve, and so on) read from a copy-on-write share of
+/// it, so that its pixels are copied once, when `dst` is first written; if
+/// the ImageBuf pixel pool is enabled (the `imagebuf:pool_MB` attribute),
+/// repeating the operation reuses the buffer that the last one freed.
+///
 /// **Region of interest**
 ///
 /// Most ImageBufAlgo functions take an optional ROI parameter that
@@ -366,6 +376,11 @@ enum class TextAlignY { Baseline, Top, Bottom, Center };
 /// number of common system font areas, including `/usr/share/fonts`,
 /// `/Library/fonts`, and `C:/Windows/fonts`; (d) in fonts directories one
 /// level up from the place where the currently running binary lives.
+///
+/// Opened fonts and their rasterized glyphs (for each font, size, and
+/// character) are kept for the life of the process, so rendering the same
+/// or similar text again -- a burn-in on every frame, for example -- is
+/// much cheaper than the first time.
 bool OIIO_API render_text (ImageBuf &dst, int x, int y, string_view text,
                            int fontsize=16, string_view fontname="",
                            cspan<float> textcolor = 1.0f,
@@ -392,6 +407,11 @@ ROI OIIO_API text_size (string_view text, int fontsize=16,
 /// fill value in `channelvalues[i]`. In-place operation is allowed (i.e.,
 /// `dst` and `src` the same image, but an extra copy will occur).
 ///
+/// Selecting a run of consecutive channels of an image in memory, such as
+/// the RGB of a many-channel image, takes constant time: the result is a
+/// view that shares the pixels of `src` until either is written (see
+/// `ImageBuf::share_channels()`).
+///
 /// @param  nchannels
 ///             The total number of channels that will be set up in the
 ///             `dst` image.
@@ -910,6 +930,76 @@ bool OIIO_API st_warp (ImageBuf &dst, const ImageBuf &src,
 /// @}
 
 
+/// @defgroup warp_plan (warp_plan: a warp computed once, applied often)
+/// @{
+///
+/// A `WarpPlan` holds, for each output pixel of a `warp()` or `st_warp()`,
+/// which source pixels it reads and with what (normalized) filter weights.
+/// Making one does all the work of those functions except reading the
+/// source pixels, so when the same warp (such as a lens distortion ST map)
+/// is applied to many images, say every frame of a shot, applying the
+/// plan to each one is just a gather and weighted sum per pixel:
+///
+///     auto plan = ImageBufAlgo::make_st_warp_plan(frame0.spec(), stmap);
+///     for (auto& frame : frames)
+///         ImageBuf undistorted = ImageBufAlgo::warp(frame, plan);
+///
+/// The result is what `warp()` or `st_warp()` would have computed (up to
+/// float rounding) into an uninitialized `dst`, for any source with the
+/// same data and display windows as `srcspec`. The plan takes roughly 8
+/// bytes per output pixel per filter tap, which `memory()` tells. Copies
+/// of a WarpPlan share the same tables.
+class OIIO_API WarpPlan {
+public:
+    struct Impl;  ///< Implementation detail
+
+    /// An uninitialized plan.
+    WarpPlan() {}
+    explicit WarpPlan(std::shared_ptr<const Impl> impl)
+        : m_impl(std::move(impl))
+    {
+    }
+
+    bool initialized() const { return bool(m_impl); }
+    /// The region of the output that the plan computes.
+    ROI roi() const;
+    /// The bytes of memory used by the plan.
+    size_t memory() const;
+    const std::shared_ptr<const Impl>& impl() const { return m_impl; }
+
+private:
+    std::shared_ptr<const Impl> m_impl;
+};
+
+/// Plan `warp(dst, src, M, options, roi)` for an uninitialized `dst` and
+/// a `src` like `srcspec`. Upon failure, return an uninitialized plan and
+/// set an error retrievable with `OIIO::geterror()`.
+WarpPlan OIIO_API make_warp_plan (const ImageSpec &srcspec, M33fParam M,
+                                  KWArgs options = {}, ROI roi = {},
+                                  int nthreads = 0);
+
+/// Plan `st_warp(dst, src, stbuf, ...)` for an uninitialized `dst` and a
+/// `src` like `srcspec`. Upon failure, return an uninitialized plan and
+/// set an error retrievable with `OIIO::geterror()`.
+WarpPlan OIIO_API make_st_warp_plan (const ImageSpec &srcspec,
+                                     const ImageBuf& stbuf,
+                                     string_view filtername=string_view(),
+                                     float filterwidth=0.0f, int chan_s=0,
+                                     int chan_t=1, bool flip_s=false,
+                                     bool flip_t=false, ROI roi={},
+                                     int nthreads=0);
+
+/// Apply a warp `plan` to `src`, whose data and display windows must be
+/// those it was made for. An uninitialized `dst` is allocated as the
+/// planned function would have; for an initialized one, just the part of
+/// the plan's region within it is computed.
+ImageBuf OIIO_API warp (const ImageBuf &src, const WarpPlan &plan,
+                        int nthreads=0);
+bool OIIO_API warp (ImageBuf &dst, const ImageBuf &src, const WarpPlan &plan,
+                    int nthreads=0);
+/// @}
+
+
 /// Compute per-pixel sum `A + B`, returning the result image.
 ///
 /// `A` and `B` may each either be an `ImageBuf&`, or a `cspan<float>`
@@ -1035,6 +1125,17 @@ ImageBuf OIIO_API over (const ImageBuf &A, const ImageBuf &B,
 bool OIIO_API over (ImageBuf &dst, const ImageBuf &A, const ImageBuf &B,
                     ROI roi={}, int nthreads=0);
 
+/// Composite a whole stack of images: `layers[0]` over `layers[1]` over
+/// ... over `layers[n-1]`, with the same requirements on the images as
+/// `over()` has, always computing all channels. The whole stack is done in
+/// a single pass over the pixels, in float, rather than making (and
+/// rounding to the type of `dst`) an intermediate image for each layer.
+ImageBuf OIIO_API over (cspan<const ImageBuf*> layers,
+                        ROI roi={}, int nthreads=0);
+/// Write to an existing image `dst` (allocating if it is uninitialized).
+bool OIIO_API over (ImageBuf &dst, cspan<const ImageBuf*> layers,
+                    ROI roi={}, int nthreads=0);
+
 
 /// Just like `ImageBufAlgo::over()`, but inputs `A` and `B` must have
 /// designated 'z' channels, and on a pixel-by-pixel basis, the z values
@@ -1068,6 +1169,11 @@ bool OIIO_API invert (ImageBuf &dst, const ImageBuf &A, ROI roi={}, int nthreads
 /// `A` is always an image, and `B` is either an image or a `cspan<float>`
 /// giving a per-channel constant or a single constant used for all
 /// channels.
+///
+/// Powers of positive, finite values are computed with a fast SIMD
+/// approximation that is within a relative error of about 2e-5; all other
+/// cases (zero, negative, infinite, or NaN values, or results that would
+/// overflow or underflow) are the same as `std::pow`.
 ImageBuf OIIO_API pow (const ImageBuf &A, cspan<float> B,
                        ROI roi={}, int nthreads=0);
 /// Write to an existing image `dst` (allocating if it is uninitialized).
@@ -1340,7 +1446,9 @@ bool OIIO_API color_map (ImageBuf &dst, const ImageBuf &src, int srcchannel,
 /// captured or rendered images).  By compressing the range pixel values,
 /// then performing the operation, then expanding the range of the result
 /// again, the result can be much more pleasing (even if not exactly
-/// correct).
+/// correct). They use fast SIMD approximations of log and exp, so that an
+/// expansion of a compression is within a relative error of about 1e-5 of
+/// the original value.
 
 ImageBuf OIIO_API rangecompress (const ImageBuf &src, bool useluma = false,
                                  ROI roi={}, int nthreads=0);
@@ -1364,11 +1472,13 @@ struct OIIO_API PixelStats {
     std::vector<double> sum, sum2;  // for intermediate calculation
 
     PixelStats () {}
+    PixelStats (const PixelStats& other) = default;
     PixelStats (PixelStats&& other) = default;
     PixelStats (int nchannels) { reset(nchannels); }
     void reset (int nchannels);
     void merge (const PixelStats &p);
     const PixelStats& operator= (PixelStats&& other);  // Move assignment
+    PixelStats& operator= (const PixelStats& other) = default;
 };
 
 
@@ -1444,6 +1554,16 @@ int OIIO_API compare_Yee (const ImageBuf &A, const ImageBuf &B,
                           float luminance = 100, float fov = 45,
                           ROI roi={}, int nthreads=0);
 
+/// Like the above, but stop comparing once more than `maxfail` pixels
+/// have failed, when all that matters is whether the images are within
+/// a failure budget. If it stops early, the count returned (and the
+/// maxerror and location) reflect only the pixels compared so far, so it
+/// is some number larger than `maxfail`, not the total.
+int OIIO_API compare_Yee (const ImageBuf &A, const ImageBuf &B,
+                          CompareResults &result, float luminance,
+                          float fov, ROI roi, int nthreads,
+                          imagesize_t maxfail);
+
 
 /// Do all pixels within the ROI have the same values for channels
 /// `[roi.chbegin..roi.chend-1]`, within a tolerance of +/- `threshold`?  If
@@ -1533,6 +1653,49 @@ bool OIIO_API color_range_check (const ImageBuf &src,
 OIIO_API ROI nonzero_region (const ImageBuf &src, ROI roi={}, int nthreads=0);
 
 
+/// Results of `analyze()`. Only the members for the analyses that were
+/// asked for are meaningful.
+struct ImageAnalysis {
+    PixelStats stats;                   ///< As from computePixelStats()
+    bool constant = false;              ///< As from isConstantColor()
+    std::vector<float> constant_color;  ///< The color, if constant
+    bool monochrome = false;            ///< As from isMonochrome()
+    imagesize_t lowcount     = 0;       ///< As from color_range_check()
+    imagesize_t highcount    = 0;
+    imagesize_t inrangecount = 0;
+    ROI nonzero_region;                 ///< As from nonzero_region()
+    bool error = false;                 ///< True if the analysis failed
+};
+
+/// Compute any of `computePixelStats()`, `isConstantColor()`,
+/// `isMonochrome()`, `color_range_check()`, and `nonzero_region()` for the
+/// ROI of `src` (by default, all of it), in a single pass over its pixels
+/// that reads (and converts to float) each of them just once, rather than
+/// once for each of those functions. Which are computed is given by
+/// `options`:
+///
+///   - `stats` (int: 1) : Nonzero to compute the pixel statistics.
+///   - `constant` (int: 1) : Nonzero to test whether all pixels are one
+///     color, and if so give it in `constant_color` (which, as with
+///     `isConstantColor()`, is zero for the channels outside the ROI).
+///   - `monochrome` (int: 1) : Nonzero to test whether all pixels are
+///     monochrome.
+///   - `threshold` (float: 0.0) : The tolerance of the constant and
+///     monochrome tests. As those functions do, a zero threshold demands
+///     exact equality, but these compare values converted to float.
+///   - `low`, `high` (float[nchannels]) : If either is given, range check
+///     against them (a missing one allows any value), counting pixels as
+///     `color_range_check()` does.
+///   - `nonzero_region` (int: 1) : Nonzero to find the region of nonzero
+///     pixels.
+///
+/// For deep images, only the stats and the nonzero region are computed,
+/// and not in a single pass. Upon failure, `error` is true in the result
+/// and an error is set in `src`.
+ImageAnalysis OIIO_API analyze (const ImageBuf &src, KWArgs options = {},
+                                ROI roi={}, int nthreads=0);
+
+
 /// Compute the SHA-1 byte hash for all the pixels in the specified region of
 /// the image.  If `blocksize` > 0, the function will compute separate SHA-1
 /// hashes of each `blocksize` batch of scanlines, then return a hash of the
@@ -1547,6 +1710,19 @@ std::string OIIO_API computePixelHashSHA1 (const ImageBuf &src,
                                            ROI roi={},
                                            int blocksize = 0, int nthreads=0);
 
+/// Compute a fast 128-bit hash (see `FastHash128` in hash.h) of the pixels
+/// in the specified region of the image, returned as 32 hex digits. It's
+/// meant for fingerprinting image content, much faster than the SHA-1 of
+/// `computePixelHashSHA1()` but not cryptographic. As there, the hash is of
+/// the hashes of each `blocksize` batch of scanlines, computed in parallel
+/// with `nthreads` threads (or a single hash of the whole region if
+/// `blocksize` is 0). The result depends on `blocksize`, but never on the
+/// number of threads, the order in which they finish, or the platform.
+std::string OIIO_API computePixelHash (const ImageBuf &src,
+                                       string_view extrainfo = "",
+                                       ROI roi={},
+                                       int blocksize = 256, int nthreads=0);
+
 
 /// Compute a histogram of `src`, for the given channel and ROI. Return a
 /// vector of length `bins` that contains the counts of how many pixel
@@ -1602,6 +1778,26 @@ ImageBuf OIIO_API convolve (const ImageBuf &src, const ImageBuf &kernel,
 bool OIIO_API convolve (ImageBuf &dst, const ImageBuf &src, const ImageBuf &kernel,
                         bool normalize = true, ROI roi={}, int nthreads=0);
 
+/// Convolution with optional parameters given as `options`:
+///
+///   - `normalize` (int: 1) : Nonzero to normalize the kernel, as above.
+///   - `method` (string: "auto") : How to compute it. "direct" sums the
+///     products of the kernel and the image about each pixel. "separable"
+///     runs a horizontal and then a vertical 1D convolution, requiring a
+///     2D kernel that is the product of a column and a row (as the
+///     "gaussian" and "box" kernels of `make_kernel()` are), whose cost is
+///     proportional to the kernel's width plus its height rather than its
+///     area. "fft" multiplies the Fourier transforms of the image and the
+///     kernel, for a cost that barely depends on the kernel size, and also
+///     requires a 2D kernel. "auto", as the `convolve` variants taking a
+///     `normalize` argument use, picks "separable" when the kernel
+///     allows, else "fft" for 2D kernels of 256 or more pixels, else
+///     "direct". All give the same result, up to floating-point rounding.
+ImageBuf OIIO_API convolve (const ImageBuf &src, const ImageBuf &kernel,
+                            KWArgs options, ROI roi={}, int nthreads=0);
+bool OIIO_API convolve (ImageBuf &dst, const ImageBuf &src, const ImageBuf &kernel,
+                        KWArgs options, ROI roi={}, int nthreads=0);
+
 
 /// Return the Laplacian of the corresponding region of `src`.  The
 /// Laplacian is the generalized second derivative of the image
@@ -1752,6 +1948,10 @@ bool OIIO_API fillholes_pushpull (ImageBuf &dst, const ImageBuf &src,
 /// Median filters are good for removing high-frequency detail smaller than
 /// the window size (including noise), without blurring edges that are
 /// larger than the window size.
+///
+/// For uint8 and uint16 images and windows of at least 7x7 (uint8) or
+/// 15x15 (uint16) pixels, the cost per pixel doesn't depend on the window
+/// size.
 ImageBuf OIIO_API median_filter (const ImageBuf &src,
                                  int width = 3, int height = -1,
                                  ROI roi={}, int nthreads=0);
@@ -1797,7 +1997,8 @@ bool OIIO_API unsharp_mask (ImageBuf &dst, const ImageBuf &src,
 /// the structuring element (which is taken to be a width x height square).
 /// If height is not set, it will default to be the same as width. Dilation
 /// makes bright features wider and more prominent, dark features thinner,
-/// and removes small isolated dark spots.
+/// and removes small isolated dark spots. The cost per pixel hardly
+/// depends on the window size.
 ImageBuf OIIO_API dilate (const ImageBuf &src, int width=3, int height=-1,
                           ROI roi={}, int nthreads=0);
 /// Write to an existing image `dst` (allocating if it is uninitialized).
@@ -1810,7 +2011,8 @@ bool OIIO_API dilate (ImageBuf &dst, const ImageBuf &src,
 /// the structuring element (which is taken to be a width x height square).
 /// If height is not set, it will default to be the same as width. Erosion
 /// makes dark features wider, bright features thinner, and removes small
-/// isolated bright spots.
+/// isolated bright spots. The cost per pixel hardly depends on the window
+/// size.
 ImageBuf OIIO_API erode (const ImageBuf &src, int width=3, int height=-1,
                          ROI roi={}, int nthreads=0);
 /// Write to an existing image `dst` (allocating if it is uninitialized).
@@ -1818,6 +2020,58 @@ bool OIIO_API erode (ImageBuf &dst, const ImageBuf &src,
                      int width=3, int height=-1, ROI roi={}, int nthreads=0);
 
 
+/// Return the summed-area table (also known as the integral image) of the
+/// corresponding region of the 2D image `src`: a `double` image of the
+/// same size and channels, each pixel of which is the sum of all the
+/// pixels of `src` at or above and to the left of it, within the ROI. The
+/// sum of any rectangle of `src` can then be had from just four pixels of
+/// the table, with `summed_area_sum()`, however big the rectangle is.
+ImageBuf OIIO_API summed_area_table (const ImageBuf &src, ROI roi={},
+                                     int nthreads=0);
+/// Write to `dst`, which is always reallocated as a `double` image.
+bool OIIO_API summed_area_table (ImageBuf &dst, const ImageBuf &src,
+                                 ROI roi={}, int nthreads=0);
+
+/// Store in `result[c]` the sum of channel `c` of the pixels of the image
+/// whose summed-area table is `sat` (made by `summed_area_table()`), over
+/// the rectangle [`xbegin`,`xend`) x [`ybegin`,`yend`), clipped to the
+/// table's region. Return the number of pixels in the clipped rectangle,
+/// or 0 if it is empty (and then the sums are 0, too).
+imagesize_t OIIO_API summed_area_sum (const ImageBuf &sat, int xbegin,
+                                      int xend, int ybegin, int yend,
+                                      span<double> result);
+
+
+/// Return a box-filtered version of the corresponding region of `src`:
+/// each pixel is the average of the pixels of `src` within the `width` x
+/// `height` window around it (only those inside the image, at its edges).
+/// If `height` <= 0, it will be set to `width`, making a square window.
+/// Since it is computed with a summed-area table, the cost per pixel is
+/// the same whatever the size of the window.
+ImageBuf OIIO_API box_filter (const ImageBuf &src, int width = 3,
+                              int height = -1, ROI roi={}, int nthreads=0);
+/// Write to an existing image `dst` (allocating if it is uninitialized).
+bool OIIO_API box_filter (ImageBuf &dst, const ImageBuf &src,
+                          int width = 3, int height = -1,
+                          ROI roi={}, int nthreads=0);
+
+/// Return a version of the corresponding region of `src` box-filtered with
+/// a different window at every pixel: the square window reaching `r`
+/// pixels to each side, where `r` is channel `radius_channel` of the same
+/// pixel of the image `radius` (0 leaves the pixel unchanged). Fractional
+/// radii blend between the two nearest whole ones, so that the result
+/// varies smoothly with the radius. As with the `box_filter()` of a fixed
+/// size, the cost per pixel doesn't depend on the radius, which makes this
+/// useful for approximating depth-dependent defocus or local contrast.
+ImageBuf OIIO_API box_filter (const ImageBuf &src, const ImageBuf &radius,
+                              int radius_channel = 0, ROI roi={},
+                              int nthreads=0);
+/// Write to an existing image `dst` (allocating if it is uninitialized).
+bool OIIO_API box_filter (ImageBuf &dst, const ImageBuf &src,
+                          const ImageBuf &radius, int radius_channel = 0,
+                          ROI roi={}, int nthreads=0);
+
+
 
 /// @defgroup colorconvert (Color space conversions)
 /// @{
@@ -2039,6 +2293,10 @@ bool OIIO_API ociodisplay (ImageBuf &dst, const ImageBuf &src,
 /// transformed, and the fourth channel (if it exists) is presumed to be
 /// alpha. Any additional channels will be simply copied unaltered.
 ///
+/// A `.cube` LUT file is applied directly by OIIO, interpolating a 3D LUT
+/// tetrahedrally, rather than through OpenColorIO -- unless `inverse` is
+/// true, or the global attribute "imagebufalgo:fastpaths" is 0.
+///
 /// @param  name
 ///             The name of the file containing the transform information.
 /// @param  unpremult
@@ -2195,6 +2453,36 @@ ImageBuf OIIO_API demosaic (const ImageBuf& src, KWArgs options = {},
 bool OIIO_API demosaic (ImageBuf& dst, const ImageBuf& src, KWArgs options = {},
                         ROI roi = {}, int nthreads = 0);
 
+
+/// Compute the tables for importance sampling the latitude-longitude
+/// environment map `src` in proportion to its luminance: `marginal`
+/// receives the CDF over rows, and `conditional` the CDF along each row.
+/// Each row's weight is scaled by the sine of its polar angle, so that the
+/// tables describe the distribution over directions rather than over
+/// pixels. Luminance uses Rec. 709 weights for sources with 3 or more
+/// channels, otherwise channel 0; negative and NaN values count as 0.
+///
+/// @param  marginal
+///             Reset to a 1-channel float image `height+1` pixels wide and
+///             1 high, increasing from 0 to 1. Pixel `j` is the probability
+///             of a direction in rows before `j`.
+/// @param  conditional
+///             Reset to a 1-channel float image `width+1` pixels wide and
+///             `height` high. Row `j` is the CDF of columns within row `j`,
+///             also from 0 to 1 (uniform for an all-black row).
+/// @param  width/height
+///             The resolution of the tables. If 0, it's that of `src`, and
+///             if only `height` is 0, it is half of `width` (the usual
+///             aspect ratio of an environment map). When it differs from
+///             the source's, the luminance is box-filtered to it first.
+///
+/// Together, they take `(width+1)*(height+1)` floats, which is small
+/// enough for `make_texture()` to store them in the texture as metadata
+/// (see `maketx:envcdf`).
+bool OIIO_API envlatl_cdf (ImageBuf &marginal, ImageBuf &conditional,
+                           const ImageBuf &src, int width = 0,
+                           int height = 0, int nthreads = 0);
+
 enum MakeTextureMode {
     MakeTxTexture, MakeTxShadow, MakeTxEnvLatl,
     MakeTxEnvLatlFromLightProbe,
@@ -2251,6 +2539,10 @@ enum MakeTextureMode {
 ///    - `maketx:opaque_detect` (int) :
 ///                           If nonzero, drop the alpha channel if alpha
 ///                           is 1.0 in all pixels (default: 0).
+///    - `maketx:tile_stats` (int) :
+///                           If nonzero, store the min, max, and average
+///                           of each channel of each tile as the
+///                           "oiio:TileStats" metadata (default: 0).
 ///    - `maketx:compute_average` (int) :
 ///                           If nonzero, compute and store the average
 ///                           color of the texture (default: 1).
@@ -2336,6 +2628,19 @@ enum MakeTextureMode {
 ///                           the sake of ImageBuf math. (1)
 ///    - `maketx:hash` (int) :
 ///                           Compute the sha1 hash of the file in parallel. (1)
+///    - `maketx:hashtype` (string) :
+///                           The hash stored as the fingerprint of the
+///                           pixels: "sha1" for the SHA-1 (`oiio:SHA-1`), or
+///                           "fast" for the much faster 128-bit hash of
+///                           `computePixelHash()` (`oiio:ContentHash`).
+///                           ("sha1")
+///    - `maketx:stream` (int) :
+///                           If nonzero, and making a plain texture from a
+///                           file without any option that needs the whole
+///                           image at once, read and process the input a
+///                           band of tile rows at a time, so that memory
+///                           use is proportional to the image width rather
+///                           than its size. (0)
 ///    - `maketx:allow_pixel_shift` (int) :
 ///                           Allow up to a half pixel shift per mipmap level.
 ///                           The fastest path may result in a slight shift
@@ -2376,6 +2681,21 @@ enum MakeTextureMode {
 ///                           When `maketx:cdf` is active, determines the
 ///                           number of bits to use for the size of the CDF
 ///                           table. (default: 8, meaning 256 bins)
+///    - `maketx:envcdf` (int) :
+///                           If nonzero, for a lat-long environment map,
+///                           store the tables of `envlatl_cdf()` in the
+///                           texture, as the metadata
+///                           `oiio:EnvCDFResolution` (int[2], the width
+///                           and height of the tables),
+///                           `oiio:EnvCDFMarginal` (float[height+1]), and
+///                           `oiio:EnvCDFConditional` (float[(width+1) *
+///                           height], row by row). Like `maketx:cdf`, this
+///                           needs a format with arbitrary metadata, such
+///                           as OpenEXR. (0)
+///    - `maketx:envcdfres` (int) :
+///                           When `maketx:envcdf` is active, the width of
+///                           the tables, at most that of the image; the
+///                           height keeps the image's aspect ratio. (512)
 ///
 /// @param  mode
 ///    Describes what type of texture file we are creating and may
@@ -2434,6 +2754,49 @@ bool OIIO_API make_texture (MakeTextureMode mode,
 /// @}
 
 
+/// @defgroup process_tiles (process_tiles -- compute huge images in strips)
+/// @{
+///
+/// Compute an image that may be far larger than memory, such as a
+/// gigapixel scan, writing it to `outputfilename` one row of tiles at a
+/// time, so that memory use is bounded by the width of the image rather
+/// than its area. The source images should be backed by an ImageCache
+/// (for example, `ImageBuf A(filename, 0, 0, ImageCache::create())`), so
+/// that only the tiles they are read from need be in memory.
+///
+/// For each tile of the output, `func(dst, srcs, roi)` must set the
+/// region `roi` of `dst`, an ImageBuf with the format and channels of
+/// `spec` that covers the current row of tiles, and return true for
+/// success (or false after setting an error in `dst`). `srcs` are local
+/// copies of the corresponding regions of the source images, grown by
+/// `halo` pixels on every side -- the reach of a neighborhood operation,
+/// such as 2 for a 5x5 filter -- with pixels outside a source's data
+/// window being zero. Tiles are computed in parallel, so `func` must be
+/// safe to call concurrently, and the IBA functions it calls should be
+/// asked to use a single thread:
+///
+///     ImageBuf A("huge.exr", 0, 0, ImageCache::create());
+///     ImageSpec spec = A.spec();
+///     spec.tile_width = spec.tile_height = 256;
+///     ImageBufAlgo::process_tiles("out.exr", spec, { &A }, 2,
+///         [](ImageBuf& dst, cspan<const ImageBuf*> srcs, ROI roi) {
+///             return ImageBufAlgo::median_filter(dst, *srcs[0], 5, 5,
+///                                                roi, 1);
+///         });
+///
+/// If `spec` has no tile size, or the output format doesn't support
+/// tiles, the image is written as scanlines, 64 at a time. Deep and
+/// volume images are not supported. Errors are retrievable with
+/// `OIIO::geterror()`.
+bool OIIO_API process_tiles (string_view outputfilename, const ImageSpec &spec,
+                             cspan<const ImageBuf*> srcs, int halo,
+                             function_view<bool(ImageBuf &dst,
+                                                cspan<const ImageBuf*> srcs,
+                                                ROI roi)> func,
+                             int nthreads=0);
+/// @}
+
+
 /// Return the "deep" equivalent of the "flat" input `src`. Turning a flat
 /// image into a deep one means:
 ///
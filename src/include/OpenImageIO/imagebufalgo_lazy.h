@@ -0,0 +1,135 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include <OpenImageIO/imagebufalgo.h>
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace ImageBufAlgo {
+
+
+/// A `LazyImage` is an ImageBufAlgo expression that has been recorded but
+/// not yet computed: an image, or an operation on other LazyImages.
+///
+/// Chaining ordinary IBA calls, such as a `colorconvert` of an image that
+/// is then composited `over` a background and scaled with `mul`, allocates
+/// a full-size intermediate image for every step and makes a full pass
+/// over memory for each. Built with the functions of `ImageBufAlgo::lazy`
+/// instead, the same chain (in general a DAG, since a LazyImage may be used
+/// more than once) is only computed by `lazy::evaluate()`, which runs all
+/// of the per-pixel operations one after another on a few scanlines at a
+/// time, in a single parallel pass, so that no intermediate result is ever
+/// held as a whole image:
+///
+///     using namespace ImageBufAlgo;
+///     LazyImage fg = lazy::colorconvert(FG, "sRGB", "linear");
+///     ImageBuf R   = lazy::evaluate(lazy::mul(lazy::over(fg, BG), 0.5f));
+///
+/// Operations that need more than the corresponding pixel of their inputs
+/// (`lazy::resize`, or any IBA function passed to `lazy::apply`) are
+/// computed in full, before that pass, and then read like a source image.
+///
+/// A LazyImage made from an ImageBuf only refers to it, so the ImageBuf
+/// must stay valid and unchanged until every evaluation using it is done.
+/// LazyImages are cheap to copy, and copies share the same expression.
+class OIIO_API LazyImage {
+public:
+    struct Node;  ///< Implementation detail
+
+    /// An uninitialized expression.
+    LazyImage() {}
+    /// The pixels of `img`, which must outlive the evaluation.
+    LazyImage(const ImageBuf& img);
+    explicit LazyImage(std::shared_ptr<Node> node)
+        : m_node(std::move(node))
+    {
+    }
+
+    bool initialized() const { return bool(m_node); }
+    const std::shared_ptr<Node>& node() const { return m_node; }
+
+private:
+    std::shared_ptr<Node> m_node;
+};
+
+
+
+namespace lazy {
+
+/// @defgroup lazy (lazy: deferred, fused evaluation of IBA operations)
+/// @{
+///
+/// Each of these records the same computation as the ImageBufAlgo function
+/// of the same name, with the same channel and alpha conventions. As with
+/// those, the result of an operation on two images covers the union of
+/// their data windows and has as many channels as the larger of them, and
+/// pixels or channels missing from one of the inputs read as zero.
+
+LazyImage OIIO_API add(const LazyImage& A, const LazyImage& B);
+LazyImage OIIO_API add(const LazyImage& A, cspan<float> B);
+LazyImage OIIO_API sub(const LazyImage& A, const LazyImage& B);
+LazyImage OIIO_API sub(const LazyImage& A, cspan<float> B);
+LazyImage OIIO_API mul(const LazyImage& A, const LazyImage& B);
+LazyImage OIIO_API mul(const LazyImage& A, cspan<float> B);
+/// As with `ImageBufAlgo::div()`, dividing by zero gives zero.
+LazyImage OIIO_API div(const LazyImage& A, const LazyImage& B);
+LazyImage OIIO_API div(const LazyImage& A, cspan<float> B);
+
+/// `A` composited over `B`, using the alpha channel of `A`, which it is an
+/// error for `A` not to have.
+LazyImage OIIO_API over(const LazyImage& A, const LazyImage& B);
+
+LazyImage OIIO_API clamp(const LazyImage& src,
+                         cspan<float> min = -std::numeric_limits<float>::max(),
+                         cspan<float> max = std::numeric_limits<float>::max(),
+                         bool clampalpha01 = false);
+
+/// Convert the first three channels from `fromspace` to `tospace`, as
+/// `ImageBufAlgo::colorconvert()` does. The color config (the default one
+/// if `colorconfig` is null) must outlive the evaluation.
+LazyImage OIIO_API colorconvert(const LazyImage& src, string_view fromspace,
+                                string_view tospace, bool unpremult = true,
+                                const ColorConfig* colorconfig = nullptr);
+
+/// Resize to the resolution of `roi`, as `ImageBufAlgo::resize()` would.
+/// This is computed in full before the rest of the expression.
+LazyImage OIIO_API resize(const LazyImage& src, KWArgs options, ROI roi);
+
+/// Record a call of `func` (which may be any ImageBufAlgo function, or
+/// anything else returning an ImageBuf) on the evaluated `src`, and the
+/// number of threads to use. Its result, or its error if it has one, is
+/// computed in full before the rest of the expression:
+///
+///     LazyImage blurred = lazy::apply(src, [](const ImageBuf& src, int nt) {
+///         return ImageBufAlgo::median_filter(src, 3, 3, {}, nt);
+///     });
+///
+LazyImage OIIO_API
+apply(const LazyImage& src,
+      std::function<ImageBuf(const ImageBuf& src, int nthreads)> func);
+
+/// Compute `expr` over the region of interest (by default, all of it) into
+/// `dst`, allocating it if it is uninitialized. Since each pixel is read
+/// before it is written, `dst` may also be one of the images in the
+/// expression.
+bool OIIO_API evaluate(ImageBuf& dst, const LazyImage& expr, ROI roi = {},
+                       int nthreads = 0);
+/// Return the result of `expr` as a new ImageBuf.
+ImageBuf OIIO_API evaluate(const LazyImage& expr, ROI roi = {},
+                           int nthreads = 0);
+
+/// @}
+
+}  // namespace lazy
+
+}  // namespace ImageBufAlgo
+
+OIIO_NAMESPACE_END
@@ -5,7 +5,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
+#include <memory>
 
 #include <OpenImageIO/function_view.h>
 #include <OpenImageIO/imagebufalgo.h>
@@ -37,6 +40,13 @@ namespace ImageBufAlgo {
 /// fastest (due to cache layout issues?), but perhaps there are algorithms
 /// where it's better to split in X, Z, or along the longest axis.
 ///
+/// SplitDir::Tile instead divides the region into square tiles sized so
+/// that a tile of float pixels in and out fits in the L2 cache (see
+/// `parallel_for_tiled_2D()`), which the threads take one at a time until
+/// they're all done. This suits neighborhood operations on wide images,
+/// where each thread's full-width band of the input would otherwise fall
+/// out of the cache before the scanlines below it need it again.
+///
 inline void
 parallel_image(ROI roi, paropt opt, std::function<void(ROI)> f)
 {
@@ -66,8 +76,15 @@ parallel_image(ROI roi, paropt opt, std::function<void(ROI)> f)
         ychunk = roi.height();
         // ychunk = std::max (64, minitems/xchunk);
     } else if (splitdir == paropt::SplitDir::Tile) {
-        int64_t n = std::min<imagesize_t>(opt.minitems(), roi.npixels());
-        xchunk = ychunk = std::max(1, int(std::sqrt(n)) / 4);
+        parallel_for_tiled_2D(
+            roi.xbegin, roi.xend, roi.ybegin, roi.yend,
+            parallel_tile_size(sizeof(float) * std::max(1, roi.nchannels())),
+            [&](int64_t xbegin, int64_t xend, int64_t ybegin, int64_t yend) {
+                f(ROI(xbegin, xend, ybegin, yend, roi.zbegin, roi.zend,
+                      roi.chbegin, roi.chend));
+            },
+            opt);
+        return;
     } else {
         xchunk = ychunk = std::max(int64_t(1),
                                    int64_t(std::sqrt(opt.maxthreads())) / 2);
@@ -91,6 +108,95 @@ parallel_image(ROI roi, std::function<void(ROI)> f)
 
 
 
+/// Number of scanlines in each band that `parallel_image_reduce()` and
+/// `parallel_image_all()` divide `roi` into: enough for `opt.minitems()`
+/// pixels, but at least one.
+inline int
+parallel_image_band_rows(ROI roi, const paropt& opt)
+{
+    int64_t rowpixels = std::max(int64_t(1),
+                                 int64_t(roi.width()) * int64_t(roi.depth()));
+    return int(std::max(int64_t(1), int64_t(opt.minitems()) / rowpixels));
+}
+
+
+
+/// Helper template for parallel reductions over an image region (totals,
+/// counts, extrema, and the like). The region `roi` is divided into bands
+/// of whole scanlines, and `f(ROI band, T& acc)` accumulates each band into
+/// its own copy of `init`, with as many threads as `opt` allows. The
+/// accumulators are then combined, in band order, by `merge(T& total,
+/// const T& acc)`, starting with a copy of `init`, and the total returned.
+///
+/// Since the bands don't depend on the number of threads, neither does
+/// the result, even when it is a floating point sum. For example,
+///
+///     double sum = parallel_image_reduce(roi, nthreads, 0.0,
+///         [&](ROI band, double& acc) {
+///             ImageBuf::ConstIterator<float> s(src, band);
+///             for (; !s.done(); ++s)
+///                 acc += s[0];
+///         },
+///         [](double& total, const double& acc) { total += acc; });
+///
+template<typename T, typename Func, typename Merge>
+T
+parallel_image_reduce(ROI roi, paropt opt, const T& init, Func&& f,
+                      Merge&& merge)
+{
+    const int bandrows   = parallel_image_band_rows(roi, opt);
+    const int64_t nbands = std::max(0, roi.height() + bandrows - 1) / bandrows;
+    // Not a std::vector, which for bool would pack the values into bits
+    // that the threads would then share.
+    std::unique_ptr<T[]> acc(new T[size_t(nbands)]);
+    std::fill(acc.get(), acc.get() + nbands, init);
+    parallel_for(
+        int64_t(0), nbands,
+        [&](int64_t b) {
+            ROI band    = roi;
+            band.ybegin = roi.ybegin + int(b) * bandrows;
+            band.yend   = std::min(roi.yend, band.ybegin + bandrows);
+            f(band, acc[b]);
+        },
+        opt);
+    T total = init;
+    for (int64_t b = 0; b < nbands; ++b)
+        merge(total, acc[b]);
+    return total;
+}
+
+
+
+/// Helper for parallel tests of whether something holds for every pixel of
+/// an image region, such as whether it is all one color. The region `roi`
+/// is divided into bands of scanlines as with `parallel_image_reduce()`,
+/// and `pred(ROI band)` is called for them in parallel; the result is true
+/// if it returned true for all of them. As soon as any band fails, every
+/// thread skips the bands it hasn't yet started, so a failure anywhere
+/// ends the whole test quickly.
+inline bool
+parallel_image_all(ROI roi, paropt opt, function_view<bool(ROI)> pred)
+{
+    const int bandrows   = parallel_image_band_rows(roi, opt);
+    const int64_t nbands = std::max(0, roi.height() + bandrows - 1) / bandrows;
+    std::atomic<bool> ok(true);
+    parallel_for(
+        int64_t(0), nbands,
+        [&](int64_t b) {
+            if (!ok.load(std::memory_order_relaxed))
+                return;  // Another band already failed
+            ROI band    = roi;
+            band.ybegin = roi.ybegin + int(b) * bandrows;
+            band.yend   = std::min(roi.yend, band.ybegin + bandrows);
+            if (!pred(band))
+                ok.store(false, std::memory_order_relaxed);
+        },
+        opt);
+    return ok.load();
+}
+
+
+
 /// Common preparation for IBA functions (or work-alikes): Given an ROI (which
 /// may or may not be the default ROI::All()), destination image (which may or
 /// may not yet be allocated), and optional input images (presented as a span
@@ -99,6 +99,9 @@ public:
     ///           image cache will hold open simultaneously. This is not an
     ///           iron-clad guarantee; the number of handles may momentarily
     ///           exceed this by a small percentage. (Default = 100)
+    ///           For OpenEXR and TIFF files, only the file handle is closed
+    ///           when over the limit (least recently read first), and the
+    ///           file is reopened without rereading its headers.
     /// - `float max_memory_MB` :
     ///           The approximate maximum amount of memory (measured in MB)
     ///           used for the internal "tile cache." (Default: 1024.0 MB)
@@ -165,6 +168,13 @@ public:
     ///           images only. (Default: 1)
     /// - `int statistics:level` :
     ///           verbosity of statistics auto-printed.
+    /// - `int statistics:per_file` :
+    ///           If nonzero, gather texture lookup statistics for each file
+    ///           (lookups, probes per lookup, the MIP levels sampled, how
+    ///           often the lookup magnified the finest level, and the time
+    ///           spent sampling versus finding tiles), which getstats()
+    ///           reports at level 2 and above. This costs some time in
+    ///           every lookup, so it is off by default.
     /// - `int forcefloat` :
     ///           If set to nonzero, all image tiles will be converted to
     ///           `float` type when stored in the image cache.  This can be
@@ -219,11 +229,232 @@ public:
     ///           enabled, this reduces the number of file opens, at the
     ///           expense of not being able to open files if their format do
     ///           not actually match their filename extension). Default: 0
+    /// - `int udim_manifest` :
+    ///           When nonzero, the set of files that make up each udim
+    ///           pattern is saved, the first time the directory is
+    ///           scanned for them, in a hidden sidecar file next to them
+    ///           (for `tex.<UDIM>.tx`, named `.tex._UDIM_.tx.udims`). Later
+    ///           processes read that instead of scanning the directory
+    ///           again, as long as the directory hasn't been modified
+    ///           since. Each udim tile file is still opened only when it
+    ///           is first needed. Default: 0.
     /// - `string colorspace` :
     ///           The working colorspace of the texture system. Default: none.
     /// - `string colorconfig` :
     ///           Name of the OCIO config to use. Default: "" (meaning to use
     ///           the default color config).
+    /// - `int prefetch_threads` :
+    ///           The number of threads that read tiles requested with
+    ///           `prefetch_tiles()`. Zero makes `prefetch_tiles()` read them
+    ///           before returning, and -1 reads them with the I/O thread
+    ///           pool shared with the rest of OpenImageIO (see the global
+    ///           `"io_threads"` attribute), after any other I/O waiting to
+    ///           run there. Default: -1.
+    /// - `int microcache_size` :
+    ///           Besides the last two tiles it used, each thread can keep
+    ///           this many more recently used tiles close at hand, checked
+    ///           before the shared tile cache, which helps when lookups
+    ///           cycle among more than two tiles, such as several textures
+    ///           used in turn. Rounded up to a multiple of 4, at most 1024;
+    ///           0 disables it. Default: 0.
+    /// - `int watch_files` :
+    ///           If nonzero, ask the operating system to report changes to
+    ///           the directories holding the cache's files (currently only
+    ///           on Linux, with inotify), so that `invalidate_all(false)`
+    ///           only looks at the files that changed rather than checking
+    ///           the modification time of every file. Setting it fails
+    ///           where that isn't available, and the attribute then reads
+    ///           back 0. Changes made by other hosts to network file
+    ///           systems may not be reported. Default: 0.
+    /// - `string diskcache_dir` :
+    ///           If not empty, a local directory (created if necessary) to
+    ///           use as a second level cache of decoded tiles, shared by all
+    ///           processes that name the same directory. On a miss in the
+    ///           memory cache, a tile found there is loaded with one local
+    ///           read rather than rereading and decompressing the original
+    ///           file, which is a big win when many processes read the same
+    ///           images over a network. Tiles are identified by the image
+    ///           fingerprint when it has one (as written by `maketx`), or
+    ///           else by file name and modification time, and tiles with a
+    ///           color transform also by the OCIO config's cache ID, so
+    ///           processes with different configs don't share them.
+    ///           Default: "".
+    /// - `float diskcache_max_MB` :
+    ///           The size limit of `diskcache_dir`, beyond which the least
+    ///           recently used tiles are deleted. Default: 10240.
+    /// - `int thumbnail_size` :
+    ///           If nonzero, `get_thumbnail()` delivers a thumbnail of any
+    ///           image, not only of those that have one embedded, its
+    ///           larger dimension the smallest of the standard sizes 64,
+    ///           128, 256, 512, and 1024 that is at least `thumbnail_size`
+    ///           (reading back as that size). Each is made from the
+    ///           cheapest source that is big enough: the embedded
+    ///           thumbnail, the coarsest MIP level, or a reduced resolution
+    ///           decode (see `"oiio:reduce_factor"`), which for most
+    ///           formats means reading the whole image, and is resized to
+    ///           fit. The most recently used thumbnails (up to 32 MB) are
+    ///           kept in memory, and each is made only once however many
+    ///           threads ask for it at the same time. Default: 0.
+    /// - `string thumbnail_dir` :
+    ///           If not empty, a directory (created if necessary) in which to
+    ///           keep the thumbnails made for `thumbnail_size`, shared by all
+    ///           processes that name the same directory, such as the
+    ///           sessions of an asset browser. Thumbnails are identified by
+    ///           the file name, size, and modification time of their
+    ///           images. Default: "".
+    /// - `float thumbnail_max_MB` :
+    ///           The size limit of `thumbnail_dir`, beyond which the least
+    ///           recently used thumbnails are deleted. Default: 1024.
+    /// - `string retile_dir` :
+    ///           If not empty, a directory (created if necessary) in which to
+    ///           keep local tiled copies, in the OTX format, of images that
+    ///           are costly to read a tile at a time: untiled ones (see
+    ///           `autotile`), which are otherwise decoded again whenever
+    ///           their evicted tiles are needed, and unmipped ones when
+    ///           `automip` is on, which are otherwise resized again. The
+    ///           first open of such an image (a single subimage in a plain
+    ///           file) queues the making of its copy on the `prefetch_threads`
+    ///           pool; lookups carry on from the original until the copy is
+    ///           ready, then the file switches to it transparently. Copies
+    ///           are identified by the file name, size, and modification time
+    ///           of their images, so a changed image is copied again, and are
+    ///           shared by all processes that name the same directory.
+    ///           Default: "".
+    /// - `float retile_max_MB` :
+    ///           The size limit of `retile_dir`, beyond which the least
+    ///           recently made or used copies are deleted. Default: 10240.
+    /// - `string sharedcache_name` :
+    ///           If not empty, the name of a shared memory segment (created
+    ///           by the first process to ask for it) holding decoded tiles
+    ///           for all the processes on the machine that name the same
+    ///           segment, such as several renders of the same scene. A tile
+    ///           read from its file by any of them is kept there, and a
+    ///           miss in the memory cache of any of them on a tile found
+    ///           there costs only a copy, so each process can use a small
+    ///           `max_memory_MB` of its own. Only tiles of at most 64 KB
+    ///           (e.g. 64x64 RGBA float) are shared, keyed like those of
+    ///           `diskcache_dir`. The segment persists after the processes
+    ///           exit until it is removed (on Linux, from `/dev/shm`).
+    ///           Default: "".
+    /// - `float sharedcache_max_MB` :
+    ///           The size of the segment if this process is the one that
+    ///           creates it; it holds that much of tiles. Default: 1024.
+    /// - `string tileservers` :
+    ///           If not empty, a comma-separated list of "host:port" tile
+    ///           servers (ImageCaches of other processes, usually on other
+    ///           machines, with a `tileserver_port`) shared by all the
+    ///           render nodes that name the same list. A tile missing from
+    ///           the memory and disk caches is asked for from the one
+    ///           server its key belongs to, and a tile that has to be read
+    ///           from its file is given to that server, so that each tile
+    ///           is read from the file server only once for the whole farm.
+    ///           Tiles are keyed like those of `diskcache_dir`. A server
+    ///           that fails to answer is left alone for a few seconds.
+    ///           Not available on Windows. Default: "".
+    /// - `int tileserver_port` :
+    ///           If nonzero, serve tiles to other processes' `tileservers`
+    ///           on this TCP port, from memory. Default: 0.
+    /// - `string tileserver_address` :
+    ///           The address of the network interface to serve tiles on,
+    ///           or "" for all of them. The default serves only the
+    ///           processes of this machine; a farm's servers must name the
+    ///           interface of the network the render nodes share, and must
+    ///           be given a `tileserver_secret` first. The traffic is not
+    ///           encrypted, and the servers store what any client that
+    ///           knows the `tileserver_secret` gives them, so the port
+    ///           should only be reachable from trusted hosts.
+    ///           Default: "127.0.0.1".
+    /// - `string tileserver_secret` :
+    ///           A secret that the tile servers and their clients must all
+    ///           be given. When they connect, the client proves to the
+    ///           server that it knows it, and then the server proves it to
+    ///           the client, each without sending it; a server hangs up on
+    ///           a client that can't, and a client doesn't use a server
+    ///           that can't. That only checks who is at each end when they
+    ///           connect: the tiles that follow are not signed, so someone
+    ///           who can tamper with the traffic can still change them.
+    ///           Without a secret, tiles are only served on a loopback
+    ///           `tileserver_address`, and only fetched from `tileservers`
+    ///           with loopback addresses. Default: "".
+    /// - `int tileserver_max_connections` :
+    ///           The most clients a server serves at once (each one with a
+    ///           thread); others are turned away, and read their tiles
+    ///           from the files. Default: 64.
+    /// - `int tileserver_tiles` :
+    ///           (Read-only) The number of tiles this process is serving.
+    /// - `float tileserver_max_MB` :
+    ///           The most memory that the tiles served on `tileserver_port`
+    ///           may use, beyond which the least recently used ones are
+    ///           dropped. Default: 1024.
+    /// - `int tileserver_timeout` :
+    ///           How many milliseconds to wait for a tile server to
+    ///           connect or answer before reading the tile from its file
+    ///           instead. Default: 250.
+    /// - `float compressed_max_MB` :
+    ///           If nonzero, tiles freed to stay within `max_memory_MB` are
+    ///           kept compressed in memory, up to this much in total, so
+    ///           that needing one of them again costs a decompression
+    ///           rather than rereading it from its file. This can raise the
+    ///           hit rate a lot for sets of textures a little too big for
+    ///           `max_memory_MB`. Default: 0.
+    /// - `string compressed_codec` :
+    ///           How the tiles are compressed for `compressed_max_MB`:
+    ///           "zip" (zlib at its fastest level), or "zip:N" for zlib
+    ///           level N, 1-9, smaller but slower as N increases.
+    ///           Default: "zip".
+    /// - `string eviction_policy` :
+    ///           How tiles are chosen for freeing when the cache exceeds
+    ///           `max_memory_MB`: "clock" (the default) frees tiles that
+    ///           have not been used since the last sweep; "clockpro" and
+    ///           "arc" are scan resistant, protecting tiles that are used
+    ///           repeatedly from a flood of tiles that are read only once
+    ///           (such as a huge image examined a single time). Changing
+    ///           it discards all cached tiles.
+    /// - `string record_tiles` :
+    ///           If set to a filename, every access to the in-memory tile
+    ///           cache (that is, every tile lookup not satisfied by the
+    ///           thread's own most recent tiles) is recorded to that file:
+    ///           the tile, whether it was a hit or a miss, its size, and
+    ///           when and by which thread it was wanted. `testtex
+    ///           --analyze-tiles` reads the recording and reports the
+    ///           working set, reuse distances, and the hit rates that other
+    ///           values of `max_memory_MB` would have had. The recording
+    ///           ends when the attribute is set to "" or the cache is
+    ///           destroyed. Only set it while no lookups are in progress.
+    ///           Default: "".
+    /// - `float record_tiles_max_MB` :
+    ///           If nonzero, the `record_tiles` file holds only about this
+    ///           much of the most recent accesses, overwriting the oldest.
+    ///           It applies to recordings started after setting it.
+    ///           Default: 0 (unbounded).
+    /// - `string tilecache_impl` :
+    ///           Which data structure holds the in-memory tiles: "map"
+    ///           (the default) is a sharded hash map that locks a shard for
+    ///           every lookup, and "lockfree" is an open-addressed table
+    ///           whose lookups take no locks, which can scale better when
+    ///           many threads hit the cache at once. It can only be
+    ///           changed before the first tile is cached; after that,
+    ///           setting a different value fails with an error.
+    /// - `int numa_tiles` :
+    ///           When nonzero, on a machine with more than one NUMA node,
+    ///           threads on each node use their own copies of the tiles
+    ///           they need, allocated and filled on that node (by copying
+    ///           another node's copy when there is one), so that texture
+    ///           lookups read only local memory. This trades cache memory
+    ///           for speed on large multi-socket machines. Default: 0.
+    /// - `int mmap_tiles` :
+    ///           When nonzero, tiled TIFF files are memory mapped, and any
+    ///           of their tiles that are stored uncompressed, in the host
+    ///           byte order, and in exactly the data type and channel
+    ///           layout that the cache would hold them (after any
+    ///           `forcefloat` conversion), are used in place rather than
+    ///           being read and copied into cache memory. Such tiles take
+    ///           no part of `max_memory_MB`, making it possible to use
+    ///           uncompressed texture sets much larger than the cache,
+    ///           paged in and out by the operating system. Tiles of other
+    ///           files, or that need any conversion, are read as usual.
+    ///           A mapped file must not be modified or truncated while the
+    ///           cache uses it. Default: 0.
     ///
     /// - `string options`
     ///           This catch-all is simply a comma-separated list of
@@ -251,6 +482,10 @@ public:
     ///           all files referenced by calls to the ImageCache. (The
     ///           array is of `ustring` or `char*`.)
     ///
+    /// - `int numa_nodes` :
+    ///           The number of NUMA nodes that `numa_tiles` distinguishes
+    ///           (1 if the machine isn't NUMA, or it can't tell).
+    ///
     /// - `int64 stat:cache_footprint` :
     ///           Total bytes used by image cache.
     /// - `int64 stat:cache_memory_used` :
@@ -273,6 +508,12 @@ public:
     /// - `int stat:find_tile_calls` :
     ///           Number of times a filename was looked up in the file cache.
     ///
+    /// - `int64 stat:microcache_set_hits` :
+    /// - `int64 stat:microcache_set_misses` :
+    ///           Number of tile lookups that, having missed the last two
+    ///           tiles used by the thread, were found, or not found, among
+    ///           its `microcache_size` others.
+    ///
     /// - `int64 stat:image_size` :
     ///           Total size (uncompressed bytes of pixel data) of all
     ///           images referenced by the ImageCache. (Note: Prior to 1.7,
@@ -311,6 +552,73 @@ public:
     ///           Total time (across all threads) that threads spent looking
     ///           up individual tiles.
     ///
+    /// - `int64 stat:tile_evictions` :
+    /// - `int64 stat:tile_promotions` :
+    /// - `int64 stat:tile_ghost_hits` :
+    ///           Number of tiles freed by the eviction policy, tiles it
+    ///           judged to be in repeated use, and cache misses on tiles
+    ///           that it had recently freed, respectively.
+    ///
+    /// - `int64 stat:tiles_prefetched` :
+    ///           Number of tile reads queued by `prefetch_tiles()`, or by
+    ///           texture lookups with `TextureOpt::nonblocking`.
+    ///
+    /// - `int64 stat:coalesced_reads` :
+    /// - `int64 stat:coalesced_tiles` :
+    ///           Number of times that several adjacent tiles missing from
+    ///           the cache were read from a file with a single call, and
+    ///           the total number of tiles read that way.
+    ///
+    /// - `int64 stat:numa_copies` :
+    ///           Number of tiles copied from one NUMA node's copy to make
+    ///           another's (see `numa_tiles`).
+    ///
+    /// - `int64 stat:tiles_mapped` :
+    ///           Number of tiles used in place from a memory mapped file
+    ///           (see `mmap_tiles`).
+    ///
+    /// - `int64 stat:tiles_constant` :
+    ///           Number of tiles that the per-tile statistics written by
+    ///           `maketx --tilestats` showed to be a single color, or that
+    ///           the reader of a sparse file said were empty (see
+    ///           `ImageInput::empty_tiles()`), and that were therefore
+    ///           filled in without reading the file. (3D texture lookups of
+    ///           empty tiles don't fetch the tiles at all.)
+    ///
+    /// - `int64 stat:compressed_hits` :
+    /// - `int64 stat:compressed_stores` :
+    ///           Number of cache misses satisfied by the compressed tier
+    ///           (see `compressed_max_MB`), and of evicted tiles kept in it.
+    ///
+    /// - `float stat:compress_time` :
+    /// - `float stat:decompress_time` :
+    ///           Total time (across all threads) spent compressing tiles
+    ///           for, and decompressing tiles from, the compressed tier.
+    ///
+    /// - `int64 stat:tiles_colortransformed` :
+    /// - `int64 stat:colortransform_copies` :
+    /// - `float stat:colortransform_time` :
+    ///           Number of tiles given a color transform (for a
+    ///           TextureOpt::colortransformid), how many of those were
+    ///           made from the untransformed tile already in the cache
+    ///           rather than by reading the file again, and the total time
+    ///           (across all threads) spent transforming them. Transformed
+    ///           tiles are cached, and count against `max_memory_MB`, like
+    ///           any others, so each is transformed only once.
+    ///
+    /// - `int64 stat:diskcache_hits` :
+    /// - `int64 stat:diskcache_misses` :
+    ///           Number of tiles found, and not found, in `diskcache_dir`.
+    ///
+    /// - `int64 stat:sharedcache_hits` :
+    /// - `int64 stat:sharedcache_misses` :
+    ///           Number of tiles found, and not found, in the
+    ///           `sharedcache_name` segment.
+    ///
+    /// - `int64 stat:tileserver_hits` :
+    /// - `int64 stat:tileserver_misses` :
+    ///           Number of tiles that the `tileservers` had, and didn't.
+    ///
     /// The following member functions of ImageCache allow you to set (and
     /// in some cases retrieve) options that control the overall behavior of
     /// the image cache:
@@ -848,6 +1156,8 @@ public:
 
     /// Copy into `thumbnail` any associated thumbnail associated with this
     /// image (for the first subimage by default, or as set by `subimage`).
+    /// If the `thumbnail_size` attribute is set, a thumbnail of that size
+    /// is made (or found already made) even if the file has none.
     ///
     /// @param  filename
     ///             The name of the image, as a UTF-8 encoded ustring.
@@ -867,6 +1177,39 @@ public:
     /// `Perthread*` for the calling thread.
     bool get_thumbnail(ImageHandle* file, Perthread* thread_info,
                        ImageBuf& thumbnail, int subimage = 0);
+
+    /// Retrieve the range of the values of each channel within a region of
+    /// an image, without reading its pixels, from the per-tile statistics
+    /// that `maketx --tilestats` stores in the file. The bounds are those
+    /// of all the tiles overlapping `roi`, and so may be looser than those
+    /// of the region itself, and are of the values in the file (before any
+    /// color transformation). For an OpenEXR file, only the highest
+    /// resolution MIP level has statistics.
+    ///
+    /// @param  filename
+    ///             The name of the image, as a UTF-8 encoded ustring.
+    /// @param  subimage/miplevel
+    ///             The subimage and mip level to query.
+    /// @param  roi
+    ///             The region of interest. Only its x, y, and channel
+    ///             ranges are used.
+    /// @param  min/max
+    ///             Receive the minimum and maximum of channels
+    ///             `roi.chbegin` through `roi.chend-1` and must each have
+    ///             room for that many values.
+    /// @returns
+    ///             `true` upon success, `false` if the file could not be
+    ///             found or opened, does not contain the designated
+    ///             subimage or mip level, has no tile statistics, or
+    ///             `roi` does not overlap its data window.
+    bool get_pixel_bounds(ustring filename, int subimage, int miplevel,
+                          ROI roi, span<float> min, span<float> max);
+    /// A more efficient variety of `get_pixel_bounds()` for cases where you
+    /// can use an `ImageHandle*` to specify the image and optionally have a
+    /// `Perthread*` for the calling thread.
+    bool get_pixel_bounds(ImageHandle* file, Perthread* thread_info,
+                          int subimage, int miplevel, ROI roi,
+                          span<float> min, span<float> max);
     /// @}
 
     /// @{
@@ -946,6 +1289,38 @@ public:
     bool get_pixels(ImageHandle* file, Perthread* thread_info, int subimage,
                     int miplevel, int xbegin, int xend, int ybegin, int yend,
                     int zbegin, int zend, TypeDesc format, void* result);
+
+    /// Retrieve a rectangle of the deep pixels of a deep image into
+    /// `result`, which will be initialized with one pixel for each of the
+    /// rectangle's pixels (in x, then y, then z order) and all the channels
+    /// of the subimage, in their native types. Deep images are cached in
+    /// tiles much as flat images are, with each tile holding the samples of
+    /// the tile's pixels, and those tiles are held to the same memory limit
+    /// and evicted in the same way as flat ones. Requested pixels outside
+    /// the data window of the image will have no samples.
+    ///
+    /// @param  filename
+    ///             The name of the image, as a UTF-8 encoded ustring.
+    /// @param  subimage/miplevel
+    ///             The subimage and MIP level to retrieve pixels from.
+    /// @param  xbegin/xend/ybegin/yend/zbegin/zend
+    ///             The range of pixels to retrieve.
+    /// @param  result
+    ///             The DeepData into which the pixels will be placed.
+    ///
+    /// @returns
+    ///             `true` for success, `false` for failure (including if
+    ///             the subimage is not deep).
+    bool get_deep_pixels(ustring filename, int subimage, int miplevel,
+                         int xbegin, int xend, int ybegin, int yend,
+                         int zbegin, int zend, DeepData& result);
+    /// A more efficient variety of `get_deep_pixels()` for cases where you
+    /// can use an `ImageHandle*` to specify the image and optionally have a
+    /// `Perthread*` for the calling thread.
+    bool get_deep_pixels(ImageHandle* file, Perthread* thread_info,
+                         int subimage, int miplevel, int xbegin, int xend,
+                         int ybegin, int yend, int zbegin, int zend,
+                         DeepData& result);
     /// @}
 
     /// @{
@@ -980,7 +1355,8 @@ public:
     /// If `force` is true, everything will be invalidated, no matter how
     /// wasteful it is, but if `force` is false, in actuality files will
     /// only be invalidated if their modification times have been changed
-    /// since they were first opened.
+    /// since they were first opened (or, with the `"watch_files"`
+    /// attribute, if they were reported to have changed).
     void invalidate_all(bool force = false);
 
     /// Close any open file handles associated with a named file (UTF-8
@@ -1020,6 +1396,22 @@ public:
     /// once again be purged from the tile cache if required.
     void release_tile(Tile* tile) const;
 
+    /// Begin reading, in the background, every tile of the given subimage
+    /// and MIP level that overlaps `roi` (and its channel range), and
+    /// return immediately. The tiles are read by a pool of I/O threads
+    /// (see the `prefetch_threads` attribute); an ordinary lookup of a tile
+    /// whose read is still pending simply waits for it to finish, rather
+    /// than reading it again. Tiles of untiled images and of automatically
+    /// generated MIP levels are not prefetched, but read on demand as
+    /// usual. Return false if the file or level does not exist.
+    bool prefetch_tiles(ustring filename, int subimage, int miplevel,
+                        ROI roi = ROI::All());
+    /// A slightly more efficient variety of `prefetch_tiles()` for cases
+    /// where you can use an `ImageHandle*` to specify the image and
+    /// optionally have a `Perthread*` for the calling thread.
+    bool prefetch_tiles(ImageHandle* file, Perthread* thread_info,
+                        int subimage, int miplevel, ROI roi = ROI::All());
+
     /// Retrieve the data type of the pixels stored in the tile, which may
     /// be different than the type of the pixels in the disk file.
     TypeDesc tile_format(const Tile* tile) const;
@@ -1069,6 +1461,38 @@ public:
     bool add_file(ustring filename, ImageInput::Creator creator = nullptr,
                   const ImageSpec* config = nullptr, bool replace = false);
 
+    /// Open and validate many files at once -- say, all the textures of a
+    /// scene as it loads -- in parallel on the OIIO thread pool, rather
+    /// than each being opened by whichever thread first needs it. Each
+    /// file (UTF-8 encoded) is resolved on the search path and its headers
+    /// read, just as the first `get_imagespec()` or lookup of it would; a
+    /// UDIM pattern preloads all of its tile files.
+    ///
+    /// @param  filenames
+    ///             The files to preload.
+    /// @param  options
+    ///             Optional keyword arguments:
+    ///             - `int read_coarsest` (0) : Also read every tile of the
+    ///               coarsest MIP level of each subimage.
+    ///             - `int averagecolor` (0) : Also compute the average color
+    ///               of each subimage (see `get_image_info()`), reading the
+    ///               coarsest MIP level unless the file records it.
+    ///             - `int close` : Close each file after preloading it, so
+    ///               that it holds no file handle until it's used. The
+    ///               default is 1 if there are more files than the
+    ///               `max_open_files` attribute, else 0.
+    ///             - `int nthreads` (0) : The most threads to use, or 0 for
+    ///               all of the thread pool.
+    /// @param  broken
+    ///             If not null, the names of the files that could not be
+    ///             opened or read are appended to it (in no particular
+    ///             order). The errors for them are also issued as for any
+    ///             other call.
+    /// @returns
+    ///             `true` if every file was preloaded successfully.
+    bool preload(cspan<ustring> filenames, ParamValueSpan options = {},
+                 std::vector<ustring>* broken = nullptr);
+
     /// Preemptively add a tile corresponding to the named image, at the
     /// given subimage, MIP level, and channel range.  The tile added is the
     /// one whose corner is (x,y,z), and buffer points to the pixels (in the
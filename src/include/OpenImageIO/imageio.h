@@ -30,6 +30,7 @@
 
 #include <OpenImageIO/span.h>
 #include <OpenImageIO/export.h>
+#include <OpenImageIO/function_view.h>
 #include <OpenImageIO/oiioversion.h>
 #include <OpenImageIO/paramlist.h>
 #include <OpenImageIO/platform.h>
@@ -680,6 +681,19 @@ public:
     /// Populates the fields of the `ImageSpec` based on the XML passed in.
     void from_xml (const char *xml);
 
+    /// Return all the fields and metadata of the `ImageSpec` in a compact,
+    /// versioned binary form (the same on every platform) that
+    /// `from_binary()` restores exactly, far faster than XML can be parsed.
+    /// It is meant for caching specs and passing them between processes.
+    /// Pointer-valued metadata is stored as the pointers themselves, which
+    /// mean nothing to another process.
+    std::string to_binary () const;
+
+    /// Set all the fields and metadata of the `ImageSpec` from the result
+    /// of `to_binary()`. Return false, leaving the spec unchanged, if `data`
+    /// is not a binary spec of a version that this library can read.
+    bool from_binary (string_view data);
+
     /// Hunt for the "Compression" and "CompressionQuality" settings in the
     /// spec and turn them into the compression name and quality. This
     /// handles compression name/qual combos of the form "name:quality".
@@ -969,6 +983,14 @@ public:
                       ioproxy, plugin_searchpath);
     }
 
+    /// Hand back an ImageInput that is no longer needed, closing it and
+    /// keeping it (up to a few of each format) for a later `create()` or
+    /// `open()` of the same format to reuse, rather than constructing a
+    /// new one. Programs reading many small files in a loop may call this
+    /// in place of letting the ImageInput be destroyed. `in` is empty
+    /// afterwards.
+    static void recycle (unique_ptr&& in);
+
     /// @}
 
 protected:
@@ -1018,6 +1040,12 @@ public:
     ///        Does this format allow 0x0 sized images, i.e. an image file
     ///        with metadata only and no pixels?
     ///
+    ///  - `"parallel_scanline_decode"` :
+    ///        May `read_native_scanlines()` be called by several threads at
+    ///        once, for different scanlines of the current subimage? If so,
+    ///        `read_scanlines()` reads large ranges of scanlines a piece at
+    ///        a time in parallel.
+    ///
     /// This list of queries may be extended in future releases. Since this
     /// can be done simply by recognizing new query strings, and does not
     /// require any new API entry points, addition of support for new
@@ -1596,6 +1624,18 @@ public:
                                     int xbegin, int xend, int ybegin, int yend,
                                     int zbegin, int zend,
                                     int chbegin, int chend, void *data);
+
+    /// For sparse formats, with large regions that hold nothing, report
+    /// which tiles of a subimage and MIP level are known to be empty,
+    /// without reading them. Upon success, bit `t % 64` of `empty[t / 64]`
+    /// is set for each empty tile `t`, numbering the tiles of the data
+    /// window with x varying fastest, then y, then z, and `background`
+    /// (which must have room for one pixel of native data) holds the value
+    /// of every pixel of the empty tiles. The ImageCache and TextureSystem
+    /// use this to avoid reading, storing, or even looking up those tiles.
+    /// Readers that don't know, which is the default, return false.
+    virtual bool empty_tiles (int subimage, int miplevel,
+                              std::vector<uint64_t>& empty, void* background);
     /// @}
 
 
@@ -1742,14 +1782,17 @@ protected:
 
     /// Retrieve any ioproxy request from the configuration hint spec, and
     /// make `m_io` point to it. But if no IOProxy is found in the config,
-    /// don't overwrite one we already have.
+    /// don't overwrite one we already have. Also note any "oiio:mmap"
+    /// hint, for `ioproxy_use_or_open()`.
     void ioproxy_retrieve_from_config(const ImageSpec& config);
 
     /// Presuming that `ioproxy_retrieve_from_config` has already been called,
     /// if `m_io` is still not set (i.e., wasn't found in the config), open a
-    /// IOFile local proxy with the given read/write `mode`. Return true if a
-    /// proxy is set up. If it can't be done (i.e., no proxy passed, file
-    /// couldn't be opened), issue an error and return false.
+    /// local proxy to read the file: an IOMMap if the "oiio:mmap" hint or
+    /// the "imageinput:mmap" attribute asks for one and the file can be
+    /// mapped, otherwise an IOFile. Return true if a proxy is set up. If
+    /// it can't be done (i.e., no proxy passed, file couldn't be opened),
+    /// issue an error and return false.
     bool ioproxy_use_or_open(string_view name);
 
     /// Helper: read from the proxy akin to fread(). Return true on success,
@@ -1766,6 +1809,20 @@ protected:
     /// Helper: retrieve the current position of the proxy, akin to ftell.
     int64_t iotell() const;
 
+    /// Helper: convert `nscanlines` scanlines of native pixels of channels
+    /// [chbegin,chend) of `spec`, contiguous as read_native_scanlines()
+    /// returns them, to `format`, storing them in `data` with the given
+    /// (not AutoStride) strides, just as read_scanlines() does. A reader
+    /// that overrides read_scanlines() to decode a chunk at a time may call
+    /// this for each chunk as soon as it is decoded, while it is still in
+    /// cache, rather than decoding the whole range first. Return true on
+    /// success, false (and issue an error) for an unsupported conversion.
+    bool convert_native_scanlines(const ImageSpec& spec, int chbegin,
+                                  int chend, int nscanlines,
+                                  const void* native, TypeDesc format,
+                                  void* data, stride_t xstride,
+                                  stride_t ystride, int nthreads = 1) const;
+
     /// Helper: convenience boilerplate for several checks and operations that
     /// every implementation of ImageInput::open() will need to do. Failure is
     /// presumed to indicate a file that is corrupt (or perhaps maliciously
@@ -1831,6 +1888,63 @@ private:
 
 
 
+/// An ImageSpecIndex remembers the specs of image files, so that browsing
+/// the same huge directories of images again and again (as a file browser,
+/// or a script running `iinfo` over every shot, would) doesn't need to open
+/// every file every time. Each spec is kept with the size and modification
+/// time of its file, and the file is only opened again if either of them
+/// has changed. The index may be kept in a file between runs, and may be
+/// used by many threads at once.
+///
+///     ImageSpecIndex index("shots.specindex");
+///     for (auto& f : filenames) {
+///         ImageSpec spec;
+///         if (index.get(f, spec))
+///             print("{} : {} x {}\n", f, spec.width, spec.height);
+///     }
+///
+class OIIO_API ImageSpecIndex {
+public:
+    /// Start with the specs saved in `indexfile`, if it exists, which is
+    /// also where `save()` will write them (if it is empty, the index is
+    /// only kept in memory). Unless `headeronly` is false, files are opened
+    /// with the `"oiio:headeronly"` configuration hint, so their specs
+    /// are complete as to resolution, channels and data types, but may lack
+    /// the metadata that the readers only find in Exif, XMP, or ICC blocks.
+    explicit ImageSpecIndex(string_view indexfile = "",
+                            bool headeronly       = true);
+    ImageSpecIndex(const ImageSpecIndex&)            = delete;
+    ImageSpecIndex& operator=(const ImageSpecIndex&) = delete;
+    /// Save the index, if it has changed, and destroy it.
+    ~ImageSpecIndex();
+
+    /// Retrieve into `spec` the spec of subimage `subimage` and MIP level
+    /// `miplevel` of `filename`: from the index if the file hasn't changed
+    /// since it was indexed, otherwise by opening the file (and adding
+    /// the spec to the index). Return `true` upon success, or `false` if
+    /// the file couldn't be read, in which case the error may be retrieved
+    /// with the global `OIIO::geterror()`.
+    bool get(string_view filename, ImageSpec& spec, int subimage = 0,
+             int miplevel = 0);
+
+    /// Write the index to its file, if it has one and anything has changed
+    /// since it was read or last saved. Return `false` if it could not be
+    /// written (the error is set as for `get()`).
+    bool save();
+
+    /// The number of specs in the index.
+    size_t size() const;
+
+    /// Forget all the specs.
+    void clear();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+
+
 
 /// ImageOutput abstracts the writing of an image file in a file
 /// format-agnostic manner.
@@ -2649,6 +2763,24 @@ protected:
                                      unsigned int dither=0,
                                      int xorigin=0, int yorigin=0, int zorigin=0);
 
+    /// Helper for write_* implementations that can encode the chunks of
+    /// the file (strips, tiles, ...) independently of each other, and only
+    /// need to write them out in order: `compress(i, buf)` is called for
+    /// each chunk `i` in `[0,nchunks)`, in parallel on the thread pool, and
+    /// must replace the contents of `buf` with the bytes to write for that
+    /// chunk (usually its converted and compressed pixels) and return
+    /// `true`. Meanwhile, the calling thread calls `write(i, buf)` for each
+    /// chunk in turn, as soon as it is ready, so the (typically serial)
+    /// writing overlaps the compression of the chunks that follow. Both
+    /// may set errors. If the `threads()` policy, or being called from the
+    /// thread pool, allows only one thread, each chunk is simply compressed
+    /// and then written before the next. Return `false` once any call
+    /// fails, or `true` if all of them succeeded.
+    bool compress_and_write_chunks (int nchunks,
+        function_view<bool(int chunk, std::vector<unsigned char>& buf)>
+            compress,
+        function_view<bool(int chunk, cspan<unsigned char> buf)> write);
+
     /// Helper function to copy a rectangle of data into the right spot in
     /// an image-sized buffer. In addition to copying to the right place,
     /// this handles data format conversion and dither (if the spec's
@@ -2834,6 +2966,16 @@ OIIO_API std::string geterror(bool clear = true);
 ///    calling thread do its own work inside of OIIO rather than spawning
 ///    new threads with a high overall "fan out."
 ///
+/// - `int io_threads`
+///
+///    How many threads OIIO keeps for work that mostly waits on I/O rather
+///    than computing -- reading ahead in files read through an
+///    `IOReadAhead`, `ImageCache::prefetch_tiles()`, and writing the
+///    finished MIP levels of `make_texture()` -- so that a stalled read or
+///    write doesn't hold up a thread of the `"threads"` pool. Zero runs
+///    that work in the thread that asks for it. The default is 4, or the
+///    value of the `OPENIMAGEIO_IO_THREADS` environment variable.
+///
 /// - `int exr_threads`
 ///
 ///    Sets the internal OpenEXR thread pool size. The default is to use as
@@ -2975,6 +3117,17 @@ OIIO_API std::string geterror(bool clear = true);
 ///    the log information. When the `log_times` attribute is disabled,
 ///    there is no additional performance cost.
 ///
+/// - `int metrics` (0)
+///
+///    When nonzero, runtime metrics (see `OpenImageIO/metrics.h`) are
+///    collected: histograms of the durations of `ImageBufAlgo` functions,
+///    of ImageBuf reads, and of ImageCache tile reads, and counts of the
+///    bytes the ImageCache reads from each file format. It can also be
+///    turned on by the environment variable `OPENIMAGEIO_METRICS`. The
+///    ImageCache statistics and the default thread pool's queue depth are
+///    reported whether or not this is on. While it's off, recording costs
+///    only a check of this flag.
+///
 /// - `oiio:print_uncaught_errors` (1)
 ///
 ///   If nonzero, upon program exit, any error messages that would have been
@@ -3009,6 +3162,122 @@ OIIO_API std::string geterror(bool clear = true);
 ///   If nonzero, an `ImageBuf` that references a file but is not given an
 ///   ImageCache will read the image through the default ImageCache.
 ///
+/// - `imagebuf:pool_MB` (0)
+///
+///   If nonzero, the pixel buffers (of at least 256 KB) of freed ImageBufs
+///   are kept, up to this many MB of them, for new ImageBufs of about the
+///   same size to reuse. This spares programs that keep making and
+///   freeing large ImageBufs of the same resolution the cost of the
+///   system allocating and zeroing fresh pages for each one. Setting it
+///   to 0 (the default) frees any that are being kept.
+///
+/// - `deepdata:pool_MB` (0)
+///
+///   Like `imagebuf:pool_MB`, but for the sample buffers (of at least 256
+///   KB) of freed DeepData, which new DeepData needing about as many
+///   samples will reuse. This helps deep compositing that makes and frees
+///   many deep images of similar sizes.
+///
+/// - `max_memory_MB` (0)
+///
+///   If nonzero, a budget for the memory of the whole process's ImageBuf
+///   pixels, DeepData samples, and ImageCache tiles together (unlike the
+///   ImageCache attribute of the same name, which limits only that cache's
+///   tiles). An allocation that would exceed it first makes the
+///   ImageCaches free tiles to make room; oiiotool also moves images on
+///   its stack that it isn't using out to temporary files. Allocations
+///   aren't refused when nothing more can be freed. 0 (the default) means
+///   no budget.
+///
+/// - `imagebuf:hugepages` (0)
+///
+///   If nonzero, ImageBuf pixel buffers of 2 MB or more are allocated to
+///   use huge pages: aligned to 2 MB and advised to use transparent huge
+///   pages on Linux, or large pages on Windows (which requires the "lock
+///   pages in memory" privilege, without which this does nothing). Fewer
+///   TLB misses make access that strides across scanlines, as in
+///   `transpose`, `rotate90`, or `flip`, markedly faster on big images.
+///
+/// - `imagebuf:scanline_alignment` (0)
+///
+///   If set to a power of 2, each scanline of the pixel buffers that
+///   ImageBufs allocate starts at a multiple of that many bytes (such as
+///   64, a cache line), by padding the scanlines as needed. Scanlines
+///   shorter than 8 times the alignment are left alone, since padding
+///   them would waste too much memory.
+///
+/// - `imagebuf:pad_scanlines` (0)
+///
+///   If nonzero, pad the scanlines of the pixel buffers that ImageBufs
+///   allocate so that the distance between them is never a multiple of
+///   4096 bytes, which would make the same pixel of successive scanlines
+///   alias in the caches.
+///
+///   Note that ImageBufs with scanlines padded by either of these are not
+///   `contiguous()`, so the ImageBufAlgo fast paths for contiguous images
+///   don't apply to them.
+///
+/// - `imagebuf:copy_on_write` (0)
+///
+///   If nonzero, copying an ImageBuf that holds its own pixels (with its
+///   copy constructor, assignment, or `copy()` with no change of type)
+///   takes constant time, with the copies sharing one pixel buffer until
+///   one of them is written. Each copy makes its own
+///   buffer when it's first asked for writable access to its pixels: the
+///   non-const `localpixels()` or `pixeladdr()`, an `Iterator`,
+///   `make_writable()`, or any ImageBufAlgo function writing to it. So a
+///   writable pointer obtained from an ImageBuf before it was copied must
+///   not be used to write to it afterwards, which is why it's off by
+///   default: then copies always duplicate the pixels, and channel subset
+///   views (`ImageBuf::share_channels()`) aren't made.
+///
+/// - `imagebufalgo:fastpaths` (1)
+///
+///   If nonzero (the default), ImageBufAlgo functions use their fast
+///   paths where they apply: pixel math functions such as `clamp`, `pow`,
+///   `premult`, and `saturate` process contiguous local float, half, or
+///   uint8 images a scanline at a time with SIMD, and `median_filter`,
+///   `dilate`, and `erode` with big windows take constant time per pixel,
+///   and `resize` with separable filters makes separate vertical and
+///   horizontal passes, and `colorconvert` of uint8 or uint16 images
+///   through OpenColorIO transforms without channel crosstalk looks up
+///   the exact results in a table of what the transform makes of each
+///   value.
+///   Setting it to 0 is only useful for testing and benchmarking the
+///   general code.
+///
+/// - `imagebufalgo:colorconvert_lut3d` (int: 0)
+///
+///   If 2 or more, `colorconvert` of uint8 or uint16 images through
+///   OpenColorIO transforms *with* channel crosstalk (such as gamut
+///   conversions) interpolates a 3D LUT of that many samples per axis
+///   (33 or 65, say), baked once per color processor, rather than applying
+///   the transform to every pixel. This is much faster but approximate,
+///   and alpha passes through unchanged. The default of 0 always applies
+///   the full transform.
+///
+/// - `imageinput:mmap` (int: 0)
+///
+///   If nonzero, ImageInput readers that do their I/O through an IOProxy,
+///   when not given one, read the file through a `Filesystem::IOMMap`
+///   that maps it into memory, rather than an `IOFile`. This saves a copy
+///   of every byte read, and readers (such as JPEG and JPEG XL) that need
+///   the whole file in memory use the mapping directly. The "oiio:mmap"
+///   configuration hint overrides it for any one file. (Note that a file
+///   must not be truncated while it is being read this way.)
+///
+/// - `imageinput:allow_urls` (int: 0)
+///
+///   If nonzero, ImageInput readers that can (TIFF and OpenEXR) open file
+///   names that are "http://" or "s3://" URLs, reading just the parts of
+///   the file they need with HTTP range requests (see
+///   `Filesystem::IOHTTP`). It's off by default, because otherwise an
+///   application that opens file names given to it by others could be
+///   made to fetch from any server on its network. Only plain HTTP is
+///   supported, so a presigned URL's signature is visible to anyone who
+///   can watch the network, and can be reused until it expires; a warning
+///   is printed the first time such a URL is opened.
+///
 /// - `imageinput:strict` (int: 0)
 ///
 ///   If zero (the default), ImageInput readers will try to be very tolerant
@@ -3112,6 +3381,17 @@ inline bool attribute (string_view name, string_view val) {
 ///   ImageBufs that owned their own allcoated local pixel buffers. (Added in
 ///   OpenImageIO 2.5.)
 ///
+/// - int64_t IB_pool_mem_current
+///
+///   Bytes of freed ImageBuf pixel buffers being kept for reuse, as
+///   `imagebuf:pool_MB` allows.
+///
+/// - int64_t DD_mem_current
+/// - int64_t total_mem_current
+///
+///   Bytes of DeepData samples, and the total of ImageBuf local pixels,
+///   DeepData samples, and ImageCache tiles that `max_memory_MB` limits.
+///
 /// - float IB_total_open_time
 /// - float IB_total_image_read_time
 ///
@@ -3173,6 +3453,20 @@ inline bool attribute (string_view name, string_view val) {
 ///        IBA::resize                  20   0.24s   (avg  12.18ms)
 ///        IBA::zero                     8   0.66ms  (avg   0.08ms)
 ///
+/// - `string metrics`
+/// - `string metrics:openmetrics`
+///
+///    All the metrics, in the Prometheus text exposition format, or in the
+///    OpenMetrics text format, ready to be served to a scraper.
+///
+/// - `float|double|int64 metric:`*name*
+///
+///    The value of one metric, such as `metric:oiio_imagecache_tiles`, the
+///    total of all its labels -- or only of the given ones, as in
+///    `metric:oiio_op_seconds{op="IBA::resize"}` -- and the number of values
+///    counted, for a histogram. (The attribute is not found if there is no
+///    such metric.)
+///
 OIIO_API bool getattribute(string_view name, TypeDesc type, void* val);
 
 /// Shortcut getattribute() for retrieving a single integer.
@@ -0,0 +1,183 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+/// @file  metrics.h
+///
+/// @brief Lightweight runtime metrics -- counters, histograms, and values
+/// computed on demand -- that may be exported in the Prometheus or
+/// OpenMetrics text format.
+///
+/// A Metrics::Counter or Metrics::Histogram is found (and made, the first
+/// time) by its name and labels, and lives as long as the program, so a
+/// reference to it may be kept. Each one is split into shards that
+/// different threads add to, so that threads counting the same thing
+/// don't contend for one cache line. A Source, instead, reports values
+/// that something already keeps (such as ImageCache statistics) only when
+/// the metrics are read.
+///
+/// Collection is off until Metrics::start() is called, or the
+/// `OPENIMAGEIO_METRICS` environment variable is set to a nonzero value;
+/// OpenImageIO checks Metrics::enabled() before recording anything, and
+/// that's all it costs while collection is off.
+///
+/// OpenImageIO itself records the durations of ImageBufAlgo functions,
+/// ImageBuf reads, and ImageCache tile reads, and the bytes read by the
+/// ImageCache for each file format; and it reports ImageCache statistics
+/// and the depth of the default thread pool's queue as sources.
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <OpenImageIO/export.h>
+#include <OpenImageIO/oiioversion.h>
+#include <OpenImageIO/platform.h>
+#include <OpenImageIO/string_view.h>
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace Metrics {
+
+namespace pvt {
+extern OIIO_UTIL_API std::atomic<bool> collecting;
+}
+
+/// Are metrics being collected?
+inline bool
+enabled()
+{
+    return pvt::collecting.load(std::memory_order_relaxed);
+}
+
+/// Start collecting metrics (keeping any collected so far).
+OIIO_UTIL_API void
+start();
+
+/// Stop collecting metrics (keeping those collected so far).
+OIIO_UTIL_API void
+stop();
+
+
+
+/// Number of shards of each counter and histogram.
+inline constexpr int nshards = 16;
+
+/// A count that only goes up, such as of calls or bytes.
+class OIIO_UTIL_API Counter {
+public:
+    /// Add n to the count.
+    void add(int64_t n = 1) noexcept;
+    /// The total count.
+    int64_t value() const noexcept;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<int64_t> count { 0 };
+    };
+    Shard m_shards[nshards];
+};
+
+
+
+/// A distribution of values, such as durations, counted in buckets whose
+/// upper bounds are `base` times successive powers of 2 (so that each
+/// bucket's bounds are within a factor of 2), with a last bucket for
+/// anything larger.
+class OIIO_UTIL_API Histogram {
+public:
+    /// Number of buckets, including the last, unbounded one.
+    static constexpr int nbuckets = 40;
+
+    Histogram(double base = 1.0e-6)
+        : m_base(base)
+    {
+    }
+
+    /// Count the value v.
+    void record(double v) noexcept;
+    /// The upper bound of bucket b (infinity for the last).
+    double upper_bound(int b) const noexcept;
+    /// The number of values counted in bucket b.
+    int64_t bucket(int b) const noexcept;
+    /// The number of values counted.
+    int64_t count() const noexcept;
+    /// The sum of the values counted.
+    double sum() const noexcept;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<int64_t> buckets[nbuckets] = {};
+        std::atomic<double> sum { 0.0 };
+    };
+    double m_base;
+    Shard m_shards[nshards];
+};
+
+
+
+/// Return the counter with the given name and labels (in the form
+/// `key="value",key2="value2"`, as made by label()), making it the first
+/// time it's asked for. The help is its description.
+OIIO_UTIL_API Counter&
+counter(string_view name, string_view help, string_view labels = {});
+
+/// Return the histogram with the given name and labels, making it (with
+/// the given bucket base) the first time it's asked for.
+OIIO_UTIL_API Histogram&
+histogram(string_view name, string_view help, string_view labels = {},
+          double base = 1.0e-6);
+
+/// Return `key="value"`, with the value escaped as the text format needs.
+OIIO_UTIL_API std::string
+label(string_view key, string_view value);
+
+
+
+/// A value reported by a Source.
+struct Sample {
+    std::string name;
+    std::string help;
+    std::string labels;
+    double value;
+    bool counter;  ///< a count that only goes up, rather than a gauge
+};
+
+/// A function that appends its current values to a vector of samples.
+using Source = std::function<void(std::vector<Sample>&)>;
+
+/// Add a source of values to be reported whenever the metrics are read,
+/// returning an id for remove_source(). Sources are called even while
+/// collection is off.
+OIIO_UTIL_API int
+add_source(Source source);
+
+/// Remove a source added by add_source().
+OIIO_UTIL_API void
+remove_source(int id);
+
+
+
+/// Return all the metrics in the Prometheus text exposition format
+/// (version 0.0.4), or, if `openmetrics` is true, in the OpenMetrics text
+/// format.
+OIIO_UTIL_API std::string
+text(bool openmetrics = false);
+
+/// Set `value` to the metric with the given name -- the total of all its
+/// labels, or only of the given ones if the name is followed by them in
+/// braces (`name{key="value"}`), and, for a histogram, the number of
+/// values counted -- and return true, or return false if there is no such
+/// metric.
+OIIO_UTIL_API bool
+value(string_view name, double& value);
+
+}  // namespace Metrics
+
+OIIO_NAMESPACE_END
@@ -48,23 +48,19 @@ public:
     // Fix up all the TBD parameters:
     // * If no pool was specified, use the default pool.
     // * If no max thread count was specified, use the pool size.
-    // * If the calling thread is itself in the pool and the recursive flag
-    //   was not turned on, just use one thread.
     void resolve()
     {
         if (pool == nullptr)
             pool = default_thread_pool();
         if (maxthreads <= 0)
             maxthreads = pool->size() + 1;  // pool size + caller
-        if (!recursive && pool->is_worker())
-            maxthreads = 1;
     }
 
     bool singlethread() const { return maxthreads == 1; }
 
     int maxthreads    = 0;        // Max threads (0 = use all)
     SplitDir splitdir = Split_Y;  // Primary split direction
-    bool recursive    = false;    // Allow thread pool recursion
+    bool recursive    = false;    // No longer needed: always allowed
     size_t minitems   = 16384;    // Min items per task
     thread_pool* pool = nullptr;  // If non-NULL, custom thread pool
     string_view name;             // For debugging
@@ -117,8 +113,8 @@ public:
     // Fix up all the TBD parameters:
     // * If no pool was specified, use the default pool.
     // * If no max thread count was specified, use the pool size.
-    // * If the calling thread is itself in the pool and the recursive flag
-    //   was not turned on, just use one thread.
+    // Loops run from within pool tasks are parallel, too: their chunks go
+    // on the calling pool thread's own queue, for idle threads to steal.
     void resolve();
 
     constexpr bool singlethread() const noexcept { return m_maxthreads == 1; }
@@ -171,7 +167,7 @@ private:
     SplitDir m_splitdir    = SplitDir::Y;  // Primary split direction
     size_t m_minitems      = 16384;        // Min items per task
     thread_pool* m_pool    = nullptr;      // If non-NULL, custom thread pool
-    bool m_recursive       = false;        // Allow thread pool recursion
+    bool m_recursive       = false;        // No longer needed: always allowed
 };
 
 
@@ -281,6 +277,37 @@ parallel_for_chunked_2D(int64_t xbegin, int64_t xend, int64_t xchunksize,
 
 
 
+/// Parallel loop over the tiles of a 2D range: divide [xbegin,xend) x
+/// [ybegin,yend) into square tiles of `tilesize` (those at the right and
+/// bottom edges may be smaller) and run
+///
+///    task (tile_xbegin, tile_xend, tile_ybegin, tile_yend);
+///
+/// for each of them, waiting for them all to complete. Rather than each
+/// thread getting a fixed share of the tiles up front, the threads take
+/// one tile at a time until there are none left, so that those that
+/// finish early take on more. They are taken in Morton (Z curve) order,
+/// so that the tiles being worked on at any moment are near one another.
+///
+/// If tilesize is 0, it will be chosen by `parallel_tile_size(4)`.
+OIIO_UTIL_API void
+parallel_for_tiled_2D(int64_t xbegin, int64_t xend, int64_t ybegin,
+                      int64_t yend, int64_t tilesize,
+                      function_view<void(int64_t xbeg, int64_t xend,
+                                         int64_t ybeg, int64_t yend)>
+                          task,
+                      paropt opt = 0);
+
+/// A tile size for parallel_for_tiled_2D() over items of `itembytes`
+/// bytes each, such that a tile of input and a tile of output, with room
+/// to spare for the input just beyond the tile's edges (as neighborhood
+/// operations read), fit in the L2 cache. It is a multiple of 16, from 16
+/// to 512.
+OIIO_UTIL_API int64_t
+parallel_tile_size(size_t itembytes);
+
+
+
 /// parallel_for, for a task that takes an int threadid and int64_t x & y
 /// indices, running all of:
 ///    task (xbegin, ybegin);
@@ -12,6 +12,10 @@
 
 #pragma once
 
+#include <atomic>
+#include <initializer_list>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include <OpenImageIO/attrdelegate.h>
@@ -154,11 +158,15 @@ public:
     // Rvalue (move) constructor
     ParamValue(ParamValue&& p) noexcept
     {
+        // A value held in the storage of the list that p belongs to must
+        // be copied, since the list may die before we do.
         init_noclear(p.name(), p.type(), p.nvalues(), p.interp(), p.data(),
-                     Copy(false), FromUstring(true));
-        m_copy       = p.m_copy;
-        m_nonlocal   = p.m_nonlocal;
-        p.m_data.ptr = nullptr;  // make sure the old one won't free
+                     Copy(p.m_inlist), FromUstring(true));
+        if (!p.m_inlist) {
+            m_copy       = p.m_copy;
+            m_nonlocal   = p.m_nonlocal;
+            p.m_data.ptr = nullptr;  // make sure the old one won't free
+        }
     }
 
     ~ParamValue() noexcept { clear_value(); }
@@ -288,6 +296,7 @@ private:
     unsigned char m_interp = INTERP_CONSTANT;  ///< Interpolation type
     bool m_copy            = false;
     bool m_nonlocal        = false;
+    bool m_inlist          = false;  ///< data is in a ParamValueList's storage
 
     void init_noclear(ustring _name, TypeDesc _type, int _nvalues,
                       const void* _value, Copy _copy = Copy(true),
@@ -298,6 +307,7 @@ private:
                       FromUstring _from_ustring = FromUstring(false)) noexcept;
     void clear_value() noexcept;
 
+    friend class ParamValueList;
     /// declare a friend heapsize definition
     template<typename T> friend size_t pvt::heapsize(const T&);
 };
@@ -331,9 +341,26 @@ make_pv(string_view name, T* val)
 /// A list of ParamValue entries, that can be iterated over or searched.
 /// It's really just a std::vector<ParamValue>, but with a few more handy
 /// methods.
+///
+/// Searches of long lists are answered from a hash index of the names,
+/// built upon the first search and kept up to date by later ones, so that
+/// they don't need to compare every entry's name. Appended entries are
+/// added to the index, and the list's own insert(), erase(), resize() and
+/// other mutators drop it, but it can't notice an entry being renamed or
+/// the entries being reordered in place through iterators, or the list
+/// being changed through a reference to its std::vector base -- so don't
+/// do that other than by sort().
+///
+/// Copying a list puts all the values too big to be held within their
+/// ParamValue entries into a single allocation owned by the new list.
 class OIIO_UTIL_API ParamValueList : public std::vector<ParamValue> {
 public:
     ParamValueList() {}
+    ParamValueList(const ParamValueList& other);
+    ParamValueList(ParamValueList&& other) noexcept;
+    ~ParamValueList();
+    ParamValueList& operator=(const ParamValueList& other);
+    ParamValueList& operator=(ParamValueList&& other) noexcept;
 
     /// Add space for one more ParamValue to the list, and return a
     /// reference to its slot.
@@ -499,6 +526,12 @@ public:
     ///     names are not already in this list will be appended.
     void merge(const ParamValueList& other, bool override = false);
 
+    /// Remove all entries from the list.
+    void clear() noexcept;
+
+    /// Exchange the contents of two lists.
+    void swap(ParamValueList& other) noexcept;
+
     /// Even more radical than clear, free ALL memory associated with the
     /// list itself.
     void free()
@@ -507,6 +540,62 @@ public:
         shrink_to_fit();
     }
 
+    /// The std::vector mutators that may move entries already in the list,
+    /// which also drop the index of their names. (Appending with
+    /// push_back() or emplace_back() leaves those entries where they were,
+    /// so the next search just indexes the new ones.)
+    template<typename... Args>
+    iterator insert(const_iterator pos, Args&&... args)
+    {
+        drop_index();
+        return std::vector<ParamValue>::insert(pos,
+                                               std::forward<Args>(args)...);
+    }
+    iterator insert(const_iterator pos, std::initializer_list<ParamValue> il)
+    {
+        drop_index();
+        return std::vector<ParamValue>::insert(pos, il);
+    }
+    template<typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        drop_index();
+        return std::vector<ParamValue>::emplace(pos,
+                                                std::forward<Args>(args)...);
+    }
+    template<typename... Args> iterator erase(Args&&... args)
+    {
+        drop_index();
+        return std::vector<ParamValue>::erase(std::forward<Args>(args)...);
+    }
+    template<typename... Args> void assign(Args&&... args)
+    {
+        drop_index();
+        std::vector<ParamValue>::assign(std::forward<Args>(args)...);
+    }
+    void assign(std::initializer_list<ParamValue> il)
+    {
+        drop_index();
+        std::vector<ParamValue>::assign(il);
+    }
+    void pop_back()
+    {
+        drop_index();
+        std::vector<ParamValue>::pop_back();
+    }
+    void resize(size_type n)
+    {
+        if (n < size())
+            drop_index();
+        std::vector<ParamValue>::resize(n);
+    }
+    void resize(size_type n, const ParamValue& value)
+    {
+        if (n < size())
+            drop_index();
+        std::vector<ParamValue>::resize(n, value);
+    }
+
     /// Array indexing by integer will return a reference to the ParamValue
     /// in that position of the list.
     ParamValue& operator[](int index)
@@ -541,6 +630,18 @@ public:
     {
         return { this, name };
     }
+
+private:
+    struct Index;
+    // The index of the names, if one has been built (see paramlist.cpp).
+    mutable std::atomic<Index*> m_index { nullptr };
+    // Storage for the values of the entries copied from another list that
+    // didn't fit within their ParamValue.
+    std::unique_ptr<char[]> m_values;
+
+    const Index* current_index() const;
+    const Index* updated_index();
+    void drop_index() noexcept;
 };
 
 
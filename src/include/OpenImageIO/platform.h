@@ -470,6 +470,45 @@
 #endif
 
 
+// OIIO_TARGET_CLONES(targets...) before a function definition compiles the
+// function once for each of the listed x86 targets (e.g. "avx2") as well as
+// for the baseline, and picks whichever the CPU supports when the library
+// is loaded. It's for hot loops that the compiler can vectorize on its own;
+// the simd.h classes used inside such a function still pick their code at
+// compile time. Where the compiler or platform can't do this, the function
+// is only compiled for the baseline.
+#if defined(__x86_64__) && defined(__ELF__) && defined(__GLIBC__) \
+    && !defined(__CUDA_ARCH__) && !defined(__INTEL_COMPILER)     \
+    && (OIIO_GNUC_VERSION >= 60000 || OIIO_CLANG_VERSION >= 140000)
+#    define OIIO_TARGET_CLONES(...) \
+        __attribute__((target_clones(__VA_ARGS__, "default")))
+#else
+#    define OIIO_TARGET_CLONES(...)
+#endif
+
+// OIIO_SIMD_DISPATCH_CLONES before the definition of a hot kernel compiles
+// it for the x86-64-v3 (AVX2, FMA, F16C) and x86-64-v4 (AVX-512) levels
+// beyond the baseline that the build targets, so that a library built for
+// a conservative USE_SIMD still runs such kernels at full width on newer
+// CPUs. The kernel's own loops must do the work -- the body of a lambda
+// it passes on (to parallel_for, say) is a separate function that is not
+// cloned. This needs GCC 12 or newer (Clang doesn't yet multiversion
+// function templates), and building with OIIO_SIMD_DISPATCH defined to 0
+// (the SIMD_DISPATCH=OFF build option) turns it off.
+#ifndef OIIO_SIMD_DISPATCH
+#    define OIIO_SIMD_DISPATCH 1
+#endif
+#if !OIIO_SIMD_DISPATCH || defined(__clang__) || OIIO_GNUC_VERSION < 120000 \
+    || defined(__AVX512F__)
+#    define OIIO_SIMD_DISPATCH_CLONES
+#elif defined(__AVX2__) && defined(__FMA__)
+#    define OIIO_SIMD_DISPATCH_CLONES OIIO_TARGET_CLONES("arch=x86-64-v4")
+#else
+#    define OIIO_SIMD_DISPATCH_CLONES \
+        OIIO_TARGET_CLONES("arch=x86-64-v3", "arch=x86-64-v4")
+#endif
+
+
 // OIIO_NO_SANITIZE_UNDEFINED can be used to mark a function that you don't
 // want undefined behavior sanitizer to catch. Only use this if you know there
 // are false positives that you can't easily get rid of.
@@ -607,6 +646,15 @@ inline bool cpu_has_avx512cd() {int i[4]; cpuid(i,7,0); return (i[1] & (1<<28))
 inline bool cpu_has_avx512bw() {int i[4]; cpuid(i,7,0); return (i[1] & (1<<30)) != 0; }
 inline bool cpu_has_avx512vl() {int i[4]; cpuid(i,7,0); return (i[1] & (0x80000000 /*1<<31*/)) != 0; }
 
+// NEON is part of every aarch64 CPU, so there's nothing to query at runtime.
+inline bool cpu_has_neon() {
+#if defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+    return true;
+#else
+    return false;
+#endif
+}
+
 // portable aligned malloc
 OIIO_API void* aligned_malloc(std::size_t size, std::size_t align);
 OIIO_API void  aligned_free(void* ptr);
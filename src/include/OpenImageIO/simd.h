@@ -68,6 +68,17 @@
 // OIIO_SIMD_AVX : If Intel AVX is supported, this will be nonzero, and
 //             specifically 1 for AVX (1.0), 2 for AVX2, 512 for AVX512f.
 // OIIO_SIMD_NEON : If ARM NEON is supported, this will be nonzero.
+// OIIO_SIMD_NEON_EXPERIMENTAL : Nonzero only if NEON is supported AND the
+//             user defined it to 1 before including this header. It turns
+//             on the newer NEON paths (8- and 16-wide classes made of
+//             4-wide halves, and the extra NEON conversions, shuffles and
+//             rounding), which have not yet been validated with simd_test
+//             on an ARM target. Otherwise those cases use scalar code.
+// OIIO_SIMD_MASKED_TAILS : If nonzero, loads and stores of fewer than all
+//             the elements use AVX-512 masked instructions. It's nonzero
+//             by default when AVX512VL is enabled; define it as 0 to split
+//             them into narrower pieces instead, which benchmarked faster
+//             on the first AVX-512 hardware (e.g., Xeon Silver 4110).
 // OIIO_SIMD_MAX_SIZE : holds the width in bytes of the widest SIMD
 //             available (generally will be OIIO_SIMD*4).
 // OIIO_SIMD4_ALIGN : macro for best alignment of 4-wide SIMD values in mem.
@@ -231,6 +242,11 @@
 #  define OIIO_AVX512IFMA_ENABLED 0
 #endif
 
+#if !defined(OIIO_SIMD_MASKED_TAILS) || !OIIO_AVX512VL_ENABLED
+#  undef OIIO_SIMD_MASKED_TAILS
+#  define OIIO_SIMD_MASKED_TAILS OIIO_AVX512VL_ENABLED
+#endif
+
 #if defined(__F16C__)
 #  define OIIO_F16C_ENABLED 1
 #else
@@ -247,6 +263,11 @@
 #  define OIIO_SIMD_NEON 0
 #endif
 
+#if !defined(OIIO_SIMD_NEON_EXPERIMENTAL) || !OIIO_SIMD_NEON
+#  undef OIIO_SIMD_NEON_EXPERIMENTAL
+#  define OIIO_SIMD_NEON_EXPERIMENTAL 0
+#endif
+
 #ifndef OIIO_SIMD
    // No SIMD available
 #  define OIIO_SIMD 0
@@ -3719,6 +3740,8 @@ OIIO_FORCEINLINE vbool8::vbool8 (const vbool4& lo, const vbool4 &hi) {
 OIIO_FORCEINLINE vbool8 operator! (const vbool8 & a) {
 #if OIIO_SIMD_AVX
     return _mm256_xor_ps (a.simd(), vbool8::True());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vbool8 (!a.lo(), !a.hi());
 #else
     SIMD_RETURN (vbool8, a[i] ^ (-1));
 #endif
@@ -3727,6 +3750,8 @@ OIIO_FORCEINLINE vbool8 operator! (const vbool8 & a) {
 OIIO_FORCEINLINE vbool8 operator& (const vbool8 & a, const vbool8 & b) {
 #if OIIO_SIMD_AVX
     return _mm256_and_ps (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vbool8 (a.lo() & b.lo(), a.hi() & b.hi());
 #else
     SIMD_RETURN (vbool8, a[i] & b[i]);
 #endif
@@ -3735,6 +3760,8 @@ OIIO_FORCEINLINE vbool8 operator& (const vbool8 & a, const vbool8 & b) {
 OIIO_FORCEINLINE vbool8 operator| (const vbool8 & a, const vbool8 & b) {
 #if OIIO_SIMD_AVX
     return _mm256_or_ps (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vbool8 (a.lo() | b.lo(), a.hi() | b.hi());
 #else
     SIMD_RETURN (vbool8, a[i] | b[i]);
 #endif
@@ -3743,6 +3770,8 @@ OIIO_FORCEINLINE vbool8 operator| (const vbool8 & a, const vbool8 & b) {
 OIIO_FORCEINLINE vbool8 operator^ (const vbool8& a, const vbool8& b) {
 #if OIIO_SIMD_AVX
     return _mm256_xor_ps (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vbool8 (a.lo() ^ b.lo(), a.hi() ^ b.hi());
 #else
     SIMD_RETURN (vbool8, a[i] ^ b[i]);
 #endif
@@ -3766,6 +3795,8 @@ OIIO_FORCEINLINE vbool8 operator~ (const vbool8& a) {
 #if OIIO_SIMD_AVX
     // Fastest way to bit-complement in SSE is to xor with 0xffffffff.
     return _mm256_xor_ps (a.simd(), vbool8::True());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vbool8 (~a.lo(), ~a.hi());
 #else
     SIMD_RETURN (vbool8, ~a[i]);
 #endif
@@ -3777,6 +3808,8 @@ OIIO_FORCEINLINE vbool8 operator== (const vbool8 & a, const vbool8 & b) {
     return _mm256_castsi256_ps (_mm256_cmpeq_epi32 (_mm256_castps_si256 (a), _mm256_castps_si256(b)));
 #elif OIIO_SIMD_AVX
     return _mm256_cmp_ps (a, b, _CMP_EQ_UQ);
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vbool8 (a.lo() == b.lo(), a.hi() == b.hi());
 #else
     SIMD_RETURN (vbool8, a[i] == b[i] ? -1 : 0);
 #endif
@@ -3785,6 +3818,8 @@ OIIO_FORCEINLINE vbool8 operator== (const vbool8 & a, const vbool8 & b) {
 OIIO_FORCEINLINE vbool8 operator!= (const vbool8 & a, const vbool8 & b) {
 #if OIIO_SIMD_AVX
     return _mm256_xor_ps (a, b);
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vbool8 (a.lo() != b.lo(), a.hi() != b.hi());
 #else
     SIMD_RETURN (vbool8, a[i] != b[i] ? -1 : 0);
 #endif
@@ -3832,6 +3867,8 @@ OIIO_FORCEINLINE bool reduce_and (const vbool8& v) {
 #if OIIO_SIMD_AVX
     return _mm256_testc_ps (v, vbool8(true)) != 0;
     // return _mm256_movemask_ps(v.simd()) == 0xff;
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return reduce_and (v.lo() & v.hi());
 #else
     SIMD_RETURN_REDUCE (bool, true, r &= bool(v[i]));
 #endif
@@ -3841,6 +3878,8 @@ OIIO_FORCEINLINE bool reduce_or (const vbool8& v) {
 #if OIIO_SIMD_AVX
     return ! _mm256_testz_ps (v, v);   // FIXME? Not in all immintrin.h !
     // return _mm256_movemask_ps(v) != 0;
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return reduce_or (v.lo() | v.hi());
 #else
     SIMD_RETURN_REDUCE (bool, false, r |= bool(v[i]));
 #endif
@@ -3973,7 +4012,7 @@ OIIO_FORCEINLINE vbool8 vbool16::lo () const {
 #if OIIO_SIMD_AVX >= 512
     return _mm256_castsi256_ps (_mm256_maskz_set1_epi32 (bitmask()&0xff, -1));
 #else
-    SIMD_RETURN (vbool8, (*this)[i] ? -1 : 0);
+    return vbool8::from_bitmask (bitmask() & 0xff);
 #endif
 }
 
@@ -3981,7 +4020,7 @@ OIIO_FORCEINLINE vbool8 vbool16::hi () const {
 #if OIIO_SIMD_AVX >= 512
     return _mm256_castsi256_ps (_mm256_maskz_set1_epi32 (bitmask()>>8, -1));
 #else
-    SIMD_RETURN (vbool8, (*this)[i+8] ? -1 : 0);
+    return vbool8::from_bitmask (bitmask() >> 8);
 #endif
 }
 
@@ -4202,6 +4241,8 @@ OIIO_FORCEINLINE void vint4::load (const unsigned short *values) {
     // Trickery: load one double worth of bits = 4 ushorts!
     simd_t a = _mm_castpd_si128 (_mm_load_sd ((const double *)values));
     m_simd = _mm_cvtepu16_epi32 (a);
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    m_simd = vreinterpretq_s32_u32 (vmovl_u16 (vld1_u16 (values)));
 #else
     SIMD_CONSTRUCT (values[i]);
 #endif
@@ -4213,6 +4254,8 @@ OIIO_FORCEINLINE void vint4::load (const short *values) {
     // Trickery: load one double worth of bits = 4 shorts!
     simd_t a = _mm_castpd_si128 (_mm_load_sd ((const double *)values));
     m_simd = _mm_cvtepi16_epi32 (a);
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    m_simd = vmovl_s16 (vld1_s16 (values));
 #else
     SIMD_CONSTRUCT (values[i]);
 #endif
@@ -4229,6 +4272,12 @@ OIIO_FORCEINLINE void vint4::load (const unsigned char *values) {
     simd_t a = _mm_castps_si128 (_mm_load_ss ((const float *)values));
     a = _mm_unpacklo_epi8(a, _mm_setzero_si128());
     m_simd = _mm_unpacklo_epi16(a, _mm_setzero_si128());
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    // Load the 4 bytes as one 32 bit lane, then widen twice
+    uint32_t bits;
+    memcpy (&bits, values, sizeof(bits));
+    uint16x8_t a = vmovl_u8 (vreinterpret_u8_u32 (vdup_n_u32 (bits)));
+    m_simd = vreinterpretq_s32_u32 (vmovl_u16 (vget_low_u16 (a)));
 #else
     SIMD_CONSTRUCT (values[i]);
 #endif
@@ -4240,6 +4289,11 @@ OIIO_FORCEINLINE void vint4::load (const char *values) {
     // Trickery: load one float worth of bits = 4 chars!
     simd_t a = _mm_castps_si128 (_mm_load_ss ((const float *)values));
     m_simd = _mm_cvtepi8_epi32 (a);
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    uint32_t bits;
+    memcpy (&bits, values, sizeof(bits));
+    int16x8_t a = vmovl_s8 (vreinterpret_s8_u32 (vdup_n_u32 (bits)));
+    m_simd = vmovl_s16 (vget_low_s16 (a));
 #else
     SIMD_CONSTRUCT (values[i]);
 #endif
@@ -4672,10 +4726,7 @@ inline std::ostream& operator<< (std::ostream& cout, const vint4& val) {
 
 OIIO_FORCEINLINE void vint4::store (int *values, int n) const {
     OIIO_DASSERT (n >= 0 && n <= elements);
-#if 0 && OIIO_SIMD_AVX >= 512 && OIIO_AVX512VL_ENABLED
-    // This SHOULD be fast, but in my benchmarks, it is slower!
-    // (At least on the AVX512 hardware I have, Xeon Silver 4110.)
-    // Re-test this periodically with new Intel hardware.
+#if OIIO_SIMD_MASKED_TAILS
     _mm_mask_storeu_epi32 (values, __mmask8(~(0xf << n)), m_simd);
 #elif OIIO_SIMD
     // For full SIMD, there is a speed advantage to storing all components.
@@ -4707,6 +4758,8 @@ OIIO_FORCEINLINE void vint4::store (unsigned short *values) const {
     vint4 result = low | highswapped;   // ABCDxxxx
     _mm_storel_pd ((double *)values, _mm_castsi128_pd(result));
     // At this point, values[] should hold A,B,C,D
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    vst1_u16 (values, vmovn_u32 (vreinterpretq_u32_s32 (m_simd)));
 #else
     SIMD_DO (values[i] = m_val[i]);
 #endif
@@ -4844,6 +4897,9 @@ OIIO_FORCEINLINE int reduce_and (const vint4& v) {
     vint4 ab = v & shuffle<1,1,3,3>(v); // ab bb cd dd
     vint4 abcd = ab & shuffle<2>(ab);
     return extract<0>(abcd);
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    int32x2_t ab = vand_s32 (vget_low_s32 (v), vget_high_s32 (v));
+    return vget_lane_s32 (ab, 0) & vget_lane_s32 (ab, 1);
 #else
     SIMD_RETURN_REDUCE (int, -1, r &= v[i]);
 #endif
@@ -4855,6 +4911,9 @@ OIIO_FORCEINLINE int reduce_or (const vint4& v) {
     vint4 ab = v | shuffle<1,1,3,3>(v); // ab bb cd dd
     vint4 abcd = ab | shuffle<2>(ab);
     return extract<0>(abcd);
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    int32x2_t ab = vorr_s32 (vget_low_s32 (v), vget_high_s32 (v));
+    return vget_lane_s32 (ab, 0) | vget_lane_s32 (ab, 1);
 #else
     SIMD_RETURN_REDUCE (int, 0, r |= v[i]);
 #endif
@@ -4890,6 +4949,8 @@ OIIO_FORCEINLINE vint4 blend0 (const vint4& a, const vbool4& mask) {
 OIIO_FORCEINLINE vint4 blend0not (const vint4& a, const vbool4& mask) {
 #if OIIO_SIMD_SSE
     return _mm_andnot_si128(_mm_castps_si128(mask), a.simd());
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    return vbicq_s32 (a.simd(), vreinterpretq_s32_u32 (mask.simd()));
 #else
     SIMD_RETURN (vint4, mask[i] ? 0.0f : a[i]);
 #endif
@@ -4951,6 +5012,8 @@ OIIO_FORCEINLINE vint4 rotl(const vint4& x, int s) {
 OIIO_FORCEINLINE vint4 andnot (const vint4& a, const vint4& b) {
 #if OIIO_SIMD_SSE
     return _mm_andnot_si128 (a.simd(), b.simd());
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    return vbicq_s32 (b.simd(), a.simd());
 #else
     SIMD_RETURN (vint4, ~(a[i]) & b[i]);
 #endif
@@ -5313,6 +5376,8 @@ OIIO_FORCEINLINE vint8::vint8 (const vint4& lo, const vint4 &hi) {
 OIIO_FORCEINLINE vint8 operator+ (const vint8& a, const vint8& b) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_add_epi32 (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vint8 (a.lo() + b.lo(), a.hi() + b.hi());
 #else
     SIMD_RETURN (vint8, a[i] + b[i]);
 #endif
@@ -5327,6 +5392,8 @@ OIIO_FORCEINLINE const vint8& operator+= (vint8& a, const vint8& b) {
 OIIO_FORCEINLINE vint8 operator- (const vint8& a) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_sub_epi32 (_mm256_setzero_si256(), a);
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vint8 (-a.lo(), -a.hi());
 #else
     SIMD_RETURN (vint8, -a[i]);
 #endif
@@ -5336,6 +5403,8 @@ OIIO_FORCEINLINE vint8 operator- (const vint8& a) {
 OIIO_FORCEINLINE vint8 operator- (const vint8& a, const vint8& b) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_sub_epi32 (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vint8 (a.lo() - b.lo(), a.hi() - b.hi());
 #else
     SIMD_RETURN (vint8, a[i] - b[i]);
 #endif
@@ -5350,6 +5419,8 @@ OIIO_FORCEINLINE const vint8 &operator-= (vint8& a, const vint8& b) {
 OIIO_FORCEINLINE vint8 operator* (const vint8& a, const vint8& b) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_mullo_epi32 (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vint8 (a.lo() * b.lo(), a.hi() * b.hi());
 #else
     SIMD_RETURN (vint8, a[i] * b[i]);
 #endif
@@ -5386,6 +5457,8 @@ OIIO_FORCEINLINE const vint8& operator%= (vint8& a, int b) { return a = a % b; }
 OIIO_FORCEINLINE vint8 operator& (const vint8& a, const vint8& b) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_and_si256 (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vint8 (a.lo() & b.lo(), a.hi() & b.hi());
 #else
     SIMD_RETURN (vint8, a[i] & b[i]);
 #endif
@@ -5396,6 +5469,8 @@ OIIO_FORCEINLINE const vint8& operator&= (vint8& a, const vint8& b) { return a =
 OIIO_FORCEINLINE vint8 operator| (const vint8& a, const vint8& b) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_or_si256 (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vint8 (a.lo() | b.lo(), a.hi() | b.hi());
 #else
     SIMD_RETURN (vint8, a[i] | b[i]);
 #endif
@@ -5406,6 +5481,8 @@ OIIO_FORCEINLINE const vint8& operator|= (vint8& a, const vint8& b) { return a =
 OIIO_FORCEINLINE vint8 operator^ (const vint8& a, const vint8& b) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_xor_si256 (a.simd(), b.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vint8 (a.lo() ^ b.lo(), a.hi() ^ b.hi());
 #else
     SIMD_RETURN (vint8, a[i] ^ b[i]);
 #endif
@@ -5417,6 +5494,8 @@ OIIO_FORCEINLINE const vint8& operator^= (vint8& a, const vint8& b) { return a =
 OIIO_FORCEINLINE vint8 operator~ (const vint8& a) {
 #if OIIO_SIMD_AVX >= 2
     return a ^ a.NegOne();
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vint8 (~a.lo(), ~a.hi());
 #else
     SIMD_RETURN (vint8, ~a[i]);
 #endif
@@ -5426,7 +5505,7 @@ OIIO_FORCEINLINE vint8 operator~ (const vint8& a) {
 OIIO_FORCEINLINE vint8 operator<< (const vint8& a, unsigned int bits) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_slli_epi32 (a, bits);
-#elif OIIO_SIMD_SSE
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
     return vint8 (a.lo() << bits, a.hi() << bits);
 #else
     SIMD_RETURN (vint8, a[i] << bits);
@@ -5441,7 +5520,7 @@ OIIO_FORCEINLINE const vint8& operator<<= (vint8& a, const unsigned int bits) {
 OIIO_FORCEINLINE vint8 operator>> (const vint8& a, const unsigned int bits) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_srai_epi32 (a, bits);
-#elif OIIO_SIMD_SSE
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
     return vint8 (a.lo() >> bits, a.hi() >> bits);
 #else
     SIMD_RETURN (vint8, a[i] >> bits);
@@ -5456,6 +5535,8 @@ OIIO_FORCEINLINE const vint8& operator>>= (vint8& a, const unsigned int bits) {
 OIIO_FORCEINLINE vint8 srl (const vint8& a, const unsigned int bits) {
 #if OIIO_SIMD_AVX >= 2
     return _mm256_srli_epi32 (a, bits);
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vint8 (srl(a.lo(), bits), srl(a.hi(), bits));
 #else
     SIMD_RETURN (vint8, int ((unsigned int)(a[i]) >> bits));
 #endif
@@ -5466,7 +5547,7 @@ OIIO_FORCEINLINE vbool8 operator== (const vint8& a, const vint8& b) {
     // FIXME: on AVX-512 should we use _mm256_cmp_epi32_mask() ?
 #if OIIO_SIMD_AVX >= 2
     return _mm256_castsi256_ps(_mm256_cmpeq_epi32 (a.m_simd, b.m_simd));
-#elif OIIO_SIMD_SSE  /* Fall back to 4-wide */
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL  /* Fall back to 4-wide */
     return vbool8 (a.lo() == b.lo(), a.hi() == b.hi());
 #else
     SIMD_RETURN (vbool8, a[i] == b[i] ? -1 : 0);
@@ -5484,7 +5565,7 @@ OIIO_FORCEINLINE vbool8 operator> (const vint8& a, const vint8& b) {
     // FIXME: on AVX-512 should we use _mm256_cmp_epi32_mask() ?
 #if OIIO_SIMD_AVX >= 2
     return _mm256_castsi256_ps(_mm256_cmpgt_epi32 (a, b));
-#elif OIIO_SIMD_SSE  /* Fall back to 4-wide */
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL  /* Fall back to 4-wide */
     return vbool8 (a.lo() > b.lo(), a.hi() > b.hi());
 #else
     SIMD_RETURN (vbool8, a[i] > b[i] ? -1 : 0);
@@ -5497,7 +5578,7 @@ OIIO_FORCEINLINE vbool8 operator< (const vint8& a, const vint8& b) {
 #if OIIO_SIMD_AVX >= 2
     // No lt or lte!
     return (b > a);
-#elif OIIO_SIMD_SSE  /* Fall back to 4-wide */
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL  /* Fall back to 4-wide */
     return vbool8 (a.lo() < b.lo(), a.hi() < b.hi());
 #else
     SIMD_RETURN (vbool8, a[i] < b[i] ? -1 : 0);
@@ -5527,12 +5608,9 @@ inline std::ostream& operator<< (std::ostream& cout, const vint8& val) {
 
 OIIO_FORCEINLINE void vint8::store (int *values, int n) const {
     OIIO_DASSERT (n >= 0 && n <= elements);
-#if 0 && OIIO_SIMD_AVX >= 512 && OIIO_AVX512VL_ENABLED
-    // This SHOULD be fast, but in my benchmarks, it is slower!
-    // (At least on the AVX512 hardware I have, Xeon Silver 4110.)
-    // Re-test this periodically with new Intel hardware.
+#if OIIO_SIMD_MASKED_TAILS
     _mm256_mask_storeu_epi32 (values, __mmask8(~(0xff << n)), m_simd);
-#elif OIIO_SIMD_SSE
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
     if (n <= 4) {
         lo().store (values, n);
     } else if (n < 8) {
@@ -5553,7 +5631,7 @@ OIIO_FORCEINLINE void vint8::store (int *values, int n) const {
 OIIO_FORCEINLINE void vint8::store (unsigned short *values) const {
 #if OIIO_AVX512VL_ENABLED
     _mm256_mask_cvtepi32_storeu_epi16 (values, __mmask8(0xff), m_simd);
-#elif OIIO_SIMD_SSE
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
     lo().store (values);
     hi().store (values+4);
 #else
@@ -5565,7 +5643,7 @@ OIIO_FORCEINLINE void vint8::store (unsigned short *values) const {
 OIIO_FORCEINLINE void vint8::store (unsigned char *values) const {
 #if OIIO_AVX512VL_ENABLED
     _mm256_mask_cvtepi32_storeu_epi8 (values, __mmask8(0xff), m_simd);
-#elif OIIO_SIMD_SSE
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
     lo().store (values);
     hi().store (values+4);
 #else
@@ -5688,7 +5766,7 @@ OIIO_FORCEINLINE vint8 blend (const vint8& a, const vint8& b, const vbool8& mask
 #if OIIO_SIMD_AVX
     return _mm256_castps_si256 (_mm256_blendv_ps (_mm256_castsi256_ps(a.simd()),
                                                   _mm256_castsi256_ps(b.simd()), mask));
-#elif OIIO_SIMD_SSE
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
     return vint8 (blend(a.lo(), b.lo(), mask.lo()),
                  blend(a.hi(), b.hi(), mask.hi()));
 #else
@@ -5702,7 +5780,7 @@ OIIO_FORCEINLINE vint8 blend0 (const vint8& a, const vbool8& mask) {
 // _mm256_maxkz_mov_epi32(_mm256_movemask_ps(maxk),a))?
 #if OIIO_SIMD_AVX
     return _mm256_castps_si256(_mm256_and_ps(_mm256_castsi256_ps(a.simd()), mask));
-#elif OIIO_SIMD_SSE
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
     return vint8 (blend0(a.lo(), mask.lo()),
                  blend0(a.hi(), mask.hi()));
 #else
@@ -5716,7 +5794,7 @@ OIIO_FORCEINLINE vint8 blend0not (const vint8& a, const vbool8& mask) {
 // _mm256_maxkz_mov_epi32(_mm256_movemask_ps(!maxk),a))?
 #if OIIO_SIMD_AVX
     return _mm256_castps_si256 (_mm256_andnot_ps (mask.simd(), _mm256_castsi256_ps(a.simd())));
-#elif OIIO_SIMD_SSE
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
     return vint8 (blend0not(a.lo(), mask.lo()),
                  blend0not(a.hi(), mask.hi()));
 #else
@@ -5776,6 +5854,8 @@ OIIO_FORCEINLINE vint8 andnot (const vint8& a, const vint8& b) {
     return _mm256_andnot_si256 (a.simd(), b.simd());
 #elif OIIO_SIMD_AVX >= 1
     return _mm256_castps_si256 (_mm256_andnot_ps (_mm256_castsi256_ps(a.simd()), _mm256_castsi256_ps(b.simd())));
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vint8 (andnot(a.lo(), b.lo()), andnot(a.hi(), b.hi()));
 #else
     SIMD_RETURN (vint8, ~(a[i]) & b[i]);
 #endif
@@ -6324,10 +6404,7 @@ inline std::ostream& operator<< (std::ostream& cout, const vint16& val) {
 
 OIIO_FORCEINLINE void vint16::store (int *values, int n) const {
     OIIO_DASSERT (n >= 0 && n <= elements);
-#if 0 && OIIO_SIMD_AVX >= 512
-    // This SHOULD be fast, but in my benchmarks, it is slower!
-    // (At least on the AVX512 hardware I have, Xeon Silver 4110.)
-    // Re-test this periodically with new Intel hardware.
+#if OIIO_SIMD_AVX >= 512 && OIIO_SIMD_MASKED_TAILS
     _mm512_mask_storeu_epi32 (values, __mmask16(~(0xffff << n)), m_simd);
 #else
     if (n > 8) {
@@ -6343,11 +6420,9 @@ OIIO_FORCEINLINE void vint16::store (int *values, int n) const {
 OIIO_FORCEINLINE void vint16::store (unsigned short *values) const {
 #if OIIO_SIMD_AVX512
     _mm512_mask_cvtepi32_storeu_epi16 (values, __mmask16(0xff), m_simd);
-#elif OIIO_SIMD_AVX >= 2
+#else
     lo().store (values);
     hi().store (values+8);
-#else
-    SIMD_DO (values[i] = m_val[i]);
 #endif
 }
 
@@ -6355,11 +6430,9 @@ OIIO_FORCEINLINE void vint16::store (unsigned short *values) const {
 OIIO_FORCEINLINE void vint16::store (unsigned char *values) const {
 #if OIIO_SIMD_AVX512
     _mm512_mask_cvtepi32_storeu_epi8 (values, __mmask16(0xff), m_simd);
-#elif OIIO_SIMD_AVX >= 2
+#else
     lo().store (values);
     hi().store (values+8);
-#else
-    SIMD_DO (values[i] = m_val[i]);
 #endif
 }
 
@@ -6742,6 +6815,8 @@ OIIO_FORCEINLINE void vfloat4::load (const unsigned short *values) {
     m_simd = _mm_cvtepi32_ps (vint4(values).simd());
     // You might guess that the following is faster, but it's NOT:
     //   NO!  m_simd = _mm_cvtpu16_ps (*(__m64*)values);
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    m_simd = vcvtq_f32_s32 (vint4(values).simd());
 #else
     SIMD_CONSTRUCT (values[i]);
 #endif
@@ -6751,6 +6826,8 @@ OIIO_FORCEINLINE void vfloat4::load (const unsigned short *values) {
 OIIO_FORCEINLINE void vfloat4::load (const short *values) {
 #if OIIO_SIMD_SSE >= 2
     m_simd = _mm_cvtepi32_ps (vint4(values).simd());
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    m_simd = vcvtq_f32_s32 (vint4(values).simd());
 #else
     SIMD_CONSTRUCT (values[i]);
 #endif
@@ -6760,6 +6837,8 @@ OIIO_FORCEINLINE void vfloat4::load (const short *values) {
 OIIO_FORCEINLINE void vfloat4::load (const unsigned char *values) {
 #if OIIO_SIMD_SSE >= 2
     m_simd = _mm_cvtepi32_ps (vint4(values).simd());
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    m_simd = vcvtq_f32_s32 (vint4(values).simd());
 #else
     SIMD_CONSTRUCT (values[i]);
 #endif
@@ -6769,6 +6848,8 @@ OIIO_FORCEINLINE void vfloat4::load (const unsigned char *values) {
 OIIO_FORCEINLINE void vfloat4::load (const char *values) {
 #if OIIO_SIMD_SSE >= 2
     m_simd = _mm_cvtepi32_ps (vint4(values).simd());
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    m_simd = vcvtq_f32_s32 (vint4(values).simd());
 #else
     SIMD_CONSTRUCT (values[i]);
 #endif
@@ -6845,10 +6926,7 @@ OIIO_FORCEINLINE void vfloat4::store (float *values) const {
 
 OIIO_FORCEINLINE void vfloat4::store (float *values, int n) const {
     OIIO_DASSERT (n >= 0 && n <= 4);
-#if 0 && OIIO_SIMD_AVX >= 512 && OIIO_AVX512VL_ENABLED
-    // This SHOULD be fast, but in my benchmarks, it is slower!
-    // (At least on the AVX512 hardware I have, Xeon Silver 4110.)
-    // Re-test this periodically with new Intel hardware.
+#if OIIO_SIMD_MASKED_TAILS
     _mm_mask_storeu_ps (values, __mmask8(~(0xf << n)), m_simd);
 #elif OIIO_SIMD_SSE
     switch (n) {
@@ -7540,6 +7618,8 @@ OIIO_FORCEINLINE vfloat4 ceil (const vfloat4& a)
 {
 #if OIIO_SIMD_SSE >= 4  /* SSE >= 4.1 */
     return _mm_ceil_ps (a);
+#elif OIIO_SIMD_NEON_EXPERIMENTAL && defined(__aarch64__)
+    return vrndpq_f32 (a);
 #else
     SIMD_RETURN (vfloat4, ceilf(a[i]));
 #endif
@@ -7549,6 +7629,8 @@ OIIO_FORCEINLINE vfloat4 floor (const vfloat4& a)
 {
 #if OIIO_SIMD_SSE >= 4  /* SSE >= 4.1 */
     return _mm_floor_ps (a);
+#elif OIIO_SIMD_NEON_EXPERIMENTAL && defined(__aarch64__)
+    return vrndmq_f32 (a);
 #else
     SIMD_RETURN (vfloat4, floorf(a[i]));
 #endif
@@ -7570,6 +7652,8 @@ OIIO_FORCEINLINE vint4 ifloor (const vfloat4& a)
     // FIXME: look into this, versus the method of quick_floor in texturesys.cpp
 #if OIIO_SIMD_SSE >= 4  /* SSE >= 4.1 */
     return vint4(floor(a));
+#elif OIIO_SIMD_NEON_EXPERIMENTAL && defined(__aarch64__)
+    return vcvtmq_s32_f32 (a);
 #else
     SIMD_RETURN (vint4, (int)floorf(a[i]));
 #endif
@@ -7595,6 +7679,10 @@ OIIO_FORCEINLINE vfloat4 rcp_fast (const vfloat4 &a)
 #elif OIIO_SIMD_SSE
     vfloat4 r = _mm_rcp_ps(a);
     return r * nmadd(r,a,vfloat4(2.0f));
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    // Estimate, then one Newton-Raphson step, as for SSE
+    float32x4_t r = vrecpeq_f32 (a);
+    return vmulq_f32 (r, vrecpsq_f32 (a, r));
 #else
     SIMD_RETURN (vfloat4, 1.0f/a[i]);
 #endif
@@ -7635,6 +7723,10 @@ OIIO_FORCEINLINE vfloat4 rsqrt_fast (const vfloat4 &a)
     return _mm512_castps512_ps128(_mm512_rsqrt14_ps(_mm512_castps128_ps512(a)));
 #elif OIIO_SIMD_SSE
     return _mm_rsqrt_ps (a.simd());
+#elif OIIO_SIMD_NEON_EXPERIMENTAL
+    // Estimate, then one Newton-Raphson step
+    float32x4_t r = vrsqrteq_f32 (a);
+    return vmulq_f32 (r, vrsqrtsq_f32 (vmulq_f32 (a, r), r));
 #else
     SIMD_RETURN (vfloat4, 1.0f/sqrtf(a[i]));
 #endif
@@ -8584,6 +8676,9 @@ OIIO_FORCEINLINE vfloat8::vfloat8 (const vfloat4& lo, const vfloat4 &hi) {
 OIIO_FORCEINLINE vfloat8::vfloat8 (const vint8& ival) {
 #if OIIO_SIMD_AVX
     m_simd = _mm256_cvtepi32_ps (ival);
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    m_4[0] = vfloat4 (ival.lo());
+    m_4[1] = vfloat4 (ival.hi());
 #else
     SIMD_CONSTRUCT (float(ival[i]));
 #endif
@@ -8663,11 +8758,8 @@ OIIO_FORCEINLINE void vfloat8::load (const float *values) {
 
 OIIO_FORCEINLINE void vfloat8::load (const float *values, int n) {
     OIIO_DASSERT (n >= 0 && n <= elements);
-#if 0 && OIIO_AVX512VL_ENABLED
-    // This SHOULD be fast, but in my benchmarks, it is slower!
-    // (At least on the AVX512 hardware I have, Xeon Silver 4110.)
-    // Re-test this periodically with new Intel hardware.
-    m_simd = _mm256_maskz_loadu_ps ((~(0xff << n)), values);
+#if OIIO_SIMD_MASKED_TAILS
+    m_simd = _mm256_maskz_loadu_ps (__mmask8(~(0xff << n)), values);
 #elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
     if (n > 4) {
         vfloat4 lo, hi;
@@ -8773,10 +8865,7 @@ OIIO_FORCEINLINE void vfloat8::store (float *values) const {
 
 OIIO_FORCEINLINE void vfloat8::store (float *values, int n) const {
     OIIO_DASSERT (n >= 0 && n <= elements);
-#if 0 && OIIO_AVX512VL_ENABLED
-    // This SHOULD be fast, but in my benchmarks, it is slower!
-    // (At least on the AVX512 hardware I have, Xeon Silver 4110.)
-    // Re-test this periodically with new Intel hardware.
+#if OIIO_SIMD_MASKED_TAILS
     _mm256_mask_storeu_ps (values,  __mmask8(~(0xff << n)), m_simd);
 #elif OIIO_SIMD_SSE || OIIO_SIMD_NEON
     if (n <= 4) {
@@ -9172,7 +9261,7 @@ OIIO_FORCEINLINE vfloat8 select (const vbool8& mask, const vfloat8& a, const vfl
 
 
 OIIO_FORCEINLINE vfloat8 safe_div (const vfloat8 &a, const vfloat8 &b) {
-#if OIIO_SIMD_SSE
+#if OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
     return blend0not (a/b, b == vfloat8::Zero());
 #else
     SIMD_RETURN (vfloat8, b[i] == 0.0f ? 0.0f : a[i] / b[i]);
@@ -9204,6 +9293,8 @@ OIIO_FORCEINLINE vfloat8 ceil (const vfloat8& a)
 {
 #if OIIO_SIMD_AVX
     return _mm256_ceil_ps (a);
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vfloat8 (ceil(a.lo()), ceil(a.hi()));
 #else
     SIMD_RETURN (vfloat8, ceilf(a[i]));
 #endif
@@ -9213,6 +9304,8 @@ OIIO_FORCEINLINE vfloat8 floor (const vfloat8& a)
 {
 #if OIIO_SIMD_AVX
     return _mm256_floor_ps (a);
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vfloat8 (floor(a.lo()), floor(a.hi()));
 #else
     SIMD_RETURN (vfloat8, floorf(a[i]));
 #endif
@@ -9222,6 +9315,8 @@ OIIO_FORCEINLINE vfloat8 round (const vfloat8& a)
 {
 #if OIIO_SIMD_AVX
     return _mm256_round_ps (a, (_MM_FROUND_TO_NEAREST_INT |_MM_FROUND_NO_EXC));
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vfloat8 (round(a.lo()), round(a.hi()));
 #else
     SIMD_RETURN (vfloat8, roundf(a[i]));
 #endif
@@ -9232,7 +9327,7 @@ OIIO_FORCEINLINE vint8 ifloor (const vfloat8& a)
     // FIXME: look into this, versus the method of quick_floor in texturesys.cpp
 #if OIIO_SIMD_AVX
     return vint8(floor(a));
-#elif OIIO_SIMD_SSE   /* SSE2/3 */
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
     return vint8 (ifloor(a.lo()), ifloor(a.hi()));
 #else
     SIMD_RETURN (vint8, (int)floorf(a[i]));
@@ -9265,6 +9360,8 @@ OIIO_FORCEINLINE vfloat8 sqrt (const vfloat8 &a)
 {
 #if OIIO_SIMD_AVX
     return _mm256_sqrt_ps (a.simd());
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vfloat8 (sqrt(a.lo()), sqrt(a.hi()));
 #else
     SIMD_RETURN (vfloat8, sqrtf(a[i]));
 #endif
@@ -9276,6 +9373,8 @@ OIIO_FORCEINLINE vfloat8 rsqrt (const vfloat8 &a)
 {
 #if OIIO_SIMD_AVX
     return _mm256_div_ps (_mm256_set1_ps(1.0f), _mm256_sqrt_ps (a.simd()));
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
+    return vfloat8 (rsqrt(a.lo()), rsqrt(a.hi()));
 #else
     SIMD_RETURN (vfloat8, 1.0f/sqrtf(a[i]));
 #endif
@@ -9293,7 +9392,7 @@ OIIO_FORCEINLINE vfloat8 rsqrt_fast (const vfloat8 &a)
     return _mm512_castps512_ps256(_mm512_rsqrt14_ps(_mm512_castps256_ps512(a)));
 #elif OIIO_SIMD_AVX
     return _mm256_rsqrt_ps (a.simd());
-#elif OIIO_SIMD_SSE
+#elif OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
     return vfloat8 (rsqrt_fast(a.lo()), rsqrt_fast(a.hi()));
 #else
     SIMD_RETURN (vfloat8, 1.0f/sqrtf(a[i]));
@@ -9481,7 +9580,8 @@ OIIO_FORCEINLINE vfloat16::vfloat16 (const vint16& ival) {
 #if OIIO_SIMD_AVX >= 512
     m_simd = _mm512_cvtepi32_ps (ival);
 #else
-    SIMD_CONSTRUCT (float(ival[i]));
+    m_8[0] = vfloat8 (ival.lo());
+    m_8[1] = vfloat8 (ival.hi());
 #endif
 }
 
@@ -9652,11 +9752,7 @@ OIIO_FORCEINLINE void vfloat16::store (float *values) const {
 
 OIIO_FORCEINLINE void vfloat16::store (float *values, int n) const {
     OIIO_DASSERT (n >= 0 && n <= elements);
-    // FIXME: is this faster with AVX masked stores?
-#if 0 && OIIO_SIMD_AVX >= 512
-    // This SHOULD be fast, but in my benchmarks, it is slower!
-    // (At least on the AVX512 hardware I have, Xeon Silver 4110.)
-    // Re-test this periodically with new Intel hardware.
+#if OIIO_SIMD_AVX >= 512 && OIIO_SIMD_MASKED_TAILS
     _mm512_mask_storeu_ps (values, __mmask16(~(0xffff << n)), m_simd);
 #else
     if (n <= 8) {
@@ -10039,7 +10135,7 @@ OIIO_FORCEINLINE vfloat16 select (const vbool16& mask, const vfloat16& a, const
 
 
 OIIO_FORCEINLINE vfloat16 safe_div (const vfloat16 &a, const vfloat16 &b) {
-#if OIIO_SIMD_SSE
+#if OIIO_SIMD_SSE || OIIO_SIMD_NEON_EXPERIMENTAL
     return blend0not (a/b, b == vfloat16::Zero());
 #else
     SIMD_RETURN (vfloat16, b[i] == 0.0f ? 0.0f : a[i] / b[i]);
@@ -623,7 +623,9 @@ OIIO_UTIL_API unsigned int stoui (string_view s, size_t* pos=0, int base=10);
 /// stof() returns the float conversion of text from several string types.
 /// No exceptions or errors -- parsing errors just return 0.0. These always
 /// use '.' for the decimal mark (versus atof and std::strtof, which are
-/// locale-dependent).
+/// locale-dependent). Where the standard library has a floating point
+/// std::from_chars, that is used for all but hex or out-of-range values,
+/// and needs no copy of a string_view.
 OIIO_UTIL_API float stof (string_view s, size_t* pos=0);
 #define OIIO_STRUTIL_HAS_STOF 1  /* be able to test this */
 
@@ -1008,6 +1010,18 @@ parse_values(string_view& str, string_view prefix, span<float> values,
              string_view sep = "", string_view postfix = "",
              bool eat = true) noexcept;
 
+/// Parse from `str` as many whitespace-separated int values as will fit in
+/// mutable span `values`, stopping early at anything that isn't a number,
+/// and return the number of values parsed. If `eat` is true, `str` will be
+/// updated in place to trim the values that were parsed. It is meant for
+/// reading long runs of numbers, such as the pixel values of an ASCII
+/// image file.
+size_t OIIO_UTIL_API
+parse_numbers(string_view& str, span<int> values, bool eat = true) noexcept;
+/// parse_numbers for float.
+size_t OIIO_UTIL_API
+parse_numbers(string_view& str, span<float> values, bool eat = true) noexcept;
+
 /// Similar to parse_values, but with no option to "eat" from
 /// or modify the source string.
 inline bool
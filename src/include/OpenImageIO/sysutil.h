@@ -52,6 +52,11 @@ memory_used(bool resident = true);
 OIIO_UTIL_API size_t
 physical_memory();
 
+/// The size, in bytes, of each core's L2 data cache. If it can't figure it
+/// out, it will return a typical size of 512 KB.
+OIIO_UTIL_API size_t
+l2_cache_size();
+
 /// Convert calendar time pointed by 'time' into local time and save it in
 /// 'converted_time' variable. This is a fully reentrant/thread-safe
 /// alternative to the non-reentrant C localtime() call.
@@ -127,6 +127,7 @@ enum class MipMode : uint8_t {
     OneLevel,   ///< Use just one mipmap level
     Trilinear,  ///< Use two MIPmap levels (trilinear)
     Aniso,      ///< Use two MIPmap levels w/ anisotropic
+    EWA,        ///< Elliptical weighted average on one MIPmap level
 };
 
 /// Interp mode determines how we sample within a mipmap level
@@ -225,6 +226,7 @@ public:
     static constexpr Tex::MipMode MipModeOneLevel = MipMode::OneLevel;
     static constexpr Tex::MipMode MipModeTrilinear = MipMode::Trilinear;
     static constexpr Tex::MipMode MipModeAniso = MipMode::Aniso;
+    static constexpr Tex::MipMode MipModeEWA = MipMode::EWA;
     static constexpr Tex::InterpMode InterpClosest = Tex::InterpMode::Closest;
     static constexpr Tex::InterpMode InterpBilinear = Tex::InterpMode::Bilinear;
     static constexpr Tex::InterpMode InterpBicubic = Tex::InterpMode::Bicubic;
@@ -256,6 +258,8 @@ public:
     const float* missingcolor = nullptr;  ///< Color for missing texture
     float rnd = -1;                 ///< Stratified sample value
     int colortransformid = 0;       ///< Color space id of the texture
+    bool nonblocking = false;       ///< Don't wait for tiles to be read
+    bool approximate = false;       ///< Output: from coarser MIP levels
 
     /// Utility: Return the Wrap enum corresponding to a wrap name:
     /// "default", "black", "clamp", "periodic", "mirror".
@@ -526,8 +530,26 @@ public:
     /// - `int stochastic` :
     ///             Bit field determining how to use stochastic sampling for
     ///             MipModeStochasticAniso and/or MipModeStochasticTrilinear.
-    ///             Bit 1 = sample MIP level, bit 2 = sample anisotropy
+    ///             Bit 1 = sample MIP level, bit 2 = sample anisotropy,
+    ///             bit 4 = sample the texels of each bilinear or bicubic
+    ///             interpolation, fetching just one texel chosen with
+    ///             probability equal to its weight instead of all 4 or 16
+    ///             (not done for lookups that request derivatives)
     ///             (default=0).
+    /// - `string record_lookups` :
+    ///             If set to a filename, every subsequent texture() and
+    ///             environment() lookup (including each lane of batched
+    ///             ones) is recorded to that file along with the thread
+    ///             that made it, until the attribute is set to the empty
+    ///             string or the TextureSystem is destroyed. `testtex
+    ///             --replay` can then repeat the same lookups, with the
+    ///             same number of threads, under any cache settings. Only
+    ///             set it while no lookups are in progress. (default="")
+    /// - `int tile_feedback` :
+    ///             If nonzero, each thread records which tiles of which MIP
+    ///             levels its `texture()`, `texture3d()`, `environment()`,
+    ///             and `get_texels()` calls touch, as a bit per tile, to be
+    ///             retrieved with `get_tile_feedback()`. (default=0)
     ///
     /// - `string options`
     ///             This catch-all is simply a comma-separated list of
@@ -1547,6 +1569,64 @@ public:
                     int ybegin, int yend, int zbegin, int zend, int chbegin,
                     int chend, TypeDesc format, void* result);
 
+    /// One patch requested of `get_texel_patches()`: the texels of MIP
+    /// level `miplevel` nearest to texture coordinates (s,t).
+    struct TexelPatch {
+        float s, t;
+        int miplevel;
+    };
+
+    /// Retrieve many equally sized patches of raw unfiltered texels from
+    /// the subimage specified in `options` at once, for callers such as
+    /// machine learning feature extraction that gather thousands of them.
+    /// Each patch is the `width` x `height` rectangle of texels of its MIP
+    /// level centered as nearly as possible on its (s,t) (so a 1x1 patch
+    /// is the texel containing (s,t)), where (s,t) range over [0,1] across
+    /// the level's pixel data window. As for `get_texels()`, texels
+    /// outside the data window are zero, channels not present in the file
+    /// get the `options.fill` value, and values are converted to `format`.
+    ///
+    /// Unlike calling `get_texels()` for each patch, the requests are
+    /// grouped by the tile they touch, and the tiles are gathered in
+    /// parallel on the OIIO thread pool, so each tile is found and copied
+    /// from just once however many patches overlap it.
+    ///
+    /// @param  texture_handle
+    ///             The handle of the texture (see `get_texture_handle()`).
+    /// @param  options
+    ///             Provides the subimage, color transform, and fill value.
+    /// @param  patches
+    ///             The requested patches, in the order they are stored.
+    /// @param  width/height
+    ///             The size of every patch, in texels.
+    /// @param  chbegin/chend
+    ///             Channel range to retrieve.
+    /// @param  format
+    ///             The data type of the values stored in `result`.
+    /// @param  result
+    ///             Where the first texel of the first patch is stored.
+    /// @param  xstride/ystride/patchstride
+    ///             The distance in bytes between successive texels, rows,
+    ///             and patches in `result`. The `AutoStride` defaults pack
+    ///             the patches contiguously.
+    ///
+    /// @returns
+    ///             `true` for success, `false` if the texture is invalid,
+    ///             a MIP level doesn't exist, or a tile could not be read.
+    bool get_texel_patches(TextureHandle* texture_handle, TextureOpt& options,
+                           cspan<TexelPatch> patches, int width, int height,
+                           int chbegin, int chend, TypeDesc format,
+                           void* result, stride_t xstride = AutoStride,
+                           stride_t ystride     = AutoStride,
+                           stride_t patchstride = AutoStride);
+    /// A variety of `get_texel_patches()` for a texture specified by name.
+    bool get_texel_patches(ustring filename, TextureOpt& options,
+                           cspan<TexelPatch> patches, int width, int height,
+                           int chbegin, int chend, TypeDesc format,
+                           void* result, stride_t xstride = AutoStride,
+                           stride_t ystride     = AutoStride,
+                           stride_t patchstride = AutoStride);
+
     /// @}
 
     /// @{
@@ -1659,6 +1739,27 @@ public:
     /// TextureSystem.
     void reset_stats();
 
+    /// The tiles of one MIP level of a texture that lookups touched, as
+    /// recorded with the `tile_feedback` attribute. Tiles are numbered
+    /// across each row of `nxtiles`, then down the `nytiles` rows of each
+    /// of the `nztiles` slices, starting at the level's data window origin,
+    /// and bit `i % 64` of `tiles[i / 64]` is set if tile `i` was touched.
+    struct TileFeedback {
+        ustring filename;
+        int subimage, miplevel;
+        int nxtiles, nytiles, nztiles;
+        std::vector<uint64_t> tiles;
+    };
+
+    /// Merge the tiles that each thread's lookups have touched since
+    /// `tile_feedback` was set (or since the last call with `clear` true)
+    /// and return them, one entry for each MIP level that any lookup
+    /// touched. Lookups may continue while this is called. The result is
+    /// suited to choosing the tiles to stream into a renderer's own
+    /// residency system, or to `ImageCache::prefetch_tiles()` for the next
+    /// frame.
+    std::vector<TileFeedback> get_tile_feedback(bool clear = true);
+
     /// @}
 
     /// Return an opaque, non-owning pointer to the underlying ImageCache
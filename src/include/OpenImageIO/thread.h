@@ -519,6 +519,219 @@ typedef spin_rw_mutex::write_lock_guard spin_rw_write_lock;
 
 
 
+/// Block the calling thread while `word` still holds `expected`, until
+/// another thread changes it and calls atomic_wake(). As with a futex, it
+/// may also return spuriously, so the caller must check again. These are
+/// futexes on Linux, WaitOnAddress on Windows, and elsewhere a small table
+/// of condition variables.
+OIIO_UTIL_API void atomic_wait(std::atomic<int>& word, int expected) noexcept;
+
+/// Wake one (or, if `all` is true, all) of the threads blocked in
+/// atomic_wait() on `word`.
+OIIO_UTIL_API void atomic_wake(std::atomic<int>& word,
+                               bool all = false) noexcept;
+
+/// Retrieve the totals, over all adaptive_mutex and adaptive_rw_mutex
+/// locks, of how many acquisitions found the lock held (`contended`) and
+/// how many times a thread waiting for one went to sleep (`parked`). This
+/// is for profiling lock contention. If `reset` is true, the counts are
+/// also reset to zero.
+OIIO_UTIL_API void adaptive_mutex_stats(long long& contended,
+                                        long long& parked,
+                                        bool reset = false) noexcept;
+
+
+
+/// An adaptive_mutex is a mutex that is as small and as fast to lock and
+/// unlock as a spin_mutex when it's not contended, but that, rather than
+/// spinning indefinitely, spins only briefly and then puts the waiting
+/// thread to sleep (with atomic_wait) until the lock is released. It's a
+/// better choice than spin_mutex wherever the lock may be held for a
+/// while, or by more threads than there are cores, and contended locks
+/// are counted (see adaptive_mutex_stats()).
+class adaptive_mutex {
+public:
+    adaptive_mutex() noexcept {}
+    ~adaptive_mutex() noexcept {}
+
+    // Do not allow copy or assignment.
+    adaptive_mutex(const adaptive_mutex&) = delete;
+    const adaptive_mutex& operator=(const adaptive_mutex&) = delete;
+
+    /// Acquire the lock, spinning briefly and then sleeping until we have
+    /// it.
+    void lock() noexcept
+    {
+        int expected = UNLOCKED;
+        if (OIIO_UNLIKELY(!m_state.compare_exchange_strong(
+                expected, LOCKED, std::memory_order_acquire)))
+            lock_contended();
+    }
+
+    /// Release the lock that we hold, waking a waiting thread if there is
+    /// one.
+    void unlock() noexcept
+    {
+        if (OIIO_UNLIKELY(m_state.exchange(UNLOCKED, std::memory_order_release)
+                          == SLEEPERS))
+            atomic_wake(m_state);
+    }
+
+    /// Try to acquire the lock.  Return true if we have it, false if
+    /// somebody else is holding the lock.
+    bool try_lock() noexcept
+    {
+        int expected = UNLOCKED;
+        return m_state.compare_exchange_strong(expected, LOCKED,
+                                               std::memory_order_acquire);
+    }
+
+    /// Helper class: scoped lock for an adaptive_mutex -- grabs the lock
+    /// upon construction, releases the lock when it exits scope.
+    class lock_guard {
+    public:
+        lock_guard(adaptive_mutex& fm) noexcept
+            : m_fm(fm)
+        {
+            m_fm.lock();
+        }
+        ~lock_guard() noexcept { m_fm.unlock(); }
+
+    private:
+        lock_guard() = delete;
+        lock_guard(const lock_guard& other) = delete;
+        lock_guard& operator=(const lock_guard& other) = delete;
+        adaptive_mutex& m_fm;
+    };
+
+private:
+    // Unlocked, locked, or locked with (possibly) threads asleep waiting
+    // for it, which the unlock must wake.
+    enum { UNLOCKED = 0, LOCKED = 1, SLEEPERS = 2 };
+    std::atomic<int> m_state { UNLOCKED };
+
+    OIIO_UTIL_API void lock_contended() noexcept;
+};
+
+
+typedef adaptive_mutex::lock_guard adaptive_lock;
+
+
+
+/// An adaptive_rw_mutex is a reader/writer mutex that is just like a
+/// spin_rw_mutex when it's not contended (a single word, and a single
+/// atomic operation to take or release either kind of lock), but that,
+/// like adaptive_mutex, spins only briefly and then sleeps until the lock
+/// it's waiting for is released.
+class adaptive_rw_mutex {
+public:
+    adaptive_rw_mutex() noexcept {}
+    ~adaptive_rw_mutex() noexcept {}
+
+    // Do not allow copy or assignment.
+    adaptive_rw_mutex(const adaptive_rw_mutex&) = delete;
+    const adaptive_rw_mutex& operator=(const adaptive_rw_mutex&) = delete;
+
+    /// Acquire the reader lock.
+    ///
+    void read_lock() noexcept
+    {
+        // As with spin_rw_mutex, if nobody was writing, just increasing
+        // the number of readers is all it takes.
+        int oldval = m_bits.fetch_add(1, std::memory_order_acquire);
+        if (OIIO_UNLIKELY(oldval & WRITER))
+            read_lock_contended();
+    }
+
+    /// Release the reader lock.
+    ///
+    void read_unlock() noexcept
+    {
+        // If we were the last reader and somebody is asleep waiting, wake
+        // them.
+        int oldval = m_bits.fetch_sub(1, std::memory_order_release);
+        if (OIIO_UNLIKELY(oldval == (SLEEPERS | 1)))
+            wake_sleepers();
+    }
+
+    /// Acquire the writer lock.
+    ///
+    void write_lock() noexcept
+    {
+        int expected = 0;
+        if (OIIO_UNLIKELY(!m_bits.compare_exchange_strong(
+                expected, WRITER, std::memory_order_acquire)))
+            write_lock_contended();
+    }
+
+    /// Release the writer lock.
+    ///
+    void write_unlock() noexcept
+    {
+        int oldval = m_bits.fetch_sub(WRITER, std::memory_order_release);
+        if (OIIO_UNLIKELY(oldval & SLEEPERS))
+            wake_sleepers();
+    }
+
+    /// lock() is a synonym for exclusive (write) lock.
+    void lock() { write_lock(); }
+
+    /// unlock() is a synonym for exclusive (write) unlock.
+    void unlock() { write_unlock(); }
+
+    /// Helper class: scoped read lock for an adaptive_rw_mutex -- grabs
+    /// the read lock upon construction, releases the lock when it exits
+    /// scope.
+    class read_lock_guard {
+    public:
+        read_lock_guard(adaptive_rw_mutex& fm) noexcept
+            : m_fm(fm)
+        {
+            m_fm.read_lock();
+        }
+        ~read_lock_guard() noexcept { m_fm.read_unlock(); }
+
+    private:
+        read_lock_guard(const read_lock_guard& other) = delete;
+        read_lock_guard& operator=(const read_lock_guard& other) = delete;
+        adaptive_rw_mutex& m_fm;
+    };
+
+    /// Helper class: scoped write lock for an adaptive_rw_mutex -- grabs
+    /// the write lock upon construction, releases the lock when it exits
+    /// scope.
+    class write_lock_guard {
+    public:
+        write_lock_guard(adaptive_rw_mutex& fm) noexcept
+            : m_fm(fm)
+        {
+            m_fm.write_lock();
+        }
+        ~write_lock_guard() noexcept { m_fm.write_unlock(); }
+
+    private:
+        write_lock_guard(const write_lock_guard& other) = delete;
+        write_lock_guard& operator=(const write_lock_guard& other) = delete;
+        adaptive_rw_mutex& m_fm;
+    };
+
+private:
+    // The reader count, with a high bit indicating that it's locked for
+    // writing, and another that threads may be asleep waiting for it.
+    enum { WRITER = 1 << 30, SLEEPERS = 1 << 29, READERS = SLEEPERS - 1 };
+    std::atomic<int> m_bits { 0 };
+
+    OIIO_UTIL_API void read_lock_contended() noexcept;
+    OIIO_UTIL_API void write_lock_contended() noexcept;
+    OIIO_UTIL_API void wake_sleepers() noexcept;
+};
+
+
+typedef adaptive_rw_mutex::read_lock_guard adaptive_rw_read_lock;
+typedef adaptive_rw_mutex::write_lock_guard adaptive_rw_write_lock;
+
+
+
 /// Mutex pool. Sometimes, we have lots of objects that need to be
 /// individually locked for thread safety, but two separate objects don't
 /// need to lock against each other. If there are many more objects than
@@ -649,6 +862,20 @@ private:
 /// can happen in cases where the whole pool is occupied and the calling
 /// thread contributes to running the work load).
 ///
+/// Tasks may themselves push tasks and wait for them. Each pool thread has
+/// its own queue for the tasks it pushes; it runs them newest first,
+/// while idle threads steal the oldest ones from it. Tasks pushed by
+/// threads outside the pool go to a shared queue.
+///
+/// A task may also be pushed with a Priority: High priority tasks run
+/// before any others that are waiting, and Low priority tasks only when
+/// there is nothing else to do.
+///
+/// Tasks that spend most of their time waiting on I/O rather than
+/// computing, such as reading ahead in a file or writing out a finished
+/// image, belong on io_thread_pool() rather than the default pool, so
+/// that a stalled read doesn't occupy a thread that could be computing.
+///
 /// Thread pool. Have fun, be safe.
 ///
 class OIIO_UTIL_API thread_pool {
@@ -674,12 +901,23 @@ public:
     /// means the queue is fully engaged.
     int idle() const;
 
+    /// Priority classes for tasks.
+    enum class Priority { Low, Normal, High };
+
     /// Run the user's function that accepts argument int - id of the
     /// running thread. The returned value is templatized std::future, where
     /// the user can get the result and rethrow any exceptions. If the queue
     /// has no worker threads, the task will be run immediately by the
     /// calling thread.
     template<typename F> auto push(F&& f) -> std::future<decltype(f(0))>
+    {
+        return push(Priority::Normal, std::forward<F>(f));
+    }
+
+    /// Run the user's function that accepts argument int - id of the
+    /// running thread, as a task of the given priority.
+    template<typename F>
+    auto push(Priority priority, F&& f) -> std::future<decltype(f(0))>
     {
         auto pck = std::make_shared<std::packaged_task<decltype(f(0))(int)>>(
             std::forward<F>(f));
@@ -688,7 +926,7 @@ public:
         } else {
             auto _f = new std::function<void(int id)>(
                 [pck](int id) { (*pck)(id); });
-            push_queue_and_notify(_f);
+            push_queue_and_notify(_f, priority);
         }
         return pck->get_future();
     }
@@ -730,7 +968,7 @@ public:
     bool this_thread_is_in_pool() const;
 
     /// Register a thread (not already in the thread pool itself) as working
-    /// on tasks in the pool. This is used to avoid recursion.
+    /// on tasks in the pool.
     void register_worker(std::thread::id id);
     /// De-register a thread, saying it is no longer in the process of
     /// taking work from the thread pool.
@@ -765,6 +1003,13 @@ private:
 
     // Utility function that helps us hide the implementation
     void push_queue_and_notify(std::function<void(int id)>* f);
+    void push_queue_and_notify(std::function<void(int id)>* f,
+                               Priority priority);
+
+    // If the calling thread's queue holds a task pushed for the given
+    // task_set frame, run it and return true.
+    bool run_frame_task(uint64_t frame);
+    friend class task_set;
 };
 
 
@@ -777,10 +1022,18 @@ private:
 /// worker threads if it has not yet been created.
 OIIO_UTIL_API thread_pool* default_thread_pool();
 
-/// If a thread pool has been created, this call will safely terminate its
-/// worker threads. This should presumably be called by an application
-/// immediately before it exists, when it is confident the thread pool will
-/// no longer be needed.
+/// Return a pointer to the shared thread pool for tasks that mostly wait
+/// on I/O, such as background reads and writes. It is separate from the
+/// default pool, and sized independently (4 threads unless the
+/// `OPENIMAGEIO_IO_THREADS` environment variable says otherwise, or it is
+/// resized, as by the `"io_threads"` attribute); its threads do little
+/// computing, so there may be more of them than there are cores.
+OIIO_UTIL_API thread_pool* io_thread_pool();
+
+/// If a thread pool (the default or the I/O pool) has been created, this
+/// call will safely terminate its worker threads. This should presumably
+/// be called by an application immediately before it exists, when it is
+/// confident the thread pool will no longer be needed.
 OIIO_UTIL_API void default_thread_pool_shutdown();
 
 
@@ -804,14 +1057,14 @@ OIIO_UTIL_API void default_thread_pool_shutdown();
 ///        // wait for all those queue tasks to finish.
 ///    }
 ///
+/// A thread that is itself running a pool task (or waiting on an enclosing
+/// task_set) never blocks in wait(), and while waiting helps only with the
+/// tasks of this set that nobody else has picked up yet.
+///
 class OIIO_UTIL_API task_set {
 public:
-    task_set(thread_pool* pool = nullptr)
-        : m_pool(pool ? pool : default_thread_pool())
-        , m_submitter_thread(std::this_thread::get_id())
-    {
-    }
-    ~task_set() { wait(); }
+    task_set(thread_pool* pool = nullptr);
+    ~task_set();
 
     task_set(const task_set&) = delete;
     const task_set& operator=(const task_set&) = delete;
@@ -856,6 +1109,11 @@ private:
     thread_pool* m_pool;
     std::thread::id m_submitter_thread;
     std::vector<std::future<void>> m_futures;
+    uint64_t m_frame;        // Tags the tasks pushed as part of this set
+    uint64_t m_outer_frame;  // Frame of the enclosing task_set, if any
+
+    bool nested() const;
+    bool help();
 };
 
 
@@ -0,0 +1,146 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+/// @file  tracing.h
+///
+/// @brief Lightweight recording of timed spans, to be viewed as a
+/// Chrome/Perfetto trace.
+///
+/// A Tracing::Span records, from its construction to its destruction, the
+/// time spent in some named block of code on some thread. Recording is off
+/// until Tracing::start() is called (or the `OPENIMAGEIO_TRACE` environment
+/// variable is set), and while it's off a Span costs only the check of a
+/// flag. The spans recorded may be written as Chrome trace event JSON, for
+/// viewing with `chrome://tracing` or https://ui.perfetto.dev.
+///
+/// OpenImageIO itself records spans around ImageInput opens and reads,
+/// ImageOutput writes, ImageBuf reads and writes, ImageBufAlgo functions,
+/// ImageCache tile reads, and texture lookups.
+///
+/// Building with `OIIO_TRACING` defined to 0 compiles away the spans made
+/// with the OIIO_TRACE_SPAN macro.
+
+
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include <OpenImageIO/export.h>
+#include <OpenImageIO/oiioversion.h>
+#include <OpenImageIO/platform.h>
+#include <OpenImageIO/string_view.h>
+
+#ifndef OIIO_TRACING
+#    define OIIO_TRACING 1
+#endif
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace Tracing {
+
+namespace pvt {
+extern OIIO_UTIL_API std::atomic<bool> recording;
+}
+
+/// Are spans currently being recorded?
+inline bool
+enabled()
+{
+    return pvt::recording.load(std::memory_order_relaxed);
+}
+
+/// Discard any spans recorded so far, and start recording.
+OIIO_UTIL_API void
+start();
+
+/// Stop recording spans (keeping those recorded so far).
+OIIO_UTIL_API void
+stop();
+
+/// Return the spans recorded so far as a Chrome trace event JSON document.
+OIIO_UTIL_API std::string
+trace_json();
+
+/// Write the spans recorded so far as Chrome trace event JSON to the named
+/// file, returning true upon success.
+OIIO_UTIL_API bool
+write(string_view filename);
+
+/// Record a span directly: the name, an optional detail for the span's
+/// arguments, and its beginning and end, in nanoseconds as returned by
+/// now().
+OIIO_UTIL_API void
+record(string_view name, string_view detail, int64_t begin, int64_t end);
+
+/// Time in nanoseconds since the tracing epoch (when the library loaded).
+OIIO_UTIL_API int64_t
+now();
+
+
+
+/// A Span records the time from its construction to its destruction,
+/// if recording was on when it was constructed.
+class Span {
+public:
+    /// Begin a span with the given name and optional detail (such as the
+    /// file name being read). Both are copied only if recording.
+    Span(string_view name, string_view detail = string_view())
+    {
+        if (OIIO_UNLIKELY(enabled()))
+            begin(name, detail);
+    }
+    Span(const Span&)            = delete;
+    Span& operator=(const Span&) = delete;
+    ~Span()
+    {
+        if (OIIO_UNLIKELY(m_begin >= 0))
+            end();
+    }
+
+    /// Change the name of the span.
+    void rename(string_view name)
+    {
+        if (m_begin >= 0)
+            m_name = name;
+    }
+
+    /// End the span now, rather than upon destruction.
+    void end()
+    {
+        record(m_name, m_detail, m_begin, now());
+        m_begin = -1;
+    }
+
+private:
+    void begin(string_view name, string_view detail)
+    {
+        m_name   = name;
+        m_detail = detail;
+        m_begin  = now();
+    }
+
+    std::string m_name, m_detail;
+    int64_t m_begin = -1;
+};
+
+}  // namespace Tracing
+
+OIIO_NAMESPACE_END
+
+
+
+#define OIIO_TRACE_CONCAT_IMPL(a, b) a##b
+#define OIIO_TRACE_CONCAT(a, b) OIIO_TRACE_CONCAT_IMPL(a, b)
+
+/// OIIO_TRACE_SPAN(name [, detail]) records a Tracing::Span for the rest
+/// of the enclosing scope, or does nothing if built with OIIO_TRACING 0.
+#if OIIO_TRACING
+#    define OIIO_TRACE_SPAN(...)                                    \
+        OIIO::Tracing::Span OIIO_TRACE_CONCAT(oiio_trace_span_, \
+                                              __LINE__)(__VA_ARGS__)
+#else
+#    define OIIO_TRACE_SPAN(...)
+#endif
@@ -91,10 +91,16 @@ find_with_hash(Map& map, const Key& key, size_t /*hash*/)
 /// the first entry of the next bin, it will also release its current
 /// lock and obtain a lock on the next bin.
 ///
+/// Each bin is locked with a BINMUTEX, a spin_rw_mutex by default. Maps
+/// whose bins may be held for longer, or by more threads than there are
+/// cores, can use an adaptive_rw_mutex instead, whose waiters sleep rather
+/// than spin.
+///
 
 template<class KEY, class VALUE, class HASH = std::hash<KEY>,
          class PRED = std::equal_to<KEY>, size_t BINS = 16,
-         class BINMAP = std::unordered_map<KEY, VALUE, HASH, PRED>>
+         class BINMAP   = std::unordered_map<KEY, VALUE, HASH, PRED>,
+         class BINMUTEX = spin_rw_mutex>
 class unordered_map_concurrent {
 public:
     typedef BINMAP BinMap_t;
@@ -115,7 +121,7 @@ public:
     class iterator {
     public:
         friend class unordered_map_concurrent<KEY, VALUE, HASH, PRED, BINS,
-                                              BINMAP>;
+                                              BINMAP, BINMUTEX>;
 
     public:
         /// Construct an unordered_map_concurrent iterator that points
@@ -505,8 +511,8 @@ public:
 
 private:
     struct Bin {
-        OIIO_CACHE_ALIGN                  // align bin to cache line
-            mutable spin_rw_mutex mutex;  // mutex for this bin
+        OIIO_CACHE_ALIGN             // align bin to cache line
+            mutable BINMUTEX mutex;  // mutex for this bin
         BinMap_t map;                     // hash map for this bin
 #ifndef NDEBUG
         mutable atomic_int m_nrlocks;  // for debugging
@@ -10,9 +10,14 @@
 #ifndef OPENIMAGEIO_IMAGEIO_PVT_H
 #define OPENIMAGEIO_IMAGEIO_PVT_H
 
+#include <functional>
+
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/metrics.h>
 #include <OpenImageIO/thread.h>
 #include <OpenImageIO/timer.h>
+#include <OpenImageIO/tracing.h>
 
 
 
@@ -21,6 +26,7 @@ OIIO_NAMESPACE_BEGIN
 namespace ImageBufAlgo {
 struct PixelStats;
 }
+class ColorProcessor;
 
 
 namespace pvt {
@@ -48,12 +54,65 @@ extern int limit_channels;
 extern int limit_imagesize_MB;
 extern int imagebuf_print_uncaught_errors;
 extern int imagebuf_use_imagecache;
+extern int imagebufalgo_fastpaths;
+extern int imagebufalgo_colorconvert_lut3d;
 extern int imageinput_strict;
+extern int imageinput_mmap;
+extern int imageinput_allow_urls;
 extern atomic_ll IB_local_mem_current;
 extern atomic_ll IB_local_mem_peak;
+extern int imagebuf_pool_MB;
+extern int imagebuf_hugepages;
+extern int imagebuf_scanline_alignment;
+extern int imagebuf_pad_scanlines;
+extern int imagebuf_copy_on_write;
+extern atomic_ll IB_pool_mem_current;
 extern std::atomic<float> IB_total_open_time;
 extern std::atomic<float> IB_total_image_read_time;
 extern OIIO_UTIL_API int oiio_use_tbb;  // This lives in libOpenImageIO_Util
+
+// Free pooled ImageBuf pixel buffers beyond the "imagebuf:pool_MB" limit.
+void
+imagebuf_pool_trim();
+
+extern int deepdata_pool_MB;
+// Free pooled DeepData sample buffers beyond the "deepdata:pool_MB" limit.
+void
+deepdata_pool_trim();
+
+// The process-wide memory budget ("max_memory_MB"), in bytes, or 0 for
+// none, for ImageBuf pixels, DeepData samples, and ImageCache tiles alike.
+extern atomic_ll memory_budget;
+extern atomic_ll DD_mem_current;  // Bytes of DeepData samples
+extern atomic_ll IC_mem_current;  // Bytes of tiles of all ImageCaches
+
+// How many bytes over the memory budget we are, or would be after
+// allocating `bytes` more, or 0 if within it.
+inline long long
+memory_over_budget(long long bytes = 0)
+{
+    long long budget = memory_budget;
+    if (!budget)
+        return 0;
+    long long used = IB_local_mem_current + DD_mem_current + IC_mem_current
+                     + bytes;
+    return std::max(used - budget, 0LL);
+}
+
+// Before allocating `bytes` more, if that would go over the memory budget,
+// ask the ImageCaches to free enough of their tiles to make room, as far as
+// they can.
+void
+memory_budget_reserve(long long bytes);
+
+// Each ImageCache registers how to ask it to free (about) a number of
+// bytes of its tiles, and unregisters before it goes away.
+void
+memory_budget_add_cache(const void* cache,
+                        std::function<void(long long bytes)> release);
+void
+memory_budget_remove_cache(const void* cache);
+
 OIIO_API const std::vector<std::string>&
 font_dirs();
 OIIO_API const std::vector<std::string>&
@@ -68,7 +127,9 @@ OIIO_API const std::string
 font_filename(string_view family, string_view style = "");
 
 
-// Make sure all plugins are inventoried. For internal use only.
+// Make sure all plugins are inventoried, including the DSOs in the
+// searchpath (each searchpath is only looked through once, so this is cheap
+// after the first call). For internal use only.
 void
 catalog_all_plugins(std::string searchpath);
 
@@ -111,6 +172,23 @@ const void*
 parallel_convert_from_float(const float* src, void* dst, size_t nvals,
                             TypeDesc format);
 
+/// Convert contiguous float pixels to uint8, adding the same blue noise
+/// dither that add_dither() would, one scanline at a time (in parallel)
+/// as it goes, rather than in a separate pass, and leaving src unchanged.
+void
+dither_convert_from_float(const float* src, unsigned char* dst, int nchannels,
+                          int width, int height, int depth,
+                          float ditheramplitude, int alpha_channel,
+                          int z_channel, unsigned int ditherseed, int xorigin,
+                          int yorigin, int zorigin);
+
+/// Decompress the zlib stream `src` into `dst`, which must be exactly the
+/// size of the data it holds (as the formats that use this always know).
+/// Whole buffers like this are inflated by libdeflate, if OIIO was built
+/// with it, which is a good deal faster than zlib. Return true for success.
+OIIO_API bool
+zlib_uncompress(cspan<unsigned char> src, span<unsigned char> dst);
+
 /// Internal utility: Error checking on the spec -- if it contains texture-
 /// specific metadata but there are clues it's not actually a texture file
 /// written by maketx or `oiiotool -otex`, then assume these metadata are
@@ -119,24 +197,43 @@ parallel_convert_from_float(const float* src, void* dst, size_t nvals,
 OIIO_API bool
 check_texture_metadata_sanity(ImageSpec& spec);
 
+/// Open `url` for an ImageInput to read, returning the proxy, or nullptr
+/// and the reason in `err` if it can't be opened -- including if reading
+/// URLs hasn't been allowed with the "imageinput:allow_urls" attribute.
+OIIO_API std::unique_ptr<Filesystem::IOProxy>
+open_input_url(string_view url, std::string& err);
+
 /// Get the timing report from log_time entries.
 OIIO_API std::string
 timing_report();
 
+/// Record the duration of the named operation in the "oiio_op_seconds"
+/// metrics histogram.
+OIIO_API void
+record_op_time(string_view name, double seconds);
+
 /// An object that, if oiio_log_times is nonzero, logs time until its
-/// destruction. If oiio_log_times is 0, it does nothing.
+/// destruction, and if metrics are being collected, records it with
+/// record_op_time(). Otherwise, it does nothing. Either way, if tracing is
+/// enabled it also records a Tracing::Span.
 class LoggedTimer {
 public:
     LoggedTimer(string_view name)
-        : m_timer(oiio_log_times)
+        : m_metrics(Metrics::enabled())
+        , m_timer(oiio_log_times || m_metrics)
+#if OIIO_TRACING
+        , m_span(name)
+#endif
     {
-        if (oiio_log_times)
+        if (oiio_log_times || m_metrics)
             m_name = name;
     }
     ~LoggedTimer()
     {
         if (oiio_log_times)
             log_time(m_name, m_timer, m_count);
+        if (m_metrics)
+            record_op_time(m_name, m_timer());
     }
     // Stop the timer. An optional count_offset will be added to the
     // "invocations count" of the underlying timer, if a single invocation
@@ -147,10 +244,20 @@ public:
         m_count += count_offset;
     }
     void start() { m_timer.start(); }
-    void rename(string_view name) { m_name = name; }
+    void rename(string_view name)
+    {
+        m_name = name;
+#if OIIO_TRACING
+        m_span.rename(name);
+#endif
+    }
 
 private:
+    bool m_metrics;
     Timer m_timer;
+#if OIIO_TRACING
+    Tracing::Span m_span;
+#endif
     std::string m_name;
     int m_count = 1;
 };
@@ -178,6 +285,19 @@ bluenoise_4chan_ptr(int x, int y)
     return bluenoise_table[y][x];
 }
 
+// The offsets into the periodic blue noise table of the pixels of plane z,
+// for channel ch and the seed (the same for each group of 4 channels), so
+// that the x,y pixel's noise is at [y + yoff][x + xoff].
+inline void
+bluenoise_offsets(int z, int ch, int seed, int& xoff, int& yoff)
+{
+    xoff = yoff = 0;
+    if (z | (ch & ~3) | seed) {
+        xoff = bjhash::bjfinal(z, ch, seed);
+        yoff = bjhash::bjfinal(z, ch, seed + 83533);
+    }
+}
+
 // 4-channel pointer lookup of periodic blue noise of 3D coordinate + seed +
 // channel channel number. The pointer is to the 4 floats of the mod 4 group
 // of channels, i.e. if ch=5, the pointer will be to the 4 floats representing
@@ -185,10 +305,10 @@ bluenoise_4chan_ptr(int x, int y)
 inline const float*
 bluenoise_4chan_ptr(int x, int y, int z, int ch = 0, int seed = 0)
 {
-    if (z | (ch & ~3) | seed) {
-        x += bjhash::bjfinal(z, ch, seed);
-        y += bjhash::bjfinal(z, ch, seed + 83533);
-    }
+    int xoff, yoff;
+    bluenoise_offsets(z, ch, seed, xoff, yoff);
+    x += xoff;
+    y += yoff;
     x &= bntable_res - 1;
     y &= bntable_res - 1;
     return bluenoise_table[y][x];
@@ -222,6 +342,53 @@ print_stats(std::ostream& out, string_view indent, const ImageBuf& input,
             const ImageSpec& spec, ROI roi, std::string& err);
 
 
+/// The conversion between the color space of a file and the
+/// "oiio:WorkingColorSpace" named by an ImageInput's open config or an
+/// ImageOutput's spec, which the reader applies to the pixels it decodes
+/// and the writer to the pixels it's given, before quantizing them. The
+/// processor is looked up when first needed and kept for as long as the
+/// file's color space stays the same. It is safe to use from multiple
+/// threads.
+class WorkingColorConversion {
+public:
+    /// Set the working color space, or clear it with an empty name.
+    void set_working_colorspace(string_view name);
+
+    /// Is there a working color space?
+    bool active() const { return !m_working.empty(); }
+
+    /// Return the processor converting from `filespace` into the working
+    /// color space, or if `tofile` is true, from the working space into
+    /// `filespace`. Return an empty pointer if there is no working space,
+    /// if the file doesn't name its color space, or if they are the same,
+    /// and also (setting `err`) if there is no such conversion.
+    std::shared_ptr<ColorProcessor> processor(string_view filespace,
+                                              bool tofile, std::string& err);
+
+    /// Convert the pixels of a buffer in place with processor(filespace,
+    /// tofile). Return false and set `err` if there is no such conversion.
+    bool apply(string_view filespace, bool tofile, int nchannels, int width,
+               int height, int depth, TypeDesc format, void* data,
+               stride_t xstride, stride_t ystride, stride_t zstride,
+               int nthreads, std::string& err);
+
+    /// Convert the pixels of a buffer in place with the given processor.
+    static bool convert(const ColorProcessor* processor, int nchannels,
+                        int width, int height, int depth, TypeDesc format,
+                        void* data, stride_t xstride, stride_t ystride,
+                        stride_t zstride, int nthreads, std::string& err);
+
+private:
+    std::mutex m_mutex;
+    ustring m_working;
+    ustring m_filespace;
+    bool m_tofile = false;
+    std::shared_ptr<ColorProcessor> m_processor;
+    std::string m_error;
+};
+
+
+
 enum class ComputeDevice : int {
     CPU  = 0,
     CUDA = 1,
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: BSD-3-Clause and Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #ifndef _WIN32
@@ -42,6 +43,7 @@
 #include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/thread.h>
 #include <OpenImageIO/timer.h>
 
 
@@ -161,6 +163,7 @@ ImageViewer::ImageViewer(bool use_ocio, const std::string& image_color_space,
 
 ImageViewer::~ImageViewer()
 {
+    cancelReadAhead(true);
     for (auto i : m_images)
         delete i;
 }
@@ -460,6 +463,11 @@ ImageViewer::createActions()
     slideShowDuration->setAccelerated(true);
     connect(slideShowDuration, SIGNAL(valueChanged(int)), this,
             SLOT(setSlideShowDuration(int)));
+
+    readAheadLabel  = new QLabel(tr("Images to read ahead"));
+    readAheadImages = new QSpinBox();
+    readAheadImages->setRange(0, 64);
+    readAheadImages->setSingleStep(1);
 }
 
 
@@ -795,6 +803,7 @@ ImageViewer::readSettings(bool ui_is_set_up)
         maxMemoryIC->setValue(settings.value("maxMemoryIC", 2048).toInt());
     slideShowDuration->setValue(
         settings.value("slideShowDuration", 10).toInt());
+    readAheadImages->setValue(settings.value("readAheadImages", 2).toInt());
 
     OIIO::attribute("imagebuf:use_imagecache", 1);
 
@@ -817,6 +826,7 @@ ImageViewer::writeSettings()
     settings.setValue("autoMipmap", autoMipmap->isChecked());
     settings.setValue("maxMemoryIC", maxMemoryIC->value());
     settings.setValue("slideShowDuration", slideShowDuration->value());
+    settings.setValue("readAheadImages", readAheadImages->value());
     QStringList recent;
     for (auto&& s : m_recent_files)
         recent.push_front(QString(s.c_str()));
@@ -940,6 +950,7 @@ ImageViewer::reload()
 {
     if (m_images.empty())
         return;
+    cancelReadAhead(true);
     IvImage* newimage = m_images[m_current_image];
     newimage->invalidate();
     //glwin->trigger_redraw ();
@@ -1136,6 +1147,51 @@ ImageViewer::updateStatusBar()
 
 
 
+void
+ImageViewer::readFormat(const IvImage* img, TypeDesc& read_format,
+                        bool& allow_transforms, bool& srgb_transform) const
+{
+    // Used to check whether we'll need to do adjustments in the
+    // CPU. If true, images should be loaded as UINT8.
+    allow_transforms = false;
+    srgb_transform   = false;
+
+    // By default, we try to load into OpenGL with the same format,
+    read_format                 = TypeDesc::UNKNOWN;
+    const ImageSpec& image_spec = img->spec();
+
+    if (image_spec.format.basetype == TypeDesc::DOUBLE) {
+        // AFAIK, OpenGL doesn't support 64-bit floats as pixel size.
+        read_format = TypeDesc::FLOAT;
+    }
+    if (glwin->is_glsl_capable()) {
+        if (image_spec.format.basetype == TypeDesc::HALF
+            && !glwin->is_half_capable()) {
+            //std::cerr << "Loading HALF-FLOAT as FLOAT\n";
+            read_format = TypeDesc::FLOAT;
+        }
+        if (IsSpecSrgb(image_spec) && !glwin->is_srgb_capable()) {
+            // If the image is in sRGB, but OpenGL can't load sRGB textures then
+            // we'll need to do the transformation on the CPU after loading the
+            // image. We (so far) can only do this with UINT8 images, so make
+            // sure that it gets loaded in this format.
+            //std::cerr << "Loading as UINT8 to do sRGB\n";
+            read_format      = TypeDesc::UINT8;
+            srgb_transform   = true;
+            allow_transforms = true;
+        }
+    } else {
+        //std::cerr << "Loading as UINT8\n";
+        read_format      = TypeDesc::UINT8;
+        allow_transforms = true;
+
+        if (IsSpecSrgb(image_spec) && !glwin->is_srgb_capable())
+            srgb_transform = true;
+    }
+}
+
+
+
 bool
 ImageViewer::loadCurrentImage(int subimage, int miplevel)
 {
@@ -1153,43 +1209,11 @@ ImageViewer::loadCurrentImage(int subimage, int miplevel)
             return false;
         }
 
-        // Used to check whether we'll need to do adjustments in the
-        // CPU. If true, images should be loaded as UINT8.
+        // What format to read it in, to suit OpenGL's capabilities
         bool allow_transforms = false;
         bool srgb_transform   = false;
-
-        // By default, we try to load into OpenGL with the same format,
-        TypeDesc read_format        = TypeDesc::UNKNOWN;
-        const ImageSpec& image_spec = img->spec();
-
-        if (image_spec.format.basetype == TypeDesc::DOUBLE) {
-            // AFAIK, OpenGL doesn't support 64-bit floats as pixel size.
-            read_format = TypeDesc::FLOAT;
-        }
-        if (glwin->is_glsl_capable()) {
-            if (image_spec.format.basetype == TypeDesc::HALF
-                && !glwin->is_half_capable()) {
-                //std::cerr << "Loading HALF-FLOAT as FLOAT\n";
-                read_format = TypeDesc::FLOAT;
-            }
-            if (IsSpecSrgb(image_spec) && !glwin->is_srgb_capable()) {
-                // If the image is in sRGB, but OpenGL can't load sRGB textures then
-                // we'll need to do the transformation on the CPU after loading the
-                // image. We (so far) can only do this with UINT8 images, so make
-                // sure that it gets loaded in this format.
-                //std::cerr << "Loading as UINT8 to do sRGB\n";
-                read_format      = TypeDesc::UINT8;
-                srgb_transform   = true;
-                allow_transforms = true;
-            }
-        } else {
-            //std::cerr << "Loading as UINT8\n";
-            read_format      = TypeDesc::UINT8;
-            allow_transforms = true;
-
-            if (IsSpecSrgb(image_spec) && !glwin->is_srgb_capable())
-                srgb_transform = true;
-        }
+        TypeDesc read_format;
+        readFormat(img, read_format, allow_transforms, srgb_transform);
 
         // FIXME: This actually won't work since the ImageCacheFile has already
         // been created when we did the init_spec.
@@ -1233,6 +1257,11 @@ ImageViewer::displayCurrentImage(bool update)
         m_current_image = 0;
     IvImage* img = cur();
     if (img) {
+        // Stop reading the images we've moved away from, and if this one
+        // was being read ahead, finish that.
+        cancelReadAhead();
+        if (finishReadAhead(img))
+            update = true;
         if (!img->image_valid()) {
             bool load_result = false;
 
@@ -1272,6 +1301,143 @@ ImageViewer::displayCurrentImage(bool update)
     //    fitImageToWindowAct->setEnabled(true);
     //    fullScreenAct->setEnabled(true);
     updateActions();
+    readAhead();
+}
+
+
+
+// Progress callback of the reads of readAhead(), which aborts the read if
+// it's been cancelled.
+static bool
+readahead_cancelled(void* opaque, float /*done*/)
+{
+    return ((std::atomic<bool>*)opaque)->load();
+}
+
+
+
+void
+ImageViewer::readAhead()
+{
+    cancelReadAhead();
+    IvImage* current = cur();
+    int n            = readAheadImages->value();
+    int nimages      = (int)m_images.size();
+    if (!current || !current->image_valid() || n < 1 || nimages < 2)
+        return;
+    // Read no more than fits in the memory allowed the ImageCache, guessing
+    // that the other images are the size of the current one.
+    imagesize_t bytes  = std::max(current->spec().image_bytes(),
+                                  imagesize_t(1));
+    imagesize_t budget = imagesize_t(maxMemoryIC->value()) * 1024 * 1024;
+    n                  = (int)std::min(imagesize_t(n), budget / bytes / 2);
+
+    // Nearest first, on either side (wrapping around, as stepping through
+    // the images does).
+    for (int d = 1; d <= n; ++d) {
+        for (int i : { m_current_image + d, m_current_image - d }) {
+            IvImage* img = m_images[(i % nimages + nimages) % nimages];
+            if (img == current
+                || std::any_of(m_readahead.begin(), m_readahead.end(),
+                               [img](const ReadAhead& r) {
+                                   return r.image == img;
+                               })
+                || img->image_valid())
+                continue;
+            ReadAhead r;
+            r.image  = img;
+            r.cancel = std::make_unique<std::atomic<bool>>(false);
+            std::atomic<bool>* cancel = r.cancel.get();
+            int subimage              = std::max(0, img->subimage());
+            int miplevel              = std::max(0, img->miplevel());
+
+            r.done = default_thread_pool()->push(
+                thread_pool::Priority::Low,
+                [this, img, cancel, subimage, miplevel](int) {
+                    if (*cancel
+                        || !img->init_spec(img->name(), subimage, miplevel))
+                        return false;
+                    bool allow_transforms, srgb_transform;
+                    TypeDesc read_format;
+                    readFormat(img, read_format, allow_transforms,
+                               srgb_transform);
+                    // Force it into memory, rather than leaving the pixels
+                    // to be read from the ImageCache when displayed.
+                    return img->read_iv(subimage, miplevel, true, read_format,
+                                        readahead_cancelled, cancel,
+                                        allow_transforms);
+                });
+            m_readahead.push_back(std::move(r));
+        }
+    }
+}
+
+
+
+void
+ImageViewer::cancelReadAhead(bool all)
+{
+    IvImage* current = cur();
+    int n            = readAheadImages->value();
+    int nimages      = (int)m_images.size();
+    auto keep        = [&](IvImage* img) {
+        if (all || !current)
+            return false;
+        if (img == current)
+            return true;
+        for (int d = 1; d <= n; ++d)
+            for (int i : { m_current_image + d, m_current_image - d })
+                if (m_images[(i % nimages + nimages) % nimages] == img)
+                    return true;
+        return false;
+    };
+
+    // Signal all the reads to stop before waiting for any of them.
+    std::vector<ReadAhead> kept, cancelled;
+    for (auto& r : m_readahead) {
+        if (keep(r.image)) {
+            kept.push_back(std::move(r));
+        } else {
+            *r.cancel = true;
+            cancelled.push_back(std::move(r));
+        }
+    }
+    for (auto& r : cancelled) {
+        r.done.wait();
+        // Free its pixels, unless it's the image being viewed.
+        if (r.image != current || !r.image->image_valid())
+            r.image->invalidate();
+    }
+    m_readahead = std::move(kept);
+}
+
+
+
+bool
+ImageViewer::finishReadAhead(IvImage* img)
+{
+    auto r = std::find_if(m_readahead.begin(), m_readahead.end(),
+                          [img](const ReadAhead& r) {
+                              return r.image == img && !r.finished;
+                          });
+    if (r == m_readahead.end())
+        return false;
+    r->done.wait();
+    r->finished = true;
+    if (!img->image_valid()) {
+        // Leave it to be read the usual way, with its errors reported.
+        img->invalidate();
+        m_readahead.erase(r);
+        return false;
+    }
+    // Fill in the secondary buffer, as loadCurrentImage() would.
+    bool allow_transforms, srgb_transform;
+    TypeDesc read_format;
+    readFormat(img, read_format, allow_transforms, srgb_transform);
+    if (allow_transforms)
+        img->pixel_transform(srgb_transform, (int)current_color_mode(),
+                             current_channel());
+    return true;
 }
 
 
@@ -1712,6 +1878,7 @@ ImageViewer::sortByImageDate()
     int numImg = m_images.size();
     if (numImg < 2)
         return;
+    cancelReadAhead(true);  // Sorting reads the specs of all the images
     std::sort(m_images.begin(), m_images.end(), &compImageDate);
     current_image(0);
     displayCurrentImage();
@@ -1968,6 +2135,7 @@ ImageViewer::closeImg()
 {
     if (m_images.empty())
         return;
+    cancelReadAhead(true);
     delete m_images[m_current_image];
     m_images[m_current_image] = NULL;
     m_images.erase(m_images.begin() + m_current_image);
@@ -18,6 +18,9 @@
 // included to remove std::min/std::max errors
 #include <OpenImageIO/platform.h>
 
+#include <atomic>
+#include <future>
+#include <memory>
 #include <vector>
 
 #include <QAction>
@@ -124,6 +127,13 @@ public:
             return ImageBuf::get_pixels(roi, format, result);
     }
 
+    /// Is a secondary (CPU-corrected) buffer being displayed in place of
+    /// the pixels read?
+    bool has_corrected_image() const
+    {
+        return m_corrected_image.localpixels() != nullptr;
+    }
+
     bool auto_subimage(void) const { return m_auto_subimage; }
     void auto_subimage(bool v) { m_auto_subimage = v; }
 
@@ -331,6 +341,20 @@ private:
     void updateRecentFilesMenu();
     bool loadCurrentImage(int subimage = 0, int miplevel = 0);
     void displayCurrentImage(bool update = true);
+    /// How img (whose spec is known) must be read for display: the data
+    /// format, and whether transforms (and sRGB to linear in particular)
+    /// need doing on the CPU.
+    void readFormat(const IvImage* img, TypeDesc& read_format,
+                    bool& allow_transforms, bool& srgb_transform) const;
+    /// Start reading the images near the current one in the background,
+    /// and free those read earlier that are no longer near it.
+    void readAhead();
+    /// Cancel the background reads of the images no longer near the
+    /// current one (or of all images), freeing their pixels.
+    void cancelReadAhead(bool all = false);
+    /// Wait for a background read of img, if there is one still to be
+    /// finished. Return true if it read the image successfully.
+    bool finishReadAhead(IvImage* img);
     void updateTitle();
     void updateStatusBar();
     void keyPressEvent(QKeyEvent* event) override;
@@ -403,8 +427,19 @@ private:
     QSpinBox* maxMemoryIC;
     QLabel* slideShowDurationLabel;
     QSpinBox* slideShowDuration;
+    QLabel* readAheadLabel;
+    QSpinBox* readAheadImages;
 
     std::vector<IvImage*> m_images;  // List of images
+    // An image being (or having been) read in the background by readAhead(),
+    // which holds its pixels until cancelReadAhead() frees them.
+    struct ReadAhead {
+        IvImage* image;
+        std::future<bool> done;
+        std::unique_ptr<std::atomic<bool>> cancel;
+        bool finished = false;  // finishReadAhead() has waited for it
+    };
+    std::vector<ReadAhead> m_readahead;
     int m_current_image;             // Index of current image, -1 if none
     int m_current_channel;           // Channel we're viewing.
     COLOR_MODE m_color_mode;         // How to show the current channel(s).
@@ -11,12 +11,14 @@
 #include <QLabel>
 #include <QMouseEvent>
 #include <QProgressBar>
+#include <QTimer>
 #if OIIO_QT_MAJOR >= 6
 #    include <QPainter>
 #    include <QPen>
 #endif
 
 #include "ivutils.h"
+#include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/timer.h>
 
@@ -67,6 +69,10 @@ IvGL::IvGL(QWidget* parent, ImageViewer& viewer)
     , m_current_image(NULL)
     , m_pixelview_left_corner(true)
     , m_last_texbuf_used(0)
+    , m_overview_tex(0)
+    , m_overview_level(-1)
+    , m_overview_width(1)
+    , m_overview_height(1)
 {
 #if 0
     QGLFormat format;
@@ -166,8 +172,17 @@ IvGL::create_textures(void)
         m_texbufs.back().y          = 0;
         m_texbufs.back().width      = 0;
         m_texbufs.back().height     = 0;
+        m_texbufs.back().level      = 0;
     }
 
+    // And one for the overview of images with MIP levels.
+    glGenTextures(1, &m_overview_tex);
+    glBindTexture(GL_TEXTURE_2D, m_overview_tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+
     // Create another texture for the pixelview.
     glGenTextures(1, &m_pixelview_tex);
     glBindTexture(GL_TEXTURE_2D, m_pixelview_tex);
@@ -612,6 +627,67 @@ IvGL::paintGL()
 
     update_state();
 
+    // When zoomed out on an image whose coarser MIP levels are in the
+    // ImageCache, draw from the coarsest of them that still has a pixel
+    // for each pixel of the display.
+    int nlevels  = coarser_miplevels(img);
+    int level    = 0;
+    ROI levelwin = img->roi();
+    for (int l = 1; l <= nlevels; ++l) {
+        ROI win = level_window(img, l);
+        if (!win.defined() || win.width() < spec.width * z)
+            break;
+        level    = l;
+        levelwin = win;
+    }
+    // Scale of the image's pixels to the level's.
+    float xscale = float(spec.width) / levelwin.width();
+    float yscale = float(spec.height) / levelwin.height();
+
+    // Upload the tiles progressively: beneath them draw a low resolution
+    // overview of the whole image, and upload no more of them than fits
+    // in a frame before drawing the rest in the next.
+    bool progressive = false;
+    Timer upload_time;
+    if (nlevels) {
+        int ov  = 0;
+        ROI ovwin;
+        for (int l = 1; l <= nlevels && !ov; ++l) {
+            ROI win = level_window(img, l);
+            if (win.defined() && win.width() <= overview_size
+                && win.height() <= overview_size
+                && win.width() <= m_texture_width
+                && win.height() <= m_texture_height) {
+                ov    = l;
+                ovwin = win;
+            }
+        }
+        if (ov > level) {
+            if (m_overview_level != ov) {
+                int nchannels = num_channels(m_viewer.current_channel(),
+                                             spec.nchannels,
+                                             m_viewer.current_color_mode());
+                GLenum gltype, glformat, glinternalformat;
+                typespec_to_opengl(spec, nchannels, gltype, glformat,
+                                   glinternalformat);
+                m_overview_width  = ceil2(ovwin.width());
+                m_overview_height = ceil2(ovwin.height());
+                glBindTexture(GL_TEXTURE_2D, m_overview_tex);
+                glTexImage2D(GL_TEXTURE_2D, 0, glinternalformat,
+                             m_overview_width, m_overview_height, 0, glformat,
+                             gltype, NULL);
+                upload_pixels(m_overview_tex, ovwin, ov);
+                m_overview_level = ov;
+            }
+            useshader(m_overview_width, m_overview_height);
+            glBindTexture(GL_TEXTURE_2D, m_overview_tex);
+            gl_rect(spec.x, spec.y, spec.x + spec.width, spec.y + spec.height,
+                    0, 0, 0, ovwin.width() / float(m_overview_width),
+                    ovwin.height() / float(m_overview_height));
+            progressive = true;
+        }
+    }
+
     useshader(m_texture_width, m_texture_height);
 
     float smin = 0, smax = 1.0;
@@ -622,25 +698,40 @@ IvGL::paintGL()
     if (img->orientation() > 4) {
         std::swap(wincenterx, wincentery);
     }
-
-    int xbegin = (int)floor(real_centerx) - wincenterx;
-    xbegin     = std::max(spec.x, xbegin - (xbegin % m_texture_width));
-    int ybegin = (int)floor(real_centery) - wincentery;
-    ybegin     = std::max(spec.y, ybegin - (ybegin % m_texture_height));
-    int xend   = (int)floor(real_centerx) + wincenterx;
-    xend       = std::min(spec.x + spec.width,
+    // ...and the same in the pixels of the level we're drawing from.
+    int lcenterx    = (int)floor(levelwin.xbegin
+                                 + (real_centerx - spec.x) / xscale);
+    int lcentery    = (int)floor(levelwin.ybegin
+                                 + (real_centery - spec.y) / yscale);
+    int lwincenterx = (int)ceil(wincenterx / xscale);
+    int lwincentery = (int)ceil(wincentery / yscale);
+
+    int xbegin = lcenterx - lwincenterx;
+    xbegin     = std::max(levelwin.xbegin,
+                          xbegin - (xbegin % m_texture_width));
+    int ybegin = lcentery - lwincentery;
+    ybegin     = std::max(levelwin.ybegin,
+                          ybegin - (ybegin % m_texture_height));
+    int xend   = lcenterx + lwincenterx;
+    xend       = std::min(levelwin.xend,
                           xend + m_texture_width - (xend % m_texture_width));
-    int yend   = (int)floor(real_centery) + wincentery;
-    yend       = std::min(spec.y + spec.height,
+    int yend   = lcentery + lwincentery;
+    yend       = std::min(levelwin.yend,
                           yend + m_texture_height - (yend % m_texture_height));
     //std::cerr << "(" << xbegin << ',' << ybegin << ") - (" << xend << ',' << yend << ")\n";
 
+    // Uploading progressively only helps if the visible tiles all fit in
+    // our textures at once.
+    int ntiles = ((xend - xbegin + m_texture_width - 1) / m_texture_width)
+                 * ((yend - ybegin + m_texture_height - 1) / m_texture_height);
+    if (ntiles > (int)m_texbufs.size())
+        progressive = false;
+
     // Provide some feedback
     m_viewer.statusViewInfo->hide();
     m_viewer.statusProgress->show();
 
-    // FIXME: change the code path so we can take full advantage of async DMA
-    // when using PBO.
+    bool incomplete = false;
     for (int ystart = ybegin; ystart < yend; ystart += m_texture_height) {
         for (int xstart = xbegin; xstart < xend; xstart += m_texture_width) {
             int tile_width  = std::min(xend - xstart, m_texture_width);
@@ -651,14 +742,22 @@ IvGL::paintGL()
             //std::cerr << "xstart: " << xstart << ". ystart: " << ystart << "\n";
             //std::cerr << "tile_width: " << tile_width << ". tile_height: " << tile_height << "\n";
 
-            // FIXME: This can get too slow. Some ideas: avoid sending the tex
-            // images more than necessary, figure an optimum texture size, use
-            // multiple texture objects.
-            load_texture(xstart, ystart, tile_width, tile_height);
-            gl_rect(xstart, ystart, xstart + tile_width, ystart + tile_height,
+            bool may_upload = !progressive || upload_time() < 1.0 / 30.0;
+            if (!load_texture(xstart, ystart, tile_width, tile_height, level,
+                              may_upload)) {
+                incomplete = true;
+                continue;
+            }
+            gl_rect(spec.x + (xstart - levelwin.xbegin) * xscale,
+                    spec.y + (ystart - levelwin.ybegin) * yscale,
+                    spec.x + (xstart + tile_width - levelwin.xbegin) * xscale,
+                    spec.y + (ystart + tile_height - levelwin.ybegin) * yscale,
                     0, smin, tmin, smax, tmax);
         }
     }
+    // Draw again soon, to upload the rest.
+    if (incomplete)
+        QTimer::singleShot(0, this, [this]() { parent_t::update(); });
 
     if (m_viewer.windowguidesOn()) {
         paint_windowguides();
@@ -1111,7 +1210,8 @@ IvGL::update()
     // Resize the buffer at once, rather than create one each drawing.
     m_tex_buffer.resize(m_texture_width * m_texture_height * nchannels
                         * spec.channel_bytes());
-    m_current_image = img;
+    m_current_image  = img;
+    m_overview_level = -1;
 }
 
 
@@ -1563,74 +1663,134 @@ IvGL::typespec_to_opengl(const ImageSpec& spec, int nchannels, GLenum& gltype,
 
 
 
-void
-IvGL::load_texture(int x, int y, int width, int height)
+bool
+IvGL::load_texture(int x, int y, int width, int height, int level,
+                   bool may_upload)
 {
-    const ImageSpec& spec = m_current_image->spec();
     // Find if this has already been loaded.
     for (auto&& tb : m_texbufs) {
-        if (tb.x == x && tb.y == y && tb.width >= width
+        if (tb.x == x && tb.y == y && tb.level == level && tb.width >= width
             && tb.height >= height) {
             glBindTexture(GL_TEXTURE_2D, tb.tex_object);
-            return;
+            return true;
         }
     }
+    if (!may_upload)
+        return false;
 
     setCursor(Qt::WaitCursor);
 
+    TexBuffer& tb = m_texbufs[m_last_texbuf_used];
+    tb.x          = x;
+    tb.y          = y;
+    tb.width      = width;
+    tb.height     = height;
+    tb.level      = level;
+    upload_pixels(tb.tex_object, ROI(x, x + width, y, y + height), level);
+    m_last_texbuf_used = (m_last_texbuf_used + 1) % m_texbufs.size();
+    return true;
+}
+
+
+
+void
+IvGL::upload_pixels(GLuint tex, ROI roi, int level)
+{
+    const ImageSpec& spec = m_current_image->spec();
+
     int nchannels = spec.nchannels;
     // For simplicity, we don't support more than 4 channels without shaders
     // (yet).
     if (m_use_shaders) {
-        nchannels = num_channels(m_viewer.current_channel(), nchannels,
-                                 m_viewer.current_color_mode());
+        nchannels   = num_channels(m_viewer.current_channel(), nchannels,
+                                   m_viewer.current_color_mode());
+        roi.chbegin = m_viewer.current_channel();
+        roi.chend   = m_viewer.current_channel() + nchannels;
     }
     GLenum gltype, glformat, glinternalformat;
     typespec_to_opengl(spec, nchannels, gltype, glformat, glinternalformat);
+    size_t bytes = size_t(roi.npixels()) * nchannels * spec.format.size();
+
+    // Write the pixels straight into the pixel buffer object, first
+    // orphaning its old storage (which the GL may still be copying into a
+    // texture) so that we needn't wait for it. If it can't be mapped, copy
+    // into it from our own buffer.
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo_objects[m_last_pbo_used]);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(bytes), nullptr,
+                 GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+                                    GLsizeiptr(bytes),
+                                    GL_MAP_WRITE_BIT
+                                        | GL_MAP_INVALIDATE_BUFFER_BIT);
+    span<std::byte> buffer = as_writable_bytes(make_span(m_tex_buffer));
+    if (mapped)
+        buffer = span<std::byte>((std::byte*)mapped, bytes);
 
-    TexBuffer& tb = m_texbufs[m_last_texbuf_used];
-    tb.x          = x;
-    tb.y          = y;
-    tb.width      = width;
-    tb.height     = height;
     // Copy the imagebuf pixels we need, that's the only way we can do
     // it safely since ImageBuf has a cache underneath and the whole image
-    // may not be resident at once.
-    if (!m_use_shaders) {
-        m_current_image->get_pixels(ROI(x, x + width, y, y + height),
-                                    spec.format,
-                                    as_writable_bytes(make_span(m_tex_buffer)));
+    // may not be resident at once. Coarser MIP levels come straight from
+    // that cache.
+    if (level == 0) {
+        m_current_image->get_pixels(roi, spec.format, buffer);
     } else {
-        m_current_image->get_pixels(ROI(x, x + width, y, y + height, 0, 1,
-                                        m_viewer.current_channel(),
-                                        m_viewer.current_channel() + nchannels),
-                                    spec.format,
-                                    as_writable_bytes(make_span(m_tex_buffer)));
+        m_current_image->imagecache()->get_pixels(
+            ustring(m_current_image->name()), m_current_image->subimage(),
+            m_current_image->miplevel() + level, roi.xbegin, roi.xend,
+            roi.ybegin, roi.yend, 0, 1, roi.chbegin, roi.chend, spec.format,
+            buffer.data());
     }
 
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo_objects[m_last_pbo_used]);
-    glBufferData(GL_PIXEL_UNPACK_BUFFER,
-                 GLsizeiptr(uint64_t(width) * uint64_t(height)
-                            * uint64_t(nchannels)
-                            * uint64_t(spec.format.size())),
-                 &m_tex_buffer[0], GL_STREAM_DRAW);
+    if (mapped)
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    else
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(bytes),
+                     &m_tex_buffer[0], GL_STREAM_DRAW);
     print_error("After buffer data");
     m_last_pbo_used = (m_last_pbo_used + 1) & 1;
 
     // When using PBO this is the offset within the buffer.
     void* data = 0;
 
-    glBindTexture(GL_TEXTURE_2D, tb.tex_object);
+    glBindTexture(GL_TEXTURE_2D, tex);
     print_error("After bind texture");
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, glformat, gltype,
-                    data);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, roi.width(), roi.height(),
+                    glformat, gltype, data);
     print_error("After loading sub image");
-    m_last_texbuf_used = (m_last_texbuf_used + 1) % m_texbufs.size();
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 }
 
 
 
+int
+IvGL::coarser_miplevels(IvImage* img) const
+{
+    // Only with shaders can we show the channels as the ImageCache has
+    // them, rather than a copy corrected on the CPU.
+    if (!m_use_shaders || img->has_corrected_image() || !img->imagecache()
+        || img->deep() || img->spec().depth > 1)
+        return 0;
+    return std::max(0, img->nmiplevels() - 1 - img->miplevel());
+}
+
+
+
+ROI
+IvGL::level_window(IvImage* img, int level) const
+{
+    if (level == 0)
+        return img->roi();
+    int dw[4];
+    if (!img->imagecache()->get_image_info(ustring(img->name()),
+                                           img->subimage(),
+                                           img->miplevel() + level,
+                                           ustring("datawindow"),
+                                           TypeDesc(TypeDesc::INT, 4), dw))
+        return ROI();
+    return ROI(dw[0], dw[2] + 1, dw[1], dw[3] + 1);
+}
+
+
+
 bool
 IvGL::is_too_big(float width, float height)
 {
@@ -134,9 +134,16 @@ protected:
         int y;
         int width;
         int height;
+        int level;  ///< MIP level, relative to the image's own
     };
     std::vector<TexBuffer> m_texbufs;
     int m_last_texbuf_used;
+    /// A low resolution texture of the whole image, drawn beneath the
+    /// tiles when zoomed out on an image with MIP levels, until they're
+    /// all uploaded.
+    GLuint m_overview_tex;
+    int m_overview_level;  ///< Its MIP level (relative), or -1 if none
+    GLsizei m_overview_width, m_overview_height;  ///< Its texture size
     bool m_mouse_activation;  ///< Can we expect the window to be activated by mouse?
 
 
@@ -187,6 +194,9 @@ private:
     /// closeuptexsize is the size of the texture used to upload the pixelview
     /// to OpenGL.
     const static int closeuptexsize = 16;
+    /// overview_size is the largest width and height of the MIP level used
+    /// for the overview of a zoomed out image.
+    const static int overview_size = 1024;
 
     void clamp_view_to_window();
 
@@ -198,9 +208,24 @@ private:
     ///
     void print_shader_log(std::ostream& out, const GLuint shader_id);
 
-    /// Loads the given patch of the image, but first figures if it's already
-    /// been loaded.
-    void load_texture(int x, int y, int width, int height);
+    /// Loads the given patch of the image (in the pixel coordinates of MIP
+    /// level `level` relative to the image's), but first figures if it's
+    /// already been loaded. If it hasn't and `may_upload` is false, leave
+    /// it. Return true if the patch's texture is now bound.
+    bool load_texture(int x, int y, int width, int height, int level = 0,
+                      bool may_upload = true);
+
+    /// Copy a patch of the image, at MIP level `level` relative to the
+    /// image's, through a pixel buffer object into texture `tex`.
+    void upload_pixels(GLuint tex, ROI roi, int level);
+
+    /// How many MIP levels coarser than the image's own can be drawn from
+    /// the ImageCache (0 if none).
+    int coarser_miplevels(IvImage* img) const;
+
+    /// The data window of the image's MIP level `level` (relative to its
+    /// own), from the ImageCache.
+    ROI level_window(IvImage* img, int level) const;
 
     /// Destroys shaders and selects fixed-function pipeline
     void create_shaders_abort(void);
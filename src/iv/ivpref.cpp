@@ -39,8 +39,13 @@ IvPreferenceWindow::IvPreferenceWindow(ImageViewer& viewer)
     slideShowLayout->addWidget(viewer.slideShowDurationLabel);
     slideShowLayout->addWidget(viewer.slideShowDuration);
 
+    QLayout* readAheadLayout = new QHBoxLayout;
+    readAheadLayout->addWidget(viewer.readAheadLabel);
+    readAheadLayout->addWidget(viewer.readAheadImages);
+
     layout->addLayout(inner_layout);
     layout->addLayout(slideShowLayout);
+    layout->addLayout(readAheadLayout);
     layout->addWidget(closeButton);
     setLayout(layout);
 
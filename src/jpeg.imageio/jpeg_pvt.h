@@ -91,6 +91,7 @@ private:
     std::string m_filename;
     int m_next_scanline;   // Which scanline is the next to read?
     bool m_raw;            // Read raw coefficients, not scanlines
+    bool m_headeronly;     // Skip the metadata markers
     bool m_cmyk;           // The input file is cmyk
     bool m_fatalerr;       // JPEG reader hit a fatal error
     bool m_decomp_create;  // Have we created the decompressor?
@@ -107,6 +108,7 @@ private:
     void init()
     {
         m_raw           = false;
+        m_headeronly    = false;
         m_cmyk          = false;
         m_fatalerr      = false;
         m_decomp_create = false;
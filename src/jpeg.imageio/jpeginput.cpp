@@ -155,8 +155,9 @@ bool
 JpgInput::open(const std::string& name, ImageSpec& newspec,
                const ImageSpec& config)
 {
-    auto p = config.find_attribute("_jpeg:raw", TypeInt);
-    m_raw  = p && *(int*)p->data();
+    auto p       = config.find_attribute("_jpeg:raw", TypeInt);
+    m_raw        = p && *(int*)p->data();
+    m_headeronly = config.get_int_attribute("oiio:headeronly", 0) == 1;
     ioproxy_retrieve_from_config(config);
     m_config.reset(new ImageSpec(config));  // save config spec
     return open(name, newspec);
@@ -172,10 +173,12 @@ JpgInput::open(const std::string& name, ImageSpec& newspec)
     if (!ioproxy_use_or_open(name))
         return false;
     // If an IOProxy was passed, it had better be a File or a
-    // MemReader, that's all we know how to use with jpeg.
+    // MemReader (or an MMap, which is one), that's all we know how to use
+    // with jpeg.
     Filesystem::IOProxy* m_io = ioproxy();
     std::string proxytype     = m_io->proxytype();
-    if (proxytype != "file" && proxytype != "memreader") {
+    if (proxytype != "file" && proxytype != "memreader"
+        && proxytype != "mmap") {
         errorfmt("JPEG reader can't handle proxy type {}", proxytype);
         return false;
     }
@@ -222,10 +225,13 @@ JpgInput::open(const std::string& name, ImageSpec& newspec)
                      buffer.size());
     }
 
-    // Request saving of EXIF and other special tags for later spelunking
-    for (int mark = 0; mark < 16; ++mark)
-        jpeg_save_markers(&m_cinfo, JPEG_APP0 + mark, 0xffff);
-    jpeg_save_markers(&m_cinfo, JPEG_COM, 0xffff);  // comment marker
+    // Request saving of EXIF and other special tags for later spelunking,
+    // unless only the header is wanted.
+    if (!m_headeronly) {
+        for (int mark = 0; mark < 16; ++mark)
+            jpeg_save_markers(&m_cinfo, JPEG_APP0 + mark, 0xffff);
+        jpeg_save_markers(&m_cinfo, JPEG_COM, 0xffff);  // comment marker
+    }
 
     // read the file parameters
     if (jpeg_read_header(&m_cinfo, FALSE) != JPEG_HEADER_OK || m_fatalerr) {
@@ -120,7 +120,8 @@ OIIO_PLUGIN_EXPORTS_END
 
 static std::set<std::string> metadata_include { "oiio:ConstantColor",
                                                 "oiio:AverageColor",
-                                                "oiio:SHA-1" };
+                                                "oiio:SHA-1",
+                                                "oiio:ContentHash" };
 static std::set<std::string> metadata_exclude {
     "XResolution",    "YResolution", "PixelAspectRatio",
     "ResolutionUnit", "Orientation", "ImageDescription"
@@ -7,9 +7,17 @@
 #include <openjpeg.h>
 #include <opj_config.h>
 
+#if defined(USE_OPENJPH)
+#    include <openjph/ojph_codestream.h>
+#    include <openjph/ojph_file.h>
+#    include <openjph/ojph_mem.h>
+#    include <openjph/ojph_params.h>
+#endif
+
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/fmath.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/strutil.h>
 
 #ifndef OIIO_OPJ_VERSION
 #    if defined(OPJ_VERSION_MAJOR)
@@ -56,6 +64,16 @@ private:
     bool m_convert_alpha;  //< Do we deassociate alpha?
     std::vector<unsigned char> m_tilebuffer;
     std::vector<unsigned char> m_scratch;
+#if defined(USE_OPENJPH)
+    // HTJ2K output, which OpenJPH encodes a scanline at a time as they
+    // are written, into memory.
+    std::unique_ptr<ojph::codestream> m_htcodestream;
+    std::unique_ptr<ojph::mem_outfile> m_htfile;
+    ojph::line_buf* m_htline;  //< The line OpenJPH wants next
+    ojph::ui32 m_htcomp;       //< ... and which channel it's for
+    int m_htprecision;         //< Bits per sample in the file
+    int m_htnexty;             //< The next scanline to write
+#endif
 
     void init(void)
     {
@@ -63,9 +81,23 @@ private:
         m_codec         = NULL;
         m_stream        = NULL;
         m_convert_alpha = true;
+#if defined(USE_OPENJPH)
+        m_htline      = nullptr;
+        m_htcomp      = 0;
+        m_htprecision = 0;
+        m_htnexty     = 0;
+#endif
         ioproxy_clear();
     }
 
+#if defined(USE_OPENJPH)
+    // Should we write an HTJ2K codestream rather than using OpenJPEG?
+    bool use_htj2k() const;
+    bool open_htj2k();
+    bool write_htj2k_scanline(int y, const void* data);
+    bool finish_htj2k();
+#endif
+
     opj_image_t* create_jpeg2000_image();
 
     void init_components(opj_image_cmptparm_t* components, int precision);
@@ -141,8 +173,13 @@ jpeg2000_output_imageio_create()
     return new Jpeg2000Output;
 }
 
-OIIO_EXPORT const char* jpeg2000_output_extensions[] = { "jp2", "j2k",
-                                                         nullptr };
+OIIO_EXPORT const char* jpeg2000_output_extensions[] = {
+    "jp2", "j2k", "j2c",
+#if defined(USE_OPENJPH)
+    "jph", "jhc",
+#endif
+    nullptr
+};
 
 OIIO_PLUGIN_EXPORTS_END
 
@@ -176,12 +213,218 @@ Jpeg2000Output::open(const std::string& name, const ImageSpec& spec,
     if (m_spec.tile_width && m_spec.tile_height)
         m_tilebuffer.resize(m_spec.image_bytes());
 
+#if defined(USE_OPENJPH)
+    if (use_htj2k())
+        return open_htj2k();
+#else
+    if (Strutil::iequals(m_spec.decode_compression_metadata().first,
+                         "htj2k")) {
+        errorfmt("HTJ2K output requires OpenImageIO built with OpenJPH");
+        return false;
+    }
+#endif
+
     m_image = create_jpeg2000_image();
     return true;
 }
 
 
 
+#if defined(USE_OPENJPH)
+
+bool
+Jpeg2000Output::use_htj2k() const
+{
+    std::string ext = Filesystem::extension(m_filename);
+    return Strutil::iequals(ext, ".jph") || Strutil::iequals(ext, ".jhc")
+           || Strutil::iequals(m_spec.decode_compression_metadata().first,
+                               "htj2k");
+}
+
+
+
+bool
+Jpeg2000Output::open_htj2k()
+{
+    // Quality 100 (the default) is lossless, with the reversible wavelet.
+    // Lower qualities quantize more and more coarsely, unless the caller
+    // picks the quantization step themselves.
+    auto compqual  = m_spec.decode_compression_metadata("htj2k", 100);
+    int quality    = clamp(compqual.second, 1, 100);
+    float qstep    = m_spec.get_float_attribute(
+        "jpeg2000:QuantizationStep",
+        0.0005f * powf(2.0f, float(100 - quality) / 10.0f));
+    const int nc   = m_spec.nchannels;
+    const int bits = int(m_spec.format.size()) * 8;
+    m_htprecision  = clamp(m_spec.get_int_attribute("oiio:BitsPerSample",
+                                                    bits),
+                           1, bits);
+    // Up to 5 wavelet decompositions, as long as the smallest level is
+    // still at least a pixel across.
+    int levels = 0;
+    while (levels < 5
+           && (std::min(m_spec.width, m_spec.height) >> (levels + 1)) > 0)
+        ++levels;
+    std::string progression
+        = m_spec.get_string_attribute("jpeg2000:ProgressionOrder", "RPCL");
+
+    try {
+        m_htcodestream.reset(new ojph::codestream);
+        ojph::param_siz siz = m_htcodestream->access_siz();
+        siz.set_image_extent(ojph::point(m_spec.width, m_spec.height));
+        siz.set_num_components(nc);
+        for (int c = 0; c < nc; ++c)
+            siz.set_component(c, ojph::point(1, 1), m_htprecision, false);
+        ojph::param_cod cod = m_htcodestream->access_cod();
+        cod.set_num_decomposition(levels);
+        cod.set_block_dims(
+            m_spec.get_int_attribute("jpeg2000:InitialCodeBlockWidth", 64),
+            m_spec.get_int_attribute("jpeg2000:InitialCodeBlockHeight", 64));
+        cod.set_progression_order(progression.c_str());
+        cod.set_color_transform(nc >= 3);
+        cod.set_reversible(quality == 100);
+        if (quality < 100)
+            m_htcodestream->access_qcd().set_irrev_quant(qstep);
+        m_htcodestream->set_planar(false);
+
+        m_htfile.reset(new ojph::mem_outfile);
+        m_htfile->open();
+        m_htcodestream->write_headers(m_htfile.get());
+        m_htline = m_htcodestream->exchange(nullptr, m_htcomp);
+    } catch (const std::exception& e) {
+        errorfmt("Could not set up HTJ2K encoding: {}", e.what());
+        m_htcodestream.reset();
+        m_htfile.reset();
+        return false;
+    }
+    return true;
+}
+
+
+
+bool
+Jpeg2000Output::write_htj2k_scanline(int y, const void* data)
+{
+    if (y != m_htnexty) {
+        errorfmt("HTJ2K scanlines must be written in order");
+        return false;
+    }
+    const int nc = m_spec.nchannels;
+    auto copy    = [&](auto* src, ojph::si32* dst, int c) {
+        const int bits = int(sizeof(*src)) * 8;
+        for (int x = 0; x < m_spec.width; ++x) {
+            unsigned int val = src[x * nc + c];
+            dst[x]           = int(bits == m_htprecision
+                                       ? val
+                                       : bit_range_convert(val, bits,
+                                                           m_htprecision));
+        }
+    };
+    try {
+        // A line of each channel, in the order that OpenJPH asks for them
+        for (int i = 0; i < nc; ++i) {
+            if (m_spec.format == TypeDesc::UINT8)
+                copy((const uint8_t*)data, m_htline->i32, int(m_htcomp));
+            else
+                copy((const uint16_t*)data, m_htline->i32, int(m_htcomp));
+            m_htline = m_htcodestream->exchange(m_htline, m_htcomp);
+        }
+    } catch (const std::exception& e) {
+        errorfmt("HTJ2K encoding error: {}", e.what());
+        return false;
+    }
+    ++m_htnexty;
+    return true;
+}
+
+
+
+bool
+Jpeg2000Output::finish_htj2k()
+{
+    if (m_htnexty != m_spec.height) {
+        errorfmt("Not all scanlines of {} were written", m_filename);
+        return false;
+    }
+    try {
+        m_htcodestream->flush();
+    } catch (const std::exception& e) {
+        errorfmt("HTJ2K encoding error: {}", e.what());
+        return false;
+    }
+    const uint8_t* data = m_htfile->get_data();
+    uint64_t size       = uint64_t(m_htfile->tell());
+
+    std::string ext = Filesystem::extension(m_filename);
+    if (Strutil::iequals(ext, ".jph") || Strutil::iequals(ext, ".jp2")) {
+        // Wrap the codestream in the boxes of a JPH file (ISO/IEC 15444-15
+        // Annex D), which are JP2's with the 'jph ' brand.
+        const int nc = m_spec.nchannels;
+        std::vector<uint8_t> boxes;
+        auto put = [&](uint64_t v, int n) {
+            for (int i = n - 1; i >= 0; --i)
+                boxes.push_back(uint8_t(v >> (8 * i)));
+        };
+        auto puttype = [&](const char* t) {
+            boxes.insert(boxes.end(), t, t + 4);
+        };
+        put(12, 4);
+        puttype("jP  ");
+        put(0x0D0A870A, 4);
+        put(20, 4);
+        puttype("ftyp");
+        puttype("jph ");
+        put(0, 4);
+        puttype("jph ");
+        // Header superbox: image header, color, and channel definitions
+        int cdeflen = m_spec.alpha_channel >= 0 ? 10 + 6 * nc : 0;
+        put(8 + 22 + 15 + cdeflen, 4);
+        puttype("jp2h");
+        put(22, 4);
+        puttype("ihdr");
+        put(m_spec.height, 4);
+        put(m_spec.width, 4);
+        put(nc, 2);
+        put(m_htprecision - 1, 1);
+        put(7, 1);  // Compression type: JPEG 2000
+        put(0, 2);  // Colorspace known, no IPR
+        put(15, 4);
+        puttype("colr");
+        put(1, 1);  // Enumerated colorspace
+        put(0, 2);
+        put(nc >= 3 ? 16 /* sRGB */ : 17 /* greyscale */, 4);
+        if (cdeflen) {
+            put(cdeflen, 4);
+            puttype("cdef");
+            put(nc, 2);
+            for (int c = 0, color = 0; c < nc; ++c) {
+                bool alpha = (c == m_spec.alpha_channel);
+                put(c, 2);
+                put(alpha ? 1 : 0, 2);
+                put(alpha ? 0 : ++color, 2);
+            }
+        }
+        // The codestream itself
+        if (size + 8 <= 0xffffffff) {
+            put(size + 8, 4);
+            puttype("jp2c");
+        } else {
+            put(1, 4);
+            puttype("jp2c");
+            put(size + 16, 8);
+        }
+        if (!iowrite(boxes.data(), boxes.size()))
+            return false;
+    }
+    bool ok = iowrite(data, size);
+    m_htcodestream->close();
+    return ok;
+}
+
+#endif  // USE_OPENJPH
+
+
+
 template<class T>
 static void
 deassociateAlpha(T* data, int size, int channels, int alpha_channel,
@@ -242,6 +485,11 @@ Jpeg2000Output::write_scanline(int y, int z, TypeDesc format, const void* data,
                              m_spec.nchannels, m_spec.alpha_channel, 2.2f);
     }
 
+#if defined(USE_OPENJPH)
+    if (m_htcodestream)
+        return write_htj2k_scanline(y, data);
+#endif
+
     if (m_spec.format == TypeDesc::UINT8)
         write_scanline<uint8_t>(y, z, data);
     else
@@ -270,7 +518,11 @@ Jpeg2000Output::write_tile(int x, int y, int z, TypeDesc format,
 bool
 Jpeg2000Output::close()
 {
-    if (!m_stream) {  // Already closed
+    bool is_open = m_stream != nullptr;
+#if defined(USE_OPENJPH)
+    is_open |= (m_htcodestream != nullptr);
+#endif
+    if (!is_open) {  // Already closed
         return true;
     }
 
@@ -283,6 +535,13 @@ Jpeg2000Output::close()
         std::vector<unsigned char>().swap(m_tilebuffer);
     }
 
+#if defined(USE_OPENJPH)
+    if (m_htcodestream) {
+        ok &= finish_htj2k();
+        m_htcodestream.reset();
+        m_htfile.reset();
+    }
+#endif
     if (m_image) {
         opj_image_destroy(m_image);
         m_image = NULL;
@@ -419,7 +678,7 @@ Jpeg2000Output::create_compressor()
 {
     std::string ext         = Filesystem::extension(m_filename);
     opj_codec_t* compressor = NULL;
-    if (ext == ".j2k")
+    if (ext == ".j2k" || ext == ".j2c")
         compressor = opj_create_compress(OPJ_CODEC_J2K);
     else if (ext == ".jp2")
         compressor = opj_create_compress(OPJ_CODEC_JP2);
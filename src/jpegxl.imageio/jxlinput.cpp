@@ -157,7 +157,9 @@ JxlInput::open(const std::string& name, ImageSpec& newspec)
 
     Filesystem::IOProxy* m_io = ioproxy();
     std::string proxytype     = m_io->proxytype();
-    if (proxytype != "file" && proxytype != "memreader") {
+    // An IOMMap is an IOMemReader of the mapped file.
+    if (proxytype != "file" && proxytype != "memreader"
+        && proxytype != "mmap") {
         errorfmt("JPEG XL reader can't handle proxy type {}", proxytype);
         return false;
     }
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -19,6 +20,7 @@
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
 
+#include "imagebufalgo_lut_prv.h"
 #include "imageio_pvt.h"
 
 #define MAKE_OCIO_VERSION_HEX(maj, min, patch) \
@@ -53,6 +55,9 @@ static bool colordebug = Strutil::stoi(Sysutil::getenv("OIIO_DEBUG_COLOR"))
 static int disable_ocio = Strutil::stoi(Sysutil::getenv("OIIO_DISABLE_OCIO"));
 static int disable_builtin_configs = Strutil::stoi(
     Sysutil::getenv("OIIO_DISABLE_BUILTIN_OCIO_CONFIGS"));
+// Directory in which to remember the classification of color spaces
+static std::string colorconfig_cache_dir = Sysutil::getenv(
+    "OPENIMAGEIO_COLORCONFIG_CACHE");
 static OCIO::ConstConfigRcPtr ocio_current_config;
 
 
@@ -167,8 +172,10 @@ struct CSInfo {
         is_Rec709          = 32,  // Rec709 primaries and transfer function
         is_known           = is_srgb | is_lin_srgb | is_ACEScg | is_Rec709
     };
-    int m_flags   = 0;
-    bool examined = false;
+    int m_flags = 0;
+    // Fully classified? Once set, the flags and canonical name no longer
+    // change, so may be read without a lock.
+    std::atomic<bool> examined { false };
     std::string canonical;  // Canonical name for this color space
     OCIO::ConstColorSpaceRcPtr ocio_cs;
 
@@ -180,6 +187,15 @@ struct CSInfo {
         , canonical(canonical_)
     {
     }
+    CSInfo(const CSInfo& other)
+        : name(other.name)
+        , index(other.index)
+        , m_flags(other.m_flags)
+        , examined(other.examined.load())
+        , canonical(other.canonical)
+        , ocio_cs(other.ocio_cs)
+    {
+    }
 
     void setflag(int flagval) { m_flags |= flagval; }
 
@@ -210,11 +226,21 @@ private:
     std::string srgb_alias;
     std::string ACEScg_alias;
     std::string Rec709_alias;
-    mutable spin_rw_mutex m_mutex;
+    mutable spin_rw_mutex m_mutex;  // Guards only m_error
     mutable std::string m_error;
-    ColorProcessorMap colorprocmap;  // cache of ColorProcessors
-    atomic_int colorprocs_requested;
+    // The cache of ColorProcessors is an immutable map, replaced by a copy
+    // with the addition whenever a processor is added, so that lookups need
+    // no lock. Replaced maps are kept until the ColorConfig goes away, since
+    // a lookup might still be reading one; there are only ever a few.
+    std::atomic<const ColorProcessorMap*> colorprocmap { nullptr };
+    std::vector<std::unique_ptr<ColorProcessorMap>> colorprocmaps;
+    std::mutex colorprocmap_mutex;  // Serializes additions
     atomic_int colorprocs_created;
+    // Color spaces are classified by the more expensive heuristics only
+    // when first asked about, under the classify mutex; all of them (and
+    // so all the aliases) only when an alias is needed.
+    std::mutex m_classify_mutex;
+    std::atomic<bool> m_all_examined { false };
     std::string m_configname;
     ColorConfig* m_self       = nullptr;
     bool m_config_is_built_in = false;
@@ -230,9 +256,8 @@ public:
 #if 0
         // Debugging the cache -- make sure we're creating a small number
         // compared to repeated requests.
-        if (colorprocs_requested)
-            DBG("ColorConfig::Impl : color procs requested: {}, created: {}\n",
-                           colorprocs_requested, colorprocs_created);
+        DBG("ColorConfig::Impl : color procs created: {}\n",
+            colorprocs_created);
 #endif
     }
 
@@ -240,7 +265,6 @@ public:
 
     void add(const std::string& name, int index, int flags = 0)
     {
-        spin_rw_write_lock lock(m_mutex);
         colorspaces.emplace_back(name, index, flags);
         // classify(colorspaces.back());
     }
@@ -263,14 +287,15 @@ public:
     }
 
     // Search for a matching ColorProcessor, return it if found (otherwise
-    // return an empty handle).
-    ColorProcessorHandle findproc(const ColorProcCacheKey& key)
+    // return an empty handle). This takes no lock.
+    ColorProcessorHandle findproc(const ColorProcCacheKey& key) const
     {
-        ++colorprocs_requested;
-        spin_rw_read_lock lock(m_mutex);
-        auto found = colorprocmap.find(key);
-        return (found == colorprocmap.end()) ? ColorProcessorHandle()
-                                             : found->second;
+        const ColorProcessorMap* map = colorprocmap.load(
+            std::memory_order_acquire);
+        if (!map)
+            return ColorProcessorHandle();
+        auto found = map->find(key);
+        return (found == map->end()) ? ColorProcessorHandle() : found->second;
     }
 
     // Add the given color processor. Be careful -- if a matching one is
@@ -281,17 +306,24 @@ public:
     {
         if (!handle)
             return handle;
-        spin_rw_write_lock lock(m_mutex);
-        auto found = colorprocmap.find(key);
-        if (found == colorprocmap.end()) {
-            // No equivalent item in the map. Add this one.
-            colorprocmap[key] = handle;
-            ++colorprocs_created;
-        } else {
-            // There's already an equivalent one. Oops. Discard this one and
-            // return the one already in the map.
-            handle = found->second;
+        std::lock_guard<std::mutex> lock(colorprocmap_mutex);
+        const ColorProcessorMap* map = colorprocmap.load(
+            std::memory_order_relaxed);
+        if (map) {
+            auto found = map->find(key);
+            if (found != map->end()) {
+                // There's already an equivalent one. Oops. Discard this one
+                // and return the one already in the map.
+                return found->second;
+            }
         }
+        // No equivalent item in the map. Publish a copy with this one added.
+        auto newmap = map ? std::make_unique<ColorProcessorMap>(*map)
+                          : std::make_unique<ColorProcessorMap>();
+        (*newmap)[key] = handle;
+        colorprocmap.store(newmap.get(), std::memory_order_release);
+        colorprocmaps.push_back(std::move(newmap));
+        ++colorprocs_created;
         return handle;
     }
 
@@ -341,66 +373,71 @@ public:
 
     bool isColorSpaceLinear(string_view name) const;
 
-private:
-    // Return the CSInfo flags for the given color space name
-    int flags(string_view name)
+    // Find the CSInfo record for the named color space, fully classified,
+    // or nullptr if it's not a color space we know.
+    const CSInfo* examined(string_view name)
     {
         CSInfo* cs = find(name);
-        if (!cs)
-            return 0;
-        examine(cs);
-        spin_rw_read_lock lock(m_mutex);
-        return cs->flags();
+        if (cs && !cs->examined.load(std::memory_order_acquire))
+            examine(*cs);
+        return cs;
     }
 
+    // Fully classify all the color spaces, if not already done, which
+    // settles the aliases, after which they never change and can be read
+    // without a lock.
+    void examine_all();
+
+private:
     // Set cs.flag to include any bits in flagval.
-    void setflag(CSInfo& cs, int flagval)
-    {
-        spin_rw_write_lock lock(m_mutex);
-        cs.setflag(flagval);
-    }
+    void setflag(CSInfo& cs, int flagval) { cs.setflag(flagval); }
 
     // Set cs.flag to include any bits in flagval, and also if alias is not
     // yet set, set it to cs.name.
     void setflag(CSInfo& cs, int flagval, std::string& alias)
     {
-        spin_rw_write_lock lock(m_mutex);
         cs.setflag(flagval, alias);
     }
 
     void inventory();
 
     // Set the flags for the given color space and canonical name, if we can
-    // make a guess based on the name. This is very inexpensive. This should
-    // only be called from within a lock of the mutex.
+    // make a guess based on the name. This is very inexpensive.
     void classify_by_name(CSInfo& cs);
 
     // Set the flags for the given color space and canonical name, trying some
     // tricks to deduce the color space from the primaries, white point, and
     // transfer function. This is more expensive, and might only work for OCIO
-    // 2.2 and above. This should only be called from within a lock of the
-    // mutex.
+    // 2.2 and above.
     void classify_by_conversions(CSInfo& cs);
 
     // Apply more heuristics to try to deduce more color space information.
     void reclassify_heuristics(CSInfo& cs);
 
-    // If the CSInfo hasn't yet been "examined" (fully classified by all
-    // heuristics), do so. This should NOT be called from within a lock of the
-    // mutex.
-    void examine(CSInfo* cs)
+    // Fully classify, by all heuristics, the color space if it hasn't yet
+    // been "examined".
+    void examine(CSInfo& cs)
     {
-        if (!cs->examined) {
-            spin_rw_write_lock lock(m_mutex);
-            if (!cs->examined) {
-                classify_by_name(*cs);
-                classify_by_conversions(*cs);
-                reclassify_heuristics(*cs);
-                cs->examined = true;
-            }
+        std::lock_guard<std::mutex> lock(m_classify_mutex);
+        examine_locked(cs);
+    }
+    void examine_locked(CSInfo& cs)
+    {
+        if (!cs.examined.load(std::memory_order_relaxed)) {
+            classify_by_conversions(cs);
+            reclassify_heuristics(cs);
+            cs.examined.store(true, std::memory_order_release);
         }
     }
 
+    // Name of the file remembering the classification of this config's
+    // color spaces, or "" if there's no such cache.
+    std::string cache_filename() const;
+    // Read the classification from the cache file, returning true if it
+    // had one for this config.
+    bool read_cache();
+    void write_cache() const;
+
     void debug_print_aliases()
     {
         DBG("Aliases: scene_linear={}   lin_srgb={}   srgb={}   ACEScg={}   Rec709={}\n",
@@ -757,6 +794,145 @@ ColorConfig::Impl::identify_builtin_equivalents()
 
 
 
+void
+ColorConfig::Impl::examine_all()
+{
+    if (m_all_examined.load(std::memory_order_acquire))
+        return;
+    std::lock_guard<std::mutex> lock(m_classify_mutex);
+    if (m_all_examined.load(std::memory_order_relaxed))
+        return;
+    Timer timer;
+#if OCIO_VERSION_HEX >= MAKE_OCIO_VERSION_HEX(2, 3, 0)
+    DBG("\nIDENTIFY BUILTIN EQUIVALENTS\n");
+    identify_builtin_equivalents();  // OCIO 2.3+ only
+    DBG("OCIO 2.3+ builtin equivalents in {:0.2f} seconds\n", timer.lap());
+#endif
+    for (auto&& cs : colorspaces)
+        examine_locked(cs);
+    DBG("OCIO color spaces examined in {:0.2f} seconds\n", timer.lap());
+    m_all_examined.store(true, std::memory_order_release);
+    write_cache();
+}
+
+
+
+std::string
+ColorConfig::Impl::cache_filename() const
+{
+    if (colorconfig_cache_dir.empty() || !config_ || disable_ocio)
+        return std::string();
+    // The classification depends on the config, and on the heuristics of
+    // this version of OIIO and of OCIO.
+    std::string key = Strutil::fmt::format("{} {} {}",
+                                           config_->getCacheID(),
+                                           OIIO_VERSION_STRING,
+                                           OCIO_VERSION_HEX);
+    return Strutil::fmt::format("{}/colorconfig-{:016x}.txt",
+                                colorconfig_cache_dir,
+                                Strutil::strhash64(key));
+}
+
+
+
+// The cache file is text: a header line, then a line `alias <which>
+// <name>` for each informal alias that's set, then a line `cs <flags>
+// <canonical or -> <name>` for every color space, in order.
+static const char* colorconfig_cache_header = "oiio-colorconfig-cache 1";
+
+
+
+bool
+ColorConfig::Impl::read_cache()
+{
+    std::string filename = cache_filename();
+    std::string text;
+    if (filename.empty() || !Filesystem::exists(filename)
+        || !Filesystem::read_text_file(filename, text))
+        return false;
+    auto lines = Strutil::splits(text, "\n");
+    if (lines.empty() || lines[0] != colorconfig_cache_header)
+        return false;
+    // Parse it all before changing anything, so that a damaged file leaves
+    // us as if there were none.
+    std::vector<std::pair<int, std::string>> classified;
+    std::string aliases[5];
+    static const char* alias_names[5] = { "scene_linear", "lin_srgb", "srgb",
+                                          "ACEScg", "Rec709" };
+    for (size_t i = 1; i < lines.size(); ++i) {
+        if (lines[i].empty())
+            continue;
+        // The last field, a color space name, may itself contain spaces
+        bool alias  = Strutil::starts_with(lines[i], "alias ");
+        auto fields = Strutil::splitsv(lines[i], " ", alias ? 3 : 4);
+        if (alias && fields.size() == 3) {
+            int a = 0;
+            while (a < 5 && fields[1] != alias_names[a])
+                ++a;
+            if (a == 5)
+                return false;
+            aliases[a] = fields[2];
+        } else if (fields.size() == 4 && fields[0] == "cs") {
+            size_t c = classified.size();
+            if (c >= colorspaces.size() || fields[3] != colorspaces[c].name)
+                return false;
+            classified.emplace_back(Strutil::stoi(fields[1]),
+                                    fields[2] == "-" ? string_view()
+                                                     : fields[2]);
+        } else {
+            return false;
+        }
+    }
+    if (classified.size() != colorspaces.size())
+        return false;
+    std::string* members[5] = { &scene_linear_alias, &lin_srgb_alias,
+                                &srgb_alias, &ACEScg_alias, &Rec709_alias };
+    for (int a = 0; a < 5; ++a)
+        *members[a] = aliases[a];
+    for (size_t i = 0; i < colorspaces.size(); ++i) {
+        colorspaces[i].m_flags   = classified[i].first;
+        colorspaces[i].canonical = classified[i].second;
+        colorspaces[i].examined  = true;
+    }
+    m_all_examined = true;
+    return true;
+}
+
+
+
+void
+ColorConfig::Impl::write_cache() const
+{
+    std::string filename = cache_filename();
+    if (filename.empty())
+        return;
+    std::string text = Strutil::fmt::format("{}\n", colorconfig_cache_header);
+    const std::pair<const char*, const std::string*> aliases[] = {
+        { "scene_linear", &scene_linear_alias },
+        { "lin_srgb", &lin_srgb_alias },
+        { "srgb", &srgb_alias },
+        { "ACEScg", &ACEScg_alias },
+        { "Rec709", &Rec709_alias },
+    };
+    for (auto& a : aliases)
+        if (a.second->size())
+            text += Strutil::fmt::format("alias {} {}\n", a.first, *a.second);
+    for (auto& cs : colorspaces)
+        text += Strutil::fmt::format("cs {} {} {}\n", cs.flags(),
+                                     cs.canonical.size() ? cs.canonical : "-",
+                                     cs.name);
+    // Write to a temporary file and rename it, so that another process
+    // never reads a partial one.
+    std::string tmpname = Strutil::fmt::format(
+        "{}.{}", filename, Filesystem::unique_path("%%%%-%%%%"));
+    std::string err;
+    if (Filesystem::write_text_file(tmpname, text)
+        && !Filesystem::rename(tmpname, filename, err))
+        Filesystem::remove(tmpname, err);
+}
+
+
+
 const char*
 ColorConfig::Impl::IdentifyBuiltinColorSpace(const char* name) const
 {
@@ -825,17 +1001,14 @@ ColorConfig::Impl::init(string_view filename)
     DBG("OCIO config {} loaded in {:0.2f} seconds\n", filename, timer.lap());
 
     inventory();
-    // NOTE: inventory already does classify_by_name
-
-#if OCIO_VERSION_HEX >= MAKE_OCIO_VERSION_HEX(2, 3, 0)
-    DBG("\nIDENTIFY BUILTIN EQUIVALENTS\n");
-    identify_builtin_equivalents();  // OCIO 2.3+ only
-    DBG("OCIO 2.3+ builtin equivalents in {:0.2f} seconds\n", timer.lap());
-#endif
+    // NOTE: inventory already does classify_by_name. The more expensive
+    // classification waits until something asks about a color space, unless
+    // the cache remembers it from before.
+    if (read_cache())
+        DBG("OCIO config {} classification read from the cache\n", filename);
 
 #if 1
     for (auto&& cs : colorspaces) {
-        // examine(&cs);
         DBG("Color space '{}':\n", cs.name);
         if (cs.flags() & CSInfo::is_srgb)
             DBG("'{}' is srgb\n", cs.name);
@@ -1301,6 +1474,16 @@ ColorConfig::configname() const
 
 
 
+std::string
+ColorConfig::cacheid() const
+{
+    if (getImpl()->config_ && !disable_ocio)
+        return getImpl()->config_->getCacheID();
+    return "built-in";
+}
+
+
+
 string_view
 ColorConfig::resolve(string_view name) const
 {
@@ -1321,21 +1504,29 @@ ColorConfig::Impl::resolve(string_view name) const
     }
     // OCIO did not know this name as a color space, role, or alias.
 
-    // Maybe it's an informal alias of common names?
-    spin_rw_write_lock lock(m_mutex);
-    if (Strutil::iequals(name, "sRGB") && !srgb_alias.empty())
+    // Maybe it's an informal alias of common names? Those are only settled
+    // once every color space has been examined, after which they never
+    // change and so need no lock.
+    bool srgb     = Strutil::iequals(name, "sRGB");
+    bool lin_srgb = Strutil::iequals(name, "lin_srgb")
+                    || Strutil::iequals(name, "lin_rec709")
+                    || Strutil::iequals(name, "linear");
+    bool acescg       = Strutil::iequals(name, "ACEScg");
+    bool scene_linear = Strutil::iequals(name, "scene_linear");
+    bool rec709       = Strutil::iequals(name, "Rec709");
+    if (!(srgb || lin_srgb || acescg || scene_linear || rec709))
+        return name;
+    const_cast<Impl*>(this)->examine_all();
+    if (srgb && !srgb_alias.empty())
         return srgb_alias;
-    if ((Strutil::iequals(name, "lin_srgb")
-         || Strutil::iequals(name, "lin_rec709")
-         || Strutil::iequals(name, "linear"))
-        && lin_srgb_alias.size())
+    if (lin_srgb && lin_srgb_alias.size())
         return lin_srgb_alias;
-    if (Strutil::iequals(name, "ACEScg") && !ACEScg_alias.empty())
+    if (acescg && !ACEScg_alias.empty())
         return ACEScg_alias;
-    if (Strutil::iequals(name, "scene_linear") && !scene_linear_alias.empty()) {
+    if (scene_linear && !scene_linear_alias.empty()) {
         return scene_linear_alias;
     }
-    if (Strutil::iequals(name, "Rec709") && Rec709_alias.size())
+    if (rec709 && Rec709_alias.size())
         return Rec709_alias;
 
     return name;
@@ -1367,8 +1558,8 @@ ColorConfig::equivalent(string_view color_space1,
     // specific known color spaces) match, consider them equivalent.
     const int mask = CSInfo::is_srgb | CSInfo::is_lin_srgb | CSInfo::is_ACEScg
                      | CSInfo::is_Rec709;
-    const CSInfo* csi1 = getImpl()->find(color_space1);
-    const CSInfo* csi2 = getImpl()->find(color_space2);
+    const CSInfo* csi1 = getImpl()->examined(color_space1);
+    const CSInfo* csi2 = getImpl()->examined(color_space2);
     if (csi1 && csi2) {
         int flags1 = csi1->flags() & mask;
         int flags2 = csi2->flags() & mask;
@@ -1412,7 +1603,87 @@ ocio_bitdepth(TypeDesc type)
 
 
 
+namespace pvt {
+int imagebufalgo_colorconvert_lut3d(0);
+}
+
+
+
+// A 3D LUT sampling a color transform over the [0,1] cube of RGB values,
+// interpolated tetrahedrally. Alpha passes through unchanged.
+class ColorLut3D {
+public:
+    ColorLut3D(const ColorProcessor& processor, int size)
+        : m_size(size)
+        , m_grid(new simd::vfloat4[size_t(size) * size * size])
+    {
+        const float scale = 1.0f / float(size - 1);
+        simd::vfloat4* g  = m_grid.get();
+        for (int b = 0; b < size; ++b)
+            for (int gr = 0; gr < size; ++gr)
+                for (int r = 0; r < size; ++r, ++g)
+                    *g = simd::vfloat4(r * scale, gr * scale, b * scale, 1.0f);
+        const int n = size * size * size;
+        processor.apply((float*)m_grid.get(), n, 1, 4, sizeof(float),
+                        4 * sizeof(float), n * 4 * sizeof(float));
+    }
+
+    int size() const { return m_size; }
+
+    simd::vfloat4 lookup(const simd::vfloat4& rgba) const
+    {
+        using simd::vfloat4;
+        const int last = m_size - 1;
+        const float fr = OIIO::clamp(rgba[0], 0.0f, 1.0f) * last;
+        const float fg = OIIO::clamp(rgba[1], 0.0f, 1.0f) * last;
+        const float fb = OIIO::clamp(rgba[2], 0.0f, 1.0f) * last;
+        const int ir = std::min(int(fr), last - 1);
+        const int ig = std::min(int(fg), last - 1);
+        const int ib = std::min(int(fb), last - 1);
+        const float dr = fr - ir, dg = fg - ig, db = fb - ib;
+        const size_t sg = size_t(m_size), sb = sg * sg;
+        const vfloat4* c000 = &m_grid[ib * sb + ig * sg + ir];
+        const vfloat4 &c100 = c000[1], &c010 = c000[sg], &c001 = c000[sb];
+        const vfloat4 &c110 = c000[sg + 1], &c101 = c000[sb + 1];
+        const vfloat4 &c011 = c000[sb + sg], &c111 = c000[sb + sg + 1];
+        vfloat4 c = *c000;
+        if (dr > dg) {
+            if (dg > db)
+                c += dr * (c100 - c000[0]) + dg * (c110 - c100)
+                     + db * (c111 - c110);
+            else if (dr > db)
+                c += dr * (c100 - c000[0]) + db * (c101 - c100)
+                     + dg * (c111 - c101);
+            else
+                c += db * (c001 - c000[0]) + dr * (c101 - c001)
+                     + dg * (c111 - c101);
+        } else {
+            if (db > dg)
+                c += db * (c001 - c000[0]) + dg * (c011 - c001)
+                     + dr * (c111 - c011);
+            else if (db > dr)
+                c += dg * (c010 - c000[0]) + db * (c011 - c010)
+                     + dr * (c111 - c011);
+            else
+                c += dg * (c010 - c000[0]) + dr * (c110 - c010)
+                     + db * (c111 - c110);
+        }
+        return simd::vfloat4(c[0], c[1], c[2], rgba[3]);
+    }
+
+private:
+    int m_size;
+    std::unique_ptr<simd::vfloat4[]> m_grid;
+};
+
+
+
 // Custom ColorProcessor that wraps an OpenColorIO Processor.
+//
+// For colorconvert of uint8 and uint16 images, it also bakes the results
+// of the transform into tables the first time they are needed, which it
+// keeps for as long as it lives -- for processors in a ColorConfig's
+// cache, that's once per ColorProcCacheKey.
 class ColorProcessor_OCIO final : public ColorProcessor {
 public:
     ColorProcessor_OCIO(OCIO::ConstProcessorRcPtr p)
@@ -1437,9 +1708,53 @@ public:
         m_cpuproc->apply(pid);
     }
 
+    /// For a transform without channel crosstalk, return a table of the
+    /// transformed value of every uint8 or uint16 value (as it would be
+    /// converted to float), with the 4 channels of value i starting at
+    /// [4*i]. Return nullptr for other types.
+    const float* channel_table(TypeDesc type) const
+    {
+        if (type == TypeUInt8) {
+            std::call_once(m_table8_once,
+                           [&]() { m_table8 = make_table<uint8_t>(); });
+            return m_table8.get();
+        }
+        if (type == TypeUInt16) {
+            std::call_once(m_table16_once,
+                           [&]() { m_table16 = make_table<uint16_t>(); });
+            return m_table16.get();
+        }
+        return nullptr;
+    }
+
+    /// Return a 3D LUT of the transform with the given size per axis.
+    std::shared_ptr<const ColorLut3D> lut3d(int size) const
+    {
+        std::lock_guard<std::mutex> lock(m_lut_mutex);
+        if (!m_lut3d || m_lut3d->size() != size)
+            m_lut3d = std::make_shared<const ColorLut3D>(*this, size);
+        return m_lut3d;
+    }
+
 private:
     OCIO::ConstProcessorRcPtr m_p;
     OCIO::ConstCPUProcessorRcPtr m_cpuproc;
+    mutable std::once_flag m_table8_once, m_table16_once;
+    mutable std::unique_ptr<float[]> m_table8, m_table16;
+    mutable std::mutex m_lut_mutex;
+    mutable std::shared_ptr<const ColorLut3D> m_lut3d;
+
+    template<typename T> std::unique_ptr<float[]> make_table() const
+    {
+        const int n = int(std::numeric_limits<T>::max()) + 1;
+        std::unique_ptr<float[]> table(new float[4 * n]);
+        for (int i = 0; i < n; ++i)
+            for (int c = 0; c < 4; ++c)
+                table[4 * i + c] = convert_type<T, float>(T(i));
+        apply(table.get(), n, 1, 4, sizeof(float), 4 * sizeof(float),
+              n * 4 * sizeof(float));
+        return table;
+    }
 };
 
 
@@ -1449,6 +1764,48 @@ private:
 // built-in configs, so we don't need any of these secondary fallback
 // heuristics.
 
+// Apply the transfer function `func` (which must take a float, vfloat4, or
+// vfloat8) to the first three channels of each pixel. Scanlines of packed
+// float values are done 8 at a time.
+template<class Func>
+static void
+apply_transfer(float* data, int width, int height, int channels,
+               stride_t chanstride, stride_t xstride, stride_t ystride,
+               const Func& func)
+{
+    if (channels > 3)
+        channels = 3;
+    for (int y = 0; y < height; ++y) {
+        char* d = (char*)data + y * ystride;
+        if (chanstride == sizeof(float) && xstride == channels * chanstride) {
+            float* f = (float*)d;
+            int n = width * channels, i = 0;
+            for (; i + simd::vfloat8::elements <= n;
+                 i += simd::vfloat8::elements)
+                func(simd::vfloat8(f + i)).store(f + i);
+            if (i < n) {
+                simd::vfloat8 r;
+                r.load(f + i, n - i);
+                func(r).store(f + i, n - i);
+            }
+        } else if (channels == 3 && chanstride == sizeof(float)) {
+            for (int x = 0; x < width; ++x, d += xstride) {
+                simd::vfloat4 r;
+                r.load((float*)d, 3);
+                r = func(r);
+                r.store((float*)d, 3);
+            }
+        } else {
+            for (int x = 0; x < width; ++x, d += xstride) {
+                char* dc = d;
+                for (int c = 0; c < channels; ++c, dc += chanstride)
+                    *(float*)dc = func(*(float*)dc);
+            }
+        }
+    }
+}
+
+
 // ColorProcessor that hard-codes sRGB-to-linear
 class ColorProcessor_sRGB_to_linear final : public ColorProcessor {
 public:
@@ -1460,28 +1817,9 @@ public:
                stride_t chanstride, stride_t xstride,
                stride_t ystride) const override
     {
-        if (channels > 3)
-            channels = 3;
-        if (channels == 3 && chanstride == sizeof(float)) {
-            for (int y = 0; y < height; ++y) {
-                char* d = (char*)data + y * ystride;
-                for (int x = 0; x < width; ++x, d += xstride) {
-                    simd::vfloat4 r;
-                    r.load((float*)d, 3);
-                    r = sRGB_to_linear(r);
-                    r.store((float*)d, 3);
-                }
-            }
-        } else {
-            for (int y = 0; y < height; ++y) {
-                char* d = (char*)data + y * ystride;
-                for (int x = 0; x < width; ++x, d += xstride) {
-                    char* dc = d;
-                    for (int c = 0; c < channels; ++c, dc += chanstride)
-                        ((float*)dc)[c] = sRGB_to_linear(((float*)dc)[c]);
-                }
-            }
-        }
+        apply_transfer(data, width, height, channels, chanstride, xstride,
+                       ystride,
+                       [](const auto& x) { return sRGB_to_linear(x); });
     }
 };
 
@@ -1497,28 +1835,9 @@ public:
                stride_t chanstride, stride_t xstride,
                stride_t ystride) const override
     {
-        if (channels > 3)
-            channels = 3;
-        if (channels == 3 && chanstride == sizeof(float)) {
-            for (int y = 0; y < height; ++y) {
-                char* d = (char*)data + y * ystride;
-                for (int x = 0; x < width; ++x, d += xstride) {
-                    simd::vfloat4 r;
-                    r.load((float*)d, 3);
-                    r = linear_to_sRGB(r);
-                    r.store((float*)d, 3);
-                }
-            }
-        } else {
-            for (int y = 0; y < height; ++y) {
-                char* d = (char*)data + y * ystride;
-                for (int x = 0; x < width; ++x, d += xstride) {
-                    char* dc = d;
-                    for (int c = 0; c < channels; ++c, dc += chanstride)
-                        ((float*)dc)[c] = linear_to_sRGB(((float*)dc)[c]);
-                }
-            }
-        }
+        apply_transfer(data, width, height, channels, chanstride, xstride,
+                       ystride,
+                       [](const auto& x) { return linear_to_sRGB(x); });
     }
 };
 
@@ -1535,16 +1854,9 @@ public:
                stride_t chanstride, stride_t xstride,
                stride_t ystride) const override
     {
-        if (channels > 3)
-            channels = 3;
-        for (int y = 0; y < height; ++y) {
-            char* d = (char*)data + y * ystride;
-            for (int x = 0; x < width; ++x, d += xstride) {
-                char* dc = d;
-                for (int c = 0; c < channels; ++c, dc += chanstride)
-                    ((float*)d)[c] = Rec709_to_linear(((float*)d)[c]);
-            }
-        }
+        apply_transfer(data, width, height, channels, chanstride, xstride,
+                       ystride,
+                       [](const auto& x) { return Rec709_to_linear(x); });
     }
 };
 
@@ -1560,16 +1872,9 @@ public:
                stride_t chanstride, stride_t xstride,
                stride_t ystride) const override
     {
-        if (channels > 3)
-            channels = 3;
-        for (int y = 0; y < height; ++y) {
-            char* d = (char*)data + y * ystride;
-            for (int x = 0; x < width; ++x, d += xstride) {
-                char* dc = d;
-                for (int c = 0; c < channels; ++c, dc += chanstride)
-                    ((float*)d)[c] = linear_to_Rec709(((float*)d)[c]);
-            }
-        }
+        apply_transfer(data, width, height, channels, chanstride, xstride,
+                       ystride,
+                       [](const auto& x) { return linear_to_Rec709(x); });
     }
 };
 
@@ -1587,29 +1892,10 @@ public:
                stride_t chanstride, stride_t xstride,
                stride_t ystride) const override
     {
-        if (channels > 3)
-            channels = 3;
-        if (channels == 3 && chanstride == sizeof(float)) {
-            simd::vfloat4 g = m_gamma;
-            for (int y = 0; y < height; ++y) {
-                char* d = (char*)data + y * ystride;
-                for (int x = 0; x < width; ++x, d += xstride) {
-                    simd::vfloat4 r;
-                    r.load((float*)d, 3);
-                    r = fast_pow_pos(r, g);
-                    r.store((float*)d, 3);
-                }
-            }
-        } else {
-            for (int y = 0; y < height; ++y) {
-                char* d = (char*)data + y * ystride;
-                for (int x = 0; x < width; ++x, d += xstride) {
-                    char* dc = d;
-                    for (int c = 0; c < channels; ++c, dc += chanstride)
-                        ((float*)d)[c] = powf(((float*)d)[c], m_gamma);
-                }
-            }
-        }
+        float g = m_gamma;
+        apply_transfer(data, width, height, channels, chanstride, xstride,
+                       ystride,
+                       [g](const auto& x) { return fast_pow_pos(x, g); });
     }
 
 private:
@@ -2232,11 +2518,14 @@ ImageBufAlgo::colormatrixtransform(const ImageBuf& src, M44fParam M,
 
 
 
+// With a channel table or 3D LUT baked from the processor (only for uint8
+// or uint16 local source pixels that aren't unpremultiplied), look up the
+// transformed values rather than applying the processor.
 template<class Rtype, class Atype>
 static bool
 colorconvert_impl(ImageBuf& R, const ImageBuf& A,
                   const ColorProcessor* processor, bool unpremult, ROI roi,
-                  int nthreads)
+                  int nthreads, const float* table, const ColorLut3D* lut)
 {
     using namespace ImageBufAlgo;
     using namespace simd;
@@ -2249,7 +2538,7 @@ colorconvert_impl(ImageBuf& R, const ImageBuf& A,
     // clang-format off
     parallel_image(
         roi, paropt(nthreads),
-        [&, unpremult, channelsToCopy, processor](ROI roi) {
+        [&, unpremult, channelsToCopy, processor, table, lut](ROI roi) {
             int width = roi.width();
             // Temporary space to hold one RGBA scanline
             vfloat4* scanline;
@@ -2263,13 +2552,25 @@ colorconvert_impl(ImageBuf& R, const ImageBuf& A,
                 for (int j = roi.ybegin; j < roi.yend; ++j) {
                     // Load the scanline
                     a.rerange(roi.xbegin, roi.xend, j, j + 1, k, k + 1);
-                    for (int i = 0; !a.done(); ++a, ++i) {
-                        vfloat4 v(0.0f);
-                        for (int c = 0; c < channelsToCopy; ++c)
-                            v[c] = a[c];
-                        if (channelsToCopy == 1)
-                            v[2] = v[1] = v[0];
-                        scanline[i] = v;
+                    if (table) {
+                        for (int i = 0; !a.done(); ++a, ++i) {
+                            const Atype* p = (const Atype*)a.rawptr();
+                            vfloat4 v(0.0f);
+                            for (int c = 0; c < channelsToCopy; ++c) {
+                                size_t val = a.exists() ? size_t(p[c]) : 0;
+                                v[c]       = table[4 * val + c];
+                            }
+                            scanline[i] = v;
+                        }
+                    } else {
+                        for (int i = 0; !a.done(); ++a, ++i) {
+                            vfloat4 v(0.0f);
+                            for (int c = 0; c < channelsToCopy; ++c)
+                                v[c] = a[c];
+                            if (channelsToCopy == 1)
+                                v[2] = v[1] = v[0];
+                            scanline[i] = lut ? lut->lookup(v) : v;
+                        }
                     }
 
                     // Optionally unpremult. Be careful of alpha==0 pixels,
@@ -2284,9 +2585,10 @@ colorconvert_impl(ImageBuf& R, const ImageBuf& A,
                     }
 
                     // Apply the color transformation in place
-                    processor->apply((float*)&scanline[0], width, 1, 4,
-                                     sizeof(float), 4 * sizeof(float),
-                                     width * 4 * sizeof(float));
+                    if (!table && !lut)
+                        processor->apply((float*)&scanline[0], width, 1, 4,
+                                         sizeof(float), 4 * sizeof(float),
+                                         width * 4 * sizeof(float));
 
                     // Optionally re-premult. Be careful of alpha==0 pixels,
                     // preserve their value rather than crushing to black.
@@ -2423,15 +2725,33 @@ ImageBufAlgo::colorconvert(ImageBuf& dst, const ImageBuf& src,
 
     if (dst.localpixels() && src.localpixels() && dst.spec().format == TypeFloat
         && src.spec().format == TypeFloat && dst.nchannels() == 4
-        && src.nchannels() == 4) {
+        && src.nchannels() == 4 && dst.pixel_stride() == 4 * sizeof(float)
+        && src.pixel_stride() == 4 * sizeof(float)) {
         return colorconvert_impl_float_rgba(dst, src, processor, unpremult, roi,
                                             nthreads);
     }
 
+    // For uint8 and uint16 pixels, look up what an OCIO transform makes of
+    // them: exactly, in a table of its results for every value if it has
+    // no channel crosstalk, or approximately, in a 3D LUT if asked to.
+    const float* table = nullptr;
+    std::shared_ptr<const ColorLut3D> lut;
+    const TypeDesc srcformat = src.spec().format;
+    auto ocioproc = dynamic_cast<const ColorProcessor_OCIO*>(processor);
+    if (ocioproc && pvt::imagebufalgo_fastpaths && src.localpixels()
+        && (srcformat == TypeUInt8 || srcformat == TypeUInt16)
+        && !(unpremult && roi.nchannels() >= 4)) {
+        if (!ocioproc->hasChannelCrosstalk())
+            table = ocioproc->channel_table(srcformat);
+        else if (pvt::imagebufalgo_colorconvert_lut3d >= 2)
+            lut = ocioproc->lut3d(pvt::imagebufalgo_colorconvert_lut3d);
+    }
+
     bool ok = true;
     OIIO_DISPATCH_COMMON_TYPES2(ok, "colorconvert", colorconvert_impl,
-                                dst.spec().format, src.spec().format, dst, src,
-                                processor, unpremult, roi, nthreads);
+                                dst.spec().format, srcformat, dst, src,
+                                processor, unpremult, roi, nthreads, table,
+                                lut.get());
     return ok;
 }
 
@@ -2582,6 +2902,26 @@ ImageBufAlgo::ociofiletransform(ImageBuf& dst, const ImageBuf& src,
         dst.errorfmt("Unknown filetransform name");
         return false;
     }
+
+    // .cube files (by far the most common kind of LUT for previews) are
+    // applied directly, without waiting for OCIO to build a processor.
+    // Anything the parser doesn't understand falls back to OCIO.
+    if (pvt::imagebufalgo_fastpaths && !inverse
+        && Strutil::iends_with(name, ".cube") && Filesystem::is_regular(name)) {
+        ROI lutroi = roi.defined() ? roi : get_roi(src.spec());
+        std::string err;
+        std::shared_ptr<const pvt::ColorLUT> lut;
+        if (std::min(lutroi.chend, src.nchannels()) - lutroi.chbegin >= 3)
+            lut = pvt::ColorLUT::cube(std::string(name), err);
+        if (lut) {
+            bool ok = pvt::apply_color_lut(dst, src, *lut, unpremult, roi,
+                                           nthreads);
+            if (ok)
+                dst.specmod().set_colorspace(name);
+            return ok;
+        }
+    }
+
     ColorProcessorHandle processor;
     {
         if (!colorconfig)
@@ -2783,4 +3123,93 @@ set_colorspace_rec709_gamma(ImageSpec& spec, float gamma)
 }
 
 
+
+void
+pvt::WorkingColorConversion::set_working_colorspace(string_view name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_working == name)
+        return;
+    m_working = ustring(name);
+    m_filespace.clear();
+    m_processor.reset();
+    m_error.clear();
+}
+
+
+
+ColorProcessorHandle
+pvt::WorkingColorConversion::processor(string_view filespace, bool tofile,
+                                       std::string& err)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_working.empty() || filespace.empty())
+        return nullptr;
+    if (m_filespace != filespace || m_tofile != tofile) {
+        const ColorConfig& cc(ColorConfig::default_colorconfig());
+        m_filespace = ustring(filespace);
+        m_tofile    = tofile;
+        m_processor.reset();
+        m_error.clear();
+        if (!cc.equivalent(filespace, m_working)) {
+            ustring from = tofile ? m_working : m_filespace;
+            ustring to   = tofile ? m_filespace : m_working;
+            m_processor  = cc.createColorProcessor(cc.resolve(from),
+                                                   cc.resolve(to));
+            if (!m_processor)
+                m_error = Strutil::fmt::format(
+                    "Could not construct the color transform {} -> {}{}{}",
+                    from, to, cc.has_error() ? ": " : "", cc.geterror());
+            else if (m_processor->isNoOp())
+                m_processor.reset();
+        }
+    }
+    err = m_error;
+    return m_processor;
+}
+
+
+
+bool
+pvt::WorkingColorConversion::apply(string_view filespace, bool tofile,
+                                   int nchannels, int width, int height,
+                                   int depth, TypeDesc format, void* data,
+                                   stride_t xstride, stride_t ystride,
+                                   stride_t zstride, int nthreads,
+                                   std::string& err)
+{
+    if (!active())
+        return true;
+    ColorProcessorHandle cp = processor(filespace, tofile, err);
+    if (err.size())
+        return false;
+    return !cp
+           || convert(cp.get(), nchannels, width, height, depth, format, data,
+                      xstride, ystride, zstride, nthreads, err);
+}
+
+
+
+bool
+pvt::WorkingColorConversion::convert(const ColorProcessor* processor,
+                                     int nchannels, int width, int height,
+                                     int depth, TypeDesc format, void* data,
+                                     stride_t xstride, stride_t ystride,
+                                     stride_t zstride, int nthreads,
+                                     std::string& err)
+{
+    // Let colorconvert do the work, on an ImageBuf wrapping the pixels.
+    ImageSpec spec(width, height, nchannels, format);
+    spec.depth      = depth;
+    spec.full_depth = depth;
+    ImageBuf buf(spec, data, xstride, ystride, zstride);
+    if (!ImageBufAlgo::colorconvert(buf, buf, processor, false, {},
+                                    nthreads)) {
+        err = buf.geterror();
+        return false;
+    }
+    return true;
+}
+
+
 OIIO_NAMESPACE_END
@@ -87,12 +87,68 @@ test_sRGB_conversion()
     bench("sRGB_to_linear",
           [&]() { return DoNotOptimize(sRGB_to_linear(fval)); });
     bench("linear_to_sRGB",
-          [&]() { return DoNotOptimize(sRGB_to_linear(fval)); });
+          [&]() { return DoNotOptimize(linear_to_sRGB(fval)); });
     bench.work(4);
     bench("sRGB_to_linear simd",
           [&]() { return DoNotOptimize(sRGB_to_linear(vfval)); });
     bench("linear_to_sRGB simd",
-          [&]() { return DoNotOptimize(sRGB_to_linear(vfval)); });
+          [&]() { return DoNotOptimize(linear_to_sRGB(vfval)); });
+    vfloat8 v8val(fval);
+    clobber(v8val);
+    bench.work(8);
+    bench("sRGB_to_linear vfloat8",
+          [&]() { return DoNotOptimize(sRGB_to_linear(v8val)); });
+    bench("linear_to_sRGB vfloat8",
+          [&]() { return DoNotOptimize(linear_to_sRGB(v8val)); });
+}
+
+
+
+// The SIMD transfer functions must be exact at 0 and 1, and within their
+// documented error of the exact functions everywhere between.
+template<typename VF>
+static void
+test_simd_transfer()
+{
+    std::cout << "Testing SIMD transfer functions for " << VF::type_name()
+              << "\n";
+    const VF zero(0.0f), one(1.0f);
+    OIIO_CHECK_SIMD_EQUAL(sRGB_to_linear(zero), zero);
+    OIIO_CHECK_SIMD_EQUAL(sRGB_to_linear(one), one);
+    OIIO_CHECK_SIMD_EQUAL(linear_to_sRGB(zero), zero);
+    OIIO_CHECK_SIMD_EQUAL(linear_to_sRGB(one), one);
+    OIIO_CHECK_SIMD_EQUAL(Rec709_to_linear(zero), zero);
+    OIIO_CHECK_SIMD_EQUAL(Rec709_to_linear(one), one);
+    OIIO_CHECK_SIMD_EQUAL(linear_to_Rec709(zero), zero);
+    OIIO_CHECK_SIMD_EQUAL(linear_to_Rec709(one), one);
+
+    float err[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const int n  = 1 << 16;
+    for (int i = 0; i <= n; i += VF::elements) {
+        VF x = (VF::Iota(float(i)) / float(n));
+        x    = min(x, one);
+        VF r[4] = { sRGB_to_linear(x), linear_to_sRGB(x),
+                    Rec709_to_linear(x), linear_to_Rec709(x) };
+        for (int j = 0; j < VF::elements; ++j) {
+            double xd     = x[j];
+            double e[4]   = { xd <= 0.04045 ? xd / 12.92
+                                            : pow((xd + 0.055) / 1.055, 2.4),
+                              x[j] <= 0.0031308f
+                                  ? 12.92 * xd
+                                  : 1.055 * pow(xd, 1.0 / 2.4) - 0.055,
+                              x[j] < 0.081f ? xd / 4.5
+                                            : pow((xd + 0.099) / 1.099,
+                                                  1.0 / 0.45),
+                              x[j] < 0.018f ? 4.5 * xd
+                                            : 1.099 * pow(xd, 0.45) - 0.099 };
+            for (int f = 0; f < 4; ++f)
+                err[f] = std::max(err[f], float(fabs(r[f][j] - e[f])));
+        }
+    }
+    OIIO_CHECK_LE(err[0], 7.0e-6f);
+    OIIO_CHECK_LE(err[1], 7.5e-6f);
+    OIIO_CHECK_LE(err[2], 7.0e-6f);
+    OIIO_CHECK_LE(err[3], 8.0e-6f);
 }
 
 
@@ -134,6 +190,9 @@ main(int argc, char* argv[])
     getargs(argc, argv);
 
     test_sRGB_conversion();
+    test_simd_transfer<vfloat4>();
+    test_simd_transfer<vfloat8>();
+    test_simd_transfer<vfloat16>();
     test_Rec709_conversion();
 
     return unit_test_failures != 0;
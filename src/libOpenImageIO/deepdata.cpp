@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <numeric>
 
 #include <OpenImageIO/half.h>
@@ -13,11 +14,18 @@
 #include <OpenImageIO/deepdata.h>
 #include <OpenImageIO/fmath.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/thread.h>
 
+#include "imageio_pvt.h"
+
 OIIO_NAMESPACE_BEGIN
 
+namespace pvt {
+int deepdata_pool_MB(0);
+}
+
 
 // Each pixel has a capacity (number of samples allocated) and a number of
 // samples currently used. Erasing samples only reduces the samples in the
@@ -30,6 +38,120 @@ OIIO_NAMESPACE_BEGIN
 // data, simultaneously, as long as they are working on separate pixels.
 
 
+namespace {
+
+// An allocator whose resize() leaves new chars uninitialized, so that the
+// (possibly huge) sample data can be cleared in parallel instead.
+template<typename T> struct default_init_allocator : std::allocator<T> {
+    template<typename U> struct rebind {
+        using other = default_init_allocator<U>;
+    };
+    default_init_allocator() = default;
+    template<typename U>
+    default_init_allocator(const default_init_allocator<U>&) noexcept
+    {
+    }
+    template<typename U> void construct(U* p) noexcept
+    {
+        ::new (static_cast<void*>(p)) U;
+    }
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args)
+    {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+using SampleData = std::vector<char, default_init_allocator<char>>;
+
+
+
+// A process-wide pool of the sample buffers of freed DeepData, for the next
+// DeepData needing about as much to reuse, rather than going back to the
+// heap (and the system) for it. It holds at most "deepdata:pool_MB" of
+// them, evicting the oldest first.
+class SampleDataPool {
+public:
+    // Smaller buffers are cheap enough to get from the heap.
+    static const size_t min_size = size_t(256) << 10;
+
+    // If there's a pooled buffer big enough for `size` bytes, but not more
+    // than 12.5% bigger, swap it into `data`.
+    void take(SampleData& data, size_t size)
+    {
+        if (size < min_size || data.capacity() >= size)
+            return;
+        spin_lock lock(m_mutex);
+        for (size_t i = m_free.size(); i-- > 0;) {
+            size_t cap = m_free[i].capacity();
+            if (cap >= size && cap - size <= size / 8) {
+                data.swap(m_free[i]);
+                m_free.erase(m_free.begin() + i);
+                m_total -= cap;
+                return;
+            }
+        }
+    }
+
+    // Keep the buffer of `data` (leaving it empty), if the pool is on.
+    void give(SampleData& data)
+    {
+        if (pvt::deepdata_pool_MB <= 0 || data.capacity() < min_size)
+            return;
+        {
+            spin_lock lock(m_mutex);
+            m_total += data.capacity();
+            m_free.emplace_back();
+            m_free.back().swap(data);
+        }
+        trim();
+    }
+
+    // Free the oldest buffers until the pool is within its limit.
+    void trim()
+    {
+        size_t limit = size_t(std::max(pvt::deepdata_pool_MB, 0)) << 20;
+        std::vector<SampleData> evicted;
+        {
+            spin_lock lock(m_mutex);
+            size_t n = 0;
+            for (; n < m_free.size() && m_total > limit; ++n) {
+                m_total -= m_free[n].capacity();
+                evicted.emplace_back();
+                evicted.back().swap(m_free[n]);
+            }
+            m_free.erase(m_free.begin(), m_free.begin() + n);
+        }
+        // The evicted buffers are freed here, outside the lock
+    }
+
+private:
+    spin_mutex m_mutex;
+    std::vector<SampleData> m_free;  ///< Oldest first
+    size_t m_total = 0;              ///< Total capacity of m_free
+};
+
+
+
+// Never destroyed, since DeepData with static lifetimes may outlive it.
+SampleDataPool&
+sample_data_pool()
+{
+    static SampleDataPool* pool = new SampleDataPool;
+    return *pool;
+}
+
+}  // namespace
+
+
+
+void
+pvt::deepdata_pool_trim()
+{
+    sample_data_pool().trim();
+}
+
+
 
 class DeepData::Impl {  // holds all the nontrivial stuff
     friend class DeepData;
@@ -40,15 +162,15 @@ public:
     std::vector<size_t> m_channeloffsets;  // for each channel [c]
     std::vector<unsigned int> m_nsamples;  // for each pixel [p]
     std::vector<unsigned int> m_capacity;  // for each pixel [p]
-    std::vector<unsigned int>
-        m_cumcapacity;         // cumulative capacity before pixel [p]
-    std::vector<char> m_data;  // for each sample [p][s][c]
+    std::vector<size_t> m_cumcapacity;  // cumulative capacity before pixel [p]
+    SampleData m_data;                        // for each sample [p][s][c]
     std::vector<std::string> m_channelnames;  // For each channel[c]
     std::vector<int> m_myalphachannel;        // For each channel[c], its alpha
         // myalphachannel[c] gives the alpha channel corresponding to channel
         // c, or c if it is itself an alpha, or -1 if it doesn't appear to
         // be a color channel at all.
     size_t m_samplesize;
+    size_t m_reserve;  // Total samples to make room for when allocating
     int m_z_channel, m_zback_channel;
     int m_alpha_channel;
     int m_AR_channel;
@@ -56,6 +178,14 @@ public:
     int m_AB_channel;
     bool m_allocated;
     spin_mutex m_mutex;
+    // The bytes of m_data counted in pvt::DD_mem_current. It isn't copied
+    // along with the rest, since each Impl counts its own.
+    struct Counted {
+        size_t bytes = 0;
+        Counted() {}
+        Counted(const Counted&) {}
+        Counted& operator=(const Counted&) { return *this; }
+    } m_counted;
 
     Impl()
         : m_allocated(false)
@@ -63,6 +193,24 @@ public:
         clear();
     }
 
+    ~Impl()
+    {
+        sample_data_pool().give(m_data);
+        m_data = SampleData();
+        count_memory();
+    }
+
+    // Bring pvt::DD_mem_current up to date with the size of m_data.
+    void count_memory()
+    {
+        size_t bytes = m_data.capacity();
+        if (bytes != m_counted.bytes) {
+            pvt::DD_mem_current += (long long)bytes
+                                   - (long long)m_counted.bytes;
+            m_counted.bytes = bytes;
+        }
+    }
+
     void clear()
     {
         m_channeltypes.clear();
@@ -75,6 +223,7 @@ public:
         m_channelnames.clear();
         m_myalphachannel.clear();
         m_samplesize    = 0;
+        m_reserve       = 0;
         m_z_channel     = -1;
         m_zback_channel = -1;
         m_alpha_channel = -1;
@@ -90,13 +239,41 @@ public:
         if (!m_allocated) {
             spin_lock lock(m_mutex);
             if (!m_allocated) {
-                // m_cumcapacity.resize (npixels);
-                size_t totalcapacity = 0;
-                for (size_t i = 0; i < npixels; ++i) {
-                    m_cumcapacity[i] = totalcapacity;
-                    totalcapacity += m_capacity[i];
-                }
+                // Deep images may have billions of samples, so both the
+                // prefix sum and clearing the data are done in parallel:
+                // each block of pixels sums its capacities, the block sums
+                // are summed in turn, and then each block fills in its part
+                // of the prefix sum and clears its samples.
+                const size_t blocksize = 1 << 16;
+                size_t nblocks         = (npixels + blocksize - 1) / blocksize;
+                std::vector<size_t> blockstart(nblocks + 1, 0);
+                parallel_for(int64_t(0), int64_t(nblocks), [&](int64_t b) {
+                    size_t end = std::min(npixels, size_t(b + 1) * blocksize);
+                    size_t sum = 0;
+                    for (size_t i = b * blocksize; i < end; ++i)
+                        sum += m_capacity[i];
+                    blockstart[b + 1] = sum;
+                });
+                for (size_t b = 0; b < nblocks; ++b)
+                    blockstart[b + 1] += blockstart[b];
+                size_t totalcapacity = blockstart[nblocks];
+                size_t reserve = std::max(totalcapacity, m_reserve)
+                                 * m_samplesize;
+                pvt::memory_budget_reserve(reserve);
+                sample_data_pool().take(m_data, reserve);
+                m_data.reserve(reserve);
                 m_data.resize(totalcapacity * m_samplesize);
+                parallel_for(int64_t(0), int64_t(nblocks), [&](int64_t b) {
+                    size_t end  = std::min(npixels, size_t(b + 1) * blocksize);
+                    size_t curr = blockstart[b];
+                    for (size_t i = b * blocksize; i < end; ++i) {
+                        m_cumcapacity[i] = curr;
+                        curr += m_capacity[i];
+                    }
+                    memset(m_data.data() + blockstart[b] * m_samplesize, 0,
+                           (curr - blockstart[b]) * m_samplesize);
+                });
+                count_memory();
                 m_allocated = true;
             }
         }
@@ -173,6 +350,7 @@ DeepData::DeepData(const DeepData& src)
     if (src.m_impl) {
         m_impl  = new Impl;
         *m_impl = *(src.m_impl);
+        m_impl->count_memory();
     }
 }
 
@@ -224,6 +402,7 @@ DeepData::operator=(const DeepData& d)
             *m_impl = *(d.m_impl);
         else
             m_impl->clear();
+        m_impl->count_memory();
     }
     return *this;
 }
@@ -514,7 +693,7 @@ DeepData::set_capacity(int64_t pixel, int samps)
             int toadd = samps - n;
             if (m_impl->m_data.empty()) {
                 size_t newtotal = (m_impl->total_capacity() + toadd);
-                m_impl->m_data.resize(newtotal * samplesize());
+                m_impl->m_data.resize(newtotal * samplesize(), 0);
             } else {
                 size_t offset = m_impl->data_offset(pixel, 0, n);
                 m_impl->m_data.insert(m_impl->m_data.begin() + offset,
@@ -524,6 +703,7 @@ DeepData::set_capacity(int64_t pixel, int samps)
             for (int64_t p = pixel + 1; p < m_npixels; ++p)
                 m_impl->m_cumcapacity[p] += toadd;
             m_impl->m_capacity[pixel] = samps;
+            m_impl->count_memory();
         }
     } else {
         m_impl->m_capacity[pixel] = samps;
@@ -532,6 +712,58 @@ DeepData::set_capacity(int64_t pixel, int samps)
 
 
 
+void
+DeepData::set_all_capacity(cspan<unsigned int> capacity)
+{
+    if (std::ssize(capacity) != m_npixels)
+        return;
+    OIIO_DASSERT(m_impl);
+    spin_lock lock(m_impl->m_mutex);
+    Impl& impl(*m_impl);
+    if (!impl.m_allocated) {
+        for (int64_t p = 0; p < m_npixels; ++p)
+            impl.m_capacity[p] = std::max(capacity[p], impl.m_nsamples[p]);
+        return;
+    }
+    // Lay out the pixels anew, with each capacity expanded if necessary
+    // (but not contracted). The pixels only move toward the end, so moving
+    // them from the last to the first moves each pixel's samples just once.
+    std::vector<size_t> cumcapacity(m_npixels);
+    size_t total = 0;
+    for (int64_t p = 0; p < m_npixels; ++p) {
+        cumcapacity[p] = total;
+        total += std::max(capacity[p], impl.m_capacity[p]);
+    }
+    size_t samplebytes = impl.m_samplesize;
+    impl.m_data.resize(total * samplebytes);
+    for (int64_t p = m_npixels - 1; p >= 0; --p) {
+        if (cumcapacity[p] != impl.m_cumcapacity[p] && impl.m_nsamples[p])
+            memmove(&impl.m_data[cumcapacity[p] * samplebytes],
+                    &impl.m_data[impl.m_cumcapacity[p] * samplebytes],
+                    impl.m_nsamples[p] * samplebytes);
+        impl.m_capacity[p] = std::max(capacity[p], impl.m_capacity[p]);
+    }
+    impl.m_cumcapacity.swap(cumcapacity);
+    impl.count_memory();
+}
+
+
+
+void
+DeepData::reserve(size_t nsamples)
+{
+    if (!m_impl)
+        return;
+    spin_lock lock(m_impl->m_mutex);
+    m_impl->m_reserve = nsamples;
+    if (m_impl->m_allocated) {
+        m_impl->m_data.reserve(nsamples * m_impl->m_samplesize);
+        m_impl->count_memory();
+    }
+}
+
+
+
 int
 DeepData::samples(int64_t pixel) const
 {
@@ -732,6 +964,37 @@ DeepData::deep_value_uint(int64_t pixel, int channel, int sample) const
 
 
 
+int
+DeepData::deep_values(int64_t pixel, int channel, span<float> values) const
+{
+    if (pixel < 0 || pixel >= m_npixels || channel < 0 || channel >= m_nchannels
+        || !m_impl || !m_impl->m_data.size())
+        return 0;
+    int n = std::min(int(m_impl->m_nsamples[pixel]), int(values.size()));
+    if (n <= 0)
+        return 0;
+    // Dispatch on the type once for all the samples, rather than per sample
+    const char* ptr = (const char*)m_impl->data_ptr(pixel, channel, 0);
+    size_t stride   = m_impl->m_samplesize;
+    switch (channeltype(channel).basetype) {
+    case TypeDesc::FLOAT:
+        for (int s = 0; s < n; ++s, ptr += stride)
+            values[s] = *(const float*)ptr;
+        break;
+    case TypeDesc::HALF:
+        for (int s = 0; s < n; ++s, ptr += stride)
+            values[s] = *(const half*)ptr;
+        break;
+    default:
+        for (int s = 0; s < n; ++s)
+            values[s] = deep_value(pixel, channel, s);
+        break;
+    }
+    return n;
+}
+
+
+
 void
 DeepData::set_deep_value(int64_t pixel, int channel, int sample, float value)
 {
@@ -1027,35 +1290,28 @@ DeepData::split(int64_t pixel, float depth)
 
 namespace {
 
-// Comparator functor for depth sorting sample indices of a deep pixel.
+// Comparator functor for depth sorting sample indices of a deep pixel,
+// given the z and zback of all its samples.
 class SampleComparator {
 public:
-    SampleComparator(const DeepData& dd, int pixel, int zchan, int zbackchan)
-        : deepdata(dd)
-        , pixel(pixel)
-        , zchan(zchan)
-        , zbackchan(zbackchan)
+    SampleComparator(const float* z, const float* zback)
+        : z(z)
+        , zback(zback)
     {
     }
     bool operator()(int i, int j) const
     {
         // If either has a lower z, that's the lower
-        float iz = deepdata.deep_value(pixel, zchan, i);
-        float jz = deepdata.deep_value(pixel, zchan, j);
-        if (iz < jz)
+        if (z[i] < z[j])
             return true;
-        if (iz > jz)
+        if (z[i] > z[j])
             return false;
         // If both z's are equal, sort based on zback
-        float izb = deepdata.deep_value(pixel, zbackchan, i);
-        float jzb = deepdata.deep_value(pixel, zbackchan, j);
-        return izb < jzb;
+        return zback[i] < zback[j];
     }
 
 private:
-    const DeepData& deepdata;
-    int pixel;
-    int zchan, zbackchan;
+    const float *z, *zback;
 };
 
 }  // namespace
@@ -1078,10 +1334,15 @@ DeepData::sort(int64_t pixel)
     // Ick, std::sort and friends take a custom comparator, but not a custom
     // swapper, so there's no way to std::sort a data type whose size is not
     // known at compile time. So we just sort the indices!
+    // The comparisons only need the depths, so gather those first.
+    span<float> z     = OIIO_ALLOCA_SPAN(float, nsamples);
+    span<float> zback = OIIO_ALLOCA_SPAN(float, nsamples);
+    deep_values(pixel, zchan, z);
+    deep_values(pixel, zbackchan, zback);
     int* sample_indices = OIIO_ALLOCA(int, nsamples);
     std::iota(sample_indices, sample_indices + nsamples, 0);
     std::stable_sort(sample_indices, sample_indices + nsamples,
-                     SampleComparator(*this, pixel, zchan, zbackchan));
+                     SampleComparator(z.data(), zback.data()));
 
     // Now copy around using a temp buffer
     size_t samplebytes = samplesize();
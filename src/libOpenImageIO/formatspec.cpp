@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <regex>
@@ -1216,6 +1217,256 @@ ImageSpec::from_xml(const char* xml)
 
 
 
+namespace {  // anonymous
+
+// The binary form of an ImageSpec starts with these four bytes and a
+// version number, and everything in it is little-endian.
+static const char binary_magic[4] = { 'O', 'I', 'S', 'B' };
+static const uint32_t binary_version = 1;
+
+class BinaryWriter {
+public:
+    explicit BinaryWriter(std::string& out)
+        : m_out(out)
+    {
+    }
+    template<typename T> void put(T v)
+    {
+        if (bigendian())
+            swap_endian(&v);
+        m_out.append((const char*)&v, sizeof(v));
+    }
+    void put_string(string_view s)
+    {
+        put(uint32_t(s.size()));
+        m_out.append(s.data(), s.size());
+    }
+    void put_type(TypeDesc t)
+    {
+        put(uint8_t(t.basetype));
+        put(uint8_t(t.aggregate));
+        put(uint8_t(t.vecsemantics));
+        put(int32_t(t.arraylen));
+    }
+    // Values of `elemsize` bytes each
+    void put_values(const void* data, size_t bytes, size_t elemsize)
+    {
+        size_t start = m_out.size();
+        m_out.append((const char*)data, bytes);
+        if (bigendian() && elemsize > 1) {
+            char* p = &m_out[start];
+            for (size_t i = 0; i + elemsize <= bytes; i += elemsize)
+                std::reverse(p + i, p + i + elemsize);
+        }
+    }
+
+private:
+    std::string& m_out;
+};
+
+
+// Bounds-checked reading of what BinaryWriter wrote. Once anything fails
+// to be read, ok() is false and everything else read is 0 or empty.
+class BinaryReader {
+public:
+    explicit BinaryReader(string_view data)
+        : m_data(data)
+    {
+    }
+    bool ok() const { return m_ok; }
+    size_t remaining() const { return m_data.size(); }
+    template<typename T> T get()
+    {
+        T v = 0;
+        if (!take(sizeof(v)))
+            return v;
+        memcpy(&v, m_data.data() - sizeof(v), sizeof(v));
+        if (bigendian())
+            swap_endian(&v);
+        return v;
+    }
+    string_view get_string()
+    {
+        size_t len = get<uint32_t>();
+        if (!take(len))
+            return string_view();
+        return string_view(m_data.data() - len, len);
+    }
+    TypeDesc get_type()
+    {
+        int basetype     = get<uint8_t>();
+        int aggregate    = get<uint8_t>();
+        int vecsemantics = get<uint8_t>();
+        int arraylen     = get<int32_t>();
+        if (basetype >= TypeDesc::LASTBASE
+            || (aggregate != 1 && aggregate != 2 && aggregate != 3
+                && aggregate != 4 && aggregate != 9 && aggregate != 16)
+            || arraylen < -1)
+            m_ok = false;
+        if (!m_ok)
+            return TypeUnknown;
+        return TypeDesc(TypeDesc::BASETYPE(basetype),
+                        TypeDesc::AGGREGATE(aggregate),
+                        TypeDesc::VECSEMANTICS(vecsemantics), arraylen);
+    }
+    bool get_values(void* data, size_t bytes, size_t elemsize)
+    {
+        if (!take(bytes))
+            return false;
+        memcpy(data, m_data.data() - bytes, bytes);
+        if (bigendian() && elemsize > 1) {
+            char* p = (char*)data;
+            for (size_t i = 0; i + elemsize <= bytes; i += elemsize)
+                std::reverse(p + i, p + i + elemsize);
+        }
+        return true;
+    }
+
+private:
+    string_view m_data;
+    bool m_ok = true;
+
+    bool take(size_t bytes)
+    {
+        if (!m_ok || bytes > m_data.size()) {
+            m_ok = false;
+            return false;
+        }
+        m_data.remove_prefix(bytes);
+        return true;
+    }
+};
+
+}  // namespace
+
+
+
+std::string
+ImageSpec::to_binary() const
+{
+    std::string out;
+    out.reserve(256 + 64 * extra_attribs.size());
+    BinaryWriter w(out);
+    out.append(binary_magic, sizeof(binary_magic));
+    w.put(binary_version);
+    for (int v : { x, y, z, width, height, depth, full_x, full_y, full_z,
+                   full_width, full_height, full_depth, tile_width,
+                   tile_height, tile_depth, nchannels, alpha_channel,
+                   z_channel, int(deep) })
+        w.put(int32_t(v));
+    w.put_type(format);
+    w.put(uint32_t(channelformats.size()));
+    for (auto t : channelformats)
+        w.put_type(t);
+    w.put(uint32_t(channelnames.size()));
+    for (auto& name : channelnames)
+        w.put_string(name);
+
+    w.put(uint32_t(extra_attribs.size()));
+    for (auto& p : extra_attribs) {
+        TypeDesc t = p.type();
+        w.put_string(p.name());
+        w.put_type(t);
+        w.put(int32_t(p.nvalues()));
+        w.put(uint8_t(p.interp()));
+        // Strings are stored as their characters, not their pointers or
+        // hashes, which are only meaningful to this process.
+        size_t n = size_t(p.nvalues()) * t.basevalues();
+        if (t.basetype == TypeDesc::STRING) {
+            for (size_t i = 0; i < n; ++i)
+                w.put_string(((const ustring*)p.data())[i]);
+        } else if (t.basetype == TypeDesc::USTRINGHASH) {
+            for (size_t i = 0; i < n; ++i)
+                w.put_string(((const ustringhash*)p.data())[i].string());
+        } else {
+            w.put_values(p.data(), t.size() * p.nvalues(), t.basesize());
+        }
+    }
+    return out;
+}
+
+
+
+bool
+ImageSpec::from_binary(string_view data)
+{
+    if (data.size() < sizeof(binary_magic)
+        || memcmp(data.data(), binary_magic, sizeof(binary_magic)))
+        return false;
+    BinaryReader r(data.substr(sizeof(binary_magic)));
+    if (r.get<uint32_t>() != binary_version)
+        return false;
+
+    ImageSpec spec;
+    for (int* v : { &spec.x, &spec.y, &spec.z, &spec.width, &spec.height,
+                    &spec.depth, &spec.full_x, &spec.full_y, &spec.full_z,
+                    &spec.full_width, &spec.full_height, &spec.full_depth,
+                    &spec.tile_width, &spec.tile_height, &spec.tile_depth,
+                    &spec.nchannels, &spec.alpha_channel, &spec.z_channel })
+        *v = r.get<int32_t>();
+    spec.deep   = r.get<int32_t>() != 0;
+    spec.format = r.get_type();
+    // Each type or string takes at least 4 bytes, which bounds the counts
+    // of them that a truncated or corrupt spec could claim.
+    size_t n = r.get<uint32_t>();
+    if (n > r.remaining() / 4)
+        return false;
+    spec.channelformats.resize(n);
+    for (auto& t : spec.channelformats)
+        t = r.get_type();
+    n = r.get<uint32_t>();
+    if (n > r.remaining() / 4)
+        return false;
+    spec.channelnames.resize(n);
+    for (auto& name : spec.channelnames)
+        name = r.get_string();
+
+    n = r.get<uint32_t>();
+    if (n > r.remaining() / 4)
+        return false;
+    spec.extra_attribs.reserve(n);
+    std::vector<ustring> strings;
+    std::vector<ustringhash> hashes;
+    std::vector<char> values;
+    for (size_t a = 0; a < n && r.ok(); ++a) {
+        string_view name = r.get_string();
+        TypeDesc t       = r.get_type();
+        int nvalues      = r.get<int32_t>();
+        auto interp      = ParamValue::Interp(r.get<uint8_t>());
+        // Values take no more memory than twice their size in the data (a
+        // string's pointer, vs. its length and characters).
+        if (!r.ok() || nvalues < 0
+            || t.size() * size_t(nvalues) > r.remaining() * 2)
+            return false;
+        size_t nbase     = size_t(nvalues) * t.basevalues();
+        const void* vals = nullptr;
+        if (t.basetype == TypeDesc::STRING
+            || t.basetype == TypeDesc::USTRINGHASH) {
+            strings.resize(nbase);
+            for (auto& str : strings)
+                str = ustring(r.get_string());
+            vals = strings.data();
+            if (t.basetype == TypeDesc::USTRINGHASH) {
+                hashes.assign(strings.begin(), strings.end());
+                vals = hashes.data();
+            }
+        } else {
+            values.resize(t.size() * nvalues);
+            r.get_values(values.data(), values.size(), t.basesize());
+            vals = values.data();
+        }
+        if (!r.ok())
+            return false;
+        spec.extra_attribs.emplace_back(name, t, nvalues, interp, vals);
+    }
+    if (!r.ok())
+        return false;
+    *this = std::move(spec);
+    return true;
+}
+
+
+
 std::pair<string_view, int>
 ImageSpec::decode_compression_metadata(string_view defaultcomp,
                                        int defaultqual) const
@@ -1253,6 +1504,7 @@ pvt::check_texture_metadata_sanity(ImageSpec& spec)
         spec.erase_attribute("oiio::ConstantColor");
         spec.erase_attribute("oiio::AverageColor");
         spec.erase_attribute("oiio:SHA-1");
+        spec.erase_attribute("oiio:ContentHash");
         return true;
     }
     return false;
@@ -3,8 +3,17 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <atomic>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#    include <windows.h>
+#elif defined(__linux__)
+#    include <sys/mman.h>
+#endif
 
 #include <OpenImageIO/half.h>
 
@@ -22,6 +31,7 @@
 #include <OpenImageIO/thread.h>
 
 #include "imageio_pvt.h"
+#include "oiio_gpu_prv.h"
 
 OIIO_NAMESPACE_BEGIN
 
@@ -33,12 +43,255 @@ int imagebuf_print_uncaught_errors(1);
 int imagebuf_use_imagecache(0);
 atomic_ll IB_local_mem_current;
 atomic_ll IB_local_mem_peak;
+int imagebuf_pool_MB(0);
+int imagebuf_hugepages(0);
+int imagebuf_scanline_alignment(0);
+int imagebuf_pad_scanlines(0);
+int imagebuf_copy_on_write(0);
+atomic_ll IB_pool_mem_current;
 std::atomic<float> IB_total_open_time(0.0f);
 std::atomic<float> IB_total_image_read_time(0.0f);
 }  // namespace pvt
 
 
 
+// Add the time taken by a read to the statistics, and to the metrics if
+// they're being collected.
+static void
+add_image_read_time(double seconds)
+{
+    atomic_fetch_add(pvt::IB_total_image_read_time, float(seconds));
+    if (Metrics::enabled()) {
+        static Metrics::Histogram& hist(
+            Metrics::histogram("oiio_imagebuf_read_seconds",
+                               "Duration of ImageBuf reads of whole images"));
+        hist.record(seconds);
+    }
+}
+
+
+
+// The deleter of ImageBufImpl::m_pixels, which frees each buffer the way
+// it was allocated, or gives it back to the pool, once the last ImageBuf
+// sharing it lets go of it.
+struct ImageBufPixelsDeleter {
+    size_t size    = 0;      ///< Size of a big buffer, 0 if from new[]
+    size_t counted = 0;      ///< Bytes counted in IB_local_mem_current
+    bool pooled    = false;  ///< Return it to the pool?
+    bool large     = false;  ///< Windows large pages
+    void operator()(char* pixels) const;
+};
+
+
+
+namespace {
+
+static const size_t hugepage_size = size_t(2) << 20;
+
+// Allocate a big pixel buffer aligned to `align` bytes, or to huge pages,
+// if asked to use them, so that the system can back it with them. Throw
+// std::bad_alloc upon failure.
+char*
+alloc_big_pixels(size_t size, size_t align, bool& large)
+{
+    large     = false;
+    bool huge = pvt::imagebuf_hugepages && size >= hugepage_size;
+#ifdef _WIN32
+    // Large pages need the "lock pages in memory" privilege, and are
+    // simply unavailable without it.
+    size_t largepage = huge ? GetLargePageMinimum() : 0;
+    if (largepage) {
+        void* p = VirtualAlloc(nullptr, round_to_multiple(size, largepage),
+                               MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES,
+                               PAGE_READWRITE);
+        if (p) {
+            large = true;
+            return (char*)p;
+        }
+    }
+#endif
+    align   = std::max(align, huge ? hugepage_size : size_t(64));
+    char* p = (char*)aligned_malloc(size, align);
+    if (!p)
+        throw std::bad_alloc();
+#ifdef __linux__
+    if (huge)
+        madvise(p, size, MADV_HUGEPAGE);
+#endif
+    return p;
+}
+
+
+
+void
+free_big_pixels(char* pixels, bool large)
+{
+#ifdef _WIN32
+    if (large) {
+        VirtualFree(pixels, 0, MEM_RELEASE);
+        return;
+    }
+#endif
+    aligned_free(pixels);
+}
+
+
+
+// A process-wide pool of the pixel buffers of freed ImageBufs, for the
+// next ImageBuf of about the same size to reuse, already paged in. It
+// holds at most "imagebuf:pool_MB" of them, evicting the oldest first.
+class PixelPool {
+public:
+    // Smaller buffers are cheap enough to get from the heap.
+    static const size_t min_size = size_t(256) << 10;
+
+    // Round up to a multiple of a power of 2 no bigger than 1/8 of the
+    // size, so that a buffer is reused for sizes up to 12.5% smaller.
+    static size_t size_class(size_t size)
+    {
+        size_t step = 4096;
+        while (step * 16 <= size)
+            step *= 2;
+        return (size + step - 1) & ~(step - 1);
+    }
+
+    char* alloc(size_t size, size_t align, bool& large)
+    {
+        {
+            spin_lock lock(m_mutex);
+            for (size_t i = m_free.size(); i-- > 0;) {
+                if (m_free[i].size == size
+                    && uintptr_t(m_free[i].pixels) % align == 0) {
+                    char* p = m_free[i].pixels;
+                    large   = m_free[i].large;
+                    m_free.erase(m_free.begin() + i);
+                    pvt::IB_pool_mem_current -= size;
+                    return p;
+                }
+            }
+        }
+        return alloc_big_pixels(size, align, large);
+    }
+
+    void free(char* pixels, size_t size, bool large)
+    {
+        {
+            spin_lock lock(m_mutex);
+            m_free.push_back({ pixels, size, large });
+            pvt::IB_pool_mem_current += size;
+        }
+        trim();
+    }
+
+    // Free the oldest buffers until the pool is within its limit.
+    void trim()
+    {
+        long long limit = (long long)pvt::imagebuf_pool_MB << 20;
+        std::vector<Buffer> evicted;
+        {
+            spin_lock lock(m_mutex);
+            size_t n = 0;
+            for (; n < m_free.size() && pvt::IB_pool_mem_current > limit; ++n)
+                pvt::IB_pool_mem_current -= m_free[n].size;
+            evicted.assign(m_free.begin(), m_free.begin() + n);
+            m_free.erase(m_free.begin(), m_free.begin() + n);
+        }
+        for (auto& b : evicted)
+            free_big_pixels(b.pixels, b.large);
+    }
+
+private:
+    struct Buffer {
+        char* pixels;
+        size_t size;
+        bool large;
+    };
+    spin_mutex m_mutex;
+    std::vector<Buffer> m_free;  ///< Oldest first
+};
+
+
+
+// Never destroyed, since ImageBufs with static lifetimes may outlive it.
+PixelPool&
+pixel_pool()
+{
+    static PixelPool* pool = new PixelPool;
+    return *pool;
+}
+
+}  // namespace
+
+
+
+void
+pvt::imagebuf_pool_trim()
+{
+    pixel_pool().trim();
+}
+
+
+
+void
+ImageBufPixelsDeleter::operator()(char* pixels) const
+{
+    pvt::IB_local_mem_current -= counted;
+    if (pooled)
+        pixel_pool().free(pixels, size, large);
+    else if (size)
+        free_big_pixels(pixels, large);
+    else
+        delete[] pixels;
+}
+
+
+
+// Allocate pixel memory, aligned for "imagebuf:scanline_alignment", from
+// the pool if it's enabled and the buffer is big enough to be worth it,
+// or else with huge pages if asked for. Throws std::bad_alloc upon
+// failure.
+static std::unique_ptr<char[], ImageBufPixelsDeleter>
+alloc_pixels(size_t size)
+{
+    if (!size)
+        return {};
+    size_t align = std::max(pvt::imagebuf_scanline_alignment, 1);
+    ImageBufPixelsDeleter deleter;
+    if (pvt::imagebuf_pool_MB > 0 && size >= PixelPool::min_size) {
+        deleter.size   = PixelPool::size_class(size);
+        deleter.pooled = true;
+        char* p = pixel_pool().alloc(deleter.size, align, deleter.large);
+        return { p, deleter };
+    }
+    // new[] only aligns for the largest scalar type.
+    if ((pvt::imagebuf_hugepages && size >= hugepage_size)
+        || align > alignof(std::max_align_t)) {
+        deleter.size = size;
+        char* p      = alloc_big_pixels(size, align, deleter.large);
+        return { p, deleter };
+    }
+    return { new char[size], deleter };
+}
+
+
+
+// The scanline stride for pixel buffers that ImageBufs allocate, with any
+// padding asked for by "imagebuf:scanline_alignment" and
+// "imagebuf:pad_scanlines".
+static stride_t
+padded_scanline_stride(stride_t ystride, int height)
+{
+    int align = pvt::imagebuf_scanline_alignment;
+    if (align > 1 && ystride >= 8 * stride_t(align))
+        ystride = round_to_multiple(ystride, stride_t(align));
+    // Successive scanlines a multiple of 4K apart alias in the caches.
+    if (pvt::imagebuf_pad_scanlines && height > 1 && ystride % 4096 == 0)
+        ystride += std::max(align, 64);
+    return ystride;
+}
+
+
+
 ROI
 get_roi(const ImageSpec& spec)
 {
@@ -168,6 +421,12 @@ public:
               ProgressCallback progress_callback = nullptr,
               void* progress_callback_data       = nullptr,
               DoLock do_lock                     = DoLock(true));
+    bool read_into(string_view filename, int subimage, int miplevel,
+                   int chbegin, int chend, const ImageSpec* config,
+                   Filesystem::IOProxy* ioproxy,
+                   ProgressCallback progress_callback,
+                   void* progress_callback_data,
+                   ImageInput* openfile = nullptr);
     void copy_metadata(const ImageBufImpl& src);
 
     // At least one of bufspan or buforigin is supplied. Set this->m_bufspan
@@ -246,6 +505,8 @@ public:
 
     bool validate_pixels(DoLock do_lock = DoLock(true)) const
     {
+        if (OIIO_UNLIKELY(m_storage == ImageBuf::DEVICEBUFFER))
+            from_device(do_lock);
         if (m_pixels_valid)
             return true;
         if (!m_name.size())
@@ -315,6 +576,27 @@ public:
             shared_imagecache->invalidate(filename, force);  // the shared IC
     }
 
+    // Bring DEVICEBUFFER pixels back to the host buffer, which they came
+    // from, and release the device memory.
+    void from_device(DoLock do_lock = DoLock(true)) const
+    {
+        lock_t lock(m_mutex, std::defer_lock_t());
+        if (do_lock)
+            lock.lock();
+        if (m_storage != ImageBuf::DEVICEBUFFER)
+            return;
+        ImageBufImpl* imp = const_cast<ImageBufImpl*>(this);
+        if (!pvt::gpu_copy(m_localpixels, m_devicepixels, m_spec.image_bytes(),
+                           false))
+            imp->error("Could not copy pixels from the device");
+        pvt::gpu_free(m_devicepixels);
+        imp->m_devicepixels = nullptr;
+        imp->m_storage      = ImageBuf::LOCALBUFFER;
+        imp->eval_contiguous();
+    }
+
+    void* to_device(bool copy);
+
     void eval_contiguous()
     {
         m_contiguous = m_localpixels
@@ -341,8 +623,9 @@ private:
     mutable int m_threads;          ///< thread policy for this image
     ImageSpec m_spec;               ///< Describes the image (size, etc)
     ImageSpec m_nativespec;         ///< Describes the true native image
-    std::unique_ptr<char[]> m_pixels;  ///< Pixel data, if local and we own it
+    std::shared_ptr<char[]> m_pixels;  ///< Pixel data, if local and we own it
     char* m_localpixels;               ///< Pointer to local pixels
+    void* m_devicepixels = nullptr;    ///< Pixels in device memory
     span<std::byte> m_bufspan;         ///< Bounded buffer for local pixels
     typedef std::recursive_mutex mutex_t;
     typedef std::unique_lock<mutex_t> lock_t;
@@ -358,6 +641,11 @@ private:
     stride_t m_zstride;
     stride_t m_channel_stride;
     bool m_contiguous;
+    bool m_view = false;  ///< Shares some channels of another's m_pixels
+    /// Might m_pixels be shared with other ImageBufs? (Set by
+    /// share_pixels() for both of them, and cleared, under the lock, once
+    /// this one has a buffer of its own.)
+    mutable std::atomic<bool> m_shared { false };
     std::shared_ptr<ImageCache> m_imagecache;  ///< ImageCache to use
     TypeDesc m_cachedpixeltype;            ///< Data type stored in the cache
     DeepData m_deepdata;                   ///< Deep data
@@ -380,6 +668,28 @@ private:
     char* new_pixels(size_t size, const void* data = nullptr);
     // Private release of m_pixels.
     void free_pixels();
+    // Make this an O(1) copy of src's local pixels, sharing its buffer
+    // until either is written. Return false, changing nothing, if that
+    // can't be done.
+    bool share_pixels(const ImageBufImpl& src);
+    // Copy the pixels of a view of some of the channels of an image (src,
+    // or this one) into a new buffer of our own, laid out compactly.
+    bool copy_view_pixels(const ImageBufImpl& src);
+    // About to write the pixels: if the buffer is shared with copies of
+    // this ImageBuf, make a private copy of it first. Return false if
+    // that wasn't possible (leaving the ImageBuf without pixels).
+    bool unshare_pixels()
+    {
+        // Only m_shared may be looked at without the lock, since another
+        // thread unsharing can be replacing m_pixels.
+        if (OIIO_UNLIKELY(m_shared.load(std::memory_order_acquire)))
+            return copy_shared_pixels();
+        return true;
+    }
+    bool copy_shared_pixels();
+    // A copied ImageBuf is no longer a direct file reference, so clear
+    // some of the fields that are only meaningful for file references.
+    void clear_file_reference();
 
     TypeDesc write_format(int channel = 0) const
     {
@@ -508,6 +818,12 @@ ImageBufImpl::ImageBufImpl(const ImageBufImpl& src)
 // NO -- copy ctr does not transfer proxy   , m_rioproxy(src.m_rioproxy)
 // NO -- copy ctr does not transfer proxy   , m_wioproxy(src.m_wioproxy)
 {
+    if (src.m_storage == ImageBuf::DEVICEBUFFER) {
+        // The copy is a host buffer, so the source must be mirrored first.
+        src.from_device();
+        m_storage    = src.m_storage;
+        m_contiguous = src.m_contiguous;
+    }
     m_spec_valid   = src.m_spec_valid;
     m_pixels_valid = src.m_pixels_valid;
     m_pixels_read  = src.m_pixels_read;
@@ -518,8 +834,16 @@ ImageBufImpl::ImageBufImpl(const ImageBufImpl& src)
             m_localpixels = src.m_localpixels;
             m_bufspan     = src.m_bufspan;
         } else {
-            // We own our pixels -- copy from source
-            new_pixels(src.m_spec.image_bytes(), src.m_pixels.get());
+            // We own our pixels -- share the source's until one of us
+            // writes them, or else copy them. (As big as the source's,
+            // whose scanlines may be padded.)
+            if (share_pixels(src)) {
+                // Sharing them.
+            } else if (src.m_view) {
+                copy_view_pixels(src);
+            } else {
+                new_pixels(src.m_bufspan.size(), src.m_pixels.get());
+            }
             // N.B. new_pixels will set m_bufspan
         }
     } else {
@@ -678,8 +1002,12 @@ ImageBufImpl::new_pixels(size_t size, const void* data)
 {
     if (m_allocated_size)
         free_pixels();
+    pvt::memory_budget_reserve(size);
     try {
-        m_pixels.reset(size ? new char[size] : nullptr);
+        auto pixels                   = alloc_pixels(size);
+        pixels.get_deleter().counted = size;
+        pvt::IB_local_mem_current += size;
+        m_pixels = std::move(pixels);
         // Set bufspan to the allocated memory
         m_bufspan = { reinterpret_cast<std::byte*>(m_pixels.get()), size };
     } catch (const std::exception& e) {
@@ -695,11 +1023,11 @@ ImageBufImpl::new_pixels(size_t size, const void* data)
         m_bufspan = {};
     }
     m_allocated_size = size;
-    pvt::IB_local_mem_current += m_allocated_size;
     atomic_max(pvt::IB_local_mem_peak, (long long)pvt::IB_local_mem_current);
     if (data && size)
         memcpy(m_pixels.get(), data, size);
     m_localpixels = m_pixels.get();
+    m_view        = false;
     m_storage     = size ? ImageBuf::LOCALBUFFER : ImageBuf::UNINITIALIZED;
     if (pvt::oiio_print_debug > 1)
         OIIO::debugfmt("IB allocated {} MB, global IB memory now {} MB\n",
@@ -712,15 +1040,21 @@ ImageBufImpl::new_pixels(size_t size, const void* data)
 void
 ImageBufImpl::free_pixels()
 {
+    if (m_devicepixels) {
+        pvt::gpu_free(m_devicepixels);
+        m_devicepixels = nullptr;
+    }
+    // N.B. The memory is only freed (and uncounted) if no copy of this
+    // ImageBuf still shares it.
+    m_pixels.reset();
+    m_view = false;
     if (m_allocated_size) {
         if (pvt::oiio_print_debug > 1)
             OIIO::debugfmt("IB freed {} MB, global IB memory now {} MB\n",
                            m_allocated_size >> 20,
                            pvt::IB_local_mem_current >> 20);
-        pvt::IB_local_mem_current -= m_allocated_size;
         m_allocated_size = 0;
     }
-    m_pixels.reset();
     // print("IB Freed pixels of length {}\n", m_bufspan.size());
     m_bufspan = make_span<std::byte>(nullptr, 0);
     m_deepdata.free();
@@ -730,6 +1064,143 @@ ImageBufImpl::free_pixels()
 
 
 
+bool
+ImageBufImpl::share_pixels(const ImageBufImpl& src)
+{
+    if (!pvt::imagebuf_copy_on_write || src.m_storage != ImageBuf::LOCALBUFFER
+        || !src.m_pixels)
+        return false;
+    if (m_allocated_size)
+        free_pixels();
+    m_pixels         = src.m_pixels;
+    m_shared         = true;
+    src.m_shared     = true;
+    m_localpixels    = src.m_localpixels;
+    m_bufspan        = src.m_bufspan;
+    m_allocated_size = src.m_allocated_size;
+    m_storage        = ImageBuf::LOCALBUFFER;
+    m_view           = src.m_view;
+    eval_contiguous();
+    return true;
+}
+
+
+
+bool
+ImageBufImpl::copy_view_pixels(const ImageBufImpl& src)
+{
+    // Hold on to the shared buffer (which may be our own m_pixels) until
+    // the copy is done.
+    std::shared_ptr<char[]> shared = src.m_pixels;
+    const char* from               = src.m_localpixels;
+    stride_t xstride = src.m_xstride, ystride = src.m_ystride;
+    stride_t zstride = src.m_zstride;
+    m_pixels.reset();
+    m_allocated_size = 0;
+    if (!new_pixels(m_spec.image_bytes()))
+        return false;
+    m_xstride = AutoStride, m_ystride = AutoStride, m_zstride = AutoStride;
+    ImageSpec::auto_stride(m_xstride, m_ystride, m_zstride, m_spec.format,
+                           m_spec.nchannels, m_spec.width, m_spec.height);
+    copy_image(m_spec.nchannels, m_spec.width, m_spec.height, m_spec.depth,
+               from, m_spec.pixel_bytes(), xstride, ystride, zstride,
+               m_localpixels, m_xstride, m_ystride, m_zstride);
+    eval_contiguous();
+    return true;
+}
+
+
+
+bool
+ImageBufImpl::copy_shared_pixels()
+{
+    lock_t lock(m_mutex);
+    if (!m_pixels || m_pixels.use_count() == 1) {
+        // The copies are gone, or another thread beat us to it
+        m_shared = false;
+        return true;
+    }
+    if (m_view) {
+        // Just our own channels need copying.
+        bool ok  = copy_view_pixels(*this);
+        m_shared = false;
+        if (ok)
+            return true;
+        m_localpixels  = nullptr;
+        m_pixels_valid = false;
+        return false;
+    }
+    size_t size = m_bufspan.size();
+    pvt::memory_budget_reserve(size);
+    try {
+        auto pixels                   = alloc_pixels(size);
+        pixels.get_deleter().counted = size;
+        pvt::IB_local_mem_current += size;
+        atomic_max(pvt::IB_local_mem_peak,
+                   (long long)pvt::IB_local_mem_current);
+        memcpy(pixels.get(), m_pixels.get(), size);
+        // N.B. Hold on to the shared buffer until the copy is done, so that
+        // the other ImageBufs sharing it don't think they're alone yet.
+        m_pixels = std::move(pixels);
+    } catch (const std::exception& e) {
+        // Writing to the shared buffer would change the copies too, so
+        // this one must give up its pixels.
+        error("ImageBuf unable to allocate {} bytes ({})\n", size, e.what());
+        free_pixels();
+        m_shared       = false;
+        m_localpixels  = nullptr;
+        m_pixels_valid = false;
+        return false;
+    }
+    m_shared      = false;
+    m_localpixels = m_pixels.get();
+    m_bufspan     = { reinterpret_cast<std::byte*>(m_localpixels), size };
+    return true;
+}
+
+
+
+void
+ImageBufImpl::clear_file_reference()
+{
+    m_fileformat.clear();
+    m_nsubimages       = 1;
+    m_current_subimage = 0;
+    m_current_miplevel = 0;
+    m_nmiplevels       = 0;
+    m_spec.erase_attribute("oiio:subimages");
+    m_nativespec.erase_attribute("oiio:subimages");
+}
+
+
+
+void*
+ImageBufImpl::to_device(bool copy)
+{
+    lock_t lock(m_mutex);
+    if (m_storage == ImageBuf::DEVICEBUFFER)
+        return m_devicepixels;
+    validate_pixels(DoLock(false) /* we already hold the lock */);
+    // The pixels will come back from the device into the host buffer.
+    unshare_pixels();
+    if (m_storage != ImageBuf::LOCALBUFFER || !m_contiguous || m_spec.deep)
+        return nullptr;
+    size_t size = m_spec.image_bytes();
+    void* mem   = pvt::gpu_malloc(size);
+    if (!mem)
+        return nullptr;
+    if (copy && !pvt::gpu_copy(mem, m_localpixels, size, true)) {
+        pvt::gpu_free(mem);
+        return nullptr;
+    }
+    m_devicepixels = mem;
+    m_storage      = ImageBuf::DEVICEBUFFER;
+    eval_contiguous();
+    return mem;
+}
+
+
+
 static spin_mutex err_mutex;  ///< Protect m_err fields
 
 
@@ -999,14 +1470,22 @@ ImageBuf::reset(const ImageSpec& spec, span<std::byte> buffer,
 void
 ImageBufImpl::realloc()
 {
-    new_pixels(m_spec.deep ? size_t(0) : m_spec.image_bytes());
-    // N.B. new_pixels will set m_bufspan
     m_channel_stride = m_spec.format.size();
     m_xstride        = AutoStride;
     m_ystride        = AutoStride;
     m_zstride        = AutoStride;
     ImageSpec::auto_stride(m_xstride, m_ystride, m_zstride, m_spec.format,
                            m_spec.nchannels, m_spec.width, m_spec.height);
+    size_t size = 0;
+    if (!m_spec.deep) {
+        m_ystride = padded_scanline_stride(m_ystride, m_spec.height);
+        m_zstride = m_ystride * m_spec.height;
+        size      = m_ystride == stride_t(m_spec.scanline_bytes())
+                        ? m_spec.image_bytes()
+                        : size_t(m_zstride) * size_t(m_spec.depth);
+    }
+    new_pixels(size);
+    // N.B. new_pixels will set m_bufspan
     m_blackpixel.resize(round_to_multiple(m_xstride, OIIO_SIMD_MAX_SIZE_BYTES),
                         0);
     // NB make it big enough for SSE
@@ -1277,12 +1756,20 @@ ImageBufImpl::read(int subimage, int miplevel, int chbegin, int chend,
         } else {
             error(input->geterror());
         }
-        atomic_fetch_add(pvt::IB_total_image_read_time, float(timer()));
+        add_image_read_time(timer());
         return ok;
     }
 
     m_pixelaspect = m_spec.get_float_attribute("pixelaspectratio", 1.0f);
 
+    // Pixels that the reader converts to a working color space are not the
+    // ones the ImageCache holds, so they must be read directly.
+    string_view working;
+    if (m_configspec)
+        working = m_configspec->get_string_attribute("oiio:WorkingColorSpace");
+    if (working.size())
+        force = true;
+
     if (m_imagecache) {
         // If we don't already have "local" pixels, and we aren't asking to
         // convert the pixels to a specific (and different) type, then take an
@@ -1374,13 +1861,17 @@ ImageBufImpl::read(int subimage, int miplevel, int chbegin, int chend,
         if (in) {
             in->threads(threads());  // Pass on our thread policy
             bool ok = in->read_image(subimage, miplevel, chbegin, chend,
-                                     m_spec.format, m_localpixels, AutoStride,
-                                     AutoStride, AutoStride, progress_callback,
+                                     m_spec.format, m_localpixels, m_xstride,
+                                     m_ystride, m_zstride, progress_callback,
                                      progress_callback_data);
             in->close();
             if (ok) {
                 m_pixels_valid = true;
                 m_pixels_read  = true;
+                if (working.size() && chbegin == 0 && chend >= 3
+                    && m_nativespec.get_string_attribute("oiio:ColorSpace")
+                           .size())
+                    m_spec.set_colorspace(working);
             } else {
                 m_pixels_valid = false;
                 error(in->geterror());
@@ -1389,7 +1880,7 @@ ImageBufImpl::read(int subimage, int miplevel, int chbegin, int chend,
             m_pixels_valid = false;
             error(OIIO::geterror());
         }
-        atomic_fetch_add(pvt::IB_total_image_read_time, float(timer()));
+        add_image_read_time(timer());
         // Since we have read in the entire image now, if we are using an
         // IOProxy, we invalidate any cache entry to avoid lifetime issues
         // related to the IOProxy. This helps to eliminate trouble emerging
@@ -1419,7 +1910,8 @@ ImageBufImpl::read(int subimage, int miplevel, int chbegin, int chend,
                                  m_spec.x + m_spec.width, m_spec.y,
                                  m_spec.y + m_spec.height, m_spec.z,
                                  m_spec.z + m_spec.depth, chbegin, chend,
-                                 m_spec.format, m_localpixels)) {
+                                 m_spec.format, m_localpixels, m_xstride,
+                                 m_ystride, m_zstride)) {
         m_imagecache->close(m_name);
         m_pixels_valid = true;
     } else {
@@ -1432,6 +1924,198 @@ ImageBufImpl::read(int subimage, int miplevel, int chbegin, int chend,
 
 
 
+bool
+ImageBufImpl::read_into(string_view filename, int subimage, int miplevel,
+                        int chbegin, int chend, const ImageSpec* config,
+                        Filesystem::IOProxy* ioproxy,
+                        ProgressCallback progress_callback,
+                        void* progress_callback_data, ImageInput* openfile)
+{
+    lock_t lock(m_mutex);
+    if ((m_storage != ImageBuf::APPBUFFER
+         && m_storage != ImageBuf::LOCALBUFFER)
+        || m_spec.deep || !m_localpixels) {
+        error("read_into: the ImageBuf must hold local or app pixels");
+        return false;
+    }
+    if (m_readonly) {
+        error("read_into: the ImageBuf's buffer is read-only");
+        return false;
+    }
+    pvt::LoggedTimer logtime("IB::read_into");
+    Timer timer;
+    // Use the caller's already open file if there is one.
+    ImageInput::unique_ptr opened;
+    ImageInput* in = openfile;
+    if (!in) {
+        opened = ImageInput::open(filename, config, ioproxy);
+        if (!opened) {
+            error(OIIO::geterror());
+            return false;
+        }
+        in = opened.get();
+    }
+    ImageSpec filespec = in->spec(subimage, miplevel);
+    if (in->has_error()) {
+        error(in->geterror());
+        return false;
+    }
+    if (chend < 0 || chend > filespec.nchannels)
+        chend = filespec.nchannels;
+    if (filespec.deep || filespec.width != m_spec.width
+        || filespec.height != m_spec.height || filespec.depth != m_spec.depth
+        || chend - chbegin != m_spec.nchannels) {
+        error(
+            "read_into: \"{}\" is {}x{}x{} with {} channels, but the buffer is {}x{}x{} with {} channels",
+            filename, filespec.width, filespec.height, filespec.depth,
+            chend - chbegin, m_spec.width, m_spec.height, m_spec.depth,
+            m_spec.nchannels);
+        return false;
+    }
+    if (!unshare_pixels())
+        return false;
+    in->threads(threads());  // Pass on our thread policy
+    // The reader converts each chunk it decodes straight into the buffer's
+    // type and layout, so the pixels are written just once.
+    bool ok = in->read_image(subimage, miplevel, chbegin, chend,
+                             m_spec.format, m_localpixels, m_xstride,
+                             m_ystride, m_zstride, progress_callback,
+                             progress_callback_data);
+    if (opened)
+        in->close();
+    add_image_read_time(timer());
+    if (!ok) {
+        error(in->geterror());
+        return false;
+    }
+
+    // The pixels keep the buffer's type and layout; the rest of the
+    // description is the file's.
+    m_nativespec = filespec;
+    TypeDesc format(m_spec.format);
+    m_spec        = filespec;
+    m_spec.format = format;
+    m_spec.channelformats.clear();
+    m_spec.tile_width = m_spec.tile_height = m_spec.tile_depth = 0;
+    if (chbegin != 0 || chend != filespec.nchannels) {
+        m_spec.nchannels = chend - chbegin;
+        m_spec.channelnames.assign(filespec.channelnames.begin() + chbegin,
+                                   filespec.channelnames.begin() + chend);
+        m_spec.alpha_channel = filespec.alpha_channel - chbegin;
+        m_spec.z_channel     = filespec.z_channel - chbegin;
+        if (m_spec.alpha_channel < 0 || m_spec.alpha_channel >= chend - chbegin)
+            m_spec.alpha_channel = -1;
+        if (m_spec.z_channel < 0 || m_spec.z_channel >= chend - chbegin)
+            m_spec.z_channel = -1;
+    }
+    m_pixelaspect = m_spec.get_float_attribute("pixelaspectratio", 1.0f);
+    m_nsubimages  = in->supports("multiimage")
+                        ? filespec.get_int_attribute("oiio:subimages", 1)
+                        : 1;
+    m_name             = ustring(filename);
+    m_fileformat       = ustring(in->format_name());
+    m_current_subimage = subimage;
+    m_current_miplevel = miplevel;
+    m_spec_valid       = true;
+    m_pixels_valid     = true;
+    m_pixels_read      = true;
+    m_badfile          = false;
+    m_has_thumbnail    = false;
+    m_thumbnail.reset();
+    return true;
+}
+
+
+
+bool
+ImageBuf::read_into(string_view filename, int subimage, int miplevel,
+                    int chbegin, int chend, const ImageSpec* config,
+                    Filesystem::IOProxy* ioproxy,
+                    ProgressCallback progress_callback,
+                    void* progress_callback_data)
+{
+    return m_impl->read_into(filename, subimage, miplevel, chbegin, chend,
+                             config, ioproxy, progress_callback,
+                             progress_callback_data);
+}
+
+
+
+std::vector<ImageBuf>
+ImageBuf::read_subimages(string_view filename, cspan<int> subimages,
+                         TypeDesc convert, const ImageSpec* config,
+                         int nthreads)
+{
+    pvt::LoggedTimer logtime("IB::read_subimages");
+    auto first = ImageInput::open(filename, config);
+    if (!first)
+        return {};  // error already set by open()
+    std::vector<int> all;
+    if (subimages.empty()) {
+        int n = 1;
+        if (first->supports("multiimage")) {
+            while (first->seek_subimage(n, 0))
+                ++n;
+            (void)first->geterror();  // Running off the end isn't an error
+        }
+        for (int s = 0; s < n; ++s)
+            all.push_back(s);
+        subimages = all;
+    }
+
+    // Each task borrows an open ImageInput, opening another only if all of
+    // them are busy, so there are never more than there are threads.
+    std::mutex pool_mutex;
+    std::vector<ImageInput::unique_ptr> pool;
+    pool.push_back(std::move(first));
+    std::vector<ImageBuf> result(subimages.size());
+    parallel_for(
+        int64_t(0), int64_t(subimages.size()),
+        [&](int64_t i) {
+            ImageInput::unique_ptr in;
+            {
+                std::lock_guard<std::mutex> lock(pool_mutex);
+                if (pool.size()) {
+                    in = std::move(pool.back());
+                    pool.pop_back();
+                }
+            }
+            if (!in)
+                in = ImageInput::open(filename, config);
+            ImageBuf& buf(result[i]);
+            if (!in) {
+                buf.errorfmt("{}", OIIO::geterror());
+                return;
+            }
+            int subimage = subimages[i];
+            ImageSpec spec = in->spec(subimage, 0);
+            if (in->has_error()) {
+                buf.errorfmt("{}", in->geterror());
+            } else if (spec.deep) {
+                // Deep images aren't read by read_into; read them
+                // separately.
+                buf.reset(filename, subimage, 0, nullptr, config);
+                buf.read(subimage, 0, true, convert);
+            } else {
+                if (convert != TypeUnknown)
+                    spec.format = convert;
+                spec.channelformats.clear();
+                spec.tile_width = spec.tile_height = spec.tile_depth = 0;
+                buf.reset(spec, InitializePixels::No);
+                if (!buf.m_impl->read_into(filename, subimage, 0, 0, -1,
+                                           config, nullptr, nullptr, nullptr,
+                                           in.get()))
+                    buf.reset();  // Keeps the error
+            }
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            pool.push_back(std::move(in));
+        },
+        paropt(nthreads));
+    return result;
+}
+
+
+
 bool
 ImageBuf::read(int subimage, int miplevel, bool force, TypeDesc convert,
                ProgressCallback progress_callback, void* progress_callback_data)
@@ -1732,7 +2416,7 @@ ImageBuf::make_writable(bool keep_cache_type)
         return read(subimage(), miplevel(), 0, -1, true /*force*/,
                     keep_cache_type ? m_impl->m_cachedpixeltype : TypeDesc());
     }
-    return true;
+    return m_impl->unshare_pixels();
 }
 
 
@@ -1996,6 +2680,7 @@ void*
 ImageBuf::localpixels()
 {
     m_impl->validate_pixels();
+    m_impl->unshare_pixels();
     return m_impl->m_localpixels;
 }
 
@@ -2010,6 +2695,32 @@ ImageBuf::localpixels() const
 
 
 
+void*
+ImageBuf::devicepixels()
+{
+    return m_impl->m_storage == DEVICEBUFFER ? m_impl->m_devicepixels
+                                             : nullptr;
+}
+
+
+
+const void*
+ImageBuf::devicepixels() const
+{
+    return m_impl->m_storage == DEVICEBUFFER ? m_impl->m_devicepixels
+                                             : nullptr;
+}
+
+
+
+void*
+ImageBuf::to_device(bool copy)
+{
+    return m_impl->to_device(copy);
+}
+
+
+
 stride_t
 ImageBuf::pixel_stride() const
 {
@@ -2187,16 +2898,7 @@ ImageBuf::copy_pixels(const ImageBuf& src)
     // we need to bottom out with something that handles all types, and
     // this is the place where that happens.
 
-    // A copied ImageBuf is no longer a direct file reference, so clear some
-    // of the fields that are only meaningful for file references.
-    m_impl->m_fileformat.clear();
-    m_impl->m_nsubimages       = 1;
-    m_impl->m_current_subimage = 0;
-    m_impl->m_current_miplevel = 0;
-    m_impl->m_nmiplevels       = 0;
-    m_impl->m_spec.erase_attribute("oiio:subimages");
-    m_impl->m_nativespec.erase_attribute("oiio:subimages");
-
+    m_impl->clear_file_reference();
     return ok;
 }
 
@@ -2217,6 +2919,30 @@ ImageBuf::copy(const ImageBuf& src, TypeDesc format)
         m_impl->m_deepdata = src.m_impl->m_deepdata;
         return true;
     }
+    if ((format.basetype == TypeDesc::UNKNOWN
+         || (format == src.spec().format && src.spec().channelformats.empty()))
+        && src.storage() == LOCALBUFFER && src.m_impl->m_pixels
+        && storage() != APPBUFFER && pvt::imagebuf_copy_on_write) {
+        // Share the source's pixels until one or the other is written.
+        ImageBufImpl* imp     = m_impl.get();
+        const ImageBufImpl* s = src.m_impl.get();
+        ImageBufImpl::lock_t lock(s->m_mutex);
+        imp->clear();
+        imp->m_name           = s->m_name;
+        imp->m_spec           = s->m_spec;
+        imp->m_nativespec     = s->m_nativespec;
+        imp->m_channel_stride = s->m_channel_stride;
+        imp->m_xstride        = s->m_xstride;
+        imp->m_ystride        = s->m_ystride;
+        imp->m_zstride        = s->m_zstride;
+        imp->m_blackpixel     = s->m_blackpixel;
+        imp->m_readonly       = false;
+        imp->m_spec_valid     = true;
+        imp->m_pixels_valid   = true;
+        imp->share_pixels(*s);
+        imp->clear_file_reference();
+        return true;
+    }
     if (format.basetype == TypeDesc::UNKNOWN || src.deep())
         m_impl->reset(src.name(), src.spec(), &src.nativespec());
     else {
@@ -2230,6 +2956,45 @@ ImageBuf::copy(const ImageBuf& src, TypeDesc format)
 
 
 
+bool
+ImageBuf::share_channels(const ImageBuf& src, int chbegin, int chend)
+{
+    src.m_impl->validate_pixels();
+    if (this == &src || src.storage() != LOCALBUFFER || !src.m_impl->m_pixels
+        || src.deep() || !src.spec().channelformats.empty()
+        || storage() == APPBUFFER || !pvt::imagebuf_copy_on_write
+        || chbegin < 0 || chend > src.nchannels() || chbegin >= chend)
+        return false;
+    ImageBufImpl* imp     = m_impl.get();
+    const ImageBufImpl* s = src.m_impl.get();
+    ImageBufImpl::lock_t lock(s->m_mutex);
+    imp->clear();
+    ImageSpec& spec = imp->m_spec;
+    spec            = s->m_spec;
+    spec.nchannels  = chend - chbegin;
+    spec.channelnames.assign(s->m_spec.channelnames.begin() + chbegin,
+                             s->m_spec.channelnames.begin() + chend);
+    for (int* c : { &spec.alpha_channel, &spec.z_channel })
+        *c = (*c >= chbegin && *c < chend) ? *c - chbegin : -1;
+    imp->m_nativespec     = spec;
+    imp->m_channel_stride = s->m_channel_stride;
+    imp->m_xstride        = s->m_xstride;
+    imp->m_ystride        = s->m_ystride;
+    imp->m_zstride        = s->m_zstride;
+    imp->m_blackpixel     = s->m_blackpixel;
+    imp->m_readonly       = false;
+    imp->m_spec_valid     = true;
+    imp->m_pixels_valid   = true;
+    imp->share_pixels(*s);
+    imp->m_localpixels += chbegin * imp->m_channel_stride;
+    imp->m_view = imp->m_view || spec.nchannels != s->m_spec.nchannels;
+    imp->eval_contiguous();
+    imp->clear_file_reference();
+    return true;
+}
+
+
+
 ImageBuf
 ImageBuf::copy(TypeDesc format) const
 {
@@ -2501,6 +3266,31 @@ get_pixels_(const ImageBuf& buf, const ImageBuf& /*dummy*/, ROI whole_roi,
 
 
 
+// Zero the pixels of a width x height x depth buffer with the given
+// strides, of `pixelbytes` each.
+static void
+zero_pixels(void* result, size_t pixelbytes, int width, int height,
+            int depth, stride_t xstride, stride_t ystride, stride_t zstride)
+{
+    if (xstride == stride_t(pixelbytes) && ystride == xstride * width
+        && zstride == ystride * height) {
+        memset(result, 0, pixelbytes * width * height * depth);
+        return;
+    }
+    for (int z = 0; z < depth; ++z) {
+        for (int y = 0; y < height; ++y) {
+            char* p = (char*)result + z * zstride + y * ystride;
+            if (xstride == stride_t(pixelbytes))
+                memset(p, 0, pixelbytes * width);
+            else
+                for (int x = 0; x < width; ++x, p += xstride)
+                    memset(p, 0, pixelbytes);
+        }
+    }
+}
+
+
+
 bool
 ImageBuf::get_pixels(ROI roi, TypeDesc format, span<std::byte> buffer,
                      void* buforigin, stride_t xstride, stride_t ystride,
@@ -2519,19 +3309,61 @@ ImageBuf::get_pixels(ROI roi, TypeDesc format, span<std::byte> buffer,
         errorfmt("get_pixels: buffer span does not contain the ROI dimensions");
         return false;
     }
-    if (localpixels() && this->roi().contains(roi)) {
-        // Easy case -- if the buffer is already fully in memory and the roi
-        // is completely contained in the pixel window, this reduces to a
-        // parallel_convert_image, which is both threaded and already
-        // handles many special cases.
+    if (localpixels() && !deep()) {
+        // Easy case -- if the buffer is already fully in memory, this
+        // reduces to a parallel_convert_image of the part of the roi within
+        // the pixel window, which is both threaded and already handles
+        // many special cases. Any of the roi outside the pixel window is
+        // black.
+        ROI inside = roi_intersection(roi, this->roi());
+        if (inside != roi)
+            zero_pixels(result, format.size() * roi.nchannels(), roi.width(),
+                        roi.height(), roi.depth(), xstride, ystride, zstride);
+        if (inside.npixels() <= 0)
+            return true;
+        char* r = (char*)result + (inside.zbegin - roi.zbegin) * zstride
+                  + (inside.ybegin - roi.ybegin) * ystride
+                  + (inside.xbegin - roi.xbegin) * xstride;
         return parallel_convert_image(
-            roi.nchannels(), roi.width(), roi.height(), roi.depth(),
-            pixeladdr(roi.xbegin, roi.ybegin, roi.zbegin, roi.chbegin),
-            spec().format, pixel_stride(), scanline_stride(), z_stride(),
-            result, format, xstride, ystride, zstride, threads());
+            roi.nchannels(), inside.width(), inside.height(), inside.depth(),
+            pixeladdr(inside.xbegin, inside.ybegin, inside.zbegin,
+                      roi.chbegin),
+            spec().format, pixel_stride(), scanline_stride(), z_stride(), r,
+            format, xstride, ystride, zstride, threads());
+    }
+
+    std::shared_ptr<ImageCache> ic = cachedpixels() ? imagecache() : nullptr;
+    if (ic) {
+        // Let the cache copy whole tile spans at a time, rather than going
+        // through an iterator a pixel at a time, with threads taking bands
+        // of scanlines. Cache errors are per thread, so keep the first.
+        std::atomic<bool> ok(true);
+        std::string err;
+        std::mutex errmutex;
+        ImageBufAlgo::parallel_image(
+            roi, { "get_pixels", threads(), paropt::SplitDir::Y, 16384 },
+            [&](ROI band) {
+                char* r = (char*)result + (band.zbegin - roi.zbegin) * zstride
+                          + (band.ybegin - roi.ybegin) * ystride
+                          + (band.xbegin - roi.xbegin) * xstride;
+                if (!ic->get_pixels(uname(), subimage(), miplevel(),
+                                    band.xbegin, band.xend, band.ybegin,
+                                    band.yend, band.zbegin, band.zend,
+                                    roi.chbegin, roi.chend, format, r,
+                                    xstride, ystride, zstride)) {
+                    std::lock_guard<std::mutex> lock(errmutex);
+                    if (ok.exchange(false))
+                        err = ic->geterror();
+                    else
+                        ic->geterror();
+                }
+            });
+        if (!ok)
+            errorfmt("{}", err);
+        return ok;
     }
 
-    // General case -- can handle IC-backed images.
+    // General case -- iterate over the pixels.
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2_CONST(ok, "get_pixels", get_pixels_, format,
                                       spec().format, *this, *this, roi, roi,
@@ -2581,6 +3413,40 @@ set_pixels_(ImageBuf& buf, ROI roi, const void* data_, stride_t xstride,
 
 
 
+// The easy case of set_pixels: once the pixels are in local memory, the
+// part of `roi` within the pixel window is a parallel_convert_image (the
+// rest is ignored). Return false if the pixels can't be made local.
+static bool
+set_pixels_local(ImageBuf& buf, ROI roi, TypeDesc format, const void* data,
+                 stride_t xstride, stride_t ystride, stride_t zstride,
+                 bool& ok)
+{
+    if (buf.deep()
+        || (buf.storage() == ImageBuf::IMAGECACHE && !buf.make_writable(true))
+        || !buf.localpixels())
+        return false;
+    ROI inside = roi_intersection(roi, buf.roi());
+    if (inside.npixels() <= 0) {
+        ok = true;
+        return true;
+    }
+    const char* src = (const char*)data
+                      + (inside.zbegin - roi.zbegin) * zstride
+                      + (inside.ybegin - roi.ybegin) * ystride
+                      + (inside.xbegin - roi.xbegin) * xstride;
+    ok = parallel_convert_image(roi.nchannels(), inside.width(),
+                                inside.height(), inside.depth(), src, format,
+                                xstride, ystride, zstride,
+                                buf.pixeladdr(inside.xbegin, inside.ybegin,
+                                              inside.zbegin, roi.chbegin),
+                                buf.spec().format, buf.pixel_stride(),
+                                buf.scanline_stride(), buf.z_stride(),
+                                buf.threads());
+    return true;
+}
+
+
+
 bool
 ImageBuf::set_pixels(ROI roi, TypeDesc format, const void* data,
                      stride_t xstride, stride_t ystride, stride_t zstride)
@@ -2597,6 +3463,9 @@ ImageBuf::set_pixels(ROI roi, TypeDesc format, const void* data,
                            roi.nchannels(), roi.width(), roi.height());
 
     bool ok;
+    if (set_pixels_local(*this, roi, format, data, xstride, ystride, zstride,
+                         ok))
+        return ok;
     OIIO_DISPATCH_TYPES2(ok, "set_pixels", set_pixels_, spec().format, format,
                          *this, roi, data, xstride, ystride, zstride);
     return ok;
@@ -2629,6 +3498,9 @@ ImageBuf::set_pixels(ROI roi, TypeDesc format, cspan<std::byte> buffer,
         return false;
     }
 
+    if (set_pixels_local(*this, roi, format, result, xstride, ystride,
+                         zstride, ok))
+        return ok;
     OIIO_DISPATCH_TYPES2(ok, "set_pixels", set_pixels_, spec().format, format,
                          *this, roi, result, xstride, ystride, zstride);
     return ok;
@@ -3009,6 +3881,7 @@ ImageBufImpl::pixeladdr(int x, int y, int z, int ch)
     validate_pixels();
     if (cachedpixels())
         return nullptr;
+    unshare_pixels();
     x -= m_spec.x;
     y -= m_spec.y;
     z -= m_spec.z;
@@ -3347,6 +4220,11 @@ ImageBuf::IteratorBase::init_ib(WrapMode wrap, bool write)
     ImageBufImpl::lock_t lock(m_ib->m_impl->m_mutex);
     const ImageSpec& spec(m_ib->spec());
     m_deep        = spec.deep;
+    // Pixels shared with copies of the image must be copied before they're
+    // written. That can't wait for the first write, since iterators made
+    // in the meantime would still point into the shared buffer.
+    if (write)
+        m_ib->m_impl->unshare_pixels();
     m_localpixels = (m_ib->localpixels() != nullptr);
     // if (write)
     //      ensure_writable();  // Not here; do it lazily
@@ -4,6 +4,8 @@
 
 
 #include <OpenImageIO/benchmark.h>
+#include <OpenImageIO/color.h>
+#include <OpenImageIO/deepdata.h>
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
@@ -393,6 +395,24 @@ test_set_get_pixels()
     float retrieved[2 * 2 * nchans] = { 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9 };
     A.get_pixels(ROI(1, 3, 1, 3, 0, 1), make_span(retrieved));
     OIIO_CHECK_ASSERT(0 == memcmp(retrieved, newdata, 2 * 2 * nchans));
+
+    // A region hanging off the edge: the part outside is ignored by
+    // set_pixels, and black from get_pixels.
+    uint8_t bytes[2 * 2 * nchans] = { 0,   255, 0,   255, 255, 255,
+                                      255, 0,   255, 51,  102, 153 };
+    A.set_pixels(ROI(3, 5, 3, 5), TypeUInt8, bytes);
+    float pixel[nchans];
+    A.getpixel(3, 3, pixel);
+    OIIO_CHECK_EQUAL(pixel[0], 0.0f);
+    OIIO_CHECK_EQUAL(pixel[1], 1.0f);
+    float edge[2 * 2 * nchans];
+    A.get_pixels(ROI(2, 4, 3, 5, 0, nchans), make_span(edge));
+    OIIO_CHECK_EQUAL(edge[0], 0.0f);
+    OIIO_CHECK_EQUAL(edge[3], 0.0f);
+    OIIO_CHECK_EQUAL(edge[4], 1.0f);
+    OIIO_CHECK_EQUAL(edge[5], 0.0f);
+    for (int i = 6; i < 2 * 2 * nchans; ++i)
+        OIIO_CHECK_EQUAL(edge[i], 0.0f);
 }
 
 
@@ -425,6 +445,9 @@ time_get_pixels()
     std::vector<uint16_t> usbuf(nvals);
     bench("get_pixels 1Mpelx4 float[4]->uint16[4] ",
           [&]() { A.get_pixels(A.roi(), make_span(usbuf)); });
+
+    bench("set_pixels 1Mpelx4 uint8[4]->float[4] ",
+          [&]() { A.set_pixels(A.roi(), make_span(ucbuf)); });
 }
 
 
@@ -711,6 +734,637 @@ test_iterator_concurrency()
 
 
 
+// Freed pixel buffers are reused by new ImageBufs of about the same size,
+// while the pool is enabled.
+static void
+test_pixel_pool()
+{
+    std::cout << "test pixel pool\n";
+    auto pooled = []() {
+        long long bytes = 0;
+        OIIO::getattribute("IB_pool_mem_current", TypeInt64, &bytes);
+        return bytes;
+    };
+    OIIO::attribute("imagebuf:pool_MB", 64);
+    const void* first = nullptr;
+    {
+        ImageBuf A(ImageSpec(1024, 512, 4, TypeFloat));
+        first = A.localpixels();
+    }
+    OIIO_CHECK_ASSERT(pooled() >= 1024 * 512 * 4 * 4);
+    {
+        // A little smaller still fits in the same buffer
+        ImageBuf B(ImageSpec(1024, 500, 4, TypeFloat));
+        OIIO_CHECK_EQUAL(B.localpixels(), first);
+        OIIO_CHECK_EQUAL(pooled(), 0);
+        ImageBufAlgo::fill(B, { 0.5f, 0.25f, 1.0f, 1.0f });
+        OIIO_CHECK_EQUAL(B.getchannel(1023, 499, 0, 1), 0.25f);
+    }
+    // Small buffers aren't pooled
+    { ImageBuf C(ImageSpec(16, 16, 4, TypeFloat)); }
+    OIIO_CHECK_EQUAL(pooled(), 1024 * 512 * 4 * 4);
+    OIIO::attribute("imagebuf:pool_MB", 0);
+    OIIO_CHECK_EQUAL(pooled(), 0);
+
+    Benchmarker bench;
+    bench.units(Benchmarker::Unit::ms);
+    bench.iterations(1);
+    bench.trials(3);
+    for (int pool : { 0, 1024 }) {
+        OIIO::attribute("imagebuf:pool_MB", pool);
+        bench(pool ? "  new 2K float image and fill (pooled)"
+                   : "  new 2K float image and fill (heap)  ",
+              []() {
+                  ImageBuf R(ImageSpec(2048, 1080, 4, TypeFloat));
+                  ImageBufAlgo::fill(R, { 0.5f, 0.5f, 0.5f, 1.0f });
+              });
+    }
+    OIIO::attribute("imagebuf:pool_MB", 0);
+}
+
+
+
+// DeepData::set_all_capacity and reserve() grow pixels' capacities after
+// the samples are allocated without disturbing the samples, and with
+// "deepdata:pool_MB" the sample buffer of a freed DeepData is reused.
+static void
+test_deepdata_capacity()
+{
+    std::cout << "test deepdata capacity\n";
+    const int npixels = 64 * 1024;
+    std::vector<TypeDesc> types { TypeFloat, TypeFloat };
+    std::vector<std::string> names { "A", "Z" };
+    std::vector<unsigned int> samples(npixels), capacity(npixels);
+    for (int p = 0; p < npixels; ++p) {
+        samples[p]  = p % 3;
+        capacity[p] = p % 3 + p % 5;
+    }
+    auto make = [&](DeepData& dd) {
+        dd.init(npixels, 2, types, names);
+        dd.set_all_samples(samples);
+        for (int p = 0; p < npixels; ++p)
+            for (int s = 0; s < dd.samples(p); ++s)
+                dd.set_deep_value(p, 1, s, float(p + s));
+    };
+
+    DeepData dd;
+    make(dd);
+    dd.reserve(size_t(3) * npixels);
+    const char* data = dd.all_data().data();
+    dd.set_all_capacity(capacity);
+    OIIO_CHECK_EQUAL(dd.all_data().data(), data);  // didn't reallocate
+    bool ok = true;
+    for (int p = 0; p < npixels; ++p) {
+        ok &= dd.capacity(p) == int(std::max(samples[p], capacity[p]));
+        for (int s = 0; s < dd.samples(p); ++s)
+            ok &= dd.deep_value(p, 1, s) == float(p + s);
+    }
+    OIIO_CHECK_ASSERT(ok);
+
+    OIIO::attribute("deepdata:pool_MB", 64);
+    {
+        DeepData first;
+        make(first);
+        data = first.all_data().data();
+    }
+    {
+        DeepData second;
+        make(second);
+        OIIO_CHECK_EQUAL(second.all_data().data(), data);
+    }
+    OIIO::attribute("deepdata:pool_MB", 0);
+}
+
+
+
+static void
+test_padded_scanlines()
+{
+    std::cout << "test padded scanlines\n";
+    ImageSpec spec(1024, 64, 4, TypeFloat);  // 16 KB scanlines
+    ImageBuf ref(spec);
+    ImageBufAlgo::fill(ref, { 0.0f, 0.0f, 0.0f, 1.0f },
+                       { 1.0f, 0.5f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.25f, 1.0f },
+                       { 1.0f, 1.0f, 1.0f, 0.5f });
+    OIIO_CHECK_ASSERT(ref.contiguous());
+
+    OIIO::attribute("imagebuf:scanline_alignment", 64);
+    OIIO::attribute("imagebuf:pad_scanlines", 1);
+    {
+        ImageBuf A(spec);
+        OIIO_CHECK_EQUAL(A.scanline_stride() % 64, 0);
+        OIIO_CHECK_NE(A.scanline_stride() % 4096, 0);
+        OIIO_CHECK_EQUAL(uintptr_t(A.localpixels()) % 64, 0);
+        OIIO_CHECK_ASSERT(!A.contiguous());
+        A.copy_pixels(ref);
+        OIIO_CHECK_EQUAL(ImageBufAlgo::compare(A, ref, 0.0f, 0.0f).nfail, 0);
+        // Its copies, and images read into padded buffers, match too
+        ImageBuf B(A);
+        OIIO_CHECK_EQUAL(B.scanline_stride(), A.scanline_stride());
+        OIIO_CHECK_EQUAL(ImageBufAlgo::compare(B, ref, 0.0f, 0.0f).nfail, 0);
+        A.write("tmp-padded.exr");
+        ImageBuf C("tmp-padded.exr");
+        C.read(0, 0, true, TypeFloat);
+        OIIO_CHECK_ASSERT(!C.contiguous());
+        OIIO_CHECK_EQUAL(ImageBufAlgo::compare(C, ref, 0.0f, 0.0f).nfail, 0);
+        OIIO_CHECK_EQUAL(ImageBufAlgo::computePixelHashSHA1(C),
+                         ImageBufAlgo::computePixelHashSHA1(ref));
+    }
+    Filesystem::remove("tmp-padded.exr");
+    // Narrow images aren't padded
+    {
+        ImageBuf D(ImageSpec(4, 4, 1, TypeFloat));
+        OIIO_CHECK_ASSERT(D.contiguous());
+    }
+    OIIO::attribute("imagebuf:scanline_alignment", 0);
+    OIIO::attribute("imagebuf:pad_scanlines", 0);
+
+    Benchmarker bench;
+    bench.units(Benchmarker::Unit::ms);
+    bench.iterations(1);
+    bench.trials(3);
+    ImageBuf big(ImageSpec(4096, 4096, 4, TypeFloat));
+    ImageBufAlgo::fill(big, { 0.5f, 0.5f, 0.5f, 1.0f });
+    for (int huge : { 0, 1 }) {
+        OIIO::attribute("imagebuf:hugepages", huge);
+        bench(huge ? "  transpose 4K float image (huge pages)"
+                   : "  transpose 4K float image            ",
+              [&]() { ImageBuf R = ImageBufAlgo::transpose(big); });
+    }
+    OIIO::attribute("imagebuf:hugepages", 0);
+}
+
+
+
+// Sum the channels of the pixels of roi of buf, a run at a time where the
+// iterator has runs, counting the pixels visited in runs.
+static double
+sum_by_runs(const ImageBuf& buf, ROI roi, imagesize_t& inruns, int& maxrun)
+{
+    double sum = 0.0;
+    inruns = 0;
+    maxrun = 0;
+    const int nc = buf.nchannels();
+    for (ImageBuf::ConstIterator<float> it(buf, roi); !it.done();) {
+        if (int n = it.run_length()) {
+            cspan<float> vals = it.run();
+            stride_t step     = it.pixel_stride() / stride_t(sizeof(float));
+            for (int i = 0; i < n; ++i)
+                for (int c = 0; c < nc; ++c)
+                    sum += vals[i * step + c];
+            inruns += n;
+            maxrun = std::max(maxrun, n);
+            it.advance(n);
+        } else {
+            for (int c = 0; c < nc; ++c)
+                sum += it[c];
+            ++it;
+        }
+    }
+    return sum;
+}
+
+
+
+static void
+test_iterator_runs()
+{
+    std::cout << "test iterator runs\n";
+    ImageSpec spec(37, 11, 3, TypeFloat);
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 0.0f, 0.25f, 0.5f }, { 1.0f, 0.5f, 0.0f },
+                       { 0.5f, 1.0f, 0.25f }, { 1.0f, 1.0f, 1.0f });
+    double expected = 0.0;
+    for (ImageBuf::ConstIterator<float> it(A); !it.done(); ++it)
+        for (int c = 0; c < 3; ++c)
+            expected += it[c];
+
+    // Local pixels: whole scanlines are runs, and pixels outside the
+    // data window aren't.
+    imagesize_t inruns;
+    int maxrun;
+    ROI over(-3, 40, -1, 12);
+    OIIO_CHECK_EQUAL_APPROX(sum_by_runs(A, over, inruns, maxrun), expected);
+    OIIO_CHECK_EQUAL(inruns, A.spec().image_pixels());
+    OIIO_CHECK_EQUAL(maxrun, 37);
+    ROI inside(5, 20, 2, 9);
+    double sumin = 0.0;
+    for (ImageBuf::ConstIterator<float> it(A, inside); !it.done(); ++it)
+        for (int c = 0; c < 3; ++c)
+            sumin += it[c];
+    OIIO_CHECK_EQUAL_APPROX(sum_by_runs(A, inside, inruns, maxrun), sumin);
+    OIIO_CHECK_EQUAL(maxrun, 15);
+
+    // An app buffer with a gap after each pixel
+    std::vector<float> padded(37 * 11 * 4, -1.0f);
+    ImageBuf B(spec, make_span(padded), nullptr, 4 * sizeof(float));
+    B.copy_pixels(A);
+    OIIO_CHECK_EQUAL_APPROX(sum_by_runs(B, over, inruns, maxrun), expected);
+    OIIO_CHECK_EQUAL(maxrun, 37);
+
+    // Writing through the runs of an Iterator
+    ImageBuf C(spec);
+    for (ImageBuf::Iterator<float> it(C); !it.done();) {
+        int n            = std::max(it.run_length(), 1);
+        span<float> vals = it.run();
+        for (auto& v : vals)
+            v = 0.5f;
+        it.advance(n);
+    }
+    OIIO_CHECK_EQUAL_APPROX(sum_by_runs(C, C.roi(), inruns, maxrun),
+                            0.5 * 37 * 11 * 3);
+
+    // Backed by an ImageCache, runs are within tiles
+    const char* filename = "tmp-runs.tif";
+    A.set_write_tiles(16, 16);
+    A.write(filename);
+    {
+        ImageBuf D(filename, 0, 0, ImageCache::create());
+        OIIO_CHECK_EQUAL(D.storage(), ImageBuf::IMAGECACHE);
+        OIIO_CHECK_EQUAL_APPROX(sum_by_runs(D, over, inruns, maxrun),
+                                expected);
+        OIIO_CHECK_EQUAL(inruns, A.spec().image_pixels());
+        OIIO_CHECK_EQUAL(maxrun, 16);
+        OIIO_CHECK_EQUAL(D.storage(), ImageBuf::IMAGECACHE);
+    }
+    ImageCache::create()->invalidate(ustring(filename));
+    Filesystem::remove(filename);
+}
+
+
+
+static void
+test_copy_on_write()
+{
+    std::cout << "test copy on write\n";
+    auto constpixels = [](const ImageBuf& buf) { return buf.localpixels(); };
+    auto localmem    = []() {
+        long long bytes = 0;
+        OIIO::getattribute("IB_local_mem_current", TypeInt64, &bytes);
+        return bytes;
+    };
+    ImageBuf A(ImageSpec(64, 64, 3, TypeFloat));
+    ImageBufAlgo::fill(A, { 0.25f, 0.5f, 0.75f });
+    ImageBuf ref(A.spec());
+    ref.copy_pixels(A);
+    {
+        // It's off by default, so copies get their own pixels
+        int cow = -1;
+        OIIO::getattribute("imagebuf:copy_on_write", cow);
+        OIIO_CHECK_EQUAL(cow, 0);
+        ImageBuf B(A);
+        OIIO_CHECK_NE(constpixels(B), constpixels(A));
+    }
+    OIIO::attribute("imagebuf:copy_on_write", 1);
+    long long before = localmem();
+    {
+        // Copies share A's pixels...
+        ImageBuf B(A);
+        ImageBuf C;
+        C.copy(A);
+        OIIO_CHECK_EQUAL(constpixels(B), constpixels(A));
+        OIIO_CHECK_EQUAL(constpixels(C), constpixels(A));
+        OIIO_CHECK_EQUAL(localmem(), before);
+        // ...until they are written, which leaves A unchanged.
+        B.setpixel(1, 1, { 1.0f, 0.0f, 0.0f });
+        OIIO_CHECK_NE(constpixels(B), constpixels(A));
+        OIIO_CHECK_EQUAL(B.getchannel(1, 1, 0, 0), 1.0f);
+        OIIO_CHECK_EQUAL(A.getchannel(1, 1, 0, 0), 0.25f);
+        OIIO_CHECK_EQUAL(localmem(),
+                         before + (long long)A.spec().image_bytes());
+        // So does assignment, until make_writable() is asked for.
+        ImageBuf F;
+        F = A;
+        OIIO_CHECK_EQUAL(constpixels(F), constpixels(A));
+        OIIO_CHECK_ASSERT(F.make_writable());
+        OIIO_CHECK_NE(constpixels(F), constpixels(A));
+        OIIO_CHECK_EQUAL(F.getchannel(1, 1, 0, 2), 0.75f);
+        for (ImageBuf::Iterator<float> it(C); !it.done(); ++it)
+            it[0] = 0.0f;
+        OIIO_CHECK_NE(constpixels(C), constpixels(A));
+        OIIO_CHECK_EQUAL(C.getchannel(2, 2, 0, 0), 0.0f);
+        ImageBuf D(A);
+        ImageBufAlgo::fill(D, { 0.0f, 0.0f, 0.0f });
+        OIIO_CHECK_NE(constpixels(D), constpixels(A));
+        OIIO_CHECK_EQUAL(ImageBufAlgo::compare(A, ref, 0.0f, 0.0f).nfail, 0);
+        // Writing the original instead leaves the copy unchanged.
+        ImageBuf E(A);
+        ImageBufAlgo::zero(A);
+        OIIO_CHECK_EQUAL(ImageBufAlgo::compare(E, ref, 0.0f, 0.0f).nfail, 0);
+        A = E;
+    }
+    // Nothing is left allocated once the copies are gone.
+    OIIO_CHECK_EQUAL(localmem(), before);
+    {
+        // Copies of one buffer may be written concurrently
+        std::vector<ImageBuf> copies(8, A);
+        parallel_for(0, int(copies.size()), [&](int i) {
+            ImageBufAlgo::fill(copies[i], { float(i), 0.0f, 0.0f });
+        });
+        for (int i = 0; i < int(copies.size()); ++i)
+            OIIO_CHECK_EQUAL(copies[i].getchannel(3, 3, 0, 0), float(i));
+        OIIO_CHECK_EQUAL(ImageBufAlgo::compare(A, ref, 0.0f, 0.0f).nfail, 0);
+    }
+    // Converting the type, or turning it off, copies the pixels
+    {
+        ImageBuf B;
+        B.copy(A, TypeHalf);
+        OIIO_CHECK_NE(constpixels(B), constpixels(A));
+        OIIO::attribute("imagebuf:copy_on_write", 0);
+        ImageBuf C(A);
+        OIIO_CHECK_NE(constpixels(C), constpixels(A));
+    }
+
+    Benchmarker bench;
+    bench.units(Benchmarker::Unit::us);
+    ImageBuf big(ImageSpec(2048, 2048, 4, TypeFloat));
+    ImageBufAlgo::fill(big, { 0.5f, 0.5f, 0.5f, 1.0f });
+    for (int cow : { 0, 1 }) {
+        OIIO::attribute("imagebuf:copy_on_write", cow);
+        bench(cow ? "  copy 2K float image (copy on write)"
+                  : "  copy 2K float image                ",
+              [&]() { ImageBuf R(big); });
+    }
+    OIIO::attribute("imagebuf:copy_on_write", 0);
+}
+
+
+
+// With a process-wide "max_memory_MB", allocating an ImageBuf makes the
+// ImageCaches give up tiles, and DeepData samples are counted too.
+static void
+test_memory_budget()
+{
+    std::cout << "test memory budget\n";
+    auto mem = [](const char* name) {
+        long long bytes = 0;
+        OIIO::getattribute(name, TypeInt64, &bytes);
+        return bytes;
+    };
+    const long long MB = 1 << 20;
+
+    {
+        DeepData dd(ImageSpec(256, 256, 4, TypeFloat));
+        long long before = mem("DD_mem_current");
+        dd.set_all_samples(std::vector<unsigned int>(256 * 256, 4));
+        OIIO_CHECK_EQUAL(dd.all_data().size(), size_t(256 * 256 * 4 * 16));
+        OIIO_CHECK_GE(mem("DD_mem_current") - before, 256 * 256 * 4 * 16);
+        dd.free();
+        OIIO_CHECK_EQUAL(mem("DD_mem_current"), before);
+    }
+
+    // Fill a cache with 4 MB of tiles
+    const char* filename = "budget_imagebuf_test.tif";
+    ImageSpec spec(512, 512, 4, TypeFloat);
+    spec.tile_width = spec.tile_height = 64;
+    ImageBuf file(spec);
+    ImageBufAlgo::fill(file, { 0.25f, 0.5f, 0.75f, 1.0f });
+    OIIO_CHECK_ASSERT(file.write(filename));
+    file.reset();
+    auto ic = ImageCache::create(false /*not shared*/);
+    std::vector<float> pixels(512 * 512 * 4);
+    OIIO_CHECK_ASSERT(ic->get_pixels(ustring(filename), 0, 0, 0, 512, 0, 512,
+                                     0, 1, TypeFloat, pixels.data()));
+    long long cached = 0;
+    ic->getattribute("stat:cache_memory_used", TypeInt64, &cached);
+    OIIO_CHECK_GE(cached, 4 * MB);
+
+    // Then make an ImageBuf that only fits if the cache frees some tiles
+    long long budget = (mem("total_mem_current") + MB - 1) / MB;
+    OIIO::attribute("max_memory_MB", int(budget));
+    {
+        ImageBuf A(ImageSpec(512, 256, 4, TypeFloat));
+        long long after = 0;
+        ic->getattribute("stat:cache_memory_used", TypeInt64, &after);
+        OIIO_CHECK_LE(after, cached - MB);
+        OIIO_CHECK_LE(mem("total_mem_current"), budget * MB);
+    }
+    OIIO::attribute("max_memory_MB", 0);
+    ic.reset();
+    Filesystem::remove(filename);
+}
+
+
+
+// ImageBufAlgo::channels of a run of consecutive channels is a view of the
+// source's pixels until one or the other is written.
+static void
+test_channel_views()
+{
+    std::cout << "test channel views\n";
+    auto constpixels = [](const ImageBuf& buf) {
+        return (const char*)buf.localpixels();
+    };
+    ImageSpec spec(16, 8, 6, TypeFloat);
+    spec.channelnames = { "R", "G", "B", "A", "Z", "N" };
+    spec.alpha_channel = 3;
+    spec.z_channel     = 4;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f });
+    ImageBuf ref = ImageBufAlgo::copy(A, TypeUnknown);
+
+    // Without copy on write, the channels are simply copied
+    ImageBuf U = ImageBufAlgo::channels(A, 3, { 2, 3, 4 });
+    OIIO_CHECK_ASSERT(U.contiguous());
+    OIIO_CHECK_EQUAL(U.getchannel(5, 5, 0, 0), 2.0f);
+
+    OIIO::attribute("imagebuf:copy_on_write", 1);
+    ImageBuf V = ImageBufAlgo::channels(A, 3, { 2, 3, 4 });
+    OIIO_CHECK_EQUAL(constpixels(V), constpixels(A) + 2 * sizeof(float));
+    OIIO_CHECK_ASSERT(!V.contiguous());
+    OIIO_CHECK_EQUAL(V.pixel_stride(), A.pixel_stride());
+    OIIO_CHECK_EQUAL(V.spec().channelnames[0], "B");
+    OIIO_CHECK_EQUAL(V.spec().alpha_channel, 1);
+    OIIO_CHECK_EQUAL(V.spec().z_channel, 2);
+    OIIO_CHECK_EQUAL(V.getchannel(5, 5, 0, 0), 2.0f);
+    OIIO_CHECK_EQUAL(V.getchannel(15, 7, 0, 2), 4.0f);
+    ImageBuf sum = ImageBufAlgo::add(V, 1.0f);
+    OIIO_CHECK_EQUAL(sum.nchannels(), 3);
+    OIIO_CHECK_EQUAL(sum.getchannel(3, 4, 0, 1), 4.0f);
+
+    // Copying a view shares its pixels too
+    ImageBuf W(V);
+    OIIO_CHECK_EQUAL(constpixels(W), constpixels(V));
+
+    // Writing the view gives it its own compact copy of its channels...
+    V.setpixel(1, 1, { 9.0f, 9.0f, 9.0f });
+    OIIO_CHECK_ASSERT(V.contiguous());
+    OIIO_CHECK_NE(constpixels(V), constpixels(A) + 2 * sizeof(float));
+    OIIO_CHECK_EQUAL(V.getchannel(1, 1, 0, 0), 9.0f);
+    OIIO_CHECK_EQUAL(V.getchannel(2, 1, 0, 0), 2.0f);
+    OIIO_CHECK_EQUAL(V.getchannel(2, 1, 0, 2), 4.0f);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compare(A, ref, 0.0f, 0.0f).nfail, 0);
+    // ...and writing the source leaves the views of it unchanged.
+    ImageBufAlgo::zero(A);
+    OIIO_CHECK_EQUAL(W.getchannel(1, 1, 0, 0), 2.0f);
+    OIIO_CHECK_EQUAL(W.getchannel(1, 1, 0, 1), 3.0f);
+
+    // Reordered channels are copied
+    ImageBuf R = ImageBufAlgo::channels(ref, 3, { 2, 1, 0 });
+    OIIO_CHECK_ASSERT(R.contiguous());
+    OIIO_CHECK_EQUAL(R.getchannel(0, 0, 0, 0), 2.0f);
+
+    Benchmarker bench;
+    bench.units(Benchmarker::Unit::us);
+    ImageBuf big(ImageSpec(2048, 1024, 40, TypeFloat));
+    ImageBufAlgo::zero(big);
+    for (int cow : { 0, 1 }) {
+        OIIO::attribute("imagebuf:copy_on_write", cow);
+        bench(cow ? "  RGB of 40 channel 2K image (view)"
+                  : "  RGB of 40 channel 2K image (copy)",
+              [&]() {
+                  ImageBuf rgb = ImageBufAlgo::channels(big, 3, { 0, 1, 2 });
+              });
+    }
+    OIIO::attribute("imagebuf:copy_on_write", 0);
+}
+
+
+
+
+static void
+test_read_into()
+{
+    std::cout << "test read_into\n";
+    ImageSpec spec(16, 8, 3, TypeFloat);
+    spec.attribute("Artist", "me");
+    ImageBuf src(spec);
+    ImageBufAlgo::fill(src, { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.5f, 0.0f },
+                       { 0.0f, 1.0f, 0.25f }, { 1.0f, 1.0f, 1.0f });
+    src.write("tmp-readinto.exr");
+    ImageBuf ref("tmp-readinto.exr");
+    ref.read(0, 0, true, TypeUInt16);
+
+    // Read into uint16 pixels with a padding channel and padded scanlines
+    const stride_t xstride = 4 * sizeof(uint16_t);
+    const stride_t ystride = 16 * xstride + 32;
+    std::vector<uint16_t> mem(ystride * 8 / sizeof(uint16_t), 0xffff);
+    ImageBuf A(ImageSpec(16, 8, 3, TypeUInt16), make_span(mem), nullptr,
+               xstride, ystride);
+    OIIO_CHECK_ASSERT(A.read_into("tmp-readinto.exr"));
+    OIIO_CHECK_EQUAL(A.storage(), ImageBuf::APPBUFFER);
+    OIIO_CHECK_EQUAL(A.localpixels(), (void*)mem.data());
+    OIIO_CHECK_EQUAL(A.spec().format, TypeUInt16);
+    OIIO_CHECK_EQUAL(A.spec().get_string_attribute("Artist"), "me");
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compare(A, ref, 0.0f, 0.0f).nfail, 0);
+    OIIO_CHECK_EQUAL(mem[3], 0xffff);  // padding left alone
+
+    // A subset of the channels
+    ImageBuf B(ImageSpec(16, 8, 2, TypeFloat));
+    OIIO_CHECK_ASSERT(B.read_into("tmp-readinto.exr", 0, 0, 1, 3));
+    OIIO_CHECK_EQUAL(B.spec().channel_name(0), "G");
+    OIIO_CHECK_EQUAL(B.getchannel(15, 7, 0, 1), 1.0f);
+    OIIO_CHECK_EQUAL(B.getchannel(15, 0, 0, 0), 0.5f);
+
+    // Mismatched resolution or channels are errors
+    ImageBuf C(ImageSpec(8, 8, 3, TypeFloat));
+    OIIO_CHECK_ASSERT(!C.read_into("tmp-readinto.exr"));
+    OIIO_CHECK_ASSERT(C.has_error());
+    C.geterror();
+    OIIO_CHECK_ASSERT(!B.read_into("tmp-readinto.exr"));
+    B.geterror();
+    Filesystem::remove("tmp-readinto.exr");
+}
+
+
+
+static void
+test_working_colorspace()
+{
+    std::cout << "test oiio:WorkingColorSpace\n";
+    const ColorConfig& cc(ColorConfig::default_colorconfig());
+    if (!cc.createColorProcessor("lin_srgb", "sRGB")) {
+        std::cout << "  (skipped, no lin_srgb -> sRGB)\n";
+        return;
+    }
+    ImageSpec spec(64, 16, 3, TypeFloat);
+    ImageBuf lin(spec);
+    ImageBufAlgo::fill(lin, { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.5f, 0.0f },
+                       { 0.0f, 1.0f, 0.25f }, { 1.0f, 1.0f, 1.0f });
+
+    // Writing linear pixels to an sRGB file converts them before
+    // quantizing, as a separate colorconvert would.
+    ImageBuf out;
+    out.copy(lin);
+    out.specmod().set_colorspace("sRGB");
+    out.specmod().attribute("oiio:WorkingColorSpace", "lin_srgb");
+    OIIO_CHECK_ASSERT(out.write("tmp-working.png", TypeUInt8));
+    ImageBuf ref = ImageBufAlgo::colorconvert(lin, "lin_srgb", "sRGB", false);
+    ImageBuf raw("tmp-working.png");
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compare(raw, ref, 0.6f / 255.0f, 0.0f).nfail,
+                     0);
+
+    // Reading with the hint converts back to linear as the file is decoded.
+    ImageSpec config;
+    config.attribute("oiio:WorkingColorSpace", "lin_srgb");
+    ImageBuf back("tmp-working.png", 0, 0, nullptr, &config);
+    OIIO_CHECK_ASSERT(back.read(0, 0, false, TypeFloat));
+    OIIO_CHECK_ASSERT(
+        cc.equivalent(back.spec().get_string_attribute("oiio:ColorSpace"),
+                      "lin_srgb"));
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compare(back, lin, 0.02f, 0.0f).nfail, 0);
+    ImageBuf rawback = ImageBufAlgo::colorconvert(raw, "sRGB", "lin_srgb",
+                                                  false);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compare(back, rawback, 1.0e-5f, 0.0f).nfail,
+                     0);
+    Filesystem::remove("tmp-working.png");
+}
+
+
+
+static void
+test_read_subimages()
+{
+    std::cout << "test read_subimages\n";
+    // A multi-image TIFF whose directories differ in size and channels
+    const int nsub = 5;
+    std::vector<ImageSpec> specs;
+    for (int s = 0; s < nsub; ++s)
+        specs.emplace_back(8 + s, 4, 1 + s % 4, TypeUInt8);
+    auto out = ImageOutput::create("tmp-subimages.tif");
+    OIIO_CHECK_ASSERT(out);
+    OIIO_CHECK_ASSERT(out->open("tmp-subimages.tif", nsub, specs.data()));
+    for (int s = 0; s < nsub; ++s) {
+        if (s)
+            out->open("tmp-subimages.tif", specs[s],
+                      ImageOutput::AppendSubimage);
+        std::vector<float> val(specs[s].nchannels, float(s) / nsub);
+        ImageBuf img(specs[s]);
+        ImageBufAlgo::fill(img, val);
+        OIIO_CHECK_ASSERT(img.write(out.get()));
+    }
+    out->close();
+
+    std::vector<ImageBuf> all = ImageBuf::read_subimages("tmp-subimages.tif");
+    OIIO_CHECK_EQUAL(all.size(), size_t(nsub));
+    for (int s = 0; s < nsub && s < int(all.size()); ++s) {
+        OIIO_CHECK_EQUAL(all[s].spec().width, specs[s].width);
+        OIIO_CHECK_EQUAL(all[s].nchannels(), specs[s].nchannels);
+        OIIO_CHECK_EQUAL(all[s].spec().format, TypeUInt8);
+        OIIO_CHECK_EQUAL(all[s].storage(), ImageBuf::LOCALBUFFER);
+        OIIO_CHECK_EQUAL(all[s].getchannel(2, 1, 0, 0),
+                         float(int(s * 255.0f / nsub + 0.5f)) / 255.0f);
+    }
+
+    // A selection, in any order, converted; a missing one is an error
+    int some[]                = { 3, 1, 7 };
+    std::vector<ImageBuf> sel = ImageBuf::read_subimages("tmp-subimages.tif",
+                                                         some, TypeFloat);
+    OIIO_CHECK_EQUAL(sel.size(), size_t(3));
+    OIIO_CHECK_EQUAL(sel[0].spec().width, specs[3].width);
+    OIIO_CHECK_EQUAL(sel[0].spec().format, TypeFloat);
+    OIIO_CHECK_EQUAL(sel[1].nchannels(), specs[1].nchannels);
+    OIIO_CHECK_ASSERT(!sel[2].initialized());
+    OIIO_CHECK_ASSERT(sel[2].has_error());
+    sel[2].geterror();
+
+    OIIO_CHECK_ASSERT(ImageBuf::read_subimages("tmp-nonexistent.tif").empty());
+    OIIO::geterror();
+    Filesystem::remove("tmp-subimages.tif");
+}
+
+
+
 int
 main(int /*argc*/, char* /*argv*/[])
 {
@@ -734,6 +1388,7 @@ main(int /*argc*/, char* /*argv*/[])
     iterator_wrap_test<ImageBuf::ConstIterator<float>>(ImageBuf::WrapMirror,
                                                        "mirror");
     test_mutable_iterator_with_imagecache();
+    test_iterator_runs();
     time_iterators();
     test_iterator_concurrency();
 
@@ -746,6 +1401,15 @@ main(int /*argc*/, char* /*argv*/[])
     time_get_pixels();
 
     test_write_over();
+    test_pixel_pool();
+    test_deepdata_capacity();
+    test_padded_scanlines();
+    test_copy_on_write();
+    test_memory_budget();
+    test_channel_views();
+    test_read_into();
+    test_read_subimages();
+    test_working_colorspace();
 
     test_uncaught_error();
 
@@ -4,7 +4,10 @@
 
 #include <algorithm>
 #include <cmath>
+#include <complex>
 #include <memory>
+#include <type_traits>
+#include <vector>
 
 #include <OpenImageIO/half.h>
 
@@ -248,9 +251,11 @@ ImageBufAlgo::IBAprep(ROI& roi, ImageBuf* dst, const ImageBuf* A,
             // Since we're altering pixels, be sure that any existing SHA
             // hash of dst's pixel values is erased.
             spec.erase_attribute("oiio:SHA-1");
+            spec.erase_attribute("oiio:ContentHash");
             std::string desc = spec.get_string_attribute("ImageDescription");
             if (desc.size()) {
                 Strutil::excise_string_after_head(desc, "oiio:SHA-1=");
+                Strutil::excise_string_after_head(desc, "oiio:ContentHash=");
                 spec.attribute("ImageDescription", desc);
             }
         }
@@ -531,9 +536,11 @@ ImageBufAlgo::IBAprep(ROI& roi, ImageBuf& dst, cspan<const ImageBuf*> srcs,
             // Since we're altering pixels, be sure that any existing SHA
             // hash of dst's pixel values is erased.
             spec.erase_attribute("oiio:SHA-1");
+            spec.erase_attribute("oiio:ContentHash");
             std::string desc = spec.get_string_attribute("ImageDescription");
             if (desc.size()) {
                 Strutil::excise_string_after_head(desc, "oiio:SHA-1=");
+                Strutil::excise_string_after_head(desc, "oiio:ContentHash=");
                 spec.attribute("ImageDescription", desc);
             }
         }
@@ -778,9 +785,16 @@ convolve_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& kernel,
     using namespace ImageBufAlgo;
     OIIO_DASSERT(kernel.spec().format == TypeDesc::FLOAT && kernel.localpixels()
                  && "kernel should be float and in local memory");
-    parallel_image(roi, nthreads, [&](ROI roi) {
-        ROI kroi   = kernel.roi();
-        int kchans = kernel.nchannels();
+    // The weights (the first channel), in order, since the kernel's
+    // scanlines may be padded.
+    ROI kroi = kernel.roi();
+    std::vector<float> weights(kroi.npixels());
+    kernel.get_pixels(ROI(kroi.xbegin, kroi.xend, kroi.ybegin, kroi.yend,
+                          kroi.zbegin, kroi.zend, 0, 1),
+                      make_span(weights));
+    // Tiles, rather than bands, keep the neighborhoods in cache
+    paropt opt(nthreads, paropt::SplitDir::Tile);
+    parallel_image(roi, opt, [&](ROI roi) {
 
         float scale = 1.0f;
         if (normalize) {
@@ -796,12 +810,12 @@ convolve_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& kernel,
         for (; !d.done(); ++d) {
             for (int c = roi.chbegin; c < roi.chend; ++c)
                 sum[c] = 0.0f;
-            const float* k = (const float*)kernel.localpixels();
+            const float* k = weights.data();
             s.rerange(d.x() + kroi.xbegin, d.x() + kroi.xend,
                       d.y() + kroi.ybegin, d.y() + kroi.yend,
                       d.z() + kroi.zbegin, d.z() + kroi.zend,
                       ImageBuf::WrapClamp);
-            for (; !s.done(); ++s, k += kchans) {
+            for (; !s.done(); ++s, ++k) {
                 for (int c = roi.chbegin; c < roi.chend; ++c)
                     sum[c] += k[0] * s[c];
             }
@@ -814,12 +828,209 @@ convolve_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& kernel,
 
 
 
-bool
-ImageBufAlgo::convolve(ImageBuf& dst, const ImageBuf& src,
-                       const ImageBuf& kernel, bool normalize, ROI roi,
-                       int nthreads)
+// If the 2D float kernel K is the outer product of a column and a row
+// (within rounding), return true and fill in `col` and `row`.
+static bool
+separate_kernel(const ImageBuf& K, std::vector<float>& col,
+                std::vector<float>& row)
 {
-    pvt::LoggedTimer logtime("IBA::convolve");
+    const ROI kroi = K.roi();
+    if (kroi.depth() != 1)
+        return false;
+    auto k = [&](int x, int y) {
+        return *(const float*)K.pixeladdr(kroi.xbegin + x, kroi.ybegin + y,
+                                          kroi.zbegin);
+    };
+    const int w = kroi.width(), h = kroi.height();
+    // The largest value is the most accurate pivot.
+    int xpivot = 0, ypivot = 0;
+    float biggest = 0.0f;
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            if (fabsf(k(x, y)) > biggest) {
+                biggest = fabsf(k(x, y));
+                xpivot  = x;
+                ypivot  = y;
+            }
+    if (biggest == 0.0f)
+        return false;
+    row.resize(w);
+    col.resize(h);
+    for (int x = 0; x < w; ++x)
+        row[x] = k(x, ypivot);
+    for (int y = 0; y < h; ++y)
+        col[y] = k(xpivot, y) / k(xpivot, ypivot);
+    const float tolerance = 1.0e-5f * biggest;
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            if (fabsf(k(x, y) - col[y] * row[x]) > tolerance)
+                return false;
+    return true;
+}
+
+
+
+// Convolve with the separable kernel K == col * row, scaled by `scale`: a
+// horizontal pass over enough extra rows for the vertical one, then the
+// vertical pass, each with the direct convolve_.
+static bool
+convolve_separable(ImageBuf& dst, const ImageBuf& src, const ImageBuf& K,
+                   cspan<float> col, cspan<float> row, float scale, ROI roi,
+                   int nthreads)
+{
+    const ROI kroi = K.roi();
+    ImageSpec hspec(kroi.width(), 1, 1, TypeFloat);
+    hspec.x = kroi.xbegin;
+    ImageBuf H(hspec);
+    for (int x = 0; x < kroi.width(); ++x)
+        *(float*)H.pixeladdr(hspec.x + x, 0) = scale * row[x];
+    ImageSpec vspec(1, kroi.height(), 1, TypeFloat);
+    vspec.y = kroi.ybegin;
+    ImageBuf V(vspec);
+    for (int y = 0; y < kroi.height(); ++y)
+        *(float*)V.pixeladdr(0, vspec.y + y) = col[y];
+
+    ImageSpec tspec(roi.width(), roi.height() + kroi.height() - 1,
+                    src.nchannels(), TypeFloat);
+    tspec.x = roi.xbegin;
+    tspec.y = roi.ybegin + kroi.ybegin;
+    tspec.z = roi.zbegin;
+    ImageBuf T(tspec);
+    ROI troi     = T.roi();
+    troi.chbegin = roi.chbegin;
+    troi.chend   = roi.chend;
+    bool ok;
+    OIIO_DISPATCH_COMMON_TYPES2(ok, "convolve", convolve_, TypeFloat,
+                                src.spec().format, T, src, H, false, troi,
+                                nthreads);
+    if (!ok) {
+        dst.errorfmt("{}", T.geterror());
+        return false;
+    }
+    OIIO_DISPATCH_COMMON_TYPES2(ok, "convolve", convolve_, dst.spec().format,
+                                TypeFloat, dst, T, V, false, roi, nthreads);
+    return ok;
+}
+
+
+
+// Smallest size of at least n with no prime factors but 2, 3, and 5, the
+// sizes for which kissfft is fastest.
+static int
+fft_size(int n)
+{
+    for (;; ++n) {
+        int m = n;
+        for (int p : { 2, 3, 5 })
+            while (m % p == 0)
+                m /= p;
+        if (m == 1)
+            return n;
+    }
+}
+
+
+
+// In-place unnormalized 2D DFT (or inverse) of nx x ny complex values.
+static void
+fft2d(std::complex<float>* data, int nx, int ny, bool inverse, int nthreads)
+{
+    parallel_for_range(
+        0, ny,
+        [&](int ybegin, int yend) {
+            kissfft<float> F(nx, inverse);
+            std::vector<std::complex<float>> tmp(nx);
+            for (int y = ybegin; y < yend; ++y) {
+                std::complex<float>* rowdata = data + size_t(y) * nx;
+                F.transform(rowdata, tmp.data());
+                std::copy(tmp.begin(), tmp.end(), rowdata);
+            }
+        },
+        paropt(nthreads));
+    parallel_for_range(
+        0, nx,
+        [&](int xbegin, int xend) {
+            kissfft<float> F(ny, inverse);
+            std::vector<std::complex<float>> column(ny), tmp(ny);
+            for (int x = xbegin; x < xend; ++x) {
+                for (int y = 0; y < ny; ++y)
+                    column[y] = data[size_t(y) * nx + x];
+                F.transform(column.data(), tmp.data());
+                for (int y = 0; y < ny; ++y)
+                    data[size_t(y) * nx + x] = tmp[y];
+            }
+        },
+        paropt(nthreads));
+}
+
+
+
+// Convolve by multiplying the Fourier transforms of the 2D kernel and of
+// the part of src it covers, channel by channel. The source is extended
+// by clamping to its edges, as in convolve_, and padded with zeroes to a
+// size that keeps the circular convolution from wrapping around.
+template<typename DSTTYPE, typename SRCTYPE>
+static bool
+convolve_fft_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& kernel,
+              float scale, ROI roi, int nthreads)
+{
+    using cfloat   = std::complex<float>;
+    const ROI kroi = kernel.roi();
+    const int nx   = fft_size(roi.width() + kroi.width() - 1);
+    const int ny   = fft_size(roi.height() + kroi.height() - 1);
+    const size_t n = size_t(nx) * size_t(ny);
+
+    // The kernel's spectrum, with the normalization and the 1/n of the
+    // inverse transform folded in. It is conjugated because convolve_()
+    // actually computes a correlation (it doesn't flip the kernel).
+    std::vector<cfloat> K(n), P(n);
+    const float norm = scale / float(n);
+    for (ImageBuf::ConstIterator<float> k(kernel); !k.done(); ++k)
+        K[size_t(k.y() - kroi.ybegin) * nx + (k.x() - kroi.xbegin)] = norm
+                                                                      * k[0];
+    fft2d(K.data(), nx, ny, false, nthreads);
+    for (auto& v : K)
+        v = std::conj(v);
+
+    ROI sroi(roi.xbegin + kroi.xbegin, roi.xend + kroi.xend - 1,
+             roi.ybegin + kroi.ybegin, roi.yend + kroi.yend - 1, roi.zbegin,
+             roi.zend);
+    for (int c = roi.chbegin; c < roi.chend; ++c) {
+        std::fill(P.begin(), P.end(), cfloat(0.0f));
+        ImageBufAlgo::parallel_image(sroi, nthreads, [&](ROI r) {
+            ImageBuf::ConstIterator<SRCTYPE> s(src, r, ImageBuf::WrapClamp);
+            for (; !s.done(); ++s)
+                P[size_t(s.y() - sroi.ybegin) * nx + (s.x() - sroi.xbegin)]
+                    = s[c];
+        });
+        fft2d(P.data(), nx, ny, false, nthreads);
+        for (size_t i = 0; i < n; ++i)
+            P[i] *= K[i];
+        fft2d(P.data(), nx, ny, true, nthreads);
+        ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI r) {
+            for (ImageBuf::Iterator<DSTTYPE> d(dst, r); !d.done(); ++d)
+                d[c] = P[size_t(d.y() - roi.ybegin) * nx + (d.x() - roi.xbegin)]
+                           .real();
+        });
+    }
+    return true;
+}
+
+
+
+// Kernels of at least this many pixels are convolved by FFT by default.
+static const int fft_min_kernel_pixels = 256;
+
+static bool
+convolve_impl(ImageBuf& dst, const ImageBuf& src, const ImageBuf& kernel,
+              bool normalize, string_view method, ROI roi, int nthreads)
+{
+    if (&dst == &src || &dst == &kernel) {  // Handle in-place operation
+        ImageBuf srcshare(src), kernelshare(kernel);
+        return convolve_impl(dst, srcshare, kernelshare, normalize, method,
+                             roi, nthreads);
+    }
+    using namespace ImageBufAlgo;
     if (!IBAprep(roi, &dst, &src, IBAprep_REQUIRE_SAME_NCHANNELS))
         return false;
     bool ok;
@@ -830,6 +1041,49 @@ ImageBufAlgo::convolve(ImageBuf& dst, const ImageBuf& src,
         Ktmp.copy(kernel, TypeDesc::FLOAT);
         K = &Ktmp;
     }
+    const ROI kroi = K->roi();
+    float scale    = 1.0f;
+    if (normalize) {
+        scale = 0.0f;
+        for (ImageBuf::ConstIterator<float> k(*K); !k.done(); ++k)
+            scale += k[0];
+        scale = 1.0f / scale;
+    }
+
+    // The separable and FFT methods only handle 2D kernels and regions.
+    const bool flat = kroi.depth() == 1 && roi.depth() == 1;
+    std::vector<float> col, row;
+    const bool separable = flat && separate_kernel(*K, col, row);
+    if (method == "auto" || method.empty()) {
+        if (separable && kroi.width() > 1 && kroi.height() > 1)
+            method = "separable";
+        else if (flat && kroi.npixels() >= fft_min_kernel_pixels)
+            method = "fft";
+        else
+            method = "direct";
+    }
+    if (method == "separable") {
+        if (!separable) {
+            dst.errorfmt("convolve: kernel is not separable");
+            return false;
+        }
+        return convolve_separable(dst, src, *K, col, row, scale, roi,
+                                  nthreads);
+    }
+    if (method == "fft") {
+        if (!flat) {
+            dst.errorfmt("convolve: \"fft\" requires a 2D kernel and image");
+            return false;
+        }
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "convolve", convolve_fft_,
+                                    dst.spec().format, src.spec().format, dst,
+                                    src, *K, scale, roi, nthreads);
+        return ok;
+    }
+    if (method != "direct") {
+        dst.errorfmt("convolve: unknown method \"{}\"", method);
+        return false;
+    }
     OIIO_DISPATCH_COMMON_TYPES2(ok, "convolve", convolve_, dst.spec().format,
                                 src.spec().format, dst, src, *K, normalize, roi,
                                 nthreads);
@@ -838,6 +1092,29 @@ ImageBufAlgo::convolve(ImageBuf& dst, const ImageBuf& src,
 
 
 
+bool
+ImageBufAlgo::convolve(ImageBuf& dst, const ImageBuf& src,
+                       const ImageBuf& kernel, bool normalize, ROI roi,
+                       int nthreads)
+{
+    pvt::LoggedTimer logtime("IBA::convolve");
+    return convolve_impl(dst, src, kernel, normalize, "auto", roi, nthreads);
+}
+
+
+
+bool
+ImageBufAlgo::convolve(ImageBuf& dst, const ImageBuf& src,
+                       const ImageBuf& kernel, KWArgs options, ROI roi,
+                       int nthreads)
+{
+    pvt::LoggedTimer logtime("IBA::convolve");
+    return convolve_impl(dst, src, kernel, options.get_int("normalize", 1),
+                         options.get_string("method", "auto"), roi, nthreads);
+}
+
+
+
 ImageBuf
 ImageBufAlgo::convolve(const ImageBuf& src, const ImageBuf& kernel,
                        bool normalize, ROI roi, int nthreads)
@@ -851,6 +1128,19 @@ ImageBufAlgo::convolve(const ImageBuf& src, const ImageBuf& kernel,
 
 
 
+ImageBuf
+ImageBufAlgo::convolve(const ImageBuf& src, const ImageBuf& kernel,
+                       KWArgs options, ROI roi, int nthreads)
+{
+    ImageBuf result;
+    bool ok = convolve(result, src, kernel, options, roi, nthreads);
+    if (!ok && !result.has_error())
+        result.errorfmt("ImageBufAlgo::convolve() error");
+    return result;
+}
+
+
+
 inline float
 binomial(int n, int k)
 {
@@ -1083,7 +1373,9 @@ static bool
 median_filter_impl(ImageBuf& R, const ImageBuf& A, int width, int height,
                    ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    // Tiles, rather than bands, keep the neighborhoods in cache
+    paropt opt(nthreads, paropt::SplitDir::Tile);
+    ImageBufAlgo::parallel_image(roi, opt, [&](ROI roi) {
         if (width < 1)
             width = 1;
         if (height < 1)
@@ -1126,19 +1418,174 @@ median_filter_impl(ImageBuf& R, const ImageBuf& A, int width, int height,
 
 
 
+// Median filter of 8 or 16 bit images in constant time per pixel, using
+// the sliding histograms of Perreault & Hebert, "Median Filtering in
+// Constant Time" (2007): each column keeps a histogram of the window's
+// rows, updated by one pixel in and one out per row, and the window's
+// histogram moves by one column in and one out per pixel. Histograms are
+// two-level, so that sliding touches only the coarse bins, and only the
+// one segment of fine bins holding the median is brought up to date. The
+// image is done in strips of columns to bound the memory of the column
+// histograms. Other types fall back to median_filter_impl.
+template<class Rtype, class Atype>
+static bool
+median_histogram_impl(ImageBuf& R, const ImageBuf& A, int width, int height,
+                      ROI roi, int nthreads)
+{
+    if constexpr (!std::is_same_v<Atype, uint8_t>
+                  && !std::is_same_v<Atype, uint16_t>) {
+        return median_filter_impl<Rtype, Atype>(R, A, width, height, roi,
+                                                nthreads);
+    } else {
+        constexpr int bits        = 8 * sizeof(Atype);
+        constexpr int nbins       = 1 << bits;
+        constexpr int fine_bits   = bits / 2;
+        constexpr int ncoarse     = 1 << (bits - fine_bits);
+        constexpr int nfine       = 1 << fine_bits;
+        constexpr int stripwidth  = bits == 8 ? 256 : 128;
+        if (width < 1)
+            width = 1;
+        if (height < 1)
+            height = width;
+        const int w_2             = std::max(1, width / 2);
+        const int h_2             = std::max(1, height / 2);
+        const int nchannels       = R.nchannels();
+        const ROI data            = A.roi();
+        const int z               = roi.zbegin;
+        auto strip = [&](int64_t xbegin, int64_t xend) {
+            const int sx0 = int(xbegin), sx1 = int(xend);
+            // The columns any of this strip's windows cover
+            const int cx0   = std::max(sx0 - w_2, data.xbegin);
+            const int cx1   = std::min(sx1 - w_2 + width - 1, data.xend);
+            const int ncols = std::max(0, cx1 - cx0);
+            std::vector<uint16_t> colcoarse(size_t(ncols) * ncoarse);
+            std::vector<uint16_t> colfine(size_t(ncols) * nbins);
+            std::vector<uint32_t> coarse(ncoarse), fine(nbins);
+            // The columns [segbegin,segend) each fine segment holds
+            std::vector<int> segbegin(ncoarse), segend(ncoarse);
+            std::vector<bool> segvalid(ncoarse);
+            for (int c = 0; c < nchannels; ++c) {
+                std::fill(colcoarse.begin(), colcoarse.end(), 0);
+                std::fill(colfine.begin(), colfine.end(), 0);
+                auto add_row = [&](int y, int delta) {
+                    if (y < data.ybegin || y >= data.yend || !ncols)
+                        return;
+                    ImageBuf::ConstIterator<Atype, Atype> a(
+                        A, ROI(cx0, cx1, y, y + 1, z, z + 1));
+                    for (int i = 0; !a.done(); ++a, ++i) {
+                        int bin = a[c];
+                        colcoarse[size_t(i) * ncoarse + (bin >> fine_bits)]
+                            += delta;
+                        colfine[size_t(i) * nbins + bin] += delta;
+                    }
+                };
+                for (int y = roi.ybegin - h_2; y < roi.ybegin - h_2 + height;
+                     ++y)
+                    add_row(y, 1);
+                for (int y = roi.ybegin; y < roi.yend; ++y) {
+                    if (y > roi.ybegin) {
+                        add_row(y - 1 - h_2, -1);
+                        add_row(y - h_2 + height - 1, 1);
+                    }
+                    const int rows = std::max(
+                        0, std::min(y - h_2 + height, data.yend)
+                               - std::max(y - h_2, data.ybegin));
+                    std::fill(coarse.begin(), coarse.end(), 0);
+                    std::fill(segvalid.begin(), segvalid.end(), false);
+                    int cbegin = 0, cend = 0;  // Columns in `coarse`
+                    ImageBuf::Iterator<Rtype> r(R, ROI(sx0, sx1, y, y + 1, z,
+                                                       z + 1));
+                    for (int x = sx0; x < sx1; ++x, ++r) {
+                        const int wx = x - w_2 - cx0;  // Window start
+                        int nbegin   = OIIO::clamp(wx, 0, ncols);
+                        int nend     = OIIO::clamp(wx + width, 0, ncols);
+                        for (; cbegin < nbegin; ++cbegin)
+                            for (int k = 0; k < ncoarse; ++k)
+                                coarse[k] -= colcoarse[cbegin * ncoarse + k];
+                        for (; cend < nend; ++cend)
+                            for (int k = 0; k < ncoarse; ++k)
+                                coarse[k] += colcoarse[cend * ncoarse + k];
+                        const uint32_t n = uint32_t(cend - cbegin) * rows;
+                        if (!n) {
+                            r[c] = 0.0f;
+                            continue;
+                        }
+                        // Find the coarse bin, then the fine bin, of the
+                        // value with n/2 below it.
+                        const uint32_t target = n / 2;
+                        uint32_t below        = 0;
+                        int k                 = 0;
+                        while (below + coarse[k] <= target)
+                            below += coarse[k++];
+                        uint32_t* seg = &fine[k * nfine];
+                        auto add_col  = [&](int i, int sign) {
+                            const uint16_t* f = &colfine[size_t(i) * nbins
+                                                         + k * nfine];
+                            for (int j = 0; j < nfine; ++j)
+                                seg[j] += sign * f[j];
+                        };
+                        if (segvalid[k] && cbegin <= segend[k]
+                            && (cbegin - segbegin[k]) + (cend - segend[k])
+                                   < cend - cbegin) {
+                            for (int i = segbegin[k]; i < cbegin; ++i)
+                                add_col(i, -1);
+                            for (int i = segend[k]; i < cend; ++i)
+                                add_col(i, 1);
+                        } else {
+                            std::fill(seg, seg + nfine, 0);
+                            for (int i = cbegin; i < cend; ++i)
+                                add_col(i, 1);
+                        }
+                        segbegin[k] = cbegin;
+                        segend[k]   = cend;
+                        segvalid[k] = true;
+                        int j       = 0;
+                        while (below + seg[j] <= target)
+                            below += seg[j++];
+                        r[c] = convert_type<Atype, float>(
+                            Atype(k * nfine + j));
+                    }
+                }
+            }
+        };
+        parallel_for_chunked(roi.xbegin, roi.xend, stripwidth, strip,
+                             paropt(nthreads));
+        return true;
+    }
+}
+
+
+
 bool
 ImageBufAlgo::median_filter(ImageBuf& dst, const ImageBuf& src, int width,
                             int height, ROI roi, int nthreads)
 {
+    if (&dst == &src) {  // Handle in-place operation
+        ImageBuf srcshare(src);
+        return median_filter(dst, srcshare, width, height, roi, nthreads);
+    }
     pvt::LoggedTimer logtime("IBA::median_filter");
     if (!IBAprep(roi, &dst, &src,
                  IBAprep_REQUIRE_SAME_NCHANNELS | IBAprep_NO_SUPPORT_VOLUME))
         return false;
 
     bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "median_filter", median_filter_impl,
-                                dst.spec().format, src.spec().format, dst, src,
-                                width, height, roi, nthreads);
+    // Sliding histograms take constant time per pixel, but with enough
+    // overhead that sorting is faster for small windows.
+    const TypeDesc format = src.spec().format;
+    const int area = std::max(1, width) * (height < 1 ? std::max(1, width)
+                                                        : height);
+    if (pvt::imagebufalgo_fastpaths && height < 65536
+        && ((format == TypeUInt8 && area >= 49)
+            || (format == TypeUInt16 && area >= 225))) {
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "median_filter", median_histogram_impl,
+                                    dst.spec().format, format, dst, src, width,
+                                    height, roi, nthreads);
+    } else {
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "median_filter", median_filter_impl,
+                                    dst.spec().format, format, dst, src, width,
+                                    height, roi, nthreads);
+    }
     return ok;
 }
 
@@ -1164,7 +1611,9 @@ static bool
 morph_impl(ImageBuf& R, const ImageBuf& A, int width, int height, MorphOp op,
            ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    // Tiles, rather than bands, keep the neighborhoods in cache
+    paropt opt(nthreads, paropt::SplitDir::Tile);
+    ImageBufAlgo::parallel_image(roi, opt, [&](ROI roi) {
         if (width < 1)
             width = 1;
         if (height < 1)
@@ -1208,19 +1657,134 @@ morph_impl(ImageBuf& R, const ImageBuf& A, int width, int height, MorphOp op,
 
 
 
+// Set out[j] to the maximum (or minimum, for MorphErode) of
+// in[j .. j+width-1], for j in [0,n), given n+width-1 inputs, with three
+// comparisons per output however wide the window: the algorithm of van
+// Herk (1992) and Gil & Werman (1993), which combines the running extremes
+// within blocks of `width` inputs from the left and from the right.
+static void
+running_extreme(const float* in, int n, int width, float* out, float* left,
+                float* right, MorphOp morphop)
+{
+    auto op = [morphop](float a, float b) {
+        return morphop == MorphDilate ? std::max(a, b) : std::min(a, b);
+    };
+    const int len = n + width - 1;
+    for (int t = 0; t < len; ++t)
+        left[t] = (t % width == 0) ? in[t] : op(left[t - 1], in[t]);
+    for (int t = len - 1; t >= 0; --t)
+        right[t] = (t % width == width - 1 || t == len - 1)
+                       ? in[t]
+                       : op(right[t + 1], in[t]);
+    for (int j = 0; j < n; ++j)
+        out[j] = op(right[j], left[j + width - 1]);
+}
+
+
+
+// Dilate or erode as a horizontal and then a vertical running extreme.
+// Pixels outside the data window don't count, as in morph_impl.
+template<class Rtype, class Atype>
+static bool
+morph_separable_impl(ImageBuf& R, const ImageBuf& A, int width, int height,
+                     MorphOp op, ROI roi, int nthreads)
+{
+    if (width < 1)
+        width = 1;
+    if (height < 1)
+        height = width;
+    const int w_2       = std::max(1, width / 2);
+    const int h_2       = std::max(1, height / 2);
+    const int nchannels = R.nchannels();
+    const ROI data      = A.roi();
+    const float none    = op == MorphDilate
+                              ? -std::numeric_limits<float>::max()
+                              : std::numeric_limits<float>::max();
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        const int nx = roi.width(), ny = roi.height();
+        const int z  = roi.zbegin;
+        // The rows of A that this region's windows cover.
+        const int y0    = roi.ybegin - h_2;
+        const int nrows = ny + height - 1;
+        const int len   = std::max(nx + width - 1, nrows);
+        std::vector<float> in(len), out(len), left(len), right(len);
+        // Horizontal pass, into rows of H (one per channel).
+        std::vector<float> H(size_t(nchannels) * nrows * nx, none);
+        std::vector<float> row(size_t(nchannels) * (nx + width - 1));
+        const int x0 = roi.xbegin - w_2;
+        for (int i = 0; i < nrows; ++i) {
+            const int y = y0 + i;
+            if (y < data.ybegin || y >= data.yend)
+                continue;
+            std::fill(row.begin(), row.end(), none);
+            const int xbegin = std::max(x0, data.xbegin);
+            const int xend   = std::min(x0 + nx + width - 1, data.xend);
+            if (xbegin >= xend)
+                continue;
+            ImageBuf::ConstIterator<Atype> a(A, ROI(xbegin, xend, y, y + 1, z,
+                                                    z + 1));
+            for (; !a.done(); ++a)
+                for (int c = 0; c < nchannels; ++c)
+                    row[size_t(a.x() - x0) * nchannels + c] = a[c];
+            for (int c = 0; c < nchannels; ++c) {
+                for (int t = 0; t < nx + width - 1; ++t)
+                    in[t] = row[size_t(t) * nchannels + c];
+                running_extreme(in.data(), nx, width,
+                                &H[(size_t(c) * nrows + i) * nx], left.data(),
+                                right.data(), op);
+            }
+        }
+        // Vertical pass, into R.
+        std::vector<float> V(size_t(nchannels) * ny * nx);
+        for (int c = 0; c < nchannels; ++c) {
+            const float* h = &H[size_t(c) * nrows * nx];
+            for (int x = 0; x < nx; ++x) {
+                for (int i = 0; i < nrows; ++i)
+                    in[i] = h[size_t(i) * nx + x];
+                running_extreme(in.data(), ny, height, out.data(),
+                                left.data(), right.data(), op);
+                for (int j = 0; j < ny; ++j)
+                    V[(size_t(j) * nx + x) * nchannels + c] = out[j];
+            }
+        }
+        const float* v = V.data();
+        for (ImageBuf::Iterator<Rtype> r(R, roi); !r.done(); ++r) {
+            for (int c = 0; c < nchannels; ++c)
+                r[c] = v[c];
+            v += nchannels;
+        }
+    });
+    return true;
+}
+
+
+
 bool
 ImageBufAlgo::dilate(ImageBuf& dst, const ImageBuf& src, int width, int height,
                      ROI roi, int nthreads)
 {
+    if (&dst == &src) {  // Handle in-place operation
+        ImageBuf srcshare(src);
+        return dilate(dst, srcshare, width, height, roi, nthreads);
+    }
     pvt::LoggedTimer logtime("IBA::dilate");
     if (!IBAprep(roi, &dst, &src,
                  IBAprep_REQUIRE_SAME_NCHANNELS | IBAprep_NO_SUPPORT_VOLUME))
         return false;
 
     bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "dilate", morph_impl, dst.spec().format,
-                                src.spec().format, dst, src, width, height,
-                                MorphDilate, roi, nthreads);
+    if (pvt::imagebufalgo_fastpaths
+        && std::max(1, width) * std::max(1, height < 1 ? width : height)
+               >= 16) {
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "dilate", morph_separable_impl,
+                                    dst.spec().format, src.spec().format, dst,
+                                    src, width, height, MorphDilate, roi,
+                                    nthreads);
+    } else {
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "dilate", morph_impl, dst.spec().format,
+                                    src.spec().format, dst, src, width, height,
+                                    MorphDilate, roi, nthreads);
+    }
     return ok;
 }
 
@@ -1243,15 +1807,28 @@ bool
 ImageBufAlgo::erode(ImageBuf& dst, const ImageBuf& src, int width, int height,
                     ROI roi, int nthreads)
 {
+    if (&dst == &src) {  // Handle in-place operation
+        ImageBuf srcshare(src);
+        return erode(dst, srcshare, width, height, roi, nthreads);
+    }
     pvt::LoggedTimer logtime("IBA::erode");
     if (!IBAprep(roi, &dst, &src,
                  IBAprep_REQUIRE_SAME_NCHANNELS | IBAprep_NO_SUPPORT_VOLUME))
         return false;
 
     bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "erode", morph_impl, dst.spec().format,
-                                src.spec().format, dst, src, width, height,
-                                MorphErode, roi, nthreads);
+    if (pvt::imagebufalgo_fastpaths
+        && std::max(1, width) * std::max(1, height < 1 ? width : height)
+               >= 16) {
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "erode", morph_separable_impl,
+                                    dst.spec().format, src.spec().format, dst,
+                                    src, width, height, MorphErode, roi,
+                                    nthreads);
+    } else {
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "erode", morph_impl, dst.spec().format,
+                                    src.spec().format, dst, src, width, height,
+                                    MorphErode, roi, nthreads);
+    }
     return ok;
 }
 
@@ -1270,6 +1847,356 @@ ImageBufAlgo::erode(const ImageBuf& src, int width, int height, ROI roi,
 
 
 
+namespace {
+
+// Raw view of a summed-area table made by summed_area_table_, for fast
+// lookups of rectangle sums.
+struct SatView {
+    const char* base;  // address of pixel (x0,y0)
+    stride_t xstride, ystride;
+    int x0, x1, y0, y1, nchannels;
+
+    explicit SatView(const ImageBuf& sat)
+        : base((const char*)sat.pixeladdr(sat.xbegin(), sat.ybegin()))
+        , xstride(sat.pixel_stride())
+        , ystride(sat.scanline_stride())
+        , x0(sat.xbegin())
+        , x1(sat.xend())
+        , y0(sat.ybegin())
+        , y1(sat.yend())
+        , nchannels(sat.nchannels())
+    {
+    }
+
+    const double* at(int x, int y) const
+    {
+        return (const double*)(base + (x - x0) * xstride
+                               + (y - y0) * ystride);
+    }
+
+    // Sum of the pixels in [xb,xe) x [yb,ye), clipped to the table, into
+    // sum[], returning the number of pixels summed.
+    imagesize_t rect_sum(int xb, int xe, int yb, int ye, double* sum) const
+    {
+        xb = std::max(xb, x0);
+        xe = std::min(xe, x1);
+        yb = std::max(yb, y0);
+        ye = std::min(ye, y1);
+        if (xb >= xe || yb >= ye) {
+            std::fill(sum, sum + nchannels, 0.0);
+            return 0;
+        }
+        // A - B - C + D, where the table is taken as 0 above and to the
+        // left of its region.
+        const double* a = at(xe - 1, ye - 1);
+        const double* b = xb > x0 ? at(xb - 1, ye - 1) : nullptr;
+        const double* c = yb > y0 ? at(xe - 1, yb - 1) : nullptr;
+        const double* d = (b && c) ? at(xb - 1, yb - 1) : nullptr;
+        for (int i = 0; i < nchannels; ++i)
+            sum[i] = a[i] - (b ? b[i] : 0.0) - (c ? c[i] : 0.0)
+                     + (d ? d[i] : 0.0);
+        return imagesize_t(xe - xb) * imagesize_t(ye - yb);
+    }
+};
+
+}  // namespace
+
+
+
+template<class S>
+static bool
+summed_area_table_(ImageBuf& sat, const ImageBuf& src, ROI roi, int nthreads)
+{
+    // Accumulate along the rows, in bands of rows...
+    int nc = roi.nchannels();
+    ImageBufAlgo::parallel_image(
+        roi, paropt(nthreads, paropt::SplitDir::Y, 16384), [&](ROI band) {
+            for (int y = band.ybegin; y < band.yend; ++y) {
+                ROI row(roi.xbegin, roi.xend, y, y + 1, 0, 1, roi.chbegin,
+                        roi.chend);
+                double* out = (double*)sat.pixeladdr(roi.xbegin, y);
+                ImageBuf::ConstIterator<S, double> s(src, row);
+                for (int x = roi.xbegin; x < roi.xend; ++x, ++s) {
+                    for (int c = 0; c < nc; ++c)
+                        out[c] = double(s[roi.chbegin + c])
+                                 + (x > roi.xbegin ? out[c - nc] : 0.0);
+                    out += nc;
+                }
+            }
+        });
+    // ...then down the columns, in bands of columns.
+    ImageBufAlgo::parallel_image(
+        roi, paropt(nthreads, paropt::SplitDir::X, 16384), [&](ROI band) {
+            size_t n = size_t(band.width()) * size_t(nc);
+            for (int y = roi.ybegin + 1; y < roi.yend; ++y) {
+                double* out = (double*)sat.pixeladdr(band.xbegin, y);
+                const double* above = (const double*)sat.pixeladdr(band.xbegin,
+                                                                   y - 1);
+                for (size_t i = 0; i < n; ++i)
+                    out[i] += above[i];
+            }
+        });
+    return true;
+}
+
+
+
+// Allocate `sat` as the double table of region `roi` of src, and fill it.
+static bool
+make_summed_area_table(ImageBuf& sat, const ImageBuf& src, ROI roi,
+                       int nthreads)
+{
+    ImageSpec spec(roi.width(), roi.height(), roi.nchannels(),
+                   TypeDesc::DOUBLE);
+    spec.x = spec.full_x = roi.xbegin;
+    spec.y = spec.full_y = roi.ybegin;
+    for (int c = 0; c < roi.nchannels(); ++c)
+        spec.channelnames[c] = src.spec().channel_name(roi.chbegin + c);
+    sat.reset(spec, InitializePixels::No);
+    bool ok;
+    OIIO_DISPATCH_TYPES(ok, "summed_area_table", summed_area_table_,
+                        src.spec().format, sat, src, roi, nthreads);
+    return ok;
+}
+
+
+
+bool
+ImageBufAlgo::summed_area_table(ImageBuf& dst, const ImageBuf& src, ROI roi,
+                                int nthreads)
+{
+    if (&dst == &src) {  // Handle in-place operation
+        ImageBuf srcshare(src);
+        return summed_area_table(dst, srcshare, roi, nthreads);
+    }
+    pvt::LoggedTimer logtime("IBA::summed_area_table");
+    if (!src.initialized()) {
+        dst.errorfmt("ImageBufAlgo::summed_area_table: uninitialized source");
+        return false;
+    }
+    if (src.spec().depth > 1) {
+        dst.errorfmt(
+            "ImageBufAlgo::summed_area_table does not support volume images");
+        return false;
+    }
+    if (!roi.defined())
+        roi = src.roi();
+    roi.chend = std::min(roi.chend, src.nchannels());
+    roi       = roi_intersection(roi, src.roi());
+    if (roi.npixels() == 0 || roi.nchannels() <= 0) {
+        dst.errorfmt("ImageBufAlgo::summed_area_table: empty region");
+        return false;
+    }
+    return make_summed_area_table(dst, src, roi, nthreads);
+}
+
+
+
+ImageBuf
+ImageBufAlgo::summed_area_table(const ImageBuf& src, ROI roi, int nthreads)
+{
+    ImageBuf result;
+    bool ok = summed_area_table(result, src, roi, nthreads);
+    if (!ok && !result.has_error())
+        result.errorfmt("ImageBufAlgo::summed_area_table() error");
+    return result;
+}
+
+
+
+imagesize_t
+ImageBufAlgo::summed_area_sum(const ImageBuf& sat, int xbegin, int xend,
+                              int ybegin, int yend, span<double> result)
+{
+    std::fill(result.begin(), result.end(), 0.0);
+    if (!sat.localpixels() || sat.spec().format != TypeDesc::DOUBLE) {
+        sat.errorfmt("summed_area_sum: not a summed-area table");
+        return 0;
+    }
+    SatView view(sat);
+    double* sum = OIIO_ALLOCA(double, view.nchannels);
+    imagesize_t n = view.rect_sum(xbegin, xend, ybegin, yend, sum);
+    for (size_t c = 0; c < std::min(result.size(), size_t(view.nchannels));
+         ++c)
+        result[c] = sum[c];
+    return n;
+}
+
+
+
+template<class D>
+static bool
+box_filter_(ImageBuf& dst, const ImageBuf& sat, int width, int height,
+            ROI roi, int nthreads)
+{
+    // The window of pixel x is [x - width/2, x - width/2 + width).
+    SatView view(sat);
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        double* sum = OIIO_ALLOCA(double, view.nchannels);
+        for (ImageBuf::Iterator<D> d(dst, roi); !d.done(); ++d) {
+            int xb = d.x() - width / 2, yb = d.y() - height / 2;
+            imagesize_t n = view.rect_sum(xb, xb + width, yb, yb + height,
+                                          sum);
+            double scale = n ? 1.0 / double(n) : 0.0;
+            for (int c = roi.chbegin; c < roi.chend; ++c)
+                d[c] = float(sum[c - roi.chbegin] * scale);
+        }
+    });
+    return true;
+}
+
+
+
+bool
+ImageBufAlgo::box_filter(ImageBuf& dst, const ImageBuf& src, int width,
+                         int height, ROI roi, int nthreads)
+{
+    if (&dst == &src) {  // Handle in-place operation
+        ImageBuf srcshare(src);
+        return box_filter(dst, srcshare, width, height, roi, nthreads);
+    }
+    pvt::LoggedTimer logtime("IBA::box_filter");
+    if (!IBAprep(roi, &dst, &src,
+                 IBAprep_REQUIRE_SAME_NCHANNELS | IBAprep_NO_SUPPORT_VOLUME))
+        return false;
+    width  = std::max(1, width);
+    height = height < 1 ? width : height;
+
+    // Only the part of src that the windows reach is summed.
+    ROI satroi(roi.xbegin - width / 2, roi.xend - width / 2 + width - 1,
+               roi.ybegin - height / 2, roi.yend - height / 2 + height - 1,
+               0, 1, roi.chbegin, roi.chend);
+    satroi = roi_intersection(satroi, src.roi());
+    if (satroi.npixels() == 0)
+        return ImageBufAlgo::zero(dst, roi, nthreads);
+    ImageBuf sat;
+    if (!make_summed_area_table(sat, src, satroi, nthreads)) {
+        dst.errorfmt("{}", sat.geterror());
+        return false;
+    }
+    bool ok;
+    OIIO_DISPATCH_TYPES(ok, "box_filter", box_filter_, dst.spec().format, dst,
+                        sat, width, height, roi, nthreads);
+    return ok;
+}
+
+
+
+ImageBuf
+ImageBufAlgo::box_filter(const ImageBuf& src, int width, int height, ROI roi,
+                         int nthreads)
+{
+    ImageBuf result;
+    bool ok = box_filter(result, src, width, height, roi, nthreads);
+    if (!ok && !result.has_error())
+        result.errorfmt("ImageBufAlgo::box_filter() error");
+    return result;
+}
+
+
+
+template<class D, class S>
+static bool
+box_filter_var_(ImageBuf& dst, const ImageBuf& src, const ImageBuf& sat,
+                const ImageBuf& radius, int radius_channel, ROI roi,
+                int nthreads)
+{
+    SatView view(sat);
+    float maxrad = float(std::max(view.x1 - view.x0, view.y1 - view.y0));
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        int nc       = view.nchannels;
+        double* sum0 = OIIO_ALLOCA(double, 2 * nc);
+        double* sum1 = sum0 + nc;
+        ImageBuf::ConstIterator<S> s(src, roi);
+        ImageBuf::ConstIterator<float> r(radius, roi);
+        for (ImageBuf::Iterator<D> d(dst, roi); !d.done(); ++d, ++s, ++r) {
+            float rad = r[radius_channel];
+            if (!(rad > 0.0f)) {  // also catches NaN
+                for (int c = roi.chbegin; c < roi.chend; ++c)
+                    d[c] = s[c];
+                continue;
+            }
+            // Blend the averages over the two nearest whole radii. Past
+            // the size of the table, a bigger window adds nothing.
+            rad            = std::min(rad, maxrad);
+            int ri         = int(rad);
+            float f        = rad - float(ri);
+            int x          = d.x();
+            int y          = d.y();
+            imagesize_t n0 = view.rect_sum(x - ri, x + ri + 1, y - ri,
+                                           y + ri + 1, sum0);
+            double scale0  = n0 ? 1.0 / double(n0) : 0.0;
+            if (f > 0.0f) {
+                imagesize_t n1 = view.rect_sum(x - ri - 1, x + ri + 2,
+                                               y - ri - 1, y + ri + 2, sum1);
+                double scale1  = n1 ? 1.0 / double(n1) : 0.0;
+                for (int c = 0; c < nc; ++c)
+                    sum0[c] = (1.0 - f) * sum0[c] * scale0
+                              + f * sum1[c] * scale1;
+                scale0 = 1.0;
+            }
+            for (int c = roi.chbegin; c < roi.chend; ++c)
+                d[c] = float(sum0[c - roi.chbegin] * scale0);
+        }
+    });
+    return true;
+}
+
+
+
+bool
+ImageBufAlgo::box_filter(ImageBuf& dst, const ImageBuf& src,
+                         const ImageBuf& radius, int radius_channel, ROI roi,
+                         int nthreads)
+{
+    if (&dst == &src || &dst == &radius) {  // Handle in-place operation
+        ImageBuf srcshare(src), radiusshare(radius);
+        return box_filter(dst, srcshare, radiusshare, radius_channel, roi,
+                          nthreads);
+    }
+    pvt::LoggedTimer logtime("IBA::box_filter");
+    if (!IBAprep(roi, &dst, &src,
+                 IBAprep_REQUIRE_SAME_NCHANNELS | IBAprep_NO_SUPPORT_VOLUME))
+        return false;
+    if (!radius.initialized() || radius_channel < 0
+        || radius_channel >= radius.nchannels()) {
+        dst.errorfmt("box_filter: invalid radius image or channel {}",
+                     radius_channel);
+        return false;
+    }
+
+    // The radii aren't known in advance, so the table covers all of src.
+    ROI satroi     = src.roi();
+    satroi.chbegin = roi.chbegin;
+    satroi.chend   = roi.chend;
+    ImageBuf sat;
+    if (!make_summed_area_table(sat, src, satroi, nthreads)) {
+        dst.errorfmt("{}", sat.geterror());
+        return false;
+    }
+    bool ok;
+    OIIO_DISPATCH_COMMON_TYPES2(ok, "box_filter", box_filter_var_,
+                                dst.spec().format, src.spec().format, dst,
+                                src, sat, radius, radius_channel, roi,
+                                nthreads);
+    return ok;
+}
+
+
+
+ImageBuf
+ImageBufAlgo::box_filter(const ImageBuf& src, const ImageBuf& radius,
+                         int radius_channel, ROI roi, int nthreads)
+{
+    ImageBuf result;
+    bool ok = box_filter(result, src, radius, radius_channel, roi, nthreads);
+    if (!ok && !result.has_error())
+        result.errorfmt("ImageBufAlgo::box_filter() error");
+    return result;
+}
+
+
+
 // Helper function: fft of the horizontal rows
 static bool
 hfft_(ImageBuf& dst, const ImageBuf& src, bool inverse, bool unitary, ROI roi,
@@ -1284,10 +2211,12 @@ hfft_(ImageBuf& dst, const ImageBuf& src, bool inverse, bool unitary, ROI roi,
                 && (src.storage() == ImageBuf::LOCALBUFFER
                     || src.storage() == ImageBuf::APPBUFFER));
 
+    // Each thread copies the plan, rather than computing its own twiddles
+    const kissfft<float> plan(roi.width(), inverse);
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
         int width     = roi.width();
         float rescale = sqrtf(1.0f / width);
-        kissfft<float> F(width, inverse);
+        kissfft<float> F(plan);
         for (int z = roi.zbegin; z < roi.zend; ++z) {
             for (int y = roi.ybegin; y < roi.yend; ++y) {
                 std::complex<float>*s, *d;
@@ -1305,9 +2234,64 @@ hfft_(ImageBuf& dst, const ImageBuf& src, bool inverse, bool unitary, ROI roi,
 
 
 
+// Helper function: fft of the vertical columns of buf, in place. Instead
+// of transposing the whole image (twice), blocks of columns are gathered
+// into contiguous buffers, so that the image is still read and written a
+// row at a time, and the blocks are transformed in parallel.
+static bool
+vfft_(ImageBuf& buf, bool inverse, bool unitary, int nthreads)
+{
+    OIIO_ASSERT(buf.spec().format.basetype == TypeDesc::FLOAT
+                && buf.spec().nchannels == 2 && buf.spec().depth == 1
+                && (buf.storage() == ImageBuf::LOCALBUFFER
+                    || buf.storage() == ImageBuf::APPBUFFER));
+    using complex    = std::complex<float>;
+    const ROI roi    = buf.roi();
+    const int height = roi.height();
+    const int block  = 16;  // columns per gather
+    float rescale    = sqrtf(1.0f / height);
+    const kissfft<float> plan(height, inverse);
+    parallel_for_chunked(
+        0, (roi.width() + block - 1) / block, 0,
+        [&](int64_t bbegin, int64_t bend) {
+            kissfft<float> F(plan);
+            std::vector<complex> cols(size_t(block) * height);
+            std::vector<complex> out(height);
+            for (int64_t b = bbegin; b < bend; ++b) {
+                int x0 = roi.xbegin + int(b) * block;
+                int nx = std::min(block, roi.xend - x0);
+                for (int y = 0; y < height; ++y) {
+                    auto row = (const complex*)buf.pixeladdr(x0,
+                                                              roi.ybegin + y);
+                    for (int i = 0; i < nx; ++i)
+                        cols[size_t(i) * height + y] = row[i];
+                }
+                for (int i = 0; i < nx; ++i) {
+                    complex* col = &cols[size_t(i) * height];
+                    F.transform(col, out.data());
+                    for (int y = 0; y < height; ++y)
+                        col[y] = unitary ? out[y] * rescale : out[y];
+                }
+                for (int y = 0; y < height; ++y) {
+                    auto row = (complex*)buf.pixeladdr(x0, roi.ybegin + y);
+                    for (int i = 0; i < nx; ++i)
+                        row[i] = cols[size_t(i) * height + y];
+                }
+            }
+        },
+        paropt(nthreads));
+    return true;
+}
+
+
+
 bool
 ImageBufAlgo::fft(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
 {
+    if (&dst == &src) {  // Handle in-place operation
+        ImageBuf srcshare(src);
+        return fft(dst, srcshare, roi, nthreads);
+    }
     pvt::LoggedTimer logtime("IBA::fft");
     if (src.spec().depth > 1) {
         dst.errorfmt("ImageBufAlgo::fft does not support volume images");
@@ -1332,11 +2316,6 @@ ImageBufAlgo::fft(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
     spec.channelnames.emplace_back("real");
     spec.channelnames.emplace_back("imag");
 
-    // And a spec that describes the transposed intermediate
-    ImageSpec specT = spec;
-    std::swap(specT.width, specT.height);
-    std::swap(specT.full_width, specT.full_height);
-
     // Resize dst
     dst.reset(spec);
 
@@ -1354,22 +2333,10 @@ ImageBufAlgo::fft(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
         return false;
     }
 
-    // FFT the rows (into temp buffer B).
-    ImageBuf B(spec);
-    hfft_(B, A, false /*inverse*/, true /*unitary*/, get_roi(B.spec()),
+    // FFT the rows (into dst), then the columns of dst in place.
+    hfft_(dst, A, false /*inverse*/, true /*unitary*/, get_roi(spec),
           nthreads);
-
-    // Transpose and shift back to A
-    A.clear();
-    ImageBufAlgo::transpose(A, B, ROI::All(), nthreads);
-
-    // FFT what was originally the columns (back to B)
-    B.reset(specT);
-    hfft_(B, A, false /*inverse*/, true /*unitary*/, get_roi(A.spec()),
-          nthreads);
-
-    // Transpose again, into the dest
-    ImageBufAlgo::transpose(dst, B, ROI::All(), nthreads);
+    vfft_(dst, false /*inverse*/, true /*unitary*/, nthreads);
 
     return true;
 }
@@ -1379,6 +2346,10 @@ ImageBufAlgo::fft(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
 bool
 ImageBufAlgo::ifft(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
 {
+    if (&dst == &src) {  // Handle in-place operation
+        ImageBuf srcshare(src);
+        return ifft(dst, srcshare, roi, nthreads);
+    }
     pvt::LoggedTimer logtime("IBA::ifft");
     if (src.nchannels() != 2 || src.spec().format != TypeDesc::FLOAT) {
         dst.errorfmt("ifft can only be done on 2-channel float images");
@@ -1409,29 +2380,21 @@ ImageBufAlgo::ifft(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
     spec.channelnames.emplace_back("real");
     spec.channelnames.emplace_back("imag");
 
-    // Inverse FFT the rows (into temp buffer B).
+    // Inverse FFT the rows (into temp buffer B), then its columns in place.
     ImageBuf B(spec);
     hfft_(B, src, true /*inverse*/, true /*unitary*/, get_roi(B.spec()),
           nthreads);
+    vfft_(B, true /*inverse*/, true /*unitary*/, nthreads);
 
-    // Transpose and shift back to A
-    ImageBuf A;
-    ImageBufAlgo::transpose(A, B, ROI::All(), nthreads);
-
-    // Inverse FFT what was originally the columns (back to B)
-    B.reset(A.spec());
-    hfft_(B, A, true /*inverse*/, true /*unitary*/, get_roi(A.spec()),
-          nthreads);
-
-    // Transpose again, into the dst, in the process throw out the
-    // imaginary part and go back to a single (real) channel.
+    // Copy to the dst, in the process throwing out the imaginary part and
+    // going back to a single (real) channel.
     spec.nchannels = 1;
     spec.channelnames.clear();
     spec.channelnames.emplace_back("R");
     dst.reset(spec);
     ROI Broi   = get_roi(B.spec());
     Broi.chend = 1;
-    ImageBufAlgo::transpose(dst, B, Broi, nthreads);
+    ImageBufAlgo::paste(dst, 0, 0, 0, 0, B, Broi, nthreads);
 
     return true;
 }
@@ -1617,12 +2580,13 @@ ImageBufAlgo::fillholes_pushpull(ImageBuf& dst, const ImageBuf& src, ROI roi,
     ImageSpec topspec = src.spec();
     topspec.set_format(TypeDesc::FLOAT);
     ImageBuf* top = new ImageBuf(topspec);
-    paste(*top, topspec.x, topspec.y, topspec.z, 0, src);
+    paste(*top, topspec.x, topspec.y, topspec.z, 0, src, {}, nthreads);
     pyramid.emplace_back(top);
 
     // Construct the rest of the pyramid by successive x/2 resizing and
     // then dividing nonzero alpha pixels by their alpha (this "spreads
-    // out" the defined part of the image).
+    // out" the defined part of the image). Each level depends on the one
+    // before it, so the parallelism is within each step of each level.
     int w = src.spec().width, h = src.spec().height;
     while (w > 1 || h > 1) {
         w = std::max(1, w / 2);
@@ -1631,7 +2595,7 @@ ImageBufAlgo::fillholes_pushpull(ImageBuf& dst, const ImageBuf& src, ROI roi,
         smallspec.alpha_channel = topspec.alpha_channel;
         ImageBuf* small         = new ImageBuf(smallspec);
         ImageBufAlgo::resize(*small, *pyramid.back(),
-                             { { "filtername", "triangle" } });
+                             { { "filtername", "triangle" } }, {}, nthreads);
         divide_by_alpha(*small, get_roi(smallspec), nthreads);
         pyramid.emplace_back(small);
         // small->write(Strutil::fmt::format("push{:04d}.exr", small->spec().width));
@@ -1645,14 +2609,16 @@ ImageBufAlgo::fillholes_pushpull(ImageBuf& dst, const ImageBuf& src, ROI roi,
     for (int i = (int)pyramid.size() - 2; i >= 0; --i) {
         ImageBuf &big(*pyramid[i]), &small(*pyramid[i + 1]);
         ImageBuf blowup(big.spec());
-        ImageBufAlgo::resize(blowup, small, { { "filtername", "triangle" } });
-        ImageBufAlgo::over(big, big, blowup);
+        ImageBufAlgo::resize(blowup, small, { { "filtername", "triangle" } },
+                             {}, nthreads);
+        ImageBufAlgo::over(big, big, blowup, {}, nthreads);
         // big.write(Strutil::sprintf("pull{:04}.exr", big.spec().width));
     }
 
     // Now copy the completed base layer of the pyramid back to the
     // original requested output.
-    paste(dst, src.spec().x, src.spec().y, src.spec().z, 0, *pyramid[0]);
+    paste(dst, src.spec().x, src.spec().y, src.spec().z, 0, *pyramid[0], {},
+          nthreads);
 
     return true;
 }
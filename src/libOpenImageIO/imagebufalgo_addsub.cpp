@@ -18,7 +18,9 @@
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
 
+#include "imagebufalgo_half_prv.h"
 #include "imageio_pvt.h"
+#include "oiio_gpu_prv.h"
 
 
 OIIO_NAMESPACE_BEGIN
@@ -95,6 +97,11 @@ ImageBufAlgo::add(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_, ROI roi,
             return false;
         ROI origroi = roi;
         roi.chend = std::min(roi.chend, std::min(A.nchannels(), B.nchannels()));
+        if (pvt::gpu_pixelmath(pvt::GPUOp::Add, dst, A, &B, {}, nullptr,
+                               {}, roi)
+            || pvt::half_pixelmath(pvt::HalfOp::Add, dst, A, &B, {}, nullptr,
+                                   {}, roi, nthreads))
+            return true;
         bool ok;
         OIIO_DISPATCH_COMMON_TYPES3(ok, "add", add_impl, dst.spec().format,
                                     A.spec().format, B.spec().format, dst, A, B,
@@ -129,6 +136,11 @@ ImageBufAlgo::add(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_, ROI roi,
             dst.deepdata()->set_all_samples(A.deepdata()->all_samples());
             return add_impl_deep(dst, A, b, roi, nthreads);
         }
+        if (pvt::gpu_pixelmath(pvt::GPUOp::Add, dst, A, nullptr, b,
+                               nullptr, {}, roi)
+            || pvt::half_pixelmath(pvt::HalfOp::Add, dst, A, nullptr, b,
+                                   nullptr, {}, roi, nthreads))
+            return true;
         bool ok;
         OIIO_DISPATCH_COMMON_TYPES2(ok, "add", add_impl, dst.spec().format,
                                     A.spec().format, dst, A, b, roi, nthreads);
@@ -182,6 +194,11 @@ ImageBufAlgo::sub(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_, ROI roi,
             return false;
         ROI origroi = roi;
         roi.chend = std::min(roi.chend, std::min(A.nchannels(), B.nchannels()));
+        if (pvt::gpu_pixelmath(pvt::GPUOp::Sub, dst, A, &B, {}, nullptr,
+                               {}, roi)
+            || pvt::half_pixelmath(pvt::HalfOp::Sub, dst, A, &B, {}, nullptr,
+                                   {}, roi, nthreads))
+            return true;
         bool ok;
         OIIO_DISPATCH_COMMON_TYPES3(ok, "sub", sub_impl, dst.spec().format,
                                     A.spec().format, B.spec().format, dst, A, B,
@@ -222,6 +239,11 @@ ImageBufAlgo::sub(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_, ROI roi,
             dst.deepdata()->set_all_samples(A.deepdata()->all_samples());
             return add_impl_deep(dst, A, b, roi, nthreads);
         }
+        if (pvt::gpu_pixelmath(pvt::GPUOp::Add, dst, A, nullptr, b,
+                               nullptr, {}, roi)
+            || pvt::half_pixelmath(pvt::HalfOp::Add, dst, A, nullptr, b,
+                                   nullptr, {}, roi, nthreads))
+            return true;
         bool ok;
         OIIO_DISPATCH_COMMON_TYPES2(ok, "sub", add_impl, dst.spec().format,
                                     A.spec().format, dst, A, b, roi, nthreads);
@@ -137,6 +137,22 @@ ImageBufAlgo::channels(ImageBuf& dst, const ImageBuf& src, int nchannels,
     if (all_same_type)                   // clear per-chan formats if
         newspec.channelformats.clear();  // they're all the same
 
+    // A run of consecutive channels of the source, with nothing filled
+    // in, is just a view of the source's pixels until one is written.
+    bool run = !src.deep() && channelorder[0] >= 0;
+    for (int c = 0; c < nchannels && run; ++c)
+        run = (channelorder[c] == channelorder[0] + c
+               && channelorder[c] < src.spec().nchannels);
+    if (run
+        && dst.share_channels(src, channelorder[0],
+                              channelorder[0] + nchannels)) {
+        ImageSpec& spec    = dst.specmod();
+        spec.channelnames  = newspec.channelnames;
+        spec.alpha_channel = newspec.alpha_channel;
+        spec.z_channel     = newspec.z_channel;
+        return true;
+    }
+
     // Update the image (realloc with the new spec)
     dst.reset(newspec);
 
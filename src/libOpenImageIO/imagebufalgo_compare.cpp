@@ -6,9 +6,13 @@
 /// Implementation of ImageBufAlgo algorithms that analyze or compare
 /// images.
 
+#include <array>
 #include <cmath>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
 
 #include <OpenImageIO/half.h>
 
@@ -118,68 +122,106 @@ finalize(ImageBufAlgo::PixelStats& p)
 
 
 
+// Accumulate channels [chbegin,chend) of a row of npixels contiguous float
+// pixels into the stats.
+static void
+stats_row(ImageBufAlgo::PixelStats& p, const float* row, int npixels,
+          int nchannels, int chbegin, int chend)
+{
+    if (nchannels == 4 && chbegin == 0 && chend == 4) {
+        // RGBA, a pixel at a time in a vector. The sums stay in double, in
+        // the same order as val() would add them, so the results match.
+        const simd::vfloat4 inf(std::numeric_limits<float>::infinity());
+        simd::vfloat4 mn(p.min.data()), mx(p.max.data());
+        double* sum  = p.sum.data();
+        double* sum2 = p.sum2.data();
+        imagesize_t nfinite = 0;
+        for (int i = 0; i < npixels; ++i, row += 4) {
+            simd::vfloat4 v(row);
+            if (!all(abs(v) < inf)) {
+                // Some NaN or Inf, let val() sort it out
+                for (int c = 0; c < 4; ++c)
+                    val(p, c, row[c]);
+                continue;
+            }
+            mn = min(mn, v);
+            mx = max(mx, v);
+            ++nfinite;
+            for (int c = 0; c < 4; ++c) {
+                sum[c] += row[c];
+                sum2[c] += double(row[c]) * double(row[c]);
+            }
+        }
+        // val() may have lowered p.min or raised p.max meanwhile
+        min(mn, simd::vfloat4(p.min.data())).store(p.min.data());
+        max(mx, simd::vfloat4(p.max.data())).store(p.max.data());
+        for (int c = 0; c < 4; ++c)
+            p.finitecount[c] += nfinite;
+        return;
+    }
+    for (int i = 0; i < npixels; ++i, row += nchannels)
+        for (int c = chbegin; c < chend; ++c)
+            val(p, c, row[c]);
+}
+
+
+
 template<class T>
 static bool
 computePixelStats_(const ImageBuf& src, ImageBufAlgo::PixelStats& stats,
                    ROI roi, int nthreads)
 {
-    // clang-format off
     if (!roi.defined())
         roi = get_roi(src.spec());
     else
         roi.chend = std::min(roi.chend, src.nchannels());
 
     int nchannels = src.spec().nchannels;
+    // Local flat pixels are read a scanline at a time, straight from memory
+    // (converted to float if need be) rather than through iterators.
+    const bool local = !src.deep() && src.localpixels() && src.contiguous();
 
-    stats.reset(nchannels);
-    OIIO::spin_mutex mutex;  // protect the shared stats when merging
-
-    paropt opt(nthreads);
-    if (src.deep()) {
-        parallel_for_chunked(roi.ybegin, roi.yend, 64,
-                             [&](int64_t ybegin, int64_t yend) {
-            ROI subroi(roi.xbegin, roi.xend, ybegin, yend, roi.zbegin,
-                       roi.zend, roi.chbegin, roi.chend);
-            ImageBufAlgo::PixelStats tmp(nchannels);
-            for (ImageBuf::ConstIterator<T> s(src, subroi); !s.done();
-                 ++s) {
+    auto band_stats = [&](ROI band, ImageBufAlgo::PixelStats& acc) {
+        if (src.deep()) {
+            for (ImageBuf::ConstIterator<T> s(src, band); !s.done(); ++s) {
                 int samples = s.deep_samples();
-                if (!samples)
-                    continue;
-                for (int c = subroi.chbegin; c < subroi.chend; ++c) {
-                    for (int i = 0; i < samples; ++i) {
-                        float value = s.deep_value(c, i);
-                        val(tmp, c, value);
-                    }
-                }
+                for (int c = band.chbegin; c < band.chend; ++c)
+                    for (int i = 0; i < samples; ++i)
+                        val(acc, c, s.deep_value(c, i));
             }
-            std::lock_guard<OIIO::spin_mutex> lock(mutex);
-            stats.merge(tmp);
-        }, opt);
-
-    } else {  // Non-deep case
-        parallel_for_chunked(roi.ybegin, roi.yend, 64,
-                             [&](int64_t ybegin, int64_t yend) {
-            ROI subroi(roi.xbegin, roi.xend, ybegin, yend, roi.zbegin,
-                       roi.zend, roi.chbegin, roi.chend);
-            ImageBufAlgo::PixelStats tmp(nchannels);
-            for (ImageBuf::ConstIterator<T> s(src, subroi); !s.done();
-                 ++s) {
-                for (int c = subroi.chbegin; c < subroi.chend; ++c) {
-                    float value = s[c];
-                    val(tmp, c, value);
+        } else if (local) {
+            const int width = band.width();
+            std::unique_ptr<float[]> buf;
+            if (!std::is_same<T, float>::value)
+                buf.reset(new float[size_t(width) * nchannels]);
+            for (int z = band.zbegin; z < band.zend; ++z) {
+                for (int y = band.ybegin; y < band.yend; ++y) {
+                    const void* row = src.pixeladdr(band.xbegin, y, z);
+                    if (buf) {
+                        convert_pixel_values(src.spec().format, row,
+                                             TypeFloat, buf.get(),
+                                             width * nchannels);
+                        row = buf.get();
+                    }
+                    stats_row(acc, (const float*)row, width, nchannels,
+                              band.chbegin, band.chend);
                 }
             }
-            std::lock_guard<OIIO::spin_mutex> lock(mutex);
-            stats.merge(tmp);
-        }, opt);
-    }
+        } else {
+            for (ImageBuf::ConstIterator<T> s(src, band); !s.done(); ++s)
+                for (int c = band.chbegin; c < band.chend; ++c)
+                    val(acc, c, s[c]);
+        }
+    };
+    stats = ImageBufAlgo::parallel_image_reduce(
+        roi, nthreads, ImageBufAlgo::PixelStats(nchannels), band_stats,
+        [](ImageBufAlgo::PixelStats& total,
+           const ImageBufAlgo::PixelStats& acc) { total.merge(acc); });
 
     // Compute final results
     finalize(stats);
 
     return !src.has_error();
-    // clang-format on
 };
 
 
@@ -261,25 +303,26 @@ compare_value(ImageBuf::ConstIterator<BUFT, float>& a, int chan, VALT aval,
 
 
 
+// What compare_ accumulates for each band of the image.
+struct CompareAccum {
+    ImageBufAlgo::CompareResults result {};
+    double totalerror    = 0;
+    double totalsqrerror = 0;
+    float maxval         = 1.0f;
+};
+
+
+
 template<class Atype, class Btype>
 static bool
 compare_(const ImageBuf& A, const ImageBuf& B, float failthresh,
          float warnthresh, float failrelative, float warnrelative,
-         ImageBufAlgo::CompareResults& result, ROI roi, int /*nthreads*/)
+         ImageBufAlgo::CompareResults& result, ROI roi, int nthreads)
 {
     imagesize_t npels = roi.npixels();
     imagesize_t nvals = npels * roi.nchannels();
     int Achannels = A.nchannels(), Bchannels = B.nchannels();
 
-    // Compare the two images.
-    //
-    double totalerror    = 0;
-    double totalsqrerror = 0;
-    result.maxerror      = 0;
-    result.maxx = 0, result.maxy = 0, result.maxz = 0, result.maxc = 0;
-    result.nfail = 0, result.nwarn = 0;
-
-    float maxval = 1.0;
     // N.B. [PSNR](https://en.wikipedia.org/wiki/Peak_signal-to-noise_ratio)
     // formula requires the max possible value. We assume a normalized 1.0,
     // but for an HDR image with potentially values > 1.0, there is no true
@@ -287,45 +330,77 @@ compare_(const ImageBuf& A, const ImageBuf& B, float failthresh,
     // either image. The compare_value() function we call on every pixel value
     // will check and adjust our max as needed.
 
-    ImageBuf::ConstIterator<Atype> a(A, roi, ImageBuf::WrapBlack);
-    ImageBuf::ConstIterator<Btype> b(B, roi, ImageBuf::WrapBlack);
     bool deep = A.deep();
-    // Break up into batches to reduce cancellation errors as the error
-    // sums become too much larger than the error for individual pixels.
-    const int batchsize = 4096;  // As good a guess as any
-    for (; !a.done();) {
-        double batcherror     = 0;
-        double batch_sqrerror = 0;
-        if (deep) {
-            for (int i = 0; i < batchsize && !a.done(); ++i, ++a, ++b) {
-                bool warned = false, failed = false;  // For this pixel
-                auto nsamps = std::max(a.deep_samples(), b.deep_samples());
-                for (int c = roi.chbegin; c < roi.chend; ++c)
-                    for (int s = 0, e = nsamps; s < e; ++s) {
-                        compare_value(a, c, a.deep_value(c, s),
-                                      b.deep_value(c, s), result, maxval,
-                                      batcherror, batch_sqrerror, failed,
-                                      warned, failthresh, warnthresh,
-                                      failrelative, warnrelative);
-                    }
-            }
-        } else {  // non-deep
-            for (int i = 0; i < batchsize && !a.done(); ++i, ++a, ++b) {
-                bool warned = false, failed = false;  // For this pixel
-                for (int c = roi.chbegin; c < roi.chend; ++c)
-                    compare_value(a, c, c < Achannels ? a[c] : 0.0f,
-                                  c < Bchannels ? b[c] : 0.0f, result, maxval,
-                                  batcherror, batch_sqrerror, failed, warned,
-                                  failthresh, warnthresh, failrelative,
-                                  warnrelative);
+    // Compare the two images, a band at a time in parallel.
+    auto compare_band = [&](ROI band, CompareAccum& acc) {
+        ImageBuf::ConstIterator<Atype> a(A, band, ImageBuf::WrapBlack);
+        ImageBuf::ConstIterator<Btype> b(B, band, ImageBuf::WrapBlack);
+        // Break up into batches to reduce cancellation errors as the error
+        // sums become too much larger than the error for individual pixels.
+        const int batchsize = 4096;  // As good a guess as any
+        for (; !a.done();) {
+            double batcherror     = 0;
+            double batch_sqrerror = 0;
+            if (deep) {
+                for (int i = 0; i < batchsize && !a.done(); ++i, ++a, ++b) {
+                    bool warned = false, failed = false;  // For this pixel
+                    auto nsamps = std::max(a.deep_samples(), b.deep_samples());
+                    for (int c = band.chbegin; c < band.chend; ++c)
+                        for (int s = 0, e = nsamps; s < e; ++s) {
+                            compare_value(a, c, a.deep_value(c, s),
+                                          b.deep_value(c, s), acc.result,
+                                          acc.maxval, batcherror,
+                                          batch_sqrerror, failed, warned,
+                                          failthresh, warnthresh,
+                                          failrelative, warnrelative);
+                        }
+                }
+            } else {  // non-deep
+                for (int i = 0; i < batchsize && !a.done(); ++i, ++a, ++b) {
+                    bool warned = false, failed = false;  // For this pixel
+                    for (int c = band.chbegin; c < band.chend; ++c)
+                        compare_value(a, c, c < Achannels ? a[c] : 0.0f,
+                                      c < Bchannels ? b[c] : 0.0f,
+                                      acc.result, acc.maxval, batcherror,
+                                      batch_sqrerror, failed, warned,
+                                      failthresh, warnthresh, failrelative,
+                                      warnrelative);
+                }
             }
+            acc.totalerror += batcherror;
+            acc.totalsqrerror += batch_sqrerror;
         }
-        totalerror += batcherror;
-        totalsqrerror += batch_sqrerror;
-    }
-    result.meanerror = totalerror / nvals;
-    result.rms_error = sqrt(totalsqrerror / nvals);
-    result.PSNR      = 20.0 * log10(maxval / result.rms_error);
+    };
+    // Merging in band order, the first of equal maximal errors is the one
+    // reported, as it would be comparing the whole image in one pass.
+    auto merge = [](CompareAccum& total, const CompareAccum& acc) {
+        total.totalerror += acc.totalerror;
+        total.totalsqrerror += acc.totalsqrerror;
+        total.maxval = std::max(total.maxval, acc.maxval);
+        total.result.nwarn += acc.result.nwarn;
+        total.result.nfail += acc.result.nfail;
+        if (!(acc.result.maxerror <= total.result.maxerror)) {
+            total.result.maxerror = acc.result.maxerror;
+            total.result.maxx     = acc.result.maxx;
+            total.result.maxy     = acc.result.maxy;
+            total.result.maxz     = acc.result.maxz;
+            total.result.maxc     = acc.result.maxc;
+        }
+    };
+    CompareAccum total = ImageBufAlgo::parallel_image_reduce(roi, nthreads,
+                                                             CompareAccum(),
+                                                             compare_band,
+                                                             merge);
+    result.maxerror  = total.result.maxerror;
+    result.maxx      = total.result.maxx;
+    result.maxy      = total.result.maxy;
+    result.maxz      = total.result.maxz;
+    result.maxc      = total.result.maxc;
+    result.nwarn     = total.result.nwarn;
+    result.nfail     = total.result.nfail;
+    result.meanerror = total.totalerror / nvals;
+    result.rms_error = sqrt(total.totalsqrerror / nvals);
+    result.PSNR      = 20.0 * log10(total.maxval / result.rms_error);
     return result.nfail == 0;
 }
 
@@ -367,9 +442,6 @@ ImageBufAlgo::compare(const ImageBuf& A, const ImageBuf& B, float failthresh,
                                       B.spec().format, A, B, failthresh,
                                       warnthresh, failrelative, warnrelative,
                                       result, roi, nthreads);
-    // FIXME - The nthreads argument is for symmetry with the rest of
-    // ImageBufAlgo and for future expansion. But for right now, we
-    // don't actually split by threads.  Maybe later.
     result.error = !ok;
     return result;
 }
@@ -381,10 +453,6 @@ static bool
 isConstantColor_(const ImageBuf& src, float threshold, span<float> color,
                  ROI roi, int nthreads)
 {
-    // Single flag that will be set to false by any of the threads if they
-    // discover that the image is non-constant, so the others can abort early. It
-    // does NOT need to be atomic, because the timing is not critical and we
-    // don't want to slow things down by locking.
     bool result = true;
 
     imagesize_t npixels = roi.npixels();
@@ -415,31 +483,23 @@ isConstantColor_(const ImageBuf& src, float threshold, span<float> color,
     } else if (threshold == 0.0f) {
         // For 0.0 threshold, use shortcut of avoiding the conversion
         // to float, just compare original type values.
-        ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-            if (!result)
-                return;  // another parallel bucket already failed, don't bother
-            for (ImageBuf::ConstIterator<T, T> s(src, roi); result && !s.done();
-                 ++s) {
+        result = ImageBufAlgo::parallel_image_all(roi, nthreads, [&](ROI roi) {
+            for (ImageBuf::ConstIterator<T, T> s(src, roi); !s.done(); ++s) {
                 for (int c = roi.chbegin; c < roi.chend; ++c)
-                    if (s[c] != constval[c]) {
-                        result = false;
-                        return;
-                    }
+                    if (s[c] != constval[c])
+                        return false;
             }
+            return true;
         });
     } else {
         // Nonzero threshold case
-        ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-            if (!result)
-                return;  // another parallel bucket already failed, don't bother
-            for (ImageBuf::ConstIterator<T> s(src, roi); result && !s.done();
-                 ++s) {
+        result = ImageBufAlgo::parallel_image_all(roi, nthreads, [&](ROI roi) {
+            for (ImageBuf::ConstIterator<T> s(src, roi); !s.done(); ++s) {
                 for (int c = roi.chbegin; c < roi.chend; ++c)
-                    if (std::abs(s[c] - constval[c]) > threshold) {
-                        result = false;
-                        return;
-                    }
+                    if (std::abs(s[c] - constval[c]) > threshold)
+                        return false;
             }
+            return true;
         });
     }
 
@@ -453,7 +513,7 @@ isConstantColor_(const ImageBuf& src, float threshold, span<float> color,
         for (int c = roi.chend; c < src.nchannels() && c < colsize; ++c)
             color[c] = 0.0f;
     }
-    return result ? true : false;
+    return result;
 }
 
 
@@ -485,32 +545,25 @@ static bool
 isConstantChannel_(const ImageBuf& src, int channel, float val, float threshold,
                    ROI roi, int nthreads)
 {
-    atomic_int result(true);
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        if (!result)
-            return;  // another parallel bucket already failed, don't bother
+    return ImageBufAlgo::parallel_image_all(roi, nthreads, [&](ROI roi) {
         if (threshold == 0.0f) {
             // For 0.0 threshold, use shortcut of avoiding the conversion
             // to float, just compare original type values.
             T constvalue = convert_type<float, T>(val);
             for (ImageBuf::ConstIterator<T, T> s(src, roi); !s.done(); ++s) {
-                if (s[channel] != constvalue) {
-                    result = false;
-                    return;
-                }
+                if (s[channel] != constvalue)
+                    return false;
             }
         } else {
             // Nonzero threshold case
             for (ImageBuf::ConstIterator<T> s(src, roi); !s.done(); ++s) {
                 float constvalue = val;
-                if (std::abs(s[channel] - constvalue) > threshold) {
-                    result = false;
-                    return;
-                }
+                if (std::abs(s[channel] - constvalue) > threshold)
+                    return false;
             }
         }
+        return true;
     });
-    return result ? true : false;
 }
 
 
@@ -543,34 +596,27 @@ isMonochrome_(const ImageBuf& src, float threshold, ROI roi, int nthreads)
     if (nchannels < 2)
         return true;
 
-    atomic_int result(true);
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        if (!result)
-            return;  // another parallel bucket already failed, don't bother
+    return ImageBufAlgo::parallel_image_all(roi, nthreads, [&](ROI roi) {
         if (threshold == 0.0f) {
             // For 0.0 threshold, use shortcut of avoiding the conversion
             // to float, just compare original type values.
             for (ImageBuf::ConstIterator<T, T> s(src, roi); !s.done(); ++s) {
                 T constvalue = s[roi.chbegin];
                 for (int c = roi.chbegin + 1; c < roi.chend; ++c)
-                    if (s[c] != constvalue) {
-                        result = false;
-                        return;
-                    }
+                    if (s[c] != constvalue)
+                        return false;
             }
         } else {
             // Nonzero threshold case
             for (ImageBuf::ConstIterator<T> s(src, roi); !s.done(); ++s) {
                 float constvalue = s[roi.chbegin];
                 for (int c = roi.chbegin + 1; c < roi.chend; ++c)
-                    if (std::abs(s[c] - constvalue) > threshold) {
-                        result = false;
-                        return;
-                    }
+                    if (std::abs(s[c] - constvalue) > threshold)
+                        return false;
             }
         }
+        return true;
     });
-    return result ? true : false;
 }
 
 
@@ -597,14 +643,12 @@ ImageBufAlgo::isMonochrome(const ImageBuf& src, float threshold, ROI roi,
 
 template<typename T>
 static bool
-color_count_(const ImageBuf& src, atomic_ll* count, int ncolors,
+color_count_(const ImageBuf& src, imagesize_t* count, int ncolors,
              const float* color, const float* eps, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    using Counts    = std::vector<imagesize_t>;
+    auto count_band = [&](ROI roi, Counts& n) {
         int nchannels = src.nchannels();
-        long long* n  = OIIO_ALLOCA(long long, ncolors);
-        for (int col = 0; col < ncolors; ++col)
-            n[col] = 0;
         for (ImageBuf::ConstIterator<T> p(src, roi); !p.done(); ++p) {
             int coloffset = 0;
             for (int col = 0; col < ncolors; ++col, coloffset += nchannels) {
@@ -618,9 +662,14 @@ color_count_(const ImageBuf& src, atomic_ll* count, int ncolors,
                 n[col] += match;
             }
         }
-        for (int col = 0; col < ncolors; ++col)
-            count[col] += n[col];
-    });
+    };
+    Counts total = ImageBufAlgo::parallel_image_reduce(
+        roi, nthreads, Counts(ncolors), count_band,
+        [=](Counts& sum, const Counts& n) {
+            for (int col = 0; col < ncolors; ++col)
+                sum[col] += n[col];
+        });
+    std::copy(total.begin(), total.end(), count);
     return true;
 }
 
@@ -649,8 +698,8 @@ ImageBufAlgo::color_count(const ImageBuf& src, imagesize_t* count, int ncolors,
         count[col] = 0;
     bool ok;
     OIIO_DISPATCH_TYPES(ok, "color_count", color_count_, src.spec().format, src,
-                        (atomic_ll*)count, ncolors, color.data(), eps.data(),
-                        roi, nthreads);
+                        count, ncolors, color.data(), eps.data(), roi,
+                        nthreads);
     return ok;
 }
 
@@ -658,12 +707,13 @@ ImageBufAlgo::color_count(const ImageBuf& src, imagesize_t* count, int ncolors,
 
 template<typename T>
 static bool
-color_range_check_(const ImageBuf& src, atomic_ll* lowcount,
-                   atomic_ll* highcount, atomic_ll* inrangecount,
+color_range_check_(const ImageBuf& src, imagesize_t* lowcount,
+                   imagesize_t* highcount, imagesize_t* inrangecount,
                    const float* low, const float* high, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [=, &src](ROI roi) {
-        long long lc = 0, hc = 0, inrange = 0;
+    // Counts of low, high, and in range pixels
+    using Counts    = std::array<imagesize_t, 3>;
+    auto count_band = [&](ROI roi, Counts& n) {
         for (ImageBuf::ConstIterator<T> p(src, roi); !p.done(); ++p) {
             bool lowval = false, highval = false;
             for (int c = roi.chbegin; c < roi.chend; ++c) {
@@ -672,20 +722,25 @@ color_range_check_(const ImageBuf& src, atomic_ll* lowcount,
                 highval |= (f > high[c]);
             }
             if (lowval)
-                ++lc;
+                ++n[0];
             if (highval)
-                ++hc;
+                ++n[1];
             if (!lowval && !highval)
-                ++inrange;
+                ++n[2];
         }
-
-        if (lowcount)
-            *lowcount += lc;
-        if (highcount)
-            *highcount += hc;
-        if (inrangecount)
-            *inrangecount += inrange;
-    });
+    };
+    Counts total = ImageBufAlgo::parallel_image_reduce(
+        roi, nthreads, Counts { 0, 0, 0 }, count_band,
+        [](Counts& sum, const Counts& n) {
+            for (int i = 0; i < 3; ++i)
+                sum[i] += n[i];
+        });
+    if (lowcount)
+        *lowcount = total[0];
+    if (highcount)
+        *highcount = total[1];
+    if (inrangecount)
+        *inrangecount = total[2];
     return true;
 }
 
@@ -714,9 +769,8 @@ ImageBufAlgo::color_range_check(const ImageBuf& src, imagesize_t* lowcount,
         *inrangecount = 0;
     bool ok;
     OIIO_DISPATCH_TYPES(ok, "color_range_check", color_range_check_,
-                        src.spec().format, src, (atomic_ll*)lowcount,
-                        (atomic_ll*)highcount, (atomic_ll*)inrangecount,
-                        low.data(), high.data(), roi, nthreads);
+                        src.spec().format, src, lowcount, highcount,
+                        inrangecount, low.data(), high.data(), roi, nthreads);
     return ok;
 }
 
@@ -812,15 +866,229 @@ ImageBufAlgo::nonzero_region(const ImageBuf& src, ROI roi, int nthreads)
 
 
 
+// What analyze() accumulates for each band of the image.
+struct AnalysisAccum {
+    ImageBufAlgo::PixelStats stats;
+    bool constant   = true;
+    bool monochrome = true;
+    imagesize_t lowcount = 0, highcount = 0, inrangecount = 0;
+    // Bounds of the nonzero pixels, empty if there are none
+    int xmin = std::numeric_limits<int>::max();
+    int xmax = std::numeric_limits<int>::min();
+    int ymin = std::numeric_limits<int>::max();
+    int ymax = std::numeric_limits<int>::min();
+    int zmin = std::numeric_limits<int>::max();
+    int zmax = std::numeric_limits<int>::min();
+};
+
+
+
+ImageBufAlgo::ImageAnalysis
+ImageBufAlgo::analyze(const ImageBuf& src, KWArgs options, ROI roi,
+                      int nthreads)
+{
+    pvt::LoggedTimer logtimer("IBA::analyze");
+    ImageAnalysis result;
+    const int nchannels = src.nchannels();
+    if (!src.initialized() || nchannels == 0) {
+        src.errorfmt("analyze: image must be initialized and have channels");
+        result.error = true;
+        return result;
+    }
+    if (!roi.defined())
+        roi = get_roi(src.spec());
+    roi       = roi_intersection(roi, src.roi());
+    roi.chend = std::min(roi.chend, nchannels);
+    bool stats      = options.get_int("stats", 1);
+    bool constant   = options.get_int("constant", 1);
+    bool monochrome = options.get_int("monochrome", 1);
+    bool nonzero    = options.get_int("nonzero_region", 1);
+    float threshold = options.get_float("threshold", 0.0f);
+    // Range checking only if at least one of the bounds was given
+    const float big = std::numeric_limits<float>::max();
+    std::vector<float> low(nchannels, -big), high(nchannels, big);
+    bool rangecheck = false;
+    for (auto bound : { std::make_pair("low", &low),
+                        std::make_pair("high", &high) }) {
+        auto p = options.find(bound.first);
+        if (p == options.end())
+            continue;
+        int n = p->nvalues() * int(p->type().basevalues());
+        for (int c = 0; c < nchannels && n > 0; ++c)
+            (*bound.second)[c] = p->get_float_indexed(std::min(c, n - 1));
+        rangecheck = true;
+    }
+
+    if (src.deep()) {
+        // Only the stats and nonzero region have meaning for deep images
+        if (stats)
+            result.stats = computePixelStats(src, roi, nthreads);
+        if (nonzero)
+            result.nonzero_region = nonzero_region(src, roi, nthreads);
+        result.error = src.has_error();
+        return result;
+    }
+
+    // The color to compare against for "constant" is the first pixel's.
+    std::vector<float> first(nchannels, 0.0f);
+    if (constant && roi.npixels()) {
+        std::vector<float> pixel(nchannels);
+        src.getpixel(roi.xbegin, roi.ybegin, roi.zbegin, pixel);
+        for (int c = roi.chbegin; c < roi.chend; ++c)
+            first[c] = pixel[c];
+    }
+
+    // Each band is read (or converted to float) once, a scanline at a time
+    // for local pixels, or all at once from an ImageCache, for all the
+    // analyses together.
+    const TypeDesc format = src.spec().format;
+    const bool local      = src.localpixels() && src.contiguous();
+    const bool direct     = local && format == TypeFloat;
+    auto analyze_band     = [&](ROI band, AnalysisAccum& acc) {
+        const int width      = band.width();
+        const size_t rowvals = size_t(width) * nchannels;
+        const size_t nrows   = size_t(band.height()) * band.depth();
+        if (!rowvals)
+            return;
+        std::unique_ptr<float[]> buf;
+        if (!direct)
+            buf.reset(new float[rowvals * (local ? 1 : nrows)]);
+        if (!local) {
+            ROI all     = band;
+            all.chbegin = 0;
+            all.chend   = nchannels;
+            if (!src.get_pixels(all, span<float>(buf.get(), rowvals * nrows)))
+                return;
+        }
+        size_t rowindex = 0;
+        for (int z = band.zbegin; z < band.zend; ++z) {
+            for (int y = band.ybegin; y < band.yend; ++y, ++rowindex) {
+                const float* row;
+                if (direct) {
+                    row = (const float*)src.pixeladdr(band.xbegin, y, z);
+                } else if (local) {
+                    convert_pixel_values(format,
+                                         src.pixeladdr(band.xbegin, y, z),
+                                         TypeFloat, buf.get(), int(rowvals));
+                    row = buf.get();
+                } else {
+                    row = buf.get() + rowindex * rowvals;
+                }
+                if (stats)
+                    stats_row(acc.stats, row, width, nchannels, band.chbegin,
+                              band.chend);
+                const float* p = row;
+                for (int x = band.xbegin; x < band.xend; ++x, p += nchannels) {
+                    bool isnonzero = false, islow = false, ishigh = false;
+                    for (int c = band.chbegin; c < band.chend; ++c) {
+                        float v = p[c];
+                        // Like isConstantColor and isMonochrome, a zero
+                        // threshold means exact equality, even for NaN.
+                        if (acc.constant)
+                            acc.constant = threshold == 0.0f
+                                               ? v == first[c]
+                                               : !(std::abs(v - first[c])
+                                                   > threshold);
+                        if (acc.monochrome && c > band.chbegin) {
+                            float m = p[band.chbegin];
+                            acc.monochrome = threshold == 0.0f
+                                                 ? v == m
+                                                 : !(std::abs(v - m)
+                                                     > threshold);
+                        }
+                        isnonzero |= (v != 0.0f);
+                        islow |= (v < low[c]);
+                        ishigh |= (v > high[c]);
+                    }
+                    if (rangecheck) {
+                        acc.lowcount += islow;
+                        acc.highcount += ishigh;
+                        acc.inrangecount += !islow && !ishigh;
+                    }
+                    if (nonzero && isnonzero) {
+                        acc.xmin = std::min(acc.xmin, x);
+                        acc.xmax = std::max(acc.xmax, x);
+                        acc.ymin = std::min(acc.ymin, y);
+                        acc.ymax = std::max(acc.ymax, y);
+                        acc.zmin = std::min(acc.zmin, z);
+                        acc.zmax = std::max(acc.zmax, z);
+                    }
+                }
+            }
+        }
+    };
+    AnalysisAccum init;
+    init.stats.reset(nchannels);
+    init.constant   = constant;
+    init.monochrome = monochrome;
+    auto merge = [](AnalysisAccum& total, const AnalysisAccum& acc) {
+        total.stats.merge(acc.stats);
+        total.constant &= acc.constant;
+        total.monochrome &= acc.monochrome;
+        total.lowcount += acc.lowcount;
+        total.highcount += acc.highcount;
+        total.inrangecount += acc.inrangecount;
+        total.xmin = std::min(total.xmin, acc.xmin);
+        total.xmax = std::max(total.xmax, acc.xmax);
+        total.ymin = std::min(total.ymin, acc.ymin);
+        total.ymax = std::max(total.ymax, acc.ymax);
+        total.zmin = std::min(total.zmin, acc.zmin);
+        total.zmax = std::max(total.zmax, acc.zmax);
+    };
+    AnalysisAccum total = parallel_image_reduce(roi, nthreads, init,
+                                                analyze_band, merge);
+    if (src.has_error()) {
+        result.error = true;
+        return result;
+    }
+
+    if (stats) {
+        finalize(total.stats);
+        result.stats = std::move(total.stats);
+    }
+    if (constant) {
+        // As with isConstantColor, an empty region is not constant.
+        result.constant = total.constant && roi.npixels() > 0;
+        if (result.constant)
+            result.constant_color = first;
+    }
+    result.monochrome = total.monochrome;
+    if (rangecheck) {
+        result.lowcount     = total.lowcount;
+        result.highcount    = total.highcount;
+        result.inrangecount = total.inrangecount;
+    }
+    if (nonzero) {
+        // An all-zero region shrinks, as with nonzero_region, to no rows.
+        ROI nz = roi;
+        if (total.xmin > total.xmax) {
+            nz.yend = nz.ybegin;
+        } else {
+            nz.xbegin = total.xmin;
+            nz.xend   = total.xmax + 1;
+            nz.ybegin = total.ymin;
+            nz.yend   = total.ymax + 1;
+            nz.zbegin = total.zmin;
+            nz.zend   = total.zmax + 1;
+        }
+        result.nonzero_region = nz;
+    }
+    return result;
+}
+
+
+
 namespace {
 
+// Hash the pixels of roi in order with a HASHER (SHA1 or FastHash128).
+template<class HASHER>
 std::string
-simplePixelHashSHA1(const ImageBuf& src, string_view extrainfo, ROI roi)
+simplePixelHash(const ImageBuf& src, string_view extrainfo, ROI roi)
 {
     if (!roi.defined())
         roi = get_roi(src.spec());
 
-    bool localpixels           = src.localpixels();
+    bool localpixels           = src.localpixels() && src.contiguous();
     imagesize_t scanline_bytes = roi.width() * src.spec().pixel_bytes();
     OIIO_ASSERT(scanline_bytes < std::numeric_limits<unsigned int>::max());
     // Do it a few scanlines at a time
@@ -830,7 +1098,7 @@ simplePixelHashSHA1(const ImageBuf& src, string_view extrainfo, ROI roi)
     if (!localpixels)
         tmp.resize(chunk * scanline_bytes);
 
-    SHA1 sha;
+    HASHER sha;
     for (int z = roi.zbegin, zend = roi.zend; z < zend; ++z) {
         for (int y = roi.ybegin, yend = roi.yend; y < yend; y += chunk) {
             int y1 = std::min(y + chunk, yend);
@@ -851,20 +1119,20 @@ simplePixelHashSHA1(const ImageBuf& src, string_view extrainfo, ROI roi)
     return sha.digest();
 }
 
-}  // namespace
-
 
 
+// Hash each blocksize batch of scanlines of roi in parallel, then hash
+// their digests in order.
+template<class HASHER>
 std::string
-ImageBufAlgo::computePixelHashSHA1(const ImageBuf& src, string_view extrainfo,
-                                   ROI roi, int blocksize, int nthreads)
+blockPixelHash(const ImageBuf& src, string_view extrainfo, ROI roi,
+               int blocksize, int nthreads)
 {
-    pvt::LoggedTimer logtimer("IBA::computePixelHashSHA1");
     if (!roi.defined())
         roi = get_roi(src.spec());
 
     if (blocksize <= 0 || blocksize >= roi.height())
-        return simplePixelHashSHA1(src, extrainfo, roi);
+        return simplePixelHash<HASHER>(src, extrainfo, roi);
 
     // clang-format off
     int nblocks = (roi.height() + blocksize - 1) / blocksize;
@@ -872,24 +1140,47 @@ ImageBufAlgo::computePixelHashSHA1(const ImageBuf& src, string_view extrainfo,
     std::vector<std::string> results(nblocks);
     parallel_for_chunked(roi.ybegin, roi.yend, blocksize,
                          [&](int64_t ybegin, int64_t yend) {
-        int64_t b   = (ybegin - src.ybegin()) / blocksize;  // block number
+        int64_t b   = (ybegin - roi.ybegin) / blocksize;  // block number
         ROI broi    = roi;
         broi.ybegin = ybegin;
         broi.yend   = yend;
-        results[b]  = simplePixelHashSHA1(src, "", broi);
+        results[b]  = simplePixelHash<HASHER>(src, "", broi);
     }, nthreads);
     // clang-format on
 
     // If there are multiple blocks, hash the block digests to get a final
     // hash. (This makes the parallel loop safe, because the order that the
     // blocks computed doesn't matter.)
-    SHA1 sha;
+    HASHER sha;
     for (int b = 0; b < nblocks; ++b)
         sha.append(results[b]);
     sha.append(extrainfo);
     return sha.digest();
 }
 
+}  // namespace
+
+
+
+std::string
+ImageBufAlgo::computePixelHashSHA1(const ImageBuf& src, string_view extrainfo,
+                                   ROI roi, int blocksize, int nthreads)
+{
+    pvt::LoggedTimer logtimer("IBA::computePixelHashSHA1");
+    return blockPixelHash<SHA1>(src, extrainfo, roi, blocksize, nthreads);
+}
+
+
+
+std::string
+ImageBufAlgo::computePixelHash(const ImageBuf& src, string_view extrainfo,
+                               ROI roi, int blocksize, int nthreads)
+{
+    pvt::LoggedTimer logtimer("IBA::computePixelHash");
+    return blockPixelHash<FastHash128>(src, extrainfo, roi, blocksize,
+                                       nthreads);
+}
+
 
 
 template<class Atype>
@@ -904,14 +1195,10 @@ histogram_impl(const ImageBuf& src, int channel, std::vector<imagesize_t>& hist,
         return false;
     }
 
-    std::mutex mutex;  // thread safety for the histogram result
-
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    using Counts   = std::vector<imagesize_t>;
+    auto band_hist = [&](ROI roi, Counts& h) {
         float ratio      = bins / (max - min);
         int bins_minus_1 = bins - 1;
-
-        // Compute histogram to thread-local h.
-        std::vector<imagesize_t> h(bins, 0);
         for (ImageBuf::ConstIterator<Atype> a(src, roi); !a.done(); a++) {
             if (ignore_empty) {
                 bool allblack = true;
@@ -925,12 +1212,13 @@ histogram_impl(const ImageBuf& src, int channel, std::vector<imagesize_t>& hist,
             int i     = clamp(int((val - min) * ratio), 0, bins_minus_1);
             h[i] += 1;
         }
-
-        // Safely update the master histogram
-        lock_guard lock(mutex);
-        for (int i = 0; i < bins; ++i)
-            hist[i] += h[i];
-    });
+    };
+    hist = ImageBufAlgo::parallel_image_reduce(
+        roi, nthreads, Counts(bins, 0), band_hist,
+        [=](Counts& total, const Counts& h) {
+            for (int i = 0; i < bins; ++i)
+                total[i] += h[i];
+        });
     return true;
 }
 
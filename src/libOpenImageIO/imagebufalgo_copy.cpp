@@ -253,6 +253,10 @@ ImageBufAlgo::copy(const ImageBuf& src, TypeDesc convert, ROI roi, int nthreads)
 bool
 ImageBufAlgo::crop(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
 {
+    if (&dst == &src) {  // Handle in-place operation
+        ImageBuf srcshare(src);
+        return crop(dst, srcshare, roi, nthreads);
+    }
     pvt::LoggedTimer logtime("IBA::crop");
     dst.clear();
     roi.chend = std::min(roi.chend, src.nchannels());
@@ -369,6 +373,11 @@ bool
 ImageBufAlgo::circular_shift(ImageBuf& dst, const ImageBuf& src, int xshift,
                              int yshift, int zshift, ROI roi, int nthreads)
 {
+    if (&dst == &src) {  // Handle in-place operation
+        ImageBuf srcshare(src);
+        return circular_shift(dst, srcshare, xshift, yshift, zshift, roi,
+                              nthreads);
+    }
     pvt::LoggedTimer logtime("IBA::circular_shift");
     if (!IBAprep(roi, &dst, &src))
         return false;
@@ -42,38 +42,83 @@ flatten_(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
         int G_channel      = srcspec.channelindex("G");
         int B_channel      = srcspec.channelindex("B");
         float* val         = OIIO_ALLOCA(float, nc);
-        float& ARval(val[AR_channel]);
-        float& AGval(val[AG_channel]);
-        float& ABval(val[AB_channel]);
+        bool* needed       = OIIO_ALLOCA(bool, nc);
+        for (int c = 0; c < nc; ++c)
+            needed[c] = (c >= roi.chbegin && c < roi.chend)
+                        || c == AR_channel || c == AG_channel
+                        || c == AB_channel;
+        // Each pixel's samples are gathered a channel at a time into
+        // contiguous arrays, and only for the channels needed, so that the
+        // sums over the samples are simple loops over floats.
+        std::vector<float> chanvals, weights;
 
         for (ImageBuf::Iterator<DSTTYPE> r(dst, roi); !r.done(); ++r) {
             int x = r.x(), y = r.y(), z = r.z();
-            int samps = src.deep_samples(x, y, z);
+            int64_t pixel = src.pixelindex(x, y, z, true);
+            int samps     = pixel >= 0 ? dd->samples(pixel) : 0;
             // Clear accumulated values for this pixel (0 for colors, big for Z)
             memset(val, 0, nc * sizeof(float));
             if (Z_channel >= 0 && samps == 0)
                 val[Z_channel] = 1.0e30;
             if (Zback_channel >= 0 && samps == 0)
                 val[Zback_channel] = 1.0e30;
-            for (int s = 0; s < samps; ++s) {
-                float AR = ARval, AG = AGval, AB = ABval;  // make copies
-                float alpha = (AR + AG + AB) / 3.0f;
-                if (alpha >= 1.0f)
-                    break;
-                for (int c = 0; c < nc; ++c) {
-                    float v = src.deep_value(x, y, z, c, s);
-                    if (c == Z_channel || c == Zback_channel)
-                        val[c] *= alpha;  // because Z are not premultiplied
-                    float a;
-                    if (c == R_channel)
-                        a = AR;
-                    else if (c == G_channel)
-                        a = AG;
-                    else if (c == B_channel)
-                        a = AB;
-                    else
-                        a = alpha;
-                    val[c] += (1.0f - a) * v;
+            if (samps) {
+                chanvals.resize(size_t(nc) * samps);
+                weights.resize(size_t(5) * samps);
+                auto chan = [&](int c) { return &chanvals[size_t(c) * samps]; };
+                for (int c = 0; c < nc; ++c)
+                    if (needed[c])
+                        dd->deep_values(pixel, c, { chan(c), size_t(samps) });
+                // The weights of the R, G, B, and other channels of each
+                // sample depend only on the alpha accumulated in front of
+                // it, until it's opaque.
+                float* wR = &weights[0];
+                float* wG = wR + samps;
+                float* wB = wG + samps;
+                float* w  = wB + samps;
+                float* a  = w + samps;
+                auto weight = [&](int c) {
+                    return c == R_channel   ? wR
+                           : c == G_channel ? wG
+                           : c == B_channel ? wB
+                                            : w;
+                };
+                int n = 0;
+                for (; n < samps; ++n) {
+                    float AR = val[AR_channel], AG = val[AG_channel],
+                          AB    = val[AB_channel];
+                    float alpha = (AR + AG + AB) / 3.0f;
+                    if (alpha >= 1.0f)
+                        break;
+                    wR[n] = 1.0f - AR;
+                    wG[n] = 1.0f - AG;
+                    wB[n] = 1.0f - AB;
+                    w[n]  = 1.0f - alpha;
+                    a[n]  = alpha;
+                    val[AR_channel] += weight(AR_channel)[n]
+                                       * chan(AR_channel)[n];
+                    if (AG_channel != AR_channel)
+                        val[AG_channel] += weight(AG_channel)[n]
+                                           * chan(AG_channel)[n];
+                    if (AB_channel != AR_channel && AB_channel != AG_channel)
+                        val[AB_channel] += weight(AB_channel)[n]
+                                           * chan(AB_channel)[n];
+                }
+                for (int c = roi.chbegin; c < roi.chend; ++c) {
+                    if (c == AR_channel || c == AG_channel || c == AB_channel)
+                        continue;  // Already accumulated above
+                    const float* v  = chan(c);
+                    const float* wc = weight(c);
+                    float sum       = 0.0f;
+                    if (c == Z_channel || c == Zback_channel) {
+                        // Z are not premultiplied
+                        for (int s = 0; s < n; ++s)
+                            sum = sum * a[s] + wc[s] * v[s];
+                    } else {
+                        for (int s = 0; s < n; ++s)
+                            sum += wc[s] * v[s];
+                    }
+                    val[c] = sum;
                 }
             }
 
@@ -238,6 +283,57 @@ ImageBufAlgo::deepen(const ImageBuf& src, float zvalue, ROI roi, int nthreads)
 
 
 
+// How many of the pixel's samples does a sample [z1,zback1] split, or is
+// split by, a sample [z2,zback2]?
+inline int
+overlap_splits(float z1, float zback1, float z2, float zback2)
+{
+    return int(z1 > z2 && z1 < zback2) + int(zback1 > z2 && zback1 < zback2)
+           + int(z2 > z1 && z2 < zback1) + int(zback2 > z1 && zback2 < zback1);
+}
+
+
+
+// The most samples that merging B's pixel into A's can produce: all of
+// both pixels' samples, plus one more for every split of a sample by the
+// front or back of another (from either pixel).
+static int
+merged_capacity(const DeepData& Add, int Apixel, const DeepData& Bdd,
+                int Bpixel)
+{
+    int Asamps = Add.samples(Apixel);
+    int Bsamps = Bdd.samples(Bpixel);
+    if (!Asamps || !Bsamps) {
+        // Nothing to merge; any splits of a pixel's samples by each other
+        // are left as they were.
+        return Asamps + Bsamps;
+    }
+    // Gather the depths of both pixels' samples once
+    span<float> Az     = OIIO_ALLOCA_SPAN(float, Asamps);
+    span<float> Azback = OIIO_ALLOCA_SPAN(float, Asamps);
+    span<float> Bz     = OIIO_ALLOCA_SPAN(float, Bsamps);
+    span<float> Bzback = OIIO_ALLOCA_SPAN(float, Bsamps);
+    Add.deep_values(Apixel, Add.Z_channel(), Az);
+    Add.deep_values(Apixel, Add.Zback_channel(), Azback);
+    Bdd.deep_values(Bpixel, Bdd.Z_channel(), Bz);
+    Bdd.deep_values(Bpixel, Bdd.Zback_channel(), Bzback);
+    int nsplits = 0;
+    for (int s = 0; s < Asamps; ++s) {
+        for (int d = 0; d < Bsamps; ++d)
+            nsplits += overlap_splits(Az[s], Azback[s], Bz[d], Bzback[d]);
+        // Check for splits A vs A -- in case they overlap!
+        for (int ss = s; ss < Asamps; ++ss)
+            nsplits += overlap_splits(Az[s], Azback[s], Az[ss], Azback[ss]);
+    }
+    // Check for splits B vs B -- in case they overlap!
+    for (int d = 0; d < Bsamps; ++d)
+        for (int dd = d; dd < Bsamps; ++dd)
+            nsplits += overlap_splits(Bz[d], Bzback[d], Bz[dd], Bzback[dd]);
+    return Asamps + Bsamps + nsplits;
+}
+
+
+
 bool
 ImageBufAlgo::deep_merge(ImageBuf& dst, const ImageBuf& A, const ImageBuf& B,
                          bool occlusion_cull, ROI roi, int nthreads)
@@ -258,92 +354,40 @@ ImageBufAlgo::deep_merge(ImageBuf& dst, const ImageBuf& A, const ImageBuf& B,
 
     // First, set the capacity of the dst image to reserve enough space for
     // the segments of both source images, including any splits that may
-    // occur.
+    // occur. Setting capacities before the samples are allocated is cheap
+    // and thread-safe.
     DeepData& dstdd(*dst.deepdata());
     const DeepData& Add(*A.deepdata());
     const DeepData& Bdd(*B.deepdata());
-    int Azchan     = Add.Z_channel();
-    int Azbackchan = Add.Zback_channel();
-    int Bzchan     = Bdd.Z_channel();
-    int Bzbackchan = Bdd.Zback_channel();
-    for (int z = roi.zbegin; z < roi.zend; ++z)
-        for (int y = roi.ybegin; y < roi.yend; ++y)
-            for (int x = roi.xbegin; x < roi.xend; ++x) {
-                int dstpixel            = dst.pixelindex(x, y, z, true);
-                int Apixel              = A.pixelindex(x, y, z, true);
-                int Bpixel              = B.pixelindex(x, y, z, true);
-                int Asamps              = Add.samples(Apixel);
-                int Bsamps              = Bdd.samples(Bpixel);
-                int nsplits             = 0;
-                int self_overlap_splits = 0;
-                for (int s = 0; s < Asamps; ++s) {
-                    float src_z     = Add.deep_value(Apixel, Azchan, s);
-                    float src_zback = Add.deep_value(Apixel, Azbackchan, s);
-                    for (int d = 0; d < Bsamps; ++d) {
-                        float dst_z     = Bdd.deep_value(Bpixel, Bzchan, d);
-                        float dst_zback = Bdd.deep_value(Bpixel, Bzbackchan, d);
-                        if (src_z > dst_z && src_z < dst_zback)
-                            ++nsplits;
-                        if (src_zback > dst_z && src_zback < dst_zback)
-                            ++nsplits;
-                        if (dst_z > src_z && dst_z < src_zback)
-                            ++nsplits;
-                        if (dst_zback > src_z && dst_zback < src_zback)
-                            ++nsplits;
-                    }
-                    // Check for splits src vs src -- in case they overlap!
-                    for (int ss = s; ss < Asamps; ++ss) {
-                        float src_z2     = Add.deep_value(Apixel, Azchan, ss);
-                        float src_zback2 = Add.deep_value(Apixel, Azbackchan,
-                                                          ss);
-                        if (src_z2 > src_z && src_z2 < src_zback)
-                            ++self_overlap_splits;
-                        if (src_zback2 > src_z && src_zback2 < src_zback)
-                            ++self_overlap_splits;
-                        if (src_z > src_z2 && src_z < src_zback2)
-                            ++self_overlap_splits;
-                        if (src_zback > src_z2 && src_zback < src_zback2)
-                            ++self_overlap_splits;
-                    }
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        for (int z = roi.zbegin; z < roi.zend; ++z)
+            for (int y = roi.ybegin; y < roi.yend; ++y)
+                for (int x = roi.xbegin; x < roi.xend; ++x) {
+                    int dstpixel = dst.pixelindex(x, y, z, true);
+                    int Apixel   = A.pixelindex(x, y, z, true);
+                    int Bpixel   = B.pixelindex(x, y, z, true);
+                    dstdd.set_capacity(dstpixel, merged_capacity(Add, Apixel,
+                                                                 Bdd, Bpixel));
                 }
-                // Check for splits dst vs dst -- in case they overlap!
-                for (int d = 0; d < Bsamps; ++d) {
-                    float dst_z     = Bdd.deep_value(Bpixel, Bzchan, d);
-                    float dst_zback = Bdd.deep_value(Bpixel, Bzbackchan, d);
-                    for (int dd = d; dd < Bsamps; ++dd) {
-                        float dst_z2     = Bdd.deep_value(Bpixel, Bzchan, dd);
-                        float dst_zback2 = Bdd.deep_value(Bpixel, Bzbackchan,
-                                                          dd);
-                        if (dst_z2 > dst_z && dst_z2 < dst_zback)
-                            ++self_overlap_splits;
-                        if (dst_zback2 > dst_z && dst_zback2 < dst_zback)
-                            ++self_overlap_splits;
-                        if (dst_z > dst_z2 && dst_z < dst_zback2)
-                            ++self_overlap_splits;
-                        if (dst_zback > dst_z2 && dst_zback < dst_zback2)
-                            ++self_overlap_splits;
-                    }
-                }
-
-                dstdd.set_capacity(dstpixel, Asamps + Bsamps + nsplits
-                                                 + self_overlap_splits);
-            }
+    });
 
     bool ok = ImageBufAlgo::copy(dst, A, TypeDesc::UNKNOWN, roi, nthreads);
-
-    for (int z = roi.zbegin; z < roi.zend; ++z)
-        for (int y = roi.ybegin; y < roi.yend; ++y)
-            for (int x = roi.xbegin; x < roi.xend; ++x) {
-                int dstpixel = dst.pixelindex(x, y, z, true);
-                int Bpixel   = B.pixelindex(x, y, z, true);
-                OIIO_DASSERT(dstpixel >= 0);
-                // OIIO_UNUSED_OK int oldcap = dstdd.capacity (dstpixel);
-                dstdd.merge_deep_pixels(dstpixel, Bdd, Bpixel);
-                // OIIO_DASSERT (oldcap == dstdd.capacity(dstpixel) &&
-                //          "Broken: we did not preallocate enough capacity");
-                if (occlusion_cull)
-                    dstdd.occlusion_cull(dstpixel);
-            }
+    dstdd.all_data();  // Make sure it's allocated, even if A had no samples
+
+    // With enough capacity for every pixel's merge, the merges never move
+    // any other pixel's samples, so the pixels may be merged in parallel.
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        for (int z = roi.zbegin; z < roi.zend; ++z)
+            for (int y = roi.ybegin; y < roi.yend; ++y)
+                for (int x = roi.xbegin; x < roi.xend; ++x) {
+                    int dstpixel = dst.pixelindex(x, y, z, true);
+                    int Bpixel   = B.pixelindex(x, y, z, true);
+                    OIIO_DASSERT(dstpixel >= 0);
+                    dstdd.merge_deep_pixels(dstpixel, Bdd, Bpixel);
+                    if (occlusion_cull)
+                        dstdd.occlusion_cull(dstpixel);
+                }
+    });
     return ok;
 }
 
@@ -5,9 +5,14 @@
 /// \file
 /// Implementation of ImageBufAlgo demosaic algorithms
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/simd.h>
 
 #include "imagebufalgo_demosaic_prv.h"
 #include "imageio_pvt.h"
@@ -220,6 +225,29 @@ protected:
 
     std::string error;
 
+    /// The window as seen by 8 pixels of the same pattern phase in
+    /// process_rows(): `planes[row * pattern_size + phase]` are the columns
+    /// of each window row with that phase, so `(row, col)` of all 8 pixels
+    /// is a single load.
+    struct Taps {
+        const float* const* planes;
+        int first_column;  ///< Column of the first pixel, < pattern_size
+        int index;         ///< Index within its phase of the first pixel
+
+        simd::vfloat8 operator()(int row, int col) const
+        {
+            int c = first_column + col;
+            return simd::vfloat8(planes[row * pattern_size + c % pattern_size]
+                                 + index + c / pattern_size);
+        }
+    };
+
+    static int pattern_phase(int v)
+    {
+        v %= pattern_size;
+        return v < 0 ? v + pattern_size : v;
+    }
+
 public:
     bool process(ImageBuf& dst, const ImageBuf& src,
                  const float (&white_balance)[4], ROI roi, int nthreads)
@@ -263,6 +291,136 @@ public:
         return true;
     };
 
+    /// Same as process(), but instead of sliding a Window over each row,
+    /// compute 8 pixels of the same pattern phase at a time with the SIMD
+    /// `Formulas::pixels(rowphase, colphase, Taps, vfloat8 rgb[3])`. Each
+    /// source row is read only once per band of rows, white balanced and
+    /// mirrored past the image edges just as the Window does, and split by
+    /// column phase into contiguous planes.
+    template<class Formulas>
+    bool process_rows(ImageBuf& dst, const ImageBuf& src,
+                      const float (&white_balance)[4], ROI roi, int nthreads)
+    {
+        if (error.length() > 0) {
+            dst.errorfmt("Demosaic::process() {}", error);
+            return false;
+        }
+
+        constexpr int central = window_size / 2;
+        const ImageSpec& spec = src.spec();
+        const int src_xbegin  = spec.x;
+        const int src_xend    = spec.x + spec.width;
+        const int src_ybegin  = spec.y;
+        const int src_yend    = spec.y + spec.height;
+
+        ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI band) {
+            const int width  = band.width();
+            const int padded = width + 2 * central;
+            // Room for a whole vector past the last pixel of every phase.
+            const int planelen = (width + pattern_size - 1) / pattern_size + 8
+                                 + (pattern_size - 1 + 2 * central)
+                                       / pattern_size;
+            // The planes of the last `window_size` source rows used, which
+            // the next output row mostly needs again.
+            std::vector<float> planes(window_size * pattern_size
+                                          * size_t(planelen),
+                                      0.0f);
+            int cached[window_size];
+            std::fill(cached, cached + window_size,
+                      std::numeric_limits<int>::min());
+
+            // Only these source columns can be needed, even mirrored.
+            const int lo = std::max(src_xbegin,
+                                    band.xbegin - central - pattern_size);
+            const int hi = std::max(lo + 1,
+                                    std::min(src_xend,
+                                             band.xend + central
+                                                 + pattern_size));
+            std::vector<float> srcrow(hi - lo);
+            auto fill_planes = [&](float* rowplanes, int y) {
+                src.get_pixels(ROI(lo, hi, y, y + 1, spec.z, spec.z + 1, 0, 1),
+                               make_span(srcrow));
+                const size_t* channels
+                    = channel_map[pattern_phase(y + y_offset)];
+                for (int i = 0; i < padded; ++i) {
+                    int x = band.xbegin - central + i;
+                    while (x < src_xbegin)
+                        x += pattern_size;
+                    while (x > src_xend - 1)
+                        x -= pattern_size;
+                    x = OIIO::clamp(x, lo, hi - 1);
+                    size_t channel = channels[pattern_phase(x + x_offset)];
+                    float wb       = white_balance[channel];
+                    rowplanes[(i % pattern_size) * planelen + i / pattern_size]
+                        = srcrow[x - lo] * wb;
+                }
+            };
+
+            std::vector<float> out(size_t(width) * 3);
+            const float* rows[window_size * pattern_size];
+            for (int y = band.ybegin; y < band.yend; y++) {
+                int needed[window_size];
+                for (int i = 0; i < window_size; i++) {
+                    int ystart = y - central + i;
+                    while (ystart < src_ybegin)
+                        ystart += pattern_size;
+                    while (ystart > src_yend - 1)
+                        ystart -= pattern_size;
+                    needed[i] = ystart;
+                }
+                for (int i = 0; i < window_size; i++) {
+                    int slot = int(std::find(cached, cached + window_size,
+                                             needed[i])
+                                   - cached);
+                    if (slot == window_size) {
+                        // Replace a row this output row doesn't use.
+                        slot = 0;
+                        while (std::find(needed, needed + window_size,
+                                         cached[slot])
+                               != needed + window_size)
+                            slot++;
+                        fill_planes(&planes[size_t(slot) * pattern_size
+                                            * planelen],
+                                    needed[i]);
+                        cached[slot] = needed[i];
+                    }
+                    for (int p = 0; p < pattern_size; p++)
+                        rows[i * pattern_size + p]
+                            = &planes[size_t(slot * pattern_size + p)
+                                      * planelen];
+                }
+
+                const int rowphase = pattern_phase(y + y_offset);
+                for (int q = 0; q < pattern_size && q < width; q++) {
+                    const int colphase = pattern_phase(band.xbegin + q
+                                                       + x_offset);
+                    const int n = (width - q + pattern_size - 1)
+                                  / pattern_size;
+                    for (int j = 0; j < n; j += 8) {
+                        simd::vfloat8 rgb[3];
+                        Formulas::pixels(rowphase, colphase,
+                                         Taps { rows, q, j }, rgb);
+                        float vals[3][8];
+                        for (int c = 0; c < 3; c++)
+                            rgb[c].store(vals[c]);
+                        for (int k = 0, e = std::min(8, n - j); k < e; k++) {
+                            float* o = &out[size_t(q + (j + k) * pattern_size)
+                                            * 3];
+                            o[0]     = vals[0][k];
+                            o[1]     = vals[1][k];
+                            o[2]     = vals[2][k];
+                        }
+                    }
+                }
+                dst.set_pixels(ROI(band.xbegin, band.xend, y, y + 1,
+                                   band.zbegin, band.zend, 0, 3),
+                               make_span(out));
+            }
+        });
+
+        return true;
+    }
+
     inline static size_t channel_at_offset(int x_offset, int y_offset)
     {
         return channel_map[y_offset % pattern_size][x_offset % pattern_size];
@@ -396,6 +554,29 @@ private:
     }
 
 public:
+    /// The formulas of calc_RG and calc_GB, for process_rows().
+    template<class W>
+    static void pixels(int rowphase, int colphase, const W& w,
+                       simd::vfloat8 (&rgb)[3])
+    {
+        simd::vfloat8 center = w(1, 1);
+        if (rowphase == colphase) {
+            simd::vfloat8 cross = (w(0, 1) + w(2, 1) + w(1, 0) + w(1, 2))
+                                  / 4.0f;
+            simd::vfloat8 diag = (w(0, 0) + w(0, 2) + w(2, 0) + w(2, 2))
+                                 / 4.0f;
+            rgb[0] = rowphase == 0 ? center : diag;
+            rgb[1] = cross;
+            rgb[2] = rowphase == 0 ? diag : center;
+        } else {
+            simd::vfloat8 horiz = (w(1, 0) + w(1, 2)) / 2.0f;
+            simd::vfloat8 vert  = (w(0, 1) + w(2, 1)) / 2.0f;
+            rgb[0]              = rowphase == 0 ? horiz : vert;
+            rgb[1]              = center;
+            rgb[2]              = rowphase == 0 ? vert : horiz;
+        }
+    }
+
     LinearBayerDemosaicing(const std::string& layout)
         : BayerDemosaicing<Rtype, Atype, 3>(layout)
     {
@@ -412,9 +593,10 @@ class MHCBayerDemosaicing : public BayerDemosaicing<Rtype, Atype, 5> {
 private:
     using Window = typename MHCBayerDemosaicing<Rtype, Atype>::Window;
 
-    inline static void mix1(Window& w, float& out_mix1, float& out_mix2)
+    template<class W, class T>
+    inline static void mix1(W& w, T& out_mix1, T& out_mix2)
     {
-        float tmp = w(0, 2) + w(4, 2) + w(2, 0) + w(2, 4);
+        T tmp    = w(0, 2) + w(4, 2) + w(2, 0) + w(2, 4);
         out_mix1  = (8.0f * w(2, 2)
                     + 4.0f * (w(1, 2) + w(3, 2) + w(2, 1) + w(2, 3))
                     - 2.0f * tmp)
@@ -425,9 +607,10 @@ private:
                    / 16.0f;
     }
 
-    inline static void mix2(Window& w, float& out_mix1, float& out_mix2)
+    template<class W, class T>
+    inline static void mix2(W& w, T& out_mix1, T& out_mix2)
     {
-        float tmp = w(1, 1) + w(1, 3) + w(3, 1) + w(3, 3);
+        T tmp = w(1, 1) + w(1, 3) + w(3, 1) + w(3, 3);
 
         out_mix1 = (10.0f * w(2, 2) + 8.0f * (w(2, 1) + w(2, 3))
                     - 2.0f * (tmp + w(2, 0) + w(2, 4))
@@ -499,6 +682,25 @@ private:
     }
 
 public:
+    /// The formulas of calc_RG and calc_GB, for process_rows().
+    template<class W>
+    static void pixels(int rowphase, int colphase, const W& w,
+                       simd::vfloat8 (&rgb)[3])
+    {
+        simd::vfloat8 val1, val2;
+        if (rowphase == colphase) {
+            mix1(w, val1, val2);
+            rgb[0] = rowphase == 0 ? w(2, 2) : val2;
+            rgb[1] = val1;
+            rgb[2] = rowphase == 0 ? val2 : w(2, 2);
+        } else {
+            mix2(w, val1, val2);
+            rgb[0] = rowphase == 0 ? val1 : val2;
+            rgb[1] = w(2, 2);
+            rgb[2] = rowphase == 0 ? val2 : val1;
+        }
+    }
+
     MHCBayerDemosaicing(const std::string& layout)
         : BayerDemosaicing<Rtype, Atype, 5>(layout)
     {
@@ -567,6 +769,108 @@ private:
                / (1.5 + M_SQRT1_2 + 1.0 / sqrt(5.0));
     }
 
+    // The formulas of the calc_* functions below, for process_rows():
+    // `formulas[block][i][ch]` is channel `ch` of the `i`th pixel of the
+    // block, and `row_blocks` the two blocks making up each row.
+    enum Kind { Center, Cross, Triangle, Pentagon, Square };
+    struct Formula {
+        Kind kind;
+        int taps[5][2];
+    };
+    static constexpr Formula C22 = { Center, { { 2, 2 } } };
+    static constexpr Formula formulas[6][3][3] = {
+        // GRB_bgg
+        { { { Cross, { { 0, 2 }, { 2, 1 }, { 2, 3 }, { 4, 2 } } },
+            C22,
+            { Cross, { { 2, 0 }, { 1, 2 }, { 3, 2 }, { 2, 4 } } } },
+          { C22,
+            { Pentagon,
+              { { 2, 1 }, { 1, 2 }, { 3, 2 }, { 1, 3 }, { 3, 3 } } },
+            { Triangle, { { 2, 3 }, { 1, 1 }, { 3, 1 } } } },
+          { { Triangle, { { 2, 1 }, { 1, 3 }, { 3, 3 } } },
+            { Pentagon,
+              { { 2, 3 }, { 1, 2 }, { 3, 2 }, { 1, 1 }, { 3, 1 } } },
+            C22 } },
+        // GBR_rgg
+        { { { Cross, { { 2, 0 }, { 1, 2 }, { 3, 2 }, { 2, 4 } } },
+            C22,
+            { Cross, { { 0, 2 }, { 2, 1 }, { 2, 3 }, { 4, 2 } } } },
+          { { Triangle, { { 2, 3 }, { 1, 1 }, { 3, 1 } } },
+            { Pentagon,
+              { { 2, 1 }, { 1, 2 }, { 3, 2 }, { 1, 3 }, { 3, 3 } } },
+            C22 },
+          { C22,
+            { Pentagon,
+              { { 2, 3 }, { 1, 2 }, { 3, 2 }, { 1, 1 }, { 3, 1 } } },
+            { Triangle, { { 2, 1 }, { 1, 3 }, { 3, 3 } } } } },
+        // BGG_rgg
+        { { { Triangle, { { 3, 2 }, { 1, 1 }, { 1, 3 } } },
+            { Pentagon,
+              { { 1, 2 }, { 2, 1 }, { 2, 3 }, { 3, 1 }, { 3, 3 } } },
+            C22 },
+          { { Square, { { 1, 2 }, { 3, 1 }, { 2, 4 }, { 4, 3 } } },
+            C22,
+            { Square, { { 2, 1 }, { 1, 3 }, { 4, 2 }, { 3, 4 } } } },
+          { { Square, { { 2, 3 }, { 1, 1 }, { 4, 2 }, { 3, 0 } } },
+            C22,
+            { Square, { { 1, 2 }, { 3, 3 }, { 2, 0 }, { 4, 1 } } } } },
+        // RGG_bgg
+        { { C22,
+            { Pentagon,
+              { { 1, 2 }, { 2, 1 }, { 2, 3 }, { 3, 1 }, { 3, 3 } } },
+            { Triangle, { { 3, 2 }, { 1, 1 }, { 1, 3 } } } },
+          { { Square, { { 2, 1 }, { 1, 3 }, { 4, 2 }, { 3, 4 } } },
+            C22,
+            { Square, { { 1, 2 }, { 3, 1 }, { 2, 4 }, { 4, 3 } } } },
+          { { Square, { { 1, 2 }, { 3, 3 }, { 2, 0 }, { 4, 1 } } },
+            C22,
+            { Square, { { 2, 3 }, { 1, 1 }, { 4, 2 }, { 3, 0 } } } } },
+        // RGG_gbr
+        { { C22,
+            { Pentagon,
+              { { 3, 2 }, { 2, 1 }, { 2, 3 }, { 1, 1 }, { 1, 3 } } },
+            { Triangle, { { 1, 2 }, { 3, 1 }, { 3, 3 } } } },
+          { { Square, { { 2, 1 }, { 3, 3 }, { 0, 2 }, { 1, 4 } } },
+            C22,
+            { Square, { { 3, 2 }, { 1, 1 }, { 2, 4 }, { 0, 3 } } } },
+          { { Square, { { 3, 2 }, { 1, 3 }, { 2, 0 }, { 3, 4 } } },
+            C22,
+            { Square, { { 2, 3 }, { 3, 1 }, { 0, 2 }, { 1, 0 } } } } },
+        // BGG_grb
+        { { { Triangle, { { 1, 2 }, { 3, 1 }, { 3, 3 } } },
+            { Pentagon,
+              { { 3, 2 }, { 2, 1 }, { 2, 3 }, { 1, 1 }, { 1, 3 } } },
+            C22 },
+          { { Square, { { 3, 2 }, { 1, 1 }, { 2, 4 }, { 0, 3 } } },
+            C22,
+            { Square, { { 2, 1 }, { 3, 3 }, { 0, 2 }, { 1, 4 } } } },
+          { { Square, { { 2, 3 }, { 3, 1 }, { 0, 2 }, { 1, 0 } } },
+            C22,
+            { Square, { { 3, 2 }, { 1, 3 }, { 2, 0 }, { 3, 4 } } } } },
+    };
+    static constexpr int row_blocks[6][2] = { { 0, 1 }, { 2, 3 }, { 4, 5 },
+                                              { 1, 0 }, { 3, 2 }, { 5, 4 } };
+
+    template<class W>
+    static simd::vfloat8 evaluate(const Formula& f, const W& w)
+    {
+        using simd::vfloat8;
+        auto t = [&](int i) { return w(f.taps[i][0], f.taps[i][1]); };
+        const float s = float(M_SQRT1_2);
+        switch (f.kind) {
+        case Cross: return (t(0) + t(3) + (t(1) + t(2)) * 2.0f) / 6.0f;
+        case Triangle: return (t(0) + (t(1) + t(2)) * s) / (1.0f + s + s);
+        case Pentagon:
+            return (t(0) + t(1) + t(2) + (t(3) + t(4)) * s) / (3.0f + s + s);
+        case Square: {
+            const float r5 = float(1.0 / sqrt(5.0));
+            return (t(0) + t(1) * s + t(2) * 0.5f + t(3) * r5)
+                   / float(1.5 + M_SQRT1_2 + 1.0 / sqrt(5.0));
+        }
+        default: return t(0);
+        }
+    }
+
     template<bool check> inline static bool calc_GRB_bgg(Context& c)
     {
         auto& w = c.window;
@@ -906,6 +1210,16 @@ private:
     }
 
 public:
+    template<class W>
+    static void pixels(int rowphase, int colphase, const W& w,
+                       simd::vfloat8 (&rgb)[3])
+    {
+        const Formula(&pixel)[3]
+            = formulas[row_blocks[rowphase][colphase / 3]][colphase % 3];
+        for (int c = 0; c < 3; c++)
+            rgb[c] = evaluate(pixel[c], w);
+    }
+
     LinearXTransDemosaicing(const std::string& layout)
         : XTransDemosaicing<Rtype, Atype, 5>(layout)
     {
@@ -934,6 +1248,9 @@ bayer_demosaic_linear_impl(ImageBuf& dst, const ImageBuf& src,
                            int nthreads)
 {
     LinearBayerDemosaicing<Rtype, Atype> obj(layout);
+    if (pvt::imagebufalgo_fastpaths && roi.chbegin == 0 && roi.chend == 3)
+        return obj.template process_rows<LinearBayerDemosaicing<Rtype, Atype>>(
+            dst, src, white_balance, roi, nthreads);
     return obj.process(dst, src, white_balance, roi, nthreads);
 }
 
@@ -944,9 +1261,10 @@ bayer_demosaic_MHC_impl(ImageBuf& dst, const ImageBuf& src,
                         const float (&white_balance)[4], ROI roi, int nthreads)
 {
     MHCBayerDemosaicing<Rtype, Atype> obj(layout);
+    if (pvt::imagebufalgo_fastpaths && roi.chbegin == 0 && roi.chend == 3)
+        return obj.template process_rows<MHCBayerDemosaicing<Rtype, Atype>>(
+            dst, src, white_balance, roi, nthreads);
     return obj.process(dst, src, white_balance, roi, nthreads);
-
-    return true;
 }
 
 template<class Rtype, class Atype>
@@ -957,6 +1275,9 @@ xtrans_demosaic_linear_impl(ImageBuf& dst, const ImageBuf& src,
                             int nthreads)
 {
     LinearXTransDemosaicing<Rtype, Atype> obj(layout);
+    if (pvt::imagebufalgo_fastpaths && roi.chbegin == 0 && roi.chend == 3)
+        return obj.template process_rows<LinearXTransDemosaicing<Rtype, Atype>>(
+            dst, src, white_balance, roi, nthreads);
     return obj.process(dst, src, white_balance, roi, nthreads);
 }
 
@@ -1046,13 +1367,13 @@ demosaic(ImageBuf& dst, const ImageBuf& src, KWArgs options, ROI roi,
                                         bayer_demosaic_linear_impl,
                                         dst.spec().format, src.spec().format,
                                         dst, src, layout, white_balance_RGBG,
-                                        dst_roi, 1);
+                                        dst_roi, nthreads);
         } else if (algorithm == "MHC") {
             OIIO_DISPATCH_COMMON_TYPES2(ok, "bayer_demosaic_MHC",
                                         bayer_demosaic_MHC_impl,
                                         dst.spec().format, src.spec().format,
                                         dst, src, layout, white_balance_RGBG,
-                                        dst_roi, 1);
+                                        dst_roi, nthreads);
         } else {
             dst.errorfmt("ImageBufAlgo::demosaic() invalid algorithm");
         }
@@ -1065,7 +1386,7 @@ demosaic(ImageBuf& dst, const ImageBuf& src, KWArgs options, ROI roi,
                                     xtrans_demosaic_linear_impl,
                                     dst.spec().format, src.spec().format, dst,
                                     src, layout, white_balance_RGBG, dst_roi,
-                                    1);
+                                    nthreads);
     } else {
         dst.errorfmt("ImageBufAlgo::demosaic() invalid pattern");
     }
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cmath>
 #include <limits>
+#include <memory>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
@@ -18,6 +19,7 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/simd.h>
 #include <OpenImageIO/sysutil.h>
 #include <OpenImageIO/thread.h>
 
@@ -567,20 +569,75 @@ hashnormal(int x, int y, int z, int c, int seed)
 
 
 
-template<typename T>
+// bjhash::bjfinal of 8 sets of values at once.
+OIIO_FORCEINLINE simd::vint8
+bjfinal8(simd::vint8 a, simd::vint8 b, simd::vint8 c)
+{
+    using simd::rotl;
+    c ^= b;
+    c -= rotl(b, 14);
+    a ^= c;
+    a -= rotl(c, 11);
+    b ^= a;
+    b -= rotl(a, 25);
+    c ^= b;
+    c -= rotl(b, 16);
+    a ^= c;
+    a -= rotl(c, 4);
+    b ^= a;
+    b -= rotl(a, 14);
+    c ^= b;
+    c -= rotl(b, 24);
+    return c;
+}
+
+
+
+// Compute hashrand(x, y, z, c, seed) for the pixels x of [xbegin,xend) of
+// a scanline and channels c of [chbegin,chend), 8 pixels at a time, into
+// vals[(x - xbegin) * nc + c - chbegin] (where nc = chend - chbegin). The
+// values are just the same as hashrand's, so they don't depend on how the
+// image is divided among threads.
+static void
+hashrand_row(float* vals, int xbegin, int xend, int y, int z, int chbegin,
+             int chend, int seed)
+{
+    using namespace simd;
+    const int nc = chend - chbegin;
+    for (int x = xbegin; x < xend; x += 8) {
+        int n    = std::min(8, xend - x);
+        vint8 xh = bjfinal8(vint8::Iota(x), vint8(y), vint8(z));
+        for (int c = chbegin; c < chend; ++c) {
+            vint8 h   = bjfinal8(xh, vint8(c), vint8(seed)) & vint8(0xfffff);
+            vfloat8 r = vfloat8(h) * (1.0f / (0xfffff + 1));
+            float* v  = vals + size_t(x - xbegin) * nc + (c - chbegin);
+            for (int i = 0; i < n; ++i)
+                v[i * nc] = r[i];
+        }
+    }
+}
+
+
+
+// Apply the noise value kernel(x, y, z, c, row) to the pixels of roi a
+// scanline at a time, where row has the values for the x of the scanline
+// and channels [roi.chbegin, chend) computed by fill(row, y, z, chend) --
+// chend being roi.chbegin + 1 if mono, for one value for all channels.
+template<typename T, typename FILL, typename KERNEL>
 static bool
-noise_uniform_(ImageBuf& dst, float min, float max, bool mono, int seed,
-               ROI roi, int nthreads)
+noise_rows_(ImageBuf& dst, bool mono, ROI roi, int nthreads, FILL&& fill,
+            KERNEL&& kernel)
 {
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        const int nc    = mono ? 1 : roi.nchannels();
+        const int chend = roi.chbegin + nc;
+        std::unique_ptr<float[]> row(new float[size_t(roi.width()) * nc]);
         for (ImageBuf::Iterator<T> p(dst, roi); !p.done(); ++p) {
-            int x = p.x(), y = p.y(), z = p.z();
-            float n = 0.0;
-            for (int c = roi.chbegin; c < roi.chend; ++c) {
-                if (c == roi.chbegin || !mono)
-                    n = lerp(min, max, hashrand(x, y, z, c, seed));
-                p[c] = p[c] + n;
-            }
+            if (p.x() == roi.xbegin)
+                fill(row.get(), p.y(), p.z(), chend);
+            const float* r = &row[size_t(p.x() - roi.xbegin) * nc];
+            for (int c = roi.chbegin; c < roi.chend; ++c)
+                kernel(p, c, r[mono ? 0 : c - roi.chbegin]);
         }
     });
     return true;
@@ -588,23 +645,57 @@ noise_uniform_(ImageBuf& dst, float min, float max, bool mono, int seed,
 
 
 
+template<typename T>
+static bool
+noise_uniform_(ImageBuf& dst, float min, float max, bool mono, int seed,
+               ROI roi, int nthreads)
+{
+    return noise_rows_<T>(
+        dst, mono, roi, nthreads,
+        [&](float* row, int y, int z, int chend) {
+            hashrand_row(row, roi.xbegin, roi.xend, y, z, roi.chbegin, chend,
+                         seed);
+        },
+        [&](ImageBuf::Iterator<T>& p, int c, float r) {
+            p[c] = p[c] + lerp(min, max, r);
+        });
+}
+
+
+
 template<typename T>
 static bool
 noise_gaussian_(ImageBuf& dst, float mean, float stddev, bool mono, int seed,
                 ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        for (ImageBuf::Iterator<T> p(dst, roi); !p.done(); ++p) {
-            int x = p.x(), y = p.y(), z = p.z();
-            float n = 0.0;
-            for (int c = roi.chbegin; c < roi.chend; ++c) {
-                if (c == roi.chbegin || !mono)
-                    n = mean + stddev * hashnormal(x, y, z, c, seed);
-                p[c] = p[c] + n;
+    // The first try of hashnormal's Marsaglia polar method, for a whole
+    // scanline, takes two rows of hashrand values. The ~21% of them that
+    // it rejects carry on from there, one at a time.
+    return noise_rows_<T>(
+        dst, mono, roi, nthreads,
+        [&](float* row, int y, int z, int chend) {
+            const int nc = chend - roi.chbegin;
+            const int w  = roi.width();
+            std::unique_ptr<float[]> yrow(new float[size_t(w) * nc]);
+            hashrand_row(row, roi.xbegin, roi.xend, y, z, roi.chbegin, chend,
+                         seed);
+            hashrand_row(yrow.get(), roi.xbegin, roi.xend, y, z, roi.chbegin,
+                         chend, seed + 139);
+            for (int i = 0; i < w * nc; ++i) {
+                float xr = 2.0 * row[i] - 1.0;
+                float yr = 2.0 * yrow[i] - 1.0;
+                float r2 = xr * xr + yr * yr;
+                if (r2 > 1.0 || r2 == 0.0) {
+                    xr = hashnormal(roi.xbegin + i / nc, y, z,
+                                    roi.chbegin + i % nc, seed + 1);
+                } else {
+                    float M = sqrt(-2.0 * log(r2) / r2);
+                    xr      = xr * M;
+                }
+                row[i] = mean + stddev * xr;
             }
-        }
-    });
-    return true;
+        },
+        [&](ImageBuf::Iterator<T>& p, int c, float n) { p[c] = p[c] + n; });
 }
 
 
@@ -614,19 +705,16 @@ static bool
 noise_salt_(ImageBuf& dst, float saltval, float saltportion, bool mono,
             int seed, ROI roi, int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        for (ImageBuf::Iterator<T> p(dst, roi); !p.done(); ++p) {
-            int x = p.x(), y = p.y(), z = p.z();
-            float n = 0.0;
-            for (int c = roi.chbegin; c < roi.chend; ++c) {
-                if (c == roi.chbegin || !mono)
-                    n = hashrand(x, y, z, c, seed);
-                if (n < saltportion)
-                    p[c] = saltval;
-            }
-        }
-    });
-    return true;
+    return noise_rows_<T>(
+        dst, mono, roi, nthreads,
+        [&](float* row, int y, int z, int chend) {
+            hashrand_row(row, roi.xbegin, roi.xend, y, z, roi.chbegin, chend,
+                         seed);
+        },
+        [&](ImageBuf::Iterator<T>& p, int c, float r) {
+            if (r < saltportion)
+                p[c] = saltval;
+        });
 }
 
 
@@ -636,17 +724,23 @@ static bool
 noise_blue_(ImageBuf& dst, float min, float max, bool mono, int seed, ROI roi,
             int nthreads)
 {
+    // All of a plane's pixels look up the same offsets into the periodic
+    // table, so just look up each scanline's row of the table.
+    const int group = roi.chbegin & ~3;
+    const int mask  = pvt::bntable_res - 1;
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        const float(*bnrow)[4] = nullptr;
+        int xoff = 0, yoff = 0;
         for (ImageBuf::Iterator<T> p(dst, roi); !p.done(); ++p) {
-            float n         = 0.0;
-            const float* bn = nullptr;
+            if (p.x() == roi.xbegin) {
+                pvt::bluenoise_offsets(p.z(), group, seed, xoff, yoff);
+                bnrow = pvt::bluenoise_table[(p.y() + yoff) & mask];
+            }
+            const float* bn = bnrow[(p.x() + xoff) & mask];
+            float n         = 0.0f;
             for (int c = roi.chbegin; c < roi.chend; ++c) {
-                if (c == roi.chbegin || !mono) {
-                    if (!bn || !(c & 3))
-                        bn = pvt::bluenoise_4chan_ptr(p.x(), p.y(), p.z(),
-                                                      roi.chbegin & ~3, seed);
+                if (c == roi.chbegin || !mono)
                     n = lerp(min, max, bn[c & 3]);
-                }
                 p[c] = p[c] + n;
             }
         }
@@ -924,33 +1018,154 @@ static const char* default_font_name[] = { "DroidSans", "cour", "Courier New",
 
 
 
-// Helper: given unicode and a font face, compute its size
+// A rasterized glyph.
+struct Glyph {
+    int left, top;                // Offset of the bitmap from the pen
+    int width, rows;              // Size of the bitmap
+    int advance;                  // Of the pen, in pixels
+    std::vector<float> coverage;  // width * rows values in [0,1]
+};
+using GlyphRef = std::shared_ptr<const Glyph>;
+
+struct GlyphKey {
+    ustring font;
+    int fontsize;
+    uint32_t ch;
+    bool operator==(const GlyphKey& k) const
+    {
+        return font == k.font && fontsize == k.fontsize && ch == k.ch;
+    }
+};
+
+struct GlyphKeyHasher {
+    size_t operator()(const GlyphKey& k) const
+    {
+        return k.font.hash() ^ (size_t(k.fontsize) * 0x9e3779b9u) ^ k.ch;
+    }
+};
+
+// The faces we've opened, each with the size it was last set to, and the
+// glyphs rasterized from them, so that rendering the same text again (a
+// burn-in on every frame, say) needn't reopen the font file or rasterize
+// anything. Glyphs that failed to load are remembered as null. Guarded by
+// ft_mutex, like everything else of FreeType's.
+struct Face {
+    FT_Face face = nullptr;
+    int fontsize = 0;
+};
+static std::unordered_map<std::string, Face> face_cache;
+static std::unordered_map<GlyphKey, GlyphRef, GlyphKeyHasher> glyph_cache;
+static const size_t glyph_cache_max = 65536;  // Glyphs before we start over
+static std::unordered_map<std::string, std::string> resolved_fonts;
+
+
+
+// Get the face of the font file, set to fontsize, or return nullptr and
+// put an error message in err.
+static FT_Face
+get_face(const std::string& font, int fontsize, std::string& err)
+{
+    Face& f(face_cache[font]);
+    if (!f.face
+        && FT_New_Face(ft_library, font.c_str(), 0 /* face index */,
+                       &f.face)) {
+        f.face = nullptr;
+        err    = Strutil::fmt::format("Could not set font face to \"{}\"",
+                                      font);
+        return nullptr;
+    }
+    if (f.fontsize != fontsize) {
+        if (FT_Set_Pixel_Sizes(f.face /*handle*/, 0 /*width*/,
+                               fontsize /*height*/)) {
+            f.fontsize = 0;
+            err = Strutil::fmt::format("Could not set font size to {}",
+                                       fontsize);
+            return nullptr;
+        }
+        f.fontsize = fontsize;
+    }
+    return f.face;
+}
+
+
+
+// Look up (rasterizing if need be) the glyphs of utext in the font file at
+// fontsize. Newlines, and characters that the font can't render, give null
+// glyphs. Return false and put an error message in err if the font can't
+// be used at all.
+static bool
+get_glyphs(const std::string& font, int fontsize, cspan<uint32_t> utext,
+           std::vector<GlyphRef>& glyphs, std::string& err)
+{
+    ustring ufont(font);
+    FT_Face face = nullptr;
+    glyphs.clear();
+    glyphs.reserve(utext.size());
+    for (auto ch : utext) {
+        if (ch == '\n') {
+            glyphs.emplace_back();
+            continue;
+        }
+        GlyphKey key { ufont, fontsize, ch };
+        auto found = glyph_cache.find(key);
+        if (found != glyph_cache.end()) {
+            glyphs.push_back(found->second);
+            continue;
+        }
+        if (!face && !(face = get_face(font, fontsize, err)))
+            return false;
+        GlyphRef glyph;
+        if (!FT_Load_Char(face, ch, FT_LOAD_RENDER)) {
+            FT_GlyphSlot slot = face->glyph;
+            auto g            = std::make_shared<Glyph>();
+            g->left           = slot->bitmap_left;
+            g->top            = slot->bitmap_top;
+            g->width          = int(slot->bitmap.width);
+            g->rows           = int(slot->bitmap.rows);
+            g->advance        = int(slot->advance.x >> 6);
+            g->coverage.resize(size_t(g->width) * g->rows);
+            for (int j = 0; j < g->rows; ++j)
+                for (int i = 0; i < g->width; ++i)
+                    g->coverage[j * g->width + i]
+                        = slot->bitmap.buffer[slot->bitmap.pitch * j + i]
+                          / 255.0f;
+            glyph = g;
+        }
+        if (glyph_cache.size() >= glyph_cache_max)
+            glyph_cache.clear();  // Glyphs in use are kept alive by glyphs
+        glyph_cache[key] = glyph;
+        glyphs.push_back(glyph);
+    }
+    return true;
+}
+
+
+
+// Helper: given unicode and its glyphs, compute its size
 static ROI
-text_size_from_unicode(cspan<uint32_t> utext, FT_Face face, int fontsize)
+text_size_from_glyphs(cspan<uint32_t> utext, cspan<GlyphRef> glyphs,
+                      int fontsize)
 {
     int y = 0;
     int x = 0;
     ROI size;
     size.xbegin = size.ybegin = std::numeric_limits<int>::max();
     size.xend = size.yend = std::numeric_limits<int>::min();
-    FT_GlyphSlot slot     = face->glyph;
-    for (auto ch : utext) {
-        if (ch == '\n') {
+    for (size_t i = 0; i < utext.size(); ++i) {
+        if (utext[i] == '\n') {
             x = 0;
             y += fontsize;
             continue;
         }
-        int error = FT_Load_Char(face, ch, FT_LOAD_RENDER);
-        if (error)
+        const Glyph* g = glyphs[i].get();
+        if (!g)
             continue;  // ignore errors
-        size.ybegin = std::min(size.ybegin, y - slot->bitmap_top);
-        size.yend   = std::max(size.yend, y + int(slot->bitmap.rows)
-                                              - int(slot->bitmap_top) + 1);
-        size.xbegin = std::min(size.xbegin, x + int(slot->bitmap_left));
-        size.xend   = std::max(size.xend, x + int(slot->bitmap.width)
-                                              + int(slot->bitmap_left) + 1);
+        size.ybegin = std::min(size.ybegin, y - g->top);
+        size.yend   = std::max(size.yend, y + g->rows - g->top + 1);
+        size.xbegin = std::min(size.xbegin, x + g->left);
+        size.xend   = std::max(size.xend, x + g->width + g->left + 1);
         // increment pen position
-        x += slot->advance.x >> 6;
+        x += g->advance;
     }
     return size;  // Font rendering not supported
 }
@@ -1045,6 +1260,13 @@ resolve_font(string_view font_, std::string& result)
 {
     result.clear();
 
+    // The same names tend to be asked for over and over
+    auto resolved = resolved_fonts.find(font_);
+    if (resolved != resolved_fonts.end()) {
+        result = resolved->second;
+        return true;
+    }
+
     // If we know FT is broken, don't bother trying again
     if (ft_broken)
         return false;
@@ -1106,7 +1328,8 @@ resolve_font(string_view font_, std::string& result)
     }
 
     // Success
-    result = font;
+    result                = font;
+    resolved_fonts[font_] = font;
     return true;
 }
 
@@ -1115,6 +1338,32 @@ resolve_font(string_view font_, std::string& result)
 
 
 
+#ifdef USE_FREETYPE
+// Composite the rendered text (and its alpha, which may have been dilated
+// for a shadow) in textcolor over the pixels of R.
+template<typename T>
+static bool
+render_text_(ImageBuf& R, const ImageBuf& textimg, const ImageBuf& alphaimg,
+             cspan<float> textcolor, float textalpha, ROI roi, int nthreads)
+{
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        ImageBuf::ConstIterator<float> t(textimg, roi, ImageBuf::WrapBlack);
+        ImageBuf::ConstIterator<float> a(alphaimg, roi, ImageBuf::WrapBlack);
+        for (ImageBuf::Iterator<T> r(R, roi); !r.done(); ++r, ++t, ++a) {
+            float val   = t[0];
+            float alpha = a[0] * textalpha;
+            if (val == 0.0f && alpha == 0.0f)
+                continue;  // Most of the box is between the glyphs
+            for (int c = roi.chbegin; c < roi.chend; ++c)
+                r[c] = val * textcolor[c] + (1.0f - alpha) * r[c];
+        }
+    });
+    return true;
+}
+#endif
+
+
+
 ROI
 ImageBufAlgo::text_size(string_view text, int fontsize, string_view font_)
 {
@@ -1124,32 +1373,19 @@ ImageBufAlgo::text_size(string_view text, int fontsize, string_view font_)
     // Thread safety
     lock_guard ft_lock(ft_mutex);
 
-    std::string font;
+    std::string font, err;
     bool ok = resolve_font(font_, font);
     if (!ok) {
         return size;
     }
 
-    int error = 0;
-    FT_Face face;  // handle to face object
-    error = FT_New_Face(ft_library, font.c_str(), 0 /* face index */, &face);
-    if (error) {
-        return size;  // couldn't open the face
-    }
-
-    error = FT_Set_Pixel_Sizes(face /*handle*/, 0 /*width*/,
-                               fontsize /*height*/);
-    if (error) {
-        FT_Done_Face(face);
-        return size;  // couldn't set the character size
-    }
-
     std::vector<uint32_t> utext;
     utext.reserve(text.size());
     Strutil::utf8_to_unicode(text, utext);
-    size = text_size_from_unicode(utext, face, fontsize);
-
-    FT_Done_Face(face);
+    std::vector<GlyphRef> glyphs;
+    if (!get_glyphs(font, fontsize, utext, glyphs, err))
+        return size;  // couldn't open the face or set its size
+    size = text_size_from_glyphs(utext, glyphs, fontsize);
 #endif
 
     return size;  // Font rendering not supported
@@ -1162,7 +1398,7 @@ ImageBufAlgo::render_text(ImageBuf& R, int x, int y, string_view text,
                           int fontsize, string_view font_,
                           cspan<float> textcolor, TextAlignX alignx,
                           TextAlignY aligny, int shadow, ROI roi,
-                          int /*nthreads*/)
+                          int nthreads)
 {
     pvt::LoggedTimer logtime("IBA::render_text");
     if (R.spec().depth > 1) {
@@ -1171,34 +1407,29 @@ ImageBufAlgo::render_text(ImageBuf& R, int x, int y, string_view text,
     }
 
 #ifdef USE_FREETYPE
-    // Thread safety
-    lock_guard ft_lock(ft_mutex);
-
-    std::string font;
-    bool ok = resolve_font(font_, font);
-    if (!ok) {
-        std::string err = font.size() ? font : "Font error";
-        R.errorfmt("{}", err);
-        return false;
-    }
-
-    int error = 0;
-    FT_Face face;  // handle to face object
-    error = FT_New_Face(ft_library, font.c_str(), 0 /* face index */, &face);
-    if (error) {
-        R.errorfmt("Could not set font face to \"{}\"", font);
-        return false;  // couldn't open the face
-    }
+    // Convert the UTF to 32 bit unicode
+    std::vector<uint32_t> utext;
+    utext.reserve(text.size());
+    Strutil::utf8_to_unicode(text, utext);
 
-    error = FT_Set_Pixel_Sizes(face /*handle*/, 0 /*width*/,
-                               fontsize /*height*/);
-    if (error) {
-        FT_Done_Face(face);
-        R.errorfmt("Could not set font size to {}", fontsize);
-        return false;  // couldn't set the character size
+    // Only finding the font and its glyphs needs the lock, not drawing them.
+    std::vector<GlyphRef> glyphs;
+    {
+        lock_guard ft_lock(ft_mutex);  // Thread safety
+        std::string font;
+        bool ok = resolve_font(font_, font);
+        if (!ok) {
+            std::string err = font.size() ? font : "Font error";
+            R.errorfmt("{}", err);
+            return false;
+        }
+        std::string err;
+        if (!get_glyphs(font, fontsize, utext, glyphs, err)) {
+            R.errorfmt("{}", err);
+            return false;
+        }
     }
 
-    FT_GlyphSlot slot = face->glyph;  // a small shortcut
     int nchannels(R.nchannels());
     IBA_FIX_PERCHAN_LEN_DEF(textcolor, nchannels);
 
@@ -1215,13 +1446,8 @@ ImageBufAlgo::render_text(ImageBuf& R, int x, int y, string_view text,
         textalpha = textcolor[3];
     }
 
-    // Convert the UTF to 32 bit unicode
-    std::vector<uint32_t> utext;
-    utext.reserve(text.size());
-    Strutil::utf8_to_unicode(text, utext);
-
     // Compute the size that the text will render as, into an ROI
-    ROI textroi     = text_size_from_unicode(utext, face, fontsize);
+    ROI textroi     = text_size_from_glyphs(utext, glyphs, fontsize);
     textroi.zbegin  = 0;
     textroi.zend    = 1;
     textroi.chbegin = 0;
@@ -1251,7 +1477,8 @@ ImageBufAlgo::render_text(ImageBuf& R, int x, int y, string_view text,
 
     // Glyph by glyph, fill in our textimg buffer
     int origx = x;
-    for (auto ch : utext) {
+    for (size_t g = 0; g < utext.size(); ++g) {
+        uint32_t ch = utext[g];
         // on Windows a newline is encoded as '\r\n'
         // we simply ignore carriage return here
         if (ch == '\r') {
@@ -1262,21 +1489,24 @@ ImageBufAlgo::render_text(ImageBuf& R, int x, int y, string_view text,
             y += fontsize;
             continue;
         }
-        int error = FT_Load_Char(face, ch, FT_LOAD_RENDER);
-        if (error)
+        const Glyph* glyph = glyphs[g].get();
+        if (!glyph)
             continue;  // ignore errors
         // now, draw to our target surface
-        for (int j = 0; j < static_cast<int>(slot->bitmap.rows); ++j) {
-            int ry = y + j - slot->bitmap_top;
-            for (int i = 0; i < static_cast<int>(slot->bitmap.width); ++i) {
-                int rx  = x + i + slot->bitmap_left;
-                float b = slot->bitmap.buffer[slot->bitmap.pitch * j + i]
-                          / 255.0f;
-                textimg.setpixel(rx, ry, b);
+        for (int j = 0; j < glyph->rows; ++j) {
+            int ry = y + j - glyph->top;
+            if (ry < textroi.ybegin || ry >= textroi.yend)
+                continue;
+            float* row = (float*)textimg.pixeladdr(textroi.xbegin, ry);
+            const float* cov = &glyph->coverage[j * glyph->width];
+            for (int i = 0; i < glyph->width; ++i) {
+                int rx = x + i + glyph->left;
+                if (rx >= textroi.xbegin && rx < textroi.xend)
+                    row[rx - textroi.xbegin] = cov[i];
             }
         }
         // increment pen position
-        x += slot->advance.x >> 6;
+        x += glyph->advance;
     }
 
     // Generate the alpha image -- if drop shadow is requested, dilate,
@@ -1291,24 +1521,16 @@ ImageBufAlgo::render_text(ImageBuf& R, int x, int y, string_view text,
         roi = textroi;
     if (!IBAprep(roi, &R))
         return false;
-    roi = roi_intersection(textroi, R.roi());
+    roi         = roi_intersection(textroi, R.roi());
+    roi.chbegin = 0;
+    roi.chend   = nchannels;
 
     // Now fill in the pixels of our destination image
-    span<float> pixelcolor = OIIO_ALLOCA_SPAN(float, nchannels);
-    ImageBuf::ConstIterator<float> t(textimg, roi, ImageBuf::WrapBlack);
-    ImageBuf::ConstIterator<float> a(alphaimg, roi, ImageBuf::WrapBlack);
-    ImageBuf::Iterator<float> r(R, roi);
-    for (; !r.done(); ++r, ++t, ++a) {
-        float val   = t[0];
-        float alpha = a[0] * textalpha;
-        R.getpixel(r.x(), r.y(), pixelcolor);
-        for (int c = 0; c < nchannels; ++c)
-            pixelcolor[c] = val * textcolor[c] + (1.0f - alpha) * pixelcolor[c];
-        R.setpixel(r.x(), r.y(), pixelcolor);
-    }
-
-    FT_Done_Face(face);
-    return true;
+    bool ok;
+    OIIO_DISPATCH_TYPES(ok, "render_text", render_text_, R.spec().format, R,
+                        textimg, alphaimg, textcolor, textalpha, roi,
+                        nthreads);
+    return ok;
 
 #else
     R.errorfmt("OpenImageIO was not compiled with FreeType for font rendering");
@@ -0,0 +1,346 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+/// \file
+/// Pixel math computed directly in half precision, for CPUs with native
+/// vector FP16 arithmetic: twice the values per vector of float, and no
+/// conversions in and out.
+
+#include <vector>
+
+#include <OpenImageIO/half.h>
+
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/platform.h>
+
+#include "imagebufalgo_half_prv.h"
+#include "imageio_pvt.h"
+
+// On ARM, the FP16 extension is used if the build targets it (as for any
+// Neoverse server CPU). On x86-64, AVX512-FP16 is used if the build
+// targets it, or else compiled separately (with GCC 12 or newer) and used
+// only if the CPU turns out to have it.
+#if defined(__ARM_NEON) && defined(__ARM_FEATURE_FP16_VECTOR_ARITHMETIC) \
+    && !defined(OIIO_NO_NEON)
+#    include <arm_neon.h>
+#    define OIIO_HALF_NEON 1
+#    define OIIO_HALF_TARGET
+#elif defined(__x86_64__) \
+    && (defined(__AVX512FP16__) || OIIO_GNUC_VERSION >= 120000)
+#    include <immintrin.h>
+#    define OIIO_HALF_AVX512 1
+#    ifdef __AVX512FP16__
+#        define OIIO_HALF_TARGET
+#    else
+#        define OIIO_HALF_TARGET \
+            __attribute__((target("avx512f,avx512bw,avx512vl,avx512fp16")))
+#    endif
+#endif
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace pvt {
+
+#if defined(OIIO_HALF_NEON) || defined(OIIO_HALF_AVX512)
+
+namespace {
+
+#    ifdef OIIO_HALF_NEON
+
+using vhalf              = float16x8_t;
+constexpr int vhalf_size = 8;
+
+inline vhalf
+vload(const half* p)
+{
+    return vld1q_f16((const float16_t*)p);
+}
+inline void
+vstore(half* p, vhalf v)
+{
+    vst1q_f16((float16_t*)p, v);
+}
+inline vhalf
+vadd(vhalf a, vhalf b)
+{
+    return vaddq_f16(a, b);
+}
+inline vhalf
+vsub(vhalf a, vhalf b)
+{
+    return vsubq_f16(a, b);
+}
+inline vhalf
+vmul(vhalf a, vhalf b)
+{
+    return vmulq_f16(a, b);
+}
+inline vhalf
+vmadd(vhalf a, vhalf b, vhalf c)
+{
+    return vfmaq_f16(c, a, b);
+}
+inline vhalf
+vclamp(vhalf a, vhalf lo, vhalf hi)
+{
+    return vminq_f16(vmaxq_f16(a, lo), hi);
+}
+
+// Premultiply the vhalf_size RGBA pixels at a into r.
+inline void
+vpremult(half* r, const half* a)
+{
+    float16x8x4_t p = vld4q_f16((const float16_t*)a);
+    p.val[0]        = vmulq_f16(p.val[0], p.val[3]);
+    p.val[1]        = vmulq_f16(p.val[1], p.val[3]);
+    p.val[2]        = vmulq_f16(p.val[2], p.val[3]);
+    vst4q_f16((float16_t*)r, p);
+}
+
+#    else
+
+using vhalf              = __m512h;
+constexpr int vhalf_size = 32;
+
+OIIO_HALF_TARGET inline vhalf
+vload(const half* p)
+{
+    return _mm512_loadu_ph(p);
+}
+OIIO_HALF_TARGET inline void
+vstore(half* p, vhalf v)
+{
+    _mm512_storeu_ph(p, v);
+}
+OIIO_HALF_TARGET inline vhalf
+vadd(vhalf a, vhalf b)
+{
+    return _mm512_add_ph(a, b);
+}
+OIIO_HALF_TARGET inline vhalf
+vsub(vhalf a, vhalf b)
+{
+    return _mm512_sub_ph(a, b);
+}
+OIIO_HALF_TARGET inline vhalf
+vmul(vhalf a, vhalf b)
+{
+    return _mm512_mul_ph(a, b);
+}
+OIIO_HALF_TARGET inline vhalf
+vmadd(vhalf a, vhalf b, vhalf c)
+{
+    return _mm512_fmadd_ph(a, b, c);
+}
+OIIO_HALF_TARGET inline vhalf
+vclamp(vhalf a, vhalf lo, vhalf hi)
+{
+    // In this order, a NaN becomes lo, as with the float SIMD clamp.
+    return _mm512_min_ph(_mm512_max_ph(a, lo), hi);
+}
+
+// Premultiply the vhalf_size / 4 RGBA pixels at a into r: multiply them by
+// their alphas broadcast across each pixel, with 1 in place of alpha.
+OIIO_HALF_TARGET inline void
+vpremult(half* r, const half* a)
+{
+    alignas(64) static const uint16_t alpha_lanes[32]
+        = { 3,  3,  3,  3,  7,  7,  7,  7,  11, 11, 11, 11, 15, 15, 15, 15,
+            19, 19, 19, 19, 23, 23, 23, 23, 27, 27, 27, 27, 31, 31, 31, 31 };
+    const __m512i alpha_index = _mm512_load_si512(alpha_lanes);
+    const vhalf one = _mm512_castsi512_ph(_mm512_set1_epi16(0x3c00));
+    vhalf p         = vload(a);
+    vhalf alpha     = _mm512_permutexvar_ph(alpha_index, p);
+    alpha           = _mm512_mask_blend_ph(__mmask32(0x88888888), alpha, one);
+    vstore(r, _mm512_mul_ph(p, alpha));
+}
+
+#    endif
+
+
+// An operand of half_values: the values of an image, or, if period is
+// nonzero, per-channel values repeated to a length of period, a multiple
+// of vhalf_size.
+struct Operand {
+    const half* p = nullptr;
+    int period    = 0;
+};
+
+
+// Compute op of the n values a[] (and b and c) into r[], a vector at a
+// time, and whatever is left over in float.
+template<HalfOp op>
+OIIO_HALF_TARGET void
+half_values(half* r, const half* a, Operand b, Operand c, int n)
+{
+    int i = 0, kb = 0, kc = 0;
+    for (; i + vhalf_size <= n; i += vhalf_size) {
+        vhalf va = vload(a + i);
+        vhalf vb = vload(b.period ? b.p + kb : b.p + i);
+        vhalf vr;
+        if constexpr (op == HalfOp::Add)
+            vr = vadd(va, vb);
+        else if constexpr (op == HalfOp::Sub)
+            vr = vsub(va, vb);
+        else if constexpr (op == HalfOp::Mul)
+            vr = vmul(va, vb);
+        else {
+            vhalf vc = vload(c.period ? c.p + kc : c.p + i);
+            if constexpr (op == HalfOp::Mad)
+                vr = vmadd(va, vb, vc);
+            else
+                vr = vclamp(va, vb, vc);
+            if (c.period && (kc += vhalf_size) == c.period)
+                kc = 0;
+        }
+        vstore(r + i, vr);
+        if (b.period && (kb += vhalf_size) == b.period)
+            kb = 0;
+    }
+    for (; i < n; ++i) {
+        float x = a[i];
+        float y = b.period ? b.p[i % b.period] : b.p[i];
+        if constexpr (op == HalfOp::Add)
+            r[i] = x + y;
+        else if constexpr (op == HalfOp::Sub)
+            r[i] = x - y;
+        else if constexpr (op == HalfOp::Mul)
+            r[i] = x * y;
+        else {
+            float z = c.period ? c.p[i % c.period] : c.p[i];
+            if constexpr (op == HalfOp::Mad)
+                r[i] = x * y + z;
+            else
+                r[i] = OIIO::clamp(x, y, z);
+        }
+    }
+}
+
+
+OIIO_HALF_TARGET void
+premult_values(half* r, const half* a, int npixels)
+{
+    constexpr int vpixels = vhalf_size / 4;
+    int p                 = 0;
+    for (; p + vpixels <= npixels; p += vpixels)
+        vpremult(r + 4 * p, a + 4 * p);
+    for (; p < npixels; ++p) {
+        float alpha  = a[4 * p + 3];
+        r[4 * p + 0] = float(a[4 * p + 0]) * alpha;
+        r[4 * p + 1] = float(a[4 * p + 1]) * alpha;
+        r[4 * p + 2] = float(a[4 * p + 2]) * alpha;
+        r[4 * p + 3] = a[4 * p + 3];
+    }
+}
+
+
+
+// Compute op of one row of n values.
+OIIO_HALF_TARGET void
+half_row(HalfOp op, half* r, const half* a, Operand b, Operand c, int n)
+{
+    switch (op) {
+    case HalfOp::Add: half_values<HalfOp::Add>(r, a, b, c, n); break;
+    case HalfOp::Sub: half_values<HalfOp::Sub>(r, a, b, c, n); break;
+    case HalfOp::Mul: half_values<HalfOp::Mul>(r, a, b, c, n); break;
+    case HalfOp::Mad: half_values<HalfOp::Mad>(r, a, b, c, n); break;
+    case HalfOp::Clamp: half_values<HalfOp::Clamp>(r, a, b, c, n); break;
+    case HalfOp::Premult: premult_values(r, a, n / 4); break;
+    }
+}
+
+}  // namespace
+
+#endif
+
+
+
+bool
+half_arithmetic_supported()
+{
+#if defined(OIIO_HALF_NEON) || defined(__AVX512FP16__)
+    return true;
+#elif defined(OIIO_HALF_AVX512)
+    static const bool supported = __builtin_cpu_supports("avx512fp16")
+                                  && __builtin_cpu_supports("avx512bw")
+                                  && __builtin_cpu_supports("avx512vl");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+
+
+bool
+half_pixelmath(HalfOp op, ImageBuf& R, const ImageBuf& A, const ImageBuf* B,
+               cspan<float> Bval, const ImageBuf* C, cspan<float> Cval,
+               ROI roi, int nthreads)
+{
+#if defined(OIIO_HALF_NEON) || defined(OIIO_HALF_AVX512)
+    if (!imagebufalgo_fastpaths || !half_arithmetic_supported())
+        return false;
+    const int nc     = A.nchannels();
+    const bool use_b = (op != HalfOp::Premult);
+    const bool use_c = (op == HalfOp::Mad || op == HalfOp::Clamp);
+    auto usable      = [&](const ImageBuf* img) {
+        return img->localpixels() && img->contiguous()
+               && img->spec().format == TypeHalf && img->nchannels() == nc
+               && img->roi().contains(roi);
+    };
+    if (roi.chbegin != 0 || roi.chend != nc || !usable(&R) || !usable(&A)
+        || (use_b && (B ? !usable(B) : int(Bval.size()) < nc))
+        || (use_c && (C ? !usable(C) : int(Cval.size()) < nc))
+        || (op == HalfOp::Premult
+            && (nc != 4 || A.spec().alpha_channel != 3
+                || A.spec().z_channel >= 0)))
+        return false;
+
+    // Per-channel values, repeated as Operand describes. Unless they are
+    // the bounds of a clamp, they must be exact in half.
+    std::vector<half> bconst, cconst;
+    auto constants = [&](cspan<float> vals, std::vector<half>& h) {
+        h.resize(size_t(nc) * vhalf_size);
+        for (size_t i = 0; i < h.size(); ++i) {
+            h[i] = half(vals[i % nc]);
+            if (op != HalfOp::Clamp && float(h[i]) != vals[i % nc])
+                return false;
+        }
+        return true;
+    };
+    if ((use_b && !B && !constants(Bval, bconst))
+        || (use_c && !C && !constants(Cval, cconst)))
+        return false;
+    Operand bop, cop;
+    if (bconst.size())
+        bop = { bconst.data(), int(bconst.size()) };
+    if (cconst.size())
+        cop = { cconst.data(), int(cconst.size()) };
+
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        const int n = roi.width() * nc;
+        for (int z = roi.zbegin; z < roi.zend; ++z) {
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                half* r       = (half*)R.pixeladdr(roi.xbegin, y, z);
+                const half* a = (const half*)A.pixeladdr(roi.xbegin, y, z);
+                Operand b = bop, c = cop;
+                if (use_b && B)
+                    b.p = (const half*)B->pixeladdr(roi.xbegin, y, z);
+                if (use_c && C)
+                    c.p = (const half*)C->pixeladdr(roi.xbegin, y, z);
+                half_row(op, r, a, b, c, n);
+            }
+        }
+    });
+    return true;
+#else
+    return false;
+#endif
+}
+
+}  // namespace pvt
+
+OIIO_NAMESPACE_END
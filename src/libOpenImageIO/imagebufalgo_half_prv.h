@@ -0,0 +1,60 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+/// \file
+/// Private declarations of the ImageBufAlgo pixel math that can be done
+/// directly in half precision, on CPUs with native FP16 arithmetic.
+
+
+#pragma once
+
+#include <OpenImageIO/imagebuf.h>
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace pvt {
+
+/// Per-pixel operations of half_pixelmath().
+enum class HalfOp : int {
+    Add,      ///< R = A + B
+    Sub,      ///< R = A - B
+    Mul,      ///< R = A * B
+    Mad,      ///< R = A * B + C
+    Clamp,    ///< R = min(max(A, B), C)
+    Premult,  ///< R = A with its color multiplied by its alpha
+};
+
+
+/// Does this CPU (as found at run time) have the vector FP16 arithmetic
+/// that half_pixelmath() needs: AVX512-FP16 on x86-64, or the ARMv8.2 FP16
+/// extension on ARM?
+bool
+half_arithmetic_supported();
+
+/// Compute `op` of A, B, and C into R over the region `roi` directly in
+/// half precision, where B and C are each either an image or, if the
+/// image pointer is null, per-channel values. Only C of Mad and Clamp is
+/// used, and neither B nor C of Premult.
+///
+/// The per-channel values of Add, Sub, Mul, and Mad must be exactly
+/// representable as half, so that the result is the same as (or, without
+/// the double rounding, closer than) computing in float and converting
+/// back, and the bounds of Clamp are rounded to half, which doesn't change
+/// the result. Premult is only for RGBA images with alpha in channel 3.
+///
+/// All the images must be local, contiguous half buffers with the same
+/// number of channels, each containing the whole roi with all of its
+/// channels. Return false, having done nothing, if they aren't, or if the
+/// CPU can't, or "imagebufalgo:fastpaths" is 0, and the caller should
+/// compute it itself.
+bool
+half_pixelmath(HalfOp op, ImageBuf& R, const ImageBuf& A, const ImageBuf* B,
+               cspan<float> Bval, const ImageBuf* C, cspan<float> Cval,
+               ROI roi, int nthreads);
+
+}  // namespace pvt
+
+OIIO_NAMESPACE_END
@@ -0,0 +1,594 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+/// \file
+/// Implementation of ImageBufAlgo::LazyImage: recording IBA operations
+/// and evaluating the per-pixel ones together, a strip at a time.
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <OpenImageIO/color.h>
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/imagebufalgo_lazy.h>
+#include <OpenImageIO/imagebufalgo_util.h>
+
+#include "imageio_pvt.h"
+
+
+OIIO_NAMESPACE_BEGIN
+
+using namespace ImageBufAlgo;
+
+
+struct LazyImage::Node {
+    enum Op {
+        Source,
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Over,
+        Clamp,
+        ColorConvert,
+        Apply
+    };
+
+    Op op;
+    std::vector<std::shared_ptr<Node>> inputs;
+    const ImageBuf* source = nullptr;  ///< Source: the image
+    bool has_const         = false;    ///< Add..Div: the operand is `values`
+    std::vector<float> values;         ///< Constant operand, or clamp bounds
+    bool flag = false;                 ///< clampalpha01, or unpremult
+    std::string fromspace, tospace;
+    const ColorConfig* colorconfig = nullptr;
+    std::function<ImageBuf(const ImageBuf&, int)> func;  ///< Apply
+
+    // Worked out by prepare(), and forgotten after each evaluation.
+    bool prepared = false;
+    ROI roi;  ///< Data window, and channels 0..nchannels
+    TypeDesc format;
+    int alpha_channel = -1;
+    std::vector<std::string> channelnames;
+    ColorProcessorHandle processor;
+    ImageBuf result;  ///< Apply: the computed image
+
+    explicit Node(Op op)
+        : op(op)
+    {
+    }
+
+    int nchannels() const { return roi.chend; }
+
+    // The whole image this node reads as, if it has one.
+    const ImageBuf* image() const
+    {
+        return op == Source ? source : op == Apply ? &result : nullptr;
+    }
+
+    void reset()
+    {
+        prepared = false;
+        processor.reset();
+        result.reset();
+    }
+};
+
+
+
+namespace {  // anonymous
+
+using Node    = LazyImage::Node;
+using NodeRef = std::shared_ptr<LazyImage::Node>;
+
+// Each thread evaluates strips of about this many pixels, which keeps the
+// few buffers a typical expression needs within the L2 cache.
+static const imagesize_t strip_pixels = 4096;
+
+
+
+LazyImage
+make_binary(Node::Op op, const LazyImage& A, const LazyImage& B)
+{
+    if (!A.initialized() || !B.initialized())
+        return {};
+    NodeRef n = std::make_shared<Node>(op);
+    n->inputs = { A.node(), B.node() };
+    return LazyImage(n);
+}
+
+
+
+LazyImage
+make_binary(Node::Op op, const LazyImage& A, cspan<float> B)
+{
+    if (!A.initialized())
+        return {};
+    NodeRef n    = std::make_shared<Node>(op);
+    n->inputs    = { A.node() };
+    n->has_const = true;
+    n->values.assign(B.begin(), B.end());
+    return LazyImage(n);
+}
+
+
+
+// Constant operands shorter than the image extend their last value.
+inline float
+chanval(const std::vector<float>& values, int c, float dflt = 0.0f)
+{
+    return values.empty() ? dflt
+                          : values[std::min(size_t(c), values.size() - 1)];
+}
+
+
+
+bool
+evaluate_node(ImageBuf& dst, const Node& node, ROI roi, int nthreads,
+              std::string& err);
+
+
+
+// Work out the window, channels, and type of `node` and everything it
+// depends on, creating color processors and computing the results of
+// operations that can't be done a strip at a time. Every node prepared is
+// added to `prepared`, so that it can be reset afterwards.
+bool
+prepare(Node& node, int nthreads, std::string& err,
+        std::vector<Node*>& prepared)
+{
+    if (node.prepared)
+        return true;
+    for (auto& in : node.inputs)
+        if (!prepare(*in, nthreads, err, prepared))
+            return false;
+    prepared.push_back(&node);
+    node.prepared = true;
+
+    const ImageSpec* spec = nullptr;
+    if (node.op == Node::Source) {
+        if (!node.source->initialized()) {
+            err = "lazy::evaluate: uninitialized source image";
+            return false;
+        }
+        spec = &node.source->spec();
+    } else if (node.op == Node::Apply) {
+        const Node& in(*node.inputs[0]);
+        const ImageBuf* src = in.image();
+        ImageBuf tmp;
+        if (!src) {
+            if (!evaluate_node(tmp, in, {}, nthreads, err))
+                return false;
+            src = &tmp;
+        }
+        node.result = node.func(*src, nthreads);
+        if (node.result.has_error()) {
+            err = node.result.geterror();
+            return false;
+        }
+        if (!node.result.initialized()) {
+            err = "lazy::evaluate: operation returned no image";
+            return false;
+        }
+        spec = &node.result.spec();
+    }
+    if (spec) {
+        if (spec->deep) {
+            err = "lazy::evaluate: deep images are not supported";
+            return false;
+        }
+        node.roi           = get_roi(*spec);
+        node.format        = spec->format;
+        node.alpha_channel = spec->alpha_channel;
+        node.channelnames  = spec->channelnames;
+        return true;
+    }
+
+    // Otherwise, the result is like the input (the bigger of two).
+    const Node& A(*node.inputs[0]);
+    const Node* like = &A;
+    node.roi         = A.roi;
+    node.format      = A.format;
+    if (node.inputs.size() > 1) {
+        const Node& B(*node.inputs[1]);
+        node.roi    = roi_union(A.roi, B.roi);
+        node.format = TypeDesc::basetype_merge(A.format, B.format);
+        if (B.nchannels() > A.nchannels())
+            like = &B;
+    }
+    node.alpha_channel = like->alpha_channel;
+    node.channelnames  = like->channelnames;
+
+    if (node.op == Node::Over && A.alpha_channel < 0) {
+        err = "over: the foreground image has no alpha channel";
+        return false;
+    }
+    if (node.op == Node::Over)
+        node.alpha_channel = A.alpha_channel;
+    if (node.op == Node::ColorConvert) {
+        const ColorConfig& config(node.colorconfig
+                                      ? *node.colorconfig
+                                      : ColorConfig::default_colorconfig());
+        node.processor = config.createColorProcessor(node.fromspace,
+                                                     node.tospace);
+        if (!node.processor) {
+            err = Strutil::fmt::format(
+                "colorconvert: could not convert from \"{}\" to \"{}\"",
+                node.fromspace, node.tospace);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+// Compute `node` over the pixels of `strip` (whose channel range is
+// ignored) into `out`, which has `nc` floats per pixel, at least the
+// node's number of channels. Channels the node doesn't have are zero.
+void
+eval_strip(const Node& node, const ROI& strip, int nc, float* out)
+{
+    const size_t npixels = size_t(strip.npixels());
+    const int nchans     = node.nchannels();
+    if (nc != nchans) {
+        // Compute it as is, then spread it out.
+        std::unique_ptr<float[]> tmp(new float[npixels * nchans]);
+        eval_strip(node, strip, nchans, tmp.get());
+        for (size_t p = 0; p < npixels; ++p) {
+            std::copy_n(tmp.get() + p * nchans, nchans, out + p * nc);
+            std::fill_n(out + p * nc + nchans, nc - nchans, 0.0f);
+        }
+        return;
+    }
+
+    switch (node.op) {
+    case Node::Source:
+    case Node::Apply: {
+        // Pixels outside the data window read as zero.
+        ROI r(strip.xbegin, strip.xend, strip.ybegin, strip.yend, strip.zbegin,
+              strip.zend, 0, nc);
+        node.image()->get_pixels(r, span<float>(out, npixels * nc));
+        break;
+    }
+    case Node::Add:
+    case Node::Sub:
+    case Node::Mul:
+    case Node::Div: {
+        eval_strip(*node.inputs[0], strip, nc, out);
+        std::unique_ptr<float[]> tmp;
+        const float* b = nullptr;
+        if (node.has_const) {
+            tmp.reset(new float[nc]);
+            for (int c = 0; c < nc; ++c)
+                tmp[c] = chanval(node.values, c);
+        } else {
+            tmp.reset(new float[npixels * nc]);
+            eval_strip(*node.inputs[1], strip, nc, tmp.get());
+        }
+        b = tmp.get();
+        const size_t bstep = node.has_const ? 0 : nc;
+        for (size_t p = 0; p < npixels; ++p, out += nc, b += bstep) {
+            switch (node.op) {
+            case Node::Add:
+                for (int c = 0; c < nc; ++c)
+                    out[c] += b[c];
+                break;
+            case Node::Sub:
+                for (int c = 0; c < nc; ++c)
+                    out[c] -= b[c];
+                break;
+            case Node::Mul:
+                for (int c = 0; c < nc; ++c)
+                    out[c] *= b[c];
+                break;
+            default:
+                for (int c = 0; c < nc; ++c)
+                    out[c] = b[c] == 0.0f ? 0.0f : out[c] / b[c];
+                break;
+            }
+        }
+        break;
+    }
+    case Node::Over: {
+        eval_strip(*node.inputs[0], strip, nc, out);
+        std::unique_ptr<float[]> tmp(new float[npixels * nc]);
+        eval_strip(*node.inputs[1], strip, nc, tmp.get());
+        const int alpha = node.inputs[0]->alpha_channel;
+        const float* b  = tmp.get();
+        for (size_t p = 0; p < npixels; ++p, out += nc, b += nc) {
+            float one_minus_alpha = 1.0f - OIIO::clamp(out[alpha], 0.0f, 1.0f);
+            for (int c = 0; c < nc; ++c)
+                out[c] += one_minus_alpha * b[c];
+        }
+        break;
+    }
+    case Node::Clamp: {
+        eval_strip(*node.inputs[0], strip, nc, out);
+        const float big = std::numeric_limits<float>::max();
+        const int n     = int(node.values.size() / 2);
+        std::vector<float> lo(nc), hi(nc);
+        for (int c = 0; c < nc; ++c) {
+            lo[c] = n ? node.values[std::min(c, n - 1)] : -big;
+            hi[c] = n ? node.values[n + std::min(c, n - 1)] : big;
+        }
+        const int alpha = node.flag ? node.alpha_channel : -1;
+        for (size_t p = 0; p < npixels; ++p, out += nc) {
+            for (int c = 0; c < nc; ++c)
+                out[c] = OIIO::clamp(out[c], lo[c], hi[c]);
+            if (alpha >= 0)
+                out[alpha] = OIIO::clamp(out[alpha], 0.0f, 1.0f);
+        }
+        break;
+    }
+    case Node::ColorConvert: {
+        eval_strip(*node.inputs[0], strip, nc, out);
+        // Like IBA::colorconvert, transform up to the first 4 channels as
+        // RGBA, treating one channel as gray.
+        const int ncolor    = std::min(4, nc);
+        const bool unpremul = node.flag && ncolor == 4;
+        const float fltmin  = std::numeric_limits<float>::min();
+        std::unique_ptr<float[]> rgba(new float[npixels * 4]);
+        for (size_t p = 0; p < npixels; ++p) {
+            float* v = rgba.get() + 4 * p;
+            v[0] = v[1] = v[2] = v[3] = 0.0f;
+            std::copy_n(out + p * nc, ncolor, v);
+            if (ncolor == 1)
+                v[2] = v[1] = v[0];
+            if (unpremul && v[3] >= fltmin && v[3] != 1.0f)
+                for (int c = 0; c < 3; ++c)
+                    v[c] /= v[3];
+        }
+        node.processor->apply(rgba.get(), int(npixels), 1, 4, sizeof(float),
+                              4 * sizeof(float), npixels * 4 * sizeof(float));
+        for (size_t p = 0; p < npixels; ++p) {
+            float* v = rgba.get() + 4 * p;
+            if (unpremul && v[3] >= fltmin && v[3] != 1.0f)
+                for (int c = 0; c < 3; ++c)
+                    v[c] *= v[3];
+            std::copy_n(v, ncolor, out + p * nc);
+        }
+        break;
+    }
+    }
+}
+
+
+
+// Evaluate a prepared node into dst over roi, allocating dst if needed.
+bool
+evaluate_node(ImageBuf& dst, const Node& node, ROI roi, int nthreads,
+              std::string& err)
+{
+    const int nc = node.nchannels();
+    if (!roi.defined())
+        roi = node.roi;
+    roi.chend = std::min(roi.chend, nc);
+    if (roi.chbegin >= roi.chend || roi.npixels() == 0)
+        return true;
+    if (!dst.initialized()) {
+        ImageSpec spec(roi, node.format);
+        if (roi.chbegin == 0 && roi.chend == nc) {
+            spec.channelnames  = node.channelnames;
+            spec.alpha_channel = node.alpha_channel;
+        }
+        dst.reset(spec);
+    }
+    if (dst.nchannels() < roi.chend) {
+        err = "lazy::evaluate: destination has too few channels";
+        return false;
+    }
+
+    std::atomic<bool> ok(true);
+    parallel_image(roi, paropt(nthreads), [&](ROI chunk) {
+        const int width = chunk.width();
+        const int rows  = OIIO::clamp(int(strip_pixels / std::max(1, width)),
+                                      1, chunk.height());
+        const size_t n  = size_t(width) * rows * nc;
+        std::unique_ptr<float[]> buf(new float[n]);
+        for (int z = chunk.zbegin; z < chunk.zend; ++z) {
+            for (int y = chunk.ybegin; y < chunk.yend; y += rows) {
+                ROI strip(chunk.xbegin, chunk.xend, y,
+                          std::min(y + rows, chunk.yend), z, z + 1,
+                          chunk.chbegin, chunk.chend);
+                eval_strip(node, strip, nc, buf.get());
+                // Store only the requested channels.
+                if (!dst.set_pixels(strip,
+                                    cspan<float>(buf.get() + strip.chbegin,
+                                                 n - strip.chbegin),
+                                    nc * sizeof(float)))
+                    ok = false;
+            }
+        }
+    });
+    if (!ok)
+        err = dst.has_error() ? dst.geterror() : "lazy::evaluate failed";
+    return ok;
+}
+
+}  // namespace
+
+
+
+LazyImage::LazyImage(const ImageBuf& img)
+    : m_node(std::make_shared<Node>(Node::Source))
+{
+    m_node->source = &img;
+}
+
+
+
+LazyImage
+lazy::add(const LazyImage& A, const LazyImage& B)
+{
+    return make_binary(Node::Add, A, B);
+}
+
+
+LazyImage
+lazy::add(const LazyImage& A, cspan<float> B)
+{
+    return make_binary(Node::Add, A, B);
+}
+
+
+LazyImage
+lazy::sub(const LazyImage& A, const LazyImage& B)
+{
+    return make_binary(Node::Sub, A, B);
+}
+
+
+LazyImage
+lazy::sub(const LazyImage& A, cspan<float> B)
+{
+    return make_binary(Node::Sub, A, B);
+}
+
+
+LazyImage
+lazy::mul(const LazyImage& A, const LazyImage& B)
+{
+    return make_binary(Node::Mul, A, B);
+}
+
+
+LazyImage
+lazy::mul(const LazyImage& A, cspan<float> B)
+{
+    return make_binary(Node::Mul, A, B);
+}
+
+
+LazyImage
+lazy::div(const LazyImage& A, const LazyImage& B)
+{
+    return make_binary(Node::Div, A, B);
+}
+
+
+LazyImage
+lazy::div(const LazyImage& A, cspan<float> B)
+{
+    return make_binary(Node::Div, A, B);
+}
+
+
+LazyImage
+lazy::over(const LazyImage& A, const LazyImage& B)
+{
+    return make_binary(Node::Over, A, B);
+}
+
+
+
+LazyImage
+lazy::clamp(const LazyImage& src, cspan<float> min, cspan<float> max,
+            bool clampalpha01)
+{
+    if (!src.initialized())
+        return {};
+    const float big = std::numeric_limits<float>::max();
+    NodeRef node    = std::make_shared<Node>(Node::Clamp);
+    node->inputs    = { src.node() };
+    node->flag      = clampalpha01;
+    // Store the bounds as two runs of the same length.
+    size_t n = std::max(min.size(), max.size());
+    for (size_t c = 0; c < n; ++c)
+        node->values.push_back(min.size() ? min[std::min(c, min.size() - 1)]
+                                          : -big);
+    for (size_t c = 0; c < n; ++c)
+        node->values.push_back(max.size() ? max[std::min(c, max.size() - 1)]
+                                          : big);
+    return LazyImage(node);
+}
+
+
+
+LazyImage
+lazy::colorconvert(const LazyImage& src, string_view fromspace,
+                   string_view tospace, bool unpremult,
+                   const ColorConfig* colorconfig)
+{
+    if (!src.initialized())
+        return {};
+    NodeRef node      = std::make_shared<Node>(Node::ColorConvert);
+    node->inputs      = { src.node() };
+    node->fromspace   = fromspace;
+    node->tospace     = tospace;
+    node->flag        = unpremult;
+    node->colorconfig = colorconfig;
+    return LazyImage(node);
+}
+
+
+
+LazyImage
+lazy::resize(const LazyImage& src, KWArgs options, ROI roi)
+{
+    // The options are only a view, so keep a copy.
+    ParamValueList opts;
+    for (const ParamValue& p : options)
+        opts.push_back(p);
+    return apply(src, [opts, roi](const ImageBuf& img, int nthreads) {
+        return ImageBufAlgo::resize(img, opts, roi, nthreads);
+    });
+}
+
+
+
+LazyImage
+lazy::apply(const LazyImage& src,
+            std::function<ImageBuf(const ImageBuf& src, int nthreads)> func)
+{
+    if (!src.initialized() || !func)
+        return {};
+    NodeRef node = std::make_shared<Node>(Node::Apply);
+    node->inputs = { src.node() };
+    node->func   = std::move(func);
+    return LazyImage(node);
+}
+
+
+
+bool
+lazy::evaluate(ImageBuf& dst, const LazyImage& expr, ROI roi, int nthreads)
+{
+    pvt::LoggedTimer logtime("IBA::lazy::evaluate");
+    if (!expr.initialized()) {
+        dst.errorfmt("lazy::evaluate: uninitialized expression");
+        return false;
+    }
+    std::string err;
+    std::vector<Node*> prepared;
+    bool ok = prepare(*expr.node(), nthreads, err, prepared)
+              && evaluate_node(dst, *expr.node(), roi, nthreads, err);
+    // Nothing is kept from one evaluation to the next, since the source
+    // images may have changed in between.
+    for (Node* n : prepared)
+        n->reset();
+    if (!ok)
+        dst.errorfmt("{}", err);
+    return ok;
+}
+
+
+
+ImageBuf
+lazy::evaluate(const LazyImage& expr, ROI roi, int nthreads)
+{
+    ImageBuf result;
+    bool ok = evaluate(result, expr, roi, nthreads);
+    if (!ok && !result.has_error())
+        result.errorfmt("ImageBufAlgo::lazy::evaluate error");
+    return result;
+}
+
+
+OIIO_NAMESPACE_END
@@ -0,0 +1,480 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+/// \file
+/// Application of 1D and 3D color LUTs to images, four pixels at a time:
+/// each LUT channel is its own plane of floats, so the entries for four
+/// pixels are gathered into one vfloat4 rather than looked up one by one.
+
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/fmath.h>
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/simd.h>
+#include <OpenImageIO/strutil.h>
+
+#include "imagebufalgo_lut_prv.h"
+#include "imageio_pvt.h"
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace pvt {
+
+namespace {
+
+using namespace simd;
+
+
+// Look up positions t (in units of entries, clamped to [0,n-1]) in the n
+// entries of one channel of a 1D LUT, interpolating linearly. This is
+// the same arithmetic as interpolate_linear(), so color_map() gives the
+// same results it always has.
+inline vfloat4
+lookup1d(const float* plane, int n, vfloat4 t)
+{
+    t = min(max(t, vfloat4::Zero()), vfloat4(float(n - 1)));
+    vfloat4 f = floor(t);
+    vint4 i(f);
+    vint4 j = min(i + vint4(1), vint4(n - 1));
+    vfloat4 a, b;
+    a.gather(plane, i);
+    b.gather(plane, j);
+    return lerp(a, b, t - f);
+}
+
+
+
+// Look up positions t[0..2] (in units of entries, clamped to [0,n-1] on
+// each axis) in the n^3 entries of the 3D LUT, interpolating
+// tetrahedrally: of the six tetrahedra of a cell, each lane uses the
+// one containing its position, whose corners are c000, the neighbor
+// along the axis with the largest fraction, the neighbor of that across
+// all but the axis with the smallest fraction, and c111.
+inline void
+lookup3d(const float* lut, int n, const vfloat4 t[3], vfloat4 out[3])
+{
+    const vfloat4 last(float(n - 1));
+    vint4 idx[3];
+    vfloat4 frac[3];
+    for (int c = 0; c < 3; ++c) {
+        vfloat4 tc = min(max(t[c], vfloat4::Zero()), last);
+        idx[c]     = min(vint4(floor(tc)), vint4(n - 2));
+        frac[c]    = tc - vfloat4(idx[c]);
+    }
+    const int sg = n, sb = n * n, s111 = 1 + sg + sb;
+    const vfloat4 &fr(frac[0]), &fg(frac[1]), &fb(frac[2]);
+    vint4 base = idx[0] + idx[1] * vint4(sg) + idx[2] * vint4(sb);
+
+    // Ties may go either way, as long as the largest and smallest axes
+    // are different ones.
+    vbool4 rmax = (fr >= fg) & (fr >= fb);
+    vbool4 gmax = (fg >= fb) & !rmax;
+    vbool4 bmin = (fb <= fr) & (fb <= fg);
+    vbool4 gmin = (fg <= fr) & !bmin;
+    vint4 offA  = select(rmax, vint4(1), select(gmax, vint4(sg), vint4(sb)));
+    vint4 offB  = vint4(s111)
+                 - select(bmin, vint4(sb), select(gmin, vint4(sg), vint4(1)));
+    vfloat4 w1 = max(max(fr, fg), fb);
+    vfloat4 w2 = max(min(fr, fg), min(max(fr, fg), fb));
+    vfloat4 w3 = min(min(fr, fg), fb);
+
+    vint4 iA = base + offA, iB = base + offB, i111 = base + vint4(s111);
+    const size_t n3 = size_t(n) * n * n;
+    for (int c = 0; c < 3; ++c) {
+        const float* plane = lut + c * n3;
+        vfloat4 c000, cA, cB, c111;
+        c000.gather(plane, base);
+        cA.gather(plane, iA);
+        cB.gather(plane, iB);
+        c111.gather(plane, i111);
+        out[c] = c000 + w1 * (cA - c000) + w2 * (cB - cA) + w3 * (c111 - cB);
+    }
+}
+
+
+
+// Transform rgb (of four pixels) by the LUT, or only by its 1D part.
+inline void
+apply_lut(const ColorLUT& lut, vfloat4 rgb[3], bool only1d = false)
+{
+    if (lut.size1d) {
+        const float n = float(lut.size1d - 1);
+        for (int c = 0; c < 3; ++c) {
+            float scale = n / (lut.domain1d_max[c] - lut.domain1d_min[c]);
+            rgb[c] = lookup1d(lut.lut1d.data() + c * lut.size1d, lut.size1d,
+                              (rgb[c] - vfloat4(lut.domain1d_min[c]))
+                                  * vfloat4(scale));
+        }
+    }
+    if (lut.size3d && !only1d) {
+        const float n = float(lut.size3d - 1);
+        vfloat4 t[3];
+        for (int c = 0; c < 3; ++c) {
+            float scale = n / (lut.domain3d_max[c] - lut.domain3d_min[c]);
+            t[c] = (rgb[c] - vfloat4(lut.domain3d_min[c])) * vfloat4(scale);
+        }
+        lookup3d(lut.lut3d.data(), lut.size3d, t, rgb);
+    }
+}
+
+
+
+// Load channel c of four pixels of nc channels.
+inline vfloat4
+load4(const float* p, int nc, int c)
+{
+    return vfloat4(p[c], p[nc + c], p[2 * nc + c], p[3 * nc + c]);
+}
+
+
+
+inline void
+store4(float* p, int nc, int c, const vfloat4& v)
+{
+    p[c]          = v[0];
+    p[nc + c]     = v[1];
+    p[2 * nc + c] = v[2];
+    p[3 * nc + c] = v[3];
+}
+
+
+
+// The uint8 or uint16 source value of channel c of four pixels (as
+// they were converted to float, exactly).
+inline vint4
+code4(const float* p, int nc, int c, float maxcode)
+{
+    return vint4(load4(p, nc, c) * vfloat4(maxcode) + vfloat4(0.5f));
+}
+
+
+
+// How many of the values of an integer type a source has, if it's worth
+// tabulating the results for all of them for an image of npixels, else 0.
+int
+table_codes(TypeDesc format, imagesize_t npixels)
+{
+    if (!imagebufalgo_fastpaths)
+        return 0;
+    if (format == TypeUInt8 && npixels >= 1024)
+        return 256;
+    if (format == TypeUInt16 && npixels >= 65536)
+        return 65536;
+    return 0;
+}
+
+
+
+// Each of the ncodes values of an integer type, converted to float just
+// as get_pixels() converts them.
+std::vector<float>
+code_values(TypeDesc format, int ncodes)
+{
+    std::vector<uint16_t> codes(ncodes);
+    std::vector<uint8_t> codes8(format == TypeUInt8 ? ncodes : 0);
+    for (int i = 0; i < ncodes; ++i) {
+        codes[i] = uint16_t(i);
+        if (codes8.size())
+            codes8[i] = uint8_t(i);
+    }
+    std::vector<float> values(ncodes);
+    if (ncodes)
+        convert_pixel_values(format,
+                             codes8.size() ? (const void*)codes8.data()
+                                           : (const void*)codes.data(),
+                             TypeFloat, values.data(), ncodes);
+    return values;
+}
+
+}  // namespace
+
+
+
+bool
+ColorLUT::read_cube(const std::string& filename, std::string& err)
+{
+    std::string text;
+    if (!Filesystem::read_text_file(filename, text)) {
+        err = Strutil::fmt::format("Could not read \"{}\"", filename);
+        return false;
+    }
+    *this = ColorLUT();
+    bool domain = false;
+    float dmin[3] = { 0.0f, 0.0f, 0.0f }, dmax[3] = { 1.0f, 1.0f, 1.0f };
+    size_t n1 = 0, n3 = 0, entries = 0;
+    for (string_view line : Strutil::splitsv(text, "\n")) {
+        line = Strutil::strip(Strutil::parse_until(line, "#"));
+        if (line.empty())
+            continue;
+        if (isalpha((unsigned char)line[0])) {
+            string_view keyword = Strutil::parse_until(line, " \t");
+            float lo = 0.0f, hi = 1.0f;
+            bool ok  = true;
+            if (keyword == "TITLE") {
+                continue;
+            } else if (keyword == "LUT_1D_SIZE") {
+                ok = entries == 0 && Strutil::parse_int(line, size1d)
+                     && size1d >= 2 && size1d <= 65536;
+                n1 = size_t(size1d);
+            } else if (keyword == "LUT_3D_SIZE") {
+                ok = entries == 0 && Strutil::parse_int(line, size3d)
+                     && size3d >= 2 && size3d <= 256;
+                n3 = size_t(size3d) * size3d * size3d;
+            } else if (keyword == "DOMAIN_MIN" || keyword == "DOMAIN_MAX") {
+                float* d = keyword == "DOMAIN_MIN" ? dmin : dmax;
+                ok       = Strutil::parse_float(line, d[0])
+                     && Strutil::parse_float(line, d[1])
+                     && Strutil::parse_float(line, d[2]);
+                domain = true;
+            } else if (keyword == "LUT_1D_INPUT_RANGE"
+                       || keyword == "LUT_3D_INPUT_RANGE") {
+                ok = Strutil::parse_float(line, lo)
+                     && Strutil::parse_float(line, hi);
+                float* m = keyword[4] == '1' ? domain1d_min : domain3d_min;
+                float* M = keyword[4] == '1' ? domain1d_max : domain3d_max;
+                std::fill(m, m + 3, lo);
+                std::fill(M, M + 3, hi);
+            } else {
+                ok = false;
+            }
+            if (!ok) {
+                err = Strutil::fmt::format("Unsupported or malformed {} in "
+                                           "\"{}\"",
+                                           keyword, filename);
+                return false;
+            }
+            continue;
+        }
+        if (entries == 0) {
+            lut1d.resize(3 * n1);
+            lut3d.resize(3 * n3);
+        }
+        float rgb[3];
+        if (!Strutil::parse_float(line, rgb[0])
+            || !Strutil::parse_float(line, rgb[1])
+            || !Strutil::parse_float(line, rgb[2]) || entries >= n1 + n3) {
+            err = Strutil::fmt::format("Malformed LUT data in \"{}\"",
+                                       filename);
+            return false;
+        }
+        for (int c = 0; c < 3; ++c) {
+            if (entries < n1)
+                lut1d[c * n1 + entries] = rgb[c];
+            else
+                lut3d[c * n3 + entries - n1] = rgb[c];
+        }
+        ++entries;
+    }
+    if (entries != n1 + n3 || entries == 0) {
+        err = Strutil::fmt::format("Incomplete LUT in \"{}\"", filename);
+        return false;
+    }
+    for (int c = 0; c < 3; ++c) {
+        if (domain) {
+            domain1d_min[c] = domain3d_min[c] = dmin[c];
+            domain1d_max[c] = domain3d_max[c] = dmax[c];
+        }
+        if (!(domain1d_max[c] > domain1d_min[c])
+            || !(domain3d_max[c] > domain3d_min[c])) {
+            err = Strutil::fmt::format("Invalid LUT domain in \"{}\"",
+                                       filename);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+std::shared_ptr<const ColorLUT>
+ColorLUT::cube(const std::string& filename, std::string& err)
+{
+    struct Entry {
+        std::time_t mtime;
+        std::shared_ptr<const ColorLUT> lut;
+    };
+    static std::mutex mutex;
+    static std::map<std::string, Entry> luts;
+
+    std::time_t mtime = Filesystem::last_write_time(filename);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = luts.find(filename);
+        if (found != luts.end() && found->second.mtime == mtime)
+            return found->second.lut;
+    }
+    auto lut = std::make_shared<ColorLUT>();
+    if (!lut->read_cube(filename, err))
+        return nullptr;
+    std::lock_guard<std::mutex> lock(mutex);
+    luts[filename] = Entry { mtime, lut };
+    return lut;
+}
+
+
+
+bool
+apply_color_lut(ImageBuf& dst, const ImageBuf& src, const ColorLUT& lut,
+                bool unpremult, ROI roi, int nthreads)
+{
+    if (!ImageBufAlgo::IBAprep(roi, &dst, &src))
+        return false;
+    if (roi.nchannels() < 3) {
+        dst.errorfmt("A color LUT needs 3 channels");
+        return false;
+    }
+    if (roi.nchannels() < 4
+        || src.spec().get_int_attribute("oiio:UnassociatedAlpha") != 0)
+        unpremult = false;
+
+    // Without unpremultiplication, the uint8 or uint16 value of each
+    // channel can index a table of its result through the 1D LUT, or its
+    // position in the 3D LUT.
+    const TypeDesc format = src.spec().format;
+    const int ncodes      = unpremult ? 0 : table_codes(format, roi.npixels());
+    const float maxcode   = float(ncodes - 1);
+    std::vector<float> table(3 * size_t(ncodes));
+    std::vector<float> values = code_values(format, ncodes);
+    for (int i = 0; i < ncodes; i += 4) {
+        vfloat4 v(&values[i]);
+        vfloat4 rgb[3] = { v, v, v };
+        if (lut.size1d)
+            apply_lut(lut, rgb, true);
+        for (int c = 0; c < 3; ++c) {
+            if (lut.size3d)
+                rgb[c] = (rgb[c] - vfloat4(lut.domain3d_min[c]))
+                         * vfloat4(float(lut.size3d - 1)
+                                   / (lut.domain3d_max[c]
+                                      - lut.domain3d_min[c]));
+            rgb[c].store(&table[c * ncodes + i]);
+        }
+    }
+
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        const int nc = roi.nchannels(), width = roi.width();
+        const float fltmin = std::numeric_limits<float>::min();
+        std::vector<float> buf(size_t(round_to_multiple(width, 4)) * nc);
+        for (int z = roi.zbegin; z < roi.zend; ++z) {
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                ROI row(roi.xbegin, roi.xend, y, y + 1, z, z + 1,
+                        roi.chbegin, roi.chend);
+                src.get_pixels(row, TypeFloat, buf.data());
+                for (int x = 0; x < width; x += 4) {
+                    float* p = buf.data() + size_t(x) * nc;
+                    vfloat4 rgb[3];
+                    if (ncodes) {
+                        for (int c = 0; c < 3; ++c)
+                            rgb[c].gather(&table[c * ncodes],
+                                          code4(p, nc, c, maxcode));
+                        if (lut.size3d)
+                            lookup3d(lut.lut3d.data(), lut.size3d, rgb, rgb);
+                    } else {
+                        vfloat4 alpha(1.0f);
+                        if (unpremult) {
+                            alpha = load4(p, nc, 3);
+                            alpha = select(alpha >= vfloat4(fltmin), alpha,
+                                           vfloat4(1.0f));
+                        }
+                        for (int c = 0; c < 3; ++c)
+                            rgb[c] = load4(p, nc, c) / alpha;
+                        apply_lut(lut, rgb);
+                        for (int c = 0; c < 3; ++c)
+                            rgb[c] *= alpha;
+                    }
+                    for (int c = 0; c < 3; ++c)
+                        store4(p, nc, c, rgb[c]);
+                }
+                dst.set_pixels(row, TypeFloat, buf.data());
+            }
+        }
+    });
+    return true;
+}
+
+
+
+bool
+color_map_lut(ImageBuf& dst, const ImageBuf& src, int srcchannel, int nknots,
+              int channels, cspan<float> knots, ROI roi, int nthreads)
+{
+    if (srcchannel < 0 && src.nchannels() < 3)
+        srcchannel = 0;
+    const int nc = roi.nchannels();
+    std::vector<float> planes(size_t(nc) * nknots);
+    for (int c = 0; c < nc; ++c)
+        for (int k = 0; k < nknots; ++k)
+            planes[c * nknots + k] = knots[k * channels + c];
+
+    // A uint8 or uint16 channel's values index a table of their results.
+    const int ncodes = srcchannel < 0
+                           ? 0
+                           : table_codes(src.spec().format, roi.npixels());
+    const float maxcode = float(ncodes - 1);
+    const vfloat4 scale(float(nknots - 1));
+    std::vector<float> table(size_t(nc) * ncodes);
+    std::vector<float> values = code_values(src.spec().format, ncodes);
+    for (int i = 0; i < ncodes; i += 4) {
+        vfloat4 t = vfloat4(&values[i]) * scale;
+        for (int c = 0; c < nc; ++c)
+            lookup1d(&planes[c * nknots], nknots, t)
+                .store(&table[c * ncodes + i]);
+    }
+
+    const int keych = srcchannel < 0 ? 3 : 1;
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        const int width  = roi.width();
+        const size_t len = round_to_multiple(width, 4);
+        std::vector<float> key(len * keych), out(len * nc);
+        for (int z = roi.zbegin; z < roi.zend; ++z) {
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                int ch0 = std::max(0, srcchannel);
+                src.get_pixels(ROI(roi.xbegin, roi.xend, y, y + 1, z, z + 1,
+                                   ch0, ch0 + keych),
+                               TypeFloat, key.data());
+                for (int x = 0; x < width; x += 4) {
+                    const float* k = key.data() + size_t(x) * keych;
+                    float* p       = out.data() + size_t(x) * nc;
+                    if (ncodes) {
+                        vint4 code = code4(k, 1, 0, maxcode);
+                        for (int c = 0; c < nc; ++c) {
+                            vfloat4 v;
+                            v.gather(&table[c * ncodes], code);
+                            store4(p, nc, c, v);
+                        }
+                        continue;
+                    }
+                    vfloat4 t = keych == 1
+                                    ? load4(k, 1, 0)
+                                    : vfloat4(0.2126f) * load4(k, 3, 0)
+                                          + vfloat4(0.7152f) * load4(k, 3, 1)
+                                          + vfloat4(0.0722f) * load4(k, 3, 2);
+                    t = min(max(t, vfloat4::Zero()), vfloat4::One()) * scale;
+                    for (int c = 0; c < nc; ++c)
+                        store4(p, nc, c,
+                               lookup1d(&planes[c * nknots], nknots, t));
+                }
+                dst.set_pixels(ROI(roi.xbegin, roi.xend, y, y + 1, z, z + 1,
+                                   roi.chbegin, roi.chend),
+                               TypeFloat, out.data());
+            }
+        }
+    });
+    return true;
+}
+
+}  // namespace pvt
+
+OIIO_NAMESPACE_END
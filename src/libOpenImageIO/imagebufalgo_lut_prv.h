@@ -0,0 +1,80 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+/// \file
+/// Private declarations of the engine that applies 1D and 3D color LUTs
+/// to images, shared by color_map() and by ociofiletransform() of LUT
+/// files.
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <OpenImageIO/imagebuf.h>
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace pvt {
+
+/// A color LUT: an optional 1D LUT (a "shaper"), applied first, then an
+/// optional 3D LUT. Both are stored as separate planes of floats for each
+/// output channel, so that the values for several pixels can be gathered
+/// into one SIMD register.
+struct ColorLUT {
+    /// Entries of the 1D LUT, or 0 if there is none.
+    int size1d = 0;
+    /// Channels of the 1D LUT, each of which looks up its own input
+    /// channel -- except in color_map_lut(), where they all look up the
+    /// same one.
+    int channels1d = 3;
+    /// Entries along each axis of the 3D LUT, or 0 if there is none.
+    int size3d = 0;
+    /// Input values mapping to the first and last entries of each LUT.
+    float domain1d_min[3] = { 0.0f, 0.0f, 0.0f };
+    float domain1d_max[3] = { 1.0f, 1.0f, 1.0f };
+    float domain3d_min[3] = { 0.0f, 0.0f, 0.0f };
+    float domain3d_max[3] = { 1.0f, 1.0f, 1.0f };
+    /// Entry i of channel c of the 1D LUT is `lut1d[c * size1d + i]`.
+    std::vector<float> lut1d;
+    /// Entry (r, g, b) of channel c of the 3D LUT is
+    /// `lut3d[c * size3d^3 + (b * size3d + g) * size3d + r]`.
+    std::vector<float> lut3d;
+
+    /// Read a LUT from a .cube file (in either the Adobe/Iridas or the
+    /// Resolve variant). Return false and set `err` if it can't be read.
+    bool read_cube(const std::string& filename, std::string& err);
+
+    /// Return the LUT of the .cube file, reading it only the first time
+    /// it's needed (or if the file has changed since), or nullptr and set
+    /// `err` if it can't be read.
+    static std::shared_ptr<const ColorLUT> cube(const std::string& filename,
+                                                std::string& err);
+};
+
+
+/// Transform the first three channels of `roi` of `src` into `dst` with
+/// the LUT, interpolating the 1D LUT linearly and the 3D LUT
+/// tetrahedrally, and copy any other channels of the roi unaltered. If
+/// `unpremult` is true and there's a fourth channel, it's taken to be
+/// alpha, and the color is divided by it before and multiplied by it
+/// again after.
+bool
+apply_color_lut(ImageBuf& dst, const ImageBuf& src, const ColorLUT& lut,
+                bool unpremult, ROI roi, int nthreads);
+
+/// Compute color_map() (with the same arguments, already checked, and
+/// dst prepared) using the LUT engine. uint8 and uint16 source channels
+/// are mapped by a table of the result for each of their values.
+bool
+color_map_lut(ImageBuf& dst, const ImageBuf& src, int srcchannel, int nknots,
+              int channels, cspan<float> knots, ROI roi, int nthreads);
+
+}  // namespace pvt
+
+OIIO_NAMESPACE_END
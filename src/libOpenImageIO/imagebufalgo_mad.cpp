@@ -12,13 +12,25 @@
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
 
+#include "imagebufalgo_half_prv.h"
 #include "imageio_pvt.h"
+#include "oiio_gpu_prv.h"
 
 
 OIIO_NAMESPACE_BEGIN
 
 
 
+// Are the pixels of img adjacent in memory along each scanline? (They
+// aren't in a view of some of the channels of another image.)
+inline bool
+compact_pixels(const ImageBuf& img)
+{
+    return img.pixel_stride() == stride_t(img.spec().pixel_bytes());
+}
+
+
+
 template<class Rtype, class ABCtype>
 static bool
 mad_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, const ImageBuf& C,
@@ -36,7 +48,8 @@ mad_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, const ImageBuf& C,
             && A.contains_roi(roi) && B.contains_roi(roi) && C.contains_roi(roi)
             && roi.chbegin == 0 && roi.chend == R.nchannels()
             && roi.chend == A.nchannels() && roi.chend == B.nchannels()
-            && roi.chend == C.nchannels()) {
+            && roi.chend == C.nchannels() && compact_pixels(R)
+            && compact_pixels(A) && compact_pixels(B) && compact_pixels(C)) {
             // Special case when all inputs are either float or half, with in-
             // memory contiguous data and we're operating on the full channel
             // range: skip iterators: For these circumstances, we can operate on
@@ -189,12 +202,22 @@ ImageBufAlgo::mad(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_,
     bool ok;
     if (B) {
         if (C) {
+            if (pvt::gpu_pixelmath(pvt::GPUOp::Mad, dst, *A, B, {}, C, {},
+                                   roi)
+                || pvt::half_pixelmath(pvt::HalfOp::Mad, dst, *A, B, {}, C,
+                                       {}, roi, nthreads))
+                return true;
             OIIO_DISPATCH_COMMON_TYPES2(ok, "mad", mad_impl, dst.spec().format,
                                         abc_type, dst, *A, *B, *C, roi,
                                         nthreads);
         } else {  // C not an image
             cspan<float> c(C_.val());
             IBA_FIX_PERCHAN_LEN_DEF(c, dst.nchannels());
+            if (pvt::gpu_pixelmath(pvt::GPUOp::Mad, dst, *A, B, {}, nullptr,
+                                   c, roi)
+                || pvt::half_pixelmath(pvt::HalfOp::Mad, dst, *A, B, {},
+                                       nullptr, c, roi, nthreads))
+                return true;
             OIIO_DISPATCH_COMMON_TYPES2(ok, "mad", mad_impl_iic,
                                         dst.spec().format, abc_type, dst, *A,
                                         *B, c, roi, nthreads);
@@ -203,12 +226,22 @@ ImageBufAlgo::mad(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_,
         cspan<float> b(B_.val());
         IBA_FIX_PERCHAN_LEN_DEF(b, dst.nchannels());
         if (C) {
+            if (pvt::gpu_pixelmath(pvt::GPUOp::Mad, dst, *A, nullptr, b, C,
+                                   {}, roi)
+                || pvt::half_pixelmath(pvt::HalfOp::Mad, dst, *A, nullptr, b,
+                                       C, {}, roi, nthreads))
+                return true;
             OIIO_DISPATCH_COMMON_TYPES2(ok, "mad", mad_impl_ici,
                                         dst.spec().format, abc_type, dst, *A, b,
                                         *C, roi, nthreads);
         } else {  // C not an image
             cspan<float> c(C_.val());
             IBA_FIX_PERCHAN_LEN_DEF(c, dst.nchannels());
+            if (pvt::gpu_pixelmath(pvt::GPUOp::Mad, dst, *A, nullptr, b,
+                                   nullptr, c, roi)
+                || pvt::half_pixelmath(pvt::HalfOp::Mad, dst, *A, nullptr, b,
+                                       nullptr, c, roi, nthreads))
+                return true;
             OIIO_DISPATCH_COMMON_TYPES2(ok, "mad", mad_impl_icc,
                                         dst.spec().format, abc_type, dst, *A, b,
                                         c, roi, nthreads);
@@ -19,7 +19,9 @@
 #include <OpenImageIO/imagebufalgo_util.h>
 #include <OpenImageIO/simd.h>
 
+#include "imagebufalgo_half_prv.h"
 #include "imageio_pvt.h"
+#include "oiio_gpu_prv.h"
 
 
 OIIO_NAMESPACE_BEGIN
@@ -152,6 +154,11 @@ ImageBufAlgo::mul(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_, ROI roi,
         const ImageBuf &A(A_.img()), &B(B_.img());
         if (!IBAprep(roi, &dst, &A, &B, IBAprep_CLAMP_MUTUAL_NCHANNELS))
             return false;
+        if (pvt::gpu_pixelmath(pvt::GPUOp::Mul, dst, A, &B, {}, nullptr,
+                               {}, roi)
+            || pvt::half_pixelmath(pvt::HalfOp::Mul, dst, A, &B, {}, nullptr,
+                                   {}, roi, nthreads))
+            return true;
         bool ok;
         OIIO_DISPATCH_COMMON_TYPES3(ok, "mul", mul_impl, dst.spec().format,
                                     A.spec().format, B.spec().format, dst, A, B,
@@ -172,6 +179,11 @@ ImageBufAlgo::mul(ImageBuf& dst, Image_or_Const A_, Image_or_Const B_, ROI roi,
             dst.deepdata()->set_all_samples(A.deepdata()->all_samples());
             return mul_impl_deep(dst, A, b, roi, nthreads);
         }
+        if (pvt::gpu_pixelmath(pvt::GPUOp::Mul, dst, A, nullptr, b,
+                               nullptr, {}, roi)
+            || pvt::half_pixelmath(pvt::HalfOp::Mul, dst, A, nullptr, b,
+                                   nullptr, {}, roi, nthreads))
+            return true;
         bool ok;
         OIIO_DISPATCH_COMMON_TYPES2(ok, "mul", mul_impl, dst.spec().format,
                                     A.spec().format, dst, A, b, roi, nthreads);
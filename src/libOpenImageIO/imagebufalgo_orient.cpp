@@ -2,7 +2,9 @@
 // SPDX-License-Identifier: Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <iostream>
 
 #include <OpenImageIO/half.h>
@@ -11,6 +13,7 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/simd.h>
 #include <OpenImageIO/thread.h>
 
 #include "imageio_pvt.h"
@@ -19,6 +22,58 @@
 OIIO_NAMESPACE_BEGIN
 
 
+// Can flip (flipy), flop (flopx), or both (rotate180) be done to all of
+// the in-memory image `buf` by swapping its pixels in place? Only if the
+// result covers the same pixels, i.e., the data window is centered in the
+// display window along each mirrored axis.
+static bool
+can_reflect_in_place(const ImageBuf& buf, ROI roi, bool flipy, bool flopx)
+{
+    ROI r = buf.roi(), f = buf.roi_full();
+    return (!roi.defined() || roi == r) && buf.localpixels() && !buf.deep()
+           && (!flipy || r.ybegin - f.ybegin == f.yend - r.yend)
+           && (!flopx || r.xbegin - f.xbegin == f.xend - r.xend);
+}
+
+
+
+// Mirror the pixels of `buf` in place, swapping each pixel with its mirror
+// image, each pair once (by the row nearer the top).
+static bool
+reflect_in_place(ImageBuf& buf, bool flipy, bool flopx, int nthreads)
+{
+    ROI r = buf.roi();
+    buf.clear_thumbnail();
+    buf.specmod().erase_attribute("oiio:SHA-1");
+    buf.specmod().erase_attribute("oiio:ContentHash");
+    char* base        = (char*)buf.pixeladdr(r.xbegin, r.ybegin, r.zbegin);
+    size_t pixelbytes = buf.spec().pixel_bytes();
+    stride_t xstride = buf.pixel_stride(), ystride = buf.scanline_stride();
+    stride_t zstride = buf.z_stride();
+    int w = r.width(), h = r.height();
+    int rows = flipy ? (h + 1) / 2 : h;  // per z plane
+    parallel_for(
+        int64_t(0), int64_t(rows) * r.depth(),
+        [&](int64_t row) {
+            int z       = int(row / rows);
+            int y       = int(row % rows);
+            int ymirror = flipy ? h - 1 - y : y;
+            char* a     = base + z * zstride + y * ystride;
+            char* b     = base + z * zstride + ymirror * ystride;
+            // A row mirrored onto itself swaps only its left half.
+            int xend = (y == ymirror) ? (flopx ? w / 2 : 0) : w;
+            for (int x = 0; x < xend; ++x) {
+                char* p = a + x * xstride;
+                char* q = b + (flopx ? w - 1 - x : x) * xstride;
+                std::swap_ranges(p, p + pixelbytes, q);
+            }
+        },
+        paropt(nthreads).minitems(std::max(1, 16384 / std::max(1, w))));
+    return true;
+}
+
+
+
 template<class D, class S = D>
 static bool
 flip_(ImageBuf& dst, const ImageBuf& src, ROI dst_roi, int /*nthreads*/)
@@ -41,6 +96,10 @@ bool
 ImageBufAlgo::flip(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
 {
     if (&dst == &src) {  // Handle in-place operation
+        if (can_reflect_in_place(src, roi, true, false)) {
+            pvt::LoggedTimer logtime("IBA::flip");
+            return reflect_in_place(dst, true, false, nthreads);
+        }
         ImageBuf tmp;
         tmp.swap(const_cast<ImageBuf&>(src));
         return flip(dst, tmp, roi, nthreads);
@@ -90,6 +149,10 @@ bool
 ImageBufAlgo::flop(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
 {
     if (&dst == &src) {  // Handle in-place operation
+        if (can_reflect_in_place(src, roi, false, true)) {
+            pvt::LoggedTimer logtime("IBA::flop");
+            return reflect_in_place(dst, false, true, nthreads);
+        }
         ImageBuf tmp;
         tmp.swap(const_cast<ImageBuf&>(src));
         return flop(dst, tmp, roi, nthreads);
@@ -141,6 +204,169 @@ ImageBufAlgo::flop(const ImageBuf& src, ROI roi, int nthreads)
 
 
 
+// The reorientations that exchange x and y walk either the source or the
+// destination across scanlines, which touches a new cache line (and, for
+// big images, a new page) for every pixel. When both images are local and
+// of the same type, so that it's only a matter of moving whole pixels,
+// these do it a block at a time instead, with each block small enough that
+// its source and destination pixels all stay in the cache.
+
+// Pixels along each side of the blocks.
+static constexpr int orient_block_size = 32;
+
+
+// Copy a rows x cols piece of a block of Bytes-sized pixels: the pixel of
+// row r and column c comes from s + c * sxstep + r * systep, and goes to
+// d + c * Bytes + r * ystride.
+template<size_t Bytes>
+static void
+orient_copy(char* d, stride_t ystride, const char* s, stride_t sxstep,
+            stride_t systep, int rows, int cols)
+{
+    for (int r = 0; r < rows; ++r, d += ystride, s += systep) {
+        char* dp       = d;
+        const char* sp = s;
+        for (int c = 0; c < cols; ++c, dp += Bytes, sp += sxstep)
+            memcpy(dp, sp, Bytes);
+    }
+}
+
+
+template<size_t Bytes>
+static void
+orient_block(char* d, stride_t ystride, const char* s, stride_t sxstep,
+             stride_t systep, int rows, int cols)
+{
+    orient_copy<Bytes>(d, ystride, s, sxstep, systep, rows, cols);
+}
+
+
+// 4-byte pixels (such as RGBA uint8, or one float channel) whose source
+// pixels are adjacent down each column of the block (systep is +/- 4
+// bytes) are moved 4x4 at a time, transposed in SIMD registers: each of
+// the four loads is a column of the destination, and each store a row.
+template<>
+void
+orient_block<4>(char* d, stride_t ystride, const char* s, stride_t sxstep,
+                stride_t systep, int rows, int cols)
+{
+    using simd::vint4;
+    if (systep != 4 && systep != -4) {
+        orient_copy<4>(d, ystride, s, sxstep, systep, rows, cols);
+        return;
+    }
+    const int rows4 = rows & ~3, cols4 = cols & ~3;
+    for (int r = 0; r < rows4; r += 4) {
+        // Going up the source, the column of 4 starts 3 pixels back.
+        const char* sp = s + r * systep - (systep < 0 ? 12 : 0);
+        char* dp       = d + r * ystride;
+        for (int c = 0; c < cols4; c += 4, sp += 4 * sxstep, dp += 16) {
+            vint4 v0((const int*)sp);
+            vint4 v1((const int*)(sp + sxstep));
+            vint4 v2((const int*)(sp + 2 * sxstep));
+            vint4 v3((const int*)(sp + 3 * sxstep));
+            if (systep < 0) {
+                v0 = simd::shuffle<3, 2, 1, 0>(v0);
+                v1 = simd::shuffle<3, 2, 1, 0>(v1);
+                v2 = simd::shuffle<3, 2, 1, 0>(v2);
+                v3 = simd::shuffle<3, 2, 1, 0>(v3);
+            }
+            simd::transpose(v0, v1, v2, v3);
+            v0.store((int*)dp);
+            v1.store((int*)(dp + ystride));
+            v2.store((int*)(dp + 2 * ystride));
+            v3.store((int*)(dp + 3 * ystride));
+        }
+    }
+    // The right and bottom edges that didn't make whole 4x4 pieces
+    orient_copy<4>(d + cols4 * 4, ystride, s + cols4 * sxstep, sxstep, systep,
+                   rows4, cols - cols4);
+    orient_copy<4>(d + rows4 * ystride, ystride, s + rows4 * systep, sxstep,
+                   systep, rows - rows4, cols);
+}
+
+
+template<size_t Bytes>
+static void
+orient_blocks(ImageBuf& dst, const ImageBuf& src, ROI dst_roi, int sx0,
+              int sy0, stride_t sxstep, stride_t systep, int nthreads)
+{
+    ImageBufAlgo::parallel_image(dst_roi, nthreads, [&](ROI roi) {
+        const int bs = orient_block_size;
+        for (int z = roi.zbegin; z < roi.zend; ++z) {
+            for (int by = roi.ybegin; by < roi.yend; by += bs) {
+                for (int bx = roi.xbegin; bx < roi.xend; bx += bs) {
+                    int rows = std::min(bs, roi.yend - by);
+                    int cols = std::min(bs, roi.xend - bx);
+                    const char* s = (const char*)src.pixeladdr(sx0, sy0, z)
+                                    + (bx - dst_roi.xbegin) * sxstep
+                                    + (by - dst_roi.ybegin) * systep;
+                    orient_block<Bytes>((char*)dst.pixeladdr(bx, by, z),
+                                        dst.scanline_stride(), s, sxstep,
+                                        systep, rows, cols);
+                }
+            }
+        }
+    });
+}
+
+
+// Set each pixel (x,y,z) of dst_roi to the pixel of src at (sx,sy,z),
+// where (sx,sy) starts at (sx0,sy0) for the first pixel of dst_roi, and
+// moves by (xstep_x,xstep_y) for each step in x and (ystep_x,ystep_y) for
+// each in y, a block at a time. Return false without doing anything
+// unless both images are flat and local, of the same pixel type, with all
+// their channels in the ROI, and src has all the pixels.
+static bool
+orient_fast(ImageBuf& dst, const ImageBuf& src, ROI dst_roi, int sx0,
+            int sy0, int xstep_x, int xstep_y, int ystep_x, int ystep_y,
+            int nthreads)
+{
+    const size_t pixelbytes = src.spec().pixel_bytes();
+    if (!pvt::imagebufalgo_fastpaths || !src.localpixels()
+        || !dst.localpixels() || src.deep() || dst.deep()
+        || src.spec().format != dst.spec().format
+        || dst_roi.chbegin != 0 || dst_roi.chend != src.nchannels()
+        || dst_roi.chend != dst.nchannels()
+        || src.pixel_stride() != stride_t(pixelbytes)
+        || dst.pixel_stride() != stride_t(pixelbytes))
+        return false;
+    // The source pixels of the corners must all be there.
+    int w = dst_roi.width() - 1, h = dst_roi.height() - 1;
+    int sx1 = sx0 + w * xstep_x + h * ystep_x;
+    int sy1 = sy0 + w * xstep_y + h * ystep_y;
+    ROI dst_need(dst_roi.xbegin, dst_roi.xend, dst_roi.ybegin, dst_roi.yend,
+                 dst_roi.zbegin, dst_roi.zend, 0, dst.nchannels());
+    ROI src_need(std::min(sx0, sx1), std::max(sx0, sx1) + 1,
+                 std::min(sy0, sy1), std::max(sy0, sy1) + 1, dst_roi.zbegin,
+                 dst_roi.zend, 0, src.nchannels());
+    if (!dst.roi().contains(dst_need) || !src.roi().contains(src_need))
+        return false;
+    const stride_t sxstep = xstep_x * src.pixel_stride()
+                            + xstep_y * src.scanline_stride();
+    const stride_t systep = ystep_x * src.pixel_stride()
+                            + ystep_y * src.scanline_stride();
+    switch (pixelbytes) {
+#define ORIENT_CASE(n)                                                    \
+    case n:                                                               \
+        orient_blocks<n>(dst, src, dst_roi, sx0, sy0, sxstep, systep,     \
+                         nthreads);                                       \
+        return true;
+        ORIENT_CASE(1)
+        ORIENT_CASE(2)
+        ORIENT_CASE(3)
+        ORIENT_CASE(4)
+        ORIENT_CASE(6)
+        ORIENT_CASE(8)
+        ORIENT_CASE(12)
+        ORIENT_CASE(16)
+#undef ORIENT_CASE
+    default: return false;
+    }
+}
+
+
+
 template<class D, class S = D>
 static bool
 rotate90_(ImageBuf& dst, const ImageBuf& src, ROI dst_roi, int /*nthreads*/)
@@ -193,6 +419,11 @@ ImageBufAlgo::rotate90(ImageBuf& dst, const ImageBuf& src, ROI roi,
     if (!dst_initialized)
         dst.set_roi_full(dst_roi_full);
 
+    // dst (x,y) is src (y, full.xend - 1 - x)
+    if (orient_fast(dst, src, dst_roi, dst_roi.ybegin,
+                    dst.roi_full().xend - 1 - dst_roi.xbegin, 0, -1, 1, 0,
+                    nthreads))
+        return true;
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2(ok, "rotate90", rotate90_, dst.spec().format,
                                 src.spec().format, dst, src, dst_roi, nthreads);
@@ -225,6 +456,10 @@ ImageBufAlgo::rotate180(ImageBuf& dst, const ImageBuf& src, ROI roi,
                         int nthreads)
 {
     if (&dst == &src) {  // Handle in-place operation
+        if (can_reflect_in_place(src, roi, true, true)) {
+            pvt::LoggedTimer logtime("IBA::rotate180");
+            return reflect_in_place(dst, true, true, nthreads);
+        }
         ImageBuf tmp;
         tmp.swap(const_cast<ImageBuf&>(src));
         return rotate180(dst, tmp, roi, nthreads);
@@ -307,6 +542,11 @@ ImageBufAlgo::rotate270(ImageBuf& dst, const ImageBuf& src, ROI roi,
     if (!dst_initialized)
         dst.set_roi_full(dst_roi_full);
 
+    // dst (x,y) is src (full.yend - 1 - y, x)
+    if (orient_fast(dst, src, dst_roi,
+                    dst.roi_full().yend - 1 - dst_roi.ybegin, dst_roi.xbegin,
+                    0, 1, -1, 0, nthreads))
+        return true;
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2(ok, "rotate270", rotate270_, dst.spec().format,
                                 src.spec().format, dst, src, dst_roi, nthreads);
@@ -420,6 +660,11 @@ bool
 ImageBufAlgo::transpose(ImageBuf& dst, const ImageBuf& src, ROI roi,
                         int nthreads)
 {
+    if (&dst == &src) {  // Handle in-place operation
+        ImageBuf tmp;
+        tmp.swap(const_cast<ImageBuf&>(src));
+        return transpose(dst, tmp, roi, nthreads);
+    }
     pvt::LoggedTimer logtime("IBA::transpose");
     if (!roi.defined())
         roi = get_roi(src.spec());
@@ -436,6 +681,10 @@ ImageBufAlgo::transpose(ImageBuf& dst, const ImageBuf& src, ROI roi,
                          r.chbegin, r.chend);
         dst.set_roi_full(dst_roi_full);
     }
+    // dst (x,y) is src (y,x)
+    if (orient_fast(dst, src, dst_roi, roi.xbegin, roi.ybegin, 0, 1, 1, 0,
+                    nthreads))
+        return true;
     bool ok;
     if (dst.spec().format == src.spec().format) {
         OIIO_DISPATCH_TYPES(ok, "transpose", transpose_, dst.spec().format, dst,
@@ -7,8 +7,11 @@
 /// single pixels at a time.
 
 #include <cmath>
+#include <cstring>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <vector>
 
 #include <OpenImageIO/half.h>
 
@@ -19,12 +22,143 @@
 #include <OpenImageIO/imagebufalgo_util.h>
 #include <OpenImageIO/simd.h>
 
+#include "imagebufalgo_half_prv.h"
+#include "imagebufalgo_lut_prv.h"
 #include "imageio_pvt.h"
+#include "oiio_gpu_prv.h"
 
 
 OIIO_NAMESPACE_BEGIN
 
 
+namespace pvt {
+int imagebufalgo_fastpaths(1);
+}  // namespace pvt
+
+
+
+// Fast path for the common case of both images being contiguous local
+// float, half, or uint8 buffers of the same type, each containing the whole
+// roi with all of its channels: each scanline of A is converted to floats
+// (unless it already is), passed to `kernel(float* values, int npixels)` to
+// modify in place, and converted back into R. This avoids the per-pixel
+// and per-channel overhead of ImageBuf iterators, and gives the kernel a
+// whole scanline to vectorize over. Return false, having done nothing, if
+// the images don't qualify (or "imagebufalgo:fastpaths" is 0), in which
+// case the caller should use the general path.
+template<class Kernel>
+static bool
+scanline_fastpath(ImageBuf& R, const ImageBuf& A, ROI roi, int nthreads,
+                  const Kernel& kernel)
+{
+    const TypeDesc type = A.spec().format;
+    if (!pvt::imagebufalgo_fastpaths || !R.localpixels() || !A.localpixels()
+        || !R.contiguous() || !A.contiguous() || R.spec().format != type
+        || (type != TypeFloat && type != TypeHalf && type != TypeUInt8)
+        || R.nchannels() != A.nchannels() || roi.chbegin != 0
+        || roi.chend != A.nchannels() || !A.roi().contains(roi)
+        || !R.roi().contains(roi))
+        return false;
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        const int width = roi.width();
+        const int n     = width * roi.nchannels();
+        std::unique_ptr<float[]> tmp(type == TypeFloat ? nullptr
+                                                       : new float[n]);
+        for (int z = roi.zbegin; z < roi.zend; ++z) {
+            for (int y = roi.ybegin; y < roi.yend; ++y) {
+                const void* a = A.pixeladdr(roi.xbegin, y, z);
+                void* r       = R.pixeladdr(roi.xbegin, y, z);
+                float* values = tmp ? tmp.get() : (float*)r;
+                if (tmp)
+                    convert_pixel_values(type, a, TypeFloat, values, n);
+                else if (r != a)
+                    memcpy(r, a, n * sizeof(float));
+                kernel(values, width);
+                if (tmp)
+                    convert_pixel_values(TypeFloat, values, type, r, n);
+            }
+        }
+    });
+    return true;
+}
+
+
+
+// Clamp n interleaved values, whose per-channel bounds are given by lo[]
+// and hi[] repeated to a length of nc * vfloat8::elements, so that each
+// vector's bounds start at a multiple of the vector width.
+static void
+clamp_values(float* values, int n, int nc, const float* lo, const float* hi)
+{
+    using simd::vfloat8;
+    const int period = nc * vfloat8::elements;
+    int i            = 0;
+    for (int k = 0; i + vfloat8::elements <= n; i += vfloat8::elements) {
+        vfloat8 v(values + i);
+        v = min(max(v, vfloat8(lo + k)), vfloat8(hi + k));
+        v.store(values + i);
+        k += vfloat8::elements;
+        if (k == period)
+            k = 0;
+    }
+    for (; i < n; ++i)
+        values[i] = OIIO::clamp(values[i], lo[i % period], hi[i % period]);
+}
+
+
+
+// x^y, by fast_pow_pos (to within a relative error of about 2e-5) where x
+// is positive and finite and the result is a normal float, and by std::pow
+// for everything else, so that its special cases are unchanged.
+inline float
+pow_fast(float x, float y)
+{
+    float l = y * fast_log2(x);
+    if (x > 0.0f && x <= std::numeric_limits<float>::max()
+        && fabsf(l) < 125.0f)
+        return fast_exp2(l);
+    return std::pow(x, y);
+}
+
+
+inline simd::vfloat8
+pow_fast(const simd::vfloat8& x, const simd::vfloat8& y)
+{
+    using namespace simd;
+    vfloat8 l = y * fast_log2(x);
+    vbool8 ok = (x > 0.0f) & (x <= std::numeric_limits<float>::max())
+                & (abs(l) < 125.0f);
+    vfloat8 r = fast_exp2(l);
+    if (!all(ok)) {
+        for (int i = 0; i < vfloat8::elements; ++i)
+            if (!ok[i])
+                r[i] = std::pow(x[i], y[i]);
+    }
+    return r;
+}
+
+
+
+// Raise n interleaved values to the per-channel powers given by exps[],
+// repeated to a length of nc * vfloat8::elements as for clamp_values().
+static void
+pow_values(float* values, int n, int nc, const float* exps)
+{
+    using simd::vfloat8;
+    const int period = nc * vfloat8::elements;
+    int i            = 0;
+    for (int k = 0; i + vfloat8::elements <= n; i += vfloat8::elements) {
+        pow_fast(vfloat8(values + i), vfloat8(exps + k)).store(values + i);
+        k += vfloat8::elements;
+        if (k == period)
+            k = 0;
+    }
+    for (; i < n; ++i)
+        values[i] = pow_fast(values[i], exps[i % period]);
+}
+
+
+
 template<class Rtype, class Atype, class Btype>
 static bool
 min_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
@@ -253,6 +387,28 @@ ImageBufAlgo::clamp(ImageBuf& dst, const ImageBuf& src, cspan<float> min,
                         -big);
     IBA_FIX_PERCHAN_LEN(max, dst.nchannels(), max.size() ? max.back() : big,
                         big);
+    // For the fast paths, clamping alpha to [min,max] and then to [0,1] is
+    // clamping it to the bounds themselves clamped to [0,1].
+    const int nc    = roi.chend;
+    const int alpha = clampalpha01 ? src.spec().alpha_channel : -1;
+    std::vector<float> lo(nc * simd::vfloat8::elements), hi(lo.size());
+    for (size_t i = 0; i < lo.size(); ++i) {
+        lo[i] = min[i % nc];
+        hi[i] = max[i % nc];
+        if (int(i % nc) == alpha) {
+            lo[i] = OIIO::clamp(lo[i], 0.0f, 1.0f);
+            hi[i] = OIIO::clamp(hi[i], 0.0f, 1.0f);
+        }
+    }
+    if (pvt::half_pixelmath(pvt::HalfOp::Clamp, dst, src, nullptr,
+                            cspan<float>(lo.data(), nc), nullptr,
+                            cspan<float>(hi.data(), nc), roi, nthreads)
+        || scanline_fastpath(dst, src, roi, nthreads,
+                             [&](float* values, int npixels) {
+                                 clamp_values(values, npixels * nc, nc,
+                                              lo.data(), hi.data());
+                             }))
+        return true;
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2(ok, "clamp", clamp_, dst.spec().format,
                                 src.spec().format, dst, src, min.data(),
@@ -402,7 +558,7 @@ pow_impl(ImageBuf& R, const ImageBuf& A, cspan<float> b, ROI roi, int nthreads)
         ImageBuf::ConstIterator<Atype> a(A, roi);
         for (ImageBuf::Iterator<Rtype> r(R, roi); !r.done(); ++r, ++a)
             for (int c = roi.chbegin; c < roi.chend; ++c)
-                r[c] = pow(a[c], b[c]);
+                r[c] = pow_fast(a[c], b[c]);
     });
     return true;
 }
@@ -416,6 +572,16 @@ ImageBufAlgo::pow(ImageBuf& dst, const ImageBuf& A, cspan<float> b, ROI roi,
     if (!IBAprep(roi, &dst, &A, IBAprep_CLAMP_MUTUAL_NCHANNELS))
         return false;
     IBA_FIX_PERCHAN_LEN_DEF(b, dst.nchannels());
+    const int nc = roi.chend;
+    std::vector<float> exps(nc * simd::vfloat8::elements);
+    for (size_t i = 0; i < exps.size(); ++i)
+        exps[i] = b[i % nc];
+    if (scanline_fastpath(dst, A, roi, nthreads,
+                          [&](float* values, int npixels) {
+                              pow_values(values, npixels * nc, nc,
+                                         exps.data());
+                          }))
+        return true;
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2(ok, "pow", pow_impl, dst.spec().format,
                                 A.spec().format, dst, A, b, roi, nthreads);
@@ -557,22 +723,44 @@ ImageBufAlgo::channel_sum(const ImageBuf& src, cspan<float> weights, ROI roi,
 
 
 
-inline float
-rangecompress(float x)
-{
-    // Formula courtesy of Sony Pictures Imageworks
+namespace {
+// Coefficients of rangecompress and rangeexpand.
+// Formula courtesy of Sony Pictures Imageworks
 #if 0 /* original coeffs -- identity transform for vals < 1 */
-    const float x1 = 1.0, a = 1.2607481479644775391;
-    const float b = 0.28785100579261779785, c = -1.4042005538940429688;
+constexpr float range_x1 = 1.0, range_a = 1.2607481479644775391;
+constexpr float range_b = 0.28785100579261779785;
+constexpr float range_c = -1.4042005538940429688;
 #else /* but received wisdom is that these work better */
-    const float x1 = 0.18, a = -0.54576885700225830078;
-    const float b = 0.18351669609546661377, c = 284.3577880859375;
+constexpr float range_x1 = 0.18, range_a = -0.54576885700225830078;
+constexpr float range_b = 0.18351669609546661377;
+constexpr float range_c = 284.3577880859375;
 #endif
+}  // namespace
 
+
+
+// The scalar and SIMD versions of rangecompress and rangeexpand use the
+// same fast_log and fast_exp, so that they give the same results.
+inline float
+rangecompress(float x)
+{
     float absx = fabsf(x);
-    if (absx <= x1)
+    if (absx <= range_x1)
         return x;
-    return copysignf(a + b * logf(fabsf(c * absx + 1.0f)), x);
+    return copysignf(range_a
+                         + range_b * fast_log(fabsf(range_c * absx + 1.0f)),
+                     x);
+}
+
+
+inline simd::vfloat8
+rangecompress(const simd::vfloat8& x)
+{
+    using namespace simd;
+    vfloat8 absx = abs(x);
+    vfloat8 r    = range_a + range_b * fast_log(abs(range_c * absx + 1.0f));
+    r            = select(x < 0.0f, -r, r);
+    return select(absx <= range_x1, x, r);
 }
 
 
@@ -580,29 +768,87 @@ rangecompress(float x)
 inline float
 rangeexpand(float y)
 {
-    // Formula courtesy of Sony Pictures Imageworks
-#if 0 /* original coeffs -- identity transform for vals < 1 */
-    const float x1 = 1.0, a = 1.2607481479644775391;
-    const float b = 0.28785100579261779785, c = -1.4042005538940429688;
-#else /* but received wisdom is that these work better */
-    const float x1 = 0.18, a = -0.54576885700225830078;
-    const float b = 0.18351669609546661377, c = 284.3577880859375;
-#endif
-
     float absy = fabsf(y);
-    if (absy <= x1)
+    if (absy <= range_x1)
         return y;
-    float xIntermediate = expf((absy - a) / b);
+    float xIntermediate = fast_exp((absy - range_a) / range_b);
     // Since the compression step includes an absolute value, there are
     // two possible results here. If x < x1 it is the incorrect result,
     // so pick the other value.
-    float x = (xIntermediate - 1.0f) / c;
-    if (x < x1)
-        x = (-xIntermediate - 1.0f) / c;
+    float x = (xIntermediate - 1.0f) / range_c;
+    if (x < range_x1)
+        x = (-xIntermediate - 1.0f) / range_c;
     return copysign(x, y);
 }
 
 
+inline simd::vfloat8
+rangeexpand(const simd::vfloat8& y)
+{
+    using namespace simd;
+    vfloat8 absy          = abs(y);
+    vfloat8 xIntermediate = fast_exp((absy - range_a) / range_b);
+    vfloat8 x             = (xIntermediate - 1.0f) / range_c;
+    x = abs(select(x < range_x1, (-xIntermediate - 1.0f) / range_c, x));
+    x = select(y < 0.0f, -x, x);
+    return select(absy <= range_x1, y, x);
+}
+
+
+
+// Fast path for rangecompress and rangeexpand, applying `func`, which must
+// take either a float or a vfloat8. Without luma, whole scanlines are
+// transformed 8 values at a time, with alpha and z put back as they were.
+template<class Func>
+static bool
+range_fastpath(ImageBuf& R, const ImageBuf& A, bool useluma,
+               const Func& func, ROI roi, int nthreads)
+{
+    using simd::vfloat8;
+    const int nc            = roi.nchannels();
+    const int alpha_channel = A.spec().alpha_channel;
+    const int z_channel     = A.spec().z_channel;
+    if (nc < 3 || (alpha_channel >= 0 && alpha_channel < 3)
+        || (z_channel >= 0 && z_channel < 3))
+        useluma = false;  // No way to use luma
+    // Which of the values are transformed (1) or not (0), repeated to a
+    // length of nc * vfloat8::elements as for clamp_values().
+    const int period = nc * vfloat8::elements;
+    std::vector<float> xform(period);
+    for (int i = 0; i < period; ++i)
+        xform[i] = (i % nc != alpha_channel && i % nc != z_channel) ? 1.0f
+                                                                      : 0.0f;
+    return scanline_fastpath(R, A, roi, nthreads, [&](float* values,
+                                                      int npixels) {
+        if (!useluma) {
+            const int n = npixels * nc;
+            int i       = 0;
+            for (int k = 0; i + vfloat8::elements <= n;
+                 i += vfloat8::elements) {
+                vfloat8 v(values + i);
+                v = select(vfloat8(xform.data() + k) != 0.0f, func(v), v);
+                v.store(values + i);
+                k += vfloat8::elements;
+                if (k == period)
+                    k = 0;
+            }
+            for (; i < n; ++i)
+                if (xform[i % period] != 0.0f)
+                    values[i] = func(values[i]);
+            return;
+        }
+        for (int p = 0; p < npixels; ++p, values += nc) {
+            float luma  = 0.21264f * values[0] + 0.71517f * values[1]
+                         + 0.07219f * values[2];
+            float scale = luma > 0.0f ? func(luma) / luma : 0.0f;
+            for (int c = 0; c < nc; ++c)
+                if (c != alpha_channel && c != z_channel)
+                    values[c] = values[c] * scale;
+        }
+    });
+}
+
+
 
 template<class Rtype, class Atype>
 static bool
@@ -745,6 +991,11 @@ ImageBufAlgo::rangecompress(ImageBuf& dst, const ImageBuf& src, bool useluma,
     pvt::LoggedTimer logtime("IBA::rangecompress");
     if (!IBAprep(roi, &dst, &src, IBAprep_CLAMP_MUTUAL_NCHANNELS))
         return false;
+    if (range_fastpath(
+            dst, src, useluma,
+            [](const auto& x) { return OIIO::rangecompress(x); }, roi,
+            nthreads))
+        return true;
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2(ok, "rangecompress", rangecompress_,
                                 dst.spec().format, src.spec().format, dst, src,
@@ -761,6 +1012,11 @@ ImageBufAlgo::rangeexpand(ImageBuf& dst, const ImageBuf& src, bool useluma,
     pvt::LoggedTimer logtime("IBA::rangeexpand");
     if (!IBAprep(roi, &dst, &src, IBAprep_CLAMP_MUTUAL_NCHANNELS))
         return false;
+    if (range_fastpath(
+            dst, src, useluma,
+            [](const auto& x) { return OIIO::rangeexpand(x); }, roi,
+            nthreads))
+        return true;
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2(ok, "rangeexpand", rangeexpand_,
                                 dst.spec().format, src.spec().format, dst, src,
@@ -796,6 +1052,47 @@ ImageBufAlgo::rangeexpand(const ImageBuf& src, bool useluma, ROI roi,
 
 
 
+// Fast path for premult (premult == true) and unpremult. Pixels whose
+// alpha is 1, or 0 if `keep_alpha0`, are left as they are.
+static bool
+premult_fastpath(ImageBuf& R, const ImageBuf& A, bool premult,
+                 bool keep_alpha0, ROI roi, int nthreads)
+{
+    using simd::vfloat4;
+    const int nc            = roi.nchannels();
+    const int alpha_channel = A.spec().alpha_channel;
+    const int z_channel     = A.spec().z_channel;
+    if (nc == 4 && alpha_channel == 3 && z_channel < 0) {
+        // RGBA: a pixel at a time, with SIMD
+        return scanline_fastpath(R, A, roi, nthreads, [&](float* values,
+                                                          int npixels) {
+            for (int p = 0; p < npixels; ++p, values += 4) {
+                float alpha = values[3];
+                if (alpha == 1.0f || (keep_alpha0 && alpha == 0.0f))
+                    continue;
+                vfloat4 v(values);
+                vfloat4 a(alpha, alpha, alpha, 1.0f);
+                v = premult ? v * a : v / a;
+                v.store(values);
+            }
+        });
+    }
+    return scanline_fastpath(R, A, roi, nthreads, [&](float* values,
+                                                      int npixels) {
+        for (int p = 0; p < npixels; ++p, values += nc) {
+            float alpha = values[alpha_channel];
+            if (alpha == 1.0f || (keep_alpha0 && alpha == 0.0f))
+                continue;
+            for (int c = 0; c < nc; ++c)
+                if (c != alpha_channel && c != z_channel)
+                    values[c] = premult ? values[c] * alpha
+                                        : values[c] / alpha;
+        }
+    });
+}
+
+
+
 template<class Rtype, class Atype>
 static bool
 unpremult_(ImageBuf& R, const ImageBuf& A, ROI roi, int nthreads)
@@ -851,9 +1148,11 @@ ImageBufAlgo::unpremult(ImageBuf& dst, const ImageBuf& src, ROI roi,
                          roi.chbegin, src, roi, nthreads);
         return true;
     }
-    bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "unpremult", unpremult_, dst.spec().format,
-                                src.spec().format, dst, src, roi, nthreads);
+    bool ok = premult_fastpath(dst, src, false, true, roi, nthreads);
+    if (!ok)
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "unpremult", unpremult_,
+                                    dst.spec().format, src.spec().format, dst,
+                                    src, roi, nthreads);
     // Mark the output as having unassociated alpha
     dst.specmod().attribute("oiio:UnassociatedAlpha", 1);
     return ok;
@@ -926,10 +1225,14 @@ ImageBufAlgo::premult(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
                          roi.chbegin, src, roi, nthreads);
         return true;
     }
-    bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "premult", premult_, dst.spec().format,
-                                src.spec().format, dst, src, false, roi,
-                                nthreads);
+    if (pvt::half_pixelmath(pvt::HalfOp::Premult, dst, src, nullptr, {},
+                            nullptr, {}, roi, nthreads))
+        return true;
+    bool ok = premult_fastpath(dst, src, true, false, roi, nthreads);
+    if (!ok)
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "premult", premult_, dst.spec().format,
+                                    src.spec().format, dst, src, false, roi,
+                                    nthreads);
     // Clear the output of any prior marking of associated alpha
     dst.specmod().erase_attribute("oiio:UnassociatedAlpha");
     return ok;
@@ -962,10 +1265,11 @@ ImageBufAlgo::repremult(ImageBuf& dst, const ImageBuf& src, ROI roi,
                          roi.chbegin, src, roi, nthreads);
         return true;
     }
-    bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "repremult", premult_, dst.spec().format,
-                                src.spec().format, dst, src, true, roi,
-                                nthreads);
+    bool ok = premult_fastpath(dst, src, true, true, roi, nthreads);
+    if (!ok)
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "repremult", premult_,
+                                    dst.spec().format, src.spec().format, dst,
+                                    src, true, roi, nthreads);
     // Clear the output of any prior marking of associated alpha
     dst.specmod().erase_attribute("oiio:UnassociatedAlpha");
     return ok;
@@ -1177,10 +1481,24 @@ ImageBufAlgo::saturate(ImageBuf& dst, const ImageBuf& src, float scale,
         return false;
     }
 
-    bool ok = true;
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "saturate", saturate_, dst.spec().format,
-                                src.spec().format, dst, src, scale,
-                                firstchannel, roi, nthreads);
+    const int nc = roi.nchannels();
+    const simd::vfloat3 weights(0.2126f, 0.7152f, 0.0722f);
+    bool ok = scanline_fastpath(
+        dst, src, roi, nthreads, [&](float* values, int npixels) {
+            for (int p = 0; p < npixels; ++p, values += nc) {
+                float* v = values + firstchannel;
+                simd::vfloat3 rgb(v[0], v[1], v[2]);
+                simd::vfloat3 luma = simd::vdot(rgb, weights);
+                rgb                = lerp(luma, rgb, scale);
+                v[0]               = rgb[0];
+                v[1]               = rgb[1];
+                v[2]               = rgb[2];
+            }
+        });
+    if (!ok)
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "saturate", saturate_,
+                                    dst.spec().format, src.spec().format, dst,
+                                    src, scale, firstchannel, roi, nthreads);
     return ok;
 }
 
@@ -1249,6 +1567,9 @@ ImageBufAlgo::color_map(ImageBuf& dst, const ImageBuf& src, int srcchannel,
         return false;
     dstroi.chend = std::min(channels, dst.nchannels());
 
+    if (pvt::imagebufalgo_fastpaths)
+        return pvt::color_map_lut(dst, src, srcchannel, nknots, channels,
+                                  knots, dstroi, nthreads);
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES2(ok, "color_map", color_map_, dst.spec().format,
                                 src.spec().format, dst, src, srcchannel, nknots,
@@ -1708,39 +2029,177 @@ over_impl(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, bool zcomp,
 
 
 
-// Special case -- 4 channel RGBA float, in-memory buffer, no wrapping.
-// Use loops and SIMD.
-static bool
-over_impl_rgbafloat(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, ROI roi,
-                    int nthreads)
+// The float values of all channels of the pixels of `row` (a span of one
+// scanline) of `img`: in place for a local float image that contains them,
+// else converted or fetched (as zero outside its data window) into `buf`.
+static const float*
+float_scanline(const ImageBuf& img, ROI row, float* buf)
 {
-    using namespace simd;
-    OIIO_DASSERT(A.localpixels() && B.localpixels()
-                 && A.spec().format == TypeFloat && A.nchannels() == 4
-                 && B.spec().format == TypeFloat && B.nchannels() == 4
-                 && A.spec().alpha_channel == 3 && A.spec().z_channel < 0
-                 && B.spec().alpha_channel == 3 && B.spec().z_channel < 0);
-    // const int nchannels = 4, alpha_channel = 3;
-    ImageBufAlgo::parallel_image(roi, nthreads, [=, &R, &A, &B](ROI roi) {
-        vfloat4 zero = vfloat4::Zero();
-        vfloat4 one  = vfloat4::One();
-        int w        = roi.width();
+    const int n = row.width() * img.nchannels();
+    if (img.localpixels() && img.contiguous() && img.roi().contains(row)) {
+        const void* p = img.pixeladdr(row.xbegin, row.ybegin, row.zbegin);
+        if (img.spec().format == TypeFloat)
+            return (const float*)p;
+        convert_pixel_values(img.spec().format, p, TypeFloat, buf, n);
+    } else {
+        img.get_pixels(row, span<float>(buf, n));
+    }
+    return buf;
+}
+
+
+
+// Where to compute the float results for `row` of `img`: in place if it's
+// a local float image that contains them, else `buf`, which
+// store_scanline() will then write back.
+static float*
+result_scanline(ImageBuf& img, ROI row, float* buf)
+{
+    if (img.localpixels() && img.contiguous() && img.roi().contains(row)
+        && img.spec().format == TypeFloat)
+        return (float*)img.pixeladdr(row.xbegin, row.ybegin, row.zbegin);
+    return buf;
+}
+
+static void
+store_scanline(ImageBuf& img, ROI row, const float* values)
+{
+    if (values == img.pixeladdr(row.xbegin, row.ybegin, row.zbegin))
+        return;  // computed in place
+    const int n = row.width() * img.nchannels();
+    if (img.localpixels() && img.contiguous() && img.roi().contains(row))
+        convert_pixel_values(TypeFloat, values, img.spec().format,
+                             img.pixeladdr(row.xbegin, row.ybegin, row.zbegin),
+                             n);
+    else
+        img.set_pixels(row, cspan<float>(values, n));
+}
+
+
+
+// Composite `layers` into R one scanline at a time, in float, calling
+// `kernel(float* r, const float* const* layers, int npixels)` for each
+// with whole (all channel) pixels. Results may be computed in place over
+// one of the layers' values, so the kernel must read each pixel of the
+// layers before writing that pixel of r.
+template<class Kernel>
+static void
+composite_scanlines(ImageBuf& R, cspan<const ImageBuf*> layers, ROI roi,
+                    int nthreads, const Kernel& kernel)
+{
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        const size_t n       = size_t(roi.width()) * R.nchannels();
+        const size_t nlayers = layers.size();
+        std::unique_ptr<float[]> bufs(new float[n * (nlayers + 1)]);
+        std::vector<const float*> rows(nlayers);
         for (int z = roi.zbegin; z < roi.zend; ++z) {
             for (int y = roi.ybegin; y < roi.yend; ++y) {
-                float* r       = (float*)R.pixeladdr(roi.xbegin, y, z);
-                const float* a = (const float*)A.pixeladdr(roi.xbegin, y, z);
-                const float* b = (const float*)B.pixeladdr(roi.xbegin, y, z);
-                for (int x = 0; x < w; ++x, r += 4, a += 4, b += 4) {
-                    vfloat4 a_simd(a);
-                    vfloat4 b_simd(b);
-                    vfloat4 alpha           = shuffle<3>(a_simd);
-                    vfloat4 one_minus_alpha = one - clamp(alpha, zero, one);
-                    vfloat4 result          = a_simd + one_minus_alpha * b_simd;
-                    result.store(r);
-                }
+                ROI row(roi.xbegin, roi.xend, y, y + 1, z, z + 1, 0,
+                        R.nchannels());
+                for (size_t i = 0; i < nlayers; ++i)
+                    rows[i] = float_scanline(*layers[i], row,
+                                             bufs.get() + (i + 1) * n);
+                float* r = result_scanline(R, row, bufs.get());
+                kernel(r, rows.data(), roi.width());
+                store_scanline(R, row, r);
             }
         }
     });
+}
+
+
+
+// r = a over b, for npixels pixels of nchannels channels. Unassociated z
+// (if z >= 0) is taken from a unless a is fully transparent.
+static void
+over_scanline(float* r, const float* a, const float* b, int npixels,
+              int nchannels, int alpha, int z)
+{
+    using namespace simd;
+    int i = 0;
+    if (nchannels == 4 && alpha == 3 && z < 0) {
+        // RGBA: two pixels per vfloat8
+        const vfloat8 zero = vfloat8::Zero(), one = vfloat8::One();
+        for (; i + 2 <= npixels; i += 2, r += 8, a += 8, b += 8) {
+            vfloat8 av(a), bv(b);
+            vfloat8 alphas = shuffle<3, 3, 3, 3, 7, 7, 7, 7>(av);
+            (av + (one - clamp(alphas, zero, one)) * bv).store(r);
+        }
+        if (i < npixels) {
+            vfloat4 av(a), bv(b);
+            vfloat4 alpha = clamp(shuffle<3>(av), vfloat4::Zero(),
+                                  vfloat4::One());
+            (av + (vfloat4::One() - alpha) * bv).store(r);
+        }
+        return;
+    }
+    for (; i < npixels; ++i, r += nchannels, a += nchannels, b += nchannels) {
+        float al              = clamp(a[alpha], 0.0f, 1.0f);
+        float one_minus_alpha = 1.0f - al;
+        float rz              = z < 0 ? 0.0f : (al != 0.0f ? a[z] : b[z]);
+        for (int c = 0; c < nchannels; ++c)
+            r[c] = a[c] + one_minus_alpha * b[c];
+        if (z >= 0)
+            r[z] = rz;
+    }
+}
+
+
+
+// Depth composite: r = whichever of a and b has the nearer z, over the
+// other.
+static void
+zover_scanline(float* r, const float* a, const float* b, int npixels,
+               int nchannels, int alpha, int z, bool z_zeroisinf)
+{
+    for (int i = 0; i < npixels; ++i, r += nchannels, a += nchannels,
+             b += nchannels) {
+        float az = a[z], bz = b[z];
+        if (z_zeroisinf) {
+            if (az == 0.0f)
+                az = std::numeric_limits<float>::max();
+            if (bz == 0.0f)
+                bz = std::numeric_limits<float>::max();
+        }
+        const float* fg       = (az <= bz) ? a : b;
+        const float* bg       = (az <= bz) ? b : a;
+        float al              = clamp(fg[alpha], 0.0f, 1.0f);
+        float one_minus_alpha = 1.0f - al;
+        float rz              = (al != 0.0f) ? fg[z] : bg[z];
+        for (int c = 0; c < nchannels; ++c)
+            r[c] = fg[c] + one_minus_alpha * bg[c];
+        r[z] = rz;
+    }
+}
+
+
+
+// Fast path for over and zover of float or half images, for all channels:
+// composite a scanline at a time in float, rather than with iterators.
+// Return false, having done nothing, if the images don't qualify.
+static bool
+over_fastpath(ImageBuf& R, const ImageBuf& A, const ImageBuf& B, bool zcomp,
+              bool z_zeroisinf, ROI roi, int nthreads)
+{
+    auto floatish = [](const ImageBuf& img) {
+        return img.spec().format == TypeFloat || img.spec().format == TypeHalf;
+    };
+    if (!pvt::imagebufalgo_fastpaths || !floatish(R) || !floatish(A)
+        || !floatish(B) || roi.chbegin != 0 || roi.chend != R.nchannels())
+        return false;
+    int nchannels = 0, alpha = 0, z = 0, ncolors = 0;
+    decode_over_channels(R, nchannels, alpha, z, ncolors);
+    const ImageBuf* layers[] = { &A, &B };
+    composite_scanlines(R, layers, roi, nthreads,
+                        [=](float* r, const float* const* l, int npixels) {
+                            if (zcomp)
+                                zover_scanline(r, l[0], l[1], npixels,
+                                               nchannels, alpha, z,
+                                               z_zeroisinf);
+                            else
+                                over_scanline(r, l[0], l[1], npixels,
+                                              nchannels, alpha, z);
+                        });
     return true;
 }
 
@@ -1755,18 +2214,12 @@ ImageBufAlgo::over(ImageBuf& dst, const ImageBuf& A, const ImageBuf& B, ROI roi,
                  IBAprep_REQUIRE_ALPHA | IBAprep_REQUIRE_SAME_NCHANNELS))
         return false;
 
-    if (A.localpixels() && B.localpixels() && A.spec().format == TypeFloat
-        && A.nchannels() == 4 && B.spec().format == TypeFloat
-        && B.nchannels() == 4 && A.spec().alpha_channel == 3
-        && A.spec().z_channel < 0 && B.spec().alpha_channel == 3
-        && B.spec().z_channel < 0 && A.roi().contains(roi)
-        && B.roi().contains(roi) && roi.chbegin == 0 && roi.chend == 4) {
-        // Easy case -- both buffers are float, 4 channels, alpha is
-        // channel[3], no special z channel, and pixel data windows
-        // completely cover the roi. This reduces to a simpler case we can
-        // handle without iterators and taking advantage of SIMD.
-        return over_impl_rgbafloat(dst, A, B, roi, nthreads);
-    }
+    if (A.spec().alpha_channel == B.spec().alpha_channel
+        && pvt::gpu_pixelmath(pvt::GPUOp::Over, dst, A, &B, {}, nullptr, {},
+                              roi))
+        return true;
+    if (over_fastpath(dst, A, B, false, false, roi, nthreads))
+        return !dst.has_error();
 
     bool ok;
     OIIO_DISPATCH_COMMON_TYPES3(ok, "over", over_impl, dst.spec().format,
@@ -1789,6 +2242,70 @@ ImageBufAlgo::over(const ImageBuf& A, const ImageBuf& B, ROI roi, int nthreads)
 
 
 
+bool
+ImageBufAlgo::over(ImageBuf& dst, cspan<const ImageBuf*> layers, ROI roi,
+                   int nthreads)
+{
+    pvt::LoggedTimer logtime("IBA::over");
+    if (layers.empty()) {
+        dst.errorfmt("over: no layers to composite");
+        return false;
+    }
+    if (!IBAprep(roi, dst, layers,
+                 { { "require_alpha", 1 }, { "require_same_nchannels", 1 } }))
+        return false;
+    roi.chbegin = 0;
+    roi.chend   = dst.nchannels();
+    int nchannels = 0, alpha = 0, z = 0, ncolors = 0;
+    decode_over_channels(dst, nchannels, alpha, z, ncolors);
+    const int nlayers = int(layers.size());
+    composite_scanlines(
+        dst, layers, roi, nthreads,
+        [=](float* r, const float* const* l, int npixels) {
+            using namespace simd;
+            if (nchannels == 4 && alpha == 3 && z < 0) {
+                // RGBA: a pixel per vector, back to front
+                const vfloat4 zero = vfloat4::Zero(), one = vfloat4::One();
+                for (int i = 0; i < npixels; ++i) {
+                    vfloat4 result(l[nlayers - 1] + 4 * i);
+                    for (int k = nlayers - 2; k >= 0; --k) {
+                        vfloat4 a(l[k] + 4 * i);
+                        vfloat4 alpha = OIIO::clamp(shuffle<3>(a), zero, one);
+                        result        = a + (one - alpha) * result;
+                    }
+                    result.store(r + 4 * i);
+                }
+                return;
+            }
+            float* result = OIIO_ALLOCA(float, nchannels);
+            for (int i = 0; i < npixels; ++i) {
+                size_t p = size_t(i) * nchannels;
+                std::copy(l[nlayers - 1] + p, l[nlayers - 1] + p + nchannels,
+                          result);
+                for (int k = nlayers - 2; k >= 0; --k) {
+                    const float* a = l[k] + p;
+                    over_scanline(result, a, result, 1, nchannels, alpha, z);
+                }
+                std::copy(result, result + nchannels, r + p);
+            }
+        });
+    return !dst.has_error();
+}
+
+
+
+ImageBuf
+ImageBufAlgo::over(cspan<const ImageBuf*> layers, ROI roi, int nthreads)
+{
+    ImageBuf result;
+    bool ok = over(result, layers, roi, nthreads);
+    if (!ok && !result.has_error())
+        result.errorfmt("ImageBufAlgo::over() error");
+    return result;
+}
+
+
+
 bool
 ImageBufAlgo::zover(ImageBuf& dst, const ImageBuf& A, const ImageBuf& B,
                     bool z_zeroisinf, ROI roi, int nthreads)
@@ -1798,7 +2315,10 @@ ImageBufAlgo::zover(ImageBuf& dst, const ImageBuf& A, const ImageBuf& B,
                  IBAprep_REQUIRE_ALPHA | IBAprep_REQUIRE_Z
                      | IBAprep_REQUIRE_SAME_NCHANNELS))
         return false;
+    if (over_fastpath(dst, A, B, true, z_zeroisinf, roi, nthreads))
+        return !dst.has_error();
     bool ok;
+
     OIIO_DISPATCH_COMMON_TYPES3(ok, "zover", over_impl, dst.spec().format,
                                 A.spec().format, B.spec().format, dst, A, B,
                                 true, z_zeroisinf, roi, nthreads);
@@ -18,8 +18,10 @@
 #include <OpenImageIO/color.h>
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/half.h>
+#include <OpenImageIO/Imath.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/imagebufalgo_lazy.h>
 #include <OpenImageIO/imagebufalgo_util.h>
 #include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/imageio.h>
@@ -1173,7 +1175,97 @@ test_color_management()
 
 
 
-static void
+// colorconvert of uint8 and uint16 images should get the same results
+// from the tables baked from a separable transform as from applying it,
+// and close to them from a 3D LUT of a transform with channel crosstalk.
+void
+test_colorconvert_tables()
+{
+    std::cout << "test colorconvert tables\n";
+    ColorConfig config, builtin("ocio://default");
+    const ColorConfig* cc = config.createColorProcessor("lin_srgb", "srgb")
+                                ? &config
+                                : &builtin;
+    ImageSpec spec(37, 20, 4, TypeFloat);
+    ImageBuf F(spec);
+    const float tl[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+    const float tr[] = { 1.0f, 0.0f, 0.5f, 0.5f };
+    const float bl[] = { 0.5f, 1.0f, 0.0f, 0.0f };
+    const float br[] = { 0.2f, 0.4f, 1.0f, 0.25f };
+    ImageBufAlgo::fill(F, tl, tr, bl, br);
+    for (TypeDesc type : { TypeUInt8, TypeUInt16 }) {
+        ImageBuf A;
+        A.copy(F, type);
+        auto convert = [&](string_view from, string_view to) {
+            return ImageBufAlgo::colorconvert(A, from, to, false, "", "", cc);
+        };
+        OIIO::attribute("imagebufalgo:fastpaths", 0);
+        ImageBuf general = convert("srgb", "lin_srgb");
+        OIIO::attribute("imagebufalgo:fastpaths", 1);
+        ImageBuf fast = convert("srgb", "lin_srgb");
+        auto comp     = ImageBufAlgo::compare(fast, general, 0.0f, 0.0f);
+        OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+        // A gamut conversion, which has crosstalk
+        if (!cc->createColorProcessor("srgb", "ACEScg"))
+            continue;
+        general = convert("srgb", "ACEScg");
+        OIIO::attribute("imagebufalgo:colorconvert_lut3d", 65);
+        ImageBuf lut = convert("srgb", "ACEScg");
+        OIIO::attribute("imagebufalgo:colorconvert_lut3d", 0);
+        comp = ImageBufAlgo::compare(lut, general, 2.0e-3f, 2.0e-3f);
+        OIIO_CHECK_EQUAL(comp.nfail, 0);
+    }
+}
+
+
+
+static // Noise is deterministic per pixel, however the image is split among
+// threads.
+void
+test_noise()
+{
+    print("Testing noise\n");
+    ImageSpec spec(61, 37, 3, TypeFloat);
+    for (auto type : { "uniform", "gaussian", "salt", "blue" }) {
+        for (bool mono : { false, true }) {
+            ImageBuf A(spec), B(spec);
+            ImageBufAlgo::zero(A);
+            ImageBufAlgo::zero(B);
+            float a = strcmp(type, "salt") ? 0.0f : 1.0f;
+            float b = strcmp(type, "salt") ? 1.0f : 0.25f;
+            ImageBufAlgo::noise(A, type, a, b, mono, 7, {}, 1);
+            ImageBufAlgo::noise(B, type, a, b, mono, 7, {}, 0);
+            OIIO_CHECK_EQUAL(ImageBufAlgo::compare(A, B, 0.0f, 0.0f).nfail, 0);
+            // A region that starts mid-scanline gets the same values there
+            ROI roi(5, 42, 3, 30, 0, 1, 0, 3);
+            ImageBuf C(spec);
+            ImageBufAlgo::zero(C);
+            ImageBufAlgo::noise(C, type, a, b, mono, 7, roi, 0);
+            OIIO_CHECK_EQUAL(ImageBufAlgo::compare(A, C, 0.0f, 0.0f, roi).nfail,
+                             0);
+            if (mono && strcmp(type, "salt"))
+                OIIO_CHECK_EQUAL(A.getchannel(17, 9, 0, 0),
+                                 A.getchannel(17, 9, 0, 2));
+        }
+    }
+    ImageBuf U(spec);
+    ImageBufAlgo::zero(U);
+    ImageBufAlgo::noise(U, "uniform", 0.25f, 0.75f);
+    auto stats = ImageBufAlgo::computePixelStats(U);
+    OIIO_CHECK_GE(stats.min[1], 0.25f);
+    OIIO_CHECK_LT(stats.max[1], 0.75f);
+    OIIO_CHECK_EQUAL_THRESH(stats.avg[1], 0.5f, 0.02f);
+    ImageBufAlgo::zero(U);
+    ImageBufAlgo::noise(U, "gaussian", 0.5f, 0.1f);
+    stats = ImageBufAlgo::computePixelStats(U);
+    OIIO_CHECK_EQUAL_THRESH(stats.avg[0], 0.5f, 0.02f);
+    OIIO_CHECK_EQUAL_THRESH(stats.stddev[0], 0.1f, 0.01f);
+}
+
+
+
+void
 test_yee()
 {
     print("Testing Yee comparison\n");
@@ -1187,6 +1279,26 @@ test_yee()
     OIIO_CHECK_EQUAL(n, 1);
     OIIO_CHECK_EQUAL(cr.maxx, 0);
     OIIO_CHECK_EQUAL(cr.maxy, 0);
+
+    // One different pixel, in the ragged end of a scanline
+    ImageSpec bigspec(37, 23, 3, TypeDesc::FLOAT);
+    ImageBuf big1(bigspec);
+    ImageBufAlgo::fill(big1, { 0.1f, 0.1f, 0.1f });
+    ImageBuf big2(bigspec);
+    ImageBufAlgo::fill(big2, { 0.1f, 0.1f, 0.1f });
+    big2.setpixel(34, 17, cspan<float>({ 0.1f, 0.6f, 0.1f }));
+    n = ImageBufAlgo::compare_Yee(big1, big2, cr);
+    OIIO_CHECK_EQUAL(n, 1);
+    OIIO_CHECK_EQUAL(cr.maxx, 34);
+    OIIO_CHECK_EQUAL(cr.maxy, 17);
+
+    // Stopping once more than maxfail pixels have failed
+    ImageBufAlgo::fill(big2, { 0.1f, 0.6f, 0.1f });
+    n = ImageBufAlgo::compare_Yee(big1, big2, cr);
+    OIIO_CHECK_EQUAL(n, 37 * 23);
+    n = ImageBufAlgo::compare_Yee(big1, big2, cr, 100.0f, 45.0f, {}, 0, 10);
+    OIIO_CHECK_GT(n, 10);
+    OIIO_CHECK_LE(n, 37 * 23);
 }
 
 
@@ -1513,6 +1625,1067 @@ test_demosaic()
 }
 
 
+// Test ImageBufAlgo::lazy, whose results should match the eager functions
+void
+test_lazy()
+{
+    std::cout << "test lazy\n";
+    namespace lazy = ImageBufAlgo::lazy;
+    using ImageBufAlgo::LazyImage;
+
+    // As in test_color_management, fall back to the built-in config.
+    ColorConfig config, builtin("ocio://default");
+    const ColorConfig* cc = config.createColorProcessor("lin_srgb", "srgb")
+                                ? &config
+                                : &builtin;
+
+    ImageSpec spec(64, 48, 4, TypeFloat);
+    spec.alpha_channel = 3;
+    ImageBuf FG(spec);
+    const float tl[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const float tr[] = { 0.5f, 0.1f, 0.2f, 0.5f };
+    const float bl[] = { 0.1f, 0.3f, 0.1f, 0.4f };
+    const float br[] = { 0.9f, 0.8f, 0.7f, 1.0f };
+    ImageBufAlgo::fill(FG, tl, tr, bl, br);
+    ImageBuf BG = filled_image({ 0.2f, 0.4f, 0.6f, 1.0f }, spec);
+    // A smaller window, to check that missing pixels read as zero
+    ImageSpec smallspec(16, 16, 4, TypeFloat);
+    smallspec.x = 8;
+    smallspec.y = 40;
+    ImageBuf small = filled_image({ 0.1f, 0.2f, 0.3f, 0.0f }, smallspec);
+
+    ImageBuf eager = ImageBufAlgo::colorconvert(FG, "lin_srgb", "srgb", true,
+                                                "", "", cc);
+    eager          = ImageBufAlgo::over(eager, BG);
+    eager          = ImageBufAlgo::mul(eager, 0.5f);
+    eager          = ImageBufAlgo::add(eager, small);
+    eager          = ImageBufAlgo::clamp(eager, 0.0f, 0.6f);
+
+    LazyImage expr = lazy::colorconvert(FG, "lin_srgb", "srgb", true, cc);
+    expr           = lazy::mul(lazy::over(expr, BG), 0.5f);
+    expr           = lazy::clamp(lazy::add(expr, small), 0.0f, 0.6f);
+    ImageBuf R     = lazy::evaluate(expr);
+    OIIO_CHECK_ASSERT(!R.has_error());
+    OIIO_CHECK_ASSERT(R.roi() == eager.roi());
+    auto comp = ImageBufAlgo::compare(R, eager, 1.0e-5f, 1.0e-5f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // Resizing is done first, then fed to the rest
+    ROI half(0, 32, 0, 24, 0, 1, 0, 4);
+    eager = ImageBufAlgo::sub(ImageBufAlgo::resize(FG, {}, half), 0.25f);
+    R     = lazy::evaluate(lazy::sub(lazy::resize(FG, {}, half), 0.25f));
+    OIIO_CHECK_ASSERT(R.roi() == eager.roi());
+    comp = ImageBufAlgo::compare(R, eager, 1.0e-5f, 1.0e-5f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // Evaluating in place
+    ImageBuf inplace = FG;
+    eager            = ImageBufAlgo::div(FG, BG);
+    OIIO_CHECK_ASSERT(lazy::evaluate(inplace, lazy::div(inplace, BG)));
+    comp = ImageBufAlgo::compare(inplace, eager, 1.0e-5f, 1.0e-5f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    // Errors are reported in the result
+    ImageBuf rgb = filled_image({ 0.1f, 0.2f, 0.3f });
+    R            = lazy::evaluate(lazy::over(rgb, BG));
+    OIIO_CHECK_ASSERT(R.has_error());
+
+    // Timing of a comp chain, eager vs. fused
+    Benchmarker bench;
+    ImageSpec onek(1000, 1000, 4, TypeFloat);
+    onek.alpha_channel = 3;
+    FG.reset(onek);
+    ImageBufAlgo::fill(FG, tl, tr, bl, br);
+    BG = filled_image({ 0.2f, 0.4f, 0.6f, 1.0f }, onek);
+    bench("  IBA comp chain", [&]() {
+        ImageBuf r = ImageBufAlgo::over(FG, BG);
+        r          = ImageBufAlgo::mul(r, 0.5f);
+        r          = ImageBufAlgo::clamp(r, 0.0f, 0.6f);
+    });
+    bench("  IBA::lazy comp chain", [&]() {
+        ImageBuf r = lazy::evaluate(
+            lazy::clamp(lazy::mul(lazy::over(FG, BG), 0.5f), 0.0f, 0.6f));
+    });
+}
+
+
+
+// Test ImageBufAlgo::process_tiles, which should give the same result as
+// running the IBA function on the whole image.
+void
+test_process_tiles()
+{
+    std::cout << "test process_tiles\n";
+    ImageBuf A(ImageSpec(200, 150, 3, TypeFloat));
+    const float tl[] = { 0.0f, 0.2f, 0.4f };
+    const float tr[] = { 1.0f, 0.0f, 0.5f };
+    const float bl[] = { 0.5f, 1.0f, 0.0f };
+    const float br[] = { 0.2f, 0.4f, 1.0f };
+    ImageBufAlgo::fill(A, tl, tr, bl, br);
+    ImageBufAlgo::render_box(A, 40, 30, 120, 90, { 1.0f, 1.0f, 1.0f }, true);
+    OIIO_CHECK_ASSERT(A.write("process_tiles_in.tif"));
+    ImageBuf expected = ImageBufAlgo::median_filter(A, 5, 5);
+
+    ImageBuf src("process_tiles_in.tif", 0, 0, ImageCache::create());
+    auto median = [](ImageBuf& dst, cspan<const ImageBuf*> srcs, ROI roi) {
+        return ImageBufAlgo::median_filter(dst, *srcs[0], 5, 5, roi, 1);
+    };
+    // Tiles that don't evenly divide the image, and scanlines
+    for (int tilesize : { 64, 0 }) {
+        ImageSpec spec(200, 150, 3, TypeFloat);
+        spec.tile_width = spec.tile_height = tilesize;
+        bool ok = ImageBufAlgo::process_tiles("process_tiles_out.tif", spec,
+                                              { &src }, 2, median);
+        OIIO_CHECK_ASSERT(ok);
+        if (!ok)
+            std::cout << "process_tiles error: " << OIIO::geterror() << "\n";
+        ImageBuf R("process_tiles_out.tif");
+        R.read(0, 0, true);
+        OIIO_CHECK_EQUAL(R.spec().tile_width, tilesize);
+        auto comp = ImageBufAlgo::compare(R, expected, 1.0e-6f, 1.0e-6f);
+        OIIO_CHECK_EQUAL(comp.nfail, 0);
+    }
+    Filesystem::remove("process_tiles_in.tif");
+    Filesystem::remove("process_tiles_out.tif");
+}
+
+
+
+// The scanline fast paths of the pixel math functions should match the
+// general code, for each of the types they handle.
+void
+test_pixelmath_fastpaths()
+{
+    std::cout << "test pixel math fast paths\n";
+    using Op = std::function<bool(ImageBuf&, const ImageBuf&)>;
+    const std::pair<const char*, Op> ops[] = {
+        { "clamp",
+          [](ImageBuf& R, const ImageBuf& A) {
+              return ImageBufAlgo::clamp(R, A, { 0.1f, 0.2f, 0.3f, 0.0f },
+                                         { 0.9f, 0.8f, 0.7f, 2.0f }, true);
+          } },
+        { "pow",
+          [](ImageBuf& R, const ImageBuf& A) {
+              return ImageBufAlgo::pow(R, A, { 2.2f, 1.0f, 0.5f, 1.0f });
+          } },
+        { "rangecompress",
+          [](ImageBuf& R, const ImageBuf& A) {
+              return ImageBufAlgo::rangecompress(R, A, true);
+          } },
+        { "rangeexpand",
+          [](ImageBuf& R, const ImageBuf& A) {
+              return ImageBufAlgo::rangeexpand(R, A, false);
+          } },
+        { "saturate",
+          [](ImageBuf& R, const ImageBuf& A) {
+              return ImageBufAlgo::saturate(R, A, 0.5f);
+          } },
+        { "premult",
+          [](ImageBuf& R, const ImageBuf& A) {
+              return ImageBufAlgo::premult(R, A);
+          } },
+        { "unpremult",
+          [](ImageBuf& R, const ImageBuf& A) {
+              return ImageBufAlgo::unpremult(R, A);
+          } },
+    };
+    // An odd width, so that scanlines don't fill whole SIMD vectors
+    ImageSpec spec(37, 20, 4, TypeFloat);
+    spec.alpha_channel = 3;
+    ImageBuf F(spec);
+    const float tl[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+    const float tr[] = { 1.5f, 0.0f, 0.5f, 0.5f };
+    const float bl[] = { 0.5f, 3.0f, 0.0f, 0.0f };
+    const float br[] = { 0.2f, 0.4f, 1.0f, 0.25f };
+    ImageBufAlgo::fill(F, tl, tr, bl, br);
+    for (TypeDesc type : { TypeFloat, TypeHalf, TypeUInt8 }) {
+        ImageBuf A;
+        A.copy(F, type);
+        for (auto& op : ops) {
+            ImageBuf general(A.spec()), fast(A.spec());
+            OIIO::attribute("imagebufalgo:fastpaths", 0);
+            OIIO_CHECK_ASSERT(op.second(general, A));
+            OIIO::attribute("imagebufalgo:fastpaths", 1);
+            OIIO_CHECK_ASSERT(op.second(fast, A));
+            auto comp = ImageBufAlgo::compare(fast, general, 1.0e-6f, 1.0e-6f);
+            if (comp.nfail)
+                std::cout << "  " << op.first << " " << type << " differs\n";
+            OIIO_CHECK_EQUAL(comp.nfail, 0);
+        }
+    }
+}
+
+
+
+// Test the methods of ImageBufAlgo::convolve, which should all agree.
+void
+test_convolve()
+{
+    std::cout << "test convolve\n";
+    ImageBuf A(ImageSpec(64, 48, 3, TypeFloat));
+    const float tl[] = { 0.0f, 0.2f, 0.4f };
+    const float tr[] = { 1.0f, 0.0f, 0.5f };
+    const float bl[] = { 0.5f, 1.0f, 0.0f };
+    const float br[] = { 0.2f, 0.4f, 1.0f };
+    ImageBufAlgo::fill(A, tl, tr, bl, br);
+    ImageBufAlgo::render_box(A, 20, 10, 40, 30, { 1.0f, 1.0f, 1.0f }, true);
+
+    auto check = [&](const ImageBuf& K, string_view method) {
+        ImageBuf direct = ImageBufAlgo::convolve(A, K, { { "method",
+                                                           "direct" } });
+        ImageBuf R = ImageBufAlgo::convolve(A, K, { { "method", method } });
+        OIIO_CHECK_ASSERT(!R.has_error());
+        auto comp = ImageBufAlgo::compare(R, direct, 1.0e-5f, 1.0e-5f);
+        if (comp.nfail)
+            std::cout << "  " << method << " differs from direct\n";
+        OIIO_CHECK_EQUAL(comp.nfail, 0);
+    };
+    // A separable kernel, and one that isn't
+    ImageBuf gauss = ImageBufAlgo::make_kernel("gaussian", 7, 5);
+    ImageBuf disk  = ImageBufAlgo::make_kernel("disk", 7, 7);
+    for (auto method : { "separable", "fft", "auto" })
+        check(gauss, method);
+    for (auto method : { "fft", "auto" })
+        check(disk, method);
+    ImageBuf R = ImageBufAlgo::convolve(A, disk, { { "method", "separable" } });
+    OIIO_CHECK_ASSERT(R.has_error());
+
+    // With the kernel not normalized, over part of the image
+    ImageBuf big = ImageBufAlgo::make_kernel("disk", 21, 21, 1.0f, false);
+    ROI roi(10, 50, 5, 40, 0, 1, 0, 3);
+    ImageBuf direct = ImageBufAlgo::convolve(A, big,
+                                             { { "method", "direct" },
+                                               { "normalize", 0 } },
+                                             roi);
+    ImageBuf fft    = ImageBufAlgo::convolve(A, big,
+                                             { { "method", "fft" },
+                                               { "normalize", 0 } },
+                                             roi);
+    auto comp       = ImageBufAlgo::compare(fft, direct, 1.0e-4f, 1.0e-4f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+}
+
+
+
+// The constant-time median_filter, dilate, and erode used for big windows
+// should give exactly the same results as the brute-force ones.
+void
+test_big_window_filters()
+{
+    std::cout << "test median_filter, dilate, erode with big windows\n";
+    for (TypeDesc type : { TypeUInt8, TypeUInt16, TypeFloat }) {
+        ImageBuf src(ImageSpec(83, 61, 2, type));
+        ImageBufAlgo::noise(src, "uniform", 0.0f, 1.0f, false, 42);
+        ImageBufAlgo::render_box(src, 20, 10, 50, 40, { 1.0f, 0.0f }, true);
+        // Windows both odd and even, over all and part of the image
+        const int sizes[][2] = { { 15, 15 }, { 18, 11 }, { 9, 31 } };
+        for (auto size : sizes) {
+            for (ROI roi : { src.roi(), ROI(3, 40, 30, 61, 0, 1, 0, 2) }) {
+                for (int f = 0; f < 3; ++f) {
+                    ImageBuf R[2];
+                    for (int fast = 0; fast < 2; ++fast) {
+                        OIIO::attribute("imagebufalgo:fastpaths", fast);
+                        R[fast].reset(ImageSpec(83, 61, 2, type));
+                        if (f == 0)
+                            ImageBufAlgo::median_filter(R[fast], src, size[0],
+                                                        size[1], roi);
+                        else if (f == 1)
+                            ImageBufAlgo::dilate(R[fast], src, size[0],
+                                                 size[1], roi);
+                        else
+                            ImageBufAlgo::erode(R[fast], src, size[0],
+                                                size[1], roi);
+                    }
+                    auto comp = ImageBufAlgo::compare(R[1], R[0], 0.0f, 0.0f);
+                    if (comp.nfail)
+                        std::cout << "  filter " << f << " " << type << " "
+                                  << size[0] << "x" << size[1] << " differs\n";
+                    OIIO_CHECK_EQUAL(comp.nfail, 0);
+                }
+            }
+        }
+    }
+    OIIO::attribute("imagebufalgo:fastpaths", 1);
+}
+
+
+
+// The two-pass resize for separable filters should match the direct one.
+void
+test_resize_separable()
+{
+    std::cout << "test separable resize\n";
+    for (int nchannels : { 4, 3, 1 }) {
+        // uint8 (only for 1 channel) exercises the non-float conversion
+        ImageBuf src(ImageSpec(160, 90, nchannels,
+                               nchannels == 1 ? TypeUInt8 : TypeFloat));
+        ImageBufAlgo::noise(src, "uniform", 0.0f, 1.0f, false, 7);
+        ImageBufAlgo::render_box(src, 40, 20, 100, 60, { 1, 0, 0.5f, 1 },
+                                 true);
+        for (const char* filter : { "lanczos3", "blackman-harris", "box" }) {
+            // Down, up, and neither way, to a non-integer ratio, and down
+            // by exactly 2x
+            for (ROI roi : { ROI(0, 64, 0, 36), ROI(0, 400, 0, 200),
+                             ROI(0, 100, 0, 150), ROI(0, 80, 0, 45) }) {
+                ImageBuf R[2];
+                for (int fast = 0; fast < 2; ++fast) {
+                    OIIO::attribute("imagebufalgo:fastpaths", fast);
+                    R[fast] = ImageBufAlgo::resize(src,
+                                                   { { "filtername", filter } },
+                                                   roi);
+                }
+                // uint8 results may round the other way
+                float eps = nchannels == 1 ? 1.01f / 255.0f : 1.0e-5f;
+                auto comp = ImageBufAlgo::compare(R[1], R[0], eps, eps);
+                if (comp.nfail)
+                    std::cout << "  " << filter << " " << roi << " differs\n";
+                OIIO_CHECK_EQUAL(comp.nfail, 0);
+            }
+        }
+    }
+    OIIO::attribute("imagebufalgo:fastpaths", 1);
+
+    Benchmarker bench;
+    bench.units(Benchmarker::Unit::ms);
+    bench.iterations(1);
+    ImageBuf big(ImageSpec(1024, 540, 3, TypeHalf));
+    ImageBufAlgo::noise(big, "uniform", 0.0f, 1.0f);
+    ImageBuf small(ImageSpec(512, 270, 3, TypeHalf));
+    for (int fast = 0; fast < 2; ++fast) {
+        OIIO::attribute("imagebufalgo:fastpaths", fast);
+        bench(fast ? "  IBA::resize 1K->512 half (two pass)"
+                   : "  IBA::resize 1K->512 half (direct)  ",
+              [&]() { ImageBufAlgo::resize(small, big); });
+    }
+    OIIO::attribute("imagebufalgo:fastpaths", 1);
+}
+
+
+
+// Results of the statistics and predicates, computed in bands, must not
+// depend on the number of threads or the pixel type.
+void
+test_parallel_reductions()
+{
+    std::cout << "test parallel reductions\n";
+    ImageBuf F(ImageSpec(300, 200, 4, TypeFloat));
+    ImageBufAlgo::noise(F, "uniform", 0.0f, 1.0f, false, 3);
+    ImageBuf H = F.copy(TypeHalf);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    F.setpixel(17, 103, { 0.5f, nan, 2.0f, -1.0f });
+    for (const ImageBuf* img : { &F, &H }) {
+        auto S1 = ImageBufAlgo::computePixelStats(*img, {}, 1);
+        auto S  = ImageBufAlgo::computePixelStats(*img, {}, 8);
+        for (int c = 0; c < 4; ++c) {
+            OIIO_CHECK_EQUAL(S.min[c], S1.min[c]);
+            OIIO_CHECK_EQUAL(S.max[c], S1.max[c]);
+            OIIO_CHECK_EQUAL(S.sum[c], S1.sum[c]);
+            OIIO_CHECK_EQUAL(S.finitecount[c], S1.finitecount[c]);
+        }
+        // A channel subset doesn't take the RGBA path, but must agree
+        auto S3 = ImageBufAlgo::computePixelStats(*img, ROI(0, 300, 0, 200,
+                                                             0, 1, 1, 3));
+        OIIO_CHECK_EQUAL(S3.sum[1], S.sum[1]);
+        OIIO_CHECK_EQUAL(S3.max[2], S.max[2]);
+    }
+    auto S = ImageBufAlgo::computePixelStats(F);
+    OIIO_CHECK_EQUAL(S.nancount[1], 1);
+    OIIO_CHECK_EQUAL(S.finitecount[1], 300 * 200 - 1);
+    OIIO_CHECK_EQUAL(S.max[2], 2.0f);
+    OIIO_CHECK_EQUAL(S.min[3], -1.0f);
+
+    auto C1 = ImageBufAlgo::compare(F, H, 1.0e-3f, 1.0e-4f, {}, 1);
+    auto C  = ImageBufAlgo::compare(F, H, 1.0e-3f, 1.0e-4f, {}, 8);
+    OIIO_CHECK_EQUAL(C.nfail, C1.nfail);
+    OIIO_CHECK_EQUAL(C.nwarn, C1.nwarn);
+    OIIO_CHECK_EQUAL(C.meanerror, C1.meanerror);
+    OIIO_CHECK_EQUAL(C.maxerror, C1.maxerror);
+    OIIO_CHECK_EQUAL(C.maxx, C1.maxx);
+    OIIO_CHECK_EQUAL(C.maxy, C1.maxy);
+
+    // A single different pixel anywhere must be found
+    ImageBuf K(ImageSpec(1000, 1000, 3, TypeFloat));
+    ImageBufAlgo::fill(K, { 0.25f, 0.5f, 0.75f });
+    OIIO_CHECK_ASSERT(ImageBufAlgo::isConstantColor(K));
+    K.setpixel(999, 998, { 0.25f, 0.5f, 0.7f });
+    OIIO_CHECK_ASSERT(!ImageBufAlgo::isConstantColor(K));
+    OIIO_CHECK_ASSERT(!ImageBufAlgo::isConstantChannel(K, 2, 0.75f));
+    OIIO_CHECK_ASSERT(ImageBufAlgo::isConstantChannel(K, 1, 0.5f));
+
+    // Block hashes don't depend on the number of threads, and any changed
+    // pixel changes them
+    std::string h1 = ImageBufAlgo::computePixelHash(F, "", {}, 16, 1);
+    OIIO_CHECK_EQUAL(h1.size(), 32);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::computePixelHash(F, "", {}, 16, 8), h1);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::computePixelHashSHA1(F, "", {}, 16, 1),
+                     ImageBufAlgo::computePixelHashSHA1(F, "", {}, 16, 8));
+    OIIO_CHECK_NE(ImageBufAlgo::computePixelHash(F, "", {}, 0), h1);
+    OIIO_CHECK_NE(ImageBufAlgo::computePixelHash(F, "extra", {}, 16), h1);
+    OIIO_CHECK_NE(ImageBufAlgo::computePixelHash(K),
+                  ImageBufAlgo::computePixelHash(K, "", K.roi(), 0));
+    std::string hk = ImageBufAlgo::computePixelHash(K);
+    K.setpixel(999, 998, { 0.25f, 0.5f, 0.75f });
+    OIIO_CHECK_NE(ImageBufAlgo::computePixelHash(K), hk);
+}
+
+
+
+// Tests ImageBufAlgo::analyze against the functions it stands in for
+void
+test_analyze()
+{
+    std::cout << "test analyze\n";
+    ImageBuf A(ImageSpec(120, 80, 3, TypeHalf));
+    ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f, false, 5);
+    ImageBufAlgo::zero(A, ROI(0, 120, 0, 10));
+    ImageBufAlgo::zero(A, ROI(100, 120, 0, 80));
+    A.setpixel(50, 40, { 1.5f, -0.25f, 0.5f });
+    const float low[] = { 0.0f, 0.0f, 0.0f }, high[] = { 1.0f, 1.0f, 1.0f };
+    auto R = ImageBufAlgo::analyze(A, { ParamValue("low", TypeFloat, 3, low),
+                                        ParamValue("high", TypeFloat, 3,
+                                                   high) });
+    OIIO_CHECK_ASSERT(!R.error);
+    auto S = ImageBufAlgo::computePixelStats(A);
+    for (int c = 0; c < 3; ++c) {
+        OIIO_CHECK_EQUAL(R.stats.min[c], S.min[c]);
+        OIIO_CHECK_EQUAL(R.stats.max[c], S.max[c]);
+        OIIO_CHECK_EQUAL(R.stats.avg[c], S.avg[c]);
+    }
+    OIIO_CHECK_EQUAL(R.constant, ImageBufAlgo::isConstantColor(A));
+    OIIO_CHECK_EQUAL(R.monochrome, ImageBufAlgo::isMonochrome(A));
+    OIIO_CHECK_EQUAL(R.nonzero_region, ImageBufAlgo::nonzero_region(A));
+    imagesize_t lowcount, highcount, inrangecount;
+    ImageBufAlgo::color_range_check(A, &lowcount, &highcount, &inrangecount,
+                                    low, high);
+    OIIO_CHECK_EQUAL(R.lowcount, lowcount);
+    OIIO_CHECK_EQUAL(R.highcount, highcount);
+    OIIO_CHECK_EQUAL(R.inrangecount, inrangecount);
+
+    // Constant, monochrome, and all zero
+    ImageBuf Z(ImageSpec(64, 64, 3, TypeUInt8));
+    ImageBufAlgo::zero(Z);
+    R = ImageBufAlgo::analyze(Z, { { "stats", 0 } });
+    OIIO_CHECK_ASSERT(R.constant && R.monochrome);
+    OIIO_CHECK_EQUAL(R.constant_color.size(), 3);
+    OIIO_CHECK_EQUAL(R.nonzero_region, ImageBufAlgo::nonzero_region(Z));
+    OIIO_CHECK_EQUAL(R.nonzero_region.npixels(), 0);
+}
+
+
+
+// The scanline over/zover kernels and the multi-layer over must match the
+// pairwise, iterator-based results.
+void
+test_over_fastpaths()
+{
+    std::cout << "test over fast paths\n";
+    for (TypeDesc type : { TypeFloat, TypeHalf }) {
+        ImageBuf L[3];
+        for (int i = 0; i < 3; ++i) {
+            // Layers of different sizes, one partly outside the others
+            ImageSpec spec(97 - 20 * i, 61, 4, type);
+            spec.x = 5 * i;
+            spec.alpha_channel = 3;
+            L[i].reset(spec);
+            ImageBufAlgo::noise(L[i], "uniform", 0.0f, 1.0f, false, 11 + i);
+        }
+        ImageBuf R[2];
+        for (int fast = 0; fast < 2; ++fast) {
+            OIIO::attribute("imagebufalgo:fastpaths", fast);
+            R[fast] = ImageBufAlgo::over(L[0], L[1]);
+        }
+        OIIO_CHECK_EQUAL(ImageBufAlgo::compare(R[0], R[1], 0.0f, 0.0f).nfail,
+                         0);
+        // The whole stack at once, versus in float a pair at a time
+        ImageBuf M = ImageBufAlgo::over({ &L[0], &L[1], &L[2] });
+        ImageBuf L1 = L[1].copy(TypeFloat), L2 = L[2].copy(TypeFloat);
+        ImageBuf P = ImageBufAlgo::over(L[0], ImageBufAlgo::over(L1, L2));
+        OIIO_CHECK_EQUAL(M.roi(), P.roi());
+        OIIO_CHECK_EQUAL(ImageBufAlgo::compare(M, P, 0.0f, 0.0f).nfail, 0);
+    }
+
+    ImageSpec zspec(40, 30, 5, TypeFloat);
+    zspec.channelnames.assign({ "R", "G", "B", "A", "Z" });
+    zspec.alpha_channel = 3;
+    zspec.z_channel     = 4;
+    ImageBuf A(zspec), B(zspec);
+    ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f, false, 1);
+    ImageBufAlgo::noise(B, "uniform", 0.0f, 1.0f, false, 2);
+    ImageBufAlgo::zero(A, ROI(0, 10, 0, 10, 0, 1, 4, 5));  // z == 0
+    for (bool zeroisinf : { false, true }) {
+        ImageBuf R[2];
+        for (int fast = 0; fast < 2; ++fast) {
+            OIIO::attribute("imagebufalgo:fastpaths", fast);
+            R[fast] = ImageBufAlgo::zover(A, B, zeroisinf);
+        }
+        OIIO_CHECK_EQUAL(ImageBufAlgo::compare(R[0], R[1], 0.0f, 0.0f).nfail,
+                         0);
+    }
+    OIIO::attribute("imagebufalgo:fastpaths", 1);
+
+    Benchmarker bench;
+    bench.units(Benchmarker::Unit::ms);
+    bench.iterations(1);
+    ImageBuf layers[4];
+    for (int i = 0; i < 4; ++i) {
+        ImageSpec spec(2048, 1080, 4, TypeHalf);
+        spec.alpha_channel = 3;
+        layers[i].reset(spec);
+        ImageBufAlgo::noise(layers[i], "uniform", 0.0f, 1.0f, false, i);
+    }
+    bench("  IBA::over 4 half layers, pairwise", [&]() {
+        ImageBufAlgo::over(layers[0],
+                           ImageBufAlgo::over(layers[1],
+                                              ImageBufAlgo::over(layers[2],
+                                                                 layers[3])));
+    });
+    bench("  IBA::over 4 half layers, one pass", [&]() {
+        ImageBufAlgo::over({ &layers[0], &layers[1], &layers[2], &layers[3] });
+    });
+}
+
+
+
+// The row-based demosaicing should match the sliding window one, for every
+// layout of each pattern, with the image edges in any phase.
+static void
+test_demosaic_fastpaths()
+{
+    std::cout << "test demosaic fast paths\n";
+    ImageBuf rgb(ImageSpec(67, 45, 3, TypeFloat));
+    ImageBufAlgo::noise(rgb, "uniform", 0.0f, 1.0f, false, 3);
+    float wb[4] = { 2.0f, 1.1f, 1.5f, 0.9f };
+    struct Case {
+        const char* pattern;
+        const char* algorithm;
+        int size;
+    };
+    for (Case c : { Case { "bayer", "linear", 2 }, Case { "bayer", "MHC", 2 },
+                    Case { "xtrans", "linear", 6 } }) {
+        for (int y = 0; y < c.size; ++y) {
+            for (int x = 0; x < c.size; ++x) {
+                ImageBuf mosaiced(ImageSpec(67, 45, 1, TypeFloat));
+                std::string layout
+                    = ImageBufAlgo::mosaic_float(mosaiced, rgb, x, y,
+                                                 c.pattern, wb, 0);
+                ParamValue options[]
+                    = { ParamValue("pattern", c.pattern),
+                        ParamValue("algorithm", c.algorithm),
+                        ParamValue("layout", layout),
+                        ParamValue("white_balance", TypeFloat, 4, wb) };
+                // A sub-region too, which doesn't start on a whole pattern
+                ROI part(7, 60, 5, 41, 0, 1, 0, 3);
+                ImageBuf R[2], Rpart[2];
+                for (int fast = 0; fast < 2; ++fast) {
+                    OIIO::attribute("imagebufalgo:fastpaths", fast);
+                    R[fast] = ImageBufAlgo::demosaic(mosaiced, options);
+                    Rpart[fast] = ImageBufAlgo::demosaic(mosaiced, options,
+                                                         part);
+                }
+                OIIO_CHECK_ASSERT(!R[1].has_error());
+                auto cr = ImageBufAlgo::compare(R[0], R[1], 1.0e-5f, 1.0e-5f);
+                OIIO_CHECK_EQUAL(cr.nfail, 0);
+                cr = ImageBufAlgo::compare(Rpart[0], Rpart[1], 1.0e-5f,
+                                           1.0e-5f, part);
+                OIIO_CHECK_EQUAL(cr.nfail, 0);
+            }
+        }
+    }
+    OIIO::attribute("imagebufalgo:fastpaths", 1);
+
+    Benchmarker bench;
+    bench.units(Benchmarker::Unit::ms);
+    bench.iterations(1);
+    ImageBuf big(ImageSpec(2048, 1536, 3, TypeFloat));
+    ImageBufAlgo::noise(big, "uniform", 0.0f, 1.0f, false, 1);
+    for (Case c : { Case { "bayer", "linear", 2 }, Case { "bayer", "MHC", 2 },
+                    Case { "xtrans", "linear", 6 } }) {
+        ImageBuf mosaiced(ImageSpec(2048, 1536, 1, TypeUInt16));
+        ImageBufAlgo::mosaic_uint16(mosaiced, big, 0, 0, c.pattern, wb, 0);
+        ParamValue options[] = { ParamValue("pattern", c.pattern),
+                                 ParamValue("algorithm", c.algorithm) };
+        for (int fast = 0; fast < 2; ++fast) {
+            OIIO::attribute("imagebufalgo:fastpaths", fast);
+            bench(Strutil::fmt::format("  IBA::demosaic {} {} 2k uint16{}",
+                                       c.pattern, c.algorithm,
+                                       fast ? "" : " (window)"),
+                  [&]() { ImageBufAlgo::demosaic(mosaiced, options); });
+        }
+    }
+    OIIO::attribute("imagebufalgo:fastpaths", 1);
+}
+
+
+
+// The CUDA pixel math, when there is a device to run it, should match the
+// CPU's results.
+static void
+test_gpu_pixelmath()
+{
+#ifdef OIIO_CUDA_IBA_EXPERIMENTAL
+    if (!OIIO::attribute("gpu:device", "CUDA"))
+        return;
+    std::cout << "test gpu pixel math\n";
+    ImageSpec spec(203, 101, 4, TypeFloat);
+    spec.alpha_channel = 3;
+    ImageBuf A(spec), B(spec), C(spec);
+    ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f, false, 1);
+    ImageBufAlgo::noise(B, "uniform", -1.0f, 1.0f, false, 2);
+    ImageBufAlgo::noise(C, "uniform", 0.0f, 2.0f, false, 3);
+    const float k[] = { 0.5f, -2.0f, 3.0f, 1.0f };
+    ROI part(10, 150, 20, 90, 0, 1, 0, 4);
+    std::function<ImageBuf(ROI)> ops[] = {
+        [&](ROI roi) { return ImageBufAlgo::add(A, B, roi); },
+        [&](ROI roi) { return ImageBufAlgo::sub(A, k, roi); },
+        [&](ROI roi) { return ImageBufAlgo::mul(A, B, roi); },
+        [&](ROI roi) { return ImageBufAlgo::mad(A, B, C, roi); },
+        [&](ROI roi) { return ImageBufAlgo::mad(A, k, C, roi); },
+        [&](ROI roi) { return ImageBufAlgo::over(A, B, roi); },
+    };
+    for (auto& op : ops) {
+        for (ROI roi : { ROI(), part }) {
+            OIIO::attribute("gpu:device", "CUDA");
+            ImageBuf gpu = op(roi);
+            OIIO::attribute("gpu:device", "CPU");
+            ImageBuf cpu = op(roi);
+            OIIO_CHECK_EQUAL(ImageBufAlgo::compare(gpu, cpu, 0.0f, 0.0f).nfail,
+                             0);
+        }
+    }
+
+    // Chained operations leave their results on the device, until the
+    // host looks at them.
+    OIIO::attribute("gpu:device", "CUDA");
+    ImageBuf gsum = ImageBufAlgo::add(A, B);
+    OIIO_CHECK_EQUAL(gsum.storage(), ImageBuf::DEVICEBUFFER);
+    ImageBuf gprod = ImageBufAlgo::mul(gsum, k);
+    OIIO_CHECK_EQUAL(gsum.storage(), ImageBuf::DEVICEBUFFER);
+    OIIO_CHECK_EQUAL(gprod.storage(), ImageBuf::DEVICEBUFFER);
+    OIIO::attribute("gpu:device", "CPU");
+    ImageBuf cprod = ImageBufAlgo::mul(ImageBufAlgo::add(A, B), k);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compare(gprod, cprod, 0.0f, 0.0f).nfail, 0);
+    OIIO_CHECK_EQUAL(gprod.storage(), ImageBuf::LOCALBUFFER);
+    OIIO_CHECK_ASSERT(gsum.localpixels() != nullptr);
+    OIIO_CHECK_EQUAL(gsum.storage(), ImageBuf::LOCALBUFFER);
+    OIIO_CHECK_ASSERT(gsum.devicepixels() == nullptr);
+#endif
+}
+
+
+
+// A WarpPlan must compute what the warp it was made from would.
+void
+test_warp_plan()
+{
+    std::cout << "test warp plan\n";
+    ImageBuf src(ImageSpec(96, 64, 4, TypeFloat));
+    ImageBufAlgo::noise(src, "uniform", 0.0f, 1.0f, false, 11);
+    ImageBuf src8(ImageSpec(96, 64, 3, TypeUInt8));
+    ImageBufAlgo::noise(src8, "uniform", 0.0f, 1.0f, false, 12);
+    // Rotate, scale unevenly, and translate
+    Imath::M33f M(1.2f, 0.35f, 0.0f, -0.25f, 0.8f, 0.0f, 10.0f, -5.0f, 1.0f);
+    const ParamValue optionsets[][2] = {
+        { { "wrap", "black" }, { "recompute_roi", 1 } },
+        { { "wrap", "periodic" }, { "filtername", "gaussian" } },
+        { { "wrap", "clamp" }, { "edgeclamp", 1 } },
+    };
+    for (const ImageBuf* s : { &src, &src8 }) {
+        for (auto& options : optionsets) {
+            ImageBuf direct = ImageBufAlgo::warp(*s, M, options);
+            auto plan = ImageBufAlgo::make_warp_plan(s->spec(), M, options);
+            OIIO_CHECK_ASSERT(plan.initialized());
+            ImageBuf planned = ImageBufAlgo::warp(*s, plan);
+            OIIO_CHECK_EQUAL(planned.roi(), direct.roi());
+            float eps = s == &src8 ? 1.01f / 255.0f : 1.0e-5f;
+            OIIO_CHECK_EQUAL(
+                ImageBufAlgo::compare(planned, direct, eps, eps).nfail, 0);
+        }
+    }
+
+    // An ST map of a mild barrel distortion, over part of the output
+    ImageBuf st(ImageSpec(96, 64, 2, TypeFloat));
+    for (ImageBuf::Iterator<float> it(st); !it.done(); ++it) {
+        float s = (it.x() + 0.5f) / 96.0f - 0.5f;
+        float t = (it.y() + 0.5f) / 64.0f - 0.5f;
+        float k = 1.0f + 0.2f * (s * s + t * t);
+        it[0]   = 0.5f + s * k;
+        it[1]   = 0.5f + t * k;
+    }
+    for (ROI roi : { ROI(), ROI(8, 80, 4, 60) }) {
+        ImageBuf direct = ImageBufAlgo::st_warp(src, st, "lanczos3", 0.0f, 0,
+                                                1, false, true, roi);
+        auto plan = ImageBufAlgo::make_st_warp_plan(src.spec(), st,
+                                                    "lanczos3", 0.0f, 0, 1,
+                                                    false, true, roi);
+        ImageBuf planned = ImageBufAlgo::warp(src, plan);
+        OIIO_CHECK_EQUAL(planned.roi(), direct.roi());
+        OIIO_CHECK_EQUAL(planned.roi_full(), direct.roi_full());
+        OIIO_CHECK_EQUAL(
+            ImageBufAlgo::compare(planned, direct, 1.0e-5f, 1.0e-5f).nfail, 0);
+    }
+
+    // The plan is only good for a source of the same size.
+    ImageBuf other(ImageSpec(64, 64, 4, TypeFloat));
+    auto plan = ImageBufAlgo::make_st_warp_plan(src.spec(), st);
+    ImageBuf bad = ImageBufAlgo::warp(other, plan);
+    OIIO_CHECK_ASSERT(bad.has_error());
+    bad.geterror();
+
+    Benchmarker bench;
+    bench.units(Benchmarker::Unit::ms);
+    bench.iterations(1);
+    ImageBuf frame(ImageSpec(1024, 540, 3, TypeFloat));
+    ImageBufAlgo::noise(frame, "uniform", 0.0f, 1.0f);
+    ImageBuf bigst = ImageBufAlgo::resize(st, {}, ROI(0, 1024, 0, 540));
+    auto bigplan   = ImageBufAlgo::make_st_warp_plan(frame.spec(), bigst);
+    ImageBuf R;
+    bench("  IBA::st_warp 1K float (direct)", [&]() {
+        ImageBufAlgo::st_warp(R, frame, bigst);
+    });
+    bench("  IBA::st_warp 1K float (plan)  ", [&]() {
+        ImageBufAlgo::warp(R, frame, bigplan);
+    });
+}
+
+
+
+// The blocked transpose and rotations must move the same pixels as the
+// general ones, for each size of pixel and for sizes that aren't a whole
+// number of blocks.
+void
+test_orient_blocked()
+{
+    std::cout << "test blocked transpose/rotate\n";
+    const float tl[] = { 0.0f, 0.2f, 0.4f, 1.0f };
+    const float tr[] = { 1.5f, 0.0f, 0.5f, 0.5f };
+    const float bl[] = { 0.5f, 3.0f, 0.0f, 0.0f };
+    const float br[] = { 0.2f, 0.4f, 1.0f, 0.25f };
+    using OrientFunc = ImageBuf (*)(const ImageBuf&, ROI, int);
+    std::pair<const char*, OrientFunc> ops[] = {
+        { "transpose", ImageBufAlgo::transpose },
+        { "rotate90", ImageBufAlgo::rotate90 },
+        { "rotate270", ImageBufAlgo::rotate270 },
+    };
+    for (TypeDesc type : { TypeUInt8, TypeHalf, TypeFloat }) {
+        for (int nc : { 1, 3, 4 }) {
+            ImageSpec spec(75, 37, nc, type);
+            spec.x = 3;
+            spec.y = -2;
+            ImageBuf A(spec);
+            ImageBufAlgo::fill(A, cspan<float>(tl, nc), cspan<float>(tr, nc),
+                               cspan<float>(bl, nc), cspan<float>(br, nc));
+            for (auto& op : ops) {
+                OIIO::attribute("imagebufalgo:fastpaths", 0);
+                ImageBuf general = op.second(A, {}, 0);
+                OIIO::attribute("imagebufalgo:fastpaths", 1);
+                ImageBuf fast = op.second(A, {}, 0);
+                OIIO_CHECK_EQUAL(fast.roi(), general.roi());
+                OIIO_CHECK_EQUAL(fast.roi_full(), general.roi_full());
+                auto comp = ImageBufAlgo::compare(fast, general, 0.0f, 0.0f);
+                if (comp.nfail)
+                    std::cout << "  " << op.first << " " << type << " " << nc
+                              << " channels differs\n";
+                OIIO_CHECK_EQUAL(comp.nfail, 0);
+            }
+        }
+    }
+
+    Benchmarker bench;
+    bench.units(Benchmarker::Unit::ms);
+    bench.iterations(1);
+    bench.trials(3);
+    for (TypeDesc type : { TypeUInt8, TypeFloat }) {
+        ImageBuf big(ImageSpec(4096, 3072, 4, type));
+        ImageBufAlgo::fill(big, tl, tr, bl, br);
+        for (int fast : { 0, 1 }) {
+            OIIO::attribute("imagebufalgo:fastpaths", fast);
+            bench(Strutil::fmt::format("  rotate90 4096x3072 RGBA {} {}", type,
+                                       fast ? "blocked" : "general"),
+                  [&]() { ImageBuf R = ImageBufAlgo::rotate90(big); });
+        }
+    }
+    OIIO::attribute("imagebufalgo:fastpaths", 1);
+}
+
+
+
+// Operations with dst the same as a source: pixelwise ones and mirroring
+// write over the source pixels in place, and others give the same result
+// as into a separate image.
+// Brute force average of the pixels of A in [xb,xe) x [yb,ye), clipped.
+static void
+box_average(const ImageBuf& A, int xb, int xe, int yb, int ye, float* avg)
+{
+    int nc = A.nchannels(), n = 0;
+    std::vector<float> p(nc);
+    std::fill(avg, avg + nc, 0.0f);
+    for (int y = std::max(yb, A.ybegin()); y < std::min(ye, A.yend()); ++y)
+        for (int x = std::max(xb, A.xbegin()); x < std::min(xe, A.xend());
+             ++x, ++n) {
+            A.getpixel(x, y, p);
+            for (int c = 0; c < nc; ++c)
+                avg[c] += p[c];
+        }
+    for (int c = 0; c < nc; ++c)
+        avg[c] /= std::max(n, 1);
+}
+
+
+
+static void
+test_summed_area_table()
+{
+    std::cout << "test summed_area_table, box_filter\n";
+    ImageSpec spec(41, 23, 2, TypeFloat);
+    spec.x = 3;
+    spec.y = -2;
+    ImageBuf A(spec);
+    ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f);
+
+    ImageBuf sat = ImageBufAlgo::summed_area_table(A);
+    OIIO_CHECK_ASSERT(!sat.has_error());
+    OIIO_CHECK_EQUAL(sat.spec().format, TypeDesc::DOUBLE);
+    OIIO_CHECK_EQUAL(sat.roi(), A.roi());
+    double sum[2];
+    float avg[2];
+    OIIO_CHECK_EQUAL(ImageBufAlgo::summed_area_sum(sat, 5, 12, 0, 9, sum),
+                     7 * 9);
+    box_average(A, 5, 12, 0, 9, avg);
+    OIIO_CHECK_EQUAL_THRESH(sum[1] / (7 * 9), avg[1], 1e-5);
+    // Clipped to the image, and empty
+    OIIO_CHECK_EQUAL(ImageBufAlgo::summed_area_sum(sat, 0, 5, -9, 1, sum),
+                     2 * 3);
+    box_average(A, 0, 5, -9, 1, avg);
+    OIIO_CHECK_EQUAL_THRESH(sum[0] / 6, avg[0], 1e-5);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::summed_area_sum(sat, 60, 70, 0, 9, sum), 0);
+    OIIO_CHECK_EQUAL(sum[0], 0.0);
+
+    // Fixed size box filter, compared with brute force at every pixel
+    ImageBuf B = ImageBufAlgo::box_filter(A, 5, 3);
+    OIIO_CHECK_EQUAL(B.roi(), A.roi());
+    int nfail = 0;
+    for (ImageBuf::ConstIterator<float> b(B); !b.done(); ++b) {
+        box_average(A, b.x() - 2, b.x() + 3, b.y() - 1, b.y() + 2, avg);
+        nfail += fabsf(b[0] - avg[0]) > 1e-5f || fabsf(b[1] - avg[1]) > 1e-5f;
+    }
+    OIIO_CHECK_EQUAL(nfail, 0);
+
+    // Variable radius: 0 is the source, 2 is a 5x5 box, and 1.5 is halfway
+    // between the 3x3 and 5x5 boxes.
+    ImageBuf R(ImageSpec(spec.width, spec.height, 1, TypeFloat));
+    R.set_origin(spec.x, spec.y);
+    ImageBuf V;
+    ImageBufAlgo::zero(R);
+    ImageBufAlgo::box_filter(V, A, R);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compare(V, A, 0.0f, 0.0f).nfail, 0);
+    ImageBufAlgo::fill(R, { 2.0f });
+    ImageBufAlgo::box_filter(V, A, R);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compare(V, ImageBufAlgo::box_filter(A, 5),
+                                           1e-5f, 1e-5f)
+                         .nfail,
+                     0);
+    ImageBufAlgo::fill(R, { 1.5f });
+    ImageBufAlgo::box_filter(V, A, R);
+    ImageBuf box3 = ImageBufAlgo::box_filter(A, 3);
+    ImageBuf box5 = ImageBufAlgo::box_filter(A, 5);
+    ImageBuf mid  = ImageBufAlgo::mul(ImageBufAlgo::add(box3, box5), 0.5f);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compare(V, mid, 1e-5f, 1e-5f).nfail, 0);
+}
+
+
+
+static void
+test_envlatl_cdf()
+{
+    std::cout << "test envlatl_cdf\n";
+    // A constant map: each row's CDF is linear, and the marginal follows
+    // the solid angle, which from the pole to the equator is half.
+    ImageBuf A(ImageSpec(64, 32, 3, TypeFloat));
+    ImageBufAlgo::fill(A, { 0.5f, 0.5f, 0.5f });
+    ImageBuf marginal, conditional;
+    OIIO_CHECK_ASSERT(ImageBufAlgo::envlatl_cdf(marginal, conditional, A));
+    OIIO_CHECK_EQUAL(marginal.spec().width, 33);
+    OIIO_CHECK_EQUAL(conditional.spec().width, 65);
+    OIIO_CHECK_EQUAL(conditional.spec().height, 32);
+    OIIO_CHECK_EQUAL(marginal.getchannel(0, 0, 0, 0), 0.0f);
+    OIIO_CHECK_EQUAL_THRESH(marginal.getchannel(16, 0, 0, 0), 0.5f, 1e-5f);
+    OIIO_CHECK_EQUAL(marginal.getchannel(32, 0, 0, 0), 1.0f);
+    OIIO_CHECK_ASSERT(marginal.getchannel(1, 0, 0, 0)
+                      < marginal.getchannel(16, 0, 0, 0)
+                            - marginal.getchannel(15, 0, 0, 0));
+    OIIO_CHECK_EQUAL_THRESH(conditional.getchannel(16, 7, 0, 0), 0.25f, 1e-5f);
+
+    // One bright pixel (and a NaN, which counts as black) at half the
+    // resolution: all the probability is in its row and column.
+    A.setpixel(10, 20, { 1000.0f, 1000.0f, 1000.0f });
+    A.setpixel(40, 3, { std::numeric_limits<float>::quiet_NaN(), 0.0f, 0.0f });
+    OIIO_CHECK_ASSERT(
+        ImageBufAlgo::envlatl_cdf(marginal, conditional, A, 32, 16));
+    OIIO_CHECK_EQUAL(marginal.spec().width, 17);
+    float rowp = marginal.getchannel(11, 0, 0, 0)
+                 - marginal.getchannel(10, 0, 0, 0);
+    OIIO_CHECK_ASSERT(rowp > 0.1f);
+    OIIO_CHECK_ASSERT(conditional.getchannel(6, 10, 0, 0)
+                          - conditional.getchannel(5, 10, 0, 0)
+                      > 0.5f);
+    OIIO_CHECK_EQUAL(conditional.getchannel(32, 1, 0, 0), 1.0f);
+}
+
+
+
+// The pixel math on half images, which may be computed directly in half,
+// must match computing in float (up to the rounding of the result).
+static void
+test_half_arithmetic()
+{
+    std::cout << "test half arithmetic\n";
+    ImageSpec spec(37, 5, 4, TypeFloat);
+    spec.alpha_channel = 3;
+    ImageBuf Af(spec), Bf(spec), Cf(spec);
+    ImageBufAlgo::noise(Af, "uniform", -2.0f, 2.0f);
+    ImageBufAlgo::noise(Bf, "uniform", 0.0f, 1.0f, false, 1);
+    ImageBufAlgo::noise(Cf, "uniform", -1.0f, 1.0f, false, 2);
+    ImageBuf A(Af.copy(TypeHalf)), B(Bf.copy(TypeHalf)), C(Cf.copy(TypeHalf));
+    Af = A.copy(TypeFloat);  // the exact values of the half images
+    Bf = B.copy(TypeFloat);
+    Cf = C.copy(TypeFloat);
+    const float k[] = { 0.5f, -1.25f, 3.0f, 0.125f };
+    auto check = [](const ImageBuf& R, const ImageBuf& expected) {
+        OIIO_CHECK_EQUAL(R.spec().format, TypeHalf);
+        auto cmp = ImageBufAlgo::compare(R, expected.copy(TypeHalf), 1e-2f,
+                                         1e-2f);
+        OIIO_CHECK_EQUAL(cmp.nfail, 0);
+    };
+    check(ImageBufAlgo::add(A, B), ImageBufAlgo::add(Af, Bf));
+    check(ImageBufAlgo::add(A, k), ImageBufAlgo::add(Af, k));
+    check(ImageBufAlgo::sub(A, B), ImageBufAlgo::sub(Af, Bf));
+    check(ImageBufAlgo::mul(A, B), ImageBufAlgo::mul(Af, Bf));
+    check(ImageBufAlgo::mul(A, k), ImageBufAlgo::mul(Af, k));
+    check(ImageBufAlgo::mad(A, B, C), ImageBufAlgo::mad(Af, Bf, Cf));
+    check(ImageBufAlgo::mad(A, k, C), ImageBufAlgo::mad(Af, k, Cf));
+    check(ImageBufAlgo::mad(A, B, k), ImageBufAlgo::mad(Af, Bf, k));
+    check(ImageBufAlgo::clamp(A, -0.3f, 0.7f, true),
+          ImageBufAlgo::clamp(Af, -0.3f, 0.7f, true));
+    check(ImageBufAlgo::clamp(A, { -1.0f, 0.0f, 0.1f, 1.5f },
+                              { 1.0f, 2.0f, 0.2f, 3.0f }, true),
+          ImageBufAlgo::clamp(Af, { -1.0f, 0.0f, 0.1f, 1.5f },
+                              { 1.0f, 2.0f, 0.2f, 3.0f }, true));
+    check(ImageBufAlgo::premult(B), ImageBufAlgo::premult(Bf));
+    // In place
+    ImageBuf D = A.copy(TypeHalf);
+    ImageBufAlgo::mul(D, D, B);
+    check(D, ImageBufAlgo::mul(Af, Bf));
+}
+
+
+
+// color_map and .cube LUTs through the LUT engine, including the tables
+// for uint8 sources, must match computing them the slow way.
+static void
+test_color_lut()
+{
+    std::cout << "test color LUTs\n";
+    ImageBuf A(ImageSpec(64, 32, 4, TypeFloat));
+    ImageBufAlgo::noise(A, "uniform", -0.1f, 1.1f);
+    ImageBuf A8 = A.copy(TypeUInt8);
+    for (const ImageBuf* src : { &A, &A8 }) {
+        for (int srcchannel : { -1, 1 }) {
+            ImageBuf fast = ImageBufAlgo::color_map(*src, srcchannel,
+                                                    "inferno");
+            OIIO::attribute("imagebufalgo:fastpaths", 0);
+            ImageBuf slow = ImageBufAlgo::color_map(*src, srcchannel,
+                                                    "inferno");
+            OIIO::attribute("imagebufalgo:fastpaths", 1);
+            auto cmp = ImageBufAlgo::compare(fast, slow, 1e-6f, 1e-6f);
+            OIIO_CHECK_EQUAL(cmp.nfail, 0);
+        }
+    }
+
+    // A 3D LUT of a linear transform, which tetrahedral interpolation
+    // reproduces exactly: (r, g, b) -> (g/2, b, r).
+    std::string cube = "TITLE \"swizzle\"\n# comment\nLUT_3D_SIZE 3\n";
+    for (int b = 0; b < 3; ++b)
+        for (int g = 0; g < 3; ++g)
+            for (int r = 0; r < 3; ++r)
+                cube += Strutil::fmt::format("{} {} {}\n", 0.25f * g,
+                                             0.5f * b, 0.5f * r);
+    Filesystem::write_text_file("test_color_lut.cube", cube);
+    for (const ImageBuf* src : { &A, &A8 }) {
+        ImageBuf R = ImageBufAlgo::ociofiletransform(*src,
+                                                     "test_color_lut.cube",
+                                                     false);
+        const int order[] = { 1, 2, 0, 3 };
+        const float mul[] = { 0.5f, 1.0f, 1.0f, 1.0f };
+        const float lo[]  = { 0.0f, 0.0f, 0.0f, -1.0f };
+        const float hi[]  = { 1.0f, 1.0f, 1.0f, 2.0f };  // alpha unchanged
+        ImageBuf clamped  = ImageBufAlgo::clamp(*src, lo, hi);
+        ImageBuf expected = ImageBufAlgo::mul(
+            ImageBufAlgo::channels(clamped, 4, order), mul);
+        // (Rounding to uint8 may go either way for exact halves.)
+        auto cmp = ImageBufAlgo::compare(R, expected, 1.01f / 255.0f, 1.0f);
+        OIIO_CHECK_EQUAL(cmp.nfail, 0);
+    }
+    Filesystem::remove("test_color_lut.cube");
+}
+
+
+
+static void
+test_in_place()
+{
+    std::cout << "test in-place operations\n";
+    const float tl[] = { 0.0f, 0.2f, 0.4f };
+    const float tr[] = { 1.5f, 0.0f, 0.5f };
+    const float bl[] = { 0.5f, 3.0f, 0.0f };
+    const float br[] = { 0.2f, 0.4f, 1.0f };
+    ImageSpec spec(37, 21, 3, TypeFloat);
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, tl, tr, bl, br);
+
+    ImageBuf B       = A.copy(TypeUnknown);
+    const void* orig = B.localpixels();
+    ImageBufAlgo::mul(B, B, 2.0f);
+    OIIO_CHECK_EQUAL(B.localpixels(), orig);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compare(B, ImageBufAlgo::mul(A, 2.0f), 0.0f,
+                                           0.0f)
+                         .nfail,
+                     0);
+
+    using OrientFunc = bool (*)(ImageBuf&, const ImageBuf&, ROI, int);
+    for (OrientFunc op : { OrientFunc(ImageBufAlgo::flip),
+                           OrientFunc(ImageBufAlgo::flop),
+                           OrientFunc(ImageBufAlgo::rotate180) }) {
+        ImageBuf expected;
+        op(expected, A, {}, 0);
+        ImageBuf Bcopy = A.copy(TypeUnknown);
+        orig           = Bcopy.localpixels();
+        op(Bcopy, Bcopy, {}, 0);
+        OIIO_CHECK_EQUAL(Bcopy.localpixels(), orig);
+        OIIO_CHECK_EQUAL(
+            ImageBufAlgo::compare(Bcopy, expected, 0.0f, 0.0f).nfail, 0);
+    }
+
+    ImageBuf K      = ImageBufAlgo::make_kernel("gaussian", 5, 5);
+    ImageBuf blurry = ImageBufAlgo::convolve(A, K);
+    B               = A.copy(TypeUnknown);
+    ImageBufAlgo::convolve(B, B, K);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compare(B, blurry, 0.0f, 0.0f).nfail, 0);
+
+    ImageBuf rotated;
+    rotated.reset(spec);
+    ImageBufAlgo::rotate(rotated, A, 0.5f);
+    B = A.copy(TypeUnknown);
+    ImageBufAlgo::rotate(B, B, 0.5f);
+    OIIO_CHECK_EQUAL(ImageBufAlgo::compare(B, rotated, 0.0f, 0.0f).nfail, 0);
+
+    ROI cropped(5, 20, 3, 12);
+    B = A.copy(TypeUnknown);
+    OIIO_CHECK_ASSERT(ImageBufAlgo::crop(B, B, cropped));
+    OIIO_CHECK_EQUAL(B.roi(), ImageBufAlgo::crop(A, cropped).roi());
+}
+
+
+
 int
 main(int argc, char** argv)
 {
@@ -1552,10 +2725,30 @@ main(int argc, char** argv)
     test_validate_st_warp_checks();
     test_opencv();
     test_color_management();
+    test_colorconvert_tables();
     test_yee();
+    test_noise();
     test_demosaic();
     test_simple_perpixel<float>();
     test_simple_perpixel<half>();
+    test_lazy();
+    test_process_tiles();
+    test_pixelmath_fastpaths();
+    test_convolve();
+    test_big_window_filters();
+    test_resize_separable();
+    test_parallel_reductions();
+    test_analyze();
+    test_over_fastpaths();
+    test_demosaic_fastpaths();
+    test_gpu_pixelmath();
+    test_warp_plan();
+    test_orient_blocked();
+    test_in_place();
+    test_summed_area_table();
+    test_envlatl_cdf();
+    test_half_arithmetic();
+    test_color_lut();
 
     benchmark_parallel_image(64, iterations * 64);
     benchmark_parallel_image(512, iterations * 16);
@@ -0,0 +1,142 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+/// \file
+/// Implementation of ImageBufAlgo::process_tiles, which computes an image
+/// a row of tiles at a time, for images too big to hold in memory.
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
+
+#include "imageio_pvt.h"
+
+
+OIIO_NAMESPACE_BEGIN
+
+
+// Make a local copy of the region `roi` of `src`.
+static bool
+copy_region(ImageBuf& dst, const ImageBuf& src, ROI roi)
+{
+    ImageSpec spec = src.spec();
+    spec.set_roi(roi);
+    spec.tile_width = spec.tile_height = spec.tile_depth = 0;
+    dst.reset(spec);
+    roi.chbegin = 0;
+    roi.chend   = spec.nchannels;
+    // Reading from an ImageCache, get_pixels copies whole tiles at a time.
+    // (dst's scanlines may be padded, so use its strides.)
+    return src.get_pixels(roi, spec.format,
+                          span<std::byte>((std::byte*)dst.localpixels(),
+                                          size_t(dst.z_stride())),
+                          dst.localpixels(), dst.pixel_stride(),
+                          dst.scanline_stride(), dst.z_stride());
+}
+
+
+
+bool
+ImageBufAlgo::process_tiles(
+    string_view outputfilename, const ImageSpec& spec_,
+    cspan<const ImageBuf*> srcs, int halo,
+    function_view<bool(ImageBuf& dst, cspan<const ImageBuf*> srcs, ROI roi)>
+        func,
+    int nthreads)
+{
+    using OIIO::errorfmt;
+    pvt::LoggedTimer logtime("IBA::process_tiles");
+    if (spec_.deep || spec_.depth > 1) {
+        errorfmt("process_tiles: deep and volume images are not supported");
+        return false;
+    }
+    for (const ImageBuf* src : srcs) {
+        if (!src || !src->initialized() || src->deep()) {
+            errorfmt("process_tiles: sources must be initialized flat images");
+            return false;
+        }
+    }
+    auto out = ImageOutput::create(outputfilename);
+    if (!out)
+        return false;  // error already set by create()
+    ImageSpec spec = spec_;
+    if (!out->supports("tiles"))
+        spec.tile_width = spec.tile_height = spec.tile_depth = 0;
+    const bool tiled = spec.tile_width > 0 && spec.tile_height > 0;
+    if (tiled)
+        spec.tile_depth = 1;
+    if (!out->open(outputfilename, spec)) {
+        errorfmt("Could not open \"{}\" : {}", outputfilename,
+                 out->geterror());
+        return false;
+    }
+
+    // Scanline output is computed in pieces this size, for parallelism.
+    const int stripheight = tiled ? spec.tile_height : 64;
+    const int tilewidth   = tiled ? spec.tile_width : 256;
+    const int ntiles      = (spec.width + tilewidth - 1) / tilewidth;
+    ImageSpec stripspec   = spec;
+    stripspec.tile_width = stripspec.tile_height = stripspec.tile_depth = 0;
+    const int yend = spec.y + spec.height;
+    const int xend = spec.x + spec.width;
+    bool ok        = true;
+    for (int y = spec.y; y < yend && ok; y += stripheight) {
+        stripspec.y      = y;
+        stripspec.height = std::min(stripheight, yend - y);
+        ImageBuf strip(stripspec);
+        std::atomic<bool> strip_ok(true);
+        parallel_for(
+            0, ntiles,
+            [&](int t) {
+                ROI roi(spec.x + t * tilewidth,
+                        std::min(spec.x + (t + 1) * tilewidth, xend), y,
+                        y + stripspec.height, spec.z, spec.z + 1, 0,
+                        spec.nchannels);
+                ROI haloroi(roi.xbegin - halo, roi.xend + halo,
+                            roi.ybegin - halo, roi.yend + halo, roi.zbegin,
+                            roi.zend);
+                std::vector<ImageBuf> local(srcs.size());
+                std::vector<const ImageBuf*> localptrs(srcs.size());
+                for (size_t i = 0; i < srcs.size(); ++i) {
+                    if (!copy_region(local[i], *srcs[i], haloroi)) {
+                        strip.errorfmt("{}", srcs[i]->geterror());
+                        strip_ok = false;
+                        return;
+                    }
+                    localptrs[i] = &local[i];
+                }
+                if (!func(strip, localptrs, roi))
+                    strip_ok = false;
+            },
+            paropt(nthreads));
+        if (!strip_ok) {
+            errorfmt("process_tiles: {}", strip.has_error()
+                                              ? strip.geterror()
+                                              : std::string("failed"));
+            ok = false;
+            break;
+        }
+        const void* pixels = strip.localpixels();
+        ok = tiled ? out->write_tiles(spec.x, xend, y, y + stripspec.height,
+                                      spec.z, spec.z + 1, spec.format, pixels)
+                   : out->write_scanlines(y, y + stripspec.height, spec.z,
+                                          spec.format, pixels);
+        if (!ok)
+            errorfmt("{}", out->geterror());
+    }
+    if (!out->close() && ok) {
+        errorfmt("{}", out->geterror());
+        ok = false;
+    }
+    return ok;
+}
+
+
+OIIO_NAMESPACE_END
@@ -6,8 +6,11 @@
 /// ImageBufAlgo functions for filtered transformations
 
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
+#include <type_traits>
+#include <vector>
 
 #include <OpenImageIO/Imath.h>
 
@@ -17,6 +20,7 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/simd.h>
 #include <OpenImageIO/thread.h>
 
 #include <Imath/ImathBox.h>
@@ -254,11 +258,14 @@ transform(const Imath::M33f& M, ROI roi)
 
 // Given s,t image space coordinates and their derivatives, compute a
 // filtered sample using the derivatives to guide the size of the filter
-// footprint.
+// footprint. If the filter is separable, xtab and ytab are tables of its
+// horizontal and vertical 1D forms, which are used in place of calling the
+// filter for each of the footprint's pixels.
 template<typename SRCTYPE>
 inline void
 filtered_sample(const ImageBuf& src, float s, float t, float dsdx, float dtdx,
                 float dsdy, float dtdy, const Filter2D* filter,
+                const FilterTable1D* xtab, const FilterTable1D* ytab,
                 ImageBuf::WrapMode wrap, bool edgeclamp, float* result)
 {
     OIIO_DASSERT(filter);
@@ -302,9 +309,27 @@ filtered_sample(const ImageBuf& src, float s, float t, float dsdx, float dtdx,
     float* sum = OIIO_ALLOCA(float, nc);
     memset(sum, 0, nc * sizeof(float));
     float total_w = 0.0f;
+    float* xw     = nullptr;
+    float yw      = 0.0f;
+    int yw_row    = tmin - 1;
+    if (xtab && ytab) {
+        // Look up the weights of the footprint's columns just once
+        xw = OIIO_ALLOCA(float, std::max(smax - smin, 1));
+        for (int x = smin; x < smax; ++x)
+            xw[x - smin] = (*xtab)(ds_inv * (x + 0.5f - s));
+    }
     for (; !samp.done(); ++samp) {
-        float w = (*filter)(ds_inv * (samp.x() + 0.5f - s),
-                            dt_inv * (samp.y() + 0.5f - t));
+        float w;
+        if (xw) {
+            if (samp.y() != yw_row) {
+                yw_row = samp.y();
+                yw     = (*ytab)(dt_inv * (yw_row + 0.5f - t));
+            }
+            w = xw[samp.x() - smin] * yw;
+        } else {
+            w = (*filter)(ds_inv * (samp.x() + 0.5f - s),
+                          dt_inv * (samp.y() + 0.5f - t));
+        }
         for (int c = 0; c < nc; ++c)
             sum[c] += w * samp[c];
         total_w += w;
@@ -351,6 +376,12 @@ warp_(ImageBuf& dst, const ImageBuf& src, const Imath::M33f& M,
       const Filter2D* filter, ImageBuf::WrapMode wrap, bool edgeclamp, ROI roi,
       int nthreads)
 {
+    // Separable filters are evaluated from tables of their 1D forms
+    std::unique_ptr<FilterTable1D> xtab, ytab;
+    if (filter->separable()) {
+        xtab.reset(new FilterTable1D(*filter, false));
+        ytab.reset(new FilterTable1D(*filter, true));
+    }
     ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
         int nc     = dst.nchannels();
         float* pel = OIIO_ALLOCA(float, nc);
@@ -362,8 +393,8 @@ warp_(ImageBuf& dst, const ImageBuf& src, const Imath::M33f& M,
             Dual2 y(out.y() + 0.5f, 0.0f, 1.0f);
             robust_multVecMatrix(Minv, x, y, x, y);
             filtered_sample<SRCTYPE>(src, x.val(), y.val(), x.dx(), y.dx(),
-                                     x.dy(), y.dy(), filter, wrap, edgeclamp,
-                                     pel);
+                                     x.dy(), y.dy(), filter, xtab.get(),
+                                     ytab.get(), wrap, edgeclamp, pel);
             for (int c = roi.chbegin; c < roi.chend; ++c)
                 out[c] = pel[c];
         }
@@ -378,6 +409,14 @@ warp_impl(ImageBuf& dst, const ImageBuf& src, const Imath::M33f& M,
           const Filter2D* filter, bool recompute_roi, ImageBuf::WrapMode wrap,
           bool edgeclamp, ROI roi, int nthreads)
 {
+    if (&dst == &src) {
+        // Handle in-place operation: read from a copy-on-write share of
+        // src, so that the pixels are copied once as dst is first written,
+        // rather than overwritten before they're read.
+        ImageBuf srcshare(src);
+        return warp_impl(dst, srcshare, M, filter, recompute_roi, wrap,
+                         edgeclamp, roi, nthreads);
+    }
     pvt::LoggedTimer logtime("IBA::warp");
     ROI src_roi_full = src.roi_full();
     ROI dst_roi, dst_roi_full;
@@ -461,40 +500,63 @@ get_filterptr_option(ImageBufAlgo::KWArgs options)
 
 
 
-bool
-ImageBufAlgo::warp(ImageBuf& dst, const ImageBuf& src, M33fParam M,
-                   KWArgs options, ROI roi, int nthreads)
+// The options of warp(), and the filter they ask for.
+struct WarpOptions {
+    Filter2D::ref filter;
+    ImageBuf::WrapMode wrap = ImageBuf::WrapMode::WrapDefault;
+    bool recompute_roi      = false;
+    bool edgeclamp          = false;
+};
+
+
+
+// Decode the warp() options, returning false (with an error in `dst`) if
+// the filter can't be made.
+static bool
+get_warp_options(ImageBufAlgo::KWArgs options, WarpOptions& opt,
+                 ImageBuf& dst)
 {
     static const ustring recognized[] = { filtername_us,    filterwidth_us,
                                           wrap_us,          edgeclamp_us,
                                           recompute_roi_us, filterptr_us };
     IBA_check_optional(options, recognized);
 
-    Filter2D::ref filterptr = get_filterptr_option(options);
-    if (!filterptr) {
-        filterptr = get_warp_filter(options.get_string(filtername_us),
-                                    options.get_float(filterwidth_us), dst);
-        if (!filterptr)
+    opt.filter = get_filterptr_option(options);
+    if (!opt.filter) {
+        opt.filter = get_warp_filter(options.get_string(filtername_us),
+                                     options.get_float(filterwidth_us), dst);
+        if (!opt.filter)
             return false;  // error issued in get_warp_filter
     }
-    if (!filterptr) {
+    if (!opt.filter) {
         dst.errorfmt("Invalid filter");
         return false;
     }
 
-    ImageBuf::WrapMode wrap = ImageBuf::WrapMode::WrapDefault;
-    auto wrapparam          = options.find(wrap_us);
+    auto wrapparam = options.find(wrap_us);
     if (wrapparam != options.end()) {
         if (wrapparam->type() == TypeString)
-            wrap = ImageBuf::WrapMode_from_string(wrapparam->get_ustring());
+            opt.wrap = ImageBuf::WrapMode_from_string(
+                wrapparam->get_ustring());
         else
-            wrap = (ImageBuf::WrapMode)wrapparam->get_int();
+            opt.wrap = (ImageBuf::WrapMode)wrapparam->get_int();
     }
-    bool recompute_roi = options.get_int(recompute_roi_us, 0);
-    bool edgeclamp     = options.get_int(edgeclamp_us, 0);
+    opt.recompute_roi = options.get_int(recompute_roi_us, 0);
+    opt.edgeclamp     = options.get_int(edgeclamp_us, 0);
+    return true;
+}
+
 
-    return warp_impl(dst, src, M, filterptr.get(), recompute_roi, wrap,
-                     edgeclamp, roi, nthreads);
+
+bool
+ImageBufAlgo::warp(ImageBuf& dst, const ImageBuf& src, M33fParam M,
+                   KWArgs options, ROI roi, int nthreads)
+{
+    WarpOptions opt;
+    if (!get_warp_options(options, opt, dst))
+        return false;
+    return warp_impl(dst, src, M, opt.filter.get(), opt.recompute_roi,
+                     opt.wrap, opt.edgeclamp, roi, nthreads);
 }
 
 
@@ -592,7 +654,9 @@ static bool
 resize_(ImageBuf& dst, const ImageBuf& src, const Filter2D* filter, ROI roi,
         int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+    // Tiles, rather than bands, keep the filter footprints in cache
+    paropt opt(nthreads, paropt::SplitDir::Tile);
+    ImageBufAlgo::parallel_image(roi, opt, [&](ROI roi) {
         const ImageSpec& srcspec(src.spec());
         const ImageSpec& dstspec(dst.spec());
         int nchannels = dstspec.nchannels;
@@ -822,6 +886,186 @@ resize_(ImageBuf& dst, const ImageBuf& src, const Filter2D* filter, ROI roi,
 
 
 
+// Polyphase weights of a separable resize filter along one axis,
+// computed once for all of the output: output coordinate `first + o`
+// is the sum over i < taps of weight[o * taps + i] times source
+// coordinate index[o * taps + i], which is already clamped to the data
+// window. They are the same weights resize_() uses, normalized, or all
+// zero if they sum to zero. For integer reduction ratios (2:1, 4:1, ...)
+// aligned with the pixel grid, every output has the same weights, and
+// `uniform` is true.
+struct ResizeTaps {
+    int first    = 0;
+    int taps     = 0;
+    bool uniform = false;
+    std::vector<int> index;
+    std::vector<float> weight;
+};
+
+static void
+resize_taps(ResizeTaps& t, const Filter2D* filter, bool xaxis, int begin,
+            int end, float dstorigin, float dstsize, float srcorigin,
+            float srcsize, int srcbegin, int srcend)
+{
+    const float ratio     = dstsize / srcsize;
+    const float pixelsize = 1.0f / dstsize;
+    const float filterrad = filter->width() / 2.0f;
+    const int rad         = (int)ceilf(filterrad / ratio);
+    t.first               = begin;
+    t.taps                = 2 * rad + 1;
+    t.index.resize(size_t(end - begin) * t.taps);
+    t.weight.resize(t.index.size());
+    for (int d = begin; d < end; ++d) {
+        int* index    = &t.index[size_t(d - begin) * t.taps];
+        float* weight = &t.weight[size_t(d - begin) * t.taps];
+        float s       = (d - dstorigin + 0.5f) * pixelsize;
+        int src;
+        float frac  = floorfrac(srcorigin + s * srcsize, &src);
+        float total = 0.0f;
+        for (int i = 0; i < t.taps; ++i) {
+            float x   = ratio * (i - rad - (frac - 0.5f));
+            weight[i] = xaxis ? filter->xfilt(x) : filter->yfilt(x);
+            total += weight[i];
+            index[i] = OIIO::clamp(src - rad + i, srcbegin, srcend - 1);
+        }
+        for (int i = 0; i < t.taps; ++i)
+            weight[i] = total != 0.0f ? weight[i] / total : 0.0f;
+    }
+
+    // Drop the first and last taps while they have zero weight for every
+    // output, as the outermost often do when the ratio is an integer
+    // (a box filter halving the size needs only 2 of its 3 taps).
+    const size_t n = size_t(end - begin);
+    auto zero_tap  = [&](int i) {
+        for (size_t o = 0; o < n; ++o)
+            if (t.weight[o * t.taps + i] != 0.0f)
+                return false;
+        return true;
+    };
+    int tbegin = 0, tend = t.taps;
+    while (tend - tbegin > 1 && zero_tap(tbegin))
+        ++tbegin;
+    while (tend - tbegin > 1 && zero_tap(tend - 1))
+        --tend;
+    if (tbegin > 0 || tend < t.taps) {
+        const int taps = tend - tbegin;
+        for (size_t o = 0; o < n; ++o)
+            for (int i = 0; i < taps; ++i) {
+                t.index[o * taps + i]  = t.index[o * t.taps + tbegin + i];
+                t.weight[o * taps + i] = t.weight[o * t.taps + tbegin + i];
+            }
+        t.taps = taps;
+        t.index.resize(n * taps);
+        t.weight.resize(n * taps);
+    }
+    // All the same if each output's weights equal the previous one's
+    t.uniform = n <= 1
+                || std::equal(t.weight.begin() + t.taps, t.weight.end(),
+                              t.weight.begin());
+}
+
+
+
+// acc[i] += w * in[i] for i < n
+// Left as a plain loop so that each dispatched version vectorizes it at
+// its own width.
+OIIO_SIMD_DISPATCH_CLONES
+static void
+accumulate_scaled(float* OIIO_RESTRICT acc, const float* OIIO_RESTRICT in,
+                  float w, int n)
+{
+    for (int i = 0; i < n; ++i)
+        acc[i] += w * in[i];
+}
+
+
+
+// Resize with a separable filter in two passes per output scanline: the
+// vertical filter combines the source rows into a single scanline of
+// float pixels, and the horizontal filter then combines its pixels.
+// Pixels are the same as resize_() makes, up to rounding, but the cost
+// per output pixel is proportional to the sum rather than the product of
+// the horizontal and vertical filter sizes.
+template<typename DSTTYPE, typename SRCTYPE>
+static bool
+resize_separable_(ImageBuf& dst, const ImageBuf& src, const ResizeTaps& xt,
+                  const ResizeTaps& yt, ROI roi, int nthreads)
+{
+    using simd::vfloat4;
+    const int nchannels = dst.nchannels();
+    const int z         = src.spec().z;
+    // Float rows of local contiguous sources can be filtered in place,
+    // and other types converted straight from their pixels.
+    const TypeDesc srcformat = src.spec().format;
+    const bool local         = src.localpixels() && src.contiguous();
+    const bool direct        = local && std::is_same<SRCTYPE, float>::value;
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        // The source columns this part of the output reads
+        const int* xindex = &xt.index[size_t(roi.xbegin - xt.first) * xt.taps];
+        const size_t ntaps = size_t(roi.width()) * xt.taps;
+        const int col0     = *std::min_element(xindex, xindex + ntaps);
+        const int col1     = *std::max_element(xindex, xindex + ntaps) + 1;
+        const int n        = (col1 - col0) * nchannels;
+        std::unique_ptr<float[]> row(new float[n]);
+        std::unique_ptr<float[]> in(direct ? nullptr : new float[n]);
+        float* pel = OIIO_ALLOCA(float, nchannels);
+        // With the same weights for every column, splat them just once.
+        std::vector<vfloat4> xweights(xt.uniform ? xt.taps : 0);
+        for (size_t i = 0; i < xweights.size(); ++i)
+            xweights[i] = vfloat4(xt.weight[i]);
+        ImageBuf::Iterator<DSTTYPE> out(dst, roi);
+        for (int y = roi.ybegin; y < roi.yend; ++y) {
+            const size_t yo = size_t(y - yt.first) * yt.taps;
+            std::fill(row.get(), row.get() + n, 0.0f);
+            for (int j = 0; j < yt.taps; ++j) {
+                const float w = yt.weight[yo + j];
+                if (w == 0.0f)
+                    continue;
+                const int sy   = yt.index[yo + j];
+                const float* s = in.get();
+                if (direct)
+                    s = (const float*)src.pixeladdr(col0, sy, z);
+                else if (local)
+                    convert_pixel_values(srcformat, src.pixeladdr(col0, sy, z),
+                                         TypeFloat, in.get(), n);
+                else
+                    src.get_pixels(ROI(col0, col1, sy, sy + 1, z, z + 1, 0,
+                                       nchannels),
+                                   span<float>(in.get(), n));
+                accumulate_scaled(row.get(), s, w, n);
+            }
+            for (int x = roi.xbegin; x < roi.xend; ++x, ++out) {
+                const size_t xo = size_t(x - xt.first) * xt.taps;
+                if (nchannels == 4) {
+                    vfloat4 sum = vfloat4::Zero();
+                    for (int i = 0; i < xt.taps; ++i)
+                        sum = madd(xt.uniform ? xweights[i]
+                                              : vfloat4(xt.weight[xo + i]),
+                                   vfloat4(&row[(xt.index[xo + i] - col0) * 4]),
+                                   sum);
+                    for (int c = 0; c < 4; ++c)
+                        out[c] = sum[c];
+                    continue;
+                }
+                for (int c = 0; c < nchannels; ++c)
+                    pel[c] = 0.0f;
+                for (int i = 0; i < xt.taps; ++i) {
+                    const float w  = xt.weight[xo + i];
+                    const float* p = &row[(xt.index[xo + i] - col0)
+                                          * nchannels];
+                    for (int c = 0; c < nchannels; ++c)
+                        pel[c] += w * p[c];
+                }
+                for (int c = 0; c < nchannels; ++c)
+                    out[c] = pel[c];
+            }
+        }
+    });
+    return true;
+}
+
+
+
 static std::shared_ptr<Filter2D>
 get_resize_filter(string_view filtername, float fwidth, ImageBuf& dst,
                   float wratio, float hratio)
@@ -860,6 +1104,10 @@ bool
 ImageBufAlgo::resize(ImageBuf& dst, const ImageBuf& src, KWArgs options,
                      ROI roi, int nthreads)
 {
+    if (&dst == &src) {  // Handle in-place operation
+        ImageBuf srcshare(src);
+        return resize(dst, srcshare, options, roi, nthreads);
+    }
     pvt::LoggedTimer logtime("IBA::resize");
 
     static const ustring recognized[] = {
@@ -906,9 +1154,25 @@ ImageBufAlgo::resize(ImageBuf& dst, const ImageBuf& src, KWArgs options,
 #endif
 
     bool ok;
-    OIIO_DISPATCH_COMMON_TYPES2(ok, "resize", resize_, dst.spec().format,
-                                src.spec().format, dst, src, filterptr.get(),
-                                roi, nthreads);
+    if (pvt::imagebufalgo_fastpaths && filterptr->separable()
+        && src.nchannels() == dst.nchannels()
+        && dstspec.format != TypeDesc::DOUBLE) {
+        ResizeTaps xtaps, ytaps;
+        resize_taps(xtaps, filterptr.get(), true, roi.xbegin, roi.xend,
+                    dstspec.full_x, dstspec.full_width, srcspec.full_x,
+                    srcspec.full_width, srcspec.x, srcspec.x + srcspec.width);
+        resize_taps(ytaps, filterptr.get(), false, roi.ybegin, roi.yend,
+                    dstspec.full_y, dstspec.full_height, srcspec.full_y,
+                    srcspec.full_height, srcspec.y,
+                    srcspec.y + srcspec.height);
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "resize", resize_separable_,
+                                    dstspec.format, srcspec.format, dst, src,
+                                    xtaps, ytaps, roi, nthreads);
+    } else {
+        OIIO_DISPATCH_COMMON_TYPES2(ok, "resize", resize_, dst.spec().format,
+                                    src.spec().format, dst, src,
+                                    filterptr.get(), roi, nthreads);
+    }
     return ok;
 }
 
@@ -929,6 +1193,10 @@ bool
 ImageBufAlgo::fit(ImageBuf& dst, const ImageBuf& src, KWArgs options, ROI roi,
                   int nthreads)
 {
+    if (&dst == &src) {  // Handle in-place operation
+        ImageBuf srcshare(src);
+        return fit(dst, srcshare, options, roi, nthreads);
+    }
     pvt::LoggedTimer logtime("IBA::fit");
 
     static const ustring recognized[] = {
@@ -1148,6 +1416,10 @@ bool
 ImageBufAlgo::resample(ImageBuf& dst, const ImageBuf& src, bool interpolate,
                        ROI roi, int nthreads)
 {
+    if (&dst == &src) {  // Handle in-place operation
+        ImageBuf srcshare(src);
+        return resample(dst, srcshare, interpolate, roi, nthreads);
+    }
     pvt::LoggedTimer logtime("IBA::resample");
     if (!IBAprep(roi, &dst, &src,
                  IBAprep_NO_SUPPORT_VOLUME | IBAprep_NO_COPY_ROI_FULL
@@ -1459,6 +1731,11 @@ ImageBufAlgo::st_warp(ImageBuf& dst, const ImageBuf& src, const ImageBuf& stbuf,
                       const Filter2D* filter, int chan_s, int chan_t,
                       bool flip_s, bool flip_t, ROI roi, int nthreads)
 {
+    if (&dst == &src || &dst == &stbuf) {  // Handle in-place operation
+        ImageBuf srcshare(src), stshare(stbuf);
+        return st_warp(dst, srcshare, stshare, filter, chan_s, chan_t, flip_s,
+                       flip_t, roi, nthreads);
+    }
     pvt::LoggedTimer logtime("IBA::st_warp");
 
     if (!check_st_warp_args(dst, src, stbuf, chan_s, chan_t, roi)) {
@@ -1534,4 +1811,426 @@ ImageBufAlgo::st_warp(const ImageBuf& src, const ImageBuf& stbuf,
 }
 
 
+struct ImageBufAlgo::WarpPlan::Impl {
+    struct Tap {
+        int32_t pixel;  ///< Index of the source pixel in its data window
+        float weight;   ///< Normalized filter weight
+    };
+    // The taps of each pixel of a row, those of pixel i of the row being
+    // taps[starts[i]] up to taps[starts[i+1]].
+    struct Row {
+        std::vector<Tap> taps;
+        std::vector<uint32_t> starts;
+    };
+    ROI roi;           ///< The pixels computed
+    ROI dstroi;        ///< The data window of a new dst
+    ROI dstfull;       ///< The display window of a new dst
+    ROI srcroi;        ///< The data window of the source
+    ROI srcfull;       ///< The display window of the source
+    int prepflags = 0;  ///< For IBAprep of a new dst
+    std::vector<Row> rows;
+};
+
+
+
+ROI
+ImageBufAlgo::WarpPlan::roi() const
+{
+    return m_impl ? m_impl->roi : ROI();
+}
+
+
+
+size_t
+ImageBufAlgo::WarpPlan::memory() const
+{
+    if (!m_impl)
+        return 0;
+    size_t bytes = sizeof(Impl) + m_impl->rows.size() * sizeof(Impl::Row);
+    for (const auto& row : m_impl->rows)
+        bytes += row.taps.capacity() * sizeof(Impl::Tap)
+                 + row.starts.capacity() * sizeof(uint32_t);
+    return bytes;
+}
+
+
+
+// Move (x,y) into the data window of `spec` as an iterator with the wrap
+// mode `wrap` would, returning false if it ends up outside (reads black).
+static bool
+wrap_to_data(const ImageSpec& spec, ImageBuf::WrapMode wrap, int& x, int& y)
+{
+    auto inside = [&]() {
+        return x >= spec.x && x < spec.x + spec.width && y >= spec.y
+               && y < spec.y + spec.height;
+    };
+    if (inside())
+        return true;
+    if (wrap == ImageBuf::WrapClamp) {
+        x = clamp(x, spec.full_x, spec.full_x + spec.full_width - 1);
+        y = clamp(y, spec.full_y, spec.full_y + spec.full_height - 1);
+    } else if (wrap == ImageBuf::WrapPeriodic) {
+        wrap_periodic(x, spec.full_x, spec.full_width);
+        wrap_periodic(y, spec.full_y, spec.full_height);
+    } else if (wrap == ImageBuf::WrapMirror) {
+        wrap_mirror(x, spec.full_x, spec.full_width);
+        wrap_mirror(y, spec.full_y, spec.full_height);
+    } else {
+        return false;
+    }
+    return inside();
+}
+
+
+
+// Add to `taps` the source pixels [xmin,xmax) x [ymin,ymax), weighted by
+// `weight(x,y)` and normalized, as the filtered loops of warp and st_warp
+// combine them: pixels that read as black count towards the total weight,
+// but needn't be kept. If the total isn't positive, the result is black.
+template<typename WEIGHT>
+static void
+add_warp_taps(std::vector<ImageBufAlgo::WarpPlan::Impl::Tap>& taps,
+              const ImageSpec& spec, ImageBuf::WrapMode wrap, int xmin,
+              int xmax, int ymin, int ymax, WEIGHT&& weight)
+{
+    size_t first = taps.size();
+    float total  = 0.0f;
+    for (int y = ymin; y < ymax; ++y) {
+        for (int x = xmin; x < xmax; ++x) {
+            float w = weight(x, y);
+            total += w;
+            int wx = x, wy = y;
+            if (w != 0.0f && wrap_to_data(spec, wrap, wx, wy))
+                taps.push_back({ (wy - spec.y) * spec.width + (wx - spec.x),
+                                 w });
+        }
+    }
+    if (total > 0.0f) {
+        float scale = 1.0f / total;
+        for (size_t i = first, e = taps.size(); i < e; ++i)
+            taps[i].weight *= scale;
+    } else {
+        taps.resize(first);
+    }
+}
+
+
+
+// Compute the rows of `plan` in parallel, row_taps(y, row) adding the
+// taps of each pixel of row y to `row`.
+template<typename ROWTAPS>
+static void
+build_warp_plan(ImageBufAlgo::WarpPlan::Impl& plan, int nthreads,
+                ROWTAPS&& row_taps)
+{
+    plan.rows.resize(plan.roi.height());
+    parallel_for(
+        int64_t(plan.roi.ybegin), int64_t(plan.roi.yend),
+        [&](int64_t y) {
+            auto& row = plan.rows[y - plan.roi.ybegin];
+            row.starts.reserve(plan.roi.width() + 1);
+            row_taps(int(y), row);
+            row.starts.push_back(uint32_t(row.taps.size()));
+            row.taps.shrink_to_fit();
+        },
+        paropt(nthreads));
+}
+
+
+
+// Check that a source of `srcspec` can be planned for, or issue an error.
+static bool
+check_warp_plan_src(const ImageSpec& srcspec, string_view funcname)
+{
+    if (srcspec.deep || srcspec.depth > 1 || srcspec.image_pixels() <= 0) {
+        errorfmt("{}: the source must be a flat 2D image", funcname);
+        return false;
+    }
+    if (srcspec.image_pixels() > imagesize_t(std::numeric_limits<int>::max())) {
+        errorfmt("{}: the source has too many pixels", funcname);
+        return false;
+    }
+    return true;
+}
+
+
+
+ImageBufAlgo::WarpPlan
+ImageBufAlgo::make_warp_plan(const ImageSpec& srcspec, M33fParam M_,
+                             KWArgs options, ROI roi, int nthreads)
+{
+    pvt::LoggedTimer logtime("IBA::make_warp_plan");
+    if (!check_warp_plan_src(srcspec, "make_warp_plan"))
+        return {};
+    WarpOptions opt;
+    ImageBuf errbuf;
+    if (!get_warp_options(options, opt, errbuf)) {
+        errorfmt("make_warp_plan: {}", errbuf.geterror());
+        return {};
+    }
+    const Imath::M33f M(M_);
+    auto plan       = std::make_shared<WarpPlan::Impl>();
+    plan->srcroi    = get_roi(srcspec);
+    plan->srcfull   = get_roi_full(srcspec);
+    plan->prepflags = IBAprep_NO_SUPPORT_VOLUME;
+    // Just as warp_impl() sizes an uninitialized dst
+    plan->roi = roi.defined()
+                    ? roi
+                    : (opt.recompute_roi ? transform(M, plan->srcroi)
+                                         : plan->srcroi);
+    plan->roi.chend = std::min(plan->roi.chend, srcspec.nchannels);
+    plan->dstroi    = plan->roi;
+    plan->dstfull   = plan->srcfull;
+
+    const Filter2D* filter = opt.filter.get();
+    ImageBuf::WrapMode wrap = opt.wrap == ImageBuf::WrapDefault
+                                  ? ImageBuf::WrapBlack
+                                  : opt.wrap;
+    Imath::M33f Minv = M.inverse();
+    build_warp_plan(*plan, nthreads, [&](int y, WarpPlan::Impl::Row& row) {
+        for (int x = plan->roi.xbegin; x < plan->roi.xend; ++x) {
+            row.starts.push_back(uint32_t(row.taps.size()));
+            Dual2 sx(x + 0.5f, 1.0f, 0.0f);
+            Dual2 sy(y + 0.5f, 0.0f, 1.0f);
+            robust_multVecMatrix(Minv, sx, sy, sx, sy);
+            // The footprint of filtered_sample()
+            float s           = sx.val();
+            float t           = sy.val();
+            float ds          = std::max(1.0f, std::max(fabsf(sx.dx()),
+                                                        fabsf(sx.dy())));
+            float dt          = std::max(1.0f, std::max(fabsf(sy.dx()),
+                                                        fabsf(sy.dy())));
+            float ds_inv      = 1.0f / ds;
+            float dt_inv      = 1.0f / dt;
+            float filterrad_s = 0.5f * ds * filter->width();
+            float filterrad_t = 0.5f * dt * filter->width();
+            int smin          = (int)floorf(s - filterrad_s);
+            int smax          = (int)ceilf(s + filterrad_s);
+            int tmin          = (int)floorf(t - filterrad_t);
+            int tmax          = (int)ceilf(t + filterrad_t);
+            if (opt.edgeclamp) {
+                const ROI& src(plan->srcroi);
+                smin = OIIO::clamp(smin, src.xbegin, src.xend);
+                smax = OIIO::clamp(smax, src.xbegin, src.xend);
+                tmin = OIIO::clamp(tmin, src.ybegin, src.yend);
+                tmax = OIIO::clamp(tmax, src.ybegin, src.yend);
+                if (s < src.xbegin - 1 || s >= src.xend || t < src.ybegin - 1
+                    || t >= src.yend)
+                    continue;  // black
+            }
+            add_warp_taps(row.taps, srcspec, wrap, smin, smax, tmin, tmax,
+                          [&](int px, int py) {
+                              return (*filter)(ds_inv * (px + 0.5f - s),
+                                               dt_inv * (py + 0.5f - t));
+                          });
+        }
+    });
+    return WarpPlan(std::move(plan));
+}
+
+
+
+ImageBufAlgo::WarpPlan
+ImageBufAlgo::make_st_warp_plan(const ImageSpec& srcspec, const ImageBuf& stbuf,
+                                string_view filtername, float filterwidth,
+                                int chan_s, int chan_t, bool flip_s,
+                                bool flip_t, ROI roi, int nthreads)
+{
+    pvt::LoggedTimer logtime("IBA::make_st_warp_plan");
+    if (!check_warp_plan_src(srcspec, "make_st_warp_plan"))
+        return {};
+    if (!stbuf.initialized()) {
+        errorfmt("make_st_warp_plan: Uninitialized ST buffer");
+        return {};
+    }
+    const ImageSpec& stspec = stbuf.spec();
+    if (chan_s >= stspec.nchannels || chan_t >= stspec.nchannels) {
+        errorfmt("make_st_warp_plan: Out-of-range S or T channel index");
+        return {};
+    }
+    ImageBuf errbuf;
+    auto filter = get_warp_filter(filtername, filterwidth, errbuf);
+    if (!filter) {
+        errorfmt("make_st_warp_plan: {}", errbuf.geterror());
+        return {};
+    }
+    auto plan       = std::make_shared<WarpPlan::Impl>();
+    plan->srcroi    = get_roi(srcspec);
+    plan->srcfull   = get_roi_full(srcspec);
+    plan->prepflags = IBAprep_NO_SUPPORT_VOLUME | IBAprep_NO_COPY_ROI_FULL;
+    // Just as check_st_warp_args() sizes an uninitialized dst
+    if (roi.defined()) {
+        plan->dstroi       = roi;
+        plan->dstroi.chend = std::min(roi.chend, srcspec.nchannels);
+        plan->dstfull      = plan->dstroi;
+    } else {
+        plan->dstroi  = plan->srcroi;
+        plan->dstfull = plan->srcfull;
+    }
+    plan->roi         = roi_intersection(plan->dstroi, stspec.roi());
+    plan->roi.chbegin = plan->dstroi.chbegin;
+    plan->roi.chend   = plan->dstroi.chend;
+    if (plan->roi.npixels() <= 0) {
+        errorfmt("make_st_warp_plan: Output ROI does not intersect ST buffer.");
+        return {};
+    }
+
+    // The footprint of st_warp_()
+    const int src_width   = srcspec.full_width;
+    const int src_height  = srcspec.full_height;
+    const float xscale    = float(plan->dstfull.width()) / src_width;
+    const float yscale    = float(plan->dstfull.height()) / src_height;
+    const int filterrad_x = (int)ceilf(filter->width() / 2.0f / xscale);
+    const int filterrad_y = (int)ceilf(filter->height() / 2.0f / yscale);
+    const ROI& src(plan->srcroi);
+    build_warp_plan(*plan, nthreads, [&](int y, WarpPlan::Impl::Row& row) {
+        ImageBuf::ConstIterator<float> st(stbuf, plan->roi.xbegin,
+                                          plan->roi.xend, y, y + 1);
+        for (; !st.done(); ++st) {
+            row.starts.push_back(uint32_t(row.taps.size()));
+            float src_s = flip_s ? 1.0f - st[chan_s] : st[chan_s];
+            float src_t = flip_t ? 1.0f - st[chan_t] : st[chan_t];
+            const float src_x = src_s * src_width;
+            const float src_y = src_t * src_height;
+            const int x_min   = OIIO::clamp((int)floorf(src_x - filterrad_x),
+                                            src.xbegin, src.xend);
+            const int x_max   = OIIO::clamp((int)ceilf(src_x + filterrad_x),
+                                            src.xbegin, src.xend);
+            const int y_min   = OIIO::clamp((int)floorf(src_y - filterrad_y),
+                                            src.ybegin, src.yend);
+            const int y_max   = OIIO::clamp((int)ceilf(src_y + filterrad_y),
+                                            src.ybegin, src.yend);
+            add_warp_taps(row.taps, srcspec, ImageBuf::WrapBlack, x_min,
+                          x_max + 1, y_min, y_max + 1, [&](int px, int py) {
+                              return (*filter)(px - src_x + 0.5f,
+                                               py - src_y + 0.5f);
+                          });
+        }
+    });
+    return WarpPlan(std::move(plan));
+}
+
+
+
+template<typename DSTTYPE, typename SRCTYPE>
+static bool
+warp_plan_(ImageBuf& dst, const ImageBuf& src,
+           const ImageBufAlgo::WarpPlan::Impl& plan, ROI roi, int nthreads)
+{
+    using Tap = ImageBufAlgo::WarpPlan::Impl::Tap;
+    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
+        const SRCTYPE* pixels = (const SRCTYPE*)src.localpixels();
+        const int nc          = src.nchannels();
+        const int nch         = roi.chend - roi.chbegin;
+        float* sum            = OIIO_ALLOCA(float, nch);
+        ImageBuf::Iterator<DSTTYPE> out(dst, roi);
+        for (int y = roi.ybegin; y < roi.yend; ++y) {
+            const auto& row = plan.rows[y - plan.roi.ybegin];
+            for (int x = roi.xbegin; x < roi.xend; ++x, ++out) {
+                int i         = x - plan.roi.xbegin;
+                const Tap* t  = row.taps.data() + row.starts[i];
+                const Tap* te = row.taps.data() + row.starts[i + 1];
+                if (std::is_same<SRCTYPE, float>::value && nch <= 4) {
+                    simd::vfloat4 acc = simd::vfloat4::Zero();
+                    for (; t < te; ++t) {
+                        simd::vfloat4 p;
+                        p.load((const float*)pixels + size_t(t->pixel) * nc
+                                   + roi.chbegin,
+                               nch);
+                        acc = madd(p, simd::vfloat4(t->weight), acc);
+                    }
+                    acc.store(sum, nch);
+                } else {
+                    for (int c = 0; c < nch; ++c)
+                        sum[c] = 0.0f;
+                    for (; t < te; ++t) {
+                        const SRCTYPE* p = pixels + size_t(t->pixel) * nc
+                                           + roi.chbegin;
+                        for (int c = 0; c < nch; ++c)
+                            sum[c] += t->weight
+                                      * convert_type<SRCTYPE, float>(p[c]);
+                    }
+                }
+                for (int c = 0; c < nch; ++c)
+                    out[roi.chbegin + c] = sum[c];
+            }
+        }
+    });
+    return true;
+}
+
+
+
+bool
+ImageBufAlgo::warp(ImageBuf& dst, const ImageBuf& src, const WarpPlan& plan_,
+                   int nthreads)
+{
+    if (&dst == &src) {  // Handle in-place operation
+        ImageBuf srcshare(src);
+        return warp(dst, srcshare, plan_, nthreads);
+    }
+    pvt::LoggedTimer logtime("IBA::warp");
+    if (!plan_.initialized()) {
+        dst.errorfmt("warp: uninitialized WarpPlan");
+        return false;
+    }
+    const WarpPlan::Impl& plan(*plan_.impl());
+    auto same_window = [](const ROI& a, const ROI& b) {
+        return a.xbegin == b.xbegin && a.xend == b.xend && a.ybegin == b.ybegin
+               && a.yend == b.yend && a.zbegin == b.zbegin && a.zend == b.zend;
+    };
+    if (!src.initialized() || src.deep()
+        || !same_window(src.roi(), plan.srcroi)
+        || !same_window(src.roi_full(), plan.srcfull)) {
+        ROI r(plan.srcroi);
+        dst.errorfmt("warp: the plan is for a source of {}x{}{:+d}{:+d}",
+                     r.width(), r.height(), r.xbegin, r.ybegin);
+        return false;
+    }
+    bool newdst = !dst.initialized();
+    ROI roi     = newdst ? plan.dstroi : plan.roi;
+    if (!IBAprep(roi, &dst, &src, plan.prepflags))
+        return false;
+    if (newdst)
+        dst.set_roi_full(plan.dstfull);
+    int chbegin = roi.chbegin;
+    int chend   = std::min(roi.chend, src.nchannels());
+    roi         = roi_intersection(roi, plan.roi);
+    roi.chbegin = chbegin;
+    roi.chend   = chend;
+    if (roi.npixels() <= 0 || chend <= chbegin)
+        return true;
+
+    // The taps address the source pixels directly, so they must be in
+    // contiguous local memory: make a copy of any that aren't.
+    ImageBuf localsrc;
+    const ImageBuf* s = &src;
+    if (!src.localpixels() || !src.contiguous()) {
+        localsrc = ImageBufAlgo::copy(src, TypeUnknown, {}, nthreads);
+        if (localsrc.has_error()) {
+            dst.errorfmt("warp: {}", localsrc.geterror());
+            return false;
+        }
+        s = &localsrc;
+    }
+    bool ok;
+    OIIO_DISPATCH_COMMON_TYPES2(ok, "warp", warp_plan_, dst.spec().format,
+                                s->spec().format, dst, *s, plan, roi,
+                                nthreads);
+    return ok;
+}
+
+
+
+ImageBuf
+ImageBufAlgo::warp(const ImageBuf& src, const WarpPlan& plan, int nthreads)
+{
+    ImageBuf result;
+    bool ok = warp(result, src, plan, nthreads);
+    if (!ok && !result.has_error())
+        result.errorfmt("ImageBufAlgo::warp() error");
+    return result;
+}
+
+
 OIIO_NAMESPACE_END
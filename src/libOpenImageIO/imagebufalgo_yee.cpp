@@ -6,8 +6,11 @@
 /// \file
 /// Implementation of ImageBufAlgo algorithms.
 
+#include <atomic>
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <mutex>
 
 #include <OpenImageIO/Imath.h>
 #include <OpenImageIO/dassert.h>
@@ -15,7 +18,11 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
+#include <OpenImageIO/parallel.h>
+#include <OpenImageIO/simd.h>
 using Imath::Color3f;
+using OIIO::simd::vbool8;
+using OIIO::simd::vfloat8;
 
 
 
@@ -37,22 +44,23 @@ namespace {
 
 class GaussianPyramid {
 public:
-    GaussianPyramid(ImageBuf& image)
+    GaussianPyramid(ImageBuf& image, int nthreads = 0)
     {
         level[0].swap(image);  // swallow the source as the top level
         ImageBuf kernel = ImageBufAlgo::make_kernel("gaussian", 5, 5);
         for (int i = 1; i < PYRAMID_MAX_LEVELS; ++i)
-            ImageBufAlgo::convolve(level[i], level[i - 1], kernel);
+            ImageBufAlgo::convolve(level[i], level[i - 1], kernel, true, {},
+                                   nthreads);
     }
 
     ~GaussianPyramid() {}
 
-    float value(int x, int y, int lev) const
+    // Scanline y of a level, which are all 0-origin, 1-channel float
+    // images in local memory.
+    const float* row(int lev, int y) const
     {
-        if (lev >= PYRAMID_MAX_LEVELS)
-            return 0.0f;
-        else
-            return level[lev].getchannel(x, y, 0, 1);
+        OIIO_DASSERT(lev < PYRAMID_MAX_LEVELS);
+        return (const float*)level[lev].pixeladdr(0, y);
     }
 
 #if 0 /* unused */
@@ -87,23 +95,6 @@ AdobeRGBToXYZ_color(const Color3f& rgb)
 
 
 
-static bool
-AdobeRGBToXYZ(ImageBuf& A, ROI roi, int nthreads)
-{
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        for (ImageBuf::Iterator<float> a(A, roi); !a.done(); ++a) {
-            Color3f rgb(a[0], a[1], a[2]);
-            Color3f XYZ = AdobeRGBToXYZ_color(rgb);
-            a[0]        = XYZ.x;
-            a[1]        = XYZ.y;
-            a[2]        = XYZ.z;
-        }
-    });
-    return true;
-}
-
-
-
 /// Convert a color in XYZ space to LAB space.
 ///
 inline Color3f
@@ -132,19 +123,38 @@ XYZToLAB_color(const Color3f& xyz)
 
 
 
-static bool
-XYZToLAB(ImageBuf& A, ROI roi, int nthreads)
+// For each pixel of the two RGB images (0-origin float buffers of the
+// same size), convert to XYZ and then LAB, saving each one's luminance
+// (Y, scaled by luminance) in aLum and bLum, and the squared distance
+// between their A and B color coordinates in chroma.
+static void
+RGBToLumAndChroma(const ImageBuf& aRGB, const ImageBuf& bRGB, ImageBuf& aLum,
+                  ImageBuf& bLum, ImageBuf& chroma, float luminance,
+                  int nthreads)
 {
-    ImageBufAlgo::parallel_image(roi, nthreads, [&](ROI roi) {
-        for (ImageBuf::Iterator<float> a(A, roi); !a.done(); ++a) {
-            Color3f XYZ(a[0], a[1], a[2]);
-            Color3f LAB = XYZToLAB_color(XYZ);
-            a[0]        = LAB.x;
-            a[1]        = LAB.y;
-            a[2]        = LAB.z;
-        }
-    });
-    return true;
+    const float* argb = (const float*)aRGB.localpixels();
+    const float* brgb = (const float*)bRGB.localpixels();
+    float* alum       = (float*)aLum.localpixels();
+    float* blum       = (float*)bLum.localpixels();
+    float* ab         = (float*)chroma.localpixels();
+    parallel_for_chunked(
+        0, int64_t(aRGB.spec().image_pixels()), 0,
+        [&](int64_t begin, int64_t end) {
+            for (int64_t p = begin; p < end; ++p) {
+                const float* ap = argb + 3 * p;
+                const float* bp = brgb + 3 * p;
+                Color3f a = AdobeRGBToXYZ_color(Color3f(ap[0], ap[1], ap[2]));
+                Color3f b = AdobeRGBToXYZ_color(Color3f(bp[0], bp[1], bp[2]));
+                alum[p]   = a.y * luminance;
+                blum[p]   = b.y * luminance;
+                a         = XYZToLAB_color(a);
+                b         = XYZToLAB_color(b);
+                float da  = a.y - b.y;  // diff in A
+                float db  = a.z - b.z;  // diff in B
+                ab[p]     = da * da + db * db;
+            }
+        },
+        paropt(nthreads));
 }
 
 
@@ -161,42 +171,37 @@ contrast_sensitivity(float cyclesperdegree, float luminance)
 
 
 
-// Visual Masking Function from Daly 1993
-inline float
-mask(float contrast)
-{
-    float a = powf(392.498f * contrast, 0.7f);
-    float b = powf(0.0153f * a, 4.0f);
-    return powf(1.0f + b, 0.25f);
-}
-
-
-
 // Given the adaptation luminance, this function returns the
 // threshold of visibility in cd per m^2
 // TVI means Threshold vs Intensity function
 // This version comes from Ward Larson Siggraph 1997
-static float
-tvi(float adaptation_luminance)
+inline vfloat8
+tvi(const vfloat8& adaptation_luminance)
 {
     // returns the threshold luminance given the adaptation luminance
-    // units are candelas per meter squared
-    float r;
-    float log_a = log10f(adaptation_luminance);
-    if (log_a < -3.94f)
-        r = -2.86f;
-    else if (log_a < -1.44f)
-        r = powf(0.405f * log_a + 1.6f, 2.18f) - 2.86f;
-    else if (log_a < -0.0184f)
-        r = log_a - 0.395f;
-    else if (log_a < 1.9f)
-        r = powf(0.249f * log_a + 0.65f, 2.7f) - 0.72f;
-    else
-        r = log_a - 1.255f;
-    return powf(10.0f, r);
+    // units are candelas per meter squared. All the pieces are computed,
+    // and the right one selected for each lane (the fast_pow_pos of the
+    // pieces that aren't selected can't make NaNs).
+    vfloat8 log_a = fast_log10(adaptation_luminance);
+    vfloat8 r4    = fast_pow_pos(madd(0.249f, log_a, 0.65f), 2.7f) - 0.72f;
+    vfloat8 r     = select(log_a < 1.9f, r4, log_a - 1.255f);
+    r             = select(log_a < -0.0184f, log_a - 0.395f, r);
+    vfloat8 r2    = fast_pow_pos(madd(0.405f, log_a, 1.6f), 2.18f) - 2.86f;
+    r             = select(log_a < -1.44f, r2, r);
+    r             = select(log_a < -3.94f, vfloat8(-2.86f), r);
+    return fast_exp2(r * float(M_LN10 / M_LN2));
 }
 
 
+
+// The results for one part of the image, to merge into the totals.
+struct YeeResults {
+    imagesize_t nfail = 0;
+    float maxerror    = 0.0f;
+    int maxx = 0, maxy = 0;
+};
+
+
 }  // namespace
 
 
@@ -205,6 +210,17 @@ int
 ImageBufAlgo::compare_Yee(const ImageBuf& img0, const ImageBuf& img1,
                           CompareResults& result, float luminance, float fov,
                           ROI roi, int nthreads)
+{
+    return compare_Yee(img0, img1, result, luminance, fov, roi, nthreads,
+                       std::numeric_limits<imagesize_t>::max());
+}
+
+
+
+int
+ImageBufAlgo::compare_Yee(const ImageBuf& img0, const ImageBuf& img1,
+                          CompareResults& result, float luminance, float fov,
+                          ROI roi, int nthreads, imagesize_t maxfail)
 {
     if (!roi.defined())
         roi = roi_union(get_roi(img0.spec()), get_roi(img1.spec()));
@@ -214,38 +230,29 @@ ImageBufAlgo::compare_Yee(const ImageBuf& img0, const ImageBuf& img1,
     result.maxx = 0, result.maxy = 0, result.maxz = 0, result.maxc = 0;
     result.nfail = 0, result.nwarn = 0;
 
-    int nscanlines = roi.height() * roi.depth();
-
     bool luminanceOnly = false;
 
     // assuming colorspaces are in Adobe RGB (1998), convert to LAB
 
     // paste() to copy of up to 3 channels, converting to float, and
-    // ending up with a 0-origin image.  End up with an LAB image in
-    // aLAB, and a luminance image in aLum.
+    // ending up with 0-origin images. Then in one pass over both, convert
+    // to LAB, keeping just a luminance image of each (aLum and bLum) and
+    // the squared difference of their colors (chroma).
     ImageSpec spec(roi.width(), roi.height(), 3 /*chans*/, TypeDesc::FLOAT);
-    ImageBuf aLAB(spec);
-    ImageBufAlgo::paste(aLAB, 0, 0, 0, 0, img0, roi, nthreads);
-    AdobeRGBToXYZ(aLAB, ROI::All(), nthreads);  // contains XYZ now
-    ImageBuf aLum;
-    ImageBufAlgo::channels(aLum, aLAB, 1, { 1 } /* channelorder */);
-    ImageBufAlgo::mul(aLum, aLum, luminance, ROI::All(), nthreads);
-    XYZToLAB(aLAB, ROI::All(), nthreads);  // now it's LAB
-
-    // Same thing for img1/bLAB/bLum
-    ImageBuf bLAB(spec);
-    ImageBufAlgo::paste(bLAB, 0, 0, 0, 0, img1, roi, nthreads);
-    AdobeRGBToXYZ(bLAB, ROI::All(), nthreads);  // contains XYZ now
-    ImageBuf bLum;
-    ImageBufAlgo::channels(bLum, bLAB, 1, { 1 } /* channelorder */);
-    ImageBufAlgo::mul(bLum, bLum, luminance, ROI::All(), nthreads);
-    XYZToLAB(bLAB, ROI::All(), nthreads);  // now it's LAB
+    ImageBuf aRGB(spec), bRGB(spec);
+    ImageBufAlgo::paste(aRGB, 0, 0, 0, 0, img0, roi, nthreads);
+    ImageBufAlgo::paste(bRGB, 0, 0, 0, 0, img1, roi, nthreads);
+    ImageSpec spec1(roi.width(), roi.height(), 1 /*chans*/, TypeDesc::FLOAT);
+    ImageBuf aLum(spec1), bLum(spec1), chroma(spec1);
+    RGBToLumAndChroma(aRGB, bRGB, aLum, bLum, chroma, luminance, nthreads);
+    aRGB.reset();
+    bRGB.reset();
 
     // Construct Gaussian pyramids (not really pyramids, because they all
     // have the same resolution, but really just a bunch of successively
     // more blurred images).
-    GaussianPyramid la(aLum);
-    GaussianPyramid lb(bLum);
+    GaussianPyramid la(aLum, nthreads);
+    GaussianPyramid lb(bLum, nthreads);
 
     float num_one_degree_pixels = (float)(2 * tan(fov * 0.5 * M_PI / 180) * 180
                                           / M_PI);
@@ -257,81 +264,131 @@ ImageBufAlgo::compare_Yee(const ImageBuf& img0, const ImageBuf& img1,
          ++i, npixels *= 2)
         adaptation_level = i;
 
+    const int nlevels = PYRAMID_MAX_LEVELS - 2;
     float cpd[PYRAMID_MAX_LEVELS];
     cpd[0] = 0.5f * pixels_per_degree;
     for (int i = 1; i < PYRAMID_MAX_LEVELS; ++i)
         cpd[i] = 0.5f * cpd[i - 1];
     float csf_max = contrast_sensitivity(3.248f, 100.0f);
 
-    float F_freq[PYRAMID_MAX_LEVELS - 2];
-    for (int i = 0; i < PYRAMID_MAX_LEVELS - 2; ++i)
+    float F_freq[nlevels];
+    for (int i = 0; i < nlevels; ++i)
         F_freq[i] = csf_max / contrast_sensitivity(cpd[i], 100.0f);
 
-    for (int y = 0; y < nscanlines; ++y) {
-        for (int x = 0; x < roi.width(); ++x) {
-            float contrast[PYRAMID_MAX_LEVELS - 2];
-            float sum_contrast = 0;
-            for (int i = 0; i < PYRAMID_MAX_LEVELS - 2; i++) {
-                float n1 = fabsf(la.value(x, y, i) - la.value(x, y, i + 1));
-                float n2 = fabsf(lb.value(x, y, i) - lb.value(x, y, i + 1));
-                float numerator   = std::max(n1, n2);
-                float d1          = fabsf(la.value(x, y, i + 2));
-                float d2          = fabsf(lb.value(x, y, i + 2));
-                float denominator = std::max(std::max(d1, d2), 1.0e-5f);
-                contrast[i]       = numerator / denominator;
-                sum_contrast += contrast[i];
-            }
-            if (sum_contrast < 1e-5)
-                sum_contrast = 1e-5f;
-            float F_mask[PYRAMID_MAX_LEVELS - 2];
-            float adapt = la.value(x, y, adaptation_level)
-                          + lb.value(x, y, adaptation_level);
-            adapt *= 0.5f;
-            if (adapt < 1e-5)
-                adapt = 1e-5f;
-            for (int i = 0; i < PYRAMID_MAX_LEVELS - 2; i++)
-                F_mask[i] = mask(contrast[i]
-                                 * contrast_sensitivity(cpd[i], adapt));
-            float factor = 0;
-            for (int i = 0; i < PYRAMID_MAX_LEVELS - 2; i++)
-                factor += contrast[i] * F_freq[i] * F_mask[i] / sum_contrast;
-            factor      = OIIO::clamp(factor, 1.0f, 10.0f);
-            float delta = fabsf(la.value(x, y, 0) - lb.value(x, y, 0));
-            bool pass   = true;
-            // pure luminance test
-            delta /= tvi(adapt);
-            if (delta > factor) {
-                pass = false;
-            } else if (!luminanceOnly) {
-                // CIE delta E test with modifications
-                float color_scale = 1.0f;
-                // ramp down the color test in scotopic regions
-                if (adapt < 10.0f) {
-                    color_scale = 1.0f - (10.0f - color_scale) / 10.0f;
-                    color_scale = color_scale * color_scale;
+    // Test 8 pixels at a time, a band of scanlines per task. Once more
+    // than maxfail pixels have failed, the rest are skipped.
+    const int width  = roi.width();
+    const int height = roi.height();
+    std::atomic<imagesize_t> nfail(0);
+    std::mutex merge_mutex;
+    YeeResults total;
+    parallel_for_chunked(
+        0, height, 0,
+        [&](int64_t ybegin, int64_t yend) {
+            YeeResults local;
+            for (int y = int(ybegin); y < yend; ++y) {
+                if (nfail.load(std::memory_order_relaxed) > maxfail)
+                    break;
+                const float *arow[PYRAMID_MAX_LEVELS],
+                    *brow[PYRAMID_MAX_LEVELS];
+                for (int i = 0; i < PYRAMID_MAX_LEVELS; ++i) {
+                    arow[i] = la.row(i, y);
+                    brow[i] = lb.row(i, y);
                 }
-                float da = aLAB.getchannel(x, y, 0, 1)
-                           - bLAB.getchannel(x, y, 0, 1);  // diff in A
-                float db = aLAB.getchannel(x, y, 0, 2)
-                           - bLAB.getchannel(x, y, 0, 2);  // diff in B
-                da    = da * da;
-                db    = db * db;
-                delta = (da + db) * color_scale;
-                if (delta > factor)
-                    pass = false;
-            }
-            if (!pass) {
-                ++result.nfail;
-                if (factor > result.maxerror) {
-                    result.maxerror = factor;
-                    result.maxx     = x;
-                    result.maxy     = y;
-                    //                    result.maxz = z;
+                const float* abrow = (const float*)chroma.pixeladdr(0, y);
+                imagesize_t rowfail = 0;
+                for (int x = 0; x < width; x += 8) {
+                    int n = std::min(8, width - x);
+                    vfloat8 a[PYRAMID_MAX_LEVELS], b[PYRAMID_MAX_LEVELS];
+                    for (int i = 0; i < PYRAMID_MAX_LEVELS; ++i) {
+                        a[i].load(arow[i] + x, n);
+                        b[i].load(brow[i] + x, n);
+                    }
+                    vfloat8 contrast[nlevels];
+                    vfloat8 sum_contrast = 0.0f;
+                    for (int i = 0; i < nlevels; i++) {
+                        vfloat8 numerator = max(abs(a[i] - a[i + 1]),
+                                                abs(b[i] - b[i + 1]));
+                        vfloat8 denominator = max(max(abs(a[i + 2]),
+                                                      abs(b[i + 2])),
+                                                  vfloat8(1.0e-5f));
+                        contrast[i] = numerator / denominator;
+                        sum_contrast += contrast[i];
+                    }
+                    sum_contrast  = max(sum_contrast, vfloat8(1e-5f));
+                    vfloat8 adapt = (a[adaptation_level] + b[adaptation_level])
+                                    * 0.5f;
+                    adapt = max(adapt, vfloat8(1e-5f));
+
+                    // The contrast sensitivity at each level, with the
+                    // terms that depend only on adapt computed just once.
+                    vfloat8 csf_a = 440.0f
+                                    * fast_pow_pos(1.0f + 0.7f / adapt, -0.2f);
+                    vfloat8 csf_b = 0.3f
+                                    * fast_pow_pos(1.0f + 100.0f / adapt,
+                                                   0.15f);
+                    vfloat8 factor = 0.0f;
+                    for (int i = 0; i < nlevels; i++) {
+                        vfloat8 e   = fast_exp(-csf_b * cpd[i]);
+                        vfloat8 csf = csf_a * cpd[i] * e
+                                      * sqrt(1.0f + 0.06f / e);
+                        // Visual Masking Function from Daly 1993
+                        vfloat8 m = fast_pow_pos(392.498f * contrast[i] * csf,
+                                                 0.7f)
+                                    * 0.0153f;
+                        m *= m;
+                        m = sqrt(sqrt(1.0f + m * m));  // (1 + m^4)^(1/4)
+                        factor += contrast[i] * F_freq[i] * m;
+                    }
+                    factor = min(max(factor / sum_contrast, vfloat8(1.0f)),
+                                 vfloat8(10.0f));
+
+                    // pure luminance test
+                    vfloat8 delta = abs(a[0] - b[0]) / tvi(adapt);
+                    vbool8 fail   = delta > factor;
+                    if (!luminanceOnly) {
+                        // CIE delta E test with modifications, ramping
+                        // down the color test in scotopic regions
+                        vfloat8 color_scale = select(adapt < 10.0f,
+                                                     vfloat8(0.01f),
+                                                     vfloat8(1.0f));
+                        vfloat8 ab;
+                        ab.load(abrow + x, n);
+                        fail |= (ab * color_scale) > factor;
+                    }
+                    int fails = fail.bitmask() & ((1 << n) - 1);
+                    for (int j = 0; fails; ++j, fails >>= 1) {
+                        if (!(fails & 1))
+                            continue;
+                        ++rowfail;
+                        if (factor[j] > local.maxerror) {
+                            local.maxerror = factor[j];
+                            local.maxx     = x + j;
+                            local.maxy     = y;
+                        }
+                    }
                 }
+                local.nfail += rowfail;
+                nfail += rowfail;
             }
-        }
-    }
+            // Merge, keeping the first in scanline order of the pixels that
+            // tie for the largest error, just as a serial loop would.
+            std::lock_guard<std::mutex> lock(merge_mutex);
+            total.nfail += local.nfail;
+            if (local.maxerror > total.maxerror
+                || (local.maxerror == total.maxerror && local.nfail
+                    && local.maxy < total.maxy)) {
+                total.maxerror = local.maxerror;
+                total.maxx     = local.maxx;
+                total.maxy     = local.maxy;
+            }
+        },
+        paropt(nthreads));
 
+    result.nfail    = total.nfail;
+    result.maxerror = total.maxerror;
+    result.maxx     = total.maxx;
+    result.maxy     = total.maxy;
     return result.nfail;
 }
 
@@ -3,20 +3,31 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <OpenImageIO/Imath.h>
+#include <OpenImageIO/benchmark.h>
+#include <OpenImageIO/deepdata.h>
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/texture.h>
 #include <OpenImageIO/unittest.h>
 
+#include <algorithm>
 #include <iostream>
 
+#ifndef _WIN32
+#    include <sys/mman.h>
+#endif
+
 using namespace OIIO;
 
 
 static ustring udimpattern;
 static ustring checkertex;
+static ustring tiledtex;
 static std::vector<ustring> files_to_delete;
 
 
@@ -37,6 +48,11 @@ create_temp_textures()
         config.format = TypeHalf;
         ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture, check,
                                    checkertex, config);
+        // Keep a tiled, MIP-mapped copy, too, for tests that need one.
+        tiledtex = ustring::fmtformat("{}/checkertex_tiled.exr", temp_dir);
+        ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture, check,
+                                   tiledtex, config);
+        files_to_delete.push_back(tiledtex);
         check.write(checkertex);
         files_to_delete.push_back(checkertex);
     }
@@ -368,6 +384,1039 @@ test_get_cache_dimensions()
 
 
 
+static void
+test_tilecache_impl()
+{
+    Strutil::print("\nTesting tilecache_impl\n");
+    auto ic = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_EQUAL(ic->getattributetype("tilecache_impl"), TypeString);
+    std::string impl;
+    OIIO_CHECK_ASSERT(ic->getattribute("tilecache_impl", impl));
+    OIIO_CHECK_EQUAL(impl, "map");
+    OIIO_CHECK_FALSE(ic->attribute("tilecache_impl", "nonsense"));
+
+    // Read the whole texture through the default cache, then again
+    // through a lock-free one, and expect identical pixels.
+    const int res = 256, nc = 3;
+    std::vector<float> ref(res * res * nc), pixels(res * res * nc, -1.0f);
+    OIIO_CHECK_ASSERT(ic->get_pixels(checkertex, 0, 0, 0, res, 0, res, 0, 1,
+                                     0, nc, TypeFloat, ref.data()));
+    auto lf = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(lf->attribute("tilecache_impl", "lockfree"));
+    OIIO_CHECK_ASSERT(lf->getattribute("tilecache_impl", impl));
+    OIIO_CHECK_EQUAL(impl, "lockfree");
+    OIIO_CHECK_ASSERT(lf->get_pixels(checkertex, 0, 0, 0, res, 0, res, 0, 1,
+                                     0, nc, TypeFloat, pixels.data()));
+    OIIO_CHECK_ASSERT(pixels == ref);
+    ImageCache::Tile* tile = lf->get_tile(checkertex, 0, 0, 64, 64, 0);
+    OIIO_CHECK_ASSERT(tile != nullptr);
+    lf->release_tile(tile);
+
+    // Invalidating must drop the tiles from the lock-free cache, too.
+    lf->invalidate(checkertex);
+    std::fill(pixels.begin(), pixels.end(), -1.0f);
+    OIIO_CHECK_ASSERT(lf->get_pixels(checkertex, 0, 0, 0, res, 0, res, 0, 1,
+                                     0, nc, TypeFloat, pixels.data()));
+    OIIO_CHECK_ASSERT(pixels == ref);
+
+    // Once tiles have been cached, the choice can't be changed.
+    for (auto c : { ic, lf }) {
+        OIIO_CHECK_ASSERT(c->getattribute("tilecache_impl", impl));
+        OIIO_CHECK_FALSE(c->attribute("tilecache_impl",
+                                      impl == "map" ? "lockfree" : "map"));
+        OIIO_CHECK_ASSERT(c->geterror().size());
+        OIIO_CHECK_ASSERT(c->attribute("tilecache_impl", impl));
+    }
+    ImageCache::destroy(lf);
+    ImageCache::destroy(ic);
+}
+
+
+
+static void
+test_eviction_policy()
+{
+    Strutil::print("\nTesting eviction_policy\n");
+    auto ic = ImageCache::create(false /*not shared*/);
+    std::string policy;
+    OIIO_CHECK_ASSERT(ic->getattribute("eviction_policy", policy));
+    OIIO_CHECK_EQUAL(policy, "clock");
+    OIIO_CHECK_FALSE(ic->attribute("eviction_policy", "nonsense"));
+    OIIO_CHECK_EQUAL(ic->getattributetype("stat:tile_evictions"), TypeInt64);
+
+    ImageCache::destroy(ic);
+
+    // A small texture in constant use (the hot set), and an image several
+    // times the size of the cache that is read just once, a tile at a time
+    // (the scan). All float, in 64x64 tiles of 64 KB.
+    std::string temp_dir = Filesystem::temp_directory_path();
+    ustring hotfile  = ustring::fmtformat("{}/evict_hot.exr", temp_dir);
+    ustring scanfile = ustring::fmtformat("{}/evict_scan.exr", temp_dir);
+    const int tile = 64, nc = 4;
+    ImageBuf hot(ImageSpec(256, 256, nc, TypeFloat));
+    ImageBuf scan(ImageSpec(2048, 1024, nc, TypeFloat));
+    ImageBufAlgo::checker(hot, 8, 8, 1, { 0.1f, 0.2f, 0.3f, 1.0f },
+                          { 0.9f, 0.8f, 0.7f, 1.0f });
+    ImageBufAlgo::checker(scan, 48, 48, 1, { 0.0f, 0.5f, 1.0f, 1.0f },
+                          { 1.0f, 0.5f, 0.0f, 1.0f });
+    hot.set_write_tiles(tile, tile);
+    scan.set_write_tiles(tile, tile);
+    OIIO_CHECK_ASSERT(hot.write(hotfile));
+    OIIO_CHECK_ASSERT(scan.write(scanfile));
+    files_to_delete.push_back(hotfile);
+    files_to_delete.push_back(scanfile);
+    std::vector<float> hotref(hot.spec().image_pixels() * nc);
+    std::vector<float> scanref(scan.spec().image_pixels() * nc);
+    hot.get_pixels(hot.roi(), TypeFloat, hotref.data());
+    scan.get_pixels(scan.roi(), TypeFloat, scanref.data());
+
+    for (const char* name : { "clockpro", "arc", "clock" }) {
+        auto ic = ImageCache::create(false /*not shared*/);
+        // 10 MB, the least a release build allows, and set before the
+        // policy, which sizes its targets from it.
+        OIIO_CHECK_ASSERT(ic->attribute("max_memory_MB", 10.0f));
+        OIIO_CHECK_ASSERT(ic->attribute("eviction_policy", name));
+        OIIO_CHECK_ASSERT(ic->getattribute("eviction_policy", policy));
+        OIIO_CHECK_EQUAL(policy, name);
+
+        // Use the hot set repeatedly, then scan once through 32 MB.
+        std::vector<float> pixels(hotref.size(), -1.0f);
+        for (int i = 0; i < 3; ++i)
+            OIIO_CHECK_ASSERT(ic->get_pixels(hotfile, 0, 0, 0, 256, 0, 256,
+                                             0, 1, TypeFloat, pixels.data()));
+        OIIO_CHECK_ASSERT(pixels == hotref);
+        std::vector<float> scanned(scanref.size(), -1.0f);
+        const stride_t ystride = 2048 * nc * sizeof(float);
+        for (int y = 0; y < 1024; y += tile)
+            for (int x = 0; x < 2048; x += tile)
+                OIIO_CHECK_ASSERT(ic->get_pixels(
+                    scanfile, 0, 0, x, x + tile, y, y + tile, 0, 1, 0, nc,
+                    TypeFloat, &scanned[(size_t(y) * 2048 + x) * nc],
+                    AutoStride, ystride));
+        OIIO_CHECK_ASSERT(scanned == scanref);
+        long long evictions = 0, bytes_before = 0, bytes_after = 0;
+        OIIO_CHECK_ASSERT(ic->getattribute("stat:tile_evictions", TypeInt64,
+                                           &evictions));
+        OIIO_CHECK_GT(evictions, 2048 / tile * 1024 / tile / 2);
+
+        // Now the hot set again: the scan-resistant policies kept all of
+        // it, while plain clock let the scan push it out.
+        OIIO_CHECK_ASSERT(ic->getattribute("stat:bytes_read", TypeInt64,
+                                           &bytes_before));
+        std::fill(pixels.begin(), pixels.end(), -1.0f);
+        OIIO_CHECK_ASSERT(ic->get_pixels(hotfile, 0, 0, 0, 256, 0, 256, 0, 1,
+                                         TypeFloat, pixels.data()));
+        OIIO_CHECK_ASSERT(pixels == hotref);
+        OIIO_CHECK_ASSERT(ic->getattribute("stat:bytes_read", TypeInt64,
+                                           &bytes_after));
+        if (policy == "clock")
+            OIIO_CHECK_GT(bytes_after, bytes_before);
+        else
+            OIIO_CHECK_EQUAL(bytes_after, bytes_before);
+        ImageCache::destroy(ic);
+    }
+}
+
+
+
+static void
+test_diskcache()
+{
+    Strutil::print("\nTesting diskcache_dir\n");
+    std::string dir = Filesystem::temp_directory_path() + "/"
+                      + Filesystem::unique_path("oiio-diskcache-%%%%%%%%");
+    const int res = 256, nc = 3;
+    std::vector<float> ref(res * res * nc), pixels(res * res * nc, -1.0f);
+    long long hits = -1, misses = -1, bytes = -1;
+
+    // The first cache reads the file and fills the disk cache
+    auto ic = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(ic->attribute("diskcache_dir", dir));
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtex, 0, 0, 0, res, 0, res, 0, 1, 0,
+                                     nc, TypeFloat, ref.data()));
+    OIIO_CHECK_ASSERT(ic->getattribute("stat:diskcache_hits", TypeInt64,
+                                       &hits));
+    OIIO_CHECK_ASSERT(ic->getattribute("stat:diskcache_misses", TypeInt64,
+                                       &misses));
+    OIIO_CHECK_EQUAL(hits, 0);
+    OIIO_CHECK_EQUAL(misses, (res / 64) * (res / 64));
+    std::vector<std::string> files;
+    Filesystem::get_directory_entries(dir, files, true);
+    OIIO_CHECK_GE(files.size(), size_t(misses));
+
+    // A second, independent, cache finds every tile on disk, and so never
+    // reads the file's pixels at all.
+    auto ic2 = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(ic2->attribute("diskcache_dir", dir));
+    OIIO_CHECK_ASSERT(ic2->get_pixels(tiledtex, 0, 0, 0, res, 0, res, 0, 1, 0,
+                                      nc, TypeFloat, pixels.data()));
+    OIIO_CHECK_ASSERT(pixels == ref);
+    OIIO_CHECK_ASSERT(ic2->getattribute("stat:diskcache_hits", TypeInt64,
+                                        &hits));
+    OIIO_CHECK_EQUAL(hits, misses);
+    OIIO_CHECK_ASSERT(ic2->getattribute("stat:diskcache_misses", TypeInt64,
+                                        &misses));
+    OIIO_CHECK_EQUAL(misses, 0);
+    OIIO_CHECK_ASSERT(ic2->getattribute("stat:bytes_read", TypeInt64,
+                                        &bytes));
+    OIIO_CHECK_EQUAL(bytes, 0);
+
+    ImageCache::destroy(ic2);
+    ImageCache::destroy(ic);
+    Filesystem::remove_all(dir);
+}
+
+
+
+static void
+test_thumbnail_cache()
+{
+    Strutil::print("\nTesting thumbnail_size and thumbnail_dir\n");
+    std::string dir = Filesystem::temp_directory_path() + "/"
+                      + Filesystem::unique_path("oiio-thumbs-%%%%%%%%");
+    auto ic         = ImageCache::create(false /*not shared*/);
+    ImageBuf thumb;
+    // Without thumbnail_size, only embedded thumbnails are delivered
+    OIIO_CHECK_ASSERT(!ic->get_thumbnail(tiledtex, thumb));
+    ic->geterror();
+
+    // Rounded up to a standard size, and made from the MIP level of that
+    // size, or else by reading the image and resizing it.
+    OIIO_CHECK_ASSERT(ic->attribute("thumbnail_size", 100));
+    OIIO_CHECK_ASSERT(ic->attribute("thumbnail_dir", dir));
+    int size = 0;
+    OIIO_CHECK_ASSERT(ic->getattribute("thumbnail_size", size));
+    OIIO_CHECK_EQUAL(size, 128);
+    for (ustring name : { tiledtex, checkertex }) {
+        OIIO_CHECK_ASSERT(ic->get_thumbnail(name, thumb));
+        OIIO_CHECK_EQUAL(thumb.spec().width, 128);
+        OIIO_CHECK_EQUAL(thumb.spec().height, 128);
+        OIIO_CHECK_EQUAL(thumb.spec().nchannels, 3);
+    }
+    std::vector<std::string> files;
+    Filesystem::get_directory_entries(dir, files, true, "\\.thumb$");
+    OIIO_CHECK_EQUAL(files.size(), size_t(2));
+
+    // Another cache finds them in the directory
+    auto ic2 = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(ic2->attribute("thumbnail_size", 128));
+    OIIO_CHECK_ASSERT(ic2->attribute("thumbnail_dir", dir));
+    ImageBuf thumb2;
+    OIIO_CHECK_ASSERT(ic2->get_thumbnail(checkertex, thumb2));
+    OIIO_CHECK_EQUAL(thumb2.spec().width, 128);
+    auto comp = ImageBufAlgo::compare(thumb, thumb2, 0.0f, 0.0f);
+    OIIO_CHECK_EQUAL(comp.nfail, 0);
+
+    ImageCache::destroy(ic2);
+    ImageCache::destroy(ic);
+    Filesystem::remove_all(dir);
+}
+
+
+
+static void
+test_sharedcache()
+{
+    Strutil::print("\nTesting sharedcache_name\n");
+    std::string name = Filesystem::unique_path("oiio-shm-%%%%%%%%");
+    const int res = 256, nc = 3;
+    std::vector<float> ref(res * res * nc), pixels(res * res * nc, -1.0f);
+    long long hits = -1;
+
+    // Two independent caches stand in for two processes: the second finds
+    // the tiles that the first read.
+    auto ic = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(ic->attribute("sharedcache_max_MB", 16));
+    OIIO_CHECK_ASSERT(ic->attribute("sharedcache_name", name));
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtex, 0, 0, 0, res, 0, res, 0, 1, 0,
+                                     nc, TypeFloat, ref.data()));
+    OIIO_CHECK_ASSERT(ic->getattribute("stat:sharedcache_hits", TypeInt64,
+                                       &hits));
+    OIIO_CHECK_EQUAL(hits, 0);
+
+    auto ic2 = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(ic2->attribute("sharedcache_name", name));
+    OIIO_CHECK_ASSERT(ic2->get_pixels(tiledtex, 0, 0, 0, res, 0, res, 0, 1, 0,
+                                      nc, TypeFloat, pixels.data()));
+    OIIO_CHECK_ASSERT(pixels == ref);
+    OIIO_CHECK_ASSERT(ic2->getattribute("stat:sharedcache_hits", TypeInt64,
+                                        &hits));
+    OIIO_CHECK_EQUAL(hits, (res / 64) * (res / 64));
+
+    ImageCache::destroy(ic2);
+    ImageCache::destroy(ic);
+#ifndef _WIN32
+    shm_unlink(("/" + name).c_str());
+#endif
+}
+
+
+
+static void
+test_tileserver()
+{
+#ifndef _WIN32
+    Strutil::print("\nTesting tileservers\n");
+    const int res = 256, nc = 3;
+    std::vector<float> ref(res * res * nc), pixels(res * res * nc, -1.0f);
+    long long hits = -1;
+
+    // One cache serves tiles, on the first free port we find, and two
+    // independent caches stand in for two render nodes using it.
+    const std::string secret = "test secret";
+    auto server = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(server->attribute("tileserver_secret", secret));
+    int port = 0;
+    for (int p = 23517; p < 23617 && !port; ++p)
+        if (server->attribute("tileserver_port", p))
+            port = p;
+    server->geterror();  // The ports that were in use
+    OIIO_CHECK_ASSERT(port != 0);
+    std::string servers = Strutil::fmt::format("127.0.0.1:{}", port);
+
+    auto ic = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(ic->attribute("tileserver_secret", secret));
+    OIIO_CHECK_ASSERT(ic->attribute("tileservers", servers));
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtex, 0, 0, 0, res, 0, res, 0, 1, 0,
+                                     nc, TypeFloat, ref.data()));
+    OIIO_CHECK_ASSERT(ic->getattribute("stat:tileserver_hits", TypeInt64,
+                                       &hits));
+    OIIO_CHECK_EQUAL(hits, 0);
+    // Tiles are given to the server without waiting for it to store them,
+    // so wait until it has them all (or long enough to be sure it won't).
+    const int ntiles = (res / 64) * (res / 64);
+    int stored       = 0;
+    for (int i = 0; i < 1000 && stored < ntiles; ++i) {
+        if (i)
+            Sysutil::usleep(10000);
+        server->getattribute("tileserver_tiles", stored);
+    }
+    OIIO_CHECK_EQUAL(stored, ntiles);
+
+    // A client that doesn't know the secret gets nothing from the server.
+    auto intruder = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(intruder->attribute("tileservers", servers));
+    OIIO_CHECK_ASSERT(intruder->get_pixels(tiledtex, 0, 0, 0, res, 0, res, 0,
+                                           1, 0, nc, TypeFloat,
+                                           pixels.data()));
+    OIIO_CHECK_ASSERT(pixels == ref);
+    OIIO_CHECK_ASSERT(intruder->getattribute("stat:tileserver_hits",
+                                             TypeInt64, &hits));
+    OIIO_CHECK_EQUAL(hits, 0);
+    ImageCache::destroy(intruder);
+
+    // Without a secret, tiles may only be served to this machine.
+    auto open = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(open->attribute("tileserver_address", ""));
+    OIIO_CHECK_ASSERT(!open->attribute("tileserver_port", port + 1));
+    OIIO_CHECK_ASSERT(open->geterror().size());
+    ImageCache::destroy(open);
+
+    auto ic2 = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(ic2->attribute("tileserver_secret", secret));
+    OIIO_CHECK_ASSERT(ic2->attribute("tileservers", servers));
+    OIIO_CHECK_ASSERT(ic2->get_pixels(tiledtex, 0, 0, 0, res, 0, res, 0, 1, 0,
+                                      nc, TypeFloat, pixels.data()));
+    OIIO_CHECK_ASSERT(pixels == ref);
+    OIIO_CHECK_ASSERT(ic2->getattribute("stat:tileserver_hits", TypeInt64,
+                                        &hits));
+    OIIO_CHECK_EQUAL(hits, ntiles);
+
+    // With the server gone, tiles are just read from the file.
+    OIIO_CHECK_ASSERT(server->attribute("tileserver_port", 0));
+    ic->invalidate(tiledtex);
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtex, 0, 0, 0, res, 0, res, 0, 1, 0,
+                                     nc, TypeFloat, pixels.data()));
+    OIIO_CHECK_ASSERT(pixels == ref);
+
+    ImageCache::destroy(ic2);
+    ImageCache::destroy(ic);
+    ImageCache::destroy(server);
+#endif
+}
+
+
+
+static void
+test_prefetch()
+{
+    Strutil::print("\nTesting prefetch_tiles\n");
+    auto ic = ImageCache::create(false /*not shared*/);
+    const int res = 256, nc = 3;
+    std::vector<float> ref(res * res * nc), pixels(res * res * nc, -1.0f);
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtex, 0, 0, 0, res, 0, res, 0, 1,
+                                     0, nc, TypeFloat, ref.data()));
+    ic->invalidate(tiledtex);
+
+    // Prefetch the whole top level, then look it up while (or after) the
+    // tiles are read in the background.
+    auto hand = ic->get_image_handle(tiledtex);
+    OIIO_CHECK_ASSERT(ic->prefetch_tiles(hand, nullptr, 0, 0, ROI::All()));
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtex, 0, 0, 0, res, 0, res, 0, 1,
+                                     0, nc, TypeFloat, pixels.data()));
+    OIIO_CHECK_ASSERT(pixels == ref);
+    long long prefetched = 0;
+    OIIO_CHECK_ASSERT(ic->getattribute("stat:tiles_prefetched", TypeInt64,
+                                       &prefetched));
+    OIIO_CHECK_GT(prefetched, 0);
+
+    // Asking again for tiles already in the cache queues nothing.
+    OIIO_CHECK_ASSERT(ic->prefetch_tiles(tiledtex, 0, 0));
+    long long prefetched2 = 0;
+    ic->getattribute("stat:tiles_prefetched", TypeInt64, &prefetched2);
+    OIIO_CHECK_EQUAL(prefetched2, prefetched);
+
+    // Errors
+    OIIO_CHECK_FALSE(ic->prefetch_tiles(tiledtex, 0, 100));
+    OIIO_CHECK_FALSE(ic->prefetch_tiles(ustring("noexist.exr"), 0, 0));
+    ic->geterror();
+}
+
+
+
+static void
+test_coalesced_reads()
+{
+    Strutil::print("\nTesting coalesced tile reads\n");
+    const int res = 256, nc = 3;
+    // One tile at a time, which can't be coalesced...
+    auto ic = ImageCache::create(false /*not shared*/);
+    std::vector<float> ref(res * res * nc), pixels(res * res * nc, -1.0f);
+    const ImageSpec* spec = ic->imagespec(tiledtex);
+    OIIO_ASSERT(spec && spec->tile_width > 0 && spec->tile_width < res);
+    int tw = spec->tile_width, th = spec->tile_height;
+    for (int y = 0; y < res; y += th)
+        for (int x = 0; x < res; x += tw)
+            OIIO_CHECK_ASSERT(ic->get_pixels(tiledtex, 0, 0, x, x + tw, y,
+                                             y + th, 0, 1, 0, nc, TypeFloat,
+                                             &ref[(y * res + x) * nc],
+                                             nc * sizeof(float),
+                                             res * nc * sizeof(float)));
+    long long reads = -1;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:coalesced_reads", TypeInt64, &reads));
+    OIIO_CHECK_EQUAL(reads, 0);
+
+    // ...must match reading whole rows of tiles at once.
+    ic->invalidate_all(true);
+    ic->reset_stats();
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtex, 0, 0, 0, res, 0, res, 0, 1,
+                                     0, nc, TypeFloat, pixels.data()));
+    OIIO_CHECK_ASSERT(pixels == ref);
+    long long tiles = 0;
+    ic->getattribute("stat:coalesced_reads", TypeInt64, &reads);
+    ic->getattribute("stat:coalesced_tiles", TypeInt64, &tiles);
+    OIIO_CHECK_GT(reads, 0);
+    OIIO_CHECK_GE(tiles, 2 * reads);
+}
+
+
+
+static void
+test_compressed_tier()
+{
+    Strutil::print("\nTesting compressed_max_MB\n");
+    // An image too big to fit in the smallest allowed cache
+    const int res = 2048, nc = 3;
+    ustring bigtex(Filesystem::temp_directory_path() + "/bigchecker.tif");
+    {
+        ImageSpec spec(res, res, nc, TypeUInt8);
+        spec.tile_width = spec.tile_height = 64;
+        ImageBuf big(spec);
+        ImageBufAlgo::checker(big, 16, 16, 1, { 0.0f, 0.0f, 0.0f },
+                              { 1.0f, 0.5f, 0.25f }, 0, 0, 0);
+        OIIO_CHECK_ASSERT(big.write(bigtex));
+        files_to_delete.push_back(bigtex);
+    }
+
+    auto ic = ImageCache::create(false /*not shared*/);
+    std::string codec;
+    OIIO_CHECK_ASSERT(ic->getattribute("compressed_codec", codec));
+    OIIO_CHECK_EQUAL(codec, "zip");
+    OIIO_CHECK_FALSE(ic->attribute("compressed_codec", "zip:12"));
+    OIIO_CHECK_FALSE(ic->attribute("compressed_codec", "lz5"));
+    OIIO_CHECK_ASSERT(ic->attribute("compressed_codec", "zip:6"));
+    OIIO_CHECK_ASSERT(ic->getattribute("compressed_codec", codec));
+    OIIO_CHECK_EQUAL(codec, "zip:6");
+    ic->geterror();
+    ic->attribute("max_memory_MB", 10.0f);
+    ic->attribute("compressed_max_MB", 100.0f);
+
+    // Read it all twice: the second time, tiles evicted during the first
+    // should come back from the compressed tier, unchanged.
+    std::vector<unsigned char> ref(size_t(res) * res * nc);
+    std::vector<unsigned char> pixels(ref.size(), 0);
+    OIIO_CHECK_ASSERT(ic->get_pixels(bigtex, 0, 0, 0, res, 0, res, 0, 1, 0,
+                                     nc, TypeUInt8, ref.data()));
+    long long stores = 0, hits = 0;
+    ic->getattribute("stat:compressed_stores", TypeInt64, &stores);
+    OIIO_CHECK_GT(stores, 0);
+    OIIO_CHECK_ASSERT(ic->get_pixels(bigtex, 0, 0, 0, res, 0, res, 0, 1, 0,
+                                     nc, TypeUInt8, pixels.data()));
+    OIIO_CHECK_ASSERT(pixels == ref);
+    ic->getattribute("stat:compressed_hits", TypeInt64, &hits);
+    OIIO_CHECK_GT(hits, 0);
+    ic->invalidate(bigtex);
+}
+
+
+
+static void
+test_numa_tiles()
+{
+    Strutil::print("\nTesting numa_tiles\n");
+    auto ic = ImageCache::create(false /*not shared*/);
+    int nodes = 0, numa = -1;
+    OIIO_CHECK_ASSERT(ic->getattribute("numa_nodes", nodes));
+    OIIO_CHECK_GE(nodes, 1);
+    OIIO_CHECK_ASSERT(ic->getattribute("numa_tiles", numa));
+    OIIO_CHECK_EQUAL(numa, 0);
+
+    const int res = 256, nc = 3;
+    std::vector<float> ref(res * res * nc), pixels(res * res * nc, -1.0f);
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtex, 0, 0, 0, res, 0, res, 0, 1, 0,
+                                     nc, TypeFloat, ref.data()));
+    // Whichever node's copies we get, they must hold the same pixels, and
+    // invalidating the file must drop all of them.
+    OIIO_CHECK_ASSERT(ic->attribute("numa_tiles", 1));
+    OIIO_CHECK_ASSERT(ic->getattribute("numa_tiles", numa));
+    OIIO_CHECK_EQUAL(numa, 1);
+    for (int i = 0; i < 2; ++i) {
+        OIIO_CHECK_ASSERT(ic->get_pixels(tiledtex, 0, 0, 0, res, 0, res, 0, 1,
+                                         0, nc, TypeFloat, pixels.data()));
+        OIIO_CHECK_ASSERT(pixels == ref);
+        ic->invalidate(tiledtex);
+    }
+}
+
+
+
+static void
+test_microcache()
+{
+    Strutil::print("\nTesting microcache_size\n");
+    auto ic = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(ic->attribute("microcache_size", 16));
+    int size = 0;
+    OIIO_CHECK_ASSERT(ic->getattribute("microcache_size", size));
+    OIIO_CHECK_EQUAL(size, 16);
+
+    // Cycle among four tiles, which thrashes a two tile microcache but
+    // fits in the bigger one.
+    const ImageSpec* spec = ic->imagespec(tiledtex);
+    OIIO_ASSERT(spec && spec->tile_width > 0);
+    int tw = spec->tile_width;
+    float pixel[3], ref[4][3];
+    for (int pass = 0; pass < 4; ++pass) {
+        for (int t = 0; t < 4; ++t) {
+            OIIO_CHECK_ASSERT(ic->get_pixels(tiledtex, 0, 0, t * tw,
+                                             t * tw + 1, 0, 1, 0, 1, 0, 3,
+                                             TypeFloat, pixel));
+            if (pass == 0)
+                std::copy(pixel, pixel + 3, ref[t]);
+            else
+                OIIO_CHECK_ASSERT(std::equal(pixel, pixel + 3, ref[t]));
+        }
+    }
+    long long hits = 0;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:microcache_set_hits", TypeInt64, &hits));
+    OIIO_CHECK_GT(hits, 0);
+
+    // Invalidating the file must not leave its tiles in any microcache.
+    ic->invalidate(tiledtex);
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtex, 0, 0, 0, 1, 0, 1, 0, 1, 0, 3,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_ASSERT(std::equal(pixel, pixel + 3, ref[0]));
+}
+
+
+
+static void
+test_mmap_tiles()
+{
+    Strutil::print("\nTesting mmap_tiles\n");
+    const int res = 256, nc = 3;
+    ustring rawtex(Filesystem::temp_directory_path() + "/rawchecker.tif");
+    {
+        ImageSpec spec(res, res, nc, TypeUInt16);
+        spec.tile_width = spec.tile_height = 64;
+        spec.attribute("compression", "none");
+        ImageBuf raw(spec);
+        ImageBufAlgo::checker(raw, 16, 16, 1, { 0.0f, 0.0f, 0.0f },
+                              { 1.0f, 0.5f, 0.25f }, 0, 0, 0);
+        OIIO_CHECK_ASSERT(raw.write(rawtex));
+        files_to_delete.push_back(rawtex);
+    }
+
+    // The pixels must be the same whether the tiles are read or mapped.
+    std::vector<uint16_t> read(res * res * nc), mapped(res * res * nc);
+    {
+        auto ic = ImageCache::create(false /*not shared*/);
+        OIIO_CHECK_ASSERT(ic->get_pixels(rawtex, 0, 0, 0, res, 0, res, 0, 1,
+                                         TypeUInt16, read.data()));
+    }
+    auto ic = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(ic->attribute("mmap_tiles", 1));
+    OIIO_CHECK_ASSERT(ic->get_pixels(rawtex, 0, 0, 0, res, 0, res, 0, 1,
+                                     TypeUInt16, mapped.data()));
+    OIIO_CHECK_ASSERT(read == mapped);
+    long long tiles_mapped = 0;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:tiles_mapped", TypeInt64, &tiles_mapped));
+    OIIO_CHECK_EQUAL(tiles_mapped, (res / 64) * (res / 64));
+
+    // Compressed tiles can't be mapped, and are read as usual.
+    float pixel[3];
+    OIIO_CHECK_ASSERT(ic->get_pixels(tiledtex, 0, 0, 0, 1, 0, 1, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:tiles_mapped", TypeInt64, &tiles_mapped));
+    OIIO_CHECK_EQUAL(tiles_mapped, (res / 64) * (res / 64));
+}
+
+
+
+static void
+test_udim_manifest()
+{
+    Strutil::print("\nTesting udim_manifest\n");
+    std::string dir = Filesystem::temp_directory_path() + "/udim_manifest";
+    Filesystem::remove_all(dir);
+    OIIO_CHECK_ASSERT(Filesystem::create_directory(dir));
+    ImageBuf tile(ImageSpec(16, 16, 1, TypeUInt8));
+    OIIO_CHECK_ASSERT(tile.write(dir + "/tex.1001.tif"));
+    OIIO_CHECK_ASSERT(tile.write(dir + "/tex.1012.tif"));
+    ustring pattern(dir + "/tex.<UDIM>.tif");
+    std::string manifest = dir + "/.tex._UDIM_.tif.udims";
+
+    // Scanning the directory leaves a manifest of what it found, which a
+    // later cache uses instead of scanning it again.
+    for (int pass = 0; pass < 2; ++pass) {
+        auto ic = ImageCache::create(false /*not shared*/);
+        OIIO_CHECK_ASSERT(ic->attribute("udim_manifest", 1));
+        int isudim = 0, res[2] = { 0, 0 };
+        OIIO_CHECK_ASSERT(ic->get_image_info(pattern, 0, 0, ustring("udim"),
+                                             TypeInt, &isudim));
+        OIIO_CHECK_EQUAL(isudim, 1);
+        OIIO_CHECK_ASSERT(ic->get_image_info(pattern, 0, 0,
+                                             ustring("resolution"),
+                                             TypeDesc(TypeDesc::INT, 2), res));
+        OIIO_CHECK_EQUAL(res[0], 16);
+        OIIO_CHECK_ASSERT(Filesystem::exists(manifest));
+        std::string stats = ic->getstats(1);
+        OIIO_CHECK_ASSERT(Strutil::contains(
+            stats, pass ? "2 tiles (1 from manifests)"
+                        : "2 tiles (0 from manifests)"));
+    }
+
+    // Once the directory changes, the manifest is out of date.
+    OIIO_CHECK_ASSERT(tile.write(dir + "/tex.1002.tif"));
+    Filesystem::last_write_time(dir, std::time(nullptr) + 10);
+    {
+        auto ic = ImageCache::create(false /*not shared*/);
+        ic->attribute("udim_manifest", 1);
+        int isudim = 0;
+        OIIO_CHECK_ASSERT(ic->get_image_info(pattern, 0, 0, ustring("udim"),
+                                             TypeInt, &isudim));
+        OIIO_CHECK_ASSERT(Strutil::contains(ic->getstats(1),
+                                            "3 tiles (0 from manifests)"));
+    }
+    Filesystem::remove_all(dir);
+}
+
+
+
+static void
+test_tile_stats()
+{
+    Strutil::print("\nTesting tile stats\n");
+    const int res = 128, nc = 3;
+    ustring stattex(Filesystem::temp_directory_path() + "/tilestats.tx");
+    {
+        // The left half is constant, the right half a checkerboard.
+        ImageBuf src(ImageSpec(res, res, nc, TypeFloat));
+        ImageBufAlgo::fill(src, { 0.25f, 0.5f, 0.75f });
+        ImageBufAlgo::checker(src, 8, 8, 1, { 0.0f, 0.0f, 0.0f },
+                              { 1.0f, 1.0f, 1.0f }, 0, 0, 0,
+                              ROI(res / 2, res, 0, res));
+        ImageSpec config;
+        config.tile_width = config.tile_height = 64;
+        config.attribute("maketx:tile_stats", 1);
+        OIIO_CHECK_ASSERT(ImageBufAlgo::make_texture(
+            ImageBufAlgo::MakeTxTexture, src, stattex, config));
+        files_to_delete.push_back(stattex);
+    }
+
+    auto ic = ImageCache::create(false /*not shared*/);
+    float min[nc], max[nc];
+    OIIO_CHECK_ASSERT(ic->get_pixel_bounds(stattex, 0, 0,
+                                           ROI(0, res / 2, 0, res, 0, 1, 0, nc),
+                                           min, max));
+    OIIO_CHECK_EQUAL(min[1], 0.5f);
+    OIIO_CHECK_EQUAL(max[1], 0.5f);
+    OIIO_CHECK_ASSERT(ic->get_pixel_bounds(stattex, 0, 0, ROI::All(), min,
+                                           max));
+    OIIO_CHECK_EQUAL(min[0], 0.0f);
+    OIIO_CHECK_EQUAL(max[0], 1.0f);
+    // Files without statistics just don't have bounds.
+    OIIO_CHECK_ASSERT(!ic->get_pixel_bounds(checkertex, 0, 0, ROI::All(), min,
+                                            max));
+
+    // The constant tiles are filled in rather than read, with the same
+    // result.
+    std::vector<float> pixels(res * res * nc);
+    OIIO_CHECK_ASSERT(ic->get_pixels(stattex, 0, 0, 0, res, 0, res, 0, 1,
+                                     TypeFloat, pixels.data()));
+    OIIO_CHECK_EQUAL(pixels[(5 * res + 5) * nc + 2], 0.75f);
+    long long tiles_constant = 0;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:tiles_constant", TypeInt64, &tiles_constant));
+    OIIO_CHECK_EQUAL(tiles_constant, 2);
+}
+
+
+
+static void
+test_max_open_files()
+{
+    Strutil::print("\nTesting max_open_files\n");
+    const int nfiles = 24, res = 128;
+    std::vector<ustring> files;
+    for (int f = 0; f < nfiles; ++f) {
+        ustring name(Strutil::fmt::format("{}/openfiles{}.tif",
+                                          Filesystem::temp_directory_path(),
+                                          f));
+        ImageSpec spec(res, res, 1, TypeUInt8);
+        spec.tile_width = spec.tile_height = 64;
+        ImageBuf buf(spec);
+        ImageBufAlgo::fill(buf, { f / 255.0f });
+        OIIO_CHECK_ASSERT(buf.write(name));
+        files.push_back(name);
+        files_to_delete.push_back(name);
+    }
+
+    // Read a tile of each file, then a different tile of each, so that
+    // files whose handles were closed to stay within the limit must be
+    // reopened.
+    auto ic = ImageCache::create(false /*not shared*/);
+    ic->attribute("max_open_files", 10);
+    for (int x : { 0, res - 1 }) {
+        for (int f = 0; f < nfiles; ++f) {
+            float pixel = -1.0f;
+            OIIO_CHECK_ASSERT(ic->get_pixels(files[f], 0, 0, x, x + 1, x,
+                                             x + 1, 0, 1, TypeFloat, &pixel));
+            OIIO_CHECK_EQUAL(pixel, f / 255.0f);
+        }
+    }
+    int created = 0, current = 0;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:open_files_created", TypeInt, &created));
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:open_files_current", TypeInt, &current));
+    OIIO_CHECK_GT(created, nfiles);
+    OIIO_CHECK_LE(current, 10);
+}
+
+
+
+static void
+test_watch_files()
+{
+    Strutil::print("\nTesting watch_files\n");
+    ustring name(Strutil::fmt::format("{}/watched.tif",
+                                      Filesystem::temp_directory_path()));
+    files_to_delete.push_back(name);
+    auto write = [&](float value) {
+        ImageBuf buf(ImageSpec(16, 16, 1, TypeFloat));
+        ImageBufAlgo::fill(buf, { value });
+        OIIO_CHECK_ASSERT(buf.write(name));
+    };
+    write(0.25f);
+
+    auto ic = ImageCache::create(false /*not shared*/);
+    ic->attribute("watch_files", 1);
+    int watching = 0;
+    ic->getattribute("watch_files", watching);
+    if (!watching) {
+        Strutil::print("  (file change notifications not available)\n");
+        (void)ic->geterror();
+        return;
+    }
+    float pixel = -1.0f;
+    OIIO_CHECK_ASSERT(
+        ic->get_pixels(name, 0, 0, 0, 1, 0, 1, 0, 1, TypeFloat, &pixel));
+    OIIO_CHECK_EQUAL(pixel, 0.25f);
+    ic->invalidate_all(false);  // Nothing changed
+
+    // Rewriting the file (probably within the same second, so that its
+    // modification time alone wouldn't show it) is reported.
+    write(0.5f);
+    ic->invalidate_all(false);
+    OIIO_CHECK_ASSERT(
+        ic->get_pixels(name, 0, 0, 0, 1, 0, 1, 0, 1, TypeFloat, &pixel));
+    OIIO_CHECK_EQUAL(pixel, 0.5f);
+}
+
+
+
+// A null image is all one value, so its reader reports every tile as
+// empty. Those are filled in rather than read, and 3D texture lookups don't
+// even look them up.
+static void
+test_empty_tiles()
+{
+    Strutil::print("\nTesting empty tiles\n");
+    ustring vol("empty.null?RES=32x32x32&TILE=8x8x8&CHANNELS=2&TYPE=half"
+                "&PIXEL=0.25,0.5");
+    auto ic = ImageCache::create(false /*not shared*/);
+    float pixel[2] = { 0.0f, 0.0f };
+    OIIO_CHECK_ASSERT(
+        ic->get_pixels(vol, 0, 0, 3, 4, 5, 6, 7, 8, TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[1], 0.5f);
+    long long tiles_constant = 0;
+    OIIO_CHECK_ASSERT(
+        ic->getattribute("stat:tiles_constant", TypeInt64, &tiles_constant));
+    OIIO_CHECK_EQUAL(tiles_constant, 1);
+
+    auto ts = TextureSystem::create(false /*not shared*/, ic);
+    long long find_tile_calls = 0, calls_after = 0;
+    ic->getattribute("stat:find_tile_calls", TypeInt64, &find_tile_calls);
+    TextureOpt opt;
+    Imath::V3f zero(0.0f, 0.0f, 0.0f);
+    for (auto interp :
+         { TextureOpt::InterpClosest, TextureOpt::InterpBilinear }) {
+        opt.interpmode  = interp;
+        float result[2] = { 0.0f, 0.0f };
+        OIIO_CHECK_ASSERT(ts->texture3d(vol, opt, Imath::V3f(0.3f, 0.5f, 0.7f),
+                                        zero, zero, zero, 2, result));
+        OIIO_CHECK_EQUAL(result[0], 0.25f);
+        OIIO_CHECK_EQUAL(result[1], 0.5f);
+    }
+    ic->getattribute("stat:find_tile_calls", TypeInt64, &calls_after);
+    OIIO_CHECK_EQUAL(calls_after, find_tile_calls);
+    TextureSystem::destroy(ts);
+}
+
+
+
+// preload opens many files in parallel, reporting the broken ones.
+static void
+test_preload()
+{
+    Strutil::print("\nTesting preload\n");
+    auto ic = ImageCache::create(false /*not shared*/);
+    std::vector<ustring> files;
+    for (int i = 0; i < 20; ++i)
+        files.emplace_back(Strutil::fmt::format(
+            "preload{}.null?RES=64x64&TILE=16x16&CHANNELS=3&TEX=1&PIXEL=0.5",
+            i));
+    ustring missing("no_such_preload_file.exr");
+    files.push_back(missing);
+    std::vector<ustring> broken;
+    ParamValue options[] = { ParamValue("read_coarsest", 1),
+                             ParamValue("averagecolor", 1) };
+    OIIO_CHECK_ASSERT(!ic->preload(files, options, &broken));
+    OIIO_CHECK_EQUAL(broken.size(), 1);
+    if (broken.size() == 1)
+        OIIO_CHECK_EQUAL(broken[0], missing);
+    OIIO_CHECK_ASSERT(ic->has_error());
+    ic->geterror();
+
+    // The good ones are all ready to use.
+    ImageSpec spec;
+    OIIO_CHECK_ASSERT(ic->get_imagespec(files[7], spec));
+    OIIO_CHECK_EQUAL(spec.width, 64);
+    float avg[3] = { 0.0f, 0.0f, 0.0f };
+    OIIO_CHECK_ASSERT(ic->get_image_info(files[7], 0, 0,
+                                         ustring("averagecolor"),
+                                         TypeDesc(TypeDesc::FLOAT, 3), avg));
+    OIIO_CHECK_EQUAL(avg[1], 0.5f);
+}
+
+
+
+static void
+test_retile()
+{
+    Strutil::print("\nTesting retile_dir\n");
+    std::string dir = Filesystem::temp_directory_path() + "/"
+                      + Filesystem::unique_path("oiio-retile-%%%%%%%%");
+    auto ic         = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(ic->attribute("retile_dir", dir));
+    ic->attribute("autotile", 64);
+
+    // The scanline file is used as it is until its copy is ready, and then
+    // the file switches to the copy.
+    float pixel[3] = { -1.0f, -1.0f, -1.0f };
+    OIIO_CHECK_ASSERT(ic->get_pixels(checkertex, 0, 0, 20, 21, 0, 1, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+    ustring format;
+    for (int i = 0; i < 500 && format != "otx"; ++i) {
+        Sysutil::usleep(10000);
+        ic->get_image_info(checkertex, 0, 0, ustring("fileformat"),
+                           TypeString, &format);
+    }
+    OIIO_CHECK_EQUAL(format, "otx");
+    int made = 0;
+    OIIO_CHECK_ASSERT(ic->getattribute("stat:files_retiled", made));
+    OIIO_CHECK_EQUAL(made, 1);
+    ImageSpec spec;
+    OIIO_CHECK_ASSERT(ic->get_imagespec(checkertex, spec));
+    OIIO_CHECK_EQUAL(spec.tile_width, 64);
+    pixel[0] = -1.0f;
+    OIIO_CHECK_ASSERT(ic->get_pixels(checkertex, 0, 0, 20, 21, 0, 1, 0, 1,
+                                     TypeFloat, pixel));
+    OIIO_CHECK_EQUAL(pixel[0], 1.0f);
+
+    // Another cache uses the copy from the start.
+    auto ic2 = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(ic2->attribute("retile_dir", dir));
+    format.clear();
+    ic2->get_image_info(checkertex, 0, 0, ustring("fileformat"), TypeString,
+                        &format);
+    OIIO_CHECK_EQUAL(format, "otx");
+
+    ImageCache::destroy(ic2);
+    ImageCache::destroy(ic);
+    Filesystem::remove_all(dir);
+}
+
+
+
+// With "tile_feedback", the tiles that each thread's texture lookups touch
+// are recorded, and merged (and cleared) by get_tile_feedback.
+static void
+test_tile_feedback()
+{
+    Strutil::print("\nTesting tile feedback\n");
+    ustring tex("feedback.null?RES=256x256&TILE=64x64&CHANNELS=1&TEX=1");
+    auto ts = TextureSystem::create(false /*not shared*/);
+    ts->attribute("tile_feedback", 1);
+    TextureOpt opt;
+    opt.mipmode    = TextureOpt::MipModeNoMIP;
+    opt.interpmode = TextureOpt::InterpClosest;
+    float result   = -1.0f;
+    // Texel (76,153) of the finest level, in tile (1,2).
+    OIIO_CHECK_ASSERT(ts->texture(tex, opt, 0.3f, 0.6f, 0.0f, 0.0f, 0.0f,
+                                  0.0f, 1, &result));
+    auto feedback = ts->get_tile_feedback();
+    OIIO_CHECK_EQUAL(feedback.size(), 1);
+    if (feedback.size() == 1) {
+        const TextureSystem::TileFeedback& f(feedback[0]);
+        OIIO_CHECK_EQUAL(f.filename, tex);
+        OIIO_CHECK_EQUAL(f.miplevel, 0);
+        OIIO_CHECK_EQUAL(f.nxtiles, 4);
+        OIIO_CHECK_EQUAL(f.nytiles, 4);
+        OIIO_CHECK_EQUAL(f.nztiles, 1);
+        OIIO_CHECK_EQUAL(f.tiles.size(), 1);
+        OIIO_CHECK_EQUAL(f.tiles[0], uint64_t(1) << (1 + 2 * 4));
+    }
+    OIIO_CHECK_ASSERT(ts->get_tile_feedback().empty());
+    TextureSystem::destroy(ts);
+}
+
+
+
+// Deep images are cached in tiles of DeepData, which get_deep_pixels
+// assembles into any rectangle.
+static void
+test_deep_pixels()
+{
+    Strutil::print("\nTesting get_deep_pixels\n");
+    const int w = 50, h = 40;
+    ustring deeptex(Filesystem::temp_directory_path() + "/deeptiled.exr");
+    auto nsamples = [](int x, int y) { return (x + y) % 3; };
+    {
+        ImageSpec spec(w, h, 3, TypeFloat);
+        spec.channelnames  = { "R", "A", "Z" };
+        spec.alpha_channel = 1;
+        spec.z_channel     = 2;
+        spec.tile_width    = 16;
+        spec.tile_height   = 16;
+        spec.deep          = true;
+        ImageBuf buf(spec);
+        DeepData& dd(*buf.deepdata());
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                dd.set_samples(buf.pixelindex(x, y, 0), nsamples(x, y));
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                int64_t p = buf.pixelindex(x, y, 0);
+                for (int s = 0; s < nsamples(x, y); ++s) {
+                    dd.set_deep_value(p, 0, s, float(x) + 0.25f * s);
+                    dd.set_deep_value(p, 1, s, 0.5f);
+                    dd.set_deep_value(p, 2, s, float(y + s));
+                }
+            }
+        }
+        OIIO_CHECK_ASSERT(buf.write(deeptex));
+        files_to_delete.push_back(deeptex);
+    }
+
+    auto ic = ImageCache::create(false /*not shared*/);
+    // A region straddling tiles and the edges of the image
+    const int xbegin = 10, xend = 55, ybegin = -3, yend = 20;
+    DeepData result;
+    OIIO_CHECK_ASSERT(ic->get_deep_pixels(deeptex, 0, 0, xbegin, xend, ybegin,
+                                          yend, 0, 1, result));
+    OIIO_CHECK_EQUAL(result.pixels(), (xend - xbegin) * (yend - ybegin));
+    OIIO_CHECK_EQUAL(result.channels(), 3);
+    OIIO_CHECK_EQUAL(result.channelname(2), "Z");
+    int wrong = 0;
+    for (int y = ybegin; y < yend; ++y) {
+        for (int x = xbegin; x < xend; ++x) {
+            int64_t p = (y - ybegin) * (xend - xbegin) + (x - xbegin);
+            bool inside = x < w && y >= 0 && y < h;
+            int n       = inside ? nsamples(x, y) : 0;
+            wrong += (result.samples(p) != n);
+            for (int s = 0; s < std::min(n, result.samples(p)); ++s)
+                wrong += (result.deep_value(p, 0, s) != float(x) + 0.25f * s
+                          || result.deep_value(p, 2, s) != float(y + s));
+        }
+    }
+    OIIO_CHECK_EQUAL(wrong, 0);
+
+    // Flat pixels of a deep image can't be had, nor deep ones of a flat.
+    float pixel[3];
+    OIIO_CHECK_FALSE(
+        ic->get_pixels(deeptex, 0, 0, 0, 1, 0, 1, 0, 1, TypeFloat, pixel));
+    OIIO_CHECK_FALSE(
+        ic->get_deep_pixels(tiledtex, 0, 0, 0, 1, 0, 1, 0, 1, result));
+    ic->geterror();
+    ic->invalidate(deeptex);
+}
+
+
+
+static void
+bench_file_lookup()
+{
+    Strutil::print("\nBenchmarking image lookups by name and by handle\n");
+    auto ic = ImageCache::create(false /*not shared*/);
+    ImageCache::Perthread* thread_info = ic->get_perthread_info();
+    ImageCache::ImageHandle* handle    = ic->get_image_handle(tiledtex,
+                                                              thread_info);
+    OIIO_CHECK_ASSERT(handle);
+    static ustring resolution("resolution");
+    int res[2] = { 0, 0 };
+    Benchmarker bench;
+    bench.iterations(10000);
+    bench.trials(5);
+    bench("get_image_info by name", [&]() {
+        DoNotOptimize(ic->get_image_info(tiledtex, 0, 0, resolution,
+                                         TypeDesc(TypeDesc::INT, 2), res));
+    });
+    bench("get_image_info by handle", [&]() {
+        DoNotOptimize(ic->get_image_info(handle, thread_info, 0, 0, resolution,
+                                         TypeDesc(TypeDesc::INT, 2), res));
+    });
+    OIIO_CHECK_EQUAL(res[0], 256);
+}
+
+
+
 int
 main(int /*argc*/, char* /*argv*/[])
 {
@@ -386,6 +1435,28 @@ main(int /*argc*/, char* /*argv*/[])
     test_custom_threadinfo();
     test_imagespec();
     test_get_cache_dimensions();
+    test_tilecache_impl();
+    test_eviction_policy();
+    test_diskcache();
+    test_thumbnail_cache();
+    test_sharedcache();
+    test_tileserver();
+    test_prefetch();
+    test_coalesced_reads();
+    test_compressed_tier();
+    test_numa_tiles();
+    test_microcache();
+    test_mmap_tiles();
+    test_udim_manifest();
+    test_tile_stats();
+    test_max_open_files();
+    test_watch_files();
+    test_empty_tiles();
+    test_preload();
+    test_retile();
+    test_tile_feedback();
+    test_deep_pixels();
+    bench_file_lookup();
 
     auto ic = ImageCache::create();
     Strutil::print("\n\n{}\n", ic->getstats(5));
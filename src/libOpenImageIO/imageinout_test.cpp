@@ -6,6 +6,7 @@
 // Tests related to ImageInput and ImageOutput
 /////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <iostream>
 
 #if defined(__linux__)
@@ -26,6 +27,7 @@ using namespace OIIO;
 static std::string onlyformat = Sysutil::getenv("IMAGEINOUTTEST_ONLY_FORMAT");
 static bool nodelete          = false;  // Don't delete the test files
 static bool enable_fpe        = false;  // Throw exceptions on FP errors.
+static bool benchmark         = false;  // Time some formats' reads/writes
 
 
 
@@ -44,6 +46,8 @@ getargs(int argc, char* argv[])
       .help("Enable floating point exceptions.");
     ap.arg("--onlyformat %s:FORMAT", &onlyformat)
       .help("Test only one format");
+    ap.arg("--benchmark", &benchmark)
+      .help("Benchmark reading and writing 4K DPX frames");
 
     ap.parse_args(argc, (const char**)argv);
     // clang-format on
@@ -293,6 +297,22 @@ test_read_proxy(string_view formatname, string_view extension,
         std::cout << "Error was: " << OIIO::geterror() << "\n";
     }
 
+    // Read the disk file through a memory mapping
+    Filesystem::IOMMap mmproxy(disk_filename);
+    auto mmin = ImageInput::open(disk_filename, nullptr, &mmproxy);
+    OIIO_CHECK_ASSERT(mmin && "Failed to open input with mmap proxy");
+    if (mmin) {
+        std::vector<unsigned char> readpixels;
+        ok &= checked_read(mmin.get(), disk_filename, readpixels, true);
+        ok &= test_pixel_match({ (const float*)readpixels.data(), nvalues },
+                               { (const float*)buf.localpixels(), nvalues },
+                               eps);
+        OIIO_CHECK_ASSERT(ok && "Read mmap proxy didn't match original");
+    } else {
+        ok = false;
+        std::cout << "Error was: " << OIIO::geterror() << "\n";
+    }
+
     // Read the in-memory file using an ioproxy again, but with ImageInput
     Filesystem::IOMemReader inproxybuf(readbuf);
     ImageBuf inbuf(memname, 0, 0, nullptr, nullptr, &inproxybuf);
@@ -531,6 +551,437 @@ test_read_tricky_sizes()
 
 
 
+// Readers supporting "parallel_scanline_decode" have large reads split
+// into pieces read by several threads, which must give the same pixels as
+// reading one scanline at a time.
+void
+test_parallel_scanline_decode()
+{
+    std::cout << "Testing parallel scanline decode\n";
+    ImageBuf src(ImageSpec(67, 301, 3, TypeFloat));
+    ImageBufAlgo::fill(src, { 0.0f, 0.5f, 1.0f }, { 1.0f, 0.0f, 0.25f },
+                       { 0.5f, 1.0f, 0.0f }, { 0.0f, 0.25f, 0.75f });
+    std::vector<float> ref(src.spec().image_pixels() * 3);
+    src.get_pixels(src.roi(), TypeFloat, ref.data());
+    const char* filename = "tmp_parallel.sgi";
+    for (TypeDesc format : { TypeUInt8, TypeUInt16 }) {
+        src.set_write_format(format);
+        OIIO_CHECK_ASSERT(src.write(filename));
+        auto in = ImageInput::open(filename);
+        OIIO_CHECK_ASSERT(in && in->supports("parallel_scanline_decode"));
+        if (!in)
+            continue;
+        const ImageSpec& spec(in->spec());
+        std::vector<unsigned char> whole(spec.image_bytes());
+        std::vector<float> converted(ref.size());
+        OIIO_CHECK_ASSERT(in->read_image(0, 0, 0, 3, format, whole.data()));
+        OIIO_CHECK_ASSERT(
+            in->read_image(0, 0, 0, 3, TypeFloat, converted.data()));
+        std::vector<unsigned char> line(spec.scanline_bytes());
+        bool ok = true;
+        for (int y = 0; y < spec.height; ++y) {
+            ok &= in->read_scanline(y, 0, format, line.data());
+            ok &= !memcmp(line.data(), &whole[y * line.size()], line.size());
+        }
+        OIIO_CHECK_ASSERT(ok);
+        // 8 bit quantization of the gradient
+        OIIO_CHECK_ASSERT(test_pixel_match(converted, ref, 0.5f / 255.0f));
+        in->close();
+    }
+    Filesystem::remove(filename);
+}
+
+
+
+// Reading with a type conversion and a channel subset, which a reader may
+// fuse with its decoding, must match converting the native pixels.
+void
+test_read_converted_subset()
+{
+    std::cout << "Testing read of converted channel subset\n";
+    const char* filename = "tmp_subset.exr";
+    ImageBuf src(ImageSpec(37, 100, 4, TypeFloat));
+    ImageBufAlgo::fill(src, { 0.0f, 0.5f, 1.0f, 0.1f },
+                       { 1.0f, 0.0f, 0.25f, 0.2f }, { 0.5f, 1.0f, 0.0f, 0.3f },
+                       { 0.0f, 0.25f, 0.75f, 0.4f });
+    src.specmod().attribute("compression", "zip");
+    OIIO_CHECK_ASSERT(src.write(filename));
+    int core = 0;
+    OIIO::getattribute("openexr:core", core);
+    for (int usecore : { 0, 1 }) {
+        OIIO::attribute("openexr:core", usecore);
+        auto in = ImageInput::open(filename);
+        OIIO_CHECK_ASSERT(in);
+        if (!in)
+            continue;
+        // Channels 1-2 of scanlines 5-94, as half, leaving a gap of one
+        // value after each pixel.
+        const int ybegin = 5, yend = 95, w = 37;
+        std::vector<half> buf(size_t(yend - ybegin) * w * 3, half(-1.0f));
+        OIIO_CHECK_ASSERT(in->read_scanlines(0, 0, ybegin, yend, 0, 1, 3,
+                                             TypeHalf, buf.data(),
+                                             3 * sizeof(half)));
+        bool ok = true;
+        for (int y = ybegin; y < yend; ++y)
+            for (int x = 0; x < w; ++x) {
+                const half* p = &buf[((y - ybegin) * w + x) * 3];
+                ok &= (p[0] == half(src.getchannel(x, y, 0, 1))
+                       && p[1] == half(src.getchannel(x, y, 0, 2))
+                       && p[2] == half(-1.0f));
+            }
+        OIIO_CHECK_ASSERT(ok);
+    }
+    OIIO::attribute("openexr:core", core);
+    Filesystem::remove(filename);
+}
+
+
+
+// The "oiio:headeronly" hint skips the Exif, and an ImageSpecIndex
+// remembers specs until their files change.
+void
+test_headeronly_and_spec_index()
+{
+    std::cout << "Testing header-only open and spec index\n";
+    const char* filename  = "tmp_specindex.tif";
+    const char* indexfile = "tmp_specindex.idx";
+    ImageBuf src(ImageSpec(40, 30, 3, TypeUInt8));
+    src.specmod().attribute("Exif:ExposureTime", 0.01f);
+    OIIO_CHECK_ASSERT(src.write(filename));
+    ImageSpec config;
+    config.attribute("oiio:headeronly", 1);
+    auto in = ImageInput::open(filename, &config);
+    OIIO_CHECK_ASSERT(in);
+    if (in) {
+        OIIO_CHECK_EQUAL(in->spec().width, 40);
+        OIIO_CHECK_EQUAL(in->spec().nchannels, 3);
+        OIIO_CHECK_ASSERT(!in->spec().find_attribute("Exif:ExposureTime"));
+    }
+    in = ImageInput::open(filename);
+    OIIO_CHECK_ASSERT(in && in->spec().find_attribute("Exif:ExposureTime"));
+    in.reset();
+
+    Filesystem::remove(indexfile);
+    ImageSpec spec;
+    {
+        ImageSpecIndex index(indexfile);
+        OIIO_CHECK_ASSERT(index.get(filename, spec));
+        OIIO_CHECK_EQUAL(spec.width, 40);
+        OIIO_CHECK_EQUAL(index.size(), size_t(1));
+        OIIO_CHECK_ASSERT(!index.get(filename, spec, 1));
+        OIIO::geterror();
+        OIIO_CHECK_ASSERT(!index.get("tmp_nonexistent.tif", spec));
+        OIIO::geterror();
+    }  // saved by the destructor
+    {
+        ImageSpecIndex index(indexfile);
+        OIIO_CHECK_EQUAL(index.size(), size_t(1));
+        spec = ImageSpec();
+        OIIO_CHECK_ASSERT(index.get(filename, spec));
+        OIIO_CHECK_EQUAL(spec.height, 30);
+        OIIO_CHECK_EQUAL(spec.format, TypeUInt8);
+        // A changed file is read again
+        src.reset(ImageSpec(50, 30, 4, TypeUInt8));
+        OIIO_CHECK_ASSERT(src.write(filename));
+        OIIO_CHECK_ASSERT(index.get(filename, spec));
+        OIIO_CHECK_EQUAL(spec.width, 50);
+        OIIO_CHECK_EQUAL(spec.nchannels, 4);
+    }
+    Filesystem::remove(indexfile);
+    Filesystem::remove(filename);
+}
+
+
+
+// TIFF zip compression done in parallel, for every data type and
+// predictor and for both strips and tiles, must round trip exactly.
+void
+test_tiff_parallel_compression()
+{
+    std::cout << "Testing TIFF parallel compression\n";
+    const char* filename = "tmp_parallelzip.tif";
+    // Enough strips and tiles to be compressed in parallel, with partial
+    // ones at the edges.
+    ImageBuf src(ImageSpec(150, 131, 3, TypeFloat));
+    ImageBufAlgo::fill(src, { 0.0f, 0.5f, 1.0f }, { 1.0f, 0.0f, 0.25f },
+                       { 0.5f, 1.0f, 0.0f }, { 0.0f, 0.25f, 0.75f });
+    for (TypeDesc format :
+         { TypeUInt8, TypeUInt16, TypeInt16, TypeUInt32, TypeHalf, TypeFloat,
+           TypeDesc(TypeDesc::DOUBLE) }) {
+        for (bool tiled : { false, true }) {
+            ImageBuf img = src.copy(format);
+            img.specmod().attribute("compression", "zip");
+            img.specmod().attribute("tiff:RowsPerStrip", 8);
+            img.set_write_tiles(tiled ? 32 : 0, tiled ? 32 : 0);
+            OIIO_CHECK_ASSERT(img.write(filename));
+            ImageBuf back(filename);
+            OIIO_CHECK_ASSERT(back.read(0, 0, true, format));
+            auto comp = ImageBufAlgo::compare(back, img, 0.0f, 0.0f);
+            if (comp.nfail)
+                std::cout << "  " << format << (tiled ? " tiled" : "")
+                          << " failed\n";
+            OIIO_CHECK_EQUAL(comp.nfail, 0);
+        }
+    }
+    Filesystem::remove(filename);
+}
+
+
+
+// A PNG big enough to be filtered and compressed in bands, in parallel,
+// should read back just as one written serially, whatever the filters.
+static void
+test_png_parallel_bands()
+{
+    std::cout << "Testing PNG parallel bands\n";
+    ImageSpec spec(700, 600, 3, TypeUInt16);
+    ImageBuf src(spec);
+    ImageBufAlgo::fill(src, { 0.0f, 0.5f, 1.0f }, { 1.0f, 0.0f, 0.25f },
+                       { 0.5f, 1.0f, 0.0f }, { 0.0f, 0.25f, 0.75f });
+    ImageBufAlgo::noise(src, "uniform", 0.0f, 0.25f);
+    std::vector<unsigned short> want(spec.image_pixels() * spec.nchannels);
+    src.get_pixels(src.roi(), make_span(want));
+    for (int filter : { 0, 16 }) {
+        spec.attribute("png:filter", filter);
+        for (int nthreads : { 0, 1 }) {
+            auto out = ImageOutput::create("tmp_bands.png");
+            OIIO_CHECK_ASSERT(out);
+            if (!out)
+                return;
+            out->threads(nthreads);
+            OIIO_CHECK_ASSERT(out->open("tmp_bands.png", spec)
+                              && out->write_image(TypeUInt16,
+                                                  src.localpixels())
+                              && out->close());
+            out.reset();
+            auto in = ImageInput::open("tmp_bands.png");
+            OIIO_CHECK_ASSERT(in);
+            if (!in)
+                return;
+            std::vector<unsigned short> got(want.size());
+            OIIO_CHECK_ASSERT(
+                in->read_image(0, 0, 0, 3, TypeUInt16, got.data()));
+            OIIO_CHECK_ASSERT(got == want);
+        }
+    }
+    Filesystem::remove("tmp_bands.png");
+}
+
+
+
+// 10-bit filled DPX, with lines that end in a part-full word, reads back
+// exactly what was written (to 10 bits), whether all at once or a band of
+// scanlines at a time.
+static void
+test_dpx_10bit_filled()
+{
+    std::cout << "Testing DPX 10-bit filled packing\n";
+    for (int nchannels : { 3, 4 }) {
+        for (const char* packing : { "Filled, method A", "Filled, method B" }) {
+            ImageSpec spec(301, 40, nchannels, TypeUInt16);
+            spec.attribute("oiio:BitsPerSample", 10);
+            spec.attribute("dpx:Packing", packing);
+            ImageBuf src(spec);
+            ImageBufAlgo::noise(src, "uniform", 0.0f, 1.0f);
+            std::vector<unsigned short> want(spec.image_pixels() * nchannels);
+            src.get_pixels(src.roi(), make_span(want));
+            for (auto& v : want)
+                v = (v & 0xffc0) | (v >> 10);  // 10 bits, and back to 16
+            OIIO_CHECK_ASSERT(src.write("tmp_10bit.dpx"));
+            auto in = ImageInput::open("tmp_10bit.dpx");
+            OIIO_CHECK_ASSERT(in);
+            if (!in)
+                return;
+            std::vector<unsigned short> got(want.size());
+            OIIO_CHECK_ASSERT(in->read_image(0, 0, 0, nchannels, TypeUInt16,
+                                             got.data()));
+            OIIO_CHECK_ASSERT(got == want);
+            size_t linevals = size_t(spec.width) * nchannels;
+            std::vector<unsigned short> band(linevals * 7);
+            OIIO_CHECK_ASSERT(in->read_scanlines(0, 0, 10, 17, 0, 0,
+                                                 nchannels, TypeUInt16,
+                                                 band.data()));
+            OIIO_CHECK_ASSERT(std::equal(band.begin(), band.end(),
+                                         want.begin() + 10 * linevals));
+        }
+    }
+    Filesystem::remove("tmp_10bit.dpx");
+}
+
+
+
+// Each BCn compression the DDS writer supports comes back close to what was
+// written, with a partial block at the edges and a second MIP level.
+static void
+test_dds_bcn_output()
+{
+    std::cout << "Testing DDS BCn compressed output\n";
+    struct Case {
+        const char* compression;
+        int nchannels;  // Written, and read back
+        int ncompared;  // BC1 alpha is only opaque or transparent
+    };
+    for (Case c : { Case { "bc1", 4, 3 }, Case { "bc3", 4, 4 },
+                    Case { "bc4", 1, 1 }, Case { "bc5", 2, 2 },
+                    Case { "bc7", 4, 4 } }) {
+        ImageBuf levels[2];
+        auto out = ImageOutput::create("tmp_bcn.dds");
+        OIIO_CHECK_ASSERT(out && out->supports("mipmap"));
+        if (!out)
+            return;
+        for (int m = 0; m < 2; ++m) {
+            ImageSpec spec(70 >> m, 38 >> m, c.nchannels, TypeUInt8);
+            spec.attribute("compression", c.compression);
+            levels[m].reset(spec);
+            ImageBufAlgo::fill(levels[m], { 0.0f, 0.0f, 0.0f, 0.6f },
+                               { 1.0f, 0.5f, 0.0f, 1.0f },
+                               { 0.0f, 1.0f, 1.0f, 0.8f },
+                               { 1.0f, 1.0f, 0.25f, 1.0f });
+            OIIO_CHECK_ASSERT(out->open("tmp_bcn.dds", spec,
+                                        m ? ImageOutput::AppendMIPLevel
+                                          : ImageOutput::Create));
+            OIIO_CHECK_ASSERT(
+                out->write_image(TypeUInt8, levels[m].localpixels()));
+        }
+        OIIO_CHECK_ASSERT(out->close());
+
+        for (int m = 0; m < 2; ++m) {
+            ImageBuf in("tmp_bcn.dds", 0, m);
+            OIIO_CHECK_ASSERT(in.read());
+            OIIO_CHECK_EQUAL(in.spec().width, 70 >> m);
+            OIIO_CHECK_EQUAL(in.nchannels(), c.nchannels);
+            ROI roi     = in.roi();
+            roi.chend   = c.ncompared;
+            auto result = ImageBufAlgo::compare(in, levels[m], 0.05f, 0.05f,
+                                                roi);
+            OIIO_CHECK_ASSERT(result.maxerror < 0.05);
+        }
+    }
+    Filesystem::remove("tmp_bcn.dds");
+}
+
+
+
+// Frames per second reading and writing 4K 10-bit RGB DPX, as delivered for
+// DI, to a file in the current directory.
+static void
+benchmark_dpx()
+{
+    ImageSpec spec(4096, 2160, 3, TypeUInt16);
+    spec.attribute("oiio:BitsPerSample", 10);
+    ImageBuf src(spec);
+    ImageBufAlgo::noise(src, "uniform", 0.0f, 1.0f);
+    std::vector<float> pixels(spec.image_pixels() * spec.nchannels);
+    Benchmarker bench;
+    bench.iterations(1).trials(5);
+    double t = bench("DPX 4K 10-bit write", [&]() {
+        src.write("tmp_bench.dpx");
+    });
+    std::cout << Strutil::fmt::format("  {:.1f} frames/s\n", 1.0 / t);
+    for (TypeDesc format : { TypeUInt16, TypeFloat }) {
+        t = bench(Strutil::fmt::format("DPX 4K 10-bit read to {}", format),
+                  [&]() {
+                      auto in = ImageInput::open("tmp_bench.dpx");
+                      if (in)
+                          in->read_image(0, 0, 0, 3, format, pixels.data());
+                  });
+        std::cout << Strutil::fmt::format("  {:.1f} frames/s\n", 1.0 / t);
+    }
+    Filesystem::remove("tmp_bench.dpx");
+}
+
+
+
+// The direct conversions of uint8 to half and uint16, and of uint16 to
+// uint8, must give exactly what going through float does, for every value
+// and for every length that leaves a different tail for their loops.
+static void
+test_convert_direct()
+{
+    std::cout << "Testing direct pixel value conversions\n";
+    std::vector<unsigned char> u8(256);
+    std::vector<unsigned short> u16(65536);
+    for (size_t i = 0; i < u8.size(); ++i)
+        u8[i] = (unsigned char)i;
+    for (size_t i = 0; i < u16.size(); ++i)
+        u16[i] = (unsigned short)i;
+    struct Pair {
+        TypeDesc from, to;
+        const void* src;
+        int n;
+    };
+    for (Pair p : { Pair { TypeUInt8, TypeHalf, u8.data(), 256 },
+                    Pair { TypeUInt8, TypeUInt16, u8.data(), 256 },
+                    Pair { TypeUInt16, TypeUInt8, u16.data(), 65536 } }) {
+        size_t srcsize = p.from.size(), dstsize = p.to.size();
+        std::vector<float> f(p.n);
+        std::vector<char> ref(p.n * dstsize), dst(p.n * dstsize);
+        OIIO_CHECK_ASSERT(
+            convert_pixel_values(p.from, p.src, TypeFloat, f.data(), p.n));
+        OIIO_CHECK_ASSERT(
+            convert_pixel_values(TypeFloat, f.data(), p.to, ref.data(), p.n));
+        OIIO_CHECK_ASSERT(
+            convert_pixel_values(p.from, p.src, p.to, dst.data(), p.n));
+        OIIO_CHECK_ASSERT(dst == ref);
+        // The last few values, at every length up to three 8-wide vectors,
+        // leave what follows them alone.
+        for (int len = 0; len <= 24; ++len) {
+            int start = p.n - len;
+            std::vector<char> part((len + 1) * dstsize, char(0x5a));
+            OIIO_CHECK_ASSERT(convert_pixel_values(
+                p.from, (const char*)p.src + start * srcsize, p.to,
+                part.data(), len));
+            OIIO_CHECK_ASSERT(std::equal(part.begin(),
+                                         part.begin() + len * dstsize,
+                                         ref.begin() + start * dstsize));
+            OIIO_CHECK_ASSERT(std::all_of(part.end() - dstsize, part.end(),
+                                          [](char c) { return c == 0x5a; }));
+        }
+    }
+}
+
+
+
+// Reading a misnamed file finds the right reader (and remembers it for the
+// next one), and a recycled ImageInput reads another file correctly.
+static void
+test_recycle_and_probe_cache()
+{
+    std::cout << "Testing ImageInput recycling and format probe caching\n";
+    ImageBuf a(ImageSpec(16, 8, 3, TypeUInt8));
+    ImageBuf b(ImageSpec(24, 12, 1, TypeUInt8));
+    ImageBufAlgo::fill(a, { 0.25f, 0.5f, 0.75f });
+    ImageBufAlgo::fill(b, { 1.0f });
+    // TIFF files with an extension of another format
+    OIIO_CHECK_ASSERT(a.write("tmp_misnamed_a.png", TypeUnknown, "tiff"));
+    OIIO_CHECK_ASSERT(b.write("tmp_misnamed_b.png", TypeUnknown, "tiff"));
+    for (const char* f : { "tmp_misnamed_a.png", "tmp_misnamed_b.png" }) {
+        auto in = ImageInput::open(f);
+        OIIO_CHECK_ASSERT(in && in->format_name() == std::string("tiff"));
+        if (in)
+            ImageInput::recycle(std::move(in));
+        OIIO_CHECK_ASSERT(!in);
+    }
+
+    auto in = ImageInput::open("tmp_misnamed_b.png");
+    OIIO_CHECK_ASSERT(in);
+    if (in) {
+        OIIO_CHECK_EQUAL(in->spec().width, 24);
+        OIIO_CHECK_EQUAL(in->spec().nchannels, 1);
+        unsigned char pixels[24 * 12];
+        OIIO_CHECK_ASSERT(in->read_image(0, 0, 0, 1, TypeUInt8, pixels));
+        OIIO_CHECK_EQUAL(int(pixels[24 * 12 - 1]), 255);
+        ImageInput::recycle(std::move(in));
+    }
+    ImageBuf r("tmp_misnamed_a.png");
+    OIIO_CHECK_ASSERT(r.read() && r.spec().width == 16);
+    OIIO_CHECK_EQUAL(r.getchannel(3, 3, 0, 2), 0.75f);
+    Filesystem::remove("tmp_misnamed_a.png");
+    Filesystem::remove("tmp_misnamed_b.png");
+}
+
+
+
 int
 main(int argc, char* argv[])
 {
@@ -549,6 +1000,17 @@ main(int argc, char* argv[])
 
     test_all_formats();
     test_read_tricky_sizes();
+    test_parallel_scanline_decode();
+    test_read_converted_subset();
+    test_headeronly_and_spec_index();
+    test_tiff_parallel_compression();
+    test_png_parallel_bands();
+    test_dpx_10bit_filled();
+    test_dds_bcn_output();
+    test_convert_direct();
+    test_recycle_and_probe_cache();
+    if (benchmark)
+        benchmark_dpx();
 
     return unit_test_failures;
 }
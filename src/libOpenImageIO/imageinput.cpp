@@ -6,6 +6,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <tsl/robin_map.h>
@@ -17,6 +18,7 @@
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/parallel.h>
 #include <OpenImageIO/strutil.h>
+#include <OpenImageIO/tracing.h>
 #include <OpenImageIO/typedesc.h>
 
 #include "imageio_pvt.h"
@@ -48,6 +50,36 @@ public:
     // The "local" proxy that we will create to use if the user didn't
     // supply a proxy for us to use.
     std::unique_ptr<Filesystem::IOProxy> m_io_local;
+    // The "oiio:mmap" hint from the config, or -1 to use "imageinput:mmap".
+    int m_mmap = -1;
+    // Conversion to the "oiio:WorkingColorSpace" hint of the config.
+    pvt::WorkingColorConversion m_working_color;
+
+    // Convert pixels just read, in the given format (UNKNOWN for native),
+    // from the file's color space to the working color space. Only reads
+    // of channels starting with RGB are converted.
+    bool to_working_color(ImageInput* in, string_view filespace,
+                          const ImageSpec& spec, int chbegin, int chend,
+                          int width, int height, int depth, TypeDesc format,
+                          void* data, stride_t xstride, stride_t ystride,
+                          stride_t zstride)
+    {
+        if (filespace.empty() || chbegin != 0 || chend < 3)
+            return true;
+        if (format == TypeDesc::UNKNOWN) {
+            if (spec.channelformats.size())
+                return true;  // Can't convert mixed channel formats
+            format = spec.format;
+        }
+        std::string err;
+        if (!m_working_color.apply(filespace, false, chend, width, height,
+                                   depth, format, data, xstride, ystride,
+                                   zstride, in->threads(), err)) {
+            in->errorfmt("{}", err);
+            return false;
+        }
+        return true;
+    }
 };
 
 
@@ -108,7 +140,12 @@ ImageInput::valid_file(const std::string& filename) const
 {
     ImageInput* self = const_cast<ImageInput*>(this);
 
-    if (self->supports("ioproxy")) {
+    if (self->supports("ioproxy") && Filesystem::is_url(filename)) {
+        std::string err;
+        std::unique_ptr<Filesystem::IOProxy> io = open_input_url(filename,
+                                                                 err);
+        return io && valid_file(io.get());
+    } else if (self->supports("ioproxy")) {
         Filesystem::IOFile io(filename, Filesystem::IOProxy::Read);
         return valid_file(&io);
     } else {
@@ -166,6 +203,9 @@ ImageInput::open(const std::string& filename, const ImageSpec* config,
         if (err.size())
             OIIO::errorfmt("{}", err);
         in.reset();
+    } else {
+        in->m_impl->m_working_color.set_working_colorspace(
+            config->get_string_attribute("oiio:WorkingColorSpace"));
     }
 
     return in;
@@ -236,9 +276,16 @@ ImageInput::read_scanline(int y, int z, TypeDesc format, void* data,
 
     // If user's format and strides are set up to accept the native data
     // layout, read the scanline directly into the user's buffer.
+    std::string filespace;
+    if (m_impl->m_working_color.active())
+        filespace = m_spec.get_string_attribute("oiio:ColorSpace");
     if (native_data && contiguous)
         return read_native_scanline(current_subimage(), current_miplevel(), y,
-                                    z, data);
+                                    z, data)
+               && m_impl->to_working_color(this, filespace, m_spec, 0,
+                                           m_spec.nchannels, m_spec.width, 1,
+                                           1, format, data, xstride,
+                                           AutoStride, AutoStride);
 
     // Complex case -- either changing data type or stride
     int scanline_values = m_spec.width * m_spec.nchannels;
@@ -277,7 +324,11 @@ ImageInput::read_scanline(int y, int z, TypeDesc format, void* data,
     if (!ok)
         errorfmt("ImageInput::read_scanline : no support for format {}",
                  m_spec.format);
-    return ok;
+    return ok
+           && m_impl->to_working_color(this, filespace, m_spec, 0,
+                                       m_spec.nchannels, m_spec.width, 1, 1,
+                                       format, data, xstride, AutoStride,
+                                       AutoStride);
 }
 
 
@@ -290,6 +341,7 @@ ImageInput::read_scanlines(int subimage, int miplevel, int ybegin, int yend,
     pvt::LoggedTimer logtime("II::read_scanlines");
     ImageSpec spec;
     int rps = 0;
+    std::string filespace;
     {
         // We need to lock briefly to retrieve rps from the spec
         lock_guard lock(*this);
@@ -303,6 +355,8 @@ ImageInput::read_scanlines(int subimage, int miplevel, int ybegin, int yend,
         if (!spec.tile_width)
             rps = m_spec.get_int_attribute("tiff:RowsPerStrip", 64);
         // FIXME: does the above search of metadata have a significant cost?
+        if (m_impl->m_working_color.active())
+            filespace = m_spec.get_string_attribute("oiio:ColorSpace");
     }
     if (spec.image_bytes() < 1) {
         errorfmt("Invalid image size {} x {} ({} chans)", m_spec.width,
@@ -331,16 +385,53 @@ ImageInput::read_scanlines(int subimage, int miplevel, int ybegin, int yend,
     bool contiguous                = (xstride == (stride_t)buffer_pixel_bytes
                        && ystride == (stride_t)buffer_scanline_bytes);
 
+    // Readers that can decode different scanlines at the same time are
+    // given pieces of a large range, by separate threads. (The pieces are
+    // small enough not to be split again.)
+    int piece = round_to_multiple(32, std::max(rps, 1));
+    if (yend - ybegin > piece && threads() != 1
+        && supports("parallel_scanline_decode")) {
+        std::atomic<bool> ok(true);
+        std::mutex errmutex;
+        std::string err;
+        int npieces = (yend - ybegin + piece - 1) / piece;
+        parallel_for(
+            0, npieces,
+            [&](int64_t p) {
+                int y0 = ybegin + int(p) * piece;
+                int y1 = std::min(y0 + piece, yend);
+                if (!ok
+                    || read_scanlines(subimage, miplevel, y0, y1, z, chbegin,
+                                      chend, format,
+                                      (char*)data + (y0 - ybegin) * ystride,
+                                      xstride, ystride))
+                    return;
+                // Errors are kept per thread, so pass it to the caller's.
+                ok = false;
+                std::lock_guard<std::mutex> lock(errmutex);
+                if (err.empty())
+                    err = geterror();
+            },
+            paropt(threads()));
+        if (!ok)
+            errorfmt("{}", err.size() ? err : std::string("read failed"));
+        return ok;
+    }
+
     // no_type_convert is true if asking for data in the native format
     bool no_type_convert = (format == spec.format
                             && spec.channelformats.empty());
     if ((native || no_type_convert) && contiguous) {
-        if (chbegin == 0 && chend == spec.nchannels)
-            return read_native_scanlines(subimage, miplevel, ybegin, yend, z,
-                                         data);
-        else
-            return read_native_scanlines(subimage, miplevel, ybegin, yend, z,
-                                         chbegin, chend, data);
+        bool ok = (chbegin == 0 && chend == spec.nchannels)
+                      ? read_native_scanlines(subimage, miplevel, ybegin, yend,
+                                              z, data)
+                      : read_native_scanlines(subimage, miplevel, ybegin, yend,
+                                              z, chbegin, chend, data);
+        return ok
+               && m_impl->to_working_color(this, filespace, spec, chbegin,
+                                           chend, spec.width, yend - ybegin,
+                                           1, format, data, xstride, ystride,
+                                           AutoStride);
     }
 
     // No such luck.  Read scanlines in chunks.
@@ -352,8 +443,7 @@ ImageInput::read_scanlines(int subimage, int miplevel, int ybegin, int yend,
     chunk     = round_to_multiple(chunk, rps);
     std::unique_ptr<char[]> buf(new char[chunk * native_scanline_bytes]);
 
-    bool ok             = true;
-    int scanline_values = spec.width * nchans;
+    bool ok = true;
     for (; ok && ybegin < yend; ybegin += chunk) {
         int y1 = std::min(ybegin + chunk, yend);
         ok &= read_native_scanlines(subimage, miplevel, ybegin, y1, z, chbegin,
@@ -361,47 +451,70 @@ ImageInput::read_scanlines(int subimage, int miplevel, int ybegin, int yend,
         if (!ok)
             break;
 
-        int nscanlines  = y1 - ybegin;
-        int chunkvalues = scanline_values * nscanlines;
-        if (spec.channelformats.empty()) {
-            // No per-channel formats -- do the conversion in one shot
-            if (contiguous) {
-                ok = convert_pixel_values(spec.format, &buf[0], format, data,
-                                          chunkvalues);
-            } else {
-                ok = parallel_convert_image(nchans, spec.width, nscanlines, 1,
-                                            &buf[0], spec.format, AutoStride,
-                                            AutoStride, AutoStride, data,
-                                            format, xstride, ystride, zstride,
-                                            threads());
-            }
+        int nscanlines = y1 - ybegin;
+        // Convert to the working color space while this chunk is in cache
+        ok = convert_native_scanlines(spec, chbegin, chend, nscanlines,
+                                      &buf[0], format, data, xstride, ystride,
+                                      threads())
+             && m_impl->to_working_color(this, filespace, spec, chbegin,
+                                         chend, spec.width, nscanlines, 1,
+                                         format, data, xstride, ystride,
+                                         AutoStride);
+        data = (char*)data + ystride * nscanlines;
+    }
+    return ok;
+}
+
+
+
+bool
+ImageInput::convert_native_scanlines(const ImageSpec& spec, int chbegin,
+                                     int chend, int nscanlines,
+                                     const void* native, TypeDesc format,
+                                     void* data, stride_t xstride,
+                                     stride_t ystride, int nthreads) const
+{
+    int nchans                = chend - chbegin;
+    size_t native_pixel_bytes = spec.pixel_bytes(chbegin, chend, true);
+    const char* buf           = (const char*)native;
+    bool ok                   = true;
+    if (spec.channelformats.empty()) {
+        // No per-channel formats -- do the conversion in one shot
+        stride_t pixel_bytes = stride_t(format.size() * nchans);
+        if (xstride == pixel_bytes && ystride == pixel_bytes * spec.width) {
+            ok = convert_pixel_values(spec.format, buf, format, data,
+                                      spec.width * nchans * nscanlines);
         } else {
-            // Per-channel formats -- have to convert/copy channels individually
-            size_t offset = 0;
-            int n         = 1;
-            for (int c = 0; ok && c < nchans; c += n) {
-                TypeDesc chanformat = spec.channelformats[c + chbegin];
-                // Try to do more than one channel at a time to improve
-                // memory coherence, if there are groups of adjacent
-                // channels needing the same data conversion.
-                for (n = 1; c + n < nchans; ++n)
-                    if (spec.channelformats[c + chbegin + n] != chanformat)
-                        break;
-                ok = parallel_convert_image(n /* channels */, spec.width,
-                                            nscanlines, 1, &buf[offset],
-                                            chanformat, native_pixel_bytes,
-                                            AutoStride, AutoStride,
-                                            (char*)data + c * format.size(),
-                                            format, xstride, ystride, zstride,
-                                            threads());
-                offset += n * chanformat.size();
-            }
+            ok = parallel_convert_image(nchans, spec.width, nscanlines, 1, buf,
+                                        spec.format, AutoStride, AutoStride,
+                                        AutoStride, data, format, xstride,
+                                        ystride, AutoStride, nthreads);
+        }
+    } else {
+        // Per-channel formats -- have to convert/copy channels individually
+        size_t offset = 0;
+        int n         = 1;
+        for (int c = 0; ok && c < nchans; c += n) {
+            TypeDesc chanformat = spec.channelformats[c + chbegin];
+            // Try to do more than one channel at a time to improve
+            // memory coherence, if there are groups of adjacent
+            // channels needing the same data conversion.
+            for (n = 1; c + n < nchans; ++n)
+                if (spec.channelformats[c + chbegin + n] != chanformat)
+                    break;
+            ok = parallel_convert_image(n /* channels */, spec.width,
+                                        nscanlines, 1, buf + offset,
+                                        chanformat, native_pixel_bytes,
+                                        AutoStride, AutoStride,
+                                        (char*)data + c * format.size(),
+                                        format, xstride, ystride, AutoStride,
+                                        nthreads);
+            offset += n * chanformat.size();
         }
-        if (!ok)
-            errorfmt("ImageInput::read_scanlines : no support for format {}",
-                     spec.format);
-        data = (char*)data + ystride * nscanlines;
     }
+    if (!ok)
+        errorfmt("ImageInput::read_scanlines : no support for format {}",
+                 spec.format);
     return ok;
 }
 
@@ -509,9 +622,17 @@ ImageInput::read_tile(int x, int y, int z, TypeDesc format, void* data,
 
     // If user's format and strides are set up to accept the native data
     // layout, read the tile directly into the user's buffer.
+    std::string filespace;
+    if (m_impl->m_working_color.active())
+        filespace = m_spec.get_string_attribute("oiio:ColorSpace");
     if (native_data && contiguous)
         return read_native_tile(current_subimage(), current_miplevel(), x, y, z,
-                                data);  // Simple case
+                                data)  // Simple case
+               && m_impl->to_working_color(this, filespace, m_spec, 0,
+                                           m_spec.nchannels, m_spec.tile_width,
+                                           m_spec.tile_height,
+                                           m_spec.tile_depth, format, data,
+                                           xstride, ystride, zstride);
 
     // Complex case -- either changing data type or stride
     size_t tile_values = (size_t)m_spec.tile_pixels() * m_spec.nchannels;
@@ -549,7 +670,12 @@ ImageInput::read_tile(int x, int y, int z, TypeDesc format, void* data,
     if (!ok)
         errorfmt("ImageInput::read_tile : no support for format {}",
                  m_spec.format);
-    return ok;
+    return ok
+           && m_impl->to_working_color(this, filespace, m_spec, 0,
+                                       m_spec.nchannels, m_spec.tile_width,
+                                       m_spec.tile_height, m_spec.tile_depth,
+                                       format, data, xstride, ystride,
+                                       zstride);
 }
 
 
@@ -560,6 +686,7 @@ ImageInput::read_tiles(int subimage, int miplevel, int xbegin, int xend,
                        int chend, TypeDesc format, void* data, stride_t xstride,
                        stride_t ystride, stride_t zstride)
 {
+    OIIO_TRACE_SPAN("II::read_tiles");
     ImageSpec spec = spec_dimensions(subimage, miplevel);  // thread-safe
     if (spec.undefined())
         return false;
@@ -567,6 +694,12 @@ ImageInput::read_tiles(int subimage, int miplevel, int xbegin, int xend,
     chend = clamp(chend, chbegin + 1, spec.nchannels);
     if (!spec.valid_tile_range(xbegin, xend, ybegin, yend, zbegin, zend))
         return false;
+    std::string filespace;
+    if (m_impl->m_working_color.active()) {
+        lock_guard lock(*this);
+        if (seek_subimage(subimage, miplevel))
+            filespace = m_spec.get_string_attribute("oiio:ColorSpace");
+    }
 
     int nchans = chend - chbegin;
     // native_pixel_bytes is the size of a pixel in the FILE, including
@@ -602,13 +735,18 @@ ImageInput::read_tiles(int subimage, int miplevel, int xbegin, int xend,
         && (xend - xbegin) == nxtiles * spec.tile_width
         && (yend - ybegin) == nytiles * spec.tile_height
         && (zend - zbegin) == nztiles * spec.tile_depth) {
-        if (chbegin == 0 && chend == spec.nchannels)
-            return read_native_tiles(subimage, miplevel, xbegin, xend, ybegin,
-                                     yend, zbegin, zend,
-                                     data);  // Simple case
-        else
-            return read_native_tiles(subimage, miplevel, xbegin, xend, ybegin,
-                                     yend, zbegin, zend, chbegin, chend, data);
+        bool ok = (chbegin == 0 && chend == spec.nchannels)
+                      ? read_native_tiles(subimage, miplevel, xbegin, xend,
+                                          ybegin, yend, zbegin, zend,
+                                          data)  // Simple case
+                      : read_native_tiles(subimage, miplevel, xbegin, xend,
+                                          ybegin, yend, zbegin, zend, chbegin,
+                                          chend, data);
+        return ok
+               && m_impl->to_working_color(this, filespace, spec, chbegin,
+                                           chend, xend - xbegin, yend - ybegin,
+                                           zend - zbegin, format, data,
+                                           xstride, ystride, zstride);
     }
 
     // No such luck.  Just punt and read tiles individually.
@@ -655,6 +793,12 @@ ImageInput::read_tiles(int subimage, int miplevel, int xbegin, int xend,
                                   native_pixelsize * x_full_tiles
                                       * spec.tile_width * spec.tile_height,
                                   tilestart, format, xstride, ystride, zstride);
+                // The rest of the row is converted by read_tile().
+                ok = ok
+                     && m_impl->to_working_color(this, filespace, spec, 0,
+                                                 chend, x_full_tile_end - x,
+                                                 yh, zd, format, tilestart,
+                                                 xstride, ystride, zstride);
                 tilestart += x_full_tiles * spec.tile_width * xstride;
                 x += x_full_tiles * spec.tile_width;
             }
@@ -995,6 +1139,15 @@ ImageInput::read_native_deep_image(int subimage, int miplevel,
 
 
 
+bool
+ImageInput::empty_tiles(int /*subimage*/, int /*miplevel*/,
+                        std::vector<uint64_t>& /*empty*/, void* /*background*/)
+{
+    return false;
+}
+
+
+
 int
 ImageInput::send_to_input(const char* /*format*/, ...)
 {
@@ -1144,6 +1297,43 @@ ImageInput::ioproxy_retrieve_from_config(const ImageSpec& config)
 {
     if (auto p = config.find_attribute("oiio:ioproxy", TypeDesc::PTR))
         set_ioproxy(p->get<Filesystem::IOProxy*>());
+    m_impl->m_mmap = config.get_int_attribute("oiio:mmap", -1);
+}
+
+
+
+std::unique_ptr<Filesystem::IOProxy>
+pvt::open_input_url(string_view url, std::string& err)
+{
+    if (!imageinput_allow_urls) {
+        // Off by default, so that an application that opens file names it
+        // was given can't be made to fetch from the network instead.
+        err = Strutil::fmt::format(
+            "Could not open \"{}\": reading URLs is disabled (see the "
+            "\"imageinput:allow_urls\" attribute)",
+            url);
+        return {};
+    }
+    size_t query = url.find('?');
+    if (query != string_view::npos
+        && (Strutil::contains(url.substr(query), "Signature=")
+            || Strutil::contains(url.substr(query), "X-Amz-Credential="))) {
+        static std::once_flag warned;
+        std::call_once(warned, [&]() {
+            Strutil::print(stderr,
+                           "OpenImageIO WARNING: presigned URLs are read "
+                           "over plain HTTP, so anyone who can watch the "
+                           "network can read and reuse their signatures "
+                           "until they expire ({})\n",
+                           url.substr(0, query));
+        });
+    }
+    std::unique_ptr<Filesystem::IOProxy> io = Filesystem::open_url(url);
+    if (!io->opened()) {
+        err = io->error();
+        return {};
+    }
+    return io;
 }
 
 
@@ -1152,6 +1342,28 @@ bool
 ImageInput::ioproxy_use_or_open(string_view name)
 {
     Filesystem::IOProxy*& m_io(m_impl->m_io);
+    int use_mmap = m_impl->m_mmap >= 0 ? m_impl->m_mmap : pvt::imageinput_mmap;
+    if (!m_io && Filesystem::is_url(name)) {
+        // Read just the parts of it that we need, over the network.
+        std::string err;
+        m_impl->m_io_local = open_input_url(name, err);
+        if (!m_impl->m_io_local) {
+            errorfmt("{}", err);
+            ioproxy_clear();
+            return false;
+        }
+        m_io = m_impl->m_io_local.get();
+    }
+    if (!m_io && use_mmap) {
+        // Map the file if asked to and if it can be, or else fall back to
+        // an IOFile.
+        std::unique_ptr<Filesystem::IOProxy> mapped(
+            new Filesystem::IOMMap(name));
+        if (mapped->opened()) {
+            m_io               = mapped.get();
+            m_impl->m_io_local = std::move(mapped);
+        }
+    }
     if (!m_io) {
         // If no proxy was supplied, create an IOFile
         m_io = new Filesystem::IOFile(name, Filesystem::IOProxy::Mode::Read);
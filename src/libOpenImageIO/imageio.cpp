@@ -13,6 +13,7 @@
 #include <OpenImageIO/fmath.h>
 #include <OpenImageIO/hash.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/metrics.h>
 #include <OpenImageIO/optparser.h>
 #include <OpenImageIO/parallel.h>
 #include <OpenImageIO/strutil.h>
@@ -57,6 +58,8 @@ int limit_channels(1024);
 int limit_imagesize_MB(std::min(32 * 1024,
                                 int(Sysutil::physical_memory() >> 20)));
 int imageinput_strict(0);
+int imageinput_mmap(0);
+int imageinput_allow_urls(0);
 ustring font_searchpath(Sysutil::getenv("OPENIMAGEIO_FONTS"));
 ustring plugin_searchpath(OIIO_DEFAULT_PLUGIN_SEARCHPATH);
 std::string format_list;         // comma-separated list of all formats
@@ -66,6 +69,9 @@ std::string extension_list;      // list of all extensions for all formats
 std::string library_list;        // list of all libraries for all formats
 int oiio_log_times = Strutil::stoi(Sysutil::getenv("OPENIMAGEIO_LOG_TIMES"));
 std::vector<float> oiio_missingcolor;
+atomic_ll memory_budget(0);
+atomic_ll DD_mem_current(0);
+atomic_ll IC_mem_current(0);
 }  // namespace pvt
 
 using namespace pvt;
@@ -148,10 +154,70 @@ bool force_global_opts = []() {
     return true;
 }();
 
+
+
+
+// The ImageCaches that can be asked to free tiles to stay within the
+// memory budget. (Never destroyed, since caches may outlive statics.)
+struct BudgetCaches {
+    std::mutex mutex;
+    std::vector<std::pair<const void*, std::function<void(long long)>>> caches;
+};
+
+static BudgetCaches&
+budget_caches()
+{
+    static BudgetCaches* caches = new BudgetCaches;
+    return *caches;
+}
+
 }  // namespace
 
 
 
+void
+pvt::memory_budget_reserve(long long bytes)
+{
+    if (memory_over_budget(bytes) <= 0)
+        return;
+    BudgetCaches& bc(budget_caches());
+    std::lock_guard<std::mutex> lock(bc.mutex);
+    for (auto& cache : bc.caches) {
+        long long over = memory_over_budget(bytes);
+        if (over <= 0)
+            break;
+        cache.second(over);
+    }
+}
+
+
+
+void
+pvt::memory_budget_add_cache(const void* cache,
+                             std::function<void(long long bytes)> release)
+{
+    BudgetCaches& bc(budget_caches());
+    std::lock_guard<std::mutex> lock(bc.mutex);
+    bc.caches.emplace_back(cache, std::move(release));
+}
+
+
+
+void
+pvt::memory_budget_remove_cache(const void* cache)
+{
+    BudgetCaches& bc(budget_caches());
+    std::lock_guard<std::mutex> lock(bc.mutex);
+    for (size_t i = 0; i < bc.caches.size(); ++i) {
+        if (bc.caches[i].first == cache) {
+            bc.caches.erase(bc.caches.begin() + i);
+            break;
+        }
+    }
+}
+
+
+
 // Return a comma-separated list of all the important SIMD/capabilities
 // supported by the hardware we're running on right now.
 static std::string
@@ -174,6 +240,7 @@ hw_simd_caps()
     if (cpu_has_avx512cd())    caps.emplace_back ("avx512cd");
     if (cpu_has_avx512bw())    caps.emplace_back ("avx512bw");
     if (cpu_has_avx512vl())    caps.emplace_back ("avx512vl");
+    if (cpu_has_neon())        caps.emplace_back ("neon");
     if (cpu_has_fma())         caps.emplace_back ("fma");
     if (cpu_has_f16c())        caps.emplace_back ("f16c");
     if (cpu_has_popcnt())      caps.emplace_back ("popcnt");
@@ -327,6 +394,24 @@ log_time(string_view key, const Timer& timer, int count)
 
 
 
+void
+pvt::record_op_time(string_view name, double seconds)
+{
+    // Remember the histogram of the last operation this thread recorded,
+    // since the same one is usually timed many times in a row.
+    thread_local std::string last_name;
+    thread_local Metrics::Histogram* last_hist = nullptr;
+    if (!last_hist || name != last_name) {
+        last_name = name;
+        last_hist = &Metrics::histogram("oiio_op_seconds",
+                                        "Duration of OIIO operations",
+                                        Metrics::label("op", name));
+    }
+    last_hist->record(seconds);
+}
+
+
+
 bool
 attribute(string_view name, TypeDesc type, const void* val)
 {
@@ -342,6 +427,10 @@ attribute(string_view name, TypeDesc type, const void* val)
         default_thread_pool()->resize(ot - 1);
         return true;
     }
+    if (name == "io_threads" && type == TypeInt) {
+        io_thread_pool()->resize(OIIO::clamp(*(const int*)val, 0, maxthreads));
+        return true;
+    }
     if (Strutil::starts_with(name, "gpu:")
         || Strutil::starts_with(name, "cuda:")) {
         return pvt::gpu_attribute(name, type, val);
@@ -409,10 +498,67 @@ attribute(string_view name, TypeDesc type, const void* val)
         imagebuf_use_imagecache = *(const int*)val;
         return true;
     }
+    if (name == "imagebuf:pool_MB" && type == TypeInt) {
+        imagebuf_pool_MB = std::max(*(const int*)val, 0);
+        imagebuf_pool_trim();
+        return true;
+    }
+    if (name == "deepdata:pool_MB" && type == TypeInt) {
+        deepdata_pool_MB = std::max(*(const int*)val, 0);
+        deepdata_pool_trim();
+        return true;
+    }
+    if (name == "max_memory_MB" && type == TypeInt) {
+        memory_budget = std::max(*(const int*)val, 0) * (1LL << 20);
+        memory_budget_reserve(0);
+        return true;
+    }
+    if (name == "max_memory_MB" && type == TypeFloat) {
+        memory_budget = (long long)(std::max(*(const float*)val, 0.0f)
+                                    * (1024.0 * 1024.0));
+        memory_budget_reserve(0);
+        return true;
+    }
+    if (name == "imagebuf:hugepages" && type == TypeInt) {
+        imagebuf_hugepages = *(const int*)val;
+        return true;
+    }
+    if (name == "imagebuf:scanline_alignment" && type == TypeInt) {
+        int align = *(const int*)val;
+        // Only powers of 2 make sense, and 0 turns it off.
+        imagebuf_scanline_alignment = align > 0 && !(align & (align - 1))
+                                          ? align
+                                          : 0;
+        return true;
+    }
+    if (name == "imagebuf:pad_scanlines" && type == TypeInt) {
+        imagebuf_pad_scanlines = *(const int*)val;
+        return true;
+    }
+    if (name == "imagebuf:copy_on_write" && type == TypeInt) {
+        imagebuf_copy_on_write = *(const int*)val;
+        return true;
+    }
+    if (name == "imagebufalgo:fastpaths" && type == TypeInt) {
+        imagebufalgo_fastpaths = *(const int*)val;
+        return true;
+    }
+    if (name == "imagebufalgo:colorconvert_lut3d" && type == TypeInt) {
+        imagebufalgo_colorconvert_lut3d = std::max(0, *(const int*)val);
+        return true;
+    }
     if (name == "imageinput:strict" && type == TypeInt) {
         imageinput_strict = *(const int*)val;
         return true;
     }
+    if (name == "imageinput:mmap" && type == TypeInt) {
+        imageinput_mmap = *(const int*)val;
+        return true;
+    }
+    if (name == "imageinput:allow_urls" && type == TypeInt) {
+        imageinput_allow_urls = *(const int*)val;
+        return true;
+    }
     if (name == "use_tbb" && type == TypeInt) {
         oiio_use_tbb = *(const int*)val;
         return true;
@@ -425,6 +571,13 @@ attribute(string_view name, TypeDesc type, const void* val)
         oiio_log_times = *(const int*)val;
         return true;
     }
+    if (name == "metrics" && type == TypeInt) {
+        if (*(const int*)val)
+            Metrics::start();
+        else
+            Metrics::stop();
+        return true;
+    }
     if (name == "missingcolor" && type.basetype == TypeDesc::FLOAT) {
         // missingcolor as float array
         oiio_missingcolor.assign((const float*)val,
@@ -455,6 +608,10 @@ getattribute(string_view name, TypeDesc type, void* val)
         *(int*)val = oiio_threads;
         return true;
     }
+    if (name == "io_threads" && type == TypeInt) {
+        *(int*)val = io_thread_pool()->size();
+        return true;
+    }
     if (name == "version" && type == TypeString) {
         *(ustring*)val = ustring(OIIO_VERSION_STRING);
         return true;
@@ -479,32 +636,27 @@ getattribute(string_view name, TypeDesc type, void* val)
         return true;
     }
     if (name == "format_list" && type == TypeString) {
-        if (format_list.empty())
-            pvt::catalog_all_plugins(plugin_searchpath.string());
+        pvt::catalog_all_plugins(plugin_searchpath.string());
         *(ustring*)val = ustring(format_list);
         return true;
     }
     if (name == "input_format_list" && type == TypeString) {
-        if (input_format_list.empty())
-            pvt::catalog_all_plugins(plugin_searchpath.string());
+        pvt::catalog_all_plugins(plugin_searchpath.string());
         *(ustring*)val = ustring(input_format_list);
         return true;
     }
     if (name == "output_format_list" && type == TypeString) {
-        if (output_format_list.empty())
-            pvt::catalog_all_plugins(plugin_searchpath.string());
+        pvt::catalog_all_plugins(plugin_searchpath.string());
         *(ustring*)val = ustring(output_format_list);
         return true;
     }
     if (name == "extension_list" && type == TypeString) {
-        if (extension_list.empty())
-            pvt::catalog_all_plugins(plugin_searchpath.string());
+        pvt::catalog_all_plugins(plugin_searchpath.string());
         *(ustring*)val = ustring(extension_list);
         return true;
     }
     if (name == "library_list" && type == TypeString) {
-        if (library_list.empty())
-            pvt::catalog_all_plugins(plugin_searchpath.string());
+        pvt::catalog_all_plugins(plugin_searchpath.string());
         *(ustring*)val = ustring(library_list);
         return true;
     }
@@ -592,10 +744,58 @@ getattribute(string_view name, TypeDesc type, void* val)
         *(int*)val = imagebuf_use_imagecache;
         return true;
     }
+    if (name == "imagebuf:pool_MB" && type == TypeInt) {
+        *(int*)val = imagebuf_pool_MB;
+        return true;
+    }
+    if (name == "deepdata:pool_MB" && type == TypeInt) {
+        *(int*)val = deepdata_pool_MB;
+        return true;
+    }
+    if (name == "max_memory_MB" && type == TypeInt) {
+        *(int*)val = int(memory_budget >> 20);
+        return true;
+    }
+    if (name == "max_memory_MB" && type == TypeFloat) {
+        *(float*)val = float(memory_budget / (1024.0 * 1024.0));
+        return true;
+    }
+    if (name == "imagebuf:hugepages" && type == TypeInt) {
+        *(int*)val = imagebuf_hugepages;
+        return true;
+    }
+    if (name == "imagebuf:scanline_alignment" && type == TypeInt) {
+        *(int*)val = imagebuf_scanline_alignment;
+        return true;
+    }
+    if (name == "imagebuf:pad_scanlines" && type == TypeInt) {
+        *(int*)val = imagebuf_pad_scanlines;
+        return true;
+    }
+    if (name == "imagebuf:copy_on_write" && type == TypeInt) {
+        *(int*)val = imagebuf_copy_on_write;
+        return true;
+    }
+    if (name == "imagebufalgo:fastpaths" && type == TypeInt) {
+        *(int*)val = imagebufalgo_fastpaths;
+        return true;
+    }
+    if (name == "imagebufalgo:colorconvert_lut3d" && type == TypeInt) {
+        *(int*)val = imagebufalgo_colorconvert_lut3d;
+        return true;
+    }
     if (name == "imageinput:strict" && type == TypeInt) {
         *(int*)val = imageinput_strict;
         return true;
     }
+    if (name == "imageinput:mmap" && type == TypeInt) {
+        *(int*)val = imageinput_mmap;
+        return true;
+    }
+    if (name == "imageinput:allow_urls" && type == TypeInt) {
+        *(int*)val = imageinput_allow_urls;
+        return true;
+    }
     if (name == "use_tbb" && type == TypeInt) {
         *(int*)val = oiio_use_tbb;
         return true;
@@ -608,6 +808,33 @@ getattribute(string_view name, TypeDesc type, void* val)
         *(int*)val = oiio_log_times;
         return true;
     }
+    if (name == "metrics" && type == TypeInt) {
+        *(int*)val = Metrics::enabled();
+        return true;
+    }
+    if ((name == "metrics" || name == "metrics:openmetrics")
+        && type == TypeString) {
+        *(ustring*)val = ustring(Metrics::text(name == "metrics:openmetrics"));
+        return true;
+    }
+    if (Strutil::starts_with(name, "metric:")) {
+        double v = 0.0;
+        if (!Metrics::value(name.substr(7), v))
+            return false;
+        if (type == TypeFloat) {
+            *(float*)val = float(v);
+            return true;
+        }
+        if (type == TypeDesc::DOUBLE) {
+            *(double*)val = v;
+            return true;
+        }
+        if (type == TypeDesc::INT64) {
+            *(int64_t*)val = int64_t(v);
+            return true;
+        }
+        return false;
+    }
     if (name == "timing_report" && type == TypeString) {
         *(ustring*)val = ustring(timing_log.report());
         return true;
@@ -670,6 +897,19 @@ getattribute(string_view name, TypeDesc type, void* val)
         *(long long*)val = IB_local_mem_peak;
         return true;
     }
+    if (name == "IB_pool_mem_current" && type == TypeInt64) {
+        *(long long*)val = IB_pool_mem_current;
+        return true;
+    }
+    if (name == "DD_mem_current" && type == TypeInt64) {
+        *(long long*)val = DD_mem_current;
+        return true;
+    }
+    if (name == "total_mem_current" && type == TypeInt64) {
+        *(long long*)val = IB_local_mem_current + DD_mem_current
+                           + IC_mem_current;
+        return true;
+    }
     if (name == "IB_total_open_time" && type == TypeFloat) {
         *(float*)val = IB_total_open_time;
         return true;
@@ -770,6 +1010,7 @@ pvt::contiguize(const void* src, int nchannels, stride_t xstride,
 
 
 
+OIIO_SIMD_DISPATCH_CLONES
 const float*
 pvt::convert_to_float(const void* src, float* dst, int nvals, TypeDesc format)
 {
@@ -802,6 +1043,7 @@ pvt::convert_to_float(const void* src, float* dst, int nvals, TypeDesc format)
 
 
 
+OIIO_SIMD_DISPATCH_CLONES
 const void*
 pvt::convert_from_float(const float* src, void* dst, size_t nvals,
                         TypeDesc format)
@@ -850,6 +1092,96 @@ pvt::parallel_convert_from_float(const float* src, void* dst, size_t nvals,
 
 
 
+namespace {
+
+// Convert float values to 'dst_type', returning false if it is not a type we
+// know how to convert to.
+OIIO_SIMD_DISPATCH_CLONES
+bool
+convert_from_float_values(const float* src, void* dst, int n,
+                          TypeDesc dst_type)
+{
+    switch (dst_type.basetype) {
+    case TypeDesc::UINT8: convert_type(src, (unsigned char*)dst, n); break;
+    case TypeDesc::UINT16: convert_type(src, (unsigned short*)dst, n); break;
+    case TypeDesc::HALF: convert_type(src, (half*)dst, n); break;
+    case TypeDesc::INT8: convert_type(src, (char*)dst, n); break;
+    case TypeDesc::INT16: convert_type(src, (short*)dst, n); break;
+    case TypeDesc::INT: convert_type(src, (int*)dst, n); break;
+    case TypeDesc::UINT: convert_type(src, (unsigned int*)dst, n); break;
+    case TypeDesc::INT64: convert_type(src, (long long*)dst, n); break;
+    case TypeDesc::UINT64:
+        convert_type(src, (unsigned long long*)dst, n);
+        break;
+    case TypeDesc::DOUBLE: convert_type(src, (double*)dst, n); break;
+    default: return false;  // unknown format
+    }
+    return true;
+}
+
+
+
+// The integer rescalings vectorize well, and much more so with AVX2.
+OIIO_SIMD_DISPATCH_CLONES
+void
+convert_uint8_to_uint16(const uint8_t* s, uint16_t* d, int n)
+{
+    for (int i = 0; i < n; ++i)
+        d[i] = uint16_t(s[i] * 257);
+}
+
+
+
+OIIO_SIMD_DISPATCH_CLONES
+void
+convert_uint16_to_uint8(const uint16_t* s, uint8_t* d, int n)
+{
+    // Rounding x/257 this way is exact, since it's never a tie.
+    for (int i = 0; i < n; ++i)
+        d[i] = uint8_t((uint32_t(s[i]) + 128) / 257);
+}
+
+
+
+// Direct conversions between the common integer types and half, giving
+// the same results as going through float, but without the second pass.
+// Return false if there isn't one for this pair of types.
+bool
+convert_direct(TypeDesc src_type, const void* src, TypeDesc dst_type,
+               void* dst, int n)
+{
+    if (src_type == TypeUInt8 && dst_type == TypeHalf) {
+        // Only 256 possible values, so look them up.
+        struct Table {
+            half vals[256];
+            Table()
+            {
+                for (int i = 0; i < 256; ++i)
+                    vals[i] = half(float(i) * (1.0f / 255.0f));
+            }
+        };
+        static const Table table;
+        const uint8_t* s = (const uint8_t*)src;
+        half* d          = (half*)dst;
+        for (int i = 0; i < n; ++i)
+            d[i] = table.vals[s[i]];
+        return true;
+    }
+    if (src_type == TypeUInt8 && dst_type == TypeUInt16) {
+        convert_uint8_to_uint16((const uint8_t*)src, (uint16_t*)dst, n);
+        return true;
+    }
+    if (src_type == TypeUInt16 && dst_type == TypeUInt8) {
+        convert_uint16_to_uint8((const uint16_t*)src, (uint8_t*)dst, n);
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+
+
 bool
 convert_pixel_values(TypeDesc src_type, const void* src, TypeDesc dst_type,
                      void* dst, int n)
@@ -868,36 +1200,24 @@ convert_pixel_values(TypeDesc src_type, const void* src, TypeDesc dst_type,
 
     // Conversion is to a non-float type
 
-    std::unique_ptr<float[]> tmp;  // In case we need a lot of temp space
-    float* buf = (float*)src;
-    if (src_type != TypeFloat) {
-        // If src is also not float, convert through an intermediate buffer
-        if (n <= 4096)  // If < 16k, use the stack
-            buf = OIIO_ALLOCA(float, n);
-        else {
-            tmp.reset(new float[n]);  // Freed when tmp exists its scope
-            buf = tmp.get();
-        }
-        pvt::convert_to_float(src, buf, n, src_type);
-    }
+    if (src_type == TypeFloat)
+        return convert_from_float_values((const float*)src, dst, n, dst_type);
+    if (convert_direct(src_type, src, dst_type, dst, n))
+        return true;
 
-    // Convert float to 'dst_type'
-    switch (dst_type.basetype) {
-    case TypeDesc::UINT8: convert_type(buf, (unsigned char*)dst, n); break;
-    case TypeDesc::UINT16: convert_type(buf, (unsigned short*)dst, n); break;
-    case TypeDesc::HALF: convert_type(buf, (half*)dst, n); break;
-    case TypeDesc::INT8: convert_type(buf, (char*)dst, n); break;
-    case TypeDesc::INT16: convert_type(buf, (short*)dst, n); break;
-    case TypeDesc::INT: convert_type(buf, (int*)dst, n); break;
-    case TypeDesc::UINT: convert_type(buf, (unsigned int*)dst, n); break;
-    case TypeDesc::INT64: convert_type(buf, (long long*)dst, n); break;
-    case TypeDesc::UINT64:
-        convert_type(buf, (unsigned long long*)dst, n);
-        break;
-    case TypeDesc::DOUBLE: convert_type(buf, (double*)dst, n); break;
-    default: return false;  // unknown format
+    // Neither is float, so convert through an intermediate float buffer, a
+    // block at a time so that it stays in cache.
+    const int blocksize = 1024;
+    float buf[blocksize];
+    size_t src_size = src_type.size(), dst_size = dst_type.size();
+    for (int b = 0; b < n; b += blocksize) {
+        int nb = std::min(blocksize, n - b);
+        pvt::convert_to_float((const char*)src + b * src_size, buf, nb,
+                              src_type);
+        if (!convert_from_float_values(buf, (char*)dst + b * dst_size, nb,
+                                       dst_type))
+            return false;
     }
-
     return true;
 }
 
@@ -1036,22 +1356,33 @@ add_bluenoise(int nchannels, int width, int height, int depth, float* data,
 {
     ImageSpec::auto_stride(xstride, ystride, zstride, sizeof(float), nchannels,
                            width, height);
-    char* plane = (char*)data;
+    // Each channel of a plane looks up its noise at the same offsets into
+    // the periodic table, so find them just once per plane, rather than
+    // hashing for every value.
+    const int mask = pvt::bntable_res - 1;
+    int* xoff      = OIIO_ALLOCA(int, nchannels);
+    int* yoff      = OIIO_ALLOCA(int, nchannels);
+    char* plane    = (char*)data;
     for (int z = 0; z < depth; ++z, plane += zstride) {
+        for (int c = 0; c < nchannels; ++c) {
+            int channel = c + chorigin;
+            pvt::bluenoise_offsets(z + zorigin, channel & (~3), ditherseed,
+                                   xoff[c], yoff[c]);
+            xoff[c] += xorigin;
+            yoff[c] += yorigin;
+        }
         char* scanline = plane;
         for (int y = 0; y < height; ++y, scanline += ystride) {
-            char* pixel = scanline;
-            for (int x = 0; x < width; ++x, pixel += xstride) {
-                float* val = (float*)pixel;
-                for (int c = 0; c < nchannels; ++c, ++val) {
-                    int channel = c + chorigin;
-                    if (channel == alpha_channel || channel == z_channel)
-                        continue;
-                    float dither
-                        = pvt::bluenoise_4chan_ptr(x + xorigin, y + yorigin,
-                                                   z + zorigin, channel & (~3),
-                                                   ditherseed)[channel & 3];
-                    *val += ditheramplitude * (dither - 0.5f);
+            for (int c = 0; c < nchannels; ++c) {
+                int channel = c + chorigin;
+                if (channel == alpha_channel || channel == z_channel)
+                    continue;
+                const float(*bnrow)[4] = pvt::bluenoise_table[(y + yoff[c])
+                                                              & mask];
+                char* pixel = scanline + c * sizeof(float);
+                for (int x = 0; x < width; ++x, pixel += xstride) {
+                    float dither = bnrow[(x + xoff[c]) & mask][channel & 3];
+                    *(float*)pixel += ditheramplitude * (dither - 0.5f);
                 }
             }
         }
@@ -1074,6 +1405,35 @@ add_dither(int nchannels, int width, int height, int depth, float* data,
 
 
 
+void
+pvt::dither_convert_from_float(const float* src, unsigned char* dst,
+                               int nchannels, int width, int height,
+                               int depth, float ditheramplitude,
+                               int alpha_channel, int z_channel,
+                               unsigned int ditherseed, int xorigin,
+                               int yorigin, int zorigin)
+{
+    const size_t nvals = size_t(width) * nchannels;
+    parallel_for_chunked(
+        0, int64_t(height) * depth, 0, [&](int64_t begin, int64_t end) {
+            // Dither a copy of each scanline, while it's in cache, just
+            // before converting it.
+            std::unique_ptr<float[]> row(new float[nvals]);
+            for (int64_t i = begin; i < end; ++i) {
+                int y = int(i % height), z = int(i / height);
+                memcpy(row.get(), src + i * nvals, nvals * sizeof(float));
+                add_bluenoise(nchannels, width, 1, 1, row.get(), AutoStride,
+                              AutoStride, AutoStride, ditheramplitude,
+                              alpha_channel, z_channel, ditherseed, 0, xorigin,
+                              yorigin + y, zorigin + z);
+                convert_from_float(row.get(), dst + i * nvals, nvals,
+                                   TypeUInt8);
+            }
+        });
+}
+
+
+
 template<typename T>
 static void
 premult_impl(int width, int height, int depth, int chbegin, int chend, T* data,
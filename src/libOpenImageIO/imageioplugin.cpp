@@ -5,6 +5,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
 #include <vector>
@@ -14,6 +15,7 @@
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/plugin.h>
 #include <OpenImageIO/strutil.h>
+#include <OpenImageIO/tracing.h>
 
 #include "imageio_pvt.h"
 
@@ -46,11 +48,25 @@ static std::map<std::string, std::string> extension_to_format_map;
 static std::vector<ustring> format_list_vector;
 
 // Which format names and extensions are procedural (not reading from files)
-static std::set<std::string> procedural_plugins;
+static std::map<ImageInput::Creator, bool> procedural_plugins;
+// Searchpaths whose DSO plugins have been cataloged
+static std::set<std::string> cataloged_searchpaths;
 
 static std::string pattern = Strutil::fmt::format(".imageio.{}",
                                                   Plugin::plugin_extension());
 
+// For files whose extension didn't lead to a reader that could open them,
+// the reader that did, by extension and first few bytes of the file, so
+// that the next such file tries it first. Guarded by imageio_mutex.
+static std::map<std::string, ImageInput::Creator> probe_cache;
+
+// Closed ImageInputs handed back by ImageInput::recycle(), by the Creator
+// that makes their format, for create() to reuse.
+static std::mutex input_pool_mutex;
+static std::map<ImageInput::Creator, std::vector<std::unique_ptr<ImageInput>>>
+    input_pool;
+static const size_t input_pool_max = 4;  // Idle ImageInputs kept per format
+
 
 inline void
 add_if_missing(std::vector<std::string>& vec, const std::string& val)
@@ -59,6 +75,42 @@ add_if_missing(std::vector<std::string>& vec, const std::string& val)
         vec.push_back(val);
 }
 
+// An ImageInput made by create_function, reused from the pool if there is
+// one there.
+static std::unique_ptr<ImageInput>
+new_input(ImageInput::Creator create_function)
+{
+    {
+        std::lock_guard<std::mutex> lock(input_pool_mutex);
+        auto found = input_pool.find(create_function);
+        if (found != input_pool.end() && found->second.size()) {
+            std::unique_ptr<ImageInput> in = std::move(found->second.back());
+            found->second.pop_back();
+            return in;
+        }
+    }
+    return std::unique_ptr<ImageInput>(create_function());
+}
+
+
+
+// The probe_cache key for a file: its extension and first bytes, or empty
+// if it can't be read.
+static std::string
+probe_key(string_view filename, const std::string& ext,
+          Filesystem::IOProxy* ioproxy)
+{
+    unsigned char magic[8];
+    size_t n = ioproxy ? ioproxy->pread(magic, sizeof(magic), 0)
+                       : Filesystem::read_bytes(filename, magic, sizeof(magic));
+    if (!n || n > sizeof(magic))
+        return {};
+    std::string key = ext + ':';
+    for (size_t i = 0; i < n; ++i)
+        key += Strutil::fmt::format("{:02x}", magic[i]);
+    return key;
+}
+
 }  // namespace
 
 
@@ -164,14 +216,10 @@ is_imageio_format_name(string_view name)
 {
     ustring namelower(Strutil::lower(name));
 
-    std::unique_lock<std::recursive_mutex> lock(imageio_mutex);
-    // If we were called before any plugins were loaded at all, catalog now
-    if (!format_list_vector.size()) {
-        lock.unlock();
-        // catalog_all_plugins() will lock imageio_mutex.
-        pvt::catalog_all_plugins(pvt::plugin_searchpath.string());
-        lock.lock();
-    }
+    // catalog_all_plugins() will lock imageio_mutex, and returns right away
+    // if the plugins have already been cataloged.
+    pvt::catalog_all_plugins(pvt::plugin_searchpath.string());
+    std::lock_guard<std::recursive_mutex> lock(imageio_mutex);
     for (const auto& n : format_list_vector)
         if (namelower == n)
             return true;
@@ -284,6 +332,7 @@ PLUGENTRY(jpegxl);
 PLUGENTRY(null);
 PLUGENTRY(openexr);
 PLUGENTRY(openvdb);
+PLUGENTRY(otx);
 PLUGENTRY(png);
 PLUGENTRY(pnm);
 PLUGENTRY_RO(psd);
@@ -352,7 +401,7 @@ catalog_builtin_plugins()
     DECLAREPLUG_RO (cineon);
 #endif
 #if !defined(DISABLE_DDS)
-    DECLAREPLUG_RO (dds);
+    DECLAREPLUG (dds);
 #endif
 #if defined(USE_DCMTK) && !defined(DISABLE_DICOM)
     DECLAREPLUG_RO (dicom);
@@ -393,6 +442,9 @@ catalog_builtin_plugins()
 #if defined(USE_OPENVDB) && !defined(DISABLE_OPENVDB)
     DECLAREPLUG_RO (openvdb);
 #endif
+#if !defined(DISABLE_OTX)
+    DECLAREPLUG (otx);
+#endif
 #if !defined(DISABLE_PNG)
     DECLAREPLUG (png);
 #endif
@@ -436,6 +488,23 @@ catalog_builtin_plugins()
 }
 // clang-format on
 
+
+
+// Add the built-in plugins to the catalog, if they aren't already. This is
+// cheap, since it only records each one's creation functions, extensions,
+// and library version: no plugin is instantiated (nor any library it uses
+// initialized) until a file of its format is first created or opened, and
+// no DSO is opened unless a format isn't among the built-in ones.
+//
+// N.B. Don't call while holding imageio_mutex, since declaring the formats
+// takes it.
+static void
+catalog_builtin_plugins_once()
+{
+    static std::once_flag builtin_flag;
+    std::call_once(builtin_flag, catalog_builtin_plugins);
+}
+
 }  // namespace
 
 
@@ -460,17 +529,18 @@ append_if_env_exists(std::string& searchpath, const char* env,
 
 
 /// Look at ALL imageio plugins in the searchpath and add them to the
-/// catalog.
+/// catalog. Each searchpath is only looked through once.
 void
 pvt::catalog_all_plugins(std::string searchpath)
 {
-    static std::once_flag builtin_flag;
-    std::call_once(builtin_flag, catalog_builtin_plugins);
+    catalog_builtin_plugins_once();
 
     std::unique_lock<std::recursive_mutex> lock(imageio_mutex);
     append_if_env_exists(searchpath, "OPENIMAGEIO_PLUGIN_PATH", true);
     // obsolete name:
     append_if_env_exists(searchpath, "OIIO_LIBRARY_PATH", true);
+    if (!cataloged_searchpaths.insert(searchpath).second)
+        return;  // Already did this one
 
     size_t patlen = pattern.length();
     std::vector<std::string> dirs;
@@ -489,17 +559,6 @@ pvt::catalog_all_plugins(std::string searchpath)
             }
         }
     }
-
-    // Inventory the procedural plugins
-    auto current_input_formats = input_formats;  // do a copy
-    for (auto&& f : current_input_formats) {
-        lock.unlock();
-        // ImageInput::create will take a lock of imageio_mutex
-        auto inp = ImageInput::create(f.first);
-        lock.lock();
-        if (inp->supports("procedural"))
-            procedural_plugins.insert(f.first);
-    }
 }
 
 
@@ -507,15 +566,39 @@ pvt::catalog_all_plugins(std::string searchpath)
 bool
 pvt::is_procedural_plugin(const std::string& name)
 {
-    std::unique_lock<std::recursive_mutex> lock(imageio_mutex);
+    ImageInput::Creator create_function = nullptr;
+    {
+        // Only if it's not a built-in format do we need to look through
+        // the searchpath. catalog_all_plugins() will lock imageio_mutex.
+        catalog_builtin_plugins_once();
+        std::unique_lock<std::recursive_mutex> lock(imageio_mutex);
+        auto found = input_formats.find(name);
+        if (found == input_formats.end()) {
+            lock.unlock();
+            pvt::catalog_all_plugins(pvt::plugin_searchpath.string());
+            lock.lock();
+            found = input_formats.find(name);
+            if (found == input_formats.end())
+                return false;
+        }
+        create_function = found->second;
+        auto known      = procedural_plugins.find(create_function);
+        if (known != procedural_plugins.end())
+            return known->second;
+    }
 
-    if (!format_list_vector.size()) {
-        lock.unlock();
-        // catalog_all_plugins() will lock imageio_mutex.
-        pvt::catalog_all_plugins(pvt::plugin_searchpath.string());
-        lock.lock();
+    // Ask the plugin, the first time anyone asks about its format, rather
+    // than instantiating every plugin up front.
+    std::unique_ptr<ImageInput> in;
+    try {
+        in.reset(create_function());
+    } catch (...) {
+        // Safety in case the ctr throws an exception
     }
-    return procedural_plugins.find(name) != procedural_plugins.end();
+    bool procedural = in && in->supports("procedural");
+    std::lock_guard<std::recursive_mutex> lock(imageio_mutex);
+    procedural_plugins[create_function] = procedural;
+    return procedural;
 }
 
 
@@ -538,6 +621,7 @@ ImageOutput::create(string_view filename, Filesystem::IOProxy* ioproxy,
     }
 
     ImageOutput::Creator create_function = nullptr;
+    catalog_builtin_plugins_once();
     {  // scope the lock:
         std::unique_lock<std::recursive_mutex> lock(imageio_mutex);
 
@@ -599,6 +683,7 @@ std::unique_ptr<ImageInput>
 ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
                    Filesystem::IOProxy* ioproxy, string_view plugin_searchpath)
 {
+    OIIO_TRACE_SPAN("II::create", filename);
     // In case the 'filename' was really a REST-ful URI with query/config
     // details tacked on to the end, strip them off so we can correctly
     // extract the file extension.
@@ -606,8 +691,12 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
     std::map<std::string, std::string> args;
     std::string filename_stripped;
 
-    // Only check REST arguments if the file does not exist
-    if (!Filesystem::exists(filename)) {
+    // Only check REST arguments if the file does not exist. A URL's query
+    // is part of its name (e.g., the signature of a presigned URL), but
+    // not of its extension.
+    if (Filesystem::is_url(filename)) {
+        filename_stripped = filename.substr(0, filename.find('?'));
+    } else if (!Filesystem::exists(filename)) {
         if (!Strutil::get_rest_arguments(filename, filename_stripped, args)) {
             OIIO::errorfmt(
                 "ImageInput::create() called with malformed filename");
@@ -630,7 +719,10 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
         format = filename;
     }
 
+    if (plugin_searchpath.empty())
+        plugin_searchpath = pvt::plugin_searchpath;
     ImageInput::Creator create_function = nullptr;
+    catalog_builtin_plugins_once();
     {  // scope the lock:
         std::unique_lock<std::recursive_mutex> lock(imageio_mutex);
 
@@ -639,8 +731,6 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
         Strutil::to_lower(format);
         InputPluginMap::const_iterator found = input_formats.find(format);
         if (found == input_formats.end()) {
-            if (plugin_searchpath.empty())
-                plugin_searchpath = pvt::plugin_searchpath;
             lock.unlock();
             // catalog_all_plugins() will lock imageio_mutex.
             catalog_all_plugins(plugin_searchpath);
@@ -661,7 +751,7 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
         // when somebody will have an incorrectly-named file, let's
         // deal with it robustly.
         formats_tried.push_back(create_function);
-        in = std::unique_ptr<ImageInput>(create_function());
+        in = new_input(create_function);
         if (!do_open && in && in->valid_file(filename)) {
             // Special case: we don't need to return the file
             // already opened, and this ImageInput says that the
@@ -709,22 +799,34 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
         if (config)
             myconfig = *config;
         myconfig.attribute("nowait", (int)1);
+        std::string probe = probe_key(filename, format, ioproxy);
+        // Every plugin gets a chance, so those in the searchpath must have
+        // been cataloged, even if this format was a built-in one.
+        catalog_all_plugins(plugin_searchpath);
         std::lock_guard<std::recursive_mutex> lock(imageio_mutex);
+        // Try first whichever reader opened the last file with the same
+        // extension and first bytes, then all of them in priority order.
+        std::vector<std::pair<std::string, ImageInput::Creator>> candidates;
+        auto cached = probe.size() ? probe_cache.find(probe)
+                                   : probe_cache.end();
+        if (cached != probe_cache.end())
+            candidates.emplace_back("(cached)", cached->second);
         for (auto f : format_list_vector) {
             auto plugin = input_formats.find(f.string());
-            if (plugin == input_formats.end() || !plugin->second)
-                continue;  // format that's output only
+            if (plugin != input_formats.end() && plugin->second)
+                candidates.emplace_back(plugin->first, plugin->second);
+        }
+        for (const auto& plugin : candidates) {
             // If we already tried this create function, don't do it again
             if (std::find(formats_tried.begin(), formats_tried.end(),
-                          plugin->second)
+                          plugin.second)
                 != formats_tried.end())
                 continue;
-            formats_tried.push_back(plugin->second);  // remember
+            formats_tried.push_back(plugin.second);  // remember
 
             ImageSpec tmpspec;
             try {
-                ImageInput::Creator create_function = plugin->second;
-                in = std::unique_ptr<ImageInput>(create_function());
+                in = new_input(plugin.second);
             } catch (...) {
                 // Safety in case the ctr throws an exception
             }
@@ -736,7 +838,7 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
                 if (pvt::oiio_print_debug > 1)
                     OIIO::debugfmt(
                         "ImageInput::create: \"{}\" did not open using format \"{}\" {} [valid_file was false].\n",
-                        filename, plugin->first, in->format_name());
+                        filename, plugin.first, in->format_name());
                 in.reset();
                 continue;
             }
@@ -750,13 +852,15 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
                 if (pvt::oiio_print_debug > 1)
                     OIIO::debugfmt(
                         "ImageInput::create: \"{}\" succeeded using format \"{}\".\n",
-                        filename, plugin->first);
+                        filename, plugin.first);
+                if (probe.size())
+                    probe_cache[probe] = plugin.second;
                 return in;
             }
             if (pvt::oiio_print_debug > 1)
                 OIIO::debugfmt(
                     "ImageInput::create: \"{}\" did not open using format \"{}\" {}.\n",
-                    filename, plugin->first, in->format_name());
+                    filename, plugin.first, in->format_name());
             in.reset();
         }
     }
@@ -788,7 +892,34 @@ ImageInput::create(string_view filename, bool do_open, const ImageSpec* config,
         return in;
     }
 
-    return std::unique_ptr<ImageInput>(create_function());
+    return new_input(create_function);
+}
+
+
+
+void
+ImageInput::recycle(unique_ptr&& in)
+{
+    std::unique_ptr<ImageInput> local(std::move(in));
+    if (!local)
+        return;
+    local->close();
+    local->set_ioproxy(nullptr);
+    local->threads(0);
+    (void)local->geterror();
+    ImageInput::Creator create_function = nullptr;
+    {
+        std::lock_guard<std::recursive_mutex> lock(imageio_mutex);
+        auto found = input_formats.find(local->format_name());
+        if (found != input_formats.end())
+            create_function = found->second;
+    }
+    if (!create_function)
+        return;
+    std::lock_guard<std::mutex> lock(input_pool_mutex);
+    auto& pool(input_pool[create_function]);
+    if (pool.size() < input_pool_max)
+        pool.push_back(std::move(local));
 }
 
 
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <atomic>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -11,6 +12,7 @@
 
 #include <tsl/robin_map.h>
 
+#include <OpenImageIO/color.h>
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/deepdata.h>
 #include <OpenImageIO/filesystem.h>
@@ -53,6 +55,9 @@ public:
     // The "local" proxy that we will create to use if the user didn't
     // supply a proxy for us to use.
     std::unique_ptr<Filesystem::IOProxy> m_io_local;
+    // Conversion from the "oiio:WorkingColorSpace" of the spec.
+    pvt::WorkingColorConversion m_working_color;
+    bool m_working_color_failed = false;
 };
 
 
@@ -372,7 +377,24 @@ ImageOutput::to_native_rectangle(int xbegin, int xend, int ybegin, int yend,
     contiguous &= ((ystride == xstride * width || height == 1)
                    && (zstride == ystride * height || depth == 1));
 
-    if (native_data && contiguous) {
+    // If the pixels are in a working color space, they are converted to the
+    // file's color space (as float) before being quantized.
+    ColorProcessorHandle tofile;
+    string_view working = m_spec.get_string_attribute("oiio:WorkingColorSpace");
+    if (working.size() && format != TypeDesc::UNKNOWN
+        && m_spec.nchannels >= 3) {
+        std::string err;
+        m_impl->m_working_color.set_working_colorspace(working);
+        tofile = m_impl->m_working_color.processor(
+            m_spec.get_string_attribute("oiio:ColorSpace"), true, err);
+        if (err.size() && !m_impl->m_working_color_failed) {
+            // Only say so once, rather than for every scanline or tile.
+            m_impl->m_working_color_failed = true;
+            errorfmt("{}", err);
+        }
+    }
+
+    if (native_data && contiguous && !tofile) {
         // Data are already in the native format and contiguous
         // just return a ptr to the original data.
         return data;
@@ -398,7 +420,28 @@ ImageOutput::to_native_rectangle(int xbegin, int xend, int ybegin, int yend,
             && "Per-channel native output requires contiguous strides");
         OIIO_DASSERT(format != TypeDesc::UNKNOWN);
         OIIO_DASSERT(m_spec.channelformats.size() == (size_t)m_spec.nchannels);
-        scratch.resize(native_rectangle_bytes);
+        imagesize_t nativesize = (native_rectangle_bytes + 3) & (~3);
+        scratch.resize(nativesize
+                       + (tofile ? rectangle_values * sizeof(float) : 0));
+        if (tofile) {
+            // Convert to float (after the native pixels in the scratch), to
+            // the file's color space, and only then to the channel formats.
+            float* fbuf = (float*)&scratch[nativesize];
+            convert_image(m_spec.nchannels, width, height, depth, data, format,
+                          xstride, ystride, zstride, fbuf, TypeFloat,
+                          AutoStride, AutoStride, AutoStride);
+            std::string err;
+            if (!pvt::WorkingColorConversion::convert(
+                    tofile.get(), m_spec.nchannels, width, height, depth,
+                    TypeFloat, fbuf, AutoStride, AutoStride, AutoStride,
+                    threads(), err))
+                errorfmt("{}", err);
+            data    = fbuf;
+            format  = TypeFloat;
+            xstride = m_spec.nchannels * sizeof(float);
+            ystride = xstride * width;
+            zstride = ystride * height;
+        }
         size_t offset = 0;
         for (int c = 0; c < m_spec.nchannels; ++c) {
             TypeDesc chanformat = m_spec.channelformats[c];
@@ -435,7 +478,7 @@ ImageOutput::to_native_rectangle(int xbegin, int xend, int ybegin, int yend,
     // contiguous, but it was in the correct native data format all along,
     // we can return the contiguized data without needing unnecessary
     // conversion into float and back.
-    if (native_data) {
+    if (native_data && !tofile) {
         return data;
     }
 
@@ -444,12 +487,13 @@ ImageOutput::to_native_rectangle(int xbegin, int xend, int ybegin, int yend,
     // will always preserve enough precision.
     const float* buf;
     if (format == TypeDesc::FLOAT) {
-        if (!do_dither) {
-            // Already in float format and no dither -- leave it as-is.
+        if (!tofile) {
+            // Already in float format and no color conversion -- leave it
+            // as-is. (Dithering doesn't alter it.)
             buf = (float*)data;
         } else {
             // Need to make a copy, even though it's already float, so the
-            // dither doesn't overwrite the caller's data.
+            // color conversion doesn't overwrite the caller's data.
             buf = (float*)&scratch[contiguoussize];
             memcpy((float*)buf, data, floatsize);
         }
@@ -459,18 +503,29 @@ ImageOutput::to_native_rectangle(int xbegin, int xend, int ybegin, int yend,
                                (int)rectangle_values, format);
     }
 
+    if (tofile) {
+        std::string err;
+        if (!pvt::WorkingColorConversion::convert(
+                tofile.get(), m_spec.nchannels, width, height, depth,
+                TypeFloat, (float*)buf, AutoStride, AutoStride, AutoStride,
+                threads(), err))
+            errorfmt("{}", err);
+    }
+
     if (do_dither) {
         // Note: We only dither if the intent is to convert from a floating
         // point data type to uint8 or less.
-        stride_t pixelsize = m_spec.nchannels * sizeof(float);
-        int bps            = m_spec["oiio:BitsPerSample"].get<int>(8);
-        int ditheramp      = 1 << (8 - bps);
-        OIIO::add_dither(m_spec.nchannels, width, height, depth, (float*)buf,
-                         pixelsize, pixelsize * stride_t(width),
-                         pixelsize * stride_t(width) * stride_t(height),
-                         float(ditheramp) / 255.0f, m_spec.alpha_channel,
-                         m_spec.z_channel, dither, 0, xorigin, yorigin,
-                         zorigin);
+        // It's added on the way to uint8, rather than in a pass of its own.
+        int bps       = m_spec["oiio:BitsPerSample"].get<int>(8);
+        int ditheramp = 1 << (8 - bps);
+        unsigned char* native
+            = (unsigned char*)&scratch[contiguoussize + floatsize];
+        pvt::dither_convert_from_float(buf, native, m_spec.nchannels, width,
+                                       height, depth,
+                                       float(ditheramp) / 255.0f,
+                                       m_spec.alpha_channel, m_spec.z_channel,
+                                       dither, xorigin, yorigin, zorigin);
+        return native;
     }
 
     // Convert from float to native format.
@@ -481,6 +536,50 @@ ImageOutput::to_native_rectangle(int xbegin, int xend, int ybegin, int yend,
 
 
 
+bool
+ImageOutput::compress_and_write_chunks(
+    int nchunks,
+    function_view<bool(int chunk, std::vector<unsigned char>& buf)> compress,
+    function_view<bool(int chunk, cspan<unsigned char> buf)> write)
+{
+    thread_pool* pool = default_thread_pool();
+    std::vector<unsigned char> buf;
+    if (nchunks < 2 || threads() == 1 || pool->size() < 2) {
+        for (int i = 0; i < nchunks; ++i)
+            if (!compress(i, buf) || !write(i, buf))
+                return false;
+        return true;
+    }
+
+    std::vector<std::vector<unsigned char>> bufs(nchunks);
+    std::unique_ptr<bool[]> compressed(new bool[nchunks]);
+    std::atomic<bool> failed(false);
+    // Declared last so that waiting for the tasks is the first thing its
+    // destructor does, even upon an early return.
+    task_set tasks(pool);
+    for (int i = 0; i < nchunks; ++i) {
+        tasks.push(pool->push([&, i](int /*id*/) {
+            // Don't bother with the rest once something has failed.
+            compressed[i] = !failed && compress(i, bufs[i]);
+        }));
+    }
+    // Write each chunk as soon as it's done, while the later ones are
+    // still being compressed. This non-blocking wait runs queued tasks
+    // itself while the chunk it needs isn't ready yet.
+    for (int i = 0; i < nchunks; ++i) {
+        tasks.wait_for_task(i);
+        if (!compressed[i] || !write(i, bufs[i])) {
+            failed = true;
+            return false;
+        }
+        // Free each chunk once written, to bound the memory held.
+        std::vector<unsigned char>().swap(bufs[i]);
+    }
+    return true;
+}
+
+
+
 bool
 ImageOutput::write_image(TypeDesc format, const void* data, stride_t xstride,
                          stride_t ystride, stride_t zstride,
@@ -353,6 +353,77 @@ test_imagespec_from_xml()
 
 
 
+static void
+test_imagespec_binary()
+{
+    std::cout << "test_imagespec_binary\n";
+    ImageSpec spec(1920, 1080, 5, TypeHalf);
+    spec.x              = -16;
+    spec.full_height    = 1200;
+    spec.tile_width     = 64;
+    spec.tile_height    = 32;
+    spec.alpha_channel  = 3;
+    spec.z_channel      = 4;
+    spec.channelformats = { TypeHalf, TypeHalf, TypeHalf, TypeHalf,
+                            TypeFloat };
+    spec.channelnames[4] = "Z";
+    spec.attribute("oiio:ColorSpace", "scene_linear");
+    spec.attribute("compression", "");
+    spec.attribute("Orientation", 6);
+    spec.attribute("PixelAspectRatio", 1.25f);
+    uint32_t timecode[2] = { 0x01020304u, 5u };
+    spec.attribute("smpte:TimeCode", TypeTimeCode, timecode);
+    float m[16] = { 1, 0, 0, 0, 0, 2, 0, 0, 0, 0, 3, 0, 4, 5, 6, 1 };
+    spec.attribute("worldtocamera", TypeMatrix, m);
+    ustring names[2] = { ustring("left"), ustring("right") };
+    spec.attribute("multiView", TypeDesc(TypeDesc::STRING, 2), names);
+    ustringhash hashed(names[1]);
+    spec.attribute("hashed", TypeDesc::USTRINGHASH, &hashed);
+    double d = 1.0 / 3.0;
+    spec.attribute("exposure", TypeDesc::DOUBLE, &d);
+    uint16_t shorts[3] = { 1, 2, 65535 };
+    spec.attribute("shorts", TypeDesc(TypeDesc::UINT16, 3), shorts);
+
+    std::string bin = spec.to_binary();
+    ImageSpec copy;
+    OIIO_CHECK_ASSERT(copy.from_binary(bin));
+    OIIO_CHECK_EQUAL(copy.to_binary(), bin);
+    OIIO_CHECK_EQUAL(copy.x, -16);
+    OIIO_CHECK_EQUAL(copy.width, 1920);
+    OIIO_CHECK_EQUAL(copy.full_height, 1200);
+    OIIO_CHECK_EQUAL(copy.tile_height, 32);
+    OIIO_CHECK_EQUAL(copy.z_channel, 4);
+    OIIO_CHECK_EQUAL(copy.format, TypeHalf);
+    OIIO_CHECK_ASSERT(copy.channelformats == spec.channelformats);
+    OIIO_CHECK_ASSERT(copy.channelnames == spec.channelnames);
+    OIIO_CHECK_EQUAL(copy.extra_attribs.size(), spec.extra_attribs.size());
+    OIIO_CHECK_EQUAL(copy.get_string_attribute("oiio:ColorSpace"),
+                     "scene_linear");
+    OIIO_CHECK_EQUAL(copy.get_int_attribute("Orientation"), 6);
+    OIIO_CHECK_EQUAL(copy.get_float_attribute("PixelAspectRatio"), 1.25f);
+    OIIO_CHECK_EQUAL(copy.find_attribute("exposure")->get<double>(), d);
+    OIIO_CHECK_EQUAL(copy.find_attribute("worldtocamera")->get<float>(13),
+                     5.0f);
+    OIIO_CHECK_EQUAL(copy.find_attribute("multiView")->get<ustring>(1),
+                     "right");
+    OIIO_CHECK_EQUAL(copy.find_attribute("hashed")->type(),
+                     TypeDesc::USTRINGHASH);
+    OIIO_CHECK_EQUAL(copy.find_attribute("shorts")->get<uint16_t>(2), 65535);
+    OIIO_CHECK_EQUAL(copy.find_attribute("smpte:TimeCode")->type(),
+                     TypeTimeCode);
+
+    // Anything truncated or not a binary spec is rejected, and leaves the
+    // spec as it was.
+    ImageSpec other(8, 8, 1, TypeUInt8);
+    for (size_t len = 0; len < bin.size(); len += 7)
+        OIIO_CHECK_ASSERT(!other.from_binary(string_view(bin.data(), len)));
+    OIIO_CHECK_ASSERT(!other.from_binary(spec.to_xml()));
+    OIIO_CHECK_EQUAL(other.width, 8);
+    OIIO_CHECK_EQUAL(other.extra_attribs.size(), 0);
+}
+
+
+
 int
 main(int /*argc*/, char* /*argv*/[])
 {
@@ -364,6 +435,7 @@ main(int /*argc*/, char* /*argv*/[])
     test_get_attribute();
     test_imagespec_from_ROI();
     test_imagespec_from_xml();
+    test_imagespec_binary();
 
     return unit_test_failures;
 }
@@ -27,6 +27,8 @@ static int numthreads    = 0;
 static int autotile_size = 64;
 static bool iter_only    = false;
 static bool no_iter      = false;
+static bool no_pixelmath = false;
+static bool no_convert   = false;
 static std::string conversionname;
 static TypeDesc conversion = TypeDesc::UNKNOWN;  // native by default
 static std::vector<ustring> input_filename;
@@ -65,6 +67,10 @@ getargs(int argc, char* argv[])
       .help("Run ImageBuf iteration tests only (not read tests)");
     ap.arg("--noiter", &no_iter)
       .help("Don't run ImageBuf iteration tests");
+    ap.arg("--nopixelmath", &no_pixelmath)
+      .help("Don't run ImageBufAlgo pixel math tests");
+    ap.arg("--noconvert", &no_convert)
+      .help("Don't run pixel value conversion tests");
     ap.arg("--convert %s", &conversionname)
       .help("Convert to named type upon read (default: native)");
     ap.arg("--cache %f", &cache_size)
@@ -450,6 +456,52 @@ test_pixel_iteration(const std::string& explanation,
 
 
 
+// Time `op` on the first image, read as `type`, with and without the
+// ImageBufAlgo pixel math fast paths, and report the speedup.
+static void
+test_pixelmath(const std::string& explanation,
+               const std::function<bool(ImageBuf&, const ImageBuf&)>& op,
+               TypeDesc type, int iters = 10)
+{
+    ImageBuf src(input_filename[0]);
+    src.read(0, 0, true, type);
+    ImageBuf dst(src.spec());
+    auto run = [&]() {
+        for (int i = 0; i < iters; ++i)
+            op(dst, src);
+    };
+    OIIO::attribute("imagebufalgo:fastpaths", 0);
+    double tslow = time_trial(run, ntrials) / iters;
+    OIIO::attribute("imagebufalgo:fastpaths", 1);
+    double tfast = time_trial(run, ntrials) / iters;
+    print("  {} {:5}: {} -> {}  ({:4.1f}x)\n", explanation, type,
+          Strutil::timeintervalformat(tslow, 3),
+          Strutil::timeintervalformat(tfast, 3), tslow / tfast);
+}
+
+
+
+// Time convert_pixel_values from one type to another.
+static void
+test_convert_pixel_values(TypeDesc srctype, TypeDesc dsttype, int iters = 10)
+{
+    const int n = 1 << 22;
+    std::vector<float> ramp(n);
+    for (int i = 0; i < n; ++i)
+        ramp[i] = float(i % 1000) / 999.0f;
+    std::vector<char> src(n * srctype.size()), dst(n * dsttype.size());
+    convert_pixel_values(TypeFloat, ramp.data(), srctype, src.data(), n);
+    auto run = [&]() {
+        for (int i = 0; i < iters; ++i)
+            convert_pixel_values(srctype, src.data(), dsttype, dst.data(), n);
+    };
+    double t = time_trial(run, ntrials) / iters;
+    print("  {:6} -> {:6}: {} = {:7.1f} Mvals/s\n", srctype, dsttype,
+          Strutil::timeintervalformat(t, 3), n / t / 1.0e6);
+}
+
+
+
 static void
 set_dataformat(const std::string& output_format, ImageSpec& outspec)
 {
@@ -608,6 +660,51 @@ main(int argc, char** argv)
         test_pixel_iteration("Iterate over a cache image (incr slave) ",
                              time_iterate_pixels_slave_incr, false, iters);
     }
+    if (!no_pixelmath) {
+        using namespace ImageBufAlgo;
+        std::cout << "Timing ImageBufAlgo pixel math (general -> fast path):"
+                  << std::endl;
+        for (TypeDesc type : { TypeFloat, TypeHalf, TypeUInt8 }) {
+            test_pixelmath("clamp        ", [](ImageBuf& R, const ImageBuf& A) {
+                return clamp(R, A, 0.25f, 0.75f, true);
+            }, type);
+            test_pixelmath("pow          ", [](ImageBuf& R, const ImageBuf& A) {
+                return pow(R, A, 2.2f);
+            }, type);
+            test_pixelmath("rangecompress", [](ImageBuf& R, const ImageBuf& A) {
+                return rangecompress(R, A, true);
+            }, type);
+            test_pixelmath("rangeexpand  ", [](ImageBuf& R, const ImageBuf& A) {
+                return rangeexpand(R, A, true);
+            }, type);
+            test_pixelmath("saturate     ", [](ImageBuf& R, const ImageBuf& A) {
+                return saturate(R, A, 0.5f);
+            }, type);
+            test_pixelmath("premult      ", [](ImageBuf& R, const ImageBuf& A) {
+                return premult(R, A);
+            }, type);
+            test_pixelmath("unpremult    ", [](ImageBuf& R, const ImageBuf& A) {
+                return unpremult(R, A);
+            }, type);
+        }
+        std::cout << std::endl;
+    }
+
+    if (!no_convert) {
+        std::cout << "Timing pixel value conversions:" << std::endl;
+        std::pair<TypeDesc, TypeDesc> pairs[] = {
+            { TypeUInt8, TypeFloat },  { TypeFloat, TypeUInt8 },
+            { TypeUInt16, TypeFloat }, { TypeFloat, TypeUInt16 },
+            { TypeHalf, TypeFloat },   { TypeFloat, TypeHalf },
+            { TypeUInt8, TypeHalf },   { TypeHalf, TypeUInt8 },
+            { TypeUInt16, TypeHalf },  { TypeHalf, TypeUInt16 },
+            { TypeUInt8, TypeUInt16 }, { TypeUInt16, TypeUInt8 },
+        };
+        for (auto& p : pairs)
+            test_convert_pixel_values(p.first, p.second);
+        std::cout << std::endl;
+    }
+
     if (verbose)
         std::cout << "\n" << imagecache->getstats(2) << "\n";
 
@@ -0,0 +1,63 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+#include <memory>
+
+#include <zlib.h>
+#if defined(USE_LIBDEFLATE)
+#    include <libdeflate.h>
+#endif
+
+#include "imageio_pvt.h"
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace pvt {
+
+
+#if defined(USE_LIBDEFLATE)
+
+namespace {
+struct DecompressorDeleter {
+    void operator()(libdeflate_decompressor* d) const
+    {
+        libdeflate_free_decompressor(d);
+    }
+};
+}  // namespace
+
+#endif
+
+
+
+bool
+zlib_uncompress(cspan<unsigned char> src, span<unsigned char> dst)
+{
+#if defined(USE_LIBDEFLATE)
+    // libdeflate inflates a whole buffer at once, knowing where it ends,
+    // which saves it most of zlib's bookkeeping. A decompressor is a few
+    // tens of KB, so each thread keeps one rather than making one a call.
+    thread_local std::unique_ptr<libdeflate_decompressor, DecompressorDeleter>
+        decompressor(libdeflate_alloc_decompressor());
+    if (decompressor) {
+        // With no actual_out_nbytes_ret, anything but exactly dst.size()
+        // bytes of output is an error.
+        return libdeflate_zlib_decompress(decompressor.get(), src.data(),
+                                          src.size(), dst.data(), dst.size(),
+                                          nullptr)
+               == LIBDEFLATE_SUCCESS;
+    }
+#endif
+    uLong size = uLong(dst.size());
+    return ::uncompress((Bytef*)dst.data(), &size, (const Bytef*)src.data(),
+                        uLong(src.size()))
+               == Z_OK
+           && size == dst.size();
+}
+
+
+}  // namespace pvt
+
+OIIO_NAMESPACE_END
@@ -2,14 +2,20 @@
 // SPDX-License-Identifier: Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <atomic>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <type_traits>
 
 #include <OpenImageIO/Imath.h>
 #include <OpenImageIO/argparse.h>
@@ -22,6 +28,7 @@
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagebufalgo_util.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
 #include <OpenImageIO/thread.h>
@@ -32,9 +39,6 @@
 using namespace OIIO;
 
 
-static spin_mutex maketx_mutex;  // for anything that needs locking
-
-
 
 static Filter2D*
 setup_filter(const ImageSpec& dstspec, const ImageSpec& srcspec,
@@ -240,6 +244,15 @@ template<class SRCTYPE>
 static void
 halve_scanline(const SRCTYPE* s, const int nchannels, size_t sw, float* dst)
 {
+    if constexpr (std::is_same<SRCTYPE, float>::value) {
+        if (nchannels == 4) {
+            // RGBA float, the usual case for MIP levels: a pixel per vector
+            const simd::vfloat4 half(0.5f);
+            for (size_t i = 0; i < sw; i += 2, s += 8, dst += 4)
+                (half * (simd::vfloat4(s) + simd::vfloat4(s + 4))).store(dst);
+            return;
+        }
+    }
     for (size_t i = 0; i < sw; i += 2, s += nchannels) {
         for (int j = 0; j < nchannels; ++j, ++dst, ++s)
             *dst = 0.5f * (float)(*s + *(s + nchannels));
@@ -287,6 +300,18 @@ resize_block_2pass(ImageBuf& dst, const ImageBuf& src, ROI roi,
         halve_scanline<SRCTYPE>(s, nchannels, sw, &S1[0]);
         s += ystride;
         const float *s0 = &S0[0], *s1 = &S1[0];
+        if constexpr (std::is_same<SRCTYPE, float>::value) {
+            // Average vertically, a vector at a time
+            using simd::vfloat8;
+            const vfloat8 half(0.5f);
+            size_t i = 0;
+            for (; i + vfloat8::elements <= row_elem; i += vfloat8::elements)
+                (half * (vfloat8(s0 + i) + vfloat8(s1 + i))).store(d + i);
+            for (; i < row_elem; ++i)
+                d[i] = 0.5f * (s0[i] + s1[i]);
+            d += row_elem;
+            continue;
+        }
         for (size_t x = 0; x < dw; ++x) {  // For each dst ROI col
             for (int i = 0; i < nchannels; ++i, ++s0, ++s1, ++d)
                 *d = (SRCTYPE)(0.5f * (*s0 + *s1));  // Average vertically
@@ -308,6 +333,7 @@ resize_block(ImageBuf& dst, const ImageBuf& src, ROI roi, bool envlatlmode,
     OIIO_DASSERT(dst.localpixels());
     bool ok;
     if (src.localpixels() &&                     // Not a cached image
+        src.contiguous() && dst.contiguous() &&  // Unpadded scanlines
         !envlatlmode &&                          // not latlong wrap mode
         roi.xbegin == 0 &&                       // Region x at origin
         dstspec.width == roi.width() &&          // Full width ROI
@@ -329,28 +355,37 @@ resize_block(ImageBuf& dst, const ImageBuf& src, ROI roi, bool envlatlmode,
 
 
 
-// Copy src into dst, but only for the range [x0,x1) x [y0,y1).
-static void
-check_nan_block(const ImageBuf& src, ROI roi, int& found_nonfinite)
+// Count the pixels in the roi of src with any nonfinite channel value.
+template<class SRCTYPE>
+static bool
+count_nonfinite_(const ImageBuf& src, ROI roi, std::atomic<int>& found)
 {
-    int x0 = roi.xbegin, x1 = roi.xend, y0 = roi.ybegin, y1 = roi.yend;
-    const ImageSpec& spec(src.spec());
-    span<float> pel = OIIO_ALLOCA_SPAN(float, spec.nchannels);
-    for (int y = y0; y < y1; ++y) {
-        for (int x = x0; x < x1; ++x) {
-            src.getpixel(x, y, pel);
-            for (int c = 0; c < spec.nchannels; ++c) {
-                if (!isfinite(pel[c])) {
-                    spin_lock lock(maketx_mutex);
-                    // if (found_nonfinite < 3)
-                    //     std::cerr << "maketx ERROR: Found " << pel[c]
-                    //               << " at (x=" << x << ", y=" << y << ")\n";
-                    ++found_nonfinite;
-                    break;  // skip other channels, there's no point
-                }
+    int n = 0;
+    for (ImageBuf::ConstIterator<SRCTYPE> s(src, roi); !s.done(); ++s) {
+        for (int c = roi.chbegin; c < roi.chend; ++c) {
+            if (!isfinite(s[c])) {
+                ++n;
+                break;  // skip other channels, there's no point
             }
         }
     }
+    found += n;
+    return true;
+}
+
+
+
+// Count the pixels of src with any nonfinite (NaN or Inf) value.
+static int
+count_nonfinite_pixels(const ImageBuf& src)
+{
+    std::atomic<int> found(0);
+    ImageBufAlgo::parallel_image(get_roi(src.spec()), [&](ROI roi) {
+        bool ok;
+        OIIO_DISPATCH_TYPES(ok, "count_nonfinite", count_nonfinite_,
+                            src.spec().format, src, roi, found);
+    });
+    return found;
 }
 
 
@@ -577,6 +612,87 @@ fix_latl_edges(ImageBuf& buf)
 
 
 
+bool
+ImageBufAlgo::envlatl_cdf(ImageBuf& marginal, ImageBuf& conditional,
+                          const ImageBuf& src, int width, int height,
+                          int nthreads)
+{
+    pvt::LoggedTimer logtime("IBA::envlatl_cdf");
+    if (!src.initialized() || src.spec().depth > 1) {
+        conditional.errorfmt("envlatl_cdf needs a 2D source image");
+        return false;
+    }
+    if (width <= 0) {
+        width  = src.spec().width;
+        height = height > 0 ? height : src.spec().height;
+    } else if (height <= 0) {
+        height = std::max(1, width / 2);
+    }
+
+    // Luminance, at the resolution of the tables
+    std::vector<float> weights(src.nchannels(), 0.0f);
+    if (src.nchannels() >= 3) {
+        weights[0] = 0.2126f;
+        weights[1] = 0.7152f;
+        weights[2] = 0.0722f;
+    } else {
+        weights[0] = 1.0f;
+    }
+    ImageBuf lum = ImageBufAlgo::channel_sum(src, weights, {}, nthreads);
+    if (lum.spec().width != width || lum.spec().height != height)
+        lum = ImageBufAlgo::resize(lum, { { "filtername", "box" } },
+                                   ROI(0, width, 0, height, 0, 1, 0, 1),
+                                   nthreads);
+    if (lum.has_error()) {
+        conditional.errorfmt("envlatl_cdf: {}", lum.geterror());
+        return false;
+    }
+
+    // Each row's CDF, and its total weighted by the solid angle it covers
+    marginal.reset(ImageSpec(height + 1, 1, 1, TypeDesc::FLOAT));
+    conditional.reset(ImageSpec(width + 1, height, 1, TypeDesc::FLOAT));
+    std::vector<double> rowsum(height);
+    parallel_for(
+        0, height,
+        [&](int64_t j) {
+            int y           = lum.ybegin() + int(j);
+            const float* in = (const float*)lum.pixeladdr(lum.xbegin(), y);
+            float* cdf      = (float*)conditional.pixeladdr(0, int(j));
+            auto weight = [](float v) {
+                return (v > 0.0f && std::isfinite(v)) ? double(v) : 0.0;
+            };
+            double sum = 0.0;
+            for (int i = 0; i < width; ++i)
+                sum += weight(in[i]);
+            double acc = 0.0;
+            cdf[0]     = 0.0f;
+            for (int i = 0; i < width; ++i) {
+                acc += weight(in[i]);
+                cdf[i + 1] = sum > 0.0 ? float(acc / sum)
+                                       : float(i + 1) / float(width);
+            }
+            cdf[width] = 1.0f;
+            rowsum[j]  = sum * std::sin(M_PI * (double(j) + 0.5) / height);
+        },
+        paropt(nthreads));
+
+    double total = 0.0;
+    for (double s : rowsum)
+        total += s;
+    float* cdf = (float*)marginal.localpixels();
+    double acc = 0.0;
+    cdf[0]     = 0.0f;
+    for (int j = 0; j < height; ++j) {
+        acc += rowsum[j];
+        cdf[j + 1] = total > 0.0 ? float(acc / total)
+                                 : float(j + 1) / float(height);
+    }
+    cdf[height] = 1.0f;
+    return true;
+}
+
+
+
 inline std::string
 formatres(const ImageSpec& spec)
 {
@@ -607,6 +723,104 @@ maketx_merge_spec(ImageSpec& dstspec, const ImageSpec& srcspec)
 
 
 
+// Set "oiio:TileStats" in spec to the per-tile statistics of img, to be
+// written as one MIP level with the tiling of spec: the level's width,
+// height, and channel count, then, for each tile in raster order, the
+// minimum, maximum, and average of each channel. The ImageCache uses them
+// to skip reading constant tiles and to bound the values in a region. If
+// the format has no arbitrary metadata, they go in the ImageDescription.
+static void
+set_tile_stats(ImageSpec& spec, const ImageBuf& img, bool arbitrary_metadata)
+{
+    const ImageSpec& imgspec(img.spec());
+    int nc = imgspec.nchannels;
+    int tw = spec.tile_width, th = spec.tile_height;
+    if (tw < 1 || th < 1 || imgspec.depth > 1)
+        return;
+    int nxtiles = (imgspec.width + tw - 1) / tw;
+    int nytiles = (imgspec.height + th - 1) / th;
+    std::vector<float> stats(size_t(nxtiles) * nytiles * nc * 3);
+    parallel_for(0, nxtiles * nytiles, [&](int t) {
+        int x = imgspec.x + (t % nxtiles) * tw;
+        int y = imgspec.y + (t / nxtiles) * th;
+        ROI roi(x, std::min(x + tw, imgspec.x + imgspec.width), y,
+                std::min(y + th, imgspec.y + imgspec.height), imgspec.z,
+                imgspec.z + 1, 0, nc);
+        float* min = &stats[size_t(t) * nc * 3];
+        float* max = min + nc;
+        float* avg = max + nc;
+        std::vector<double> sum(nc, 0.0);
+        std::fill(min, max, std::numeric_limits<float>::max());
+        std::fill(max, avg, -std::numeric_limits<float>::max());
+        for (ImageBuf::ConstIterator<float> p(img, roi); !p.done(); ++p) {
+            for (int c = 0; c < nc; ++c) {
+                float v = p[c];
+                min[c]  = std::min(min[c], v);
+                max[c]  = std::max(max[c], v);
+                sum[c] += v;
+            }
+        }
+        for (int c = 0; c < nc; ++c)
+            avg[c] = float(sum[c] / double(roi.npixels()));
+    });
+    // The shortest representation that reads back as the same float, so
+    // that a constant tile is recognized exactly.
+    std::string str = Strutil::fmt::format("{},{},{}", imgspec.width,
+                                           imgspec.height, nc);
+    for (float v : stats)
+        str += Strutil::fmt::format(",{}", v);
+    if (arbitrary_metadata) {
+        spec.attribute("oiio:TileStats", str);
+    } else {
+        std::string desc = spec.get_string_attribute("ImageDescription");
+        Strutil::excise_string_after_head(desc, "oiio:TileStats=");
+        desc = Strutil::fmt::format("{}{}oiio:TileStats={}", desc,
+                                    desc.size() ? " " : "", str);
+        spec.attribute("ImageDescription", desc);
+    }
+}
+
+
+
+// Some special constraints for OpenEXR output. Return true if the source
+// must sample the border (as OpenEXR environment maps do).
+static bool
+set_openexr_constraints(ImageSpec& outspec, const ImageOutput* out,
+                        bool mipmap, bool envlatlmode, bool verbose,
+                        std::ostream& outstream)
+{
+    if (strcmp(out->format_name(), "openexr"))
+        return false;
+    bool src_samples_border = false;
+    // Always use "round down" mode
+    outspec.attribute("openexr:roundingmode", 0 /* ROUND_DOWN */);
+    if (!mipmap) {
+        // Send hint to OpenEXR driver that we won't specify a MIPmap
+        outspec.attribute("openexr:levelmode", 0 /* ONE_LEVEL */);
+    } else {
+        outspec.erase_attribute("openexr:levelmode");
+    }
+    // OpenEXR always uses border sampling for environment maps
+    if (envlatlmode) {
+        src_samples_border = true;
+        outspec.attribute("oiio:updirection", "y");
+        outspec.attribute("oiio:sampleborder", 1);
+    }
+    // For single channel images, dwaa/b compression only seems to work
+    // reliably when size > 16 and size is a power of two. Bug?
+    // FIXME: watch future OpenEXR releases to see if this gets fixed.
+    if (outspec.nchannels == 1
+        && Strutil::istarts_with(outspec["compression"].get(), "dwa")) {
+        outspec.attribute("compression", "zip");
+        if (verbose)
+            outstream
+                << "WARNING: Changing unsupported DWA compression for this case to zip.\n";
+    }
+    return src_samples_border;
+}
+
+
+
 static bool
 write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
              const ImageSpec& outspec_template, std::string outputfilename,
@@ -639,35 +853,10 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
     }
 
     bool verbose = configspec.get_int_attribute("maketx:verbose") != 0;
-    bool src_samples_border = false;
-
-    // Some special constraints for OpenEXR
-    if (!strcmp(out->format_name(), "openexr")) {
-        // Always use "round down" mode
-        outspec.attribute("openexr:roundingmode", 0 /* ROUND_DOWN */);
-        if (!mipmap) {
-            // Send hint to OpenEXR driver that we won't specify a MIPmap
-            outspec.attribute("openexr:levelmode", 0 /* ONE_LEVEL */);
-        } else {
-            outspec.erase_attribute("openexr:levelmode");
-        }
-        // OpenEXR always uses border sampling for environment maps
-        if (envlatlmode) {
-            src_samples_border = true;
-            outspec.attribute("oiio:updirection", "y");
-            outspec.attribute("oiio:sampleborder", 1);
-        }
-        // For single channel images, dwaa/b compression only seems to work
-        // reliably when size > 16 and size is a power of two. Bug?
-        // FIXME: watch future OpenEXR releases to see if this gets fixed.
-        if (outspec.nchannels == 1
-            && Strutil::istarts_with(outspec["compression"].get(), "dwa")) {
-            outspec.attribute("compression", "zip");
-            if (verbose)
-                outstream
-                    << "WARNING: Changing unsupported DWA compression for this case to zip.\n";
-        }
-    }
+    bool tile_stats = configspec.get_int_attribute("maketx:tile_stats") != 0;
+    bool src_samples_border = set_openexr_constraints(outspec, out, mipmap,
+                                                      envlatlmode, verbose,
+                                                      outstream);
 
     if (envlatlmode && src_samples_border)
         fix_latl_edges(*img);
@@ -687,11 +876,72 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
         filtername  = "lanczos3";
     }
 
-    Timer writetimer;
-    if (!out->open(outputfilename.c_str(), outspec)) {
-        errorfmt("Could not open \"{}\" : {}", outputfilename, out->geterror());
-        return false;
+    if (clamp_half) {
+        std::shared_ptr<ImageBuf> tmp(new ImageBuf);
+        ImageBufAlgo::clamp(*tmp, *img, -HALF_MAX, HALF_MAX, true);
+        std::swap(tmp, img);
     }
+    if (tile_stats)
+        set_tile_stats(outspec, *img, out->supports("arbitrary_metadata"));
+
+    // Each level is written in the background while the next one is
+    // computed from it, so that the compression and I/O of one overlap the
+    // filtering of the next. The writes to the ImageOutput must be in
+    // order, so each waits for the one before it. Nothing may modify a
+    // level once it's handed to the writer. Errors are per-thread, so the
+    // writer returns any error message to be issued from this thread. The
+    // writes run on the I/O thread pool, whose futures (unlike those of
+    // std::async) don't wait when destroyed, so every return below must
+    // finish the pending write first.
+    std::future<std::string> pending_write;
+    auto finish_write = [&]() -> bool {
+        if (!pending_write.valid())
+            return true;
+        std::string err = pending_write.get();
+        if (err.size())
+            errorfmt("{}", err);
+        return err.empty();
+    };
+    auto start_write = [&](std::shared_ptr<ImageBuf> level,
+                           const ImageSpec& spec, ImageOutput::OpenMode mode,
+                           double miptime) -> bool {
+        if (!finish_write())
+            return false;
+        pending_write = io_thread_pool()->push([&, level, spec, mode,
+                                                miptime](int /*id*/) {
+            Timer writetimer;
+            if (!out->open(outputfilename.c_str(), spec, mode))
+                return Strutil::fmt::format("Could not {} \"{}\" : {}",
+                                            mode == ImageOutput::Create
+                                                ? "open"
+                                                : "append",
+                                            outputfilename, out->geterror());
+            if (!level->write(out)) {
+                // ImageBuf::write transfers any errors from the
+                // ImageOutput to the ImageBuf.
+                out->close();
+                return Strutil::fmt::format("Error writing \"{}\" : {}",
+                                            outputfilename, level->geterror());
+            }
+            double wtime = writetimer();
+            stat_writetime += wtime;
+            if (verbose) {
+                size_t mem = Sysutil::memory_used(true);
+                peak_mem   = std::max(peak_mem, mem);
+                if (mode == ImageOutput::Create)
+                    print(outstream, "    {:15s} ({})  write {}\n",
+                          formatres(spec), Strutil::memformat(mem),
+                          Strutil::timeintervalformat(wtime, 2));
+                else
+                    print(outstream, "    {:15s} ({})  downres {} write {}\n",
+                          formatres(spec), Strutil::memformat(mem),
+                          Strutil::timeintervalformat(miptime, 2),
+                          Strutil::timeintervalformat(wtime, 2));
+            }
+            return std::string();
+        });
+        return true;
+    };
 
     // Write out the image
     if (verbose) {
@@ -701,27 +951,16 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
               outspec.height);
     }
 
-    if (clamp_half) {
-        std::shared_ptr<ImageBuf> tmp(new ImageBuf);
-        ImageBufAlgo::clamp(*tmp, *img, -HALF_MAX, HALF_MAX, true);
-        std::swap(tmp, img);
-    }
-    if (!img->write(out)) {
-        // ImageBuf::write transfers any errors from the ImageOutput to
-        // the ImageBuf.
-        errorfmt("Write failed: {}", img->geterror());
-        out->close();
-        return false;
-    }
-
-    double wtime = writetimer();
-    stat_writetime += wtime;
-    if (verbose) {
-        size_t mem = Sysutil::memory_used(true);
-        peak_mem   = std::max(peak_mem, mem);
-        print(outstream, "    {:15s} ({})  write {}\n", formatres(outspec),
-              Strutil::memformat(mem), Strutil::timeintervalformat(wtime, 2));
-    }
+    // Trick: to get the resizes to the MIP levels working properly, we
+    // doctor each level to have its display and pixel windows match (and
+    // generate the smaller ones with 0 offset). Don't worry, the texture
+    // engine doesn't care what the upper MIP levels have for the window
+    // sizes, it uses level 0 to determine the relatinship between texture
+    // 0-1 space (display window) and the pixels.
+    if (mipmap)
+        img->set_full(img->xbegin(), img->xend(), img->ybegin(), img->yend(),
+                      img->zbegin(), img->zend());
+    start_write(img, outspec, ImageOutput::Create, 0.0);
 
     if (mipmap) {  // Mipmap levels:
         if (verbose)
@@ -776,21 +1015,13 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
                     || configspec.get_int_attribute("maketx:forcefloat", 1))
                     smallspec.set_format(TypeDesc::FLOAT);
 
-                // Trick: to get the resize working properly, we reset
-                // both display and pixel windows to match, and have 0
-                // offset, AND doctor the big image to have its display
-                // and pixel windows match.  Don't worry, the texture
-                // engine doesn't care what the upper MIP levels have
-                // for the window sizes, it uses level 0 to determine
-                // the relatinship between texture 0-1 space (display
-                // window) and the pixels.
+                // See the "Trick" above: the display and pixel windows
+                // match, with 0 offset.
                 smallspec.x      = 0;
                 smallspec.y      = 0;
                 smallspec.full_x = 0;
                 smallspec.full_y = 0;
                 small->reset(smallspec);  // Realocate with new size
-                img->set_full(img->xbegin(), img->xend(), img->ybegin(),
-                              img->yend(), img->zbegin(), img->zend());
 
                 if (filtername == "box" && !orig_was_overscan
                     && sharpen <= 0.0f) {
@@ -804,6 +1035,7 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
                     Filter2D* filter = setup_filter(small->spec(), img->spec(),
                                                     filtername);
                     if (!filter) {
+                        finish_write();
                         errorfmt("Could not make filter \"{}\"", filtername);
                         return false;
                     }
@@ -819,8 +1051,12 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
                                 (sharpen_first ? "before" : "after"));
                         print(outstream, "\n");
                     }
-                    if (do_highlight_compensation)
-                        ImageBufAlgo::rangecompress(*img, *img);
+                    if (do_highlight_compensation) {
+                        // Not in place: img may still be being written.
+                        std::shared_ptr<ImageBuf> compressed(new ImageBuf);
+                        ImageBufAlgo::rangecompress(*compressed, *img);
+                        std::swap(img, compressed);
+                    }
                     if (sharpen > 0.0f && sharpen_first) {
                         std::shared_ptr<ImageBuf> sharp(new ImageBuf);
                         bool uok = ImageBufAlgo::unsharp_mask(*sharp, *img,
@@ -859,45 +1095,276 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
             outspec.set_format(outputdatatype);
             if (envlatlmode && src_samples_border)
                 fix_latl_edges(*small);
+            // Formats with true MIP-maps (OpenEXR) have only one header, so
+            // only the top level can carry tile statistics.
+            if (tile_stats && !out->supports("mipmap"))
+                set_tile_stats(outspec, *small,
+                               out->supports("arbitrary_metadata"));
 
-            Timer writetimer;
             // If the format explicitly supports MIP-maps, use that,
             // otherwise try to simulate MIP-mapping with multi-image.
             ImageOutput::OpenMode mode = out->supports("mipmap")
                                              ? ImageOutput::AppendMIPLevel
                                              : ImageOutput::AppendSubimage;
-            if (!out->open(outputfilename.c_str(), outspec, mode)) {
-                errorfmt("Could not append \"{}\" : {}", outputfilename,
-                         out->geterror());
+            small->set_full(small->xbegin(), small->xend(), small->ybegin(),
+                            small->yend(), small->zbegin(), small->zend());
+            if (!start_write(small, outspec, mode, this_miptime))
+                return false;
+            // The next level is computed from this one, into the buffer of
+            // the one before, which start_write has finished writing.
+            std::swap(img, small);
+        }
+    }
+    if (!finish_write())
+        return false;
+
+    if (verbose)
+        print(outstream, "  Wrote file: {}  ({})\n", outputfilename,
+              Strutil::memformat(Sysutil::memory_used(true)));
+    Timer writetimer;
+    if (!out->close()) {
+        errorfmt("Error writing \"{}\" : {}", outputfilename, out->geterror());
+        return false;
+    }
+    stat_writetime += writetimer();
+    return true;
+}
+
+
+
+// Making a texture by streaming (maketx:stream): the input is read a band
+// of tile rows at a time, each band of level 0 is written as soon as it's
+// read, and each coarser MIP level is made a row at a time from just the
+// two rows of the level above that it interpolates, so that the memory
+// needed is proportional to the width of the image rather than its area.
+// The levels after the first can only be written once the first is
+// finished, so until then each spills to a temporary file of its own.
+struct StreamLevel {
+    ImageSpec spec;
+    std::vector<int> x0, x1;   // Columns of the level above interpolated
+    std::vector<float> xfrac;  //   for each pixel, and the weight of x1
+    std::vector<float> prev;   // The last row passed to this level
+    std::vector<float> row;    // Scratch for a row of the next level
+    int nextrow = 0;           // The next row of the next level to make
+    std::string spillname;
+    FILE* spill = nullptr;
+
+    ~StreamLevel()
+    {
+        if (spill) {
+            fclose(spill);
+            Filesystem::remove(spillname);
+        }
+    }
+};
+
+using StreamLevels = std::vector<std::unique_ptr<StreamLevel>>;
+
+
+
+// Pass row y of levels[L] along: spill it (level 0 is written directly),
+// and make whichever rows of the next level it completes. The rows are
+// bilinearly interpolated exactly as resize_block does.
+static bool
+stream_row(StreamLevels& levels, size_t L, int y, const float* row)
+{
+    StreamLevel& lev(*levels[L]);
+    int nc        = lev.spec.nchannels;
+    size_t rowlen = size_t(lev.spec.width) * nc;
+    if (L > 0 && fwrite(row, sizeof(float), rowlen, lev.spill) != rowlen)
+        return false;
+    if (L + 1 == levels.size())
+        return true;
+
+    StreamLevel& next(*levels[L + 1]);
+    float yscale = 1.0f / (float)next.spec.height;
+    for (; lev.nextrow < next.spec.height; ++lev.nextrow) {
+        float t = (lev.nextrow + 0.5f) * yscale * (float)lev.spec.height
+                  - 0.5f;
+        int r0;
+        float yfrac = floorfrac(t, &r0);
+        int r1      = OIIO::clamp(r0 + 1, 0, lev.spec.height - 1);
+        r0          = OIIO::clamp(r0, 0, lev.spec.height - 1);
+        if (r1 > y)
+            break;  // Needs rows we don't have yet
+        const float* row0 = (r0 == y) ? row : lev.prev.data();
+        float* d          = lev.row.data();
+        for (int x = 0; x < next.spec.width; ++x, d += nc)
+            bilerp(row0 + next.x0[x] * nc, row0 + next.x1[x] * nc,
+                   row + next.x0[x] * nc, row + next.x1[x] * nc,
+                   next.xfrac[x], yfrac, nc, d);
+        if (!stream_row(levels, L + 1, lev.nextrow, lev.row.data()))
+            return false;
+    }
+    std::copy(row, row + rowlen, lev.prev.begin());
+    return true;
+}
+
+
+
+// Write the MIP-map of the image whose level 0 read_band(ybegin,yend,data)
+// supplies as float pixels, a band at a time (see StreamLevel).
+static bool
+write_mipmap_streaming(
+    const std::function<bool(int, int, float*)>& read_band,
+    const ImageSpec& outspec_template, std::string outputfilename,
+    ImageOutput* out, TypeDesc outputdatatype, bool mipmap,
+    const ImageSpec& configspec, std::ostream& outstream,
+    double& stat_readtime, double& stat_writetime, double& stat_miptime,
+    size_t& peak_mem)
+{
+    using OIIO::errorfmt;
+    using OIIO::Strutil::sync::print;  // Be sure to use synchronized one
+    if (mipmap && !out->supports("multiimage") && !out->supports("mipmap")) {
+        errorfmt("\"{} \" format does not support multires images",
+                 outputfilename);
+        return false;
+    }
+    bool verbose      = configspec.get_int_attribute("maketx:verbose") != 0;
+    ImageSpec outspec = outspec_template;
+    outspec.set_format(outputdatatype);
+    set_openexr_constraints(outspec, out, mipmap, false, verbose, outstream);
+    bool clamp_half = (outspec.format == TypeHalf);
+
+    // Set up the levels, each half the size of the one before
+    StreamLevels levels;
+    levels.emplace_back(new StreamLevel);
+    levels[0]->spec = outspec;
+    while (mipmap
+           && (levels.back()->spec.width > 1
+               || levels.back()->spec.height > 1)) {
+        const ImageSpec& bigspec(levels.back()->spec);
+        std::unique_ptr<StreamLevel> small(new StreamLevel);
+        ImageSpec& spec(small->spec);
+        spec = bigspec;
+        if (!configspec.get_int_attribute("maketx:mipmap_metadata"))
+            spec.extra_attribs.free();
+        if (spec.width > 1)
+            spec.width /= 2;
+        if (spec.height > 1)
+            spec.height /= 2;
+        spec.full_width  = spec.width;
+        spec.full_height = spec.height;
+        small->x0.resize(spec.width);
+        small->x1.resize(spec.width);
+        small->xfrac.resize(spec.width);
+        float xscale = 1.0f / (float)spec.width;
+        for (int x = 0; x < spec.width; ++x) {
+            float s         = (x + 0.5f) * xscale * (float)bigspec.width - 0.5f;
+            small->xfrac[x] = floorfrac(s, &small->x0[x]);
+            small->x1[x]    = OIIO::clamp(small->x0[x] + 1, 0,
+                                          bigspec.width - 1);
+            small->x0[x]    = OIIO::clamp(small->x0[x], 0, bigspec.width - 1);
+        }
+        small->spillname = Filesystem::unique_path(outputfilename
+                                                   + ".%%%%%%%%.level");
+        small->spill     = Filesystem::fopen(small->spillname, "w+b");
+        if (!small->spill) {
+            errorfmt("Could not create temporary file \"{}\"",
+                     small->spillname);
+            return false;
+        }
+        levels.back()->prev.resize(size_t(bigspec.width) * bigspec.nchannels);
+        levels.back()->row.resize(size_t(spec.width) * spec.nchannels);
+        levels.push_back(std::move(small));
+    }
+
+    if (verbose) {
+        print(outstream, "  Writing file: {}\n", outputfilename);
+        print(outstream, "  Streaming {} rows at a time\n",
+              outspec.tile_height);
+        print(outstream, "  Top level is {}x{}\n", outspec.width,
+              outspec.height);
+    }
+
+    // Level 0, as it's read. Every band fits the buffer for level 0's.
+    if (!out->open(outputfilename.c_str(), outspec)) {
+        errorfmt("Could not open \"{}\" : {}", outputfilename,
+                 out->geterror());
+        return false;
+    }
+    int nc = outspec.nchannels, tileheight = outspec.tile_height;
+    ImageSpec bandspec(outspec.width, tileheight, nc, TypeFloat);
+    bandspec.alpha_channel = outspec.alpha_channel;
+    std::vector<float> band(bandspec.image_pixels() * nc);
+    ImageBuf bandbuf(bandspec, make_span(band));
+    for (int ybegin = 0; ybegin < outspec.height; ybegin += tileheight) {
+        int yend = std::min(ybegin + tileheight, outspec.height);
+        Timer readtimer;
+        if (!read_band(ybegin, yend, band.data()))
+            return false;
+        if (clamp_half)
+            ImageBufAlgo::clamp(bandbuf, bandbuf, -HALF_MAX, HALF_MAX, true);
+        stat_readtime += readtimer();
+        Timer writetimer;
+        if (!out->write_tiles(0, outspec.width, ybegin, yend, 0, 1, TypeFloat,
+                              band.data())) {
+            errorfmt("Error writing \"{}\" : {}", outputfilename,
+                     out->geterror());
+            return false;
+        }
+        stat_writetime += writetimer();
+        Timer miptimer;
+        for (int y = ybegin; y < yend; ++y) {
+            if (!stream_row(levels, 0, y,
+                            &band[size_t(y - ybegin) * outspec.width * nc])) {
+                errorfmt("Could not write temporary file \"{}\"",
+                         levels[1]->spillname);
                 return false;
             }
-            if (!small->write(out)) {
-                // ImageBuf::write transfers any errors from the
-                // ImageOutput to the ImageBuf.
-                errorfmt("Error writing \"{}\" : {}", outputfilename,
-                         small->geterror());
-                out->close();
+        }
+        stat_miptime += miptimer();
+    }
+    if (verbose) {
+        size_t mem = Sysutil::memory_used(true);
+        peak_mem   = std::max(peak_mem, mem);
+        print(outstream, "    {:15s} ({})\n", formatres(outspec),
+              Strutil::memformat(mem));
+    }
+
+    // Then the other levels, from their spill files. If the format
+    // explicitly supports MIP-maps, use that, otherwise try to simulate
+    // MIP-mapping with multi-image.
+    ImageOutput::OpenMode mode = out->supports("mipmap")
+                                     ? ImageOutput::AppendMIPLevel
+                                     : ImageOutput::AppendSubimage;
+    for (size_t L = 1; L < levels.size(); ++L) {
+        StreamLevel& lev(*levels[L]);
+        ImageSpec spec = lev.spec;
+        spec.set_format(outputdatatype);
+        Timer writetimer;
+        if (!out->open(outputfilename.c_str(), spec, mode)) {
+            errorfmt("Could not append \"{}\" : {}", outputfilename,
+                     out->geterror());
+            return false;
+        }
+        rewind(lev.spill);
+        for (int ybegin = 0; ybegin < spec.height; ybegin += tileheight) {
+            int yend = std::min(ybegin + tileheight, spec.height);
+            size_t n = size_t(yend - ybegin) * spec.width * nc;
+            if (fread(band.data(), sizeof(float), n, lev.spill) != n) {
+                errorfmt("Could not read temporary file \"{}\"",
+                         lev.spillname);
                 return false;
             }
-            double wtime = writetimer();
-            stat_writetime += wtime;
-            if (verbose) {
-                size_t mem = Sysutil::memory_used(true);
-                peak_mem   = std::max(peak_mem, mem);
-                print(outstream, "    {:15s} ({})  downres {} write {}\n",
-                      formatres(smallspec), Strutil::memformat(mem),
-                      Strutil::timeintervalformat(this_miptime, 2),
-                      Strutil::timeintervalformat(wtime, 2));
+            if (!out->write_tiles(0, spec.width, ybegin, yend, 0, 1,
+                                  TypeFloat, band.data())) {
+                errorfmt("Error writing \"{}\" : {}", outputfilename,
+                         out->geterror());
+                return false;
             }
-            std::swap(img, small);
         }
+        double wtime = writetimer();
+        stat_writetime += wtime;
+        if (verbose)
+            print(outstream, "    {:15s} write {}\n", formatres(spec),
+                  Strutil::timeintervalformat(wtime, 2));
     }
 
     if (verbose)
         print(outstream, "  Wrote file: {}  ({})\n", outputfilename,
               Strutil::memformat(Sysutil::memory_used(true)));
-    writetimer.reset();
-    writetimer.start();
+    Timer writetimer;
     if (!out->close()) {
         errorfmt("Error writing \"{}\" : {}", outputfilename, out->geterror());
         return false;
@@ -908,6 +1375,144 @@ write_mipmap(ImageBufAlgo::MakeTextureMode mode, std::shared_ptr<ImageBuf>& img,
 
 
 
+// For streaming: a pass over the image just to compute what must be in
+// the header before anything can be written -- the statistics of the
+// unprocessed pixels, and the same hash of the processed ones that
+// computePixelHashSHA1 (HASHER = SHA1) or computePixelHash (FastHash128)
+// would compute of the whole image.
+template<class HASHER>
+static bool
+stream_stats_and_hash(const ImageSpec& spec, int bandheight,
+                      const std::function<bool(int, int, float*)>& read_raw,
+                      const std::function<bool(int, int, float*)>& process,
+                      bool compute_stats, ImageBufAlgo::PixelStats& stats,
+                      bool compute_hash, string_view extrainfo, int blocksize,
+                      std::string& hash_digest)
+{
+    int nc        = spec.nchannels;
+    size_t rowlen = size_t(spec.width) * nc;
+    std::vector<float> band(rowlen * bandheight);
+    std::vector<double> sum(nc, 0.0);
+    std::vector<imagesize_t> count(nc, 0);
+    stats.min.assign(nc, std::numeric_limits<float>::max());
+    stats.max.assign(nc, -std::numeric_limits<float>::max());
+    bool oneblock = (blocksize <= 0 || blocksize >= spec.height);
+    HASHER whole;
+    std::unique_ptr<HASHER> block(new HASHER);
+    for (int ybegin = 0; ybegin < spec.height; ybegin += bandheight) {
+        int yend = std::min(ybegin + bandheight, spec.height);
+        if (!read_raw(ybegin, yend, band.data()))
+            return false;
+        if (compute_stats) {
+            const float* p = band.data();
+            for (size_t i = 0, n = (yend - ybegin) * rowlen; i < n; ++i) {
+                int c = int(i % nc);
+                if (!isfinite(p[i]))
+                    continue;
+                stats.min[c] = std::min(stats.min[c], p[i]);
+                stats.max[c] = std::max(stats.max[c], p[i]);
+                sum[c] += p[i];
+                ++count[c];
+            }
+        }
+        if (!compute_hash)
+            continue;
+        if (!process(ybegin, yend, band.data()))
+            return false;
+        for (int y = ybegin; y < yend; ++y) {
+            block->append(&band[(y - ybegin) * rowlen],
+                          rowlen * sizeof(float));
+            if (!oneblock
+                && ((y + 1) % blocksize == 0 || y + 1 == spec.height)) {
+                whole.append(block->digest());
+                block.reset(new HASHER);
+            }
+        }
+    }
+    if (compute_stats) {
+        stats.avg.resize(nc);
+        for (int c = 0; c < nc; ++c) {
+            if (!count[c])
+                stats.min[c] = stats.max[c] = 0.0f;
+            stats.avg[c] = count[c] ? float(sum[c] / count[c]) : 0.0f;
+        }
+    }
+    if (compute_hash) {
+        HASHER& sha(oneblock ? *block : whole);
+        sha.append(extrainfo);
+        hash_digest = sha.digest();
+    }
+    return true;
+}
+
+
+
+// Return why the texture can't be made by streaming (see StreamLevel),
+// for all the things that need the whole image at once, or an empty
+// string if it can.
+static std::string
+streaming_unsupported(ImageBufAlgo::MakeTextureMode mode,
+                      const ImageSpec& srcspec, const ImageSpec& configspec,
+                      bool from_filename)
+{
+    if (!from_filename)
+        return "the input is not a file";
+    if (mode != ImageBufAlgo::MakeTxTexture)
+        return "only plain textures can be streamed";
+    if (srcspec.depth > 1 || srcspec.x || srcspec.y || srcspec.full_x
+        || srcspec.full_y || srcspec.roi() != srcspec.roi_full())
+        return "the image is a volume, cropped, or has overscan";
+    static const char* whole_image_options[]
+        = { "cdf",           "constant_color_detect", "opaque_detect",
+            "monochrome_detect", "resize",            "tile_stats",
+            "highlightcomp" };
+    for (auto option : whole_image_options)
+        if (configspec.get_int_attribute(std::string("maketx:") + option))
+            return Strutil::fmt::format("of maketx:{}", option);
+    int nchannels = configspec.get_int_attribute("maketx:nchannels", -1);
+    if (nchannels > 0 && nchannels != srcspec.nchannels)
+        return "of maketx:nchannels";
+    if (configspec.get_float_attribute("maketx:sharpen") > 0.0f)
+        return "of maketx:sharpen";
+    if (configspec.get_string_attribute("maketx:mipimages").size())
+        return "of maketx:mipimages";
+    if (configspec.get_string_attribute("maketx:filtername", "box") != "box")
+        return "only the box filter can be streamed";
+    if (configspec.get_string_attribute("maketx:fixnan") == "box3")
+        return "of maketx:fixnan box3";
+    if (!configspec.get_int_attribute("maketx:forcefloat", 1))
+        return "of maketx:forcefloat 0";
+    return std::string();
+}
+
+
+
+// The color configuration of the given name (or the default one, if it's
+// empty), read just once however many textures are made with it, so that
+// batches of textures share it and the processors it caches. Return nullptr
+// (with an error) if it can't be read.
+static const ColorConfig*
+shared_colorconfig(const std::string& name)
+{
+    if (name.empty())
+        return &ColorConfig::default_colorconfig();
+    static std::mutex mutex;
+    static std::map<std::string, std::unique_ptr<ColorConfig>> configs;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& config = configs[name];
+    if (!config) {
+        std::unique_ptr<ColorConfig> c(new ColorConfig(name));
+        if (c->has_error()) {
+            errorfmt("Error Creating ColorConfig: {}", c->geterror());
+            return nullptr;
+        }
+        config = std::move(c);
+    }
+    return config.get();
+}
+
+
+
 // Deconstruct the command line string, stripping directory names off of
 // any arguments. This is used for "update mode" to not think it's doing
 // a fresh maketx for relative paths and whatnot.
@@ -1036,6 +1641,9 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
         // Image buffer supplied that's backed by ImageCache -- create a
         // copy (very light weight, just another cache reference)
         src.reset(new ImageBuf(*input));
+    } else if (!input->contiguous()) {
+        // Pixels with padded scanlines -- copy them
+        src.reset(new ImageBuf(*input));
     } else {
         // Image buffer supplied that has pixels -- wrap it
         src.reset(new ImageBuf(input->spec(),
@@ -1146,9 +1754,28 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
                        < imagesize_t(local_mb_thresh * 1024 * 1024));
 
     bool verbose       = configspec.get_int_attribute("maketx:verbose") != 0;
+    bool streaming     = false;
+    if (configspec.get_int_attribute("maketx:stream")) {
+        std::string whynot = streaming_unsupported(mode, src->spec(),
+                                                   configspec, from_filename);
+        streaming          = whynot.empty();
+        if (!streaming && verbose)
+            print(outstream, "  Not streaming, because {}\n", whynot);
+    }
     double misc_time_1 = alltime.lap();
     STATUS("prep", misc_time_1);
-    if (from_filename) {
+    std::unique_ptr<ImageInput> streamin;
+    if (streaming) {
+        // Only open it; it's read a band at a time as it's written.
+        if (verbose)
+            outstream << "Streaming file: " << src->name() << std::endl;
+        streamin = ImageInput::open(src->name(), &inconfig);
+        if (!streamin) {
+            errorfmt("Could not open \"{}\" : {}", src->name(),
+                     OIIO::geterror());
+            return false;
+        }
+    } else if (from_filename) {
         if (verbose)
             outstream << "Reading file: " << src->name() << std::endl;
         if (!src->read(0, 0, read_local)) {
@@ -1179,6 +1806,30 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
         src  = latlong;
     }
 
+    if (mode == ImageBufAlgo::MakeTxEnvLatl
+        && configspec.get_int_attribute("maketx:envcdf")) {
+        // Store the importance sampling tables, so that renderers can load
+        // them rather than rebuild them from the pixels.
+        const ImageSpec& spec(src->spec());
+        int w = clamp(configspec.get_int_attribute("maketx:envcdfres", 512), 1,
+                      spec.width);
+        int h = std::max(1, int(int64_t(w) * spec.height / spec.width));
+        ImageBuf marginal, conditional;
+        if (!ImageBufAlgo::envlatl_cdf(marginal, conditional, *src, w, h)) {
+            errorfmt("{}", conditional.geterror());
+            return false;
+        }
+        int res[2] = { w, h };
+        configspec.attribute("oiio:EnvCDFResolution",
+                             TypeDesc(TypeDesc::INT, 2), res);
+        configspec.attribute("oiio:EnvCDFMarginal",
+                             TypeDesc(TypeDesc::FLOAT, h + 1),
+                             marginal.localpixels());
+        configspec.attribute("oiio:EnvCDFConditional",
+                             TypeDesc(TypeDesc::FLOAT, (w + 1) * h),
+                             conditional.localpixels());
+    }
+
     const bool is_bumpslopes = (mode == ImageBufAlgo::MakeTxBumpWithSlopes);
     if (is_bumpslopes) {
         ImageSpec newspec  = src->spec();
@@ -1298,7 +1949,7 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
     ImageBufAlgo::PixelStats pixel_stats;
     bool compute_stats = (constant_color_detect || opaque_detect
                           || compute_average_color || monochrome_detect);
-    if (compute_stats) {
+    if (compute_stats && !streaming) {
         pixel_stats = ImageBufAlgo::computePixelStats(*src);
     }
     double stat_pixelstatstime = alltime.lap();
@@ -1310,8 +1961,8 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
     // wrap mode at runtime.
     std::vector<float> constantColor(src->nchannels());
     bool isConstantColor = false;
-    if (compute_stats && src->spec().x == 0 && src->spec().y == 0
-        && src->spec().z == 0 && src->spec().full_x == 0
+    if (compute_stats && !streaming && src->spec().x == 0
+        && src->spec().y == 0 && src->spec().z == 0 && src->spec().full_x == 0
         && src->spec().full_y == 0 && src->spec().full_z == 0
         && src->spec().full_width == src->spec().width
         && src->spec().full_height == src->spec().height
@@ -1365,6 +2016,10 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
         && src->spec().alpha_channel < 0
         && pixel_stats.avg[0] == pixel_stats.avg[1]
         && pixel_stats.avg[0] == pixel_stats.avg[2]
+        && pixel_stats.min[0] == pixel_stats.min[1]
+        && pixel_stats.min[0] == pixel_stats.min[2]
+        && pixel_stats.max[0] == pixel_stats.max[1]
+        && pixel_stats.max[0] == pixel_stats.max[2]
         && ImageBufAlgo::isMonochrome(*src)) {
         if (verbose)
             print(
@@ -1568,8 +2223,16 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
         errorfmt("Unknown fixnan mode \"{}\"", fixnan);
         return false;
     }
+    // The pixel statistics count the nonfinite values too, so if they were
+    // gathered and found none, there's no need for any more passes over the
+    // image to fix or check them.
+    bool maybe_nonfinite = !compute_stats || streaming;
+    for (size_t c = 0; c < pixel_stats.nancount.size(); ++c)
+        if (pixel_stats.nancount[c] || pixel_stats.infcount[c])
+            maybe_nonfinite = true;
     int pixelsFixed = 0;
-    if (fixmode != ImageBufAlgo::NONFINITE_NONE
+    if (fixmode != ImageBufAlgo::NONFINITE_NONE && !streaming
+        && maybe_nonfinite
         && (srcspec.format.basetype == TypeDesc::FLOAT
             || srcspec.format.basetype == TypeDesc::HALF
             || srcspec.format.basetype == TypeDesc::DOUBLE)
@@ -1582,14 +2245,12 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
 
     // If --checknan was used and it's a floating point image, check for
     // nonfinite (NaN or Inf) values and abort if they are found.
-    if (configspec.get_int_attribute("maketx:checknan")
-        && (srcspec.format.basetype == TypeDesc::FLOAT
-            || srcspec.format.basetype == TypeDesc::HALF
-            || srcspec.format.basetype == TypeDesc::DOUBLE)) {
-        int found_nonfinite = 0;
-        ImageBufAlgo::parallel_image(get_roi(srcspec),
-                                     std::bind(check_nan_block, std::ref(*src),
-                                               _1, std::ref(found_nonfinite)));
+    bool checknan = configspec.get_int_attribute("maketx:checknan")
+                    && (srcspec.format.basetype == TypeDesc::FLOAT
+                        || srcspec.format.basetype == TypeDesc::HALF
+                        || srcspec.format.basetype == TypeDesc::DOUBLE);
+    if (checknan && !streaming && maybe_nonfinite) {
+        int found_nonfinite = count_nonfinite_pixels(*src);
         if (found_nonfinite) {
             errorfmt("maketx ERROR: Nan/Inf at {} pixels", found_nonfinite);
             return false;
@@ -1609,73 +2270,81 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
         "maketx:incolorspace");
     std::string outcolorspace = configspec.get_string_attribute(
         "maketx:outcolorspace");
+    bool unpremult = configspec.get_int_attribute("maketx:unpremult") != 0;
+    ColorProcessorHandle processor;
+    auto convert_stat_colors = [&]() -> bool {
+        if (isConstantColor) {
+            if (constantColor.size() < 3)
+                constantColor.resize(3, constantColor[0]);
+            if (!ImageBufAlgo::colorconvert(constantColor, processor.get(),
+                                            unpremult)) {
+                errorfmt("Error applying color conversion to constant color.");
+                return false;
+            }
+        }
+
+        if (compute_average_color) {
+            if (pixel_stats.avg.size() < 3)
+                pixel_stats.avg.resize(3, pixel_stats.avg[0]);
+            if (!ImageBufAlgo::colorconvert(pixel_stats.avg, processor.get(),
+                                            unpremult)) {
+                errorfmt("Error applying color conversion to average color.");
+                return false;
+            }
+        }
+        return true;
+    };
     if (!incolorspace.empty() && !outcolorspace.empty()
         && incolorspace != outcolorspace) {
         if (verbose)
             outstream << "  Converting from colorspace " << incolorspace
                       << " to colorspace " << outcolorspace << std::endl;
 
-        // Buffer for the color-corrected version. Start by making it just
-        // another pointer to the original source.
-        std::shared_ptr<ImageBuf> ccSrc(src);  // color-corrected buffer
-
-        if (src->spec().format != TypeDesc::FLOAT) {
-            // If the original src buffer isn't float, make a scratch space
-            // that is float.
-            ImageSpec floatSpec = src->spec();
-            floatSpec.set_format(TypeDesc::FLOAT);
-            ccSrc.reset(new ImageBuf(floatSpec));
-        }
-
-        ColorConfig colorconfig(colorconfigname);
-        if (colorconfig.has_error()) {
-            errorfmt("Error Creating ColorConfig: {}", colorconfig.geterror());
+        const ColorConfig* colorconfig = shared_colorconfig(colorconfigname);
+        if (!colorconfig)
             return false;
-        }
 
-        ColorProcessorHandle processor
-            = colorconfig.createColorProcessor(incolorspace, outcolorspace);
-        if (!processor || colorconfig.has_error()) {
+        processor = colorconfig->createColorProcessor(incolorspace,
+                                                      outcolorspace);
+        if (!processor) {
             errorfmt("Error Creating Color Processor: {}",
-                     colorconfig.geterror());
+                     colorconfig->geterror());
             return false;
         }
 
-        bool unpremult = configspec.get_int_attribute("maketx:unpremult") != 0;
         if (unpremult && verbose)
             outstream << "  Unpremulting image..." << std::endl;
 
-        if (!ImageBufAlgo::colorconvert(*ccSrc, *src, processor.get(),
-                                        unpremult)) {
-            errorfmt("Error applying color conversion to image.");
-            return false;
-        }
+        // When streaming, each band is converted as it's read, and the
+        // constant and average colors once they're known.
+        if (!streaming) {
+            // Buffer for the color-corrected version. Start by making it
+            // just another pointer to the original source.
+            std::shared_ptr<ImageBuf> ccSrc(src);  // color-corrected buffer
+
+            if (src->spec().format != TypeDesc::FLOAT) {
+                // If the original src buffer isn't float, make a scratch
+                // space that is float.
+                ImageSpec floatSpec = src->spec();
+                floatSpec.set_format(TypeDesc::FLOAT);
+                ccSrc.reset(new ImageBuf(floatSpec));
+            }
 
-        if (isConstantColor) {
-            if (constantColor.size() < 3)
-                constantColor.resize(3, constantColor[0]);
-            if (!ImageBufAlgo::colorconvert(constantColor, processor.get(),
+            if (!ImageBufAlgo::colorconvert(*ccSrc, *src, processor.get(),
                                             unpremult)) {
-                errorfmt("Error applying color conversion to constant color.");
+                errorfmt("Error applying color conversion to image.");
                 return false;
             }
-        }
 
-        if (compute_average_color) {
-            if (pixel_stats.avg.size() < 3)
-                pixel_stats.avg.resize(3, pixel_stats.avg[0]);
-            if (!ImageBufAlgo::colorconvert(pixel_stats.avg, processor.get(),
-                                            unpremult)) {
-                errorfmt("Error applying color conversion to average color.");
+            if (!convert_stat_colors())
                 return false;
-            }
-        }
 
-        // swap the color-converted buffer and src (making src be the
-        // working master that's color converted).
-        std::swap(src, ccSrc);
-        // N.B. at this point, ccSrc will go out of scope, freeing it if
-        // it was a scratch buffer.
+            // swap the color-converted buffer and src (making src be the
+            // working master that's color converted).
+            std::swap(src, ccSrc);
+            // N.B. at this point, ccSrc will go out of scope, freeing it if
+            // it was a scratch buffer.
+        }
         stat_colorconverttime += alltime.lap();
         STATUS("color convert", stat_colorconverttime);
     }
@@ -1725,7 +2394,9 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
     STATUS("misc3", misc_time_4);
 
     std::shared_ptr<ImageBuf> toplevel;  // Ptr to top level of mipmap
-    if (!do_resize && dstspec.format == src->spec().format) {
+    if (streaming) {
+        // The top level is made a band at a time by read_band, below
+    } else if (!do_resize && dstspec.format == src->spec().format) {
         // No resize needed, no format conversion needed -- just stick to
         // the image we've already got
         toplevel = src;
@@ -1785,6 +2456,8 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
     dstspec.erase_attribute("AverageColor=");
     dstspec.erase_attribute("oiio:SHA-1=");
     dstspec.erase_attribute("SHA-1=");
+    dstspec.erase_attribute("oiio:ContentHash=");
+    dstspec.erase_attribute("oiio:TileStats");
     if (desc.size()) {
         Strutil::excise_string_after_head(desc, "oiio:ConstantColor=");
         Strutil::excise_string_after_head(desc, "ConstantColor=");
@@ -1792,6 +2465,8 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
         Strutil::excise_string_after_head(desc, "AverageColor=");
         Strutil::excise_string_after_head(desc, "oiio:SHA-1=");
         Strutil::excise_string_after_head(desc, "SHA-1=");
+        Strutil::excise_string_after_head(desc, "oiio:ContentHash=");
+        Strutil::excise_string_after_head(desc, "oiio:TileStats=");
         updatedDesc = true;
     }
 
@@ -1811,28 +2486,107 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
     if (configspec.get_int_attribute("maketx:highlightcomp", 0))
         addlHashData << "highlightcomp=1 ";
 
+    // When streaming, the bands of the top level are read, then have nans
+    // fixed or checked, and are color converted, as the whole image would
+    // be otherwise.
+    auto read_raw = [&](int ybegin, int yend, float* data) -> bool {
+        if (!streamin->read_scanlines(0, 0, ybegin, yend, 0, 0,
+                                      srcspec.nchannels, TypeFloat, data)) {
+            errorfmt("Could not read \"{}\" : {}", filename,
+                     streamin->geterror());
+            return false;
+        }
+        return true;
+    };
+    auto process_band = [&](int ybegin, int yend, float* data) -> bool {
+        ImageSpec bandspec(srcspec.width, yend - ybegin, srcspec.nchannels,
+                           TypeFloat);
+        bandspec.alpha_channel = srcspec.alpha_channel;
+        ImageBuf band(bandspec, span<float>(data, bandspec.image_pixels()
+                                                      * bandspec.nchannels));
+        int fixed = 0;
+        if (fixmode != ImageBufAlgo::NONFINITE_NONE
+            && (srcspec.format.basetype == TypeDesc::FLOAT
+                || srcspec.format.basetype == TypeDesc::HALF
+                || srcspec.format.basetype == TypeDesc::DOUBLE)) {
+            if (!ImageBufAlgo::fixNonFinite(band, band, fixmode, &fixed)) {
+                errorfmt("Error fixing nans/infs.");
+                return false;
+            }
+            pixelsFixed += fixed;
+        }
+        if (checknan) {
+            int found_nonfinite = count_nonfinite_pixels(band);
+            if (found_nonfinite) {
+                errorfmt("maketx ERROR: Nan/Inf at {} pixels",
+                         found_nonfinite);
+                return false;
+            }
+        }
+        if (processor
+            && !ImageBufAlgo::colorconvert(band, band, processor.get(),
+                                           unpremult)) {
+            errorfmt("Error applying color conversion to image.");
+            return false;
+        }
+        return true;
+    };
+    auto read_band = [&](int ybegin, int yend, float* data) -> bool {
+        return read_raw(ybegin, yend, data)
+               && process_band(ybegin, yend, data);
+    };
+
     const int sha1_blocksize = 256;
-    std::string hash_digest
-        = configspec.get_int_attribute("maketx:hash", 1)
-              ? ImageBufAlgo::computePixelHashSHA1(*toplevel,
-                                                   addlHashData.str(),
-                                                   ROI::All(), sha1_blocksize)
-              : "";
+    bool compute_hash        = configspec.get_int_attribute("maketx:hash", 1);
+    bool fasthash = Strutil::iequals(
+        configspec.get_string_attribute("maketx:hashtype"), "fast");
+    const char* hash_attrib = fasthash ? "oiio:ContentHash" : "oiio:SHA-1";
+    std::string hash_digest;
+    if (streaming && (compute_hash || compute_stats)) {
+        // What goes in the header must be known before the first band can
+        // be written, so this costs a pass over the image of its own.
+        if (verbose)
+            print(outstream, "  Computing statistics and hash\n");
+        auto stream_pass = fasthash ? stream_stats_and_hash<FastHash128>
+                                    : stream_stats_and_hash<SHA1>;
+        if (!stream_pass(srcspec, dstspec.tile_height, read_raw, process_band,
+                         compute_stats, pixel_stats, compute_hash,
+                         addlHashData.str(), sha1_blocksize, hash_digest))
+            return false;
+        isConstantColor = compute_stats && pixel_stats.min == pixel_stats.max;
+        if (isConstantColor)
+            constantColor = pixel_stats.min;
+        if (processor && !convert_stat_colors())
+            return false;
+        pixelsFixed = 0;  // They'll be fixed again as they're written
+    } else if (compute_hash && fasthash) {
+        hash_digest = ImageBufAlgo::computePixelHash(*toplevel,
+                                                     addlHashData.str(),
+                                                     ROI::All(),
+                                                     sha1_blocksize);
+    } else if (compute_hash) {
+        hash_digest = ImageBufAlgo::computePixelHashSHA1(*toplevel,
+                                                         addlHashData.str(),
+                                                         ROI::All(),
+                                                         sha1_blocksize);
+    }
     if (hash_digest.length()) {
         if (out->supports("arbitrary_metadata")) {
-            dstspec.attribute("oiio:SHA-1", hash_digest);
+            dstspec.attribute(hash_attrib, hash_digest);
         } else {
             if (desc.length())
                 desc += " ";
-            desc += "oiio:SHA-1=";
+            desc += hash_attrib;
+            desc += "=";
             desc += hash_digest;
             updatedDesc = true;
         }
         if (verbose)
-            outstream << "  SHA-1: " << hash_digest << std::endl;
+            outstream << (fasthash ? "  ContentHash: " : "  SHA-1: ")
+                      << hash_digest << std::endl;
     }
     double stat_hashtime = alltime.lap();
-    STATUS("SHA-1 hash", stat_hashtime);
+    STATUS(fasthash ? "Content hash" : "SHA-1 hash", stat_hashtime);
 
     if (isConstantColor) {
         std::string colstr = Strutil::join(constantColor, ",",
@@ -1893,10 +2647,21 @@ make_texture_impl(ImageBufAlgo::MakeTextureMode mode, const ImageBuf* input,
 
     // Write out, and compute, the mipmap levels for the specified image
     bool nomipmap = configspec.get_int_attribute("maketx:nomipmap") != 0;
-    bool ok = write_mipmap(mode, toplevel, dstspec, tmpfilename, out.get(),
-                           out_dataformat, !shadowmode && !nomipmap, filtername,
-                           configspec, outstream, stat_writetime, stat_miptime,
-                           peak_mem);
+    bool ok;
+    if (streaming) {
+        ok = write_mipmap_streaming(read_band, dstspec, tmpfilename, out.get(),
+                                    out_dataformat, !nomipmap, configspec,
+                                    outstream, stat_readtime, stat_writetime,
+                                    stat_miptime, peak_mem);
+        if (verbose && pixelsFixed)
+            outstream << "  Warning: " << pixelsFixed
+                      << " nan/inf pixels fixed.\n";
+    } else {
+        ok = write_mipmap(mode, toplevel, dstspec, tmpfilename, out.get(),
+                          out_dataformat, !shadowmode && !nomipmap, filtername,
+                          configspec, outstream, stat_writetime, stat_miptime,
+                          peak_mem);
+    }
     out.reset();  // don't need it any more
 
     // If using update mode, stamp the output file with a modification time
@@ -0,0 +1,513 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+// oiio_benchmarks -- a consistent suite of benchmarks of the operations
+// whose speed matters most: starting up to open a first image, pixel data
+// conversion, the ImageBufAlgo families, reading and writing each format,
+// ImageCache hits and misses, and texture lookups in each filtering mode.
+// The results may be written as JSON, to compare runs on the same hardware
+// from one release to the next.
+
+
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <regex>
+#include <vector>
+
+#include <OpenImageIO/argparse.h>
+#include <OpenImageIO/benchmark.h>
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/half.h>
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/texture.h>
+#include <OpenImageIO/ustring.h>
+
+using namespace OIIO;
+
+static int ntrials    = 10;
+static int numthreads = 0;
+static std::string sizelist("256,1024");
+static std::string filterpattern;
+static std::string jsonfilename;
+static std::regex filter;
+static std::vector<int> sizes;
+static std::string tmpdir;
+static std::string firstopen;
+
+
+
+// The results of one benchmark, for the JSON output.
+struct Result {
+    std::string name;
+    Benchmarker bench;
+};
+static std::vector<Result> results;
+
+
+
+static void
+getargs(int argc, char* argv[])
+{
+    ArgParse ap;
+    // clang-format off
+    ap.intro("oiio_benchmarks -- benchmark the main operations of OpenImageIO\n"
+             OIIO_INTRO_STRING)
+      .usage("oiio_benchmarks [options]");
+
+    ap.arg("--threads %d:N", &numthreads)
+      .help("Number of threads (default: #cores)");
+    ap.arg("--trials %d:N", &ntrials)
+      .help(Strutil::fmt::format("Number of trials of each benchmark (default: {})", ntrials));
+    ap.arg("--sizes %s:LIST", &sizelist)
+      .help(Strutil::fmt::format("Comma-separated image sizes for the ImageBufAlgo benchmarks (default: {})", sizelist));
+    ap.arg("--filter %s:REGEX", &filterpattern)
+      .help("Only run the benchmarks whose names match this regular expression");
+    ap.arg("--json %s:FILENAME", &jsonfilename)
+      .help("Write the results to this file as JSON");
+    ap.arg("--first-open %s:FILENAME", &firstopen)
+      .hidden();  // Used by the startup benchmark
+    // clang-format on
+
+    ap.parse(argc, (const char**)argv);
+    sizes = Strutil::extract_from_list_string<int>(sizelist);
+    if (filterpattern.size())
+        filter = std::regex(filterpattern);
+}
+
+
+
+// Should the named benchmark be run?
+static bool
+wanted(string_view name)
+{
+    return filterpattern.empty()
+           || std::regex_search(std::string(name), filter);
+}
+
+
+
+// Run func as the named benchmark, each call of which does `work` units
+// of work (pixels, values, or lookups), and record the results.
+static void
+bench(string_view name, size_t work, function_view<void()> func)
+{
+    if (!wanted(name))
+        return;
+    Result r;
+    r.name = name;
+    r.bench.trials(ntrials).work(work).indent(2);
+    r.bench(name, [&]() { func(); });
+    results.push_back(std::move(r));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+// The time from starting a process to having opened its first image, which
+// is most of the run time of short-lived tools and scripts.
+
+static void
+benchmark_startup()
+{
+    Strutil::print("Startup (per process):\n");
+    std::string filename = tmpdir + "/first.tif";
+    ImageBuf img(ImageSpec(64, 64, 3, TypeUInt8));
+    if (!img.write(filename)) {
+        Strutil::print(stderr, "  {}\n", img.geterror());
+        return;
+    }
+    // Each trial runs this program again, to do nothing but open the file.
+    std::string command = Strutil::fmt::format("\"{}\" --first-open \"{}\"",
+                                               Sysutil::this_program_path(),
+                                               filename);
+    bench("startup/first open", 1,
+          [&]() { DoNotOptimize(std::system(command.c_str())); });
+    Filesystem::remove(filename);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+// Pixel data conversion between the common types
+
+static void
+benchmark_conversion()
+{
+    Strutil::print("Pixel data conversion (per value):\n");
+    const int n = 1 << 20;
+    const TypeDesc types[] = { TypeUInt8, TypeUInt16, TypeHalf, TypeFloat };
+    std::vector<float> ramp(n);
+    for (int i = 0; i < n; ++i)
+        ramp[i] = float(i % 4096) / 4095.0f;
+    for (TypeDesc from : types) {
+        std::vector<char> src(n * from.size());
+        convert_pixel_values(TypeFloat, ramp.data(), from, src.data(), n);
+        for (TypeDesc to : types) {
+            if (to == from)
+                continue;
+            std::vector<char> dst(n * to.size());
+            bench(Strutil::fmt::format("convert/{}->{}", from, to), n, [&]() {
+                convert_pixel_values(from, src.data(), to, dst.data(), n);
+                clobber(dst.data());
+            });
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+// A representative of each ImageBufAlgo family, at each size and type
+
+static void
+benchmark_iba()
+{
+    Strutil::print("ImageBufAlgo (per pixel):\n");
+    const TypeDesc types[] = { TypeUInt8, TypeHalf, TypeFloat };
+    ImageBuf kernel = ImageBufAlgo::make_kernel("gaussian", 5, 5);
+    for (int size : sizes) {
+        for (TypeDesc type : types) {
+            ImageSpec spec(size, size, 4, type);
+            ImageBuf A(spec), B(spec), C(spec);
+            ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f, false, 1);
+            ImageBufAlgo::noise(B, "uniform", 0.0f, 1.0f, false, 2);
+            ImageBufAlgo::noise(C, "uniform", 0.0f, 1.0f, false, 3);
+            size_t npixels = size_t(size) * size;
+            auto name      = [&](string_view op) {
+                return Strutil::fmt::format("iba/{}/{}/{}", op, type, size);
+            };
+            // Each destination is allocated by the first call, and reused
+            // by the rest.
+            ImageBuf dst;
+            const float gray[] = { 0.5f, 0.5f, 0.5f, 0.5f };
+            dst.reset(spec);
+            bench(name("fill"), npixels,
+                  [&]() { ImageBufAlgo::fill(dst, gray); });
+            dst.reset();
+            bench(name("add"), npixels,
+                  [&]() { ImageBufAlgo::add(dst, A, B); });
+            dst.reset();
+            bench(name("mad"), npixels,
+                  [&]() { ImageBufAlgo::mad(dst, A, B, C); });
+            dst.reset();
+            bench(name("over"), npixels,
+                  [&]() { ImageBufAlgo::over(dst, A, B); });
+            dst.reset();
+            const int order[] = { 2, 1, 0 };
+            bench(name("channels"), npixels,
+                  [&]() { ImageBufAlgo::channels(dst, A, 3, order); });
+            dst.reset();
+            bench(name("resize"), npixels, [&]() {
+                ImageBufAlgo::resize(dst, A, {},
+                                     ROI(0, size / 2, 0, size / 2, 0, 1, 0, 4));
+            });
+            dst.reset();
+            bench(name("rotate90"), npixels,
+                  [&]() { ImageBufAlgo::rotate90(dst, A); });
+            dst.reset();
+            bench(name("convolve"), npixels,
+                  [&]() { ImageBufAlgo::convolve(dst, A, kernel); });
+            dst.reset();
+            bench(name("colorconvert"), npixels, [&]() {
+                ImageBufAlgo::colorconvert(dst, A, "linear", "sRGB");
+            });
+            bench(name("computePixelStats"), npixels, [&]() {
+                auto stats = ImageBufAlgo::computePixelStats(A);
+                DoNotOptimize(stats.avg[0]);
+            });
+            bench(name("compare"), npixels, [&]() {
+                auto cr = ImageBufAlgo::compare(A, B, 0.01f, 0.01f);
+                DoNotOptimize(cr.meanerror);
+            });
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+// Reading and writing each format, with each compression
+
+static void
+benchmark_io()
+{
+    Strutil::print("Image file I/O (per pixel):\n");
+    struct Format {
+        const char* extension;
+        const char* compression;
+        TypeDesc type;
+    };
+    const Format formats[] = {
+        { "tif", "none", TypeUInt8 }, { "tif", "lzw", TypeUInt8 },
+        { "tif", "zip", TypeUInt8 },  { "tif", "zip", TypeHalf },
+        { "exr", "none", TypeHalf },  { "exr", "zip", TypeHalf },
+        { "exr", "piz", TypeHalf },   { "exr", "dwaa", TypeHalf },
+        { "exr", "zip", TypeFloat },  { "png", "", TypeUInt8 },
+        { "jpg", "", TypeUInt8 },     { "dpx", "", TypeUInt16 },
+        { "tga", "", TypeUInt8 },
+    };
+    // A smooth gradient with a little noise compresses roughly like a
+    // photograph or a render.
+    const int size     = 1024;
+    const float top[]  = { 0.1f, 0.2f, 0.4f };
+    const float bott[] = { 0.8f, 0.5f, 0.2f };
+    ImageBuf gradient(ImageSpec(size, size, 3, TypeFloat));
+    ImageBufAlgo::fill(gradient, top, bott);
+    ImageBufAlgo::noise(gradient, "gaussian", 0.0f, 0.02f);
+    size_t npixels = size_t(size) * size;
+
+    for (auto& f : formats) {
+        std::string id = f.compression[0]
+                             ? Strutil::fmt::format("{}-{}-{}", f.extension,
+                                                    f.compression, f.type)
+                             : Strutil::fmt::format("{}-{}", f.extension,
+                                                    f.type);
+        std::string filename = Strutil::fmt::format("{}/io.{}", tmpdir,
+                                                    f.extension);
+        if (!ImageOutput::create(filename)) {
+            OIIO::geterror();  // Not built with this format
+            continue;
+        }
+        ImageBuf img = gradient.copy(f.type);
+        if (f.compression[0])
+            img.specmod().attribute("compression", f.compression);
+        if (!img.write(filename)) {
+            Strutil::print(stderr, "  {}\n", img.geterror());
+            continue;
+        }
+        bench(Strutil::fmt::format("io/write/{}", id), npixels,
+              [&]() { img.write(filename); });
+        std::vector<char> pixels(img.spec().image_bytes());
+        bench(Strutil::fmt::format("io/read/{}", id), npixels, [&]() {
+            auto in = ImageInput::open(filename);
+            if (in)
+                in->read_image(0, 0, 0, 3, f.type, pixels.data());
+        });
+        Filesystem::remove(filename);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+// ImageCache tiles that are already in the cache, and those that aren't
+
+static void
+benchmark_imagecache()
+{
+    Strutil::print("ImageCache (per tile):\n");
+    // 32 MB of 32 KB tiles, three times the smallest cache.
+    const int size = 2048, tilesize = 64, ntiles = size / tilesize;
+    std::string filename = tmpdir + "/tiled.exr";
+    ImageSpec spec(size, size, 4, TypeHalf);
+    spec.tile_width  = tilesize;
+    spec.tile_height = tilesize;
+    ImageBuf img(spec);
+    ImageBufAlgo::noise(img, "uniform", 0.0f, 1.0f);
+    if (!img.write(filename)) {
+        Strutil::print(stderr, "  {}\n", img.geterror());
+        return;
+    }
+    ustring name(filename);
+
+    auto ic = ImageCache::create(false);
+    ic->attribute("max_memory_MB", 256.0f);
+    ImageCache::Tile* tile = ic->get_tile(name, 0, 0, 0, 0, 0);
+    ic->release_tile(tile);
+    bench("imagecache/tile hit", 1, [&]() {
+        ImageCache::Tile* t = ic->get_tile(name, 0, 0, 0, 0, 0);
+        ic->release_tile(t);
+    });
+    std::vector<half> pixels(tilesize * tilesize * 4);
+    bench("imagecache/get_pixels hit", 1, [&]() {
+        ic->get_pixels(name, 0, 0, 0, tilesize, 0, tilesize, 0, 1, 0, 4,
+                       TypeHalf, pixels.data());
+    });
+
+    // Cycling through every tile of an image three times the size of the
+    // cache, each one has been evicted by the time it's needed again.
+    auto small = ImageCache::create(false);
+    small->attribute("max_memory_MB", 10.0f);
+    int next = 0;
+    bench("imagecache/tile miss", 1, [&]() {
+        int x = (next % ntiles) * tilesize, y = (next / ntiles) * tilesize;
+        next  = (next + 1) % (ntiles * ntiles);
+        ImageCache::Tile* t = small->get_tile(name, 0, 0, x, y, 0);
+        small->release_tile(t);
+    });
+    bench("imagecache/reopen", 1, [&]() {
+        small->invalidate(name);
+        ImageCache::Tile* t = small->get_tile(name, 0, 0, 0, 0, 0);
+        small->release_tile(t);
+    });
+    ImageCache::destroy(small);
+    ImageCache::destroy(ic);
+    Filesystem::remove(filename);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+// Texture lookups with each interpolation and MIP mode
+
+static void
+benchmark_texture()
+{
+    Strutil::print("Texture lookups (per lookup):\n");
+    std::string filename = tmpdir + "/texture.tx";
+    ImageBuf src(ImageSpec(2048, 2048, 3, TypeUInt8));
+    ImageBufAlgo::noise(src, "uniform", 0.0f, 1.0f);
+    ImageSpec config;
+    config.tile_width  = 64;
+    config.tile_height = 64;
+    if (!ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture, src,
+                                    filename, config)) {
+        Strutil::print(stderr, "  {}\n", OIIO::geterror());
+        return;
+    }
+
+    // Lookups scattered over the texture, with footprints spanning a few
+    // texels of the top level, and twice as long as they are wide.
+    const int nlookups = 1024;
+    std::vector<float> s(nlookups), t(nlookups);
+    for (int i = 0; i < nlookups; ++i) {
+        s[i] = float((i * 7919) % nlookups) / nlookups;
+        t[i] = float((i * 104729) % nlookups) / nlookups;
+    }
+    const float dsdx = 4.0f / 2048, dtdy = 8.0f / 2048;
+
+    auto ts = TextureSystem::create(false);
+    TextureSystem::TextureHandle* handle = ts->get_texture_handle(
+        ustring(filename));
+    TextureSystem::Perthread* thread_info = ts->get_perthread_info();
+    const std::pair<Tex::InterpMode, const char*> interps[] = {
+        { Tex::InterpMode::Closest, "closest" },
+        { Tex::InterpMode::Bilinear, "bilinear" },
+        { Tex::InterpMode::Bicubic, "bicubic" },
+        { Tex::InterpMode::SmartBicubic, "smartbicubic" },
+    };
+    const std::pair<Tex::MipMode, const char*> mips[] = {
+        { Tex::MipMode::NoMIP, "nomip" },
+        { Tex::MipMode::OneLevel, "onelevel" },
+        { Tex::MipMode::Trilinear, "trilinear" },
+        { Tex::MipMode::Aniso, "aniso" },
+        { Tex::MipMode::EWA, "ewa" },
+    };
+    for (auto& interp : interps) {
+        for (auto& mip : mips) {
+            TextureOpt opt;
+            opt.interpmode = interp.first;
+            opt.mipmode    = mip.first;
+            float result[3];
+            bench(Strutil::fmt::format("texture/{}/{}", interp.second,
+                                       mip.second),
+                  nlookups, [&]() {
+                      for (int i = 0; i < nlookups; ++i)
+                          ts->texture(handle, thread_info, opt, s[i], t[i],
+                                      dsdx, 0.0f, 0.0f, dtdy, 3, result);
+                      DoNotOptimize(result[0]);
+                  });
+        }
+    }
+    TextureSystem::destroy(ts);
+    Filesystem::remove(filename);
+}
+
+
+
+// Quote s as a JSON string.
+static std::string
+json_string(string_view s)
+{
+    std::string r = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            r += '\\';
+        if ((unsigned char)c < 0x20)
+            r += Strutil::fmt::format("\\u{:04x}", int(c));
+        else
+            r += c;
+    }
+    return r + "\"";
+}
+
+
+
+// Write the results, with what's needed to know which runs are comparable:
+// the version, the SIMD it was built for, and the machine's threads.
+static bool
+write_json(const std::string& filename)
+{
+    char date[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S",
+                  std::localtime(&now));
+    std::string out = Strutil::fmt::format(
+        "{{\n  \"oiio_version\": {},\n  \"build_simd\": {},\n"
+        "  \"threads\": {},\n  \"date\": {},\n  \"results\": [\n",
+        json_string(OIIO_VERSION_STRING),
+        json_string(OIIO::get_string_attribute("build:simd")),
+        OIIO::get_int_attribute("threads"), json_string(date));
+    for (auto& r : results) {
+        const Benchmarker& b(r.bench);
+        // Times are in ns per call, rates in units of work per second.
+        out += Strutil::fmt::format(
+            "    {{\"name\": {}, \"avg_ns\": {:.3f}, \"stddev_ns\": {:.3f}, "
+            "\"median_ns\": {:.3f}, \"range_ns\": {:.3f}, \"work\": {}, "
+            "\"rate\": {:.6g}, \"iterations\": {}, \"trials\": {}}}{}\n",
+            json_string(r.name), b.avg() * 1.0e9, b.stddev() * 1.0e9,
+            b.median() * 1.0e9, b.range() * 1.0e9, b.work(),
+            b.avg() > 0.0 ? b.work() / b.avg() : 0.0, b.iterations(),
+            b.trials(), &r == &results.back() ? "" : ",");
+    }
+    out += "  ]\n}\n";
+    return Filesystem::write_text_file(filename, out);
+}
+
+
+
+int
+main(int argc, char* argv[])
+{
+    getargs(argc, argv);
+    if (firstopen.size()) {
+        // Just the startup benchmark's child process
+        auto in = ImageInput::open(firstopen);
+        return in ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    OIIO::attribute("threads", numthreads);
+
+    tmpdir = Filesystem::temp_directory_path() + "/oiio_benchmarks-"
+             + Filesystem::unique_path();
+    std::string err;
+    if (!Filesystem::create_directory(tmpdir, err)) {
+        Strutil::print(stderr, "oiio_benchmarks: {}\n", err);
+        return EXIT_FAILURE;
+    }
+
+    benchmark_startup();
+    benchmark_conversion();
+    benchmark_iba();
+    benchmark_io();
+    benchmark_imagecache();
+    benchmark_texture();
+
+    Filesystem::remove_all(tmpdir);
+    int ret = EXIT_SUCCESS;
+    if (jsonfilename.size() && !write_json(jsonfilename)) {
+        Strutil::print(stderr, "oiio_benchmarks: Could not write {}\n",
+                       jsonfilename);
+        ret = EXIT_FAILURE;
+    }
+    shutdown();
+    return ret;
+}
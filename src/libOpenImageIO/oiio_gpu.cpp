@@ -13,6 +13,8 @@
 #endif
 
 #include "imageio_pvt.h"
+#include "oiio_gpu_prv.h"
+#include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
@@ -212,6 +214,156 @@ device_free(void* mem)
 }
 
 
+
+void*
+gpu_malloc(size_t size)
+{
+#if defined(OIIO_USE_CUDA) && defined(OIIO_CUDA_IBA_EXPERIMENTAL)
+    void* mem = nullptr;
+    if (oiio_compute_device == ComputeDevice::CUDA
+        && CUDA_CHECK(cudaMalloc(&mem, size)))
+        return mem;
+    cuda_geterror();  // clear the error
+#endif
+    return nullptr;
+}
+
+
+
+void
+gpu_free(void* mem)
+{
+#if defined(OIIO_USE_CUDA) && defined(OIIO_CUDA_IBA_EXPERIMENTAL)
+    if (mem)
+        CUDA_CHECK(cudaFree(mem));
+#endif
+}
+
+
+
+bool
+gpu_copy(void* dst, const void* src, size_t size, bool to_device)
+{
+#if defined(OIIO_USE_CUDA) && defined(OIIO_CUDA_IBA_EXPERIMENTAL)
+    if (CUDA_CHECK(cudaMemcpy(dst, src, size,
+                              to_device ? cudaMemcpyHostToDevice
+                                        : cudaMemcpyDeviceToHost)))
+        return true;
+    OIIO::debugfmt("gpu_copy: {}", cuda_geterror());
+#endif
+    return false;
+}
+
+
+
+bool
+gpu_pixelmath(GPUOp op, ImageBuf& R, const ImageBuf& A, const ImageBuf* B,
+              cspan<float> Bval, const ImageBuf* C, cspan<float> Cval,
+              ROI roi)
+{
+#if defined(OIIO_USE_CUDA) && defined(OIIO_CUDA_IBA_EXPERIMENTAL)
+    if (oiio_compute_device != ComputeDevice::CUDA)
+        return false;
+    const int nc = A.nchannels();
+    // Check for device pixels first, since localpixels() moves them.
+    auto usable = [&](const ImageBuf* img) {
+        return !img
+               || ((img->devicepixels()
+                    || (img->localpixels() && img->contiguous()))
+                   && img->spec().format == TypeFloat
+                   && img->nchannels() == nc && img->roi().contains(roi));
+    };
+    if (roi.chbegin != 0 || roi.chend != nc || roi.depth() != 1
+        || !usable(&R) || !usable(&A) || !usable(B) || !usable(C)
+        || (!B && (op == GPUOp::Over || int(Bval.size()) < nc))
+        || (op == GPUOp::Mad && !C && int(Cval.size()) < nc)
+        || (op == GPUOp::Over && A.spec().alpha_channel < 0))
+        return false;
+    if (op != GPUOp::Mad)
+        C = nullptr;
+
+    // One device allocation: R, A, and any of B and C that are images,
+    // then the per-channel values of any that are not.
+    const size_t nvalues  = size_t(roi.npixels()) * nc;
+    const size_t rowbytes = size_t(roi.width()) * nc * sizeof(float);
+    const size_t nimages  = 2 + (B ? 1 : 0) + (C ? 1 : 0);
+    float* dev            = nullptr;
+    if (!CUDA_CHECK(cudaMalloc(&dev, (nimages * nvalues + 2 * nc)
+                                         * sizeof(float)))) {
+        OIIO::debugfmt("gpu_pixelmath: {}", cuda_geterror());
+        return false;
+    }
+    float* d_r    = dev;
+    float* d_a    = d_r + nvalues;
+    float* d_b    = B ? d_a + nvalues : nullptr;
+    float* d_c    = C ? d_a + (B ? 2 : 1) * nvalues : nullptr;
+    float* d_bval = dev + nimages * nvalues;
+    float* d_cval = d_bval + nc;
+    // Images already on the device are laid out contiguously there.
+    auto deviceaddr = [&](const ImageBuf& img, const void* devpixels) {
+        const ImageSpec& spec = img.spec();
+        return (char*)devpixels
+               + ((roi.ybegin - spec.y) * imagesize_t(spec.width)
+                  + (roi.xbegin - spec.x))
+                     * spec.pixel_bytes();
+    };
+    auto upload = [&](float* d, const ImageBuf& img) {
+        if (const void* devpixels = img.devicepixels())
+            return CUDA_CHECK(cudaMemcpy2DAsync(
+                d, rowbytes, deviceaddr(img, devpixels),
+                img.spec().scanline_bytes(), rowbytes, roi.height(),
+                cudaMemcpyDeviceToDevice, cuda_stream));
+        return CUDA_CHECK(cudaMemcpy2DAsync(
+            d, rowbytes, img.pixeladdr(roi.xbegin, roi.ybegin, roi.zbegin),
+            img.scanline_stride(), rowbytes, roi.height(),
+            cudaMemcpyHostToDevice, cuda_stream));
+    };
+    bool ok = upload(d_a, A);
+    ok &= B ? upload(d_b, *B)
+            : CUDA_CHECK(cudaMemcpyAsync(d_bval, Bval.data(),
+                                         nc * sizeof(float),
+                                         cudaMemcpyHostToDevice, cuda_stream));
+    if (op == GPUOp::Mad)
+        ok &= C ? upload(d_c, *C)
+                : CUDA_CHECK(cudaMemcpyAsync(d_cval, Cval.data(),
+                                             nc * sizeof(float),
+                                             cudaMemcpyHostToDevice,
+                                             cuda_stream));
+    ok = ok
+         && cuda_pixelmath(op, d_r, d_a, d_b, d_c, d_bval, d_cval, nvalues, nc,
+                           A.spec().alpha_channel, cuda_stream);
+    // Leave the result on the device for the next operation if R is
+    // already there, or if it is all being overwritten (and only now that
+    // the inputs, one of which might be R, have been uploaded).
+    if (ok) {
+        void* rdev = R.devicepixels();
+        if (!rdev && roi == R.roi()) {
+            ok   = CUDA_CHECK(cudaStreamSynchronize(cuda_stream));
+            rdev = ok ? R.to_device(false) : nullptr;
+        }
+        if (rdev)
+            ok = ok
+                 && CUDA_CHECK(cudaMemcpy2DAsync(
+                     deviceaddr(R, rdev), R.spec().scanline_bytes(), d_r,
+                     rowbytes, rowbytes, roi.height(),
+                     cudaMemcpyDeviceToDevice, cuda_stream));
+        else
+            ok = CUDA_CHECK(cudaMemcpy2DAsync(
+                R.pixeladdr(roi.xbegin, roi.ybegin, roi.zbegin),
+                R.scanline_stride(), d_r, rowbytes, rowbytes, roi.height(),
+                cudaMemcpyDeviceToHost, cuda_stream));
+        ok = ok && CUDA_CHECK(cudaStreamSynchronize(cuda_stream));
+    }
+    CUDA_CHECK(cudaFree(dev));
+    if (!ok)
+        OIIO::debugfmt("gpu_pixelmath: {}", cuda_geterror());
+    return ok;
+#else
+    return false;
+#endif
+}
+
+
 bool
 gpu_attribute(string_view name, TypeDesc type, const void* val)
 {
@@ -231,6 +383,10 @@ gpu_attribute(string_view name, TypeDesc type, const void* val)
         ComputeDevice request = ComputeDevice(*(const int*)val);
         if (request == oiio_compute_device)
             return true;  // Already using the requested device
+        if (request == ComputeDevice::CPU) {
+            oiio_compute_device = request;
+            return true;
+        }
         if (request == ComputeDevice::CUDA) {
             if (enable_cuda()) {
                 oiio_compute_device = request;
@@ -0,0 +1,82 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+/// \file
+/// Private declarations of the ImageBufAlgo operations that can run on a
+/// compute device. This is also included by the CUDA kernels, which are
+/// compiled by nvcc and so only see the parts not involving ImageBuf.
+
+
+#pragma once
+
+#include <cstddef>
+
+#include <OpenImageIO/oiioversion.h>
+
+#ifndef __CUDACC__
+#    include <OpenImageIO/imageio.h>
+#endif
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace pvt {
+
+/// Per-pixel operations of gpu_pixelmath().
+enum class GPUOp : int {
+    Add,   ///< R = A + B
+    Sub,   ///< R = A - B
+    Mul,   ///< R = A * B
+    Mad,   ///< R = A * B + C
+    Over,  ///< R = A + B * (1 - alpha of A)
+};
+
+
+#ifndef __CUDACC__
+
+/// Compute `op` of A, B, and C into R over the region `roi` on the active
+/// compute device, where B and C are each either an image or, if the image
+/// pointer is null, per-channel values. Only C of Mad is used, and B of
+/// Over must be an image.
+///
+/// All the images must be local, contiguous float buffers with the same
+/// number of channels, each containing the whole (2D) roi with all of its
+/// channels. Return false, having done nothing, if they aren't, or if the
+/// device is the CPU or fails, and the caller should compute it itself.
+/// Unless built with OIIO_CUDA_IBA_EXPERIMENTAL, this always returns false.
+bool
+gpu_pixelmath(GPUOp op, ImageBuf& R, const ImageBuf& A, const ImageBuf* B,
+              cspan<float> Bval, const ImageBuf* C, cspan<float> Cval,
+              ROI roi);
+
+/// Allocate and free the device memory of ImageBuf's DEVICEBUFFER storage.
+/// Unlike device_malloc(), this is always CUDA memory, and nullptr if CUDA
+/// isn't the active compute device or the build lacks the experimental
+/// OIIO_CUDA_IBA_EXPERIMENTAL option.
+void*
+gpu_malloc(size_t size);
+void
+gpu_free(void* mem);
+
+/// Copy `size` bytes between host and device memory.
+bool
+gpu_copy(void* dst, const void* src, size_t size, bool to_device);
+
+#endif
+
+
+/// Launch the CUDA kernel computing `op` of the `nvalues` floats of the
+/// device buffers a, b, and c (or, for a null b or c, of the `nchannels`
+/// values bval or cval repeated) into r, on `stream`. `alpha` is the alpha
+/// channel of Over. Only defined if built with CUDA and the experimental
+/// OIIO_CUDA_IBA_EXPERIMENTAL build option.
+bool
+cuda_pixelmath(GPUOp op, float* r, const float* a, const float* b,
+               const float* c, const float* bval, const float* cval,
+               size_t nvalues, int nchannels, int alpha, void* stream);
+
+}  // namespace pvt
+
+OIIO_NAMESPACE_END
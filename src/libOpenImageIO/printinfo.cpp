@@ -339,8 +339,28 @@ print_stats(std::ostream& out, string_view indent, const ImageBuf& input,
     if (input.deep()) {
         print_deep_stats(out, indent, input, spec);
     } else {
-        std::vector<float> constantValues(input.spec().nchannels);
-        if (isConstantColor(input, 0.0f, constantValues)) {
+        // The statistics of the whole image already tell whether it is
+        // constant, and if it is, whether it is monochrome, saving more
+        // passes over the pixels -- provided that its values are all finite,
+        // and that converting them to float can't make different values
+        // the same.
+        TypeDesc format = input.spec().format;
+        int nchannels   = input.spec().nchannels;
+        bool known      = !roi.defined() || roi == input.roi();
+        known &= format.size() <= 2 || format == TypeFloat;
+        bool varies = false, nonfinite = false;
+        for (int c = 0; c < nchannels && known; ++c) {
+            varies |= stats.finitecount[c] && stats.min[c] != stats.max[c];
+            nonfinite |= stats.nancount[c] || stats.infcount[c]
+                         || !stats.finitecount[c];
+        }
+        known &= varies || !nonfinite;
+        std::vector<float> constantValues(nchannels);
+        bool constant = known ? !varies
+                              : isConstantColor(input, 0.0f, constantValues);
+        if (constant && known)
+            constantValues = stats.min;
+        if (constant) {
             print(out, "{}Constant: Yes\n", indent);
             print(out, "{}Constant Color: ", indent);
             for (unsigned int i = 0; i < constantValues.size(); ++i) {
@@ -351,7 +371,15 @@ print_stats(std::ostream& out, string_view indent, const ImageBuf& input,
             print(out, "{}Constant: No\n", indent);
         }
 
-        if (isMonochrome(input)) {
+        bool monochrome;
+        if (constant && known)
+            monochrome = std::all_of(constantValues.begin(),
+                                     constantValues.end(), [&](float v) {
+                                         return v == constantValues[0];
+                                     });
+        else
+            monochrome = isMonochrome(input);
+        if (monochrome) {
             print(out, "{}Monochrome: Yes\n", indent);
         } else {
             print(out, "{}Monochrome: No\n", indent);
@@ -0,0 +1,254 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/strutil.h>
+
+#include "imageio_pvt.h"
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace {  // anonymous
+
+// The index file starts with this line. Then each entry is a line
+//     namelen mtime size subimage miplevel speclen
+// followed by the file name, the spec (ImageSpec::to_binary()), and a
+// newline.
+static const char* index_magic = "OpenImageIO spec index 2\n";
+
+struct IndexEntry {
+    std::string filename;
+    int subimage;
+    int miplevel;
+    std::time_t mtime;
+    uint64_t size;
+    std::string spec;  // ImageSpec::to_binary()
+};
+
+}  // namespace
+
+
+
+class ImageSpecIndex::Impl {
+public:
+    Impl(string_view indexfile, bool headeronly)
+        : m_indexfile(indexfile)
+        , m_headeronly(headeronly)
+    {
+        if (m_indexfile.size())
+            load();
+    }
+
+    bool get(string_view filename, ImageSpec& spec, int subimage,
+             int miplevel);
+    bool save();
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.size();
+    }
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dirty |= !m_entries.empty();
+        m_entries.clear();
+    }
+
+private:
+    std::string m_indexfile;
+    bool m_headeronly;
+    bool m_dirty = false;
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, IndexEntry> m_entries;
+
+    static std::string key(string_view filename, int subimage, int miplevel)
+    {
+        return Strutil::fmt::format("{}|{}|{}", filename, subimage, miplevel);
+    }
+    void load();
+};
+
+
+
+void
+ImageSpecIndex::Impl::load()
+{
+    std::string text(Filesystem::file_size(m_indexfile), '\0');
+    if (text.empty()
+        || Filesystem::read_bytes(m_indexfile, &text[0], text.size())
+               != text.size()
+        || !Strutil::starts_with(text, index_magic))
+        return;  // Not there yet, or not an index: start afresh
+    string_view rest(text);
+    rest.remove_prefix(strlen(index_magic));
+    while (rest.size()) {
+        // An entry that doesn't parse ends the index, keeping the ones
+        // before it.
+        size_t eol = rest.find('\n');
+        if (eol == string_view::npos)
+            break;
+        auto fields = Strutil::splitsv(rest.substr(0, eol), " ");
+        rest.remove_prefix(eol + 1);
+        if (fields.size() != 6)
+            break;
+        IndexEntry e;
+        size_t namelen = Strutil::from_string<uint64_t>(fields[0]);
+        size_t speclen = Strutil::from_string<uint64_t>(fields[5]);
+        e.mtime    = std::time_t(Strutil::from_string<int64_t>(fields[1]));
+        e.size     = Strutil::from_string<uint64_t>(fields[2]);
+        e.subimage = Strutil::stoi(fields[3]);
+        e.miplevel = Strutil::stoi(fields[4]);
+        if (namelen > rest.size() || speclen + 1 > rest.size() - namelen)
+            break;
+        e.filename = rest.substr(0, namelen);
+        e.spec     = rest.substr(namelen, speclen);
+        rest.remove_prefix(namelen + speclen + 1);
+        std::string k = key(e.filename, e.subimage, e.miplevel);
+        m_entries[k]  = std::move(e);
+    }
+}
+
+
+
+bool
+ImageSpecIndex::Impl::get(string_view filename, ImageSpec& spec, int subimage,
+                          int miplevel)
+{
+    std::time_t mtime = Filesystem::last_write_time(filename);
+    uint64_t size     = Filesystem::file_size(filename);
+    std::string k     = key(filename, subimage, miplevel);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_entries.find(k);
+        if (found != m_entries.end() && found->second.mtime == mtime
+            && found->second.size == size
+            && spec.from_binary(found->second.spec))
+            return true;
+    }
+
+    // Not indexed, or the file has changed since: read it (without holding
+    // the lock, so other threads may read other files meanwhile).
+    ImageSpec config;
+    if (m_headeronly)
+        config.attribute("oiio:headeronly", 1);
+    auto in = ImageInput::open(filename, &config);
+    if (!in)
+        return false;  // error already set by open()
+    ImageSpec newspec = in->spec(subimage, miplevel);
+    if (in->has_error()) {
+        errorfmt("{}", in->geterror());
+        return false;
+    }
+    if (newspec.undefined()) {
+        errorfmt("\"{}\" has no subimage {} MIP level {}", filename, subimage,
+                 miplevel);
+        return false;
+    }
+    in.reset();
+
+    IndexEntry e;
+    e.filename = filename;
+    e.subimage = subimage;
+    e.miplevel = miplevel;
+    e.mtime    = mtime;
+    e.size     = size;
+    e.spec     = newspec.to_binary();
+    spec       = std::move(newspec);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries[k] = std::move(e);
+    m_dirty      = true;
+    return true;
+}
+
+
+
+bool
+ImageSpecIndex::Impl::save()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_dirty || m_indexfile.empty())
+        return true;
+    std::string text(index_magic);
+    for (const auto& ke : m_entries) {
+        const IndexEntry& e(ke.second);
+        text += Strutil::fmt::format("{} {} {} {} {} {}\n", e.filename.size(),
+                                     int64_t(e.mtime), e.size, e.subimage,
+                                     e.miplevel, e.spec.size());
+        text += e.filename;
+        text += e.spec;
+        text += '\n';
+    }
+    // Write a new file and then replace the old one with it, so that a
+    // crash or another process never sees half an index.
+    std::string tmpname = m_indexfile + "." + Filesystem::unique_path();
+    std::string err;
+    if (!Filesystem::write_binary_file(tmpname,
+                                       cspan<char>(text.data(), text.size()))
+        || !Filesystem::rename(tmpname, m_indexfile, err)) {
+        Filesystem::remove(tmpname, err);
+        errorfmt("Could not write spec index \"{}\"", m_indexfile);
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
+
+
+
+ImageSpecIndex::ImageSpecIndex(string_view indexfile, bool headeronly)
+    : m_impl(new Impl(indexfile, headeronly))
+{
+}
+
+
+
+ImageSpecIndex::~ImageSpecIndex()
+{
+    m_impl->save();
+}
+
+
+
+bool
+ImageSpecIndex::get(string_view filename, ImageSpec& spec, int subimage,
+                    int miplevel)
+{
+    return m_impl->get(filename, spec, subimage, miplevel);
+}
+
+
+
+bool
+ImageSpecIndex::save()
+{
+    return m_impl->save();
+}
+
+
+
+size_t
+ImageSpecIndex::size() const
+{
+    return m_impl->size();
+}
+
+
+
+void
+ImageSpecIndex::clear()
+{
+    m_impl->clear();
+}
+
+OIIO_NAMESPACE_END
@@ -18,6 +18,7 @@
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/texture.h>
 #include <OpenImageIO/thread.h>
+#include <OpenImageIO/tracing.h>
 #include <OpenImageIO/typedesc.h>
 #include <OpenImageIO/ustring.h>
 
@@ -299,6 +300,7 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
                                int nchannels, float* result, float* dresultds,
                                float* dresultdt)
 {
+    OIIO_TRACE_SPAN("TS::environment");
     // Handle >4 channel lookups by recursion.
     if (nchannels > 4) {
         int save_firstchannel = options.firstchannel;
@@ -321,6 +323,14 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
         return true;
     }
 
+    if (OIIO_UNLIKELY(m_recorder)) {
+        float coords[9] = { _R.x,    _R.y,    _R.z,    _dRdx.x, _dRdx.y,
+                            _dRdx.z, _dRdy.x, _dRdy.y, _dRdy.z };
+        m_recorder->record((TextureFile*)texture_handle_,
+                           LookupRecord::Environment, options, nchannels,
+                           dresultds != nullptr, coords);
+    }
+
     PerThreadInfo* thread_info = m_imagecache->get_perthread_info(
         (PerThreadInfo*)thread_info_);
     TextureFile* texturefile = verify_texturefile((TextureFile*)texture_handle_,
@@ -364,6 +374,33 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
     int actualchannels = OIIO::clamp(spec.nchannels - options.firstchannel, 0,
                                      nchannels);
 
+    // Calculate unit-length vectors in the direction of R, R+dRdx, R+dRdy.
+    // These define the ellipse we're filtering over.
+    Imath::V3f R = _R.cast<Imath::V3f>();
+    R.normalize();  // center
+    Imath::V3f Rx = _R.cast<Imath::V3f>() + _dRdx.cast<Imath::V3f>();
+    Rx.normalize();  // x axis of the ellipse
+    Imath::V3f Ry = _R.cast<Imath::V3f>() + _dRdy.cast<Imath::V3f>();
+    Ry.normalize();  // y axis of the ellipse
+    return environment_lookup(*texturefile, thread_info, options, nchannels,
+                              actualchannels, R, Rx, Ry, result, dresultds,
+                              dresultdt);
+}
+
+
+
+bool
+TextureSystemImpl::environment_lookup(TextureFile& texturefile,
+                                      PerThreadInfo* thread_info,
+                                      TextureOpt& options, int nchannels,
+                                      int actualchannels, const Imath::V3f& R,
+                                      const Imath::V3f& Rx,
+                                      const Imath::V3f& Ry, float* result,
+                                      float* dresultds, float* dresultdt)
+{
+    ImageCacheStatistics& stats(thread_info->m_stats);
+    const ImageSpec& spec(texturefile.spec(options.subimage, 0));
+
     // Initialize results to 0.  We'll add from here on as we sample.
     for (int c = 0; c < nchannels; ++c)
         result[c] = 0;
@@ -379,14 +416,6 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
     if (!(dresultds && dresultdt))
         dresultds = dresultdt = NULL;
 
-    // Calculate unit-length vectors in the direction of R, R+dRdx, R+dRdy.
-    // These define the ellipse we're filtering over.
-    Imath::V3f R = _R.cast<Imath::V3f>();
-    R.normalize();  // center
-    Imath::V3f Rx = _R.cast<Imath::V3f>() + _dRdx.cast<Imath::V3f>();
-    Rx.normalize();  // x axis of the ellipse
-    Imath::V3f Ry = _R.cast<Imath::V3f>() + _dRdy.cast<Imath::V3f>();
-    Ry.normalize();  // y axis of the ellipse
     // angles formed by the ellipse axes.
     float xfilt_noblur = std::max(safe_acos(R.dot(Rx)), 1e-8f);
     float yfilt_noblur = std::max(safe_acos(R.dot(Ry)), 1e-8f);
@@ -436,7 +465,8 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
 
     TextureOpt::MipMode mipmode = options.mipmode;
     bool aniso                  = (mipmode == TextureOpt::MipModeDefault
-                  || mipmode == TextureOpt::MipModeAniso);
+                  || mipmode == TextureOpt::MipModeAniso
+                  || mipmode == TextureOpt::MipModeEWA);
 
     float aspect, trueaspect, filtwidth;
     int nsamples;
@@ -456,7 +486,7 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
     }
 
     ImageCacheFile::SubimageInfo& subinfo(
-        texturefile->subimageinfo(options.subimage));
+        texturefile.subimageinfo(options.subimage));
     int min_mip_level = subinfo.min_mip_level;
 
     // FIXME -- assuming latlong
@@ -465,7 +495,7 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
     for (int sample = 0; sample < nsamples; ++sample, pos += invsamples) {
         Imath::V3f Rsamp = R + pos * Rmajor;
         float s, t;
-        vector_to_latlong(Rsamp, texturefile->m_y_up, s, t);
+        vector_to_latlong(Rsamp, texturefile.m_y_up, s, t);
 
         // Determine the MIP-map level(s) we need: we will blend
         //  data(miplevel[0]) * (1-levelblend) + data(miplevel[1]) * levelblend
@@ -524,7 +554,7 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
             int lev = miplevel[level];
             if (options.interpmode == TextureOpt::InterpSmartBicubic) {
                 if (lev == 0
-                    || (texturefile->spec(options.subimage, lev).full_height
+                    || (texturefile.spec(options.subimage, lev).full_height
                         < naturalres / 2)) {
                     sampler = &TextureSystemImpl::sample_bicubic;
                     ++stats.cubic_interps;
@@ -541,7 +571,7 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
             OIIO_SIMD4_ALIGN float weight[4]
                 = { levelweight[level] * invsamples, 0.0f, 0.0f, 0.0f };
             vfloat4 r, drds, drdt;
-            ok &= (this->*sampler)(1, sval, tval, miplevel[level], *texturefile,
+            ok &= (this->*sampler)(1, sval, tval, miplevel[level], texturefile,
                                    thread_info, options, nchannels,
                                    actualchannels, weight, &r,
                                    dresultds ? &drds : NULL,
@@ -568,15 +598,33 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
 
 
 
+// Normalize a batch of SOA 3-vectors in place. Zero-length vectors are
+// left unchanged, just like Imath's V3f::normalize().
+static inline void
+normalize_wide(Tex::FloatWide& x, Tex::FloatWide& y, Tex::FloatWide& z)
+{
+    Tex::FloatWide len = sqrt(x * x + y * y + z * z);
+    auto nonzero       = (len != Tex::FloatWide::Zero());
+    x                  = select(nonzero, x / len, x);
+    y                  = select(nonzero, y / len, y);
+    z                  = select(nonzero, z / len, z);
+}
+
+
+
 bool
-TextureSystemImpl::environment(TextureHandle* texture_handle,
-                               Perthread* thread_info, TextureOptBatch& options,
-                               Tex::RunMask mask, const float* R,
-                               const float* dRdx, const float* dRdy,
-                               int nchannels, float* result, float* dresultds,
-                               float* dresultdt)
+TextureSystemImpl::environment(TextureHandle* texture_handle_,
+                               Perthread* thread_info_,
+                               TextureOptBatch& options, Tex::RunMask mask,
+                               const float* R, const float* dRdx,
+                               const float* dRdy, int nchannels, float* result,
+                               float* dresultds, float* dresultdt)
 {
-    // (FIXME) CHEAT! Texture points individually
+    OIIO_TRACE_SPAN("TS::environment batch");
+    using Tex::BatchWidth;
+    using Tex::FloatWide;
+
+    // The non-varying options are shared by all lanes.
     TextureOpt opt;
     opt.firstchannel        = options.firstchannel;
     opt.subimage            = options.subimage;
@@ -590,40 +638,145 @@ TextureSystemImpl::environment(TextureHandle* texture_handle,
     opt.fill                = options.fill;
     opt.missingcolor        = options.missingcolor;
 
-    bool ok          = true;
-    Tex::RunMask bit = 1;
-    float* r         = OIIO_ALLOCA(float, 3 * nchannels * Tex::BatchWidth);
-    float* drds      = r + nchannels * Tex::BatchWidth;
-    float* drdt      = r + 2 * nchannels * Tex::BatchWidth;
-    for (int i = 0; i < Tex::BatchWidth; ++i, bit <<= 1) {
-        if (mask & bit) {
-            opt.sblur  = options.sblur[i];
-            opt.tblur  = options.tblur[i];
-            opt.swidth = options.swidth[i];
-            opt.twidth = options.twidth[i];
-            opt.rnd    = options.rnd[i];
-            Imath::V3f R_(R[i], R[i + Tex::BatchWidth],
-                          R[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dRdx_(dRdx[i], dRdx[i + Tex::BatchWidth],
-                             dRdx[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dRdy_(dRdy[i], dRdy[i + Tex::BatchWidth],
-                             dRdy[i + 2 * Tex::BatchWidth]);
+    mask &= Tex::RunMaskOn;
+    if (!mask)
+        return true;
+
+    if (OIIO_UNLIKELY(m_recorder)) {
+        // Record each lane as the lookup of one direction that it amounts
+        // to. The inputs are laid out as [3][BatchWidth].
+        TextureOpt lane  = opt;
+        Tex::RunMask bit = 1;
+        for (int i = 0; i < BatchWidth; ++i, bit <<= 1) {
+            if (!(mask & bit))
+                continue;
+            lane.sblur      = options.sblur[i];
+            lane.tblur      = options.tblur[i];
+            lane.swidth     = options.swidth[i];
+            lane.twidth     = options.twidth[i];
+            lane.rnd        = options.rnd[i];
+            float coords[9] = { R[i],
+                                R[i + BatchWidth],
+                                R[i + 2 * BatchWidth],
+                                dRdx[i],
+                                dRdx[i + BatchWidth],
+                                dRdx[i + 2 * BatchWidth],
+                                dRdy[i],
+                                dRdy[i + BatchWidth],
+                                dRdy[i + 2 * BatchWidth] };
+            m_recorder->record((TextureFile*)texture_handle_,
+                               LookupRecord::Environment, lane, nchannels,
+                               dresultds != nullptr, coords);
+        }
+    }
+
+    // Verify the file and resolve the subimage and wrap modes once for the
+    // whole batch rather than once per point.
+    PerThreadInfo* thread_info = m_imagecache->get_perthread_info(
+        (PerThreadInfo*)thread_info_);
+    TextureFile* texturefile = verify_texturefile((TextureFile*)texture_handle_,
+                                                  thread_info);
+    ImageCacheStatistics& stats(thread_info->m_stats);
+    ++stats.environment_batches;
+
+    auto scatter = [&](int lane, int firstc, int n, const float* r,
+                       const float* drds, const float* drdt) {
+        for (int c = 0; c < n; ++c) {
+            result[(firstc + c) * BatchWidth + lane] = r[c];
             if (dresultds) {
-                ok &= environment(texture_handle, thread_info, opt, R_, dRdx_,
-                                  dRdy_, nchannels, r, drds, drdt);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i]    = r[c];
-                    dresultds[c * Tex::BatchWidth + i] = drds[c];
-                    dresultdt[c * Tex::BatchWidth + i] = drdt[c];
-                }
-            } else {
-                ok &= environment(texture_handle, thread_info, opt, R_, dRdx_,
-                                  dRdy_, nchannels, r);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i] = r[c];
-                }
+                dresultds[(firstc + c) * BatchWidth + lane] = drds[c];
+                dresultdt[(firstc + c) * BatchWidth + lane] = drdt[c];
             }
         }
+    };
+    auto missing = [&]() {
+        float* r    = OIIO_ALLOCA(float, 3 * nchannels);
+        float* drds = r + nchannels;
+        float* drdt = drds + nchannels;
+        bool ok     = missing_texture(opt, nchannels, r, drds, drdt);
+
+        Tex::RunMask bit = 1;
+        for (int i = 0; i < BatchWidth; ++i, bit <<= 1) {
+            if (mask & bit) {
+                ++stats.environment_queries;
+                scatter(i, 0, nchannels, r, drds, drdt);
+            }
+        }
+        return ok;
+    };
+
+    if (!texturefile || texturefile->broken())
+        return missing();
+
+    if (!opt.subimagename.empty()) {
+        // If subimage was specified by name, figure out its index.
+        int si = m_imagecache->subimage_from_name(texturefile,
+                                                  opt.subimagename);
+        if (si < 0) {
+            error("Unknown subimage \"{}\" in texture \"{}\"",
+                  opt.subimagename, texturefile->filename());
+            return missing();
+        }
+        opt.subimage = si;
+        opt.subimagename.clear();
+    }
+    if (opt.subimage < 0 || opt.subimage >= texturefile->subimages()) {
+        error("Unknown subimage \"{}\" in texture \"{}\"", opt.subimagename,
+              texturefile->filename());
+        return missing();
+    }
+    const ImageSpec& spec(texturefile->spec(opt.subimage, 0));
+
+    // Environment maps dictate particular wrap modes
+    opt.swrap     = texturefile->m_sample_border
+                        ? TextureOpt::WrapPeriodicSharedBorder
+                        : TextureOpt::WrapPeriodic;
+    opt.twrap     = TextureOpt::WrapClamp;
+    opt.envlayout = LayoutLatLong;
+
+    // Compute the unit-length vectors in the direction of R, R+dRdx, and
+    // R+dRdy for all lanes at once. The inputs are already laid out as
+    // [3][BatchWidth].
+    FloatWide Rx(R), Ry(R + BatchWidth), Rz(R + 2 * BatchWidth);
+    FloatWide Xx = Rx + FloatWide(dRdx);
+    FloatWide Xy = Ry + FloatWide(dRdx + BatchWidth);
+    FloatWide Xz = Rz + FloatWide(dRdx + 2 * BatchWidth);
+    FloatWide Yx = Rx + FloatWide(dRdy);
+    FloatWide Yy = Ry + FloatWide(dRdy + BatchWidth);
+    FloatWide Yz = Rz + FloatWide(dRdy + 2 * BatchWidth);
+    normalize_wide(Rx, Ry, Rz);
+    normalize_wide(Xx, Xy, Xz);
+    normalize_wide(Yx, Yy, Yz);
+
+    // Only the direction setup above is wide. Each active lane is still
+    // converted to st and filtered by the scalar environment_lookup().
+    bool ok          = true;
+    Tex::RunMask bit = 1;
+    int firstchannel = opt.firstchannel;
+    for (int i = 0; i < BatchWidth; ++i, bit <<= 1) {
+        if (!(mask & bit))
+            continue;
+        ++stats.environment_queries;
+        opt.sblur  = options.sblur[i];
+        opt.tblur  = options.tblur[i];
+        opt.swidth = options.swidth[i];
+        opt.twidth = options.twidth[i];
+        opt.rnd    = options.rnd[i];
+        Imath::V3f Rn(Rx[i], Ry[i], Rz[i]);
+        Imath::V3f Rxn(Xx[i], Xy[i], Xz[i]);
+        Imath::V3f Ryn(Yx[i], Yy[i], Yz[i]);
+        for (int c0 = 0; c0 < nchannels; c0 += 4) {
+            int n              = std::min(nchannels - c0, 4);
+            opt.firstchannel   = firstchannel + c0;
+            int actualchannels = OIIO::clamp(spec.nchannels - opt.firstchannel,
+                                             0, n);
+            float r[4], drds[4], drdt[4];
+            ok &= environment_lookup(*texturefile, thread_info, opt, n,
+                                     actualchannels, Rn, Rxn, Ryn, r,
+                                     dresultds ? drds : nullptr,
+                                     dresultds ? drdt : nullptr);
+            scatter(i, c0, n, r, drds, drdt);
+        }
     }
     return ok;
 }
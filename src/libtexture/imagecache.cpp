@@ -3,6 +3,7 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <climits>
 #include <cstring>
 #include <memory>
 #include <regex>
@@ -10,6 +11,10 @@
 #include <string>
 #include <vector>
 
+#ifdef __linux__
+#    include <sched.h>
+#endif
+
 #include <OpenImageIO/Imath.h>
 
 #include <OpenImageIO/color.h>
@@ -20,13 +25,16 @@
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/metrics.h>
 #include <OpenImageIO/optparser.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/simd.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
 #include <OpenImageIO/texture.h>
 #include <OpenImageIO/thread.h>
 #include <OpenImageIO/timer.h>
+#include <OpenImageIO/tracing.h>
 #include <OpenImageIO/typedesc.h>
 #include <OpenImageIO/ustring.h>
 
@@ -69,6 +77,70 @@ static std::atomic_int64_t imagecache_next_id = 0;
 static thread_local tsl::robin_map<uint64_t, ImageCachePerThreadInfo*>
     imagecache_per_thread_infos;
 
+// Most adjacent tiles that add_tiles_to_cache will read from a file at once.
+static const int max_tile_run = 8;
+
+
+// The NUMA node of each logical CPU, as listed in /sys on Linux. Empty if
+// unknown, in which case everything is treated as being on node 0.
+static const std::vector<int>&
+numa_cpu_nodes()
+{
+    static const std::vector<int> cpu_nodes = []() {
+        std::vector<int> nodes;
+#ifdef __linux__
+        for (int n = 0; n < ImageCacheImpl::max_numa_nodes; ++n) {
+            std::string path
+                = Strutil::fmt::format("/sys/devices/system/node/node{}/cpulist",
+                                       n);
+            std::string cpulist;
+            if (!Filesystem::read_text_file(path, cpulist))
+                continue;
+            // A list of ranges, like "0-63,128-191"
+            for (string_view range : Strutil::splitsv(Strutil::strip(cpulist),
+                                                      ",")) {
+                int first = -1, last = -1;
+                if (!Strutil::parse_int(range, first))
+                    continue;
+                last = Strutil::parse_char(range, '-')
+                               && Strutil::parse_int(range, last)
+                           ? last
+                           : first;
+                for (int cpu = first; cpu >= 0 && cpu <= last; ++cpu) {
+                    if (cpu >= int(nodes.size()))
+                        nodes.resize(cpu + 1, 0);
+                    nodes[cpu] = n;
+                }
+            }
+        }
+#endif
+        return nodes;
+    }();
+    return cpu_nodes;
+}
+
+
+static int
+numa_node_count()
+{
+    const std::vector<int>& nodes(numa_cpu_nodes());
+    return nodes.empty() ? 1 : 1 + *std::max_element(nodes.begin(), nodes.end());
+}
+
+
+// The NUMA node of the CPU that the calling thread is running on.
+static int
+current_numa_node()
+{
+#ifdef __linux__
+    const std::vector<int>& nodes(numa_cpu_nodes());
+    int cpu = sched_getcpu();
+    if (cpu >= 0 && cpu < int(nodes.size()))
+        return nodes[cpu];
+#endif
+    return 0;
+}
+
 
 // Functor to compare filenames
 static bool
@@ -127,6 +199,8 @@ ImageCacheStatistics::init()
     find_tile_calls             = 0;
     find_tile_microcache_misses = 0;
     find_tile_cache_misses      = 0;
+    microcache_set_hits         = 0;
+    microcache_set_misses       = 0;
     //    tiles_created = 0;
     //    tiles_current = 0;
     //    tiles_peak = 0;
@@ -136,13 +210,36 @@ ImageCacheStatistics::init()
     //    open_files_created = 0;
     //    open_files_current = 0;
     //    open_files_peak = 0;
-    unique_files      = 0;
-    fileio_time       = 0;
-    fileopen_time     = 0;
-    file_locking_time = 0;
-    tile_locking_time = 0;
-    find_file_time    = 0;
-    find_tile_time    = 0;
+    unique_files       = 0;
+    fileio_time        = 0;
+    fileopen_time      = 0;
+    file_locking_time  = 0;
+    tile_locking_time  = 0;
+    find_file_time     = 0;
+    find_tile_time     = 0;
+    tile_evictions     = 0;
+    tile_promotions    = 0;
+    tile_ghost_hits    = 0;
+    diskcache_hits     = 0;
+    diskcache_misses   = 0;
+    sharedcache_hits   = 0;
+    sharedcache_misses = 0;
+    tileserver_hits    = 0;
+    tileserver_misses  = 0;
+    tiles_prefetched   = 0;
+    coalesced_reads    = 0;
+    coalesced_tiles    = 0;
+    numa_copies        = 0;
+    tiles_mapped       = 0;
+    tiles_constant     = 0;
+    compressed_hits    = 0;
+    compressed_stores  = 0;
+    compress_time      = 0;
+    decompress_time    = 0;
+
+    tiles_colortransformed = 0;
+    colortransform_copies  = 0;
+    colortransform_time    = 0;
 
     // TextureSystem stats:
     texture_queries     = 0;
@@ -160,6 +257,7 @@ ImageCacheStatistics::init()
     closest_interps     = 0;
     bilinear_interps    = 0;
     cubic_interps       = 0;
+    approximate_lookups = 0;
     file_retry_success  = 0;
     tile_retry_success  = 0;
 }
@@ -189,6 +287,30 @@ ImageCacheStatistics::merge(const ImageCacheStatistics& s)
     tile_locking_time += s.tile_locking_time;
     find_file_time += s.find_file_time;
     find_tile_time += s.find_tile_time;
+    tile_evictions += s.tile_evictions;
+    tile_promotions += s.tile_promotions;
+    tile_ghost_hits += s.tile_ghost_hits;
+    diskcache_hits += s.diskcache_hits;
+    diskcache_misses += s.diskcache_misses;
+    sharedcache_hits += s.sharedcache_hits;
+    sharedcache_misses += s.sharedcache_misses;
+    tileserver_hits += s.tileserver_hits;
+    tileserver_misses += s.tileserver_misses;
+    tiles_prefetched += s.tiles_prefetched;
+    coalesced_reads += s.coalesced_reads;
+    coalesced_tiles += s.coalesced_tiles;
+    numa_copies += s.numa_copies;
+    tiles_mapped += s.tiles_mapped;
+    tiles_constant += s.tiles_constant;
+    microcache_set_hits += s.microcache_set_hits;
+    microcache_set_misses += s.microcache_set_misses;
+    compressed_hits += s.compressed_hits;
+    compressed_stores += s.compressed_stores;
+    compress_time += s.compress_time;
+    decompress_time += s.decompress_time;
+    tiles_colortransformed += s.tiles_colortransformed;
+    colortransform_copies += s.colortransform_copies;
+    colortransform_time += s.colortransform_time;
 
     // TextureSystem stats:
     texture_queries += s.texture_queries;
@@ -206,6 +328,7 @@ ImageCacheStatistics::merge(const ImageCacheStatistics& s)
     closest_interps += s.closest_interps;
     bilinear_interps += s.bilinear_interps;
     cubic_interps += s.cubic_interps;
+    approximate_lookups += s.approximate_lookups;
     file_retry_success += s.file_retry_success;
     tile_retry_success += s.tile_retry_success;
 }
@@ -242,6 +365,25 @@ ImageCacheFile::LevelInfo::LevelInfo(std::unique_ptr<ImageSpec> spec_,
     tiles_read   = new atomic_ll[sz];
     for (int i = 0; i < sz; i++)
         tiles_read[i] = 0;
+
+    // Tile statistics from maketx, if they are of this very level and it
+    // is tiled in the file just as we tile it.
+    string_view stats = nativespec.get_string_attribute("oiio:TileStats");
+    int w = 0, h = 0, nc = 0;
+    if (stats.size() && Strutil::parse_int(stats, w)
+        && Strutil::parse_char(stats, ',') && Strutil::parse_int(stats, h)
+        && Strutil::parse_char(stats, ',') && Strutil::parse_int(stats, nc)
+        && w == spec.width && h == spec.height && nc == spec.nchannels
+        && spec.depth <= 1 && spec.tile_width == nativespec.tile_width
+        && spec.tile_height == nativespec.tile_height) {
+        size_t n = size_t(nxtiles) * nytiles * nc * 3, i = 0;
+        tilestats.reset(new float[n]);
+        while (i < n && Strutil::parse_char(stats, ',')
+               && Strutil::parse_float(stats, tilestats[i]))
+            ++i;
+        if (i < n || stats.size())
+            tilestats.reset();
+    }
 }
 
 
@@ -262,6 +404,17 @@ ImageCacheFile::LevelInfo::LevelInfo(const LevelInfo& src)
         polecolor.reset(new float[2 * spec.nchannels]);
         std::copy_n(src.polecolor.get(), 2 * spec.nchannels, polecolor.get());
     }
+    if (src.tilestats) {
+        size_t n = size_t(nxtiles) * nytiles * spec.nchannels * 3;
+        tilestats.reset(new float[n]);
+        std::copy_n(src.tilestats.get(), n, tilestats.get());
+    }
+    emptytiles = src.emptytiles;
+    if (src.emptypixel) {
+        size_t n = spec.pixel_bytes();
+        emptypixel.reset(new char[n]);
+        std::copy_n(src.emptypixel.get(), n, emptypixel.get());
+    }
     int nwords = round_to_multiple(nxtiles * nytiles * nztiles, 64) / 64;
     tiles_read = new atomic_ll[nwords];
     for (int i = 0; i < nwords; ++i)
@@ -270,6 +423,116 @@ ImageCacheFile::LevelInfo::LevelInfo(const LevelInfo& src)
 
 
 
+ImageCacheFileProxy::ImageCacheFileProxy(ImageCacheImpl& imagecache,
+                                         string_view filename)
+    : IOProxy(filename, Read)
+    , m_imagecache(imagecache)
+{
+    m_file.reset(new Filesystem::IOFile(filename, Read));
+    if (!m_file->opened()) {
+        error(m_file->error());
+        m_file.reset();
+        m_mode = Closed;
+        return;
+    }
+    m_size        = m_file->size();
+    m_handle_open = true;
+    m_imagecache.incr_open_files();
+    m_imagecache.add_open_proxy(this);
+}
+
+
+
+ImageCacheFileProxy::~ImageCacheFileProxy()
+{
+    // Nobody else can be reading, so this closes the file if it's open.
+    m_imagecache.suspend_proxy(this);
+}
+
+
+
+bool
+ImageCacheFileProxy::suspend()
+{
+    std::unique_lock<std::shared_mutex> lock(m_file_mutex, std::try_to_lock);
+    if (!lock.owns_lock() || !m_file)
+        return false;
+    m_file.reset();
+    m_handle_open = false;
+    m_imagecache.decr_open_files();
+    return true;
+}
+
+
+
+bool
+ImageCacheFileProxy::lock_for_read(std::shared_lock<std::shared_mutex>& lock)
+{
+    m_last_use = m_imagecache.proxy_read_tick();
+    lock       = std::shared_lock<std::shared_mutex>(m_file_mutex);
+    while (!m_file) {
+        lock.unlock();
+        {
+            std::unique_lock<std::shared_mutex> reopen(m_file_mutex);
+            if (!m_file) {
+                std::unique_ptr<Filesystem::IOFile> file(
+                    new Filesystem::IOFile(m_filename, Read));
+                if (!file->opened()) {
+                    error(file->error());
+                    return false;
+                }
+                m_file        = std::move(file);
+                m_handle_open = true;
+                m_imagecache.incr_open_files();
+                m_imagecache.add_open_proxy(this);
+            }
+        }
+        lock.lock();
+    }
+    return true;
+}
+
+
+
+size_t
+ImageCacheFileProxy::read(void* buf, size_t size)
+{
+    size_t r = pread(buf, size, m_pos);
+    m_pos += int64_t(r);
+    return r;
+}
+
+
+
+size_t
+ImageCacheFileProxy::pread(void* buf, size_t size, int64_t offset)
+{
+    std::shared_lock<std::shared_mutex> lock;
+    return lock_for_read(lock) ? m_file->pread(buf, size, offset) : 0;
+}
+
+
+
+bool
+ImageCacheFileProxy::pread_many(span<ReadRequest> requests)
+{
+    std::shared_lock<std::shared_mutex> lock;
+    return lock_for_read(lock) && m_file->pread_many(requests);
+}
+
+
+
+// Is the format one whose ImageInputs read pixels from the file only as
+// they're asked for, and so are worth keeping open (through an
+// ImageCacheFileProxy) when their file handles are closed?
+static bool
+reads_on_demand(string_view format)
+{
+    return format == "openexr" || format == "tiff";
+}
+
+
+
 ImageCacheFile::ImageCacheFile(ImageCacheImpl& imagecache,
                                ImageCachePerThreadInfo* /*thread_info*/,
                                ustring filename, ImageInput::Creator creator,
@@ -304,7 +567,7 @@ ImageCacheFile::ImageCacheFile(ImageCacheImpl& imagecache,
     , m_configspec(config ? new ImageSpec(*config) : NULL)
 {
     m_filename_original = m_filename;
-    m_filename = imagecache.resolve_filename(m_filename_original.string());
+    resolve();
     // N.B. the file is not opened, the ImageInput is NULL.  This is
     // reflected by the fact that m_validspec is false.
 
@@ -323,6 +586,17 @@ ImageCacheFile::~ImageCacheFile() { close(); }
 
 
 
+void
+ImageCacheFile::resolve()
+{
+    m_source = ustring(
+        m_imagecache.resolve_filename(m_filename_original.string()));
+    ustring retiled = m_imagecache.retiled_filename(m_source);
+    m_filename      = retiled.empty() ? m_source : retiled;
+}
+
+
+
 void
 ImageCacheFile::reset(ImageInput::Creator creator, const ImageSpec* config)
 {
@@ -349,26 +623,46 @@ ImageCacheFile::get_imageinput(ImageCachePerThreadInfo* /*thread_info*/)
 
 
 
+std::shared_ptr<ImageCacheFileProxy>
+ImageCacheFile::get_ioproxy()
+{
+#if defined(__GLIBCXX__) && __GLIBCXX__ < 20160822
+    recursive_timed_lock_guard guard(m_input_mutex);
+    return m_ioproxy;
+#else
+    return std::atomic_load(&m_ioproxy);
+#endif
+}
+
+
+
 void
-ImageCacheFile::set_imageinput(std::shared_ptr<ImageInput> newval)
+ImageCacheFile::set_imageinput(std::shared_ptr<ImageInput> newval,
+                               std::shared_ptr<ImageCacheFileProxy> proxy)
 {
-    if (newval)
+    // An ImageInput reading through a proxy doesn't count as an open file,
+    // its proxy counts itself while it has the file open.
+    if (newval && !proxy)
         imagecache().incr_open_files();
 #if defined(__GLIBCXX__) && __GLIBCXX__ < 20160822
     // Older gcc libstdc++ does not properly support std::atomic
     // operations on std::shared_ptr, despite it being a C++11
     // feature. No choice but to lock.
     std::shared_ptr<ImageInput> oldval;
+    std::shared_ptr<ImageCacheFileProxy> oldproxy;
     {
         recursive_timed_lock_guard guard(m_input_mutex);
-        oldval  = m_input;
-        m_input = newval;
+        oldval    = m_input;
+        m_input   = newval;
+        oldproxy  = m_ioproxy;
+        m_ioproxy = proxy;
     }
 #else
     // True C++11: can atomically exchange a shared_ptr safely.
-    auto oldval = std::atomic_exchange(&m_input, newval);
+    auto oldval   = std::atomic_exchange(&m_input, newval);
+    auto oldproxy = std::atomic_exchange(&m_ioproxy, proxy);
 #endif
-    if (oldval)
+    if (oldval && !oldproxy)
         imagecache().decr_open_files();
 }
 
@@ -379,6 +673,7 @@ ImageCacheFile::SubimageInfo::init(ImageCacheFile& icfile,
                                    const ImageSpec& spec, bool forcefloat)
 {
     volume = (spec.depth > 1 || spec.full_depth > 1);
+    deep   = spec.deep;
     full_pixel_range
         = (spec.x == spec.full_x && spec.y == spec.full_y
            && spec.z == spec.full_z && spec.width == spec.full_width
@@ -462,8 +757,14 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
     std::shared_ptr<ImageInput> inp = get_imageinput(thread_info);
     if (m_broken)
         return {};
-    if (inp)
+    if (inp) {
+        // If its file handle was closed, the next read will reopen it, and
+        // that has to stay within the limit too.
+        auto proxy = get_ioproxy();
+        if (proxy && proxy->suspended())
+            imagecache().check_max_files(thread_info);
         return inp;
+    }
 
     // The file wasn't already opened and in a good state.
 
@@ -494,8 +795,9 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
     if (imagecache().unassociatedalpha())
         configspec.attribute("oiio:UnassociatedAlpha", 1);
 
+    std::unique_ptr<ImageInput> newinp;
     if (m_inputcreator)
-        inp.reset(m_inputcreator());
+        newinp.reset(m_inputcreator());
     else {
         // If we are trusting extensions and this isn't a special "REST-ful"
         // name construction, just open with the extension in order to skip
@@ -506,15 +808,35 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
             fmt = OIIO::Filesystem::extension(fmt, false);
         else
             fmt = m_filename.string();
-        inp = ImageInput::create(fmt, false, &configspec, nullptr,
-                                 m_imagecache.plugin_searchpath());
+        newinp = ImageInput::create(fmt, false, &configspec, nullptr,
+                                    m_imagecache.plugin_searchpath());
     }
-    if (!inp) {
+    if (!newinp) {
         mark_broken(OIIO::geterror());
         invalidate_spec();
         return {};
     }
 
+    // Formats that read tiles only as they're asked for read through a
+    // proxy, which can close the file handle to stay within max_open_files
+    // without the ImageInput having to be closed too, and then reread the
+    // header and tile offsets when the file is used again.
+    std::shared_ptr<ImageCacheFileProxy> proxy;
+    if (m_allow_release && reads_on_demand(newinp->format_name())
+        && newinp->supports("ioproxy") && !Filesystem::is_url(m_filename)) {
+        proxy = std::make_shared<ImageCacheFileProxy>(imagecache(),
+                                                      m_filename);
+        if (proxy->opened()) {
+            Filesystem::IOProxy* io = proxy.get();
+            configspec.attribute("oiio:ioproxy", TypeDesc::PTR, &io);
+        } else {
+            proxy.reset();  // Let the ImageInput fail to open it
+        }
+    }
+    // The ImageInput keeps the proxy it reads through alive.
+    inp = std::shared_ptr<ImageInput>(newinp.release(),
+                                      [proxy](ImageInput* in) { delete in; });
+
     ImageSpec nativespec, tempspec;
     mark_not_broken();
     bool ok = true;
@@ -544,7 +866,7 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
     // If we are simply re-opening a closed file, and the spec is still
     // valid, we're done, no need to reread the subimage and mip headers.
     if (validspec()) {
-        set_imageinput(inp);
+        set_imageinput(inp, proxy);
         return inp;
     }
 
@@ -559,6 +881,7 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
     imagesize_t old_total_imagesize        = m_total_imagesize;
     imagesize_t old_total_imagesize_ondisk = m_total_imagesize_ondisk;
     m_total_imagesize                      = 0;
+    m_deep                                 = false;
     do {
         m_subimages.resize(nsubimages + 1);
         SubimageInfo& si(subimageinfo(nsubimages));
@@ -571,6 +894,7 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
             if (nmip == 0) {
                 // Things to do on MIP level 0, i.e. once per subimage
                 si.init(*this, tempspec, imagecache().forcefloat());
+                m_deep |= si.deep;
             }
             if (tempspec.tile_width == 0 || tempspec.tile_height == 0) {
                 si.untiled   = true;
@@ -601,6 +925,12 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
                     tempspec.tile_height = tempspec.height;
                     tempspec.tile_depth  = tempspec.depth;
                 }
+                if (si.deep) {
+                    // Deep scanlines can only be read whole, one plane at
+                    // a time.
+                    tempspec.tile_width = tempspec.width;
+                    tempspec.tile_depth = 1;
+                }
                 tmpspecmodified = true;
             }
             // If a request was made for a maximum MIP resolution to use for
@@ -631,6 +961,30 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
             } else {
                 LevelInfo levelinfo(nativespec);
                 si.levels.push_back(levelinfo);
+                // A sparse file may tell us which of its tiles are empty,
+                // so that they needn't be read (or for 3D textures, even
+                // looked up). Their values are those of the file, so skip
+                // it if reading would associate the alpha.
+                LevelInfo& lev(si.levels.back());
+                std::unique_ptr<char[]> bg(new char[nativespec.pixel_bytes()]);
+                if (nativespec.channelformats.empty()
+                    && !nativespec.get_int_attribute("oiio:UnassociatedAlpha")
+                    && inp->empty_tiles(nsubimages, nmip, lev.emptytiles,
+                                        bg.get())) {
+                    size_t nwords = (size_t(lev.nxtiles) * lev.nytiles
+                                         * lev.nztiles
+                                     + 63)
+                                    / 64;
+                    if (lev.onetile || lev.emptytiles.size() < nwords) {
+                        lev.emptytiles.clear();  // Not how we tile it
+                    } else {
+                        lev.emptypixel.reset(new char[tempspec.nchannels
+                                                      * si.datatype.size()]);
+                        convert_pixel_values(nativespec.format, bg.get(),
+                                             si.datatype, lev.emptypixel.get(),
+                                             tempspec.nchannels);
+                    }
+                }
             }
             ++nmip;
         } while (inp->seek_subimage(nsubimages, nmip));
@@ -639,11 +993,12 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
         // is on, it's a non-mipmapped image, and it doesn't have a
         // "textureformat" attribute (because that would indicate somebody
         // constructed it as texture and specifically wants it un-mipmapped).
-        // But not volume textures -- don't auto MIP them for now.
+        // But not volume textures -- don't auto MIP them for now. Nor deep
+        // images, which there's no way to resize.
         if (nmip == 1 && !si.volume
             && (tempspec.width > 1 || tempspec.height > 1 || tempspec.depth > 1))
             si.unmipped = true;
-        if (si.unmipped && imagecache().automip()
+        if (si.unmipped && !si.deep && imagecache().automip()
             && !tempspec.find_attribute("textureformat", TypeString)) {
             int w = tempspec.full_width;
             int h = tempspec.full_height;
@@ -712,7 +1067,8 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
     thread_info->m_stats.files_totalsize_ondisk += m_total_imagesize_ondisk;
 
     init_from_spec();  // Fill in the rest of the fields
-    set_imageinput(inp);
+    set_imageinput(inp, proxy);
+    m_imagecache.request_retile(this);
     return inp;
 }
 
@@ -789,8 +1145,11 @@ ImageCacheFile::init_from_spec()
     // Squash some problematic texture metadata if we suspect it's wrong
     pvt::check_texture_metadata_sanity(spec);
 
-    // See if there's a SHA-1 hash in the image description
+    // See if there's a SHA-1 hash in the image description, or else the
+    // faster content hash that maketx may store instead.
     string_view fing = spec.get_string_attribute("oiio:SHA-1");
+    if (fing.empty())
+        fing = spec.get_string_attribute("oiio:ContentHash");
     if (fing.length())
         m_fingerprint = ustring(fing);
 
@@ -810,32 +1169,38 @@ ImageCacheFile::init_from_spec()
 
 
 bool
-ImageCacheFile::read_tile(ImageCachePerThreadInfo* thread_info,
-                          const TileID& id, void* data)
+ImageCacheFile::read_tiles(ImageCachePerThreadInfo* thread_info,
+                           const TileID& id, int ntiles, void* data)
 {
+    OIIO_TRACE_SPAN("IC::read_tiles", m_filename);
     OIIO_DASSERT(id.chend() > id.chbegin());
+    OIIO_DASSERT(ntiles >= 1);
 
     // Mark if we ever use a mip level that's not the first
     int miplevel = id.miplevel();
     if (miplevel > 0)
         m_mipused = true;
     // count how many times this mipmap level was read
-    m_mipreadcount[miplevel]++;
+    m_mipreadcount[miplevel] += ntiles;
 
     int subimage = id.subimage();
     SubimageInfo& subinfo(subimageinfo(subimage));
 
     // Special case for un-MIP-mapped
-    if (subinfo.unmipped && miplevel != 0)
+    if (subinfo.unmipped && miplevel != 0) {
+        OIIO_DASSERT(ntiles == 1);
         return read_unmipped(thread_info, id, data);
+    }
 
     std::shared_ptr<ImageInput> inp = open(thread_info);
     if (!inp)
         return false;
 
     // Special case for untiled images -- need to do tile emulation
-    if (subinfo.untiled)
+    if (subinfo.untiled) {
+        OIIO_DASSERT(ntiles == 1);
         return read_untiled(thread_info, inp.get(), id, data);
+    }
 
     // Ordinary tiled
     int x           = id.x();
@@ -848,7 +1213,8 @@ ImageCacheFile::read_tile(ImageCachePerThreadInfo* thread_info,
     bool ok = true;
     const ImageSpec& spec(this->spec(subimage, miplevel));
     for (int tries = 0; tries <= imagecache().failure_retries(); ++tries) {
-        ok = inp->read_tiles(subimage, miplevel, x, x + spec.tile_width, y,
+        ok = inp->read_tiles(subimage, miplevel, x,
+                             x + ntiles * spec.tile_width, y,
                              y + spec.tile_height, z, z + spec.tile_depth,
                              chbegin, chend, format, data);
         if (ok) {
@@ -873,34 +1239,172 @@ ImageCacheFile::read_tile(ImageCachePerThreadInfo* thread_info,
     }
 
     if (ok) {
-        size_t b = spec.tile_bytes();
+        size_t b = spec.tile_bytes() * ntiles;
         thread_info->m_stats.bytes_read += b;
         m_bytesread += b;
-        ++m_tilesread;
-        if (id.colortransformid() > 0) {
-            // print("CONVERT id {} {},{} to cs {}\n", filename(), id.x(), id.y(),
-            //       id.colortransformid());
-            ImageSpec tilespec(spec.tile_width, spec.tile_height,
-                               spec.nchannels, format);
-            ImageBuf wrapper(tilespec, make_cspan((const std::byte*)data,
-                                                  tilespec.image_bytes()));
-            ImageBufAlgo::colorconvert(
-                wrapper, wrapper,
-                ColorConfig::default_colorconfig().getColorSpaceNameByIndex(
-                    (id.colortransformid() >> 16) - 1),
-                m_imagecache.colorspace(), true, string_view(), string_view(),
-                nullptr, ROI(), 1);
+        m_tilesread += ntiles;
+        ok = colortransform(thread_info, id, ntiles, ntiles * spec.tile_width,
+                            spec.tile_height, std::max(1, spec.tile_depth),
+                            data);
+    }
+    return ok;
+}
+
+
+
+bool
+ImageCacheFile::read_deep_tile(ImageCachePerThreadInfo* thread_info,
+                               const TileID& id, DeepData& deepdata)
+{
+    OIIO_TRACE_SPAN("IC::read_deep_tile", m_filename);
+    int subimage = id.subimage();
+    int miplevel = id.miplevel();
+    if (miplevel > 0)
+        m_mipused = true;
+    ++m_mipreadcount[miplevel];
+
+    std::shared_ptr<ImageInput> inp = open(thread_info);
+    if (!inp)
+        return false;
+
+    // Deep reads must stop at the edge of the image, not of the tile.
+    const ImageSpec& spec(this->spec(subimage, miplevel));
+    int xend = std::min(id.x() + spec.tile_width, spec.x + spec.width);
+    int yend = std::min(id.y() + spec.tile_height, spec.y + spec.height);
+    int zend = std::min(id.z() + spec.tile_depth,
+                        spec.z + std::max(1, spec.depth));
+    bool untiled = subimageinfo(subimage).untiled;
+    bool ok      = true;
+    for (int tries = 0; tries <= imagecache().failure_retries(); ++tries) {
+        ok = untiled ? inp->read_native_deep_scanlines(subimage, miplevel,
+                                                       id.y(), yend, id.z(),
+                                                       id.chbegin(),
+                                                       id.chend(), deepdata)
+                     : inp->read_native_deep_tiles(subimage, miplevel, id.x(),
+                                                   xend, id.y(), yend, id.z(),
+                                                   zend, id.chbegin(),
+                                                   id.chend(), deepdata);
+        if (ok) {
+            if (tries)  // succeeded, but only after a failure!
+                ++thread_info->m_stats.tile_retry_success;
+            (void)inp->geterror();  // Eat the errors
+            break;
         }
+        if (tries < imagecache().failure_retries())
+            Sysutil::usleep(1000 * 100);  // 100 ms
+    }
+    if (!ok) {
+        m_broken        = true;
+        std::string err = inp->geterror();
+        if (errors_should_issue())
+            imagecache().error("{}",
+                               err.size() ? err : std::string("unknown error"));
+        return false;
     }
+    size_t b = deepdata.all_data().size();
+    thread_info->m_stats.bytes_read += b;
+    m_bytesread += b;
+    ++m_tilesread;
+    return true;
+}
+
+
+
+bool
+ImageCacheFile::colortransform(ImageCachePerThreadInfo* thread_info,
+                               const TileID& id, int ntiles, int width,
+                               int height, int depth, void* data)
+{
+    int ctid = id.colortransformid();
+    if (ctid <= 0)
+        return true;
+    OIIO_TRACE_SPAN("IC::colortransform", m_filename);
+    Timer timer;
+    // The id holds the indices (plus 1) of the color spaces to convert from
+    // and to, in its upper and lower 16 bits.
+    const ColorConfig& cc(ColorConfig::default_colorconfig());
+    ImageSpec spec(width, height, id.nchannels(), datatype(id.subimage()));
+    spec.depth      = depth;
+    spec.full_depth = depth;
+    ImageBuf wrapper(spec, data);
+    bool ok = ImageBufAlgo::colorconvert(
+        wrapper, wrapper, cc.getColorSpaceNameByIndex((ctid >> 16) - 1),
+        cc.getColorSpaceNameByIndex((ctid & 0xffff) - 1), true, string_view(),
+        string_view(), nullptr, ROI(), 1);
+    if (!ok && errors_should_issue())
+        imagecache().error("{}", wrapper.geterror());
+    thread_info->m_stats.tiles_colortransformed += ntiles;
+    thread_info->m_stats.colortransform_time += timer();
     return ok;
 }
 
 
 
+const char*
+ImageCacheFile::mapped_tile(const TileID& id,
+                            std::shared_ptr<const MappedTileFile>& mapping)
+{
+    // Only tiles that the TIFF or OTX reader itself would hand over
+    // unchanged (which MappedTileFile checks further) can be used in place.
+    int subimage = id.subimage();
+    int miplevel = id.miplevel();
+    const SubimageInfo& subinfo(subimageinfo(subimage));
+    const ImageSpec& spec(this->spec(subimage, miplevel));
+    if ((m_fileformat != "tiff" && m_fileformat != "otx") || m_inputcreator
+        || m_configspec || subinfo.untiled
+        || (subinfo.unmipped && miplevel > 0)
+        || id.colortransformid() > 0 || id.chbegin() != 0
+        || id.chend() != spec.nchannels || spec.tile_depth != 1
+        || spec.channelformats.size())
+        return nullptr;
+
+    // The TIFF reader makes each directory a subimage, or a MIP level of
+    // the only subimage (and OTX levels are numbered to match).
+    int dir = miplevel;
+    for (int s = 0; s < subimage; ++s)
+        dir += subimageinfo(s).unmipped ? 1 : miplevels(s);
+
+    // Map the file the first time it's needed.
+    bool tried;
+    {
+        spin_lock lock(m_mapped_mutex);
+        mapping = m_mapped;
+        tried   = m_mapped_tried;
+    }
+    if (!tried) {
+        std::shared_ptr<const MappedTileFile> mapped = MappedTileFile::open(
+            m_filename.string());
+        spin_lock lock(m_mapped_mutex);
+        if (!m_mapped_tried) {
+            m_mapped       = mapped;
+            m_mapped_tried = true;
+        }
+        mapping = m_mapped;
+    }
+    if (!mapping)
+        return nullptr;
+
+    const LevelInfo& lev(levelinfo(subimage, miplevel));
+    int tile = (id.x() - spec.x) / spec.tile_width
+               + ((id.y() - spec.y) / spec.tile_height) * lev.nxtiles;
+    const char* pixels = mapping->tile(dir, spec, datatype(subimage),
+                                       imagecache().unassociatedalpha(), tile);
+    if (pixels) {
+        if (miplevel > 0)
+            m_mipused = true;
+        ++m_mipreadcount[miplevel];
+        ++m_tilesread;
+    }
+    return pixels;
+}
+
+
+
 bool
 ImageCacheFile::read_unmipped(ImageCachePerThreadInfo* thread_info,
                               const TileID& id, void* data)
 {
+    OIIO_TRACE_SPAN("IC::read_unmipped", m_filename);
     // We need a tile from an unmipmapped file, and it doesn't really
     // exist.  So generate it out of thin air by interpolating pixels
     // from the next higher-res level.  Of course, that may also not
@@ -988,10 +1492,12 @@ ImageCacheFile::read_unmipped(ImageCachePerThreadInfo* thread_info,
         }
     }
 
-    // Now convert and copy those values out to the caller's buffer
+    // Now convert and copy those values out to the caller's buffer. (The
+    // finer level was read without any color transform.)
     lores.get_pixels(ROI(0, tw, 0, th, 0, 1, 0, nchans), format,
                      make_span((std::byte*)data,
                                size_t(tw * th * nchans) * format.size()));
+    ok &= colortransform(thread_info, id, 1, tw, th, 1, data);
 
     // Restore the microcache to the way it was before.
     thread_info->tile     = oldtile;
@@ -1008,6 +1514,7 @@ bool
 ImageCacheFile::read_untiled(ImageCachePerThreadInfo* thread_info,
                              ImageInput* inp, const TileID& id, void* data)
 {
+    OIIO_TRACE_SPAN("IC::read_untiled", m_filename);
     int subimage         = id.subimage();
     int miplevel         = id.miplevel();
     int x                = id.x();
@@ -1062,6 +1569,11 @@ ImageCacheFile::read_untiled(ImageCachePerThreadInfo* thread_info,
         thread_info->m_stats.bytes_read += b;
         m_bytesread += b;
         ++m_tilesread;
+        // Transform the whole row of tiles at once.
+        int ntx = (spec.width + tw - 1) / tw;
+        if (ok)
+            ok = colortransform(thread_info, id, ntx, ntx * tw, y1 - y0 + 1, 1,
+                                &buf[0]);
 
         // For all tiles in the tile-row, enter them into the cache if not
         // already there.  Special case for the tile we're actually being
@@ -1099,6 +1611,9 @@ ImageCacheFile::read_untiled(ImageCachePerThreadInfo* thread_info,
             if (!err.empty() && errors_should_issue())
                 imagecache().error("{}", err);
         }
+        if (ok)
+            ok = colortransform(thread_info, id, 1, tw, th,
+                                std::max(1, spec.tile_depth), data);
         size_t b = spec.image_bytes();
         thread_info->m_stats.bytes_read += b;
         m_bytesread += b;
@@ -1141,10 +1656,16 @@ ImageCacheFile::release()
         // pressure on the cache, it'll get freed next time around.
         return;
     }
-    if (m_used)
+    if (m_used) {
         m_used = false;
-    else if (m_allow_release)
-        close();
+    } else if (m_allow_release) {
+        // A file read through a proxy just closes its file handle, keeping
+        // the ImageInput ready to read again.
+        if (auto proxy = get_ioproxy())
+            imagecache().suspend_proxy(proxy.get());
+        else
+            close();
+    }
     m_input_mutex.unlock();
 }
 
@@ -1161,8 +1682,14 @@ ImageCacheFile::invalidate()
     mark_not_broken();
     m_fingerprint.clear();
     duplicate(NULL);
+    {
+        // Tiles still using the old mapping keep it alive.
+        spin_lock lock(m_mapped_mutex);
+        m_mapped.reset();
+        m_mapped_tried = false;
+    }
 
-    m_filename = m_imagecache.resolve_filename(m_filename_original.string());
+    resolve();
 
     // Eat any errors that occurred in the open/close
     while (!imagecache().geterror().empty())
@@ -1249,6 +1776,7 @@ ImageCacheFile::heapsize() const
     size += pvt::heapsize(m_input);
     size += pvt::heapsize(m_mipreadcount);
     size += pvt::heapsize(m_udim_lookup);
+    size += pvt::heapsize(m_udim_index);
     return size;
 }
 
@@ -1265,9 +1793,18 @@ ImageCacheImpl::find_file(ustring filename,
     if (!m_substitute_image.empty())
         filename = m_substitute_image;
 
-    // Shortcut - check the per-thread microcache before grabbing a more
-    // expensive lock on the shared file cache.
-    ImageCacheFile* tf = replace ? nullptr : thread_info->find_file(filename);
+    // Shortcuts - check the recently found files and then the per-thread
+    // microcache before grabbing a more expensive lock on the shared file
+    // cache.
+    std::atomic<ImageCacheFile*>& recent(
+        m_recent_files[filename.hash() & (recent_file_slots - 1)]);
+    ImageCacheFile* tf = nullptr;
+    if (!replace) {
+        tf = recent.load(std::memory_order_acquire);
+        if (tf && tf->filename_original() == filename)
+            return tf;
+        tf = thread_info->find_file(filename);
+    }
 
     // Make sure the ImageCacheFile entry exists and is in the
     // file cache.  For this part, we need to lock the file cache.
@@ -1294,6 +1831,7 @@ ImageCacheImpl::find_file(ustring filename,
         }
 
         if (newfile) {
+            m_watcher.watch(filename, tf->source());
             // We don't need to check_max_files here, because open() already
             // does it, and we're only trying to limit the number of open
             // files, not the number of entries in the cache.
@@ -1306,6 +1844,7 @@ ImageCacheImpl::find_file(ustring filename,
         thread_info->m_stats.find_file_time += timer();
 #endif
     }
+    recent.store(tf, std::memory_order_release);
 
     // Ensure that it's open and do other important housekeeping.
     //    tf = verify_file (tf, thread_info, header_only);
@@ -1425,6 +1964,30 @@ ImageCacheImpl::clear_fingerprints()
 
 
 
+void
+ImageCacheImpl::add_open_proxy(ImageCacheFileProxy* proxy)
+{
+    std::lock_guard<std::mutex> lock(m_open_proxies_mutex);
+    m_open_proxies.push_back(proxy);
+}
+
+
+
+bool
+ImageCacheImpl::suspend_proxy(ImageCacheFileProxy* proxy)
+{
+    std::lock_guard<std::mutex> lock(m_open_proxies_mutex);
+    auto found = std::find(m_open_proxies.begin(), m_open_proxies.end(),
+                           proxy);
+    if (found == m_open_proxies.end() || !proxy->suspend())
+        return false;
+    *found = m_open_proxies.back();
+    m_open_proxies.pop_back();
+    return true;
+}
+
+
+
 void
 ImageCacheImpl::check_max_files(ImageCachePerThreadInfo* /*thread_info*/)
 {
@@ -1460,6 +2023,33 @@ ImageCacheImpl::check_max_files(ImageCachePerThreadInfo* /*thread_info*/)
         m_file_sweep_mutex.lock();
     }
 
+    // Files read through an ImageCacheFileProxy are the cheapest to
+    // close, since their ImageInputs stay open and only the file handles
+    // need reopening. So first close the handles that were least recently
+    // read, strictly in that order, and a few extra so that we needn't come
+    // back here for every file opened. Only then sweep over the rest.
+    {
+        std::lock_guard<std::mutex> lock(m_open_proxies_mutex);
+        int excess = m_stat_open_files_current - m_max_open_files
+                     + std::max(1, m_max_open_files / 16);
+        if (excess > 0 && m_open_proxies.size()) {
+            std::vector<std::pair<int64_t, ImageCacheFileProxy*>> lru;
+            lru.reserve(m_open_proxies.size());
+            for (auto p : m_open_proxies)
+                lru.emplace_back(p->last_use(), p);
+            std::sort(lru.begin(), lru.end());
+            for (size_t i = 0; i < lru.size() && excess > 0; ++i)
+                if (lru[i].second->suspend())
+                    --excess;
+            m_open_proxies.erase(std::remove_if(m_open_proxies.begin(),
+                                                m_open_proxies.end(),
+                                                [](ImageCacheFileProxy* p) {
+                                                    return p->suspended();
+                                                }),
+                                 m_open_proxies.end());
+        }
+    }
+
     // Now, what we want to do is have a "clock hand" that sweeps across
     // the cache, releasing files that haven't been used for a long
     // time.  Because of multi-thread, rather than keep an iterator
@@ -1565,7 +2155,7 @@ ImageCacheTile::ImageCacheTile(const TileID& id, const void* pels,
         m_pixels.reset((char*)pels);
         m_valid = true;
     }
-    id.file().imagecache().incr_tiles(m_pixels_size);
+    id.file().imagecache().incr_tiles(m_pixels_size, id.numa_node());
     m_pixels_ready = true;  // Caller sent us the pixels, no read necessary
     // FIXME -- for shadow, fill in mindepth, maxdepth
 }
@@ -1574,7 +2164,7 @@ ImageCacheTile::ImageCacheTile(const TileID& id, const void* pels,
 
 ImageCacheTile::~ImageCacheTile()
 {
-    m_id.file().imagecache().decr_tiles(memsize());
+    m_id.file().imagecache().decr_tiles(memsize(), m_id.numa_node());
     if (m_nofree)
         m_pixels.release();  // release without freeing
 }
@@ -1594,8 +2184,8 @@ ImageCacheTile::memsize_needed() const
 
 
 
-bool
-ImageCacheTile::read(ImageCachePerThreadInfo* thread_info)
+size_t
+ImageCacheTile::allocate_pixels()
 {
     ImageCacheFile& file(m_id.file());
     m_channelsize = file.datatype(id().subimage()).size();
@@ -1606,8 +2196,195 @@ ImageCacheTile::read(ImageCachePerThreadInfo* thread_info)
     // Clear the end pad values so there aren't NaNs sucked up by simd loads
     memset(m_pixels.get() + size - OIIO_SIMD_MAX_SIZE_BYTES, 0,
            OIIO_SIMD_MAX_SIZE_BYTES);
-    m_valid = file.read_tile(thread_info, m_id, &m_pixels[0]);
-    file.imagecache().incr_mem(size);
+    return size;
+}
+
+
+
+bool
+ImageCacheTile::map_pixels(ImageCachePerThreadInfo* thread_info)
+{
+    ImageCacheFile& file(m_id.file());
+    const char* pixels = file.mapped_tile(m_id, m_mapping);
+    if (!pixels) {
+        m_mapping.reset();
+        return false;
+    }
+    m_channelsize = file.datatype(m_id.subimage()).size();
+    m_pixelsize   = m_id.nchannels() * m_channelsize;
+    m_nofree      = true;  // The mapping owns them
+    m_pixels_size = 0;     // ...and they take no cache memory
+    m_pixels.reset(const_cast<char*>(pixels));
+    ++thread_info->m_stats.tiles_mapped;
+    return true;
+}
+
+
+
+bool
+ImageCacheTile::fill_constant(ImageCachePerThreadInfo* thread_info)
+{
+    ImageCacheFile& file(m_id.file());
+    const ImageCacheFile::LevelInfo& lev(
+        file.levelinfo(m_id.subimage(), m_id.miplevel()));
+    const float* stats = lev.tile_stats(m_id.x(), m_id.y());
+    const char* emptypel = lev.empty_tile_pixel(m_id.x(), m_id.y(), m_id.z());
+    // The statistics are of the values in the file, which a color
+    // transform or associating the alpha on reading would change.
+    if ((!stats && !emptypel) || m_id.colortransformid() > 0
+        || (lev.nativespec.get_int_attribute("oiio:UnassociatedAlpha")
+            && !file.imagecache().unassociatedalpha()))
+        return false;
+    const ImageSpec& spec(lev.spec());
+    int nc = spec.nchannels, chbegin = m_id.chbegin();
+    char* pixels = m_pixels.get();
+    if (emptypel) {
+        // The reader told us that this tile is empty
+        memcpy(pixels, emptypel + chbegin * m_channelsize, m_pixelsize);
+    } else {
+        for (int c = chbegin; c < m_id.chend(); ++c)
+            if (stats[c] != stats[nc + c])  // min != max
+                return false;
+        convert_pixel_values(TypeFloat, stats + chbegin,
+                             file.datatype(m_id.subimage()), pixels,
+                             m_id.nchannels());
+    }
+    size_t npixels = size_t(spec.tile_width) * spec.tile_height
+                     * spec.tile_depth;
+    for (size_t p = 1; p < npixels; ++p)
+        memcpy(pixels + p * m_pixelsize, pixels, m_pixelsize);
+    ++thread_info->m_stats.tiles_constant;
+    return true;
+}
+
+
+
+bool
+ImageCacheTile::read_deep(ImageCachePerThreadInfo* thread_info)
+{
+    m_deepdata.reset(new DeepData);
+    if (!m_id.file().read_deep_tile(thread_info, m_id, *m_deepdata))
+        return false;
+    // Count the samples, and each pixel's sample count, capacity, and
+    // offset of its samples, against the cache's memory limit.
+    m_pixels_size = m_deepdata->all_data().size()
+                    + size_t(m_deepdata->pixels())
+                          * (2 * sizeof(unsigned int) + sizeof(size_t));
+    return true;
+}
+
+
+
+bool
+ImageCacheTile::read(ImageCachePerThreadInfo* thread_info)
+{
+    ImageCacheFile& file(m_id.file());
+    // Deep tiles hold DeepData rather than pixels, so none of the ways of
+    // getting flat pixels below apply to them.
+    if (file.subimageinfo(m_id.subimage()).deep)
+        return finish_read(read_deep(thread_info));
+    // Tiles stored just as we'd hold them can be used straight from a
+    // memory mapping of the file.
+    if (file.imagecache().mmap_tiles() && map_pixels(thread_info))
+        return finish_read(true);
+    size_t size = allocate_pixels();
+    // Nor need a tile that maketx found to be constant be read at all.
+    if (fill_constant(thread_info))
+        return finish_read(true);
+    // A tile that was evicted not long ago may still be held compressed.
+    CompressedTileCache& compressed(file.imagecache().compressedtier());
+    if (compressed.enabled()) {
+        Timer timer;
+        bool hit = compressed.fetch(m_id, &m_pixels[0], size);
+        thread_info->m_stats.decompress_time += timer();
+        if (hit) {
+            ++thread_info->m_stats.compressed_hits;
+            return finish_read(true);
+        }
+    }
+    // Another process may already have read it into the shared tier.
+    SharedTileCache& shared(file.imagecache().sharedtier());
+    if (shared.enabled()) {
+        bool hit = shared.read(m_id, &m_pixels[0], size);
+        ++(hit ? thread_info->m_stats.sharedcache_hits
+               : thread_info->m_stats.sharedcache_misses);
+        if (hit)
+            return finish_read(true);
+    }
+    // Try the disk cache, if there is one, before reading and decoding the
+    // file itself; and put anything we did have to read into it.
+    DiskTileCache& diskcache(file.imagecache().diskcache());
+    bool fromdisk = false;
+    if (diskcache.enabled()) {
+        fromdisk = diskcache.read(m_id, &m_pixels[0], size);
+        ++(fromdisk ? thread_info->m_stats.diskcache_hits
+                    : thread_info->m_stats.diskcache_misses);
+    }
+    // Then ask the tile server, so that of all the render nodes wanting
+    // this tile, only the first reads it from the file; which gives it to
+    // the server for the rest.
+    RemoteTileCache& remote(file.imagecache().remotetier());
+    bool fromremote = false;
+    if (!fromdisk && remote.enabled()) {
+        fromremote = remote.read(m_id, &m_pixels[0], size);
+        ++(fromremote ? thread_info->m_stats.tileserver_hits
+                      : thread_info->m_stats.tileserver_misses);
+    }
+    bool fromfile = !fromdisk && !fromremote;
+    bool ok = !fromfile || file.read_tile(thread_info, m_id, &m_pixels[0]);
+    if (ok && fromfile && remote.enabled())
+        remote.write(m_id, &m_pixels[0], size);
+    if (ok && !fromdisk && diskcache.enabled())
+        diskcache.write(m_id, &m_pixels[0], size);
+    if (ok && shared.enabled())
+        shared.write(m_id, &m_pixels[0], size);
+    return finish_read(ok);
+}
+
+
+
+bool
+ImageCacheTile::read_run(ImageCachePerThreadInfo* thread_info,
+                         span<ImageCacheTileRef> tiles)
+{
+    OIIO_DASSERT(tiles.size() >= 1);
+    const TileID& first(tiles[0]->id());
+    ImageCacheFile& file(first.file());
+    const ImageSpec& spec(file.spec(first.subimage(), first.miplevel()));
+    int ntiles = int(tiles.size());
+    for (int i = 0; i < ntiles; ++i) {
+        OIIO_DASSERT(tiles[i]->id().x() == first.x() + i * spec.tile_width);
+        tiles[i]->allocate_pixels();
+    }
+
+    // The file hands back the run as one image ntiles tiles wide, so each
+    // row of each tile has to be copied out into its own tile.
+    size_t rowbytes = size_t(spec.tile_width) * tiles[0]->pixelsize();
+    size_t nrows    = size_t(spec.tile_height) * spec.tile_depth;
+    std::unique_ptr<char[]> buf(new char[rowbytes * nrows * ntiles]);
+    bool readok = file.read_tiles(thread_info, first, ntiles, buf.get());
+    if (readok) {
+        for (int i = 0; i < ntiles; ++i) {
+            char* pixels = tiles[i]->m_pixels.get();
+            for (size_t r = 0; r < nrows; ++r)
+                memcpy(pixels + r * rowbytes,
+                       buf.get() + (r * ntiles + i) * rowbytes, rowbytes);
+        }
+    }
+    bool ok = true;
+    for (auto& tile : tiles)
+        ok &= tile->finish_read(readok);
+    return ok;
+}
+
+
+
+bool
+ImageCacheTile::finish_read(bool ok)
+{
+    ImageCacheFile& file(m_id.file());
+    file.imagecache().incr_mem(m_pixels_size, m_id.numa_node());
+    m_valid = ok;
     if (m_valid) {
         ImageCacheFile::LevelInfo& lev(
             file.levelinfo(m_id.subimage(), m_id.miplevel()));
@@ -1681,10 +2458,320 @@ ImageCacheTile::data(int x, int y, int z, int c) const
 
 
 
-ImageCacheImpl::ImageCacheImpl()
+LockFreeTileCache::~LockFreeTileCache()
 {
-    imagecache_id = imagecache_next_id.fetch_add(1);
+    // No readers remain by now, so drop the tables' references directly.
+    for (Shard& shard : m_shards) {
+        if (Table* t = shard.table.load(std::memory_order_relaxed)) {
+            for (size_t i = 0; i <= t->mask; ++i) {
+                ImageCacheTile* p = t->slots[i].tile.load(
+                    std::memory_order_relaxed);
+                if (live(p))
+                    intrusive_ptr_release(p);
+            }
+            delete t;
+        }
+    }
+}
+
+
+
+void
+LockFreeTileCache::add_reader(Reader* reader)
+{
+    spin_lock lock(m_retire_mutex);
+    m_readers.push_back(reader);
+}
+
+
+
+void
+LockFreeTileCache::remove_reader(Reader* reader)
+{
+    spin_lock lock(m_retire_mutex);
+    auto found = std::find(m_readers.begin(), m_readers.end(), reader);
+    if (found != m_readers.end())
+        m_readers.erase(found);
+}
+
+
+
+int64_t
+LockFreeTileCache::find_index(const Table* t, const TileID& id, size_t hash)
+{
+    for (size_t i = probe_start(t, hash), n = 0; n <= t->mask;
+         i = (i + 1) & t->mask, ++n) {
+        ImageCacheTile* p = t->slots[i].tile.load(std::memory_order_relaxed);
+        if (!p)
+            break;
+        if (p != tombstone()
+            && t->slots[i].hash.load(std::memory_order_relaxed) == hash
+            && p->id() == id)
+            return int64_t(i);
+    }
+    return -1;
+}
+
+
+
+bool
+LockFreeTileCache::contains(const TileID& id) const
+{
+    size_t hash        = id.hash();
+    const Shard& shard = m_shards[hash % TILE_CACHE_SHARDS];
+    spin_lock lock(shard.mutex);
+    const Table* t = shard.table.load(std::memory_order_relaxed);
+    return t && find_index(t, id, hash) >= 0;
+}
+
+
+
+LockFreeTileCache::Table*
+LockFreeTileCache::grow(Shard& shard)
+{
+    // Size the new table to be at most half full, which also throws away
+    // any tombstones that have accumulated in the old one.
+    Table* old      = shard.table.load(std::memory_order_relaxed);
+    size_t capacity = 16;
+    while (capacity < 2 * (shard.live + 1))
+        capacity *= 2;
+    Table* t = new Table(capacity);
+    if (old) {
+        for (size_t i = 0; i <= old->mask; ++i) {
+            ImageCacheTile* p = old->slots[i].tile.load(
+                std::memory_order_relaxed);
+            if (!live(p))
+                continue;
+            size_t hash = old->slots[i].hash.load(std::memory_order_relaxed);
+            size_t j    = probe_start(t, hash);
+            while (t->slots[j].tile.load(std::memory_order_relaxed))
+                j = (j + 1) & t->mask;
+            t->slots[j].hash.store(hash, std::memory_order_relaxed);
+            t->slots[j].tile.store(p, std::memory_order_relaxed);
+        }
+    }
+    // The tiles' references move to the new table along with them.
+    shard.table.store(t, std::memory_order_release);
+    shard.used = shard.live;
+    if (old)
+        retire(std::unique_ptr<Table>(old));
+    return t;
+}
+
+
+
+bool
+LockFreeTileCache::insert_retrieve(ImageCacheTileRef& tile)
+{
+    const TileID& id(tile->id());
+    size_t hash  = id.hash();
+    Shard& shard = m_shards[hash % TILE_CACHE_SHARDS];
+    bool grew    = false;
+    {
+        spin_lock lock(shard.mutex);
+        Table* t = shard.table.load(std::memory_order_relaxed);
+        // Keep the table no more than 3/4 full, counting tombstones, so
+        // that probes stay short and always end at an empty slot.
+        if (!t || 4 * (shard.used + 1) > 3 * (t->mask + 1)) {
+            t    = grow(shard);
+            grew = true;
+        }
+        size_t insert_at = t->mask + 1;
+        for (size_t i = probe_start(t, hash);; i = (i + 1) & t->mask) {
+            ImageCacheTile* p = t->slots[i].tile.load(
+                std::memory_order_relaxed);
+            if (p == nullptr || p == tombstone()) {
+                if (insert_at > t->mask)
+                    insert_at = i;
+                if (p == nullptr)
+                    break;
+            } else if (t->slots[i].hash.load(std::memory_order_relaxed) == hash
+                       && p->id() == id) {
+                tile = p;  // Somebody beat us to it
+                return false;
+            }
+        }
+        Slot& slot(t->slots[insert_at]);
+        if (!slot.tile.load(std::memory_order_relaxed))
+            ++shard.used;  // not reusing a tombstone
+        ++shard.live;
+        ++m_size;
+        intrusive_ptr_add_ref(tile.get());
+        slot.hash.store(hash, std::memory_order_relaxed);
+        slot.tile.store(tile.get(), std::memory_order_release);
+    }
+    if (grew)
+        reclaim();
+    return true;
+}
+
+
+
+void
+LockFreeTileCache::erase_slot(Shard& shard, Table* t, size_t i)
+{
+    ImageCacheTile* p = t->slots[i].tile.load(std::memory_order_relaxed);
+    t->slots[i].tile.store(tombstone(), std::memory_order_release);
+    --shard.live;
+    --m_size;
+    // Take over the reference that the slot held, and hand it to the
+    // retire list, since a lookup in flight may still be using it.
+    ImageCacheTileRef ref(p);
+    intrusive_ptr_release(p);
+    retire(std::move(ref));
+}
+
+
+
+bool
+LockFreeTileCache::erase(const TileID& id)
+{
+    size_t hash  = id.hash();
+    Shard& shard = m_shards[hash % TILE_CACHE_SHARDS];
+    {
+        spin_lock lock(shard.mutex);
+        Table* t = shard.table.load(std::memory_order_relaxed);
+        int64_t i = t ? find_index(t, id, hash) : -1;
+        if (i < 0)
+            return false;
+        erase_slot(shard, t, size_t(i));
+    }
+    reclaim();
+    return true;
+}
+
+
+
+void
+LockFreeTileCache::clear()
+{
+    for (Shard& shard : m_shards) {
+        spin_lock lock(shard.mutex);
+        Table* t = shard.table.load(std::memory_order_relaxed);
+        if (!t)
+            continue;
+        for (size_t i = 0; i <= t->mask; ++i)
+            if (live(t->slots[i].tile.load(std::memory_order_relaxed)))
+                erase_slot(shard, t, i);
+        shard.table.store(nullptr, std::memory_order_release);
+        shard.used = 0;
+        retire(std::unique_ptr<Table>(t));
+    }
+    reclaim();
+}
+
+
+
+bool
+LockFreeTileCache::sweep(SweepPos& pos,
+                         function_view<bool(ImageCacheTile*)> evict)
+{
+    for (; pos.shard < TILE_CACHE_SHARDS; ++pos.shard, pos.slot = 0) {
+        Shard& shard = m_shards[pos.shard];
+        bool found   = false;
+        bool erased  = false;
+        {
+            spin_lock lock(shard.mutex);
+            Table* t = shard.table.load(std::memory_order_relaxed);
+            while (t && pos.slot <= t->mask && !found) {
+                size_t i          = pos.slot++;
+                ImageCacheTile* p = t->slots[i].tile.load(
+                    std::memory_order_relaxed);
+                if (live(p)) {
+                    found = true;
+                    if (evict(p)) {
+                        erase_slot(shard, t, i);
+                        erased = true;
+                    }
+                }
+            }
+        }
+        if (erased)
+            reclaim();
+        if (found)
+            return true;
+    }
+    pos = SweepPos();
+    return false;
+}
+
+
+
+void
+LockFreeTileCache::retire(ImageCacheTileRef&& tile)
+{
+    // Order the unlinking before reclaim() reads the readers' epochs, to
+    // pair with the fence in retrieve().
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    spin_lock lock(m_retire_mutex);
+    m_retired_tiles.emplace_back(m_epoch.fetch_add(1), std::move(tile));
+}
+
+
+
+void
+LockFreeTileCache::retire(std::unique_ptr<Table>&& table)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    spin_lock lock(m_retire_mutex);
+    m_retired_tables.emplace_back(m_epoch.fetch_add(1), std::move(table));
+}
+
+
+
+// Move the items retired before `epoch` from `retired` to `out`.
+template<class T>
+static void
+take_retired_before(std::vector<std::pair<uint64_t, T>>& retired,
+                    uint64_t epoch, std::vector<T>& out)
+{
+    auto stale = std::partition(retired.begin(), retired.end(),
+                                [=](const std::pair<uint64_t, T>& r) {
+                                    return r.first >= epoch;
+                                });
+    for (auto r = stale; r != retired.end(); ++r)
+        out.push_back(std::move(r->second));
+    retired.erase(stale, retired.end());
+}
+
+
+
+void
+LockFreeTileCache::reclaim()
+{
+    std::vector<ImageCacheTileRef> tiles;
+    std::vector<std::unique_ptr<Table>> tables;
+    {
+        spin_lock lock(m_retire_mutex);
+        if (m_retired_tiles.empty() && m_retired_tables.empty())
+            return;
+        // Nothing retired before the oldest epoch that a reader is still
+        // announcing can be reached by any lookup.
+        uint64_t oldest = m_epoch.load();
+        for (const Reader* r : m_readers) {
+            uint64_t e = r->epoch.load(std::memory_order_acquire);
+            if (e && e < oldest)
+                oldest = e;
+        }
+        take_retired_before(m_retired_tiles, oldest, tiles);
+        take_retired_before(m_retired_tables, oldest, tables);
+    }
+    // The tiles and tables are freed here, after releasing the lock.
+}
+
+
+
+ImageCacheImpl::ImageCacheImpl()
+{
+    imagecache_id = imagecache_next_id.fetch_add(1);
     init();
+    pvt::memory_budget_add_cache(this, [this](long long bytes) {
+        release_memory(bytes);
+    });
+    m_metrics_source = Metrics::add_source(
+        [this](std::vector<Metrics::Sample>& samples) {
+            report_metrics(samples);
+        });
 }
 
 
@@ -1708,6 +2795,7 @@ ImageCacheImpl::init()
 {
     set_max_open_files(100);
     m_max_memory_bytes     = 1024LL * 1024 * 1024;  // 1 GB default cache size
+    m_numa_nodes           = numa_node_count();
     m_autotile             = 0;
     m_autoscanline         = false;
     m_automip              = false;
@@ -1730,6 +2818,7 @@ ImageCacheImpl::init()
     m_stat_open_files_current = 0;
     m_stat_open_files_peak    = 0;
     m_max_open_files_strict   = false;
+    m_eviction_policy = TileEvictionPolicy::create("clock", m_max_memory_bytes);
 
     // Allow environment variable to override default options
     const char* options = getenv("OPENIMAGEIO_IMAGECACHE_OPTIONS");
@@ -1741,11 +2830,24 @@ ImageCacheImpl::init()
 
 ImageCacheImpl::~ImageCacheImpl()
 {
+    Metrics::remove_source(m_metrics_source);
+    pvt::memory_budget_remove_cache(this);
+    // Finish any prefetches still queued before taking anything apart.
+    while (m_prefetches_pending) {
+        thread_pool* pool = m_prefetch_pool ? m_prefetch_pool.get()
+                                            : io_thread_pool();
+        if (!pool->run_one_task(std::this_thread::get_id()))
+            std::this_thread::yield();
+    }
+    m_prefetch_pool.reset();
     printstats();
     // All the per_thread_infos get destroyed here, regardless of if they were created implicitly
     // or manually by the caller
     {
         spin_lock lock(m_perthread_info_mutex);
+        for (auto& p : m_all_perthread_info)
+            if (p)
+                m_tilecache_lf.remove_reader(&p->m_tilecache_reader);
         m_all_perthread_info.clear();
     }
     // Erase any leftover errors from this thread
@@ -1768,6 +2870,141 @@ ImageCacheImpl::mergestats(ImageCacheStatistics& stats) const
 
 
 
+void
+ImageCacheImpl::report_metrics(std::vector<Metrics::Sample>& samples) const
+{
+    ImageCacheStatistics stats;
+    mergestats(stats);
+    std::string labels = Metrics::label("cache",
+                                        Strutil::to_string(imagecache_id));
+    auto sample = [&](const char* name, const char* help, double value,
+                      bool counter) {
+        samples.push_back({ name, help, labels, value, counter });
+    };
+    sample("oiio_imagecache_find_tile_calls_total",
+           "Tiles looked up in the ImageCache", double(stats.find_tile_calls),
+           true);
+    sample("oiio_imagecache_microcache_misses_total",
+           "Tile lookups not found in the thread's microcache",
+           double(stats.find_tile_microcache_misses), true);
+    sample("oiio_imagecache_cache_misses_total",
+           "Tile lookups not found in the ImageCache, and read",
+           double(stats.find_tile_cache_misses), true);
+    sample("oiio_imagecache_fileio_seconds_total",
+           "Time spent reading tiles from files", stats.fileio_time, true);
+    sample("oiio_imagecache_tile_evictions_total",
+           "Tiles freed to make room for others",
+           double(stats.tile_evictions), true);
+    sample("oiio_imagecache_tiles", "Tiles held in the ImageCache",
+           double(m_stat_tiles_current), false);
+    sample("oiio_imagecache_memory_bytes",
+           "Memory used by the tiles held in the ImageCache",
+           double(m_mem_used), false);
+    sample("oiio_imagecache_open_files", "Files held open by the ImageCache",
+           double(m_stat_open_files_current), false);
+    sample("oiio_texture_queries_total", "Texture lookups",
+           double(stats.texture_queries + stats.texture3d_queries
+                  + stats.shadow_queries + stats.environment_queries),
+           true);
+}
+
+
+
+// With metrics being collected, record a read of tiles of the file: its
+// duration, and its bytes, counted for each file format.
+static void
+record_tile_read_metrics(const ImageCacheFile& file, double seconds,
+                         size_t bytes)
+{
+    static Metrics::Histogram& latency(
+        Metrics::histogram("oiio_imagecache_tile_read_seconds",
+                           "Time to read tiles into the ImageCache"));
+    latency.record(seconds);
+    thread_local ustring format;
+    thread_local Metrics::Counter* bytes_read = nullptr;
+    if (!bytes_read || file.fileformat() != format) {
+        format     = file.fileformat();
+        bytes_read = &Metrics::counter("oiio_imagecache_bytes_read_total",
+                                       "Bytes of tiles read by the "
+                                       "ImageCache, by file format",
+                                       Metrics::label("format", format));
+    }
+    bytes_read->add(int64_t(bytes));
+}
+
+
+
+std::vector<std::pair<const ImageCacheFile*, FileLookupStats>>
+ImageCacheImpl::merge_file_stats() const
+{
+    ImageCachePerThreadInfo::FileStatsMap merged;
+    {
+        spin_lock lock(m_perthread_info_mutex);
+        for (auto& p : m_all_perthread_info) {
+            if (!p)
+                continue;
+            spin_lock filelock(p->m_file_stats_mutex);
+            for (auto& f : p->m_file_stats)
+                merged[f.first].merge(f.second);
+        }
+    }
+    std::vector<std::pair<const ImageCacheFile*, FileLookupStats>> files(
+        merged.begin(), merged.end());
+    std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) {
+        return a.second.lookups > b.second.lookups;
+    });
+    return files;
+}
+
+
+
+std::vector<TextureSystem::TileFeedback>
+ImageCacheImpl::merge_tile_feedback(bool clear) const
+{
+    std::map<ImageCachePerThreadInfo::TileFeedbackKey, std::vector<uint64_t>>
+        merged;
+    {
+        spin_lock lock(m_perthread_info_mutex);
+        for (auto& p : m_all_perthread_info) {
+            if (!p)
+                continue;
+            spin_lock feedbacklock(p->m_tile_feedback_mutex);
+            for (auto& f : p->m_tile_feedback) {
+                const TileFeedbackBits& bits(f.second);
+                std::vector<uint64_t>& m(merged[f.first]);
+                size_t nwords = (bits.ntiles + 63) / 64;
+                m.resize(std::max(m.size(), nwords), 0);
+                for (size_t i = 0; i < nwords; ++i)
+                    m[i] |= clear ? bits.words[i].exchange(0)
+                                  : bits.words[i].load();
+            }
+        }
+    }
+    std::vector<TextureSystem::TileFeedback> feedback;
+    for (auto& f : merged) {
+        // Leave out levels not touched since the last merge.
+        if (std::all_of(f.second.begin(), f.second.end(),
+                        [](uint64_t w) { return w == 0; }))
+            continue;
+        const ImageCacheFile* file = std::get<0>(f.first);
+        int subimage = std::get<1>(f.first), miplevel = std::get<2>(f.first);
+        const ImageCacheFile::LevelInfo& levelinfo(
+            file->levelinfo(subimage, miplevel));
+        TextureSystem::TileFeedback level;
+        level.filename = file->filename();
+        level.subimage = subimage;
+        level.miplevel = miplevel;
+        level.nxtiles  = levelinfo.nxtiles;
+        level.nytiles  = levelinfo.nytiles;
+        level.nztiles  = levelinfo.nztiles;
+        level.tiles    = std::move(f.second);
+        feedback.push_back(std::move(level));
+    }
+    return feedback;
+}
+
+
+
 std::string
 ImageCacheImpl::onefile_stat_line(const ImageCacheFileRef& file, int i,
                                   bool includestats) const
@@ -1872,6 +3109,8 @@ ImageCacheImpl::getstats(int level) const
     size_t total_constant              = 0;
     double total_iotime                = 0;
     double total_input_mutex_wait_time = 0;
+    size_t total_udims = 0, total_udim_tiles = 0, total_udim_manifests = 0;
+    double total_udim_setup_time = 0;
     std::vector<ImageCacheFileRef> files;
     {
         for (FilenameMap::iterator f = m_files.begin(); f != m_files.end();
@@ -1885,6 +3124,12 @@ ImageCacheImpl::getstats(int level) const
             total_bytes += file->bytesread();
             total_iotime += file->iotime();
             total_input_mutex_wait_time += file->m_mutex_wait_time;
+            if (file->is_udim()) {
+                ++total_udims;
+                total_udim_tiles += file->m_udim_lookup.size();
+                total_udim_manifests += file->m_udim_from_manifest;
+                total_udim_setup_time += file->m_udim_setup_time;
+            }
             if (file->duplicate()) {
                 ++total_duplicates;
                 continue;
@@ -1996,6 +3241,15 @@ ImageCacheImpl::getstats(int level) const
                       stats.find_tile_microcache_misses,
                       100.0 * stats.find_tile_microcache_misses
                           / (double)stats.find_tile_calls);
+            if (stats.microcache_set_hits || stats.microcache_set_misses)
+                print(out,
+                      "    set-associative micro-cache ({} tiles) : {} hits "
+                      "({:.1f}%), {} misses\n",
+                      m_microcache_size, stats.microcache_set_hits,
+                      100.0 * stats.microcache_set_hits
+                          / double(stats.microcache_set_hits
+                                   + stats.microcache_set_misses),
+                      stats.microcache_set_misses);
             if (stats.find_tile_cache_misses)
                 print(out, "    main cache misses : {} ({:.1f}%)\n",
                       stats.find_tile_cache_misses,
@@ -2004,6 +3258,64 @@ ImageCacheImpl::getstats(int level) const
             print(out, "    redundant reads: {} tiles, {}\n",
                   total_redundant_tiles,
                   Strutil::memformat(total_redundant_bytes));
+            if (stats.tiles_prefetched || level > 2)
+                print(out, "    prefetched tiles : {}\n",
+                      stats.tiles_prefetched);
+            if (stats.coalesced_reads || level > 2)
+                print(out, "    coalesced reads : {} ({} tiles)\n",
+                      stats.coalesced_reads, stats.coalesced_tiles);
+            if (m_mmap_tiles || level > 2)
+                print(out, "    memory-mapped tiles : {}\n",
+                      stats.tiles_mapped);
+            if (stats.tiles_constant || level > 2)
+                print(out, "    constant tiles (not read) : {}\n",
+                      stats.tiles_constant);
+            if (m_numa_tiles || level > 2) {
+                print(out, "    NUMA tiles : {} nodes, {} copied between nodes\n",
+                      m_numa_nodes, stats.numa_copies);
+                for (int n = 0; n < m_numa_nodes; ++n)
+                    print(out, "      node {} : {}\n", n,
+                          Strutil::memformat(m_numa_mem_used[n]));
+            }
+            if (m_compressedtier.enabled() || level > 2) {
+                print(out,
+                      "    compressed tier : {} hits, {} stored, {} tiles "
+                      "held in {} (max {})\n",
+                      stats.compressed_hits, stats.compressed_stores,
+                      m_compressedtier.size(),
+                      Strutil::memformat(m_compressedtier.bytes()),
+                      Strutil::memformat(m_compressedtier.max_bytes()));
+                print(out, "    compression time : {}, decompression {}\n",
+                      Strutil::timeintervalformat(stats.compress_time),
+                      Strutil::timeintervalformat(stats.decompress_time));
+            }
+            if (stats.tiles_colortransformed || level > 2)
+                print(out,
+                      "    color transformed tiles : {} ({} from cached "
+                      "tiles), {}\n",
+                      stats.tiles_colortransformed, stats.colortransform_copies,
+                      Strutil::timeintervalformat(stats.colortransform_time));
+            if (m_diskcache.enabled() || level > 2)
+                print(out, "    disk cache : {} hits, {} misses ({})\n",
+                      stats.diskcache_hits, stats.diskcache_misses,
+                      m_diskcache.directory());
+            if (m_retile.enabled() || level > 2)
+                print(out, "    retiled copies : {} made ({})\n",
+                      m_retile.made(), m_retile.directory());
+            if (m_sharedtier.enabled() || level > 2)
+                print(out, "    shared tier : {} hits, {} misses ({})\n",
+                      stats.sharedcache_hits, stats.sharedcache_misses,
+                      m_sharedtier.name());
+            if (m_remotetier.enabled() || level > 2)
+                print(out, "    tile servers : {} hits, {} misses ({})\n",
+                      stats.tileserver_hits, stats.tileserver_misses,
+                      m_remotetier.servers());
+            if (stats.tile_evictions || level > 2)
+                print(out,
+                      "    eviction policy {} : {} evicted, {} promoted, "
+                      "{} missed after eviction\n",
+                      m_eviction_policy->name(), stats.tile_evictions,
+                      stats.tile_promotions, stats.tile_ghost_hits);
         }
         print(out, "    Peak cache memory : {}\n",
               Strutil::memformat(m_mem_used));
@@ -2044,6 +3356,37 @@ ImageCacheImpl::getstats(int level) const
               Strutil::timeintervalformat(total_iotime));
     }
 
+    if (level >= 2 && m_per_file_stats) {
+        // The files most looked up, and how: many probes per lookup point
+        // to anisotropy, lookups mostly of MIP level 0 or magnified to too
+        // little resolution, and find tile time to cache thrashing.
+        auto filestats = merge_file_stats();
+        size_t maxfiles = level > 2 ? filestats.size() : 25;
+        print(out, "  Texture lookups by file:\n");
+        print(out, "      lookups probes/lookup magnified   sampling "
+                   "find tile  MIP levels  File\n");
+        for (size_t i = 0; i < filestats.size() && i < maxfiles; ++i) {
+            const FileLookupStats& fs(filestats[i].second);
+            int nlevels = FileLookupStats::max_miplevels;
+            while (nlevels > 1 && !fs.miplevels[nlevels - 1])
+                --nlevels;
+            std::string mips;
+            for (int m = 0; m < nlevels; ++m)
+                mips += Strutil::fmt::format("{}{}", m ? "," : "",
+                                             fs.miplevels[m]);
+            double lookups = std::max(1.0, double(fs.lookups));
+            print(out, "    {:9} {:14.2f} {:8.1f}% {:>10} {:>9}  [{}]  {}\n",
+                  fs.lookups, fs.probes / lookups,
+                  100.0 * fs.magnified / lookups,
+                  Strutil::timeintervalformat(fs.lookup_time
+                                              - fs.find_tile_time),
+                  Strutil::timeintervalformat(fs.find_tile_time), mips,
+                  filestats[i].first->filename());
+        }
+        if (filestats.size() > maxfiles)
+            print(out, "    ({} more files)\n", filestats.size() - maxfiles);
+    }
+
     // Try to point out hot spots
     if (level > 0) {
         if (total_duplicates || level > 2)
@@ -2066,6 +3409,12 @@ ImageCacheImpl::getstats(int level) const
         if (total_constant || level > 2)
             print(out, "  {} {} constant-valued in all pixels\n",
                   total_constant, (total_constant == 1 ? "was" : "were"));
+        if (total_udims || level > 2)
+            print(out,
+                  "  {} udim patterns, {} tiles ({} from manifests), "
+                  "found in {}\n",
+                  total_udims, total_udim_tiles, total_udim_manifests,
+                  Strutil::timeintervalformat(total_udim_setup_time));
         if (files.size() >= 50 || level > 2) {
             const int topN = 3;
             int nprinted;
@@ -2174,8 +3523,12 @@ ImageCacheImpl::reset_stats()
     {
         spin_lock lock(m_perthread_info_mutex);
         for (size_t i = 0; i < m_all_perthread_info.size(); ++i)
-            if (m_all_perthread_info[i])
+            if (m_all_perthread_info[i]) {
                 m_all_perthread_info[i]->m_stats.init();
+                spin_lock filelock(
+                    m_all_perthread_info[i]->m_file_stats_mutex);
+                m_all_perthread_info[i]->m_file_stats.clear();
+            }
     }
 
     {
@@ -2230,6 +3583,8 @@ ImageCacheImpl::attribute(string_view name, TypeDesc type, const void* val)
         m_plugin_searchpath = std::string(*(const char**)val);
     } else if (name == "statistics:level" && type == TypeDesc::INT) {
         m_statslevel = *(const int*)val;
+    } else if (name == "statistics:per_file" && type == TypeDesc::INT) {
+        m_per_file_stats = *(const int*)val != 0;
     } else if (name == "max_errors_per_file" && type == TypeDesc::INT) {
         m_max_errors_per_file = *(const int*)val;
     } else if (name == "autotile" && type == TypeDesc::INT) {
@@ -2291,6 +3646,8 @@ ImageCacheImpl::attribute(string_view name, TypeDesc type, const void* val)
         m_failure_retries = *(const int*)val;
     } else if (name == "trust_file_extensions" && type == TypeDesc::INT) {
         m_trust_file_extensions = *(const int*)val;
+    } else if (name == "udim_manifest" && type == TypeDesc::INT) {
+        m_udim_manifest = *(const int*)val;
     } else if (name == "max_open_files_strict" && type == TypeDesc::INT) {
         m_max_open_files_strict = *(const int*)val;
     } else if (name == "latlong_up" && type == TypeDesc::STRING) {
@@ -2320,13 +3677,149 @@ ImageCacheImpl::attribute(string_view name, TypeDesc type, const void* val)
     } else if (name == "max_mip_res" && type == TypeInt) {
         m_max_mip_res = *(const int*)val;
         do_invalidate = true;
+    } else if (name == "prefetch_threads" && type == TypeInt) {
+        spin_lock lock(m_prefetch_mutex);
+        m_prefetch_threads = std::max(-1, *(const int*)val);
+        if (m_prefetch_pool && m_prefetch_threads >= 0)
+            m_prefetch_pool->resize(m_prefetch_threads);
+    } else if (name == "watch_files" && type == TypeInt) {
+        bool on = (*(const int*)val != 0);
+        if (!m_watcher.enable(on))
+            error("File change notifications are not available here");
+    } else if (name == "diskcache_dir" && type == TypeDesc::STRING) {
+        string_view dir(*(const char**)val);
+        if (!m_diskcache.set_directory(dir))
+            error("Could not use \"{}\" as a disk tile cache directory", dir);
+    } else if (name == "diskcache_max_MB" && type == TypeDesc::FLOAT) {
+        m_diskcache.set_max_bytes(
+            (long long)(*(const float*)val * (1024.0 * 1024.0)));
+    } else if (name == "diskcache_max_MB" && type == TypeDesc::INT) {
+        m_diskcache.set_max_bytes(*(const int*)val * (1024LL * 1024));
+    } else if (name == "thumbnail_size" && type == TypeInt) {
+        m_thumbnails.set_size(*(const int*)val);
+    } else if (name == "thumbnail_dir" && type == TypeDesc::STRING) {
+        string_view dir(*(const char**)val);
+        if (!m_thumbnails.set_directory(dir))
+            error("Could not use \"{}\" as a thumbnail cache directory", dir);
+    } else if (name == "thumbnail_max_MB" && type == TypeDesc::FLOAT) {
+        m_thumbnails.set_max_bytes(
+            (long long)(*(const float*)val * (1024.0 * 1024.0)));
+    } else if (name == "thumbnail_max_MB" && type == TypeDesc::INT) {
+        m_thumbnails.set_max_bytes(*(const int*)val * (1024LL * 1024));
+    } else if (name == "retile_dir" && type == TypeDesc::STRING) {
+        string_view dir(*(const char**)val);
+        if (!m_retile.set_directory(dir))
+            error("Could not use \"{}\" as a retile cache directory", dir);
+    } else if (name == "retile_max_MB" && type == TypeDesc::FLOAT) {
+        m_retile.set_max_bytes(
+            (long long)(*(const float*)val * (1024.0 * 1024.0)));
+    } else if (name == "retile_max_MB" && type == TypeDesc::INT) {
+        m_retile.set_max_bytes(*(const int*)val * (1024LL * 1024));
+    } else if (name == "sharedcache_name" && type == TypeDesc::STRING) {
+        string_view shmname(*(const char**)val);
+        if (!m_sharedtier.set_name(shmname))
+            error("Could not use \"{}\" as a shared tile cache", shmname);
+    } else if (name == "sharedcache_max_MB" && type == TypeDesc::FLOAT) {
+        m_sharedtier.set_max_bytes(
+            (long long)(*(const float*)val * (1024.0 * 1024.0)));
+    } else if (name == "sharedcache_max_MB" && type == TypeDesc::INT) {
+        m_sharedtier.set_max_bytes(*(const int*)val * (1024LL * 1024));
+    } else if (name == "tileservers" && type == TypeDesc::STRING) {
+        string_view list(*(const char**)val);
+        if (!m_remotetier.set_servers(list))
+            error("Could not use tile servers \"{}\"", list);
+    } else if (name == "tileserver_port" && type == TypeDesc::INT) {
+        int port = *(const int*)val;
+        if (!m_remotetier.set_port(port))
+            error("Could not serve tiles on port {}", port);
+    } else if (name == "tileserver_address" && type == TypeDesc::STRING) {
+        string_view address(*(const char**)val);
+        if (!m_remotetier.set_address(address))
+            error("Could not serve tiles on \"{}\" port {}", address,
+                  m_remotetier.port());
+    } else if (name == "tileserver_secret" && type == TypeDesc::STRING) {
+        m_remotetier.set_secret(*(const char**)val);
+    } else if (name == "tileserver_max_connections"
+               && type == TypeDesc::INT) {
+        m_remotetier.set_max_connections(*(const int*)val);
+    } else if (name == "tileserver_max_MB" && type == TypeDesc::FLOAT) {
+        m_remotetier.set_max_bytes(
+            (long long)(*(const float*)val * (1024.0 * 1024.0)));
+    } else if (name == "tileserver_max_MB" && type == TypeDesc::INT) {
+        m_remotetier.set_max_bytes(*(const int*)val * (1024LL * 1024));
+    } else if (name == "tileserver_timeout" && type == TypeDesc::INT) {
+        m_remotetier.set_timeout_ms(*(const int*)val);
+    } else if (name == "compressed_max_MB" && type == TypeDesc::FLOAT) {
+        m_compressedtier.set_max_bytes(
+            (long long)(*(const float*)val * (1024.0 * 1024.0)));
+    } else if (name == "compressed_max_MB" && type == TypeDesc::INT) {
+        m_compressedtier.set_max_bytes(*(const int*)val * (1024LL * 1024));
+    } else if (name == "compressed_codec" && type == TypeDesc::STRING) {
+        string_view codec(*(const char**)val);
+        if (!m_compressedtier.set_codec(codec)) {
+            error("Unknown compressed_codec \"{}\"", codec);
+            return false;
+        }
+    } else if (name == "record_tiles" && type == TypeDesc::STRING) {
+        string_view filename(*(const char**)val);
+        if (!m_tilerecorder.set_filename(filename)) {
+            error("Could not open \"{}\" to record tile accesses", filename);
+            return false;
+        }
+    } else if (name == "record_tiles_max_MB" && type == TypeDesc::FLOAT) {
+        m_tilerecorder.set_max_bytes(
+            (long long)(*(const float*)val * (1024.0 * 1024.0)));
+    } else if (name == "record_tiles_max_MB" && type == TypeDesc::INT) {
+        m_tilerecorder.set_max_bytes(*(const int*)val * (1024LL * 1024));
+    } else if (name == "eviction_policy" && type == TypeDesc::STRING) {
+        string_view policyname(*(const char**)val);
+        if (policyname != m_eviction_policy->name()) {
+            auto policy = TileEvictionPolicy::create(policyname,
+                                                     m_max_memory_bytes);
+            if (!policy)
+                return false;
+            // The new policy knows nothing of the tiles already cached.
+            invalidate_all(true);
+            spin_lock lock(m_tile_sweep_mutex);
+            m_eviction_policy.swap(policy);
+        }
+    } else if (name == "microcache_size" && type == TypeInt) {
+        m_microcache_size = clamp(*(const int*)val, 0, 1024);
+        // Each thread resizes its own the next time it checks for a purge.
+        purge_perthread_microcaches();
+    } else if (name == "numa_tiles" && type == TypeInt) {
+        m_numa_tiles = *(const int*)val != 0;
+    } else if (name == "mmap_tiles" && type == TypeInt) {
+        m_mmap_tiles = *(const int*)val != 0;
+    } else if (name == "tilecache_impl" && type == TypeDesc::STRING) {
+        string_view impl(*(const char**)val);
+        if (impl != "map" && impl != "lockfree")
+            return false;
+        bool lockfree = (impl == "lockfree");
+        if (lockfree != m_tilecache_lockfree) {
+            // Lookups on other threads may be using the cache we have, and
+            // tiles don't migrate between the two, so it can only be
+            // chosen while no tile has been cached.
+            if (m_tiles_cached) {
+                error("\"tilecache_impl\" can't be changed once tiles have "
+                      "been cached");
+                return false;
+            }
+            m_tilecache_lockfree = lockfree;
+            m_tile_sweep_id      = TileID();
+            m_tile_sweep_pos     = LockFreeTileCache::SweepPos();
+        }
     } else {
         // Otherwise, unknown name
         return false;
     }
 
-    if (do_invalidate)
+    if (do_invalidate) {
+        // The settings changed, not the files, so change notifications
+        // won't say which files need another look.
+        m_watcher.rescan();
         invalidate_all(force_invalidate);
+    }
     return true;
 }
 
@@ -2339,6 +3832,7 @@ ImageCacheImpl::getattributetype(string_view name) const
         { "max_open_files", TypeInt },
         { "max_memory_MB", TypeFloat },
         { "statistics:level", TypeInt },
+        { "statistics:per_file", TypeInt },
         { "max_errors_per_file", TypeInt },
         { "autotile", TypeInt },
         { "autoscanline", TypeInt },
@@ -2349,6 +3843,7 @@ ImageCacheImpl::getattributetype(string_view name) const
         { "deduplicate", TypeInt },
         { "unassociatedalpha", TypeInt },
         { "trust_file_extensions", TypeInt },
+        { "udim_manifest", TypeInt },
         { "failure_retries", TypeInt },
         { "total_files", TypeInt },
         { "max_mip_res", TypeInt },
@@ -2358,6 +3853,34 @@ ImageCacheImpl::getattributetype(string_view name) const
         { "commontoworld", TypeMatrix },
         { "latlong_up", TypeString },
         { "substitute_image", TypeString },
+        { "prefetch_threads", TypeInt },
+        { "watch_files", TypeInt },
+        { "eviction_policy", TypeString },
+        { "record_tiles", TypeString },
+        { "record_tiles_max_MB", TypeFloat },
+        { "diskcache_dir", TypeString },
+        { "diskcache_max_MB", TypeFloat },
+        { "thumbnail_size", TypeInt },
+        { "thumbnail_dir", TypeString },
+        { "thumbnail_max_MB", TypeFloat },
+        { "retile_dir", TypeString },
+        { "retile_max_MB", TypeFloat },
+        { "sharedcache_name", TypeString },
+        { "sharedcache_max_MB", TypeFloat },
+        { "tileservers", TypeString },
+        { "tileserver_port", TypeInt },
+        { "tileserver_address", TypeString },
+        { "tileserver_max_connections", TypeInt },
+        { "tileserver_tiles", TypeInt },
+        { "tileserver_max_MB", TypeFloat },
+        { "tileserver_timeout", TypeInt },
+        { "compressed_max_MB", TypeFloat },
+        { "compressed_codec", TypeString },
+        { "tilecache_impl", TypeString },
+        { "numa_tiles", TypeInt },
+        { "mmap_tiles", TypeInt },
+        { "microcache_size", TypeInt },
+        { "numa_nodes", TypeInt },
         { "stat:cache_memory_used", TypeInt64 },
         { "stat:tiles_created", TypeInt },
         { "stat:tiles_current", TypeInt },
@@ -2367,6 +3890,8 @@ ImageCacheImpl::getattributetype(string_view name) const
         { "stat:open_files_peak", TypeInt },
         { "stat:find_tile_calls", TypeInt64 },
         { "stat:find_tile_microcache_misses", TypeInt64 },
+        { "stat:microcache_set_hits", TypeInt64 },
+        { "stat:microcache_set_misses", TypeInt64 },
         { "stat:find_tile_cache_misses", TypeInt },
         { "stat:files_totalsize", TypeInt64 },
         { "stat:image_size", TypeInt64 },
@@ -2379,7 +3904,31 @@ ImageCacheImpl::getattributetype(string_view name) const
         { "stat:tile_locking_time", TypeFloat },
         { "stat:find_file_time", TypeFloat },
         { "stat:find_tile_time", TypeFloat },
+        { "stat:tile_evictions", TypeInt64 },
+        { "stat:tile_promotions", TypeInt64 },
+        { "stat:tile_ghost_hits", TypeInt64 },
+        { "stat:diskcache_hits", TypeInt64 },
+        { "stat:diskcache_misses", TypeInt64 },
+        { "stat:sharedcache_hits", TypeInt64 },
+        { "stat:sharedcache_misses", TypeInt64 },
+        { "stat:tileserver_hits", TypeInt64 },
+        { "stat:tileserver_misses", TypeInt64 },
+        { "stat:tiles_prefetched", TypeInt64 },
+        { "stat:coalesced_reads", TypeInt64 },
+        { "stat:coalesced_tiles", TypeInt64 },
+        { "stat:numa_copies", TypeInt64 },
+        { "stat:tiles_mapped", TypeInt64 },
+        { "stat:tiles_constant", TypeInt64 },
+        { "stat:compressed_hits", TypeInt64 },
+        { "stat:compressed_stores", TypeInt64 },
+        { "stat:compress_time", TypeFloat },
+        { "stat:decompress_time", TypeFloat },
+        { "stat:tiles_colortransformed", TypeInt64 },
+        { "stat:colortransform_copies", TypeInt64 },
+        { "stat:colortransform_time", TypeFloat },
         { "stat:texture_queries", TypeInt64 },
+        { "stat:approximate_lookups", TypeInt64 },
+        { "stat:files_retiled", TypeInt },
         { "stat:texture3d_queries", TypeInt64 },
         { "stat:environment_queries", TypeInt64 },
         { "stat:getimageinfo_queries", TypeInt64 },
@@ -2417,6 +3966,7 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
     ATTR_DECODE("max_memory_MB", float, m_max_memory_bytes / (1024.0 * 1024.0));
     ATTR_DECODE("max_memory_MB", int, m_max_memory_bytes / (1024 * 1024));
     ATTR_DECODE("statistics:level", int, m_statslevel);
+    ATTR_DECODE("statistics:per_file", int, m_per_file_stats);
     ATTR_DECODE("max_errors_per_file", int, m_max_errors_per_file);
     ATTR_DECODE("autotile", int, m_autotile);
     ATTR_DECODE("autoscanline", int, m_autoscanline);
@@ -2427,10 +3977,50 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
     ATTR_DECODE("deduplicate", int, m_deduplicate);
     ATTR_DECODE("unassociatedalpha", int, m_unassociatedalpha);
     ATTR_DECODE("trust_file_extensions", int, m_trust_file_extensions);
+    ATTR_DECODE("udim_manifest", int, m_udim_manifest);
     ATTR_DECODE("max_open_files_strict", int, m_max_open_files_strict);
     ATTR_DECODE("failure_retries", int, m_failure_retries);
     ATTR_DECODE("total_files", int, m_files.size());
     ATTR_DECODE("max_mip_res", int, m_max_mip_res);
+    ATTR_DECODE("prefetch_threads", int, m_prefetch_threads);
+    ATTR_DECODE("microcache_size", int, m_microcache_size);
+    ATTR_DECODE("numa_tiles", int, int(m_numa_tiles));
+    ATTR_DECODE("mmap_tiles", int, int(m_mmap_tiles));
+    ATTR_DECODE("numa_nodes", int, m_numa_nodes);
+    ATTR_DECODE("watch_files", int, int(m_watcher.enabled()));
+    ATTR_DECODE("diskcache_max_MB", float,
+                m_diskcache.max_bytes() / (1024.0 * 1024.0));
+    ATTR_DECODE("diskcache_max_MB", int,
+                m_diskcache.max_bytes() / (1024 * 1024));
+    ATTR_DECODE("thumbnail_size", int, m_thumbnails.size());
+    ATTR_DECODE("thumbnail_max_MB", float,
+                m_thumbnails.max_bytes() / (1024.0 * 1024.0));
+    ATTR_DECODE("thumbnail_max_MB", int,
+                m_thumbnails.max_bytes() / (1024 * 1024));
+    ATTR_DECODE("retile_max_MB", float,
+                m_retile.max_bytes() / (1024.0 * 1024.0));
+    ATTR_DECODE("retile_max_MB", int, m_retile.max_bytes() / (1024 * 1024));
+    ATTR_DECODE("sharedcache_max_MB", float,
+                m_sharedtier.max_bytes() / (1024.0 * 1024.0));
+    ATTR_DECODE("sharedcache_max_MB", int,
+                m_sharedtier.max_bytes() / (1024 * 1024));
+    ATTR_DECODE("tileserver_port", int, m_remotetier.port());
+    ATTR_DECODE("tileserver_max_MB", float,
+                m_remotetier.max_bytes() / (1024.0 * 1024.0));
+    ATTR_DECODE("tileserver_max_MB", int,
+                m_remotetier.max_bytes() / (1024 * 1024));
+    ATTR_DECODE("tileserver_timeout", int, m_remotetier.timeout_ms());
+    ATTR_DECODE("tileserver_max_connections", int,
+                m_remotetier.max_connections());
+    ATTR_DECODE("tileserver_tiles", int, m_remotetier.tiles_served());
+    ATTR_DECODE("compressed_max_MB", float,
+                m_compressedtier.max_bytes() / (1024.0 * 1024.0));
+    ATTR_DECODE("compressed_max_MB", int,
+                m_compressedtier.max_bytes() / (1024 * 1024));
+    ATTR_DECODE("record_tiles_max_MB", float,
+                m_tilerecorder.max_bytes() / (1024.0 * 1024.0));
+    ATTR_DECODE("record_tiles_max_MB", int,
+                m_tilerecorder.max_bytes() / (1024 * 1024));
 
     // The cases that don't fit in the simple ATTR_DECODE scheme
     if (name == "searchpath" && type == TypeDesc::STRING) {
@@ -2467,6 +4057,47 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
         *(const char**)val = m_colorspace.c_str();
         return true;
     }
+    if (name == "diskcache_dir" && type == TypeDesc::STRING) {
+        *(const char**)val = ustring(m_diskcache.directory()).c_str();
+        return true;
+    }
+    if (name == "thumbnail_dir" && type == TypeDesc::STRING) {
+        *(const char**)val = ustring(m_thumbnails.directory()).c_str();
+        return true;
+    }
+    if (name == "retile_dir" && type == TypeDesc::STRING) {
+        *(const char**)val = ustring(m_retile.directory()).c_str();
+        return true;
+    }
+    if (name == "sharedcache_name" && type == TypeDesc::STRING) {
+        *(const char**)val = ustring(m_sharedtier.name()).c_str();
+        return true;
+    }
+    if (name == "tileservers" && type == TypeDesc::STRING) {
+        *(const char**)val = ustring(m_remotetier.servers()).c_str();
+        return true;
+    }
+    if (name == "tileserver_address" && type == TypeDesc::STRING) {
+        *(const char**)val = ustring(m_remotetier.address()).c_str();
+        return true;
+    }
+    if (name == "compressed_codec" && type == TypeDesc::STRING) {
+        *(const char**)val = ustring(m_compressedtier.codec()).c_str();
+        return true;
+    }
+    if (name == "record_tiles" && type == TypeDesc::STRING) {
+        *(const char**)val = ustring(m_tilerecorder.filename()).c_str();
+        return true;
+    }
+    if (name == "eviction_policy" && type == TypeDesc::STRING) {
+        *(const char**)val = ustring(m_eviction_policy->name()).c_str();
+        return true;
+    }
+    if (name == "tilecache_impl" && type == TypeDesc::STRING) {
+        *(const char**)val
+            = ustring(m_tilecache_lockfree ? "lockfree" : "map").c_str();
+        return true;
+    }
     if (name == "all_filenames" && type.basetype == TypeDesc::STRING
         && type.is_sized_array()) {
         ustring* names = (ustring*)val;
@@ -2496,6 +4127,10 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
         ATTR_DECODE("stat:find_tile_calls", long long, stats.find_tile_calls);
         ATTR_DECODE("stat:find_tile_microcache_misses", long long,
                     stats.find_tile_microcache_misses);
+        ATTR_DECODE("stat:microcache_set_hits", long long,
+                    stats.microcache_set_hits);
+        ATTR_DECODE("stat:microcache_set_misses", long long,
+                    stats.microcache_set_misses);
         ATTR_DECODE("stat:find_tile_cache_misses", int,
                     stats.find_tile_cache_misses);
         ATTR_DECODE("stat:files_totalsize", long long,
@@ -2510,7 +4145,41 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
         ATTR_DECODE("stat:tile_locking_time", float, stats.tile_locking_time);
         ATTR_DECODE("stat:find_file_time", float, stats.find_file_time);
         ATTR_DECODE("stat:find_tile_time", float, stats.find_tile_time);
+        ATTR_DECODE("stat:tile_evictions", long long, stats.tile_evictions);
+        ATTR_DECODE("stat:tile_promotions", long long, stats.tile_promotions);
+        ATTR_DECODE("stat:tile_ghost_hits", long long, stats.tile_ghost_hits);
+        ATTR_DECODE("stat:diskcache_hits", long long, stats.diskcache_hits);
+        ATTR_DECODE("stat:diskcache_misses", long long,
+                    stats.diskcache_misses);
+        ATTR_DECODE("stat:sharedcache_hits", long long,
+                    stats.sharedcache_hits);
+        ATTR_DECODE("stat:sharedcache_misses", long long,
+                    stats.sharedcache_misses);
+        ATTR_DECODE("stat:tileserver_hits", long long, stats.tileserver_hits);
+        ATTR_DECODE("stat:tileserver_misses", long long,
+                    stats.tileserver_misses);
+        ATTR_DECODE("stat:tiles_prefetched", long long,
+                    stats.tiles_prefetched);
+        ATTR_DECODE("stat:coalesced_reads", long long, stats.coalesced_reads);
+        ATTR_DECODE("stat:coalesced_tiles", long long, stats.coalesced_tiles);
+        ATTR_DECODE("stat:numa_copies", long long, stats.numa_copies);
+        ATTR_DECODE("stat:tiles_mapped", long long, stats.tiles_mapped);
+        ATTR_DECODE("stat:tiles_constant", long long, stats.tiles_constant);
+        ATTR_DECODE("stat:compressed_hits", long long, stats.compressed_hits);
+        ATTR_DECODE("stat:compressed_stores", long long,
+                    stats.compressed_stores);
+        ATTR_DECODE("stat:compress_time", float, stats.compress_time);
+        ATTR_DECODE("stat:decompress_time", float, stats.decompress_time);
+        ATTR_DECODE("stat:tiles_colortransformed", long long,
+                    stats.tiles_colortransformed);
+        ATTR_DECODE("stat:colortransform_copies", long long,
+                    stats.colortransform_copies);
+        ATTR_DECODE("stat:colortransform_time", float,
+                    stats.colortransform_time);
         ATTR_DECODE("stat:texture_queries", long long, stats.texture_queries);
+        ATTR_DECODE("stat:approximate_lookups", long long,
+                    stats.approximate_lookups);
+        ATTR_DECODE("stat:files_retiled", int, m_retile.made());
         ATTR_DECODE("stat:texture3d_queries", long long,
                     stats.texture3d_queries);
         ATTR_DECODE("stat:environment_queries", long long,
@@ -2528,19 +4197,60 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
 
 
 bool
-ImageCacheImpl::find_tile_main_cache(const TileID& id, ImageCacheTileRef& tile,
+ImageCacheImpl::find_tile_microcache(const TileID& id,
+                                     ImageCachePerThreadInfo* thread_info)
+{
+    ImageCacheTileRef& tile(thread_info->tile);
+    TileMicroCache& microcache(thread_info->microcache);
+    // `tile` holds what was lasttile before find_tile swapped them, and is
+    // about to be replaced: it goes to the microcache either way.
+    ImageCacheTileRef found;
+    if (microcache.take(id, found)) {
+        ++thread_info->m_stats.microcache_set_hits;
+        if (tile)
+            microcache.insert(std::move(tile));
+        tile = std::move(found);
+        tile->use();
+        return true;
+    }
+    ++thread_info->m_stats.microcache_set_misses;
+    if (tile)
+        microcache.insert(std::move(tile));
+    return find_tile_main_cache(id, tile, thread_info);
+}
+
+
+
+bool
+ImageCacheImpl::find_tile_main_cache(const TileID& requested,
+                                     ImageCacheTileRef& tile,
                                      ImageCachePerThreadInfo* thread_info)
 {
-    OIIO_DASSERT(!id.file().broken());
+    OIIO_DASSERT(!requested.file().broken());
     ImageCacheStatistics& stats(thread_info->m_stats);
 
+    // With "numa_tiles", what we want is the copy of the tile belonging
+    // to the NUMA node we're running on.
+    TileID localid;
+    if (m_numa_tiles && m_numa_nodes > 1) {
+        int node = current_numa_node();
+        if (node != requested.numa_node()) {
+            localid = requested;
+            localid.numa_node(node);
+        }
+    }
+    const TileID& id(localid.empty() ? requested : localid);
+
     ++stats.find_tile_microcache_misses;
 
     {
 #if IMAGECACHE_TIME_STATS
         Timer timer1;
 #endif
-        bool found = m_tilecache.retrieve(id, tile);
+        bool found = m_tilecache_lockfree
+                         ? m_tilecache_lf.retrieve(
+                             id, tile, &thread_info->m_tilecache_reader)
+                         : m_tilecache.retrieve(id, tile);
 #if IMAGECACHE_TIME_STATS
         stats.find_tile_time += timer1();
 #endif
@@ -2554,6 +4264,8 @@ ImageCacheImpl::find_tile_main_cache(const TileID& id, ImageCacheTileRef& tile,
             tile->use();
             OIIO_DASSERT(id == tile->id());
             OIIO_DASSERT(tile);
+            if (OIIO_UNLIKELY(m_tilerecorder.enabled()))
+                m_tilerecorder.record(id, true, tile->memsize());
             return true;
         }
     }
@@ -2567,14 +4279,275 @@ ImageCacheImpl::find_tile_main_cache(const TileID& id, ImageCacheTileRef& tile,
     // expensive disk read.  We believe this is safe, since underneath
     // the ImageCacheFile will lock itself for the read_tile and there are
     // no other non-threadsafe side effects.
-    tile = new ImageCacheTile(id);
-    // N.B. the ImageCacheTile ctr starts the tile out as 'used'
-    OIIO_DASSERT(tile);
-    OIIO_DASSERT(id == tile->id());
+    bool ok;
+    if (m_numa_tiles && m_numa_nodes > 1
+        && copy_numa_tile(id, tile, thread_info)) {
+        ok = tile->valid();
+    } else if (id.colortransformid() > 0
+               && colortransform_cached_tile(id, tile, thread_info)) {
+        ok = tile->valid();
+    } else {
+        tile = new ImageCacheTile(id);
+        // N.B. the ImageCacheTile ctr starts the tile out as 'used'
+        OIIO_DASSERT(tile);
+        OIIO_DASSERT(id == tile->id());
+
+        ok = add_tile_to_cache(tile, thread_info);
+        OIIO_DASSERT(id == tile->id());
+        ok = ok && tile->valid();
+    }
+    if (OIIO_UNLIKELY(m_tilerecorder.enabled()))
+        m_tilerecorder.record(id, false, tile->memsize());
+    return ok;
+}
 
-    bool ok = add_tile_to_cache(tile, thread_info);
-    OIIO_DASSERT(id == tile->id());
-    return ok && tile->valid();
+
+
+bool
+ImageCacheImpl::find_tile_nonblocking(const TileID& id,
+                                      ImageCachePerThreadInfo* thread_info,
+                                      bool mark_same_tile_used)
+{
+    // The last two tiles used are resident, of course. Untiled images,
+    // automatic MIP levels, and color transformed or NUMA node copies of
+    // tiles are made from other tiles, so those we read as usual, like
+    // prefetch_tiles does.
+    ImageCacheTileRef& tile(thread_info->tile);
+    ImageCacheTileRef& lasttile(thread_info->lasttile);
+    const ImageCacheFile::SubimageInfo& si(
+        id.file().subimageinfo(id.subimage()));
+    if ((tile && same_tile(tile->id(), id))
+        || (lasttile && same_tile(lasttile->id(), id)) || si.untiled
+        || (si.unmipped && id.miplevel() > 0) || id.colortransformid() > 0
+        || (m_numa_tiles && m_numa_nodes > 1) || tile_resident(id, thread_info))
+        return find_tile(id, thread_info, mark_same_tile_used);
+
+    // N.B. A tile whose read is already queued is in the cache, so it
+    // won't be queued again.
+    const ImageSpec& spec(id.file().spec(id.subimage(), id.miplevel()));
+    ROI roi(id.x(), id.x() + spec.tile_width, id.y(),
+            id.y() + spec.tile_height, id.z(), id.z() + spec.tile_depth,
+            id.chbegin(), id.chend());
+    init_prefetch_pool();
+    thread_info->m_stats.tiles_prefetched
+        += add_tiles_to_cache(id.file_ptr(), thread_info, id.subimage(),
+                              id.miplevel(), roi, true /*async*/);
+    thread_info->m_nonresident_level
+        = std::max(thread_info->m_nonresident_level, id.miplevel());
+    // Keep the last tile used, as find_tile would have.
+    if (tile)
+        lasttile = std::move(tile);
+    tile.reset();
+    return false;
+}
+
+
+
+bool
+ImageCacheImpl::copy_numa_tile(const TileID& id, ImageCacheTileRef& tile,
+                               ImageCachePerThreadInfo* thread_info)
+{
+    for (int node = 0; node < m_numa_nodes; ++node) {
+        if (node == id.numa_node())
+            continue;
+        TileID otherid(id);
+        otherid.numa_node(node);
+        ImageCacheTileRef other;
+        bool found = m_tilecache_lockfree
+                         ? m_tilecache_lf.retrieve(
+                             otherid, other, &thread_info->m_tilecache_reader)
+                         : m_tilecache.retrieve(otherid, other);
+        if (!found || !other->pixels_ready() || !other->valid()
+            || !other->memsize() || other->deepdata())
+            continue;
+        // Copying is much cheaper than reading the file again, and since
+        // this thread allocates and writes the new pixels, they will be
+        // local to its node.
+        const ImageSpec& spec(id.file().spec(id.subimage(), id.miplevel()));
+        stride_t xstride = other->pixelsize();
+        stride_t ystride = xstride * spec.tile_width;
+        tile = new ImageCacheTile(id, other->data(),
+                                  id.file().datatype(id.subimage()), xstride,
+                                  ystride, ystride * spec.tile_height);
+        ++thread_info->m_stats.numa_copies;
+        (void)add_tile_to_cache(tile, thread_info);
+        return true;
+    }
+    return false;
+}
+
+
+
+bool
+ImageCacheImpl::colortransform_cached_tile(const TileID& id,
+                                           ImageCacheTileRef& tile,
+                                           ImageCachePerThreadInfo* thread_info)
+{
+    TileID rawid(id.file(), id.subimage(), id.miplevel(), id.x(), id.y(),
+                 id.z(), id.chbegin(), id.chend());
+    rawid.numa_node(id.numa_node());
+    ImageCacheTileRef raw;
+    bool found = m_tilecache_lockfree
+                     ? m_tilecache_lf.retrieve(rawid, raw,
+                                               &thread_info->m_tilecache_reader)
+                     : m_tilecache.retrieve(rawid, raw);
+    if (!found || !raw->pixels_ready() || !raw->valid() || !raw->data())
+        return false;
+    // Transforming a copy of the pixels already decoded is much cheaper
+    // than reading and decoding the file again.
+    const ImageSpec& spec(id.file().spec(id.subimage(), id.miplevel()));
+    int tw           = spec.tile_width;
+    int th           = spec.tile_height;
+    int td           = std::max(1, spec.tile_depth);
+    stride_t xstride = raw->pixelsize();
+    stride_t ystride = xstride * tw;
+    size_t size      = size_t(ystride) * th * td;
+    std::unique_ptr<char[]> pixels(new char[size]);
+    memcpy(pixels.get(), raw->data(), size);
+    raw.reset();
+    if (!id.file().colortransform(thread_info, id, 1, tw, th, td,
+                                  pixels.get()))
+        return false;
+    tile = new ImageCacheTile(id, pixels.get(),
+                              id.file().datatype(id.subimage()), xstride,
+                              ystride, ystride * th);
+    ++thread_info->m_stats.colortransform_copies;
+    (void)add_tile_to_cache(tile, thread_info);
+    return true;
+}
+
+
+
+bool
+ImageCacheImpl::insert_tile(ImageCacheTileRef& tile)
+{
+    if (!m_tiles_cached.load(std::memory_order_relaxed))
+        m_tiles_cached = true;
+    return m_tilecache_lockfree
+               ? m_tilecache_lf.insert_retrieve(tile)
+               : m_tilecache.insert_retrieve(tile->id(), tile, tile);
+}
+
+
+
+bool
+ImageCacheImpl::finish_new_tile(ImageCacheTileRef& tile,
+                                ImageCachePerThreadInfo* thread_info)
+{
+    bool ok = true;
+    if (!tile->pixels_ready()) {
+        Timer timer;
+        ok              = tile->read(thread_info);
+        double readtime = timer();
+        thread_info->m_stats.fileio_time += readtime;
+        tile->id().file().iotime() += readtime;
+        if (Metrics::enabled())
+            record_tile_read_metrics(tile->id().file(), readtime,
+                                     tile->memsize());
+    }
+    m_eviction_policy->inserted(tile.get(), thread_info->m_stats);
+    check_max_mem(thread_info);
+    return ok;
+}
+
+
+
+bool
+ImageCacheImpl::finish_new_tiles(span<ImageCacheTileRef> tiles,
+                                 ImageCachePerThreadInfo* thread_info)
+{
+    if (tiles.size() == 1)
+        return finish_new_tile(tiles[0], thread_info);
+    Timer timer;
+    bool ok         = ImageCacheTile::read_run(thread_info, tiles);
+    double readtime = timer();
+    thread_info->m_stats.fileio_time += readtime;
+    tiles[0]->id().file().iotime() += readtime;
+    if (Metrics::enabled()) {
+        size_t bytes = 0;
+        for (auto& tile : tiles)
+            bytes += tile->memsize();
+        record_tile_read_metrics(tiles[0]->id().file(), readtime, bytes);
+    }
+    ++thread_info->m_stats.coalesced_reads;
+    thread_info->m_stats.coalesced_tiles += (long long)tiles.size();
+    for (auto& tile : tiles)
+        m_eviction_policy->inserted(tile.get(), thread_info->m_stats);
+    check_max_mem(thread_info);
+    return ok;
+}
+
+
+
+int
+ImageCacheImpl::add_tiles_to_cache(ImageCacheFile* file,
+                                   ImageCachePerThreadInfo* thread_info,
+                                   int subimage, int miplevel, ROI roi,
+                                   bool async)
+{
+    const ImageSpec& spec(file->spec(subimage, miplevel));
+    // Only ordinary tiles can be read several at a time, and the disk
+    // cache, compressed tier, tile servers, and mapped tiles, if used, work
+    // one tile at a time.
+    const ImageCacheFile::SubimageInfo& si(file->subimageinfo(subimage));
+    int maxrun = (si.untiled || si.deep || (si.unmipped && miplevel > 0)
+                  || m_diskcache.enabled() || m_compressedtier.enabled()
+                  || m_remotetier.enabled() || m_mmap_tiles)
+                     ? 1
+                     : max_tile_run;
+
+    // Snap the ROI to tile boundaries, then add each tile not already in
+    // the cache as not-yet-read, so that lookups find it and wait on
+    // wait_pixels_ready(), collecting runs of adjacent new tiles in each
+    // row of tiles to be read together.
+    std::vector<ImageCacheTileRef> run;
+    auto read_run = [&]() {
+        if (run.empty())
+            return;
+        if (async) {
+            // Speculative reads, so they yield to any other I/O.
+            thread_pool* pool = m_prefetch_threads < 0 ? io_thread_pool()
+                                                       : m_prefetch_pool.get();
+            ++m_prefetches_pending;
+            pool->push(thread_pool::Priority::Low, [this, run](int /*id*/) {
+                std::vector<ImageCacheTileRef> r(run);
+                (void)finish_new_tiles(r, get_perthread_info());
+                --m_prefetches_pending;
+            });
+        } else {
+            (void)finish_new_tiles(run, thread_info);
+        }
+        run.clear();
+    };
+    int added = 0;
+    int x0 = spec.x + (roi.xbegin - spec.x) / spec.tile_width * spec.tile_width;
+    int y0 = spec.y
+             + (roi.ybegin - spec.y) / spec.tile_height * spec.tile_height;
+    int z0 = spec.z + (roi.zbegin - spec.z) / spec.tile_depth * spec.tile_depth;
+    for (int z = z0; z < roi.zend; z += spec.tile_depth) {
+        for (int y = y0; y < roi.yend; y += spec.tile_height) {
+            for (int x = x0; x < roi.xend; x += spec.tile_width) {
+                TileID id(*file, subimage, miplevel, x, y, z, roi.chbegin,
+                          roi.chend);
+                ImageCacheTileRef tile;
+                if (!tile_in_cache(id, thread_info)) {
+                    tile = new ImageCacheTile(id);
+                    if (!insert_tile(tile))
+                        tile.reset();  // Somebody else is already on it
+                }
+                if (!tile) {
+                    read_run();  // The run can't continue past this tile
+                    continue;
+                }
+                ++added;
+                run.push_back(tile);
+                if (int(run.size()) >= maxrun)
+                    read_run();
+            }
+            read_run();
+        }
+    }
+    return added;
 }
 
 
@@ -2583,21 +4556,14 @@ bool
 ImageCacheImpl::add_tile_to_cache(ImageCacheTileRef& tile,
                                   ImageCachePerThreadInfo* thread_info)
 {
-    bool ourtile = m_tilecache.insert_retrieve(tile->id(), tile, tile);
+    bool ourtile = insert_tile(tile);
 
     // If we added a new tile to the cache, we may still need to read the
     // pixels; and if we found the tile in cache, we may need to wait for
     // somebody else to read the pixels.
     bool ok = true;
     if (ourtile) {
-        if (!tile->pixels_ready()) {
-            Timer timer;
-            ok              = tile->read(thread_info);
-            double readtime = timer();
-            thread_info->m_stats.fileio_time += readtime;
-            tile->id().file().iotime() += readtime;
-        }
-        check_max_mem(thread_info);
+        ok = finish_new_tile(tile, thread_info);
     } else {
         // Somebody else already added the tile to the cache before we
         // could, so we'll use their reference, but we need to wait until it
@@ -2610,7 +4576,8 @@ ImageCacheImpl::add_tile_to_cache(ImageCacheTileRef& tile,
 
 
 void
-ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* /*thread_info*/)
+ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* thread_info,
+                              long long release)
 {
     OIIO_DASSERT(m_mem_used < (long long)m_max_memory_bytes * 10);  // sanity
 #if 0
@@ -2619,10 +4586,16 @@ ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* /*thread_info*/)
         std::cerr << "mem used: " << m_mem_used << ", max = " << m_max_memory_bytes << "\n";
 #endif
     // Early out if the cache is empty
-    if (m_tilecache.empty())
+    if (m_tilecache_lockfree ? m_tilecache_lf.empty() : m_tilecache.empty())
         return;
+    // Besides our own limit, give up tiles when asked to release memory,
+    // or when the process as a whole is over the "max_memory_MB" budget.
+    long long limit = (long long)m_max_memory_bytes;
+    long long over  = std::max(release, pvt::memory_over_budget());
+    if (over > 0)
+        limit = std::min(limit, m_mem_used - over);
     // Early out if we aren't exceeding the tile memory limit
-    if (m_mem_used < (long long)m_max_memory_bytes)
+    if (m_mem_used < limit)
         return;
 
     // Try to grab the tile_sweep_mutex lock. If somebody else holds it,
@@ -2634,6 +4607,29 @@ ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* /*thread_info*/)
     if (!m_tile_sweep_mutex.try_lock())
         return;
 
+    ImageCacheStatistics& stats(thread_info->m_stats);
+    if (m_tilecache_lockfree) {
+        // Same clock algorithm as below, but the lock-free cache keeps
+        // the hand position for us and erases the tiles itself.
+        int full_loops = 0;
+        while (m_mem_used >= limit && full_loops < 100) {
+            if (!m_tilecache_lf.sweep(m_tile_sweep_pos,
+                                      [&](ImageCacheTile* tile) {
+                                          if (!m_eviction_policy->evict(
+                                                  tile, stats))
+                                              return false;
+                                          demote_tile(tile, thread_info);
+                                          return true;
+                                      })) {
+                if (m_tilecache_lf.empty())
+                    break;
+                ++full_loops;
+            }
+        }
+        m_tile_sweep_mutex.unlock();
+        return;
+    }
+
     // Now, what we want to do is have a "clock hand" that sweeps across
     // the cache, releasing tiles that haven't been used for a long
     // time.  Because of multi-thread, rather than keep an iterator
@@ -2655,7 +4651,7 @@ ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* /*thread_info*/)
     // of looping for too long, exit the loop if we just keep spinning
     // uncontrollably.
     int full_loops = 0;
-    while (m_mem_used >= (long long)m_max_memory_bytes && full_loops < 100) {
+    while (m_mem_used >= limit && full_loops < 100) {
         // If we have fallen off the end of the cache, loop back to the
         // beginning and increment our full_loops count.
         if (!sweep) {
@@ -2668,13 +4664,13 @@ ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* /*thread_info*/)
             break;
         OIIO_DASSERT(sweep->second);
 
-        if (!sweep->second->release()) {
+        if (m_eviction_policy->evict(sweep->second.get(), stats)) {
             // This is a tile we should delete.  To keep iterating
             // safely, we have a good trick:
             // 1. remember the TileID of the tile to delete
             TileID todelete = sweep->first;
-            size_t size     = sweep->second->memsize();
-            OIIO_DASSERT(m_mem_used >= (long long)size);
+            ImageCacheTileRef evicted(sweep->second);
+            OIIO_DASSERT(m_mem_used >= (long long)evicted->memsize());
             // 2. Find the TileID of the NEXT item. We do this by
             // incrementing the sweep iterator and grabbing its id.
             ++sweep;
@@ -2682,6 +4678,8 @@ ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* /*thread_info*/)
             // 3. Release the bin lock and erase the tile we wish to delete.
             sweep.unlock();
             m_tilecache.erase(todelete);
+            demote_tile(evicted.get(), thread_info);
+            evicted.reset();
             // 4. Re-establish a locked iterator for the next item, since
             // the old iterator may have been invalidated by the erasure.
             if (!m_tile_sweep_id.empty())
@@ -2706,6 +4704,29 @@ ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* /*thread_info*/)
 
 
 
+void
+ImageCacheImpl::release_memory(long long bytes)
+{
+    check_max_mem(get_perthread_info(), bytes);
+}
+
+
+
+void
+ImageCacheImpl::demote_tile(const ImageCacheTile* tile,
+                            ImageCachePerThreadInfo* thread_info)
+{
+    if (!m_compressedtier.enabled() || !tile->valid() || !tile->memsize()
+        || tile->deepdata())
+        return;
+    Timer timer;
+    if (m_compressedtier.store(tile->id(), tile->data(), tile->memsize()))
+        ++thread_info->m_stats.compressed_stores;
+    thread_info->m_stats.compress_time += timer();
+}
+
+
+
 std::string
 ImageCacheImpl::resolve_filename(const std::string& filename) const
 {
@@ -2820,8 +4841,6 @@ ImageCacheImpl::get_image_info(ImageCacheFile* file,
         // If file->is_udim() is true, the map's length won't be changed
         // again, so it's safe to freely iterate over it without locking.
         for (auto& f : file->m_udim_lookup) {
-            if (f.filename.empty())
-                continue;  // empty filename means tile is unpopulated
             ImageCacheFile* concretefile = resolve_udim(file, thread_info, f.u,
                                                         f.v);
             concretefile = verify_file(concretefile, thread_info, true);
@@ -3168,20 +5187,110 @@ ImageCacheImpl::get_thumbnail(ustring filename, ImageBuf& thumb, int subimage)
         error("Image file \"{}\" not found", filename);
         return false;
     }
-    return get_thumbnail(file, thread_info, thumb, subimage);
-}
-
-
-
-bool
-ImageCacheImpl::get_thumbnail(ImageCacheFile* file,
-                              ImageCachePerThreadInfo* thread_info,
-                              ImageBuf& thumb, int subimage)
-{
-    std::shared_ptr<ImageInput> inp = file->open(thread_info);
-    if (!inp)
-        return false;  // indicates a broken file
-    return inp->get_thumbnail(thumb, subimage);
+    return get_thumbnail(file, thread_info, thumb, subimage);
+}
+
+
+
+bool
+ImageCacheImpl::get_thumbnail(ImageCacheFile* file,
+                              ImageCachePerThreadInfo* thread_info,
+                              ImageBuf& thumb, int subimage)
+{
+    if (m_thumbnails.enabled() && !file->is_udim()) {
+        if (m_thumbnails.get(*this, file, thread_info, thumb, subimage))
+            return true;
+        error("Could not make a thumbnail of \"{}\"", file->filename());
+        thumb.reset();
+        return false;
+    }
+    std::shared_ptr<ImageInput> inp = file->open(thread_info);
+    if (!inp)
+        return false;  // indicates a broken file
+    return inp->get_thumbnail(thumb, subimage);
+}
+
+
+
+bool
+ImageCacheImpl::get_pixel_bounds(ustring filename, int subimage, int miplevel,
+                                 ROI roi, span<float> min, span<float> max)
+{
+    ImageCachePerThreadInfo* thread_info = get_perthread_info();
+    ImageCacheFile* file = find_file(filename, thread_info, nullptr);
+    if (!file) {
+        error("Image file \"{}\" not found", filename);
+        return false;
+    }
+    return get_pixel_bounds(file, thread_info, subimage, miplevel, roi, min,
+                            max);
+}
+
+
+
+bool
+ImageCacheImpl::get_pixel_bounds(ImageCacheFile* file,
+                                 ImageCachePerThreadInfo* thread_info,
+                                 int subimage, int miplevel, ROI roi,
+                                 span<float> min, span<float> max)
+{
+    if (!file) {
+        error("Image file handle was NULL");
+        return false;
+    }
+    if (!thread_info)
+        thread_info = get_perthread_info();
+    file = verify_file(file, thread_info, true);
+    if (file->broken()) {
+        if (file->errors_should_issue())
+            error("Invalid image file \"{}\": {}", file->filename(),
+                  file->broken_error_message());
+        return false;
+    }
+    if (file->is_udim()) {
+        error("Cannot retrieve pixel bounds of a UDIM-like virtual file");
+        return false;
+    }
+    if (subimage < 0 || subimage >= file->subimages()) {
+        if (file->errors_should_issue())
+            error("Unknown subimage {} (out of {})", subimage,
+                  file->subimages());
+        return false;
+    }
+    if (miplevel < 0 || miplevel >= file->miplevels(subimage)) {
+        if (file->errors_should_issue())
+            error("Unknown mip level {} (out of {})", miplevel,
+                  file->miplevels(subimage));
+        return false;
+    }
+    const ImageCacheFile::LevelInfo& lev(file->levelinfo(subimage, miplevel));
+    if (!lev.tilestats)
+        return false;  // Not an error, there just aren't any
+    const ImageSpec& spec(lev.spec());
+    roi.zbegin = spec.z;
+    roi.zend   = spec.z + spec.depth;
+    roi        = roi_intersection(roi, spec.roi());
+    if (roi.npixels() == 0 || min.size() < size_t(roi.nchannels())
+        || max.size() < size_t(roi.nchannels()))
+        return false;
+    for (int c = 0; c < roi.nchannels(); ++c) {
+        min[c] = std::numeric_limits<float>::max();
+        max[c] = -std::numeric_limits<float>::max();
+    }
+    int nc    = spec.nchannels;
+    int tw    = spec.tile_width, th = spec.tile_height;
+    int xtile = spec.x + (roi.xbegin - spec.x) / tw * tw;
+    int ytile = spec.y + (roi.ybegin - spec.y) / th * th;
+    for (int y = ytile; y < roi.yend; y += th) {
+        for (int x = xtile; x < roi.xend; x += tw) {
+            const float* stats = lev.tile_stats(x, y);
+            for (int c = 0; c < roi.nchannels(); ++c) {
+                min[c] = std::min(min[c], stats[roi.chbegin + c]);
+                max[c] = std::max(max[c], stats[nc + roi.chbegin + c]);
+            }
+        }
+    }
+    return true;
 }
 
 
@@ -3278,6 +5387,12 @@ ImageCacheImpl::get_pixels(ImageCacheFile* file,
                   miplevel, file->filename());
         return false;
     }
+    if (file->subimageinfo(subimage).deep) {
+        error("get_pixels() cannot retrieve deep pixels of \"{}\" (use "
+              "get_deep_pixels())",
+              file->filename());
+        return false;
+    }
 
     if (!thread_info)
         thread_info = get_perthread_info();
@@ -3314,6 +5429,22 @@ ImageCacheImpl::get_pixels(ImageCacheFile* file,
     stride_t zplanesize         = (yend - ybegin) * scanlinesize;
     OIIO_DASSERT(spec.depth >= 1 && spec.tile_depth >= 1);
 
+    // If the region is more than a tile wide, add its missing tiles up
+    // front, so that adjacent ones can be read from the file together
+    // rather than one by one as the loop below comes to them -- unless the
+    // region is so big that they'd be pushed out of the cache again before
+    // we got to them.
+    const ImageCacheFile::SubimageInfo& si(file->subimageinfo(subimage));
+    ROI tileroi = roi_intersection(ROI(xbegin, xend, ybegin, yend, zbegin,
+                                       zend, cache_chbegin, cache_chend),
+                                   get_roi(spec));
+    if (!si.untiled && !(si.unmipped && miplevel > 0)
+        && tileroi.width() > spec.tile_width
+        && (long long)(tileroi.npixels() * cache_stride)
+               < (long long)m_max_memory_bytes / 4)
+        add_tiles_to_cache(file, thread_info, subimage, miplevel, tileroi,
+                           false /*async*/);
+
     imagesize_t npixelsread = 0;
     char* zptr              = (char*)result;
     for (int z = zbegin; z < zend; ++z, zptr += zstride) {
@@ -3410,6 +5541,141 @@ ImageCacheImpl::get_pixels(ImageCacheFile* file,
 
 
 
+bool
+ImageCacheImpl::get_deep_pixels(ustring filename, int subimage, int miplevel,
+                                int xbegin, int xend, int ybegin, int yend,
+                                int zbegin, int zend, DeepData& result)
+{
+    ImageCachePerThreadInfo* thread_info = get_perthread_info();
+    ImageCacheFile* file                 = find_file(filename, thread_info);
+    if (!file) {
+        error("Image file \"{}\" not found", filename);
+        return false;
+    }
+    return get_deep_pixels(file, thread_info, subimage, miplevel, xbegin,
+                           xend, ybegin, yend, zbegin, zend, result);
+}
+
+
+
+bool
+ImageCacheImpl::get_deep_pixels(ImageCacheFile* file,
+                                ImageCachePerThreadInfo* thread_info,
+                                int subimage, int miplevel, int xbegin,
+                                int xend, int ybegin, int yend, int zbegin,
+                                int zend, DeepData& result)
+{
+    if (!thread_info)
+        thread_info = get_perthread_info();
+    file = verify_file(file, thread_info);
+    if (file->broken()) {
+        if (file->errors_should_issue())
+            error("Invalid image file \"{}\": {}", file->filename(),
+                  file->broken_error_message());
+        return false;
+    }
+    if (file->is_udim()) {
+        error("Cannot get_deep_pixels() of a UDIM-like virtual file");
+        return false;
+    }
+    if (subimage < 0 || subimage >= file->subimages()) {
+        if (file->errors_should_issue())
+            error("get_deep_pixels asked for nonexistent subimage {} of "
+                  "\"{}\"",
+                  subimage, file->filename());
+        return false;
+    }
+    if (miplevel < 0 || miplevel >= file->miplevels(subimage)) {
+        if (file->errors_should_issue())
+            error("get_deep_pixels asked for nonexistent MIP level {} of "
+                  "\"{}\"",
+                  miplevel, file->filename());
+        return false;
+    }
+    if (!file->subimageinfo(subimage).deep) {
+        error("get_deep_pixels asked for subimage {} of \"{}\", which is not "
+              "deep",
+              subimage, file->filename());
+        return false;
+    }
+
+    const ImageSpec& spec(file->spec(subimage, miplevel));
+    const ImageSpec& nativespec(file->nativespec(subimage, miplevel));
+    int nchannels = nativespec.nchannels;
+    std::vector<TypeDesc> channeltypes(nchannels);
+    for (int c = 0; c < nchannels; ++c)
+        channeltypes[c] = nativespec.channelformat(c);
+    int width = std::max(xend - xbegin, 0), height = std::max(yend - ybegin, 0);
+    int64_t npixels = int64_t(width) * height * std::max(zend - zbegin, 0);
+    result.init(npixels, nchannels, channeltypes, nativespec.channelnames);
+
+    // Hold on to every tile the region touches while we first size all
+    // the result's pixels at once, and then copy their samples (rather
+    // than moving the samples of all the later pixels each time another
+    // pixel is sized).
+    ROI roi = roi_intersection(ROI(xbegin, xend, ybegin, yend, zbegin, zend),
+                               get_roi(spec));
+    if (roi.npixels() == 0)
+        return true;
+    std::vector<ImageCacheTileRef> tiles;
+    std::vector<unsigned int> nsamples(npixels, 0);
+    int x0 = spec.x + (roi.xbegin - spec.x) / spec.tile_width * spec.tile_width;
+    int y0 = spec.y
+             + (roi.ybegin - spec.y) / spec.tile_height * spec.tile_height;
+    int z0 = spec.z + (roi.zbegin - spec.z) / spec.tile_depth * spec.tile_depth;
+    // Call f(tile, dstpixel, srcpixel) for each pixel of the region within
+    // the image, with the tiles in the same order each time.
+    auto each_pixel = [&](auto f) {
+        size_t t = 0;
+        for (int tz = z0; tz < roi.zend; tz += spec.tile_depth) {
+            for (int ty = y0; ty < roi.yend; ty += spec.tile_height) {
+                for (int tx = x0; tx < roi.xend; tx += spec.tile_width, ++t) {
+                    const DeepData* dd = tiles[t]->deepdata();
+                    int tw = std::min(spec.tile_width,
+                                      spec.x + spec.width - tx);
+                    int th = std::min(spec.tile_height,
+                                      spec.y + spec.height - ty);
+                    ROI r = roi_intersection(roi,
+                                             ROI(tx, tx + tw, ty, ty + th, tz,
+                                                 tz + spec.tile_depth));
+                    for (int z = r.zbegin; z < r.zend; ++z) {
+                        for (int y = r.ybegin; y < r.yend; ++y) {
+                            int64_t dst = (int64_t(z - zbegin) * height + y
+                                           - ybegin)
+                                              * width
+                                          - xbegin;
+                            int64_t src = (int64_t(z - tz) * th + y - ty) * tw
+                                          - tx;
+                            for (int x = r.xbegin; x < r.xend; ++x)
+                                f(*dd, dst + x, src + x);
+                        }
+                    }
+                }
+            }
+        }
+    };
+    for (int tz = z0; tz < roi.zend; tz += spec.tile_depth) {
+        for (int ty = y0; ty < roi.yend; ty += spec.tile_height) {
+            for (int tx = x0; tx < roi.xend; tx += spec.tile_width) {
+                TileID id(*file, subimage, miplevel, tx, ty, tz, 0, nchannels);
+                if (!find_tile(id, thread_info, true))
+                    return false;
+                tiles.push_back(thread_info->tile);
+            }
+        }
+    }
+    each_pixel([&](const DeepData& dd, int64_t dst, int64_t src) {
+        nsamples[dst] = dd.samples(src);
+    });
+    result.set_all_samples(nsamples);
+    each_pixel([&](const DeepData& dd, int64_t dst, int64_t src) {
+        result.copy_deep_pixel(dst, dd, src);
+    });
+    return true;
+}
+
+
+
 ImageCache::Tile*
 ImageCacheImpl::get_tile(ustring filename, int subimage, int miplevel, int x,
                          int y, int z, int chbegin, int chend)
@@ -3433,7 +5699,8 @@ ImageCacheImpl::get_tile(ImageHandle* file, Perthread* thread_info,
     if (!file || file->broken() || file->is_udim())
         return nullptr;
     if (subimage < 0 || subimage >= file->subimages() || miplevel < 0
-        || miplevel >= file->miplevels(subimage))
+        || miplevel >= file->miplevels(subimage)
+        || file->subimageinfo(subimage).deep)
         return nullptr;
     const ImageSpec& spec(file->spec(subimage, miplevel));
     // Snap x,y,z to the corner of the tile
@@ -3459,6 +5726,84 @@ ImageCacheImpl::get_tile(ImageHandle* file, Perthread* thread_info,
 
 
 
+bool
+ImageCacheImpl::prefetch_tiles(ustring filename, int subimage, int miplevel,
+                               ROI roi)
+{
+    ImageCachePerThreadInfo* thread_info = get_perthread_info();
+    ImageCacheFile* file = find_file(filename, thread_info);
+    return prefetch_tiles(file, thread_info, subimage, miplevel, roi);
+}
+
+
+
+bool
+ImageCacheImpl::prefetch_tiles(ImageHandle* file, Perthread* thread_info,
+                               int subimage, int miplevel, ROI roi)
+{
+    if (!thread_info)
+        thread_info = get_perthread_info();
+    file = verify_file(file, thread_info);
+    if (!file || file->broken() || file->is_udim())
+        return false;
+    if (subimage < 0 || subimage >= file->subimages() || miplevel < 0
+        || miplevel >= file->miplevels(subimage))
+        return false;
+    // Untiled images and automatically made MIP levels are assembled by
+    // reading other tiles, which could end up waiting on the very
+    // prefetches still queued behind them, so leave those to be read on
+    // demand as usual.
+    const ImageCacheFile::SubimageInfo& si(file->subimageinfo(subimage));
+    if (si.untiled || (si.unmipped && miplevel > 0))
+        return true;
+    const ImageSpec& spec(file->spec(subimage, miplevel));
+    roi = roi_intersection(roi, get_roi(spec));
+    if (roi.npixels() == 0 || roi.nchannels() == 0)
+        return true;
+
+    init_prefetch_pool();
+    thread_info->m_stats.tiles_prefetched
+        += add_tiles_to_cache(file, thread_info, subimage, miplevel, roi,
+                              true /*async*/);
+    return true;
+}
+
+
+
+void
+ImageCacheImpl::init_prefetch_pool()
+{
+    spin_lock lock(m_prefetch_mutex);
+    if (!m_prefetch_pool && m_prefetch_threads >= 0)
+        m_prefetch_pool.reset(new thread_pool(m_prefetch_threads));
+}
+
+
+
+void
+ImageCacheImpl::request_retile(ImageCacheFile* file)
+{
+    if (!m_retile.wanted(*this, *file))
+        return;
+    init_prefetch_pool();
+    thread_pool* pool = m_prefetch_threads < 0 ? io_thread_pool()
+                                               : m_prefetch_pool.get();
+    int tilesize      = m_autotile > 0 ? m_autotile : 64;
+    bool mipmap       = m_automip;
+    ImageCacheFileRef ref(file);
+    ++m_prefetches_pending;
+    pool->push(thread_pool::Priority::Low,
+               [this, ref, tilesize, mipmap](int /*id*/) {
+                   // Lookups carry on from the original until the copy is
+                   // made, and then find it when the file is reopened.
+                   if (m_retile.make(ref->source(), tilesize, mipmap))
+                       invalidate(ref.get(), true);
+                   --m_prefetches_pending;
+               });
+}
+
+
+
 void
 ImageCacheImpl::release_tile(ImageCache::Tile* tile) const
 {
@@ -3519,6 +5864,81 @@ ImageCacheImpl::add_file(ustring filename, ImageInput::Creator creator,
 
 
 
+bool
+ImageCacheImpl::preload(cspan<ustring> filenames, ParamValueSpan options,
+                        std::vector<ustring>* broken)
+{
+    bool read_coarsest = options.get_int("read_coarsest", 0);
+    bool averagecolor  = options.get_int("averagecolor", 0);
+    int nthreads       = options.get_int("nthreads", 0);
+
+    // A UDIM pattern stands for all of its tile files.
+    ImageCachePerThreadInfo* thread_info = get_perthread_info();
+    std::vector<ImageCacheFile*> files;
+    files.reserve(filenames.size());
+    std::vector<ustring> udimtiles;
+    for (ustring filename : filenames) {
+        ImageCacheFile* file = find_file(filename, thread_info);
+        if (!file->is_udim()) {
+            files.push_back(file);
+            continue;
+        }
+        int nutiles = 0, nvtiles = 0;
+        inventory_udim(file, thread_info, udimtiles, nutiles, nvtiles);
+        for (ustring tile : udimtiles)
+            if (!tile.empty())
+                files.push_back(find_file(tile, thread_info));
+    }
+    bool close = options.get_int("close",
+                                 int(files.size()) > m_max_open_files);
+
+    // Errors go to the thread that encounters them, so each task collects
+    // its own to be issued from this thread afterwards.
+    std::vector<std::string> errors(files.size());
+    std::vector<char> ok(files.size(), 1);
+    parallel_for(
+        int64_t(0), int64_t(files.size()),
+        [&](int64_t i) {
+            ImageCachePerThreadInfo* task_info = get_perthread_info();
+            ImageCacheFile* file               = verify_file(files[i],
+                                                             task_info);
+            ok[i] = file && !file->broken();
+            for (int s = 0; ok[i] && s < file->subimages(); ++s) {
+                if (read_coarsest) {
+                    int m = file->miplevels(s) - 1;
+                    const ImageSpec& spec(file->spec(s, m));
+                    add_tiles_to_cache(file, task_info, s, m,
+                                       get_roi(spec), false /*async*/);
+                }
+                if (averagecolor && !file->subimageinfo(s).deep) {
+                    std::vector<float> avg(file->spec(s, 0).nchannels);
+                    file->get_average_color(avg.data(), s, 0,
+                                            int(avg.size()));
+                }
+            }
+            if (ok[i] && close)
+                file->close();
+            if (has_error())
+                errors[i] = geterror();
+            ok[i] &= errors[i].empty();
+        },
+        paropt(nthreads, paropt::SplitDir::Y, 1));
+
+    bool allok = true;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!errors[i].empty())
+            error("{}", errors[i]);
+        if (!ok[i]) {
+            allok = false;
+            if (broken)
+                broken->push_back(files[i]->filename_original());
+        }
+    }
+    return allok;
+}
+
+
+
 bool
 ImageCacheImpl::add_tile(ustring filename, int subimage, int miplevel, int x,
                          int y, int z, int chbegin, int chend, TypeDesc format,
@@ -3580,23 +6000,39 @@ ImageCacheImpl::invalidate(ImageHandle* handle, bool force)
         // time of the file has not changed since we opened it.
         recursive_timed_lock_guard guard(file->m_input_mutex);
         if (file->mod_time() == Filesystem::last_write_time(file->filename())
-            && !file->broken())
+            && !file->broken()
+            && (file->filename() == file->source()
+                || retiled_filename(file->source()) == file->filename()))
             return;
     }
 
     // Iterate over the entire tilecache, record the TileID's of all
     // tiles that are from the file we are invalidating.
-    std::vector<TileID> tiles_to_delete;
-    for (TileCache::iterator tci = m_tilecache.begin(), e = m_tilecache.end();
-         tci != e; ++tci) {
-        if (&(*tci).second->file() == file)
-            tiles_to_delete.push_back((*tci).second->id());
+    std::vector<ImageCacheTileRef> tiles_to_delete;
+    if (m_tilecache_lockfree) {
+        m_tilecache_lf.for_each([&](ImageCacheTile* tile) {
+            if (&tile->file() == file)
+                tiles_to_delete.emplace_back(tile);
+        });
+    } else {
+        for (TileCache::iterator tci = m_tilecache.begin(),
+                                 e   = m_tilecache.end();
+             tci != e; ++tci) {
+            if (&(*tci).second->file() == file)
+                tiles_to_delete.push_back((*tci).second);
+        }
     }
     // N.B. at this point, we hold no locks!
 
     // Safely erase all the tiles we found
-    for (const TileID& id : tiles_to_delete)
-        m_tilecache.erase(id);
+    for (const ImageCacheTileRef& tile : tiles_to_delete) {
+        if (m_tilecache_lockfree)
+            m_tilecache_lf.erase(tile->id());
+        else
+            m_tilecache.erase(tile->id());
+        m_eviction_policy->removed(tile.get());
+    }
+    m_compressedtier.erase(file.get());
 
     const ustring fingerprint = file->fingerprint();
 
@@ -3622,6 +6058,9 @@ ImageCacheImpl::invalidate_all(bool force)
     if (force) {
         // Clear the whole tile cache
         m_tilecache.clear();
+        m_tilecache_lf.clear();
+        m_eviction_policy->clear();
+        m_compressedtier.clear();
         // Invalidate (close and clear spec) all individual files
         for (FilenameMap::iterator fileit = m_files.begin(), e = m_files.end();
              fileit != e; ++fileit) {
@@ -3635,40 +6074,37 @@ ImageCacheImpl::invalidate_all(bool force)
     }
 
     // Not forced... we need to look for particular files that seem
-    // to need invalidation.
-
-    // Make a list of all files that need to be invalidated
-    std::vector<ustring> all_files;
-    for (FilenameMap::iterator fileit = m_files.begin(), e = m_files.end();
-         fileit != e; ++fileit) {
-        const ImageCacheFileRef& f(fileit->second);
+    // to need invalidation. With change notifications, those are just the
+    // files that changed (which need no further checks) and any that
+    // couldn't be watched; without them, we must check every file.
+    auto needs_invalidation = [&](const ImageCacheFileRef& f) -> bool {
         ustring name = f->filename();
         Timer input_mutex_timer;
         recursive_timed_lock_guard guard(f->m_input_mutex);
         f->m_mutex_wait_time += input_mutex_timer();
         // If the file was broken when we opened it, or if it no longer
         // exists, definitely invalidate it.
-        if (f->broken() || !Filesystem::exists(name)) {
-            all_files.push_back(name);
-            continue;
-        }
+        if (f->broken()
+            || (!Filesystem::exists(name) && !Filesystem::is_url(name)))
+            return true;
         // Invalidate the file if it has been modified since it was
         // last opened.
         std::time_t t = Filesystem::last_write_time(name);
-        if (t != f->mod_time()) {
-            all_files.push_back(name);
-            continue;
-        }
+        if (t != f->mod_time())
+            return true;
+        // Invalidate a retiled copy if its source has changed or the copy
+        // has been removed, and switch to a copy that's been made since.
+        if (retiled_filename(f->source()) != (name == f->source() ? ustring()
+                                                                  : name))
+            return true;
         for (int s = 0; s < f->subimages(); ++s) {
             const ImageCacheFile::SubimageInfo& sub(f->subimageinfo(s));
             // Invalidate if any unmipped subimage didn't automip but
             // automip is now on, or did automip but automip is now off.
             if (sub.unmipped
                 && ((m_automip && f->miplevels(s) <= 1)
-                    || (!m_automip && f->miplevels(s) > 1))) {
-                all_files.push_back(name);
-                break;
-            }
+                    || (!m_automip && f->miplevels(s) > 1)))
+                return true;
             // Invalidate if any untiled subimage doesn't match the current
             // auto-tile setting.
             if (sub.untiled) {
@@ -3676,20 +6112,46 @@ ImageCacheImpl::invalidate_all(bool force)
                     const ImageCacheFile::LevelInfo& level(f->levelinfo(s, m));
                     const ImageSpec& spec(level.spec());
                     if (spec.tile_width != m_autotile
-                        || spec.tile_height != m_autotile) {
-                        all_files.push_back(name);
-                        break;
-                    }
+                        || spec.tile_height != m_autotile)
+                        return true;
                 }
             }
         }
+        return false;
+    };
+
+    // Make a list of all files that need to be invalidated
+    std::vector<ImageCacheFileRef> all_files;
+    std::vector<ustring> changed, unwatched;
+    if (m_watcher.enabled() && m_watcher.changes(changed, unwatched)) {
+        std::sort(changed.begin(), changed.end());
+        changed.erase(std::unique(changed.begin(), changed.end()),
+                      changed.end());
+        for (ustring name : changed) {
+            ImageCacheFileRef f;
+            if (m_files.retrieve(name, f))
+                all_files.push_back(f);
+        }
+        for (ustring name : unwatched) {
+            ImageCacheFileRef f;
+            if (m_files.retrieve(name, f) && needs_invalidation(f))
+                all_files.push_back(f);
+        }
+    } else {
+        for (FilenameMap::iterator fileit = m_files.begin(), e = m_files.end();
+             fileit != e; ++fileit) {
+            const ImageCacheFileRef& f(fileit->second);
+            // (Re)watch its directory, in case any changes were missed
+            // because the directory itself went away.
+            m_watcher.watch(fileit->first, f->source());
+            if (needs_invalidation(f))
+                all_files.push_back(f);
+        }
     }
 
     // Now, invalidate all the files in our "needs invalidation" list
-    for (auto f : all_files) {
-        // print(stderr, "Invalidating {}\n", f);
-        invalidate(f, true);
-    }
+    for (auto& f : all_files)
+        invalidate(f.get(), true);
 
     // Mark the per-thread microcaches as invalid
     purge_perthread_microcaches();
@@ -3750,23 +6212,66 @@ ImageCacheFile::udim_setup()
     if (!is_udim)
         return;
 
-    // Enumerate all the matching textures by looking at all files in the
-    // directory portion of the pattern, and seeing if they match a regex
-    // we derive from the non-directory part of the pattern.
-    std::vector<std::string> filenames;
+    Timer timer;
     std::string dirname = Filesystem::parent_path(m_filename);
     if (dirname.empty())
         dirname = ".";
     std::string pat = udim_to_wildcard(Filesystem::filename(m_filename));
+
+    // With "udim_manifest", the inventory may be found in a sidecar file
+    // next to the tiles, saving the directory scan.
+    std::vector<UdimInfo> udim_list;
+    std::string manifest;
+    if (m_imagecache.udim_manifest()) {
+        std::string name = Filesystem::filename(m_filename);
+        for (char& c : name)
+            if (strchr("<>%()#", c))
+                c = '_';
+        manifest = Strutil::fmt::format("{}/.{}.udims", dirname, name);
+    }
+    m_udim_from_manifest = manifest.size()
+                           && udim_read_manifest(manifest, dirname, udim_list);
+    if (!m_udim_from_manifest) {
+        udim_scan(dirname, pat, udim1, udim2_1, udim_list);
+        if (manifest.size())
+            udim_write_manifest(manifest, dirname, udim_list);
+    }
+    for (auto& ud : udim_list) {
+        m_udim_nutiles = std::max(m_udim_nutiles, short(ud.u + 1));
+        m_udim_nvtiles = std::max(m_udim_nvtiles, short(ud.v + 1));
+    }
+
+    // Keep only the tiles that exist, with a grid of indices into them for
+    // lookups by u and v.
+    m_udim_lookup.swap(udim_list);
+    m_udim_index.assign(int(m_udim_nutiles) * int(m_udim_nvtiles), -1);
+    for (size_t i = 0, e = m_udim_lookup.size(); i < e; ++i) {
+        const UdimInfo& ud(m_udim_lookup[i]);
+        m_udim_index[ud.v * m_udim_nutiles + ud.u] = int(i);
+    }
+    m_udim_setup_time = timer();
+}
+
+
+
+void
+ImageCacheFile::udim_scan(const std::string& dirname, const std::string& pat,
+                          bool udim1, bool udim2_1,
+                          std::vector<UdimInfo>& udim_list)
+{
+    // Enumerate all the matching textures by looking at all files in the
+    // directory portion of the pattern, and seeing if they match a regex
+    // we derive from the non-directory part of the pattern.
+    std::vector<std::string> filenames;
     Filesystem::get_directory_entries(dirname, filenames, false /*recurse*/,
                                       pat);
 
     // Now we have all the matching filenames, and we need to associate
     // these with uv tile numbering, for which we again use the regex
     // pattern, and our prior knowledge of whether it's a 1-number or
-    // 2-number kind of pattern, to populate the lookup map.
-    std::vector<UdimInfo> udim_list;  // temporary -- we don't know extent
-    udim_list.reserve(100);
+    // 2-number kind of pattern.
+    udim_list.clear();
+    udim_list.reserve(filenames.size());
     std::regex decoder(pat);
     for (auto udim_tile_name : filenames) {
         std::string fnpart = Filesystem::filename(udim_tile_name);
@@ -3788,21 +6293,81 @@ ImageCacheFile::udim_setup()
                     v -= 1;
                 }
             }
-            if (u < 0 || v < 0)
+            if (u < 0 || v < 0 || u >= SHRT_MAX || v >= SHRT_MAX)
                 continue;  // invalid tile
             udim_list.emplace_back(ustring(udim_tile_name), nullptr, u, v);
-            m_udim_nutiles = std::max(m_udim_nutiles, short(u + 1));
-            m_udim_nvtiles = std::max(m_udim_nvtiles, short(v + 1));
         }
     }
+}
 
-    // Now that we have the inventory, we can reassemble the udim info into
-    // a simply indexed vector.
-    m_udim_lookup.clear();
-    m_udim_lookup.resize(int(m_udim_nutiles) * int(m_udim_nvtiles));
-    for (auto& ud : udim_list) {
-        m_udim_lookup[ud.v * m_udim_nutiles + ud.u] = ud;
+
+
+// A udim manifest is a line naming the pattern it inventories, followed
+// by a line "u v filename" for each tile, the filename being relative to
+// the manifest's own directory.
+static const char udim_manifest_magic[] = "# OIIO udim manifest 1";
+
+
+
+bool
+ImageCacheFile::udim_read_manifest(const std::string& manifest,
+                                   const std::string& dirname,
+                                   std::vector<UdimInfo>& udim_list)
+{
+    // Any change to the directory since the manifest was written (which
+    // is dated to match) means it may be out of date.
+    std::time_t when = Filesystem::last_write_time(manifest);
+    if (!when || Filesystem::last_write_time(dirname) > when)
+        return false;
+    std::string text;
+    if (!Filesystem::read_text_file(manifest, text))
+        return false;
+    auto lines = Strutil::splitsv(text, "\n");
+    if (lines.size() < 2 || lines[0] != udim_manifest_magic
+        || lines[1] != Filesystem::filename(m_filename))
+        return false;
+    udim_list.clear();
+    udim_list.reserve(lines.size() - 2);
+    for (size_t i = 2; i < lines.size(); ++i) {
+        string_view line = lines[i];
+        int u, v;
+        if (!Strutil::parse_int(line, u) || !Strutil::parse_int(line, v)
+            || u < 0 || v < 0 || u >= SHRT_MAX || v >= SHRT_MAX)
+            return false;
+        line = Strutil::strip(line);
+        if (line.empty())
+            return false;
+        udim_list.emplace_back(ustring::fmtformat("{}/{}", dirname, line),
+                               nullptr, u, v);
+    }
+    return true;
+}
+
+
+
+void
+ImageCacheFile::udim_write_manifest(const std::string& manifest,
+                                    const std::string& dirname,
+                                    const std::vector<UdimInfo>& udim_list)
+{
+    std::string text = Strutil::fmt::format("{}\n{}\n", udim_manifest_magic,
+                                            Filesystem::filename(m_filename));
+    for (auto& ud : udim_list)
+        text += Strutil::fmt::format("{} {} {}\n", ud.u, ud.v,
+                                     Filesystem::filename(ud.filename));
+    // Write under a temporary name and then rename, so that no reader ever
+    // sees a partial manifest. Failure (e.g., a read-only directory) just
+    // means that the next process scans the directory again.
+    std::string temp = Strutil::fmt::format("{}.{}.tmp", manifest,
+                                            Filesystem::unique_path());
+    if (!Filesystem::write_text_file(temp, text)
+        || !Filesystem::rename(temp, manifest)) {
+        Filesystem::remove(temp);
+        return;
     }
+    // Writing it changed the directory, too, so date the manifest to match
+    // the directory (which this doesn't change), rather than the clock.
+    Filesystem::last_write_time(manifest, Filesystem::last_write_time(dirname));
 }
 
 
@@ -3846,14 +6411,12 @@ ImageCacheImpl::resolve_udim(ImageCacheFile* udimfile, Perthread* thread_info,
     // files and filled in udimfile->udim_lookup. That vector, and the
     // filename fields, are set and can be accessed without locks. The
     // `ImageCacheFile*` within it, however, should use rw lock access.
-    int index = utile + vtile * udimfile->m_udim_nutiles;
-    OIIO_DASSERT(index >= 0 && size_t(index) < udimfile->m_udim_lookup.size());
+    int index = udimfile->m_udim_index[utile
+                                       + vtile * udimfile->m_udim_nutiles];
+    if (index < 0)
+        return nullptr;  // That tile is not populated
     UdimInfo& udiminfo(udimfile->m_udim_lookup[index]);
 
-    // An empty filename in the record means that tile is not populated.
-    if (udiminfo.filename.empty())
-        return nullptr;
-
     ImageCacheFile* realfile = udiminfo.icfile;
     if (!realfile) {
         realfile        = find_file(udiminfo.filename, thread_info);
@@ -3880,8 +6443,9 @@ ImageCacheImpl::inventory_udim(ImageCacheFile* udimfile, Perthread* thread_info,
     int n   = nutiles * nvtiles;
     filenames.resize(n);
     for (int i = 0; i < n; ++i) {
-        const UdimInfo& udiminfo(udimfile->m_udim_lookup[i]);
-        filenames[i] = udiminfo.filename;
+        int index    = udimfile->m_udim_index[i];
+        filenames[i] = index >= 0 ? udimfile->m_udim_lookup[index].filename
+                                  : ustring();
     }
 }
 
@@ -3892,6 +6456,8 @@ ImageCacheImpl::create_thread_info()
 {
     ImageCachePerThreadInfo* p = new ImageCachePerThreadInfo;
     // printf ("New perthread %p\n", (void *)p);
+    p->microcache.resize(m_microcache_size);
+    m_tilecache_lf.add_reader(&p->m_tilecache_reader);
     spin_lock lock(m_perthread_info_mutex);
     m_all_perthread_info.emplace_back(p);
     return p;
@@ -3907,6 +6473,7 @@ ImageCacheImpl::destroy_thread_info(ImageCachePerThreadInfo* thread_info)
     // the ImageCache owns the thread_infos associated with it,
     // so all we need to do is find the entry and reset the unique pointer
     // to fully destroy the object
+    m_tilecache_lf.remove_reader(&thread_info->m_tilecache_reader);
     spin_lock lock(m_perthread_info_mutex);
     for (auto& p : m_all_perthread_info) {
         if (p.get() == thread_info) {
@@ -3930,6 +6497,8 @@ ImageCacheImpl::get_perthread_info(ImageCachePerThreadInfo* p)
             // this thread doesn't have a ImageCachePerThreadInfo for this ImageCacheImpl yet
             ptr = p = new ImageCachePerThreadInfo;
             // printf ("New perthread %p\n", (void *)p);
+            p->microcache.resize(m_microcache_size);
+            m_tilecache_lf.add_reader(&p->m_tilecache_reader);
             spin_lock lock(m_perthread_info_mutex);
             m_all_perthread_info.emplace_back(p);
         }
@@ -3941,6 +6510,7 @@ ImageCacheImpl::get_perthread_info(ImageCachePerThreadInfo* p)
         p->lasttile = NULL;
         p->purge    = 0;
         p->m_thread_files.clear();
+        p->microcache.resize(m_microcache_size);
     }
     return p;
 }
@@ -4015,6 +6585,9 @@ ImageCacheImpl::heapsize() const
     for (TileCache::iterator t = m_tilecache.begin(), e = m_tilecache.end();
          t != e; ++t)
         size += footprint(t->first) + footprint(t->second);
+    m_tilecache_lf.for_each([&](ImageCacheTile* tile) {
+        size += footprint(tile->id()) + footprint(ImageCacheTileRef(tile));
+    });
     // files
     for (FilenameMap::iterator t = m_files.begin(), e = m_files.end(); t != e;
          ++t)
@@ -4044,10 +6617,14 @@ ImageCacheImpl::footprint(ImageCacheFootprint& output) const
     output.ic_thdi_mem   = heapsize(m_all_perthread_info);
 
     // tile cache
-    output.ic_tile_count = m_tilecache.size();
+    output.ic_tile_count = m_tilecache.size() + m_tilecache_lf.size();
     for (TileCache::iterator t = m_tilecache.begin(), e = m_tilecache.end();
          t != e; ++t)
         output.ic_tile_mem += footprint(t->first) + footprint(t->second);
+    m_tilecache_lf.for_each([&](ImageCacheTile* tile) {
+        output.ic_tile_mem += footprint(tile->id())
+                              + footprint(ImageCacheTileRef(tile));
+    });
 
     // finger prints; we only account for references, this map does not own the files.
     constexpr size_t sizeofFingerprintPair = sizeof(ustring)
@@ -4340,6 +6917,26 @@ ImageCache::get_thumbnail(ImageHandle* file, Perthread* thread_info,
 
 
 
+bool
+ImageCache::get_pixel_bounds(ustring filename, int subimage, int miplevel,
+                             ROI roi, span<float> min, span<float> max)
+{
+    return m_impl->get_pixel_bounds(filename, subimage, miplevel, roi, min,
+                                    max);
+}
+
+
+bool
+ImageCache::get_pixel_bounds(ImageHandle* file, Perthread* thread_info,
+                             int subimage, int miplevel, ROI roi,
+                             span<float> min, span<float> max)
+{
+    return m_impl->get_pixel_bounds(file, thread_info, subimage, miplevel, roi,
+                                    min, max);
+}
+
+
+
 bool
 ImageCache::get_pixels(ustring filename, int subimage, int miplevel, int xbegin,
                        int xend, int ybegin, int yend, int zbegin, int zend,
@@ -4391,6 +6988,30 @@ ImageCache::get_pixels(ImageHandle* file, Perthread* thread_info, int subimage,
 
 
 
+bool
+ImageCache::get_deep_pixels(ustring filename, int subimage, int miplevel,
+                            int xbegin, int xend, int ybegin, int yend,
+                            int zbegin, int zend, DeepData& result)
+{
+    return m_impl->get_deep_pixels(filename, subimage, miplevel, xbegin, xend,
+                                   ybegin, yend, zbegin, zend, result);
+}
+
+
+
+bool
+ImageCache::get_deep_pixels(ImageHandle* file, Perthread* thread_info,
+                            int subimage, int miplevel, int xbegin, int xend,
+                            int ybegin, int yend, int zbegin, int zend,
+                            DeepData& result)
+{
+    return m_impl->get_deep_pixels(file, thread_info, subimage, miplevel,
+                                   xbegin, xend, ybegin, yend, zbegin, zend,
+                                   result);
+}
+
+
+
 void
 ImageCache::invalidate(ustring filename, bool force)
 {
@@ -4453,6 +7074,24 @@ ImageCache::release_tile(Tile* tile) const
 
 
 
+bool
+ImageCache::prefetch_tiles(ustring filename, int subimage, int miplevel,
+                           ROI roi)
+{
+    return m_impl->prefetch_tiles(filename, subimage, miplevel, roi);
+}
+
+
+
+bool
+ImageCache::prefetch_tiles(ImageHandle* file, Perthread* thread_info,
+                           int subimage, int miplevel, ROI roi)
+{
+    return m_impl->prefetch_tiles(file, thread_info, subimage, miplevel, roi);
+}
+
+
+
 TypeDesc
 ImageCache::tile_format(const Tile* tile) const
 {
@@ -4486,6 +7125,15 @@ ImageCache::add_file(ustring filename, ImageInput::Creator creator,
 
 
 
+bool
+ImageCache::preload(cspan<ustring> filenames, ParamValueSpan options,
+                    std::vector<ustring>* broken)
+{
+    return m_impl->preload(filenames, options, broken);
+}
+
+
+
 bool
 ImageCache::add_tile(ustring filename, int subimage, int miplevel, int x, int y,
                      int z, int chbegin, int chend, TypeDesc format,
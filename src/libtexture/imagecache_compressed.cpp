@@ -0,0 +1,179 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <zlib.h>
+
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/thread.h>
+
+#include "imagecache_pvt.h"
+
+OIIO_NAMESPACE_BEGIN
+
+
+void
+CompressedTileCache::set_max_bytes(long long bytes)
+{
+    spin_lock lock(m_mutex);
+    m_max_bytes = std::max(bytes, 0LL);
+    trim();
+}
+
+
+
+size_t
+CompressedTileCache::size() const
+{
+    spin_lock lock(m_mutex);
+    return m_tiles.size();
+}
+
+
+
+bool
+CompressedTileCache::set_codec(string_view codec)
+{
+    string_view name = Strutil::parse_until(codec, ":");
+    int level        = 1;
+    if (Strutil::parse_char(codec, ':') && !Strutil::parse_int(codec, level))
+        return false;
+    if (name != "zip" || level < 1 || level > 9 || codec.size())
+        return false;
+    m_level = level;
+    return true;
+}
+
+
+
+std::string
+CompressedTileCache::codec() const
+{
+    int level = m_level;
+    return level == 1 ? std::string("zip")
+                      : Strutil::fmt::format("zip:{}", level);
+}
+
+
+
+bool
+CompressedTileCache::store(const TileID& id, const void* pixels, size_t size)
+{
+    if (!enabled())
+        return false;
+    // Compress without holding the lock. Tiles that don't shrink by at
+    // least a quarter aren't worth the memory or the decompression.
+    uLongf csize = compressBound(uLong(size));
+    std::unique_ptr<char[]> buf(new char[csize]);
+    if (compress2((Bytef*)buf.get(), &csize, (const Bytef*)pixels,
+                  uLong(size), m_level)
+            != Z_OK
+        || csize > size - size / 4)
+        return false;
+    Entry entry;
+    entry.data.reset(new char[csize]);
+    memcpy(entry.data.get(), buf.get(), csize);
+    entry.csize = csize;
+    entry.size  = size;
+
+    spin_lock lock(m_mutex);
+    auto found = m_tiles.find(id);
+    if (found != m_tiles.end()) {
+        m_bytes -= (long long)found->second.csize;
+        m_tiles.erase(found);
+    }
+    entry.serial = ++m_serial;
+    m_fifo.emplace_back(id, entry.serial);
+    m_bytes += (long long)csize;
+    m_tiles[id] = std::move(entry);
+    trim();
+    return true;
+}
+
+
+
+bool
+CompressedTileCache::fetch(const TileID& id, void* pixels, size_t size)
+{
+    Entry entry;
+    {
+        spin_lock lock(m_mutex);
+        auto found = m_tiles.find(id);
+        if (found == m_tiles.end())
+            return false;
+        entry = std::move(found.value());
+        m_tiles.erase(found);
+        m_bytes -= (long long)entry.csize;
+        // Its FIFO entry is left for trim() to skip; but don't let such
+        // leftovers pile up.
+        if (m_fifo.size() > 2 * m_tiles.size() + 64) {
+            m_fifo.erase(std::remove_if(m_fifo.begin(), m_fifo.end(),
+                                        [&](const auto& f) {
+                                            auto t = m_tiles.find(f.first);
+                                            return t == m_tiles.end()
+                                                   || t->second.serial
+                                                          != f.second;
+                                        }),
+                         m_fifo.end());
+        }
+    }
+    if (entry.size != size)
+        return false;
+    uLongf dsize = uLongf(size);
+    return uncompress((Bytef*)pixels, &dsize, (const Bytef*)entry.data.get(),
+                      uLong(entry.csize))
+               == Z_OK
+           && dsize == size;
+}
+
+
+
+void
+CompressedTileCache::erase(const ImageCacheFile* file)
+{
+    spin_lock lock(m_mutex);
+    for (auto t = m_tiles.begin(); t != m_tiles.end();) {
+        if (&t->first.file() == file) {
+            m_bytes -= (long long)t->second.csize;
+            t = m_tiles.erase(t);
+        } else {
+            ++t;
+        }
+    }
+}
+
+
+
+void
+CompressedTileCache::clear()
+{
+    spin_lock lock(m_mutex);
+    m_tiles.clear();
+    m_fifo.clear();
+    m_bytes = 0;
+}
+
+
+
+void
+CompressedTileCache::trim()
+{
+    while (m_bytes > m_max_bytes && !m_fifo.empty()) {
+        auto front = std::move(m_fifo.front());
+        m_fifo.pop_front();
+        auto found = m_tiles.find(front.first);
+        if (found != m_tiles.end() && found->second.serial == front.second) {
+            m_bytes -= (long long)found->second.csize;
+            m_tiles.erase(found);
+        }
+    }
+}
+
+OIIO_NAMESPACE_END
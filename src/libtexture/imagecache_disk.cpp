@@ -0,0 +1,234 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <OpenImageIO/color.h>
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/thread.h>
+
+#include "imagecache_pvt.h"
+
+OIIO_NAMESPACE_BEGIN
+
+namespace {  // anonymous
+
+// Each tile file is this header, then the key (so that a hash collision
+// can never return the wrong pixels), then the pixels.
+struct DiskTileHeader {
+    char magic[8];
+    uint64_t keylen;
+    uint64_t size;
+};
+
+static const char disktile_magic[8] = { 'O', 'I', 'I', 'O',
+                                        't', 'i', 'l', '1' };
+
+}  // namespace
+
+
+
+bool
+DiskTileCache::set_directory(string_view dir)
+{
+    std::string d(dir);
+    if (d.size() && !Filesystem::is_directory(d)
+        && !Filesystem::create_directory(d)) {
+        d.clear();
+    }
+    {
+        spin_lock lock(m_mutex);
+        m_dir = d;
+    }
+    m_enabled = !d.empty();
+    if (d.size())
+        trim(d);  // Measure what's already there
+    return d.size() || dir.empty();
+}
+
+
+
+std::string
+DiskTileCache::directory() const
+{
+    spin_lock lock(m_mutex);
+    return m_dir;
+}
+
+
+
+std::string
+DiskTileCache::tile_key(const TileID& id, size_t size)
+{
+    const ImageCacheFile& file(id.file());
+    std::string filekey;
+    if (!file.fingerprint().empty())
+        filekey = file.fingerprint().string();
+    else if (file.mod_time() && !file.creator())
+        filekey = Strutil::fmt::format("{}@{}", file.filename(),
+                                       (long long)file.mod_time());
+    else
+        return {};  // e.g., an application buffer
+    // A color transform id is only the indices of two color spaces in this
+    // process's config, so the key names the spaces and the config's
+    // contents instead, for other processes (whose configs may differ) that
+    // share the tiles.
+    std::string transform;
+    if (int ctid = id.colortransformid(); ctid > 0) {
+        const ColorConfig& cc(ColorConfig::default_colorconfig());
+        const char* from = cc.getColorSpaceNameByIndex((ctid >> 16) - 1);
+        const char* to   = cc.getColorSpaceNameByIndex((ctid & 0xffff) - 1);
+        if (!from || !to)
+            return {};
+        transform = Strutil::fmt::format("{}>{}@{}", from, to, cc.cacheid());
+    }
+    const ImageSpec& spec(file.spec(id.subimage(), id.miplevel()));
+    return Strutil::fmt::format("{}|{}|{}|{},{},{}|{}-{}|{}|{}|{}x{}x{}|{}|{}",
+                                filekey, id.subimage(), id.miplevel(), id.x(),
+                                id.y(), id.z(), id.chbegin(), id.chend(),
+                                transform,
+                                file.datatype(id.subimage()), spec.tile_width,
+                                spec.tile_height, spec.tile_depth,
+                                int(file.imagecache().unassociatedalpha()),
+                                size);
+}
+
+
+
+std::string
+DiskTileCache::tile_path(string_view dir, string_view key)
+{
+    // Spread the tiles over 256 subdirectories to keep each one small.
+    std::string hash = Strutil::fmt::format("{:016x}", Strutil::strhash64(key));
+    return Strutil::fmt::format("{}/{}/{}.tile", dir, hash.substr(0, 2),
+                                hash);
+}
+
+
+
+bool
+DiskTileCache::read(const TileID& id, void* pixels, size_t size)
+{
+    std::string dir = directory();
+    std::string key = tile_key(id, size);
+    if (dir.empty() || key.empty())
+        return false;
+    std::string path = tile_path(dir, key);
+    FILE* f          = Filesystem::fopen(path, "rb");
+    if (!f)
+        return false;
+    DiskTileHeader header;
+    std::string filekey(key.size(), '\0');
+    bool ok = fread(&header, sizeof(header), 1, f) == 1
+              && !memcmp(header.magic, disktile_magic, sizeof(header.magic))
+              && header.keylen == key.size() && header.size == size
+              && fread(&filekey[0], 1, key.size(), f) == key.size()
+              && filekey == key && fread(pixels, 1, size, f) == size;
+    fclose(f);
+    // Mark it recently used, so that trim() deletes it last.
+    if (ok)
+        Filesystem::last_write_time(path, std::time(nullptr));
+    return ok;
+}
+
+
+
+void
+DiskTileCache::write(const TileID& id, const void* pixels, size_t size)
+{
+    std::string dir = directory();
+    std::string key = tile_key(id, size);
+    if (dir.empty() || key.empty())
+        return;
+    std::string path   = tile_path(dir, key);
+    std::string subdir = Filesystem::parent_path(path);
+    if (!Filesystem::is_directory(subdir)
+        && !Filesystem::create_directory(subdir))
+        return;
+    // Write under a temporary name and then rename, so that no reader (in
+    // this or another process) ever sees a partially written tile.
+    std::string temp = Strutil::fmt::format("{}.{}.tmp", path,
+                                            Filesystem::unique_path());
+    FILE* f          = Filesystem::fopen(temp, "wb");
+    if (!f)
+        return;
+    DiskTileHeader header;
+    memcpy(header.magic, disktile_magic, sizeof(header.magic));
+    header.keylen = key.size();
+    header.size   = size;
+    bool ok       = fwrite(&header, sizeof(header), 1, f) == 1
+              && fwrite(key.data(), 1, key.size(), f) == key.size()
+              && fwrite(pixels, 1, size, f) == size;
+    ok &= (fclose(f) == 0);
+    if (!ok || !Filesystem::rename(temp, path)) {
+        Filesystem::remove(temp);
+        return;
+    }
+    m_bytes += (long long)(sizeof(header) + key.size() + size);
+    if (m_bytes > m_max_bytes)
+        trim(dir);
+}
+
+
+
+void
+DiskTileCache::trim(const std::string& dir)
+{
+    // If another thread is already trimming, leave it to them.
+    if (!m_trim_mutex.try_lock())
+        return;
+    m_bytes = trim_cache_directory(dir, "\\.tile$", m_max_bytes);
+    m_trim_mutex.unlock();
+}
+
+
+
+long long
+trim_cache_directory(const std::string& dir, string_view pattern,
+                     long long max_bytes)
+{
+    struct Entry {
+        std::time_t time;
+        uint64_t size;
+        std::string path;
+    };
+    std::vector<std::string> files;
+    Filesystem::get_directory_entries(dir, files, true /*recursive*/,
+                                      std::string(pattern));
+    std::vector<Entry> entries;
+    entries.reserve(files.size());
+    long long total = 0;
+    for (auto& path : files) {
+        uint64_t size = Filesystem::file_size(path);
+        if (size == uint64_t(-1))
+            continue;  // Somebody else deleted it
+        entries.push_back({ Filesystem::last_write_time(path), size, path });
+        total += (long long)size;
+    }
+
+    // Delete least recently used files until we're comfortably under the
+    // limit, so that we don't end up doing this on every write.
+    long long target = max_bytes - max_bytes / 10;
+    if (total > max_bytes) {
+        std::sort(entries.begin(), entries.end(),
+                  [](const Entry& a, const Entry& b) { return a.time < b.time; });
+        for (const Entry& e : entries) {
+            if (total <= target)
+                break;
+            if (Filesystem::remove(e.path))
+                total -= (long long)e.size;
+        }
+    }
+    return total;
+}
+
+OIIO_NAMESPACE_END
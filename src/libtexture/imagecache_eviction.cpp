@@ -0,0 +1,349 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+
+#include <tsl/robin_map.h>
+
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/thread.h>
+
+#include "imagecache_pvt.h"
+
+OIIO_NAMESPACE_BEGIN
+
+namespace {  // anonymous
+
+
+// FIFO history of tiles that were recently evicted ("ghosts"), keeping
+// only their IDs and sizes, so that a policy can recognize a miss on a
+// tile it should not have let go.
+class GhostList {
+public:
+    size_t bytes() const { return m_bytes; }
+
+    void push(const TileID& id, size_t size)
+    {
+        take(id);
+        m_map[id] = Entry { ++m_serial, size };
+        m_fifo.emplace_back(id, m_serial);
+        m_bytes += size;
+    }
+
+    // If id is in the history, remove it and return true.
+    bool take(const TileID& id)
+    {
+        auto found = m_map.find(id);
+        if (found == m_map.end())
+            return false;
+        m_bytes -= found->second.size;
+        m_map.erase(found);
+        // Entries taken out of the middle stay in the FIFO until popped;
+        // compact it if they start to dominate.
+        if (m_fifo.size() > 2 * m_map.size() + 64)
+            compact();
+        return true;
+    }
+
+    // Forget the oldest entry, returning its size (0 if empty).
+    size_t pop_oldest()
+    {
+        while (!m_fifo.empty()) {
+            auto front = std::move(m_fifo.front());
+            m_fifo.pop_front();
+            auto found = m_map.find(front.first);
+            if (found != m_map.end() && found->second.serial == front.second) {
+                size_t size = found->second.size;
+                m_bytes -= size;
+                m_map.erase(found);
+                return size;
+            }
+        }
+        return 0;
+    }
+
+    void clear()
+    {
+        m_map.clear();
+        m_fifo.clear();
+        m_bytes = 0;
+    }
+
+private:
+    struct Entry {
+        uint64_t serial;
+        size_t size;
+    };
+
+    void compact()
+    {
+        std::deque<std::pair<TileID, uint64_t>> fifo;
+        for (auto& f : m_fifo) {
+            auto found = m_map.find(f.first);
+            if (found != m_map.end() && found->second.serial == f.second)
+                fifo.push_back(f);
+        }
+        m_fifo.swap(fifo);
+    }
+
+    tsl::robin_map<TileID, Entry, TileID::Hasher> m_map;
+    std::deque<std::pair<TileID, uint64_t>> m_fifo;
+    uint64_t m_serial = 0;
+    size_t m_bytes    = 0;
+};
+
+
+
+// The original policy: a tile survives the sweep if it has been used since
+// the clock hand last passed it.
+class ClockPolicy final : public TileEvictionPolicy {
+public:
+    const char* name() const override { return "clock"; }
+
+    bool evict(ImageCacheTile* tile, ImageCacheStatistics& stats) override
+    {
+        if (tile->release())
+            return false;
+        ++stats.tile_evictions;
+        return true;
+    }
+};
+
+
+
+// CLOCK-Pro (Jiang, Chen & Zhang, 2005). New tiles start "cold" and are
+// freed the first time the hand finds them unused, but a cold tile that is
+// used again before the hand comes around becomes "hot". Hot tiles are
+// never freed directly; unused ones are demoted to cold only while the hot
+// set is over its target size. Evicted cold tiles are remembered for a
+// while, and a miss on one of them brings it back as hot and shifts the
+// target in favor of cold tiles, since evidently they deserved more room.
+class ClockProPolicy final : public TileEvictionPolicy {
+public:
+    explicit ClockProPolicy(const atomic_ll& max_memory_bytes)
+        : m_capacity(max_memory_bytes)
+    {
+    }
+
+    const char* name() const override { return "clockpro"; }
+
+    void inserted(ImageCacheTile* tile, ImageCacheStatistics& stats) override
+    {
+        tile->release();  // Being read doesn't count as being reused
+        size_t size = tile->memsize();
+        spin_lock lock(m_mutex);
+        if (m_nonresident.take(tile->id())) {
+            // Re-referenced within its test period: it should be hot, and
+            // the cold set was too small to catch it.
+            ++stats.tile_ghost_hits;
+            m_cold_target = std::min(m_cold_target + (long long)size,
+                                     max_cold_target());
+            tile->eviction_state() = Hot;
+            m_hot_bytes += size;
+        } else {
+            tile->eviction_state() = Cold;
+        }
+    }
+
+    bool evict(ImageCacheTile* tile, ImageCacheStatistics& stats) override
+    {
+        spin_lock lock(m_mutex);
+        int state = tile->eviction_state();
+        if (state == Unknown)
+            return false;  // Not finished being added
+        bool used   = tile->release();
+        size_t size = tile->memsize();
+        if (state == Hot) {
+            if (!used && m_hot_bytes > hot_target()) {
+                tile->eviction_state() = Cold;
+                m_hot_bytes -= size;
+            }
+            return false;
+        }
+        if (used) {
+            ++stats.tile_promotions;
+            tile->eviction_state() = Hot;
+            m_hot_bytes += size;
+            return false;
+        }
+        // An unused cold tile is evicted, but remembered so that we notice
+        // if it is needed again soon. Once it ages out of the history
+        // without having been missed, cold tiles needed less room.
+        tile->eviction_state() = Unknown;
+        ++stats.tile_evictions;
+        m_nonresident.push(tile->id(), size);
+        while (m_nonresident.bytes() > (size_t)capacity())
+            m_cold_target = std::max(m_cold_target
+                                         - (long long)m_nonresident.pop_oldest(),
+                                     min_cold_target());
+        return true;
+    }
+
+    void removed(ImageCacheTile* tile) override
+    {
+        spin_lock lock(m_mutex);
+        if (tile->eviction_state() == Hot)
+            m_hot_bytes -= tile->memsize();
+        tile->eviction_state() = Unknown;
+    }
+
+    void clear() override
+    {
+        spin_lock lock(m_mutex);
+        m_nonresident.clear();
+        m_hot_bytes   = 0;
+        m_cold_target = capacity() / 4;
+    }
+
+private:
+    enum State { Unknown = 0, Cold, Hot };
+
+    long long capacity() const { return m_capacity; }
+    long long min_cold_target() const { return capacity() / 16; }
+    long long max_cold_target() const { return capacity() - capacity() / 16; }
+    long long hot_target() const { return capacity() - m_cold_target; }
+
+    const atomic_ll& m_capacity;
+    spin_mutex m_mutex;  ///< Protects everything below
+    GhostList m_nonresident;
+    long long m_hot_bytes   = 0;
+    long long m_cold_target = m_capacity / 4;
+};
+
+
+
+// ARC (Megiddo & Modha, 2003), in its clock form CAR (Bansal & Modha,
+// 2004), which unlike true ARC needs no list reordering -- and therefore
+// no lock -- on a cache hit. Tiles used once live in T1 and tiles used
+// more than once in T2; ghost histories B1 and B2 remember what each
+// recently evicted, and a miss on one of them moves the T1 target size `p`
+// toward whichever list would have kept that tile.
+class ArcPolicy final : public TileEvictionPolicy {
+public:
+    explicit ArcPolicy(const atomic_ll& max_memory_bytes)
+        : m_capacity(max_memory_bytes)
+    {
+    }
+
+    const char* name() const override { return "arc"; }
+
+    void inserted(ImageCacheTile* tile, ImageCacheStatistics& stats) override
+    {
+        tile->release();  // Being read doesn't count as being reused
+        long long size = tile->memsize();
+        long long c    = m_capacity;
+        spin_lock lock(m_mutex);
+        double b1 = double(m_b1.bytes()), b2 = double(m_b2.bytes());
+        if (m_b1.take(tile->id())) {
+            ++stats.tile_ghost_hits;
+            m_p = std::min(c, m_p + (long long)(size * std::max(1.0, b2 / b1)));
+            tile->eviction_state() = T2;
+            m_t2_bytes += size;
+        } else if (m_b2.take(tile->id())) {
+            ++stats.tile_ghost_hits;
+            m_p = std::max(0LL,
+                           m_p - (long long)(size * std::max(1.0, b1 / b2)));
+            tile->eviction_state() = T2;
+            m_t2_bytes += size;
+        } else {
+            tile->eviction_state() = T1;
+            m_t1_bytes += size;
+        }
+        // Keep the histories from outgrowing the cache itself.
+        while (m_t1_bytes + (long long)m_b1.bytes() > c && m_b1.pop_oldest())
+            ;
+        while (m_t1_bytes + m_t2_bytes
+                   + (long long)(m_b1.bytes() + m_b2.bytes())
+               > 2 * c
+               && m_b2.pop_oldest())
+            ;
+    }
+
+    bool evict(ImageCacheTile* tile, ImageCacheStatistics& stats) override
+    {
+        spin_lock lock(m_mutex);
+        int state = tile->eviction_state();
+        if (state == Unknown)
+            return false;  // Not finished being added
+        bool used      = tile->release();
+        long long size = tile->memsize();
+        // Replace from T1 while it is over its target, otherwise from T2.
+        bool from_t1 = m_t1_bytes > 0 && m_t1_bytes >= std::max(m_p, 1LL);
+        if (state == T1) {
+            if (used) {
+                ++stats.tile_promotions;
+                tile->eviction_state() = T2;
+                m_t1_bytes -= size;
+                m_t2_bytes += size;
+                return false;
+            }
+            if (!from_t1)
+                return false;
+            m_t1_bytes -= size;
+            m_b1.push(tile->id(), size);
+        } else {
+            if (used || from_t1)
+                return false;
+            m_t2_bytes -= size;
+            m_b2.push(tile->id(), size);
+        }
+        tile->eviction_state() = Unknown;
+        ++stats.tile_evictions;
+        return true;
+    }
+
+    void removed(ImageCacheTile* tile) override
+    {
+        spin_lock lock(m_mutex);
+        int state = tile->eviction_state();
+        if (state == T1)
+            m_t1_bytes -= tile->memsize();
+        else if (state == T2)
+            m_t2_bytes -= tile->memsize();
+        tile->eviction_state() = Unknown;
+    }
+
+    void clear() override
+    {
+        spin_lock lock(m_mutex);
+        m_b1.clear();
+        m_b2.clear();
+        m_t1_bytes = 0;
+        m_t2_bytes = 0;
+        m_p        = 0;
+    }
+
+private:
+    enum State { Unknown = 0, T1, T2 };
+
+    const atomic_ll& m_capacity;
+    spin_mutex m_mutex;  ///< Protects everything below
+    GhostList m_b1, m_b2;
+    long long m_t1_bytes = 0;
+    long long m_t2_bytes = 0;
+    long long m_p        = 0;  ///< Target size of T1
+};
+
+}  // namespace
+
+
+
+std::unique_ptr<TileEvictionPolicy>
+TileEvictionPolicy::create(string_view name, const atomic_ll& max_memory_bytes)
+{
+    if (name == "clock")
+        return std::unique_ptr<TileEvictionPolicy>(new ClockPolicy);
+    if (name == "clockpro")
+        return std::unique_ptr<TileEvictionPolicy>(
+            new ClockProPolicy(max_memory_bytes));
+    if (name == "arc")
+        return std::unique_ptr<TileEvictionPolicy>(
+            new ArcPolicy(max_memory_bytes));
+    return {};
+}
+
+OIIO_NAMESPACE_END
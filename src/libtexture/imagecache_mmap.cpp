@@ -0,0 +1,394 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/platform.h>
+#include <OpenImageIO/strutil.h>
+
+#include "../otx.imageio/otx_pvt.h"
+#include "imagecache_pvt.h"
+
+OIIO_NAMESPACE_BEGIN
+
+namespace {  // anonymous
+
+// The TIFF tags that decide whether a directory's tiles can be used as is.
+enum TiffTag {
+    TAG_ImageWidth      = 256,
+    TAG_ImageLength     = 257,
+    TAG_BitsPerSample   = 258,
+    TAG_Compression     = 259,
+    TAG_Photometric     = 262,
+    TAG_SamplesPerPixel = 277,
+    TAG_PlanarConfig    = 284,
+    TAG_TileWidth       = 322,
+    TAG_TileLength      = 323,
+    TAG_TileOffsets     = 324,
+    TAG_TileByteCounts  = 325,
+    TAG_ExtraSamples    = 338,
+    TAG_SampleFormat    = 339,
+    TAG_TileDepth       = 32998,
+};
+
+// Directories beyond this many are not indexed (nor their tiles mapped).
+static const int max_directories = 1024;
+
+
+
+// Bounds-checked reading of the TIFF structure out of the mapping, which
+// must be in the host byte order.
+class TiffParser {
+public:
+    TiffParser(const char* base, size_t size, bool bigtiff)
+        : m_base(base)
+        , m_size(size)
+        , m_bigtiff(bigtiff)
+    {
+    }
+
+    bool in_bounds(uint64_t offset, uint64_t bytes) const
+    {
+        return offset <= m_size && bytes <= m_size - offset;
+    }
+
+    template<typename T> T get(uint64_t offset) const
+    {
+        T val = 0;
+        if (in_bounds(offset, sizeof(T)))
+            memcpy(&val, m_base + offset, sizeof(T));
+        return val;
+    }
+
+    uint64_t offset_at(uint64_t offset) const
+    {
+        return m_bigtiff ? get<uint64_t>(offset) : get<uint32_t>(offset);
+    }
+
+    // Read the value(s) of the directory entry at `entry`, which may be
+    // BYTE, SHORT, LONG, or LONG8, into `vals`. Return false if the entry
+    // is of another type or runs off the end of the file.
+    bool values(uint64_t entry, std::vector<uint64_t>& vals) const
+    {
+        int type       = get<uint16_t>(entry + 2);
+        uint64_t count = m_bigtiff ? get<uint64_t>(entry + 4)
+                                   : get<uint32_t>(entry + 4);
+        int size       = type == 1    ? 1
+                         : type == 3  ? 2
+                         : type == 4  ? 4
+                         : type == 16 ? 8
+                                      : 0;
+        if (!size || !count || count > m_size / size)
+            return false;
+        // Values that fit are stored in the entry itself.
+        uint64_t data = entry + (m_bigtiff ? 12 : 8);
+        if (count * size > (m_bigtiff ? 8u : 4u))
+            data = offset_at(data);
+        if (!in_bounds(data, count * size))
+            return false;
+        vals.resize(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t v = data + i * size;
+            vals[i]    = size == 1   ? get<uint8_t>(v)
+                         : size == 2 ? get<uint16_t>(v)
+                         : size == 4 ? get<uint32_t>(v)
+                                     : get<uint64_t>(v);
+        }
+        return true;
+    }
+
+private:
+    const char* m_base;
+    size_t m_size;
+    bool m_bigtiff;
+};
+
+
+
+// The type that the TIFF reader delivers for these samples, or UNKNOWN.
+static TypeDesc
+tiff_sample_type(uint64_t bits, uint64_t sampleformat)
+{
+    if (sampleformat == 1)
+        return bits == 8    ? TypeUInt8
+               : bits == 16 ? TypeUInt16
+               : bits == 32 ? TypeUInt32
+                            : TypeUnknown;
+    if (sampleformat == 2)
+        return bits == 8    ? TypeInt8
+               : bits == 16 ? TypeInt16
+               : bits == 32 ? TypeInt32
+                            : TypeUnknown;
+    if (sampleformat == 3)
+        return bits == 16   ? TypeHalf
+               : bits == 32 ? TypeFloat
+               : bits == 64 ? TypeDesc(TypeDesc::DOUBLE)
+                            : TypeUnknown;
+    return TypeUnknown;
+}
+
+}  // namespace
+
+
+
+std::shared_ptr<const MappedTileFile>
+MappedTileFile::open(const std::string& filename)
+{
+    std::shared_ptr<MappedTileFile> mapped(new MappedTileFile);
+#ifdef _WIN32
+    HANDLE file = CreateFileW(Strutil::utf8_to_utf16wstring(filename).c_str(),
+                              GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return {};
+    LARGE_INTEGER size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0,
+                                     nullptr);
+    if (mapping) {
+        mapped->m_base = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0,
+                                                    0, 0);
+        mapped->m_size = size_t(size.QuadPart);
+        // The view keeps the file mapped after the handles are closed.
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return {};
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* base = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED,
+                          fd, 0);
+        if (base != MAP_FAILED) {
+            mapped->m_base = (const char*)base;
+            mapped->m_size = size_t(st.st_size);
+        }
+    }
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+#endif
+    if (!mapped->m_base || !mapped->parse())
+        return {};  // The destructor unmaps it
+    return mapped;
+}
+
+
+
+MappedTileFile::~MappedTileFile()
+{
+    if (!m_base)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(m_base);
+#else
+    munmap((void*)m_base, m_size);
+#endif
+}
+
+
+
+bool
+MappedTileFile::parse()
+{
+    if (m_size >= sizeof(otx_pvt::Header)
+        && !memcmp(m_base, otx_pvt::magic, sizeof(otx_pvt::magic)))
+        return parse_otx();
+
+    // Only a file in the host byte order can be used without swapping.
+    if (m_size < 16 || memcmp(m_base, littleendian() ? "II" : "MM", 2))
+        return false;
+    uint16_t magic;
+    memcpy(&magic, m_base + 2, sizeof(magic));
+    if (magic != 42 && magic != 43)
+        return false;
+    bool bigtiff = (magic == 43);
+    TiffParser tiff(m_base, m_size, bigtiff);
+    if (bigtiff && tiff.get<uint16_t>(4) != 8)
+        return false;
+    size_t entrysize = bigtiff ? 20 : 12;
+
+    bool any = false;
+    std::vector<uint64_t> vals;
+    uint64_t ifd = tiff.offset_at(bigtiff ? 8 : 4);
+    while (ifd && int(m_dirs.size()) < max_directories) {
+        uint64_t nentries = bigtiff ? tiff.get<uint64_t>(ifd)
+                                    : tiff.get<uint16_t>(ifd);
+        uint64_t first    = ifd + (bigtiff ? 8 : 2);
+        if (!nentries || nentries > m_size / entrysize
+            || !tiff.in_bounds(first, nentries * entrysize))
+            break;
+        // Defaults for tags that need not be present
+        uint64_t compression = 1, planar = 1, bits = 1, sampleformat = 1;
+        uint64_t photometric = 0, depth = 1;
+        std::vector<uint64_t> offsets, bytecounts, extrasamples;
+        Directory dir;
+        bool ok = true;
+        for (uint64_t e = 0; e < nentries; ++e) {
+            uint64_t entry = first + e * entrysize;
+            int tag        = tiff.get<uint16_t>(entry);
+            if (tag == TAG_TileOffsets)
+                ok &= tiff.values(entry, offsets);
+            else if (tag == TAG_TileByteCounts)
+                ok &= tiff.values(entry, bytecounts);
+            else if (tag == TAG_ExtraSamples)
+                ok &= tiff.values(entry, extrasamples);
+            else if (tag == TAG_ImageWidth || tag == TAG_ImageLength
+                     || tag == TAG_BitsPerSample || tag == TAG_Compression
+                     || tag == TAG_Photometric || tag == TAG_SamplesPerPixel
+                     || tag == TAG_PlanarConfig || tag == TAG_TileWidth
+                     || tag == TAG_TileLength || tag == TAG_SampleFormat
+                     || tag == TAG_TileDepth) {
+                if (!tiff.values(entry, vals)) {
+                    ok = false;
+                    continue;
+                }
+                // Per-sample values must all be the same to be usable.
+                for (auto v : vals)
+                    ok &= (v == vals[0]);
+                uint64_t v = vals[0];
+                switch (tag) {
+                case TAG_ImageWidth: dir.width = int(v); break;
+                case TAG_ImageLength: dir.height = int(v); break;
+                case TAG_BitsPerSample: bits = v; break;
+                case TAG_Compression: compression = v; break;
+                case TAG_Photometric: photometric = v; break;
+                case TAG_SamplesPerPixel: dir.nchannels = int(v); break;
+                case TAG_PlanarConfig: planar = v; break;
+                case TAG_TileWidth: dir.tile_width = int(v); break;
+                case TAG_TileLength: dir.tile_height = int(v); break;
+                case TAG_SampleFormat: sampleformat = v; break;
+                case TAG_TileDepth: depth = v; break;
+                }
+            }
+        }
+        for (auto e : extrasamples)
+            dir.unassociated_alpha |= (e == 2);
+        dir.format = tiff_sample_type(bits, sampleformat);
+
+        // The TIFF reader hands over uncompressed, contiguous, grayscale or
+        // RGB pixels unchanged (multi-byte ones only in the host byte
+        // order, which we checked above); anything else it must convert.
+        imagesize_t tilebytes = imagesize_t(dir.tile_width) * dir.tile_height
+                                * dir.nchannels * dir.format.size();
+        int nxtiles = dir.tile_width > 0
+                          ? (dir.width + dir.tile_width - 1) / dir.tile_width
+                          : 0;
+        int nytiles = dir.tile_height > 0
+                          ? (dir.height + dir.tile_height - 1)
+                                / dir.tile_height
+                          : 0;
+        ok &= compression == 1 && planar == 1 && depth == 1
+              && (photometric == 1 || photometric == 2) && dir.width > 0
+              && dir.height > 0 && dir.tile_width > 0 && dir.tile_height > 0
+              && dir.nchannels > 0 && dir.format != TypeUnknown
+              && offsets.size() == size_t(nxtiles) * size_t(nytiles)
+              && bytecounts.size() == offsets.size();
+        for (size_t t = 0; ok && t < offsets.size(); ++t) {
+            // Each tile must also be aligned for its channel type, and
+            // leave room for a SIMD load past its end.
+            ok = bytecounts[t] == tilebytes
+                 && offsets[t] % dir.format.size() == 0
+                 && tiff.in_bounds(offsets[t],
+                                   tilebytes + OIIO_SIMD_MAX_SIZE_BYTES);
+        }
+        if (ok) {
+            dir.offsets.swap(offsets);
+            any = true;
+        }
+        m_dirs.push_back(std::move(dir));
+        ifd = tiff.offset_at(first + nentries * entrysize);
+    }
+    return any;
+}
+
+
+
+bool
+MappedTileFile::parse_otx()
+{
+    using namespace otx_pvt;
+    Header header;
+    bool swab;
+    memcpy(&header, m_base, sizeof(header));
+    if (!valid_header(header, swab) || swab || header.version != version
+        || header.directory > m_size
+        || header.nlevels > (m_size - header.directory) / sizeof(LevelRecord))
+        return false;
+
+    // The levels are in the order the OTX reader presents them, so they
+    // are numbered like TIFF directories: subimages in order, each one's
+    // MIP levels in order.
+    bool any = false;
+    for (uint32_t i = 0; i < header.nlevels && i < max_directories; ++i) {
+        LevelRecord rec;
+        memcpy(&rec, m_base + header.directory + i * sizeof(rec), sizeof(rec));
+        Directory dir;
+        if (rec.valid() && rec.tiles <= m_size
+            && rec.ntiles <= (m_size - rec.tiles) / sizeof(TileEntry)) {
+            dir.width       = rec.width;
+            dir.height      = rec.height;
+            dir.tile_width  = rec.tile_width;
+            dir.tile_height = rec.tile_height;
+            dir.nchannels   = rec.nchannels;
+            dir.format      = rec.format();
+            // Only uncompressed tiles can be used; the rest stay 0.
+            dir.offsets.resize(size_t(rec.ntiles), 0);
+            for (size_t t = 0; t < dir.offsets.size(); ++t) {
+                TileEntry entry;
+                memcpy(&entry, m_base + rec.tiles + t * sizeof(entry),
+                       sizeof(entry));
+                if (entry.offset && !(entry.flags & tile_zlib)
+                    && entry.bytes == rec.tile_bytes
+                    && entry.offset % dir.format.size() == 0
+                    && entry.offset <= m_size
+                    && rec.tile_bytes + OIIO_SIMD_MAX_SIZE_BYTES
+                           <= m_size - entry.offset) {
+                    dir.offsets[t] = entry.offset;
+                    any            = true;
+                }
+            }
+        }
+        m_dirs.push_back(std::move(dir));
+    }
+    return any;
+}
+
+
+
+const char*
+MappedTileFile::tile(int dir, const ImageSpec& spec, TypeDesc format,
+                     bool unassociatedalpha, int tile) const
+{
+    if (dir < 0 || dir >= int(m_dirs.size()))
+        return nullptr;
+    const Directory& d(m_dirs[dir]);
+    // The reader would associate the alpha unless asked not to.
+    if (d.offsets.empty() || (d.unassociated_alpha && !unassociatedalpha)
+        || d.width != spec.width || d.height != spec.height
+        || d.tile_width != spec.tile_width
+        || d.tile_height != spec.tile_height || d.nchannels != spec.nchannels
+        || d.format != format || tile < 0 || tile >= int(d.offsets.size())
+        || !d.offsets[tile])
+        return nullptr;
+    return m_base + d.offsets[tile];
+}
+
+OIIO_NAMESPACE_END
@@ -10,18 +10,36 @@
 #ifndef OPENIMAGEIO_IMAGECACHE_PVT_H
 #define OPENIMAGEIO_IMAGECACHE_PVT_H
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
 #include <tsl/robin_map.h>
 
 #include <OpenImageIO/Imath.h>
+#include <OpenImageIO/deepdata.h>
 #include <OpenImageIO/export.h>
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/function_view.h>
 #include <OpenImageIO/hash.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/memory.h>
+#include <OpenImageIO/metrics.h>
 #include <OpenImageIO/refcnt.h>
 #include <OpenImageIO/texture.h>
 #include <OpenImageIO/timer.h>
 #include <OpenImageIO/unordered_map_concurrent.h>
 
+#include "imageio_pvt.h"
+
 
 OIIO_NAMESPACE_BEGIN
 
@@ -43,6 +61,7 @@ OIIO_NAMESPACE_BEGIN
 
 struct TileID;
 class ImageCacheImpl;
+class MappedTileFile;
 struct ImageCacheFootprint;
 
 namespace pvt {
@@ -66,6 +85,8 @@ struct ImageCacheStatistics {
     long long find_tile_calls;
     long long find_tile_microcache_misses;
     int find_tile_cache_misses;
+    long long microcache_set_hits;    // Found in a thread's TileMicroCache
+    long long microcache_set_misses;  // Not found there either
     long long files_totalsize;
     long long files_totalsize_ondisk;
     long long bytes_read;
@@ -84,6 +105,28 @@ struct ImageCacheStatistics {
     double tile_locking_time;
     double find_file_time;
     double find_tile_time;
+    long long tile_evictions;   // Tiles freed by the eviction policy
+    long long tile_promotions;  // Tiles moved to the policy's frequent set
+    long long tile_ghost_hits;  // Misses on tiles the policy recently freed
+    long long diskcache_hits;
+    long long diskcache_misses;
+    long long sharedcache_hits;
+    long long sharedcache_misses;
+    long long tileserver_hits;
+    long long tileserver_misses;
+    long long tiles_prefetched;
+    long long coalesced_reads;  // Reads of several tiles at once
+    long long coalesced_tiles;  // Tiles read by those reads
+    long long numa_copies;      // Tiles copied from another NUMA node
+    long long tiles_mapped;     // Tiles used in place in mapped files
+    long long tiles_constant;   // Constant tiles filled without reading
+    long long compressed_hits;    // Misses satisfied by the compressed tier
+    long long compressed_stores;  // Evicted tiles kept in that tier
+    double compress_time;
+    double decompress_time;
+    long long tiles_colortransformed;  // Tiles given a color transform
+    long long colortransform_copies;   // ... made from cached tiles
+    double colortransform_time;
 
     // TextureSystem-specific fields below:
     long long texture_queries;
@@ -101,6 +144,7 @@ struct ImageCacheStatistics {
     long long closest_interps;
     long long bilinear_interps;
     long long cubic_interps;
+    long long approximate_lookups;  // Nonblocking lookups from coarser MIPs
     int file_retry_success;
     int tile_retry_success;
 
@@ -148,6 +192,48 @@ struct UdimInfo {
 
 
 
+/// IOProxy through which an ImageCacheFile's ImageInput reads the file,
+/// for formats that read their pixels on demand. To stay within the
+/// cache's max_open_files, its file handle can be closed (suspend()) while
+/// the ImageInput it serves stays open, with the header and tile offsets
+/// it already read, so that using it again only needs the file reopened,
+/// which happens on the next read.
+class ImageCacheFileProxy final : public Filesystem::IOProxy {
+public:
+    ImageCacheFileProxy(ImageCacheImpl& imagecache, string_view filename);
+    ~ImageCacheFileProxy() override;
+    const char* proxytype() const override { return "imagecache"; }
+    size_t read(void* buf, size_t size) override;
+    size_t pread(void* buf, size_t size, int64_t offset) override;
+    bool pread_many(span<ReadRequest> requests) override;
+    size_t size() const override { return m_size; }
+
+    /// Close the file handle, unless a read is using it right now.
+    /// Return true if it was closed. Only the ImageCacheImpl calls this,
+    /// holding its lock on its list of open proxies.
+    bool suspend();
+
+    /// Is the file handle closed?
+    bool suspended() const { return !m_handle_open; }
+
+    /// When was the file last read, on the cache's clock of reads?
+    int64_t last_use() const { return m_last_use; }
+
+private:
+    ImageCacheImpl& m_imagecache;
+    std::unique_ptr<Filesystem::IOFile> m_file;  ///< Null when suspended
+    std::shared_mutex m_file_mutex;  ///< Shared by reads, exclusive to close
+    std::atomic<bool> m_handle_open { false };
+    std::atomic<int64_t> m_last_use { 0 };
+    size_t m_size = 0;
+
+    // Lock the open file for a read, reopening it if needed. Return false
+    // if it can't be reopened.
+    bool lock_for_read(std::shared_lock<std::shared_mutex>& lock);
+};
+
+
+
 /// Unique in-memory record for each image file on disk.  Note that
 /// this class is not in and of itself thread-safe.  It's critical that
 /// any calling routine use a mutex any time a ImageCacheFile's methods are
@@ -190,6 +276,11 @@ public:
         return levelinfo(subimage, miplevel).nativespec;
     }
     ustring filename(void) const { return m_filename; }
+    /// The name it was asked for by, before applying the search path.
+    ustring filename_original() const { return m_filename_original; }
+    /// The file the image comes from, which is filename() unless that is
+    /// a copy made by the RetileCache.
+    ustring source() const { return m_source; }
     ustring fileformat(void) const { return m_fileformat; }
     TexFormat textureformat() const { return m_texformat; }
     TextureOpt::Wrap swrap() const { return m_swrap; }
@@ -205,7 +296,30 @@ public:
     /// Load new data tile
     ///
     bool read_tile(ImageCachePerThreadInfo* thread_info, const TileID& id,
-                   void* data);
+                   void* data)
+    {
+        return read_tiles(thread_info, id, 1, data);
+    }
+
+    /// Load `ntiles` horizontally adjacent tiles, the first of which is
+    /// `first`, with a single read from the file, into `data` laid out as
+    /// one image `ntiles` tiles wide. Only ntiles == 1 is allowed for
+    /// untiled images or automatically generated MIP levels.
+    bool read_tiles(ImageCachePerThreadInfo* thread_info, const TileID& first,
+                    int ntiles, void* data);
+
+    /// Load the deep data tile `id` (of a deep subimage) into `deepdata`,
+    /// with one pixel for each of the tile's pixels that lie within the
+    /// image, in x, then y, then z order.
+    bool read_deep_tile(ImageCachePerThreadInfo* thread_info, const TileID& id,
+                        DeepData& deepdata);
+
+    /// For "mmap_tiles": if tile `id` is stored in the file exactly as the
+    /// cache would hold it, return a pointer to its pixels in the memory
+    /// mapped file, setting `mapping` to what keeps them valid. Otherwise
+    /// return nullptr, and the tile must be read as usual.
+    const char* mapped_tile(const TileID& id,
+                            std::shared_ptr<const MappedTileFile>& mapping);
 
     /// Mark the file as recently used.
     ///
@@ -213,7 +327,8 @@ public:
 
     /// Try to release resources for this file -- if recently used, mark
     /// as not recently used; if already not recently used, close the
-    /// file and return true.
+    /// file (or, if it reads through an ImageCacheFileProxy, just its
+    /// file handle).
     void release(void);
 
     size_t channelsize(int subimage) const
@@ -231,6 +346,8 @@ public:
     bool mipused(void) const { return m_mipused; }
     bool sample_border(void) const { return m_sample_border; }
     bool is_udim(void) const { return m_udim_nutiles != 0; }
+    /// Does any subimage hold deep data?
+    bool deep() const { return m_deep; }
     const std::vector<size_t>& mipreadcount(void) const
     {
         return m_mipreadcount;
@@ -269,6 +386,14 @@ public:
             // only specified if different from nativespec
         ImageSpec nativespec;  ///< Native ImageSpec for the mip level
         mutable std::unique_ptr<float[]> polecolor;  ///< Pole colors
+        /// Per-tile min, max, and average of each channel, from the
+        /// "oiio:TileStats" that maketx may write (else empty)
+        std::unique_ptr<float[]> tilestats;
+        /// Bitfield of the tiles that the reader says are empty, as
+        /// ImageInput::empty_tiles() returns them (else empty), and the
+        /// value of all their pixels, in the data type we store.
+        std::vector<uint64_t> emptytiles;
+        std::unique_ptr<char[]> emptypixel;
         atomic_ll* tiles_read;  ///< Bitfield for tiles read at least once
         int nxtiles, nytiles, nztiles;  ///< Number of tiles in each dimension
         bool full_pixel_range;  ///< pixel data window matches image window
@@ -286,6 +411,40 @@ public:
 
         ImageSpec& spec() { return m_spec ? *m_spec : nativespec; }
         const ImageSpec& spec() const { return m_spec ? *m_spec : nativespec; }
+
+        /// The tilestats of the tile at x,y, or nullptr if there are none.
+        const float* tile_stats(int x, int y) const
+        {
+            if (!tilestats)
+                return nullptr;
+            const ImageSpec& s(spec());
+            int t = (x - s.x) / s.tile_width
+                    + (y - s.y) / s.tile_height * nxtiles;
+            return &tilestats[size_t(t) * s.nchannels * 3];
+        }
+
+        /// The index of the tile containing pixel x,y,z, counting tiles
+        /// across rows, then rows down slices.
+        size_t tile_index(int x, int y, int z) const
+        {
+            const ImageSpec& s(spec());
+            return (size_t((z - s.z) / s.tile_depth) * nytiles
+                    + (y - s.y) / s.tile_height)
+                       * nxtiles
+                   + (x - s.x) / s.tile_width;
+        }
+
+        /// If the tile containing pixel x,y,z is one that the reader said
+        /// is empty, return the pixel (of all channels) that fills it,
+        /// else nullptr.
+        const char* empty_tile_pixel(int x, int y, int z) const
+        {
+            if (emptytiles.empty())
+                return nullptr;
+            size_t t = tile_index(x, y, z);
+            return (emptytiles[t / 64] >> (t % 64)) & 1 ? emptypixel.get()
+                                                        : nullptr;
+        }
     };
 
     /// Info for each subimage
@@ -299,6 +458,7 @@ public:
         bool unmipped            = false;  ///< Not really MIP-mapped
         bool volume              = false;  ///< It's a volume image
         bool autotiled           = false;  ///< We are autotiling this image
+        bool deep                = false;  ///< Deep data, in DeepData tiles
         bool full_pixel_range    = false;  ///< data window matches image window
         bool is_constant_image   = false;  ///< Is the image a constant color?
         bool has_average_color   = false;  ///< We have an average color
@@ -385,6 +545,7 @@ public:
 private:
     ustring m_filename_original;   ///< original filename before search path
     ustring m_filename;            ///< Filename
+    ustring m_source;              ///< Resolved, before any retiled copy
     bool m_used;                   ///< Recently used (in the LRU sense)
     bool m_broken;                 ///< has errors; can't be used properly
     bool m_allow_release = true;   ///< Allow the file to release()?
@@ -398,6 +559,13 @@ private:
         // access directly. ALWAYS retrieve its value with get_imageinput
         // (it's thread-safe to use that result) and set its value with
         // set_imageinput -- those are guaranteed thread-safe.
+#endif
+#if __cpp_lib_atomic_shared_ptr >= 201711L
+    // The proxy m_input reads through, if it has one
+    std::atomic<std::shared_ptr<ImageCacheFileProxy>> m_ioproxy;
+#else
+    std::shared_ptr<ImageCacheFileProxy> m_ioproxy;  ///< m_input's proxy
+        // Like m_input, only access it atomically.
 #endif
     std::vector<SubimageInfo> m_subimages;  ///< Info on each subimage
     TexFormat m_texformat;                  ///< Which texture format
@@ -407,6 +575,7 @@ private:
     EnvLayout m_envlayout;                  ///< env map: which layout?
     bool m_y_up;                  ///< latlong: is y "up"? (else z is up)
     bool m_sample_border;         ///< are edge samples exactly on the border?
+    bool m_deep = false;          ///< Does any subimage hold deep data?
     short m_udim_nutiles;         ///< Number of u tiles (0 if not a udim)
     short m_udim_nvtiles;         ///< Number of v tiles (0 if not a udim)
     ustring m_fileformat;         ///< File format name
@@ -431,8 +600,14 @@ private:
     imagesize_t m_total_imagesize_ondisk;  ///< Total size, compressed on disk
     ImageInput::Creator m_inputcreator;    ///< Custom ImageInput-creator
     std::unique_ptr<ImageSpec> m_configspec;  // Optional configuration hints
-    std::vector<UdimInfo> m_udim_lookup;      ///< Used for decoding udim tiles
+    std::vector<UdimInfo> m_udim_lookup;      ///< The udim tiles that exist
                                               /// protected by mutex elsewhere!
+    std::vector<int> m_udim_index;  ///< m_udim_lookup index of each u,v, or -1
+    double m_udim_setup_time = 0;  ///< Time spent finding the udim tiles
+    bool m_udim_from_manifest = false;  ///< Were they found in a manifest?
+    spin_mutex m_mapped_mutex;  ///< Protects m_mapped and m_mapped_tried
+    std::shared_ptr<const MappedTileFile> m_mapped;  ///< For "mmap_tiles"
+    bool m_mapped_tried = false;  ///< Has mapping the file been tried?
 
     // Thread-safe retrieve a shared pointer to the ImageInput (which may
     // not currently be open). The one returned is safe to use as long as
@@ -440,10 +615,16 @@ private:
     std::shared_ptr<ImageInput>
     get_imageinput(ImageCachePerThreadInfo* thread_info);
 
+    // Thread-safe retrieve a shared pointer to the proxy that the
+    // ImageInput reads through, which is empty if it has none.
+    std::shared_ptr<ImageCacheFileProxy> get_ioproxy();
+
     // Safely replace the existing ImageInput shared pointer with the one in
-    // newval. Ensure that the cache still knows how many open ImageInputs
-    // there are in total.
-    void set_imageinput(std::shared_ptr<ImageInput> newval);
+    // newval, which reads through `proxy` if it isn't empty. Ensure that
+    // the cache still knows how many open files there are in total (the
+    // proxies count their own).
+    void set_imageinput(std::shared_ptr<ImageInput> newval,
+                        std::shared_ptr<ImageCacheFileProxy> proxy = {});
 
     /// Retrieve a shared pointer to the file's open ImageInput (opening if
     /// necessary, and maintaining the limit on number of open files). For a
@@ -470,18 +651,41 @@ private:
     bool read_unmipped(ImageCachePerThreadInfo* thread_info, const TileID& id,
                        void* data);
 
+    /// Apply the color transform of id, if it has one, to the pixels just
+    /// read of ntiles of its tiles (width x height x depth in all, in the
+    /// file's data type, the channels of id, contiguous).
+    bool colortransform(ImageCachePerThreadInfo* thread_info, const TileID& id,
+                        int ntiles, int width, int height, int depth,
+                        void* data);
+
     // Initialize a bunch of fields based on the ImageSpec.
     // FIXME -- this is actually deeply flawed, many of these things only
     // make sense if they are per subimage, not one value for the whole
     // file. But it will require a bigger refactor to fix that.
     void init_from_spec();
 
+    // Set m_source by the search path, and m_filename to it or to its
+    // retiled copy if there is one.
+    void resolve();
+
     // Helper for ctr: evaluate udim information, including setting
     // m_udim_tiles.
     void udim_setup();
 
+    // Helpers for udim_setup: find the udim tiles in the directory of
+    // the pattern, or in its manifest ("udim_manifest").
+    void udim_scan(const std::string& dirname, const std::string& pat,
+                   bool udim1, bool udim2_1, std::vector<UdimInfo>& udims);
+    bool udim_read_manifest(const std::string& manifest,
+                            const std::string& dirname,
+                            std::vector<UdimInfo>& udims);
+    void udim_write_manifest(const std::string& manifest,
+                             const std::string& dirname,
+                             const std::vector<UdimInfo>& udims);
+
     friend class ImageCacheImpl;
     friend class TextureSystemImpl;
+    friend class ThumbnailCache;
     friend struct SubimageInfo;
 };
 
@@ -492,10 +696,13 @@ private:
 typedef intrusive_ptr<ImageCacheFile> ImageCacheFileRef;
 
 
-/// Map file names to file references
+/// Map file names to file references. A bin's lock is held while a new
+/// ImageCacheFile is made, which looks for the file on disk, so waiters for
+/// it sleep rather than spin.
 typedef unordered_map_concurrent<ustring, ImageCacheFileRef, std::hash<ustring>,
                                  std::equal_to<ustring>, FILE_CACHE_SHARDS,
-                                 tsl::robin_map<ustring, ImageCacheFileRef>>
+                                 tsl::robin_map<ustring, ImageCacheFileRef>,
+                                 adaptive_rw_mutex>
     FilenameMap;
 typedef tsl::robin_map<ustring, ImageCacheFileRef> FingerprintMap;
 
@@ -546,8 +753,11 @@ struct TileID {
     int chend() const { return m_chend; }
     int nchannels() const { return m_chend - m_chbegin; }
     int colortransformid() const { return m_colortransformid; }
+    /// NUMA node whose copy of the tile this is (see "numa_tiles").
+    int numa_node() const { return m_numa_node; }
 
     void x(int v) { m_x = v; }
+    void numa_node(int v) { m_numa_node = v; }
     void y(int v) { m_y = v; }
     void z(int v) { m_z = v; }
     void xy(int x, int y)
@@ -571,6 +781,18 @@ struct TileID {
     {
         // Try to speed up by comparing field by field in order of most
         // probable rejection if they really are unequal.
+        return (a.m_x == b.m_x && a.m_y == b.m_y && a.m_z == b.m_z
+                && a.m_subimage == b.m_subimage && a.m_miplevel == b.m_miplevel
+                && (a.m_file == b.m_file) && a.m_chbegin == b.m_chbegin
+                && a.m_chend == b.m_chend
+                && a.m_colortransformid == b.m_colortransformid
+                && a.m_numa_node == b.m_numa_node);
+    }
+
+    /// Are the two ID's for the same tile, though perhaps for copies of
+    /// it on different NUMA nodes?
+    friend bool same_tile(const TileID& a, const TileID& b)
+    {
         return (a.m_x == b.m_x && a.m_y == b.m_y && a.m_z == b.m_z
                 && a.m_subimage == b.m_subimage && a.m_miplevel == b.m_miplevel
                 && (a.m_file == b.m_file) && a.m_chbegin == b.m_chbegin
@@ -589,7 +811,7 @@ struct TileID {
         static constexpr size_t member_size
             = sizeof(m_x) + sizeof(m_y) + sizeof(m_z) + sizeof(m_subimage)
               + sizeof(m_miplevel) + sizeof(m_chbegin) + sizeof(m_chend)
-              + sizeof(m_colortransformid) + sizeof(m_padding) + sizeof(m_file);
+              + sizeof(m_colortransformid) + sizeof(m_numa_node) + sizeof(m_file);
         static_assert(
             sizeof(*this) == member_size,
             "All TileID members must be accounted for so we can hash the entire class.");
@@ -622,7 +844,7 @@ private:
     int m_miplevel;            ///< MIP-map level
     short m_chbegin, m_chend;  ///< Channel range
     int m_colortransformid;    ///< Colorspace id (0 == default)
-    int m_padding = 0;         ///< Unused
+    int m_numa_node = 0;       ///< NUMA node of this copy of the tile
     ImageCacheFile* m_file;    ///< Which ImageCacheFile we refer to
 };
 
@@ -647,9 +869,21 @@ public:
     /// constructed the tile.  Return true for success, false for failure.
     OIIO_NODISCARD bool read(ImageCachePerThreadInfo* thread_info);
 
+    /// Read the pixels of several new tiles that are horizontally adjacent,
+    /// in order, in the same file and level, with one read from the file.
+    /// Return true if all were read successfully.
+    OIIO_NODISCARD static bool
+    read_run(ImageCachePerThreadInfo* thread_info,
+             span<intrusive_ptr<ImageCacheTile>> tiles);
+
     /// Return pointer to the raw pixel data
     const void* data(void) const { return &m_pixels[0]; }
 
+    /// For a tile of a deep subimage, return its deep data (which has a
+    /// pixel for each of the tile's pixels within the image, in x, then y,
+    /// then z order), or nullptr for a tile of flat pixels.
+    const DeepData* deepdata() const { return m_deepdata.get(); }
+
     /// Return pointer to the pixel data for a particular pixel.  Be
     /// extremely sure the pixel is within this tile!
     const void* data(int x, int y, int z, int c) const;
@@ -706,6 +940,10 @@ public:
     ///
     int used(void) const { return m_used; }
 
+    /// Per-tile state private to the TileEvictionPolicy in use; zero until
+    /// the policy has seen the tile.
+    atomic_int& eviction_state() { return m_eviction_state; }
+
     bool valid(void) const { return m_valid; }
 
     /// Are the pixels ready for use?  If false, they're still being
@@ -733,16 +971,31 @@ public:
     }
 
 private:
+    // The parts of read() before and after the pixels come in: allocate
+    // m_pixels, returning its size; and record whether the read worked.
+    size_t allocate_pixels();
+    bool finish_read(bool ok);
+    // Point m_pixels at the tile in its memory mapped file, if possible.
+    bool map_pixels(ImageCachePerThreadInfo* thread_info);
+    // Fill the allocated pixels with the tile's color, if its file's tile
+    // statistics say it is constant.
+    bool fill_constant(ImageCachePerThreadInfo* thread_info);
+    // Read the tile of a deep subimage into m_deepdata.
+    bool read_deep(ImageCachePerThreadInfo* thread_info);
+
     TileID m_id;                       ///< ID of this tile
     std::unique_ptr<char[]> m_pixels;  ///< The pixel data
+    std::unique_ptr<DeepData> m_deepdata;  ///< Deep tiles: the deep data
     size_t m_pixels_size { 0 };        ///< How much m_pixels has allocated
     int m_channelsize { 0 };           ///< How big is each channel (bytes)
     int m_pixelsize { 0 };             ///< How big is each pixel (bytes)
     int m_tile_width { 0 };            ///< Tile width
     bool m_valid { false };            ///< Valid pixels
     bool m_nofree { false };  ///< We do NOT own the pixels, do not free!
+    std::shared_ptr<const MappedTileFile> m_mapping;  ///< Owns mapped pixels
     volatile bool m_pixels_ready { false };  // Pixels have been read from disk
     atomic_int m_used { 1 };                 ///< Used recently
+    atomic_int m_eviction_state { 0 };       ///< See eviction_state()
 };
 
 
@@ -753,6 +1006,48 @@ typedef intrusive_ptr<ImageCacheTile> ImageCacheTileRef;
 
 
 
+/// TileEvictionPolicy decides which tiles the "clock" sweep in
+/// ImageCacheImpl::check_max_mem frees when the cache is over its memory
+/// limit. It is chosen by name with the "eviction_policy" attribute:
+/// "clock" is the classic single reference bit, "clockpro" and "arc" are
+/// scan resistant, keeping tiles that are used repeatedly in preference
+/// to tiles that were only read once.
+///
+/// The sweep calls evict() under its own lock (and perhaps a lock of the
+/// tile cache), but inserted() and removed() may be called concurrently
+/// from any thread, so implementations must be thread-safe.
+class TileEvictionPolicy {
+public:
+    virtual ~TileEvictionPolicy() {}
+
+    virtual const char* name() const = 0;
+
+    /// `tile` was just added to the cache and its pixels read.
+    virtual void inserted(ImageCacheTile* /*tile*/,
+                          ImageCacheStatistics& /*stats*/)
+    {
+    }
+
+    /// The clock hand has reached `tile`. Return true if it should be
+    /// removed from the cache.
+    virtual bool evict(ImageCacheTile* tile, ImageCacheStatistics& stats) = 0;
+
+    /// `tile` was removed from the cache by something other than evict(),
+    /// such as invalidation.
+    virtual void removed(ImageCacheTile* /*tile*/) {}
+
+    /// Forget all history; the cache has been emptied.
+    virtual void clear() {}
+
+    /// Create the named policy, which will size its bookkeeping relative
+    /// to the cache limit `max_memory_bytes`. Return an empty pointer if
+    /// the name is not known.
+    static std::unique_ptr<TileEvictionPolicy>
+    create(string_view name, const atomic_ll& max_memory_bytes);
+};
+
+
+
 /// Hash table that maps TileID to ImageCacheTileRef -- this is the type of the
 /// main tile cache.
 typedef unordered_map_concurrent<
@@ -762,6 +1057,320 @@ typedef unordered_map_concurrent<
 
 
 
+/// LockFreeTileCache is an alternative to TileCache, selected with the
+/// "tilecache_impl" attribute, whose lookups take no locks at all. It is
+/// split into TILE_CACHE_SHARDS shards by hash, each an open-addressed
+/// (linear probing) table of atomic tile pointers. Insertions and erasures
+/// lock only their shard. A lookup instead announces the current epoch in
+/// its thread's Reader while it probes; tiles that are erased and tables
+/// that are outgrown are retired, and only released once every announced
+/// epoch is newer than the retirement, so a concurrent lookup never sees a
+/// dangling pointer.
+class LockFreeTileCache {
+public:
+    /// Epoch announcement for one thread doing lookups. Each thread that
+    /// calls retrieve() must pass its own Reader, registered with
+    /// add_reader() and kept alive until remove_reader().
+    struct Reader {
+        std::atomic<uint64_t> epoch { 0 };  ///< Nonzero only during lookup
+    };
+
+    /// Position of the "clock hand" used by sweep().
+    struct SweepPos {
+        size_t shard = 0;
+        size_t slot  = 0;
+    };
+
+    LockFreeTileCache() {}
+    ~LockFreeTileCache();
+    LockFreeTileCache(const LockFreeTileCache&)            = delete;
+    LockFreeTileCache& operator=(const LockFreeTileCache&) = delete;
+
+    void add_reader(Reader* reader);
+    void remove_reader(Reader* reader);
+
+    /// Look up the tile with the given id, without locking. If found,
+    /// store a reference to it in `tile` and return true.
+    bool retrieve(const TileID& id, ImageCacheTileRef& tile,
+                  Reader* reader) const
+    {
+        size_t hash        = id.hash();
+        const Shard& shard = m_shards[hash % TILE_CACHE_SHARDS];
+        reader->epoch.store(m_epoch.load(std::memory_order_relaxed),
+                            std::memory_order_relaxed);
+        // Order the epoch announcement before any load of the table, to
+        // pair with the fence in retire().
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        ImageCacheTile* found = nullptr;
+        if (const Table* t = shard.table.load(std::memory_order_acquire))
+            found = find(t, id, hash);
+        if (found)
+            tile = found;
+        reader->epoch.store(0, std::memory_order_release);
+        return found != nullptr;
+    }
+
+    /// Is the tile with the given id in the cache? Takes the shard lock.
+    bool contains(const TileID& id) const;
+
+    /// If tile->id() is not yet in the cache, add `tile` and return true.
+    /// Otherwise, replace `tile` with the one already in the cache and
+    /// return false.
+    bool insert_retrieve(ImageCacheTileRef& tile);
+
+    /// Remove the tile with the given id, returning true if it was found.
+    bool erase(const TileID& id);
+
+    /// Remove all tiles.
+    void clear();
+
+    size_t size() const { return m_size.load(std::memory_order_relaxed); }
+    bool empty() const { return size() == 0; }
+
+    /// Call f(ImageCacheTile*) for every tile in the cache, locking one
+    /// shard at a time.
+    template<class F> void for_each(F&& f) const
+    {
+        for (const Shard& shard : m_shards) {
+            spin_lock lock(shard.mutex);
+            if (const Table* t = shard.table.load(std::memory_order_relaxed))
+                for (size_t i = 0; i <= t->mask; ++i) {
+                    ImageCacheTile* p = t->slots[i].tile.load(
+                        std::memory_order_relaxed);
+                    if (live(p))
+                        f(p);
+                }
+        }
+    }
+
+    /// Advance the clock hand `pos` to the next tile, and erase that tile
+    /// if `evict(tile)` returns true. Return false, leaving `pos` reset to
+    /// the start, if there were no more tiles past `pos`.
+    bool sweep(SweepPos& pos, function_view<bool(ImageCacheTile*)> evict);
+
+private:
+    // A slot holds its own reference to the tile. The hash is stored
+    // alongside so that most mismatched probes need not touch the tile.
+    struct Slot {
+        atomic<ImageCacheTile*> tile { nullptr };
+        atomic<size_t> hash { 0 };
+    };
+    struct Table {
+        explicit Table(size_t capacity)
+            : mask(capacity - 1)
+            , slots(new Slot[capacity])
+        {
+        }
+        size_t mask;  ///< capacity-1, capacity is a power of 2
+        std::unique_ptr<Slot[]> slots;
+    };
+    struct alignas(OIIO_CACHE_LINE_SIZE) Shard {
+        mutable spin_mutex mutex;  ///< Held by writers only
+        atomic<Table*> table { nullptr };
+        size_t live = 0;  ///< Slots holding a tile
+        size_t used = 0;  ///< Slots holding a tile or a tombstone
+    };
+
+    // Marks a slot whose tile was erased, so probing continues past it.
+    static ImageCacheTile* tombstone()
+    {
+        return reinterpret_cast<ImageCacheTile*>(uintptr_t(1));
+    }
+    static bool live(const ImageCacheTile* p)
+    {
+        return p != nullptr && p != tombstone();
+    }
+    static size_t probe_start(const Table* t, size_t hash)
+    {
+        // The low bits of the hash already chose the shard.
+        return (hash / TILE_CACHE_SHARDS) & t->mask;
+    }
+    static ImageCacheTile* find(const Table* t, const TileID& id, size_t hash)
+    {
+        for (size_t i = probe_start(t, hash), n = 0; n <= t->mask;
+             i = (i + 1) & t->mask, ++n) {
+            ImageCacheTile* p = t->slots[i].tile.load(std::memory_order_acquire);
+            if (!p)
+                break;
+            if (p != tombstone()
+                && t->slots[i].hash.load(std::memory_order_relaxed) == hash
+                && p->id() == id)
+                return p;
+        }
+        return nullptr;
+    }
+
+    // Index of the slot holding id, or -1. The shard lock must be held.
+    static int64_t find_index(const Table* t, const TileID& id, size_t hash);
+    // Remove the tile in slot i of the shard's table t. The shard lock
+    // must be held.
+    void erase_slot(Shard& shard, Table* t, size_t i);
+    // Make room in the shard's table, which must be locked.
+    Table* grow(Shard& shard);
+    void retire(ImageCacheTileRef&& tile);
+    void retire(std::unique_ptr<Table>&& table);
+    // Release whatever retired items no reader can still see.
+    void reclaim();
+
+    Shard m_shards[TILE_CACHE_SHARDS];
+    atomic<size_t> m_size { 0 };
+    atomic<uint64_t> m_epoch { 1 };
+    spin_mutex m_retire_mutex;  ///< Protects all of the following
+    std::vector<Reader*> m_readers;
+    std::vector<std::pair<uint64_t, ImageCacheTileRef>> m_retired_tiles;
+    std::vector<std::pair<uint64_t, std::unique_ptr<Table>>> m_retired_tables;
+};
+
+
+
+/// TileMicroCache is a small set-associative cache of tile references,
+/// owned by a single thread, that ImageCacheImpl::find_tile consults after
+/// the thread's last two tiles and before the shared cache; it catches
+/// access patterns that cycle among more than two tiles, as when shading
+/// alternates among several textures. Each set keeps its tiles in most
+/// recently used order. It is not thread-safe, nor does it need to be.
+class TileMicroCache {
+public:
+    static constexpr int ways = 4;  ///< Tiles per set
+
+    /// Hold up to `entries` tiles (rounded up to a power of two number of
+    /// sets), dropping everything; 0 disables it.
+    void resize(int entries)
+    {
+        m_nsets = 0;
+        if (entries > 0) {
+            m_nsets = 1;
+            while (m_nsets * ways < entries)
+                m_nsets *= 2;
+        }
+        m_slots.clear();
+        m_slots.resize(size_t(m_nsets) * ways);
+    }
+    int size() const { return m_nsets * ways; }
+    bool enabled() const { return m_nsets != 0; }
+    void clear()
+    {
+        for (auto& t : m_slots)
+            t.reset();
+    }
+
+    /// If we have tile `id`, move it out of this cache into `tile` and
+    /// return true.
+    bool take(const TileID& id, ImageCacheTileRef& tile)
+    {
+        ImageCacheTileRef* set = &m_slots[set_index(id) * ways];
+        for (int i = 0; i < ways && set[i]; ++i) {
+            if (same_tile(set[i]->id(), id)) {
+                tile = std::move(set[i]);
+                // Close the gap, keeping the rest in order
+                for (; i < ways - 1; ++i)
+                    set[i] = std::move(set[i + 1]);
+                set[ways - 1].reset();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Add a tile as the most recently used in its set, dropping that
+    /// set's least recently used one if it is full.
+    void insert(ImageCacheTileRef&& tile)
+    {
+        ImageCacheTileRef* set = &m_slots[set_index(tile->id()) * ways];
+        for (int i = ways - 1; i > 0; --i)
+            set[i] = std::move(set[i - 1]);
+        set[0] = std::move(tile);
+    }
+
+private:
+    // Which set a tile goes in. This deliberately ignores the NUMA node,
+    // which, as for the rest of the microcache, is not part of a request.
+    size_t set_index(const TileID& id) const
+    {
+        uint64_t h = uint64_t(uintptr_t(id.file_ptr()) >> 4)
+                     ^ (uint64_t(uint32_t(id.x())) * 0x9e3779b97f4a7c15ULL)
+                     ^ (uint64_t(uint32_t(id.y())) * 0xc2b2ae3d27d4eb4fULL)
+                     ^ (uint64_t(uint32_t(id.z())) * 0x165667b19e3779f9ULL)
+                     ^ (uint64_t(id.miplevel()) << 20)
+                     ^ (uint64_t(id.subimage()) << 26)
+                     ^ (uint64_t(id.chbegin()) << 32);
+        h ^= h >> 29;
+        return size_t(h) & size_t(m_nsets - 1);
+    }
+
+    std::vector<ImageCacheTileRef> m_slots;  ///< m_nsets sets of `ways`
+    int m_nsets = 0;
+};
+
+
+
+/// Texture lookup statistics for one file, gathered per thread when the
+/// "statistics:per_file" attribute is set, and merged for getstats().
+struct FileLookupStats {
+    static const int max_miplevels = 16;  ///< Deeper levels count as last
+
+    long long lookups     = 0;  ///< Texture lookups
+    long long probes      = 0;  ///< Sample points, summed over MIP levels
+    long long magnified   = 0;  ///< Lookups finer than the finest level
+    double lookup_time    = 0;  ///< Total time in the lookups...
+    double find_tile_time = 0;  ///< ...of which was spent finding tiles
+    /// Number of lookups that sampled each MIP level
+    long long miplevels[max_miplevels] = {};
+
+    /// Record that a lookup sampled MIP level `level` with `nprobes`
+    /// probes.
+    void add_level(int level, int nprobes)
+    {
+        ++miplevels[std::min(level, max_miplevels - 1)];
+        probes += nprobes;
+    }
+
+    void merge(const FileLookupStats& s)
+    {
+        lookups += s.lookups;
+        probes += s.probes;
+        magnified += s.magnified;
+        for (int i = 0; i < max_miplevels; ++i)
+            miplevels[i] += s.miplevels[i];
+        lookup_time += s.lookup_time;
+        find_tile_time += s.find_tile_time;
+    }
+};
+
+
+
+/// The tiles of one MIP level of a file that a thread's texture lookups
+/// touched, for the TextureSystem's "tile_feedback": bit `i % 64` of word
+/// `i / 64` for tile `i`. Only the owning thread sets bits, so that needs no
+/// atomic read-modify-write, but any thread may read or clear them.
+struct TileFeedbackBits {
+    explicit TileFeedbackBits(size_t ntiles)
+        : ntiles(ntiles)
+        , words(new std::atomic<uint64_t>[(ntiles + 63) / 64])
+    {
+        for (size_t i = 0, n = (ntiles + 63) / 64; i < n; ++i)
+            words[i].store(0, std::memory_order_relaxed);
+    }
+
+    void set(size_t tile)
+    {
+        if (tile >= ntiles)
+            return;
+        std::atomic<uint64_t>& w(words[tile / 64]);
+        uint64_t bit  = uint64_t(1) << (tile % 64);
+        uint64_t bits = w.load(std::memory_order_relaxed);
+        // A clear that races with this may be undone, which only ever
+        // reports a tile as touched once more.
+        if (!(bits & bit))
+            w.store(bits | bit, std::memory_order_relaxed);
+    }
+
+    size_t ntiles;
+    std::unique_ptr<std::atomic<uint64_t>[]> words;
+};
+
+
+
 /// A very small amount of per-thread data that saves us from locking
 /// the mutex quite as often.  We store things here used by both
 /// ImageCache and TextureSystem, so they don't each need a costly
@@ -778,8 +1387,37 @@ public:
 
     // We have a two-tile "microcache", storing the last two tiles needed.
     ImageCacheTileRef tile, lasttile;
+    // Behind those, an optional bigger one ("microcache_size").
+    TileMicroCache microcache;
     atomic_int purge;  // If set, tile ptrs need purging!
     ImageCacheStatistics m_stats;
+    // This thread's lookups in a LockFreeTileCache.
+    LockFreeTileCache::Reader m_tilecache_reader;
+    // With "statistics:per_file", lookup statistics for each file, and
+    // those of the file being looked up right now (else nullptr). Only
+    // this thread changes the map, but getstats() may read it, so
+    // insertions (which may move the entries) hold the mutex.
+    using FileStatsMap = tsl::robin_map<const ImageCacheFile*, FileLookupStats>;
+    FileStatsMap m_file_stats;
+    spin_mutex m_file_stats_mutex;
+    FileLookupStats* m_lookup_stats = nullptr;
+    // For TextureOpt::nonblocking lookups: while m_nonblocking is set,
+    // find_tile_nonblocking() queues tiles that aren't resident rather
+    // than waiting for them, noting the coarsest such MIP level in
+    // m_nonresident_level, and the lookups use no MIP level finer than
+    // m_min_miplevel.
+    bool m_nonblocking      = false;
+    int m_nonresident_level = -1;
+    int m_min_miplevel      = 0;
+    // With the TextureSystem's "tile_feedback", the tiles touched in each
+    // (file, subimage, MIP level), and the one touched last. Only this
+    // thread adds levels, holding the mutex, so that merging may read them.
+    using TileFeedbackKey = std::tuple<const ImageCacheFile*, int, int>;
+    using TileFeedbackMap = std::map<TileFeedbackKey, TileFeedbackBits>;
+    TileFeedbackMap m_tile_feedback;
+    spin_mutex m_tile_feedback_mutex;
+    TileFeedbackBits* m_last_feedback = nullptr;
+    TileFeedbackKey m_last_feedback_key;
 
     ImageCachePerThreadInfo()
     {
@@ -805,16 +1443,661 @@ public:
         return f == m_thread_files.end() ? nullptr : f->second;
     }
 
+    // Find (or add) the tile feedback bits of a file's MIP level, which
+    // has `ntiles` tiles.
+    TileFeedbackBits& tile_feedback(const ImageCacheFile* file, int subimage,
+                                    int miplevel, size_t ntiles)
+    {
+        TileFeedbackKey key(file, subimage, miplevel);
+        if (m_last_feedback && m_last_feedback_key == key)
+            return *m_last_feedback;
+        auto f = m_tile_feedback.find(key);
+        if (f == m_tile_feedback.end()) {
+            spin_lock lock(m_tile_feedback_mutex);
+            f = m_tile_feedback.try_emplace(key, ntiles).first;
+        }
+        m_last_feedback_key = key;
+        m_last_feedback     = &f->second;
+        return f->second;
+    }
+
+    // Find (or add) the lookup statistics for a file.
+    FileLookupStats& file_stats(const ImageCacheFile* file)
+    {
+        auto f = m_file_stats.find(file);
+        if (f != m_file_stats.end())
+            return f.value();
+        spin_lock lock(m_file_stats_mutex);
+        return m_file_stats[file];
+    }
+
     size_t heapsize() const
     {
         /// TODO: this should take into account the two last tiles, if their refcount is zero.
         constexpr size_t sizeofPair = sizeof(ustring) + sizeof(ImageCacheFile*);
-        return m_thread_files.size() * sizeofPair;
+        return m_thread_files.size() * sizeofPair
+               + microcache.size() * sizeof(ImageCacheTileRef)
+               + m_file_stats.size()
+                     * (sizeof(ImageCacheFile*) + sizeof(FileLookupStats));
     }
 };
 
 
 
+/// While in scope, attributes a texture lookup to its file, if
+/// "statistics:per_file" is set: counts it, times it, and lets the
+/// lookup record what it sampled in thread_info->m_lookup_stats.
+class FileLookupScope {
+public:
+    FileLookupScope(ImageCachePerThreadInfo* thread_info,
+                    const ImageCacheFile* file, bool enabled)
+        : m_thread_info(thread_info)
+    {
+        if (OIIO_LIKELY(!enabled))
+            return;
+        m_stats = &thread_info->file_stats(file);
+        ++m_stats->lookups;
+        thread_info->m_lookup_stats = m_stats;
+        m_timer.start();
+    }
+    ~FileLookupScope()
+    {
+        if (m_stats) {
+            m_stats->lookup_time += m_timer();
+            m_thread_info->m_lookup_stats = nullptr;
+        }
+    }
+
+private:
+    ImageCachePerThreadInfo* m_thread_info;
+    FileLookupStats* m_stats = nullptr;
+    Timer m_timer { Timer::DontStartNow };
+};
+
+
+
+/// DiskTileCache is an optional second level below the in-memory tile
+/// cache, enabled with the "diskcache_dir" attribute: a local directory of
+/// tiles that were already read and decoded into the cache's pixel format.
+/// A main cache miss on a tile found there -- put there earlier by this or
+/// any other process -- costs one local file read instead of rereading and
+/// decompressing the original image. Tiles are keyed by the image's
+/// fingerprint if it has one (otherwise by its name and modification
+/// time) plus everything in the TileID -- a color transform by the names
+/// of its color spaces and the OCIO config's cache ID, since the transform
+/// id's indices mean different spaces to a process with a different
+/// config -- and the directory is held under "diskcache_max_MB" by
+/// deleting the least recently used tiles.
+class DiskTileCache {
+public:
+    DiskTileCache() {}
+    DiskTileCache(const DiskTileCache&)            = delete;
+    DiskTileCache& operator=(const DiskTileCache&) = delete;
+
+    /// Use the directory `dir`, creating it if necessary, or disable the
+    /// cache if `dir` is empty. Return false if the directory is unusable.
+    bool set_directory(string_view dir);
+    std::string directory() const;
+    bool enabled() const { return m_enabled; }
+
+    void set_max_bytes(long long bytes) { m_max_bytes = bytes; }
+    long long max_bytes() const { return m_max_bytes; }
+
+    /// Fill pixels[0..size-1] with the cached copy of tile `id`, returning
+    /// true if there was one.
+    bool read(const TileID& id, void* pixels, size_t size);
+
+    /// Save size bytes of decoded pixels of tile `id` for later read().
+    void write(const TileID& id, const void* pixels, size_t size);
+
+    /// Describe everything that determines the pixels of the tile, or
+    /// return an empty string if the tile can't be identified across
+    /// processes and so must not be cached. (Also used by SharedTileCache.)
+    static std::string tile_key(const TileID& id, size_t size);
+
+private:
+    static std::string tile_path(string_view dir, string_view key);
+    // Delete the oldest tiles until the directory is within budget.
+    void trim(const std::string& dir);
+
+    mutable spin_mutex m_mutex;  ///< Protects m_dir
+    std::string m_dir;
+    std::atomic<bool> m_enabled { false };
+    atomic_ll m_max_bytes { 10LL * 1024 * 1024 * 1024 };
+    atomic_ll m_bytes { 0 };  ///< Estimated size of the directory
+    spin_mutex m_trim_mutex;  ///< Ensure only one thread in trim()
+};
+
+
+
+/// FileChangeWatcher, enabled with the "watch_files" attribute, asks the
+/// OS to report changes to the directories of the cache's files (inotify,
+/// on Linux), so that invalidate_all() can look at just the files that
+/// changed rather than checking every file's modification time. Where
+/// notifications aren't available, enable() fails and invalidate_all()
+/// checks them all, as always.
+class FileChangeWatcher {
+public:
+    FileChangeWatcher() {}
+    FileChangeWatcher(const FileChangeWatcher&)            = delete;
+    FileChangeWatcher& operator=(const FileChangeWatcher&) = delete;
+    ~FileChangeWatcher() { enable(false); }
+
+    /// Start or stop watching. Return false if notifications can't be
+    /// had on this platform.
+    bool enable(bool on);
+    bool enabled() const { return m_enabled; }
+
+    /// Watch for changes to `filename`, the resolved name of the cache's
+    /// file `name`.
+    void watch(ustring name, ustring filename);
+
+    /// Make the next changes() report that every file must be checked,
+    /// e.g. because settings that they depend on have changed.
+    void rescan();
+
+    /// Add to `changed` the cache's files that were modified, replaced, or
+    /// removed since the last call, and to `unwatched` the files whose
+    /// directories couldn't be watched. Return false if changes may have
+    /// been missed (the event queue overflowed, or a directory itself was
+    /// moved or removed), in which case every file must be checked.
+    bool changes(std::vector<ustring>& changed,
+                 std::vector<ustring>& unwatched);
+
+private:
+    // Watch the directory of filename, returning false if we can't.
+    bool watch_dir(const std::string& dir);
+
+    std::mutex m_mutex;
+    std::atomic<bool> m_enabled { false };
+    int m_fd      = -1;     ///< The notification queue
+    bool m_missed = false;  ///< Have changes been missed?
+    /// Watched directories (each the prefix of its files' names, up to
+    /// and including the last slash) and their watch descriptors.
+    std::unordered_map<std::string, int> m_dirs;
+    std::unordered_map<int, std::string> m_watches;
+    /// The cache's files (by resolved name) that are being watched.
+    std::unordered_multimap<ustring, ustring> m_names;
+    std::unordered_set<ustring> m_unwatched;
+};
+
+
+
+/// CompressedTileCache is an optional tier between the tile cache and the
+/// files, enabled by setting "compressed_max_MB": tiles freed by the
+/// eviction policy are kept here compressed (with zlib), and a later miss
+/// on one of them costs a decompression rather than a read and decode
+/// from the file. fetch() moves a tile back out, so that a tile is never
+/// held in both tiers at once, and the oldest tiles are dropped first when
+/// the tier is over its budget.
+class CompressedTileCache {
+public:
+    CompressedTileCache() {}
+    CompressedTileCache(const CompressedTileCache&)            = delete;
+    CompressedTileCache& operator=(const CompressedTileCache&) = delete;
+
+    bool enabled() const { return m_max_bytes > 0; }
+    void set_max_bytes(long long bytes);
+    long long max_bytes() const { return m_max_bytes; }
+    /// Total size of the compressed tiles currently held.
+    long long bytes() const { return m_bytes; }
+    size_t size() const;
+
+    /// Choose the compression: "zip", or "zip:N" for zlib level N, 1
+    /// (fastest, the default) to 9 (smallest). Return false if unknown.
+    bool set_codec(string_view codec);
+    std::string codec() const;
+
+    /// Keep a compressed copy of size bytes of pixels of tile `id`. Return
+    /// false if it wasn't kept, e.g. because it didn't compress enough to
+    /// be worth the trouble.
+    bool store(const TileID& id, const void* pixels, size_t size);
+
+    /// If a copy of tile `id` is held, decompress it into
+    /// pixels[0..size-1], drop it from this tier, and return true.
+    bool fetch(const TileID& id, void* pixels, size_t size);
+
+    /// Drop all tiles of one file, or all tiles.
+    void erase(const ImageCacheFile* file);
+    void clear();
+
+private:
+    struct Entry {
+        std::unique_ptr<char[]> data;
+        size_t csize;   ///< Compressed size
+        size_t size;    ///< Uncompressed size
+        uint64_t serial;
+    };
+    // Drop the oldest tiles until within budget. Requires m_mutex.
+    void trim();
+
+    mutable spin_mutex m_mutex;  ///< Protects everything below
+    tsl::robin_map<TileID, Entry, TileID::Hasher> m_tiles;
+    std::deque<std::pair<TileID, uint64_t>> m_fifo;  ///< Oldest first
+    uint64_t m_serial = 0;
+    atomic_ll m_bytes { 0 };
+    atomic_ll m_max_bytes { 0 };
+    std::atomic<int> m_level { 1 };
+};
+
+
+
+/// SharedTileCache is an optional tier shared by all the processes on a
+/// machine that attach to the same "sharedcache_name": a POSIX shared
+/// memory segment (a named file mapping on Windows) of fixed-size slots of
+/// decoded tiles, keyed just as DiskTileCache keys them. A tile that any
+/// of the processes reads from its file is stored there, and a main cache
+/// miss in any of them on a tile found there costs only a copy. A tile can
+/// only go in the small set of slots that its key hashes to, so that the
+/// index is just the slots themselves, and each set has its own lock and
+/// CLOCK hand in the segment. The locks are only tried for a bounded time,
+/// so that a process that dies holding one can't hang the others.
+class SharedTileCache {
+public:
+    SharedTileCache() {}
+    SharedTileCache(const SharedTileCache&)            = delete;
+    SharedTileCache& operator=(const SharedTileCache&) = delete;
+
+    /// Attach to the segment `name`, first creating it with room for
+    /// max_bytes() of tiles if no process has yet, or detach if `name` is
+    /// empty. Return false if the segment can't be created or used.
+    bool set_name(string_view name);
+    std::string name() const;
+    bool enabled() const { return m_enabled; }
+
+    /// The size of a new segment (an existing one keeps its own size).
+    void set_max_bytes(long long bytes) { m_max_bytes = bytes; }
+    long long max_bytes() const { return m_max_bytes; }
+
+    /// Fill pixels[0..size-1] with the shared copy of tile `id`, returning
+    /// true if there was one.
+    bool read(const TileID& id, void* pixels, size_t size);
+
+    /// Share size bytes of decoded pixels of tile `id`, replacing the
+    /// least recently used tile of its set if need be.
+    void write(const TileID& id, const void* pixels, size_t size);
+
+    /// The largest tile that is shared, e.g. 64x64 RGBA float.
+    static constexpr size_t slot_bytes = 64 * 1024;
+
+private:
+    struct Segment;  // The mapping, in imagecache_shm.cpp
+    std::shared_ptr<Segment> segment() const;
+
+    mutable spin_mutex m_mutex;  ///< Protects m_name and m_segment
+    std::string m_name;
+    std::shared_ptr<Segment> m_segment;
+    std::atomic<bool> m_enabled { false };
+    atomic_ll m_max_bytes { 1024LL * 1024 * 1024 };
+};
+
+
+
+/// RemoteTileCache is an optional tier of tiles shared by the ImageCaches
+/// of a whole render farm over TCP. Any ImageCache can serve tiles, from
+/// memory, to the others ("tileserver_port"), and ask the servers listed in
+/// "tileservers" for tiles, keyed just as DiskTileCache keys them. Each key
+/// belongs to one of the servers (by its hash), so that however many nodes
+/// want a tile, it's read from its file by only the first, which gives it
+/// to that server for the others. A server that doesn't answer in time is
+/// left alone for a while, and its tiles are read from their files.
+/// Servers and clients prove to each other, when they connect, that they
+/// know the same secret ("tileserver_secret"); the traffic itself is not
+/// encrypted.
+class RemoteTileCache {
+public:
+    RemoteTileCache() {}
+    RemoteTileCache(const RemoteTileCache&)            = delete;
+    RemoteTileCache& operator=(const RemoteTileCache&) = delete;
+    ~RemoteTileCache();
+
+    /// Use the comma-separated "host:port" servers, or none if `list` is
+    /// empty. Return false if any of them can't be resolved.
+    bool set_servers(string_view list);
+    std::string servers() const;
+    bool enabled() const { return m_enabled; }
+
+    /// How long to wait for a server before giving up on it.
+    void set_timeout_ms(int ms) { m_timeout_ms = std::max(ms, 1); }
+    int timeout_ms() const { return m_timeout_ms; }
+
+    /// Fill pixels[0..size-1] with the server's copy of tile `id`,
+    /// returning true if it had one.
+    bool read(const TileID& id, void* pixels, size_t size);
+
+    /// Give size bytes of decoded pixels of tile `id` to its server.
+    void write(const TileID& id, const void* pixels, size_t size);
+
+    /// Serve tiles to other caches on TCP `port`, or stop if it's 0.
+    /// Return false if we can't listen there, or if there's no secret and
+    /// the address isn't a loopback one.
+    bool set_port(int port);
+    int port() const { return m_port; }
+
+    /// Listen on the interface with this address (or on all of them if
+    /// it's empty), starting over if we're already serving. Return false
+    /// if we can't listen there. Without a secret, only a loopback address
+    /// may be used.
+    bool set_address(string_view address);
+    std::string address() const;
+
+    /// The secret that servers and clients must share. Clearing it stops
+    /// serving on any but a loopback address.
+    void set_secret(string_view secret);
+    std::string secret() const;
+
+    /// The most connections we serve at once; more are refused.
+    void set_max_connections(int n) { m_max_connections = std::max(n, 1); }
+    int max_connections() const { return m_max_connections; }
+
+    /// The number of tiles we're serving.
+    int tiles_served() const;
+
+    /// The most memory that the tiles we serve may use.
+    void set_max_bytes(long long bytes) { m_max_bytes = bytes; }
+    long long max_bytes() const { return m_max_bytes; }
+
+private:
+    struct Server;    // A server we ask, in imagecache_remote.cpp
+    struct Listener;  // Our own server
+    std::shared_ptr<Server> server_for(string_view key) const;
+    bool listen(int port);  // set_port, with m_listen_mutex held
+
+    mutable spin_mutex m_mutex;  ///< Protects all but the atomics
+    std::mutex m_listen_mutex;   ///< Serializes changes of m_listener
+    std::vector<std::shared_ptr<Server>> m_servers;
+    std::shared_ptr<Listener> m_listener;
+    std::string m_address = "127.0.0.1";
+    std::string m_secret;
+    std::atomic<bool> m_enabled { false };
+    std::atomic<int> m_timeout_ms { 250 };
+    std::atomic<int> m_port { 0 };
+    std::atomic<int> m_max_connections { 64 };
+    atomic_ll m_max_bytes { 1024LL * 1024 * 1024 };
+};
+
+
+
+/// Delete the least recently used files in `dir` (and its subdirectories)
+/// whose names match the regex `pattern`, until they add up to comfortably
+/// less than max_bytes, and return how many bytes of them remain. For the
+/// caches that keep their entries as files in a directory.
+long long
+trim_cache_directory(const std::string& dir, string_view pattern,
+                     long long max_bytes);
+
+
+
+/// ThumbnailCache, enabled with the "thumbnail_size" attribute, lets
+/// get_thumbnail() deliver a thumbnail of any image, not only of those that
+/// have one embedded. Thumbnails come in a few standard sizes, and each is
+/// made from the cheapest source that is big enough: the embedded
+/// thumbnail, the coarsest MIP level, or a reduced resolution decode
+/// ("oiio:reduce_factor"), which for most formats means reading the whole
+/// image. The most recently used are kept in memory, and with
+/// "thumbnail_dir" in a directory shared by all processes, keyed by the
+/// file's name, size, and modification time, held under
+/// "thumbnail_max_MB" like the files of DiskTileCache.
+class ThumbnailCache {
+public:
+    ThumbnailCache() {}
+    ThumbnailCache(const ThumbnailCache&)            = delete;
+    ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+    /// Deliver thumbnails of (at least) `size` pixels across, rounded up to
+    /// a standard size, or only embedded ones if `size` is 0.
+    void set_size(int size);
+    int size() const { return m_size; }
+    bool enabled() const { return m_size > 0; }
+
+    /// Use the directory `dir`, creating it if necessary, or keep the
+    /// thumbnails only in memory if `dir` is empty. Return false if the
+    /// directory is unusable.
+    bool set_directory(string_view dir);
+    std::string directory() const;
+
+    void set_max_bytes(long long bytes) { m_max_bytes = bytes; }
+    long long max_bytes() const { return m_max_bytes; }
+
+    /// Retrieve into `thumb` the thumbnail of `subimage` of `file`, from
+    /// memory or the directory, or else by making it (only once, however
+    /// many threads ask for it at the same time). Return false if it could
+    /// not be made.
+    bool get(ImageCacheImpl& imagecache, ImageCacheFile* file,
+             ImageCachePerThreadInfo* thread_info, ImageBuf& thumb,
+             int subimage);
+
+    /// Forget the thumbnails held in memory.
+    void clear();
+
+    /// The thumbnails in memory are limited to this many bytes.
+    static const long long max_memory_bytes = 32LL * 1024 * 1024;
+
+private:
+    struct Entry {
+        std::shared_ptr<const ImageBuf> thumb;
+        std::list<std::string>::iterator lru;  ///< Position in m_lru
+    };
+
+    // Describe everything that determines the thumbnail, or return an
+    // empty string if the file can't be identified across processes.
+    static std::string thumbnail_key(const ImageCacheFile& file,
+                                     int subimage, int size);
+    bool make(ImageCacheImpl& imagecache, ImageCacheFile* file,
+              ImageCachePerThreadInfo* thread_info, int subimage, int size,
+              ImageBuf& thumb);
+    bool read_file(const std::string& dir, const std::string& key,
+                   ImageBuf& thumb);
+    void write_file(const std::string& dir, const std::string& key,
+                    const ImageBuf& thumb);
+    // Keep `thumb` in memory, dropping the least recently used to make
+    // room. Call with m_mutex held.
+    void remember(const std::string& key,
+                  std::shared_ptr<const ImageBuf> thumb);
+
+    std::atomic<int> m_size { 0 };
+    mutable std::mutex m_mutex;      ///< Protects all but the atomics
+    std::condition_variable m_made;  ///< Signaled when one is made
+    std::string m_dir;
+    std::unordered_map<std::string, Entry> m_thumbs;
+    std::list<std::string> m_lru;              ///< Most recently used first
+    std::unordered_set<std::string> m_making;  ///< Being made by a thread
+    long long m_memory_bytes = 0;              ///< Pixels of m_thumbs
+    atomic_ll m_max_bytes { 1024LL * 1024 * 1024 };
+    atomic_ll m_bytes { 0 };  ///< Estimated size of the directory
+    spin_mutex m_trim_mutex;  ///< Ensure only one thread trims
+};
+
+
+
+/// RetileCache, enabled with the "retile_dir" attribute, keeps local tiled
+/// copies in the OTX format of images that are expensive to read a tile at
+/// a time: untiled ones, which otherwise are decoded again each time their
+/// tiles are evicted and needed, and unmipped ones under "automip", which
+/// otherwise are resized again. A copy is made in the background on the
+/// first open of such an image, and the ImageCacheFile switches to it once
+/// it's ready. Copies are keyed by the file's name, size, and modification
+/// time, shared by all processes naming the same directory, and held under
+/// "retile_max_MB" like the files of DiskTileCache.
+class RetileCache {
+public:
+    RetileCache() {}
+    RetileCache(const RetileCache&)            = delete;
+    RetileCache& operator=(const RetileCache&) = delete;
+
+    /// Use the directory `dir`, creating it if necessary, or make no copies
+    /// if `dir` is empty. Return false if the directory is unusable.
+    bool set_directory(string_view dir);
+    std::string directory() const;
+    bool enabled() const { return m_enabled; }
+
+    void set_max_bytes(long long bytes) { m_max_bytes = bytes; }
+    long long max_bytes() const { return m_max_bytes; }
+
+    /// The name of the finished copy of `source`, or an empty ustring if
+    /// there is none (yet) for its current contents.
+    ustring find(ustring source) const;
+
+    /// Is `file`, just opened, worth copying?
+    bool wanted(const ImageCacheImpl& imagecache,
+                const ImageCacheFile& file) const;
+
+    /// Make the copy of `source`, unless another thread is already making
+    /// it, with tiles of `tilesize` and MIP levels if `mipmap`. Return true
+    /// if the copy is now there to be used.
+    bool make(ustring source, int tilesize, bool mipmap);
+
+    /// How many copies have been made.
+    int made() const { return m_made; }
+
+private:
+    // Describe everything that determines the copy, or return an empty
+    // string if the file can't be identified across processes.
+    static std::string retile_key(ustring source);
+    static std::string retile_path(const std::string& dir,
+                                   const std::string& key);
+
+    mutable std::mutex m_mutex;  ///< Protects m_dir and m_making
+    std::string m_dir;
+    std::atomic<bool> m_enabled { false };
+    std::unordered_set<std::string> m_making;  ///< Being made by a thread
+    atomic_ll m_max_bytes { 10LL * 1024 * 1024 * 1024 };
+    atomic_ll m_bytes { 0 };  ///< Estimated size of the directory
+    spin_mutex m_trim_mutex;  ///< Ensure only one thread trims
+    std::atomic<int> m_made { 0 };
+};
+
+
+
+/// MappedTileFile is a read-only memory mapping of a tiled TIFF file, for
+/// "mmap_tiles": tiles that are stored uncompressed, with contiguous
+/// channels in the host byte order -- just as the cache lays them out --
+/// can be used directly from the mapping, with no read, copy, or cache
+/// memory of their own. Tiles using it hold a shared_ptr to it, so that
+/// the mapping outlives them.
+class MappedTileFile {
+public:
+    ~MappedTileFile();
+    MappedTileFile(const MappedTileFile&)            = delete;
+    MappedTileFile& operator=(const MappedTileFile&) = delete;
+
+    /// Map the file and index the tiles of each of its TIFF directories
+    /// (or OTX levels, numbered the same way). Return an empty pointer if
+    /// it can't be mapped, isn't a TIFF or OTX file in the host byte
+    /// order, or has no tiles that could be used.
+    static std::shared_ptr<const MappedTileFile>
+    open(const std::string& filename);
+
+    /// Return a pointer to tile number `tile` (counting in raster order)
+    /// of TIFF directory `dir`, if that directory's image matches `spec`
+    /// with pixels of type `format`, and its tiles can be used in place
+    /// (including reading up to OIIO_SIMD_MAX_SIZE_BYTES past their end).
+    /// Otherwise return nullptr.
+    const char* tile(int dir, const ImageSpec& spec, TypeDesc format,
+                     bool unassociatedalpha, int tile) const;
+
+private:
+    struct Directory {
+        int width       = 0;
+        int height      = 0;
+        int tile_width  = 0;
+        int tile_height = 0;
+        int nchannels   = 0;
+        TypeDesc format;
+        bool unassociated_alpha = false;
+        std::vector<uint64_t> offsets;  ///< 0 for tiles that can't be used
+    };
+
+    MappedTileFile() {}
+    bool parse();
+    bool parse_otx();
+
+    const char* m_base = nullptr;  ///< Start of the mapping
+    size_t m_size      = 0;        ///< Size of the file and mapping
+    std::vector<Directory> m_dirs;
+};
+
+
+
+/// One main tile cache access, as recorded by TileAccessRecorder. The
+/// layout is fixed, without padding, in native byte order.
+struct TileAccessRecord {
+    int64_t time;        ///< Nanoseconds since the recording started
+    uint32_t file;       ///< Index of the file in the recording
+    uint16_t subimage, miplevel;
+    int32_t x, y, z;
+    uint16_t chbegin, chend;
+    uint32_t bytes;  ///< Memory used by the tile's pixels
+    uint8_t hit;     ///< 1 if the tile was in the cache, 0 if it was read
+    uint8_t unused[3];
+};
+static_assert(sizeof(TileAccessRecord) == 40,
+              "TileAccessRecord must not be padded");
+
+
+
+/// TileAccessRecorder, enabled with the "record_tiles" attribute, writes
+/// every access to the main tile cache -- that is, every tile that the
+/// threads' own microcaches didn't already hold -- to a file, so that the
+/// working set and the hit rate of other cache sizes can be worked out
+/// offline (see `testtex --analyze-tiles`). Each thread records into its
+/// own buffer and writes it as a block when it's full.
+///
+/// The file is a 40-byte header, a ring of fixed-size blocks, and a table
+/// of the files' names:
+///   - header: char[16] "OIIO tile rec 1\n", uint32 records per block,
+///     uint32 blocks in the ring (0 if unbounded), uint64 blocks written,
+///     uint64 offset of the table of files.
+///   - block: uint32 thread, uint32 count, then count TileAccessRecords
+///     padded to the block size. When there are more blocks than fit in
+///     the ring ("record_tiles_max_MB"), the newest overwrite the oldest.
+///   - table of files, written when the recording ends: uint32 count,
+///     then for each file a uint32 length and the name.
+class TileAccessRecorder {
+public:
+    TileAccessRecorder();
+    TileAccessRecorder(const TileAccessRecorder&)            = delete;
+    TileAccessRecorder& operator=(const TileAccessRecorder&) = delete;
+    ~TileAccessRecorder();
+
+    /// Finish any recording in progress, and start recording to filename
+    /// unless it's empty. Return false if the file can't be written. There
+    /// must be no cache accesses in progress.
+    bool set_filename(string_view filename);
+    const std::string& filename() const { return m_filename; }
+    bool enabled() const { return m_file != nullptr; }
+
+    /// Bound the ring to this many bytes (0 for unbounded), starting with
+    /// the next recording.
+    void set_max_bytes(long long bytes) { m_max_bytes = bytes; }
+    long long max_bytes() const { return m_max_bytes; }
+
+    /// Record an access to tile id, by the calling thread.
+    void record(const TileID& id, bool hit, size_t bytes);
+
+private:
+    struct Buffer;
+    Buffer& thread_buffer();
+    uint32_t file_index(Buffer& buffer, const ImageCacheFile* file);
+    void flush(Buffer& buffer);
+    bool write_header(uint64_t files_offset);
+
+    std::string m_filename;
+    FILE* m_file          = nullptr;
+    long long m_max_bytes = 0;
+    uint32_t m_capacity   = 0;  ///< Blocks in the ring, or 0
+    uint64_t m_blocks     = 0;  ///< Blocks written so far
+    uint64_t m_serial     = 0;  ///< Tells this recording's buffers apart
+    std::chrono::steady_clock::time_point m_start;
+    std::mutex m_mutex;  ///< Guards the file and the tables below
+    std::vector<std::unique_ptr<Buffer>> m_buffers;
+    std::unordered_map<std::thread::id, Buffer*> m_thread_buffers;
+    std::unordered_map<const ImageCacheFile*, uint32_t> m_file_indices;
+    std::vector<ustring> m_file_names;
+};
+
+
+
 /// Working implementation of the abstract ImageCache class.
 ///
 /// Some of the methods require a pointer to the thread-specific IC data
@@ -822,6 +2105,9 @@ public:
 ///
 class ImageCacheImpl {
 public:
+    /// Most NUMA nodes that "numa_tiles" distinguishes.
+    static constexpr int max_numa_nodes = 16;
+
     using Perthread   = ImageCachePerThreadInfo;
     using ImageHandle = ImageCacheFile;
     using Tile        = ImageCacheTile;
@@ -896,7 +2182,14 @@ public:
     bool accept_untiled() const { return m_accept_untiled; }
     bool accept_unmipped() const { return m_accept_unmipped; }
     bool unassociatedalpha() const { return m_unassociatedalpha; }
+    DiskTileCache& diskcache() { return m_diskcache; }
+    CompressedTileCache& compressedtier() { return m_compressedtier; }
+    SharedTileCache& sharedtier() { return m_sharedtier; }
+    RemoteTileCache& remotetier() { return m_remotetier; }
+    bool mmap_tiles() const { return m_mmap_tiles; }
+    bool per_file_stats() const { return m_per_file_stats; }
     bool trust_file_extensions() const { return m_trust_file_extensions; }
+    bool udim_manifest() const { return m_udim_manifest; }
     int failure_retries() const { return m_failure_retries; }
     bool latlong_y_up_default() const { return m_latlong_y_up_default; }
     void get_commontoworld(Imath::M44f& result) const { result = m_Mc2w; }
@@ -904,6 +2197,17 @@ public:
 
     std::string resolve_filename(const std::string& filename) const;
 
+    /// The retiled copy of `source` to use in its place, or an empty
+    /// ustring if there is none.
+    ustring retiled_filename(ustring source) const
+    {
+        return m_retile.enabled() ? m_retile.find(source) : ustring();
+    }
+
+    /// If `file`, just opened, is worth a retiled copy, queue the making of
+    /// one on the prefetch pool, and its switch to the copy once it's made.
+    void request_retile(ImageCacheFile* file);
+
     // Set m_max_open_files, with logic to try to clamp reasonably.
     void set_max_open_files(int m);
 
@@ -948,6 +2252,13 @@ public:
     bool get_thumbnail(ImageHandle* file, Perthread* thread_info,
                        ImageBuf& thumbnail, int subimage = 0);
 
+    bool get_pixel_bounds(ustring filename, int subimage, int miplevel,
+                          ROI roi, span<float> min, span<float> max);
+    bool get_pixel_bounds(ImageCacheFile* file,
+                          ImageCachePerThreadInfo* thread_info, int subimage,
+                          int miplevel, ROI roi, span<float> min,
+                          span<float> max);
+
     // Retrieve a rectangle of raw unfiltered pixels.
     bool get_pixels(ustring filename, int subimage, int miplevel, int xbegin,
                     int xend, int ybegin, int yend, int zbegin, int zend,
@@ -972,6 +2283,15 @@ public:
                     stride_t zstride = AutoStride, int cache_chbegin = 0,
                     int cache_chend = -1);
 
+    // Retrieve a rectangle of deep pixels.
+    bool get_deep_pixels(ustring filename, int subimage, int miplevel,
+                         int xbegin, int xend, int ybegin, int yend,
+                         int zbegin, int zend, DeepData& result);
+    bool get_deep_pixels(ImageCacheFile* file,
+                         ImageCachePerThreadInfo* thread_info, int subimage,
+                         int miplevel, int xbegin, int xend, int ybegin,
+                         int yend, int zbegin, int zend, DeepData& result);
+
     // Find the ImageCacheFile record for the named image, adding an entry
     // if it is not already in the cache. This returns a plain old pointer,
     // which is ok because the file hash table has ref-counted pointers and
@@ -1016,10 +2336,24 @@ public:
     bool tile_in_cache(const TileID& id,
                        ImageCachePerThreadInfo* /*thread_info*/)
     {
+        if (m_tilecache_lockfree)
+            return m_tilecache_lf.contains(id);
         TileCache::iterator found = m_tilecache.find(id);
         return (found != m_tilecache.end());
     }
 
+    /// Is the tile specified by the TileID in the cache with its pixels
+    /// already read, so that finding it won't have to wait?
+    bool tile_resident(const TileID& id, ImageCachePerThreadInfo* thread_info)
+    {
+        ImageCacheTileRef tile;
+        bool found = m_tilecache_lockfree
+                         ? m_tilecache_lf.retrieve(
+                             id, tile, &thread_info->m_tilecache_reader)
+                         : m_tilecache.retrieve(id, tile);
+        return found && tile->pixels_ready();
+    }
+
     /// Add the tile to the cache.  This will also enforce cache memory
     /// limits.
     OIIO_NODISCARD bool add_tile_to_cache(ImageCacheTileRef& tile,
@@ -1039,7 +2373,7 @@ public:
         ++thread_info->m_stats.find_tile_calls;
         ImageCacheTileRef& tile(thread_info->tile);
         if (tile) {
-            if (tile->id() == id) {
+            if (same_tile(tile->id(), id)) {
                 if (mark_same_tile_used)
                     tile->use();
                 return true;  // already have the tile we want
@@ -1048,25 +2382,41 @@ public:
             // and last tile.  Then the new one will either match,
             // or we'll fall through and replace tile.
             tile.swap(thread_info->lasttile);
-            if (tile && tile->id() == id) {
+            if (tile && same_tile(tile->id(), id)) {
                 tile->use();
                 return true;
             }
         }
+        if (thread_info->microcache.enabled())
+            return find_tile_microcache(id, thread_info);
         return find_tile_main_cache(id, tile, thread_info);
         // N.B. find_tile_main_cache marks the tile as used
     }
 
+    /// Like find_tile, but if the tile isn't resident yet, queue it to be
+    /// read asynchronously (as prefetch_tiles does), note its MIP level in
+    /// thread_info->m_nonresident_level, and return false with
+    /// thread_info->tile empty, rather than waiting for it.
+    bool find_tile_nonblocking(const TileID& id,
+                               ImageCachePerThreadInfo* thread_info,
+                               bool mark_same_tile_used);
+
     Tile* get_tile(ustring filename, int subimage, int miplevel, int x, int y,
                    int z, int chbegin, int chend);
     Tile* get_tile(ImageHandle* file, Perthread* thread_info, int subimage,
                    int miplevel, int x, int y, int z, int chbegin, int chend);
     void release_tile(Tile* tile) const;
+    bool prefetch_tiles(ustring filename, int subimage, int miplevel,
+                        ROI roi);
+    bool prefetch_tiles(ImageHandle* file, Perthread* thread_info,
+                        int subimage, int miplevel, ROI roi);
     TypeDesc tile_format(const Tile* tile) const;
     ROI tile_roi(const Tile* tile) const;
     const void* tile_pixels(Tile* tile, TypeDesc& format) const;
     bool add_file(ustring filename, ImageInput::Creator creator,
                   const ImageSpec* config, bool replace);
+    bool preload(cspan<ustring> filenames, ParamValueSpan options,
+                 std::vector<ustring>* broken);
     bool add_tile(ustring filename, int subimage, int miplevel, int x, int y,
                   int z, int chbegin, int chend, TypeDesc format,
                   const void* buffer, stride_t xstride, stride_t ystride,
@@ -1090,6 +2440,15 @@ public:
     /// Merge all the per-thread statistics into one set of stats.
     ///
     void mergestats(ImageCacheStatistics& merged) const;
+    /// Append the merged statistics as metrics samples (the metrics
+    /// source that the ImageCache adds for itself).
+    void report_metrics(std::vector<Metrics::Sample>& samples) const;
+    /// Merge all threads' FileLookupStats, sorted by most lookups first.
+    std::vector<std::pair<const ImageCacheFile*, FileLookupStats>>
+    merge_file_stats() const;
+    /// Merge all threads' tile feedback, clearing it if `clear` is true.
+    std::vector<TextureSystem::TileFeedback>
+    merge_tile_feedback(bool clear) const;
 
     // void operator delete(void* todel) { ::delete ((char*)todel); }
 
@@ -1107,23 +2466,30 @@ public:
 
     /// Called when a new tile is created, to update all the stats.
     ///
-    void incr_tiles(size_t size)
+    void incr_tiles(size_t size, int numa_node = 0)
     {
         ++m_stat_tiles_created;
         atomic_max(m_stat_tiles_peak, ++m_stat_tiles_current);
-        m_mem_used += size;
+        incr_mem(size, numa_node);
     }
 
     /// Called when a tile's pixel memory is allocated, but a new tile
     /// is not created.
-    void incr_mem(size_t size) { m_mem_used += size; }
+    void incr_mem(size_t size, int numa_node = 0)
+    {
+        m_mem_used += size;
+        m_numa_mem_used[numa_node] += size;
+        pvt::IC_mem_current += size;
+    }
 
     /// Called when a tile is destroyed, to update all the stats.
     ///
-    void decr_tiles(size_t size)
+    void decr_tiles(size_t size, int numa_node = 0)
     {
         --m_stat_tiles_current;
         m_mem_used -= size;
+        m_numa_mem_used[numa_node] -= size;
+        pvt::IC_mem_current -= size;
         OIIO_DASSERT(m_mem_used >= 0);
     }
 
@@ -1149,6 +2515,17 @@ public:
     /// Enforce the max number of open files.
     void check_max_files(ImageCachePerThreadInfo* thread_info);
 
+    /// An ImageCacheFileProxy has opened its file.
+    void add_open_proxy(ImageCacheFileProxy* proxy);
+
+    /// Close the file handle of an ImageCacheFileProxy (if it's open and
+    /// not being read), returning true if it was closed.
+    bool suspend_proxy(ImageCacheFileProxy* proxy);
+
+    /// The cache's clock of reads through ImageCacheFileProxy's, for
+    /// closing the least recently read first.
+    int64_t proxy_read_tick() { return ++m_proxy_read_clock; }
+
     int max_mip_res() const noexcept { return m_max_mip_res; }
 
     ustring colorspace() const noexcept { return m_colorspace; }
@@ -1159,14 +2536,70 @@ public:
 private:
     void init();
 
+    /// The part of find_tile after missing the last two tiles, when the
+    /// thread has a TileMicroCache: look there, and failing that in the
+    /// main cache, for the tile to put in thread_info->tile, and keep the
+    /// one it displaces in the microcache.
+    bool find_tile_microcache(const TileID& id,
+                              ImageCachePerThreadInfo* thread_info);
+
     /// Find a tile identified by 'id' in the tile cache, paging it in if
     /// needed, and store a reference to the tile.  Return true if ok,
     /// false if no such tile exists in the file or could not be read.
     bool find_tile_main_cache(const TileID& id, ImageCacheTileRef& tile,
                               ImageCachePerThreadInfo* thread_info);
 
-    /// Enforce the max memory for tile data.
-    void check_max_mem(ImageCachePerThreadInfo* thread_info);
+    /// Add the tile to whichever tile cache is in use. Return true if it
+    /// was added, false if a tile with the same id was already there, in
+    /// which case `tile` is changed to refer to that one.
+    bool insert_tile(ImageCacheTileRef& tile);
+
+    /// Read the pixels (if needed) of a tile that we just added to the
+    /// cache, and then enforce the memory limits.
+    bool finish_new_tile(ImageCacheTileRef& tile,
+                         ImageCachePerThreadInfo* thread_info);
+
+    /// Like finish_new_tile, for a run of horizontally adjacent tiles that
+    /// we just added to the cache, read all at once.
+    bool finish_new_tiles(span<ImageCacheTileRef> tiles,
+                          ImageCachePerThreadInfo* thread_info);
+
+    /// Add to the cache all the tiles of the level that overlap `roi` and
+    /// are not already there, reading adjacent ones together where we can.
+    /// If `async` is true, queue the reads on the prefetch pool rather than
+    /// waiting for them. Return the number of tiles added.
+    int add_tiles_to_cache(ImageCacheFile* file,
+                           ImageCachePerThreadInfo* thread_info, int subimage,
+                           int miplevel, ROI roi, bool async);
+
+    /// Make the thread pool for asynchronous reads, if it's needed and we
+    /// haven't already.
+    void init_prefetch_pool();
+
+    /// Enforce the max memory for tile data, freeing at least `release`
+    /// bytes of tiles if asked to.
+    void check_max_mem(ImageCachePerThreadInfo* thread_info,
+                       long long release = 0);
+
+    /// Free (about) `bytes` of tiles, for the process-wide memory budget.
+    void release_memory(long long bytes);
+
+    /// For "numa_tiles": if some other NUMA node has a copy of the tile
+    /// `id`, make a copy for id.numa_node() out of it and add it to the
+    /// cache, returning true. Return false if there is no such copy.
+    bool copy_numa_tile(const TileID& id, ImageCacheTileRef& tile,
+                        ImageCachePerThreadInfo* thread_info);
+
+    /// If the tile `id` has a color transform, and the same tile without
+    /// it is in the cache, make the transformed tile out of that and add it
+    /// to the cache, returning true, rather than reading the file again.
+    /// Return false if there is no such tile.
+    bool colortransform_cached_tile(const TileID& id, ImageCacheTileRef& tile,
+                                    ImageCachePerThreadInfo* thread_info);
+
+    /// Offer a tile that is being evicted to the compressed tier.
+    void demote_tile(const ImageCacheTile* tile,
+                     ImageCachePerThreadInfo* thread_info);
 
     /// Internal statistics printing routine
     ///
@@ -1209,6 +2642,7 @@ private:
     bool m_unassociatedalpha;  ///< Keep unassociated alpha files as they are?
     bool m_latlong_y_up_default;  ///< Is +y the default "up" for latlong?
     bool m_trust_file_extensions = false;  ///< Assume file extensions don't lie?
+    bool m_udim_manifest = false;          ///< Use sidecar udim manifests?
     bool m_max_open_files_strict = false;  ///< Be strict about open files limit?
     int m_failure_retries;                 ///< Times to re-try disk failures
     int m_max_mip_res = 1 << 30;  ///< Don't use MIP levels higher than this
@@ -1221,6 +2655,16 @@ private:
     mutable FilenameMap m_files;    ///< Map file names to ImageCacheFile's
     ustring m_file_sweep_name;      ///< Sweeper for "clock" paging algorithm
     spin_mutex m_file_sweep_mutex;  ///< Ensure only one in check_max_files
+    std::mutex m_open_proxies_mutex;  ///< Protects m_open_proxies
+    std::vector<ImageCacheFileProxy*> m_open_proxies;  ///< Hold a file open
+    std::atomic<int64_t> m_proxy_read_clock { 0 };  ///< See proxy_read_tick
+    /// The files that find_file most recently returned, shared by all
+    /// threads, each in the slot chosen by its name's precomputed hash and
+    /// recognized by its filename_original(), so that a repeated lookup by
+    /// name needs no locks, hashing, or probing. (Files are never freed
+    /// before the ImageCache itself, so a stale entry is merely a miss.)
+    static constexpr size_t recent_file_slots = 4096;
+    std::atomic<ImageCacheFile*> m_recent_files[recent_file_slots] {};
 
     spin_mutex m_fingerprints_mutex;  ///< Protect m_fingerprints
     FingerprintMap m_fingerprints;    ///< Map fingerprints to files
@@ -1231,6 +2675,45 @@ private:
     TileID m_tile_sweep_id;         ///< Sweeper for "clock" paging algorithm
     spin_mutex m_tile_sweep_mutex;  ///< Ensure only one in check_max_mem
 
+    /// Chooses the tiles that check_max_mem frees ("eviction_policy").
+    std::unique_ptr<TileEvictionPolicy> m_eviction_policy;
+    DiskTileCache m_diskcache;  ///< Optional second level tile cache
+    ThumbnailCache m_thumbnails;  ///< Optional made thumbnails
+    RetileCache m_retile;         ///< Optional local tiled copies
+    FileChangeWatcher m_watcher;  ///< Optional file change notifications
+    /// Optional tier of evicted tiles kept compressed in memory
+    CompressedTileCache m_compressedtier;
+    /// Optional tier of tiles shared with other processes
+    SharedTileCache m_sharedtier;
+    /// Optional tier of tiles shared with other machines
+    RemoteTileCache m_remotetier;
+    /// Optional record of main cache accesses ("record_tiles")
+    TileAccessRecorder m_tilerecorder;
+
+    int m_prefetch_threads = -1;     ///< Size of m_prefetch_pool, or -1
+                                     ///<   to use the shared I/O pool
+    int m_microcache_size  = 0;      ///< Tiles per TileMicroCache
+    bool m_mmap_tiles      = false;  ///< Use tiles in place in mapped files?
+    bool m_per_file_stats  = false;  ///< Gather FileLookupStats?
+    std::unique_ptr<thread_pool> m_prefetch_pool;  ///< For prefetch_tiles
+    spin_mutex m_prefetch_mutex;  ///< Protects creation of m_prefetch_pool
+    std::atomic<int> m_prefetches_pending { 0 };  ///< Runs yet to be read
+
+    /// When "tilecache_impl" is "lockfree", m_tilecache_lf is used in place
+    /// of m_tilecache, with m_tile_sweep_pos as its clock hand. It may only
+    /// be changed until m_tiles_cached is set, by the first tile inserted.
+    std::atomic<bool> m_tilecache_lockfree { false };
+    std::atomic<bool> m_tiles_cached { false };
+    LockFreeTileCache m_tilecache_lf;
+    LockFreeTileCache::SweepPos m_tile_sweep_pos;
+
+    /// With "numa_tiles", threads on each of the m_numa_nodes NUMA nodes
+    /// use their own copies of tiles, allocated and filled by a thread on
+    /// that node so that the pages are local to it.
+    bool m_numa_tiles = false;
+    int m_numa_nodes  = 1;
+    atomic_ll m_numa_mem_used[max_numa_nodes] = {};  ///< Tile mem per node
+
     atomic_ll m_mem_used;       ///< Memory being used for tiles
     int m_statslevel;           ///< Statistics level
     int m_max_errors_per_file;  ///< Max errors to print for each file.
@@ -1245,6 +2728,7 @@ private:
     atomic_int m_stat_open_files_created;
     atomic_int m_stat_open_files_current;
     atomic_int m_stat_open_files_peak;
+    int m_metrics_source;  ///< id of our source of Metrics
 
     // Simulate an atomic double with a long long!
     void incr_time_stat(double& stat, double incr)
@@ -0,0 +1,223 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/strutil.h>
+
+#include "imagecache_pvt.h"
+
+OIIO_NAMESPACE_BEGIN
+
+namespace {  // anonymous
+
+static const char tilerecord_magic[16] = { 'O', 'I', 'I', 'O', ' ', 't',
+                                           'i', 'l', 'e', ' ', 'r', 'e',
+                                           'c', ' ', '1', '\n' };
+
+struct TileRecordHeader {
+    char magic[16];
+    uint32_t block_records;
+    uint32_t capacity;
+    uint64_t blocks;
+    uint64_t files_offset;
+};
+static_assert(sizeof(TileRecordHeader) == 40, "TileRecordHeader is padded");
+
+// Write a thread's block after this many accesses.
+static const uint32_t records_per_block = 4096;
+
+static const size_t block_bytes = 2 * sizeof(uint32_t)
+                                  + records_per_block
+                                        * sizeof(TileAccessRecord);
+
+std::atomic<uint64_t> next_tilerecorder_serial(0);
+
+}  // namespace
+
+
+
+struct TileAccessRecorder::Buffer {
+    uint32_t thread;
+    std::vector<TileAccessRecord> records;
+    // The files this thread has already named, so that most accesses
+    // don't need the recorder's lock.
+    std::unordered_map<const ImageCacheFile*, uint32_t> files;
+};
+
+
+
+TileAccessRecorder::TileAccessRecorder() {}
+
+
+
+TileAccessRecorder::~TileAccessRecorder() { set_filename(""); }
+
+
+
+bool
+TileAccessRecorder::set_filename(string_view filename)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file) {
+        // Write what's left in each thread's buffer, then the names of the
+        // files after the last block of the ring, and finally the header
+        // that says where they are.
+        for (auto& b : m_buffers)
+            flush(*b);
+        uint64_t ringblocks = m_blocks;
+        if (m_capacity)
+            ringblocks = std::min(ringblocks, uint64_t(m_capacity));
+        uint64_t offset = sizeof(TileRecordHeader) + ringblocks * block_bytes;
+        Filesystem::fseek(m_file, offset, SEEK_SET);
+        uint32_t nfiles = uint32_t(m_file_names.size());
+        fwrite(&nfiles, sizeof(nfiles), 1, m_file);
+        for (ustring name : m_file_names) {
+            uint32_t len = uint32_t(name.size());
+            fwrite(&len, sizeof(len), 1, m_file);
+            fwrite(name.data(), 1, name.size(), m_file);
+        }
+        write_header(offset);
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    m_buffers.clear();
+    m_thread_buffers.clear();
+    m_file_indices.clear();
+    m_file_names.clear();
+    m_filename.clear();
+    m_blocks = 0;
+    if (filename.empty())
+        return true;
+
+    m_file = Filesystem::fopen(filename, "wb");
+    if (!m_file)
+        return false;
+    m_filename = filename;
+    m_capacity = m_max_bytes > 0
+                     ? uint32_t(std::max(m_max_bytes / (long long)block_bytes,
+                                         1LL))
+                     : 0;
+    m_serial   = ++next_tilerecorder_serial;
+    m_start    = std::chrono::steady_clock::now();
+    return write_header(0);
+}
+
+
+
+bool
+TileAccessRecorder::write_header(uint64_t files_offset)
+{
+    TileRecordHeader header;
+    memcpy(header.magic, tilerecord_magic, sizeof(header.magic));
+    header.block_records = records_per_block;
+    header.capacity      = m_capacity;
+    header.blocks        = m_blocks;
+    header.files_offset  = files_offset;
+    return Filesystem::fseek(m_file, 0, SEEK_SET) == 0
+           && fwrite(&header, sizeof(header), 1, m_file) == 1;
+}
+
+
+
+TileAccessRecorder::Buffer&
+TileAccessRecorder::thread_buffer()
+{
+    // The common case: the last recording this thread recorded to is this
+    // one. If not, find (or make) this thread's buffer.
+    struct LastBuffer {
+        uint64_t serial = 0;
+        Buffer* buffer  = nullptr;
+    };
+    thread_local LastBuffer last;
+    if (last.serial != m_serial) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Buffer*& b = m_thread_buffers[std::this_thread::get_id()];
+        if (!b) {
+            m_buffers.emplace_back(new Buffer);
+            b         = m_buffers.back().get();
+            b->thread = uint32_t(m_buffers.size() - 1);
+            b->records.reserve(records_per_block);
+        }
+        last.serial = m_serial;
+        last.buffer = b;
+    }
+    return *last.buffer;
+}
+
+
+
+uint32_t
+TileAccessRecorder::file_index(Buffer& buffer, const ImageCacheFile* file)
+{
+    auto found = buffer.files.find(file);
+    if (found != buffer.files.end())
+        return found->second;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto inserted = m_file_indices.emplace(file,
+                                           uint32_t(m_file_names.size()));
+    if (inserted.second)
+        m_file_names.push_back(file->filename());
+    buffer.files.emplace(file, inserted.first->second);
+    return inserted.first->second;
+}
+
+
+
+void
+TileAccessRecorder::flush(Buffer& buffer)
+{
+    // N.B. called with m_mutex held
+    if (buffer.records.empty())
+        return;
+    uint64_t slot = m_capacity ? m_blocks % m_capacity : m_blocks;
+    Filesystem::fseek(m_file, sizeof(TileRecordHeader) + slot * block_bytes,
+                      SEEK_SET);
+    uint32_t header[2] = { buffer.thread, uint32_t(buffer.records.size()) };
+    fwrite(header, sizeof(header), 1, m_file);
+    // Pad the block to its full size, so that every slot of the ring is
+    // the same size.
+    buffer.records.resize(records_per_block);
+    fwrite(buffer.records.data(), sizeof(TileAccessRecord),
+           records_per_block, m_file);
+    buffer.records.clear();
+    ++m_blocks;
+}
+
+
+
+void
+TileAccessRecorder::record(const TileID& id, bool hit, size_t bytes)
+{
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - m_start);
+    Buffer& buffer(thread_buffer());
+    TileAccessRecord r;
+    memset(&r, 0, sizeof(r));
+    r.time     = elapsed.count();
+    r.file     = file_index(buffer, &id.file());
+    r.subimage = uint16_t(id.subimage());
+    r.miplevel = uint16_t(id.miplevel());
+    r.x        = id.x();
+    r.y        = id.y();
+    r.z        = id.z();
+    r.chbegin  = uint16_t(id.chbegin());
+    r.chend    = uint16_t(id.chend());
+    r.bytes    = uint32_t(bytes);
+    r.hit      = hit;
+    buffer.records.push_back(r);
+    if (buffer.records.size() >= records_per_block) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        flush(buffer);
+    }
+}
+
+OIIO_NAMESPACE_END
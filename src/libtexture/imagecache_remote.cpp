@@ -0,0 +1,893 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifndef _WIN32
+#    include <arpa/inet.h>
+#    include <netdb.h>
+#    include <netinet/in.h>
+#    include <netinet/tcp.h>
+#    include <poll.h>
+#    include <sys/socket.h>
+#    include <sys/time.h>
+#    include <unistd.h>
+#endif
+
+#include <OpenImageIO/hash.h>
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/thread.h>
+
+#include "imagecache_pvt.h"
+
+OIIO_NAMESPACE_BEGIN
+
+
+// The tile server protocol
+//
+// Every message starts with the same 16 byte header: the magic "OTS3", an
+// op byte, a status byte, two unused bytes, then the length of the key and
+// the size of the pixels, as little-endian 32 bit integers. The key
+// follows, and for a 'P' (put) the pixels; a put has no reply. A 'G' (get)
+// is answered by a header with status 1 followed by the pixels if the
+// server has the tile, or status 0 and no pixels if it doesn't. A client
+// keeps its connections open for its next requests.
+//
+// First, though, each end proves to the other that it knows the shared
+// secret. The server sends a 'C' (challenge) whose key is a random nonce.
+// The client answers with an 'A' whose key is the hex SHA-1 of that nonce
+// followed by the secret, then a random nonce of its own. The server hangs
+// up on a client that gets it wrong, or that takes too long to answer, and
+// otherwise replies with an 'a' whose key is the hex SHA-1 of the client's
+// nonce, the server's nonce, and the secret; a client doesn't use a server
+// that gets that wrong. This only authenticates the connection: what
+// follows is neither encrypted nor signed.
+//
+// With no secret, that proves nothing, so then tiles are only served on,
+// and asked of, loopback addresses.
+
+
+
+#ifndef _WIN32
+
+namespace {  // anonymous
+
+static const char magic[4]       = { 'O', 'T', 'S', '3' };
+static const size_t header_bytes = 16;
+static const size_t nonce_bytes  = 16;
+static const size_t answer_bytes = 40;  // Hex SHA-1
+
+// How long a client has to answer the challenge.
+static const int handshake_timeout_ms = 5000;
+
+// Nothing plausible is bigger, so anything that is isn't a request.
+static const size_t max_key   = 4096;
+static const size_t max_pixels = 64 * 1024 * 1024;
+
+// How long to leave alone a server that failed us.
+static const int64_t backoff_ms = 5000;
+
+// Most idle connections to keep open to each server.
+static const size_t max_idle = 8;
+
+
+
+struct Header {
+    char op         = 0;
+    char status     = 0;
+    uint32_t keylen = 0;
+    uint32_t size   = 0;
+};
+
+
+
+void
+encode(char* buf, const Header& h)
+{
+    memcpy(buf, magic, 4);
+    buf[4] = h.op;
+    buf[5] = h.status;
+    buf[6] = buf[7] = 0;
+    for (int i = 0; i < 4; ++i) {
+        buf[8 + i]  = char((h.keylen >> (8 * i)) & 0xff);
+        buf[12 + i] = char((h.size >> (8 * i)) & 0xff);
+    }
+}
+
+
+
+bool
+decode(const char* buf, Header& h)
+{
+    if (memcmp(buf, magic, 4))
+        return false;
+    h.op     = buf[4];
+    h.status = buf[5];
+    h.keylen = h.size = 0;
+    for (int i = 0; i < 4; ++i) {
+        h.keylen |= uint32_t((unsigned char)buf[8 + i]) << (8 * i);
+        h.size |= uint32_t((unsigned char)buf[12 + i]) << (8 * i);
+    }
+    return h.keylen <= max_key && h.size <= max_pixels;
+}
+
+
+
+int64_t
+now_ms()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch())
+        .count();
+}
+
+
+
+// Send all of the data, or return false.
+bool
+send_all(int fd, const void* data, size_t size)
+{
+#    ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;  // A closed connection is just an error
+#    else
+    const int flags = 0;
+#    endif
+    const char* p = (const char*)data;
+    while (size) {
+        ssize_t n = ::send(fd, p, size, flags);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= size_t(n);
+    }
+    return true;
+}
+
+
+
+// Receive exactly size bytes, or return false.
+bool
+recv_all(int fd, void* data, size_t size)
+{
+    char* p = (char*)data;
+    while (size) {
+        ssize_t n = ::recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= size_t(n);
+    }
+    return true;
+}
+
+
+
+// Send a request or reply: the header, the key, and the pixels if any.
+bool
+send_message(int fd, const Header& h, string_view key, const void* pixels)
+{
+    char buf[header_bytes];
+    encode(buf, h);
+    std::string msg(buf, header_bytes);
+    msg.append(key.data(), key.size());
+    if (pixels && h.size + msg.size() <= 64 * 1024) {
+        // Small enough to go in one packet
+        msg.append((const char*)pixels, h.size);
+        return send_all(fd, msg.data(), msg.size());
+    }
+    return send_all(fd, msg.data(), msg.size())
+           && (!pixels || send_all(fd, pixels, h.size));
+}
+
+
+
+// Set the timeouts of fd (none if timeout_ms is 0).
+void
+set_timeout(int fd, int timeout_ms)
+{
+    timeval tv;
+    tv.tv_sec  = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    // On Linux, this bounds connect() too.
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+
+
+void
+set_options(int fd, int timeout_ms)
+{
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#    ifdef SO_NOSIGPIPE
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#    endif
+    if (timeout_ms > 0)
+        set_timeout(fd, timeout_ms);
+}
+
+
+
+// Whether a is a loopback address, which only this machine can reach.
+bool
+is_loopback(const sockaddr* a)
+{
+    if (a->sa_family == AF_INET)
+        return (ntohl(((const sockaddr_in*)a)->sin_addr.s_addr) >> 24) == 127;
+    if (a->sa_family == AF_INET6) {
+        const in6_addr& a6(((const sockaddr_in6*)a)->sin6_addr);
+        return IN6_IS_ADDR_LOOPBACK(&a6)
+               || (IN6_IS_ADDR_V4MAPPED(&a6) && a6.s6_addr[12] == 127);
+    }
+    return false;
+}
+
+
+
+std::string
+random_nonce()
+{
+    static std::random_device rd;
+    static std::mutex rd_mutex;
+    std::string nonce(nonce_bytes, '\0');
+    std::lock_guard<std::mutex> lock(rd_mutex);
+    for (auto& n : nonce)
+        n = char(rd());
+    return nonce;
+}
+
+
+
+// The answer to the challenge `nonce` from one who knows `secret`. The
+// server's answer is to the client's nonce followed by its own, so that
+// it's never the answer to a challenge a client could be given.
+std::string
+challenge_answer(string_view nonce, string_view secret)
+{
+    SHA1 sha(nonce);
+    sha.append(secret);
+    return sha.digest();
+}
+
+
+
+// Compare without stopping at the first difference, so that the time
+// taken doesn't tell how much of a guess was right.
+bool
+same_answer(string_view a, string_view b)
+{
+    if (a.size() != b.size())
+        return false;
+    unsigned char diff = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+        diff |= (unsigned char)(a[i] ^ b[i]);
+    return diff == 0;
+}
+
+
+
+// As a client, answer the server's challenge on fd, and check the
+// server's answer to ours.
+bool
+answer_challenge(int fd, string_view secret)
+{
+    char buf[header_bytes];
+    Header h;
+    if (!recv_all(fd, buf, header_bytes) || !decode(buf, h) || h.op != 'C'
+        || h.keylen != nonce_bytes || h.size)
+        return false;
+    std::string nonce(nonce_bytes, '\0');
+    if (!recv_all(fd, &nonce[0], nonce_bytes))
+        return false;
+    std::string ours = random_nonce();
+    Header a;
+    a.op     = 'A';
+    a.keylen = uint32_t(answer_bytes + nonce_bytes);
+    if (!send_message(fd, a, challenge_answer(nonce, secret) + ours, nullptr)
+        || !recv_all(fd, buf, header_bytes) || !decode(buf, h) || h.op != 'a'
+        || h.keylen != answer_bytes || h.size)
+        return false;
+    std::string answer(answer_bytes, '\0');
+    return recv_all(fd, &answer[0], answer_bytes)
+           && same_answer(answer, challenge_answer(ours + nonce, secret));
+}
+
+}  // namespace
+
+
+
+struct RemoteTileCache::Server {
+    std::string name;  // As given, "host:port"
+    sockaddr_storage addr;
+    socklen_t addrlen = 0;
+    bool loopback     = false;
+    std::mutex mutex;  // Protects idle
+    std::vector<int> idle;
+    std::atomic<int64_t> down_until { 0 };
+
+    ~Server()
+    {
+        for (int fd : idle)
+            ::close(fd);
+    }
+
+    // A connection to the server, or -1 if it's down.
+    int connect(const RemoteTileCache& tier)
+    {
+        if (now_ms() < down_until)
+            return -1;
+        std::string secret = tier.secret();
+        if (secret.empty() && !loopback)
+            return -1;  // Nothing to tell it from an impostor
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (idle.size()) {
+                int fd = idle.back();
+                idle.pop_back();
+                return fd;
+            }
+        }
+        int fd = ::socket(addr.ss_family, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+        set_options(fd, tier.timeout_ms());
+        if (::connect(fd, (const sockaddr*)&addr, addrlen) < 0
+            || !answer_challenge(fd, secret)) {
+            ::close(fd);
+            failed();
+            return -1;
+        }
+        return fd;
+    }
+
+    // Done with connection fd, which may be used again if ok.
+    void release(int fd, bool ok)
+    {
+        if (ok) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (idle.size() < max_idle) {
+                idle.push_back(fd);
+                return;
+            }
+        }
+        ::close(fd);
+        if (!ok)
+            failed();
+    }
+
+    void failed() { down_until = now_ms() + backoff_ms; }
+};
+
+
+
+// The tiles we serve, and the threads serving them.
+struct RemoteTileCache::Listener {
+    RemoteTileCache& tier;
+    int fd        = -1;
+    bool loopback = false;  // Only listening on a loopback address
+    std::thread acceptor;
+    std::atomic<bool> stop { false };
+
+    // Connections, counted so that we can wait for them all to finish.
+    std::mutex conn_mutex;
+    std::condition_variable finished;
+    std::unordered_set<int> connections;
+
+    // Tiles, least recently used last.
+    struct Tile {
+        std::string key;
+        std::vector<char> pixels;
+    };
+    std::mutex tile_mutex;
+    std::list<Tile> lru;
+    std::unordered_map<std::string, std::list<Tile>::iterator> tiles;
+    long long bytes = 0;
+
+    Listener(RemoteTileCache& tier, int fd, bool loopback)
+        : tier(tier)
+        , fd(fd)
+        , loopback(loopback)
+    {
+        acceptor = std::thread([this]() { accept_loop(); });
+    }
+
+    ~Listener()
+    {
+        stop = true;
+        acceptor.join();
+        std::unique_lock<std::mutex> lock(conn_mutex);
+        for (int c : connections)
+            ::shutdown(c, SHUT_RDWR);  // Wakes its thread
+        finished.wait(lock, [&]() { return connections.empty(); });
+        ::close(fd);
+    }
+
+    void accept_loop()
+    {
+        while (!stop) {
+            pollfd p { fd, POLLIN, 0 };
+            if (::poll(&p, 1, 100) <= 0)
+                continue;  // Time to check whether to stop
+            int c = ::accept(fd, nullptr, nullptr);
+            if (c < 0)
+                continue;
+            std::lock_guard<std::mutex> lock(conn_mutex);
+            if (connections.size() >= size_t(tier.max_connections())) {
+                ::close(c);  // Busy enough; the client will read the file
+                continue;
+            }
+            set_options(c, handshake_timeout_ms);
+            connections.insert(c);
+            std::thread([this, c]() {
+                serve(c);
+                ::close(c);
+                std::lock_guard<std::mutex> lock(conn_mutex);
+                connections.erase(c);
+                finished.notify_all();
+            }).detach();
+        }
+    }
+
+    // Challenge the client on connection c, and if it knows the secret,
+    // answer its challenge and return true.
+    bool handshake(int c)
+    {
+        std::string nonce  = random_nonce();
+        std::string secret = tier.secret();
+        if (secret.empty() && !loopback)
+            return false;  // The secret was taken away since we started
+        Header h;
+        h.op     = 'C';
+        h.keylen = uint32_t(nonce_bytes);
+        char buf[header_bytes];
+        if (!send_message(c, h, nonce, nullptr)
+            || !recv_all(c, buf, header_bytes) || !decode(buf, h)
+            || h.op != 'A' || h.keylen != answer_bytes + nonce_bytes
+            || h.size)
+            return false;
+        std::string reply(h.keylen, '\0');
+        if (!recv_all(c, &reply[0], h.keylen)
+            || !same_answer(string_view(reply).substr(0, answer_bytes),
+                            challenge_answer(nonce, secret)))
+            return false;
+        std::string theirs = reply.substr(answer_bytes);
+        Header a;
+        a.op     = 'a';
+        a.keylen = uint32_t(answer_bytes);
+        return send_message(c, a, challenge_answer(theirs + nonce, secret),
+                            nullptr);
+    }
+
+    // Answer the requests on connection c until the client closes it.
+    void serve(int c)
+    {
+        if (!handshake(c))
+            return;
+        set_timeout(c, 0);  // Clients keep their connections for later
+        char buf[header_bytes];
+        std::string key;
+        std::vector<char> pixels;
+        Header h;
+        while (!stop && recv_all(c, buf, header_bytes) && decode(buf, h)) {
+            key.resize(h.keylen);
+            if (!recv_all(c, &key[0], h.keylen))
+                return;
+            if (h.op == 'G') {
+                Header reply;
+                reply.op = 'g';
+                if (get(key, pixels)) {
+                    reply.status = 1;
+                    reply.size   = uint32_t(pixels.size());
+                }
+                if (!send_message(c, reply, {},
+                                  reply.status ? pixels.data() : nullptr))
+                    return;
+            } else if (h.op == 'P') {
+                pixels.resize(h.size);
+                if (!recv_all(c, pixels.data(), h.size))
+                    return;
+                put(key, pixels);
+            } else {
+                return;  // Not a client we understand
+            }
+        }
+    }
+
+    bool get(const std::string& key, std::vector<char>& pixels)
+    {
+        std::lock_guard<std::mutex> lock(tile_mutex);
+        auto t = tiles.find(key);
+        if (t == tiles.end())
+            return false;
+        lru.splice(lru.begin(), lru, t->second);
+        pixels = t->second->pixels;
+        return true;
+    }
+
+    int count()
+    {
+        std::lock_guard<std::mutex> lock(tile_mutex);
+        return int(tiles.size());
+    }
+
+    void put(const std::string& key, const std::vector<char>& pixels)
+    {
+        std::lock_guard<std::mutex> lock(tile_mutex);
+        if (tiles.find(key) != tiles.end())
+            return;  // Another client gave it to us first
+        lru.push_front(Tile { key, pixels });
+        tiles[lru.front().key] = lru.begin();
+        bytes += (long long)pixels.size();
+        while (bytes > tier.max_bytes() && lru.size() > 1) {
+            Tile& old(lru.back());
+            bytes -= (long long)old.pixels.size();
+            tiles.erase(old.key);
+            lru.pop_back();
+        }
+    }
+};
+
+
+
+RemoteTileCache::~RemoteTileCache()
+{
+    // Stop serving before the rest of us goes away
+    m_listener.reset();
+}
+
+
+
+bool
+RemoteTileCache::set_servers(string_view list)
+{
+    std::vector<std::shared_ptr<Server>> servers;
+    bool ok = true;
+    for (auto name : Strutil::splitsv(list, ",")) {
+        name       = Strutil::strip(name);
+        size_t col = name.rfind(':');
+        if (name.empty())
+            continue;
+        if (col == string_view::npos) {
+            ok = false;
+            continue;
+        }
+        std::string host(name.substr(0, col)), port(name.substr(col + 1));
+        if (host.size() > 2 && host.front() == '[' && host.back() == ']')
+            host = host.substr(1, host.size() - 2);  // [::1]:port
+        addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* res     = nullptr;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) || !res) {
+            ok = false;
+            continue;
+        }
+        auto server  = std::make_shared<Server>();
+        server->name = name;
+        memcpy(&server->addr, res->ai_addr, res->ai_addrlen);
+        server->addrlen  = socklen_t(res->ai_addrlen);
+        server->loopback = is_loopback(res->ai_addr);
+        freeaddrinfo(res);
+        servers.push_back(std::move(server));
+    }
+    spin_lock lock(m_mutex);
+    m_servers.swap(servers);
+    m_enabled = !m_servers.empty();
+    return ok;
+}
+
+
+
+std::string
+RemoteTileCache::servers() const
+{
+    spin_lock lock(m_mutex);
+    std::string list;
+    for (auto& s : m_servers) {
+        if (list.size())
+            list += ',';
+        list += s->name;
+    }
+    return list;
+}
+
+
+
+std::shared_ptr<RemoteTileCache::Server>
+RemoteTileCache::server_for(string_view key) const
+{
+    spin_lock lock(m_mutex);
+    if (m_servers.empty())
+        return {};
+    return m_servers[Strutil::strhash64(key) % m_servers.size()];
+}
+
+
+
+bool
+RemoteTileCache::read(const TileID& id, void* pixels, size_t size)
+{
+    if (!m_enabled || size > max_pixels)
+        return false;
+    std::string key = DiskTileCache::tile_key(id, size);
+    if (key.empty() || key.size() > max_key)
+        return false;
+    std::shared_ptr<Server> server = server_for(key);
+    int fd = server ? server->connect(*this) : -1;
+    if (fd < 0)
+        return false;
+    Header h;
+    h.op     = 'G';
+    h.keylen = uint32_t(key.size());
+    h.size   = uint32_t(size);
+    char buf[header_bytes];
+    bool ok = send_message(fd, h, key, nullptr)
+              && recv_all(fd, buf, header_bytes) && decode(buf, h)
+              && h.op == 'g';
+
+    bool found = ok && h.status == 1;
+    if (found && h.size != size)
+        ok = found = false;  // Can't be the same tile
+    else if (found)
+        ok = found = recv_all(fd, pixels, size);
+    server->release(fd, ok);
+    return found;
+}
+
+
+
+void
+RemoteTileCache::write(const TileID& id, const void* pixels, size_t size)
+{
+    if (!m_enabled || !size || size > max_pixels)
+        return;
+    std::string key = DiskTileCache::tile_key(id, size);
+    if (key.empty() || key.size() > max_key)
+        return;
+    std::shared_ptr<Server> server = server_for(key);
+    int fd = server ? server->connect(*this) : -1;
+    if (fd < 0)
+        return;
+    Header h;
+    h.op     = 'P';
+    h.keylen = uint32_t(key.size());
+    h.size   = uint32_t(size);
+    server->release(fd, send_message(fd, h, key, pixels));
+}
+
+
+
+std::string
+RemoteTileCache::address() const
+{
+    spin_lock lock(m_mutex);
+    return m_address;
+}
+
+
+
+bool
+RemoteTileCache::set_address(string_view address)
+{
+    std::lock_guard<std::mutex> listening(m_listen_mutex);
+    int port;
+    {
+        spin_lock lock(m_mutex);
+        m_address = address;
+        port      = m_port;
+    }
+    return listen(port);  // Listen there instead, if we're listening
+}
+
+
+
+std::string
+RemoteTileCache::secret() const
+{
+    spin_lock lock(m_mutex);
+    return m_secret;
+}
+
+
+
+void
+RemoteTileCache::set_secret(string_view secret)
+{
+    std::lock_guard<std::mutex> listening(m_listen_mutex);
+    std::shared_ptr<Listener> old;
+    {
+        spin_lock lock(m_mutex);
+        m_secret = secret;
+        if (secret.empty() && m_listener && !m_listener->loopback) {
+            // Without a secret, stop serving anyone who can reach us
+            old.swap(m_listener);
+            m_port = 0;
+        }
+    }
+    old.reset();  // Stops serving, outside the lock
+}
+
+
+
+int
+RemoteTileCache::tiles_served() const
+{
+    std::shared_ptr<Listener> listener;
+    {
+        spin_lock lock(m_mutex);
+        listener = m_listener;
+    }
+    return listener ? listener->count() : 0;
+}
+
+
+
+bool
+RemoteTileCache::set_port(int port)
+{
+    std::lock_guard<std::mutex> listening(m_listen_mutex);
+    return listen(port);
+}
+
+
+
+bool
+RemoteTileCache::listen(int port)
+{
+    std::shared_ptr<Listener> old;
+    std::string address, secret;
+    {
+        spin_lock lock(m_mutex);
+        old.swap(m_listener);
+        m_port  = 0;
+        address = m_address;
+        secret  = m_secret;
+    }
+    old.reset();  // Stops serving, outside the lock
+    if (port <= 0)
+        return port == 0;
+    if (port > 65535)
+        return false;
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags    = AI_PASSIVE;  // All interfaces if no address
+    addrinfo* res     = nullptr;
+    std::string service = Strutil::to_string(port);
+    if (getaddrinfo(address.size() ? address.c_str() : nullptr,
+                    service.c_str(), &hints, &res)
+        || !res)
+        return false;
+    bool loopback = is_loopback(res->ai_addr);
+    if (secret.empty() && !loopback) {
+        freeaddrinfo(res);
+        return false;  // Only with a secret may other hosts reach us
+    }
+    int fd = ::socket(res->ai_family, SOCK_STREAM, 0);
+    if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (::bind(fd, res->ai_addr, res->ai_addrlen) < 0
+            || ::listen(fd, 64) < 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    if (fd < 0)
+        return false;
+    auto listener = std::make_shared<Listener>(*this, fd, loopback);
+    spin_lock lock(m_mutex);
+    m_listener.swap(listener);
+    m_port = port;
+    return true;
+}
+
+
+
+#else  // _WIN32
+
+// No tile servers on this platform: every tile is read from its file.
+
+struct RemoteTileCache::Server {};
+struct RemoteTileCache::Listener {};
+
+RemoteTileCache::~RemoteTileCache() {}
+
+bool
+RemoteTileCache::set_servers(string_view list)
+{
+    return Strutil::strip(list).empty();
+}
+
+std::string
+RemoteTileCache::servers() const
+{
+    return {};
+}
+
+std::shared_ptr<RemoteTileCache::Server>
+RemoteTileCache::server_for(string_view /*key*/) const
+{
+    return {};
+}
+
+bool
+RemoteTileCache::read(const TileID& /*id*/, void* /*pixels*/, size_t /*size*/)
+{
+    return false;
+}
+
+void
+RemoteTileCache::write(const TileID& /*id*/, const void* /*pixels*/,
+                       size_t /*size*/)
+{
+}
+
+bool
+RemoteTileCache::set_port(int port)
+{
+    return port == 0;
+}
+
+std::string
+RemoteTileCache::address() const
+{
+    spin_lock lock(m_mutex);
+    return m_address;
+}
+
+bool
+RemoteTileCache::set_address(string_view address)
+{
+    spin_lock lock(m_mutex);
+    m_address = address;
+    return true;
+}
+
+std::string
+RemoteTileCache::secret() const
+{
+    spin_lock lock(m_mutex);
+    return m_secret;
+}
+
+void
+RemoteTileCache::set_secret(string_view secret)
+{
+    spin_lock lock(m_mutex);
+    m_secret = secret;
+}
+
+int
+RemoteTileCache::tiles_served() const
+{
+    return 0;
+}
+
+#endif
+
+OIIO_NAMESPACE_END
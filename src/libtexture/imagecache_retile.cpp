@@ -0,0 +1,154 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <ctime>
+#include <string>
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/strutil.h>
+
+#include "imagecache_pvt.h"
+
+OIIO_NAMESPACE_BEGIN
+
+
+
+bool
+RetileCache::set_directory(string_view dir)
+{
+    std::string d(dir);
+    if (d.size() && !Filesystem::is_directory(d)
+        && !Filesystem::create_directory(d)) {
+        d.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dir     = d;
+        m_enabled = !d.empty();
+    }
+    if (d.size() && m_trim_mutex.try_lock()) {
+        // Measure what's already there
+        m_bytes = trim_cache_directory(d, "\\.otx$", m_max_bytes);
+        m_trim_mutex.unlock();
+    }
+    return d.size() || dir.empty();
+}
+
+
+
+std::string
+RetileCache::directory() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dir;
+}
+
+
+
+std::string
+RetileCache::retile_key(ustring source)
+{
+    if (source.empty() || Filesystem::is_url(source)
+        || !Filesystem::is_regular(source))
+        return {};
+    return Strutil::fmt::format("{}@{}@{}", source,
+                                (long long)Filesystem::last_write_time(source),
+                                Filesystem::file_size(source));
+}
+
+
+
+std::string
+RetileCache::retile_path(const std::string& dir, const std::string& key)
+{
+    std::string hash = Strutil::fmt::format("{:016x}", Strutil::strhash64(key));
+    return Strutil::fmt::format("{}/{}/{}.otx", dir, hash.substr(0, 2), hash);
+}
+
+
+
+ustring
+RetileCache::find(ustring source) const
+{
+    std::string key = retile_key(source);
+    if (key.empty())
+        return {};
+    std::string path = retile_path(directory(), key);
+    return Filesystem::exists(path) ? ustring(path) : ustring();
+}
+
+
+
+bool
+RetileCache::wanted(const ImageCacheImpl& imagecache,
+                    const ImageCacheFile& file) const
+{
+    // Only a single image read from a plain file, exactly as it's stored,
+    // can be replaced by a copy of it.
+    if (!enabled() || file.filename() != file.source() || file.creator()
+        || file.is_udim() || file.subimages() != 1
+        || file.fileformat() == "otx" || file.nativespec(0, 0).deep
+        || file.miplevels(0) != 1 || file.nativespec(0, 0).depth > 1)
+        return false;
+    const ImageCacheFile::SubimageInfo& si(file.subimageinfo(0));
+    return si.untiled || (si.unmipped && imagecache.automip());
+}
+
+
+
+bool
+RetileCache::make(ustring source, int tilesize, bool mipmap)
+{
+    std::string key = retile_key(source);
+    std::string dir;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (key.empty() || m_dir.empty() || m_making.count(key))
+            return false;
+        m_making.insert(key);
+        dir = m_dir;
+    }
+    std::string path = retile_path(dir, key);
+    bool ok          = Filesystem::exists(path);  // Made by another process?
+    if (!ok) {
+        // make_texture writes under a temporary name and then renames, so
+        // no reader (in this or another process) ever sees a partial copy.
+        std::string subdir = Filesystem::parent_path(path);
+        ImageSpec config;
+        config.tile_width  = tilesize;
+        config.tile_height = tilesize;
+        config.tile_depth  = 1;
+        config.attribute("maketx:fileformatname", "otx");
+        config.attribute("maketx:nomipmap", int(!mipmap));
+        config.attribute("maketx:stream", 1);
+        ok = (Filesystem::is_directory(subdir)
+              || Filesystem::create_directory(subdir))
+             && ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture,
+                                           source, path, config);
+        if (ok) {
+            ++m_made;
+            m_bytes += (long long)Filesystem::file_size(path);
+            if (m_bytes > m_max_bytes && m_trim_mutex.try_lock()) {
+                m_bytes = trim_cache_directory(dir, "\\.otx$", m_max_bytes);
+                m_trim_mutex.unlock();
+                ok = Filesystem::exists(path);  // Unless too big to keep
+            }
+        } else {
+            (void)OIIO::geterror();  // A failed copy isn't an error
+        }
+    } else {
+        // Mark it recently used, so that it's deleted last.
+        Filesystem::last_write_time(path, std::time(nullptr));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_making.erase(key);
+    }
+    return ok;
+}
+
+OIIO_NAMESPACE_END
@@ -0,0 +1,374 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/platform.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/thread.h>
+
+#include "imagecache_pvt.h"
+
+OIIO_NAMESPACE_BEGIN
+
+namespace {  // anonymous
+
+// The segment is this header, then a SetHeader for each set, then the
+// slots, set by set. Everything in it is at a fixed offset from its start,
+// since each process maps it at a different address.
+struct SegmentHeader {
+    char magic[8];
+    uint32_t version;
+    std::atomic<uint32_t> ready;  ///< Nonzero once the creator is done
+    uint64_t nsets;
+    uint64_t ways;
+    uint64_t slot_bytes;
+};
+
+struct SetHeader {
+    std::atomic<uint32_t> lock;
+    uint32_t hand;  ///< Clock hand, the next way to consider evicting
+};
+
+// Longest key that can be stored, currently far longer than any plausible
+// file name plus the rest of the key.
+static const size_t max_key = 1024;
+
+struct SlotHeader {
+    uint64_t hash;
+    uint64_t size;  ///< Bytes of pixels, or 0 if the slot is empty
+    uint32_t keylen;
+    uint32_t used;  ///< Read since the clock hand last passed?
+    char key[max_key];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "shared memory needs address-free atomics");
+
+static const char segment_magic[8] = { 'O', 'I', 'I', 'O',
+                                       's', 'h', 'm', '1' };
+static const uint32_t segment_version = 1;
+static const uint64_t segment_ways    = 8;
+
+// Everything is aligned to this, to keep the sets' locks on separate cache
+// lines and the pixels aligned for SIMD.
+static const size_t segment_align = 64;
+
+static size_t
+align_up(size_t n)
+{
+    return (n + segment_align - 1) & ~(segment_align - 1);
+}
+
+
+
+// Try for a while to lock a set. A process that died holding the lock
+// would otherwise hang all the others, so give up after a while, and the
+// caller treats the set as though the tile weren't there.
+static bool
+lock_set(SetHeader& set)
+{
+    for (int i = 0; i < 4096; ++i) {
+        uint32_t unlocked = 0;
+        if (set.lock.compare_exchange_weak(unlocked, 1,
+                                           std::memory_order_acquire))
+            return true;
+        if (i < 64)
+            pause(4);
+        else
+            std::this_thread::yield();
+    }
+    return false;
+}
+
+static void
+unlock_set(SetHeader& set)
+{
+    set.lock.store(0, std::memory_order_release);
+}
+
+}  // namespace
+
+
+
+// A mapping of the shared segment into this process.
+struct SharedTileCache::Segment {
+    char* base  = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE handle = nullptr;
+#endif
+
+    ~Segment()
+    {
+        if (!base)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(base);
+        CloseHandle(handle);
+#else
+        munmap(base, size);
+#endif
+    }
+
+    SegmentHeader& header() const { return *(SegmentHeader*)base; }
+    uint64_t nsets() const { return header().nsets; }
+    // Each slot is its header and then room for slot_bytes of pixels.
+    static size_t slot_stride()
+    {
+        return align_up(align_up(sizeof(SlotHeader)) + slot_bytes);
+    }
+    SetHeader& set(uint64_t s) const
+    {
+        return *(SetHeader*)(base + align_up(sizeof(SegmentHeader))
+                             + s * align_up(sizeof(SetHeader)));
+    }
+    SlotHeader& slot(uint64_t s, uint64_t way) const
+    {
+        size_t first = align_up(sizeof(SegmentHeader))
+                       + nsets() * align_up(sizeof(SetHeader));
+        return *(SlotHeader*)(base + first
+                              + (s * segment_ways + way) * slot_stride());
+    }
+    char* pixels(SlotHeader& slot) const
+    {
+        return (char*)&slot + align_up(sizeof(SlotHeader));
+    }
+
+    // The total size of a segment of nsets sets.
+    static size_t bytes_needed(uint64_t nsets)
+    {
+        return align_up(sizeof(SegmentHeader))
+               + nsets * align_up(sizeof(SetHeader))
+               + nsets * segment_ways * slot_stride();
+    }
+
+    static std::shared_ptr<Segment> open(const std::string& name,
+                                         long long max_bytes);
+};
+
+
+
+std::shared_ptr<SharedTileCache::Segment>
+SharedTileCache::Segment::open(const std::string& name, long long max_bytes)
+{
+    long long setsize = (long long)(slot_stride() * segment_ways);
+    uint64_t nsets    = uint64_t(std::max(1LL, max_bytes / setsize));
+    size_t size       = bytes_needed(nsets);
+    std::shared_ptr<Segment> seg(new Segment);
+    bool created = false;
+#ifdef _WIN32
+    // A named mapping backed by the paging file lasts as long as any
+    // process has it open.
+    std::wstring wname = Strutil::utf8_to_utf16wstring(name);
+    seg->handle        = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr,
+                                            PAGE_READWRITE,
+                                            DWORD(uint64_t(size) >> 32),
+                                            DWORD(size), wname.c_str());
+    if (!seg->handle)
+        return {};
+    created   = (GetLastError() != ERROR_ALREADY_EXISTS);
+    seg->base = (char*)MapViewOfFile(seg->handle, FILE_MAP_ALL_ACCESS, 0, 0,
+                                     0);
+    if (!seg->base)
+        return {};
+    MEMORY_BASIC_INFORMATION info;
+    if (!VirtualQuery(seg->base, &info, sizeof(info)))
+        return {};
+    seg->size = info.RegionSize;
+#else
+    // POSIX names are a single component starting with a slash.
+    std::string shmname = name[0] == '/' ? name : "/" + name;
+    int fd = shm_open(shmname.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+    if (fd >= 0) {
+        created = true;
+        bool ok = ftruncate(fd, off_t(size)) == 0;
+#    ifdef __linux__
+        // Reserve the memory now: on a full /dev/shm, touching the pages
+        // later would be a SIGBUS rather than an error.
+        ok &= posix_fallocate(fd, 0, off_t(size)) == 0;
+#    endif
+        if (!ok) {
+            ::close(fd);
+            shm_unlink(shmname.c_str());
+            return {};
+        }
+    } else if (errno == EEXIST) {
+        fd = shm_open(shmname.c_str(), O_RDWR, 0);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0)
+            size = size_t(st.st_size);
+        else
+            size = 0;
+    }
+    if (fd < 0)
+        return {};
+    void* base = size >= sizeof(SegmentHeader)
+                     ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                            fd, 0)
+                     : MAP_FAILED;
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+    if (base == MAP_FAILED)
+        return {};
+    seg->base = (char*)base;
+    seg->size = size;
+#endif
+
+    SegmentHeader& header(seg->header());
+    if (created) {
+        // The new memory is all zeroes, that is, unlocked empty slots.
+        memcpy(header.magic, segment_magic, sizeof(header.magic));
+        header.version    = segment_version;
+        header.nsets      = nsets;
+        header.ways       = segment_ways;
+        header.slot_bytes = slot_bytes;
+        header.ready.store(1, std::memory_order_release);
+        return seg;
+    }
+    // Another process made it, and may not have finished setting it up.
+    for (int i = 0; i < 1000 && !header.ready.load(std::memory_order_acquire);
+         ++i)
+        Sysutil::usleep(1000);
+    if (!header.ready.load(std::memory_order_acquire)
+        || memcmp(header.magic, segment_magic, sizeof(header.magic))
+        || header.version != segment_version || header.ways != segment_ways
+        || header.slot_bytes != slot_bytes || header.nsets < 1
+        || bytes_needed(header.nsets) > seg->size)
+        return {};
+    return seg;
+}
+
+
+
+bool
+SharedTileCache::set_name(string_view name)
+{
+    std::shared_ptr<Segment> seg;
+    if (name.size())
+        seg = Segment::open(name, m_max_bytes);
+    spin_lock lock(m_mutex);
+    m_segment = seg;
+    m_name    = seg ? std::string(name) : std::string();
+    m_enabled = bool(seg);
+    return seg || name.empty();
+}
+
+
+
+std::string
+SharedTileCache::name() const
+{
+    spin_lock lock(m_mutex);
+    return m_name;
+}
+
+
+
+std::shared_ptr<SharedTileCache::Segment>
+SharedTileCache::segment() const
+{
+    spin_lock lock(m_mutex);
+    return m_segment;
+}
+
+
+
+bool
+SharedTileCache::read(const TileID& id, void* pixels, size_t size)
+{
+    std::shared_ptr<Segment> seg = segment();
+    if (!seg || size > slot_bytes)
+        return false;
+    std::string key = DiskTileCache::tile_key(id, size);
+    if (key.empty() || key.size() > max_key)
+        return false;
+    uint64_t hash = Strutil::strhash64(key);
+    uint64_t s    = hash % seg->nsets();
+    SetHeader& set(seg->set(s));
+    if (!lock_set(set))
+        return false;
+    bool found = false;
+    for (uint64_t w = 0; w < segment_ways && !found; ++w) {
+        SlotHeader& slot(seg->slot(s, w));
+        if (slot.size == size && slot.hash == hash && slot.keylen == key.size()
+            && !memcmp(slot.key, key.data(), key.size())) {
+            memcpy(pixels, seg->pixels(slot), size);
+            slot.used = 1;
+            found     = true;
+        }
+    }
+    unlock_set(set);
+    return found;
+}
+
+
+
+void
+SharedTileCache::write(const TileID& id, const void* pixels, size_t size)
+{
+    std::shared_ptr<Segment> seg = segment();
+    if (!seg || !size || size > slot_bytes)
+        return;
+    std::string key = DiskTileCache::tile_key(id, size);
+    if (key.empty() || key.size() > max_key)
+        return;
+    uint64_t hash = Strutil::strhash64(key);
+    uint64_t s    = hash % seg->nsets();
+    SetHeader& set(seg->set(s));
+    if (!lock_set(set))
+        return;
+    // Another process may have stored it meanwhile; otherwise take an
+    // empty way, or else the first one the clock hand finds unused.
+    uint64_t victim = segment_ways;
+    for (uint64_t w = 0; w < segment_ways; ++w) {
+        SlotHeader& slot(seg->slot(s, w));
+        if (slot.size == size && slot.hash == hash && slot.keylen == key.size()
+            && !memcmp(slot.key, key.data(), key.size())) {
+            unlock_set(set);
+            return;
+        }
+        if (!slot.size && victim == segment_ways)
+            victim = w;
+    }
+    if (victim == segment_ways) {
+        for (;;) {
+            uint64_t w = set.hand % segment_ways;
+            set.hand   = uint32_t((w + 1) % segment_ways);
+            SlotHeader& slot(seg->slot(s, w));
+            if (!slot.used) {
+                victim = w;
+                break;
+            }
+            slot.used = 0;
+        }
+    }
+    SlotHeader& slot(seg->slot(s, victim));
+    slot.hash   = hash;
+    slot.size   = size;
+    slot.keylen = uint32_t(key.size());
+    slot.used   = 0;
+    memcpy(slot.key, key.data(), key.size());
+    memcpy(seg->pixels(slot), pixels, size);
+    unlock_set(set);
+}
+
+OIIO_NAMESPACE_END
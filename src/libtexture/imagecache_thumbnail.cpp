@@ -0,0 +1,346 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/strutil.h>
+
+#include "imagecache_pvt.h"
+
+OIIO_NAMESPACE_BEGIN
+
+namespace {  // anonymous
+
+// Thumbnails are this many pixels across (at most), in their larger
+// dimension.
+static const int standard_sizes[] = { 64, 128, 256, 512, 1024 };
+
+// Each thumbnail file is this header, then the key (so that a hash
+// collision can never return the wrong thumbnail), then the spec
+// (ImageSpec::to_binary()), then the pixels.
+struct ThumbnailHeader {
+    char magic[8];
+    uint64_t keylen;
+    uint64_t speclen;
+    uint64_t size;
+};
+
+static const char thumbnail_magic[8] = { 'O', 'I', 'I', 'O',
+                                         't', 'h', 'm', '1' };
+
+}  // namespace
+
+
+
+void
+ThumbnailCache::set_size(int size)
+{
+    int s = 0;
+    if (size > 0) {
+        s = standard_sizes[std::size(standard_sizes) - 1];
+        for (int std_size : standard_sizes) {
+            if (std_size >= size) {
+                s = std_size;
+                break;
+            }
+        }
+    }
+    m_size = s;
+}
+
+
+
+bool
+ThumbnailCache::set_directory(string_view dir)
+{
+    std::string d(dir);
+    if (d.size() && !Filesystem::is_directory(d)
+        && !Filesystem::create_directory(d)) {
+        d.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dir = d;
+    }
+    if (d.size() && m_trim_mutex.try_lock()) {
+        // Measure what's already there
+        m_bytes = trim_cache_directory(d, "\\.thumb$", m_max_bytes);
+        m_trim_mutex.unlock();
+    }
+    return d.size() || dir.empty();
+}
+
+
+
+std::string
+ThumbnailCache::directory() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dir;
+}
+
+
+
+void
+ThumbnailCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_thumbs.clear();
+    m_lru.clear();
+    m_memory_bytes = 0;
+}
+
+
+
+std::string
+ThumbnailCache::thumbnail_key(const ImageCacheFile& file, int subimage,
+                              int size)
+{
+    if (!file.mod_time() || file.creator())
+        return {};  // e.g., an application buffer
+    uint64_t filesize = Filesystem::file_size(file.filename());
+    return Strutil::fmt::format("{}@{}@{}|{}|{}", file.filename(),
+                                (long long)file.mod_time(), filesize,
+                                subimage, size);
+}
+
+
+
+bool
+ThumbnailCache::get(ImageCacheImpl& imagecache, ImageCacheFile* file,
+                    ImageCachePerThreadInfo* thread_info, ImageBuf& thumb,
+                    int subimage)
+{
+    int size        = m_size;
+    std::string key = thumbnail_key(*file, subimage, size);
+    if (key.empty())
+        return make(imagecache, file, thread_info, subimage, size, thumb);
+
+    std::string dir;
+    {
+        // If another thread is making this one, wait for it rather than
+        // making it twice.
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_made.wait(lock, [&]() { return !m_making.count(key); });
+        auto found = m_thumbs.find(key);
+        if (found != m_thumbs.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, found->second.lru);
+            return thumb.copy(*found->second.thumb);
+        }
+        m_making.insert(key);
+        dir = m_dir;
+    }
+
+    auto made = std::make_shared<ImageBuf>();
+    bool ok   = dir.size() && read_file(dir, key, *made);
+    if (!ok) {
+        ok = make(imagecache, file, thread_info, subimage, size, *made);
+        if (ok && dir.size())
+            write_file(dir, key, *made);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_making.erase(key);
+        if (ok)
+            remember(key, made);
+    }
+    m_made.notify_all();
+    return ok && thumb.copy(*made);
+}
+
+
+
+void
+ThumbnailCache::remember(const std::string& key,
+                         std::shared_ptr<const ImageBuf> thumb)
+{
+    long long bytes = (long long)thumb->spec().image_bytes();
+    m_lru.push_front(key);
+    m_thumbs[key] = Entry { std::move(thumb), m_lru.begin() };
+    m_memory_bytes += bytes;
+    while (m_memory_bytes > max_memory_bytes && m_lru.size() > 1) {
+        auto oldest = m_thumbs.find(m_lru.back());
+        const ImageSpec& spec(oldest->second.thumb->spec());
+        m_memory_bytes -= (long long)spec.image_bytes();
+        m_thumbs.erase(oldest);
+        m_lru.pop_back();
+    }
+}
+
+
+
+bool
+ThumbnailCache::make(ImageCacheImpl& imagecache, ImageCacheFile* file,
+                     ImageCachePerThreadInfo* thread_info, int subimage,
+                     int size, ImageBuf& thumb)
+{
+    std::shared_ptr<ImageInput> inp = file->open(thread_info);
+    if (!inp)
+        return false;  // indicates a broken file
+    if (subimage < 0 || subimage >= file->subimages())
+        return false;
+
+    // Find the cheapest source that is at least `size` across. First, the
+    // embedded thumbnail.
+    ImageBuf src;
+    if (!inp->get_thumbnail(src, subimage))
+        inp->geterror();  // Not having one isn't an error
+    else if (std::max(src.spec().width, src.spec().height) < size)
+        src.reset();
+    inp.reset();
+
+    // Next, the coarsest MIP level that's big enough (from the cache).
+    int nmip = file->miplevels(subimage);
+    for (int m = nmip - 1; m > 0 && !src.initialized(); --m) {
+        const ImageSpec& mipspec(file->spec(subimage, m));
+        if (std::max(mipspec.width, mipspec.height) < size
+            || mipspec.depth > 1)
+            continue;
+        ImageSpec spec(mipspec.width, mipspec.height, mipspec.nchannels,
+                       mipspec.format);
+        spec.channelnames  = mipspec.channelnames;
+        spec.alpha_channel = mipspec.alpha_channel;
+        src.reset(spec, InitializePixels::No);
+        if (!imagecache.get_pixels(file, thread_info, subimage, m, mipspec.x,
+                                   mipspec.x + mipspec.width, mipspec.y,
+                                   mipspec.y + mipspec.height, mipspec.z,
+                                   mipspec.z + 1, mipspec.format,
+                                   src.localpixels()))
+            src.reset();
+    }
+
+    // Finally, ask the reader to reduce the resolution as it decodes, which
+    // most formats can't and so read the whole image.
+    if (!src.initialized()) {
+        const ImageSpec& spec(file->spec(subimage, 0));
+        int reduce = std::max(spec.width, spec.height) / size;
+        ImageSpec config;
+        config.attribute("oiio:reduce_factor", std::max(1, reduce));
+        src.reset(file->filename(), subimage, 0, nullptr, &config);
+        if (!src.read(subimage, 0, true)) {
+            src.geterror();
+            return false;
+        }
+    }
+
+    // Resize to fit within size x size (but never enlarge).
+    int w = src.spec().width, h = src.spec().height;
+    if (std::max(w, h) <= size) {
+        thumb.swap(src);
+        return true;
+    }
+    if (w >= h) {
+        h = std::max(1, int(int64_t(h) * size / w));
+        w = size;
+    } else {
+        w = std::max(1, int(int64_t(w) * size / h));
+        h = size;
+    }
+    thumb.reset();
+    bool ok = ImageBufAlgo::resize(thumb, src, {},
+                                   ROI(0, w, 0, h, 0, 1, 0,
+                                       src.spec().nchannels));
+    if (!ok)
+        thumb.geterror();
+    return ok;
+}
+
+
+
+bool
+ThumbnailCache::read_file(const std::string& dir, const std::string& key,
+                          ImageBuf& thumb)
+{
+    std::string hash = Strutil::fmt::format("{:016x}", Strutil::strhash64(key));
+    std::string path = Strutil::fmt::format("{}/{}/{}.thumb", dir,
+                                            hash.substr(0, 2), hash);
+    FILE* f          = Filesystem::fopen(path, "rb");
+    if (!f)
+        return false;
+    ThumbnailHeader header;
+    std::string filekey(key.size(), '\0');
+    std::string specdata;
+    ImageSpec spec;
+    bool ok = fread(&header, sizeof(header), 1, f) == 1
+              && !memcmp(header.magic, thumbnail_magic, sizeof(header.magic))
+              && header.keylen == key.size() && header.speclen < (1 << 24)
+              && fread(&filekey[0], 1, key.size(), f) == key.size()
+              && filekey == key;
+    if (ok) {
+        specdata.resize(size_t(header.speclen));
+        ok = fread(&specdata[0], 1, specdata.size(), f) == specdata.size()
+             && spec.from_binary(specdata) && spec.image_bytes() == header.size
+             && spec.depth == 1;
+    }
+    if (ok) {
+        thumb.reset(spec, InitializePixels::No);
+        ok = fread(thumb.localpixels(), 1, size_t(header.size), f)
+             == header.size;
+    }
+    fclose(f);
+    // Mark it recently used, so that it's deleted last.
+    if (ok)
+        Filesystem::last_write_time(path, std::time(nullptr));
+    else
+        thumb.reset();
+    return ok;
+}
+
+
+
+void
+ThumbnailCache::write_file(const std::string& dir, const std::string& key,
+                           const ImageBuf& thumb)
+{
+    if (!thumb.localpixels())
+        return;
+    std::string hash = Strutil::fmt::format("{:016x}", Strutil::strhash64(key));
+    std::string subdir = Strutil::fmt::format("{}/{}", dir, hash.substr(0, 2));
+    std::string path   = Strutil::fmt::format("{}/{}.thumb", subdir, hash);
+    if (!Filesystem::is_directory(subdir)
+        && !Filesystem::create_directory(subdir))
+        return;
+    // Write under a temporary name and then rename, so that no reader (in
+    // this or another process) ever sees a partially written thumbnail.
+    std::string temp = Strutil::fmt::format("{}.{}.tmp", path,
+                                            Filesystem::unique_path());
+    FILE* f          = Filesystem::fopen(temp, "wb");
+    if (!f)
+        return;
+    std::string specdata = thumb.spec().to_binary();
+    ThumbnailHeader header;
+    memcpy(header.magic, thumbnail_magic, sizeof(header.magic));
+    header.keylen  = key.size();
+    header.speclen = specdata.size();
+    header.size    = thumb.spec().image_bytes();
+    bool ok        = fwrite(&header, sizeof(header), 1, f) == 1
+              && fwrite(key.data(), 1, key.size(), f) == key.size()
+              && fwrite(specdata.data(), 1, specdata.size(), f)
+                     == specdata.size()
+              && fwrite(thumb.localpixels(), 1, size_t(header.size), f)
+                     == header.size;
+    ok &= (fclose(f) == 0);
+    if (!ok || !Filesystem::rename(temp, path)) {
+        Filesystem::remove(temp);
+        return;
+    }
+    m_bytes += (long long)(sizeof(header) + key.size() + specdata.size()
+                           + header.size);
+    if (m_bytes > m_max_bytes && m_trim_mutex.try_lock()) {
+        m_bytes = trim_cache_directory(dir, "\\.thumb$", m_max_bytes);
+        m_trim_mutex.unlock();
+    }
+}
+
+OIIO_NAMESPACE_END
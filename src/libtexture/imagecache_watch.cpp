@@ -0,0 +1,196 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#    include <fcntl.h>
+#    include <sys/inotify.h>
+#    include <unistd.h>
+#endif
+
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/thread.h>
+
+#include "imagecache_pvt.h"
+
+OIIO_NAMESPACE_BEGIN
+
+
+#ifdef __linux__
+
+// Changes to a directory's entries that could change an image file:
+// written, renamed into or out of place, removed, or touched.
+static const uint32_t watch_events = IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB
+                                     | IN_CREATE | IN_DELETE | IN_MOVED_FROM
+                                     | IN_MOVED_TO | IN_DELETE_SELF
+                                     | IN_MOVE_SELF;
+
+
+
+bool
+FileChangeWatcher::enable(bool on)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (on == m_enabled)
+        return true;
+    if (on) {
+        m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_fd < 0)
+            return false;
+        // Nothing has been watched yet, so the first look must be at all
+        // the files, which watches their directories.
+        m_missed = true;
+    } else {
+        ::close(m_fd);  // Which removes all its watches
+        m_fd = -1;
+        m_dirs.clear();
+        m_watches.clear();
+        m_names.clear();
+        m_unwatched.clear();
+    }
+    m_enabled = on;
+    return true;
+}
+
+
+
+bool
+FileChangeWatcher::watch_dir(const std::string& dir)
+{
+    if (m_dirs.find(dir) != m_dirs.end())
+        return true;
+    int wd = inotify_add_watch(m_fd, dir.empty() ? "." : dir.c_str(),
+                               watch_events);
+    if (wd < 0)
+        return false;  // No such directory, or out of watches
+    m_dirs[dir]   = wd;
+    m_watches[wd] = dir;
+    return true;
+}
+
+
+
+void
+FileChangeWatcher::watch(ustring name, ustring filename)
+{
+    if (!m_enabled)
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0)
+        return;
+    auto range = m_names.equal_range(filename);
+    bool known = false;
+    for (auto i = range.first; i != range.second && !known; ++i)
+        known = (i->second == name);
+    if (!known)
+        m_names.emplace(filename, name);
+    size_t slash = filename.rfind('/');
+    std::string dir(slash == ustring::npos ? string_view()
+                                           : filename.substr(0, slash + 1));
+    if (watch_dir(dir))
+        m_unwatched.erase(name);
+    else
+        m_unwatched.insert(name);
+}
+
+
+
+bool
+FileChangeWatcher::changes(std::vector<ustring>& changed,
+                           std::vector<ustring>& unwatched)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0)
+        return false;
+    alignas(inotify_event) char buf[16384];
+    for (;;) {
+        ssize_t n = ::read(m_fd, buf, sizeof(buf));
+        if (n <= 0)
+            break;  // EAGAIN -- no more events for now
+        for (char* p = buf; p < buf + n;) {
+            const inotify_event* ev = (const inotify_event*)p;
+            p += sizeof(inotify_event) + ev->len;
+            if (ev->mask & IN_Q_OVERFLOW) {
+                m_missed = true;
+                continue;
+            }
+            auto w = m_watches.find(ev->wd);
+            if (w == m_watches.end())
+                continue;
+            if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                // The directory itself went away, so its files' names
+                // mean something else now. Forget the watch; checking all
+                // the files will watch whatever is there now.
+                m_missed = true;
+                m_dirs.erase(w->second);
+                if (ev->mask & IN_IGNORED)
+                    m_watches.erase(w);
+                else
+                    inotify_rm_watch(m_fd, ev->wd);
+                continue;
+            }
+            if (!ev->len)
+                continue;
+            ustring filename(w->second + ev->name);
+            auto range = m_names.equal_range(filename);
+            for (auto i = range.first; i != range.second; ++i)
+                changed.push_back(i->second);
+        }
+    }
+    unwatched.insert(unwatched.end(), m_unwatched.begin(), m_unwatched.end());
+    bool complete = !m_missed;
+    m_missed      = false;
+    return complete;
+}
+
+#else
+
+// No notifications on this platform: invalidate_all() checks every file.
+
+bool
+FileChangeWatcher::enable(bool on)
+{
+    return !on;
+}
+
+
+
+bool
+FileChangeWatcher::watch_dir(const std::string& /*dir*/)
+{
+    return false;
+}
+
+
+
+void
+FileChangeWatcher::watch(ustring /*name*/, ustring /*filename*/)
+{
+}
+
+
+
+bool
+FileChangeWatcher::changes(std::vector<ustring>& /*changed*/,
+                           std::vector<ustring>& /*unwatched*/)
+{
+    return false;
+}
+
+#endif
+
+
+
+void
+FileChangeWatcher::rescan()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_missed = true;
+}
+
+OIIO_NAMESPACE_END
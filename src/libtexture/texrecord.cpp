@@ -0,0 +1,174 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <atomic>
+#include <cstring>
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/texture.h>
+
+#include "imagecache_pvt.h"
+#include "texture_pvt.h"
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace {
+
+static const char record_magic[] = "OIIO lookup record 1\n";
+
+// Write after this many lookups of a thread.
+static const size_t records_per_block = 4096;
+
+std::atomic<uint64_t> next_recorder_serial(0);
+
+}  // namespace
+
+
+
+struct LookupRecorder::Buffer {
+    uint32_t thread;
+    std::vector<LookupRecord> records;
+    // The files this thread has already named, so that most lookups don't
+    // need the recorder's lock.
+    FileIndices files;
+};
+
+
+
+LookupRecorder::LookupRecorder(string_view filename)
+    : m_filename(filename)
+    , m_serial(++next_recorder_serial)
+{
+    m_file = Filesystem::fopen(m_filename, "wb");
+    if (m_file)
+        fwrite(record_magic, 1, strlen(record_magic), m_file);
+}
+
+
+
+LookupRecorder::~LookupRecorder()
+{
+    if (!m_file)
+        return;
+    for (auto& b : m_buffers)
+        flush(*b);
+    fclose(m_file);
+}
+
+
+
+LookupRecorder::Buffer&
+LookupRecorder::thread_buffer()
+{
+    // The common case: the last recorder this thread recorded to was this
+    // one. If not, find (or make) this thread's buffer.
+    struct LastBuffer {
+        uint64_t serial = 0;
+        Buffer* buffer  = nullptr;
+    };
+    thread_local LastBuffer last;
+    if (last.serial != m_serial) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Buffer*& b = m_thread_buffers[std::this_thread::get_id()];
+        if (!b) {
+            m_buffers.emplace_back(new Buffer);
+            b         = m_buffers.back().get();
+            b->thread = uint32_t(m_buffers.size() - 1);
+            b->records.reserve(records_per_block);
+        }
+        last.serial = m_serial;
+        last.buffer = b;
+    }
+    return *last.buffer;
+}
+
+
+
+uint32_t
+LookupRecorder::file_index(Buffer& buffer, const ImageCacheFile* file,
+                           ustring subimagename)
+{
+    FileKey key(file, subimagename);
+    auto found = buffer.files.find(key);
+    if (found != buffer.files.end())
+        return found->second;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto inserted  = m_files.emplace(key, uint32_t(m_files.size()));
+    uint32_t index = inserted.first->second;
+    if (inserted.second) {
+        // The first lookup of this file by any thread: name it in the file
+        // before any block that refers to it.
+        ustring name       = file->filename();
+        uint32_t header[3] = { index, uint32_t(name.size()),
+                               uint32_t(subimagename.size()) };
+        fputc('F', m_file);
+        fwrite(header, sizeof(header), 1, m_file);
+        fwrite(name.data(), 1, name.size(), m_file);
+        fwrite(subimagename.data(), 1, subimagename.size(), m_file);
+    }
+    buffer.files.emplace(key, index);
+    return index;
+}
+
+
+
+void
+LookupRecorder::flush(Buffer& buffer)
+{
+    if (buffer.records.empty())
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t header[2] = { buffer.thread, uint32_t(buffer.records.size()) };
+    fputc('L', m_file);
+    fwrite(header, sizeof(header), 1, m_file);
+    fwrite(buffer.records.data(), sizeof(LookupRecord),
+           buffer.records.size(), m_file);
+    buffer.records.clear();
+}
+
+
+
+void
+LookupRecorder::record(const ImageCacheFile* file, LookupRecord::Kind kind,
+                       const TextureOpt& options, int nchannels, bool derivs,
+                       const float* coords)
+{
+    if (!m_file || !file)
+        return;
+    Buffer& buffer(thread_buffer());
+    uint8_t flags = derivs ? LookupRecord::Derivs : 0;
+    if (options.conservative_filter)
+        flags |= LookupRecord::ConservativeFilter;
+    LookupRecord r;
+    memset(&r, 0, sizeof(r));
+    r.file             = file_index(buffer, file, options.subimagename);
+    r.kind             = kind;
+    r.nchannels        = uint8_t(nchannels);
+    r.interpmode       = uint8_t(options.interpmode);
+    r.mipmode          = uint8_t(options.mipmode);
+    r.swrap            = uint8_t(options.swrap);
+    r.twrap            = uint8_t(options.twrap);
+    r.flags            = flags;
+    r.firstchannel     = uint16_t(options.firstchannel);
+    r.anisotropic      = options.anisotropic;
+    r.subimage         = options.subimage;
+    r.colortransformid = options.colortransformid;
+    r.sblur            = options.sblur;
+    r.tblur            = options.tblur;
+    r.swidth           = options.swidth;
+    r.twidth           = options.twidth;
+    r.fill             = options.fill;
+    r.rnd              = options.rnd;
+    memcpy(r.coords, coords,
+           (kind == LookupRecord::Texture ? 6 : 9) * sizeof(float));
+    buffer.records.push_back(r);
+    if (buffer.records.size() >= records_per_block)
+        flush(buffer);
+}
+
+OIIO_NAMESPACE_END
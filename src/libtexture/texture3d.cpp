@@ -16,6 +16,7 @@
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/texture.h>
+#include <OpenImageIO/tracing.h>
 #include <OpenImageIO/typedesc.h>
 #include <OpenImageIO/ustring.h>
 
@@ -45,6 +46,16 @@ float2float(float val)
     return val;
 }
 
+// The pixel that fills the tile containing x,y,z, if the file said that
+// tile is empty and there's no color transform to change it, else nullptr.
+OIIO_FORCEINLINE const char*
+empty_tile_pixel(const ImageCacheFile::LevelInfo& levelinfo,
+                 const TextureOpt& options, int x, int y, int z)
+{
+    return options.colortransformid > 0 ? nullptr
+                                        : levelinfo.empty_tile_pixel(x, y, z);
+}
+
 }  // end anonymous namespace
 
 bool
@@ -121,6 +132,7 @@ TextureSystemImpl::texture3d(TextureHandle* texture_handle_,
                              float* dresultds, float* dresultdt,
                              float* dresultdr)
 {
+    OIIO_TRACE_SPAN("TS::texture3d");
 #if 0
     // Handle >4 channel lookups by recursion.
     if (nchannels > 4) {
@@ -344,41 +356,50 @@ TextureSystemImpl::accum3d_sample_closest(
         tile_chbegin = options.firstchannel;
         tile_chend   = options.firstchannel + actualchannels;
     }
-    int tile_s = (stex - spec.x) % spec.tile_width;
-    int tile_t = (ttex - spec.y) % spec.tile_height;
-    int tile_r = (rtex - spec.z) % spec.tile_depth;
-    TileID id(texturefile, options.subimage, miplevel, stex - tile_s,
-              ttex - tile_t, rtex - tile_r, tile_chbegin, tile_chend,
-              options.colortransformid);
-    bool ok = find_tile(id, thread_info, true);
-    if (!ok)
-        error("{}", m_imagecache->geterror());
-    TileRef& tile(thread_info->tile);
-    if (!tile || !ok)
-        return false;
-    imagesize_t tilepel = (tile_r * spec.tile_height + imagesize_t(tile_t))
-                              * spec.tile_width
-                          + tile_s;
-    int startchan_in_tile = options.firstchannel - id.chbegin();
-    imagesize_t offset    = spec.nchannels * tilepel + startchan_in_tile;
-    OIIO_DASSERT((size_t)offset < spec.nchannels * spec.tile_pixels());
+    size_t channelsize = texturefile.channelsize(options.subimage);
+    const unsigned char* texel;
+    if (const char* empty = empty_tile_pixel(levelinfo, options, stex, ttex,
+                                             rtex)) {
+        // The file said this tile is empty, no need to look it up
+        texel = (const unsigned char*)empty
+                + options.firstchannel * channelsize;
+    } else {
+        int tile_s = (stex - spec.x) % spec.tile_width;
+        int tile_t = (ttex - spec.y) % spec.tile_height;
+        int tile_r = (rtex - spec.z) % spec.tile_depth;
+        TileID id(texturefile, options.subimage, miplevel, stex - tile_s,
+                  ttex - tile_t, rtex - tile_r, tile_chbegin, tile_chend,
+                  options.colortransformid);
+        bool ok = find_tile(id, thread_info, true);
+        if (!ok)
+            error("{}", m_imagecache->geterror());
+        TileRef& tile(thread_info->tile);
+        if (!tile || !ok)
+            return false;
+        imagesize_t tilepel = (tile_r * spec.tile_height + imagesize_t(tile_t))
+                                  * spec.tile_width
+                              + tile_s;
+        int startchan_in_tile = options.firstchannel - id.chbegin();
+        imagesize_t offset    = spec.nchannels * tilepel + startchan_in_tile;
+        OIIO_DASSERT((size_t)offset < spec.nchannels * spec.tile_pixels());
+        texel = tile->bytedata() + offset * channelsize;
+    }
     if (pixeltype == TypeDesc::UINT8) {
-        const unsigned char* texel = tile->bytedata() + offset;
         for (int c = 0; c < actualchannels; ++c)
             accum[c] += weight * uchar2float(texel[c]);
     } else if (pixeltype == TypeDesc::UINT16) {
-        const unsigned short* texel = tile->ushortdata() + offset;
+        const unsigned short* t = (const unsigned short*)texel;
         for (int c = 0; c < actualchannels; ++c)
-            accum[c] += weight * ushort2float(texel[c]);
+            accum[c] += weight * ushort2float(t[c]);
     } else if (pixeltype == TypeDesc::HALF) {
-        const half* texel = tile->halfdata() + offset;
+        const half* t = (const half*)texel;
         for (int c = 0; c < actualchannels; ++c)
-            accum[c] += weight * float(texel[c]);
+            accum[c] += weight * float(t[c]);
     } else {
         OIIO_DASSERT(pixeltype == TypeDesc::FLOAT);
-        const float* texel = tile->floatdata() + offset;
+        const float* t = (const float*)texel;
         for (int c = 0; c < actualchannels; ++c)
-            accum[c] += weight * texel[c];
+            accum[c] += weight * t[c];
     }
 
     // Add appropriate amount of "fill" color to extra channels in
@@ -582,7 +603,19 @@ TextureSystemImpl::accum3d_sample_bilinear(
               tile_chend, options.colortransformid);
     int startchan_in_tile = options.firstchannel - id.chbegin();
 
-    if (onetile && valid_storage.ivalid == all_valid) {
+    const char* empty = nullptr;
+    if (onetile && valid_storage.ivalid == all_valid
+        && (empty = empty_tile_pixel(levelinfo, options, stex[0], ttex[0],
+                                     rtex[0]))) {
+        // All the texels are on one tile that the file said is empty, so
+        // there's no need to even look it up.
+        const unsigned char* b = (const unsigned char*)empty
+                                 + options.firstchannel * channelsize;
+        for (int k = 0; k < 2; ++k)
+            for (int j = 0; j < 2; ++j)
+                for (int i = 0; i < 2; ++i)
+                    texel[k][j][i] = b;
+    } else if (onetile && valid_storage.ivalid == all_valid) {
         // Shortcut if all the texels we need are on the same tile
         id.xyz(stex[0] - tile_s, ttex[0] - tile_t, rtex[0] - tile_r);
         bool ok = find_tile(id, thread_info, true);
@@ -617,6 +650,12 @@ TextureSystemImpl::accum3d_sample_bilinear(
                         texel[k][j][i] = (unsigned char*)black;
                         continue;
                     }
+                    if ((empty = empty_tile_pixel(levelinfo, options, stex[i],
+                                                  ttex[j], rtex[k]))) {
+                        texel[k][j][i] = (const unsigned char*)empty
+                                         + options.firstchannel * channelsize;
+                        continue;
+                    }
                     tile_s = (stex[i] - spec.x) % spec.tile_width;
                     tile_t = (ttex[j] - spec.y) % spec.tile_height;
                     tile_r = (rtex[k] - spec.z) % spec.tile_depth;
@@ -646,7 +685,7 @@ TextureSystemImpl::accum3d_sample_bilinear(
 #endif
                     OIIO_DASSERT((size_t)offset < spec.tile_bytes());
                     texel[k][j][i] = tile->bytedata() + offset;
-                    OIIO_DASSERT(tile->id() == id);
+                    OIIO_DASSERT(same_tile(tile->id(), id));
                 }
             }
         }
@@ -678,15 +717,19 @@ TextureSystemImpl::accum3d_sample_bilinear(
 
 
 bool
-TextureSystemImpl::texture3d(TextureHandle* texture_handle,
-                             Perthread* thread_info, TextureOptBatch& options,
+TextureSystemImpl::texture3d(TextureHandle* texture_handle_,
+                             Perthread* thread_info_, TextureOptBatch& options,
                              Tex::RunMask mask, const float* P,
                              const float* dPdx, const float* dPdy,
                              const float* dPdz, int nchannels, float* result,
                              float* dresultds, float* dresultdt,
                              float* dresultdr)
 {
-    // (FIXME) CHEAT! Texture points individually
+    OIIO_TRACE_SPAN("TS::texture3d batch");
+    using Tex::BatchWidth;
+    using Tex::FloatWide;
+
+    // The non-varying options are shared by all lanes.
     TextureOpt opt;
     opt.firstchannel        = options.firstchannel;
     opt.subimage            = options.subimage;
@@ -701,45 +744,141 @@ TextureSystemImpl::texture3d(TextureHandle* texture_handle,
     opt.missingcolor        = options.missingcolor;
     opt.rwrap               = (TextureOpt::Wrap)options.rwrap;
 
-    bool ok          = true;
-    Tex::RunMask bit = 1;
-    float* r         = OIIO_ALLOCA(float, 4 * nchannels * Tex::BatchWidth);
-    float* drds      = r + 1 * nchannels * Tex::BatchWidth;
-    float* drdt      = r + 2 * nchannels * Tex::BatchWidth;
-    float* drdr      = r + 3 * nchannels * Tex::BatchWidth;
-    for (int i = 0; i < Tex::BatchWidth; ++i, bit <<= 1) {
-        if (mask & bit) {
-            opt.sblur  = options.sblur[i];
-            opt.tblur  = options.tblur[i];
-            opt.rblur  = options.rblur[i];
-            opt.swidth = options.swidth[i];
-            opt.twidth = options.twidth[i];
-            opt.rwidth = options.rwidth[i];
-            Imath::V3f P_(P[i], P[i + Tex::BatchWidth],
-                          P[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dPdx_(dPdx[i], dPdx[i + Tex::BatchWidth],
-                             dPdx[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dPdy_(dPdy[i], dPdy[i + Tex::BatchWidth],
-                             dPdy[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dPdz_(dPdz[i], dPdz[i + Tex::BatchWidth],
-                             dPdz[i + 2 * Tex::BatchWidth]);
+    mask &= Tex::RunMaskOn;
+    if (!mask)
+        return true;
+
+    // Verify the file and resolve the subimage and wrap modes once for the
+    // whole batch rather than once per point.
+    PerThreadInfo* thread_info = m_imagecache->get_perthread_info(
+        (PerThreadInfo*)thread_info_);
+    TextureFile* texturefile = verify_texturefile((TextureFile*)texture_handle_,
+                                                  thread_info);
+    ImageCacheStatistics& stats(thread_info->m_stats);
+    ++stats.texture3d_batches;
+
+    float* r    = OIIO_ALLOCA(float, 4 * nchannels);
+    float* drds = r + 1 * nchannels;
+    float* drdt = r + 2 * nchannels;
+    float* drdr = r + 3 * nchannels;
+
+    auto scatter = [&](int lane) {
+        for (int c = 0; c < nchannels; ++c) {
+            result[c * BatchWidth + lane] = r[c];
             if (dresultds) {
-                ok &= texture3d(texture_handle, thread_info, opt, P_, dPdx_,
-                                dPdy_, dPdz_, nchannels, r, drds, drdt, drdr);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i]    = r[c];
-                    dresultds[c * Tex::BatchWidth + i] = drds[c];
-                    dresultdt[c * Tex::BatchWidth + i] = drdt[c];
-                    dresultdr[c * Tex::BatchWidth + i] = drdr[c];
-                }
-            } else {
-                ok &= texture3d(texture_handle, thread_info, opt, P_, dPdx_,
-                                dPdy_, dPdz_, nchannels, r);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i] = r[c];
-                }
+                dresultds[c * BatchWidth + lane] = drds[c];
+                dresultdt[c * BatchWidth + lane] = drdt[c];
+                dresultdr[c * BatchWidth + lane] = drdr[c];
             }
         }
+    };
+    auto missing = [&]() {
+        bool ok = missing_texture(opt, nchannels, r, drds, drdt, drdr);
+
+        Tex::RunMask bit = 1;
+        for (int i = 0; i < BatchWidth; ++i, bit <<= 1) {
+            if (mask & bit) {
+                ++stats.texture3d_queries;
+                scatter(i);
+            }
+        }
+        return ok;
+    };
+
+    if (!texturefile || texturefile->broken())
+        return missing();
+
+    if (!opt.subimagename.empty()) {
+        // If subimage was specified by name, figure out its index.
+        int si = m_imagecache->subimage_from_name(texturefile,
+                                                  opt.subimagename);
+        if (si < 0) {
+            error("Unknown subimage \"{}\" in texture \"{}\"",
+                  opt.subimagename, texturefile->filename());
+            return missing();
+        }
+        opt.subimage = si;
+        opt.subimagename.clear();
+    }
+    if (opt.subimage < 0 || opt.subimage >= texturefile->subimages()) {
+        error("Unknown subimage \"{}\" in texture \"{}\"", opt.subimagename,
+              texturefile->filename());
+        return missing();
+    }
+
+    const ImageSpec& spec(texturefile->spec(opt.subimage, 0));
+
+    // Figure out the wrap functions
+    if (opt.swrap == TextureOpt::WrapDefault)
+        opt.swrap = (TextureOpt::Wrap)texturefile->swrap();
+    if (opt.swrap == TextureOpt::WrapPeriodic && ispow2(spec.width))
+        opt.swrap = TextureOpt::WrapPeriodicPow2;
+    if (opt.twrap == TextureOpt::WrapDefault)
+        opt.twrap = (TextureOpt::Wrap)texturefile->twrap();
+    if (opt.twrap == TextureOpt::WrapPeriodic && ispow2(spec.height))
+        opt.twrap = TextureOpt::WrapPeriodicPow2;
+    if (opt.rwrap == TextureOpt::WrapDefault)
+        opt.rwrap = (TextureOpt::Wrap)texturefile->rwrap();
+    if (opt.rwrap == TextureOpt::WrapPeriodic && ispow2(spec.depth))
+        opt.rwrap = TextureOpt::WrapPeriodicPow2;
+
+    int actualchannels = OIIO::clamp(spec.nchannels - opt.firstchannel, 0,
+                                     nchannels);
+
+    // Transform all the lookup points into local space at once. The
+    // inputs are already laid out as [3][BatchWidth].
+    FloatWide Px(P), Py(P + BatchWidth), Pz(P + 2 * BatchWidth);
+    const auto& si(texturefile->subimageinfo(opt.subimage));
+    if (si.Mlocal) {
+        // Same as M44f::multVecMatrix, including the homogeneous divide.
+        const Imath::M44f& M(*si.Mlocal);
+        FloatWide x = Px * M[0][0] + Py * M[1][0] + Pz * M[2][0] + M[3][0];
+        FloatWide y = Px * M[0][1] + Py * M[1][1] + Pz * M[2][1] + M[3][1];
+        FloatWide z = Px * M[0][2] + Py * M[1][2] + Pz * M[2][2] + M[3][2];
+        FloatWide w = Px * M[0][3] + Py * M[1][3] + Pz * M[2][3] + M[3][3];
+        Px          = x / w;
+        Py          = y / w;
+        Pz          = z / w;
+    }
+
+    // Only the transform above is wide. Each active lane is still looked up
+    // by the scalar texture3d_lookup_nomip().
+    //
+    // FIXME: as with the single point texture3d, the derivatives are not
+    // transformed into local space because volume lookups are not yet
+    // filtered.
+    texture3d_lookup_prototype lookup
+        = &TextureSystemImpl::texture3d_lookup_nomip;
+    bool ok          = true;
+    Tex::RunMask bit = 1;
+    for (int i = 0; i < BatchWidth; ++i, bit <<= 1) {
+        if (!(mask & bit))
+            continue;
+        ++stats.texture3d_queries;
+        opt.sblur  = options.sblur[i];
+        opt.tblur  = options.tblur[i];
+        opt.rblur  = options.rblur[i];
+        opt.swidth = options.swidth[i];
+        opt.twidth = options.twidth[i];
+        opt.rwidth = options.rwidth[i];
+        Imath::V3f Plocal(Px[i], Py[i], Pz[i]);
+        Imath::V3f dPdx_(dPdx[i], dPdx[i + BatchWidth],
+                         dPdx[i + 2 * BatchWidth]);
+        Imath::V3f dPdy_(dPdy[i], dPdy[i + BatchWidth],
+                         dPdy[i + 2 * BatchWidth]);
+        Imath::V3f dPdz_(dPdz[i], dPdz[i + BatchWidth],
+                         dPdz[i + 2 * BatchWidth]);
+        ok &= (this->*lookup)(*texturefile, thread_info, opt, nchannels,
+                              actualchannels, Plocal, dPdx_, dPdy_, dPdz_, r,
+                              dresultds ? drds : nullptr,
+                              dresultds ? drdt : nullptr,
+                              dresultds ? drdr : nullptr);
+        if (actualchannels < nchannels && opt.firstchannel == 0
+            && m_gray_to_rgb)
+            fill_gray_channels(spec, nchannels, r, dresultds ? drds : nullptr,
+                               dresultds ? drdt : nullptr,
+                               dresultds ? drdr : nullptr);
+        scatter(i);
     }
     return ok;
 }
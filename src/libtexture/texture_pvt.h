@@ -10,6 +10,13 @@
 #ifndef OPENIMAGEIO_TEXTURE_PVT_H
 #define OPENIMAGEIO_TEXTURE_PVT_H
 
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include <OpenImageIO/simd.h>
 #include <OpenImageIO/texture.h>
 
@@ -29,6 +36,85 @@ class ImageCacheImpl;
 
 
 
+/// One texture lookup, as stored in a lookup recording (see the
+/// "record_lookups" attribute). The layout is fixed, without padding, and
+/// in native byte order, so that records can be written and read whole.
+struct LookupRecord {
+    enum Kind : uint8_t { Texture = 0, Environment = 1 };
+    enum Flags : uint8_t { Derivs = 1, ConservativeFilter = 2 };
+    uint32_t file;      ///< Index of the file and subimage name
+    uint8_t kind;       ///< Texture or Environment
+    uint8_t nchannels;  ///< Channels looked up (at most 4)
+    uint8_t interpmode, mipmode, swrap, twrap;
+    uint8_t flags;  ///< Derivs if dresultds was requested, etc.
+    uint8_t unused;
+    uint16_t firstchannel, anisotropic;
+    int32_t subimage, colortransformid;
+    float sblur, tblur, swidth, twidth, fill, rnd;
+    /// s, t, dsdx, dtdx, dsdy, dtdy for a texture lookup, or R, dRdx, dRdy
+    /// for an environment lookup.
+    float coords[9];
+};
+static_assert(sizeof(LookupRecord) == 84, "LookupRecord must not be padded");
+
+
+
+/// LookupRecorder writes each thread's texture lookups to a file, so that
+/// the same workload can later be replayed (see `testtex --replay`)
+/// against other cache settings. Each thread records into its own buffer,
+/// and only takes the recorder's lock to write a full buffer or to name a
+/// file it hasn't looked up before.
+///
+/// The file starts with the line "OIIO lookup record 1", followed by
+/// blocks that each start with a character:
+///   - 'F', uint32 index, uint32 length, uint32 sublength, then the file
+///     name and the subimage name (empty if the lookups name none) that
+///     the lookups of that index use, which precedes any of those lookups.
+///   - 'L', uint32 thread, uint32 count, then count LookupRecords: the
+///     next lookups of that thread, in order.
+class LookupRecorder {
+public:
+    LookupRecorder(string_view filename);
+    /// Write what's left in all the threads' buffers and close the file.
+    /// There must be no lookups in progress.
+    ~LookupRecorder();
+
+    bool opened() const { return m_file != nullptr; }
+    const std::string& filename() const { return m_filename; }
+
+    /// Record one lookup of file by the calling thread. coords holds the
+    /// six (texture) or nine (environment) coordinates.
+    void record(const ImageCacheFile* file, LookupRecord::Kind kind,
+                const TextureOpt& options, int nchannels, bool derivs,
+                const float* coords);
+
+private:
+    // A file and the subimage name used to look it up
+    using FileKey = std::pair<const ImageCacheFile*, ustring>;
+    struct FileKeyHash {
+        size_t operator()(const FileKey& k) const
+        {
+            return std::hash<const void*>()(k.first) ^ k.second.hash();
+        }
+    };
+    using FileIndices = std::unordered_map<FileKey, uint32_t, FileKeyHash>;
+    struct Buffer;
+    Buffer& thread_buffer();
+    uint32_t file_index(Buffer& buffer, const ImageCacheFile* file,
+                        ustring subimagename);
+    void flush(Buffer& buffer);
+
+    std::string m_filename;
+    FILE* m_file      = nullptr;
+    uint64_t m_serial = 0;  // Tells this recorder's buffers from others'
+    std::mutex m_mutex;     // Guards the file and the tables below
+    std::vector<std::unique_ptr<Buffer>> m_buffers;
+    std::unordered_map<std::thread::id, Buffer*> m_thread_buffers;
+    FileIndices m_files;
+};
+
+
+
 /// Working implementation of the abstract TextureSystem class.
 class TextureSystemImpl {
 public:
@@ -215,6 +301,16 @@ public:
                     TextureOpt& options, int miplevel, int xbegin, int xend,
                     int ybegin, int yend, int zbegin, int zend, int chbegin,
                     int chend, TypeDesc format, void* result);
+    bool get_texel_patches(ustring filename, TextureOpt& options,
+                           cspan<TextureSystem::TexelPatch> patches,
+                           int width, int height, int chbegin, int chend,
+                           TypeDesc format, void* result, stride_t xstride,
+                           stride_t ystride, stride_t patchstride);
+    bool get_texel_patches(TextureHandle* texture_handle, TextureOpt& options,
+                           cspan<TextureSystem::TexelPatch> patches,
+                           int width, int height, int chbegin, int chend,
+                           TypeDesc format, void* result, stride_t xstride,
+                           stride_t ystride, stride_t patchstride);
 
     bool is_udim(ustring filename);
     bool is_udim(TextureHandle* udimfile);
@@ -231,6 +327,10 @@ public:
     std::string geterror(bool clear = true) const;
     std::string getstats(int level = 1, bool icstats = true) const;
     void reset_stats();
+    std::vector<TextureSystem::TileFeedback> get_tile_feedback(bool clear)
+    {
+        return m_imagecache->merge_tile_feedback(clear);
+    }
 
     void invalidate(ustring filename, bool force);
     void invalidate_all(bool force = false);
@@ -277,15 +377,45 @@ public:
             else
                 error ("(unknown error - NULL texturefile)");
 #endif
+        } else if (OIIO_UNLIKELY(texturefile->deep())) {
+            // Deep images are cached as DeepData, which can't be filtered
+            // as texture.
+            if (texturefile->errors_should_issue())
+                error("\"{}\" is a deep image, which cannot be used as a "
+                      "texture",
+                      texturefile->filename());
+            return nullptr;
         }
         return texturefile;
     }
 
     /// Find the tile specified by id.  Just a pass-through to the
-    /// underlying ImageCache.
+    /// underlying ImageCache, timed if the lookup is being attributed to
+    /// its file (see FileLookupScope), and not waiting for the tile during
+    /// a nonblocking lookup.
     bool find_tile(const TileID& id, PerThreadInfo* thread_info,
                    bool mark_same_tile_used)
     {
+        if (OIIO_UNLIKELY(m_tile_feedback)) {
+            const ImageCacheFile::LevelInfo& levelinfo(
+                id.file().levelinfo(id.subimage(), id.miplevel()));
+            size_t ntiles = size_t(levelinfo.nxtiles) * levelinfo.nytiles
+                            * levelinfo.nztiles;
+            thread_info
+                ->tile_feedback(id.file_ptr(), id.subimage(), id.miplevel(),
+                                ntiles)
+                .set(levelinfo.tile_index(id.x(), id.y(), id.z()));
+        }
+        if (OIIO_UNLIKELY(thread_info->m_nonblocking))
+            return m_imagecache->find_tile_nonblocking(id, thread_info,
+                                                       mark_same_tile_used);
+        if (OIIO_UNLIKELY(thread_info->m_lookup_stats)) {
+            Timer timer;
+            bool ok = m_imagecache->find_tile(id, thread_info,
+                                              mark_same_tile_used);
+            thread_info->m_lookup_stats->find_tile_time += timer();
+            return ok;
+        }
         return m_imagecache->find_tile(id, thread_info, mark_same_tile_used);
     }
 
@@ -323,6 +453,27 @@ public:
         float _dsdx, float _dtdx, float _dsdy, float _dtdy, float* result,
         float* dresultds, float* resultdt);
 
+    /// Look up texture from just ONE point, with an elliptical weighted
+    /// average of the texels of one MIP level (MipMode::EWA).
+    bool texture_lookup_ewa(TextureFile& texfile, PerThreadInfo* thread_info,
+                            TextureOpt& options, int nchannels_result,
+                            int actualchannels, float _s, float _t,
+                            float _dsdx, float _dtdx, float _dsdy,
+                            float _dtdy, float* result, float* dresultds,
+                            float* resultdt);
+
+    /// For TextureOpt::nonblocking: the lookup of options.mipmode, redone
+    /// from coarser MIP levels for as long as it needs tiles that aren't
+    /// resident yet (which are queued to be read), waiting only for the
+    /// coarsest level. Sets options.approximate if it had to do that.
+    bool texture_lookup_nonblocking(TextureFile& texfile,
+                                    PerThreadInfo* thread_info,
+                                    TextureOpt& options, int nchannels_result,
+                                    int actualchannels, float _s, float _t,
+                                    float _dsdx, float _dtdx, float _dsdy,
+                                    float _dtdy, float* result,
+                                    float* dresultds, float* resultdt);
+
     // For the samplers, it's guaranteed that all float* inputs and outputs
     // are padded to length 'simd' and aligned to a simd*4-byte boundary
     // (for example, 4 for SSE). This means that the functions can behave AS
@@ -346,12 +497,45 @@ public:
                          int nchannels_result, int actualchannels,
                          const float* weight, simd::vfloat4* accum,
                          simd::vfloat4* daccumds, simd::vfloat4* daccumdt);
+    // sample_bilinear for a texture whose tiles hold pixels of type T.
+    template<typename T>
+    bool sample_bilinear_typed(int nsamples, const float* s, const float* t,
+                               int level, TextureFile& texturefile,
+                               PerThreadInfo* thread_info, TextureOpt& options,
+                               int nchannels_result, int actualchannels,
+                               const float* weight, simd::vfloat4* accum,
+                               simd::vfloat4* daccumds,
+                               simd::vfloat4* daccumdt);
     bool sample_bicubic(int nsamples, const float* s, const float* t, int level,
                         TextureFile& texturefile, PerThreadInfo* thread_info,
                         TextureOpt& options, int nchannels_result,
                         int actualchannels, const float* weight,
                         simd::vfloat4* accum, simd::vfloat4* daccumds,
                         simd::vfloat4* daccumdt);
+    // StochasticStrategy_Texel versions of sample_bilinear and
+    // sample_bicubic: each sample looks up just one of the texels it would
+    // interpolate, chosen using options.rnd with probability equal to its
+    // weight, so that the result is right on average. They compute no
+    // derivatives.
+    bool sample_bilinear_texel(int nsamples, const float* s, const float* t,
+                               int level, TextureFile& texturefile,
+                               PerThreadInfo* thread_info, TextureOpt& options,
+                               int nchannels_result, int actualchannels,
+                               const float* weight, simd::vfloat4* accum,
+                               simd::vfloat4* daccumds,
+                               simd::vfloat4* daccumdt);
+    bool sample_bicubic_texel(int nsamples, const float* s, const float* t,
+                              int level, TextureFile& texturefile,
+                              PerThreadInfo* thread_info, TextureOpt& options,
+                              int nchannels_result, int actualchannels,
+                              const float* weight, simd::vfloat4* accum,
+                              simd::vfloat4* daccumds, simd::vfloat4* daccumdt);
+    bool sample_texel(bool bicubic, int nsamples, const float* s,
+                      const float* t, int level, TextureFile& texturefile,
+                      PerThreadInfo* thread_info, TextureOpt& options,
+                      int nchannels_result, int actualchannels,
+                      const float* weight, simd::vfloat4* accum,
+                      simd::vfloat4* daccumds, simd::vfloat4* daccumdt);
 
     // Define a prototype of a member function pointer for texture3d
     // lookups.
@@ -386,6 +570,17 @@ public:
                                  float* daccumds, float* daccumdt,
                                  float* daccumdr);
 
+    /// Filter a latlong environment map for ONE direction, given the
+    /// already-normalized center direction R and the normalized
+    /// directions Rx, Ry of the ellipse axes. The file, subimage, and
+    /// wrap modes in options must already be resolved.
+    bool environment_lookup(TextureFile& texfile, PerThreadInfo* thread_info,
+                            TextureOpt& options, int nchannels,
+                            int actualchannels, const Imath::V3f& R,
+                            const Imath::V3f& Rx, const Imath::V3f& Ry,
+                            float* result, float* dresultds,
+                            float* dresultdt);
+
     /// Helper function to calculate the anisotropic aspect ratio from
     /// the major and minor ellipse axis lengths.  The "clamped" aspect
     /// ratio is returned (possibly adjusting major and minorlength to
@@ -466,6 +661,7 @@ public:
     int m_max_tile_channels;  ///< narrow tile ID channel range when
                               ///<   the file has more channels
     int m_stochastic;
+    bool m_tile_feedback;     ///< Record the tiles lookups touch?
     static EightBitConverter<float> uchar2float;
 
     enum StochasticStrategyBits {
@@ -477,6 +673,7 @@ public:
 
     std::unique_ptr<Filter1D> hq_filter;  // Better filter for magnification
     int m_statslevel;
+    std::unique_ptr<LookupRecorder> m_recorder;  ///< If recording lookups
     friend class TextureSystem;
 };
 
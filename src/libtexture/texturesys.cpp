@@ -3,6 +3,7 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <list>
@@ -21,11 +22,13 @@
 #include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/optparser.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/simd.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
 #include <OpenImageIO/texture.h>
 #include <OpenImageIO/thread.h>
+#include <OpenImageIO/tracing.h>
 #include <OpenImageIO/typedesc.h>
 #include <OpenImageIO/ustring.h>
 
@@ -72,6 +75,37 @@ ushort2float4(const unsigned short* s)
 }
 
 
+// Load the first 4 channels of a texel held as T, as floats normalized
+// the way the cache's integer formats are.
+template<typename T>
+OIIO_FORCEINLINE vfloat4
+load_texel(const unsigned char* p)
+{
+    return vfloat4((const float*)p);
+}
+
+template<>
+OIIO_FORCEINLINE vfloat4
+load_texel<uint8_t>(const unsigned char* p)
+{
+    return uchar2float4(p);
+}
+
+template<>
+OIIO_FORCEINLINE vfloat4
+load_texel<uint16_t>(const unsigned char* p)
+{
+    return ushort2float4((const uint16_t*)p);
+}
+
+template<>
+OIIO_FORCEINLINE vfloat4
+load_texel<half>(const unsigned char* p)
+{
+    return vfloat4((const half*)p);
+}
+
+
 static const OIIO_SIMD4_ALIGN vbool4 channel_masks[5] = {
     vbool4(false, false, false, false), vbool4(true, false, false, false),
     vbool4(true, true, false, false),   vbool4(true, true, true, false),
@@ -378,6 +412,36 @@ TextureSystem::get_texels(TextureHandle* texture_handle, Perthread* thread_info,
 
 
 
+bool
+TextureSystem::get_texel_patches(TextureHandle* texture_handle,
+                                 TextureOpt& options,
+                                 cspan<TexelPatch> patches, int width,
+                                 int height, int chbegin, int chend,
+                                 TypeDesc format, void* result,
+                                 stride_t xstride, stride_t ystride,
+                                 stride_t patchstride)
+{
+    return m_impl->get_texel_patches(texture_handle, options, patches, width,
+                                     height, chbegin, chend, format, result,
+                                     xstride, ystride, patchstride);
+}
+
+
+bool
+TextureSystem::get_texel_patches(ustring filename, TextureOpt& options,
+                                 cspan<TexelPatch> patches, int width,
+                                 int height, int chbegin, int chend,
+                                 TypeDesc format, void* result,
+                                 stride_t xstride, stride_t ystride,
+                                 stride_t patchstride)
+{
+    return m_impl->get_texel_patches(filename, options, patches, width,
+                                     height, chbegin, chend, format, result,
+                                     xstride, ystride, patchstride);
+}
+
+
+
 bool
 TextureSystem::is_udim(ustring filename)
 {
@@ -487,6 +551,13 @@ TextureSystem::reset_stats()
 }
 
 
+std::vector<TextureSystem::TileFeedback>
+TextureSystem::get_tile_feedback(bool clear)
+{
+    return m_impl->get_tile_feedback(clear);
+}
+
+
 
 std::shared_ptr<ImageCache>
 TextureSystem::imagecache() const
@@ -693,6 +764,7 @@ TextureSystemImpl::init()
     m_flip_t            = false;
     m_max_tile_channels = 6;
     m_stochastic        = StochasticStrategy_None;
+    m_tile_feedback     = false;
     hq_filter.reset(Filter1D::create("b-spline", 4));
     m_statslevel = 0;
 
@@ -747,6 +819,7 @@ TextureSystemImpl::getstats(int level, bool icstats) const
         INTOPT(flip_t);
         INTOPT(max_tile_channels);
         INTOPT(stochastic);
+        BOOLOPT(tile_feedback);
 #undef BOOLOPT
 #undef INTOPT
 #undef STROPT
@@ -773,6 +846,9 @@ TextureSystemImpl::getstats(int level, bool icstats) const
         else
             print(out, "  Average anisotropic probes : 0\n");
         print(out, "  Max anisotropy in the wild : {:.3g}\n", stats.max_aniso);
+        if (stats.approximate_lookups)
+            print(out, "  Nonblocking lookups from coarser MIP levels : {}\n",
+                  stats.approximate_lookups);
         if (icstats)
             print(out, "\n");
     }
@@ -836,10 +912,29 @@ TextureSystemImpl::attribute(string_view name, TypeDesc type, const void* val)
         m_stochastic = *(const int*)val;
         return true;
     }
+    if (name == "tile_feedback" && type == TypeInt) {
+        m_tile_feedback = *(const int*)val;
+        return true;
+    }
     if (name == "statistics:level" && type == TypeInt) {
         m_statslevel = *(const int*)val;
         // DO NOT RETURN! pass the same message to the image cache
     }
+    if (name == "record_lookups" && type == TypeString) {
+        // Finish any recording in progress before starting another.
+        m_recorder.reset();
+        string_view filename(*(const char**)val);
+        if (filename.empty())
+            return true;
+        auto recorder = std::make_unique<LookupRecorder>(filename);
+        if (!recorder->opened()) {
+            error("Could not open \"{}\" to record texture lookups",
+                  filename);
+            return false;
+        }
+        m_recorder = std::move(recorder);
+        return true;
+    }
     if (name == "unit_test" && type == TypeInt) {
         do_unit_test_texture = *(const int*)val;
         return true;
@@ -867,6 +962,8 @@ TextureSystemImpl::getattributetype(string_view name) const
         { "flip_t", TypeInt },
         { "max_tile_channels", TypeInt },
         { "stochastic", TypeInt },
+        { "tile_feedback", TypeInt },
+        { "record_lookups", TypeString },
     };
     // clang-format on
 
@@ -916,6 +1013,15 @@ TextureSystemImpl::getattribute(string_view name, TypeDesc type,
         *(int*)val = m_stochastic;
         return true;
     }
+    if (name == "tile_feedback" && type == TypeInt) {
+        *(int*)val = m_tile_feedback;
+        return true;
+    }
+    if (name == "record_lookups" && type == TypeString) {
+        *(const char**)val
+            = ustring(m_recorder ? m_recorder->filename() : "").c_str();
+        return true;
+    }
 
     // If not one of these, maybe it's an attribute meant for the image cache?
     return m_imagecache->getattribute(name, type, val);
@@ -1258,6 +1364,197 @@ TextureSystemImpl::get_texels(TextureHandle* texture_handle_,
 }
 
 
+bool
+TextureSystemImpl::get_texel_patches(
+    ustring filename, TextureOpt& options,
+    cspan<TextureSystem::TexelPatch> patches, int width, int height,
+    int chbegin, int chend, TypeDesc format, void* result, stride_t xstride,
+    stride_t ystride, stride_t patchstride)
+{
+    PerThreadInfo* thread_info = m_imagecache->get_perthread_info();
+    TextureFile* texfile       = find_texturefile(filename, thread_info);
+    if (!texfile) {
+        error("Texture file \"{}\" not found", filename);
+        return false;
+    }
+    return get_texel_patches((TextureHandle*)texfile, options, patches, width,
+                             height, chbegin, chend, format, result, xstride,
+                             ystride, patchstride);
+}
+
+
+
+bool
+TextureSystemImpl::get_texel_patches(
+    TextureHandle* texture_handle_, TextureOpt& options,
+    cspan<TextureSystem::TexelPatch> patches, int width, int height,
+    int chbegin, int chend, TypeDesc format, void* result, stride_t xstride,
+    stride_t ystride, stride_t patchstride)
+{
+    PerThreadInfo* thread_info = m_imagecache->get_perthread_info();
+    TextureFile* texfile = verify_texturefile((TextureFile*)texture_handle_,
+                                              thread_info);
+    if (!texfile) {
+        error("Invalid texture handle NULL");
+        return false;
+    }
+    if (texfile->broken()) {
+        if (texfile->errors_should_issue())
+            error("Invalid texture file \"{}\"", texfile->filename());
+        return false;
+    }
+    int subimage = options.subimage;
+    if (subimage < 0 || subimage >= texfile->subimages()) {
+        error("get_texel_patches asked for nonexistent subimage {} of \"{}\"",
+              subimage, texfile->filename());
+        return false;
+    }
+    int nchannels = chend - chbegin;
+    if (patches.empty() || width < 1 || height < 1 || nchannels < 1)
+        return true;
+    ImageSpec::auto_stride(xstride, ystride, patchstride, format, nchannels,
+                           width, height);
+    const ImageSpec& spec0(texfile->spec(subimage, 0));
+    int actualchannels = OIIO::clamp(spec0.nchannels - chbegin, 0, nchannels);
+    int tile_chbegin = 0, tile_chend = spec0.nchannels;
+    if (spec0.nchannels > m_max_tile_channels) {
+        // For files with many channels, narrow the range we cache
+        tile_chbegin = chbegin;
+        tile_chend   = chbegin + actualchannels;
+    }
+    size_t formatpixelsize = nchannels * format.size();
+
+    // Zero the texels [xbegin,xend) x [ybegin,yend) of the patch that
+    // begins at `patch`.
+    auto zero = [&](char* patch, int xbegin, int xend, int ybegin, int yend) {
+        for (int y = ybegin; y < yend; ++y)
+            for (int x = xbegin; x < xend; ++x)
+                memset(patch + y * ystride + x * xstride, 0, formatpixelsize);
+    };
+    // The first texel of a patch of `size` texels centered on st.
+    auto origin = [](float st, int begin, int res, int size) {
+        float x = OIIO::clamp(st * res - 0.5f * size + 0.5f, -1.0e8f, 1.0e8f);
+        return begin + int(floorf(x));
+    };
+
+    // Split each patch into the pieces of it in different tiles, and sort
+    // them by tile, so that each tile is found and copied from just once.
+    // Patch texels outside the data window are zeroed now.
+    struct Piece {
+        int level, ty, tx;  // Which tile
+        int patch, x0, y0;  // Which patch, and where it begins
+    };
+    std::vector<Piece> pieces;
+    pieces.reserve(patches.size());
+    for (int p = 0, n = int(patches.size()); p < n; ++p) {
+        int level = patches[p].miplevel;
+        if (level < 0 || level >= texfile->miplevels(subimage)) {
+            if (texfile->errors_should_issue())
+                error("get_texel_patches asked for nonexistent MIP level {} "
+                      "of \"{}\"",
+                      level, texfile->filename());
+            return false;
+        }
+        const ImageSpec& spec(texfile->spec(subimage, level));
+        int x0      = origin(patches[p].s, spec.x, spec.width, width);
+        int y0      = origin(patches[p].t, spec.y, spec.height, height);
+        int xb      = std::max(x0, spec.x);
+        int xe      = std::min(x0 + width, spec.x + spec.width);
+        int yb      = std::max(y0, spec.y);
+        int ye      = std::min(y0 + height, spec.y + spec.height);
+        char* patch = (char*)result + p * patchstride;
+        if (xb >= xe || yb >= ye) {
+            zero(patch, 0, width, 0, height);
+            continue;
+        }
+        zero(patch, 0, width, 0, yb - y0);
+        zero(patch, 0, width, ye - y0, height);
+        zero(patch, 0, xb - x0, yb - y0, ye - y0);
+        zero(patch, xe - x0, width, yb - y0, ye - y0);
+        for (int ty = yb - ((yb - spec.y) % spec.tile_height); ty < ye;
+             ty += spec.tile_height)
+            for (int tx = xb - ((xb - spec.x) % spec.tile_width); tx < xe;
+                 tx += spec.tile_width)
+                pieces.push_back({ level, ty, tx, p, x0, y0 });
+    }
+    auto sametile = [](const Piece& a, const Piece& b) {
+        return a.level == b.level && a.ty == b.ty && a.tx == b.tx;
+    };
+    std::sort(pieces.begin(), pieces.end(), [](const Piece& a, const Piece& b) {
+        return a.level != b.level ? a.level < b.level
+               : a.ty != b.ty     ? a.ty < b.ty
+                                  : a.tx < b.tx;
+    });
+    std::vector<size_t> tilestart;
+    for (size_t i = 0; i < pieces.size(); ++i)
+        if (!i || !sametile(pieces[i], pieces[i - 1]))
+            tilestart.push_back(i);
+    tilestart.push_back(pieces.size());
+
+    // Gather the tiles in parallel, each thread with its own microcache.
+    TypeDesc datatype = texfile->datatype(subimage);
+    std::atomic<bool> ok(true);
+    auto gather = [&](int64_t tbegin, int64_t tend) {
+        PerThreadInfo* thread_info = m_imagecache->get_perthread_info();
+        for (int64_t t = tbegin; t < tend; ++t) {
+            const Piece& first(pieces[tilestart[t]]);
+            const ImageSpec& spec(texfile->spec(subimage, first.level));
+            TileID tileid(*texfile, subimage, first.level, first.tx, first.ty,
+                          spec.z, tile_chbegin, tile_chend,
+                          options.colortransformid);
+            if (!find_tile(tileid, thread_info, true))
+                ok = false;
+            TileRef& tile(thread_info->tile);
+            for (size_t i = tilestart[t]; i < tilestart[t + 1]; ++i) {
+                const Piece& piece(pieces[i]);
+                int xb = std::max({ piece.x0, piece.tx, spec.x });
+                int xe = std::min({ piece.x0 + width,
+                                    piece.tx + spec.tile_width,
+                                    spec.x + spec.width });
+                int yb = std::max({ piece.y0, piece.ty, spec.y });
+                int ye = std::min({ piece.y0 + height,
+                                    piece.ty + spec.tile_height,
+                                    spec.y + spec.height });
+                char* patch = (char*)result + piece.patch * patchstride;
+                char* dst   = patch + (yb - piece.y0) * ystride
+                            + (xb - piece.x0) * xstride;
+                const void* data = (tile && actualchannels)
+                                       ? tile->data(xb, yb, spec.z, chbegin)
+                                       : nullptr;
+                if (data) {
+                    stride_t pixelsize = tile->pixelsize();
+                    convert_image(actualchannels, xe - xb, ye - yb, 1, data,
+                                  datatype, pixelsize,
+                                  pixelsize * spec.tile_width, AutoStride, dst,
+                                  format, xstride, ystride, AutoStride);
+                } else if (actualchannels) {
+                    // The tile couldn't be read
+                    zero(patch, xb - piece.x0, xe - piece.x0, yb - piece.y0,
+                         ye - piece.y0);
+                    continue;
+                }
+                for (int y = yb; y < ye && actualchannels < nchannels; ++y)
+                    for (int x = xb; x < xe; ++x)
+                        for (int c = actualchannels; c < nchannels; ++c)
+                            convert_pixel_values(TypeFloat, &options.fill,
+                                                 format,
+                                                 dst + (y - yb) * ystride
+                                                     + (x - xb) * xstride
+                                                     + c * format.size(),
+                                                 1);
+            }
+        }
+    };
+    parallel_for_range(int64_t(0), int64_t(tilestart.size() - 1), gather);
+    if (!ok) {
+        std::string err = m_imagecache->geterror();
+        if (!err.empty())
+            error("{}", err);
+    }
+    return ok;
+}
+
+
 
 bool
 TextureSystemImpl::has_error() const
@@ -1437,14 +1734,18 @@ TextureSystemImpl::texture(TextureHandle* texture_handle_,
                            float dtdy, int nchannels, float* result,
                            float* dresultds, float* dresultdt)
 {
+    OIIO_TRACE_SPAN("TS::texture");
     // Handle >4 channel lookups by recursion.
     if (nchannels > 4) {
         int save_firstchannel = options.firstchannel;
+        bool approximate      = false;
         while (nchannels) {
             int n   = std::min(nchannels, 4);
             bool ok = texture(texture_handle_, thread_info_, options, s, t,
                               dsdx, dtdx, dsdy, dtdy, n /* chans */, result,
                               dresultds, dresultdt);
+            approximate |= options.approximate;
+            options.approximate = approximate;
             if (!ok)
                 return false;
             result += n;
@@ -1459,6 +1760,13 @@ TextureSystemImpl::texture(TextureHandle* texture_handle_,
         return true;
     }
 
+    if (OIIO_UNLIKELY(m_recorder)) {
+        float coords[6] = { s, t, dsdx, dtdx, dsdy, dtdy };
+        m_recorder->record((TextureFile*)texture_handle_,
+                           LookupRecord::Texture, options, nchannels,
+                           dresultds != nullptr, coords);
+    }
+
     static const texture_lookup_prototype lookup_functions[] = {
         // Must be in the same order as Mipmode enum
         &TextureSystemImpl::texture_lookup,
@@ -1466,10 +1774,13 @@ TextureSystemImpl::texture(TextureHandle* texture_handle_,
         &TextureSystemImpl::texture_lookup_trilinear_mipmap,
         &TextureSystemImpl::texture_lookup_trilinear_mipmap,
         &TextureSystemImpl::texture_lookup,
-        &TextureSystemImpl::texture_lookup_trilinear_mipmap,
+        &TextureSystemImpl::texture_lookup_ewa,
         &TextureSystemImpl::texture_lookup
     };
     texture_lookup_prototype lookup = lookup_functions[(int)options.mipmode];
+    options.approximate             = false;
+    if (options.nonblocking)
+        lookup = &TextureSystemImpl::texture_lookup_nonblocking;
 
     PerThreadInfo* thread_info = m_imagecache->get_perthread_info(
         (PerThreadInfo*)thread_info_);
@@ -1560,6 +1871,8 @@ TextureSystemImpl::texture(TextureHandle* texture_handle_,
         dtdy *= subinfo.tscale;
     }
 
+    FileLookupScope filelookup(thread_info, texturefile,
+                               m_imagecache->per_file_stats());
     bool ok;
     // Everything from the lookup function on down will assume that there
     // is space for a vfloat4 in all of the result locations, so if that's
@@ -1625,14 +1938,18 @@ TextureSystemImpl::texture(ustring filename, TextureOptBatch& options,
 
 
 bool
-TextureSystemImpl::texture(TextureHandle* texture_handle,
-                           Perthread* thread_info, TextureOptBatch& options,
+TextureSystemImpl::texture(TextureHandle* texture_handle_,
+                           Perthread* thread_info_, TextureOptBatch& options,
                            Tex::RunMask mask, const float* s, const float* t,
                            const float* dsdx, const float* dtdx,
                            const float* dsdy, const float* dtdy, int nchannels,
                            float* result, float* dresultds, float* dresultdt)
 {
-    // (FIXME) CHEAT! Texture points individually
+    OIIO_TRACE_SPAN("TS::texture batch");
+    using Tex::BatchWidth;
+    using Tex::FloatWide;
+
+    // The non-varying options are shared by all lanes.
     TextureOpt opt;
     opt.firstchannel        = options.firstchannel;
     opt.subimage            = options.subimage;
@@ -1648,37 +1965,301 @@ TextureSystemImpl::texture(TextureHandle* texture_handle,
     opt.colortransformid    = options.colortransformid;
     // rwrap not needed for 2D texture
 
-    bool ok          = true;
-    Tex::RunMask bit = 1;
-    float* r         = OIIO_ALLOCA(float, 3 * nchannels);
-    float* drds      = r + nchannels;
-    float* drdt      = drds + nchannels;
-    for (int i = 0; i < Tex::BatchWidth; ++i, bit <<= 1) {
-        if (mask & bit) {
-            opt.sblur  = options.sblur[i];
-            opt.tblur  = options.tblur[i];
-            opt.swidth = options.swidth[i];
-            opt.twidth = options.twidth[i];
-            opt.rnd    = options.rnd[i];
-            // rblur, rwidth not needed for 2D texture
+    mask &= Tex::RunMaskOn;
+    if (!mask)
+        return true;
+
+    bool ok                  = true;
+    Tex::RunMask bit         = 1;
+    TextureFile* texturefile = (TextureFile*)texture_handle_;
+    if (texturefile && texturefile->is_udim()) {
+        // Each lane may resolve to a different UDIM tile. Find the tiles of
+        // all lanes at once, then give each distinct tile file a single
+        // batched lookup of just the lanes that landed in it, with s and t
+        // made relative to the tile.
+        using Tex::IntWide;
+        FloatWide S(s), T(t);
+        FloatWide Sfloor = floor(S), Tfloor = floor(T);
+        alignas(Tex::BatchAlign) int utile[BatchWidth], vtile[BatchWidth];
+        alignas(Tex::BatchAlign) float stile[BatchWidth], ttile[BatchWidth];
+        max(ifloor(S), IntWide::Zero()).store(utile);
+        max(ifloor(T), IntWide::Zero()).store(vtile);
+        (S - Sfloor).store(stile);
+        (T - Tfloor).store(ttile);
+
+        // Resolve each distinct tile just once.
+        PerThreadInfo* tinfo = m_imagecache->get_perthread_info(
+            (PerThreadInfo*)thread_info_);
+        TextureFile* files[BatchWidth];
+        for (int i = 0; i < BatchWidth; ++i, bit <<= 1) {
+            if (!(mask & bit))
+                continue;
+            int same = 0;
+            while (same < i
+                   && (!(mask & (Tex::RunMask(1) << same))
+                       || utile[same] != utile[i] || vtile[same] != vtile[i]))
+                ++same;
+            files[i] = (same < i) ? files[same]
+                                  : (TextureFile*)m_imagecache->resolve_udim(
+                                      texturefile, tinfo, utile[i], vtile[i]);
+        }
+
+        // Partition the lanes by the file they resolved to.
+        Tex::RunMask todo = mask;
+        for (int i = 0; todo; ++i) {
+            Tex::RunMask lane = Tex::RunMask(1) << i;
+            if (!(todo & lane))
+                continue;
+            Tex::RunMask group = 0;
+            for (int j = i; j < BatchWidth; ++j) {
+                Tex::RunMask b = Tex::RunMask(1) << j;
+                if ((todo & b) && files[j] == files[i])
+                    group |= b;
+            }
+            todo &= ~group;
+            ok &= texture((TextureHandle*)files[i], (Perthread*)tinfo, options,
+                          group, stile, ttile, dsdx, dtdx, dsdy, dtdy,
+                          nchannels, result, dresultds, dresultdt);
+        }
+        return ok;
+    }
+
+    if (OIIO_UNLIKELY(m_recorder)) {
+        // Record each lane as the lookup of one point that it amounts to.
+        TextureOpt lane = opt;
+        for (int i = 0; i < BatchWidth; ++i, bit <<= 1) {
+            if (!(mask & bit))
+                continue;
+            lane.sblur      = options.sblur[i];
+            lane.tblur      = options.tblur[i];
+            lane.swidth     = options.swidth[i];
+            lane.twidth     = options.twidth[i];
+            lane.rnd        = options.rnd[i];
+            float coords[6] = { s[i],    t[i],    dsdx[i],
+                                dtdx[i], dsdy[i], dtdy[i] };
+            m_recorder->record(texturefile, LookupRecord::Texture, lane,
+                               nchannels, dresultds != nullptr, coords);
+        }
+        bit = 1;
+    }
+
+    // Everything that does not vary per lane -- verifying the file,
+    // resolving the subimage, wrap modes, and the lookup function -- is
+    // done once for the whole batch rather than once per point.
+    PerThreadInfo* thread_info = m_imagecache->get_perthread_info(
+        (PerThreadInfo*)thread_info_);
+    texturefile = verify_texturefile(texturefile, thread_info);
+
+    ImageCacheStatistics& stats(thread_info->m_stats);
+    ++stats.texture_batches;
+
+    // Copy one lane's worth of results into the SOA output arrays.
+    auto scatter = [&](int lane, int firstc, int n, const float* r,
+                       const float* drds, const float* drdt) {
+        for (int c = 0; c < n; ++c) {
+            result[(firstc + c) * BatchWidth + lane] = r[c];
             if (dresultds) {
-                ok &= texture(texture_handle, thread_info, opt, s[i], t[i],
-                              dsdx[i], dtdx[i], dsdy[i], dtdy[i], nchannels, r,
-                              drds, drdt);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i]    = r[c];
-                    dresultds[c * Tex::BatchWidth + i] = drds[c];
-                    dresultdt[c * Tex::BatchWidth + i] = drdt[c];
-                }
-            } else {
-                ok &= texture(texture_handle, thread_info, opt, s[i], t[i],
-                              dsdx[i], dtdx[i], dsdy[i], dtdy[i], nchannels, r);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i] = r[c];
-                }
+                dresultds[(firstc + c) * BatchWidth + lane] = drds[c];
+                dresultdt[(firstc + c) * BatchWidth + lane] = drdt[c];
             }
         }
+    };
+    // Copy results that are identical in all lanes to every active lane.
+    auto broadcast = [&](const float* r, const float* drds,
+                         const float* drdt) {
+        Tex::RunMask b = 1;
+        for (int i = 0; i < BatchWidth; ++i, b <<= 1) {
+            if (mask & b) {
+                ++stats.texture_queries;
+                scatter(i, 0, nchannels, r, drds, drdt);
+            }
+        }
+    };
+
+    float* r    = OIIO_ALLOCA(float, 3 * nchannels);
+    float* drds = r + nchannels;
+    float* drdt = drds + nchannels;
+    if (!texturefile || texturefile->broken()) {
+        ok = missing_texture(opt, nchannels, r, drds, drdt);
+        broadcast(r, drds, drdt);
+        return ok;
+    }
+
+    if (!opt.subimagename.empty()) {
+        // If subimage was specified by name, figure out its index.
+        int si = m_imagecache->subimage_from_name(texturefile,
+                                                  opt.subimagename);
+        if (si < 0) {
+            error("Unknown subimage \"{}\" in texture \"{}\"",
+                  opt.subimagename, texturefile->filename());
+            ok = missing_texture(opt, nchannels, r, drds, drdt);
+            broadcast(r, drds, drdt);
+            return ok;
+        }
+        opt.subimage = si;
+        opt.subimagename.clear();
+    }
+
+    const ImageCacheFile::SubimageInfo& subinfo(
+        texturefile->subimageinfo(opt.subimage));
+    const ImageSpec& spec(texturefile->spec(opt.subimage, 0));
+
+    // Figure out the wrap functions
+    if (opt.swrap == TextureOpt::WrapDefault)
+        opt.swrap = (TextureOpt::Wrap)texturefile->swrap();
+    if (opt.swrap == TextureOpt::WrapPeriodic && ispow2(spec.width))
+        opt.swrap = TextureOpt::WrapPeriodicPow2;
+    if (opt.twrap == TextureOpt::WrapDefault)
+        opt.twrap = (TextureOpt::Wrap)texturefile->twrap();
+    if (opt.twrap == TextureOpt::WrapPeriodic && ispow2(spec.height))
+        opt.twrap = TextureOpt::WrapPeriodicPow2;
+
+    if (subinfo.is_constant_image && opt.swrap != TextureOpt::WrapBlack
+        && opt.twrap != TextureOpt::WrapBlack && opt.colortransformid <= 0) {
+        // Lookup of constant color texture, non-black wrap -- every lane
+        // gets the same answer, so compute it once.
+        int actualchannels = OIIO::clamp(spec.nchannels - opt.firstchannel, 0,
+                                         nchannels);
+        for (int c = 0; c < actualchannels; ++c)
+            r[c] = subinfo.average_color[c + opt.firstchannel];
+        for (int c = actualchannels; c < nchannels; ++c)
+            r[c] = opt.fill;
+        // Derivs are always 0 from a constant texture lookup
+        for (int c = 0; c < nchannels; ++c)
+            drds[c] = drdt[c] = 0.0f;
+        if (actualchannels < nchannels && opt.firstchannel == 0
+            && m_gray_to_rgb)
+            fill_gray_channels(spec, nchannels, r, drds, drdt);
+        broadcast(r, drds, drdt);
+        return true;
+    }
+
+    // Apply the t flip and the overscan/crop remapping to all lanes at
+    // once, rather than per point.
+    FloatWide S(s), T(t), DSDX(dsdx), DTDX(dtdx), DSDY(dsdy), DTDY(dtdy);
+    if (m_flip_t) {
+        T    = 1.0f - T;
+        DTDX = -DTDX;
+        DTDY = -DTDY;
+    }
+    if (!subinfo.full_pixel_range) {  // remap st for overscan or crop
+        FloatWide sscale(subinfo.sscale), tscale(subinfo.tscale);
+        S    = S * sscale + FloatWide(subinfo.soffset);
+        DSDX = DSDX * sscale;
+        DSDY = DSDY * sscale;
+        T    = T * tscale + FloatWide(subinfo.toffset);
+        DTDX = DTDX * tscale;
+        DTDY = DTDY * tscale;
+    }
+    alignas(Tex::BatchAlign) float sv[BatchWidth], tv[BatchWidth];
+    alignas(Tex::BatchAlign) float dsdxv[BatchWidth], dtdxv[BatchWidth];
+    alignas(Tex::BatchAlign) float dsdyv[BatchWidth], dtdyv[BatchWidth];
+    S.store(sv);
+    T.store(tv);
+    DSDX.store(dsdxv);
+    DTDX.store(dtdxv);
+    DSDY.store(dsdyv);
+    DTDY.store(dtdyv);
+
+    static const texture_lookup_prototype lookup_functions[] = {
+        // Must be in the same order as Mipmode enum
+        &TextureSystemImpl::texture_lookup,
+        &TextureSystemImpl::texture_lookup_nomip,
+        &TextureSystemImpl::texture_lookup_trilinear_mipmap,
+        &TextureSystemImpl::texture_lookup_trilinear_mipmap,
+        &TextureSystemImpl::texture_lookup,
+        &TextureSystemImpl::texture_lookup_ewa,
+        &TextureSystemImpl::texture_lookup
+    };
+    texture_lookup_prototype lookup = lookup_functions[(int)opt.mipmode];
+
+    // Only the setup above is shared across lanes. Each active lane is still
+    // filtered by the scalar lookup, at most 4 channels at a time, straight
+    // into aligned vfloat4 scratch space.
+    int firstchannel = opt.firstchannel;
+    for (int i = 0; i < BatchWidth; ++i, bit <<= 1) {
+        if (!(mask & bit))
+            continue;
+        ++stats.texture_queries;
+        opt.sblur  = options.sblur[i];
+        opt.tblur  = options.tblur[i];
+        opt.swidth = options.swidth[i];
+        opt.twidth = options.twidth[i];
+        opt.rnd    = options.rnd[i];
+        // rblur, rwidth not needed for 2D texture
+        FileLookupScope filelookup(thread_info, texturefile,
+                                   m_imagecache->per_file_stats());
+        for (int c0 = 0; c0 < nchannels; c0 += 4) {
+            int n              = std::min(nchannels - c0, 4);
+            opt.firstchannel   = firstchannel + c0;
+            int actualchannels = OIIO::clamp(spec.nchannels - opt.firstchannel,
+                                             0, n);
+            vfloat4 r4, drds4, drdt4;
+            ok &= (this->*lookup)(*texturefile, thread_info, opt, n,
+                                  actualchannels, sv[i], tv[i], dsdxv[i],
+                                  dtdxv[i], dsdyv[i], dtdyv[i], (float*)&r4,
+                                  dresultds ? (float*)&drds4 : nullptr,
+                                  dresultds ? (float*)&drdt4 : nullptr);
+            if (actualchannels < n && opt.firstchannel == 0 && m_gray_to_rgb)
+                fill_gray_channels(spec, n, (float*)&r4,
+                                   dresultds ? (float*)&drds4 : nullptr,
+                                   dresultds ? (float*)&drdt4 : nullptr);
+            if (m_flip_t && dresultds)
+                drdt4 = -drdt4;
+            scatter(i, c0, n, (const float*)&r4, (const float*)&drds4,
+                    (const float*)&drdt4);
+        }
+    }
+    return ok;
+}
+
+
+
+bool
+TextureSystemImpl::texture_lookup_nonblocking(
+    TextureFile& texturefile, PerThreadInfo* thread_info, TextureOpt& options,
+    int nchannels_result, int actualchannels, float s, float t, float dsdx,
+    float dtdx, float dsdy, float dtdy, float* result, float* dresultds,
+    float* dresultdt)
+{
+    static const texture_lookup_prototype lookup_functions[] = {
+        // Must be in the same order as Mipmode enum
+        &TextureSystemImpl::texture_lookup,
+        &TextureSystemImpl::texture_lookup_nomip,
+        &TextureSystemImpl::texture_lookup_trilinear_mipmap,
+        &TextureSystemImpl::texture_lookup_trilinear_mipmap,
+        &TextureSystemImpl::texture_lookup,
+        &TextureSystemImpl::texture_lookup_ewa,
+        &TextureSystemImpl::texture_lookup
+    };
+    texture_lookup_prototype lookup = lookup_functions[(int)options.mipmode];
+    const ImageCacheFile::SubimageInfo& subinfo(
+        texturefile.subimageinfo(options.subimage));
+    int coarsest = subinfo.n_mip_levels - 1;
+
+    // Each time the lookup wanted a tile that wasn't resident (and so was
+    // queued to be read), redo it with nothing finer than the next coarser
+    // level, until at the coarsest level we'll wait for the tiles. Any
+    // lookup, even a failed one, may have changed the results and rnd.
+    float rnd = options.rnd;
+    bool ok;
+    for (int level = 0;;) {
+        thread_info->m_nonblocking       = (level < coarsest);
+        thread_info->m_nonresident_level = -1;
+        thread_info->m_min_miplevel      = level;
+        options.rnd                      = rnd;
+        ok = (this->*lookup)(texturefile, thread_info, options,
+                             nchannels_result, actualchannels, s, t, dsdx,
+                             dtdx, dsdy, dtdy, result, dresultds, dresultdt);
+        if (thread_info->m_nonresident_level < 0)
+            break;
+        level = std::min(thread_info->m_nonresident_level + 1, coarsest);
+        options.approximate = true;
     }
+    thread_info->m_nonblocking  = false;
+    thread_info->m_min_miplevel = 0;
+    if (options.approximate)
+        ++thread_info->m_stats.approximate_lookups;
     return ok;
 }
 
@@ -1706,19 +2287,37 @@ TextureSystemImpl::texture_lookup_nomip(
         &TextureSystemImpl::sample_bicubic,
         &TextureSystemImpl::sample_bilinear,
     };
-    sampler_prototype sampler      = sample_functions[(int)options.interpmode];
+    // With StochasticStrategy_Texel, a single texel stands in for the
+    // whole interpolation, unless derivatives are needed.
+    static const sampler_prototype stochastic_texel_functions[] = {
+        // Must be in the same order as InterpMode enum
+        &TextureSystemImpl::sample_closest,
+        &TextureSystemImpl::sample_bilinear_texel,
+        &TextureSystemImpl::sample_bicubic_texel,
+        &TextureSystemImpl::sample_bilinear_texel,
+    };
+    bool stoch_texel = (options.rnd >= 0.0f
+                        && (m_stochastic & StochasticStrategy_Texel)
+                        && !dresultds);
+    sampler_prototype sampler
+        = stoch_texel ? stochastic_texel_functions[(int)options.interpmode]
+                      : sample_functions[(int)options.interpmode];
     OIIO_SIMD4_ALIGN float sval[4] = { s, 0.0f, 0.0f, 0.0f };
     OIIO_SIMD4_ALIGN float tval[4] = { t, 0.0f, 0.0f, 0.0f };
     static OIIO_SIMD4_ALIGN float weight[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
     ImageCacheFile::SubimageInfo& subinfo(
         texturefile.subimageinfo(options.subimage));
-    int min_mip_level = subinfo.min_mip_level;
+    int min_mip_level = std::max(subinfo.min_mip_level,
+                                 std::min(thread_info->m_min_miplevel,
+                                          subinfo.n_mip_levels - 1));
     bool ok = (this->*sampler)(1, sval, tval, min_mip_level, texturefile,
                                thread_info, options, nchannels_result,
                                actualchannels, weight, (vfloat4*)result,
                                (vfloat4*)dresultds, (vfloat4*)dresultdt);
 
     // Update stats
+    if (FileLookupStats* filestats = thread_info->m_lookup_stats)
+        filestats->add_level(min_mip_level, 1);
     ImageCacheStatistics& stats(thread_info->m_stats);
     ++stats.aniso_queries;
     ++stats.aniso_probes;
@@ -1846,17 +2445,19 @@ adjust_blur(float& majorlength, float& minorlength, float& theta, float sblur,
 // pixel-sized (and then we will sample several times along the major
 // axis in order to handle anisotropy), but we make adjustments in
 // corner cases where the ideal sampling is too high or too low resolution
-// given the MIPmap levels we have available.
+// given the MIPmap levels we have available (or may use: no level finer
+// than min_miplevel, for nonblocking lookups).
 inline void
 compute_miplevels(TextureSystemImpl::TextureFile& texturefile,
-                  TextureOpt& options, bool stochastic, float majorlength,
-                  float minorlength, float& aspect, int* miplevel,
-                  float* levelweight)
+                  TextureOpt& options, int min_miplevel, bool stochastic,
+                  float majorlength, float minorlength, float& aspect,
+                  int* miplevel, float* levelweight)
 {
     ImageCacheFile::SubimageInfo& subinfo(
         texturefile.subimageinfo(options.subimage));
     int nmiplevels    = subinfo.n_mip_levels;
-    int min_mip_level = subinfo.min_mip_level;
+    int min_mip_level = std::max(subinfo.min_mip_level,
+                                 std::min(min_miplevel, nmiplevels - 1));
     for (int m = min_mip_level; m < nmiplevels; ++m) {
         // Compute the filter size (minor axis) in raster space at this
         // MIP level.  We use the smaller of the two texture resolutions,
@@ -1964,8 +2565,9 @@ TextureSystemImpl::texture_lookup_trilinear_mipmap(
     // account for blur
     filtwidth += std::max(options.sblur, options.tblur);
     float aspect = 1.0f;
-    compute_miplevels(texturefile, options, stoch_mip, filtwidth, filtwidth,
-                      aspect, miplevel, levelweight);
+    compute_miplevels(texturefile, options, thread_info->m_min_miplevel,
+                      stoch_mip, filtwidth, filtwidth, aspect, miplevel,
+                      levelweight);
 
     static const sampler_prototype sample_functions[] = {
         // Must be in the same order as InterpMode enum
@@ -1974,7 +2576,21 @@ TextureSystemImpl::texture_lookup_trilinear_mipmap(
         &TextureSystemImpl::sample_bicubic,
         &TextureSystemImpl::sample_bilinear,
     };
-    sampler_prototype sampler = sample_functions[(int)options.interpmode];
+    // With StochasticStrategy_Texel, a single texel stands in for the
+    // whole interpolation, unless derivatives are needed.
+    static const sampler_prototype stochastic_texel_functions[] = {
+        // Must be in the same order as InterpMode enum
+        &TextureSystemImpl::sample_closest,
+        &TextureSystemImpl::sample_bilinear_texel,
+        &TextureSystemImpl::sample_bicubic_texel,
+        &TextureSystemImpl::sample_bilinear_texel,
+    };
+    bool stoch_texel = (options.rnd >= 0.0f
+                        && (m_stochastic & StochasticStrategy_Texel)
+                        && !dresultds);
+    sampler_prototype sampler
+        = stoch_texel ? stochastic_texel_functions[(int)options.interpmode]
+                      : sample_functions[(int)options.interpmode];
 
     // FIXME -- support for smart cubic?
 
@@ -2014,6 +2630,15 @@ TextureSystemImpl::texture_lookup_trilinear_mipmap(
     }
 
     // Update stats
+    if (FileLookupStats* filestats = thread_info->m_lookup_stats) {
+        const ImageCacheFile::SubimageInfo& subinfo(
+            texturefile.subimageinfo(options.subimage));
+        for (int level = 0; level < 2; ++level)
+            if (levelweight[level])
+                filestats->add_level(miplevel[level], 1);
+        if (filtwidth * subinfo.minwh[subinfo.min_mip_level] <= 1.0f)
+            ++filestats->magnified;
+    }
     ImageCacheStatistics& stats(thread_info->m_stats);
     stats.aniso_queries += npointson;
     stats.aniso_probes += npointson;
@@ -2170,6 +2795,16 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
     bool stoch       = (options.rnd >= 0.0f);
     bool stoch_mip   = stoch && (m_stochastic & StochasticStrategy_MIP);
     bool stoch_aniso = stoch && (m_stochastic & StochasticStrategy_Aniso);
+    bool stoch_texel = stoch && (m_stochastic & StochasticStrategy_Texel)
+                       && !dresultds;
+    // With StochasticStrategy_Texel, a single texel stands in for each
+    // bilinear or bicubic interpolation.
+    sampler_prototype sample_bilinear_func
+        = stoch_texel ? &TextureSystemImpl::sample_bilinear_texel
+                      : &TextureSystemImpl::sample_bilinear;
+    sampler_prototype sample_bicubic_func
+        = stoch_texel ? &TextureSystemImpl::sample_bicubic_texel
+                      : &TextureSystemImpl::sample_bicubic;
     // Scale by 'width'
     adjust_width(dsdx, dtdx, dsdy, dtdy, options.swidth, options.twidth);
 
@@ -2193,8 +2828,9 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
 
     int miplevel[2]      = { -1, -1 };
     float levelweight[2] = { 0, 0 };
-    compute_miplevels(texturefile, options, stoch_mip, majorlength, minorlength,
-                      aspect, miplevel, levelweight);
+    compute_miplevels(texturefile, options, thread_info->m_min_miplevel,
+                      stoch_mip, majorlength, minorlength, aspect, miplevel,
+                      levelweight);
 
     int maxsamples    = round_to_multiple_of_pow2(2 * options.anisotropic, 4);
     float* lineweight = OIIO_ALLOCA(float, 4 * maxsamples);
@@ -2206,6 +2842,12 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
                                             minorlength, smajor, tmajor,
                                             invsamples, lineweight, samplepos,
                                             stoch_aniso, options.rnd);
+    if (stoch_aniso && stoch_texel) {
+        // The probe position took the leading bits of rnd; choosing the
+        // texel gets the rest.
+        options.rnd *= 256.0f;
+        options.rnd -= floorf(options.rnd);
+    }
     // All the computations were done assuming full diametric axes of
     // the ellipse, but our derivatives are pixel-to-pixel, yielding
     // semi-major and semi-minor lengths, so we need to scale everything
@@ -2257,19 +2899,17 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
             ++closestprobes;
             break;
         case TextureOpt::InterpBilinear:
-            ok &= sample_bilinear(nsamples, sval, tval, lev, texturefile,
-                                  thread_info, options, nchannels_result,
-                                  actualchannels, lineweight, &r,
-                                  dresultds ? &drds : NULL,
-                                  dresultds ? &drdt : NULL);
+            ok &= (this->*sample_bilinear_func)(
+                nsamples, sval, tval, lev, texturefile, thread_info, options,
+                nchannels_result, actualchannels, lineweight, &r,
+                dresultds ? &drds : NULL, dresultds ? &drdt : NULL);
             ++bilinearprobes;
             break;
         case TextureOpt::InterpBicubic:
-            ok &= sample_bicubic(nsamples, sval, tval, lev, texturefile,
-                                 thread_info, options, nchannels_result,
-                                 actualchannels, lineweight, &r,
-                                 dresultds ? &drds : NULL,
-                                 dresultds ? &drdt : NULL);
+            ok &= (this->*sample_bicubic_func)(
+                nsamples, sval, tval, lev, texturefile, thread_info, options,
+                nchannels_result, actualchannels, lineweight, &r,
+                dresultds ? &drds : NULL, dresultds ? &drdt : NULL);
             ++bicubicprobes;
             break;
         case TextureOpt::InterpSmartBicubic:
@@ -2278,18 +2918,16 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
                     < naturalsres / 2)
                 || (texturefile.spec(options.subimage, lev).height
                     < naturaltres / 2)) {
-                ok &= sample_bicubic(nsamples, sval, tval, lev, texturefile,
-                                     thread_info, options, nchannels_result,
-                                     actualchannels, lineweight, &r,
-                                     dresultds ? &drds : NULL,
-                                     dresultds ? &drdt : NULL);
+                ok &= (this->*sample_bicubic_func)(
+                    nsamples, sval, tval, lev, texturefile, thread_info,
+                    options, nchannels_result, actualchannels, lineweight, &r,
+                    dresultds ? &drds : NULL, dresultds ? &drdt : NULL);
                 ++bicubicprobes;
             } else {
-                ok &= sample_bilinear(nsamples, sval, tval, lev, texturefile,
-                                      thread_info, options, nchannels_result,
-                                      actualchannels, lineweight, &r,
-                                      dresultds ? &drds : NULL,
-                                      dresultds ? &drdt : NULL);
+                ok &= (this->*sample_bilinear_func)(
+                    nsamples, sval, tval, lev, texturefile, thread_info,
+                    options, nchannels_result, actualchannels, lineweight, &r,
+                    dresultds ? &drds : NULL, dresultds ? &drdt : NULL);
                 ++bilinearprobes;
             }
             break;
@@ -2310,6 +2948,15 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
     }
 
     // Update stats
+    if (FileLookupStats* filestats = thread_info->m_lookup_stats) {
+        const ImageCacheFile::SubimageInfo& subinfo(
+            texturefile.subimageinfo(options.subimage));
+        for (int level = 0; level < 2; ++level)
+            if (levelweight[level])
+                filestats->add_level(miplevel[level], nsamples);
+        if (minorlength * subinfo.minwh[subinfo.min_mip_level] <= 1.0f)
+            ++filestats->magnified;
+    }
     ImageCacheStatistics& stats(thread_info->m_stats);
     stats.aniso_queries += npointson;
     stats.aniso_probes += npointson * nsamples;
@@ -2324,6 +2971,194 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
 
 
 
+namespace {
+
+// The EWA filter weight, exp(-2 r^2), tabulated for r^2 (the elliptical
+// distance squared of a texel from the lookup point) on [0,1], beyond
+// which texels get no weight at all.
+struct EWAWeightTable {
+    static constexpr int size = 128;
+    float weight[size + 1];
+    EWAWeightTable()
+    {
+        for (int i = 0; i <= size; ++i)
+            weight[i] = expf(-2.0f * float(i) / float(size));
+    }
+};
+static const EWAWeightTable ewa_weights;
+
+}  // namespace
+
+
+
+bool
+TextureSystemImpl::texture_lookup_ewa(TextureFile& texturefile,
+                                      PerThreadInfo* thread_info,
+                                      TextureOpt& options,
+                                      int nchannels_result, int actualchannels,
+                                      float s, float t, float dsdx, float dtdx,
+                                      float dsdy, float dtdy, float* result,
+                                      float* dresultds, float* dresultdt)
+{
+    OIIO_DASSERT((dresultds == NULL) == (dresultdt == NULL));
+    bool stoch_mip = (options.rnd >= 0.0f)
+                     && (m_stochastic & StochasticStrategy_MIP);
+    adjust_width(dsdx, dtdx, dsdy, dtdy, options.swidth, options.twidth);
+
+    // The same ellipse, and the same limit on its eccentricity, as for
+    // anisotropic probes.
+    float majorlength, minorlength, theta;
+    ellipse_axes(dsdx, dtdx, dsdy, dtdy, majorlength, minorlength, theta);
+    adjust_blur(majorlength, minorlength, theta, options.sblur, options.tblur);
+    float trueaspect;
+    float aspect = anisotropic_aspect(majorlength, minorlength, options,
+                                      trueaspect);
+
+    // Filter on the finer of the two levels that trilinear would blend,
+    // where the minor axis is 1-2 texels long, and go coarser only if the
+    // ellipse would cover an unreasonable number of texels.
+    int miplevel[2]      = { -1, -1 };
+    float levelweight[2] = { 0, 0 };
+    compute_miplevels(texturefile, options, thread_info->m_min_miplevel,
+                      stoch_mip, majorlength, minorlength, aspect, miplevel,
+                      levelweight);
+    int lev = levelweight[0] > 0.0f ? miplevel[0] : miplevel[1];
+    const ImageCacheFile::SubimageInfo& subinfo(
+        texturefile.subimageinfo(options.subimage));
+    int maxtexels = 32 * OIIO::clamp(int(options.anisotropic), 1, 64);
+    float smaj, tmaj;
+    sincos(theta, &tmaj, &smaj);
+    float px, py, ex, ey, M00, M01, M11;
+    int x0, x1, y0, y1;
+    float ires, jres;
+    for (;; ++lev) {
+        // Find the ellipse in texel coordinates of this level. Its axes
+        // sum (as covariances) with a circle of one texel's radius, which
+        // reconstructs between texels, so that a tiny ellipse still
+        // reaches the texels around it.
+        const ImageSpec& spec(texturefile.spec(options.subimage, lev));
+        if (texturefile.sample_border() == 0) {
+            ires = float(spec.width);
+            jres = float(spec.height);
+            px   = s * ires + (spec.x - 0.5f);
+            py   = t * jres + (spec.y - 0.5f);
+        } else {
+            ires = float(spec.width - 1);
+            jres = float(spec.height - 1);
+            px   = s * ires + float(spec.x);
+            py   = t * jres + float(spec.y);
+        }
+        float ux = majorlength * smaj * ires, uy = majorlength * tmaj * jres;
+        float vx = -minorlength * tmaj * ires, vy = minorlength * smaj * jres;
+        float S00 = ux * ux + vx * vx + 1.0f;
+        float S01 = ux * uy + vx * vy;
+        float S11 = uy * uy + vy * vy + 1.0f;
+        float det = std::max(S00 * S11 - S01 * S01, 1.0e-12f);
+        M00       = S11 / det;
+        M01       = -S01 / det;
+        M11       = S00 / det;
+        ex        = sqrtf(S00);
+        ey        = sqrtf(S11);
+        x0        = ifloor(px - ex) + 1;
+        x1        = ifloor(px + ex);
+        y0        = ifloor(py - ey) + 1;
+        y1        = ifloor(py + ey);
+        if ((x1 - x0 + 1) * (y1 - y0 + 1) <= maxtexels
+            || lev + 1 >= subinfo.n_mip_levels)
+            break;
+    }
+    // Just in case the coarsest level is no help either.
+    x1 = std::min(x1, x0 + maxtexels - 1);
+    y1 = std::min(y1, y0 + maxtexels / std::max(1, x1 - x0 + 1) - 1);
+
+    // Weigh every texel inside the ellipse, four at a time, and gather the
+    // contributing ones as closest-texel samples.
+    float* sval    = OIIO_ALLOCA(float, 4 * (maxtexels + 4));
+    float* tval    = sval + (maxtexels + 4);
+    float* weight  = tval + (maxtexels + 4);
+    float* dweight = weight + (maxtexels + 4);
+    int ntexels    = 0;
+    float sumw     = 0.0f;
+    vfloat4 iota(0.0f, 1.0f, 2.0f, 3.0f);
+    for (int y = y0; y <= y1; ++y) {
+        float dy = float(y) - py;
+        for (int x = x0; x <= x1; x += 4) {
+            vfloat4 dx = vfloat4(float(x) - px) + iota;
+            vfloat4 q  = (M00 * dx + 2.0f * M01 * dy) * dx + M11 * dy * dy;
+            vbool4 in  = (q < 1.0f) & (dx <= x1 - px + 0.5f);
+            if (none(in))
+                continue;
+            vint4 index = vint4(q * float(EWAWeightTable::size));
+            for (int i = 0; i < 4; ++i) {
+                if (!in[i])
+                    continue;
+                float w = ewa_weights.weight[index[i]];
+                // The sample at the texel center finds exactly that texel
+                sval[ntexels]   = (float(x + i) - px) / ires + s;
+                tval[ntexels]   = dy / jres + t;
+                weight[ntexels] = w;
+                sumw += w;
+                ++ntexels;
+            }
+        }
+    }
+    if (ntexels == 0) {
+        // Degenerate; the reconstruction makes this all but impossible.
+        sval[0]   = s;
+        tval[0]   = t;
+        weight[0] = sumw = 1.0f;
+        ntexels          = 1;
+    }
+    float invw = 1.0f / sumw;
+    for (int i = 0; i < ntexels; ++i)
+        weight[i] *= invw;
+
+    vfloat4 r;
+    bool ok = sample_closest(ntexels, sval, tval, lev, texturefile,
+                             thread_info, options, nchannels_result,
+                             actualchannels, weight, &r, NULL, NULL);
+    *(simd::vfloat4*)(result) = r;
+    if (dresultds) {
+        // d(weight_i)/dp = 4 w_i M (x_i - p) in texels, so the derivative
+        // of the normalized average is sum(dw_i T_i) - r * sum(dw_i).
+        vfloat4 rmasked = blend0(r, channel_masks[actualchannels]);
+        TextureOpt nofill(options);
+        nofill.fill = 0.0f;
+        for (int axis = 0; axis < 2; ++axis) {
+            float sumdw = 0.0f;
+            for (int i = 0; i < ntexels; ++i) {
+                float dx   = (sval[i] - s) * ires;
+                float dy   = (tval[i] - t) * jres;
+                float grad = axis == 0 ? (M00 * dx + M01 * dy) * ires
+                                       : (M01 * dx + M11 * dy) * jres;
+                dweight[i] = 4.0f * weight[i] * grad;
+                sumdw += dweight[i];
+            }
+            vfloat4 d;
+            ok &= sample_closest(ntexels, sval, tval, lev, texturefile,
+                                 thread_info, nofill, nchannels_result,
+                                 actualchannels, dweight, &d, NULL, NULL);
+            d -= rmasked * sumdw;
+            *(simd::vfloat4*)(axis == 0 ? dresultds : dresultdt) = d;
+        }
+    }
+
+    if (FileLookupStats* filestats = thread_info->m_lookup_stats) {
+        filestats->add_level(lev, ntexels);
+        if (minorlength * subinfo.minwh[subinfo.min_mip_level] <= 1.0f)
+            ++filestats->magnified;
+    }
+    ImageCacheStatistics& stats(thread_info->m_stats);
+    stats.aniso_queries += 1;
+    stats.aniso_probes += ntexels;
+    if (trueaspect > stats.max_aniso)
+        stats.max_aniso = trueaspect;
+    stats.closest_interps += ntexels;
+    return ok;
+}
+
+
+
 const float*
 TextureSystemImpl::pole_color(TextureFile& texturefile,
                               PerThreadInfo* /*thread_info*/,
@@ -2415,6 +3250,7 @@ TextureSystemImpl::fade_to_pole(float t, float* accum, float& weight,
 
 
 
+OIIO_SIMD_DISPATCH_CLONES
 bool
 TextureSystemImpl::sample_closest(
     int nsamples, const float* s_, const float* t_, int miplevel,
@@ -2551,22 +3387,64 @@ st_to_texel_simd(const vfloat4& s_, const vfloat4& t_,
 
 
 
+OIIO_SIMD_DISPATCH_CLONES
 bool
 TextureSystemImpl::sample_bilinear(
     int nsamples, const float* s_, const float* t_, int miplevel,
     TextureFile& texturefile, PerThreadInfo* thread_info, TextureOpt& options,
     int nchannels_result, int actualchannels, const float* weight_,
     vfloat4* accum_, vfloat4* daccumds_, vfloat4* daccumdt_)
+{
+    // Choose the pixel type once for all the samples, rather than for
+    // every texel.
+    switch (texturefile.pixeltype(options.subimage)) {
+    case TypeDesc::UINT8:
+        return sample_bilinear_typed<uint8_t>(nsamples, s_, t_, miplevel,
+                                              texturefile, thread_info,
+                                              options, nchannels_result,
+                                              actualchannels, weight_, accum_,
+                                              daccumds_, daccumdt_);
+    case TypeDesc::UINT16:
+        return sample_bilinear_typed<uint16_t>(nsamples, s_, t_, miplevel,
+                                               texturefile, thread_info,
+                                               options, nchannels_result,
+                                               actualchannels, weight_,
+                                               accum_, daccumds_, daccumdt_);
+    case TypeDesc::HALF:
+        return sample_bilinear_typed<half>(nsamples, s_, t_, miplevel,
+                                           texturefile, thread_info, options,
+                                           nchannels_result, actualchannels,
+                                           weight_, accum_, daccumds_,
+                                           daccumdt_);
+    default:
+        OIIO_DASSERT(texturefile.pixeltype(options.subimage)
+                     == TypeDesc::FLOAT);
+        return sample_bilinear_typed<float>(nsamples, s_, t_, miplevel,
+                                            texturefile, thread_info, options,
+                                            nchannels_result, actualchannels,
+                                            weight_, accum_, daccumds_,
+                                            daccumdt_);
+    }
+}
+
+
+
+template<typename T>
+bool
+TextureSystemImpl::sample_bilinear_typed(
+    int nsamples, const float* s_, const float* t_, int miplevel,
+    TextureFile& texturefile, PerThreadInfo* thread_info, TextureOpt& options,
+    int nchannels_result, int actualchannels, const float* weight_,
+    vfloat4* accum_, vfloat4* daccumds_, vfloat4* daccumdt_)
 {
     const ImageSpec& spec(texturefile.spec(options.subimage, miplevel));
     const ImageCacheFile::LevelInfo& levelinfo(
         texturefile.levelinfo(options.subimage, miplevel));
-    TypeDesc::BASETYPE pixeltype = texturefile.pixeltype(options.subimage);
-    wrap_impl swrap_func         = wrap_functions[(int)options.swrap];
-    wrap_impl twrap_func         = wrap_functions[(int)options.twrap];
-    wrap_impl_simd wrap_func     = (swrap_func == twrap_func)
-                                       ? wrap_functions_simd[(int)options.swrap]
-                                       : NULL;
+    wrap_impl swrap_func     = wrap_functions[(int)options.swrap];
+    wrap_impl twrap_func     = wrap_functions[(int)options.twrap];
+    wrap_impl_simd wrap_func = (swrap_func == twrap_func)
+                                   ? wrap_functions_simd[(int)options.swrap]
+                                   : NULL;
     simd::vint4 xy(spec.x, spec.y);
     simd::vint4 widthheight(spec.width, spec.height);
     simd::vint4 tilewh(spec.tile_width, spec.tile_height);
@@ -2667,39 +3545,18 @@ TextureSystemImpl::sample_bilinear(
             if (!ok)
                 error("{}", m_imagecache->geterror());
             TileRef& tile(thread_info->tile);
-            if (!tile->valid())
+            if (!tile || !tile->valid())
                 return false;
             int pixelsize      = tile->pixelsize();
             imagesize_t offset = tile->pixel_offset(tile_st[S0], tile_st[T0]);
             const unsigned char* p = tile->bytedata() + offset
                                      + channelsize
                                            * (firstchannel - id.chbegin());
-            if (pixeltype == TypeDesc::UINT8) {
-                texel_simd[0][0] = uchar2float4(p);
-                texel_simd[0][1] = uchar2float4(p + pixelsize);
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0] = uchar2float4(p);
-                texel_simd[1][1] = uchar2float4(p + pixelsize);
-            } else if (pixeltype == TypeDesc::UINT16) {
-                texel_simd[0][0] = ushort2float4((uint16_t*)p);
-                texel_simd[0][1] = ushort2float4((uint16_t*)(p + pixelsize));
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0] = ushort2float4((uint16_t*)p);
-                texel_simd[1][1] = ushort2float4((uint16_t*)(p + pixelsize));
-            } else if (pixeltype == TypeDesc::HALF) {
-                texel_simd[0][0] = vfloat4((half*)p);
-                texel_simd[0][1] = vfloat4((half*)(p + pixelsize));
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0] = vfloat4((half*)p);
-                texel_simd[1][1] = vfloat4((half*)(p + pixelsize));
-            } else {
-                OIIO_DASSERT(pixeltype == TypeDesc::FLOAT);
-                texel_simd[0][0].load((const float*)p);
-                texel_simd[0][1].load((const float*)(p + pixelsize));
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0].load((const float*)p);
-                texel_simd[1][1].load((const float*)(p + pixelsize));
-            }
+            texel_simd[0][0] = load_texel<T>(p);
+            texel_simd[0][1] = load_texel<T>(p + pixelsize);
+            p += pixelsize * spec.tile_width;
+            texel_simd[1][0] = load_texel<T>(p);
+            texel_simd[1][1] = load_texel<T>(p + pixelsize);
         } else {
             bool noreusetile      = (options.swrap == TextureOpt::WrapMirror);
             simd::vint4 tile_st   = (sttex - xy) % tilewh;
@@ -2726,29 +3583,18 @@ TextureSystemImpl::sample_bilinear(
                         bool ok = find_tile(id, thread_info, sample == 0);
                         if (!ok)
                             error("{}", m_imagecache->geterror());
-                        if (!thread_info->tile->valid()) {
+                        if (!thread_info->tile
+                            || !thread_info->tile->valid()) {
                             return false;
                         }
-                        OIIO_DASSERT(thread_info->tile->id() == id);
+                        OIIO_DASSERT(same_tile(thread_info->tile->id(), id));
                     }
                     TileRef& tile(thread_info->tile);
                     imagesize_t offset = tile->pixel_offset(tile_s, tile_t);
                     offset += (firstchannel - id.chbegin()) * channelsize;
                     OIIO_DASSERT(offset < spec.tile_bytes());
-                    if (pixeltype == TypeDesc::UINT8)
-                        texel_simd[j][i] = uchar2float4(
-                            (const unsigned char*)(tile->bytedata() + offset));
-                    else if (pixeltype == TypeDesc::UINT16)
-                        texel_simd[j][i] = ushort2float4(
-                            (const unsigned short*)(tile->bytedata() + offset));
-                    else if (pixeltype == TypeDesc::HALF)
-                        texel_simd[j][i] = vfloat4(
-                            (const half*)(tile->bytedata() + offset));
-                    else {
-                        OIIO_DASSERT(pixeltype == TypeDesc::FLOAT);
-                        texel_simd[j][i].load(
-                            (const float*)(tile->bytedata() + offset));
-                    }
+                    texel_simd[j][i] = load_texel<T>(tile->bytedata()
+                                                     + offset);
                 }
             }
         }
@@ -2901,6 +3747,7 @@ evalBSplineWeights_and_derivs(simd::vfloat4* w, float fraction,
 
 
 
+OIIO_SIMD_DISPATCH_CLONES
 bool
 TextureSystemImpl::sample_bicubic(
     int nsamples, const float* s_, const float* t_, int miplevel,
@@ -2948,6 +3795,9 @@ TextureSystemImpl::sample_bicubic(
     int pixelsize                         = channelsize * id.nchannels();
     imagesize_t firstchannel_offset_bytes = channelsize
                                             * (firstchannel - id.chbegin());
+    // Single-channel tiles (as displacement maps usually are) have each
+    // row of 4 texels in one place, and we filter them all at once.
+    bool single_channel = (id.nchannels() == 1);
     vfloat4 accum, daccumds, daccumdt;
     accum.clear();
     if (daccumds_) {
@@ -3000,6 +3850,8 @@ TextureSystemImpl::sample_bicubic(
         }
 
         simd::vfloat4 texel_simd[4][4];
+        simd::vfloat4 rows[4];  // Texels 0-3 of each row, if rowwise
+        bool rowwise = false;
         // int tile_s = (stex[0] - spec.x) % spec.tile_width;
         // int tile_t = (ttex[0] - spec.y) % spec.tile_height;
         int tile_s = (stex[0] - spec.x);
@@ -3041,7 +3893,22 @@ TextureSystemImpl::sample_bicubic(
             const unsigned char* base = tile->bytedata() + offset
                                         + firstchannel_offset_bytes;
             OIIO_DASSERT(tile->data());
-            if (pixeltype == TypeDesc::UINT8) {
+            rowwise = single_channel;
+            if (rowwise) {
+                imagesize_t rowbytes = imagesize_t(pixelsize)
+                                       * spec.tile_width;
+                for (int j = 0; j < 4; ++j) {
+                    const unsigned char* row = base + j * rowbytes;
+                    if (pixeltype == TypeDesc::UINT8)
+                        rows[j] = uchar2float4(row);
+                    else if (pixeltype == TypeDesc::UINT16)
+                        rows[j] = ushort2float4((const uint16_t*)row);
+                    else if (pixeltype == TypeDesc::HALF)
+                        rows[j] = vfloat4((const half*)row);
+                    else
+                        rows[j].load((const float*)row);
+                }
+            } else if (pixeltype == TypeDesc::UINT8) {
                 for (int j = 0, j_offset = 0; j < 4;
                      ++j, j_offset += pixelsize * spec.tile_width)
                     for (int i = 0, i_offset = j_offset; i < 4;
@@ -3101,9 +3968,10 @@ TextureSystemImpl::sample_bicubic(
                         bool ok = find_tile(id, thread_info, sample == 0);
                         if (!ok)
                             error("{}", m_imagecache->geterror());
-                        OIIO_DASSERT(thread_info->tile->id() == id);
-                        if (!thread_info->tile->valid())
+                        if (!thread_info->tile
+                            || !thread_info->tile->valid())
                             return false;
+                        OIIO_DASSERT(same_tile(thread_info->tile->id(), id));
                     }
                     TileRef& tile(thread_info->tile);
                     OIIO_DASSERT(tile->data());
@@ -3196,6 +4064,37 @@ TextureSystemImpl::sample_bicubic(
         vfloat4 wx13_wy13 = AxyBxy(wx_1302, wy_1302);
         vfloat4 h         = wx13_wy13 / g;  // [ h0x h1x h0y h1y ]
 
+        if (rowwise) {
+            // The same lerps as below, but with the lanes holding the 4
+            // rows (or columns) of the one channel rather than 4 channels,
+            // so that all the rows are filtered at once.
+            simd::vfloat4 column[4];
+            simd::transpose(rows[0], rows[1], rows[2], rows[3], column[0],
+                            column[1], column[2], column[3]);
+            simd::vfloat4 lx  = lerp(column[0], column[1], shuffle<0>(h));
+            simd::vfloat4 rx  = lerp(column[2], column[3], shuffle<1>(h));
+            simd::vfloat4 col = lerp(lx, rx, shuffle<1>(g));  // by row
+            float ly          = lerp(col[0], col[1], extract<2>(h));
+            float ry          = lerp(col[2], col[3], extract<3>(h));
+            accum += vfloat4(weight * lerp(ly, ry, extract<3>(g)), 0.0f, 0.0f,
+                             0.0f);
+            if (daccumds_) {
+                // Each column weighted by wy, and each row by wx.
+                simd::vfloat4 bycol = wy[0] * rows[0] + wy[1] * rows[1]
+                                      + wy[2] * rows[2] + wy[3] * rows[3];
+                simd::vfloat4 byrow = wx[0] * column[0] + wx[1] * column[1]
+                                      + wx[2] * column[2]
+                                      + wx[3] * column[3];
+                daccumds += vfloat4(weight * float(spec.width)
+                                        * dot(dwx, bycol),
+                                    0.0f, 0.0f, 0.0f);
+                daccumdt += vfloat4(weight * float(spec.height)
+                                        * dot(dwy, byrow),
+                                    0.0f, 0.0f, 0.0f);
+            }
+            continue;  // All texels were valid, so no fill to consider
+        }
+
         simd::vfloat4 col[4];
         for (int j = 0; j < 4; ++j) {
             simd::vfloat4 lx = lerp(texel_simd[j][0], texel_simd[j][1],
@@ -3292,6 +4191,113 @@ TextureSystemImpl::sample_bicubic(
 
 
 
+namespace {
+
+// Choose one of the texels that a bilinear (texels 0 and 1 relative to
+// the one to the "upper left" of the lookup point) or B-spline bicubic
+// (texels -1 to 2) interpolation with fraction `frac` would blend, with
+// probability equal to its weight, using the uniform random number u.
+// Then rescale u so that it can be used again.
+inline int
+choose_texel(float frac, bool bicubic, float& u)
+{
+    float w[4];
+    int first, n;
+    if (bicubic) {
+        evalBSplineWeights_and_derivs(w, frac);
+        first = -1;
+        n     = 4;
+    } else {
+        w[0]  = 1.0f - frac;
+        w[1]  = frac;
+        first = 0;
+        n     = 2;
+    }
+    int i = 0;
+    for (; i < n - 1 && u >= w[i]; ++i)
+        u -= w[i];
+    u = w[i] > 0.0f ? OIIO::clamp(u / w[i], 0.0f, 1.0f) : 0.0f;
+    return first + i;
+}
+
+}  // namespace
+
+
+
+bool
+TextureSystemImpl::sample_texel(bool bicubic, int nsamples, const float* s_,
+                                const float* t_, int miplevel,
+                                TextureFile& texturefile,
+                                PerThreadInfo* thread_info, TextureOpt& options,
+                                int nchannels_result, int actualchannels,
+                                const float* weight_, vfloat4* accum_,
+                                vfloat4* daccumds_, vfloat4* daccumdt_)
+{
+    // Replace each sample position with the center of the one texel it
+    // will look up, then just fetch those.
+    const ImageSpec& spec(texturefile.spec(options.subimage, miplevel));
+    bool border    = texturefile.sample_border();
+    float sscale   = border ? float(std::max(1, spec.width - 1))
+                            : float(spec.width);
+    float tscale   = border ? float(std::max(1, spec.height - 1))
+                            : float(spec.height);
+    float center   = border ? 0.0f : 0.5f;
+    int maxsamples = round_to_multiple_of_pow2(nsamples, 4);
+    float* sval    = OIIO_ALLOCA(float, 2 * maxsamples);
+    float* tval    = sval + maxsamples;
+    for (int sample = 0; sample < nsamples; ++sample) {
+        // Spread the one random number over the samples along the line
+        // with golden ratio steps.
+        float u = options.rnd + sample * 0.618034f;
+        u -= floorf(u);
+        int stex, ttex;
+        float sfrac, tfrac;
+        st_to_texel(s_[sample], t_[sample], texturefile, spec, stex, ttex,
+                    sfrac, tfrac);
+        stex += choose_texel(sfrac, bicubic, u);
+        ttex += choose_texel(tfrac, bicubic, u);
+        sval[sample] = (float(stex - spec.x) + center) / sscale;
+        tval[sample] = (float(ttex - spec.y) + center) / tscale;
+    }
+    if (daccumds_) {
+        daccumds_->clear();
+        daccumdt_->clear();
+    }
+    return sample_closest(nsamples, sval, tval, miplevel, texturefile,
+                          thread_info, options, nchannels_result,
+                          actualchannels, weight_, accum_, NULL, NULL);
+}
+
+
+
+bool
+TextureSystemImpl::sample_bilinear_texel(
+    int nsamples, const float* s_, const float* t_, int miplevel,
+    TextureFile& texturefile, PerThreadInfo* thread_info, TextureOpt& options,
+    int nchannels_result, int actualchannels, const float* weight_,
+    vfloat4* accum_, vfloat4* daccumds_, vfloat4* daccumdt_)
+{
+    return sample_texel(false, nsamples, s_, t_, miplevel, texturefile,
+                        thread_info, options, nchannels_result, actualchannels,
+                        weight_, accum_, daccumds_, daccumdt_);
+}
+
+
+
+bool
+TextureSystemImpl::sample_bicubic_texel(
+    int nsamples, const float* s_, const float* t_, int miplevel,
+    TextureFile& texturefile, PerThreadInfo* thread_info, TextureOpt& options,
+    int nchannels_result, int actualchannels, const float* weight_,
+    vfloat4* accum_, vfloat4* daccumds_, vfloat4* daccumdt_)
+{
+    return sample_texel(true, nsamples, s_, t_, miplevel, texturefile,
+                        thread_info, options, nchannels_result, actualchannels,
+                        weight_, accum_, daccumds_, daccumdt_);
+}
+
+
+
 void
 TextureSystemImpl::visualize_ellipse(const std::string& name, float dsdx,
                                      float dtdx, float dsdy, float dtdy,
@@ -29,6 +29,7 @@
 
 // https://github.com/google/farmhash
 
+#include <OpenImageIO/strutil.h>
 #include <OpenImageIO/detail/farmhash.h>
 
 // namespace NAMESPACE_FOR_HASH_FUNCTIONS {
@@ -123,4 +124,82 @@ uint128_t Fingerprint128(const char* s, size_t len) {
 //   farmhashns::Hash32{,WithSeed}()
 
 // }  // namespace NAMESPACE_FOR_HASH_FUNCTIONS
-} /*end namespace farmhash*/ OIIO_NAMESPACE_END
+} /*end namespace farmhash*/
+
+
+
+// FastHash128 hashes each whole chunk, seeded with the hash of the ones
+// before it, and at the end, the rest (perhaps nothing) seeded also with
+// the total length. It uses CityHash128WithSeed directly rather than
+// farmhash::Hash128WithSeed, whose results may change with the build.
+
+static const size_t fasthash128_chunksize = 64 * 1024;
+
+static inline void
+fasthash128_chunk(uint64_t state[2], const char* data, size_t size,
+                  uint64_t length = 0)
+{
+    farmhash::uint128_t h = farmhash::farmhashcc::CityHash128WithSeed(
+        data, size, farmhash::Uint128(state[0] ^ length, state[1]));
+    state[0] = farmhash::Uint128Low64(h);
+    state[1] = farmhash::Uint128High64(h);
+}
+
+
+FastHash128::FastHash128(const void* data, size_t size)
+{
+    m_state[0] = 0x9ae16a3b2f90404fULL;
+    m_state[1] = 0xc3a5c85c97cb3127ULL;
+    append(data, size);
+}
+
+
+FastHash128::~FastHash128() {}
+
+
+void
+FastHash128::append(const void* data, size_t size)
+{
+    const char* p = (const char*)data;
+    m_length += size;
+    if (m_buffered) {
+        size_t n = std::min(size, fasthash128_chunksize - m_buffered);
+        memcpy(m_buffer.get() + m_buffered, p, n);
+        m_buffered += n;
+        p += n;
+        size -= n;
+        if (m_buffered < fasthash128_chunksize)
+            return;
+        fasthash128_chunk(m_state, m_buffer.get(), fasthash128_chunksize);
+        m_buffered = 0;
+    }
+    // Whole chunks are hashed where they are, without copying them
+    for (; size >= fasthash128_chunksize; p += fasthash128_chunksize,
+                                          size -= fasthash128_chunksize)
+        fasthash128_chunk(m_state, p, fasthash128_chunksize);
+    if (size) {
+        if (!m_buffer)
+            m_buffer.reset(new char[fasthash128_chunksize]);
+        memcpy(m_buffer.get(), p, size);
+        m_buffered = size;
+    }
+}
+
+
+FastHash128::Hash
+FastHash128::gethash() const
+{
+    uint64_t state[2] = { m_state[0], m_state[1] };
+    fasthash128_chunk(state, m_buffer.get(), m_buffered, m_length);
+    return { state[0], state[1] };
+}
+
+
+std::string
+FastHash128::digest() const
+{
+    Hash h = gethash();
+    return Strutil::fmt::format("{:016x}{:016x}", h.hi, h.lo);
+}
+
+OIIO_NAMESPACE_END
@@ -3,21 +3,31 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <fcntl.h>
 #include <filesystem>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <regex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/platform.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/thread.h>
 #include <OpenImageIO/ustring.h>
 
 #ifdef _WIN32
@@ -29,12 +39,25 @@
 #    include <sys/types.h>
 #    include <sys/utime.h>
 #else
+#    include <sys/mman.h>
 #    include <sys/stat.h>
 #    include <sys/types.h>
+#    include <sys/uio.h>
 #    include <unistd.h>
 #    include <utime.h>
 #endif
 
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#    include <linux/io_uring.h>
+#    include <sys/syscall.h>
+#    if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#        define OIIO_HAS_IO_URING 1
+#    endif
+#endif
+#ifndef OIIO_HAS_IO_URING
+#    define OIIO_HAS_IO_URING 0
+#endif
+
 namespace filesystem = std::filesystem;
 using std::error_code;
 
@@ -264,6 +287,64 @@ Filesystem::find_program(string_view program)
 
 
 
+namespace {
+
+// Append the entries of directory dirpath that pass the filter to files,
+// each followed (if recursive) by those of the subdirectory it names, in
+// the same order as recursive_directory_iterator would give them. The
+// subdirectories are listed in parallel on the I/O thread pool, which
+// matters when each readdir is a round trip to a file server.
+void
+list_directory_entries(const filesystem::path& dirpath, bool recursive,
+                       const std::regex* filter,
+                       std::vector<std::string>& files)
+{
+    std::vector<filesystem::path> subdirs;
+    std::vector<size_t> subdir_pos;  // Where each one's entries go in files
+    error_code ec;
+    for (filesystem::directory_iterator s(dirpath, ec), end;
+         !ec && s != end; s.increment(ec)) {
+        std::string file = pathstr(s->path());
+        if (!filter || std::regex_search(file, *filter))
+            files.push_back(std::move(file));
+        error_code typeec;
+        if (recursive && s->is_directory(typeec) && !s->is_symlink(typeec)) {
+            subdirs.push_back(s->path());
+            subdir_pos.push_back(files.size());
+        }
+    }
+    if (subdirs.empty())
+        return;
+
+    std::vector<std::vector<std::string>> subfiles(subdirs.size());
+    thread_pool* pool = io_thread_pool();
+    task_set tasks(pool);
+    for (size_t i = 0; i < subdirs.size(); ++i)
+        tasks.push(pool->push([&, i](int) {
+            list_directory_entries(subdirs[i], true, filter, subfiles[i]);
+        }));
+    tasks.wait();
+
+    std::vector<std::string> all;
+    size_t total = files.size();
+    for (auto& sub : subfiles)
+        total += sub.size();
+    all.reserve(total);
+    for (size_t i = 0, f = 0; i <= subdirs.size(); ++i) {
+        size_t pos = i < subdirs.size() ? subdir_pos[i] : files.size();
+        for (; f < pos; ++f)
+            all.push_back(std::move(files[f]));
+        if (i < subdirs.size())
+            for (auto& file : subfiles[i])
+                all.push_back(std::move(file));
+    }
+    files.swap(all);
+}
+
+}  // namespace
+
+
+
 bool
 Filesystem::get_directory_entries(const std::string& dirname,
                                   std::vector<std::string>& filenames,
@@ -275,26 +356,11 @@ Filesystem::get_directory_entries(const std::string& dirname,
         return false;
     filesystem::path dirpath(dirname.size() ? u8path(dirname)
                                             : filesystem::path("."));
-    std::regex re;
     try {
-        re = std::regex(filter_regex);
-        if (recursive) {
-            error_code ec;
-            for (filesystem::recursive_directory_iterator s(dirpath, ec), end;
-                 !ec && s != end; s.increment(ec)) {
-                std::string file = pathstr(s->path());
-                if (!filter_regex.size() || std::regex_search(file, re))
-                    filenames.push_back(file);
-            }
-        } else {
-            error_code ec;
-            for (filesystem::directory_iterator s(dirpath, ec), end;
-                 !ec && s != end; s.increment(ec)) {
-                std::string file = pathstr(s->path());
-                if (!filter_regex.size() || std::regex_search(file, re))
-                    filenames.push_back(file);
-            }
-        }
+        std::regex re(filter_regex);
+        list_directory_entries(dirpath, recursive,
+                               filter_regex.size() ? &re : nullptr,
+                               filenames);
     } catch (...) {
         return false;
     }
@@ -946,6 +1012,119 @@ Filesystem::enumerate_file_sequence(const std::string& pattern,
 
 
 
+namespace {
+
+// The name and type (not following symlinks) of a directory entry, as the
+// directory listing itself gives them, without a stat of each entry.
+struct DirEntry {
+    std::string name;
+    filesystem::file_type type;
+};
+
+typedef std::shared_ptr<const std::vector<DirEntry>> DirListing;
+
+struct DirListingCache {
+    std::mutex mutex;
+    std::atomic<bool> enabled { false };
+    struct Listing {
+        filesystem::file_time_type mtime;
+        DirListing entries;
+    };
+    std::unordered_map<std::string, Listing> listings;
+};
+
+DirListingCache&
+dir_listing_cache()
+{
+    static DirListingCache cache;
+    return cache;
+}
+
+
+
+// Return the entries of the directory, or nullptr if it can't be read.
+DirListing
+list_directory(const std::string& directory)
+{
+    filesystem::path dirpath(u8path(directory));
+    error_code ec;
+    DirListingCache& cache(dir_listing_cache());
+    filesystem::file_time_type mtime;
+    if (cache.enabled) {
+        mtime = filesystem::last_write_time(dirpath, ec);
+        if (ec)
+            return nullptr;
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto found = cache.listings.find(directory);
+        if (found != cache.listings.end() && found->second.mtime == mtime)
+            return found->second.entries;
+    }
+
+    auto entries = std::make_shared<std::vector<DirEntry>>();
+    filesystem::directory_iterator it(dirpath, ec), end_it;
+    if (ec)
+        return nullptr;
+    for (; !ec && it != end_it; it.increment(ec)) {
+        error_code typeec;
+        entries->push_back({ pathstr(it->path().filename()),
+                             it->symlink_status(typeec).type() });
+    }
+
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.enabled && mtime != filesystem::file_time_type())
+        cache.listings[directory] = { mtime, entries };
+    return entries;
+}
+
+
+
+// Append to matches the frame number and filename of each regular file of
+// the directory whose name is prefix, at least `padding` digits, and
+// suffix.
+void
+match_frames(const std::string& directory, const DirEntry* begin,
+             const DirEntry* end, string_view prefix, string_view suffix,
+             size_t padding,
+             std::vector<std::pair<int, std::string>>& matches)
+{
+    for (const DirEntry* e = begin; e != end; ++e) {
+        string_view name(e->name);
+        if (name.size() < prefix.size() + padding + suffix.size()
+            || !Strutil::starts_with(name, prefix)
+            || !Strutil::ends_with(name, suffix))
+            continue;
+        string_view digits = name.substr(prefix.size(), name.size()
+                                                            - prefix.size()
+                                                            - suffix.size());
+        if (std::find_if(digits.begin(), digits.end(),
+                         [](char c) { return c < '0' || c > '9'; })
+            != digits.end())
+            continue;
+        std::string f = Filesystem::generic_filepath(
+            pathstr(u8path(directory) / u8path(e->name)));
+        error_code ec;
+        if (e->type == filesystem::file_type::regular
+            || (e->type == filesystem::file_type::symlink
+                && filesystem::is_regular_file(u8path(f), ec)))
+            matches.emplace_back(Strutil::stoi(digits), std::move(f));
+    }
+}
+
+}  // namespace
+
+
+
+void
+Filesystem::cache_directory_listings(bool enable)
+{
+    DirListingCache& cache(dir_listing_cache());
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.enabled = enable;
+    cache.listings.clear();
+}
+
+
+
 bool
 Filesystem::scan_for_matching_filenames(const std::string& pattern,
                                         const std::vector<string_view>& views,
@@ -1025,67 +1204,54 @@ Filesystem::scan_for_matching_filenames(const std::string& pattern,
 
 
 bool
-Filesystem::scan_for_matching_filenames(const std::string& pattern_,
+Filesystem::scan_for_matching_filenames(const std::string& pattern,
                                         std::vector<int>& numbers,
                                         std::vector<std::string>& filenames)
 {
     numbers.clear();
     filenames.clear();
-    std::string pattern = pattern_;
     // Isolate the directory name (or '.' if none was specified)
     std::string directory = Filesystem::parent_path(pattern);
-    if (directory.size() == 0) {
+    if (directory.size() == 0)
         directory = ".";
-        pattern   = "./" + pattern;
-    }
-
-    if (!exists(directory))
-        return false;
 
-    // build a regex that matches the pattern
+    // Split the file name part of the pattern around the frame number
     static std::regex format_re("%0([0-9]+)d");
+    std::string filepattern = Filesystem::filename(pattern);
     std::match_results<std::string::const_iterator> format_match;
-    if (!std::regex_search(pattern, format_match, format_re))
+    if (!std::regex_search(filepattern, format_match, format_re))
         return false;
-
-    std::string thepadding(format_match[1].first, format_match[1].second);
+    size_t padding = size_t(std::max(0, Strutil::stoi(format_match.str(1))));
     std::string prefix(format_match.prefix().first,
                        format_match.prefix().second);
     std::string suffix(format_match.suffix().first,
                        format_match.suffix().second);
 
-    // N.B. make sure that the prefix and suffix are regex-safe by
-    // backslashing anything that might be in a literal filename that will
-    // be problematic in a regex.
-    std::string pattern_re_str = Filesystem::filename_to_regex(prefix, false)
-                                 + "([0-9]{" + thepadding + ",})"
-                                 + Filesystem::filename_to_regex(suffix, false);
-    std::vector<std::pair<int, std::string>> matches;
-
-    // There are some corner cases regex that could be constructed here that
-    // are badly structured and might throw an exception.
-    try {
-        std::regex pattern_re(pattern_re_str);
-        error_code ec;
-        for (filesystem::directory_iterator it(u8path(directory), ec), end_it;
-             !ec && it != end_it; ++it) {
-            std::string itpath = Filesystem::generic_filepath(
-                it->path().string());
-            if (filesystem::is_regular_file(itpath, ec)) {
-                const std::string f = pathstr(itpath);
-                std::match_results<std::string::const_iterator> frame_match;
-                if (regex_match(f, frame_match, pattern_re)) {
-                    std::string thenumber(frame_match[1].first,
-                                          frame_match[1].second);
-                    int frame = Strutil::stoi(thenumber);
-                    matches.push_back(std::make_pair(frame, f));
-                }
-            }
-        }
-
-    } catch (...) {
-        // Botched regex. Just fail.
+    DirListing entries = list_directory(directory);
+    if (!entries)
         return false;
+
+    // Over a file server, each stat is a round trip, so the file names are
+    // matched with no more than the listing itself, and the large listings
+    // that sequences make are matched in parallel.
+    std::vector<std::pair<int, std::string>> matches;
+    const DirEntry* first = entries->data();
+    size_t n              = entries->size();
+    if (n < 4096) {
+        match_frames(directory, first, first + n, prefix, suffix, padding,
+                     matches);
+    } else {
+        size_t nchunks = std::min(size_t(64), n / 1024);
+        std::vector<std::vector<std::pair<int, std::string>>> chunk_matches(
+            nchunks);
+        parallel_for(int64_t(0), int64_t(nchunks), [&](int64_t c) {
+            match_frames(directory, first + n * c / nchunks,
+                         first + n * (c + 1) / nchunks, prefix, suffix,
+                         padding, chunk_matches[c]);
+        });
+        for (auto& cm : chunk_matches)
+            for (auto& m : cm)
+                matches.push_back(std::move(m));
     }
 
     // filesystem order is undefined, so return sorted sequences
@@ -1154,6 +1320,243 @@ Filesystem::IOProxy::pwrite(const void* /*buf*/, size_t /*size*/,
 }
 
 
+bool
+Filesystem::IOProxy::pread_many(span<ReadRequest> requests)
+{
+    bool ok          = true;
+    int64_t filesize = int64_t(size());
+    for (auto& r : requests) {
+        r.nread = pread(r.buf, r.size, r.offset);
+        ok &= r.complete(filesize);
+    }
+    return ok;
+}
+
+
+
+#if OIIO_HAS_IO_URING
+namespace {
+
+// A minimal io_uring, used only to do batches of reads. Each thread has
+// its own (see uring_for_thread()), so no locking is needed.
+class ReadRing {
+public:
+    ReadRing(unsigned entries)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        m_fd = int(syscall(__NR_io_uring_setup, entries, &params));
+        if (m_fd < 0)
+            return;
+        m_entries      = params.sq_entries;
+        m_sq_ring_size = params.sq_off.array
+                         + params.sq_entries * sizeof(unsigned);
+        m_cq_ring_size = params.cq_off.cqes
+                         + params.cq_entries * sizeof(io_uring_cqe);
+        m_sqes_size    = params.sq_entries * sizeof(io_uring_sqe);
+        m_sq_ring = mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+        m_cq_ring = mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+        void* sqes = mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+        m_sqes = sqes == MAP_FAILED ? nullptr : (io_uring_sqe*)sqes;
+        if (m_sq_ring == MAP_FAILED || m_cq_ring == MAP_FAILED || !m_sqes) {
+            teardown();
+            return;
+        }
+        char* sq   = (char*)m_sq_ring;
+        char* cq   = (char*)m_cq_ring;
+        m_sq_tail  = (unsigned*)(sq + params.sq_off.tail);
+        m_sq_mask  = *(unsigned*)(sq + params.sq_off.ring_mask);
+        m_sq_array = (unsigned*)(sq + params.sq_off.array);
+        m_cq_head  = (unsigned*)(cq + params.cq_off.head);
+        m_cq_tail  = (unsigned*)(cq + params.cq_off.tail);
+        m_cq_mask  = *(unsigned*)(cq + params.cq_off.ring_mask);
+        m_cqes     = (io_uring_cqe*)(cq + params.cq_off.cqes);
+    }
+
+    ~ReadRing() { teardown(); }
+
+    bool valid() const { return m_sqes != nullptr; }
+
+    // Read the requests from fd, keeping as many in flight as the ring
+    // holds. Requests that fail or come up short are left for the caller
+    // to retry. Return false if the ring itself failed, in which case it
+    // must not be used again.
+    bool read(int fd, span<Filesystem::IOProxy::ReadRequest> requests)
+    {
+        std::vector<iovec> iov(requests.size());
+        size_t next = 0, inflight = 0, unsubmitted = 0;
+        while (next < requests.size() || inflight) {
+            unsigned tail = *m_sq_tail;
+            for (; next < requests.size() && inflight < m_entries; ++next) {
+                auto& r = requests[next];
+                if (!r.size || r.offset < 0)
+                    continue;
+                // Longer reads are finished by the caller.
+                iov[next].iov_base = r.buf;
+                iov[next].iov_len  = std::min(r.size, size_t(1) << 30);
+                unsigned idx       = tail & m_sq_mask;
+                io_uring_sqe& sqe(m_sqes[idx]);
+                memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode      = IORING_OP_READV;
+                sqe.fd          = fd;
+                sqe.off         = uint64_t(r.offset);
+                sqe.addr        = uint64_t(uintptr_t(&iov[next]));
+                sqe.len         = 1;
+                sqe.user_data   = next;
+                m_sq_array[idx] = idx;
+                ++tail;
+                ++inflight;
+                ++unsubmitted;
+            }
+            __atomic_store_n(m_sq_tail, tail, __ATOMIC_RELEASE);
+            if (!inflight)
+                break;
+            int n = int(syscall(__NR_io_uring_enter, m_fd, unsubmitted, 1,
+                                IORING_ENTER_GETEVENTS, nullptr, 0));
+            if (n < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                    continue;
+                // Not expected with valid arguments; give up on the ring.
+                teardown();
+                return false;
+            }
+            unsubmitted -= std::min(unsubmitted, size_t(n));
+            unsigned head = *m_cq_head;
+            while (head != __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE)) {
+                const io_uring_cqe& cqe(m_cqes[head & m_cq_mask]);
+                if (cqe.res > 0)
+                    requests[size_t(cqe.user_data)].nread = size_t(cqe.res);
+                ++head;
+                --inflight;
+            }
+            __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+        }
+        return true;
+    }
+
+private:
+    void teardown()
+    {
+        if (m_sqes)
+            munmap(m_sqes, m_sqes_size);
+        if (m_sq_ring && m_sq_ring != MAP_FAILED)
+            munmap(m_sq_ring, m_sq_ring_size);
+        if (m_cq_ring && m_cq_ring != MAP_FAILED)
+            munmap(m_cq_ring, m_cq_ring_size);
+        if (m_fd >= 0)
+            ::close(m_fd);
+        m_sqes    = nullptr;
+        m_sq_ring = m_cq_ring = nullptr;
+        m_fd                  = -1;
+    }
+
+    int m_fd              = -1;
+    unsigned m_entries    = 0;
+    void* m_sq_ring       = nullptr;
+    void* m_cq_ring       = nullptr;
+    size_t m_sq_ring_size = 0;
+    size_t m_cq_ring_size = 0;
+    size_t m_sqes_size    = 0;
+    io_uring_sqe* m_sqes  = nullptr;
+    unsigned* m_sq_tail   = nullptr;
+    unsigned* m_sq_array  = nullptr;
+    unsigned m_sq_mask    = 0;
+    unsigned* m_cq_head   = nullptr;
+    unsigned* m_cq_tail   = nullptr;
+    unsigned m_cq_mask    = 0;
+    io_uring_cqe* m_cqes  = nullptr;
+};
+
+
+// Set once io_uring has been found not to work (an old kernel, or one
+// that doesn't allow it), so that we stop trying.
+static std::atomic<bool> uring_unavailable(false);
+
+
+// This thread's ring, or nullptr if there is none.
+static ReadRing*
+uring_for_thread()
+{
+    thread_local std::unique_ptr<ReadRing> ring;
+    if (!ring && !uring_unavailable) {
+        ring.reset(new ReadRing(64));
+        if (!ring->valid())
+            uring_unavailable = true;
+    }
+    return ring && ring->valid() ? ring.get() : nullptr;
+}
+
+}  // namespace
+#endif
+
+
+
+bool
+Filesystem::IOFile::pread_many(span<ReadRequest> requests)
+{
+    if (!m_file || m_mode == Closed)
+        return false;
+    for (auto& r : requests)
+        r.nread = 0;
+    if (requests.size() > 1) {
+#if OIIO_HAS_IO_URING
+        if (ReadRing* ring = uring_for_thread())
+            ring->read(fileno(m_file), requests);
+#elif defined(_WIN32)
+        // Reopen the file for overlapped I/O, and issue up to a few dozen
+        // reads at a time.
+        HANDLE h = ReOpenFile((HANDLE)_get_osfhandle(_fileno(m_file)),
+                              GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE
+                                  | FILE_SHARE_DELETE,
+                              FILE_FLAG_OVERLAPPED);
+        if (h != INVALID_HANDLE_VALUE) {
+            const size_t maxinflight = 64;
+            std::vector<OVERLAPPED> ov(std::min(requests.size(), maxinflight));
+            std::vector<bool> issued(ov.size());
+            for (size_t first = 0; first < requests.size();
+                 first += ov.size()) {
+                size_t n = std::min(ov.size(), requests.size() - first);
+                for (size_t i = 0; i < n; ++i) {
+                    auto& r = requests[first + i];
+                    memset(&ov[i], 0, sizeof(OVERLAPPED));
+                    ov[i].Offset     = DWORD(uint64_t(r.offset));
+                    ov[i].OffsetHigh = DWORD(uint64_t(r.offset) >> 32);
+                    ov[i].hEvent     = CreateEventW(nullptr, TRUE, FALSE,
+                                                    nullptr);
+                    DWORD len = DWORD(std::min(r.size, size_t(1) << 30));
+                    issued[i] = ov[i].hEvent && r.offset >= 0
+                                && (ReadFile(h, r.buf, len, nullptr, &ov[i])
+                                    || GetLastError() == ERROR_IO_PENDING);
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    DWORD got = 0;
+                    if (issued[i] && GetOverlappedResult(h, &ov[i], &got, TRUE))
+                        requests[first + i].nread = size_t(got);
+                    if (ov[i].hEvent)
+                        CloseHandle(ov[i].hEvent);
+                }
+            }
+            CloseHandle(h);
+        }
+#endif
+    }
+    // Whatever wasn't read in full (all of it, if there was no way to
+    // batch the reads) is finished with pread().
+    bool ok = true;
+    for (auto& r : requests) {
+        if (r.nread < r.size)
+            r.nread += pread((char*)r.buf + r.nread, r.size - r.nread,
+                             r.offset + int64_t(r.nread));
+        ok &= r.complete(int64_t(m_size));
+    }
+    return ok;
+}
+
+
 
 // Shared mutex to guard IOProxy error get/set. Shared should be ok. If
 // enough file I/O errors are happening that multiple threads are
@@ -1394,4 +1797,487 @@ Filesystem::IOMemReader::pread(void* buf, size_t size, int64_t offset)
 }
 
 
+
+// How far ahead of the current position IOMMap::read() asks for the file
+// to be read in advance.
+static const int64_t mmap_readahead = 4 << 20;
+
+
+Filesystem::IOMMap::IOMMap(string_view filename)
+    : IOMemReader(nullptr, 0)
+{
+    m_filename  = filename;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = CreateFileW(Strutil::utf8_to_utf16wstring(filename).c_str(),
+                              GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error(Strutil::fmt::format("Could not open \"{}\"", filename));
+        m_mode = Closed;
+        return;
+    }
+    LARGE_INTEGER filesize;
+    if (GetFileSizeEx(file, &filesize) && filesize.QuadPart > 0) {
+        size      = size_t(filesize.QuadPart);
+        m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0,
+                                       nullptr);
+        if (m_mapping)
+            m_map = MapViewOfFile((HANDLE)m_mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    // The view keeps the file open after its handle is closed.
+    CloseHandle(file);
+#else
+    int fd = ::open(m_filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error(Strutil::fmt::format("Could not open \"{}\": {}", filename,
+                                   std::strerror(errno)));
+        m_mode = Closed;
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        size       = size_t(st.st_size);
+        void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (base != MAP_FAILED) {
+            m_map = base;
+            posix_madvise(m_map, size, POSIX_MADV_SEQUENTIAL);
+        }
+    }
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+#endif
+    if (size && !m_map) {
+        error(Strutil::fmt::format("Could not map \"{}\"", filename));
+        m_mode = Closed;
+        return;
+    }
+    // N.B. An empty file is opened, with nothing to read.
+    m_buf = cspan<unsigned char>((const unsigned char*)m_map, size);
+}
+
+
+
+Filesystem::IOMMap::~IOMMap() { close(); }
+
+
+
+void
+Filesystem::IOMMap::close()
+{
+    if (m_map) {
+#ifdef _WIN32
+        UnmapViewOfFile(m_map);
+#else
+        munmap(m_map, m_buf.size());
+#endif
+        m_map = nullptr;
+    }
+#ifdef _WIN32
+    if (m_mapping) {
+        CloseHandle((HANDLE)m_mapping);
+        m_mapping = nullptr;
+    }
+#endif
+    m_buf  = {};
+    m_mode = Closed;
+}
+
+
+
+size_t
+Filesystem::IOMMap::read(void* buf, size_t size)
+{
+#ifndef _WIN32
+    // Ask for the next stretch of the file to be paged in before we get to
+    // it, whenever reading comes within half of the readahead distance of
+    // the end of what was already asked for.
+    int64_t end = std::min(m_pos + int64_t(size), int64_t(m_buf.size()));
+    if (m_map && m_pos >= 0 && m_pos < int64_t(m_buf.size())
+        && end + mmap_readahead / 2 > m_readahead_end
+        && m_readahead_end < int64_t(m_buf.size())) {
+        static const int64_t pagesize = int64_t(sysconf(_SC_PAGESIZE));
+
+        int64_t begin   = std::max(m_readahead_end, m_pos) & ~(pagesize - 1);
+        m_readahead_end = std::min(end + mmap_readahead,
+                                   int64_t(m_buf.size()));
+        posix_madvise((char*)m_map + begin, size_t(m_readahead_end - begin),
+                      POSIX_MADV_WILLNEED);
+    }
+#endif
+    return IOMemReader::read(buf, size);
+}
+
+
+
+// The state of an IOReadAhead, shared with the prefetches it has handed to
+// the thread pool.
+struct Filesystem::IOReadAhead::Impl {
+    using Block = std::shared_ptr<const std::vector<char>>;
+    struct Cached {
+        Block data;
+        uint64_t lastuse;  // Value of `clock` when last used
+    };
+
+    IOProxy* src = nullptr;
+    std::unique_ptr<IOProxy> owned;
+    size_t blocksize = 0;
+    size_t maxblocks = 0;
+    int prefetch     = 0;
+    int64_t filesize = 0;
+    std::atomic<int64_t> nreads { 0 };
+
+    std::mutex mutex;  // Guards all that follows
+    std::condition_variable cv;
+    std::unordered_map<int64_t, Cached> blocks;
+    // Blocks waiting to be prefetched, and whether the prefetch has begun
+    // reading them. Until it has, a reader may take one over.
+    std::unordered_map<int64_t, bool> pending;
+    int inflight     = 0;  // Prefetch tasks not yet done
+    uint64_t clock   = 0;
+    int64_t last_end = 0;  // End of the last read, to detect sequential ones
+
+    size_t block_bytes(int64_t b) const
+    {
+        return size_t(std::min(int64_t(blocksize),
+                               filesize - b * int64_t(blocksize)));
+    }
+
+    // Read blocks [first,first+n) from the source, all with one read, and
+    // return those (from the first on) that were read in full.
+    std::vector<Block> fetch(int64_t first, int64_t n)
+    {
+        size_t total = 0;
+        for (int64_t b = first; b < first + n; ++b)
+            total += block_bytes(b);
+        std::vector<char> run(total);
+        ++nreads;
+        size_t got = src->pread(run.data(), total,
+                                first * int64_t(blocksize));
+        std::vector<Block> result;
+        if (n == 1 && got == total) {
+            result.emplace_back(
+                std::make_shared<const std::vector<char>>(std::move(run)));
+            return result;
+        }
+        size_t pos = 0;
+        for (int64_t b = first; b < first + n; ++b) {
+            size_t len = block_bytes(b);
+            if (pos + len > got)
+                break;
+            result.emplace_back(std::make_shared<const std::vector<char>>(
+                run.begin() + pos, run.begin() + pos + len));
+            pos += len;
+        }
+        return result;
+    }
+
+    // Add fetched blocks to the cache, evicting the least recently used
+    // ones beyond maxblocks. The mutex must be locked.
+    void insert(int64_t first, const std::vector<Block>& got)
+    {
+        for (size_t i = 0; i < got.size(); ++i)
+            blocks[first + int64_t(i)] = { got[i], ++clock };
+        while (blocks.size() > maxblocks) {
+            auto lru = blocks.begin();
+            for (auto c = blocks.begin(); c != blocks.end(); ++c)
+                if (c->second.lastuse < lru->second.lastuse)
+                    lru = c;
+            blocks.erase(lru);
+        }
+    }
+
+    // The task for the thread pool: read whichever of blocks
+    // [first,first+n) are still waiting for it.
+    void prefetch_blocks(int64_t first, int64_t n)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::vector<std::pair<int64_t, int64_t>> runs;
+        for (int64_t b = first; b < first + n; ++b) {
+            auto p = pending.find(b);
+            if (p == pending.end() || p->second)
+                continue;
+            p->second = true;
+            if (runs.size() && runs.back().first + runs.back().second == b)
+                ++runs.back().second;
+            else
+                runs.emplace_back(b, 1);
+        }
+        for (auto& r : runs) {
+            lock.unlock();
+            std::vector<Block> got = fetch(r.first, r.second);
+            lock.lock();
+            insert(r.first, got);
+            for (int64_t b = r.first; b < r.first + r.second; ++b)
+                pending.erase(b);
+        }
+        --inflight;
+        cv.notify_all();
+    }
+
+    // Wait for all prefetches to finish, helping the I/O pool with its
+    // work meanwhile, in case the prefetches are queued behind the caller.
+    void wait_for_prefetches()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (inflight) {
+            lock.unlock();
+            bool ran = io_thread_pool()->run_one_task(
+                std::this_thread::get_id());
+            lock.lock();
+            if (!ran && inflight)
+                cv.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+};
+
+
+
+Filesystem::IOReadAhead::IOReadAhead(IOProxy* src, size_t blocksize,
+                                     int maxblocks, int prefetch)
+    : IOProxy(src ? string_view(src->filename()) : string_view(), Read)
+    , m_impl(new Impl)
+{
+    m_impl->src       = src;
+    m_impl->blocksize = std::max(blocksize, size_t(1));
+    m_impl->maxblocks = size_t(std::max(maxblocks, 1));
+    m_impl->prefetch  = std::max(prefetch, 0);
+    if (!src || !src->opened() || src->mode() != Read) {
+        m_mode = Closed;
+        error("IOReadAhead needs a proxy opened for reading");
+        return;
+    }
+    m_impl->filesize = int64_t(src->size());
+}
+
+
+
+Filesystem::IOReadAhead::IOReadAhead(std::unique_ptr<IOProxy> src,
+                                     size_t blocksize, int maxblocks,
+                                     int prefetch)
+    : IOReadAhead(src.get(), blocksize, maxblocks, prefetch)
+{
+    m_impl->owned = std::move(src);
+}
+
+
+
+Filesystem::IOReadAhead::~IOReadAhead() { close(); }
+
+
+
+void
+Filesystem::IOReadAhead::close()
+{
+    // Prefetches in flight use the source, so must finish first.
+    m_impl->wait_for_prefetches();
+    std::lock_guard<std::mutex> lock(m_impl->mutex);
+    m_impl->blocks.clear();
+    m_impl->pending.clear();
+    if (m_impl->owned) {
+        m_impl->owned.reset();
+        m_impl->src = nullptr;
+    }
+    m_mode = Closed;
+}
+
+
+
+size_t
+Filesystem::IOReadAhead::read(void* buf, size_t size)
+{
+    size_t n = pread(buf, size, m_pos);
+    m_pos += int64_t(n);
+    return n;
+}
+
+
+
+size_t
+Filesystem::IOReadAhead::pread(void* buf, size_t size, int64_t offset)
+{
+    Impl& impl(*m_impl);
+    if (!opened() || offset < 0 || offset >= impl.filesize || !size)
+        return 0;
+    size = size_t(std::min(int64_t(size), impl.filesize - offset));
+    if (size > impl.blocksize * impl.maxblocks / 2) {
+        // Too big to cache without evicting everything else
+        ++impl.nreads;
+        return impl.src->pread(buf, size, offset);
+    }
+    const int64_t bs = int64_t(impl.blocksize);
+    int64_t b0       = offset / bs;
+    int64_t b1       = (offset + int64_t(size) - 1) / bs;
+    std::vector<Impl::Block> data(size_t(b1 - b0 + 1));
+    bool failed = false;
+    std::unique_lock<std::mutex> lock(impl.mutex);
+    bool sequential = (offset == impl.last_end);
+    impl.last_end   = offset + int64_t(size);
+    for (;;) {
+        // Take the blocks that are cached, and read the missing ones,
+        // except for those that a prefetch is already reading.
+        std::vector<std::pair<int64_t, int64_t>> runs;
+        bool wait = false;
+        for (int64_t b = b0; b <= b1; ++b) {
+            if (data[b - b0])
+                continue;
+            auto c = impl.blocks.find(b);
+            if (c != impl.blocks.end()) {
+                c->second.lastuse = ++impl.clock;
+                data[b - b0]      = c->second.data;
+                continue;
+            }
+            auto p = impl.pending.find(b);
+            if (p != impl.pending.end() && p->second) {
+                wait = true;
+                continue;
+            }
+            if (p != impl.pending.end())
+                impl.pending.erase(p);
+            if (runs.size() && runs.back().first + runs.back().second == b)
+                ++runs.back().second;
+            else
+                runs.emplace_back(b, 1);
+        }
+        for (auto& r : runs) {
+            lock.unlock();
+            std::vector<Impl::Block> got = impl.fetch(r.first, r.second);
+            lock.lock();
+            impl.insert(r.first, got);
+            for (size_t i = 0; i < got.size(); ++i)
+                data[r.first + int64_t(i) - b0] = got[i];
+            failed |= (int64_t(got.size()) < r.second);
+        }
+        if (failed || !wait)
+            break;
+        impl.cv.wait(lock);
+    }
+
+    // While reading sequentially, have the blocks that come next read in
+    // the background.
+    const int64_t nblocks = (impl.filesize + bs - 1) / bs;
+    int64_t first = b1 + 1, n = 0;
+    for (int64_t b = first; sequential && !failed && b <= b1 + impl.prefetch
+                            && b < nblocks;
+         ++b) {
+        if (impl.blocks.count(b) || impl.pending.count(b)) {
+            if (n)
+                break;
+            first = b + 1;
+            continue;
+        }
+        impl.pending[b] = false;
+        ++n;
+    }
+    if (n)
+        ++impl.inflight;
+    lock.unlock();
+    // The reader will want these soon, so they go ahead of other I/O.
+    if (n) {
+        std::shared_ptr<Impl> self(m_impl);
+        io_thread_pool()->push(thread_pool::Priority::High,
+                               [self, first, n](int /*id*/) {
+                                   self->prefetch_blocks(first, n);
+                               });
+    }
+
+    size_t nread = 0;
+    for (int64_t b = b0; b <= b1 && data[b - b0]; ++b) {
+        const std::vector<char>& d(*data[b - b0]);
+        size_t start = size_t(std::max(offset, b * bs) - b * bs);
+        size_t len   = std::min(d.size() - start, size - nread);
+        memcpy((char*)buf + nread, d.data() + start, len);
+        nread += len;
+    }
+    if (nread < size) {
+        std::string e = impl.src->error();
+        error(e.size() ? e : std::string("IOReadAhead: read failed"));
+    }
+    return nread;
+}
+
+
+
+bool
+Filesystem::IOReadAhead::pread_many(span<ReadRequest> requests)
+{
+    Impl& impl(*m_impl);
+    if (!opened())
+        return false;
+    // Copy what's cached, and leave the rest to the source, which may be
+    // able to read them all at once.
+    const int64_t bs = int64_t(impl.blocksize);
+    std::vector<ReadRequest> uncached;
+    std::vector<size_t> which;
+    {
+        std::lock_guard<std::mutex> lock(impl.mutex);
+        for (size_t i = 0; i < requests.size(); ++i) {
+            ReadRequest& r(requests[i]);
+            r.nread = 0;
+            if (r.offset < 0 || r.offset >= impl.filesize || !r.size)
+                continue;
+            size_t size = size_t(
+                std::min(int64_t(r.size), impl.filesize - r.offset));
+            int64_t b0  = r.offset / bs;
+            int64_t b1  = (r.offset + int64_t(size) - 1) / bs;
+            bool cached = true;
+            for (int64_t b = b0; b <= b1 && cached; ++b)
+                cached = impl.blocks.count(b) != 0;
+            if (!cached) {
+                uncached.push_back(r);
+                which.push_back(i);
+                continue;
+            }
+            for (int64_t b = b0; b <= b1; ++b) {
+                Impl::Cached& c(impl.blocks[b]);
+                c.lastuse    = ++impl.clock;
+                size_t start = size_t(std::max(r.offset, b * bs) - b * bs);
+                size_t len   = std::min(c.data->size() - start,
+                                        size - r.nread);
+                memcpy((char*)r.buf + r.nread, c.data->data() + start, len);
+                r.nread += len;
+            }
+        }
+    }
+    if (uncached.size()) {
+        impl.nreads += int64_t(uncached.size());
+        impl.src->pread_many(uncached);
+        for (size_t i = 0; i < uncached.size(); ++i)
+            requests[which[i]].nread = uncached[i].nread;
+    }
+    // As pread() does, a read running past the end is complete once it
+    // has all that's there.
+    bool ok = true;
+    for (auto& r : requests)
+        ok &= r.complete(impl.filesize);
+    return ok;
+}
+
+
+
+size_t
+Filesystem::IOReadAhead::size() const
+{
+    return size_t(m_impl->filesize);
+}
+
+
+
+Filesystem::IOProxy*
+Filesystem::IOReadAhead::source() const
+{
+    return m_impl->src;
+}
+
+
+
+int64_t
+Filesystem::IOReadAhead::source_reads() const
+{
+    return m_impl->nreads;
+}
+
+
+
 OIIO_NAMESPACE_END
@@ -2,11 +2,14 @@
 // SPDX-License-Identifier: Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <sstream>
 
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/platform.h>
 #include <OpenImageIO/unittest.h>
 
@@ -566,6 +569,56 @@ test_scan_sequences()
 
 
 
+void
+test_scan_large_directory()
+{
+    std::cout << "Testing scanning of a large directory:\n";
+    Filesystem::create_directory("bigseq");
+    const int nframes = 5000;  // Enough to be matched in parallel
+    for (int i = 1; i <= nframes; ++i)
+        create_test_file(Strutil::fmt::format("bigseq/foo.{:04d}.exr", i));
+    create_test_file("bigseq/foo.12.exr");                // too few digits
+    create_test_file("bigseq/foo.00042.exr");             // more digits ok
+    create_test_file("bigseq/foo.0x01.exr");              // not a number
+    Filesystem::create_directory("bigseq/foo.9999.exr");  // not a file
+    Filesystem::create_directory("bigseq/sub");
+    create_test_file("bigseq/sub/foo.0001.exr");
+
+    for (bool cached : { false, true, true }) {
+        Filesystem::cache_directory_listings(cached);
+        std::vector<int> numbers;
+        std::vector<std::string> names;
+        OIIO_CHECK_ASSERT(Filesystem::scan_for_matching_filenames(
+            "bigseq/foo.%04d.exr", numbers, names));
+        OIIO_CHECK_EQUAL(numbers.size(), nframes + 1);
+        OIIO_CHECK_EQUAL(names.size(), nframes + 1);
+        if (numbers.size() == nframes + 1 && names.size() == nframes + 1) {
+            OIIO_CHECK_EQUAL(numbers[0], 1);
+            OIIO_CHECK_EQUAL(names[0], "bigseq/foo.0001.exr");
+            OIIO_CHECK_EQUAL(numbers[41], 42);
+            OIIO_CHECK_EQUAL(numbers[42], 42);
+            OIIO_CHECK_EQUAL(names.back(), "bigseq/foo.5000.exr");
+        }
+    }
+    Filesystem::cache_directory_listings(false);
+
+    // Recursive listings read subdirectories in parallel, but still list
+    // each directory just before its contents.
+    std::vector<std::string> files;
+    OIIO_CHECK_ASSERT(Filesystem::get_directory_entries("bigseq", files,
+                                                        true));
+    OIIO_CHECK_EQUAL(files.size(), nframes + 6);
+    auto sub = std::find(files.begin(), files.end(), "bigseq/sub");
+    OIIO_CHECK_ASSERT(sub != files.end() && sub + 1 != files.end()
+                      && sub[1] == "bigseq/sub/foo.0001.exr");
+    OIIO_CHECK_ASSERT(Filesystem::get_directory_entries("bigseq", files, true,
+                                                        "sub"));
+    OIIO_CHECK_EQUAL(files.size(), 2);
+    Filesystem::remove_all("bigseq");
+}
+
+
+
 void
 test_mem_proxies()
 {
@@ -594,6 +647,199 @@ test_mem_proxies()
 
 
 
+void
+test_mmap_proxy()
+{
+    std::cout << "Testing mmap file proxy:\n";
+    std::string contents;
+    for (int i = 0; i < 10000; ++i)
+        contents += Strutil::fmt::format("{:04d}\n", i);
+    const char* tmpfilename = "oiio-mmap-test.txt";
+    Filesystem::write_text_file(tmpfilename, contents);
+    {
+        Filesystem::IOMMap in(tmpfilename);
+        OIIO_CHECK_ASSERT(in.opened());
+        OIIO_CHECK_EQUAL(in.proxytype(), std::string("mmap"));
+        OIIO_CHECK_EQUAL(in.size(), contents.size());
+        // The whole file is accessible without copying
+        OIIO_CHECK_EQUAL(string_view((const char*)in.buffer().data(),
+                                     in.buffer().size()),
+                         contents);
+        // Sequential reads, then pread and seek
+        std::string all;
+        char b[1000];
+        size_t len = 0;
+        while ((len = in.read(b, sizeof(b))))
+            all.append(b, len);
+        OIIO_CHECK_EQUAL(all, contents);
+        OIIO_CHECK_EQUAL(in.pread(b, 5, 5 * 42), 5);
+        OIIO_CHECK_EQUAL(string_view(b, 5), "0042\n");
+        in.seek(5 * 9999);
+        OIIO_CHECK_EQUAL(in.read(b, 100), 5);
+        OIIO_CHECK_EQUAL(string_view(b, 5), "9999\n");
+        in.close();
+        OIIO_CHECK_ASSERT(!in.opened());
+    }
+    Filesystem::remove(tmpfilename);
+    Filesystem::IOMMap missing("oiio-no-such-file.txt");
+    OIIO_CHECK_ASSERT(!missing.opened());
+    OIIO_CHECK_ASSERT(missing.error().size());
+}
+
+
+
+void
+test_pread_many()
+{
+    std::cout << "Testing batched pread:\n";
+    std::string contents;
+    for (int i = 0; i < 10000; ++i)
+        contents += Strutil::fmt::format("{:04d}\n", i);
+    const char* tmpfilename = "oiio-pread-test.txt";
+    Filesystem::write_text_file(tmpfilename, contents);
+    // Many scattered reads, more than are kept in flight at once, the last
+    // of them running past the end of the file (which is still complete,
+    // as it reads all there is).
+    const int nreqs = 200;
+    std::vector<char> bufs(nreqs * 5);
+    std::vector<Filesystem::IOProxy::ReadRequest> reqs(nreqs);
+    for (int i = 0; i < nreqs; ++i) {
+        reqs[i].buf    = &bufs[i * 5];
+        reqs[i].size   = 5;
+        reqs[i].offset = int64_t((i * 37) % 10000) * 5;
+    }
+    reqs.back().offset = int64_t(contents.size()) - 2;
+    auto check = [&](Filesystem::IOProxy& io) {
+        for (auto& r : reqs)
+            r.nread = 0;
+        OIIO_CHECK_ASSERT(io.pread_many(reqs));
+        bool ok = true;
+        for (int i = 0; i < nreqs - 1; ++i)
+            ok &= (reqs[i].nread == 5
+                   && string_view(&bufs[i * 5], 5)
+                          == string_view(contents).substr(reqs[i].offset, 5));
+        OIIO_CHECK_ASSERT(ok);
+        OIIO_CHECK_EQUAL(reqs.back().nread, 2);
+        OIIO_CHECK_EQUAL(string_view(&bufs[(nreqs - 1) * 5], 2), "9\n");
+        // A read that starts past the end is not.
+        Filesystem::IOProxy::ReadRequest past;
+        past.buf    = bufs.data();
+        past.size   = 5;
+        past.offset = int64_t(contents.size()) + 10;
+        OIIO_CHECK_ASSERT(!io.pread_many({ &past, 1 }));
+        OIIO_CHECK_EQUAL(past.nread, 0);
+    };
+    {
+        Filesystem::IOFile in(tmpfilename, Filesystem::IOProxy::Read);
+        check(in);
+    }
+    {
+        // Other proxies read them one at a time.
+        Filesystem::IOMemReader in(contents.data(), contents.size());
+        check(in);
+    }
+    Filesystem::remove(tmpfilename);
+}
+
+
+
+void
+test_readahead_proxy()
+{
+    std::cout << "Testing read-ahead proxy:\n";
+    std::string contents;
+    for (int i = 0; i < 20000; ++i)
+        contents += Strutil::fmt::format("{:04d}\n", i % 10000);
+    Filesystem::IOMemReader mem(contents.data(), contents.size());
+    const size_t blocksize = 4096;
+    const int nblocks = int((contents.size() + blocksize - 1) / blocksize);
+    {
+        // Many small sequential reads become one read per block.
+        Filesystem::IOReadAhead in(&mem, blocksize, 8, 2);
+        OIIO_CHECK_ASSERT(in.opened());
+        OIIO_CHECK_EQUAL(in.proxytype(), std::string("readahead"));
+        OIIO_CHECK_EQUAL(in.size(), contents.size());
+        std::string all;
+        char b[20];
+        size_t len = 0;
+        while ((len = in.read(b, sizeof(b))))
+            all.append(b, len);
+        OIIO_CHECK_EQUAL(all, contents);
+        OIIO_CHECK_LE(in.source_reads(), nblocks);
+        // Scattered reads spanning block boundaries, and past the end
+        bool ok = true;
+        for (int i = 0; i < 1000; ++i) {
+            int64_t offset = (int64_t(i) * 7919) % int64_t(contents.size());
+            size_t n       = in.pread(b, 10, offset);
+            ok &= (string_view(b, n)
+                   == string_view(contents).substr(size_t(offset), 10));
+        }
+        OIIO_CHECK_ASSERT(ok);
+        OIIO_CHECK_EQUAL(in.pread(b, 10, int64_t(contents.size())), 0);
+        // A read too big to cache goes straight to the source.
+        std::vector<char> big(contents.size());
+        int64_t reads = in.source_reads();
+        OIIO_CHECK_EQUAL(in.pread(big.data(), big.size(), 0), big.size());
+        OIIO_CHECK_EQUAL(in.source_reads(), reads + 1);
+        OIIO_CHECK_ASSERT(string_view(big.data(), big.size()) == contents);
+        // pread_many copies what's cached, and passes on the rest.
+        char c1[10], c2[10];
+        Filesystem::IOProxy::ReadRequest reqs[2];
+        reqs[0].buf    = c1;
+        reqs[0].size   = sizeof(c1);
+        reqs[0].offset = 5;  // In the cached first block
+        reqs[1].buf    = c2;
+        reqs[1].size   = sizeof(c2);
+        reqs[1].offset = int64_t(contents.size()) - 5;  // Runs off the end
+        OIIO_CHECK_ASSERT(in.pread_many(reqs));
+        OIIO_CHECK_ASSERT(string_view(c1, reqs[0].nread)
+                          == string_view(contents).substr(5, 10));
+        OIIO_CHECK_EQUAL(reqs[1].nread, 5);
+    }
+    {
+        // Taking ownership of the source, and reading from many threads
+        std::unique_ptr<Filesystem::IOProxy> src(
+            new Filesystem::IOMemReader(contents.data(), contents.size()));
+        Filesystem::IOReadAhead in(std::move(src), 1000, 4, 4);
+        std::atomic<bool> ok(true);
+        parallel_for(0, 64, [&](int64_t t) {
+            char b[100];
+            for (int64_t offset = t * 1000; offset < t * 1000 + 20000;
+                 offset += 77) {
+                size_t n = in.pread(b, sizeof(b), offset);
+                if (string_view(b, n)
+                    != string_view(contents).substr(size_t(offset), 100))
+                    ok = false;
+            }
+        });
+        OIIO_CHECK_ASSERT(ok);
+    }
+    Filesystem::IOReadAhead unopened(nullptr);
+    OIIO_CHECK_ASSERT(!unopened.opened());
+}
+
+
+
+void
+test_url_proxy()
+{
+    std::cout << "Testing URL proxy:\n";
+    OIIO_CHECK_ASSERT(Filesystem::is_url("http://example.com/a.tif"));
+    OIIO_CHECK_ASSERT(Filesystem::is_url("HTTPS://example.com/a.tif"));
+    OIIO_CHECK_ASSERT(Filesystem::is_url("s3://bucket/a.exr"));
+    OIIO_CHECK_ASSERT(!Filesystem::is_url("/tmp/http://a.tif"));
+    OIIO_CHECK_ASSERT(!Filesystem::is_url("a.tif"));
+    // Failures to open explain themselves, without any network.
+    Filesystem::IOHTTP https("https://example.com/a.tif");
+    OIIO_CHECK_ASSERT(!https.opened());
+    OIIO_CHECK_ASSERT(Strutil::contains(https.error(), "https"));
+    Filesystem::IOHTTP badkey("s3://bucket");
+    OIIO_CHECK_ASSERT(!badkey.opened());
+    OIIO_CHECK_ASSERT(badkey.error().size());
+}
+
+
+
 void
 test_last_write_time()
 {
@@ -653,7 +899,12 @@ main(int /*argc*/, char* /*argv*/[])
     test_file_status();
     test_frame_sequences();
     test_scan_sequences();
+    test_scan_large_directory();
     test_mem_proxies();
+    test_mmap_proxy();
+    test_pread_many();
+    test_readahead_proxy();
+    test_url_proxy();
     test_last_write_time();
     test_getline();
 
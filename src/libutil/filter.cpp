@@ -1047,4 +1047,44 @@ Filter2D::destroy(Filter2D* filt)
 }
 
 
+
+template<class FUNC>
+void
+FilterTable1D::init(float width, int resolution, FUNC&& f)
+{
+    if (!(width > 0.0f))
+        return;  // Leave it empty
+    // An even number of intervals, so that the center is an entry too, and
+    // spaced so that the last entry is exactly at the right edge.
+    int n    = std::max(2, int(std::ceil(width * std::max(resolution, 1))));
+    n        = (n + 1) & ~1;
+    m_offset = 0.5f * width;
+    m_scale  = width > 0.0f ? float(n) / width : 0.0f;
+    m_tmax   = float(n);
+    m_table.resize(n + 1);
+    for (int i = 0; i <= n; ++i)
+        m_table[i] = f(width * (float(i) / float(n)) - m_offset);
+}
+
+
+
+FilterTable1D::FilterTable1D(const Filter1D& filter, int resolution)
+{
+    init(filter.width(), resolution, [&](float x) { return filter(x); });
+}
+
+
+
+FilterTable1D::FilterTable1D(const Filter2D& filter, bool vertical,
+                             int resolution)
+{
+    if (vertical)
+        init(filter.height(), resolution,
+             [&](float y) { return filter.yfilt(y); });
+    else
+        init(filter.width(), resolution,
+             [&](float x) { return filter.xfilt(x); });
+}
+
+
 OIIO_NAMESPACE_END
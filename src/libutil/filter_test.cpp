@@ -92,6 +92,71 @@ test_2d()
 
 
 
+// Compare the tables to the filters they tabulate, everywhere but right
+// next to the edges, where the box is discontinuous.
+static float
+max_table_error(const FilterTable1D& table, function_view<float(float)> f,
+                float width)
+{
+    float hw = width / 2.0f, margin = 2.0f / table.scale();
+    float maxerr = 0.0f, peak = 0.0f;
+    for (int i = 0; i <= 100000; ++i) {
+        float x = -hw + width * (i / 100000.0f);
+        if (fabsf(x) > hw - margin)
+            continue;
+        maxerr = std::max(maxerr, fabsf(table(x) - f(x)));
+        peak   = std::max(peak, fabsf(f(x)));
+    }
+    return maxerr / peak;
+}
+
+
+
+void
+test_tables()
+{
+    print("\nTesting filter tables\n");
+    for (int i = 0, e = Filter1D::num_filters(); i < e; ++i) {
+        FilterDesc filtdesc;
+        Filter1D::get_filterdesc(i, &filtdesc);
+        auto filter = Filter1D::create_shared(filtdesc.name, filtdesc.width);
+        FilterTable1D table(*filter);
+        float err = max_table_error(
+            table, [&](float x) { return (*filter)(x); }, filter->width());
+        print("1D {:<20s}: relative error {:.3g}\n", filter->name(), err);
+        OIIO_CHECK_LT(err, 1.0e-5f);
+        // Exact at the center, and zero outside
+        OIIO_CHECK_EQUAL(table(0.0f), (*filter)(0.0f));
+        OIIO_CHECK_EQUAL(table(filter->width()), 0.0f);
+        OIIO_CHECK_EQUAL(table(-filter->width()), 0.0f);
+    }
+    for (int i = 0, e = Filter2D::num_filters(); i < e; ++i) {
+        FilterDesc filtdesc;
+        Filter2D::get_filterdesc(i, &filtdesc);
+        if (!filtdesc.separable)
+            continue;
+        // Different widths, to tell the x and y tables apart
+        auto filter = Filter2D::create_shared(filtdesc.name, filtdesc.width,
+                                              2.0f * filtdesc.width);
+        FilterTable1D xtable(*filter), ytable(*filter, true);
+        OIIO_CHECK_EQUAL(xtable.width(), filter->width());
+        OIIO_CHECK_EQUAL(ytable.width(), filter->height());
+        float xerr = max_table_error(
+            xtable, [&](float x) { return filter->xfilt(x); },
+            filter->width());
+        float yerr = max_table_error(
+            ytable, [&](float y) { return filter->yfilt(y); },
+            filter->height());
+        print("2D {:<20s}: relative error {:.3g} {:.3g}\n", filter->name(),
+              xerr, yerr);
+        OIIO_CHECK_LT(xerr, 1.0e-5f);
+        OIIO_CHECK_LT(yerr, 1.0e-5f);
+    }
+    OIIO_CHECK_EQUAL(FilterTable1D()(0.0f), 0.0f);
+}
+
+
+
 void
 graph_1d()
 {
@@ -202,6 +267,9 @@ bench_1d()
         auto filter = Filter1D::create_shared(filtdesc.name, filtdesc.width);
         auto f      = filter.get();
         bench(filtdesc.name, [=]() { DoNotOptimize((*f)(0.25f)); });
+        FilterTable1D table(*f);
+        bench(Strutil::fmt::format("{} table", filtdesc.name),
+              [&]() { DoNotOptimize(table(0.25f)); });
     }
 }
 
@@ -241,10 +309,13 @@ main(int argc, char* argv[])
 
     test_1d();
     test_2d();
+    test_tables();
     if (graph) {
         test_1d();
         test_2d();
     }
     bench_1d();
     bench_2d();
+
+    return unit_test_failures;
 }
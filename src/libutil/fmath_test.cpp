@@ -332,6 +332,87 @@ test_convert_type(double tolerance = 1e-6)
 
 
 
+// The SIMD conversion of arrays, with a length that leaves a remainder,
+// must match converting one value at a time (except that SIMD rounds exact
+// ties to even when converting to integers).
+template<typename S, typename D>
+void
+test_convert_type_array()
+{
+    const size_t n = 1027;
+    std::vector<S> svec(n);
+    for (size_t i = 0; i < n; ++i) {
+        // Cover the full range of integers, or a bit beyond [0,1] for float
+        if (std::numeric_limits<S>::is_integer)
+            svec[i] = S(i * 131071u);
+        else
+            svec[i] = S(float(i) / (n - 200) - 0.1f);
+    }
+    std::vector<D> dvec(n);
+    convert_type(svec.data(), dvec.data(), n);
+    int bad = 0;
+    double tolerance = std::numeric_limits<D>::is_integer ? 1.0 : 0.0;
+    for (size_t i = 0; i < n; ++i)
+        bad += (std::abs(double(dvec[i]) - double(convert_type<S, D>(svec[i])))
+                > tolerance);
+    Strutil::print("array convert {} -> {}: {} mismatches\n",
+                   TypeDesc(BaseTypeFromC<S>::value),
+                   TypeDesc(BaseTypeFromC<D>::value), bad);
+    OIIO_CHECK_EQUAL(bad, 0);
+}
+
+
+
+// Every value of an 8 or 16 bit unsigned integer type, converted to float
+// and back by the array conversions, must match converting them one at a
+// time -- both for the whole range at once and for every length short
+// enough to leave each possible tail after the 8- and 4-wide loops, and
+// without writing past the end.
+template<typename I>
+void
+test_convert_type_exhaustive()
+{
+    const size_t n = size_t(std::numeric_limits<I>::max()) + 1;
+    std::vector<I> ivec(n);
+    for (size_t i = 0; i < n; ++i)
+        ivec[i] = I(i);
+    std::vector<float> fvec(n);
+    std::vector<I> back(n);
+    convert_type(ivec.data(), fvec.data(), n);
+    convert_type(fvec.data(), back.data(), n);
+    int bad = 0;
+    for (size_t i = 0; i < n; ++i)
+        bad += (fvec[i] != convert_type<I, float>(ivec[i])
+                || back[i] != convert_type<float, I>(fvec[i])
+                || back[i] != ivec[i]);
+
+    // Lengths up to three 8-wide vectors, from every offset within one,
+    // near both ends of the range.
+    const float fsentinel = -42.0f;
+    const I isentinel     = I(12345);
+    for (size_t start : { size_t(0), n - 40 }) {
+        for (size_t offset = 0; offset < 8; ++offset) {
+            for (size_t len = 0; len <= 24; ++len) {
+                const I* isrc    = ivec.data() + start + offset;
+                const float* src = fvec.data() + start + offset;
+                std::vector<float> f(len + 1, fsentinel);
+                std::vector<I> i(len + 1, isentinel);
+                convert_type(isrc, f.data(), len);
+                convert_type(src, i.data(), len);
+                for (size_t j = 0; j < len; ++j)
+                    bad += (f[j] != convert_type<I, float>(isrc[j])
+                            || i[j] != convert_type<float, I>(src[j]));
+                bad += (f[len] != fsentinel || i[len] != isentinel);
+            }
+        }
+    }
+    Strutil::print("exhaustive array convert {} <-> float: {} mismatches\n",
+                   TypeDesc(BaseTypeFromC<I>::value), bad);
+    OIIO_CHECK_EQUAL(bad, 0);
+}
+
+
+
 template<typename S, typename D>
 void
 do_convert_type(const std::vector<S>& svec, std::vector<D>& dvec)
@@ -745,6 +826,12 @@ main(int argc, char* argv[])
     std::cout << "round trip convert float/unsigned int/float\n";
     test_convert_type<float, unsigned int>();
 
+    test_convert_type_array<unsigned char, float>();
+    test_convert_type_array<float, unsigned char>();
+    test_convert_type_array<unsigned short, float>();
+    test_convert_type_array<float, unsigned short>();
+    test_convert_type_exhaustive<unsigned char>();
+    test_convert_type_exhaustive<unsigned short>();
     test_half_convert_accuracy();
 
     benchmark_convert_type<unsigned char, float>();
@@ -79,6 +79,16 @@ test_fasthash64(int len)
     return a;
 }
 
+uint64_t
+test_fasthash128(int len)
+{
+    char* ptr  = reinterpret_cast<char*>(data.data());
+    uint64_t a = 0;
+    for (int i = 0, e = iterations / len; i < e; i++, ptr += len)
+        a += FastHash128(ptr, len).gethash().lo;
+    return a;
+}
+
 #ifdef __AES__
 
 // https://github.com/gamozolabs/falkhash
@@ -174,6 +184,47 @@ test_falkhash(int len)
 
 
 
+static void
+test_fasthash128_streaming()
+{
+    print("\nTesting FastHash128 streaming\n");
+    // Enough to span several chunks, and not a multiple of the chunk size
+    size_t size = std::min(data.size() * sizeof(data[0]), size_t(1000000));
+    const char* bytes = reinterpret_cast<const char*>(data.data());
+    std::string whole = FastHash128::digest(bytes, size);
+    print("  {} bytes: {}\n", size, whole);
+    OIIO_CHECK_EQUAL(whole.size(), 32);
+
+    // It doesn't matter how the data is split among calls to append()
+    for (size_t piece : { size_t(1), size_t(7), size_t(4096), size_t(65535),
+                          size_t(65536), size_t(100000), size }) {
+        FastHash128 h;
+        for (size_t pos = 0; pos < size; pos += piece)
+            h.append(bytes + pos, std::min(piece, size - pos));
+        OIIO_CHECK_EQUAL(h.digest(), whole);
+    }
+
+    // The hash so far may be taken without disturbing what follows
+    FastHash128 h(bytes, size / 3);
+    OIIO_CHECK_EQUAL(h.digest(), FastHash128::digest(bytes, size / 3));
+    h.append(bytes + size / 3, size - size / 3);
+    OIIO_CHECK_EQUAL(h.digest(), whole);
+
+    // Any change, including to the length, gives a different hash
+    OIIO_CHECK_NE(FastHash128::digest(bytes, size - 1), whole);
+    OIIO_CHECK_NE(FastHash128::digest(bytes + 1, size - 1), whole);
+    std::vector<char> zeros(size);
+    OIIO_CHECK_NE(FastHash128::digest(zeros.data(), size - 1),
+                  FastHash128::digest(zeros.data(), size));
+    OIIO_CHECK_NE(FastHash128::digest(zeros.data(), 0),
+                  FastHash128::digest(zeros.data(), 1));
+    FastHash128 s;
+    s.append(string_view("openimageio"));
+    OIIO_CHECK_EQUAL(s.digest(), FastHash128::digest("openimageio", 11));
+}
+
+
+
 static void
 getargs(int argc, char* argv[])
 {
@@ -236,6 +287,7 @@ main(int argc, char* argv[])
         std::make_pair("farmhash          ", test_farmhash),
         std::make_pair("farmhash::inlined ", test_farmhash_inlined),
         std::make_pair("fasthash64        ", test_fasthash64),
+        std::make_pair("FastHash128       ", test_fasthash128),
 #ifdef __AES__
         std::make_pair("falkhash          ", test_falkhash),
 #endif
@@ -358,5 +410,7 @@ main(int argc, char* argv[])
         ++stringno;
     }
 
+    test_fasthash128_streaming();
+
     return unit_test_failures;
 }
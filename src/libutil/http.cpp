@@ -0,0 +1,641 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#    include <netdb.h>
+#    include <netinet/in.h>
+#    include <netinet/tcp.h>
+#    include <sys/socket.h>
+#    include <sys/time.h>
+#    include <unistd.h>
+#endif
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/thread.h>
+
+OIIO_NAMESPACE_BEGIN
+
+
+// Bytes fetched when the URL is opened, which hold the headers of nearly
+// every image file.
+static const size_t head_bytes = 64 * 1024;
+
+// pread_many() reads the bytes between requests this close together,
+// rather than make another request, up to this many bytes at once.
+static const int64_t merge_gap   = 64 * 1024;
+static const int64_t merge_limit = 16 * 1024 * 1024;
+
+// Most idle connections to keep open.
+static const size_t max_idle = 16;
+
+
+
+bool
+Filesystem::is_url(string_view name)
+{
+    return Strutil::istarts_with(name, "http://")
+           || Strutil::istarts_with(name, "https://")
+           || Strutil::istarts_with(name, "s3://");
+}
+
+
+
+std::unique_ptr<Filesystem::IOProxy>
+Filesystem::open_url(string_view url)
+{
+    std::unique_ptr<IOProxy> http(new IOHTTP(url));
+    if (!http->opened())
+        return http;  // Which explains why
+    // Blocks smaller than the default, since each costs a round trip but
+    // the reads of tiles are scattered over the file.
+    return std::unique_ptr<IOProxy>(
+        new IOReadAhead(std::move(http), 256 * 1024, 64));
+}
+
+
+
+#ifndef _WIN32
+
+namespace {
+
+// Split a URL into the host, port, and request target, or return false
+// and say why not.
+bool
+parse_url(string_view url, std::string& host, std::string& port,
+          std::string& target, std::string& err)
+{
+    if (Strutil::istarts_with(url, "s3://")) {
+        url.remove_prefix(5);
+        size_t slash       = url.find('/');
+        string_view bucket = url.substr(0, slash);
+        string_view key    = slash == string_view::npos
+                                 ? string_view()
+                                 : url.substr(slash + 1);
+        if (bucket.empty() || key.empty()) {
+            err = "an s3 URL must be s3://bucket/key";
+            return false;
+        }
+        const char* endpoint = getenv("AWS_ENDPOINT_URL");
+        if (endpoint && *endpoint) {
+            // e.g. a MinIO server: path-style, endpoint/bucket/key
+            if (!parse_url(endpoint, host, port, target, err))
+                return false;
+            if (target.size() && target.back() != '/')
+                target += '/';
+            target += Strutil::fmt::format("{}/{}", bucket, key);
+        } else {
+            host   = Strutil::fmt::format("{}.s3.amazonaws.com", bucket);
+            port   = "80";
+            target = Strutil::fmt::format("/{}", key);
+        }
+        return true;
+    }
+    if (Strutil::istarts_with(url, "https://")) {
+        err = "https is not supported (OpenImageIO has no TLS library)";
+        return false;
+    }
+    if (!Strutil::istarts_with(url, "http://")) {
+        err = "not an http URL";
+        return false;
+    }
+    url.remove_prefix(7);
+    size_t end            = std::min(url.find('/'), url.find('?'));
+    string_view authority = url.substr(0, end);
+    target = end == string_view::npos ? std::string("/")
+                                      : std::string(url.substr(end));
+    if (target[0] == '?')
+        target.insert(0, "/");
+    size_t at = authority.rfind('@');  // No credentials are sent
+    if (at != string_view::npos)
+        authority.remove_prefix(at + 1);
+    size_t colon = authority.rfind(':');
+    if (colon != string_view::npos
+        && authority.find(']', colon) == string_view::npos) {
+        port      = authority.substr(colon + 1);
+        authority = authority.substr(0, colon);
+    } else {
+        port = "80";
+    }
+    if (authority.size() > 2 && authority.front() == '['
+        && authority.back() == ']')
+        authority = authority.substr(1, authority.size() - 2);  // IPv6
+    host = authority;
+    if (host.empty() || port.empty()) {
+        err = "no host in the URL";
+        return false;
+    }
+    return true;
+}
+
+
+
+bool
+send_all(int fd, string_view data)
+{
+#    ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;  // A closed connection is just an error
+#    else
+    const int flags = 0;
+#    endif
+    while (data.size()) {
+        ssize_t n = ::send(fd, data.data(), data.size(), flags);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        data.remove_prefix(size_t(n));
+    }
+    return true;
+}
+
+
+
+ssize_t
+recv_some(int fd, void* buf, size_t size)
+{
+    for (;;) {
+        ssize_t n = ::recv(fd, buf, size, 0);
+        if (n >= 0 || errno != EINTR)
+            return n;
+    }
+}
+
+}  // namespace
+
+
+
+struct Filesystem::IOHTTP::Impl {
+    std::string host, port, target;
+    std::string hostfield;  // What the Host header says
+    int timeout_ms = 0;
+    sockaddr_storage addr;
+    socklen_t addrlen = 0;
+    int64_t filesize  = 0;
+    std::vector<char> head;  // The first bytes of the file
+    std::atomic<int64_t> nrequests { 0 };
+    std::mutex mutex;  // Protects idle
+    std::vector<int> idle;
+
+    ~Impl() { close_all(); }
+
+    void close_all()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int fd : idle)
+            ::close(fd);
+        idle.clear();
+    }
+
+    // A connection, pooled if there is one, or -1.
+    int connect(bool& pooled)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pooled = !idle.empty();
+            if (pooled) {
+                int fd = idle.back();
+                idle.pop_back();
+                return fd;
+            }
+        }
+        int fd = ::socket(addr.ss_family, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#    ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#    endif
+        timeval tv;
+        tv.tv_sec  = timeout_ms / 1000;
+        tv.tv_usec = (timeout_ms % 1000) * 1000;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        if (::connect(fd, (const sockaddr*)&addr, addrlen) < 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    void release(int fd, bool reuse)
+    {
+        if (reuse) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (idle.size() < max_idle) {
+                idle.push_back(fd);
+                return;
+            }
+        }
+        ::close(fd);
+    }
+
+    // Read up to `size` bytes at `offset` into buf[] with one request,
+    // returning how many were read, and setting `total` to the size of the
+    // file if asked to. On failure, return false and say why.
+    bool get(int64_t offset, size_t size, char* buf, size_t& nread,
+             std::string& err, int64_t* total = nullptr)
+    {
+        nread = 0;
+        if (!size)
+            return true;
+        std::string request = Strutil::fmt::format(
+            "GET {} HTTP/1.1\r\nHost: {}\r\nRange: bytes={}-{}\r\n"
+            "User-Agent: OpenImageIO/{}\r\n\r\n",
+            target, hostfield, offset, offset + int64_t(size) - 1,
+            OIIO_VERSION_STRING);
+        // A pooled connection may have been closed by the server since
+        // its last use, in which case we try again with a new one.
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            bool pooled = false;
+            int fd      = connect(pooled);
+            if (fd < 0) {
+                err = Strutil::fmt::format("could not connect to {}:{}", host,
+                                           port);
+                return false;
+            }
+            ++nrequests;
+            std::string reply;
+            size_t eoh = std::string::npos;
+            char tmp[16384];
+            bool sent = send_all(fd, request);
+            while (sent && eoh == std::string::npos) {
+                ssize_t n = recv_some(fd, tmp, sizeof(tmp));
+                if (n <= 0)
+                    break;
+                reply.append(tmp, size_t(n));
+                eoh = reply.find("\r\n\r\n");
+                if (eoh == std::string::npos && reply.size() > 65536)
+                    break;  // That's no HTTP header
+            }
+            if (eoh == std::string::npos) {
+                ::close(fd);
+                if (pooled && reply.empty())
+                    continue;
+                err = Strutil::fmt::format("no reply from {}:{}", host, port);
+                return false;
+            }
+            return body(fd, reply, eoh, offset, size, buf, nread, err, total);
+        }
+        err = Strutil::fmt::format("lost the connection to {}:{}", host, port);
+        return false;
+    }
+
+    // Having read the headers of a reply, reply[0..eoh), and perhaps some
+    // of its body after them, read the rest of the body into buf[].
+    bool body(int fd, const std::string& reply, size_t eoh, int64_t offset,
+              size_t size, char* buf, size_t& nread, std::string& err,
+              int64_t* total)
+    {
+        string_view headers(reply.data(), eoh);
+        int status         = 0;
+        int64_t length     = -1;
+        int64_t rangebegin = -1;
+        int64_t rangetotal = -1;
+        bool keepalive     = true;
+        bool chunked       = false;
+        bool first         = true;
+        for (auto line : Strutil::splitsv(headers, "\r\n")) {
+            if (first) {
+                // "HTTP/1.1 206 Partial Content"
+                first = false;
+                if (!Strutil::parse_prefix(line, "HTTP/1.")) {
+                    ::close(fd);
+                    err = "not an HTTP server";
+                    return false;
+                }
+                // HTTP/1.0 closes the connection after each reply.
+                keepalive = Strutil::parse_prefix(line, "1");
+                if (!keepalive)
+                    Strutil::parse_prefix(line, "0");
+                Strutil::parse_int(line, status);
+                continue;
+            }
+            size_t colon = line.find(':');
+            if (colon == string_view::npos)
+                continue;
+            string_view name  = Strutil::strip(line.substr(0, colon));
+            string_view value = Strutil::strip(line.substr(colon + 1));
+            if (Strutil::iequals(name, "Content-Length")) {
+                length = Strutil::from_string<int64_t>(value);
+            } else if (Strutil::iequals(name, "Content-Range")) {
+                // "bytes 0-65535/1234567"
+                Strutil::parse_prefix(value, "bytes");
+                Strutil::skip_whitespace(value);
+                rangebegin   = Strutil::from_string<int64_t>(value);
+                size_t slash = value.find('/');
+                if (slash != string_view::npos && value[slash + 1] != '*')
+                    rangetotal = Strutil::from_string<int64_t>(
+                        value.substr(slash + 1));
+            } else if (Strutil::iequals(name, "Connection")) {
+                keepalive = !Strutil::iequals(value, "close");
+            } else if (Strutil::iequals(name, "Transfer-Encoding")) {
+                chunked = !Strutil::iequals(value, "identity");
+            }
+        }
+        if (status == 206 && rangebegin != offset) {
+            err = "the server sent the wrong range";
+        } else if (status == 200) {
+            err = "the server doesn't support range requests";
+        } else if (status == 416) {
+            err = "the file is empty";
+        } else if (status != 206) {
+            err = Strutil::fmt::format("HTTP status {}", status);
+        } else if (chunked || length < 0) {
+            err = "the server sent no Content-Length";
+        }
+        if (err.size()) {
+            ::close(fd);
+            return false;
+        }
+        if (total)
+            *total = rangetotal;
+        // The part of the body that came with the headers, then the rest.
+        size_t have  = std::min(reply.size() - (eoh + 4), size_t(length));
+        size_t limit = std::min(size_t(length), size);
+        memcpy(buf, reply.data() + eoh + 4, std::min(have, limit));
+        nread         = std::min(have, limit);
+        int64_t extra = length - int64_t(limit);  // To be read and dropped
+        while (nread < limit) {
+            ssize_t n = recv_some(fd, buf + nread, limit - nread);
+            if (n <= 0)
+                break;
+            nread += size_t(n);
+        }
+        // Anything after the body would be taken for the next reply.
+        keepalive &= (reply.size() - (eoh + 4) <= size_t(length));
+        if (nread == limit && extra > 0) {
+            // The connection can only take another request once the rest
+            // of the body is drained, so it's closed if that fails.
+            int64_t dropped = std::max(int64_t(have) - int64_t(limit),
+                                       int64_t(0));
+            char tmp[16384];
+            while (dropped < extra) {
+                ssize_t n = recv_some(fd, tmp,
+                                      size_t(std::min(extra - dropped,
+                                                      int64_t(sizeof(tmp)))));
+                if (n <= 0)
+                    break;
+                dropped += n;
+            }
+            keepalive &= (dropped == extra);
+        }
+        if (nread < limit) {
+            ::close(fd);
+            err = Strutil::fmt::format("lost the connection to {}:{}", host,
+                                       port);
+            return nread > 0;
+        }
+        release(fd, keepalive);
+        return true;
+    }
+};
+
+
+
+Filesystem::IOHTTP::IOHTTP(string_view url, int timeout_ms)
+    : IOProxy(url, Read)
+    , m_impl(new Impl)
+{
+    Impl& impl(*m_impl);
+    impl.timeout_ms = std::max(timeout_ms, 1);
+    std::string err;
+    if (!parse_url(url, impl.host, impl.port, impl.target, err)) {
+        m_mode = Closed;
+        error(Strutil::fmt::format("Could not open \"{}\": {}", url, err));
+        return;
+    }
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res     = nullptr;
+    if (getaddrinfo(impl.host.c_str(), impl.port.c_str(), &hints, &res)
+        || !res) {
+        m_mode = Closed;
+        error(Strutil::fmt::format("Could not open \"{}\": unknown host {}",
+                                   url, impl.host));
+        return;
+    }
+    memcpy(&impl.addr, res->ai_addr, res->ai_addrlen);
+    impl.addrlen = socklen_t(res->ai_addrlen);
+    freeaddrinfo(res);
+    // The port may only be left out of the Host header if it's the usual
+    // one, and an IPv6 address must be in brackets.
+    impl.hostfield = impl.host.find(':') == std::string::npos
+                         ? impl.host
+                         : "[" + impl.host + "]";
+    if (impl.port != "80" && impl.port != "443")
+        impl.hostfield += ":" + impl.port;
+
+    // Fetch the first bytes, and learn the size.
+    impl.head.resize(head_bytes);
+    size_t n      = 0;
+    int64_t total = -1;
+    if (!impl.get(0, head_bytes, impl.head.data(), n, err, &total)
+        || total < 0) {
+        m_mode = Closed;
+        error(Strutil::fmt::format("Could not open \"{}\": {}", url,
+                                   err.size() ? err : "unknown size"));
+        return;
+    }
+    impl.head.resize(n);
+    impl.filesize = total;
+}
+
+
+
+Filesystem::IOHTTP::~IOHTTP() {}
+
+
+
+void
+Filesystem::IOHTTP::close()
+{
+    m_impl->close_all();
+    m_mode = Closed;
+}
+
+
+
+size_t
+Filesystem::IOHTTP::read(void* buf, size_t size)
+{
+    size_t n = pread(buf, size, m_pos);
+    m_pos += int64_t(n);
+    return n;
+}
+
+
+
+size_t
+Filesystem::IOHTTP::pread(void* buf, size_t size, int64_t offset)
+{
+    Impl& impl(*m_impl);
+    if (!opened() || offset < 0 || offset >= impl.filesize || !size)
+        return 0;
+    size = size_t(std::min(int64_t(size), impl.filesize - offset));
+    if (offset + int64_t(size) <= int64_t(impl.head.size())) {
+        memcpy(buf, impl.head.data() + offset, size);
+        return size;
+    }
+    size_t n = 0;
+    std::string err;
+    if (!impl.get(offset, size, (char*)buf, n, err) || n < size)
+        error(Strutil::fmt::format("\"{}\": {}", filename(),
+                                   err.size() ? err : "short read"));
+    return n;
+}
+
+
+
+bool
+Filesystem::IOHTTP::pread_many(span<ReadRequest> requests)
+{
+    // Merge the requests, in order of offset, into spans each read with
+    // one range request.
+    struct Span {
+        int64_t begin, end;
+        std::vector<ReadRequest*> reqs;
+    };
+    std::vector<ReadRequest*> sorted;
+    for (auto& r : requests) {
+        r.nread = 0;
+        sorted.push_back(&r);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const ReadRequest* a, const ReadRequest* b) {
+                  return a->offset < b->offset;
+              });
+    std::vector<Span> spans;
+    for (ReadRequest* r : sorted) {
+        int64_t end = r->offset + int64_t(r->size);
+        if (spans.size() && r->offset <= spans.back().end + merge_gap
+            && end - spans.back().begin <= merge_limit) {
+            spans.back().end = std::max(spans.back().end, end);
+            spans.back().reqs.push_back(r);
+        } else {
+            spans.push_back({ r->offset, end, { r } });
+        }
+    }
+
+    auto read_span = [this](Span& s) {
+        if (s.reqs.size() == 1) {
+            ReadRequest& r(*s.reqs[0]);
+            r.nread = pread(r.buf, r.size, r.offset);
+            return;
+        }
+        std::unique_ptr<char[]> tmp(new char[size_t(s.end - s.begin)]);
+        size_t n = pread(tmp.get(), size_t(s.end - s.begin), s.begin);
+        for (ReadRequest* r : s.reqs) {
+            int64_t start = r->offset - s.begin;
+            if (start >= int64_t(n))
+                continue;
+            r->nread = std::min(r->size, n - size_t(start));
+            memcpy(r->buf, tmp.get() + start, r->nread);
+        }
+    };
+    if (spans.size() == 1) {
+        read_span(spans[0]);
+    } else {
+        // Each request waits on the network, so send them all at once.
+        thread_pool* pool = io_thread_pool();
+        task_set tasks(pool);
+        for (auto& s : spans)
+            tasks.push(pool->push([&read_span, &s](int /*id*/) {
+                read_span(s);
+            }));
+        tasks.wait();
+    }
+    bool ok = true;
+    for (auto& r : requests)
+        ok &= r.complete(m_impl->filesize);
+    return ok;
+}
+
+
+
+size_t
+Filesystem::IOHTTP::size() const
+{
+    return size_t(m_impl->filesize);
+}
+
+
+
+int64_t
+Filesystem::IOHTTP::requests() const
+{
+    return m_impl->nrequests;
+}
+
+
+
+#else  // _WIN32
+
+struct Filesystem::IOHTTP::Impl {};
+
+Filesystem::IOHTTP::IOHTTP(string_view url, int /*timeout_ms*/)
+    : IOProxy(url, Read)
+{
+    m_mode = Closed;
+    error(Strutil::fmt::format(
+        "Could not open \"{}\": URLs are not supported on this platform",
+        url));
+}
+
+Filesystem::IOHTTP::~IOHTTP() {}
+
+void
+Filesystem::IOHTTP::close()
+{
+    m_mode = Closed;
+}
+
+size_t
+Filesystem::IOHTTP::read(void* /*buf*/, size_t /*size*/)
+{
+    return 0;
+}
+
+size_t
+Filesystem::IOHTTP::pread(void* /*buf*/, size_t /*size*/, int64_t /*offset*/)
+{
+    return 0;
+}
+
+bool
+Filesystem::IOHTTP::pread_many(span<ReadRequest> requests)
+{
+    return requests.empty();
+}
+
+size_t
+Filesystem::IOHTTP::size() const
+{
+    return 0;
+}
+
+int64_t
+Filesystem::IOHTTP::requests() const
+{
+    return 0;
+}
+
+#endif
+
+OIIO_NAMESPACE_END
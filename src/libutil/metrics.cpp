@@ -0,0 +1,393 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <cmath>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <OpenImageIO/atomic.h>
+#include <OpenImageIO/metrics.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/sysutil.h>
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace Metrics {
+
+std::atomic<bool> pvt::collecting(
+    Strutil::stoi(Sysutil::getenv("OPENIMAGEIO_METRICS")) != 0);
+
+namespace {
+
+// Each thread adds to one shard of every counter and histogram, the
+// threads being dealt out to the shards in turn.
+int
+shard_index()
+{
+    static std::atomic<int> next_thread(0);
+    thread_local int index = next_thread++ % nshards;
+    return index;
+}
+
+
+
+template<typename T> struct Family {
+    std::string help;
+    std::map<std::string, std::unique_ptr<T>> metrics;  // by labels
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::map<std::string, Family<Counter>> counters;
+    std::map<std::string, Family<Histogram>> histograms;
+    std::map<int, Source> sources;
+    int next_source = 1;
+
+    // All the sources' samples, grouped by name.
+    std::map<std::string, std::vector<Sample>> source_samples()
+    {
+        std::vector<Sample> samples;
+        for (auto& s : sources)
+            s.second(samples);
+        std::map<std::string, std::vector<Sample>> byname;
+        for (auto& s : samples)
+            byname[s.name].push_back(std::move(s));
+        return byname;
+    }
+};
+
+// It's never destroyed, so that the metrics outlive anything recording
+// them from static destructors.
+Registry&
+registry()
+{
+    static Registry* r = new Registry;
+    return *r;
+}
+
+
+
+std::string
+escape(string_view s, bool quotes)
+{
+    std::string r;
+    for (char c : s) {
+        if (c == '\\' || (quotes && c == '"'))
+            r += '\\';
+        if (c == '\n')
+            r += "\\n";
+        else
+            r += c;
+    }
+    return r;
+}
+
+
+
+std::string
+number(double v)
+{
+    if (std::isinf(v))
+        return v > 0 ? "+Inf" : "-Inf";
+    if (std::isnan(v))
+        return "NaN";
+    return Strutil::fmt::format("{}", v);
+}
+
+
+
+// name{labels} (or just name, without labels), with an extra label
+std::string
+sample_name(string_view name, string_view labels, string_view extra = {})
+{
+    if (labels.empty() && extra.empty())
+        return std::string(name);
+    return Strutil::fmt::format("{}{{{}{}{}}}", name, labels,
+                                labels.size() && extra.size() ? "," : "",
+                                extra);
+}
+
+
+
+void
+family_header(std::string& out, string_view name, string_view help,
+              string_view type, bool openmetrics)
+{
+    // OpenMetrics names a counter's family without the "_total" that
+    // ends the name of its samples.
+    if (openmetrics && type == "counter" && Strutil::ends_with(name, "_total"))
+        name.remove_suffix(6);
+    out += Strutil::fmt::format("# HELP {} {}\n# TYPE {} {}\n", name,
+                                escape(help, false), name, type);
+}
+
+}  // namespace
+
+
+
+void
+start()
+{
+    pvt::collecting = true;
+}
+
+
+
+void
+stop()
+{
+    pvt::collecting = false;
+}
+
+
+
+void
+Counter::add(int64_t n) noexcept
+{
+    m_shards[shard_index()].count.fetch_add(n, std::memory_order_relaxed);
+}
+
+
+
+int64_t
+Counter::value() const noexcept
+{
+    int64_t total = 0;
+    for (auto& s : m_shards)
+        total += s.count.load(std::memory_order_relaxed);
+    return total;
+}
+
+
+
+void
+Histogram::record(double v) noexcept
+{
+    // Bucket b holds (base*2^(b-1), base*2^b].
+    int b    = 0;
+    double x = v / m_base;
+    if (x > 1.0) {
+        int e;
+        double m = std::frexp(x, &e);
+        b        = std::min(m == 0.5 ? e - 1 : e, nbuckets - 1);
+    }
+    Shard& shard(m_shards[shard_index()]);
+    shard.buckets[b].fetch_add(1, std::memory_order_relaxed);
+    atomic_fetch_add(shard.sum, v);
+}
+
+
+
+double
+Histogram::upper_bound(int b) const noexcept
+{
+    return b >= nbuckets - 1 ? std::numeric_limits<double>::infinity()
+                             : std::ldexp(m_base, b);
+}
+
+
+
+int64_t
+Histogram::bucket(int b) const noexcept
+{
+    int64_t total = 0;
+    for (auto& s : m_shards)
+        total += s.buckets[b].load(std::memory_order_relaxed);
+    return total;
+}
+
+
+
+int64_t
+Histogram::count() const noexcept
+{
+    int64_t total = 0;
+    for (int b = 0; b < nbuckets; ++b)
+        total += bucket(b);
+    return total;
+}
+
+
+
+double
+Histogram::sum() const noexcept
+{
+    double total = 0.0;
+    for (auto& s : m_shards)
+        total += s.sum.load(std::memory_order_relaxed);
+    return total;
+}
+
+
+
+Counter&
+counter(string_view name, string_view help, string_view labels)
+{
+    Registry& r(registry());
+    std::lock_guard<std::mutex> lock(r.mutex);
+    Family<Counter>& family(r.counters[std::string(name)]);
+    if (family.help.empty())
+        family.help = help;
+    auto& c = family.metrics[std::string(labels)];
+    if (!c)
+        c.reset(new Counter);
+    return *c;
+}
+
+
+
+Histogram&
+histogram(string_view name, string_view help, string_view labels,
+          double base)
+{
+    Registry& r(registry());
+    std::lock_guard<std::mutex> lock(r.mutex);
+    Family<Histogram>& family(r.histograms[std::string(name)]);
+    if (family.help.empty())
+        family.help = help;
+    auto& h = family.metrics[std::string(labels)];
+    if (!h)
+        h.reset(new Histogram(base));
+    return *h;
+}
+
+
+
+std::string
+label(string_view key, string_view value)
+{
+    return Strutil::fmt::format("{}=\"{}\"", key, escape(value, true));
+}
+
+
+
+int
+add_source(Source source)
+{
+    Registry& r(registry());
+    std::lock_guard<std::mutex> lock(r.mutex);
+    int id        = r.next_source++;
+    r.sources[id] = std::move(source);
+    return id;
+}
+
+
+
+void
+remove_source(int id)
+{
+    // Holding the lock, this waits for any text() or value() that may be
+    // calling the source to finish with it.
+    Registry& r(registry());
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.sources.erase(id);
+}
+
+
+
+std::string
+text(bool openmetrics)
+{
+    std::string out;
+    Registry& r(registry());
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto& f : r.counters) {
+        family_header(out, f.first, f.second.help, "counter", openmetrics);
+        for (auto& c : f.second.metrics)
+            out += Strutil::fmt::format("{} {}\n",
+                                        sample_name(f.first, c.first),
+                                        c.second->value());
+    }
+    for (auto& f : r.histograms) {
+        family_header(out, f.first, f.second.help, "histogram", openmetrics);
+        for (auto& h : f.second.metrics) {
+            const Histogram& hist(*h.second);
+            int64_t cumulative = 0;
+            for (int b = 0; b < Histogram::nbuckets; ++b) {
+                cumulative += hist.bucket(b);
+                std::string le = Strutil::fmt::format(
+                    "le=\"{}\"", number(hist.upper_bound(b)));
+                out += Strutil::fmt::format(
+                    "{} {}\n", sample_name(f.first + "_bucket", h.first, le),
+                    cumulative);
+            }
+            out += Strutil::fmt::format("{} {}\n{} {}\n",
+                                        sample_name(f.first + "_sum", h.first),
+                                        number(hist.sum()),
+                                        sample_name(f.first + "_count",
+                                                    h.first),
+                                        cumulative);
+        }
+    }
+    for (auto& f : r.source_samples()) {
+        const Sample& first(f.second.front());
+        family_header(out, f.first, first.help,
+                      first.counter ? "counter" : "gauge", openmetrics);
+        for (auto& s : f.second)
+            out += Strutil::fmt::format("{} {}\n",
+                                        sample_name(s.name, s.labels),
+                                        number(s.value));
+    }
+    if (openmetrics)
+        out += "# EOF\n";
+    return out;
+}
+
+
+
+bool
+value(string_view name, double& value)
+{
+    std::string labels;
+    bool all = true;
+    size_t brace = name.find('{');
+    if (brace != string_view::npos && Strutil::ends_with(name, "}")) {
+        labels = name.substr(brace + 1, name.size() - brace - 2);
+        name   = name.substr(0, brace);
+        all    = false;
+    }
+    std::string key(name);
+    bool found = false;
+    value      = 0.0;
+    Registry& r(registry());
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto c = r.counters.find(key);
+    if (c != r.counters.end()) {
+        for (auto& m : c->second.metrics) {
+            if (all || m.first == labels) {
+                value += double(m.second->value());
+                found = true;
+            }
+        }
+    }
+    auto h = r.histograms.find(key);
+    if (h != r.histograms.end()) {
+        for (auto& m : h->second.metrics) {
+            if (all || m.first == labels) {
+                value += double(m.second->count());
+                found = true;
+            }
+        }
+    }
+    auto samples = r.source_samples();
+    auto s       = samples.find(key);
+    if (s != samples.end()) {
+        for (auto& sample : s->second) {
+            if (all || sample.labels == labels) {
+                value += sample.value;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+}  // namespace Metrics
+
+OIIO_NAMESPACE_END
@@ -0,0 +1,131 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <thread>
+#include <vector>
+
+#include <OpenImageIO/benchmark.h>
+#include <OpenImageIO/metrics.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/unittest.h>
+
+using namespace OIIO;
+
+
+
+static void
+test_counters()
+{
+    Strutil::print("Testing counters\n");
+    Metrics::Counter& c(Metrics::counter("test_calls_total", "Test calls",
+                                         Metrics::label("kind", "a")));
+    OIIO_CHECK_EQUAL(&c, &Metrics::counter("test_calls_total", "",
+                                           "kind=\"a\""));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i)
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 1000; ++j)
+                c.add();
+        });
+    for (auto& t : threads)
+        t.join();
+    OIIO_CHECK_EQUAL(c.value(), 8000);
+    Metrics::counter("test_calls_total", "", Metrics::label("kind", "b"))
+        .add(5);
+
+    double v = 0;
+    OIIO_CHECK_ASSERT(Metrics::value("test_calls_total", v));
+    OIIO_CHECK_EQUAL(v, 8005.0);
+    OIIO_CHECK_ASSERT(Metrics::value("test_calls_total{kind=\"b\"}", v));
+    OIIO_CHECK_EQUAL(v, 5.0);
+    OIIO_CHECK_ASSERT(!Metrics::value("no_such_metric", v));
+    OIIO_CHECK_EQUAL(Metrics::label("k", "a\"b"), "k=\"a\\\"b\"");
+}
+
+
+
+static void
+test_histograms()
+{
+    Strutil::print("Testing histograms\n");
+    Metrics::Histogram& h(Metrics::histogram("test_seconds", "Test times",
+                                             "", 1.0));
+    OIIO_CHECK_EQUAL(h.upper_bound(0), 1.0);
+    OIIO_CHECK_EQUAL(h.upper_bound(3), 8.0);
+    h.record(0.5);  // bucket 0
+    h.record(1.0);  // bucket 0
+    h.record(1.5);  // bucket 1
+    h.record(8.0);  // bucket 3
+    h.record(9.0);  // bucket 4
+    h.record(1.0e30);
+    OIIO_CHECK_EQUAL(h.bucket(0), 2);
+    OIIO_CHECK_EQUAL(h.bucket(1), 1);
+    OIIO_CHECK_EQUAL(h.bucket(3), 1);
+    OIIO_CHECK_EQUAL(h.bucket(4), 1);
+    OIIO_CHECK_EQUAL(h.bucket(Metrics::Histogram::nbuckets - 1), 1);
+    OIIO_CHECK_EQUAL(h.count(), 6);
+    OIIO_CHECK_EQUAL(h.sum(), 20.0 + 1.0e30);
+}
+
+
+
+static void
+test_text()
+{
+    Strutil::print("Testing text\n");
+    int id = Metrics::add_source([](std::vector<Metrics::Sample>& samples) {
+        samples.push_back({ "test_depth", "Test depth", "", 3.0, false });
+    });
+    std::string text = Metrics::text();
+    Strutil::print("{}\n", text);
+    OIIO_CHECK_ASSERT(Strutil::contains(text, "# TYPE test_calls_total "
+                                              "counter\n"));
+    OIIO_CHECK_ASSERT(Strutil::contains(text, "test_calls_total{kind=\"a\"} "
+                                              "8000\n"));
+    OIIO_CHECK_ASSERT(Strutil::contains(text, "# TYPE test_seconds "
+                                              "histogram\n"));
+    OIIO_CHECK_ASSERT(Strutil::contains(text, "test_seconds_bucket{le=\"2\"} "
+                                              "3\n"));
+    OIIO_CHECK_ASSERT(Strutil::contains(text, "test_seconds_bucket"
+                                              "{le=\"+Inf\"} 6\n"));
+    OIIO_CHECK_ASSERT(Strutil::contains(text, "test_seconds_count 6\n"));
+    OIIO_CHECK_ASSERT(Strutil::contains(text, "# TYPE test_depth gauge\n"
+                                              "test_depth 3\n"));
+    OIIO_CHECK_ASSERT(!Strutil::contains(text, "# EOF"));
+
+    std::string om = Metrics::text(true);
+    OIIO_CHECK_ASSERT(Strutil::contains(om, "# TYPE test_calls counter\n"));
+    OIIO_CHECK_ASSERT(Strutil::ends_with(om, "# EOF\n"));
+
+    Metrics::remove_source(id);
+    OIIO_CHECK_ASSERT(!Strutil::contains(Metrics::text(), "test_depth"));
+}
+
+
+
+static void
+benchmark_counter()
+{
+    Metrics::Counter& c(Metrics::counter("bench_total", "Benchmark"));
+    Benchmarker bench;
+    bench("Counter::add", [&]() { c.add(); });
+    Metrics::stop();
+    bench("enabled() check when not collecting", []() {
+        bool e = Metrics::enabled();
+        DoNotOptimize(e);
+    });
+}
+
+
+
+int
+main(int /*argc*/, char* /*argv*/[])
+{
+    test_counters();
+    test_histograms();
+    test_text();
+    benchmark_counter();
+    return unit_test_failures;
+}
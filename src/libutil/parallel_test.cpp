@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <functional>
 #include <iostream>
+#include <set>
 
 #include <OpenImageIO/argparse.h>
 #include <OpenImageIO/benchmark.h>
@@ -117,6 +118,31 @@ test_parallel_for_2D()
 
 
 
+void
+test_parallel_for_tiled_2D()
+{
+    // Every item is visited exactly once, even with partial edge tiles
+    const int64_t xres = 1000, yres = 77, tilesize = 32;
+    std::vector<int> vals(xres * yres, 0);
+    std::atomic<bool> oversize(false);
+    parallel_for_tiled_2D(0, xres, 0, yres, tilesize,
+                          [&](int64_t xb, int64_t xe, int64_t yb, int64_t ye) {
+                              if (xe - xb > tilesize || ye - yb > tilesize)
+                                  oversize = true;
+                              for (auto y = yb; y < ye; ++y)
+                                  for (auto x = xb; x < xe; ++x)
+                                      vals[y * xres + x] += 1;
+                          });
+    OIIO_CHECK_ASSERT(!oversize);
+    OIIO_CHECK_ASSERT(
+        std::all_of(vals.cbegin(), vals.cend(), [](int v) { return v == 1; }));
+
+    int64_t ts = parallel_tile_size(16);
+    OIIO_CHECK_ASSERT(ts >= 16 && ts <= 512 && ts % 16 == 0);
+}
+
+
+
 void
 test_thread_pool_recursion()
 {
@@ -140,6 +166,45 @@ test_thread_pool_recursion()
 
 
 
+void
+test_nested_parallelism()
+{
+    std::cout << "\nTesting parallel loops run from within pool tasks"
+              << std::endl;
+    thread_pool* pool(default_thread_pool());
+    pool->resize(4);
+    // A loop run by a single pool task should still get spread across
+    // the idle threads.
+    spin_mutex mutex;
+    std::set<std::thread::id> threads;
+    atomic_int count(0);
+    pool->push([&](int /*id*/) {
+            parallel_for(
+                0, 64,
+                [&](int64_t /*i*/) {
+                    Sysutil::usleep(1000);
+                    count += 1;
+                    spin_lock lock(mutex);
+                    threads.insert(std::this_thread::get_id());
+                },
+                paropt().minitems(1));
+        })
+        .wait();
+    OIIO_CHECK_EQUAL(count, 64);
+    OIIO_CHECK_GT(threads.size(), 1);
+
+    // Loops nested within loops all complete.
+    count = 0;
+    parallel_for(0, 16, [&](int64_t /*i*/) {
+        parallel_for(0, 16, [&](int64_t /*j*/) {
+            parallel_for(0, 16, [&](int64_t /*k*/) { count += 1; });
+        });
+    });
+    OIIO_CHECK_EQUAL(count, 16 * 16 * 16);
+}
+
+
+
 void
 test_empty_thread_pool()
 {
@@ -192,8 +257,10 @@ main(int argc, char** argv)
 
     test_parallel_for();
     test_parallel_for_2D();
+    test_parallel_for_tiled_2D();
     time_parallel_for();
     test_thread_pool_recursion();
+    test_nested_parallelism();
     test_empty_thread_pool();
     test_thread_pool_shutdown();
 
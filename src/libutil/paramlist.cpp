@@ -7,8 +7,10 @@
 #include <cstdlib>
 
 #include <OpenImageIO/dassert.h>
+#include <OpenImageIO/fmath.h>
 #include <OpenImageIO/half.h>
 #include <OpenImageIO/paramlist.h>
+#include <OpenImageIO/strutil.h>
 #include <OpenImageIO/ustring.h>
 
 
@@ -35,6 +37,7 @@ ParamValue::init_noclear(ustring _name, TypeDesc _type, int _nvalues,
     m_type      = _type;
     m_nvalues   = _nvalues;
     m_interp    = _interp;
+    m_inlist    = false;
     size_t size = (size_t)(m_nvalues * m_type.size());
     bool small  = (size <= sizeof(m_data));
 
@@ -78,7 +81,7 @@ ParamValue::operator=(const ParamValue& p) noexcept
     if (this != &p) {
         clear_value();
         init_noclear(p.name(), p.type(), p.nvalues(), p.interp(), p.data(),
-                     Copy(p.m_copy), FromUstring(true));
+                     Copy(p.m_copy || p.m_inlist), FromUstring(true));
     }
     return *this;
 }
@@ -91,10 +94,12 @@ ParamValue::operator=(ParamValue&& p) noexcept
     if (this != &p) {
         clear_value();
         init_noclear(p.name(), p.type(), p.nvalues(), p.interp(), p.data(),
-                     Copy(false), FromUstring(true));
-        m_copy       = p.m_copy;
-        m_nonlocal   = p.m_nonlocal;
-        p.m_data.ptr = nullptr;  // make sure the old one won't free
+                     Copy(p.m_inlist), FromUstring(true));
+        if (!p.m_inlist) {
+            m_copy       = p.m_copy;
+            m_nonlocal   = p.m_nonlocal;
+            p.m_data.ptr = nullptr;  // make sure the old one won't free
+        }
     }
     return *this;
 }
@@ -374,6 +379,7 @@ ParamValue::clear_value() noexcept
     m_data.ptr = nullptr;
     m_copy     = false;
     m_nonlocal = false;
+    m_inlist   = false;
 }
 
 
@@ -389,9 +395,263 @@ pvt::heapsize<ParamValue>(const ParamValue& pv)
 
 
 
+namespace {
+
+// Lists shorter than this are searched without an index.
+constexpr size_t min_indexed_size = 16;
+
+// Case-insensitive (in the C locale, like Strutil::iequals) FNV-1a hash of
+// a name.
+inline uint32_t
+name_hash(string_view name)
+{
+    uint32_t h = 2166136261u;
+    for (unsigned char c : name) {
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        h = (h ^ c) * 16777619u;
+    }
+    return h;
+}
+
+}  // namespace
+
+
+
+// An open addressed hash table of the positions of the first `size`
+// entries of the list, keyed on the case-insensitive hash of their names,
+// so it serves both case-sensitive and case-insensitive searches.
+struct ParamValueList::Index {
+    struct Slot {
+        uint32_t hash;
+        uint32_t pos;  // Position in the list + 1, or 0 if the slot is empty
+    };
+    std::vector<Slot> slots;  // Power of 2 long, never more than half full
+    const ParamValue* data = nullptr;  // The list's data() when indexed
+    size_t size            = 0;        // How many entries are indexed
+    ustring last;                      // The name of the last one
+
+    // Are the first `size` entries of the list, as far as we can cheaply
+    // tell, still the ones that were indexed?
+    bool current_prefix(const ParamValueList& list) const
+    {
+        return size && size <= list.size() && data == list.data()
+               && data[size - 1].name() == last;
+    }
+
+    // Are exactly the entries of the list indexed?
+    bool current(const ParamValueList& list) const
+    {
+        return size == list.size() && current_prefix(list);
+    }
+
+    // Index the entries after the first `size` (or all of them, if size is
+    // 0), growing the table as needed.
+    void add(const ParamValueList& list)
+    {
+        if (!size || 2 * list.size() > slots.size()) {
+            size_t n = 2 * min_indexed_size;
+            while (n < 2 * list.size())
+                n *= 2;
+            slots.assign(n, Slot { 0, 0 });
+            size = 0;
+        }
+        size_t mask = slots.size() - 1;
+        for (; size < list.size(); ++size) {
+            uint32_t h = name_hash(list.data()[size].name());
+            size_t i   = h & mask;
+            while (slots[i].pos)
+                i = (i + 1) & mask;
+            slots[i] = { h, uint32_t(size + 1) };
+        }
+        data = list.data();
+        last = data[size - 1].name();
+    }
+
+    // Return the position of the first entry matching name and type, or
+    // the list's size if there is none. All entries with the same hash are
+    // in the run of slots starting at the hash, but not in list order.
+    size_t find(const ParamValueList& list, string_view name, TypeDesc type,
+                bool casesensitive) const
+    {
+        uint32_t h   = name_hash(name);
+        size_t mask  = slots.size() - 1;
+        size_t found = list.size();
+        for (size_t i = h & mask; slots[i].pos; i = (i + 1) & mask) {
+            size_t p = slots[i].pos - 1;
+            if (slots[i].hash != h || p >= found)
+                continue;
+            const ParamValue& pv(data[p]);
+            if ((casesensitive ? pv.name() == name
+                               : Strutil::iequals(pv.name(), name))
+                && (type == TypeDesc::UNKNOWN || type == pv.type()))
+                found = p;
+        }
+        return found;
+    }
+};
+
+
+
+ParamValueList::ParamValueList(const ParamValueList& other)
+    : std::vector<ParamValue>()
+{
+    // Rather than each big value getting its own allocation, they all get
+    // a piece of one, which the entries refer to without owning.
+    auto piece = [](const ParamValue& p) {
+        return p.is_nonlocal() ? round_to_multiple(size_t(p.datasize()), 16)
+                               : size_t(0);
+    };
+    size_t bytes = 0;
+    for (const ParamValue& p : other)
+        bytes += piece(p);
+    if (bytes)
+        m_values.reset(new char[bytes]);
+    reserve(other.size());
+    char* values = m_values.get();
+    for (const ParamValue& p : other) {
+        if (!p.is_nonlocal()) {
+            emplace_back(p);
+            continue;
+        }
+        memcpy(values, p.data(), size_t(p.datasize()));  //NOSONAR
+        emplace_back(p, ParamValue::Copy(false));
+        back().m_data.ptr = values;
+        back().m_inlist   = true;
+        values += piece(p);
+    }
+    const Index* index = other.m_index.load(std::memory_order_acquire);
+    if (index && index->current(other)) {
+        Index* copy = new Index(*index);
+        copy->data  = data();
+        m_index.store(copy, std::memory_order_relaxed);
+    }
+}
+
+
+
+ParamValueList::ParamValueList(ParamValueList&& other) noexcept
+    : std::vector<ParamValue>(std::move(other))
+    , m_index(other.m_index.exchange(nullptr))
+    , m_values(std::move(other.m_values))
+{
+}
+
+
+
+ParamValueList::~ParamValueList() { drop_index(); }
+
+
+
+ParamValueList&
+ParamValueList::operator=(const ParamValueList& other)
+{
+    if (this != &other) {
+        ParamValueList copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+
+
+ParamValueList&
+ParamValueList::operator=(ParamValueList&& other) noexcept
+{
+    if (this != &other) {
+        std::vector<ParamValue>::operator=(std::move(other));
+        drop_index();
+        m_index.store(other.m_index.exchange(nullptr),
+                      std::memory_order_relaxed);
+        m_values = std::move(other.m_values);
+    }
+    return *this;
+}
+
+
+
+void
+ParamValueList::clear() noexcept
+{
+    std::vector<ParamValue>::clear();
+    drop_index();
+    m_values.reset();
+}
+
+
+
+void
+ParamValueList::swap(ParamValueList& other) noexcept
+{
+    std::vector<ParamValue>::swap(other);
+    Index* index = m_index.exchange(nullptr);
+    m_index.store(other.m_index.exchange(index));
+    m_values.swap(other.m_values);
+}
+
+
+
+void
+ParamValueList::drop_index() noexcept
+{
+    delete m_index.exchange(nullptr);
+}
+
+
+
+// For searches of a const list, which may be searched by other threads at
+// once: use the index if it's current, or build it if there is none yet,
+// but leave a stale index for the next search of the non-const list to
+// bring up to date, since other threads may be using it.
+const ParamValueList::Index*
+ParamValueList::current_index() const
+{
+    if (size() < min_indexed_size)
+        return nullptr;
+    Index* index = m_index.load(std::memory_order_acquire);
+    if (index)
+        return index->current(*this) ? index : nullptr;
+    Index* fresh = new Index;
+    fresh->add(*this);
+    if (m_index.compare_exchange_strong(index, fresh,
+                                        std::memory_order_acq_rel)) {
+        return fresh;
+    }
+    delete fresh;  // Another thread just built one
+    return index->current(*this) ? index : nullptr;
+}
+
+
+
+// For searches of the non-const list, which nobody else may be using:
+// index any entries appended since last time, or rebuild the index if the
+// list was otherwise changed.
+const ParamValueList::Index*
+ParamValueList::updated_index()
+{
+    if (size() < min_indexed_size) {
+        drop_index();
+        return nullptr;
+    }
+    Index* index = m_index.load(std::memory_order_relaxed);
+    if (!index) {
+        index = new Index;
+        m_index.store(index, std::memory_order_relaxed);
+    } else if (!index->current_prefix(*this)) {
+        index->size = 0;
+    }
+    if (index->size < size())
+        index->add(*this);
+    return index;
+}
+
+
+
 ParamValueList::const_iterator
 ParamValueList::find(ustring name, TypeDesc type, bool casesensitive) const
 {
+    if (const Index* index = current_index())
+        return cbegin() + index->find(*this, name, type, casesensitive);
     if (casesensitive) {
         for (const_iterator i = cbegin(), e = cend(); i != e; ++i) {
             if (i->name() == name
@@ -413,6 +673,8 @@ ParamValueList::find(ustring name, TypeDesc type, bool casesensitive) const
 ParamValueList::const_iterator
 ParamValueList::find(string_view name, TypeDesc type, bool casesensitive) const
 {
+    if (const Index* index = current_index())
+        return cbegin() + index->find(*this, name, type, casesensitive);
     if (casesensitive) {
         return find(ustring(name), type, casesensitive);
     } else {
@@ -430,6 +692,8 @@ ParamValueList::find(string_view name, TypeDesc type, bool casesensitive) const
 ParamValueList::iterator
 ParamValueList::find(ustring name, TypeDesc type, bool casesensitive)
 {
+    if (const Index* index = updated_index())
+        return begin() + index->find(*this, name, type, casesensitive);
     if (casesensitive) {
         for (iterator i = begin(), e = end(); i != e; ++i) {
             if (i->name() == name
@@ -451,6 +715,8 @@ ParamValueList::find(ustring name, TypeDesc type, bool casesensitive)
 ParamValueList::iterator
 ParamValueList::find(string_view name, TypeDesc type, bool casesensitive)
 {
+    if (const Index* index = updated_index())
+        return begin() + index->find(*this, name, type, casesensitive);
     if (casesensitive) {
         return find(ustring(name), type, casesensitive);
     } else {
@@ -647,6 +913,7 @@ ParamValueList::sort(bool casesensitive)
                                  ? bprefix
                                  : Strutil::iless(a.name(), b.name());
                   });
+    drop_index();  // The positions it holds are all wrong now
 }
 
 
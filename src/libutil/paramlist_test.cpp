@@ -4,10 +4,12 @@
 
 
 #include <limits>
+#include <memory>
 
 #include <OpenImageIO/Imath.h>
 #include <OpenImageIO/paramlist.h>
 #include <OpenImageIO/span.h>
+#include <OpenImageIO/strutil.h>
 #include <OpenImageIO/typedesc.h>
 #include <OpenImageIO/unittest.h>
 
@@ -354,6 +356,124 @@ test_paramlist()
 
 
 
+static void
+test_paramlist_index()
+{
+    std::cout << "test_paramlist_index\n";
+    // Long enough lists are searched with a hash index of the names, which
+    // must give the same answers as looking at every entry would.
+    auto check = [](const ParamValueList& pl, int n) {
+        for (int i = 0; i < n; ++i) {
+            std::string name = Strutil::fmt::format("attrib{}", i);
+            auto f           = pl.find(name);
+            OIIO_CHECK_ASSERT(f != pl.cend() && f->get_int() == i);
+            OIIO_CHECK_ASSERT(pl.contains(Strutil::upper(name),
+                                          TypeDesc::UNKNOWN, false));
+            OIIO_CHECK_ASSERT(!pl.contains(Strutil::upper(name)));
+            OIIO_CHECK_ASSERT(!pl.contains(name, TypeFloat));
+        }
+        OIIO_CHECK_ASSERT(!pl.contains(Strutil::fmt::format("attrib{}", n)));
+    };
+    ParamValueList pl;
+    for (int i = 0; i < 100; ++i) {
+        pl.attribute(Strutil::fmt::format("attrib{}", i), i);
+        OIIO_CHECK_ASSERT(pl.contains(Strutil::fmt::format("attrib{}", i)));
+    }
+    OIIO_CHECK_EQUAL(pl.size(), 100);
+    check(pl, 100);
+    const ParamValueList& cpl(pl);
+    check(cpl, 100);
+
+    // Appended entries are found by either kind of search
+    pl.emplace_back("attrib100", 100);
+    check(cpl, 101);
+    pl.emplace_back("attrib101", 101);
+    check(pl, 102);
+
+    // The first of several matching entries is found
+    pl.emplace_back("Attrib5", 5.0f);
+    OIIO_CHECK_EQUAL(cpl.find("ATTRIB5", TypeUnknown, false) - cpl.cbegin(),
+                     5);
+    OIIO_CHECK_EQUAL(cpl.find("ATTRIB5", TypeFloat, false) - cpl.cbegin(),
+                     102);
+
+    // Changes to the list otherwise are noticed too
+    pl.remove("Attrib5");
+    pl.remove("attrib101");
+    pl.erase(pl.begin());
+    OIIO_CHECK_ASSERT(!cpl.contains("attrib0"));
+    OIIO_CHECK_EQUAL(cpl.find("attrib1") - cpl.cbegin(), 0);
+    ParamValueList copy(pl);
+    pl.sort();
+    OIIO_CHECK_EQUAL(cpl.find("attrib2") - cpl.cbegin(), 12);
+    OIIO_CHECK_EQUAL(copy.find("attrib2") - copy.cbegin(), 1);
+    // ...even those that leave as many entries, ending with the same name,
+    // in the same storage.
+    auto check_positions = [&]() {
+        for (size_t j = 0; j + 1 < cpl.size(); ++j)
+            OIIO_CHECK_EQUAL(cpl.find(cpl[int(j)].name()) - cpl.cbegin(),
+                             int(j));
+    };
+    ustring last = pl.back().name();
+    pl.erase(pl.begin() + 3);
+    pl.emplace_back(last, 0);
+    check_positions();
+    pl.insert(pl.begin(), ParamValue("first", 1));
+    pl.pop_back();
+    check_positions();
+    OIIO_CHECK_EQUAL(cpl.find("first") - cpl.cbegin(), 0);
+    pl.resize(pl.size() - 2);
+    pl.emplace_back(last, 0);
+    check_positions();
+    pl.clear();
+    for (int i = 0; i < 200; ++i)
+        pl.emplace_back(Strutil::fmt::format("attrib{}", 199 - i), 199 - i);
+    check(cpl, 200);
+    pl.swap(copy);
+    OIIO_CHECK_ASSERT(!cpl.contains("attrib0") && cpl.contains("attrib100"));
+    OIIO_CHECK_ASSERT(!cpl.contains("attrib101"));
+    check(copy, 200);
+}
+
+
+
+static void
+test_paramlist_copy()
+{
+    std::cout << "test_paramlist_copy\n";
+    // A copied list holds its big values in storage of its own, which must
+    // not be left referred to by anything that outlives (or leaves) it.
+    const float m[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 42, 0, 0, 1 };
+    const int ints[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    ParamValue moved, assigned;
+    ParamValueList copy2;
+    {
+        std::unique_ptr<ParamValueList> orig(new ParamValueList);
+        orig->attribute("small", 1);
+        orig->attribute("matrix", TypeMatrix, m);
+        orig->attribute("ints", TypeDesc(TypeDesc::INT, 8), ints);
+        ParamValueList copy(*orig);
+        orig.reset();
+        OIIO_CHECK_ASSERT(copy.find("matrix")->is_nonlocal());
+        OIIO_CHECK_EQUAL(copy.find("matrix")->get<float>(12), 42.0f);
+        OIIO_CHECK_EQUAL(copy.find("ints")->get<int>(7), 8);
+        OIIO_CHECK_EQUAL(copy.get_int("small"), 1);
+        assigned = *copy.find("ints");
+        copy2    = copy;
+        moved    = std::move(copy[1]);
+        copy.attribute("matrix", TypeMatrix, m);  // replace it
+        copy.emplace_back("more", 3);             // make it reallocate
+    }
+    OIIO_CHECK_EQUAL(moved.get<float>(12), 42.0f);
+    OIIO_CHECK_EQUAL(assigned.get<int>(7), 8);
+    ParamValueList swapped;
+    swapped.swap(copy2);
+    OIIO_CHECK_EQUAL(swapped.find("matrix")->get<float>(12), 42.0f);
+    OIIO_CHECK_EQUAL(swapped.find("ints")->get<int>(0), 1);
+}
+
+
+
 static void
 test_delegates()
 {
@@ -531,6 +651,8 @@ main(int /*argc*/, char* /*argv*/[])
     test_value_types();
     test_from_string();
     test_paramlist();
+    test_paramlist_index();
+    test_paramlist_copy();
     test_delegates();
     test_implied_construction();
     test_paramlistspan();
@@ -33,6 +33,7 @@ static bool wedge           = false;
 
 long long accum = 0;
 spin_rw_mutex mymutex;
+adaptive_rw_mutex myadaptivemutex;
 
 
 
@@ -54,6 +55,23 @@ do_accum(int iterations)
 
 
 
+static void
+do_accum_adaptive(int iterations)
+{
+    for (int i = 0; i < iterations; ++i) {
+        if ((i % (read_write_ratio + 1)) == read_write_ratio) {
+            adaptive_rw_write_lock lock(myadaptivemutex);
+            accum += 1;
+        } else {
+            adaptive_rw_read_lock lock(myadaptivemutex);
+            if (accum < 0)
+                break;
+        }
+    }
+}
+
+
+
 void
 test_spin_rw(int numthreads, int iterations)
 {
@@ -74,6 +92,27 @@ test_spin_rw(int numthreads, int iterations)
 
 
 
+// Like test_spin_rw, but for adaptive_rw_mutex, and with more threads than
+// cores so that some of them have to sleep.
+void
+test_adaptive_rw(int numthreads, int iterations)
+{
+    long long contended = 0, parked = 0;
+    adaptive_mutex_stats(contended, parked, true);
+    accum = 0;
+    thread_group threads;
+    for (int i = 0; i < numthreads; ++i)
+        threads.create_thread(do_accum_adaptive, iterations);
+    threads.join_all();
+    OIIO_CHECK_EQUAL(accum, (((long long)iterations / (read_write_ratio + 1))
+                             * (long long)numthreads));
+    adaptive_mutex_stats(contended, parked);
+    std::cout << "adaptive_rw_mutex, " << numthreads << " threads: "
+              << contended << " contended, " << parked << " parked\n";
+}
+
+
+
 static void
 getargs(int argc, char* argv[])
 {
@@ -130,5 +169,8 @@ main(int argc, char* argv[])
             break;  // don't loop if we're not wedging
     }
 
+    int nt = 4 * std::max(1, int(Sysutil::hardware_concurrency()));
+    test_adaptive_rw(nt, std::min(iterations / nt, 100000));
+
     return unit_test_failures;
 }
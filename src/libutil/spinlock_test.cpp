@@ -43,12 +43,17 @@ time_lock_cycle()
     Benchmarker bench;
     std::cout << "Cost of lock/unlock cycle under no contention:\n";
     spin_mutex sm;
+    adaptive_mutex am;
     std::mutex m;
     std::recursive_mutex rm;
     bench("spin_mutex", [&]() {
         sm.lock();
         sm.unlock();
     });
+    bench("adaptive_mutex", [&]() {
+        am.lock();
+        am.unlock();
+    });
     bench("std::mutex", [&]() {
         m.lock();
         m.unlock();
@@ -89,6 +94,35 @@ do_accum(int iterations)
 
 
 
+// With more threads than cores incrementing under an adaptive_mutex, some
+// of them have to sleep, and the count must still come out right.
+static void
+test_adaptive_mutex()
+{
+    long long contended = 0, parked = 0;
+    adaptive_mutex_stats(contended, parked, true);
+    adaptive_mutex am;
+    long long count = 0;
+    int nthreads    = 4 * std::max(1, int(Sysutil::hardware_concurrency()));
+    int iters       = std::min(iterations / nthreads, 100000);
+    thread_group threads;
+    for (int t = 0; t < nthreads; ++t) {
+        threads.create_thread([&]() {
+            for (int i = 0; i < iters; ++i) {
+                adaptive_lock lock(am);
+                ++count;
+            }
+        });
+    }
+    threads.join_all();
+    OIIO_CHECK_EQUAL(count, (long long)nthreads * iters);
+    adaptive_mutex_stats(contended, parked);
+    std::cout << "\nadaptive_mutex, " << nthreads << " threads: "
+              << contended << " contended, " << parked << " parked\n";
+}
+
+
+
 static void
 getargs(int argc, char* argv[])
 {
@@ -130,5 +164,7 @@ main(int argc, char* argv[])
         timed_thread_wedge(do_accum, numthreads, iterations, ntrials,
                            numthreads);
 
+    test_adaptive_mutex();
+
     return unit_test_failures;
 }
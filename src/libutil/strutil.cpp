@@ -14,6 +14,7 @@ OIIO_CLANG_PRAGMA(clang diagnostic ignored "-Wdeprecated-declarations")
 OIIO_PRAGMA_WARNING_POP
 
 #include <algorithm>
+#include <charconv>
 #include <cmath>
 #include <cstdarg>
 #include <cstdint>
@@ -1227,6 +1228,46 @@ Strutil::parse_string(string_view& str, string_view& val, bool eat,
 
 
 
+size_t
+Strutil::parse_numbers(string_view& str, span<int> values, bool eat) noexcept
+{
+    string_view p = str;
+    size_t n      = 0;
+    for (; n < values.size(); ++n) {
+        size_t endpos = 0;
+        int v         = Strutil::stoi(p, &endpos);
+        if (endpos == 0)
+            break;
+        values[n] = v;
+        p.remove_prefix(endpos);
+    }
+    if (eat)
+        str = p;
+    return n;
+}
+
+
+
+size_t
+Strutil::parse_numbers(string_view& str, span<float> values, bool eat) noexcept
+{
+    string_view p = str;
+    size_t n      = 0;
+    for (; n < values.size(); ++n) {
+        size_t endpos = 0;
+        float v       = Strutil::stof(p, &endpos);
+        if (endpos == 0)
+            break;
+        values[n] = v;
+        p.remove_prefix(endpos);
+    }
+    if (eat)
+        str = p;
+    return n;
+}
+
+
+
 bool
 Strutil::parse_values(string_view& str, string_view prefix, span<int> values,
                       string_view sep, string_view postfix, bool eat) noexcept
@@ -1779,12 +1820,55 @@ Strutil::strtod(const char* nptr, char** endptr) noexcept
 
 
 
+// Parse a float or double from the start of str, exactly as strtod would in
+// the "C" locale, using std::from_chars, which needs neither a locale nor a
+// null-terminated copy of the string. Return false, having parsed nothing,
+// if from_chars isn't available or the text is one of the cases it treats
+// differently from strtod: no number at all, hex, or a value out of range.
+template<typename T>
+static bool
+from_chars_c(string_view str, T& val, size_t& pos) noexcept
+{
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    const char* begin = str.data();
+    const char* end   = begin + str.size();
+    const char* p     = begin;
+    while (p != end && Strutil::isspace(*p))
+        ++p;
+    if (p != end && *p == '+') {
+        ++p;  // from_chars allows only a leading '-'
+        if (p != end && *p == '-')
+            return false;
+    }
+    const char* digits = (p != end && *p == '-') ? p + 1 : p;
+    if (end - digits >= 2 && digits[0] == '0'
+        && (digits[1] == 'x' || digits[1] == 'X'))
+        return false;
+    auto result = std::from_chars(p, end, val);
+    if (result.ec != std::errc())
+        return false;
+    pos = size_t(result.ptr - begin);
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+
 float
 Strutil::stof(const char* s, size_t* pos)
 {
     if (s) {
+        float r;
+        size_t endpos;
+        if (from_chars_c(string_view(s), r, endpos)) {
+            if (pos)
+                *pos = endpos;
+            return r;
+        }
         char* endptr;
-        float r = Strutil::strtof(s, &endptr);
+        r = Strutil::strtof(s, &endptr);
         if (endptr != s) {
             if (pos)
                 *pos = size_t(endptr - s);
@@ -1801,20 +1885,28 @@ Strutil::stof(const char* s, size_t* pos)
 float
 Strutil::stof(const std::string& s, size_t* pos)
 {
-    return Strutil::stof(s.c_str(), pos);
+    return Strutil::stof(string_view(s), pos);
 }
 
 
 float
 Strutil::stof(string_view s, size_t* pos)
 {
-    // string_view can't be counted on to end with a terminating null, so
-    // for safety, create a temporary string. This looks wasteful, but it's
+    float r;
+    size_t endpos;
+    if (from_chars_c(s, r, endpos)) {
+        if (pos)
+            *pos = endpos;
+        return r;
+    }
+    // For what from_chars doesn't handle, strtod is needed. But string_view
+    // can't be counted on to end with a terminating null, so for safety,
+    // create a temporary string. This looks wasteful, but it's
     // not as bad as you think -- fully compliant C++ >= 11 implementations
     // will use the "short string optimization", meaning that this string
     // creation will NOT need an allocation/free for most strings we expect
     // to hold a text representation of a float.
-    return Strutil::stof(std::string(s), pos);
+    return Strutil::stof(std::string(s).c_str(), pos);
 }
 
 
@@ -1823,8 +1915,15 @@ double
 Strutil::stod(const char* s, size_t* pos)
 {
     if (s) {
+        double r;
+        size_t endpos;
+        if (from_chars_c(string_view(s), r, endpos)) {
+            if (pos)
+                *pos = endpos;
+            return r;
+        }
         char* endptr;
-        double r = Strutil::strtod(s, &endptr);
+        r = Strutil::strtod(s, &endptr);
         if (endptr != s) {
             if (pos)
                 *pos = size_t(endptr - s);
@@ -1841,15 +1940,23 @@ Strutil::stod(const char* s, size_t* pos)
 double
 Strutil::stod(const std::string& s, size_t* pos)
 {
-    return Strutil::stod(s.c_str(), pos);
+    return Strutil::stod(string_view(s), pos);
 }
 
 
 double
 Strutil::stod(string_view s, size_t* pos)
 {
-    // string_view can't be counted on to end with a terminating null, so
-    // for safety, create a temporary string. This looks wasteful, but it's
+    double r;
+    size_t endpos;
+    if (from_chars_c(s, r, endpos)) {
+        if (pos)
+            *pos = endpos;
+        return r;
+    }
+    // For what from_chars doesn't handle, strtod is needed. But string_view
+    // can't be counted on to end with a terminating null, so for safety,
+    // create a temporary string. This looks wasteful, but it's
     // not as bad as you think -- fully compliant C++ >= 11 implementations
     // will use the "short string optimization", meaning that this string
     // creation will NOT need an allocation/free for most strings we expect
@@ -960,6 +960,26 @@ test_numeric_conversion()
     // stress case!
     OIIO_CHECK_EQUAL (Strutil::stof("100000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000001E-200"), 1.0f);
     OIIO_CHECK_EQUAL (Strutil::stof("0.00000000000000000001"), 1.0e-20f);
+    // Cases that follow strtod rather than std::from_chars
+    OIIO_CHECK_EQUAL(Strutil::stof("+1.5", &pos), 1.5f);
+    OIIO_CHECK_EQUAL(pos, 4);
+    OIIO_CHECK_EQUAL(Strutil::stof("+-1.5", &pos), 0.0f);
+    OIIO_CHECK_EQUAL(pos, 0);
+    OIIO_CHECK_EQUAL(Strutil::stof("0x10", &pos), 16.0f);
+    OIIO_CHECK_EQUAL(pos, 4);
+    OIIO_CHECK_EQUAL(Strutil::stof("-0x1p1"), -2.0f);
+    OIIO_CHECK_EQUAL(Strutil::stof("1e400"),
+                     std::numeric_limits<float>::infinity());
+    OIIO_CHECK_EQUAL(Strutil::stod("-1e400"),
+                     -std::numeric_limits<double>::infinity());
+    OIIO_CHECK_EQUAL(Strutil::stof("inf"),
+                     std::numeric_limits<float>::infinity());
+    OIIO_CHECK_ASSERT(std::isnan(Strutil::stof("nan")));
+    // A string_view needn't be null-terminated
+    OIIO_CHECK_EQUAL(Strutil::stof(string_view("1.2345", 3), &pos), 1.2f);
+    OIIO_CHECK_EQUAL(pos, 3);
+    OIIO_CHECK_EQUAL(Strutil::stod(string_view(" 8.5e12", 6), &pos), 85.0);
+    OIIO_CHECK_EQUAL(pos, 6);
 
     OIIO_CHECK_EQUAL(Strutil::strtod("314.25"), 314.25);
     OIIO_CHECK_EQUAL(Strutil::strtod("hi"), 0.0);
@@ -1389,6 +1409,26 @@ void test_parse ()
                           && xyz[0] == 1 && xyz[1] == 2.5 && xyz[2] == 3
                           && sv == ", 4, 5,6");
     }
+    {
+        string_view sv;
+        int ivals[4]   = { 0, 0, 0, 0 };
+        float fvals[4] = { 0, 0, 0, 0 };
+        sv = " 1 2\n 3 # 4";
+        OIIO_CHECK_EQUAL(parse_numbers(sv, ivals), 3);
+        OIIO_CHECK_ASSERT(ivals[0] == 1 && ivals[1] == 2 && ivals[2] == 3
+                          && sv == " # 4");
+        sv = "1 2 3 4 5";
+        OIIO_CHECK_EQUAL(parse_numbers(sv, ivals, false), 4);
+        OIIO_CHECK_EQUAL(sv, "1 2 3 4 5");
+        OIIO_CHECK_EQUAL(parse_numbers(sv, ivals), 4);
+        OIIO_CHECK_EQUAL(sv, " 5");
+        sv = "0.5 -1e3\t2.25 x";
+        OIIO_CHECK_EQUAL(parse_numbers(sv, fvals), 3);
+        OIIO_CHECK_ASSERT(fvals[0] == 0.5f && fvals[1] == -1000.0f
+                          && fvals[2] == 2.25f && sv == " x");
+        sv = "";
+        OIIO_CHECK_EQUAL(parse_numbers(sv, fvals), 0);
+    }
 
     string_view ss;
     s = "foo bar";
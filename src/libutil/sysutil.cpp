@@ -6,6 +6,7 @@
 #    define _POSIX_C_SOURCE 1  // for localtime_r
 #endif
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -15,6 +16,7 @@
 #include <signal.h>
 #include <string>
 #include <thread>
+#include <vector>
 
 #ifdef __linux__
 #    include <sys/ioctl.h>
@@ -216,6 +218,47 @@ Sysutil::physical_memory()
 
 
 
+size_t
+Sysutil::l2_cache_size()
+{
+    static size_t l2size = []() -> size_t {
+        size_t size = 0;
+#if defined(__linux__)
+#    ifdef _SC_LEVEL2_CACHE_SIZE
+        long n = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        if (n > 0)
+            size = size_t(n);
+#    endif
+        if (!size) {
+            // e.g. "1024K"
+            std::string s;
+            if (Filesystem::read_text_file(
+                    "/sys/devices/system/cpu/cpu0/cache/index2/size", s))
+                size = 1024 * Strutil::stoui(s);
+        }
+#elif defined(__APPLE__)
+        int64_t n     = 0;
+        size_t length = sizeof(n);
+        if (sysctlbyname("hw.l2cachesize", &n, &length, NULL, 0) == 0
+            && n > 0)
+            size = size_t(n);
+#elif defined(_WIN32)
+        DWORD length = 0;
+        GetLogicalProcessorInformation(nullptr, &length);
+        std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(
+            length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+        if (info.size() && GetLogicalProcessorInformation(info.data(), &length))
+            for (auto& i : info)
+                if (i.Relationship == RelationCache && i.Cache.Level == 2)
+                    size = std::max(size, size_t(i.Cache.Size));
+#endif
+        return size ? size : size_t(512 * 1024);
+    }();
+    return l2size;
+}
+
+
+
 void
 Sysutil::get_local_time(const time_t* time, struct tm* converted_time)
 {
@@ -18,11 +18,17 @@
 #    define _ENABLE_ATOMIC_ALIGNMENT_FIX /* Avoid MSVS error, ugh */
 #endif
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
 #include <exception>
 #include <functional>
 #include <future>
+#include <iterator>
 #include <memory>
 
+#include <OpenImageIO/metrics.h>
 #include <OpenImageIO/parallel.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
@@ -39,46 +45,71 @@
 #    include <windows.h>
 #endif
 
+#ifdef __linux__
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
 
-#include <queue>
+#include <deque>
 
 OIIO_NAMESPACE_BEGIN
 namespace pvt {
 
-template<typename T> class ThreadsafeQueue {
+// A task waiting in a thread_pool queue, tagged with the frame -- the
+// task_set -- that it was pushed for.
+struct PoolTask {
+    std::function<void(int id)>* f = nullptr;
+    uint64_t frame                 = 0;
+};
+
+// A spin-locked double-ended queue of tasks. The pool's global queues (one
+// per priority) are run FIFO. Each worker thread has one, too, for the
+// Normal priority tasks it pushes itself: it runs them newest first, while
+// idle threads steal the oldest.
+class TaskDeque {
 public:
-    ThreadsafeQueue(int /*size*/) {}
-    bool push(T const& value)
+    void push_back(const PoolTask& t)
     {
-        std::unique_lock<Mutex> lock(this->mutex);
-        this->q.push(value);
-        return true;
+        spin_lock lock(m_mutex);
+        m_queue.push_back(t);
     }
-    // deletes the retrieved element, do not use for non integral types
-    bool pop(T& v)
+    bool pop_front(PoolTask& t)
     {
-        std::unique_lock<Mutex> lock(this->mutex);
-        if (this->q.empty())
+        spin_lock lock(m_mutex);
+        if (m_queue.empty())
             return false;
-        v = this->q.front();
-        this->q.pop();
+        t = m_queue.front();
+        m_queue.pop_front();
         return true;
     }
-    bool empty()
+    bool pop_back(PoolTask& t)
     {
-        std::unique_lock<Mutex> lock(this->mutex);
-        return this->q.empty();
+        spin_lock lock(m_mutex);
+        if (m_queue.empty())
+            return false;
+        t = m_queue.back();
+        m_queue.pop_back();
+        return true;
     }
-    size_t size()
+    // Pop the newest task that was pushed for the given frame.
+    bool pop_frame(PoolTask& t, uint64_t frame)
     {
-        std::unique_lock<Mutex> lock(this->mutex);
-        return q.size();
+        spin_lock lock(m_mutex);
+        for (auto i = m_queue.rbegin(); i != m_queue.rend(); ++i) {
+            if (i->frame == frame) {
+                t = *i;
+                m_queue.erase(std::next(i).base());
+                return true;
+            }
+        }
+        return false;
     }
 
 private:
-    typedef OIIO::spin_mutex Mutex;
-    std::queue<T> q;
-    Mutex mutex;
+    std::deque<PoolTask> m_queue;
+    spin_mutex m_mutex;
 };
 
 }  // namespace pvt
@@ -105,10 +136,30 @@ threads_default()
 
 
 
+namespace {
+
+// What the calling thread is doing with thread pools: which pool (if any)
+// it's a worker of, the task_set whose tasks it's pushing, and how many
+// pool tasks it's in the middle of running.
+struct PoolThreadState {
+    const void* pool = nullptr;
+    int index        = -1;
+    uint64_t frame   = 0;
+    int running      = 0;
+    unsigned steal   = 0;  // Where to start looking for a task to steal
+};
+
+thread_local PoolThreadState pool_thread_state;
+
+std::atomic<uint64_t> next_frame(1);
+
+}  // namespace
+
+
+
 class thread_pool::Impl {
 public:
-    Impl(int nThreads = 0, int queueSize = 1024)
-        : q(queueSize)
+    Impl(int nThreads = 0, int /*queueSize*/ = 1024)
     {
         this->init();
         this->resize(nThreads);
@@ -142,6 +193,11 @@ public:
                 <= nThreads) {  // if the number of threads is increased
                 this->threads.resize(nThreads);
                 this->flags.resize(nThreads);
+                {
+                    spin_rw_write_lock lock(m_local_mutex);
+                    for (int i = oldNThreads; i < nThreads; ++i)
+                        m_local.emplace_back(new pvt::TaskDeque);
+                }
                 for (int i = oldNThreads; i < nThreads; ++i) {
                     this->flags[i] = std::make_shared<std::atomic<bool>>(false);
                     this->set_thread(i);
@@ -167,30 +223,36 @@ public:
                     nThreads);  // safe to delete because the threads are detached
                 this->flags.resize(
                     nThreads);  // safe to delete because the threads have copies of shared_ptr of the flags, not originals
+                // Whatever the finished threads left in their own queues
+                // goes to the global queue, for the others to run.
+                spin_rw_write_lock lock(m_local_mutex);
+                pvt::PoolTask t;
+                for (int i = nThreads; i < oldNThreads; ++i)
+                    while (m_local[i]->pop_front(t))
+                        global(Priority::Normal).push_back(t);
+                m_local.resize(nThreads);
             }
         }
         m_size = nThreads;
     }
 
-    // empty the queue
+    // empty the queues
     void clear_queue()
     {
-        std::function<void(int id)>* _f;
-        while (this->q.pop(_f))
-            delete _f;  // empty the queue
-    }
-
-    // pops a functional wrapper to the original function
-    std::function<void(int)> pop()
-    {
-        std::function<void(int id)>* _f = nullptr;
-        this->q.pop(_f);
-        std::unique_ptr<std::function<void(int id)>> func(
-            _f);  // at return, delete the function even if an exception occurred
-        std::function<void(int)> f;
-        if (_f)
-            f = *_f;
-        return f;
+        pvt::PoolTask t;
+        spin_rw_read_lock lock(m_local_mutex);
+        for (auto& q : m_global) {
+            while (q.pop_front(t)) {
+                --m_njobs;
+                delete t.f;
+            }
+        }
+        for (auto& local : m_local) {
+            while (local->pop_front(t)) {
+                --m_njobs;
+                delete t.f;
+            }
+        }
     }
 
 
@@ -246,30 +308,64 @@ public:
         this->flags.clear();
     }
 
-    void push_queue_and_notify(std::function<void(int id)>* f)
+    // A worker thread of this pool pushes a Normal priority task onto its
+    // own queue, where it (or an idle thread that steals it) will get to it
+    // before anything else of Normal priority. Any other task goes onto the
+    // global queue for its priority.
+    void push_queue_and_notify(std::function<void(int id)>* f,
+                               Priority priority)
     {
-        this->q.push(f);
+        PoolThreadState& state(pool_thread_state);
+        pvt::PoolTask t { f, state.frame };
+        ++m_njobs;
+        if (state.pool == this && priority == Priority::Normal) {
+            spin_rw_read_lock lock(m_local_mutex);
+            m_local[state.index]->push_back(t);
+        } else {
+            global(priority).push_back(t);
+        }
         std::unique_lock<std::mutex> lock(this->mutex);
         this->cv.notify_one();
     }
 
-    // If any tasks are on the queue, pop and run one with the calling
+    // If any tasks are on the queues, pop and run one with the calling
     // thread.
     bool run_one_task(std::thread::id id)
     {
-        std::function<void(int)>* f = nullptr;
-        bool isPop                  = this->q.pop(f);
-        if (isPop) {
-            OIIO_DASSERT(f);
-            std::unique_ptr<std::function<void(int id)>> func(
-                f);  // at return, delete the function even if an exception occurred
-            register_worker(id);
-            (*f)(-1);
-            deregister_worker(id);
-        } else {
-            OIIO_DASSERT(f == nullptr);
+        pvt::PoolTask t;
+        if (!pop_task(t, my_index()))
+            return false;
+        register_worker(id);
+        run_task(t, my_index());
+        deregister_worker(id);
+        return true;
+    }
+
+    // If any tasks that were pushed for the given frame are still on the
+    // calling thread's queue or the global ones, pop and run one with the
+    // calling thread.
+    bool run_frame_task(uint64_t frame)
+    {
+        if (m_njobs.load(std::memory_order_relaxed) <= 0)
+            return false;
+        pvt::PoolTask t;
+        bool found;
+        {
+            spin_rw_read_lock lock(m_local_mutex);
+            int index = my_index();
+            if (index >= 0)
+                found = m_local[index]->pop_frame(t, frame);
+            for (int p = int(Priority::High); p >= 0 && !found; --p)
+                found = m_global[p].pop_frame(t, frame);
         }
-        return isPop;
+        if (!found)
+            return false;
+        --m_njobs;
+        std::thread::id id = std::this_thread::get_id();
+        register_worker(id);
+        run_task(t, my_index());
+        deregister_worker(id);
+        return true;
     }
 
     void register_worker(std::thread::id id)
@@ -288,7 +384,7 @@ public:
         return m_worker_threadids[id] != 0;
     }
 
-    size_t jobs_in_queue() const { return q.size(); }
+    size_t jobs_in_queue() const { return size_t(std::max(0, int(m_njobs))); }
 
     bool very_busy() const { return jobs_in_queue() > size_t(4 * m_size); }
 
@@ -298,37 +394,97 @@ private:
     Impl& operator=(const Impl&) = delete;
     Impl& operator=(Impl&&)      = delete;
 
+    // Index of the calling thread among this pool's workers, or -1.
+    int my_index() const
+    {
+        return pool_thread_state.pool == this ? pool_thread_state.index : -1;
+    }
+
+    // Pop a task for the thread with the given worker index (-1 if it is
+    // not one of ours): the oldest High priority task, else the newest on
+    // its own queue, else the oldest Normal priority one on the global
+    // queue, else the oldest on some other worker's queue, else the oldest
+    // Low priority task.
+    bool pop_task(pvt::PoolTask& t, int index)
+    {
+        if (m_njobs.load(std::memory_order_relaxed) <= 0)
+            return false;
+        bool found = false;
+        {
+            spin_rw_read_lock lock(m_local_mutex);
+            found = global(Priority::High).pop_front(t);
+            if (!found && index >= 0)
+                found = m_local[index]->pop_back(t);
+            if (!found)
+                found = global(Priority::Normal).pop_front(t);
+            unsigned n     = unsigned(m_local.size());
+            unsigned start = n ? pool_thread_state.steal++ % n : 0;
+            for (unsigned k = 0; k < n && !found; ++k) {
+                unsigned v = (start + k) % n;
+                if (int(v) != index)
+                    found = m_local[v]->pop_front(t);
+            }
+            if (!found)
+                found = global(Priority::Low).pop_front(t);
+        }
+        if (found)
+            --m_njobs;
+        return found;
+    }
+
+    // Run a popped task, as worker index id (-1 if not one of ours), in a
+    // frame of its own.
+    static void run_task(const pvt::PoolTask& t, int id)
+    {
+        // at return, delete the function even if an exception occurred
+        std::unique_ptr<std::function<void(int id)>> func(t.f);
+        struct TaskScope {
+            TaskScope(PoolThreadState& state)
+                : state(state)
+                , frame(state.frame)
+            {
+                state.frame = 0;
+                ++state.running;
+            }
+            ~TaskScope()
+            {
+                --state.running;
+                state.frame = frame;
+            }
+            PoolThreadState& state;
+            uint64_t frame;
+        } scope(pool_thread_state);
+        (*t.f)(id);
+    }
+
     void set_thread(int i)
     {
         std::shared_ptr<std::atomic<bool>> flag(
             this->flags[i]);  // a copy of the shared ptr to the flag
         auto f = [this, i, flag /* a copy of the shared ptr to the flag */]() {
             register_worker(std::this_thread::get_id());
+            pool_thread_state.pool  = this;
+            pool_thread_state.index = i;
+            pool_thread_state.steal = unsigned(i + 1);
             std::atomic<bool>& _flag = *flag;
-            std::function<void(int id)>* _f;
-            bool isPop = this->q.pop(_f);
+            pvt::PoolTask t;
             while (true) {
-                while (isPop) {  // if there is anything in the queue
-                    std::unique_ptr<std::function<void(int id)>> func(
-                        _f);  // at return, delete the function even if an exception occurred
-                    (*_f)(i);
+                while (pop_task(t, i)) {  // if there is anything to run
+                    run_task(t, i);
                     if (_flag) {
                         // the thread is wanted to stop, return even if the queue is not empty yet
                         return;
-                    } else {
-                        isPop = this->q.pop(_f);
                     }
                 }
-                // the queue is empty here, wait for the next command
+                // the queues are empty here, wait for the next command
                 std::unique_lock<std::mutex> lock(this->mutex);
                 ++this->nWaiting;
-                this->cv.wait(lock, [this, &_f, &isPop, &_flag]() {
-                    isPop = this->q.pop(_f);
-                    return isPop || this->isDone || _flag;
+                this->cv.wait(lock, [this, &_flag]() {
+                    return m_njobs > 0 || this->isDone || _flag;
                 });
                 --this->nWaiting;
-                if (!isPop)
-                    break;  // if the queue is empty and this->isDone == true or *flag then return
+                if (_flag || (this->isDone && m_njobs <= 0))
+                    break;  // if the queues are empty and this->isDone == true or *flag then return
             }
             deregister_worker(std::this_thread::get_id());
         };
@@ -336,6 +492,11 @@ private:
             new std::thread(f));  // compiler may not support std::make_unique()
     }
 
+    pvt::TaskDeque& global(Priority priority)
+    {
+        return m_global[int(priority)];
+    }
+
     void init()
     {
         this->nWaiting = 0;
@@ -345,7 +506,10 @@ private:
 
     std::vector<std::unique_ptr<std::thread>> threads;
     std::vector<std::shared_ptr<std::atomic<bool>>> flags;
-    mutable pvt::ThreadsafeQueue<std::function<void(int id)>*> q;
+    pvt::TaskDeque m_global[3];  // Per priority, Low to High
+    std::vector<std::unique_ptr<pvt::TaskDeque>> m_local;  // Per worker
+    spin_rw_mutex m_local_mutex;  // Guards m_local itself, when resizing
+    std::atomic<int> m_njobs { 0 };  // Tasks in all the queues
     std::atomic<bool> isDone;
     std::atomic<bool> isStop;
     std::atomic<int> nWaiting;  // how many threads are waiting
@@ -413,10 +577,27 @@ thread_pool::run_one_task(std::thread::id id)
 
 
 
+bool
+thread_pool::run_frame_task(uint64_t frame)
+{
+    return m_impl->run_frame_task(frame);
+}
+
+
+
 void
 thread_pool::push_queue_and_notify(std::function<void(int id)>* f)
 {
-    m_impl->push_queue_and_notify(f);
+    m_impl->push_queue_and_notify(f, Priority::Normal);
+}
+
+
+
+void
+thread_pool::push_queue_and_notify(std::function<void(int id)>* f,
+                                   Priority priority)
+{
+    m_impl->push_queue_and_notify(f, priority);
 }
 
 
@@ -458,6 +639,29 @@ thread_pool::very_busy() const
 
 
 static atomic_int default_thread_pool_created(0);
+static atomic_int io_thread_pool_created(0);
+
+
+
+// Reports the size of a pool and of its queue as metrics, for as long as
+// it exists (being a static made after the pool, and so destroyed first).
+struct PoolMetrics {
+    PoolMetrics(const char* name, thread_pool* pool)
+    {
+        std::string labels = Metrics::label("pool", name);
+        id = Metrics::add_source([=](std::vector<Metrics::Sample>& samples) {
+            samples.push_back({ "oiio_threadpool_queued_jobs",
+                                "Tasks waiting in the thread pool's queue",
+                                labels, double(pool->jobs_in_queue()),
+                                false });
+            samples.push_back({ "oiio_threadpool_threads",
+                                "Worker threads of the thread pool", labels,
+                                double(pool->size()), false });
+        });
+    }
+    ~PoolMetrics() { Metrics::remove_source(id); }
+    int id;
+};
 
 
 
@@ -465,17 +669,75 @@ thread_pool*
 default_thread_pool()
 {
     static std::unique_ptr<thread_pool> shared_pool(new thread_pool);
+    static PoolMetrics metrics("default", shared_pool.get());
     default_thread_pool_created = 1;
     return shared_pool.get();
 }
 
 
 
+thread_pool*
+io_thread_pool()
+{
+    static std::unique_ptr<thread_pool> io_pool([]() {
+        int n = Strutil::from_string<int>(
+            Sysutil::getenv("OPENIMAGEIO_IO_THREADS", "4"));
+        return new thread_pool(std::max(n, 0));
+    }());
+    static PoolMetrics metrics("io", io_pool.get());
+    io_thread_pool_created = 1;
+    return io_pool.get();
+}
+
+
+
 void
 default_thread_pool_shutdown()
 {
     if (default_thread_pool_created)
         default_thread_pool()->resize(0);
+    if (io_thread_pool_created)
+        io_thread_pool()->resize(0);
+}
+
+
+
+task_set::task_set(thread_pool* pool)
+    : m_pool(pool ? pool : default_thread_pool())
+    , m_submitter_thread(std::this_thread::get_id())
+    , m_frame(next_frame++)
+    , m_outer_frame(pool_thread_state.frame)
+{
+    // Tasks pushed by this thread from now on are part of this set.
+    pool_thread_state.frame = m_frame;
+}
+
+
+
+task_set::~task_set()
+{
+    wait();
+    pool_thread_state.frame = m_outer_frame;
+}
+
+
+
+bool
+task_set::nested() const
+{
+    return m_outer_frame != 0 || pool_thread_state.running > 0;
+}
+
+
+
+bool
+task_set::help()
+{
+    // A thread that is already running a pool task, or waiting on an
+    // enclosing task_set, only helps with this set's own tasks. Anything
+    // else might be an outer task that needs a lock it holds.
+    return nested() ? m_pool->run_frame_task(m_frame)
+                    : m_pool->run_one_task(m_submitter_thread);
 }
 
 
@@ -487,7 +749,7 @@ task_set::wait_for_task(size_t taskindex, bool block)
     if (taskindex >= m_futures.size())
         return;  // nothing to wait for
     auto& f(m_futures[taskindex]);
-    if (block || m_pool->is_worker(m_submitter_thread)) {
+    if (block && !nested()) {
         // Block on completion of all the task and don't try to do any
         // of the work with the calling thread.
         f.wait();
@@ -508,7 +770,7 @@ task_set::wait_for_task(size_t taskindex, bool block)
         }
         // Since we're waiting, try to run a task ourselves to help
         // with the load. If none is available, just yield schedule.
-        if (!m_pool->run_one_task(m_submitter_thread)) {
+        if (!help()) {
             // We tried to do a task ourselves, but there weren't any
             // left, so just wait for the rest to finish.
             std::this_thread::yield();
@@ -523,8 +785,8 @@ task_set::wait(bool block)
 {
     OIIO_DASSERT(submitter() == std::this_thread::get_id());
     const std::chrono::milliseconds wait_time(0);
-    if (m_pool->is_worker(m_submitter_thread))
-        block = true;  // don't get into recursive work stealing
+    if (nested())
+        block = false;  // blocking a pool thread could starve the pool
     if (block == false) {
         int tries = 0;
         while (1) {
@@ -544,7 +806,7 @@ task_set::wait(bool block)
             }
             // Since we're waiting, try to run a task ourselves to help
             // with the load. If none is available, just yield schedule.
-            if (!m_pool->run_one_task(m_submitter_thread)) {
+            if (!help()) {
                 // We tried to do a task ourselves, but there weren't any
                 // left, so just wait for the rest to finish.
 #if 1
@@ -576,20 +838,6 @@ task_set::wait(bool block)
 
 
 
-// Helper function to keep track of the recursve depth of our use of the
-// thread pool. Call with the adjustment (i.e., parallel_recursive_depth(1)
-// to enter, parallel_recursive_depth(-1) to exit), and it will return the
-// new value. Call with default args (0) to just return the current depth.
-static int
-parallel_recursive_depth(int change = 0)
-{
-    thread_local int depth = 0;  // let's only allow one level of parallel work
-    depth += change;
-    return depth;
-}
-
-
-
 void
 paropt::resolve()
 {
@@ -597,8 +845,6 @@ paropt::resolve()
         m_pool = default_thread_pool();
     if (m_maxthreads <= 0)
         m_maxthreads = m_pool->size() + 1;  // pool size + caller
-    if (!m_recursive && m_pool->is_worker())
-        m_maxthreads = 1;
 }
 
 
@@ -608,8 +854,6 @@ parallel_for_chunked_id(int64_t begin, int64_t end, int64_t chunksize,
                         std::function<void(int id, int64_t b, int64_t e)>&& task,
                         paropt opt)
 {
-    if (parallel_recursive_depth(1) > 1)
-        opt.maxthreads(1);
     opt.resolve();
     chunksize = std::min(chunksize, end - begin);
     if (chunksize < 1) {           // If caller left chunk size to us...
@@ -634,7 +878,6 @@ parallel_for_chunked_id(int64_t begin, int64_t end, int64_t chunksize,
             ts.push(opt.pool()->push(task, begin, e));
         }
     }
-    parallel_recursive_depth(-1);
 }
 
 
@@ -794,14 +1037,11 @@ parallel_for_chunked_2D_id(
     std::function<void(int id, int64_t, int64_t, int64_t, int64_t)>&& task,
     paropt opt)
 {
-    if (parallel_recursive_depth(1) > 1)
-        opt.maxthreads(1);
     opt.resolve();
     if (opt.singlethread()
         || (xchunksize >= (xend - xbegin) && ychunksize >= (yend - ybegin))
         || opt.pool()->very_busy()) {
         task(-1, xbegin, xend, ybegin, yend);
-        parallel_recursive_depth(-1);
         return;
     }
     if (ychunksize < 1)
@@ -820,7 +1060,6 @@ parallel_for_chunked_2D_id(
             ts.push(opt.pool()->push(task, x, xchunkend, y, ychunkend));
         }
     }
-    parallel_recursive_depth(-1);
 }
 
 
@@ -854,4 +1093,271 @@ parallel_for_2D(int64_t xbegin, int64_t xend, int64_t ybegin, int64_t yend,
 }
 
 
+
+int64_t
+parallel_tile_size(size_t itembytes)
+{
+    double items = double(Sysutil::l2_cache_size())
+                   / (4.0 * double(std::max(itembytes, size_t(1))));
+    int64_t size = int64_t(std::sqrt(items)) & ~int64_t(15);
+    return std::min(std::max(size, int64_t(16)), int64_t(512));
+}
+
+
+
+// Spread the low 32 bits of x out into the even bits of the result.
+static inline uint64_t
+morton_spread(uint64_t x)
+{
+    x &= 0xffffffff;
+    x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+    x = (x | (x << 8)) & 0x00ff00ff00ff00ffULL;
+    x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+}
+
+// The inverse of morton_spread: gather the even bits of x.
+static inline uint64_t
+morton_compact(uint64_t x)
+{
+    x &= 0x5555555555555555ULL;
+    x = (x | (x >> 1)) & 0x3333333333333333ULL;
+    x = (x | (x >> 2)) & 0x0f0f0f0f0f0f0f0fULL;
+    x = (x | (x >> 4)) & 0x00ff00ff00ff00ffULL;
+    x = (x | (x >> 8)) & 0x0000ffff0000ffffULL;
+    x = (x | (x >> 16)) & 0x00000000ffffffffULL;
+    return x;
+}
+
+
+
+void
+parallel_for_tiled_2D(
+    int64_t xbegin, int64_t xend, int64_t ybegin, int64_t yend,
+    int64_t tilesize,
+    function_view<void(int64_t, int64_t, int64_t, int64_t)> task, paropt opt)
+{
+    opt.resolve();
+    if (tilesize < 1)
+        tilesize = parallel_tile_size(4);
+    const int64_t nx = (xend - xbegin + tilesize - 1) / tilesize;
+    const int64_t ny = (yend - ybegin + tilesize - 1) / tilesize;
+    if (nx < 1 || ny < 1)
+        return;
+
+    // The tiles, as the Morton codes of their (x,y) tile coordinates, in
+    // the order they'll be taken.
+    std::vector<uint64_t> tiles;
+    tiles.reserve(size_t(nx * ny));
+    for (int64_t ty = 0; ty < ny; ++ty)
+        for (int64_t tx = 0; tx < nx; ++tx)
+            tiles.push_back(morton_spread(uint64_t(tx))
+                            | (morton_spread(uint64_t(ty)) << 1));
+    std::sort(tiles.begin(), tiles.end());
+
+    std::atomic<int64_t> next(0);
+    const int64_t ntiles = int64_t(tiles.size());
+    auto take_tiles      = [&](int64_t /*worker*/) {
+        for (int64_t i; (i = next++) < ntiles;) {
+            int64_t x = xbegin + int64_t(morton_compact(tiles[i])) * tilesize;
+            int64_t y = ybegin
+                        + int64_t(morton_compact(tiles[i] >> 1)) * tilesize;
+            task(x, std::min(x + tilesize, xend), y,
+                 std::min(y + tilesize, yend));
+        }
+    };
+    int64_t nworkers = std::min(int64_t(opt.maxthreads()), ntiles);
+    if (nworkers <= 1 || opt.pool()->very_busy())
+        take_tiles(0);
+    else
+        parallel_for(int64_t(0), nworkers, take_tiles, opt.minitems(1));
+}
+
+
+
+
+namespace {
+// How many times a contended adaptive lock is retried, with increasing
+// pauses, before the thread goes to sleep waiting for it.
+static const int adaptive_spins = 16;
+
+static std::atomic<long long> adaptive_contended(0);
+static std::atomic<long long> adaptive_parked(0);
+
+inline void
+adaptive_pause(int spins) noexcept
+{
+    pause(1 << std::min(spins, 5));
+}
+
+#if !defined(__linux__) && !defined(_WIN32) && !defined(__cpp_lib_atomic_wait)
+// Without a way to wait on an address, waiters sleep on one of a table of
+// condition variables, chosen by the address.
+struct ParkingBucket {
+    OIIO_CACHE_ALIGN std::mutex mutex;
+    std::condition_variable cv;
+};
+static ParkingBucket parking_lot[64];
+
+inline ParkingBucket&
+parking_bucket(const void* addr)
+{
+    return parking_lot[(uintptr_t(addr) >> 4) % std::size(parking_lot)];
+}
+#endif
+}  // namespace
+
+
+
+void
+atomic_wait(std::atomic<int>& word, int expected) noexcept
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAIT_PRIVATE,
+            expected, nullptr, nullptr, 0);
+#elif defined(_WIN32)
+    WaitOnAddress(&word, &expected, sizeof(int), INFINITE);
+#elif defined(__cpp_lib_atomic_wait)
+    word.wait(expected, std::memory_order_relaxed);
+#else
+    ParkingBucket& bucket(parking_bucket(&word));
+    std::unique_lock<std::mutex> lock(bucket.mutex);
+    if (word.load(std::memory_order_relaxed) == expected)
+        bucket.cv.wait(lock);
+#endif
+}
+
+
+
+void
+atomic_wake(std::atomic<int>& word, bool all) noexcept
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAKE_PRIVATE,
+            all ? INT_MAX : 1, nullptr, nullptr, 0);
+#elif defined(_WIN32)
+    if (all)
+        WakeByAddressAll(&word);
+    else
+        WakeByAddressSingle(&word);
+#elif defined(__cpp_lib_atomic_wait)
+    if (all)
+        word.notify_all();
+    else
+        word.notify_one();
+#else
+    // Taking the bucket's lock orders this after any waiter's check of the
+    // word. The bucket is shared with other words, so wake them all.
+    ParkingBucket& bucket(parking_bucket(&word));
+    {
+        std::lock_guard<std::mutex> lock(bucket.mutex);
+    }
+    bucket.cv.notify_all();
+#endif
+}
+
+
+
+void
+adaptive_mutex_stats(long long& contended, long long& parked,
+                     bool reset) noexcept
+{
+    if (reset) {
+        contended = adaptive_contended.exchange(0);
+        parked    = adaptive_parked.exchange(0);
+    } else {
+        contended = adaptive_contended.load();
+        parked    = adaptive_parked.load();
+    }
+}
+
+
+
+void
+adaptive_mutex::lock_contended() noexcept
+{
+    adaptive_contended.fetch_add(1, std::memory_order_relaxed);
+    // Spin briefly, in case the holder is about to release it.
+    for (int spins = 0; spins < adaptive_spins; ++spins) {
+        adaptive_pause(spins);
+        int expected = UNLOCKED;
+        if (m_state.load(std::memory_order_relaxed) == UNLOCKED
+            && m_state.compare_exchange_weak(expected, LOCKED,
+                                             std::memory_order_acquire))
+            return;
+    }
+    // Then sleep. Whoever takes the lock this way marks it as having
+    // sleepers, since it can't know whether there are others.
+    while (m_state.exchange(SLEEPERS, std::memory_order_acquire) != UNLOCKED) {
+        adaptive_parked.fetch_add(1, std::memory_order_relaxed);
+        atomic_wait(m_state, SLEEPERS);
+    }
+}
+
+
+
+void
+adaptive_rw_mutex::read_lock_contended() noexcept
+{
+    adaptive_contended.fetch_add(1, std::memory_order_relaxed);
+    // Back out the reader count we added, exactly as read_unlock would
+    // (the writer may be gone by now, leaving us as the "last reader").
+    read_unlock();
+    for (int spins = 0;; ++spins) {
+        int bits = m_bits.load(std::memory_order_relaxed);
+        if (!(bits & WRITER)) {
+            if (m_bits.compare_exchange_weak(bits, bits + 1,
+                                             std::memory_order_acquire))
+                return;
+        } else if (spins < adaptive_spins) {
+            adaptive_pause(spins);
+        } else if ((bits & SLEEPERS)
+                   || m_bits.compare_exchange_weak(
+                       bits, bits | SLEEPERS, std::memory_order_relaxed)) {
+            // Sleep until the writer, seeing SLEEPERS, wakes us.
+            adaptive_parked.fetch_add(1, std::memory_order_relaxed);
+            atomic_wait(m_bits, bits | SLEEPERS);
+        }
+    }
+}
+
+
+
+void
+adaptive_rw_mutex::write_lock_contended() noexcept
+{
+    adaptive_contended.fetch_add(1, std::memory_order_relaxed);
+    for (int spins = 0;; ++spins) {
+        int bits = m_bits.load(std::memory_order_relaxed);
+        if (!(bits & (WRITER | READERS))) {
+            // Keep SLEEPERS, so that our write_unlock wakes the others.
+            if (m_bits.compare_exchange_weak(bits, bits | WRITER,
+                                             std::memory_order_acquire))
+                return;
+        } else if (spins < adaptive_spins) {
+            adaptive_pause(spins);
+        } else if ((bits & SLEEPERS)
+                   || m_bits.compare_exchange_weak(
+                       bits, bits | SLEEPERS, std::memory_order_relaxed)) {
+            // Sleep until the last reader, or the writer, wakes us.
+            adaptive_parked.fetch_add(1, std::memory_order_relaxed);
+            atomic_wait(m_bits, bits | SLEEPERS);
+        }
+    }
+}
+
+
+
+void
+adaptive_rw_mutex::wake_sleepers() noexcept
+{
+    // Wake everybody: any readers can all proceed together, and those that
+    // still can't have the lock will mark it again before they sleep.
+    m_bits.fetch_and(~SLEEPERS, std::memory_order_relaxed);
+    atomic_wake(m_bits, true);
+}
+
+
 OIIO_NAMESPACE_END
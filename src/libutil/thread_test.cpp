@@ -135,6 +135,43 @@ time_thread_pool()
 
 
 
+static void
+test_priorities()
+{
+    print("\nTesting task priorities\n");
+    // One thread, kept busy while tasks of each priority are queued
+    thread_pool pool(1);
+    std::atomic<bool> release(false);
+    auto busy = pool.push([&](int /*id*/) {
+        while (!release)
+            std::this_thread::yield();
+    });
+    spin_mutex mutex;
+    std::string order;
+    auto record = [&](char c) {
+        return [&, c](int /*id*/) {
+            spin_lock lock(mutex);
+            order += c;
+        };
+    };
+    task_set tasks(&pool);
+    tasks.push(pool.push(thread_pool::Priority::Low, record('L')));
+    tasks.push(pool.push(record('N')));
+    tasks.push(pool.push(thread_pool::Priority::High, record('H')));
+    tasks.push(pool.push(thread_pool::Priority::Normal, record('n')));
+    release = true;
+    busy.wait();
+    tasks.wait(true);
+    OIIO_CHECK_EQUAL(order, "HNnL");
+
+    // The I/O pool is separate from the default one
+    OIIO_CHECK_ASSERT(io_thread_pool() != default_thread_pool());
+    OIIO_CHECK_EQUAL(io_thread_pool()->push([](int) { return 42; }).get(),
+                     42);
+}
+
+
+
 int
 main(int argc, char** argv)
 {
@@ -152,6 +189,7 @@ main(int argc, char** argv)
 
     time_thread_group();
     time_thread_pool();
+    test_priorities();
 
     return unit_test_failures;
 }
@@ -0,0 +1,197 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/tracing.h>
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace Tracing {
+
+std::atomic<bool> pvt::recording(false);
+
+namespace {
+
+struct Event {
+    std::string name, detail;
+    int64_t begin, end;
+};
+
+// Each thread records to its own buffer, so that threads don't contend
+// with each other. The buffer's mutex is only ever contended when the
+// trace is being written or cleared.
+struct ThreadBuffer {
+    std::mutex mutex;
+    std::vector<Event> events;
+    int tid;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::chrono::steady_clock::time_point epoch
+        = std::chrono::steady_clock::now();
+};
+
+Registry&
+registry()
+{
+    static Registry r;
+    return r;
+}
+
+ThreadBuffer&
+thread_buffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer = []() {
+        auto b = std::make_shared<ThreadBuffer>();
+        Registry& r(registry());
+        std::lock_guard<std::mutex> lock(r.mutex);
+        b->tid = int(r.buffers.size()) + 1;
+        r.buffers.push_back(b);
+        return b;
+    }();
+    return *buffer;
+}
+
+
+
+// Quote s as a JSON string.
+std::string
+json_string(string_view s)
+{
+    std::string r = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            r += '\\';
+        if ((unsigned char)c < 0x20)
+            r += Strutil::fmt::format("\\u{:04x}", int(c));
+        else
+            r += c;
+    }
+    return r + "\"";
+}
+
+}  // namespace
+
+
+
+int64_t
+now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - registry().epoch)
+        .count();
+}
+
+
+
+void
+start()
+{
+    Registry& r(registry());
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto& b : r.buffers) {
+        std::lock_guard<std::mutex> block(b->mutex);
+        b->events.clear();
+    }
+    pvt::recording = true;
+}
+
+
+
+void
+stop()
+{
+    pvt::recording = false;
+}
+
+
+
+void
+record(string_view name, string_view detail, int64_t begin, int64_t end)
+{
+    ThreadBuffer& b(thread_buffer());
+    std::lock_guard<std::mutex> lock(b.mutex);
+    b.events.push_back({ name, detail, begin, end });
+}
+
+
+
+std::string
+trace_json()
+{
+    std::string out = "{\"traceEvents\":[\n";
+    bool first      = true;
+    Registry& r(registry());
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto& b : r.buffers) {
+        std::lock_guard<std::mutex> block(b->mutex);
+        for (auto& e : b->events) {
+            if (!first)
+                out += ",\n";
+            first = false;
+            // Times are in microseconds
+            out += Strutil::fmt::format(
+                "{{\"name\":{},\"cat\":\"oiio\",\"ph\":\"X\",\"pid\":1,"
+                "\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}",
+                json_string(e.name), b->tid, e.begin * 1.0e-3,
+                (e.end - e.begin) * 1.0e-3);
+            if (e.detail.size())
+                out += Strutil::fmt::format(",\"args\":{{\"detail\":{}}}",
+                                            json_string(e.detail));
+            out += "}";
+        }
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+
+
+bool
+write(string_view filename)
+{
+    return Filesystem::write_text_file(filename, trace_json());
+}
+
+
+
+namespace {
+
+// If $OPENIMAGEIO_TRACE names a file, record from the start, and write the
+// trace to that file at exit.
+struct TraceFromEnvironment {
+    TraceFromEnvironment()
+        : filename(Sysutil::getenv("OPENIMAGEIO_TRACE"))
+    {
+        if (filename.size())
+            start();
+    }
+    ~TraceFromEnvironment()
+    {
+        if (filename.size()) {
+            stop();
+            write(filename);
+        }
+    }
+    std::string filename;
+};
+
+TraceFromEnvironment trace_from_environment;
+
+}  // namespace
+
+}  // namespace Tracing
+
+OIIO_NAMESPACE_END
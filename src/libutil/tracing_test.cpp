@@ -0,0 +1,88 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <thread>
+#include <vector>
+
+#include <OpenImageIO/benchmark.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/tracing.h>
+#include <OpenImageIO/unittest.h>
+
+using namespace OIIO;
+
+
+
+static void
+test_spans()
+{
+    Strutil::print("Testing spans\n");
+
+    // Nothing is recorded before start()
+    Tracing::stop();
+    {
+        Tracing::Span span("before");
+    }
+    Tracing::start();
+    OIIO_CHECK_ASSERT(Tracing::enabled());
+    {
+        Tracing::Span span("outer", "some \"detail\"");
+        OIIO_TRACE_SPAN("inner");
+    }
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.emplace_back([]() { Tracing::Span span("thread"); });
+    for (auto& t : threads)
+        t.join();
+    Tracing::stop();
+    {
+        Tracing::Span span("after");
+    }
+
+    std::string json = Strutil::trimmed_whitespace(Tracing::trace_json());
+    Strutil::print("{}\n", json);
+    OIIO_CHECK_ASSERT(Strutil::starts_with(json, "{\"traceEvents\":["));
+    OIIO_CHECK_ASSERT(Strutil::ends_with(json, "]}"));
+    OIIO_CHECK_ASSERT(Strutil::contains(json, "\"name\":\"outer\""));
+    OIIO_CHECK_ASSERT(Strutil::contains(json, "\"args\":{\"detail\":"
+                                              "\"some \\\"detail\\\"\"}"));
+    OIIO_CHECK_ASSERT(Strutil::contains(json, "\"name\":\"inner\""));
+    size_t nthreadspans = 0;
+    for (size_t pos = 0;
+         (pos = json.find("\"name\":\"thread\"", pos)) != std::string::npos;
+         ++pos)
+        ++nthreadspans;
+    OIIO_CHECK_EQUAL(nthreadspans, 4);
+    OIIO_CHECK_ASSERT(!Strutil::contains(json, "before"));
+    OIIO_CHECK_ASSERT(!Strutil::contains(json, "after"));
+
+    // start() discards what was recorded before
+    Tracing::start();
+    Tracing::stop();
+    OIIO_CHECK_ASSERT(!Strutil::contains(Tracing::trace_json(), "outer"));
+}
+
+
+
+static void
+benchmark_disabled_spans()
+{
+    Tracing::stop();
+    Benchmarker bench;
+    bench("Span when not recording", []() {
+        Tracing::Span span("nothing");
+        DoNotOptimize(span);
+    });
+}
+
+
+
+int
+main(int /*argc*/, char* /*argv*/[])
+{
+    test_spans();
+    benchmark_disabled_spans();
+    return unit_test_failures;
+}
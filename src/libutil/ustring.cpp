@@ -14,10 +14,9 @@
 
 OIIO_NAMESPACE_BEGIN
 
-// Use rw spin locks
-typedef spin_rw_mutex ustring_mutex_t;
-typedef spin_rw_read_lock ustring_read_lock_t;
-typedef spin_rw_write_lock ustring_write_lock_t;
+// Only the writers lock; readers need no lock at all (see TableRepMap).
+typedef adaptive_mutex ustring_mutex_t;
+typedef adaptive_lock ustring_lock_t;
 
 
 #define PREVENT_HASH_COLLISIONS 1
@@ -32,16 +31,22 @@ template<class T> struct identity {
 // #define USTRING_TRACK_NUM_LOOKUPS
 
 
+// The table is open addressed, and entries are never removed or moved, so
+// lookups need no lock: each slot is written just once, atomically, by an
+// insert (which does lock, against other inserts), and when the table grows
+// the larger copy is published with a single atomic pointer. A lookup that
+// started on the old slots just finishes there; the old slots are never
+// freed, since one may still be reading them, so they cost at most as much
+// memory again as the current ones.
 template<unsigned BASE_CAPACITY, unsigned POOL_SIZE> struct TableRepMap {
     static_assert((BASE_CAPACITY & (BASE_CAPACITY - 1)) == 0,
                   "BASE_CAPACITY must be a power of 2");
 
     TableRepMap()
-        : entries(static_cast<ustring::TableRep**>(
-            calloc(BASE_CAPACITY, sizeof(ustring::TableRep*))))
+        : slots(new Slots(BASE_CAPACITY - 1))
         , pool(static_cast<char*>(malloc(POOL_SIZE)))
-        , memory_usage(sizeof(*this) + POOL_SIZE
-                       + sizeof(ustring::TableRep*) * BASE_CAPACITY)
+        , memory_usage(sizeof(*this) + POOL_SIZE + sizeof(Slots)
+                       + sizeof(Slot) * BASE_CAPACITY)
     {
     }
 
@@ -51,27 +56,26 @@ template<unsigned BASE_CAPACITY, unsigned POOL_SIZE> struct TableRepMap {
 
     size_t get_memory_usage()
     {
-        ustring_read_lock_t lock(mutex);
+        ustring_lock_t lock(mutex);
         return memory_usage;
     }
 
     size_t get_num_entries()
     {
-        ustring_read_lock_t lock(mutex);
+        ustring_lock_t lock(mutex);
         return num_entries;
     }
 
 #ifdef USTRING_TRACK_NUM_LOOKUPS
     size_t get_num_lookups()
     {
-        ustring_read_lock_t lock(mutex);
+        ustring_lock_t lock(mutex);
         return num_lookups;
     }
 #endif
 
     const char* lookup(string_view str, uint64_t hash)
     {
-        ustring_read_lock_t lock(mutex);
 #ifdef USTRING_TRACK_NUM_LOOKUPS
         // NOTE: this simple increment adds a substantial amount of overhead
         // so keep it off by default, unless the user really wants it
@@ -79,17 +83,18 @@ template<unsigned BASE_CAPACITY, unsigned POOL_SIZE> struct TableRepMap {
         // can skew the number of lookups compared to release builds
         ++num_lookups;
 #endif
-        size_t pos = hash & mask, dist = 0;
+        const Slots* s = slots.load(std::memory_order_acquire);
+        size_t pos = hash & s->mask, dist = 0;
         for (;;) {
-            if (entries[pos] == 0)
+            const ustring::TableRep* e = s->entries[pos].load(
+                std::memory_order_acquire);
+            if (e == 0)
                 return 0;
-            if (entries[pos]->hashed == hash
-                && entries[pos]->length == str.length()
-                && strncmp(entries[pos]->c_str(), str.data(), str.length())
-                       == 0)
-                return entries[pos]->c_str();
+            if (e->hashed == hash && e->length == str.length()
+                && strncmp(e->c_str(), str.data(), str.length()) == 0)
+                return e->c_str();
             ++dist;
-            pos = (pos + dist) & mask;  // quadratic probing
+            pos = (pos + dist) & s->mask;  // quadratic probing
         }
     }
 
@@ -98,7 +103,6 @@ template<unsigned BASE_CAPACITY, unsigned POOL_SIZE> struct TableRepMap {
     // the hash.
     const char* lookup(uint64_t hash)
     {
-        ustring_read_lock_t lock(mutex);
 #ifdef USTRING_TRACK_NUM_LOOKUPS
         // NOTE: this simple increment adds a substantial amount of overhead
         // so keep it off by default, unless the user really wants it
@@ -106,71 +110,91 @@ template<unsigned BASE_CAPACITY, unsigned POOL_SIZE> struct TableRepMap {
         // can skew the number of lookups compared to release builds
         ++num_lookups;
 #endif
-        size_t pos = hash & mask, dist = 0;
+        const Slots* s = slots.load(std::memory_order_acquire);
+        size_t pos = hash & s->mask, dist = 0;
         for (;;) {
-            if (entries[pos] == 0)
+            const ustring::TableRep* e = s->entries[pos].load(
+                std::memory_order_acquire);
+            if (e == 0)
                 return 0;
-            if (entries[pos]->hashed == hash)
-                return entries[pos]->c_str();
+            if (e->hashed == hash)
+                return e->c_str();
             ++dist;
-            pos = (pos + dist) & mask;  // quadratic probing
+            pos = (pos + dist) & s->mask;  // quadratic probing
         }
     }
 
     const char* insert(string_view str, uint64_t hash)
     {
-        ustring_write_lock_t lock(mutex);
-        size_t pos = hash & mask, dist = 0;
+        ustring_lock_t lock(mutex);
+        // Only inserts change the slots, and we hold the lock
+        Slots* s   = slots.load(std::memory_order_relaxed);
+        size_t pos = hash & s->mask, dist = 0;
         for (;;) {
-            if (entries[pos] == 0)
+            ustring::TableRep* e = s->entries[pos].load(
+                std::memory_order_relaxed);
+            if (e == 0)
                 break;  // found insert pos
-            if (entries[pos]->hashed == hash
-                && entries[pos]->length == str.length()
-                && !strncmp(entries[pos]->c_str(), str.data(), str.length())) {
+            if (e->hashed == hash && e->length == str.length()
+                && !strncmp(e->c_str(), str.data(), str.length())) {
                 // same string is already inserted, return the one that is
                 // already in the table
-                return entries[pos]->c_str();
+                return e->c_str();
             }
             ++dist;
-            pos = (pos + dist) & mask;  // quadratic probing
+            pos = (pos + dist) & s->mask;  // quadratic probing
         }
 
         ustring::TableRep* rep = make_rep(str, hash);
-        entries[pos]           = rep;
+        // Release, so that a lookup that sees the entry sees all of it
+        s->entries[pos].store(rep, std::memory_order_release);
         ++num_entries;
-        if (2 * num_entries > mask)
+        if (2 * num_entries > s->mask)
             grow();           // maintain 0.5 load factor
         return rep->c_str();  // rep is now in the table
     }
 
 private:
+    using Slot = std::atomic<ustring::TableRep*>;
+    struct Slots {
+        Slots(size_t mask)
+            : mask(mask)
+            , entries(new Slot[mask + 1]())
+        {
+        }
+        const size_t mask;
+        std::unique_ptr<Slot[]> entries;
+    };
+
     void grow()
     {
-        size_t new_mask = mask * 2 + 1;
+        Slots* old      = slots.load(std::memory_order_relaxed);
+        size_t new_mask = old->mask * 2 + 1;
 
-        // NOTE: only increment by half because we are doubling the entries and freeing the old
-        memory_usage += (mask + 1) * sizeof(ustring::TableRep*);
+        // NOTE: the old slots are not freed (see above)
+        memory_usage += sizeof(Slots) + (new_mask + 1) * sizeof(Slot);
 
-        ustring::TableRep** new_entries = static_cast<ustring::TableRep**>(
-            calloc(new_mask + 1, sizeof(ustring::TableRep*)));
+        Slots* bigger  = new Slots(new_mask);
         size_t to_copy = num_entries;
         for (size_t i = 0; to_copy != 0; i++) {
-            if (entries[i] == 0)
+            ustring::TableRep* e = old->entries[i].load(
+                std::memory_order_relaxed);
+            if (e == 0)
                 continue;
-            size_t pos = entries[i]->hashed & new_mask, dist = 0;
+            size_t pos = e->hashed & new_mask, dist = 0;
             for (;;) {
-                if (new_entries[pos] == 0)
+                if (bigger->entries[pos].load(std::memory_order_relaxed) == 0)
                     break;
                 ++dist;
                 pos = (pos + dist) & new_mask;  // quadratic probing
             }
-            new_entries[pos] = entries[i];
+            bigger->entries[pos].store(e, std::memory_order_relaxed);
             to_copy--;
         }
 
-        free(entries);
-        entries = new_entries;
-        mask    = new_mask;
+        // Release, so that a lookup that sees the new slots sees them
+        // filled in
+        slots.store(bigger, std::memory_order_release);
     }
 
     ustring::TableRep* make_rep(string_view str, uint64_t hash)
@@ -200,9 +224,10 @@ private:
         return result;
     }
 
+    // What lookups read, apart from what inserts write, so that locking
+    // for an insert doesn't disturb the cache line lookups are reading.
+    OIIO_CACHE_ALIGN std::atomic<Slots*> slots;
     OIIO_CACHE_ALIGN mutable ustring_mutex_t mutex;
-    size_t mask = BASE_CAPACITY - 1;
-    ustring::TableRep** entries;
     size_t num_entries = 0;
     char* pool;
     size_t pool_offset = 0;
@@ -311,6 +336,18 @@ reverse_map()
 static std::vector<std::pair<const char*, uint64_t>> all_hash_collisions;
 OIIO_CACHE_ALIGN static std::mutex collision_mutex;
 
+
+// Each thread remembers the ustrings it made most recently, by hash, which
+// saves it searching the table when it keeps making the same few (as when
+// looking up the same attributes by name over and over).
+struct RecentUstring {
+    uint64_t hash;
+    size_t length;
+    const char* chars;
+};
+constexpr size_t num_recent_ustrings = 64;
+thread_local RecentUstring recent_ustrings[num_recent_ustrings];
+
 }  // end anonymous namespace
 
 
@@ -451,17 +488,12 @@ ustring::TableRep::~TableRep()
 
 
 
-const char*
-ustring::make_unique(string_view strref)
+// Find or add strref, whose hash is given, in the table.
+static const char*
+make_unique_hashed(string_view strref, ustring::hash_t hash)
 {
+    using hash_t = ustring::hash_t;
     UstringTable& table(ustring_table());
-    // Eliminate nullptr-referred string views
-    if (!strref.data())
-        strref = string_view("", 0);
-
-    hash_t hash = Strutil::strhash64(strref);
-    // This line, if uncommented, lets you force lots of hash collisions:
-    // hash &= ~hash_t(0xffffff);
 
 #if !PREVENT_HASH_COLLISIONS
     // Check the ustring table to see if this string already exists.  If so,
@@ -570,6 +602,32 @@ ustring::make_unique(string_view strref)
 
 
 
+const char*
+ustring::make_unique(string_view strref)
+{
+    // Eliminate nullptr-referred string views
+    if (!strref.data())
+        strref = string_view("", 0);
+
+    hash_t hash = Strutil::strhash64(strref);
+    // This line, if uncommented, lets you force lots of hash collisions:
+    // hash &= ~hash_t(0xffffff);
+
+    RecentUstring& recent(recent_ustrings[hash % num_recent_ustrings]);
+    if (recent.chars && recent.hash == hash && recent.length == strref.size()
+        && !memcmp(recent.chars, strref.data(), strref.size()))
+        return recent.chars;
+    const char* result = make_unique_hashed(strref, hash);
+    // Remember it, unless it was made from a string with an embedded nul,
+    // which makes it shorter than strref.
+    size_t length = ((const TableRep*)result - 1)->length;
+    if (length == strref.size())
+        recent = { hash, length, result };
+    return result;
+}
+
+
+
 ustring
 ustring::from_hash(hash_t hash)
 {
@@ -4,11 +4,15 @@
 
 #include <cmath>
 #include <cstdio>
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <iostream>
 #include <iterator>
 #include <limits>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #include <OpenImageIO/Imath.h>
 #include <OpenImageIO/argparse.h>
@@ -40,6 +44,14 @@ static std::string outputfilename;
 static bool verbose  = false;
 static bool runstats = false;
 static int nthreads  = 0;  // default: use #cores threads if available
+static int nparallel = 0;  // files at once; default: one per 4 threads
+static std::string manifest;
+
+// For making several textures: the command line without the files or the
+// options that say how to go through them, and how to record it.
+static std::vector<std::string> settings_args;
+static bool metadata_history_on = false;
+static bool sansattrib_on       = false;
 
 // Conversion modes.  If none are true, we just make an ordinary texture.
 static bool mipmapmode     = false;
@@ -145,6 +157,47 @@ command_line_string(int argc, char* argv[], bool sansattrib)
 
 
 
+// Set the command line recorded in the texture's metadata, in full or as
+// its SHA-1 hash. In update mode, a texture is only remade if this differs.
+static void
+set_command_line(ImageSpec& configspec, const std::string& cmdline)
+{
+    std::string software = Strutil::fmt::format(
+        "OpenImageIO {} : {}", OIIO_VERSION_STRING,
+        metadata_history_on ? cmdline : SHA1(cmdline).digest());
+    configspec.attribute("Software", software);
+    configspec.attribute("maketx:full_command_line", software);
+}
+
+
+
+// Read a manifest of textures to make, one per line: the input file and
+// optionally the output file, either of which may be in double quotes.
+// Blank lines and lines starting with '#' are ignored.
+static bool
+read_manifest(const std::string& filename,
+              std::vector<std::pair<std::string, std::string>>& jobs)
+{
+    std::string text;
+    if (!Filesystem::read_text_file(filename, text)) {
+        std::cerr << "maketx ERROR: Could not read manifest \"" << filename
+                  << "\"\n";
+        return false;
+    }
+    for (string_view line : Strutil::splitsv(text, "\n")) {
+        line = Strutil::strip(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+        string_view in, out;
+        Strutil::parse_string(line, in);
+        Strutil::parse_string(line, out);
+        jobs.emplace_back(in, out);
+    }
+    return true;
+}
+
+
+
 static void
 getargs(int argc, char* argv[], ImageSpec& configspec)
 {
@@ -153,7 +206,7 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
     std::string fileformatname = "";
     std::vector<std::string> mipimages;
     int tile[3] = { 64, 64, 1 };  // FIXME if we ever support volume MIPmaps
-    std::string compression = "zip";
+    std::string compression;  // Default depends on the output format
     bool updatemode         = false;
     bool checknan           = false;
     std::string fixnan;  // none, black, box3
@@ -169,10 +222,13 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
     Imath::M44f Mcam(0.0f), Mscr(0.0f), MNDC(0.0f);  // Initialize to 0
     bool separate              = false;
     bool nomipmap              = false;
+    bool stream                = false;
     bool prman_metadata        = false;
     bool constant_color_detect = false;
     bool monochrome_detect     = false;
     bool opaque_detect         = false;
+    bool tile_stats            = false;
+    bool fasthash              = false;
     bool compute_average       = true;
     int nchannels              = -1;
     bool prman                 = false;
@@ -185,6 +241,8 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
     bool cdf                   = false;
     float cdfsigma             = 1.0f / 6;
     int cdfbits                = 8;
+    bool envcdf                = false;
+    int envcdfres              = 512;
 #if OPENIMAGEIO_METADATA_HISTORY_DEFAULT
     bool metadata_history = Strutil::from_string<int>(
         getenv("OPENIMAGEIO_METADATA_HISTORY", "1"));
@@ -218,6 +276,10 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
       .help("Output filename");
     ap.arg("--threads %d:NUMTHREADS", &nthreads)
       .help("Number of threads (default: #cores)");
+    ap.arg("--parallel-files %d:N", &nparallel)
+      .help("With several input files, make up to N textures at once (default: 1 per 4 threads)");
+    ap.arg("--manifest %s:FILENAME", &manifest)
+      .help("Also make the textures listed in this file, each line naming an input and optionally its output");
     ap.arg("-u", &updatemode)
       .help("Update mode");
     ap.arg("--format %s:FILEFORMAT", &fileformatname)
@@ -233,7 +295,8 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
     ap.arg("--separate", &separate)
       .help("Use planarconfig separate (default: contiguous)");
     ap.arg("--compression %s:NAME", &compression)
-      .help("Set the compression method (default = zip, if possible)");
+      .help("Set the compression method (default = zip, if possible, "
+            "or none for otx)");
     ap.arg("--fovcot %f:FOVCAT", &fovcot)
       .help("Override the frame aspect ratio. Default is width/height.");
     ap.arg("--wrap %s:WRAP", &wrap)
@@ -252,6 +315,8 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
       .help("Sharpen MIP levels (default = 0.0 = no)");
     ap.arg("--nomipmap", &nomipmap)
       .help("Do not make multiple MIP-map levels");
+    ap.arg("--stream", &stream)
+      .help("Stream the input in bands rather than reading it whole, for images too big for memory");
     ap.arg("--checknan", &checknan)
       .help("Check for NaN/Inf values (abort if found)");
     ap.arg("--fixnan %s:STRATEGY", &fixnan)
@@ -294,6 +359,10 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
       .help("Create 1-channel textures from monochrome inputs");
     ap.arg("--opaque-detect", &opaque_detect)
       .help("Drop alpha channel that is always 1.0");
+    ap.arg("--tilestats", &tile_stats)
+      .help("Store the min, max, and average of each tile");
+    ap.arg("--fasthash", &fasthash)
+      .help("Fingerprint the pixels with a fast 128-bit hash (oiio:ContentHash) rather than SHA-1");
     ap.arg("--no-compute-average %!", &compute_average)
       .help("Don't compute and store average color");
     ap.arg("--ignore-unassoc", &ignore_unassoc)
@@ -309,6 +378,10 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
       .help("Specify the Gaussian sigma parameter when writing the forward and inverse Gaussian CDF data. The default vale is 1/6 (0.1667)");
     ap.arg("--cdfbits %d:N", &cdfbits)
       .help("Specify the number of bits used to store the forward and inverse Gaussian CDF. The default value is 8 bits");
+    ap.arg("--envcdf", &envcdf)
+      .help("For a latlong environment map, store the tables for importance sampling it as metadata");
+    ap.arg("--envcdfres %d:WIDTH", &envcdfres)
+      .help("Specify the width of the --envcdf tables (default: 512)");
 
     ap.separator("Basic modes (default is plain texture):");
     ap.arg("--shadow", &shadowmode)
@@ -345,7 +418,7 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
 
     // clang-format on
     ap.parse(argc, (const char**)argv);
-    if (filenames.empty()) {
+    if (filenames.empty() && manifest.empty()) {
         ap.briefusage();
         std::cout << "\nFor detailed help: maketx --help\n";
         exit(EXIT_SUCCESS);
@@ -372,8 +445,8 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
         exit(EXIT_FAILURE);
     }
 
-    if (filenames.size() != 1) {
-        std::cerr << "maketx ERROR: requires exactly one input filename\n";
+    if ((filenames.size() != 1 || manifest.size()) && outputfilename.size()) {
+        std::cerr << "maketx ERROR: -o requires exactly one input filename\n";
         exit(EXIT_FAILURE);
     }
 
@@ -406,6 +479,13 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
     configspec.tile_width  = tile[0];
     configspec.tile_height = tile[1];
     configspec.tile_depth  = tile[2];
+    // OTX files are meant to have their tiles mapped in place, which only
+    // uncompressed ones can be.
+    if (compression.empty())
+        compression = Strutil::iequals(fileformatname, "otx")
+                              || Strutil::iends_with(outputfilename, ".otx")
+                          ? "none"
+                          : "zip";
     configspec.attribute("compression", compression);
     if (fovcot != 0.0f)
         configspec.attribute("fovcot", fovcot);
@@ -424,10 +504,14 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
     configspec.attribute("maketx:runstats", runstats);
     configspec.attribute("maketx:resize", doresize);
     configspec.attribute("maketx:nomipmap", nomipmap);
+    configspec.attribute("maketx:stream", stream);
     configspec.attribute("maketx:updatemode", updatemode);
     configspec.attribute("maketx:constant_color_detect", constant_color_detect);
     configspec.attribute("maketx:monochrome_detect", monochrome_detect);
     configspec.attribute("maketx:opaque_detect", opaque_detect);
+    configspec.attribute("maketx:tile_stats", tile_stats);
+    if (fasthash)
+        configspec.attribute("maketx:hashtype", "fast");
     configspec.attribute("maketx:compute_average", compute_average);
     configspec.attribute("maketx:unpremult", unpremult);
     configspec.attribute("maketx:incolorspace", incolorspace);
@@ -457,13 +541,23 @@ getargs(int argc, char* argv[], ImageSpec& configspec)
     configspec.attribute("maketx:cdf", cdf);
     configspec.attribute("maketx:cdfsigma", cdfsigma);
     configspec.attribute("maketx:cdfbits", cdfbits);
+    configspec.attribute("maketx:envcdf", envcdf);
+    configspec.attribute("maketx:envcdfres", envcdfres);
 
-    std::string cmdline = command_line_string(argc, argv, sansattrib);
-    cmdline = Strutil::fmt::format("OpenImageIO {} : {}", OIIO_VERSION_STRING,
-                                   metadata_history ? cmdline
-                                                    : SHA1(cmdline).digest());
-    configspec.attribute("Software", cmdline);
-    configspec.attribute("maketx:full_command_line", cmdline);
+    metadata_history_on = metadata_history;
+    set_command_line(configspec, command_line_string(argc, argv, sansattrib));
+    sansattrib_on       = sansattrib;
+    for (int i = 0; i < argc; ++i) {
+        if (i && (!strcmp(argv[i], "-o") || !strcmp(argv[i], "--manifest")
+                  || !strcmp(argv[i], "--parallel-files"))) {
+            i += 1;  // also skip the following argument
+            continue;
+        }
+        if (i && std::find(filenames.begin(), filenames.end(), argv[i])
+                     != filenames.end())
+            continue;
+        settings_args.emplace_back(argv[i]);
+    }
 
     // Add user-specified string attributes
     for (size_t i = 0; i < string_attrib_names.size(); ++i) {
@@ -542,10 +636,67 @@ main(int argc, char* argv[])
     if (bumpslopesmode)
         mode = ImageBufAlgo::MakeTxBumpWithSlopes;
 
-    bool ok = ImageBufAlgo::make_texture(mode, filenames[0], outputfilename,
-                                         configspec, &std::cout);
-    if (!ok)
-        std::cout << "make_texture ERROR: " << OIIO::geterror() << "\n";
+    // The textures to make: the input files (each written to its default
+    // .tx name, unless there's just one and -o names it), then those of
+    // the manifest.
+    std::vector<std::pair<std::string, std::string>> jobs;
+    for (auto& f : filenames)
+        jobs.emplace_back(f, outputfilename);
+    if (manifest.size() && !read_manifest(manifest, jobs))
+        return EXIT_FAILURE;
+    bool batch = jobs.size() > 1 || manifest.size();
+
+    // Several textures are made concurrently, each on a thread of its own
+    // rather than one of the pool's, so that the operations of all of
+    // them share the thread pool (as they share the ImageCache and color
+    // configurations). Errors are per-thread, so each reports its own.
+    std::atomic<bool> ok(true);
+    std::atomic<size_t> next(0);
+    auto make_textures = [&]() {
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            const std::string& in(jobs[i].first);
+            const std::string& out(jobs[i].second);
+            // Record in each texture the command line that would have
+            // made just that one, so that -u can tell if it's current
+            // however it was made.
+            ImageSpec jobspec;
+            if (batch) {
+                std::vector<std::string> args(settings_args);
+                args.push_back(in);
+                if (out.size()) {
+                    args.emplace_back("-o");
+                    args.push_back(out);
+                }
+                std::vector<char*> argv;
+                for (auto& a : args)
+                    argv.push_back(&a[0]);
+                jobspec = configspec;
+                set_command_line(jobspec,
+                                 command_line_string(int(argv.size()),
+                                                     argv.data(),
+                                                     sansattrib_on));
+            }
+            if (!ImageBufAlgo::make_texture(mode, in, out,
+                                            batch ? jobspec : configspec,
+                                            &std::cout)) {
+                Strutil::sync::print(std::cout, "make_texture ERROR: {}\n",
+                                     OIIO::geterror());
+                ok = false;
+            }
+        }
+    };
+    if (nparallel < 1)
+        nparallel = std::max(1, OIIO::get_int_attribute("threads") / 4);
+    nparallel = std::min(nparallel, int(jobs.size()));
+    if (nparallel > 1) {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < nparallel; ++t)
+            workers.emplace_back(make_textures);
+        for (auto& w : workers)
+            w.join();
+    } else {
+        make_textures();
+    }
     if (runstats)
         std::cout << "\n" << ic->getstats();
 
@@ -10,7 +10,10 @@
 #include "DDImage/Reader.h"
 #include "DDImage/Row.h"
 
+#include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/sysutil.h>
 
 
 using namespace DD::Image;
@@ -20,10 +23,6 @@ using namespace DD::Image;
  * TODO:
  * - Look into using the planar Reader API in Nuke 8, which may map better to
  *      TIFF/OIIO.
- * - It would be nice to have a way to read in a region, rather than the whole
- *      image, but this would require access to the Read's request region,
- *      which isn't currently possible. A feature request for this is logged
- *      with The Foundry as Bug 46237.
  */
 
 
@@ -36,6 +35,24 @@ using namespace OIIO;
 static const char* const EMPTY[] = { NULL };
 
 
+// All the Readers, in all of Nuke's threads, share one ImageCache, which
+// reads just the tiles that the rows asked for need. It's our own rather
+// than the process-wide shared one, so that setting its memory limit
+// (OIIO_TXREADER_CACHE_MB, default 2048) doesn't change anyone else's.
+static ImageCache*
+txCache()
+{
+    static std::shared_ptr<ImageCache> cache = []() {
+        std::shared_ptr<ImageCache> ic = ImageCache::create(false);
+        string_view mb = Sysutil::getenv("OIIO_TXREADER_CACHE_MB");
+        ic->attribute("max_memory_MB",
+                      mb.size() ? Strutil::stof(mb) : 2048.0f);
+        return ic;
+    }();
+    return cache.get();
+}
+
+
 class TxReaderFormat final : public ReaderFormat {
     int mipLevel_;
     int mipEnumIndex_;
@@ -44,7 +61,7 @@ class TxReaderFormat final : public ReaderFormat {
 
 public:
     TxReaderFormat()
-        : mipLevel_(0)
+        : mipLevel_(-1)
         , mipEnumIndex_(0)
         , mipLevelKnob_(NULL)
         , mipLevelEnumKnob_(NULL)
@@ -54,7 +71,8 @@ public:
     void knobs(Knob_Callback cb)
     {
         // The "real" mip level knob that controls the level read by the Reader
-        // class, and whose value is stored when the Read is serialized.
+        // class, and whose value is stored when the Read is serialized. -1
+        // means to choose the level from the proxy scale.
         mipLevelKnob_ = Int_knob(cb, &mipLevel_, "tx_mip_level", "mip index");
         SetFlags(cb, Knob::INVISIBLE);
 
@@ -67,13 +85,16 @@ public:
                          | Knob::NO_RERENDER);
         Tooltip(cb,
                 "The mip level to read from the file. Currently, this will "
-                "be resampled to fill the same resolution as the base image.");
+                "be resampled to fill the same resolution as the base image. "
+                "With \"auto\", the smallest level that is at least the "
+                "proxy resolution is read (the full resolution one when not "
+                "in proxy mode).");
     }
 
     int knob_changed(Knob* k)
     {
         if (k == mipLevelEnumKnob_)
-            mipLevelKnob_->set_value(mipEnumIndex_);
+            mipLevelKnob_->set_value(mipEnumIndex_ - 1);
         return 1;
     }
 
@@ -87,7 +108,7 @@ public:
             mipLevelEnumKnob_->set_flag(Knob::NO_KNOB_CHANGED);
             mipLevelEnumKnob_->enumerationKnob()->menu(items);
             mipLevelEnumKnob_->set_value(
-                std::min((int)items.size() - 1, mipLevel_));
+                std::min((int)items.size() - 1, mipLevel_ + 1));
             mipLevelEnumKnob_->clear_flag(Knob::NO_KNOB_CHANGED);
         }
     }
@@ -97,12 +118,13 @@ public:
 
 
 class txReader final : public Reader {
-    std::unique_ptr<ImageInput> oiioInput_;
+    ustring filename_;
+    ImageCache::ImageHandle* handle_;
     TxReaderFormat* txFmt_;
 
-    int chanCount_, lastMipLevel_;
-    bool haveImage_, flip_;
-    std::vector<float> imageBuf_;
+    int chanCount_, mipLevel_;
+    bool flip_;
+    std::vector<ImageSpec> mipSpecs_;  // Dimensions of each mip level
     std::map<Channel, int> chanMap_;
 
     MetaData::Bundle meta_;
@@ -202,36 +224,61 @@ class txReader final : public Reader {
         info_.channels(mask);
     }
 
+    // The level to read: the one chosen, or else the smallest one that's
+    // at least the resolution of the (proxy scaled) output.
+    int chooseMipLevel()
+    {
+        int nlevels = int(mipSpecs_.size());
+        if (txFmt_->mipLevel() >= 0)
+            return std::min(txFmt_->mipLevel(), nlevels - 1);
+        const OutputContext& context = iop->outputContext();
+        const float needW            = width() * context.scale_x();
+        const float needH            = height() * context.scale_y();
+        int level                    = 0;
+        while (level + 1 < nlevels && mipSpecs_[level + 1].width >= needW
+               && mipSpecs_[level + 1].height >= needH)
+            ++level;
+        return level;
+    }
+
 public:
     txReader(Read* iop)
         : Reader(iop)
-        , oiioInput_(ImageInput::open(filename()))
+        , filename_(filename())
+        , handle_(nullptr)
         , chanCount_(0)
-        , lastMipLevel_(-1)
-        , haveImage_(false)
+        , mipLevel_(0)
         , flip_(false)
     {
         txFmt_ = dynamic_cast<TxReaderFormat*>(iop->handler());
 
         OIIO::attribute("threads", (int)Thread::numThreads / 2);
 
-        if (!oiioInput_) {
+        // Reread the file if it's changed since it was cached.
+        ImageCache* cache = txCache();
+        cache->invalidate(filename_, false);
+        handle_ = cache->get_image_handle(filename_);
+        ImageSpec baseSpec;
+        if (!handle_ || !cache->get_imagespec(handle_, nullptr, baseSpec)) {
             iop->internalError("OIIO: Failed to open file %s: %s", filename(),
-                               geterror().c_str());
+                               cache->geterror().c_str());
+            handle_ = nullptr;
             return;
         }
 
-        const ImageSpec& baseSpec = oiioInput_->spec();
-
         if (!(baseSpec.width * baseSpec.height)) {
             iop->internalError("tx file has one or more zero dimensions "
                                "(%d x %d)",
                                baseSpec.width, baseSpec.height);
+            handle_ = nullptr;
             return;
         }
 
-        chanCount_       = baseSpec.nchannels;
-        const bool isEXR = strcmp(oiioInput_->format_name(), "openexr") == 0;
+        chanCount_ = baseSpec.nchannels;
+        ustring fileformat;
+        cache->get_image_info(handle_, nullptr, 0, 0, ustring("fileformat"),
+                              TypeString, &fileformat);
+        const bool isEXR = fileformat == "openexr";
 
         if (isEXR) {
             float pixAspect = baseSpec.get_float_attribute("PixelAspectRatio",
@@ -256,70 +303,47 @@ public:
 
         // Populate mip level pulldown with labels in the form:
         //      "MIPLEVEL - WxH" (e.g. "0 - 1920x1080")
-        std::vector<std::string> mipLabels;
-        std::ostringstream buf;
-        ImageSpec mipSpec(baseSpec);
-        int mipLevel = 0;
-        while (true) {
-            buf << mipLevel << " - " << mipSpec.width << 'x' << mipSpec.height;
-            mipLabels.push_back(buf.str());
-            if (oiioInput_->seek_subimage(0, mipLevel + 1, mipSpec)) {
-                buf.str(std::string());
-                buf.clear();
-                mipLevel++;
-            } else
+        // after the first, "auto".
+        int nlevels = 1;
+        cache->get_image_info(handle_, nullptr, 0, 0, ustring("miplevels"),
+                              TypeInt, &nlevels);
+        std::vector<std::string> mipLabels { "auto" };
+        for (int m = 0; m < nlevels; ++m) {
+            ImageSpec mipSpec;
+            if (!cache->get_cache_dimensions(handle_, nullptr, mipSpec, 0, m))
                 break;
+            mipLabels.push_back(Strutil::fmt::format("{} - {}x{}", m,
+                                                     mipSpec.width,
+                                                     mipSpec.height));
+            mipSpecs_.push_back(mipSpec);
         }
 
-        meta_.setData("tx/mip_levels", mipLevel + 1);
+        if (mipSpecs_.empty()) {
+            iop->internalError("OIIO: Failed to read %s: %s", filename(),
+                               cache->geterror().c_str());
+            handle_ = nullptr;
+            return;
+        }
+        meta_.setData("tx/mip_levels", int(mipSpecs_.size()));
 
         txFmt_->setMipLabels(mipLabels);
     }
 
-    virtual ~txReader()
-    {
-        if (oiioInput_)
-            oiioInput_->close();
-    }
-
     void open()
     {
-        if (lastMipLevel_ != txFmt_->mipLevel()) {
-            ImageSpec mipSpec;
-            if (!oiioInput_->seek_subimage(0, txFmt_->mipLevel(), mipSpec)) {
-                iop->internalError("Failed to seek to mip level %d: %s",
-                                   txFmt_->mipLevel(),
-                                   oiioInput_->geterror().c_str());
-                return;
-            }
-
-            if (txFmt_->mipLevel() && mipSpec.nchannels != chanCount_) {
-                iop->internalError("txReader does not support mip levels with "
-                                   "different channel counts");
-                return;
-            }
-
-            lastMipLevel_ = txFmt_->mipLevel();
-            haveImage_    = false;
-        }
-
-        if (!haveImage_) {
-            const int needSize = oiioInput_->spec().width
-                                 * oiioInput_->spec().height
-                                 * oiioInput_->spec().nchannels;
-            if (size_t(needSize) > imageBuf_.size())
-                imageBuf_.resize(needSize);
-            oiioInput_->read_image(&imageBuf_[0]);
-            haveImage_ = true;
+        if (!handle_)
+            return;
+        mipLevel_ = chooseMipLevel();
+        if (mipLevel_ && mipSpecs_[mipLevel_].nchannels != chanCount_) {
+            iop->internalError("txReader does not support mip levels with "
+                               "different channel counts");
+            mipLevel_ = 0;
         }
     }
 
     void engine(int y, int x, int r, ChannelMask channels, Row& row)
     {
-        if (!haveImage_)
-            iop->internalError("engine called, but haveImage_ is false");
-
-        if (aborted()) {
+        if (!handle_ || aborted()) {
             row.erase(channels);
             return;
         }
@@ -329,38 +353,40 @@ public:
         if (flip_)
             y = height() - y - 1;
 
-        if (lastMipLevel_) {  // Mip level other than 0
-            const int mipW    = oiioInput_->spec().width;
-            const int mipMult = width() / mipW;
-
-            y              = y * oiioInput_->spec().height / height();
-            const int bufX = x ? x / mipMult : 0;
-            const int bufR = r / mipMult;
-            const int bufW = bufR - bufX;
+        // Read just the pixels of the mip level under [x, r) of the row,
+        // from the tiles the cache has (or reads) for them.
+        const ImageSpec& mipSpec(mipSpecs_[mipLevel_]);
+        const int mipW = mipSpec.width;
+        const int mipY = y * mipSpec.height / height();
+        const int bufX = x * mipW / width();
+        const int bufR = (r - 1) * mipW / width() + 1;
+        const int bufW = bufR - bufX;
+        std::vector<float> buf(size_t(bufW) * chanCount_);
+        if (!txCache()->get_pixels(handle_, nullptr, 0, mipLevel_,
+                                   mipSpec.x + bufX, mipSpec.x + bufR,
+                                   mipSpec.y + mipY, mipSpec.y + mipY + 1, 0,
+                                   1, TypeFloat, buf.data())) {
+            iop->internalError("OIIO: Failed to read %s: %s", filename(),
+                               txCache()->geterror().c_str());
+            row.erase(channels);
+            return;
+        }
 
+        const float* alpha = doAlpha ? &buf[chanMap_[Chan_Alpha]] : NULL;
+        if (mipLevel_) {  // Mip level other than 0
             std::vector<float> chanBuf(bufW);
-            float* chanStart   = &chanBuf[0];
-            const int bufStart = y * mipW * chanCount_ + bufX * chanCount_;
-            const float* alpha
-                = doAlpha ? &imageBuf_[bufStart + chanMap_[Chan_Alpha]] : NULL;
             foreach (z, channels) {
-                from_float(z, &chanBuf[0], &imageBuf_[bufStart + chanMap_[z]],
-                           alpha, bufW, chanCount_);
+                from_float(z, &chanBuf[0], &buf[chanMap_[z]], alpha, bufW,
+                           chanCount_);
 
                 float* OUT = row.writable(z);
-                for (int stride = 0, c = 0; stride < bufW; stride++, c = 0)
-                    for (; c < mipMult; c++)
-                        *OUT++ = *(chanStart + stride);
+                for (int X = x; X < r; ++X)
+                    OUT[X] = chanBuf[X * mipW / width() - bufX];
             }
         } else {  // Mip level 0
-            const int pixStart = y * width() * chanCount_ + x * chanCount_;
-            const float* alpha
-                = doAlpha ? &imageBuf_[pixStart + chanMap_[Chan_Alpha]] : NULL;
-
             foreach (z, channels) {
-                from_float(z, row.writable(z) + x,
-                           &imageBuf_[pixStart + chanMap_[z]], alpha, r - x,
-                           chanCount_);
+                from_float(z, row.writable(z) + x, &buf[chanMap_[z]], alpha,
+                           r - x, chanCount_);
             }
         }
     }
@@ -71,6 +71,8 @@ public:
                               void* data) override;
     bool read_native_tile(int subimage, int miplevel, int x, int y, int z,
                           void* data) override;
+    bool empty_tiles(int subimage, int miplevel, std::vector<uint64_t>& empty,
+                     void* background) override;
 
 private:
     std::string m_filename;        ///< Stash the filename
@@ -389,4 +391,23 @@ NullInput::read_native_tile(int /*subimage*/, int /*miplevel*/, int /*x*/,
 }
 
 
+
+bool
+NullInput::empty_tiles(int subimage, int miplevel, std::vector<uint64_t>& empty,
+                       void* background)
+{
+    // Every tile holds nothing but the one value
+    if (!seek_subimage(subimage, miplevel) || !m_spec.tile_width)
+        return false;
+    int tw = m_spec.tile_width, th = m_spec.tile_height;
+    int td = std::max(m_spec.tile_depth, 1);
+    size_t ntiles = size_t((m_spec.width + tw - 1) / tw)
+                    * size_t((m_spec.height + th - 1) / th)
+                    * size_t((m_spec.depth + td - 1) / td);
+    empty.assign((ntiles + 63) / 64, ~uint64_t(0));
+    memcpy(background, m_value.data(), m_value.size());
+    return true;
+}
+
+
 OIIO_PLUGIN_NAMESPACE_END
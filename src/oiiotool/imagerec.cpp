@@ -366,10 +366,12 @@ ImageRec::read(ReadPolicy readpolicy, string_view channel_set)
             allok &= ok;
             // Remove any existing SHA-1 hash from the spec.
             ib->specmod().erase_attribute("oiio:SHA-1");
+            ib->specmod().erase_attribute("oiio:ContentHash");
             std::string desc = ib->spec().get_string_attribute(
                 "ImageDescription");
             if (desc.size()) {
                 Strutil::excise_string_after_head(desc, "oiio:SHA-1=");
+                Strutil::excise_string_after_head(desc, "oiio:ContentHash=");
                 ib->specmod().attribute("ImageDescription", desc);
             }
 
@@ -391,6 +393,73 @@ ImageRec::read(ReadPolicy readpolicy, string_view channel_set)
 }
 
 
+size_t
+ImageRec::spill(std::shared_ptr<ImageCache> imagecache,
+                std::vector<std::string>& files)
+{
+    size_t moved = 0;
+    for (auto& sub : m_subimages) {
+        // A direct read must keep the nativespec of the file it came from.
+        if (sub.was_direct_read())
+            continue;
+        for (auto& ib : sub.m_miplevels) {
+            // Only pixels in memory that nothing else holds on to, in a
+            // format the cache can hold, and at the origin, since that's
+            // where they'll be in the file.
+            if (!ib || ib.use_count() != 1
+                || ib->storage() != ImageBuf::LOCALBUFFER || ib->deep())
+                continue;
+            const ImageSpec& spec(ib->spec());
+            if (spec.x || spec.y || spec.z
+                || (spec.format != TypeUInt8 && spec.format != TypeUInt16
+                    && spec.format != TypeHalf && spec.format != TypeFloat))
+                continue;
+            std::string filename = Filesystem::unique_path(
+                Filesystem::temp_directory_path()
+                + "/oiiotool-spill-%%%%-%%%%-%%%%.tif");
+            ImageSpec filespec(spec);
+            filespec.tile_width  = 64;
+            filespec.tile_height = 64;
+            filespec.tile_depth  = 1;
+            filespec.attribute("compression", "none");
+            auto out = ImageOutput::create(filename);
+            bool ok  = out && out->open(filename, filespec)
+                      && ib->write(out.get()) && out->close();
+            out.reset();
+            ImageBufRef spilled;
+            if (ok) {
+                spilled.reset(new ImageBuf(filename, 0, 0, imagecache));
+                ok = spilled->read(0, 0, false, spec.format);
+            }
+            if (!ok) {
+                spilled.reset();
+                if (imagecache)
+                    imagecache->invalidate(ustring(filename), true);
+                Filesystem::remove(filename);
+                continue;
+            }
+            // The file needn't have kept all the metadata exactly
+            ImageSpec& newspec(spilled->specmod());
+            newspec.full_x        = spec.full_x;
+            newspec.full_y        = spec.full_y;
+            newspec.full_z        = spec.full_z;
+            newspec.full_width    = spec.full_width;
+            newspec.full_height   = spec.full_height;
+            newspec.full_depth    = spec.full_depth;
+            newspec.channelnames  = spec.channelnames;
+            newspec.alpha_channel = spec.alpha_channel;
+            newspec.z_channel     = spec.z_channel;
+            newspec.extra_attribs = spec.extra_attribs;
+            files.push_back(filename);
+            moved += spec.image_bytes();
+            ib = spilled;
+        }
+    }
+    return moved;
+}
+
+
+
 namespace {
 static spin_mutex err_mutex;
 }
@@ -6,8 +6,10 @@
 #include <algorithm>
 #include <cctype>
 #include <cmath>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
+#include <ctime>
 #include <iostream>
 #include <iterator>
 #include <map>
@@ -36,6 +38,7 @@
 #include <OpenImageIO/simd.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/thread.h>
 #include <OpenImageIO/timer.h>
 
 #ifndef NDEBUG
@@ -94,6 +97,24 @@ using pvt::print_info_options;
         return impl(*img[0], *img[1]);                             \
     })
 
+// Like OIIOTOOL_OP, but designate the op as able to compute into its input
+// if nothing else will see that input again (see reuse_dead_input()).
+#define OIIOTOOL_PIXELWISE_OP(name, ninputs, ...)                    \
+    static void action_##name(Oiiotool& ot, cspan<const char*> argv) \
+    {                                                                \
+        if (ot.postpone_callback(ninputs, action_##name, argv))      \
+            return;                                                  \
+        OiiotoolOp op(ot, "-" #name, argv, ninputs, __VA_ARGS__);    \
+        op.reuse_dead_input(true);                                   \
+        op();                                                        \
+    }
+
+// Canned setup for a pixelwise op that uses one image on the stack.
+#define PIXELWISE_UNARY_IMAGE_OP(name, impl)                                 \
+    OIIOTOOL_PIXELWISE_OP(name, 1, [](OiiotoolOp& op, span<ImageBuf*> img) { \
+        return impl(*img[0], *img[1]);                                       \
+    })
+
 // Canned setup for an op that uses two images on the stack.
 #define BINARY_IMAGE_OP(name, impl)                                \
     OIIOTOOL_OP(name, 2, [](OiiotoolOp& op, span<ImageBuf*> img) { \
@@ -102,22 +123,22 @@ using pvt::print_info_options;
 
 // Canned setup for an op that uses one image on the stack and one float
 // on the command line.
-#define BINARY_IMAGE_FLOAT_OP(name, impl)                          \
-    OIIOTOOL_OP(name, 1, [](OiiotoolOp& op, span<ImageBuf*> img) { \
-        float val = Strutil::stof(op.args(1));                     \
-        return impl(*img[0], *img[1], val);                        \
+#define BINARY_IMAGE_FLOAT_OP(name, impl)                                    \
+    OIIOTOOL_PIXELWISE_OP(name, 1, [](OiiotoolOp& op, span<ImageBuf*> img) { \
+        float val = Strutil::stof(op.args(1));                               \
+        return impl(*img[0], *img[1], val);                                  \
     })
 
 // Canned setup for an op that uses one image on the stack and one color
 // on the command line.
-#define BINARY_IMAGE_COLOR_OP(name, impl, defaultval)                   \
-    OIIOTOOL_OP(name, 1, [](OiiotoolOp& op, span<ImageBuf*> img) {      \
-        int nchans = img[1]->spec().nchannels;                          \
-        std::vector<float> val(nchans, defaultval);                     \
-        int nvals = Strutil::extract_from_list_string(val, op.args(1)); \
-        val.resize(nvals);                                              \
-        val.resize(nchans, val.size() == 1 ? val.back() : defaultval);  \
-        return impl(*img[0], *img[1], val, ROI(), 0);                   \
+#define BINARY_IMAGE_COLOR_OP(name, impl, defaultval)                        \
+    OIIOTOOL_PIXELWISE_OP(name, 1, [](OiiotoolOp& op, span<ImageBuf*> img) { \
+        int nchans = img[1]->spec().nchannels;                               \
+        std::vector<float> val(nchans, defaultval);                          \
+        int nvals = Strutil::extract_from_list_string(val, op.args(1));      \
+        val.resize(nvals);                                                   \
+        val.resize(nchans, val.size() == 1 ? val.back() : defaultval);       \
+        return impl(*img[0], *img[1], val, ROI(), 0);                        \
     })
 
 // Macro to fully set up the "action" function that straightforwardly
@@ -137,6 +158,47 @@ Oiiotool::Oiiotool() { clear_options(); }
 
 
 
+Oiiotool::~Oiiotool()
+{
+    if (spill_files.empty())
+        return;
+    // Let go of the images read from the spill files before removing them
+    curimg = nullptr;
+    image_stack.clear();
+    image_labels.clear();
+    for (auto& f : spill_files) {
+        if (imagecache)
+            imagecache->invalidate(ustring(f), true);
+        Filesystem::remove(f);
+    }
+}
+
+
+
+void
+Oiiotool::check_memory_budget()
+{
+    float budget_MB = OIIO::get_float_attribute("max_memory_MB");
+    if (budget_MB <= 0.0f)
+        return;
+    auto over = [=]() {
+        int64_t used = 0;
+        OIIO::getattribute("total_mem_current", TypeInt64, &used);
+        return used > int64_t(budget_MB * 1024.0 * 1024.0);
+    };
+    for (size_t i = 0; i < image_stack.size() && over(); ++i) {
+        ImageRecRef& img(image_stack[i]);
+        if (!img || img == curimg || !img->elaborated())
+            continue;
+        size_t moved = img->spill(imagecache, spill_files);
+        if (moved && debug)
+            print("  moved {} of {} out of memory\n",
+                  Strutil::memformat(moved), img->name());
+    }
+}
+
+
+
 void
 Oiiotool::clear_options()
 {
@@ -228,7 +290,7 @@ Oiiotool::colorconfig()
     if (!m_colorconfig) {
         if (debug)
             print("oiiotool Creating ColorConfig\n");
-        m_colorconfig.reset(new ColorConfig);
+        m_colorconfig = std::make_shared<ColorConfig>();
     }
     return *m_colorconfig.get();
 }
@@ -411,6 +473,9 @@ Oiiotool::read(ImageRecRef img, ReadPolicy readpolicy, string_view channel_set)
         readpolicy = ReadPolicy(readpolicy | ReadNative);
     bool ok = img->read(readpolicy, channel_set);
     total_readtime.stop();
+    if (ok && profiling() && img->subimages()
+        && (*img)(0, 0).storage() != ImageBuf::IMAGECACHE)
+        direct_bytes_read += Filesystem::file_size(img->name());
     imagecache->getattribute("stat:fileio_time", post_ic_time);
     total_imagecache_readtime += post_ic_time - pre_ic_time;
     total_readtime.add_seconds(pre_ic_time - post_ic_time);
@@ -544,7 +609,7 @@ Oiiotool::process_pending()
 void
 Oiiotool::error(string_view command, string_view explanation) const
 {
-    auto& errstream(nostderr ? std::cout : std::cerr);
+    auto& errstream(this->errstream());
     errstream << "oiiotool ERROR";
     if (command.size())
         errstream << ": " << command;
@@ -568,7 +633,7 @@ Oiiotool::error(string_view command, string_view explanation) const
 void
 Oiiotool::warning(string_view command, string_view explanation) const
 {
-    auto& errstream(nostderr ? std::cout : std::cerr);
+    auto& errstream(this->errstream());
     errstream << "oiiotool WARNING";
     if (command.size())
         errstream << ": " << command;
@@ -1029,6 +1094,7 @@ adjust_output_options(string_view filename, ImageSpec& spec,
     // Make sure we kill any special hints that maketx adds and that will
     // no longer be valid after whatever oiiotool operations we've done.
     spec.erase_attribute("oiio:SHA-1");
+    spec.erase_attribute("oiio:ContentHash");
     spec.erase_attribute("oiio:ConstantColor");
     spec.erase_attribute("oiio:AverageColor");
 }
@@ -1979,7 +2045,7 @@ set_origin(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, set_origin, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     string_view origin = ot.express(argv[1]);
 
     auto options      = ot.extract_options(command);
@@ -2025,7 +2091,7 @@ offset_origin(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, offset_origin, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     string_view origin = ot.express(argv[1]);
 
     auto options      = ot.extract_options(command);
@@ -2068,7 +2134,7 @@ set_fullsize(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, set_fullsize, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     string_view size = ot.express(argv[1]);
 
     auto options      = ot.extract_options(command);
@@ -2109,7 +2175,7 @@ set_full_to_pixels(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, set_full_to_pixels, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
 
     auto options      = ot.extract_options(command);
     bool allsubimages = options.get_int("allsubimages", ot.allsubimages);
@@ -2151,7 +2217,7 @@ icc_write(Oiiotool& ot, cspan<const char*> argv)
         return;
     string_view command  = ot.express(argv[0]);
     std::string filename = ot.express(argv[1]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     // auto options      = ot.extract_options(command);
     // bool allsubimages = options.get_int("allsubimages", ot.allsubimages);
 
@@ -2182,7 +2248,7 @@ icc_read(Oiiotool& ot, cspan<const char*> argv)
         return;
     string_view command  = ot.express(argv[0]);
     std::string filename = ot.express(argv[1]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     auto options      = ot.extract_options(command);
     bool allsubimages = options.get_int("allsubimages", ot.allsubimages);
 
@@ -2225,6 +2291,10 @@ static void
 set_colorconfig(Oiiotool& ot, cspan<const char*> argv)
 {
     OIIO_DASSERT(argv.size() == 2);
+    // Don't change a configuration that's shared with other command lines
+    // (for --server), use a new one.
+    if (ot.m_colorconfig.use_count() > 1)
+        ot.m_colorconfig = std::make_shared<ColorConfig>();
     ot.colorconfig().reset(argv[1]);
     if (ot.colorconfig().has_error()) {
         ot.errorfmt("--colorconfig", "{}", ot.colorconfig().geterror());
@@ -2284,6 +2354,7 @@ public:
     {
         fromspace = args(1);
         tospace   = args(2);
+        reuse_dead_input(true);
     }
     bool setup() override
     {
@@ -2459,7 +2530,7 @@ action_unmip(Oiiotool& ot, cspan<const char*> argv)
     // Special case -- detect if there are no MIP-mapped subimages at all,
     // in which case this is a no-op (avoid any copies or allocations).
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     ot.read();
     bool mipmapped = false;
     for (int s = 0, send = ot.curimg->subimages(); s < send; ++s)
@@ -2639,19 +2710,34 @@ action_channels(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_channels, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     string_view chanlist = ot.express(argv[1]);
     auto options         = ot.extract_options(command);
     bool allsubimages    = options.get_int("allsubimages", ot.allsubimages);
 
     ImageRecRef A(ot.top());
-    ot.read(A);
-
     if (chanlist == "RGB")  // Fix common synonyms/mistakes
         chanlist = "R,G,B";
     else if (chanlist == "RGBA")
         chanlist = "R,G,B,A";
 
+    // If A hasn't been read yet, and nothing but the stack refers to it (a
+    // label would need all of its channels), the read itself can select
+    // the channels, so the others are never read or held at all.
+    if (!A->elaborated() && A.use_count() == 2 && ot.read_nativespec(A)
+        && A->subimages() == 1 && A->miplevels(0) == 1) {
+        std::vector<std::string> newchannelnames;
+        std::vector<int> channels;
+        std::vector<float> values;
+        if (decode_channel_set(*A->spec(0, 0), chanlist, newchannelnames,
+                               channels, values, ot.eh)) {
+            if (ot.read(A, ReadDefault, chanlist))
+                A->metadata_modified(true);
+            return;
+        }
+    }
+    ot.read(A);
+
     // Decode the channel set, make the full list of ImageSpec's we'll
     // need to describe the new ImageRec with the altered channels.
     std::vector<int> allmiplevels;
@@ -2783,7 +2869,7 @@ action_selectmip(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_selectmip, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     int miplevel = Strutil::from_string<int>(ot.express(argv[1]));
 
     ot.read();
@@ -2812,7 +2898,7 @@ action_select_subimage(Oiiotool& ot, cspan<const char*> argv)
         return;
 
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     auto options              = ot.extract_options(command);
     int subimage              = 0;
     std::string whichsubimage = ot.express(argv[1]);
@@ -2868,7 +2954,7 @@ action_subimage_split(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_subimage_split, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
 
     ImageRecRef A = ot.pop();
     ot.read(A);
@@ -2887,7 +2973,7 @@ action_layer_split(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_layer_split, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
 
     ImageRecRef A = ot.pop();
     ot.read(A);
@@ -3009,7 +3095,7 @@ action_subimage_append(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(2, action_subimage_append, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     auto options = ot.extract_options(command);
     int n        = OIIO::clamp(options["n"].get<int>(2), 2,
                                int(ot.image_stack.size() + 1));
@@ -3026,7 +3112,7 @@ action_subimage_append_all(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_subimage_append_all, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
 
     action_subimage_append_n(ot, int(ot.image_stack.size() + 1), command);
 }
@@ -3040,7 +3126,7 @@ action_colorcount(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_colorcount, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     string_view colorarg = ot.express(argv[1]);
 
     ot.read();
@@ -3089,7 +3175,7 @@ action_rangecheck(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_rangecheck, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     string_view lowarg  = ot.express(argv[1]);
     string_view higharg = ot.express(argv[2]);
 
@@ -3124,7 +3210,7 @@ action_diff(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(2, action_diff, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
 
     int ret = ot.do_action_diff(ot.image_stack.back(), ot.curimg, ot);
     if (ret != DiffErrOK && ret != DiffErrWarn)
@@ -3145,7 +3231,7 @@ action_pdiff(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(2, action_pdiff, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
 
     int ret = ot.do_action_diff(ot.image_stack.back(), ot.curimg, ot, 1);
     if (ret != DiffErrOK && ret != DiffErrWarn)
@@ -3174,10 +3260,10 @@ BINARY_IMAGE_COLOR_OP(absdiffc, ImageBufAlgo::absdiff, 0);  // --absdiffc
 BINARY_IMAGE_COLOR_OP(powc, ImageBufAlgo::pow, 1.0f);       // --powc
 BINARY_IMAGE_FLOAT_OP(saturate, ImageBufAlgo::saturate);    // --saturate
 
-UNARY_IMAGE_OP(abs, ImageBufAlgo::abs);  // --abs
+PIXELWISE_UNARY_IMAGE_OP(abs, ImageBufAlgo::abs);  // --abs
 
-UNARY_IMAGE_OP(premult, ImageBufAlgo::premult);      // --premult
-UNARY_IMAGE_OP(repremult, ImageBufAlgo::repremult);  // --repremult
+PIXELWISE_UNARY_IMAGE_OP(premult, ImageBufAlgo::premult);      // --premult
+PIXELWISE_UNARY_IMAGE_OP(repremult, ImageBufAlgo::repremult);  // --repremult
 
 // --unpremult
 OIIOTOOL_OP(unpremult, 1, [&](OiiotoolOp& op, span<ImageBuf*> img) {
@@ -3434,7 +3520,7 @@ action_reorient(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_reorient, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
 
     // Make sure time in the rotate functions is charged to reorient
     bool old_enable_function_timing = ot.enable_function_timing;
@@ -3708,7 +3794,7 @@ action_create(Oiiotool& ot, cspan<const char*> argv)
 {
     OIIO_DASSERT(argv.size() == 3);
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     auto options     = ot.extract_options(command);
     string_view size = ot.express(argv[1]);
     int nchans       = Strutil::from_string<int>(ot.express(argv[2]));
@@ -3744,7 +3830,7 @@ action_pattern(Oiiotool& ot, cspan<const char*> argv)
 {
     OIIO_DASSERT(argv.size() == 4);
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     auto options        = ot.extract_options(command);
     std::string pattern = ot.express(argv[1]);
     std::string size    = ot.express(argv[2]);
@@ -3866,7 +3952,7 @@ action_capture(Oiiotool& ot, cspan<const char*> argv)
 {
     OIIO_DASSERT(argv.size() == 1);
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
 
 #ifdef USE_OPENCV
     auto options = ot.extract_options(command);
@@ -3887,6 +3973,78 @@ action_capture(Oiiotool& ot, cspan<const char*> argv)
 
 
 
+// Can --crop or --cut of A, which nothing but the op itself and perhaps
+// the stack refers to, read just the region it needs of its first subimage
+// (with read_region), rather than the whole image? Only when A hasn't been
+// read yet, and only for scanline files without autotiling -- a tiled image
+// is read via the ImageCache, and the crop only pulls the tiles it needs.
+static bool
+can_read_region(Oiiotool& ot, ImageRecRef& A, int subimages)
+{
+    if (A->elaborated() || subimages != 1 || ot.nativeread || ot.autotile
+        || A->input_dataformat() != TypeUnknown || !ot.read_nativespec(A))
+        return false;
+    const ImageSpec& nspec(*A->nativespec(0, 0));
+    return !nspec.tile_width && !nspec.deep && A->miplevels(0) == 1;
+}
+
+
+
+// Make R the pixels of the first subimage of unread image A within roi
+// (black where it's outside A's data window), as float, like a crop of it
+// once it was read but reading only the scanlines that cross roi.
+static bool
+read_region(Oiiotool& ot, ImageRecRef A, ROI roi, ImageBuf& R)
+{
+    ot.remember_input_channelformats(A);
+    auto in = ImageInput::open(A->name(), A->configspec());
+    if (!in) {
+        ot.error("read", ot.format_read_error(A->name(), OIIO::geterror()));
+        return false;
+    }
+    ImageSpec spec = in->spec();
+    spec.set_format(TypeFloat);
+    spec.channelformats.clear();
+    spec.erase_attribute("oiio:SHA-1");
+    spec.erase_attribute("oiio:ContentHash");
+    std::string desc = spec.get_string_attribute("ImageDescription");
+    if (desc.size()) {
+        Strutil::excise_string_after_head(desc, "oiio:SHA-1=");
+        Strutil::excise_string_after_head(desc, "oiio:ContentHash=");
+        spec.attribute("ImageDescription", desc);
+    }
+    ROI src     = roi_intersection(roi, get_roi(spec));
+    roi.chbegin = 0;
+    roi.chend   = spec.nchannels;
+    set_roi(spec, roi);
+    R.reset(spec, InitializePixels::Yes);
+    if (!src.defined())
+        return true;
+
+    // A band of full scanlines at a time, of which we keep src's columns
+    int nch = spec.nchannels, xbegin = in->spec().x;
+    int width = in->spec().width, band = 64;
+    std::vector<float> rows(size_t(width) * nch * band);
+    for (int z = src.zbegin; z < src.zend; ++z) {
+        for (int y = src.ybegin; y < src.yend; y += band) {
+            int yend = std::min(y + band, src.yend);
+            if (!in->read_scanlines(0, 0, y, yend, z, 0, nch, TypeFloat,
+                                    rows.data())) {
+                ot.error("read",
+                         ot.format_read_error(A->name(), in->geterror()));
+                return false;
+            }
+            ROI bandroi(src.xbegin, src.xend, y, yend, z, z + 1, 0, nch);
+            R.set_pixels(bandroi, TypeFloat,
+                         rows.data() + size_t(src.xbegin - xbegin) * nch,
+                         nch * sizeof(float), width * nch * sizeof(float));
+        }
+    }
+    return true;
+}
+
+
+
 // --crop
 void
 action_crop(Oiiotool& ot, cspan<const char*> argv)
@@ -3894,14 +4052,17 @@ action_crop(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_crop, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     string_view size = ot.express(argv[1]);
 
     auto options      = ot.extract_options(command);
     bool allsubimages = options.get_int("allsubimages", ot.allsubimages);
 
-    ot.read();
-    ImageRecRef A     = ot.curimg;
+    ImageRecRef A = ot.curimg;
+    bool partial  = A.use_count() == 2 && !allsubimages
+                   && can_read_region(ot, A, 1);
+    if (!partial)
+        ot.read();
     bool crops_needed = false;
     int subimages     = allsubimages ? A->subimages() : 1;
     for (int s = 0; s < subimages; ++s) {
@@ -3924,12 +4085,13 @@ action_crop(Oiiotool& ot, cspan<const char*> argv)
             ot.adjust_geometry(argv[0], w, h, x, y, size);
             const ImageBuf& Aib((*A)(s, 0));
             ImageBuf& Rib((*R)(s, 0));
-            ROI roi = Aib.roi();
+            ROI roi = get_roi(spec);
             if (w != spec.width || h != spec.height || d != spec.depth
                 || x != spec.x || y != spec.y || z != spec.z) {
                 roi = ROI(x, x + w, y, y + h, z, z + d);
             }
-            bool ok = ImageBufAlgo::crop(Rib, Aib, roi);
+            bool ok = partial ? read_region(ot, A, roi, Rib)
+                              : ImageBufAlgo::crop(Rib, Aib, roi);
             if (!ok) {
                 ot.error(command, Rib.geterror());
                 break;
@@ -3948,7 +4110,7 @@ action_croptofull(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_croptofull, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
 
     auto options      = ot.extract_options(command);
     bool allsubimages = options.get_int("allsubimages", ot.allsubimages);
@@ -4014,7 +4176,7 @@ action_trim(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_trim, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
 
     // auto options      = ot.extract_options(command);
     // bool allsubimages = options.get_int("allsubimages", ot.allsubimages);
@@ -4057,15 +4219,18 @@ action_cut(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_cut, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     string_view size = ot.express(argv[1]);
 
     auto options      = ot.extract_options(command);
     bool allsubimages = options.get_int("allsubimages", ot.allsubimages);
 
     // Operate on (and replace) the top-of-stack image
-    ot.read();
     ImageRecRef A = ot.pop();
+    bool partial  = A.use_count() == 1 && !allsubimages
+                   && can_read_region(ot, A, 1);
+    if (!partial)
+        ot.read(A);
 
     // First, compute the specs of the cropped subimages
     int subimages = allsubimages ? A->subimages() : 1;
@@ -4073,6 +4238,11 @@ action_cut(Oiiotool& ot, cspan<const char*> argv)
     for (int s = 0; s < subimages; ++s) {
         ImageSpec& newspec(newspecs[s]);
         newspec = *A->spec(s, 0);
+        if (partial) {
+            // As it would be once read, not as it is in the file
+            newspec.set_format(TypeFloat);
+            newspec.channelformats.clear();
+        }
         ot.adjust_geometry(argv[0], newspec.width, newspec.height, newspec.x,
                            newspec.y, size);
     }
@@ -4082,8 +4252,11 @@ action_cut(Oiiotool& ot, cspan<const char*> argv)
 
     // Crop and populate the new ImageRec
     for (int s = 0; s < subimages; ++s) {
-        const ImageBuf& Aib((*A)(s, 0));
         ImageBuf& Rib((*R)(s, 0));
+        ImageBuf region;
+        if (partial && !read_region(ot, A, get_roi(newspecs[s]), region))
+            break;
+        const ImageBuf& Aib(partial ? region : (*A)(s, 0));
         ImageBufAlgo::cut(Rib, Aib, get_roi(newspecs[s]));
         ImageSpec& spec(*R->spec(s, 0));
         set_roi(spec, Rib.roi());
@@ -4326,7 +4499,7 @@ action_fit(Oiiotool& ot, cspan<const char*> argv)
         return;
     string_view command = ot.express(argv[0]);
     string_view size    = ot.express(argv[1]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     bool old_enable_function_timing = ot.enable_function_timing;
     ot.enable_function_timing       = false;
 
@@ -4406,7 +4579,7 @@ action_pixelaspect(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_pixelaspect, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     bool old_enable_function_timing = ot.enable_function_timing;
     ot.enable_function_timing       = false;
 
@@ -4588,7 +4761,7 @@ action_fixnan(Oiiotool& ot, cspan<const char*> argv)
         return;
     string_view command  = ot.express(argv[0]);
     string_view modename = ot.express(argv[1]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
 
     auto options      = ot.extract_options(command);
     bool allsubimages = options.get_int("allsubimages", ot.allsubimages);
@@ -4637,7 +4810,7 @@ action_fillholes(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_fillholes, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
 
     // Read and copy the top-of-stack image
     ImageRecRef A(ot.pop());
@@ -4661,7 +4834,7 @@ action_paste(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(2, action_paste, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     string_view position = ot.express(argv[1]);
     auto options         = ot.extract_options(command);
     bool do_merge        = options.get_int("mergeroi");
@@ -4765,6 +4938,80 @@ OIIOTOOL_OP(pastemeta, 2, [&](OiiotoolOp& op, span<ImageBuf*> img) {
 
 
 
+// The source for the `w` x `h` area of one cell of --mosaic:fit. Rather
+// than reading a file that hasn't been read yet at full resolution, use the
+// coarsest MIP level that still covers the area, and ask the reader to
+// reduce the resolution further as it decodes (which few formats can do).
+static const ImageBuf*
+mosaic_cell_source(ImageRec& img, int w, int h, ImageBuf& reduced)
+{
+    if (img.elaborated())
+        return &img(0);
+    int m = img.miplevels(0) - 1;
+    while (m > 0 && (img.spec(0, m)->width < w || img.spec(0, m)->height < h))
+        --m;
+    const ImageSpec& spec(*img.spec(0, m));
+    int reduce = std::min(spec.width / w, spec.height / h);
+    if (reduce >= 2) {
+        ImageSpec config = img.configspec() ? *img.configspec() : ImageSpec();
+        config.attribute("oiio:reduce_factor", reduce);
+        reduced.reset(img.name(), 0, m, nullptr, &config);
+        if (reduced.read(0, m, true))
+            return &reduced;
+        (void)reduced.geterror();  // Fall back on the cache
+    }
+    return &img(0, m);
+}
+
+
+
+// Do the equivalent of a --fit:pad=1 of `img` to the `cellw` x `cellh` cell
+// whose corner is (x,y) of the mosaic `dst`, whose pixels are `dstpixels`,
+// resizing directly into the cell.
+static bool
+mosaic_fit_cell(const ImageBuf& dst, span<std::byte> dstpixels, int x, int y,
+                int cellw, int cellh, ImageRec& img, std::string& err)
+{
+    // Same size and centering as ImageBufAlgo::fit's letterbox.
+    const ImageSpec& spec(*img.spec(0, 0));
+    float aspect = float(spec.full_width) / float(spec.full_height);
+    int w = cellw, h = cellh;
+    if (float(cellw) / float(cellh) >= aspect)
+        w = clamp(int(cellh * aspect + 0.5f), 1, cellw);
+    else
+        h = clamp(int(cellw / aspect + 0.5f), 1, cellh);
+    x += (cellw - w) / 2;
+    y += (cellh - h) / 2;
+
+    ImageBuf reduced;
+    const ImageBuf* src = mosaic_cell_source(img, w, h, reduced);
+    ImageSpec cellspec(w, h, dst.nchannels(), dst.spec().format);
+    stride_t xstride = dst.pixel_stride();
+    stride_t ystride = dst.scanline_stride();
+    ImageBuf cell(cellspec, dstpixels,
+                  dstpixels.data() + y * ystride + x * xstride, xstride,
+                  ystride);
+    const ImageSpec& srcspec(src->spec());
+    ROI full = get_roi_full(srcspec);
+    bool ok;
+    if (full.width() == w && full.height() == h) {
+        // No resize is necessary
+        ROI srcroi   = roi_intersection(get_roi(srcspec), full);
+        srcroi.chend = std::min(srcroi.chend, cellspec.nchannels);
+        ok = ImageBufAlgo::paste(cell, -full.xbegin, -full.ybegin, 0, 0, *src,
+                                 srcroi, 1);
+    } else {
+        ROI roi(0, w, 0, h, 0, 1, 0,
+                std::min(srcspec.nchannels, cellspec.nchannels));
+        ok = ImageBufAlgo::resize(cell, *src, {}, roi, 1);
+    }
+    if (!ok)
+        err = cell.has_error() ? cell.geterror() : src->geterror();
+    return ok;
+}
+
+
+
 // --mosaic
 static void
 action_mosaic(Oiiotool& ot, cspan<const char*> argv)
@@ -4772,7 +5019,7 @@ action_mosaic(Oiiotool& ot, cspan<const char*> argv)
     // Mosaic is tricky. We have to parse the argument before we know
     // how many images it wants to pull off the stack.
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     string_view size = ot.express(argv[1]);
     int ximages = 0, yimages = 0;
     if (!scan_resolution(size, ximages, yimages) || ximages < 1
@@ -4793,28 +5040,56 @@ action_mosaic(Oiiotool& ot, cspan<const char*> argv)
         ot.push(blank_img);
     }
 
+    auto options = ot.extract_options(command);
+    int pad      = options.get_int("pad");
+
+    std::string fit = options["fit"];
+    int fitw        = 0, fith = 0;
+    bool fitted     = fit.size() && scan_resolution(fit, fitw, fith)
+                  && fitw >= 1 && fith >= 1;
+
+    // When fitting, images that haven't been read yet only need their
+    // specs now: each cell is read (at as low a resolution as will do)
+    // and resized straight into the mosaic below, all of them in parallel.
     int widest = 0, highest = 0, nchannels = 0;
     TypeDesc outtype = TypeUnknown;
+    bool direct      = fitted;
     std::vector<ImageRecRef> images(nimages);
     for (int i = nimages - 1; i >= 0; --i) {
         ImageRecRef img = ot.pop();
         images[i]       = img;
-        ot.read(img);
-        widest    = std::max(widest, img->spec()->full_width);
-        highest   = std::max(highest, img->spec()->full_height);
-        nchannels = std::max(nchannels, img->spec()->nchannels);
-        outtype   = TypeDesc::basetype_merge(outtype, img->spec()->format);
-    }
-
-    auto options = ot.extract_options(command);
-    int pad      = options.get_int("pad");
-
-    std::string fit = options["fit"];
-    if (fit.size()) {
-        int fitw = 0, fith = 0;
-        if (scan_resolution(fit, fitw, fith) && fitw >= 1 && fith >= 1) {
-            widest  = fitw;
-            highest = fith;
+        TypeDesc format;
+        if (fitted && !img->elaborated()) {
+            if (!ot.read_nativespec(img))
+                return;
+            // As much of what Oiiotool::read would have done as affects
+            // the result.
+            const ImageSpec& nspec(*img->nativespec());
+            if (nspec.tile_width && !ot.output_tilewidth
+                && !ot.output_scanline) {
+                ot.output_tilewidth  = nspec.tile_width;
+                ot.output_tileheight = nspec.tile_height;
+            }
+            ot.remember_input_channelformats(img);
+            format = img->input_dataformat();
+            if (format == TypeUnknown)
+                format = ot.nativeread ? nspec.format : TypeFloat;
+        } else {
+            ot.read(img);
+            format = img->spec()->format;
+        }
+        const ImageSpec* spec = img->spec();
+        widest    = std::max(widest, spec->full_width);
+        highest   = std::max(highest, spec->full_height);
+        nchannels = std::max(nchannels, spec->nchannels);
+        outtype   = TypeDesc::basetype_merge(outtype, format);
+        direct &= !spec->deep && spec->depth <= 1;
+    }
+
+    if (fitted) {
+        widest  = fitw;
+        highest = fith;
+        if (!direct) {
             // Do the equivalent of a --fit on each image
             const char* fitargs[] = { "--fit:allsubimages=0:pad=1",
                                       fit.c_str() };
@@ -4833,6 +5108,25 @@ action_mosaic(Oiiotool& ot, cspan<const char*> argv)
     ot.push(R);
 
     ImageBufAlgo::zero((*R)());
+    if (fitted && direct) {
+        // (Scanlines may be padded, so the cells use the mosaic's strides.)
+        span<std::byte> pixels((std::byte*)(*R)().localpixels(),
+                               size_t((*R)().z_stride()));
+        std::vector<std::string> errors(nimages);
+        parallel_for(0, nimages, [&](int64_t n) {
+            int i = int(n % ximages), j = int(n / ximages);
+            mosaic_fit_cell((*R)(), pixels, i * (widest + pad),
+                            j * (highest + pad), widest, highest, *images[n],
+                            errors[n]);
+        });
+        for (auto& err : errors) {
+            if (err.size()) {
+                ot.error(command, err);
+                return;
+            }
+        }
+        return;
+    }
     for (int j = 0; j < yimages; ++j) {
         int y = j * (highest + pad);
         for (int i = 0; i < ximages; ++i) {
@@ -4885,7 +5179,7 @@ action_fill(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_fill, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     string_view size  = ot.express(argv[1]);
     auto options      = ot.extract_options(command);
     bool allsubimages = options.get_int("allsubimages", ot.allsubimages);
@@ -4964,7 +5258,7 @@ action_clamp(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_clamp, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
 
     auto options      = ot.extract_options(command);
     bool allsubimages = options.get_int("allsubimages", ot.allsubimages);
@@ -5160,8 +5454,9 @@ input_file(Oiiotool& ot, cspan<const char*> argv)
 
     for (int i = 0; i < std::ssize(argv); i++) {
         // FIXME: this loop is pointless, since there is ever only one arg
-        OTScopedTimer timer(ot, command);
         string_view filename = ot.express(argv[i]);
+        string_view what[]   = { command, filename };
+        OTScopedTimer timer(ot, command, cspan<string_view>(what));
         auto found           = ot.image_labels.find(filename);
         if (found != ot.image_labels.end()) {
             if (ot.debug)
@@ -5323,6 +5618,7 @@ input_file(Oiiotool& ot, cspan<const char*> argv)
     ot.clear_input_config();
     ot.input_channel_set.clear();
     ot.check_peak_memory();
+    ot.check_memory_budget();
     // ot.total_readtime.stop();
     return 0;
 }
@@ -5353,6 +5649,10 @@ prep_texture_config(Oiiotool& ot, ImageSpec& configspec,
                          fileoptions.get_int("monochrome_detect"));
     configspec.attribute("maketx:opaque_detect",
                          fileoptions.get_int("opaque_detect"));
+    configspec.attribute("maketx:tile_stats",
+                         fileoptions.get_int("tile_stats"));
+    configspec.attribute("maketx:hashtype",
+                         fileoptions.get_string("hashtype", "sha1"));
     configspec.attribute("maketx:compute_average",
                          fileoptions.get_int("compute_average", 1));
     configspec.attribute("maketx:unpremult", fileoptions.get_int("unpremult"));
@@ -5423,6 +5723,38 @@ remove_all_cmd(std::string& str)
 
 
 
+// Are the pixels of level (s,m) of ir still exactly those of the same
+// level of the file it was read from, and will they be written with the
+// format, layout, and compression they already have there? If so, out can
+// copy them straight from the file, which is lossless and skips decoding
+// and re-encoding them (for example when only the metadata was changed).
+static bool
+can_pass_through(ImageRec& ir, int s, int m, const ImageSpec& spec,
+                 const ImageOutput* out)
+{
+    const ImageBuf& ib(ir(s, m));
+    if (!ir[s].was_direct_read() || ib.storage() != ImageBuf::IMAGECACHE
+        || ib.name() != ir.name() || ib.subimage() != s || ib.miplevel() != m
+        || ib.file_format_name() != out->format_name() || spec.deep)
+        return false;
+    const ImageSpec& native(ib.nativespec());
+    return spec.format == native.format
+           && spec.channelformats == native.channelformats
+           && spec.nchannels == native.nchannels && spec.x == native.x
+           && spec.y == native.y && spec.z == native.z
+           && spec.width == native.width && spec.height == native.height
+           && spec.depth == native.depth
+           && spec.tile_width == native.tile_width
+           && spec.tile_height == native.tile_height
+           && spec.tile_depth == native.tile_depth
+           && spec.get_int_attribute("oiio:BitsPerSample")
+                  == native.get_int_attribute("oiio:BitsPerSample")
+           && spec.get_string_attribute("compression")
+                  == native.get_string_attribute("compression");
+}
+
+
+
 // -o
 static void
 output_file(Oiiotool& ot, cspan<const char*> argv)
@@ -5430,7 +5762,7 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
     ot.total_writetime.start();
     string_view command  = ot.express(argv[0]);
     std::string filename = ot.express(argv[1]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
 
     auto fileoptions = ot.extract_options(command);
 
@@ -5747,7 +6079,10 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
             }
         }
 
-        // Output all the subimages and MIP levels
+        // Output all the subimages and MIP levels. Those that haven't been
+        // altered since they were read are copied directly from their file
+        // if they can be, unless asked not to.
+        bool passthrough = fileoptions.get_int("passthrough", 1);
         for (int s = 0, send = ir->subimages(); s < send; ++s) {
             for (int m = 0, mend = ir->miplevels(s); m < mend && ok; ++m) {
                 ImageSpec spec = *ir->spec(s, m);
@@ -5761,7 +6096,22 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
                         break;
                     }
                 }
-                if (!(*ir)(s, m).write(out.get())) {
+                std::unique_ptr<ImageInput> in;
+                if (passthrough
+                    && can_pass_through(*ir, s, m, spec, out.get())) {
+                    in = ImageInput::open(std::string(ir->name()));
+                    if (in && !in->seek_subimage(s, m))
+                        in.reset();
+                    if (!in)
+                        OIIO::geterror();  // Just write it the usual way
+                }
+                if (in) {
+                    if (!out->copy_image(in.get())) {
+                        ot.error(command, out->geterror());
+                        ok = false;
+                        break;
+                    }
+                } else if (!(*ir)(s, m).write(out.get())) {
                     ot.error(command, (*ir)(s, m).geterror());
                     ok = false;
                     break;
@@ -5813,6 +6163,8 @@ output_file(Oiiotool& ot, cspan<const char*> argv)
     // Make sure to invalidate any IC entries that think they are the
     // file we just wrote.
     ot.imagecache->invalidate(ustring(filename), true);
+    if (ok && ot.profiling())
+        ot.bytes_written += Filesystem::file_size(filename);
 
     if (ot.output_adjust_time && ok) {
         std::string metadatatime = ir->spec(0, 0)->get_string_attribute(
@@ -5870,7 +6222,7 @@ action_printstats(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_printstats, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     auto options      = ot.extract_options(command);
     bool allsubimages = options.get_int("allsubimages", ot.allsubimages);
 
@@ -5908,7 +6260,7 @@ action_printinfo(Oiiotool& ot, cspan<const char*> argv)
     if (ot.postpone_callback(1, action_printinfo, argv))
         return;
     string_view command = ot.express(argv[0]);
-    OTScopedTimer timer(ot, command);
+    OTScopedTimer timer(ot, command, argv);
     auto options      = ot.extract_options(command);
     bool allsubimages = options.get_int("allsubimages", ot.allsubimages);
     bool stats        = options.get_int("stats", ot.printstats);
@@ -6401,6 +6753,16 @@ Oiiotool::getargs(int argc, char* argv[])
       .help("Debug mode");
     ap.arg("--runstats", &ot.runstats)
       .help("Print runtime statistics");
+    ap.arg("--profile %s:FILENAME")
+      .help("Write the time and memory of each subsequent command to a file (options: format=json|trace)")
+      .action([&](cspan<const char*> argv){
+            auto options = ot.extract_options(argv[0]);
+            ot.profile_format = options.get_string("format", "json");
+            if (ot.profile_format != "json" && ot.profile_format != "trace")
+                ot.errorfmt(argv[0], "Unknown format \"{}\"", ot.profile_format);
+            else
+                ot.profile_filename = ot.express(argv[1]);
+        });
     ap.arg("--buildinfo")
       .help("Print OIIO build information")
       .action([&](cspan<const char*>){
@@ -6514,6 +6876,12 @@ Oiiotool::getargs(int argc, char* argv[])
       .help("Skip to next frame in range if there's an error, rather than exiting");
     ap.arg("--parallel-frames")
       .help("Parallelize evaluation of frame range");
+    ap.arg("--server %s:SOCKET")
+      .help("Keep running, and run the command lines sent to this local socket (must be last)")
+      .action([&](cspan<const char*> a){ ot.error(a[0], "must be the last argument"); });
+    ap.arg("--connect %s:SOCKET")
+      .help("Send the rest of the command line to the oiiotool --server at this socket (must be first)")
+      .action([&](cspan<const char*> a){ ot.error(a[0], "must be the first argument"); });
     ap.arg("--wildcardoff")
       .help("Disable numeric wildcard expansion for subsequent command line arguments");
     ap.arg("--wildcardon")
@@ -7059,7 +7427,7 @@ Oiiotool::getargs(int argc, char* argv[])
     // clang-format on
 
     if (ap.parse_args(argc, (const char**)argv) < 0) {
-        auto& errstream(ot.nostderr ? std::cout : std::cerr);
+        auto& errstream(ot.errstream());
         errstream << ap.geterror() << std::endl;
         if (!ot.quiet)
             print_help(ot, ap);
@@ -7105,6 +7473,131 @@ Oiiotool::merge_stats(const Oiiotool& ot)
         return_value = ot.return_value;
     num_outputs += ot.num_outputs;
     printed_info |= ot.printed_info;
+    profile_events.insert(profile_events.end(), ot.profile_events.begin(),
+                          ot.profile_events.end());
+}
+
+
+
+// All --profile times are relative to when oiiotool started.
+static Timer profile_clock;
+
+
+
+ProfileEvent
+Oiiotool::profile_counters()
+{
+    ProfileEvent counters;
+    counters.frame = frame_number;
+    counters.start = profile_clock();
+    counters.cpu   = double(std::clock()) / CLOCKS_PER_SEC;
+    imagecache->getattribute("stat:bytes_read", TypeInt64,
+                             &counters.bytes_read);
+    counters.bytes_read += direct_bytes_read;
+    counters.bytes_written = bytes_written;
+    counters.rss           = int64_t(Sysutil::memory_used());
+    int misses             = 0;
+    imagecache->getattribute("stat:find_tile_calls", TypeInt64,
+                             &counters.tile_lookups);
+    imagecache->getattribute("stat:find_tile_cache_misses", misses);
+    counters.tile_misses = misses;
+    counters.threads     = OIIO::get_int_attribute("threads");
+    return counters;
+}
+
+
+
+void
+Oiiotool::profile_record(ProfileEvent&& event, double io_time)
+{
+    ProfileEvent now = profile_counters();
+    event.wall       = now.start - event.start;
+    event.cpu        = now.cpu - event.cpu;
+    event.io         = io_time;
+    event.bytes_read = now.bytes_read - event.bytes_read;
+    event.bytes_written = now.bytes_written - event.bytes_written;
+    event.rss           = now.rss - event.rss;
+    event.tile_lookups  = now.tile_lookups - event.tile_lookups;
+    event.tile_misses   = now.tile_misses - event.tile_misses;
+    check_peak_memory();
+    event.peak_rss = int64_t(peak_memory);
+    profile_events.push_back(std::move(event));
+}
+
+
+
+// Quote s as a JSON string.
+static std::string
+json_string(string_view s)
+{
+    std::string r = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            r += '\\';
+        if ((unsigned char)c < 0x20)
+            r += Strutil::fmt::format("\\u{:04x}", int(c));
+        else
+            r += c;
+    }
+    return r + "\"";
+}
+
+
+
+void
+Oiiotool::write_profile()
+{
+    // The events were recorded as the commands finished, so put them back
+    // in the order they started.
+    std::stable_sort(profile_events.begin(), profile_events.end(),
+                     [](const ProfileEvent& a, const ProfileEvent& b) {
+                         return a.start < b.start;
+                     });
+    std::ostringstream out;
+    bool trace = (profile_format == "trace");
+    if (trace) {
+        // Chrome trace event format, for chrome://tracing or Perfetto, with
+        // each frame of a sequence as its own "thread".
+        out << "{\"traceEvents\":[\n";
+    } else {
+        Strutil::print(out,
+                       "{{\n  \"threads\": {},\n  \"total_time\": {:.6f},\n"
+                       "  \"peak_memory\": {},\n  \"commands\": [\n",
+                       OIIO::get_int_attribute("threads"), total_runtime(),
+                       peak_memory);
+    }
+    for (size_t i = 0; i < profile_events.size(); ++i) {
+        const ProfileEvent& e(profile_events[i]);
+        double hitrate = e.tile_lookups ? 1.0
+                                              - double(e.tile_misses)
+                                                    / double(e.tile_lookups)
+                                        : 1.0;
+        std::string stats = Strutil::fmt::format(
+            "\"cpu\": {:.6f}, \"io\": {:.6f}, \"bytes_read\": {}, "
+            "\"bytes_written\": {}, \"rss_delta\": {}, \"peak_rss\": {}, "
+            "\"threads\": {}, \"tile_lookups\": {}, \"tile_misses\": {}, "
+            "\"cache_hit_rate\": {:.4f}",
+            e.cpu, e.io, e.bytes_read, e.bytes_written, e.rss, e.peak_rss,
+            e.threads, e.tile_lookups, e.tile_misses, hitrate);
+        if (trace)
+            Strutil::print(out,
+                           "{{\"name\": {}, \"ph\": \"X\", \"pid\": 1, "
+                           "\"tid\": {}, \"ts\": {:.0f}, \"dur\": {:.0f}, "
+                           "\"args\": {{{}}}}}",
+                           json_string(e.command), e.frame, e.start * 1.0e6,
+                           e.wall * 1.0e6, stats);
+        else
+            Strutil::print(out,
+                           "    {{\"command\": {}, \"frame\": {}, "
+                           "\"depth\": {}, \"start\": {:.6f}, "
+                           "\"wall\": {:.6f}, {}}}",
+                           json_string(e.command), e.frame, e.depth, e.start,
+                           e.wall, stats);
+        out << (i + 1 < profile_events.size() ? ",\n" : "\n");
+    }
+    out << (trace ? "]}\n" : "  ]\n}\n");
+    if (!Filesystem::write_text_file(profile_filename, out.str()))
+        errorfmt("--profile", "Could not write \"{}\"", profile_filename);
 }
 
 
@@ -7166,6 +7659,11 @@ one_sequence_iteration(Oiiotool& otmain, size_t i, int frame_number,
         otmain.debug = true;
     if (otit.noerrexit)
         otmain.noerrexit = true;
+    if (otit.profiling()) {
+        std::lock_guard<std::mutex> lock(otmain.m_stat_mutex);
+        otmain.profile_filename = otit.profile_filename;
+        otmain.profile_format   = otit.profile_format;
+    }
     if (otit.runstats) {
         std::lock_guard<std::mutex> lock(otmain.m_stat_mutex);
         otmain.runstats = true;
@@ -7180,6 +7678,58 @@ one_sequence_iteration(Oiiotool& otmain, size_t i, int frame_number,
 
 
 
+// Run ot's frame iterations concurrently, for --parallel-frames. Each
+// frame runs on a thread of our own rather than on one of the pool's: an
+// op called from a pool thread runs serially (lest the pool deadlock), but
+// from these, the ops of all the frames in flight share the pool. So one
+// frame's reads and writes overlap the others' computation, every frame
+// still gets the threads the others leave idle, and a frame never waits for
+// a slower one. A few frames at a time -- about one per four threads --
+// keep the pool busy; more would only hold more images in memory. And
+// while memory use is over 3/4 of the physical memory, no new frame starts
+// until another has finished.
+static void
+run_frames_concurrently(size_t nframes,
+                        const std::function<void(size_t)>& run_frame)
+{
+    int nthreads = OIIO::get_int_attribute("threads");
+    if (nthreads <= 0)
+        nthreads = Sysutil::hardware_concurrency();
+    size_t nworkers = std::min(nframes, size_t(std::max(2, nthreads / 4)));
+    size_t memlimit = Sysutil::physical_memory() / 4 * 3;
+
+    std::mutex mutex;
+    std::condition_variable frame_done;
+    size_t next = 0, running = 0;
+    auto worker = [&]() {
+        for (;;) {
+            size_t i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                frame_done.wait(lock, [&]() {
+                    return !running || Sysutil::memory_used() < memlimit;
+                });
+                if (next >= nframes)
+                    return;
+                i = next++;
+                ++running;
+            }
+            run_frame(i);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --running;
+            }
+            frame_done.notify_all();
+        }
+    };
+    thread_group workers;
+    for (size_t w = 0; w < nworkers; ++w)
+        workers.create_thread(worker);
+    workers.join_all();
+}
+
+
+
 // Check if any of the command line arguments contains numeric ranges or
 // wildcards.  If not, just return 'false'.  But if they do, the
 // remainder of processing will happen here (and return 'true').
@@ -7347,14 +7897,10 @@ handle_sequence(Oiiotool& ot, int argc, const char** argv)
         // If --parframes was used, run the iterations in parallel.
         if (ot.debug)
             print("Running {} frames in parallel\n", nfilenames);
-        parallel_for(
-            uint64_t(0), uint64_t(nfilenames),
-            [&](uint64_t i) {
-                one_sequence_iteration(ot, i, frame_numbers[0][i],
-                                       sequence_args, filenames,
-                                       { argv, argv + argc });
-            },
-            paropt().minitems(1));
+        run_frames_concurrently(nfilenames, [&](size_t i) {
+            one_sequence_iteration(ot, i, frame_numbers[0][i], sequence_args,
+                                   filenames, { argv, argv + argc });
+        });
     } else {
         // Fully serialized over the frame range, multithreaded for each frame
         // individually.
@@ -7368,6 +7914,43 @@ handle_sequence(Oiiotool& ot, int argc, const char** argv)
 
 
 
+void
+OiioTool::run_command_line(Oiiotool& ot, int argc, char* argv[])
+{
+    if (handle_sequence(ot, argc, (const char**)argv)) {
+        // Deal with sequence
+
+    } else {
+        // Not a sequence
+        ot.getargs(argc, argv);
+        if (!ot.ap.aborted()) {
+            ot.process_pending();
+            if (ot.pending_callback())
+                ot.warning(ot.pending_callback_name(),
+                           "pending command never executed");
+            if (!ot.control_stack.empty())
+                ot.warningfmt(ot.control_stack.top().command, "unterminated {}",
+                              ot.control_stack.top().command);
+        }
+    }
+
+    if (!ot.printinfo && !ot.printstats && !ot.dumpdata && !ot.dryrun
+        && !ot.printed_info && !ot.ap.aborted()) {
+        if (ot.curimg && !ot.curimg->was_output()
+            && (ot.curimg->metadata_modified() || ot.curimg->pixels_modified()))
+            ot.warning(
+                "",
+                "modified images without outputting them. Did you forget -o?");
+        else if (ot.num_outputs == 0)
+            ot.warning("", "oiiotool produced no output. Did you forget -o?");
+    }
+
+    if (ot.profiling())
+        ot.write_profile();
+}
+
+
+
 int
 main(int argc, char* argv[])
 {
@@ -7408,6 +7991,13 @@ main(int argc, char* argv[])
     // internationalization, for the entire oiiotool application.
     std::locale::global(std::locale::classic());
 
+    Filesystem::convert_native_arguments(argc, (const char**)argv);
+
+    // A client of a --server just passes the command along, without
+    // setting up anything itself.
+    if (argc >= 3 && string_view(argv[1]) == "--connect")
+        return run_client(argv[2], argc - 3, argv + 3);
+
     Oiiotool ot;
 
     ot.imagecache = ImageCache::create();
@@ -7417,34 +8007,23 @@ main(int argc, char* argv[])
     ot.imagecache->attribute("autotile", ot.autotile);
     ot.imagecache->attribute("autoscanline", int(ot.autotile ? 1 : 0));
 
-    Filesystem::convert_native_arguments(argc, (const char**)argv);
-    if (handle_sequence(ot, argc, (const char**)argv)) {
-        // Deal with sequence
-
-    } else {
-        // Not a sequence
-        ot.getargs(argc, argv);
-        if (!ot.ap.aborted()) {
-            ot.process_pending();
-            if (ot.pending_callback())
-                ot.warning(ot.pending_callback_name(),
-                           "pending command never executed");
-            if (!ot.control_stack.empty())
-                ot.warningfmt(ot.control_stack.top().command, "unterminated {}",
-                              ot.control_stack.top().command);
+    if (argc >= 3 && string_view(argv[argc - 2]) == "--server") {
+        // Any arguments before --server set up the options (--threads,
+        // --cache, --colorconfig, ...) the server runs with.
+        if (argc > 3) {
+            ot.getargs(argc - 2, argv);
+            if (ot.ap.aborted())
+                return ot.return_value;
         }
+        int status = run_server(ot, argv[argc - 1]);
+        ot.curimg  = nullptr;
+        ot.image_stack.clear();
+        ot.image_labels.clear();
+        shutdown();
+        return status;
     }
 
-    if (!ot.printinfo && !ot.printstats && !ot.dumpdata && !ot.dryrun
-        && !ot.printed_info && !ot.ap.aborted()) {
-        if (ot.curimg && !ot.curimg->was_output()
-            && (ot.curimg->metadata_modified() || ot.curimg->pixels_modified()))
-            ot.warning(
-                "",
-                "modified images without outputting them. Did you forget -o?");
-        else if (ot.num_outputs == 0)
-            ot.warning("", "oiiotool produced no output. Did you forget -o?");
-    }
+    run_command_line(ot, argc, argv);
 
     if (ot.runstats) {
         double total_time  = ot.total_runtime();
@@ -35,6 +35,27 @@ typedef void (*CallbackFunction)(Oiiotool& ot, cspan<const char*> argv);
 
 
 
+/// What it cost to run one command, for --profile. While the command
+/// runs, the fields hold the counters as they were when it started.
+struct ProfileEvent {
+    std::string command;        // The command and its arguments
+    int frame             = 0;  // Frame number, if iterating over frames
+    int depth             = 0;  // Number of commands it ran within
+    double start          = 0;  // Seconds since oiiotool started
+    double wall           = 0;  // Elapsed seconds
+    double cpu            = 0;  // Process CPU seconds (all threads)
+    double io             = 0;  // Seconds of the elapsed spent reading
+    int64_t bytes_read    = 0;  // Bytes read from image files
+    int64_t bytes_written = 0;  // Bytes written to image files
+    int64_t rss           = 0;  // Change in resident memory
+    int64_t peak_rss      = 0;  // Peak resident memory so far
+    int64_t tile_lookups  = 0;  // ImageCache tile lookups...
+    int64_t tile_misses   = 0;  //   ...that weren't already in the cache
+    int threads           = 0;  // Threads available to the command
+};
+
+
+
 /// Policy hints for reading images
 enum ReadPolicy {
     ReadDefault = 0,        //< Default: use cache, maybe convert to float.
@@ -141,7 +162,8 @@ public:
     std::vector<ImageRecRef> image_stack;  // stack of previous images
     std::map<std::string, ImageRecRef> image_labels;  // labeled images
     std::shared_ptr<ImageCache> imagecache;           // back ptr to ImageCache
-    std::unique_ptr<ColorConfig> m_colorconfig;       // OCIO color config
+    std::shared_ptr<ColorConfig> m_colorconfig;       // OCIO color config
+    std::ostream* message_stream = nullptr;  // If set, errors go here
     Timer total_runtime;
     // total_readtime is the amount of time for direct reads, and does not
     // count time spent inside ImageCache.
@@ -162,10 +184,23 @@ public:
     int input_bitspersample = 0;
     std::map<std::string, std::string> input_channelformats;
 
+    // --profile: where to write it, and the commands it has recorded
+    std::string profile_filename;
+    std::string profile_format;  // "json" or "trace"
+    std::vector<ProfileEvent> profile_events;
+    int profile_depth         = 0;
+    int64_t direct_bytes_read = 0;  // Read other than via the ImageCache
+    int64_t bytes_written     = 0;
+
+    // Temporary files holding the pixels of images moved out of memory to
+    // stay within the global "max_memory_MB" budget
+    std::vector<std::string> spill_files;
+
     // stat_mutex guards when we are merging another ot's stats into this one
     std::mutex m_stat_mutex;
 
     Oiiotool();
+    ~Oiiotool();
 
     void clear_options();
     void clear_input_config();
@@ -311,6 +346,15 @@ public:
     // "3.14".
     static ParamValueList extract_options(string_view command);
 
+    // Where errors and warnings are printed: message_stream if it's set,
+    // otherwise stderr (or stdout, if --nostderr).
+    std::ostream& errstream() const
+    {
+        return message_stream ? *message_stream
+               : nostderr     ? std::cout
+                              : std::cerr;
+    }
+
     // Error base case -- single unformatted string.
     void error(string_view command, string_view message = "") const;
     void warning(string_view command, string_view message = "") const;
@@ -337,6 +381,12 @@ public:
         return mem;
     }
 
+    // If the process is over the global "max_memory_MB" budget (even after
+    // the ImageCache gave up what tiles it could), move the pixels of the
+    // images on the stack below the current one out to temporary files,
+    // oldest first, until it isn't.
+    void check_memory_budget();
+
     static std::string format_read_error(string_view filename, std::string err)
     {
         if (!err.size())
@@ -370,6 +420,14 @@ public:
     // Merge stats from another Oiiotool
     void merge_stats(const Oiiotool& ot);
 
+    bool profiling() const { return !profile_filename.empty(); }
+    // The counters of a ProfileEvent, as of now.
+    ProfileEvent profile_counters();
+    // Given the event's counters when it started, record what it cost.
+    void profile_record(ProfileEvent&& event, double io_time);
+    // Write the --profile file.
+    void write_profile();
+
     ColorConfig& colorconfig();
 
 private:
@@ -520,6 +578,12 @@ public:
     // Read just enough to fill in the nativespecs
     bool read_nativespec();
 
+    // Move the pixels of the ImageBufs in memory that nothing else refers
+    // to out to temporary files (whose names are added to `files`), to be
+    // read back through `imagecache` as needed. Return the bytes moved.
+    size_t spill(std::shared_ptr<ImageCache> imagecache,
+                 std::vector<std::string>& files);
+
     bool read(ReadPolicy readpolicy   = ReadDefault,
               string_view channel_set = "");
 
@@ -575,6 +639,7 @@ public:
     {
         m_input_dataformat = dataformat;
     }
+    TypeDesc input_dataformat() const { return m_input_dataformat; }
 
     // This should be called if for some reason the underlying
     // ImageBuf's spec may have been modified in place.  We need to
@@ -716,9 +781,23 @@ public:
         , m_ot(ot)
         , m_name(name)
     {
+        if (m_ot.profiling()) {
+            m_profile         = m_ot.profile_counters();
+            m_profile.command = name;
+            m_profile.depth   = m_ot.profile_depth++;
+            m_profiling       = true;
+        }
         if (m_ot.enable_function_timing)
             start();
     }
+    // Also name the command's arguments in the --profile.
+    template<typename T>
+    OTScopedTimer(Oiiotool& ot, string_view name, cspan<T> args)
+        : OTScopedTimer(ot, name)
+    {
+        if (m_profiling && args.size())
+            m_profile.command = Strutil::join(args, " ");
+    }
 
     // Exit scope: record the results.
     ~OTScopedTimer()
@@ -726,6 +805,10 @@ public:
         stop();
         m_ot.function_times[m_name] += m_timer() - m_io_time;
         m_ot.function_times["-i"] += m_io_time;
+        if (m_profiling) {
+            --m_ot.profile_depth;
+            m_ot.profile_record(std::move(m_profile), m_io_time);
+        }
     }
 
     // Explicit start of the timer.
@@ -760,6 +843,8 @@ private:
     double m_pre_input_time = 0.0f;
     double m_pre_ic_time    = 0.0f;
     double m_io_time        = 0.0f;
+    ProfileEvent m_profile;
+    bool m_profiling = false;
 };
 
 
@@ -812,7 +897,7 @@ public:
     {
         // Set up a timer to automatically record how much time is spent in
         // every class of operation.
-        OTScopedTimer timer(ot, opname());
+        OTScopedTimer timer(ot, opname(), cspan<string_view>(m_args));
         if (ot.debug) {
             std::cout << "Performing '" << opname() << "'";
             if (nargs() > 1)
@@ -844,6 +929,12 @@ public:
                 // If instructed to operate in place, just make the output
                 // another reference to the first input image.
                 m_ir[0] = m_ir[1];
+            } else if (input_is_dead(subimages)) {
+                // The op may overwrite its input, which is a result that
+                // nothing else will ever see, so rather than allocate and
+                // fill another one, compute into it.
+                m_ir[0] = m_ir[1];
+                m_ir[0]->pixels_modified(true);
             } else {
                 // Not in-place, so make a new output image.
                 m_ir[0] = new_output_imagerec();
@@ -871,6 +962,7 @@ public:
 
         // Optional cleanup after processing all the subimages
         cleanup();
+        ot.check_memory_budget();
 
         if (ot.debug) {
             Strutil::print("    {} took {}  (total time {}, mem {})\n",
@@ -1089,6 +1181,34 @@ public:
     void inplace(bool val) { m_inplace = val; }
     bool inplace() const { return m_inplace; }
 
+    // Call reuse_dead_input(true) if the impl is still correct when
+    // img[0] and img[1] are the same ImageBuf (each output pixel depends
+    // only on the same input pixel). Then when the first input is an
+    // intermediate result that was popped from the stack and isn't
+    // referenced anywhere else, the op computes into it rather than into a
+    // new image.
+    void reuse_dead_input(bool val) { m_reuse_dead_input = val; }
+    bool reuse_dead_input() const { return m_reuse_dead_input; }
+
+    // Can the op's result go in its first input, as above?
+    bool input_is_dead(int subimages) const
+    {
+        if (!m_reuse_dead_input || nimages() < 2 || m_ir[1].use_count() != 1
+            || !m_ir[1]->elaborated() || m_ir[1]->subimages() != subimages)
+            return false;
+        for (int s = 0; s < subimages; ++s) {
+            if (m_ir[1]->miplevels(s) != 1)
+                return false;
+            // Only a float buffer that was computed (not read from a file,
+            // whose nativespec might yet be consulted) is as good as new.
+            const ImageBuf& ib((*m_ir[1])(s));
+            if (ib.storage() != ImageBuf::LOCALBUFFER || ib.deep()
+                || ib.spec().format != TypeFloat || !ib.name().empty())
+                return false;
+        }
+        return true;
+    }
+
     int current_subimage() const { return m_current_subimage; }
     int current_miplevel() const { return m_current_miplevel; }
 
@@ -1100,6 +1220,7 @@ protected:
     bool m_preserve_miplevels = false;
     bool m_skip_impl          = false;
     bool m_inplace            = false;
+    bool m_reuse_dead_input   = false;
     std::vector<ImageRecRef> m_ir;
     std::vector<ImageBuf*> m_img;
     std::vector<string_view> m_args;
@@ -1115,5 +1236,25 @@ protected:
 };
 
 
+
+// Run the oiiotool command line argv[0..argc-1] with ot, including any
+// frame sequence iteration, with the warnings about unwritten results.
+void
+run_command_line(Oiiotool& ot, int argc, char* argv[]);
+
+// Serve command lines sent to the local socket at socketpath, each run as
+// if it were a separate oiiotool (see run_command_line) in its client's
+// working directory, one at a time, but sharing ot's ImageCache and color
+// configuration. Returns only on error.
+int
+run_server(Oiiotool& ot, string_view socketpath);
+
+// Send the command line argv[0..argc-1] (without the program name) to the
+// server at socketpath, print the output, errors and warnings it sends
+// back, and return its exit status.
+int
+run_client(string_view socketpath, int argc, char* argv[]);
+
+
 }  // namespace OiioTool
 OIIO_NAMESPACE_END;
@@ -0,0 +1,386 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#    include <sys/socket.h>
+#    include <sys/un.h>
+#    include <unistd.h>
+#endif
+
+#include "oiiotool.h"
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/sysutil.h>
+
+using namespace OIIO;
+using namespace OiioTool;
+
+
+// oiiotool --server and --connect
+//
+// A client connects to the server's socket and sends its command line: the
+// number of arguments in decimal and a newline, then its working directory
+// and each argument, each followed by a NUL. The server runs the command
+// lines one at a time, in the client's working directory. When one has
+// run, the server replies with the length in decimal of what it printed to
+// stdout (--info, --help, ...) and a newline, that output, then what it
+// printed to stderr and the text of its errors and warnings, a NUL, and the
+// exit status in decimal, and closes the connection.
+
+
+
+#ifndef _WIN32
+
+namespace {
+
+// Send all of data, or return false.
+bool
+send_all(int fd, string_view data)
+{
+    while (data.size()) {
+        ssize_t n = ::send(fd, data.data(), data.size(), 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        data.remove_prefix(size_t(n));
+    }
+    return true;
+}
+
+
+
+// Read from fd until done(text) says that what's been read so far is
+// complete (returning true), or the other end closes it (returning false).
+template<typename DONE>
+bool
+recv_until(int fd, std::string& text, DONE done)
+{
+    char buf[16384];
+    while (!done(text)) {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        text.append(buf, size_t(n));
+    }
+    return true;
+}
+
+
+
+// Split a request into the client's working directory and its arguments,
+// or return false if it's incomplete.
+bool
+parse_request(string_view request, std::string& cwd,
+              std::vector<std::string>& args)
+{
+    args.clear();
+    size_t eol = request.find('\n');
+    if (eol == string_view::npos)
+        return false;
+    size_t nargs = Strutil::from_string<uint64_t>(request.substr(0, eol));
+    request.remove_prefix(eol + 1);
+    size_t cwdend = request.find('\0');
+    if (cwdend == string_view::npos)
+        return false;
+    cwd = request.substr(0, cwdend);
+    request.remove_prefix(cwdend + 1);
+    while (args.size() < nargs) {
+        size_t end = request.find('\0');
+        if (end == string_view::npos)
+            return false;
+        args.emplace_back(request.substr(0, end));
+        request.remove_prefix(end + 1);
+    }
+    return true;
+}
+
+
+
+bool
+make_address(string_view socketpath, sockaddr_un& addr)
+{
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketpath.empty() || socketpath.size() >= sizeof(addr.sun_path))
+        return false;
+    memcpy(addr.sun_path, socketpath.data(), socketpath.size());
+    return true;
+}
+
+
+
+// While it lives, send what the process writes to stdout or stderr to a
+// temporary file instead, and text() returns what was written there.
+class CaptureOutput {
+public:
+    explicit CaptureOutput(FILE* stream)
+        : m_stream(stream)
+        , m_file(::tmpfile())
+    {
+        fflush(m_stream);
+        m_saved = m_file ? ::dup(fileno(m_stream)) : -1;
+        if (m_saved >= 0)
+            ::dup2(fileno(m_file), fileno(m_stream));
+    }
+    ~CaptureOutput()
+    {
+        text();
+        if (m_file)
+            fclose(m_file);
+    }
+
+    // Restore the stream, and return what was written to it meanwhile.
+    std::string text()
+    {
+        std::string result;
+        if (m_saved < 0)
+            return result;
+        std::cout.flush();
+        std::cerr.flush();
+        fflush(m_stream);
+        ::dup2(m_saved, fileno(m_stream));
+        ::close(m_saved);
+        m_saved = -1;
+        rewind(m_file);
+        char buf[16384];
+        while (size_t n = fread(buf, 1, sizeof(buf), m_file))
+            result.append(buf, n);
+        return result;
+    }
+
+private:
+    FILE* m_stream;
+    FILE* m_file;
+    int m_saved;
+};
+
+
+
+// Run one client's command line in the client's working directory, as if
+// by a separate oiiotool that shares the server's ImageCache and color
+// configuration. `lastcwd` is the working directory of the previous one.
+void
+serve_connection(Oiiotool& server, int fd, const std::string& servercwd,
+                 std::string& lastcwd)
+{
+    std::string request, cwd;
+    std::vector<std::string> args;
+    if (!recv_until(fd, request, [&](const std::string& text) {
+            return parse_request(text, cwd, args);
+        }))
+        return;  // The client gave up before sending it all
+
+    std::vector<char*> argv { const_cast<char*>("oiiotool") };
+    for (auto& a : args)
+        argv.push_back(&a[0]);
+    argv.push_back(nullptr);
+
+    if (cwd != lastcwd) {
+        // Relative file names now name different files, so forget those
+        // that the cache (and the directory listing cache) already know.
+        TypeDesc type = server.imagecache->getattributetype("all_filenames");
+        std::vector<ustring> names(std::max(type.arraylen, 0));
+        if (names.size()
+            && server.imagecache->getattribute("all_filenames", type,
+                                               names.data()))
+            for (ustring name : names)
+                if (!Filesystem::path_is_absolute(name))
+                    server.imagecache->invalidate(name, true);
+        Filesystem::cache_directory_listings(true);
+        lastcwd = cwd;
+    }
+
+    std::ostringstream messages;
+    std::string output, erroutput;
+    int status = EXIT_FAILURE;
+    if (::chdir(cwd.c_str()) == 0) {
+        // A command line may change the thread count for itself
+        int nthreads = OIIO::get_int_attribute("threads");
+        CaptureOutput out(stdout), err(stderr);
+        {
+            Oiiotool ot;
+            ot.imagecache     = server.imagecache;
+            ot.m_colorconfig  = server.m_colorconfig;
+            ot.message_stream = &messages;
+            run_command_line(ot, int(argv.size() - 1), argv.data());
+            status = ot.return_value;
+        }
+        output    = out.text();
+        erroutput = err.text();
+        OIIO::attribute("threads", nthreads);
+        OIIO::geterror();  // Don't leave any for the next command line
+        if (::chdir(servercwd.c_str()) != 0)
+            Strutil::print(stderr,
+                           "oiiotool ERROR: --server : Could not return to "
+                           "{}: {}\n",
+                           servercwd, strerror(errno));
+    } else {
+        Strutil::print(messages,
+                       "oiiotool ERROR: --connect : The server could not use "
+                       "the working directory {}: {}\n",
+                       cwd, strerror(errno));
+    }
+    std::string reply = Strutil::fmt::format("{}\n", output.size());
+    reply += output;
+    reply += erroutput;
+    reply += messages.str();
+    reply += '\0';
+    reply += Strutil::to_string(status);
+    send_all(fd, reply);
+}
+
+}  // namespace
+
+
+
+int
+OiioTool::run_server(Oiiotool& ot, string_view socketpath)
+{
+    sockaddr_un addr;
+    if (!make_address(socketpath, addr)) {
+        ot.errorfmt("--server", "Invalid socket name \"{}\"", socketpath);
+        return EXIT_FAILURE;
+    }
+
+    // All that the command lines would otherwise each have to do for
+    // themselves: find the plugins, and read the OCIO config. And command
+    // lines expanding the same sequences needn't each read the directory.
+    OIIO::get_string_attribute("format_list");
+    ot.colorconfig();
+    Filesystem::cache_directory_listings(true);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        ot.errorfmt("--server", "Could not create a socket: {}",
+                    strerror(errno));
+        return EXIT_FAILURE;
+    }
+    ::unlink(addr.sun_path);  // A stale socket of a server that's gone
+    if (::bind(fd, (const sockaddr*)&addr, sizeof(addr)) < 0
+        || ::listen(fd, 64) < 0) {
+        ot.errorfmt("--server", "Could not listen on \"{}\": {}", socketpath,
+                    strerror(errno));
+        ::close(fd);
+        return EXIT_FAILURE;
+    }
+    if (ot.verbose)
+        Strutil::print("oiiotool server listening on {}\n", socketpath);
+
+    // Run the command lines one at a time, each of which uses the shared
+    // thread pool for its operations. They can't run concurrently, since
+    // each changes the process's working directory, stdout and stderr, and
+    // its global attributes and error state.
+    std::string servercwd = Filesystem::current_path();
+    std::string lastcwd   = servercwd;
+    for (;;) {
+        int conn = ::accept(fd, nullptr, nullptr);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            ot.errorfmt("--server", "{}", strerror(errno));
+            break;
+        }
+        serve_connection(ot, conn, servercwd, lastcwd);
+        ::close(conn);
+    }
+    ::close(fd);
+    ::unlink(addr.sun_path);
+    return EXIT_FAILURE;
+}
+
+
+
+int
+OiioTool::run_client(string_view socketpath, int argc, char* argv[])
+{
+    sockaddr_un addr;
+    int fd = make_address(socketpath, addr) ? ::socket(AF_UNIX, SOCK_STREAM, 0)
+                                            : -1;
+    if (fd < 0
+        || ::connect(fd, (const sockaddr*)&addr, sizeof(addr)) < 0) {
+        Strutil::print(stderr,
+                       "oiiotool ERROR: --connect : Could not connect to {}\n",
+                       socketpath);
+        if (fd >= 0)
+            ::close(fd);
+        return EXIT_FAILURE;
+    }
+
+    std::string request = Strutil::fmt::format("{}\n", argc);
+    request += Filesystem::current_path();
+    request += '\0';
+    for (int a = 0; a < argc; ++a) {
+        request += argv[a];
+        request += '\0';
+    }
+    std::string reply;
+    if (send_all(fd, request))
+        recv_until(fd, reply, [](const std::string&) {
+            return false;  // Read until the server closes it
+        });
+    ::close(fd);
+    size_t eol    = reply.find('\n');
+    size_t outlen = eol == std::string::npos
+                        ? 0
+                        : Strutil::from_string<uint64_t>(
+                            string_view(reply).substr(0, eol));
+    size_t end = eol == std::string::npos || eol + 1 + outlen > reply.size()
+                     ? std::string::npos
+                     : reply.find('\0', eol + 1 + outlen);
+    if (end == std::string::npos) {
+        Strutil::print(stderr,
+                       "oiiotool ERROR: --connect : Lost the server at {}\n",
+                       socketpath);
+        return EXIT_FAILURE;
+    }
+    string_view output = string_view(reply).substr(eol + 1, outlen);
+    string_view errors = string_view(reply).substr(eol + 1 + outlen,
+                                                   end - (eol + 1 + outlen));
+    if (output.size())
+        fwrite(output.data(), 1, output.size(), stdout);
+    if (errors.size())
+        fwrite(errors.data(), 1, errors.size(), stderr);
+    return Strutil::stoi(string_view(reply).substr(end + 1));
+}
+
+
+
+#else  // _WIN32
+
+
+
+int
+OiioTool::run_server(Oiiotool& ot, string_view socketpath)
+{
+    ot.error("--server", "not supported on this platform");
+    return EXIT_FAILURE;
+}
+
+
+
+int
+OiioTool::run_client(string_view socketpath, int argc, char* argv[])
+{
+    Strutil::print(stderr,
+                   "oiiotool ERROR: --connect : not supported on this "
+                   "platform\n");
+    return EXIT_FAILURE;
+}
+
+#endif
@@ -2,14 +2,19 @@
 // SPDX-License-Identifier: Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <numeric>
+#include <vector>
 
 #include <OpenImageIO/Imath.h>
 #include <OpenImageIO/platform.h>
@@ -22,6 +27,7 @@
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/deepdata.h>
 #include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/function_view.h>
 #include <OpenImageIO/imagebufalgo_util.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/strutil.h>
@@ -95,6 +101,129 @@ oiio_exr_read_func(exr_const_context_t ctxt, void* userdata, void* buffer,
     return nread;
 }
 
+
+// Reads the packed (compressed) data of a range of chunks before they are
+// decoded, a window of them at a time with one IOProxy::pread_many() each,
+// so that the reads are outstanding together rather than each decoding
+// task waiting on its own. The first task to need a window fetches it,
+// while the other threads are still decoding the windows before it.
+class ChunkPrefetcher {
+public:
+    // The chunk info of chunk i of the range.
+    using InfoFunc = std::function<exr_result_t(size_t i,
+                                                exr_chunk_info_t& cinfo)>;
+
+    ChunkPrefetcher(Filesystem::IOProxy* io, size_t nchunks, InfoFunc info)
+        : m_io(io)
+        , m_info(std::move(info))
+        , m_chunks(nchunks)
+        , m_windows((nchunks + window_size - 1) / window_size)
+    {
+    }
+
+    // Get the info of chunk i (fetching its window if that hasn't been
+    // done yet), returning the result of looking it up.
+    exr_result_t chunk_info(size_t i, exr_chunk_info_t& cinfo)
+    {
+        Window& w(m_windows[i / window_size]);
+        std::call_once(w.fetched, [&]() { fetch(i / window_size); });
+        cinfo = m_chunks[i].info;
+        return m_chunks[i].rv;
+    }
+
+    // Have the decoder of chunk i use its prefetched data, if there is
+    // any, and if the decoder reads and decompresses its packed data in
+    // the usual way (not, for example, reading uncompressed pixels
+    // straight into place).
+    void attach(size_t i, exr_decode_pipeline_t& decoder)
+    {
+        Chunk& c(m_chunks[i]);
+        if (!c.data || !decoder.decompress_fn
+            || !decoder.unpack_and_convert_fn)
+            return;
+        // N.B. A zero alloc size tells the library it doesn't own it.
+        decoder.packed_buffer     = c.data;
+        decoder.packed_alloc_size = 0;
+        decoder.read_fn           = &already_read;
+    }
+
+    // Done decoding chunk i, so its window may be freed after the last.
+    void release(size_t i)
+    {
+        Window& w(m_windows[i / window_size]);
+        if (--w.remaining == 0)
+            w.data.reset();
+    }
+
+private:
+    static const size_t window_size = 32;
+
+    struct Chunk {
+        exr_chunk_info_t info;
+        exr_result_t rv = EXR_ERR_UNKNOWN;
+        void* data      = nullptr;  ///< Prefetched packed data, if any
+    };
+    struct Window {
+        std::once_flag fetched;
+        std::unique_ptr<char[]> data;
+        std::atomic<int> remaining { 0 };
+    };
+
+    static exr_result_t already_read(exr_decode_pipeline_t*)
+    {
+        return EXR_ERR_SUCCESS;
+    }
+
+    void fetch(size_t window)
+    {
+        size_t begin = window * window_size;
+        size_t end   = std::min(begin + window_size, m_chunks.size());
+        size_t total = 0;
+        for (size_t i = begin; i < end; ++i) {
+            m_chunks[i].rv = m_info(i, m_chunks[i].info);
+            if (m_chunks[i].rv == EXR_ERR_SUCCESS)
+                total += m_chunks[i].info.packed_size;
+        }
+        Window& w(m_windows[window]);
+        w.remaining = int(end - begin);
+        if (!total)
+            return;
+        std::vector<Filesystem::IOProxy::ReadRequest> reqs;
+        w.data.reset(new char[total]);
+        char* p = w.data.get();
+        for (size_t i = begin; i < end; ++i) {
+            const exr_chunk_info_t& info(m_chunks[i].info);
+            if (m_chunks[i].rv != EXR_ERR_SUCCESS || !info.packed_size)
+                continue;
+            Filesystem::IOProxy::ReadRequest r;
+            r.buf    = p;
+            r.size   = size_t(info.packed_size);
+            r.offset = int64_t(info.data_offset);
+            reqs.push_back(r);
+            p += info.packed_size;
+        }
+        m_io->pread_many(reqs);
+        // Chunks that couldn't be read in full are left for the library to
+        // read (and report the errors of) as usual.
+        size_t r = 0;
+        for (size_t i = begin; i < end; ++i) {
+            const exr_chunk_info_t& info(m_chunks[i].info);
+            if (m_chunks[i].rv != EXR_ERR_SUCCESS || !info.packed_size)
+                continue;
+            if (reqs[r].nread == reqs[r].size)
+                m_chunks[i].data = reqs[r].buf;
+            ++r;
+        }
+    }
+
+    Filesystem::IOProxy* m_io;
+    InfoFunc m_info;
+    std::vector<Chunk> m_chunks;
+    std::vector<Window> m_windows;
+};
+
+
+
 class OpenEXRCoreInput final : public ImageInput {
 public:
     OpenEXRCoreInput();
@@ -128,6 +257,10 @@ public:
     bool read_native_scanlines(int subimage, int miplevel, int ybegin, int yend,
                                int z, int chbegin, int chend,
                                void* data) override;
+    bool read_scanlines(int subimage, int miplevel, int ybegin, int yend,
+                        int z, int chbegin, int chend, TypeDesc format,
+                        void* data, stride_t xstride = AutoStride,
+                        stride_t ystride = AutoStride) override;
     bool read_native_tile(int subimage, int miplevel, int x, int y, int z,
                           void* data) override;
     bool read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
@@ -153,6 +286,15 @@ public:
 
 private:
     const ImageSpec& init_part(int subimage, int miplevel);
+    // Decode scanlines [ybegin,yend) of channels [chbegin,chend). Without
+    // `convert`, the native pixels are stored contiguously in `data`.
+    // Otherwise, each chunk is decoded into a buffer of the thread's own
+    // and passed to convert(y, nlines, pixels), while still in cache, and
+    // `data` is not written.
+    bool decode_scanlines(
+        int subimage, int miplevel, int ybegin, int yend, int chbegin,
+        int chend, void* data,
+        function_view<bool(int y, int nlines, const uint8_t* pixels)> convert);
     struct PartInfo {
         std::atomic_bool initialized;
         ImageSpec spec;
@@ -209,6 +351,30 @@ private:
     int m_nsubimages;                   ///< How many subimages are there?
     std::vector<float> m_missingcolor;  ///< Color for missing tile/scanline
 
+    // The last chunk that decode_scanlines decoded but used only the start
+    // of, kept for the next read, which is likely to want the rest of it
+    // when the scanlines are read a strip at a time (as by the ImageCache
+    // for untiled files). This saves decompressing it again, which for
+    // 32 or 256 scanline chunks, like those of DWAA or DWAB, might
+    // otherwise happen many times over.
+    struct KeptChunk {
+        int subimage = -1, miplevel = -1;
+        int y = 0, chbegin = 0, chend = 0;  ///< First scanline, channels
+        std::vector<uint8_t> pixels;
+    };
+    std::mutex m_kept_chunk_mutex;  ///< Protects m_kept_chunk
+    KeptChunk m_kept_chunk;
+    // Chunks bigger than this aren't kept.
+    static const size_t max_kept_chunk_bytes = 16 * 1024 * 1024;
+
+    // If the kept chunk is the one starting at scanline y, copy it to
+    // `pixels` and return true. It's let go if `last` (no later read is
+    // expected to need it).
+    bool find_kept_chunk(int subimage, int miplevel, int y, int chbegin,
+                         int chend, uint8_t* pixels, size_t bytes, bool last);
+    void keep_chunk(int subimage, int miplevel, int y, int chbegin, int chend,
+                    const uint8_t* pixels, size_t bytes);
+
     void init()
     {
         m_exr_context    = nullptr;
@@ -216,6 +382,8 @@ private:
         m_userdata.m_io  = nullptr;
         m_local_io.reset();
         m_missingcolor.clear();
+        std::lock_guard<std::mutex> lock(m_kept_chunk_mutex);
+        m_kept_chunk = KeptChunk();
     }
 
     bool valid_file(const std::string& filename, Filesystem::IOProxy* io) const;
@@ -312,7 +480,13 @@ OpenEXRCoreInput::valid_file(const std::string& filename,
 
     // do we always want this?
     std::unique_ptr<Filesystem::IOProxy> localio;
-    if (!io) {
+    if (!io && Filesystem::is_url(filename)) {
+        std::string err;
+        localio = pvt::open_input_url(filename, err);
+        if (!localio)
+            return false;
+        io = localio.get();
+    } else if (!io) {
         localio.reset(
             new Filesystem::IOFile(filename, Filesystem::IOProxy::Read));
         io = localio.get();
@@ -383,8 +557,16 @@ OpenEXRCoreInput::open(const std::string& name, ImageSpec& newspec,
     m_spec = ImageSpec();
 
     // Establish an input stream. If we weren't given an IOProxy, create one
-    // now that just reads from the file.
-    if (!m_userdata.m_io) {
+    // now that just reads from the file, or the parts of a URL it needs.
+    if (!m_userdata.m_io && Filesystem::is_url(name)) {
+        std::string err;
+        m_local_io = pvt::open_input_url(name, err);
+        if (!m_local_io) {
+            errorfmt("{}", err);
+            return false;
+        }
+        m_userdata.m_io = m_local_io.get();
+    } else if (!m_userdata.m_io) {
         m_userdata.m_io = new Filesystem::IOFile(name,
                                                  Filesystem::IOProxy::Read);
         m_local_io.reset(m_userdata.m_io);
@@ -1180,7 +1362,52 @@ OpenEXRCoreInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
             "called OpenEXRInput::read_native_scanlines without an open file");
         return false;
     }
+    return decode_scanlines(subimage, miplevel, ybegin, yend, chbegin, chend,
+                            data, nullptr);
+}
+
 
+
+bool
+OpenEXRCoreInput::read_scanlines(int subimage, int miplevel, int ybegin,
+                                 int yend, int z, int chbegin, int chend,
+                                 TypeDesc format, void* data, stride_t xstride,
+                                 stride_t ystride)
+{
+    if (!m_exr_context)
+        return ImageInput::read_scanlines(subimage, miplevel, ybegin, yend, z,
+                                          chbegin, chend, format, data,
+                                          xstride, ystride);
+    const ImageSpec& spec = init_part(subimage, miplevel);
+    // Only a conversion from scanline chunks is fused with the decoding;
+    // anything else is handled as usual.
+    if (format == TypeUnknown || spec.tile_width || spec.deep
+        || (format == spec.format && spec.channelformats.empty()))
+        return ImageInput::read_scanlines(subimage, miplevel, ybegin, yend, z,
+                                          chbegin, chend, format, data,
+                                          xstride, ystride);
+    chend            = clamp(chend, chbegin + 1, spec.nchannels);
+    stride_t zstride = AutoStride;
+    spec.auto_stride(xstride, ystride, zstride, format, chend - chbegin,
+                     spec.width, spec.height);
+    return decode_scanlines(
+        subimage, miplevel, ybegin, yend, chbegin, chend, data,
+        [&](int y, int nlines, const uint8_t* pixels) {
+            char* dst = (char*)data + (y - ybegin) * ystride;
+            return convert_native_scanlines(spec, chbegin, chend, nlines,
+                                            pixels, format, dst, xstride,
+                                            ystride);
+        });
+}
+
+
+
+bool
+OpenEXRCoreInput::decode_scanlines(
+    int subimage, int miplevel, int ybegin, int yend, int chbegin, int chend,
+    void* data,
+    function_view<bool(int y, int nlines, const uint8_t* pixels)> convert)
+{
     // NB: to prevent locking, we use the SUBIMAGE spec, so the mip
     // information is not valid!!!! instead, we will use the library
     // which has an internal thread-safe cache of the sizes if needed
@@ -1205,10 +1432,28 @@ OpenEXRCoreInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
     yend            = std::min(endy, yend);
     int ychunkstart = spec.y
                       + round_down_to_multiple(ybegin - spec.y, scansperchunk);
+    std::unique_ptr<ChunkPrefetcher> prefetch;
+    exr_compression_t compression = EXR_COMPRESSION_NONE;
+    size_t nchunks = size_t((yend - ychunkstart + scansperchunk - 1)
+                            / scansperchunk);
+    // Uncompressed chunks may be read straight into place instead.
+    if (nchunks > 1
+        && exr_get_compression(m_exr_context, subimage, &compression)
+               == EXR_ERR_SUCCESS
+        && compression != EXR_COMPRESSION_NONE) {
+        prefetch.reset(new ChunkPrefetcher(
+            m_userdata.m_io, nchunks,
+            [&](size_t i, exr_chunk_info_t& cinfo) {
+                int y = ychunkstart + int(i) * scansperchunk;
+                return exr_read_scanline_chunk_info(m_exr_context, subimage, y,
+                                                    &cinfo);
+            }));
+    }
     std::atomic<bool> ok(true);
     parallel_for_chunked(
         ychunkstart, yend, scansperchunk,
         [&](int64_t yb, int64_t ye) {
+            size_t chunkidx   = size_t((yb - ychunkstart) / scansperchunk);
             int y             = std::max(int(yb), ybegin);
             uint8_t* linedata = static_cast<uint8_t*>(data)
                                 + scanlinebytes * (y - ybegin);
@@ -1222,7 +1467,15 @@ OpenEXRCoreInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
             // handle scenario where caller asked us to read a scanline
             // that isn't aligned to a chunk boundary
             int invalid = (y - spec.y) % scansperchunk;
-            if (invalid != 0) {
+            if (convert) {
+                // Decode the whole chunk to our own buffer, to convert it
+                // into place right away.
+                static thread_local std::vector<uint8_t> chunkbuf;
+                chunkbuf.resize(scanlinebytes * scansperchunk);
+                nlines = scansperchunk - invalid;
+                cdata  = chunkbuf.data();
+                y      = y - invalid;
+            } else if (invalid != 0) {
                 // Our first scanline, ybegin, is not on a chunk boundary.
                 // We'll need to "back up" and read a whole chunk.
                 fullchunk.reset(new uint8_t[scanlinebytes * scansperchunk]);
@@ -1240,12 +1493,24 @@ OpenEXRCoreInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
             } else {
                 // We need a full aligned chunk. Everything is already set up.
             }
-            exr_result_t rv = exr_read_scanline_chunk_info(m_exr_context,
-                                                           subimage, y, &cinfo);
-            if (rv == EXR_ERR_SUCCESS)
+            // A chunk we use only part of may have been decoded already by
+            // the previous read, or may be wanted by the next.
+            size_t chunkbytes = scanlinebytes * scansperchunk;
+            bool morelater    = y + scansperchunk > yend && yend < endy;
+            bool cached       = (invalid != 0 || morelater)
+                          && find_kept_chunk(subimage, miplevel, y, chbegin,
+                                             chend, cdata, chunkbytes,
+                                             !morelater);
+            exr_result_t rv = EXR_ERR_SUCCESS;
+            if (prefetch)
+                rv = prefetch->chunk_info(chunkidx, cinfo);
+            else if (!cached)
+                rv = exr_read_scanline_chunk_info(m_exr_context, subimage, y,
+                                                  &cinfo);
+            if (rv == EXR_ERR_SUCCESS && !cached)
                 rv = exr_decoding_initialize(m_exr_context, subimage, &cinfo,
                                              &decoder);
-            if (rv == EXR_ERR_SUCCESS) {
+            if (rv == EXR_ERR_SUCCESS && !cached) {
                 size_t chanoffset = 0;
                 for (int c = chbegin; c < chend; ++c) {
                     size_t chanbytes  = spec.channelformat(c).size();
@@ -1264,11 +1529,24 @@ OpenEXRCoreInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
                 }
                 rv = exr_decoding_choose_default_routines(m_exr_context,
                                                           subimage, &decoder);
+                if (rv == EXR_ERR_SUCCESS && prefetch)
+                    prefetch->attach(chunkidx, decoder);
             }
-            if (rv == EXR_ERR_SUCCESS)
+            if (rv == EXR_ERR_SUCCESS && !cached) {
                 rv = exr_decoding_run(m_exr_context, subimage, &decoder);
+                if (rv == EXR_ERR_SUCCESS && morelater)
+                    keep_chunk(subimage, miplevel, y, chbegin, chend, cdata,
+                               chunkbytes);
+            }
+            if (prefetch)
+                prefetch->release(chunkidx);
             if (rv != EXR_ERR_SUCCESS) {
                 ok = false;
+            } else if (convert) {
+                y += invalid;
+                nlines = std::min(nlines, yend - y);
+                if (!convert(y, nlines, cdata + invalid * scanlinebytes))
+                    ok = false;
             } else if (cdata != linedata) {
                 y += invalid;
                 nlines = std::min(nlines, yend - y);
@@ -1320,6 +1598,42 @@ OpenEXRCoreInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
 
 
 
+bool
+OpenEXRCoreInput::find_kept_chunk(int subimage, int miplevel, int y,
+                                  int chbegin, int chend, uint8_t* pixels,
+                                  size_t bytes, bool last)
+{
+    std::lock_guard<std::mutex> lock(m_kept_chunk_mutex);
+    KeptChunk& k(m_kept_chunk);
+    if (k.subimage != subimage || k.miplevel != miplevel || k.y != y
+        || k.chbegin != chbegin || k.chend != chend || k.pixels.size() != bytes)
+        return false;
+    memcpy(pixels, k.pixels.data(), bytes);
+    if (last)
+        k = KeptChunk();
+    return true;
+}
+
+
+
+void
+OpenEXRCoreInput::keep_chunk(int subimage, int miplevel, int y, int chbegin,
+                             int chend, const uint8_t* pixels, size_t bytes)
+{
+    if (bytes > max_kept_chunk_bytes)
+        return;
+    std::lock_guard<std::mutex> lock(m_kept_chunk_mutex);
+    KeptChunk& k(m_kept_chunk);
+    k.subimage = subimage;
+    k.miplevel = miplevel;
+    k.y        = y;
+    k.chbegin  = chbegin;
+    k.chend    = chend;
+    k.pixels.assign(pixels, pixels + bytes);
+}
+
+
+
 bool
 OpenEXRCoreInput::read_native_tile(int subimage, int miplevel, int x, int y,
                                    int z, void* data)
@@ -1475,12 +1789,29 @@ OpenEXRCoreInput::read_native_tiles(int subimage, int miplevel, int xbegin,
         xend - xbegin, ybegin, yend, chbegin, chend - 1, firstxtile, firstytile,
         nxtiles, nytiles, pixelbytes, scanlinebytes, tilew, tileh);
 
+    std::unique_ptr<ChunkPrefetcher> prefetch;
+    exr_compression_t compression = EXR_COMPRESSION_NONE;
+    // Uncompressed chunks may be read straight into place instead.
+    if (nxtiles * nytiles > 1
+        && exr_get_compression(m_exr_context, subimage, &compression)
+               == EXR_ERR_SUCCESS
+        && compression != EXR_COMPRESSION_NONE) {
+        prefetch.reset(new ChunkPrefetcher(
+            m_userdata.m_io, size_t(nxtiles) * size_t(nytiles),
+            [&](size_t i, exr_chunk_info_t& cinfo) {
+                return exr_read_tile_chunk_info(
+                    m_exr_context, subimage, firstxtile + int(i % nxtiles),
+                    firstytile + int(i / nxtiles), miplevel, miplevel, &cinfo);
+            }));
+    }
+
     std::atomic<bool> ok(true);
     parallel_for_2D(
         0, nxtiles, 0, nytiles,
         [&](int64_t tx, int64_t ty) {
             int curytile         = firstytile + ty;
             int curxtile         = firstxtile + tx;
+            size_t chunkidx      = size_t(ty * nxtiles + tx);
             uint8_t* tilesetdata = static_cast<uint8_t*>(data);
             tilesetdata += ty * tileh * scanlinebytes;
             exr_chunk_info_t cinfo;
@@ -1488,10 +1819,12 @@ OpenEXRCoreInput::read_native_tiles(int subimage, int miplevel, int xbegin,
             DecoderDestroyer dd(m_exr_context, &decoder);
             // Note: the decoder will be destroyed by dd exiting scope
             uint8_t* curtilestart = tilesetdata + tx * tilew * pixelbytes;
-            exr_result_t rv = exr_read_tile_chunk_info(m_exr_context, subimage,
-                                                       curxtile, curytile,
-                                                       miplevel, miplevel,
-                                                       &cinfo);
+            exr_result_t rv
+                = prefetch ? prefetch->chunk_info(chunkidx, cinfo)
+                           : exr_read_tile_chunk_info(m_exr_context, subimage,
+                                                      curxtile, curytile,
+                                                      miplevel, miplevel,
+                                                      &cinfo);
             if (rv == EXR_ERR_SUCCESS)
                 rv = exr_decoding_initialize(m_exr_context, subimage, &cinfo,
                                              &decoder);
@@ -1514,9 +1847,13 @@ OpenEXRCoreInput::read_native_tiles(int subimage, int miplevel, int xbegin,
                 }
                 rv = exr_decoding_choose_default_routines(m_exr_context,
                                                           subimage, &decoder);
+                if (rv == EXR_ERR_SUCCESS && prefetch)
+                    prefetch->attach(chunkidx, decoder);
             }
             if (rv == EXR_ERR_SUCCESS)
                 rv = exr_decoding_run(m_exr_context, subimage, &decoder);
+            if (prefetch)
+                prefetch->release(chunkidx);
             if (rv != EXR_ERR_SUCCESS
                 && !check_fill_missing(xbegin + tx * tilew,
                                        xbegin + (tx + 1) * tilew,
@@ -982,7 +982,9 @@ OpenEXROutput::put_parameter(const std::string& name, TypeDesc type,
     if (Strutil::istarts_with(xname, "oiio:")) {
         if (Strutil::iequals(xname, "oiio:ConstantColor")
             || Strutil::iequals(xname, "oiio:AverageColor")
-            || Strutil::iequals(xname, "oiio:SHA-1")) {
+            || Strutil::iequals(xname, "oiio:TileStats")
+            || Strutil::iequals(xname, "oiio:SHA-1")
+            || Strutil::iequals(xname, "oiio:ContentHash")) {
             // let these fall through and get stored as metadata
         } else {
             // Other than the listed exceptions, suppress any other custom
@@ -1455,15 +1457,11 @@ OpenEXROutput::copy_image(ImageInput* in)
                         *exr_in->m_deep_tiled_input_part);
                     return true;
                 }
-            } catch (const std::exception& e) {
-                errorfmt(
-                    "Failed OpenEXR copy: {}, falling back to the default image copy routine.",
-                    e.what());
-                return false;
-            } catch (...) {  // catch-all for edge cases or compiler bugs
-                errorfmt(
-                    "Failed OpenEXR copy: unknown exception, falling back to the default image copy routine.");
-                return false;
+            } catch (...) {
+                // copyPixels throws before copying anything if the two
+                // parts differ in their channels, windows, compression, or
+                // line order, and then decoding and re-encoding is the only
+                // way. So fall back to the default image copy routine.
             }
         }
     }
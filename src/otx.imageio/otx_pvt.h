@@ -0,0 +1,140 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <OpenImageIO/fmath.h>
+#include <OpenImageIO/imageio.h>
+
+/*
+ * OTX ("OIIO raw tiled") is a trivial tiled format meant to be a local,
+ * already-decoded copy of textures that are slow to read -- maketx can
+ * write it -- whose tiles can be used without any processing at all.
+ *
+ * A file is laid out as:
+ *
+ *     Header            at offset 0
+ *     tiles             each uncompressed tile page-aligned
+ *     LevelRecord[n]    at Header::directory, one per subimage MIP level,
+ *                       subimages in order, each one's levels in order
+ *     ImageSpec         of each level (ImageSpec::to_binary()), at
+ *                       LevelRecord::spec
+ *     TileEntry[...]    of each level, at LevelRecord::tiles
+ *
+ * Everything is in the byte order of the machine that wrote it, which the
+ * header's `byteorder` identifies. Tiles are always full size (edge tiles
+ * padded with zeroes), contiguous, with all channels in the level's
+ * format. Uncompressed tiles start on a page boundary and are followed by
+ * at least OIIO_SIMD_MAX_SIZE_BYTES more bytes of the file, so they can be
+ * mapped and used in place. A tile may instead be compressed with zlib,
+ * when that made it smaller.
+ */
+
+OIIO_PLUGIN_NAMESPACE_BEGIN
+
+namespace otx_pvt {
+
+static const char magic[4]         = { 'O', 'T', 'X', '1' };
+static const uint32_t byteorder    = 0x01020304;
+static const uint32_t version      = 1;
+static const uint32_t page_size    = 4096;
+static const uint32_t tile_zlib    = 1;  ///< TileEntry flag
+static const uint32_t max_channels = 1024;
+
+
+struct Header {
+    char magic[4];
+    uint32_t byteorder;
+    uint32_t version;
+    uint32_t page_size;  ///< Alignment of uncompressed tiles
+    uint32_t nlevels;    ///< Number of LevelRecords
+    uint32_t reserved;
+    uint64_t directory;  ///< Offset of the LevelRecords
+
+    void swap()
+    {
+        swap_endian(&byteorder);
+        swap_endian(&version);
+        swap_endian(&page_size);
+        swap_endian(&nlevels);
+        swap_endian(&directory);
+    }
+};
+static_assert(sizeof(Header) == 32, "otx Header must not be padded");
+
+
+struct LevelRecord {
+    int32_t subimage, miplevel;
+    int32_t x, y, width, height;
+    int32_t tile_width, tile_height;
+    int32_t nchannels;
+    uint32_t basetype;  ///< TypeDesc::BASETYPE of all channels
+    uint32_t reserved[2];
+    uint64_t spec, spec_bytes;  ///< The level's ImageSpec::to_binary()
+    uint64_t tiles, ntiles;     ///< The level's TileEntry table
+    uint64_t tile_bytes;        ///< Size of an uncompressed tile
+
+    TypeDesc format() const { return TypeDesc(TypeDesc::BASETYPE(basetype)); }
+    int nxtiles() const { return (width + tile_width - 1) / tile_width; }
+    int nytiles() const { return (height + tile_height - 1) / tile_height; }
+
+    void swap()
+    {
+        swap_endian(&subimage, 9);
+        swap_endian(&basetype);
+        swap_endian(&spec, 5);
+    }
+
+    // Sensible geometry and a tile table of the size it implies.
+    bool valid() const
+    {
+        TypeDesc f = format();
+        return width > 0 && height > 0 && tile_width > 0 && tile_height > 0
+               && nchannels > 0 && uint32_t(nchannels) <= max_channels
+               && basetype > TypeDesc::NONE && basetype < TypeDesc::LASTBASE
+               && f.size() > 0
+               && ntiles == uint64_t(nxtiles()) * uint64_t(nytiles())
+               && tile_bytes
+                      == uint64_t(tile_width) * uint64_t(tile_height)
+                             * uint64_t(nchannels) * f.size();
+    }
+};
+static_assert(sizeof(LevelRecord) == 88, "otx LevelRecord must not be padded");
+
+
+struct TileEntry {
+    uint64_t offset;  ///< 0 if the tile was never written
+    uint32_t bytes;   ///< Size as stored
+    uint32_t flags;   ///< tile_zlib if compressed
+
+    void swap()
+    {
+        swap_endian(&offset);
+        swap_endian(&bytes);
+        swap_endian(&flags);
+    }
+};
+static_assert(sizeof(TileEntry) == 16, "otx TileEntry must not be padded");
+
+
+// Does the header identify an otx file? Set `swab` if it's in the other
+// byte order.
+inline bool
+valid_header(const Header& header, bool& swab)
+{
+    if (memcmp(header.magic, magic, 4))
+        return false;
+    uint32_t order = header.byteorder;
+    swab           = (order != byteorder);
+    if (swab)
+        swap_endian(&order);
+    return order == byteorder;
+}
+
+}  // namespace otx_pvt
+
+OIIO_PLUGIN_NAMESPACE_END
@@ -0,0 +1,406 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+#include <algorithm>
+#include <vector>
+
+#include <zlib.h>
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/fmath.h>
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/strutil.h>
+
+#include "otx_pvt.h"
+
+OIIO_PLUGIN_NAMESPACE_BEGIN
+
+using namespace otx_pvt;
+
+
+class OtxInput final : public ImageInput {
+public:
+    OtxInput() { init(); }
+    ~OtxInput() override { close(); }
+    const char* format_name(void) const override { return "otx"; }
+    int supports(string_view feature) const override
+    {
+        return feature == "ioproxy";
+    }
+    bool valid_file(Filesystem::IOProxy* ioproxy) const override;
+    bool open(const std::string& name, ImageSpec& newspec) override;
+    bool open(const std::string& name, ImageSpec& newspec,
+              const ImageSpec& config) override;
+    bool close(void) override;
+    int current_subimage(void) const override
+    {
+        lock_guard lock(*this);
+        return m_subimage;
+    }
+    int current_miplevel(void) const override
+    {
+        lock_guard lock(*this);
+        return m_miplevel;
+    }
+    bool seek_subimage(int subimage, int miplevel) override;
+    ImageSpec spec(int subimage, int miplevel) override;
+    ImageSpec spec_dimensions(int subimage, int miplevel) override;
+    bool read_native_scanline(int subimage, int miplevel, int y, int z,
+                              void* data) override;
+    bool read_native_tile(int subimage, int miplevel, int x, int y, int z,
+                          void* data) override;
+
+private:
+    struct Level {
+        LevelRecord rec;
+        ImageSpec spec;
+        std::vector<TileEntry> tiles;
+    };
+    // Levels of each subimage
+    std::vector<std::vector<Level>> m_subimages;
+    int m_subimage = -1;
+    int m_miplevel = -1;
+    bool m_swab    = false;
+    std::vector<unsigned char> m_compressed;
+    std::vector<char> m_tilebuf;  // For read_native_scanline
+
+    void init()
+    {
+        m_subimages.clear();
+        m_subimage = -1;
+        m_miplevel = -1;
+        m_swab     = false;
+        m_compressed.clear();
+        m_tilebuf.clear();
+        ioproxy_clear();
+    }
+
+    const Level* level(int subimage, int miplevel) const
+    {
+        if (subimage < 0 || subimage >= int(m_subimages.size())
+            || miplevel < 0 || miplevel >= int(m_subimages[subimage].size()))
+            return nullptr;
+        return &m_subimages[subimage][miplevel];
+    }
+
+    bool read_directory();
+    bool read_tile(const Level& lev, int tile, void* data);
+};
+
+
+
+// Obligatory material to make this a recognizable imageio plugin:
+OIIO_PLUGIN_EXPORTS_BEGIN
+
+OIIO_EXPORT int otx_imageio_version = OIIO_PLUGIN_VERSION;
+
+OIIO_EXPORT const char*
+otx_imageio_library_version()
+{
+    return nullptr;
+}
+
+OIIO_EXPORT ImageInput*
+otx_input_imageio_create()
+{
+    return new OtxInput;
+}
+
+OIIO_EXPORT const char* otx_input_extensions[] = { "otx", nullptr };
+
+OIIO_PLUGIN_EXPORTS_END
+
+
+
+bool
+OtxInput::valid_file(Filesystem::IOProxy* ioproxy) const
+{
+    if (!ioproxy || ioproxy->mode() != Filesystem::IOProxy::Mode::Read)
+        return false;
+    Header header;
+    bool swab;
+    return ioproxy->pread(&header, sizeof(header), 0) == sizeof(header)
+           && valid_header(header, swab);
+}
+
+
+
+bool
+OtxInput::open(const std::string& name, ImageSpec& newspec,
+               const ImageSpec& config)
+{
+    ioproxy_retrieve_from_config(config);
+    return open(name, newspec);
+}
+
+
+
+bool
+OtxInput::open(const std::string& name, ImageSpec& newspec)
+{
+    if (!ioproxy_use_or_open(name))
+        return false;
+    if (!read_directory()) {
+        close();
+        return false;
+    }
+    bool ok = seek_subimage(0, 0);
+    newspec = m_spec;
+    return ok;
+}
+
+
+
+bool
+OtxInput::read_directory()
+{
+    Filesystem::IOProxy* io = ioproxy();
+    Header header;
+    if (io->pread(&header, sizeof(header), 0) != sizeof(header)
+        || !valid_header(header, m_swab)) {
+        errorfmt("\"{}\" is not an otx file", io->filename());
+        return false;
+    }
+    if (m_swab)
+        header.swap();
+    if (header.version != version) {
+        errorfmt("\"{}\" is otx version {}, which is not supported",
+                 io->filename(), header.version);
+        return false;
+    }
+
+    uint64_t filesize = io->size();
+    if (!header.nlevels || header.directory > filesize
+        || header.nlevels
+               > (filesize - header.directory) / sizeof(LevelRecord)) {
+        errorfmt("Corrupt otx directory in \"{}\"", io->filename());
+        return false;
+    }
+    std::vector<LevelRecord> recs(header.nlevels);
+    size_t recbytes = recs.size() * sizeof(LevelRecord);
+    if (io->pread(recs.data(), recbytes, header.directory) != recbytes) {
+        errorfmt("Could not read the otx directory of \"{}\"", io->filename());
+        return false;
+    }
+    for (auto& rec : recs) {
+        if (m_swab)
+            rec.swap();
+        // Levels must come in order, with nothing missing.
+        int nsub = int(m_subimages.size());
+        bool ok  = rec.valid()
+                  && ((rec.subimage == nsub && rec.miplevel == 0)
+                      || (nsub && rec.subimage == nsub - 1
+                          && rec.miplevel == int(m_subimages.back().size())))
+                  && rec.spec <= filesize && rec.spec_bytes < (1 << 30)
+                  && rec.spec_bytes <= filesize - rec.spec
+                  && rec.tiles <= filesize
+                  && rec.ntiles <= (filesize - rec.tiles) / sizeof(TileEntry);
+        if (!ok) {
+            errorfmt("Corrupt otx directory in \"{}\"", io->filename());
+            return false;
+        }
+        if (rec.subimage == nsub)
+            m_subimages.emplace_back();
+        m_subimages.back().emplace_back();
+        Level& lev(m_subimages.back().back());
+        lev.rec = rec;
+
+        std::string specdata(size_t(rec.spec_bytes), '\0');
+        lev.tiles.resize(size_t(rec.ntiles));
+        size_t tilebytes = lev.tiles.size() * sizeof(TileEntry);
+        if (io->pread(&specdata[0], specdata.size(), rec.spec)
+                != specdata.size()
+            || io->pread(lev.tiles.data(), tilebytes, rec.tiles)
+                   != tilebytes) {
+            errorfmt("Could not read the otx directory of \"{}\"",
+                     io->filename());
+            return false;
+        }
+        for (auto& t : lev.tiles) {
+            if (m_swab)
+                t.swap();
+            if (t.offset > filesize || t.bytes > filesize - t.offset
+                || (!(t.flags & tile_zlib) && t.offset
+                    && t.bytes != rec.tile_bytes)) {
+                errorfmt("Corrupt otx tile table in \"{}\"", io->filename());
+                return false;
+            }
+        }
+
+        // The metadata of the level comes from its spec, but not what's
+        // needed to find the pixels.
+        if (!lev.spec.from_binary(specdata)) {
+            errorfmt("Corrupt otx spec in \"{}\"", io->filename());
+            return false;
+        }
+        lev.spec.x           = rec.x;
+        lev.spec.y           = rec.y;
+        lev.spec.z           = 0;
+        lev.spec.width       = rec.width;
+        lev.spec.height      = rec.height;
+        lev.spec.depth       = 1;
+        lev.spec.tile_width  = rec.tile_width;
+        lev.spec.tile_height = rec.tile_height;
+        lev.spec.tile_depth  = 1;
+        lev.spec.nchannels   = rec.nchannels;
+        lev.spec.format      = rec.format();
+        lev.spec.channelformats.clear();
+        lev.spec.deep = false;
+        lev.spec.channelnames.resize(rec.nchannels);
+        for (int c = 0; c < rec.nchannels; ++c)
+            if (lev.spec.channelnames[c].empty())
+                lev.spec.channelnames[c] = Strutil::fmt::format("channel{}",
+                                                                c);
+        if (lev.spec.alpha_channel >= rec.nchannels)
+            lev.spec.alpha_channel = -1;
+        if (lev.spec.z_channel >= rec.nchannels)
+            lev.spec.z_channel = -1;
+    }
+    return true;
+}
+
+
+
+bool
+OtxInput::seek_subimage(int subimage, int miplevel)
+{
+    if (subimage == m_subimage && miplevel == m_miplevel)
+        return true;
+    const Level* lev = level(subimage, miplevel);
+    if (!lev)
+        return false;
+    m_subimage = subimage;
+    m_miplevel = miplevel;
+    m_spec     = lev->spec;
+    return true;
+}
+
+
+
+ImageSpec
+OtxInput::spec(int subimage, int miplevel)
+{
+    lock_guard lock(*this);
+    const Level* lev = level(subimage, miplevel);
+    return lev ? lev->spec : ImageSpec();
+}
+
+
+
+ImageSpec
+OtxInput::spec_dimensions(int subimage, int miplevel)
+{
+    lock_guard lock(*this);
+    ImageSpec spec;
+    if (const Level* lev = level(subimage, miplevel))
+        spec.copy_dimensions(lev->spec);
+    return spec;
+}
+
+
+
+bool
+OtxInput::read_tile(const Level& lev, int tile, void* data)
+{
+    const TileEntry& t(lev.tiles[tile]);
+    size_t tilebytes = size_t(lev.rec.tile_bytes);
+    Filesystem::IOProxy* io = ioproxy();
+    if (!t.offset) {
+        // Never written
+        memset(data, 0, tilebytes);
+        return true;
+    }
+    if (t.flags & tile_zlib) {
+        m_compressed.resize(t.bytes);
+        uLongf destlen = uLongf(tilebytes);
+        if (io->pread(m_compressed.data(), t.bytes, t.offset) != t.bytes
+            || uncompress((Bytef*)data, &destlen, m_compressed.data(),
+                          uLong(t.bytes))
+                   != Z_OK
+            || destlen != tilebytes) {
+            errorfmt("Could not read or decompress otx tile {} of \"{}\"",
+                     tile, io->filename());
+            return false;
+        }
+    } else if (io->pread(data, tilebytes, t.offset) != tilebytes) {
+        errorfmt("Could not read otx tile {} of \"{}\"", tile, io->filename());
+        return false;
+    }
+    if (m_swab) {
+        size_t n = tilebytes / lev.spec.format.size();
+        switch (lev.spec.format.size()) {
+        case 2: swap_endian((uint16_t*)data, int(n)); break;
+        case 4: swap_endian((uint32_t*)data, int(n)); break;
+        case 8: swap_endian((uint64_t*)data, int(n)); break;
+        default: break;
+        }
+    }
+    return true;
+}
+
+
+
+bool
+OtxInput::read_native_tile(int subimage, int miplevel, int x, int y, int z,
+                           void* data)
+{
+    lock_guard lock(*this);
+    const Level* lev = level(subimage, miplevel);
+    if (!lev)
+        return false;
+    const ImageSpec& spec(lev->spec);
+    if (z != 0 || (x - spec.x) % spec.tile_width
+        || (y - spec.y) % spec.tile_height || x < spec.x || y < spec.y
+        || x >= spec.x + spec.width || y >= spec.y + spec.height) {
+        errorfmt("Invalid tile origin ({}, {}, {})", x, y, z);
+        return false;
+    }
+    int tile = (x - spec.x) / spec.tile_width
+               + ((y - spec.y) / spec.tile_height) * lev->rec.nxtiles();
+    return read_tile(*lev, tile, data);
+}
+
+
+
+bool
+OtxInput::read_native_scanline(int subimage, int miplevel, int y, int z,
+                               void* data)
+{
+    // The file has only tiles, so read the row of them that holds the
+    // scanline, and copy its part of each.
+    lock_guard lock(*this);
+    const Level* lev = level(subimage, miplevel);
+    if (!lev)
+        return false;
+    const ImageSpec& spec(lev->spec);
+    if (z != 0 || y < spec.y || y >= spec.y + spec.height) {
+        errorfmt("Invalid scanline {}", y);
+        return false;
+    }
+    m_tilebuf.resize(size_t(lev->rec.tile_bytes));
+    size_t pixelbytes = spec.pixel_bytes(true);
+    size_t tilerow    = pixelbytes * spec.tile_width;
+    int ty            = (y - spec.y) / spec.tile_height;
+    int yoff          = (y - spec.y) % spec.tile_height;
+    int nxtiles       = lev->rec.nxtiles();
+    for (int tx = 0; tx < nxtiles; ++tx) {
+        if (!read_tile(*lev, tx + ty * nxtiles, m_tilebuf.data()))
+            return false;
+        int w = std::min(spec.tile_width, spec.width - tx * spec.tile_width);
+        memcpy((char*)data + tx * tilerow, m_tilebuf.data() + yoff * tilerow,
+               w * pixelbytes);
+    }
+    return true;
+}
+
+
+
+bool
+OtxInput::close()
+{
+    init();
+    return true;
+}
+
+OIIO_PLUGIN_NAMESPACE_END
@@ -0,0 +1,339 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+#include <algorithm>
+#include <vector>
+
+#include <zlib.h>
+
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/fmath.h>
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/strutil.h>
+
+#include "otx_pvt.h"
+
+OIIO_PLUGIN_NAMESPACE_BEGIN
+
+using namespace otx_pvt;
+
+
+class OtxOutput final : public ImageOutput {
+public:
+    OtxOutput() { init(); }
+    ~OtxOutput() override { close(); }
+    const char* format_name(void) const override { return "otx"; }
+    int supports(string_view feature) const override
+    {
+        return feature == "tiles" || feature == "mipmap"
+               || feature == "multiimage" || feature == "appendsubimage"
+               || feature == "origin" || feature == "negativeorigin"
+               || feature == "displaywindow" || feature == "alpha"
+               || feature == "nchannels" || feature == "arbitrary_metadata"
+               || feature == "exif" || feature == "iptc"
+               || feature == "ioproxy";
+    }
+    bool open(const std::string& name, const ImageSpec& spec,
+              OpenMode mode = Create) override;
+    bool close() override;
+    bool write_scanline(int y, int z, TypeDesc format, const void* data,
+                        stride_t xstride) override;
+    bool write_tile(int x, int y, int z, TypeDesc format, const void* data,
+                    stride_t xstride, stride_t ystride,
+                    stride_t zstride) override;
+
+private:
+    std::vector<LevelRecord> m_levels;
+    std::vector<std::string> m_specs;              // Spec of each level
+    std::vector<std::vector<TileEntry>> m_tiles;  // Tiles of each level
+    uint64_t m_end;  // Where the next thing will be written
+    int m_zlevel;    // zlib level, or -1 to not compress
+    std::vector<unsigned char> m_scratch;
+    std::vector<unsigned char> m_compressed;
+    std::vector<unsigned char> m_buffer;  // The level, if scanlines
+
+    void init()
+    {
+        m_levels.clear();
+        m_specs.clear();
+        m_tiles.clear();
+        m_end    = 0;
+        m_zlevel = -1;
+        m_scratch.clear();
+        m_compressed.clear();
+        m_buffer.clear();
+        ioproxy_clear();
+    }
+
+    void begin_level(int subimage, int miplevel);
+    bool finish_level();
+    bool write_padding(uint64_t alignment, uint64_t minbytes = 0);
+    bool store_tile(int tile, const void* data);
+};
+
+
+
+OIIO_PLUGIN_EXPORTS_BEGIN
+
+OIIO_EXPORT ImageOutput*
+otx_output_imageio_create()
+{
+    return new OtxOutput;
+}
+
+OIIO_EXPORT const char* otx_output_extensions[] = { "otx", nullptr };
+
+OIIO_PLUGIN_EXPORTS_END
+
+
+
+bool
+OtxOutput::open(const std::string& name, const ImageSpec& userspec,
+                OpenMode mode)
+{
+    if (mode == Create) {
+        close();  // Close any already-opened file
+    } else if (!ioproxy_opened()) {
+        errorfmt("{} may not append to a file that is not open",
+                 format_name());
+        return false;
+    } else if (!finish_level()) {
+        return false;
+    }
+
+    if (!check_open(mode, userspec,
+                    { -(1 << 30), 1 << 30, -(1 << 30), 1 << 30, 0, 1, 0,
+                      int(max_channels) }))
+        return false;
+    if (m_spec.deep) {
+        errorfmt("{} does not support deep images", format_name());
+        return false;
+    }
+    // Untiled images are written as 64x64 tiles.
+    if (!m_spec.tile_width || !m_spec.tile_height) {
+        m_spec.tile_width  = 64;
+        m_spec.tile_height = 64;
+    }
+    m_spec.tile_depth = 1;
+
+    auto comp = m_spec.decode_compression_metadata("none", 6);
+    if (Strutil::iequals(comp.first, "zip"))
+        m_zlevel = clamp(comp.second, 1, 9);
+    else {
+        m_zlevel = -1;
+        m_spec.attribute("compression", "none");
+    }
+
+    if (mode == Create) {
+        ioproxy_retrieve_from_config(m_spec);
+        if (!ioproxy_use_or_open(name))
+            return false;
+        // The header is written for real when the file is closed.
+        Header header = {};
+        if (!iowrite(&header, sizeof(header)))
+            return false;
+        m_end = sizeof(header);
+        begin_level(0, 0);
+    } else if (mode == AppendSubimage) {
+        begin_level(m_levels.back().subimage + 1, 0);
+    } else {
+        begin_level(m_levels.back().subimage, m_levels.back().miplevel + 1);
+    }
+    return true;
+}
+
+
+
+void
+OtxOutput::begin_level(int subimage, int miplevel)
+{
+    LevelRecord rec = {};
+    rec.subimage    = subimage;
+    rec.miplevel    = miplevel;
+    rec.x           = m_spec.x;
+    rec.y           = m_spec.y;
+    rec.width       = m_spec.width;
+    rec.height      = m_spec.height;
+    rec.tile_width  = m_spec.tile_width;
+    rec.tile_height = m_spec.tile_height;
+    rec.nchannels   = m_spec.nchannels;
+    rec.basetype    = m_spec.format.basetype;
+    rec.ntiles      = uint64_t(rec.nxtiles()) * uint64_t(rec.nytiles());
+    rec.tile_bytes  = m_spec.tile_bytes(true);
+    m_levels.push_back(rec);
+    m_specs.push_back(m_spec.to_binary());
+    m_tiles.emplace_back(size_t(rec.ntiles), TileEntry {});
+}
+
+
+
+bool
+OtxOutput::write_padding(uint64_t alignment, uint64_t minbytes)
+{
+    static const char zeros[page_size] = {};
+    uint64_t end = round_to_multiple(m_end + minbytes, alignment);
+    while (m_end < end) {
+        size_t n = size_t(std::min(end - m_end, uint64_t(page_size)));
+        if (!iowrite(zeros, n))
+            return false;
+        m_end += n;
+    }
+    return true;
+}
+
+
+
+bool
+OtxOutput::store_tile(int tile, const void* data)
+{
+    const LevelRecord& rec(m_levels.back());
+    TileEntry& entry(m_tiles.back()[tile]);
+    if (m_zlevel >= 0) {
+        // Keep the compressed tile only if it's any smaller.
+        uLongf len = compressBound(uLong(rec.tile_bytes));
+        m_compressed.resize(len);
+        if (compress2(m_compressed.data(), &len, (const Bytef*)data,
+                      uLong(rec.tile_bytes), m_zlevel)
+                == Z_OK
+            && len < rec.tile_bytes) {
+            if (!iowrite(m_compressed.data(), len))
+                return false;
+            entry.offset = m_end;
+            entry.bytes  = uint32_t(len);
+            entry.flags  = tile_zlib;
+            m_end += len;
+            return true;
+        }
+    }
+    if (!write_padding(page_size) || !iowrite(data, size_t(rec.tile_bytes)))
+        return false;
+    entry.offset = m_end;
+    entry.bytes  = uint32_t(rec.tile_bytes);
+    entry.flags  = 0;
+    m_end += rec.tile_bytes;
+    return true;
+}
+
+
+
+bool
+OtxOutput::write_tile(int x, int y, int z, TypeDesc format, const void* data,
+                      stride_t xstride, stride_t ystride, stride_t zstride)
+{
+    if (!ioproxy_opened()) {
+        errorfmt("File not open");
+        return false;
+    }
+    if (!m_buffer.empty()) {
+        // Scanlines have been written too, so tiles go in the buffer.
+        return copy_tile_to_image_buffer(x, y, z, format, data, xstride,
+                                         ystride, zstride, m_buffer.data());
+    }
+    const LevelRecord& rec(m_levels.back());
+    if (z != 0 || x < m_spec.x || y < m_spec.y
+        || x >= m_spec.x + m_spec.width || y >= m_spec.y + m_spec.height
+        || (x - m_spec.x) % m_spec.tile_width
+        || (y - m_spec.y) % m_spec.tile_height) {
+        errorfmt("Invalid tile origin ({}, {}, {})", x, y, z);
+        return false;
+    }
+    int tile = (x - m_spec.x) / m_spec.tile_width
+               + ((y - m_spec.y) / m_spec.tile_height) * rec.nxtiles();
+    data     = to_native_tile(format, data, xstride, ystride, zstride,
+                              m_scratch);
+    return store_tile(tile, data);
+}
+
+
+
+bool
+OtxOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
+                          stride_t xstride)
+{
+    if (!ioproxy_opened()) {
+        errorfmt("File not open");
+        return false;
+    }
+    // Scanlines are buffered until the whole level is there to be cut
+    // into tiles.
+    if (m_buffer.empty())
+        m_buffer.resize(m_spec.image_bytes(true));
+    return copy_to_image_buffer(m_spec.x, m_spec.x + m_spec.width, y, y + 1, z,
+                                z + 1, format, data, xstride, AutoStride,
+                                AutoStride, m_buffer.data());
+}
+
+
+
+bool
+OtxOutput::finish_level()
+{
+    if (m_buffer.empty())
+        return true;
+    // Cut the buffered level into tiles, padding the edges with zeroes.
+    const LevelRecord& rec(m_levels.back());
+    size_t pixelbytes = m_spec.pixel_bytes(true);
+    size_t rowbytes   = pixelbytes * m_spec.width;
+    size_t tilerow    = pixelbytes * m_spec.tile_width;
+    std::vector<unsigned char> tile(size_t(rec.tile_bytes));
+    bool ok = true;
+    for (int ty = 0; ok && ty < rec.nytiles(); ++ty) {
+        for (int tx = 0; ok && tx < rec.nxtiles(); ++tx) {
+            int x0 = tx * m_spec.tile_width, y0 = ty * m_spec.tile_height;
+            int w  = std::min(m_spec.tile_width, m_spec.width - x0);
+            int h  = std::min(m_spec.tile_height, m_spec.height - y0);
+            if (w < m_spec.tile_width || h < m_spec.tile_height)
+                std::fill(tile.begin(), tile.end(), 0);
+            for (int j = 0; j < h; ++j)
+                memcpy(tile.data() + j * tilerow,
+                       m_buffer.data() + (y0 + j) * rowbytes
+                           + x0 * pixelbytes,
+                       w * pixelbytes);
+            ok = store_tile(tx + ty * rec.nxtiles(), tile.data());
+        }
+    }
+    std::vector<unsigned char>().swap(m_buffer);
+    return ok;
+}
+
+
+
+bool
+OtxOutput::close()
+{
+    if (!ioproxy_opened()) {  // already closed
+        init();
+        return true;
+    }
+
+    // Leave room for reading past the last tile, then write the specs, the
+    // tile tables, the directory, and finally the header that says where
+    // it all is.
+    bool ok = finish_level() && write_padding(8, OIIO_SIMD_MAX_SIZE_BYTES);
+    for (size_t i = 0; ok && i < m_levels.size(); ++i) {
+        m_levels[i].spec       = m_end;
+        m_levels[i].spec_bytes = m_specs[i].size();
+        ok = iowrite(m_specs[i].data(), m_specs[i].size());
+        m_end += m_specs[i].size();
+        ok = ok && write_padding(8);
+        m_levels[i].tiles = m_end;
+        ok = ok && iowrite(m_tiles[i].data(), sizeof(TileEntry),
+                           m_tiles[i].size());
+        m_end += sizeof(TileEntry) * m_tiles[i].size();
+    }
+    Header header = {};
+    memcpy(header.magic, magic, sizeof(header.magic));
+    header.byteorder = byteorder;
+    header.version   = version;
+    header.page_size = page_size;
+    header.nlevels   = uint32_t(m_levels.size());
+    header.directory = m_end;
+    ok = ok && iowrite(m_levels.data(), sizeof(LevelRecord), m_levels.size())
+         && ioseek(0) && iowrite(&header, sizeof(header));
+
+    init();
+    return ok;
+}
+
+OIIO_PLUGIN_NAMESPACE_END
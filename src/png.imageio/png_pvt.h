@@ -179,11 +179,12 @@ decode_png_text_exif(string_view raw, ImageSpec& spec)
 
 
 /// Read information from a PNG file and fill the ImageSpec accordingly.
+/// If headeronly is true, skip the ICC profile, text, XMP, and Exif.
 ///
 inline bool
 read_info(png_structp& sp, png_infop& ip, int& bit_depth, int& color_type,
           int& interlace_type, Imath::Color3f& bg, ImageSpec& spec,
-          bool keep_unassociated_alpha)
+          bool keep_unassociated_alpha, bool headeronly = false)
 {
     // Must call this setjmp in every function that does PNG reads
     if (setjmp(png_jmpbuf(sp))) {  // NOLINT(cert-err52-cpp)
@@ -238,7 +239,7 @@ read_info(png_structp& sp, png_infop& ip, int& bit_depth, int& color_type,
         set_colorspace(spec, "sRGB");
     }
 
-    if (png_get_valid(sp, ip, PNG_INFO_iCCP)) {
+    if (!headeronly && png_get_valid(sp, ip, PNG_INFO_iCCP)) {
         png_charp profile_name     = nullptr;
         png_bytep profile_data     = nullptr;
         png_uint_32 profile_length = 0;
@@ -270,8 +271,8 @@ read_info(png_structp& sp, png_infop& ip, int& bit_depth, int& color_type,
         spec.attribute("DateTime", date);
     }
 
-    png_textp text_ptr;
-    int num_comments = png_get_text(sp, ip, &text_ptr, NULL);
+    png_textp text_ptr = nullptr;
+    int num_comments = headeronly ? 0 : png_get_text(sp, ip, &text_ptr, NULL);
     for (int i = 0; i < num_comments; ++i) {
         if (Strutil::iequals(text_ptr[i].key, "Description"))
             spec.attribute("ImageDescription", text_ptr[i].text);
@@ -333,7 +334,7 @@ read_info(png_structp& sp, png_infop& ip, int& bit_depth, int& color_type,
     // text embedding of Exif we handle with decode_png_text_exif.
     png_uint_32 num_exif = 0;
     png_bytep exif_data  = nullptr;
-    if (png_get_eXIf_1(sp, ip, &num_exif, &exif_data)) {
+    if (!headeronly && png_get_eXIf_1(sp, ip, &num_exif, &exif_data)) {
         decode_exif(cspan<uint8_t>(exif_data, span_size_t(num_exif)), spec);
     }
 #endif
@@ -6,6 +6,7 @@
 #include <cstdio>
 #include <cstdlib>
 
+#include "imageio_pvt.h"
 #include "png_pvt.h"
 
 OIIO_PLUGIN_NAMESPACE_BEGIN
@@ -46,9 +47,10 @@ private:
     int m_next_scanline;
     bool m_keep_unassociated_alpha;  ///< Do not convert unassociated alpha
     bool m_linear_premult;           ///< Do premult for sRGB images in linear
-    bool m_srgb   = false;           ///< It's an sRGB image (not gamma)
-    bool m_err    = false;
-    float m_gamma = 1.0f;
+    bool m_srgb       = false;       ///< It's an sRGB image (not gamma)
+    bool m_headeronly = false;       ///< Skip the metadata chunks
+    bool m_err        = false;
+    float m_gamma     = 1.0f;
     std::unique_ptr<ImageSpec> m_config;  // Saved copy of configuration spec
 
     /// Reset everything to initial state
@@ -63,6 +65,7 @@ private:
         m_keep_unassociated_alpha = false;
         m_linear_premult = OIIO::get_int_attribute("png:linear_premult");
         m_srgb           = false;
+        m_headeronly     = false;
         m_err            = false;
         m_gamma          = 1.0;
         m_config.reset();
@@ -73,6 +76,18 @@ private:
     ///
     bool readimg();
 
+#if defined(USE_LIBDEFLATE)
+    // With libdeflate, inflating all the image data at once is so much
+    // faster than libpng's way, a row at a time, that we read the image
+    // ourselves whenever libpng would do no more than byte swap the
+    // unfiltered pixels. Return false if it wouldn't or if anything goes
+    // wrong, for libpng to read it instead.
+    bool read_direct();
+    static constexpr bool m_read_whole = true;
+#else
+    static constexpr bool m_read_whole = false;
+#endif
+
     /// Extract the background color.
     ///
     bool get_background(float* red, float* green, float* blue);
@@ -163,7 +178,7 @@ PNGInput::open(const std::string& name, ImageSpec& newspec)
 
     bool ok = PNG_pvt::read_info(m_png, m_info, m_bit_depth, m_color_type,
                                  m_interlace_type, m_bg, m_spec,
-                                 m_keep_unassociated_alpha);
+                                 m_keep_unassociated_alpha, m_headeronly);
     if (!ok || m_err
         || !check_open(m_spec, { 0, 1 << 20, 0, 1 << 20, 0, 1, 0, 4 })) {
         close();
@@ -191,6 +206,7 @@ PNGInput::open(const std::string& name, ImageSpec& newspec,
     // Check 'config' for any special requests
     if (config.get_int_attribute("oiio:UnassociatedAlpha", 0) == 1)
         m_keep_unassociated_alpha = true;
+    m_headeronly     = config.get_int_attribute("oiio:headeronly", 0) == 1;
     m_linear_premult = config.get_int_attribute("png:linear_premult",
                                                 OIIO::get_int_attribute(
                                                     "png:linear_premult"));
@@ -204,6 +220,10 @@ PNGInput::open(const std::string& name, ImageSpec& newspec,
 bool
 PNGInput::readimg()
 {
+#if defined(USE_LIBDEFLATE)
+    if (m_interlace_type == PNG_INTERLACE_NONE && read_direct())
+        return true;
+#endif
     std::string s = PNG_pvt::read_into_buffer(m_png, m_info, m_spec, m_buf);
     if (s.length() || m_err || has_error()) {
         close();
@@ -217,6 +237,117 @@ PNGInput::readimg()
 
 
 
+#if defined(USE_LIBDEFLATE)
+
+// Undo the filter of one row (its first byte is the filter type) given the
+// unfiltered row above it.
+static bool
+unfilter_row(const unsigned char* in, const unsigned char* prev,
+             size_t rowbytes, size_t bpp, unsigned char* out)
+{
+    int filter = *in++;
+    switch (filter) {
+    case PNG_FILTER_VALUE_NONE: memcpy(out, in, rowbytes); break;
+    case PNG_FILTER_VALUE_SUB:
+        for (size_t i = 0; i < rowbytes; ++i)
+            out[i] = in[i] + (i >= bpp ? out[i - bpp] : 0);
+        break;
+    case PNG_FILTER_VALUE_UP:
+        for (size_t i = 0; i < rowbytes; ++i)
+            out[i] = in[i] + prev[i];
+        break;
+    case PNG_FILTER_VALUE_AVG:
+        for (size_t i = 0; i < rowbytes; ++i)
+            out[i] = in[i] + ((i >= bpp ? out[i - bpp] : 0) + prev[i]) / 2;
+        break;
+    case PNG_FILTER_VALUE_PAETH:
+        for (size_t i = 0; i < rowbytes; ++i) {
+            int a  = i >= bpp ? out[i - bpp] : 0;   // left
+            int b  = prev[i];                       // above
+            int c  = i >= bpp ? prev[i - bpp] : 0;  // above left
+            int p  = a + b - c;
+            int pa = std::abs(p - a), pb = std::abs(p - b);
+            int pc = std::abs(p - c);
+            out[i] = in[i] + ((pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c));
+        }
+        break;
+    default: return false;
+    }
+    return true;
+}
+
+
+
+bool
+PNGInput::read_direct()
+{
+    // After the signature, each chunk is a big-endian 4 byte length, the
+    // 4 byte type, the data, and a CRC (which, for the image data, the
+    // zlib stream's own checksum makes superfluous). The data of all the
+    // consecutive IDAT chunks, joined, is the zlib stream.
+    Filesystem::IOProxy* io = ioproxy();
+    int64_t pos             = 8;
+    std::vector<unsigned char> zdata;
+    for (;;) {
+        unsigned char head[8];
+        if (io->pread(head, sizeof(head), pos) != sizeof(head))
+            return false;
+        size_t len = (size_t(head[0]) << 24) | (size_t(head[1]) << 16)
+                     | (size_t(head[2]) << 8) | size_t(head[3]);
+        string_view type((const char*)head + 4, 4);
+        pos += sizeof(head);
+        if (type == "IHDR") {
+            // Only 8 or 16 bit gray, RGB, gray alpha, or RGBA (not color
+            // mapped), noninterlaced, is as libpng would leave it.
+            unsigned char ihdr[13];
+            if (len != sizeof(ihdr)
+                || io->pread(ihdr, sizeof(ihdr), pos) != sizeof(ihdr)
+                || (ihdr[8] != 8 && ihdr[8] != 16)
+                || (ihdr[9] & PNG_COLOR_MASK_PALETTE) || ihdr[10] || ihdr[11]
+                || ihdr[12] != PNG_INTERLACE_NONE)
+                return false;
+        } else if (type == "tRNS") {
+            return false;  // libpng would make it an alpha channel
+        } else if (type == "IDAT") {
+            if (pos + int64_t(len) > int64_t(io->size()))
+                return false;
+            size_t n = zdata.size();
+            zdata.resize(n + len);
+            if (io->pread(zdata.data() + n, len, pos) != len)
+                return false;
+        } else if (zdata.size() || type == "IEND") {
+            break;
+        }
+        pos += int64_t(len) + 4;  // and the CRC
+    }
+
+    size_t rowbytes = m_spec.scanline_bytes();
+    size_t bpp      = m_spec.pixel_bytes();
+    std::vector<unsigned char> filtered((rowbytes + 1) * m_spec.height);
+    if (!pvt::zlib_uncompress(zdata, filtered))
+        return false;
+    m_buf.resize(m_spec.image_bytes());
+    std::vector<unsigned char> zeros(rowbytes, 0);  // above the first row
+    const unsigned char* prev = zeros.data();
+    for (int y = 0; y < m_spec.height; ++y) {
+        unsigned char* row = m_buf.data() + rowbytes * y;
+        if (!unfilter_row(filtered.data() + (rowbytes + 1) * y, prev, rowbytes,
+                          bpp, row)) {
+            m_buf.clear();
+            return false;
+        }
+        prev = row;
+    }
+    // PNG files are naturally big-endian
+    if (m_spec.format == TypeDesc::UINT16 && littleendian())
+        swap_endian((unsigned short*)m_buf.data(), m_buf.size() / 2);
+    return true;
+}
+
+#endif
+
+
+
 bool
 PNGInput::close()
 {
@@ -290,8 +421,9 @@ PNGInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
     if (y < 0 || y >= m_spec.height)  // out of range scanline
         return false;
 
-    if (m_interlace_type != 0) {
-        // Interlaced.  Punt and read the whole image
+    if (m_interlace_type != 0 || m_read_whole) {
+        // Interlaced (or we can inflate it faster all at once).  Punt and
+        // read the whole image
         if (m_buf.empty()) {
             if (has_error() || !readimg())
                 return false;
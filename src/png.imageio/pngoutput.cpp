@@ -2,12 +2,15 @@
 // SPDX-License-Identifier: BSD-3-Clause and Apache-2.0
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
+#include <atomic>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
 
+#include <OpenImageIO/parallel.h>
+
 #include "png_pvt.h"
 
 
@@ -54,6 +57,19 @@ private:
     std::vector<png_text> m_pngtext;
     std::vector<unsigned char> m_tilebuffer;
     bool m_err = false;
+    // Bands of scanlines may be filtered and deflated separately, by more
+    // than one thread, and the pieces joined into one zlib stream.
+    bool m_bands       = false;  // Are we?
+    int m_band_rows    = 0;      // Scanlines per band
+    int m_batch_rows   = 0;      // Scanlines compressed at once
+    int m_pending_rows = 0;      // Scanlines waiting in m_pending
+    int m_rows_done    = 0;      // Scanlines already compressed
+    int m_filters      = 0;      // PNG_FILTER_* bits to choose from
+    int m_level        = 0;      // zlib compression level
+    int m_strategy     = 0;      // zlib compression strategy
+    uLong m_adler      = 1;      // Checksum of all compressed data
+    std::vector<unsigned char> m_pending;  // Scanlines not yet compressed
+    std::vector<unsigned char> m_prevrow;  // The last one compressed
 
     // Initialize private members to pre-opened state
     void init(void)
@@ -66,7 +82,13 @@ private:
         m_srgb           = false;
         m_err            = false;
         m_gamma          = 1.0;
+        m_bands          = false;
+        m_pending_rows   = 0;
+        m_rows_done      = 0;
+        m_adler          = 1;
         m_pngtext.clear();
+        std::vector<unsigned char>().swap(m_pending);
+        std::vector<unsigned char>().swap(m_prevrow);
         ioproxy_clear();
     }
 
@@ -95,6 +117,12 @@ private:
     template<class T>
     void deassociateAlpha(T* data, size_t npixels, int channels,
                           int alpha_channel, bool srgb, float gamma);
+
+    // Write native scanlines, directly or by way of m_pending.
+    bool write_native_rows(const unsigned char* data, int nrows);
+    // Compress the pending scanlines and write them as IDAT chunks, ending
+    // the zlib stream if they are the last.
+    bool write_bands(bool last);
 };
 
 
@@ -158,34 +186,29 @@ PNGOutput::open(const std::string& name, const ImageSpec& userspec,
 
     png_set_write_fn(m_png, this, PngWriteCallback, PngFlushCallback);
 
-    png_set_compression_level(
-        m_png, std::max(std::min(m_spec.get_int_attribute(
-                                     "png:compressionLevel",
-                                     6 /* medium speed vs size tradeoff */),
-                                 Z_BEST_COMPRESSION),
-                        Z_NO_COMPRESSION));
+    m_level = std::max(std::min(m_spec.get_int_attribute(
+                                    "png:compressionLevel",
+                                    6 /* medium speed vs size tradeoff */),
+                                Z_BEST_COMPRESSION),
+                       Z_NO_COMPRESSION);
+    m_strategy              = Z_DEFAULT_STRATEGY;
     std::string compression = m_spec.get_string_attribute("compression");
-    if (compression.empty()) {
-        png_set_compression_strategy(m_png, Z_DEFAULT_STRATEGY);
-    } else if (Strutil::iequals(compression, "default")) {
-        png_set_compression_strategy(m_png, Z_DEFAULT_STRATEGY);
-    } else if (Strutil::iequals(compression, "filtered")) {
-        png_set_compression_strategy(m_png, Z_FILTERED);
+    if (Strutil::iequals(compression, "filtered")) {
+        m_strategy = Z_FILTERED;
     } else if (Strutil::iequals(compression, "huffman")) {
-        png_set_compression_strategy(m_png, Z_HUFFMAN_ONLY);
+        m_strategy = Z_HUFFMAN_ONLY;
     } else if (Strutil::iequals(compression, "rle")) {
-        png_set_compression_strategy(m_png, Z_RLE);
+        m_strategy = Z_RLE;
     } else if (Strutil::iequals(compression, "fixed")) {
-        png_set_compression_strategy(m_png, Z_FIXED);
+        m_strategy = Z_FIXED;
     } else if (Strutil::iequals(compression, "pngfast")) {
-        png_set_compression_strategy(m_png, Z_DEFAULT_STRATEGY);
-        png_set_compression_level(m_png, Z_BEST_SPEED);
+        m_level = Z_BEST_SPEED;
     } else if (Strutil::iequals(compression, "none")) {
-        png_set_compression_strategy(m_png, Z_NO_COMPRESSION);
-        png_set_compression_level(m_png, 0);
-    } else {
-        png_set_compression_strategy(m_png, Z_DEFAULT_STRATEGY);
+        m_strategy = Z_NO_COMPRESSION;
+        m_level    = 0;
     }
+    png_set_compression_level(m_png, m_level);
+    png_set_compression_strategy(m_png, m_strategy);
 
     m_need_swap = (m_spec.format == TypeDesc::UINT16 && littleendian());
 
@@ -193,8 +216,8 @@ PNGOutput::open(const std::string& name, const ImageSpec& userspec,
                                                 OIIO::get_int_attribute(
                                                     "png:linear_premult"));
 
-    png_set_filter(m_png, 0,
-                   spec().get_int_attribute("png:filter", PNG_NO_FILTERS));
+    m_filters = spec().get_int_attribute("png:filter", PNG_NO_FILTERS);
+    png_set_filter(m_png, 0, m_filters);
     // https://www.w3.org/TR/PNG-Encoders.html#E.Filter-selection
     // https://www.w3.org/TR/PNG-Rationale.html#R.Filtering
     // The official advice is to PNG_NO_FILTER for palette or < 8 bpp
@@ -209,6 +232,16 @@ PNGOutput::open(const std::string& name, const ImageSpec& userspec,
     // finding a filter choice that for "ordinary" images consistently
     // performed better than the default on both time and resulting file
     // size. So for now, we are keeping the default 0 (PNG_NO_FILTERS).
+    // For the bands we filter ourselves, we interpret it as libpng does:
+    // a single filter may also be given by its PNG_FILTER_VALUE_*, and
+    // PNG_NO_FILTERS lets it choose among all of them for each row.
+    if (m_filters == PNG_NO_FILTERS)
+        m_filters = PNG_ALL_FILTERS;
+    else if ((m_filters & 0xf8) == 0)
+        m_filters = m_filters >= 0 && m_filters <= PNG_FILTER_VALUE_PAETH
+                        ? PNG_FILTER_NONE << m_filters
+                        : PNG_FILTER_NONE;
+    m_filters &= PNG_ALL_FILTERS;
 
 #if defined(PNG_SKIP_sRGB_CHECK_PROFILE) && defined(PNG_SET_OPTION_SUPPORTED)
     // libpng by default checks ICC profiles and are very strict, treating
@@ -242,6 +275,19 @@ PNGOutput::open(const std::string& name, const ImageSpec& userspec,
     if (m_spec.tile_width && m_spec.tile_height)
         m_tilebuffer.resize(m_spec.image_bytes());
 
+    // Bands are around a megabyte of pixels each, and there had better be
+    // a few of them to make it worthwhile. Then libpng writes the chunks
+    // before the image data, and we write the IDAT chunks ourselves.
+    size_t rowbytes = m_spec.scanline_bytes();
+    m_band_rows     = int(std::max(size_t(16), (size_t(1) << 20) / rowbytes));
+    m_bands = threads() != 1 && default_thread_pool()->size() > 1
+              && m_spec.height >= 2 * m_band_rows;
+    if (m_bands) {
+        int nthreads = threads() ? threads() : default_thread_pool()->size();
+        m_batch_rows = m_band_rows * nthreads;
+        m_prevrow.assign(rowbytes, 0);  // above the first is all zero
+    }
+
     return true;
 }
 
@@ -264,8 +310,20 @@ PNGOutput::close()
         std::vector<unsigned char>().swap(m_tilebuffer);
     }
 
-    if (m_png) {
+    if (m_png && m_bands) {
+        // libpng doesn't know about our IDAT chunks, so we end the file,
+        // too. Everything else was written before the image data.
+        if (!write_bands(true))
+            ok = false;
+        else if (setjmp(png_jmpbuf(m_png)))  // NOLINT(cert-err52-cpp)
+            ok = false;
+        else
+            png_write_chunk(m_png, (png_const_bytep) "IEND", nullptr, 0);
+        ok &= !m_err;
+    } else if (m_png) {
         PNG_pvt::write_end(m_png, m_info);
+    }
+    if (m_png) {
         if (m_png || m_info)
             PNG_pvt::destroy_write_struct(m_png, m_info);
         m_png  = nullptr;
@@ -374,12 +432,7 @@ PNGOutput::write_scanline(int y, int z, TypeDesc format, const void* data,
     if (m_need_swap)
         swap_endian((unsigned short*)data, m_spec.width * m_spec.nchannels);
 
-    if (!PNG_pvt::write_row(m_png, (png_byte*)data)) {
-        errorfmt("PNG library error");
-        return false;
-    }
-
-    return true;
+    return write_native_rows((const unsigned char*)data, 1);
 }
 
 
@@ -441,14 +494,192 @@ PNGOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
     if (m_need_swap)
         swap_endian((unsigned short*)data, nvals);
 
-    if (!PNG_pvt::write_rows(m_png, (png_byte*)data, yend - ybegin,
-                             stride_t(m_spec.width) * m_spec.nchannels
-                                 * m_spec.format.size())) {
-        errorfmt("PNG library error");
+    return write_native_rows((const unsigned char*)data, yend - ybegin);
+#endif
+}
+
+
+
+bool
+PNGOutput::write_native_rows(const unsigned char* data, int nrows)
+{
+    size_t rowbytes = m_spec.scanline_bytes();
+    if (!m_bands) {
+        if (!PNG_pvt::write_rows(m_png, (png_byte*)data, nrows,
+                                 stride_t(rowbytes))) {
+            errorfmt("PNG library error");
+            return false;
+        }
+        return true;
+    }
+    m_pending.resize(rowbytes * m_batch_rows);
+    while (nrows > 0) {
+        int n = std::min(nrows, m_batch_rows - m_pending_rows);
+        memcpy(m_pending.data() + rowbytes * m_pending_rows, data,
+               rowbytes * n);
+        m_pending_rows += n;
+        data += rowbytes * n;
+        nrows -= n;
+        if (m_pending_rows == m_batch_rows
+            && m_rows_done + m_pending_rows < m_spec.height
+            && !write_bands(false))
+            return false;
+    }
+    return true;
+}
+
+
+
+// Filter one scanline of `rowbytes` bytes, whose pixels are `bpp` bytes,
+// given the one above it, into `out` (a filter type byte and then the
+// filtered row). From those of `filters` (PNG_FILTER_* bits), this chooses
+// as libpng does: the smallest sum of the bytes' magnitudes as signed.
+static void
+filter_row(const unsigned char* row, const unsigned char* prev,
+           size_t rowbytes, size_t bpp, int filters, unsigned char* out,
+           std::vector<unsigned char>& scratch)
+{
+    scratch.resize(rowbytes + 1);
+    uint64_t best = std::numeric_limits<uint64_t>::max();
+    for (int f = PNG_FILTER_VALUE_NONE; f < PNG_FILTER_VALUE_LAST; ++f) {
+        if (!(filters & (PNG_FILTER_NONE << f)))
+            continue;
+        unsigned char* dst = filters == (PNG_FILTER_NONE << f) ? out
+                                                               : scratch.data();
+        dst[0] = (unsigned char)f;
+        for (size_t i = 0; i < rowbytes; ++i) {
+            int a    = i >= bpp ? row[i - bpp] : 0;   // left
+            int b    = prev[i];                       // above
+            int c    = i >= bpp ? prev[i - bpp] : 0;  // above left
+            int pred = 0;
+            if (f == PNG_FILTER_VALUE_SUB) {
+                pred = a;
+            } else if (f == PNG_FILTER_VALUE_UP) {
+                pred = b;
+            } else if (f == PNG_FILTER_VALUE_AVG) {
+                pred = (a + b) / 2;
+            } else if (f == PNG_FILTER_VALUE_PAETH) {
+                int p  = a + b - c;
+                int pa = std::abs(p - a), pb = std::abs(p - b);
+                int pc = std::abs(p - c);
+                pred   = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+            }
+            dst[i + 1] = (unsigned char)(row[i] - pred);
+        }
+        if (dst == out)
+            return;  // The only choice
+        uint64_t sum = 0;
+        for (size_t i = 1; i <= rowbytes; ++i)
+            sum += dst[i] < 128 ? dst[i] : 256 - dst[i];
+        if (sum < best) {
+            best = sum;
+            memcpy(out, dst, rowbytes + 1);
+        }
+    }
+}
+
+
+
+bool
+PNGOutput::write_bands(bool last)
+{
+    // Each band is filtered and deflated with a full flush, which makes it
+    // independent of the others, so the bands' raw deflate data can just be
+    // joined. The whole is a zlib stream, which needs the usual two byte
+    // header before the first band and the Adler-32 of all the filtered
+    // data after the last.
+    size_t rowbytes = m_spec.scanline_bytes();
+    size_t bpp      = m_spec.pixel_bytes();
+    int nbands      = (m_pending_rows + m_band_rows - 1) / m_band_rows;
+    if (last)
+        nbands = std::max(nbands, 1);  // to end the stream
+    std::vector<std::vector<unsigned char>> compressed(nbands);
+    std::vector<uLong> adler(nbands);
+    std::vector<size_t> filtered_bytes(nbands);
+    std::atomic<bool> ok(true);
+    parallel_for(
+        0, nbands,
+        [&](int64_t b) {
+            int ybegin = int(b) * m_band_rows;
+            int yend   = std::min(ybegin + m_band_rows, m_pending_rows);
+            std::vector<unsigned char> filtered((rowbytes + 1)
+                                                * (yend - ybegin));
+            std::vector<unsigned char> scratch;
+            const unsigned char* row = m_pending.data() + rowbytes * ybegin;
+            const unsigned char* prev = ybegin ? row - rowbytes
+                                               : m_prevrow.data();
+            for (int y = ybegin; y < yend; ++y) {
+                filter_row(row, prev, rowbytes, bpp, m_filters,
+                           filtered.data() + (rowbytes + 1) * (y - ybegin),
+                           scratch);
+                prev = row;
+                row += rowbytes;
+            }
+            filtered_bytes[b] = filtered.size();
+            adler[b] = adler32(adler32(0L, Z_NULL, 0), filtered.data(),
+                               uInt(filtered.size()));
+            z_stream z;
+            memset(&z, 0, sizeof(z));
+            if (deflateInit2(&z, m_level, Z_DEFLATED, -MAX_WBITS, 8,
+                             m_strategy)
+                != Z_OK) {
+                ok = false;
+                return;
+            }
+            std::vector<unsigned char>& out(compressed[b]);
+            out.resize(deflateBound(&z, uLong(filtered.size())) + 16);
+            z.next_in   = filtered.data();
+            z.avail_in  = uInt(filtered.size());
+            z.next_out  = out.data();
+            z.avail_out = uInt(out.size());
+            bool end    = last && b == nbands - 1;
+            int zerr    = deflate(&z, end ? Z_FINISH : Z_FULL_FLUSH);
+            if (zerr != (end ? Z_STREAM_END : Z_OK) || z.avail_in)
+                ok = false;
+            out.resize(out.size() - z.avail_out);
+            deflateEnd(&z);
+        },
+        paropt(threads()));
+    if (!ok) {
+        errorfmt("PNG compression error");
         return false;
     }
-#endif
 
+    for (int b = 0; b < nbands; ++b) {
+        std::vector<unsigned char>& out(compressed[b]);
+        if (m_rows_done == 0 && b == 0) {
+            // zlib header: deflate with a 32K window, and the level the
+            // way zlib would describe it (which is only informative).
+            int flevel = (m_strategy >= Z_HUFFMAN_ONLY || m_level < 2) ? 0
+                         : m_level < 6                                 ? 1
+                         : m_level == 6                                ? 2
+                                                                       : 3;
+            int header = (0x78 << 8) | (flevel << 6);
+            header += 31 - header % 31;
+            out.insert(out.begin(), { (unsigned char)(header >> 8),
+                                      (unsigned char)header });
+        }
+        m_adler = adler32_combine(m_adler, adler[b], filtered_bytes[b]);
+        if (last && b == nbands - 1) {
+            for (int shift = 24; shift >= 0; shift -= 8)
+                out.push_back((unsigned char)(m_adler >> shift));
+        }
+        if (setjmp(png_jmpbuf(m_png))) {  // NOLINT(cert-err52-cpp)
+            errorfmt("PNG library error");
+            return false;
+        }
+        png_write_chunk(m_png, (png_const_bytep) "IDAT", out.data(),
+                        out.size());
+    }
+    if (m_err) {
+        errorfmt("PNG write error");
+        return false;
+    }
+    if (m_pending_rows)
+        memcpy(m_prevrow.data(),
+               m_pending.data() + rowbytes * (m_pending_rows - 1), rowbytes);
+    m_rows_done += m_pending_rows;
+    m_pending_rows = 0;
     return true;
 }
 
@@ -6,6 +6,7 @@
 #include <cstdlib>
 #include <fstream>
 #include <string>
+#include <vector>
 
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/fmath.h>
@@ -119,13 +120,19 @@ bool
 PNMInput::ascii_to_raw(T* write, imagesize_t nvals, T max, bool invert)
 {
     if (max) {
-        for (imagesize_t i = 0; i < nvals; i++) {
-            int tmp;
-            if (!nextVal(tmp))
+        // Parse the values in runs, between any comments
+        std::vector<int> vals(nvals);
+        for (imagesize_t i = 0; i < nvals;) {
+            skipComments();
+            size_t n = Strutil::parse_numbers(m_remaining,
+                                              make_span(&vals[i], nvals - i));
+            if (!n)
                 return false;
-            write[i] = std::min((int)max, tmp) * std::numeric_limits<T>::max()
-                       / max;
+            i += n;
         }
+        for (imagesize_t i = 0; i < nvals; i++)
+            write[i] = std::min((int)max, vals[i])
+                       * std::numeric_limits<T>::max() / max;
         if (invert)
             for (imagesize_t i = 0; i < nvals; i++)
                 write[i] = std::numeric_limits<T>::max() - write[i];
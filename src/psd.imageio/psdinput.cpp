@@ -9,6 +9,7 @@
 //
 
 
+#include <atomic>
 #include <csetjmp>
 #include <functional>
 #include <map>
@@ -19,6 +20,7 @@
 #include <OpenImageIO/fmath.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/tiffutils.h>
 
 // #include "jpeg_memory_src.h"
@@ -37,7 +39,8 @@ public:
     int supports(string_view feature) const override
     {
         return (feature == "exif" || feature == "iptc" || feature == "thumbnail"
-                || feature == "ioproxy");
+                || feature == "ioproxy"
+                || feature == "parallel_scanline_decode");
     }
     bool valid_file(Filesystem::IOProxy* ioproxy) const override;
     bool open(const std::string& name, ImageSpec& newspec) override;
@@ -48,6 +51,8 @@ public:
     bool seek_subimage(int subimage, int miplevel) override;
     bool read_native_scanline(int subimage, int miplevel, int y, int z,
                               void* data) override;
+    bool read_native_scanlines(int subimage, int miplevel, int ybegin,
+                               int yend, int z, void* data) override;
     bool get_thumbnail(ImageBuf& thumb, int subimage) override
     {
         thumb = m_thumbnail;
@@ -137,6 +142,7 @@ private:
         // codecs zip and zipprediction as we need to preallocate
         // the memory this vector is already decompressed and byteswapped
         std::vector<char> decompressed_data;
+        bool decoded = false;  // decompressed_data is ready
 
         std::vector<uint32_t> rle_lengths;
         std::vector<int64_t> row_pos;
@@ -297,8 +303,15 @@ private:
     void setup();
     void fill_channel_names(ImageSpec& spec, bool transparency);
 
-    //Read a row of channel data
+    //Read a row of channel data. This only uses pread() and the already
+    //decompressed ZIP data, so may be called by several threads.
     bool read_channel_row(ChannelInfo& channel_info, uint32_t row, char* data);
+    bool pread(void* buf, size_t size, int64_t pos);
+
+    // Decompress the ZIP compressed channels of the subimage, if that has
+    // not yet been done, in parallel. This is left until the subimage is
+    // read, so that layers that never are don't cost anything.
+    bool decode_channels(int subimage);
 
     // Interleave channels (RRRGGGBBB -> RGBRGBRGB) while copying from
     // channel_buffers[0..nchans-1] to dst.
@@ -777,6 +790,9 @@ PSDInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
     std::vector<std::vector<unsigned char>> channel_buffers;
     channel_buffers.resize(m_channels[subimage].size());
 
+    if (!decode_channels(subimage))
+        return false;
+
     int bps = (m_header.depth + 7) / 8;  // bytes per sample
     OIIO_DASSERT(bps == 1 || bps == 2 || bps == 4);
     std::vector<ChannelInfo*>& channels = m_channels[subimage];
@@ -896,6 +912,93 @@ PSDInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
 
 
 
+bool
+PSDInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
+                                int yend, int z, void* data)
+{
+    if (subimage < 0 || subimage >= m_subimage_count || miplevel != 0)
+        return false;
+    // Rows are read with pread() and no other state changes, so this runs
+    // without the lock, and read_scanlines() may give several threads
+    // their own ranges of rows.
+    if (!decode_channels(subimage))
+        return false;
+    const ImageSpec& spec = m_specs[subimage];
+    yend                  = std::min(yend, spec.y + spec.height);
+    size_t scanbytes      = spec.scanline_bytes(true);
+    for (int y = ybegin; y < yend; ++y)
+        if (!read_native_scanline(subimage, miplevel, y, z,
+                                  (char*)data + (y - ybegin) * scanbytes))
+            return false;
+    return true;
+}
+
+
+
+bool
+PSDInput::decode_channels(int subimage)
+{
+    lock_guard lock(*this);
+    std::vector<ChannelInfo*> todo;
+    for (ChannelInfo* channel_info : m_channels[subimage])
+        if ((channel_info->compression == Compression_ZIP
+             || channel_info->compression == Compression_ZIP_Predict)
+            && !channel_info->decoded && channel_info->row_pos.size())
+            todo.push_back(channel_info);
+    if (todo.empty())
+        return true;
+
+    // Each channel's compressed data has its own place and length in the
+    // file, so the channels are read and decompressed all at once.
+    std::atomic<bool> ok(true);
+    parallel_for(
+        int64_t(0), int64_t(todo.size()),
+        [&](int64_t i) {
+            ChannelInfo& channel_info(*todo[i]);
+            std::vector<char> compressed_data(channel_info.data_length);
+            channel_info.decompressed_data = std::vector<char>(
+                uint64_t(channel_info.width) * channel_info.height
+                * (m_header.depth / 8));
+            if (!pread(compressed_data.data(), channel_info.data_length,
+                       channel_info.data_pos)) {
+                ok = false;
+                return;
+            }
+            if (channel_info.compression == Compression_ZIP)
+                decompress_zip(compressed_data,
+                               channel_info.decompressed_data);
+            else
+                decompress_zip_prediction(compressed_data,
+                                          channel_info.decompressed_data,
+                                          channel_info.width,
+                                          channel_info.height);
+            channel_info.decoded = true;
+        },
+        paropt(threads()));
+    return ok;
+}
+
+
+
+bool
+PSDInput::pread(void* buf, size_t size, int64_t pos)
+{
+    size_t n = ioproxy()->pread(buf, size, pos);
+    if (n != size) {
+        if (pos + int64_t(n) >= int64_t(ioproxy()->size()))
+            errorfmt("Read error: hit end of file in {} reader",
+                     format_name());
+        else
+            errorfmt("Read error at position {}, could only read {}/{} bytes "
+                     "{}",
+                     pos, n, size, ioproxy()->error());
+        return false;
+    }
+    return true;
+}
+
+
+
 void
 PSDInput::init()
 {
@@ -1672,42 +1775,17 @@ PSDInput::load_layer_channel(Layer& layer, ChannelInfo& channel_info)
         if (!ioseek(channel_info.data_length, SEEK_CUR))
             return false;
         break;
-    case Compression_ZIP: {
+    case Compression_ZIP:
+    case Compression_ZIP_Predict:
         // We subtract the compression marker from the data length
         channel_info.data_length -= 2;
 
         // Unlike with raw and rle compression we cannot access each scanline
-        // randomly so we parse the data up-front and store it
-        std::vector<char> compressed_data(channel_info.data_length);
-        channel_info.decompressed_data = std::vector<char>(
-            width * height * (m_header.depth / 8));
-
-        if (!ioseek(channel_info.data_pos))
-            return false;
-        if (!ioread(compressed_data.data(), channel_info.data_length))
-            return false;
-
-        decompress_zip(compressed_data, channel_info.decompressed_data);
-    } break;
-    case Compression_ZIP_Predict: {
-        // We subtract the compression marker from the data length
-        channel_info.data_length -= 2;
-
-        // Unlike with raw and rle compression we cannot access each scanline
-        // randomly so we parse the data up-front and store it
-        std::vector<char> compressed_data(channel_info.data_length);
-        channel_info.decompressed_data = std::vector<char>(
-            width * height * (m_header.depth / 8));
-
-        if (!ioseek(channel_info.data_pos))
-            return false;
-        if (!ioread(compressed_data.data(), channel_info.data_length))
+        // randomly, so the whole channel is decompressed, by
+        // decode_channels(), when its layer is first read.
+        if (!ioseek(channel_info.data_length, SEEK_CUR))
             return false;
-
-        decompress_zip_prediction(compressed_data,
-                                  channel_info.decompressed_data, width,
-                                  height);
-    } break;
+        break;
     default:
         errorfmt("[Layer Channel] unsupported compression {}",
                  channel_info.compression);
@@ -2045,9 +2123,7 @@ PSDInput::read_channel_row(ChannelInfo& channel_info, uint32_t row, char* data)
 
     switch (channel_info.compression) {
     case Compression_Raw:
-        if (!ioseek(channel_info.row_pos[row]))
-            return false;
-        if (!ioread(data, channel_info.row_length))
+        if (!pread(data, channel_info.row_length, channel_info.row_pos[row]))
             return false;
 
         if (!bigendian()) {
@@ -2058,12 +2134,10 @@ PSDInput::read_channel_row(ChannelInfo& channel_info, uint32_t row, char* data)
         }
         break;
     case Compression_RLE: {
-        if (!ioseek(channel_info.row_pos[row]))
-            return false;
         uint32_t rle_length = channel_info.rle_lengths[row];
         char* rle_buffer;
         OIIO_ALLOCATE_STACK_OR_HEAP(rle_buffer, char, rle_length);
-        if (!ioread(rle_buffer, rle_length)
+        if (!pread(rle_buffer, rle_length, channel_info.row_pos[row])
             || !decompress_packbits(rle_buffer, data, rle_length,
                                     channel_info.row_length))
             return false;
@@ -2281,10 +2355,12 @@ PSDInput::decompress_packbits(const char* src, char* dst,
         }
     }
 
+    // N.B. Not m_spec.width: rows may be read for any subimage, by several
+    // threads at once.
     if (!bigendian()) {
         switch (m_header.depth) {
-        case 16: swap_endian((uint16_t*)dst_start, m_spec.width); break;
-        case 32: swap_endian((uint32_t*)dst_start, m_spec.width); break;
+        case 16: swap_endian((uint16_t*)dst_start, unpacked_length / 2); break;
+        case 32: swap_endian((uint32_t*)dst_start, unpacked_length / 4); break;
         }
     }
 
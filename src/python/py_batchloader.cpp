@@ -0,0 +1,320 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+#include "py_oiio.h"
+
+#include <atomic>
+#include <future>
+#include <mutex>
+
+#include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/parallel.h>
+
+namespace PyOpenImageIO {
+
+
+// BatchLoader reads a list of image files in batches of images that are
+// all decoded, resized, and converted to the same channels and data type,
+// in parallel, each batch into one array of [image][y][x][channel] (or
+// [image][channel][y][x] if planar). While one batch is being consumed
+// in Python, the next is read in the background.
+class BatchLoader {
+public:
+    BatchLoader(std::vector<std::string> filenames, int batch_size,
+                int width, int height, int nchannels, TypeDesc format,
+                bool planar)
+        : m_filenames(std::move(filenames))
+        , m_batch_size(std::max(batch_size, 1))
+        , m_width(width)
+        , m_height(height)
+        , m_nchannels(nchannels)
+        , m_format(format)
+        , m_planar(planar)
+    {
+        if (width < 1 || height < 1 || nchannels < 1)
+            throw std::invalid_argument(
+                "BatchLoader: width, height, and nchannels must be positive");
+        if (!buffer_format_code(format))
+            throw std::invalid_argument(
+                Strutil::fmt::format("BatchLoader: unsupported format {}",
+                                     format));
+    }
+    BatchLoader(const BatchLoader&) = delete;
+    ~BatchLoader() { wait(); }
+
+    size_t nbatches() const
+    {
+        return (m_filenames.size() + m_batch_size - 1) / m_batch_size;
+    }
+
+    // Number of images in batch b.
+    size_t batch_images(size_t b) const
+    {
+        return std::min(m_filenames.size() - b * m_batch_size,
+                        size_t(m_batch_size));
+    }
+
+    TypeDesc format() const { return m_format; }
+
+    size_t image_bytes() const
+    {
+        return size_t(m_width) * m_height * m_nchannels * m_format.size();
+    }
+
+    // The shape and strides of an array of n images.
+    std::vector<py::ssize_t> shape(size_t n) const
+    {
+        if (m_planar)
+            return { py::ssize_t(n), m_nchannels, m_height, m_width };
+        return { py::ssize_t(n), m_height, m_width, m_nchannels };
+    }
+    std::vector<py::ssize_t> strides() const
+    {
+        py::ssize_t s = m_format.size();
+        if (m_planar)
+            return { py::ssize_t(image_bytes()), m_height * m_width * s,
+                     m_width * s, s };
+        return { py::ssize_t(image_bytes()), m_width * m_nchannels * s,
+                 m_nchannels * s, s };
+    }
+
+    // Read the files, in parallel, into the images of dst, returning
+    // true if all of them could be read. Files that can't be read are left
+    // black, and their errors saved.
+    bool load(cspan<std::string> files, std::byte* dst);
+
+    // Return batch b as a numpy array, and start reading the next one.
+    // Call with the GIL held.
+    py::object batch(size_t b);
+
+    // Start reading batch b in the background (if there is one).
+    void prefetch(size_t b);
+
+    // Wait for the batch being read in the background, if any.
+    void wait()
+    {
+        if (m_pending.valid())
+            m_pending.wait();
+    }
+
+    bool has_error() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return !m_errors.empty();
+    }
+
+    std::string geterror(bool clear)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::string e = m_errors;
+        if (clear)
+            m_errors.clear();
+        return e;
+    }
+
+    size_t m_next = 0;  // The next batch, when iterating
+
+private:
+    bool load_image(const std::string& filename, std::byte* dst);
+
+    std::vector<std::string> m_filenames;
+    int m_batch_size, m_width, m_height, m_nchannels;
+    TypeDesc m_format;
+    bool m_planar;
+    // The batch being read in the background, and its pixels
+    std::future<void> m_pending;
+    size_t m_pending_batch = ~size_t(0);
+    std::unique_ptr<std::byte[]> m_pending_data;
+    mutable std::mutex m_mutex;
+    std::string m_errors;
+};
+
+
+
+bool
+BatchLoader::load_image(const std::string& filename, std::byte* dst)
+{
+    // Each image is read, resized, and converted by one thread, so that
+    // many images are in flight at once.
+    ImageBuf src(filename);
+    bool ok = src.read(0, 0, true /*force*/, TypeFloat);
+    if (ok
+        && (src.spec().width != m_width || src.spec().height != m_height)) {
+        src = ImageBufAlgo::resize(src, {},
+                                   ROI(0, m_width, 0, m_height, 0, 1, 0,
+                                       src.nchannels()),
+                                   1);
+        ok = !src.has_error();
+    }
+    if (ok && src.nchannels() != m_nchannels) {
+        // Copy the channels there are, replicating a single channel to
+        // the color channels, and filling in an alpha channel with 1.
+        std::vector<int> order(m_nchannels);
+        std::vector<float> values(m_nchannels, 0.0f);
+        for (int c = 0; c < m_nchannels; ++c) {
+            if (c < src.nchannels())
+                order[c] = c;
+            else if (src.nchannels() == 1 && c < 3)
+                order[c] = 0;
+            else {
+                order[c]  = -1;
+                values[c] = (c == 3) ? 1.0f : 0.0f;
+            }
+        }
+        src = ImageBufAlgo::channels(src, m_nchannels, order, values, {},
+                                     false, 1);
+        ok  = !src.has_error();
+    }
+    if (ok) {
+        span<std::byte> buffer(dst, image_bytes());
+        ROI roi = src.roi();
+        if (m_planar) {
+            stride_t chansize = m_format.size();
+            size_t plane      = size_t(m_width) * m_height * chansize;
+            for (int c = 0; c < m_nchannels && ok; ++c) {
+                roi.chbegin = c;
+                roi.chend   = c + 1;
+                ok = src.get_pixels(roi, m_format, buffer, dst + c * plane,
+                                    chansize, m_width * chansize);
+            }
+        } else {
+            ok = src.get_pixels(roi, m_format, buffer);
+        }
+    }
+    if (!ok) {
+        memset(dst, 0, image_bytes());
+        std::string err = src.geterror();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_errors.size())
+            m_errors += '\n';
+        m_errors += Strutil::fmt::format("{}: {}", filename,
+                                         err.size() ? err : "could not read");
+    }
+    return ok;
+}
+
+
+
+bool
+BatchLoader::load(cspan<std::string> files, std::byte* dst)
+{
+    std::atomic<bool> ok(true);
+    parallel_for(int64_t(0), int64_t(files.size()), [&](int64_t i) {
+        if (!load_image(files[i], dst + i * image_bytes()))
+            ok = false;
+    });
+    return ok;
+}
+
+
+
+void
+BatchLoader::prefetch(size_t b)
+{
+    wait();
+    m_pending_batch = b;
+    if (b >= nbatches()) {
+        m_pending = std::future<void>();
+        return;
+    }
+    size_t n = batch_images(b);
+    m_pending_data.reset(new std::byte[n * image_bytes()]);
+    std::byte* dst = m_pending_data.get();
+    cspan<std::string> files(&m_filenames[b * m_batch_size], n);
+    m_pending = std::async(std::launch::async,
+                           [this, files, dst]() { load(files, dst); });
+}
+
+
+
+py::object
+BatchLoader::batch(size_t b)
+{
+    if (b >= nbatches())
+        throw py::index_error();
+    std::unique_ptr<std::byte[]> data;
+    {
+        py::gil_scoped_release gil;
+        if (m_pending_batch != b || !m_pending.valid())
+            prefetch(b);
+        wait();
+        data            = std::move(m_pending_data);
+        m_pending       = std::future<void>();
+        m_pending_batch = ~size_t(0);
+        prefetch(b + 1);
+    }
+    // The array owns the batch's memory from here on.
+    std::byte* mem = data.release();
+    py::capsule free_when_done(mem, [](void* p) {
+        delete[] reinterpret_cast<std::byte*>(p);
+    });
+    return py::array(py::dtype(buffer_format_code(m_format)),
+                     shape(batch_images(b)), strides(), mem, free_when_done);
+}
+
+
+
+void
+declare_batchloader(py::module& m)
+{
+    using namespace pybind11::literals;
+
+    py::class_<BatchLoader>(m, "BatchLoader")
+        .def(py::init([](std::vector<std::string> filenames, int batch_size,
+                         int width, int height, int nchannels,
+                         TypeDesc format, const std::string& layout) {
+                 if (layout != "NHWC" && layout != "NCHW")
+                     throw std::invalid_argument(
+                         "BatchLoader: layout must be \"NHWC\" or \"NCHW\"");
+                 return std::make_unique<BatchLoader>(std::move(filenames),
+                                                      batch_size, width,
+                                                      height, nchannels,
+                                                      format,
+                                                      layout == "NCHW");
+             }),
+             "filenames"_a, "batch_size"_a, "width"_a, "height"_a,
+             "nchannels"_a = 3, "format"_a = TypeFloat, "layout"_a = "NHWC")
+        .def("__len__", &BatchLoader::nbatches)
+        .def("__getitem__", &BatchLoader::batch, "index"_a)
+        .def("__iter__",
+             [](py::object self) {
+                 self.cast<BatchLoader&>().m_next = 0;
+                 return self;
+             })
+        .def("__next__",
+             [](BatchLoader& self) {
+                 if (self.m_next >= self.nbatches())
+                     throw py::stop_iteration();
+                 return self.batch(self.m_next++);
+             })
+        .def(
+            "load",
+            [](BatchLoader& self, const std::vector<std::string>& filenames,
+               py::array out) {
+                auto shape   = self.shape(filenames.size());
+                py::dtype dt = py::dtype(buffer_format_code(self.format()));
+                if (!out.writeable()
+                    || !(out.flags() & py::array::c_style)
+                    || out.dtype().kind() != dt.kind()
+                    || out.dtype().itemsize() != dt.itemsize()
+                    || out.ndim() != 4
+                    || !std::equal(shape.begin(), shape.end(), out.shape()))
+                    throw std::invalid_argument(
+                        "BatchLoader.load: out must be a writable contiguous "
+                        "array of the loader's shape and format");
+                std::byte* dst = (std::byte*)out.mutable_data();
+                py::gil_scoped_release gil;
+                return self.load(filenames, dst);
+            },
+            "filenames"_a, "out"_a)
+        .def_property_readonly("has_error", &BatchLoader::has_error)
+        .def(
+            "geterror",
+            [](BatchLoader& self, bool clear) {
+                return PY_STR(self.geterror(clear));
+            },
+            "clear"_a = true);
+}
+
+}  // namespace PyOpenImageIO
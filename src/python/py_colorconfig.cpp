@@ -17,8 +17,15 @@ declare_colorconfig(py::module& m)
 
     py::class_<ColorConfig>(m, "ColorConfig")
 
-        .def(py::init<>())
-        .def(py::init<const std::string&>())
+        .def(py::init([]() {
+            // Reading the config may take a while
+            py::gil_scoped_release gil;
+            return std::make_unique<ColorConfig>();
+        }))
+        .def(py::init([](const std::string& filename) {
+            py::gil_scoped_release gil;
+            return std::make_unique<ColorConfig>(filename);
+        }))
         .def("geterror",
              [](ColorConfig& self) { return PY_STR(self.geterror()); })
 
@@ -126,6 +133,8 @@ declare_colorconfig(py::module& m)
         .def(
             "resolve",
             [](const ColorConfig& self, const std::string& name) {
+                // May have to classify all the color spaces
+                py::gil_scoped_release gil;
                 return std::string(self.resolve(name));
             },
             "name"_a)
@@ -133,11 +142,13 @@ declare_colorconfig(py::module& m)
             "equivalent",
             [](const ColorConfig& self, const std::string& color_space,
                const std::string& other_color_space) {
+                py::gil_scoped_release gil;
                 return self.equivalent(color_space, other_color_space);
             },
             "color_space"_a, "other_color_space"_a)
         .def("configname", &ColorConfig::configname)
         .def_static("default_colorconfig", []() -> const ColorConfig& {
+            py::gil_scoped_release gil;
             return ColorConfig::default_colorconfig();
         });
 
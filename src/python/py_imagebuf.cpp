@@ -13,8 +13,11 @@ namespace PyOpenImageIO {
 
 
 
+// Make an ImageBuf of the pixels in the buffer: a copy of them, or if
+// `copy` is false, an APPBUFFER ImageBuf that wraps the buffer's memory
+// (whose owner the caller must keep alive as long as the ImageBuf is).
 static ImageBuf
-ImageBuf_from_buffer(const py::buffer& buffer)
+ImageBuf_from_buffer(const py::buffer& buffer, bool copy = true)
 {
     ImageBuf ib;
     const py::buffer_info info = buffer.request();
@@ -66,6 +69,17 @@ ImageBuf_from_buffer(const py::buffer& buffer)
     ImageSpec spec(width, height, nchans, format);
     spec.depth      = depth;
     spec.full_depth = depth;
+    if (!copy) {
+        if (info.readonly) {
+            ib.errorfmt("ImageBuf cannot wrap a read-only numpy array");
+            return ib;
+        }
+        auto bufspan = span_from_buffer(info.ptr, format, nchans, width, height,
+                                        depth, xstride, ystride, zstride);
+        ib.reset(spec, bufspan, info.ptr, xstride, ystride, zstride);
+        return ib;
+    }
+    py::gil_scoped_release gil;
     ib.reset(spec, InitializePixels::No);
     auto bufspan = cspan_from_buffer(info.ptr, format, nchans, width, height,
                                      depth, xstride, ystride, zstride);
@@ -179,7 +193,12 @@ ImageBuf_get_pixels(const ImageBuf& buf, TypeDesc format, ROI roi = ROI::All())
 
     size_t size = (size_t)roi.npixels() * roi.nchannels() * format.size();
     std::unique_ptr<std::byte[]> data(new std::byte[size]);
-    if (buf.get_pixels(roi, format, make_span(data.get(), size)))
+    bool ok;
+    {
+        py::gil_scoped_release gil;
+        ok = buf.get_pixels(roi, format, make_span(data.get(), size));
+    }
+    if (ok)
         return make_numpy_array(format, data.release(),
                                 buf.spec().depth > 1 ? 4 : 3, roi.nchannels(),
                                 roi.width(), roi.height(), roi.depth());
@@ -189,6 +208,36 @@ ImageBuf_get_pixels(const ImageBuf& buf, TypeDesc format, ROI roi = ROI::All())
 
 
 
+// Return a numpy array that views (rather than copies) the pixels of the
+// ImageBuf `self`, indexed as [y][x][channel] (or [z][y][x][channel] for
+// volumes), holding a reference to `self` so that the ImageBuf outlives
+// it. Return None if the pixels aren't held in memory.
+py::object
+ImageBuf_pixels_view(py::object self)
+{
+    ImageBuf& buf(self.cast<ImageBuf&>());
+    if (buf.deep())
+        return py::none();
+    const char* code = buffer_format_code(buf.spec().format);
+    void* pixels     = code ? buf.localpixels() : nullptr;
+    if (!pixels)
+        return py::none();
+    const ImageSpec& spec(buf.spec());
+    std::vector<py::ssize_t> shape, strides;
+    if (spec.depth > 1) {
+        shape.assign({ spec.depth, spec.height, spec.width, spec.nchannels });
+        strides.assign({ buf.z_stride(), buf.scanline_stride(),
+                         buf.pixel_stride(), py::ssize_t(spec.format.size()) });
+    } else {
+        shape.assign({ spec.height, spec.width, spec.nchannels });
+        strides.assign({ buf.scanline_stride(), buf.pixel_stride(),
+                         py::ssize_t(spec.format.size()) });
+    }
+    return py::array(py::dtype(code), shape, strides, pixels, self);
+}
+
+
+
 void
 ImageBuf_set_deep_value(ImageBuf& buf, int x, int y, int z, int c, int s,
                         float value)
@@ -273,6 +322,10 @@ declare_imagebuf(py::module& m)
                  return ImageBuf_from_buffer(buffer);
              }),
              "buffer"_a)
+        .def(py::init([](const py::buffer& buffer, bool copy) {
+                 return ImageBuf_from_buffer(buffer, copy);
+             }),
+             "buffer"_a, "copy"_a, py::keep_alive<1, 2>())
         .def("clear", &ImageBuf::clear)
         .def(
             "reset",
@@ -300,6 +353,12 @@ declare_imagebuf(py::module& m)
                 self = ImageBuf_from_buffer(buffer);
             },
             "buffer"_a)
+        .def(
+            "reset",
+            [](ImageBuf& self, const py::buffer& buffer, bool copy) {
+                self = ImageBuf_from_buffer(buffer, copy);
+            },
+            "buffer"_a, "copy"_a, py::keep_alive<1, 2>())
 
         .def_property_readonly("initialized",
                                [](const ImageBuf& self) {
@@ -427,7 +486,11 @@ declare_imagebuf(py::module& m)
         .def("pixelindex", &ImageBuf::pixelindex, "x"_a, "y"_a, "z"_a,
              "check_range"_a = false)
         .def("copy_metadata", &ImageBuf::copy_metadata)
-        .def("copy_pixels", &ImageBuf::copy_pixels)
+        .def("copy_pixels",
+             [](ImageBuf& self, const ImageBuf& src) {
+                 py::gil_scoped_release gil;
+                 return self.copy_pixels(src);
+             })
         .def(
             "copy",
             [](ImageBuf& self, const ImageBuf& src, TypeDesc format) {
@@ -463,6 +526,23 @@ declare_imagebuf(py::module& m)
         .def("setpixel", &ImageBuf_setpixel1, "i"_a, "pixel"_a)
         .def("get_pixels", &ImageBuf_get_pixels, "format"_a = TypeFloat,
              "roi"_a = ROI::All())
+        .def("pixels_view", &ImageBuf_pixels_view)
+        .def(
+            "__array__",
+            [](py::object self, py::object dtype, py::object copy) {
+                // numpy.asarray(buf): a view where possible, else a copy
+                py::object a = ImageBuf_pixels_view(self);
+                if (a.is_none()) {
+                    const ImageBuf& buf(self.cast<const ImageBuf&>());
+                    a = ImageBuf_get_pixels(buf, buf.spec().format);
+                } else if (!copy.is_none() && copy.cast<bool>()) {
+                    a = a.attr("copy")();
+                }
+                if (!dtype.is_none())
+                    a = a.attr("astype")(dtype, "copy"_a = false);
+                return a;
+            },
+            "dtype"_a = py::none(), "copy"_a = py::none())
         .def("set_pixels", &ImageBuf_set_pixels_buffer, "roi"_a, "pixels"_a)
 
         .def_property_readonly("deep", &ImageBuf::deep)
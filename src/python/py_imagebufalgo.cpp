@@ -1332,6 +1332,18 @@ IBA_computePixelHashSHA1(const ImageBuf& src, const std::string& extrainfo,
 
 
 
+std::string
+IBA_computePixelHash(const ImageBuf& src, const std::string& extrainfo,
+                     ROI roi = ROI::All(), int blocksize = 256,
+                     int nthreads = 0)
+{
+    py::gil_scoped_release gil;
+    return ImageBufAlgo::computePixelHash(src, extrainfo, roi, blocksize,
+                                          nthreads);
+}
+
+
+
 bool
 IBA_warp(ImageBuf& dst, const ImageBuf& src, py::object values_M,
          const std::string& filtername = "", float filterwidth = 0.0f,
@@ -1623,6 +1635,79 @@ IBA_erode_ret(const ImageBuf& src, int width, int height, ROI roi, int nthreads)
 
 
 
+bool
+IBA_summed_area_table(ImageBuf& dst, const ImageBuf& src, ROI roi,
+                      int nthreads)
+{
+    py::gil_scoped_release gil;
+    return ImageBufAlgo::summed_area_table(dst, src, roi, nthreads);
+}
+
+ImageBuf
+IBA_summed_area_table_ret(const ImageBuf& src, ROI roi, int nthreads)
+{
+    py::gil_scoped_release gil;
+    return ImageBufAlgo::summed_area_table(src, roi, nthreads);
+}
+
+py::object
+IBA_summed_area_sum(const ImageBuf& sat, int xbegin, int xend, int ybegin,
+                    int yend)
+{
+    std::vector<double> sums(std::max(0, sat.nchannels()));
+    ImageBufAlgo::summed_area_sum(sat, xbegin, xend, ybegin, yend, sums);
+    return C_to_tuple(cspan<double>(sums));
+}
+
+
+
+bool
+IBA_box_filter(ImageBuf& dst, const ImageBuf& src, int width, int height,
+               ROI roi, int nthreads)
+{
+    py::gil_scoped_release gil;
+    return ImageBufAlgo::box_filter(dst, src, width, height, roi, nthreads);
+}
+
+ImageBuf
+IBA_box_filter_ret(const ImageBuf& src, int width, int height, ROI roi,
+                   int nthreads)
+{
+    py::gil_scoped_release gil;
+    return ImageBufAlgo::box_filter(src, width, height, roi, nthreads);
+}
+
+bool
+IBA_box_filter_var(ImageBuf& dst, const ImageBuf& src, const ImageBuf& radius,
+                   int radius_channel, ROI roi, int nthreads)
+{
+    py::gil_scoped_release gil;
+    return ImageBufAlgo::box_filter(dst, src, radius, radius_channel, roi,
+                                    nthreads);
+}
+
+ImageBuf
+IBA_box_filter_var_ret(const ImageBuf& src, const ImageBuf& radius,
+                       int radius_channel, ROI roi, int nthreads)
+{
+    py::gil_scoped_release gil;
+    return ImageBufAlgo::box_filter(src, radius, radius_channel, roi,
+                                    nthreads);
+}
+
+
+
+bool
+IBA_envlatl_cdf(ImageBuf& marginal, ImageBuf& conditional,
+                const ImageBuf& src, int width, int height, int nthreads)
+{
+    py::gil_scoped_release gil;
+    return ImageBufAlgo::envlatl_cdf(marginal, conditional, src, width,
+                                     height, nthreads);
+}
+
+
+
 bool
 IBA_laplacian(ImageBuf& dst, const ImageBuf& src, ROI roi, int nthreads)
 {
@@ -2956,6 +3041,9 @@ declare_imagebufalgo(py::module& m)
         .def_static("computePixelHashSHA1", &IBA_computePixelHashSHA1, "src"_a,
                     "extrainfo"_a = "", "roi"_a = ROI::All(), "blocksize"_a = 0,
                     "nthreads"_a = 0)
+        .def_static("computePixelHash", &IBA_computePixelHash, "src"_a,
+                    "extrainfo"_a = "", "roi"_a = ROI::All(),
+                    "blocksize"_a = 256, "nthreads"_a = 0)
 
         .def_static("warp", &IBA_warp, "dst"_a, "src"_a, "M"_a,
                     "filtername"_a = "", "filterwidth"_a = 0.0f,
@@ -3050,6 +3138,29 @@ declare_imagebufalgo(py::module& m)
         .def_static("erode", &IBA_erode_ret, "src"_a, "width"_a = 3,
                     "height"_a = -1, "roi"_a = ROI::All(), "nthreads"_a = 0)
 
+        .def_static("summed_area_table", &IBA_summed_area_table, "dst"_a,
+                    "src"_a, "roi"_a = ROI::All(), "nthreads"_a = 0)
+        .def_static("summed_area_table", &IBA_summed_area_table_ret, "src"_a,
+                    "roi"_a = ROI::All(), "nthreads"_a = 0)
+        .def_static("summed_area_sum", &IBA_summed_area_sum, "sat"_a,
+                    "xbegin"_a, "xend"_a, "ybegin"_a, "yend"_a)
+
+        .def_static("envlatl_cdf", &IBA_envlatl_cdf, "marginal"_a,
+                    "conditional"_a, "src"_a, "width"_a = 0, "height"_a = 0,
+                    "nthreads"_a = 0)
+
+        .def_static("box_filter", &IBA_box_filter, "dst"_a, "src"_a,
+                    "width"_a = 3, "height"_a = -1, "roi"_a = ROI::All(),
+                    "nthreads"_a = 0)
+        .def_static("box_filter", &IBA_box_filter_ret, "src"_a, "width"_a = 3,
+                    "height"_a = -1, "roi"_a = ROI::All(), "nthreads"_a = 0)
+        .def_static("box_filter", &IBA_box_filter_var, "dst"_a, "src"_a,
+                    "radius"_a, "radius_channel"_a = 0, "roi"_a = ROI::All(),
+                    "nthreads"_a = 0)
+        .def_static("box_filter", &IBA_box_filter_var_ret, "src"_a,
+                    "radius"_a, "radius_channel"_a = 0, "roi"_a = ROI::All(),
+                    "nthreads"_a = 0)
+
         .def_static("laplacian", &IBA_laplacian, "dst"_a, "src"_a,
                     "roi"_a = ROI::All(), "nthreads"_a = 0)
         .def_static("laplacian", &IBA_laplacian_ret, "src"_a,
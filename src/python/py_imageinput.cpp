@@ -176,15 +176,23 @@ declare_imageinput(py::module& m)
             "create",
             [](const std::string& filename,
                const std::string& searchpath) -> py::object {
-                auto in = ImageInput::create(filename, false, nullptr, nullptr,
-                                             searchpath);
+                std::unique_ptr<ImageInput> in;
+                {
+                    py::gil_scoped_release gil;
+                    in = ImageInput::create(filename, false, nullptr, nullptr,
+                                            searchpath);
+                }
                 return in ? py::cast(in.release()) : py::none();
             },
             "filename"_a, "plugin_searchpath"_a = "")
         .def_static(
             "open",
             [](const std::string& filename) -> py::object {
-                auto in = ImageInput::open(filename);
+                std::unique_ptr<ImageInput> in;
+                {
+                    py::gil_scoped_release gil;
+                    in = ImageInput::open(filename);
+                }
                 return in ? py::cast(in.release()) : py::none();
             },
             "filename"_a)
@@ -192,13 +200,18 @@ declare_imageinput(py::module& m)
             "open",
             [](const std::string& filename,
                const ImageSpec& config) -> py::object {
-                auto in = ImageInput::open(filename, &config);
+                std::unique_ptr<ImageInput> in;
+                {
+                    py::gil_scoped_release gil;
+                    in = ImageInput::open(filename, &config);
+                }
                 return in ? py::cast(in.release()) : py::none();
             },
             "filename"_a, "config"_a)
         .def("format_name", &ImageInput::format_name)
         .def("valid_file",
              [](ImageInput& self, const std::string& filename) {
+                 py::gil_scoped_release gil;
                  return self.valid_file(filename);
              })
         .def("spec", [](ImageInput& self) { return self.spec(); })
@@ -218,7 +231,11 @@ declare_imageinput(py::module& m)
              [](const ImageInput& self, const std::string& feature) {
                  return self.supports(feature);
              })
-        .def("close", &ImageInput::close)
+        .def("close",
+             [](ImageInput& self) {
+                 py::gil_scoped_release gil;
+                 return self.close();
+             })
         .def("current_subimage", &ImageInput::current_subimage)
         .def("current_miplevel", &ImageInput::current_miplevel)
         .def("seek_subimage",
@@ -24,6 +24,7 @@ ImageOutput_open_specs(ImageOutput& self, const std::string& name,
         else
             return false;  // Tuple item was not an ImageSpec
     }
+    py::gil_scoped_release gil;
     return self.open(name, int(length), &Cspecs[0]);
 }
 
@@ -198,7 +199,11 @@ declare_imageoutput(py::module& m)
             "create",
             [](const std::string& filename,
                const std::string& searchpath) -> py::object {
-                auto out(ImageOutput::create(filename, nullptr, searchpath));
+                std::unique_ptr<ImageOutput> out;
+                {
+                    py::gil_scoped_release gil;
+                    out = ImageOutput::create(filename, nullptr, searchpath);
+                }
                 return out ? py::cast(out.release()) : py::none();
             },
             "filename"_a, "plugin_searchpath"_a = "")
@@ -220,6 +225,7 @@ declare_imageoutput(py::module& m)
                 else if (!Strutil::iequals(modestr, "Create"))
                     throw std::invalid_argument(
                         Strutil::fmt::format("Unknown open mode '{}'", modestr));
+                py::gil_scoped_release gil;
                 return self.open(name, newspec, mode);
             },
             "filename"_a, "spec"_a, "mode"_a = "Create")
@@ -227,11 +233,16 @@ declare_imageoutput(py::module& m)
             "open",
             [](ImageOutput& self, const std::string& name,
                const std::vector<ImageSpec>& specs) {
+                py::gil_scoped_release gil;
                 return self.open(name, (int)specs.size(), &specs[0]);
             },
             "filename"_a, "specs"_a)
         .def("open", &ImageOutput_open_specs)
-        .def("close", [](ImageOutput& self) { return self.close(); })
+        .def("close",
+             [](ImageOutput& self) {
+                 py::gil_scoped_release gil;
+                 return self.close();
+             })
         .def("write_image", &ImageOutput_write_image)
         .def("write_scanline", &ImageOutput_write_scanline, "y"_a, "z"_a,
              "pixels"_a)
@@ -250,8 +261,11 @@ declare_imageoutput(py::module& m)
              [](ImageOutput& self, const ImageBuf& thumb) {
                  return self.set_thumbnail(thumb);
              })
-        .def("copy_image", [](ImageOutput& self,
-                              ImageInput& in) { return self.copy_image(&in); })
+        .def("copy_image",
+             [](ImageOutput& self, ImageInput& in) {
+                 py::gil_scoped_release gil;
+                 return self.copy_image(&in);
+             })
         .def_property_readonly("has_error", &ImageOutput::has_error)
         .def(
             "geterror",
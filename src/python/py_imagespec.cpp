@@ -262,6 +262,14 @@ declare_imagespec(py::module& m)
         .def("to_xml",
              [](const ImageSpec& spec) { return PY_STR(spec.to_xml()); })
         .def("from_xml", &ImageSpec::from_xml)
+        .def("to_binary",
+             [](const ImageSpec& spec) { return py::bytes(spec.to_binary()); })
+        .def(
+            "from_binary",
+            [](ImageSpec& spec, const py::bytes& data) {
+                return spec.from_binary(std::string(data));
+            },
+            "data"_a)
         .def("valid_tile_range", &ImageSpec::valid_tile_range, "xbegin"_a,
              "xend"_a, "ybegin"_a, "yend"_a, "zbegin"_a, "zend"_a)
         .def("copy_dimensions", &ImageSpec::copy_dimensions, "other"_a)
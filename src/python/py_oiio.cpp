@@ -285,6 +285,7 @@ OIIO_DECLARE_PYMODULE(PYMODULE_NAME)
     declare_imageoutput(m);
     declare_imagebuf(m);
     declare_imagecache(m);
+    declare_batchloader(m);
 
     // TextureSys classes
     declare_wrap(m);
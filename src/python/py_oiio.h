@@ -102,6 +102,7 @@ void declare_mipmpode (py::module& m);
 void declare_interpmode (py::module& m);
 void declare_textureopt (py::module& m);
 void declare_texturesystem (py::module& m);
+void declare_batchloader (py::module& m);
 
 // bool PyProgressCallback(void*, float);
 // object C_array_to_Python_array (const char *data, TypeDesc type, size_t size);
@@ -533,6 +534,27 @@ getattribute_typed(const T& obj, const std::string& name,
 
 
 
+// The buffer protocol format code of a pixel data type, or nullptr if
+// numpy has no equivalent.
+inline const char*
+buffer_format_code(TypeDesc format)
+{
+    switch (format.basetype) {
+    case TypeDesc::UINT8: return "B";
+    case TypeDesc::INT8: return "b";
+    case TypeDesc::UINT16: return "H";
+    case TypeDesc::INT16: return "h";
+    case TypeDesc::UINT32: return "I";
+    case TypeDesc::INT32: return "i";
+    case TypeDesc::HALF: return "e";
+    case TypeDesc::FLOAT: return "f";
+    case TypeDesc::DOUBLE: return "d";
+    default: return nullptr;
+    }
+}
+
+
+
 // TRANSFERS ownership of the data pointer!
 // N.B. There is some evidence that this doesn't work properly with
 // non-float arrays. Maybe a limitation of pybind11?
@@ -4,6 +4,8 @@
 
 #include "py_oiio.h"
 
+#include <OpenImageIO/parallel.h>
+
 namespace PyOpenImageIO {
 
 
@@ -86,7 +88,8 @@ declare_mipmpode(py::module& m)
         .value("NoMIP", Tex::MipMode::NoMIP)
         .value("OneLevel", Tex::MipMode::OneLevel)
         .value("Trilinear", Tex::MipMode::Trilinear)
-        .value("Aniso", Tex::MipMode::Aniso);
+        .value("Aniso", Tex::MipMode::Aniso)
+        .value("EWA", Tex::MipMode::EWA);
 }
 
 
@@ -168,6 +171,114 @@ declare_textureopt(py::module& m)
 
 
 
+// Float arrays of lookup coordinates, converted as needed.
+using FloatArray
+    = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+// The extent and data of each of the arrays of coordinates of a batch of
+// lookups, each of which must have n elements of `width` floats -- or just
+// one of them, which is used for every lookup.
+static bool
+batch_arrays(std::initializer_list<const FloatArray*> arrays, size_t width,
+             size_t& n, std::vector<const float*>& data,
+             std::vector<size_t>& strides)
+{
+    n = 0;
+    for (auto a : arrays)
+        n = std::max(n, size_t(a->size()) / width);
+    for (auto a : arrays) {
+        size_t an = a->size() / width;
+        if (size_t(a->size()) != an * width || (an != n && an != 1))
+            return false;
+        data.push_back(a->data());
+        strides.push_back(an == 1 ? 0 : width);
+    }
+    return true;
+}
+
+
+
+// Do a batch of texture lookups in parallel, returning an array of n
+// results of nchannels each.
+static py::object
+TextureSystem_texture_array(const TextureSystemWrap& ts,
+                            const std::string& filename,
+                            TextureOptWrap& options, const FloatArray& s,
+                            const FloatArray& t, const FloatArray& dsdx,
+                            const FloatArray& dtdx, const FloatArray& dsdy,
+                            const FloatArray& dtdy, int nchannels)
+{
+    size_t n;
+    std::vector<const float*> d;
+    std::vector<size_t> st;
+    if (!batch_arrays({ &s, &t, &dsdx, &dtdx, &dsdy, &dtdy }, 1, n, d, st))
+        throw std::invalid_argument(
+            "texture: coordinate arrays must all be the same length");
+    if (!ts.m_texsys || nchannels < 1)
+        return py::none();
+    float* result = new float[n * nchannels];
+    {
+        py::gil_scoped_release gil;
+        TextureSystem* texsys = ts.m_texsys.get();
+        auto handle = texsys->get_texture_handle(ustring(filename));
+        parallel_for_chunked(0, int64_t(n), 0, [&](int64_t b, int64_t e) {
+            TextureOpt opt(options);
+            auto thread_info = texsys->get_perthread_info();
+            for (int64_t i = b; i < e; ++i)
+                texsys->texture(handle, thread_info, opt, d[0][i * st[0]],
+                                d[1][i * st[1]], d[2][i * st[2]],
+                                d[3][i * st[3]], d[4][i * st[4]],
+                                d[5][i * st[5]], nchannels,
+                                result + i * nchannels);
+        });
+    }
+    return make_numpy_array(result, 2, nchannels, n, 1);
+}
+
+
+
+// Do a batch of environment lookups in parallel, returning an array of n
+// results of nchannels each.
+static py::object
+TextureSystem_environment_array(const TextureSystemWrap& ts,
+                                const std::string& filename,
+                                TextureOptWrap& options, const FloatArray& R,
+                                const FloatArray& dRdx, const FloatArray& dRdy,
+                                int nchannels)
+{
+    size_t n;
+    std::vector<const float*> d;
+    std::vector<size_t> st;
+    if (!batch_arrays({ &R, &dRdx, &dRdy }, 3, n, d, st))
+        throw std::invalid_argument(
+            "environment: direction arrays must all be the same length");
+    if (!ts.m_texsys || nchannels < 1)
+        return py::none();
+    float* result = new float[n * nchannels];
+    {
+        py::gil_scoped_release gil;
+        TextureSystem* texsys = ts.m_texsys.get();
+        auto handle = texsys->get_texture_handle(ustring(filename));
+        parallel_for_chunked(0, int64_t(n), 0, [&](int64_t b, int64_t e) {
+            TextureOpt opt(options);
+            auto thread_info = texsys->get_perthread_info();
+            for (int64_t i = b; i < e; ++i) {
+                const float* r   = d[0] + i * st[0];
+                const float* rdx = d[1] + i * st[1];
+                const float* rdy = d[2] + i * st[2];
+                texsys->environment(handle, thread_info, opt,
+                                    Imath::V3f(r[0], r[1], r[2]),
+                                    Imath::V3f(rdx[0], rdx[1], rdx[2]),
+                                    Imath::V3f(rdy[0], rdy[1], rdy[2]),
+                                    nchannels, result + i * nchannels);
+            }
+        });
+    }
+    return make_numpy_array(result, 2, nchannels, n, 1);
+}
+
+
+
 void
 declare_texturesystem(py::module& m)
 {
@@ -233,6 +344,9 @@ declare_texturesystem(py::module& m)
             },
             "filename"_a, "options"_a, "s"_a, "t"_a, "dsdx"_a, "dtdx"_a,
             "dsdy"_a, "dtdy"_a, "nchannels"_a)
+        .def("texture", &TextureSystem_texture_array, "filename"_a,
+             "options"_a, "s"_a, "t"_a, "dsdx"_a, "dtdx"_a, "dsdy"_a, "dtdy"_a,
+             "nchannels"_a)
 
 
         .def(
@@ -284,6 +398,8 @@ declare_texturesystem(py::module& m)
                 return C_to_tuple(result, nchannels);
             },
             "filename"_a, "options"_a, "R"_a, "dRdx"_a, "dRdy"_a, "nchannels"_a)
+        .def("environment", &TextureSystem_environment_array, "filename"_a,
+             "options"_a, "R"_a, "dRdx"_a, "dRdy"_a, "nchannels"_a)
 
         .def(
             "resolve_filename",
@@ -448,9 +448,10 @@ RawInput::open_raw(bool unpack, const std::string& name,
     }
     m_processor->adjust_sizes_info_only();
 
-    // Process image at half size if "raw:half_size" is not 0
-    m_processor->imgdata.params.half_size
-        = config.get_int_attribute("raw:half_size", 0);
+    // Process image at half size if "raw:half_size" is not 0, or if a
+    // reduced resolution was asked for
+    m_processor->imgdata.params.half_size = config.get_int_attribute(
+        "raw:half_size", config.get_int_attribute("oiio:reduce_factor") >= 2);
     int div = m_processor->imgdata.params.half_size == 0 ? 1 : 2;
 
     // Set file information
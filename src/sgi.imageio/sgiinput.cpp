@@ -16,7 +16,7 @@ public:
     const char* format_name(void) const override { return "sgi"; }
     int supports(string_view feature) const override
     {
-        return feature == "ioproxy";
+        return feature == "ioproxy" || feature == "parallel_scanline_decode";
     }
     bool valid_file(Filesystem::IOProxy* ioproxy) const override;
     bool open(const std::string& name, ImageSpec& spec) override;
@@ -25,6 +25,8 @@ public:
     bool close(void) override;
     bool read_native_scanline(int subimage, int miplevel, int y, int z,
                               void* data) override;
+    bool read_native_scanlines(int subimage, int miplevel, int ybegin,
+                               int yend, int z, void* data) override;
 
 private:
     std::string m_filename;
@@ -48,6 +50,10 @@ private:
     // Return true if ok, false if there was a read error.
     bool read_offset_tables();
 
+    // Read scanline y of the open file. This only reads the proxy with
+    // pread() and changes no state, so may be called by several threads.
+    bool read_scanline(int y, void* data);
+
     // read channel scanline data from file, uncompress it and save the data to
     // 'out' buffer; 'out' should be allocate before call to this method.
     // Return true if ok, false if there was a read error.
@@ -179,7 +185,33 @@ SgiInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
     lock_guard lock(*this);
     if (!seek_subimage(subimage, miplevel))
         return false;
+    return read_scanline(y, data);
+}
+
+
+
+bool
+SgiInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
+                                int yend, int /*z*/, void* data)
+{
+    {
+        lock_guard lock(*this);
+        if (!seek_subimage(subimage, miplevel))
+            return false;
+    }
+    yend             = std::min(yend, m_spec.y + m_spec.height);
+    size_t scanbytes = m_spec.scanline_bytes(true);
+    for (int y = ybegin; y < yend; ++y)
+        if (!read_scanline(y, (char*)data + (y - ybegin) * scanbytes))
+            return false;
+    return true;
+}
+
+
 
+bool
+SgiInput::read_scanline(int y, void* data)
+{
     if (y < 0 || y > m_spec.height)
         return false;
 
@@ -205,10 +237,13 @@ SgiInput::read_native_scanline(int subimage, int miplevel, int y, int /*z*/,
             ptrdiff_t off             = y + c * m_spec.height;
             ptrdiff_t scanline_offset = sgi_pvt::SGI_HEADER_LEN
                                         + off * m_spec.width * bpc;
-            ioseek(scanline_offset);
-            channeldata[c].resize(m_spec.width * bpc);
-            if (!ioread(&(channeldata[c][0]), 1, m_spec.width * bpc))
+            size_t size = size_t(m_spec.width * bpc);
+            channeldata[c].resize(size);
+            if (ioproxy()->pread(channeldata[c].data(), size, scanline_offset)
+                != size) {
+                errorfmt("Read error: hit end of file in sgi reader");
                 return false;
+            }
         }
     }
 
@@ -242,9 +277,13 @@ SgiInput::uncompress_rle_channel(int scanline_off, int scanline_len,
     int bpc = m_sgi_header.bpc;
     std::unique_ptr<unsigned char[]> rle_scanline(
         new unsigned char[scanline_len]);
-    ioseek(scanline_off);
-    if (!ioread(&rle_scanline[0], 1, scanline_len))
+    if (scanline_len < 0
+        || ioproxy()->pread(&rle_scanline[0], size_t(scanline_len),
+                            scanline_off)
+               != size_t(scanline_len)) {
+        errorfmt("Read error: hit end of file in sgi reader");
         return false;
+    }
     int limit = m_spec.width;
     int i     = 0;
     if (bpc == 1) {
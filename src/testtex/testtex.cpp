@@ -3,6 +3,7 @@
 // https://github.com/AcademySoftwareFoundation/OpenImageIO
 
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -10,6 +11,7 @@
 #include <ctime>
 #include <iostream>
 #include <iterator>
+#include <unordered_map>
 
 #include <OpenImageIO/Imath.h>
 #include <OpenImageIO/argparse.h>
@@ -63,6 +65,7 @@ static bool nowarp        = false;
 static bool tube          = false;
 static bool use_handle    = false;
 static bool use_bluenoise = false;
+static bool nonblocking   = false;
 static float cachesize    = -1;
 static int maxfiles       = -1;
 static int mipmode        = int(TextureOpt::MipModeDefault);
@@ -101,6 +104,9 @@ static int num_test_files = 0;
 static std::vector<std::string> filenames_to_delete;
 const int pieces_per_udim = 20;
 static std::vector<TextureSystem::TextureHandle*> texture_handles;
+static std::string recordname, replayname;
+static std::string recordtilesname, analyzetilesname;
+static std::string cachesizes = "16,64,256,1024,4096";
 void* dummyptr;
 static const ImageBuf& bluenoiseimg(ImageBufAlgo::bluenoise_image());
 
@@ -177,11 +183,13 @@ getargs(int argc, const char* argv[])
     ap.arg("--anisomax %d:MAX", &anisomax)
       .help(Strutil::fmt::format("Set max anisotropy (default: {})", anisomax));
     ap.arg("--mipmode %d:MODE", &mipmode)
-      .help("Set mip mode (default: 0 = aniso)");
+      .help("Set mip mode (default: 0 = aniso, 5 = ewa)");
     ap.arg("--interpmode %d:MODE", &interpmode)
       .help("Set interp mode (default: 3 = smart bicubic)");
     ap.arg("--stochastic %d:MODE", &stochastic)
       .help("Set stochastic sampling mode (default: 0 = none)");
+    ap.arg("--nonblocking", &nonblocking)
+      .help("Don't wait for tiles, use coarser MIP levels until they're read");
     ap.arg("--missing %f:R %f:G %f:B", &missing[0], &missing[1], &missing[2])
       .help("Specify missing texture color");
     ap.arg("--autotile %d:TILESIZE", &autotile)
@@ -270,12 +278,23 @@ getargs(int argc, const char* argv[])
       .help("Use the specified subimage (by index)");
     ap.arg("--subimagename %s:NAME", &subimagename)
       .help("Use the specified subimage (by name)");
+    ap.arg("--record %s:FILENAME", &recordname)
+      .help("Record all texture lookups to a file");
+    ap.arg("--replay %s:FILENAME", &replayname)
+      .help("Replay the texture lookups recorded in a file (best of --trials)");
+    ap.arg("--record-tiles %s:FILENAME", &recordtilesname)
+      .help("Record all tile cache accesses to a file");
+    ap.arg("--analyze-tiles %s:FILENAME", &analyzetilesname)
+      .help("Report the working set and simulated hit rates of recorded tile accesses");
+    ap.arg("--cachesizes %s:MBLIST", &cachesizes)
+      .help("Cache sizes (MB, comma separated) to simulate for --analyze-tiles");
 
     // clang-format on
     ap.parse(argc, argv);
 
     if (filenames.size() < 1 && !num_test_files && !test_construction
-        && !test_getimagespec && !testhash) {
+        && !test_getimagespec && !testhash && replayname.empty()
+        && analyzetilesname.empty()) {
         std::cerr << "testtex: Must have at least one input file\n";
         ap.usage();
         exit(EXIT_FAILURE);
@@ -306,6 +325,7 @@ initialize_opt(TextureOpt& opt)
     else if (!subimagename.empty())
         opt.subimagename = ustring(subimagename);
     opt.colortransformid = texcolortransform_id;
+    opt.nonblocking      = nonblocking;
 }
 
 
@@ -1579,6 +1599,439 @@ launch_tex_threads(int numthreads, int iterations)
 
 
 
+// The layout of the lookups recorded by the TextureSystem's
+// "record_lookups" attribute. This must match LookupRecord in
+// libtexture/texture_pvt.h.
+struct LookupRecord {
+    enum Kind : uint8_t { Texture = 0, Environment = 1 };
+    enum Flags : uint8_t { Derivs = 1, ConservativeFilter = 2 };
+    uint32_t file;
+    uint8_t kind;
+    uint8_t nchannels;
+    uint8_t interpmode, mipmode, swrap, twrap;
+    uint8_t flags;
+    uint8_t unused;
+    uint16_t firstchannel, anisotropic;
+    int32_t subimage, colortransformid;
+    float sblur, tblur, swidth, twidth, fill, rnd;
+    float coords[9];
+};
+static_assert(sizeof(LookupRecord) == 84, "LookupRecord must not be padded");
+
+
+
+// Replay the lookups recorded in filename: each recorded thread's lookups,
+// in the order it made them, by a thread of its own.
+static bool
+replay_lookups(const std::string& filename)
+{
+    static const char magic[] = "OIIO lookup record 1\n";
+    std::string data(Filesystem::file_size(filename), '\0');
+    if (data.empty()
+        || Filesystem::read_bytes(filename, &data[0], data.size())
+               != data.size()
+        || !Strutil::starts_with(data, magic)) {
+        print(std::cerr, "testtex: {} is not a texture lookup record\n",
+              filename);
+        return false;
+    }
+
+    // Read the files and each thread's lookups.
+    struct File {
+        TextureSystem::TextureHandle* handle = nullptr;
+        ustring subimagename;
+    };
+    std::vector<File> files;
+    std::vector<std::vector<LookupRecord>> lookups;
+    size_t pos = strlen(magic);
+    auto read  = [&](void* dst, size_t n) {
+        if (n > data.size() - pos)
+            return false;
+        memcpy(dst, &data[pos], n);
+        pos += n;
+        return true;
+    };
+    bool ok = true;
+    while (ok && pos < data.size()) {
+        char block         = data[pos++];
+        uint32_t header[3] = { 0, 0, 0 };
+        if (block == 'F' && read(header, sizeof(header))
+            && size_t(header[1]) + header[2] <= data.size() - pos) {
+            if (files.size() <= header[0])
+                files.resize(header[0] + 1);
+            ustring name(&data[pos], header[1]);
+            files[header[0]].handle = texsys->get_texture_handle(name);
+            files[header[0]].subimagename = ustring(&data[pos + header[1]],
+                                                    header[2]);
+            pos += header[1] + header[2];
+        } else if (block == 'L' && read(header, 2 * sizeof(uint32_t))) {
+            if (lookups.size() <= header[0])
+                lookups.resize(header[0] + 1);
+            auto& t  = lookups[header[0]];
+            size_t n = t.size();
+            t.resize(n + header[1]);
+            ok = read(t.data() + n, header[1] * sizeof(LookupRecord));
+            for (size_t i = n; ok && i < t.size(); ++i)
+                ok = t[i].file < files.size();
+        } else {
+            ok = false;
+        }
+    }
+    if (!ok) {
+        print(std::cerr, "testtex: {} is truncated or corrupt\n", filename);
+        return false;
+    }
+
+    size_t total = 0;
+    for (auto& t : lookups)
+        total += t.size();
+    print("Replaying {} lookups of {} files by {} threads\n", total,
+          files.size(), lookups.size());
+
+    auto replay_thread = [&](const std::vector<LookupRecord>& records) {
+        TextureSystem::Perthread* thread_info = texsys->get_perthread_info();
+        float result[3 * 256];
+        float* dresultds = result + 256;
+        float* dresultdt = dresultds + 256;
+        TextureOpt opt;
+        for (const LookupRecord& r : records) {
+            const File& f(files[r.file]);
+            bool derivs             = (r.flags & LookupRecord::Derivs);
+            opt.firstchannel        = r.firstchannel;
+            opt.subimage            = r.subimage;
+            opt.subimagename        = f.subimagename;
+            opt.interpmode          = TextureOpt::InterpMode(r.interpmode);
+            opt.mipmode             = TextureOpt::MipMode(r.mipmode);
+            opt.swrap               = TextureOpt::Wrap(r.swrap);
+            opt.twrap               = TextureOpt::Wrap(r.twrap);
+            opt.conservative_filter = (r.flags
+                                       & LookupRecord::ConservativeFilter);
+            opt.anisotropic         = r.anisotropic;
+            opt.colortransformid    = r.colortransformid;
+            opt.sblur               = r.sblur;
+            opt.tblur               = r.tblur;
+            opt.swidth              = r.swidth;
+            opt.twidth              = r.twidth;
+            opt.fill                = r.fill;
+            opt.rnd                 = r.rnd;
+            const float* c          = r.coords;
+            if (r.kind == LookupRecord::Texture)
+                texsys->texture(f.handle, thread_info, opt, c[0], c[1], c[2],
+                                c[3], c[4], c[5], r.nchannels, result,
+                                derivs ? dresultds : nullptr,
+                                derivs ? dresultdt : nullptr);
+            else
+                texsys->environment(f.handle, thread_info, opt,
+                                    Imath::V3f(c[0], c[1], c[2]),
+                                    Imath::V3f(c[3], c[4], c[5]),
+                                    Imath::V3f(c[6], c[7], c[8]),
+                                    r.nchannels, result,
+                                    derivs ? dresultds : nullptr,
+                                    derivs ? dresultdt : nullptr);
+        }
+    };
+    auto replay = [&]() {
+        if (invalidate_before_iter)
+            texsys->invalidate_all(true);
+        OIIO::thread_group threads;
+        for (auto& t : lookups)
+            threads.create_thread(replay_thread, std::cref(t));
+        threads.join_all();
+    };
+    double range;
+    double t = time_trial(replay, ntrials, 1, &range);
+    if (runstats || verbose)
+        print("Replay time: {:.3f} s (best of {}, range {:.3f})\n", t,
+              ntrials, range);
+    return true;
+}
+
+
+
+// The layout of a tile cache access recorded by the ImageCache's
+// "record_tiles" attribute, and of the recording's header. These must
+// match TileAccessRecord and TileRecordHeader in libtexture.
+struct TileAccessRecord {
+    int64_t time;
+    uint32_t file;
+    uint16_t subimage, miplevel;
+    int32_t x, y, z;
+    uint16_t chbegin, chend;
+    uint32_t bytes;
+    uint8_t hit;
+    uint8_t unused[3];
+};
+static_assert(sizeof(TileAccessRecord) == 40,
+              "TileAccessRecord must not be padded");
+
+struct TileRecordHeader {
+    char magic[16];
+    uint32_t block_records;
+    uint32_t capacity;
+    uint64_t blocks;
+    uint64_t files_offset;
+};
+
+
+
+// Read the tile accesses recorded in filename, in the order they happened.
+static bool
+read_tile_record(const std::string& filename,
+                 std::vector<TileAccessRecord>& accesses,
+                 std::vector<std::string>& files, size_t& nthreads,
+                 bool& wrapped)
+{
+    std::string data(Filesystem::file_size(filename), '\0');
+    TileRecordHeader header;
+    if (data.size() < sizeof(header)
+        || Filesystem::read_bytes(filename, &data[0], data.size())
+               != data.size()
+        || !Strutil::starts_with(data, "OIIO tile rec 1\n")) {
+        print(std::cerr, "testtex: {} is not a tile access record\n",
+              filename);
+        return false;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    if (!header.files_offset) {
+        print(std::cerr, "testtex: the recording in {} was not finished\n",
+              filename);
+        return false;
+    }
+
+    // The blocks of the ring, from the oldest, then the table of files.
+    size_t block_bytes = 2 * sizeof(uint32_t)
+                         + header.block_records * sizeof(TileAccessRecord);
+    uint64_t nblocks   = header.blocks;
+    uint64_t first     = 0;
+    wrapped            = header.capacity && nblocks > header.capacity;
+    if (wrapped) {
+        first   = nblocks % header.capacity;
+        nblocks = header.capacity;
+    }
+    bool ok  = sizeof(header) + nblocks * block_bytes <= header.files_offset
+              && header.files_offset + sizeof(uint32_t) <= data.size();
+    nthreads = 0;
+    for (uint64_t b = 0; ok && b < nblocks; ++b) {
+        uint64_t slot = header.capacity ? (first + b) % header.capacity : b;
+        const char* block = data.data() + sizeof(header) + slot * block_bytes;
+        uint32_t thread_count[2];
+        memcpy(thread_count, block, sizeof(thread_count));
+        ok       = thread_count[1] <= header.block_records;
+        nthreads = std::max(nthreads, size_t(thread_count[0]) + 1);
+        size_t n = accesses.size();
+        accesses.resize(n + (ok ? thread_count[1] : 0));
+        memcpy(accesses.data() + n, block + sizeof(thread_count),
+               (accesses.size() - n) * sizeof(TileAccessRecord));
+    }
+    size_t pos = header.files_offset;
+    uint32_t nfiles = 0;
+    if (ok) {
+        memcpy(&nfiles, &data[pos], sizeof(nfiles));
+        pos += sizeof(nfiles);
+    }
+    for (uint32_t f = 0; ok && f < nfiles; ++f) {
+        uint32_t len = 0;
+        ok = pos + sizeof(len) <= data.size();
+        if (ok) {
+            memcpy(&len, &data[pos], sizeof(len));
+            pos += sizeof(len);
+            ok = len <= data.size() - pos;
+        }
+        if (ok) {
+            files.emplace_back(&data[pos], len);
+            pos += len;
+        }
+    }
+    for (size_t i = 0; ok && i < accesses.size(); ++i)
+        ok = accesses[i].file < files.size();
+    if (!ok) {
+        print(std::cerr, "testtex: {} is truncated or corrupt\n", filename);
+        return false;
+    }
+    std::stable_sort(accesses.begin(), accesses.end(),
+                     [](const TileAccessRecord& a, const TileAccessRecord& b) {
+                         return a.time < b.time;
+                     });
+    return true;
+}
+
+
+
+// Report, for the tile accesses recorded in filename: the working set
+// over time windows of several lengths, the histogram of reuse distances
+// (the bytes of the other tiles used since the last use of the same
+// tile), and the hit rate that an LRU cache of each of the --cachesizes
+// would have had.
+static bool
+analyze_tiles(const std::string& filename)
+{
+    std::vector<TileAccessRecord> accesses;
+    std::vector<std::string> files;
+    size_t nthreads = 0;
+    bool wrapped    = false;
+    if (!read_tile_record(filename, accesses, files, nthreads, wrapped))
+        return false;
+    size_t n = accesses.size();
+
+    // Number the distinct tiles.
+    struct TileKey {
+        uint32_t file;
+        uint16_t subimage, miplevel;
+        int32_t x, y, z;
+        uint16_t chbegin, chend;
+        bool operator==(const TileKey& k) const
+        {
+            return file == k.file && subimage == k.subimage
+                   && miplevel == k.miplevel && x == k.x && y == k.y
+                   && z == k.z && chbegin == k.chbegin && chend == k.chend;
+        }
+    };
+    struct TileKeyHash {
+        size_t operator()(const TileKey& k) const
+        {
+            return Strutil::strhash(sizeof(TileKey), (const char*)&k);
+        }
+    };
+    std::unordered_map<TileKey, uint32_t, TileKeyHash> tile_numbers;
+    std::vector<uint32_t> tiles(n);   // The tile of each access
+    std::vector<uint64_t> tilebytes;  // The size of each tile
+    size_t hits = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const TileAccessRecord& a(accesses[i]);
+        TileKey key;
+        memset(&key, 0, sizeof(key));
+        key.file     = a.file;
+        key.subimage = a.subimage;
+        key.miplevel = a.miplevel;
+        key.x        = a.x;
+        key.y        = a.y;
+        key.z        = a.z;
+        key.chbegin  = a.chbegin;
+        key.chend    = a.chend;
+        auto found   = tile_numbers.emplace(key, uint32_t(tilebytes.size()));
+        if (found.second)
+            tilebytes.push_back(a.bytes);
+        tiles[i] = found.first->second;
+        tilebytes[tiles[i]] = std::max(tilebytes[tiles[i]], uint64_t(a.bytes));
+        hits += a.hit;
+    }
+    uint64_t totalbytes = 0;
+    for (auto b : tilebytes)
+        totalbytes += b;
+    double duration = n ? (accesses.back().time - accesses[0].time) * 1.0e-9
+                        : 0.0;
+
+    print("Tile accesses recorded in {}:\n", filename);
+    print("  {} accesses ({} hits, {} misses) by {} threads over {}\n", n,
+          hits, n - hits, nthreads, Strutil::timeintervalformat(duration, 2));
+    if (wrapped)
+        print("  (only the most recent accesses; older ones were "
+              "overwritten)\n");
+    print("  {} distinct tiles of {} files, {} in all\n", tilebytes.size(),
+          files.size(), Strutil::memformat(totalbytes));
+
+    // The working set: the bytes of distinct tiles used within windows of
+    // time of each length, averaged over the windows that saw any use.
+    print("\nWorking set by time window:\n");
+    print("  {:>10}  {:>10}  {:>10}\n", "window", "mean", "max");
+    std::vector<uint64_t> lastwindow(tilebytes.size());
+    for (double window = 1.0e-3; n; window *= 10.0) {
+        uint64_t windowbytes = 0, maxbytes = 0, sumbytes = 0;
+        uint64_t nwindows = 0, current = 0;
+        std::fill(lastwindow.begin(), lastwindow.end(), 0);
+        for (size_t i = 0; i <= n; ++i) {
+            // Window numbers start at 1, so that 0 means "not yet used",
+            // and the end of the accesses ends the last window.
+            uint64_t w = 0;
+            if (i < n) {
+                double t = (accesses[i].time - accesses[0].time) * 1.0e-9;
+                w        = uint64_t(t / window) + 1;
+            }
+            if (w != current) {
+                if (current) {
+                    sumbytes += windowbytes;
+                    maxbytes = std::max(maxbytes, windowbytes);
+                    ++nwindows;
+                }
+                current     = w;
+                windowbytes = 0;
+            }
+            if (i < n && lastwindow[tiles[i]] != w) {
+                lastwindow[tiles[i]] = w;
+                windowbytes += tilebytes[tiles[i]];
+            }
+        }
+        print("  {:>10}  {:>10}  {:>10}\n",
+              Strutil::timeintervalformat(window, 3),
+              Strutil::memformat(sumbytes / std::max(nwindows, uint64_t(1))),
+              Strutil::memformat(maxbytes));
+        if (window > duration)
+            break;
+    }
+
+    // Reuse distances, using a Fenwick tree over the accesses that holds,
+    // at the latest access of each tile, the size of that tile.
+    std::vector<uint64_t> tree(n + 1, 0);
+    auto add = [&](size_t i, int64_t bytes) {
+        for (++i; i <= n; i += i & (~i + 1))
+            tree[i] += bytes;
+    };
+    auto sum = [&](size_t i) {  // Of the accesses before i
+        uint64_t total = 0;
+        for (; i > 0; i -= i & (~i + 1))
+            total += tree[i];
+        return total;
+    };
+    const uint64_t first_use = ~uint64_t(0);
+    std::vector<uint64_t> distances(n);  // Includes the tile itself
+    std::vector<size_t> lastuse(tilebytes.size(), ~size_t(0));
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t t  = tiles[i];
+        uint64_t tb = tilebytes[t];
+        if (lastuse[t] == ~size_t(0)) {
+            distances[i] = first_use;
+        } else {
+            distances[i] = sum(i) - sum(lastuse[t] + 1) + tb;
+            add(lastuse[t], -int64_t(tb));
+        }
+        add(i, int64_t(tb));
+        lastuse[t] = i;
+    }
+
+    print("\nReuse distance (bytes of tiles used since the last use):\n");
+    size_t nfirst  = std::count(distances.begin(), distances.end(),
+                                first_use);
+    size_t counted = 0;
+    for (uint64_t lower = 0, upper = 64 * 1024; counted + nfirst < n;
+         lower = upper, upper *= 2) {
+        size_t c = std::count_if(distances.begin(), distances.end(),
+                                 [=](uint64_t d) {
+                                     return d > lower && d <= upper;
+                                 });
+        print("  <= {:>10}  {:10}  {:5.1f}%\n", Strutil::memformat(upper), c,
+              100.0 * c / n);
+        counted += c;
+    }
+    print("  first use      {:10}  {:5.1f}%\n", nfirst,
+          n ? 100.0 * nfirst / n : 0.0);
+
+    // Under LRU, an access hits if the tiles used since the last use of
+    // the same tile, and the tile itself, fit in the cache.
+    print("\nSimulated LRU hit rates:\n");
+    print("  {:>13}  {:>8}\n", "max_memory_MB", "hit rate");
+    for (float mb : Strutil::extract_from_list_string<float>(cachesizes)) {
+        uint64_t size = uint64_t(mb * 1024.0 * 1024.0);
+        size_t h      = std::count_if(distances.begin(), distances.end(),
+                                      [=](uint64_t d) { return d <= size; });
+        print("  {:>13}  {:7.2f}%\n", mb, n ? 100.0 * h / n : 0.0);
+    }
+    if (n)
+        print("  {:>13}  {:7.2f}%\n", "recorded", 100.0 * hits / n);
+    return true;
+}
+
+
+
 class GridImageInput final : public ImageInput {
 public:
     GridImageInput()
@@ -1831,6 +2284,11 @@ main(int argc, const char* argv[])
     texsys->attribute("gray_to_rgb", gray_to_rgb);
     texsys->attribute("flip_t", flip_t);
     texsys->attribute("stochastic", stochastic);
+    if (recordname.size() && !texsys->attribute("record_lookups", recordname))
+        print(std::cerr, "testtex: {}\n", texsys->geterror());
+    if (recordtilesname.size()
+        && !texsys->attribute("record_tiles", recordtilesname))
+        print(std::cerr, "testtex: {}\n", texsys->geterror());
     texcolortransform_id
         = std::max(0, texsys->get_colortransform_id(ustring(texcolorspace),
                                                     ustring("scene_linear")));
@@ -1896,6 +2354,12 @@ main(int argc, const char* argv[])
         TextureSystem::unit_test_hash();
     }
 
+    bool ok = true;
+    if (replayname.size())
+        ok = replay_lookups(replayname);
+    if (analyzetilesname.size())
+        ok &= analyze_tiles(analyzetilesname);
+
     Imath::M33f scale;
     scale.scale(Imath::V2f(0.3, 0.3));
     Imath::M33f rot;
@@ -2055,5 +2519,5 @@ main(int argc, const char* argv[])
         Filesystem::remove(f, err);
     }
     shutdown();
-    return 0;
+    return ok ? 0 : EXIT_FAILURE;
 }
@@ -0,0 +1,30 @@
+// Copyright Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: Apache-2.0
+// https://github.com/AcademySoftwareFoundation/OpenImageIO
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Private definitions internal to the tiff.imageio plugin
+/////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <OpenImageIO/imageio.h>
+
+#include <tiffio.h>
+
+
+OIIO_PLUGIN_NAMESPACE_BEGIN
+
+namespace tiff_pvt {
+
+/// If `in` is one of this plugin's TIFF readers, return its libtiff handle,
+/// positioned at its current subimage, otherwise return nullptr. This is
+/// how TIFFOutput::copy_image() gets at the raw strips or tiles.
+TIFF*
+input_handle(ImageInput* in);
+
+}  // namespace tiff_pvt
+
+OIIO_PLUGIN_NAMESPACE_END
@@ -23,6 +23,7 @@
 #include <OpenImageIO/typedesc.h>
 
 #include "imageio_pvt.h"
+#include "tiff_pvt.h"
 
 
 // General TIFF information:
@@ -99,6 +100,7 @@ public:
     ~TIFFInput() override;
     const char* format_name(void) const override { return "tiff"; }
     bool valid_file(Filesystem::IOProxy* ioproxy) const override;
+    TIFF* tiff_handle() const { return m_tif; }
     int supports(string_view feature) const override
     {
         return (feature == "exif" || feature == "iptc" || feature == "ioproxy"
@@ -163,6 +165,7 @@ private:
     bool m_convert_alpha;            ///< Do we need to associate alpha?
     bool m_separate;                 ///< Separate planarconfig?
     bool m_testopenconfig;           ///< Debug aid to test open-with-config
+    bool m_headeronly;               ///< Skip the ICC/Exif/IPTC/XMP blocks
     bool m_use_rgba_interface;       ///< Sometimes we punt
     bool m_is_byte_swapped;          ///< Is the file opposite our endian?
     int m_rowsperstrip;              ///< For scanline imgs, rows per strip
@@ -188,6 +191,7 @@ private:
         m_separate                = false;
         m_inputchannels           = 0;
         m_testopenconfig          = false;
+        m_headeronly              = false;
         m_colormap.clear();
         m_use_rgba_interface = false;
         m_subimage_specs.clear();
@@ -429,10 +433,11 @@ private:
                 TIFFSwabArrayOfShort((unsigned short*)uncompressed_buf, nvals);
             return;
         }
-        uLong uncompressed_size = (uLong)strip_bytes;
-        auto zok = uncompress((Bytef*)uncompressed_buf, &uncompressed_size,
-                              (const Bytef*)compressed_buf, csize);
-        if (zok != Z_OK || uncompressed_size != strip_bytes) {
+        if (!pvt::zlib_uncompress(
+                cspan<unsigned char>((const unsigned char*)compressed_buf,
+                                     csize),
+                span<unsigned char>((unsigned char*)uncompressed_buf,
+                                    strip_bytes))) {
             *ok = false;
             return;
         }
@@ -462,6 +467,40 @@ private:
         return xtile + ytile * nxtiles + ztile * nxtiles * nytiles;
     }
 
+    // Read the raw (still compressed) strips or tiles `striles`, the i-th
+    // into `buf + i * bufsize` and its size into `sizes[i]`, with a single
+    // IOProxy::pread_many() so that the reads are all outstanding at once
+    // rather than done one after another. Return false, for the caller to
+    // read them with libtiff instead, if that can't be done.
+    bool read_raw_striles(cspan<uint32_t> striles, char* buf, size_t bufsize,
+                          std::vector<tsize_t>& sizes)
+    {
+#if OIIO_TIFFLIB_VERSION >= 40100
+        std::vector<Filesystem::IOProxy::ReadRequest> reqs(striles.size());
+        for (size_t i = 0; i < striles.size(); ++i) {
+            int err         = 0;
+            uint64_t offset = TIFFGetStrileOffsetWithErr(m_tif, striles[i],
+                                                         &err);
+            uint64_t bytes  = TIFFGetStrileByteCountWithErr(m_tif, striles[i],
+                                                            &err);
+            if (err || !offset || !bytes)
+                return false;
+            // As TIFFReadRawStrip/Tile would, read no more than fits.
+            reqs[i].buf    = buf + i * bufsize;
+            reqs[i].size   = std::min(size_t(bytes), bufsize);
+            reqs[i].offset = int64_t(offset);
+        }
+        if (!ioproxy()->pread_many(reqs))
+            return false;
+        sizes.resize(striles.size());
+        for (size_t i = 0; i < striles.size(); ++i)
+            sizes[i] = tsize_t(reqs[i].nread);
+        return true;
+#else
+        return false;
+#endif
+    }
+
 #if OIIO_TIFFLIB_VERSION >= 40500
     std::string m_last_error;
     spin_mutex m_last_error_mutex;
@@ -504,6 +543,15 @@ private:
 
 
 
+TIFF*
+tiff_pvt::input_handle(ImageInput* in)
+{
+    auto tiffin = dynamic_cast<TIFFInput*>(in);
+    return tiffin ? tiffin->tiff_handle() : nullptr;
+}
+
+
+
 // Obligatory material to make this a recognizable imageio plugin:
 OIIO_PLUGIN_EXPORTS_BEGIN
 
@@ -722,6 +770,11 @@ TIFFInput::open(const std::string& name, ImageSpec& newspec)
 {
     m_filename = name;
     m_subimage = -1;
+    // libtiff can't open a URL itself, so it reads one through a proxy
+    // that fetches only the parts it needs.
+    if (!ioproxy_opened() && Filesystem::is_url(name)
+        && !ioproxy_use_or_open(name))
+        return false;
 
     bool ok = seek_subimage(0, 0);
     newspec = spec();
@@ -740,6 +793,8 @@ TIFFInput::open(const std::string& name, ImageSpec& newspec,
         m_keep_unassociated_alpha = true;
     if (config.get_int_attribute("oiio:RawColor", 0) == 1)
         m_raw_color = true;
+    if (config.get_int_attribute("oiio:headeronly", 0) == 1)
+        m_headeronly = true;
     // This configuration hint has no function other than as a debugging aid
     // for testing whether configurations are received properly from other
     // OIIO components.
@@ -1234,82 +1289,86 @@ TIFFInput::readspec(bool read_meta)
             m_spec.channelnames[c] = "z";
     }
 
-    /// read color profile
-    unsigned int icc_datasize = 0;
-    uint8_t* icc_buf          = NULL;
-    TIFFGetField(m_tif, TIFFTAG_ICCPROFILE, &icc_datasize, &icc_buf);
-    if (icc_datasize && icc_buf) {
-        m_spec.attribute(ICC_PROFILE_ATTR,
-                         TypeDesc(TypeDesc::UINT8, icc_datasize), icc_buf);
-        std::string errormsg;
-        bool ok = decode_icc_profile(cspan<uint8_t>(icc_buf, icc_datasize),
-                                     m_spec, errormsg);
-        if (!ok && OIIO::get_int_attribute("imageinput:strict")) {
-            errorfmt("Possible corrupt file, could not decode ICC profile: {}\n",
-                     errormsg);
-            return false;
+    // Asked for just the header, skip the blocks of extra metadata,
+    // whose decoding can cost more than everything else here.
+    if (!m_headeronly) {
+        /// read color profile
+        unsigned int icc_datasize = 0;
+        uint8_t* icc_buf          = NULL;
+        TIFFGetField(m_tif, TIFFTAG_ICCPROFILE, &icc_datasize, &icc_buf);
+        if (icc_datasize && icc_buf) {
+            m_spec.attribute(ICC_PROFILE_ATTR,
+                             TypeDesc(TypeDesc::UINT8, icc_datasize), icc_buf);
+            std::string errormsg;
+            bool ok = decode_icc_profile(cspan<uint8_t>(icc_buf, icc_datasize),
+                                         m_spec, errormsg);
+            if (!ok && OIIO::get_int_attribute("imageinput:strict")) {
+                errorfmt("Possible corrupt file, could not decode ICC profile: {}\n",
+                         errormsg);
+                return false;
+            }
         }
-    }
 
-    // Search for an EXIF IFD in the TIFF file, and if found, rummage
-    // around for Exif fields.
-    toff_t exifoffset = 0;
-    if (TIFFGetField(m_tif, TIFFTAG_EXIFIFD, &exifoffset)) {
-        if (TIFFReadEXIFDirectory(m_tif, exifoffset)) {
-            for (const auto& tag : tag_table("Exif"))
-                find_tag(tag.tifftag, tag.tifftype, tag.name);
-            // Look for a Makernote
-            auto makerfield = find_field(EXIF_MAKERNOTE, TIFF_UNDEFINED);
-            // std::unique_ptr<uint32_t[]> buf (new uint32_t[]);
-            if (makerfield) {
-                // bool ok = TIFFGetField (m_tif, tag, dest, &ptr);
-                unsigned int mn_datasize = 0;
-                unsigned char* mn_buf    = NULL;
-                TIFFGetField(m_tif, EXIF_MAKERNOTE, &mn_datasize, &mn_buf);
+        // Search for an EXIF IFD in the TIFF file, and if found, rummage
+        // around for Exif fields.
+        toff_t exifoffset = 0;
+        if (TIFFGetField(m_tif, TIFFTAG_EXIFIFD, &exifoffset)) {
+            if (TIFFReadEXIFDirectory(m_tif, exifoffset)) {
+                for (const auto& tag : tag_table("Exif"))
+                    find_tag(tag.tifftag, tag.tifftype, tag.name);
+                // Look for a Makernote
+                auto makerfield = find_field(EXIF_MAKERNOTE, TIFF_UNDEFINED);
+                // std::unique_ptr<uint32_t[]> buf (new uint32_t[]);
+                if (makerfield) {
+                    // bool ok = TIFFGetField (m_tif, tag, dest, &ptr);
+                    unsigned int mn_datasize = 0;
+                    unsigned char* mn_buf    = NULL;
+                    TIFFGetField(m_tif, EXIF_MAKERNOTE, &mn_datasize, &mn_buf);
+                }
+                // Exif spec says that anything other than 0xffff==uncalibrated
+                // should be interpreted to be sRGB.
+                if (m_spec.get_int_attribute("Exif:ColorSpace") != 0xffff)
+                    m_spec.attribute("oiio:ColorSpace", "sRGB");
+                // NOTE: We must set "oiio:ColorSpace" explicitly, not
+                // call set_colorspace, or it will erase several other TIFF
+                // attribs we need to preserve.
             }
-            // Exif spec says that anything other than 0xffff==uncalibrated
-            // should be interpreted to be sRGB.
-            if (m_spec.get_int_attribute("Exif:ColorSpace") != 0xffff)
-                m_spec.attribute("oiio:ColorSpace", "sRGB");
-            // NOTE: We must set "oiio:ColorSpace" explicitly, not call
-            // set_colorspace, or it will erase several other TIFF attribs we
-            // need to preserve.
+            // TIFFReadEXIFDirectory seems to do something to the internal state
+            // that requires a TIFFSetDirectory to set things straight again.
+            TIFFSetDirectory(m_tif, m_subimage);
         }
-        // TIFFReadEXIFDirectory seems to do something to the internal state
-        // that requires a TIFFSetDirectory to set things straight again.
-        TIFFSetDirectory(m_tif, m_subimage);
-    }
-
-    // Search for IPTC metadata in IIM form -- but older versions of
-    // libtiff botch the size, so ignore it for very old libtiff.
-    int iptcsize         = 0;
-    const char* iptcdata = nullptr;
-    TypeDesc iptctype    = tiffgetfieldtype(TIFFTAG_RICHTIFFIPTC);
-    if (TIFFGetField(m_tif, TIFFTAG_RICHTIFFIPTC, &iptcsize, &iptcdata)
-        && iptcsize > 0) {
-        std::vector<char> iptc;
-        if (iptctype.size() == 4) {
-            // Some TIFF files in the wild inexplicably think their IPTC
-            // data are stored as longs, and we have to undo any byte
-            // swapping that may have occurred.
-            iptcsize *= 4;
-            iptc.assign(iptcdata, iptcdata + iptcsize);
-            if (TIFFIsByteSwapped(m_tif))
-                TIFFSwabArrayOfLong((uint32_t*)&iptc[0], iptcsize / 4);
-        } else {
-            iptc.assign(iptcdata, iptcdata + iptcsize);
+
+        // Search for IPTC metadata in IIM form -- but older versions of
+        // libtiff botch the size, so ignore it for very old libtiff.
+        int iptcsize         = 0;
+        const char* iptcdata = nullptr;
+        TypeDesc iptctype    = tiffgetfieldtype(TIFFTAG_RICHTIFFIPTC);
+        if (TIFFGetField(m_tif, TIFFTAG_RICHTIFFIPTC, &iptcsize, &iptcdata)
+            && iptcsize > 0) {
+            std::vector<char> iptc;
+            if (iptctype.size() == 4) {
+                // Some TIFF files in the wild inexplicably think their IPTC
+                // data are stored as longs, and we have to undo any byte
+                // swapping that may have occurred.
+                iptcsize *= 4;
+                iptc.assign(iptcdata, iptcdata + iptcsize);
+                if (TIFFIsByteSwapped(m_tif))
+                    TIFFSwabArrayOfLong((uint32_t*)&iptc[0], iptcsize / 4);
+            } else {
+                iptc.assign(iptcdata, iptcdata + iptcsize);
+            }
+            decode_iptc_iim(&iptc[0], iptcsize, m_spec);
         }
-        decode_iptc_iim(&iptc[0], iptcsize, m_spec);
-    }
 
-    // Search for an XML packet containing XMP (IPTC, Exif, etc.)
-    int xmlsize         = 0;
-    const void* xmldata = NULL;
-    if (TIFFGetField(m_tif, TIFFTAG_XMLPACKET, &xmlsize, &xmldata)) {
-        // std::cerr << "Found XML data, size " << xmlsize << "\n";
-        if (xmldata && xmlsize) {
-            std::string xml((const char*)xmldata, xmlsize);
-            decode_xmp(xml, m_spec);
+        // Search for an XML packet containing XMP (IPTC, Exif, etc.)
+        int xmlsize         = 0;
+        const void* xmldata = NULL;
+        if (TIFFGetField(m_tif, TIFFTAG_XMLPACKET, &xmlsize, &xmldata)) {
+            // std::cerr << "Found XML data, size " << xmlsize << "\n";
+            if (xmldata && xmlsize) {
+                std::string xml((const char*)xmldata, xmlsize);
+                decode_xmp(xml, m_spec);
+            }
         }
     }
 
@@ -1350,6 +1409,11 @@ TIFFInput::readspec(bool read_meta)
         m_spec.attribute("oiio:AverageColor", ac);
         updatedDesc = true;
     }
+    auto ts = Strutil::excise_string_after_head(desc, "oiio:TileStats=");
+    if (ts.size()) {
+        m_spec.attribute("oiio:TileStats", ts);
+        updatedDesc = true;
+    }
     std::string sha = Strutil::excise_string_after_head(desc, "oiio:SHA-1=");
     if (sha.empty())  // back compatibility with OIIO < 1.5
         sha = Strutil::excise_string_after_head(desc, "SHA-1=");
@@ -1357,6 +1421,12 @@ TIFFInput::readspec(bool read_meta)
         m_spec.attribute("oiio:SHA-1", sha);
         updatedDesc = true;
     }
+    std::string contenthash
+        = Strutil::excise_string_after_head(desc, "oiio:ContentHash=");
+    if (contenthash.size()) {
+        m_spec.attribute("oiio:ContentHash", contenthash);
+        updatedDesc = true;
+    }
     std::string handed = Strutil::excise_string_after_head(desc,
                                                            "oiio:handed=");
     if (handed.size() && (handed == "left" || handed == "right")) {
@@ -1941,9 +2011,8 @@ TIFFInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
         nstrips > 1
         // only if we are reading scanlines in order
         && ybegin == (m_next_scanline + m_spec.y)
-        // only if we're threading and don't enter the thread pool recursively!
+        // only if we're threading
         && pool->size() > 1
-        && !pool->is_worker()
         // and not if the feature is turned off
         && m_spec.get_int_attribute("tiff:multithread",
                                     OIIO::get_int_attribute("tiff:multithread"));
@@ -1971,12 +2040,20 @@ TIFFInput::read_native_scanlines(int subimage, int miplevel, int ybegin,
         // one is read, kick off the decompress and any other extras, to execute
         // in parallel.
         compressed_scratch.reset(new char[cbound * nstrips * planes]);
+        std::vector<uint32_t> stripnums;
+        for (int sy = y; sy + m_rowsperstrip <= yend; sy += m_rowsperstrip)
+            stripnums.push_back(uint32_t((sy - m_spec.y) / m_rowsperstrip));
+        std::vector<tsize_t> csizes;
+        bool prefetched = read_raw_striles(stripnums, compressed_scratch.get(),
+                                           cbound, csizes);
         for (size_t stripidx = 0; y + m_rowsperstrip <= yend;
              y += m_rowsperstrip, ++stripidx) {
             char* cbuf        = compressed_scratch.get() + stripidx * cbound;
             tstrip_t stripnum = (y - m_spec.y) / m_rowsperstrip;
-            tsize_t csize     = TIFFReadRawStrip(m_tif, stripnum, cbuf,
-                                                 tmsize_t(cbound));
+            tsize_t csize     = prefetched
+                                    ? csizes[stripidx]
+                                    : TIFFReadRawStrip(m_tif, stripnum, cbuf,
+                                                       tmsize_t(cbound));
             if (csize < 0) {
                 std::string err = oiio_tiff_last_error();
                 errorfmt("TIFFRead{}Strip failed reading line y={},z={}: {}",
@@ -2221,9 +2298,8 @@ TIFFInput::read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
         && (m_spec.format == TypeUInt8 || m_spec.format == TypeUInt16)
         // No other unusual cases
         && !m_use_rgba_interface
-        // only if we're threading and don't enter the thread pool recursively!
+        // only if we're threading
         && pool->size() > 1
-        && !pool->is_worker()
         // only if this ImageInput wasn't asked to be single-threaded
         && this->threads() != 1
         // and not if the feature is turned off
@@ -2256,15 +2332,26 @@ TIFFInput::read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
 
     // Strutil::printf ("Parallel tile case %d %d  %d %d  %d %d\n",
     //                  xbegin, xend, ybegin, yend, zbegin, zend);
-    size_t tileidx = 0;
+    std::vector<uint32_t> tilenums;
+    for (int z = zbegin; z < zend; z += m_spec.tile_depth)
+        for (int y = ybegin; y < yend; y += m_spec.tile_height)
+            for (int x = xbegin; x < xend; x += m_spec.tile_width)
+                tilenums.push_back(uint32_t(tile_index(x, y, z)));
+    std::vector<tsize_t> csizes;
+    bool prefetched = read_raw_striles(tilenums, compressed_scratch.get(),
+                                       cbound, csizes);
+    size_t tileidx  = 0;
     for (int z = zbegin; z < zend; z += m_spec.tile_depth) {
         for (int y = ybegin; ok && y < yend; y += m_spec.tile_height) {
             for (int x = xbegin; ok && x < xend;
                  x += m_spec.tile_width, ++tileidx) {
-                char* cbuf = compressed_scratch.get() + tileidx * cbound;
-                char* ubuf = scratch.get() + tileidx * tile_bytes;
-                auto csize = TIFFReadRawTile(m_tif, tile_index(x, y, z), cbuf,
-                                             tmsize_t(cbound));
+                char* cbuf    = compressed_scratch.get() + tileidx * cbound;
+                char* ubuf    = scratch.get() + tileidx * tile_bytes;
+                tsize_t csize = prefetched
+                                    ? csizes[tileidx]
+                                    : TIFFReadRawTile(m_tif,
+                                                      tile_index(x, y, z),
+                                                      cbuf, tmsize_t(cbound));
                 if (csize < 0) {
                     std::string err = oiio_tiff_last_error();
                     errorfmt(
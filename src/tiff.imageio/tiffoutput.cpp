@@ -24,6 +24,7 @@
 #include <OpenImageIO/timer.h>
 
 #include "imageio_pvt.h"
+#include "tiff_pvt.h"
 
 
 // clang-format off
@@ -90,6 +91,7 @@ public:
                      stride_t xstride = AutoStride,
                      stride_t ystride = AutoStride,
                      stride_t zstride = AutoStride) override;
+    bool copy_image(ImageInput* in) override;
 
 private:
     TIFF* m_tif = nullptr;
@@ -187,6 +189,27 @@ private:
             }
     }
 
+    // Apply libtiff's floating point predictor in place to height rows of
+    // width x chans values of bps bytes each: the bytes of each row are
+    // regrouped by significance, the most significant bytes of all its
+    // values first, and then differenced, each from the byte chans before.
+    void floating_point_predictor(unsigned char* data, int chans, int width,
+                                  int height, int bps)
+    {
+        size_t wc       = size_t(width) * chans;
+        size_t rowbytes = wc * bps;
+        std::unique_ptr<unsigned char[]> tmp(new unsigned char[rowbytes]);
+        for (int y = 0; y < height; ++y, data += rowbytes) {
+            memcpy(tmp.get(), data, rowbytes);
+            for (size_t i = 0; i < wc; ++i)
+                for (int b = 0; b < bps; ++b)
+                    data[(bigendian() ? b : bps - 1 - b) * wc + i]
+                        = tmp[i * bps + b];
+            for (size_t i = rowbytes - 1; i >= size_t(chans); --i)
+                data[i] -= data[i - chans];
+        }
+    }
+
     void compress_one_strip(void* uncompressed_buf, size_t strip_bytes,
                             void* compressed_buf, unsigned long cbound,
                             int channels, int width, int height,
@@ -1190,6 +1213,110 @@ TIFFOutput::close()
 
 
 
+// The number of strips or tiles of the current directory.
+static uint32_t
+nstriles(TIFF* tif)
+{
+    return TIFFIsTiled(tif) ? TIFFNumberOfTiles(tif) : TIFFNumberOfStrips(tif);
+}
+
+
+
+// Are the pixels of the current directories of `in` and `out` laid out and
+// compressed identically, so that the raw bytes of each strip or tile of
+// one are those of the same strip or tile of the other?
+static bool
+same_raw_layout(TIFF* in, TIFF* out)
+{
+    if (TIFFIsTiled(in) != TIFFIsTiled(out)
+        || TIFFIsByteSwapped(in) != TIFFIsByteSwapped(out)
+        || nstriles(in) != nstriles(out))
+        return false;
+    // Unset tags read as their defaults (or 0), so compare equal.
+    static const uint32_t shorttags[]
+        = { TIFFTAG_COMPRESSION,  TIFFTAG_PREDICTOR,    TIFFTAG_BITSPERSAMPLE,
+            TIFFTAG_SAMPLESPERPIXEL, TIFFTAG_SAMPLEFORMAT, TIFFTAG_PLANARCONFIG,
+            TIFFTAG_PHOTOMETRIC,  TIFFTAG_FILLORDER };
+    for (uint32_t tag : shorttags) {
+        uint16_t a = 0, b = 0;
+        TIFFGetFieldDefaulted(in, tag, &a);
+        TIFFGetFieldDefaulted(out, tag, &b);
+        if (a != b)
+            return false;
+    }
+    static const uint32_t longtags[]
+        = { TIFFTAG_IMAGEWIDTH,   TIFFTAG_IMAGELENGTH, TIFFTAG_IMAGEDEPTH,
+            TIFFTAG_ROWSPERSTRIP, TIFFTAG_TILEWIDTH,   TIFFTAG_TILELENGTH };
+    for (uint32_t tag : longtags) {
+        uint32_t a = 0, b = 0;
+        TIFFGetFieldDefaulted(in, tag, &a);
+        TIFFGetFieldDefaulted(out, tag, &b);
+        if (a != b)
+            return false;
+    }
+    // The extra channels must mean the same (e.g., associated alpha).
+    uint16_t nin = 0, nout = 0;
+    uint16_t *extrain = nullptr, *extraout = nullptr;
+    TIFFGetFieldDefaulted(in, TIFFTAG_EXTRASAMPLES, &nin, &extrain);
+    TIFFGetFieldDefaulted(out, TIFFTAG_EXTRASAMPLES, &nout, &extraout);
+    if (nin != nout
+        || (nin && !std::equal(extrain, extrain + nin, extraout)))
+        return false;
+    // JPEG strips depend on tables kept in the directory, which we don't
+    // copy, so those can't be moved raw.
+    uint16_t compression = 0;
+    TIFFGetFieldDefaulted(in, TIFFTAG_COMPRESSION, &compression);
+    return compression != COMPRESSION_JPEG && compression != COMPRESSION_OJPEG;
+}
+
+
+
+bool
+TIFFOutput::copy_image(ImageInput* in)
+{
+    // If the input is a TIFF file whose pixels are stored exactly as ours
+    // will be, copy the compressed strips or tiles without decoding and
+    // re-encoding them (so, for example, changing only the metadata of a
+    // file is lossless and fast). Otherwise, do it the usual way.
+    TIFF* intif = tiff_pvt::input_handle(in);
+    if (!intif || !m_tif || !same_raw_layout(intif, m_tif))
+        return ImageOutput::copy_image(in);
+
+    bool tiled = TIFFIsTiled(intif);
+    uint32_t n = nstriles(intif);
+    std::vector<unsigned char> buf;
+    for (uint32_t i = 0; i < n; ++i) {
+        int err        = 0;
+        uint64_t bytes = TIFFGetStrileByteCountWithErr(intif, i, &err);
+        if (err) {
+            errorfmt("Could not find the size of strip or tile {} of {}", i,
+                     TIFFFileName(intif));
+            return false;
+        }
+        buf.resize(size_t(bytes));
+        tmsize_t got = tiled ? TIFFReadRawTile(intif, i, buf.data(),
+                                               tmsize_t(bytes))
+                             : TIFFReadRawStrip(intif, i, buf.data(),
+                                                tmsize_t(bytes));
+        if (got < 0) {
+            errorfmt("Could not read strip or tile {} of {}", i,
+                     TIFFFileName(intif));
+            return false;
+        }
+        tmsize_t wrote = tiled
+                             ? TIFFWriteRawTile(m_tif, i, buf.data(), got)
+                             : TIFFWriteRawStrip(m_tif, i, buf.data(), got);
+        if (wrote != got) {
+            errorfmt("Could not write strip or tile {}: {}", i,
+                     oiio_tiff_last_error());
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
 /// Helper: Convert n pixels from contiguous (RGBRGBRGB) to separate
 /// (RRRGGGBBB) planarconfig.
 void
@@ -1325,11 +1452,15 @@ TIFFOutput::compress_one_strip(void* uncompressed_buf, size_t strip_bytes,
                                int channels, int width, int height,
                                unsigned long* compressed_size, bool* ok)
 {
-    if (m_spec.format == TypeUInt8)
+    // Signed integers are differenced the same as unsigned ones.
+    if (m_predictor == PREDICTOR_FLOATINGPOINT)
+        floating_point_predictor((unsigned char*)uncompressed_buf, channels,
+                                 width, height, int(m_spec.format.size()));
+    else if (m_predictor == PREDICTOR_HORIZONTAL && m_spec.format.size() == 1)
         horizontal_predictor((unsigned char*)uncompressed_buf,
                              (unsigned char*)uncompressed_buf, channels, width,
                              height);
-    else if (m_spec.format == TypeUInt16)
+    else if (m_predictor == PREDICTOR_HORIZONTAL && m_spec.format.size() == 2)
         horizontal_predictor((unsigned short*)uncompressed_buf,
                              (unsigned short*)uncompressed_buf, channels, width,
                              height);
@@ -1371,14 +1502,14 @@ TIFFOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
         && (spec().format.size() * 8 == m_bitspersample)
         // contig planarconfig only
         && m_planarconfig == PLANARCONFIG_CONTIG
-        // only deflate/zip compression with horizontal predictor
+        // only deflate/zip compression, with a predictor we can apply
         && m_compression == COMPRESSION_ADOBE_DEFLATE
-        && m_predictor == PREDICTOR_HORIZONTAL
-        // only uint8, uint16
-        && (m_spec.format == TypeUInt8 || m_spec.format == TypeUInt16)
-        // only if we're threading and don't enter the thread pool recursively!
+        && (m_predictor == PREDICTOR_NONE
+            || m_predictor == PREDICTOR_FLOATINGPOINT
+            || (m_predictor == PREDICTOR_HORIZONTAL
+                && m_spec.format.size() <= 2))
+        // only if we're threading
         && pool->size() > 1
-        && !pool->is_worker()
         // only if this ImageInput wasn't asked to be single-threaded
         && this->threads() != 1
         // and not if the feature is turned off
@@ -1395,75 +1526,63 @@ TIFFOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
 
     // From here on, we're only dealing with the parallelizeable case...
 
-    // First, do the native data type conversion and contiguization. By
-    // doing the whole chunk, it will be parallelized.
-    std::vector<unsigned char> nativebuf;
-    data = to_native_rectangle(m_spec.x, m_spec.x + m_spec.width, ybegin, yend,
-                               z, z + 1, format, data, xstride, ystride,
-                               AutoStride, nativebuf, m_dither, m_spec.x,
-                               m_spec.y, m_spec.z);
-    format  = TypeUnknown;  // native
-    xstride = (stride_t)m_spec.pixel_bytes(true);
-    ystride = xstride * m_spec.width;
-
-    // Allocate various temporary space we need
-    const void* origdata      = data;
-    imagesize_t scratch_bytes = m_spec.scanline_bytes() * (yend - ybegin);
-    // Because the predictor is destructive, we need to copy to temp space
-    std::unique_ptr<char[]> scratch(new char[scratch_bytes]);
-    memcpy(scratch.get(), data, scratch_bytes);
-    data                    = scratch.get();
+    if (format == TypeDesc::UNKNOWN && xstride == AutoStride)
+        xstride = m_spec.pixel_bytes(true);
+    stride_t zstride = AutoStride;
+    m_spec.auto_stride(xstride, ystride, zstride, format, m_spec.nchannels,
+                       m_spec.width, yend - ybegin);
+
+    // Each full strip is converted to the native type, contiguized, and
+    // compressed by its own task, and the strips are written in order as
+    // they are done.
+    int nfull               = (yend - ybegin) / m_rowsperstrip;
     imagesize_t strip_bytes = m_spec.scanline_bytes(true) * m_rowsperstrip;
     size_t cbound           = compressBound((uLong)strip_bytes);
-    std::unique_ptr<char[]> compressed_scratch(new char[cbound * nstrips]);
-    unsigned long* compressed_len;
-    OIIO_ALLOCATE_STACK_OR_HEAP(compressed_len, unsigned long, nstrips);
-    int y               = ybegin;
-    int y_at_stripstart = y;
-
-    // Compress all the strips in parallel using the thread pool.
-    task_set tasks(pool);
-    bool ok = true;  // failed compression will stash a false here
-    for (size_t stripidx = 0; y + m_rowsperstrip <= yend;
-         y += m_rowsperstrip, ++stripidx) {
-        char* cbuf = compressed_scratch.get() + stripidx * cbound;
-        auto out   = this;
-        tasks.push(pool->push([=, &ok](int /*id*/) {
-            memcpy((void*)data, origdata, strip_bytes);
-            out->compress_one_strip((void*)data, strip_bytes, cbuf, cbound,
-                                    out->m_spec.nchannels, out->m_spec.width,
-                                    out->m_rowsperstrip,
-                                    compressed_len + stripidx, &ok);
-        }));
-        data     = (char*)data + strip_bytes;
-        origdata = (char*)origdata + strip_bytes;
-    }
-    // tasks.wait(); DON'T WAIT -- start writing as strips are done!
-
-    // Now write those compressed strips as they come out of the queue.
-    y = y_at_stripstart;
-    for (size_t stripidx = 0; ok && y + m_rowsperstrip <= yend;
-         y += m_rowsperstrip, ++stripidx) {
-        char* cbuf        = compressed_scratch.get() + stripidx * cbound;
-        tstrip_t stripnum = (y - m_spec.y) / m_rowsperstrip;
-        // Wait for THIS strip to be done before writing. But ok if
-        // others are still being compressed. And this is a non-blocking
-        // wait, it will steal tasks from the queue if the next strip
-        // it needs is not yet done.
-        tasks.wait_for_task(stripidx);
-        if (!ok) {
+    auto compress = [&](int s, std::vector<unsigned char>& buf) {
+        int y0         = ybegin + s * m_rowsperstrip;
+        const char* d0 = (const char*)data + stride_t(s) * m_rowsperstrip
+                                                 * ystride;
+        std::vector<unsigned char> native;
+        const void* nd = to_native_rectangle(m_spec.x, m_spec.x + m_spec.width,
+                                             y0, y0 + m_rowsperstrip, z, z + 1,
+                                             format, d0, xstride, ystride,
+                                             AutoStride, native, m_dither,
+                                             m_spec.x, y0, z);
+        // The predictor is destructive, so it needs a copy of the caller's
+        // pixels if they were already native.
+        if (nd != native.data())
+            native.assign((const unsigned char*)nd,
+                          (const unsigned char*)nd + strip_bytes);
+        buf.resize(cbound);
+        unsigned long len = 0;
+        bool zok          = true;
+        compress_one_strip(native.data(), strip_bytes, buf.data(), cbound,
+                           m_spec.nchannels, m_spec.width, m_rowsperstrip,
+                           &len, &zok);
+        if (!zok) {
             errorfmt("Compression error");
             return false;
         }
-        if (TIFFWriteRawStrip(m_tif, stripnum, (tdata_t)cbuf,
-                              tmsize_t(compressed_len[stripidx]))
+        buf.resize(len);
+        return true;
+    };
+    auto write = [&](int s, cspan<unsigned char> buf) {
+        int y0            = ybegin + s * m_rowsperstrip;
+        tstrip_t stripnum = (y0 - m_spec.y) / m_rowsperstrip;
+        if (TIFFWriteRawStrip(m_tif, stripnum, (tdata_t)buf.data(),
+                              tmsize_t(buf.size()))
             < 0) {
             std::string err = oiio_tiff_last_error();
-            errorfmt("TIFFWriteRawStrip failed writing line y={},z={}: {}", y,
-                     z, err.size() ? err.c_str() : "unknown error");
+            errorfmt("TIFFWriteRawStrip failed writing line y={},z={}: {}",
+                     y0, z, err.size() ? err.c_str() : "unknown error");
             return false;
         }
-    }
+        return true;
+    };
+    if (!compress_and_write_chunks(nfull, compress, write))
+        return false;
+    int y   = ybegin + nfull * m_rowsperstrip;
+    bool ok = true;
 
     // Should we checkpoint? Only if we have enough scanlines and enough
     // time has passed (or if using JPEG compression, for which it seems
@@ -1477,14 +1596,11 @@ TIFFOutput::write_scanlines(int ybegin, int yend, int z, TypeDesc format,
         m_checkpointItems = 0;
     }
 
-    if (y < yend && origdata != data)
-        memcpy((void*)data, origdata, (yend - y) * m_spec.scanline_bytes(true));
-
     // Write the stray scanlines at the end that can't make a full strip.
-    // Or all the scanlines if we weren't trying to write strips.
+    data = (const char*)data + stride_t(y - ybegin) * ystride;
     for (; ok && y < yend; ++y) {
         ok &= write_scanline(y, z, format, data, xstride);
-        data = (char*)data + ystride;
+        data = (const char*)data + ystride;
     }
 
     return ok;
@@ -1588,10 +1704,13 @@ TIFFOutput::write_tiles(int xbegin, int xend, int ybegin, int yend, int zbegin,
     // uncommon cases with strips. This covers most real-world cases.
     thread_pool* pool = default_thread_pool();
     OIIO_DASSERT(m_spec.tile_depth >= 1);
-    size_t ntiles = size_t(
-        (xend - xbegin + m_spec.tile_width - 1) / m_spec.tile_width
-        * (yend - ybegin + m_spec.tile_height - 1) / m_spec.tile_height
-        * (zend - zbegin + m_spec.tile_depth - 1) / m_spec.tile_depth);
+    const int nxtiles = (xend - xbegin + m_spec.tile_width - 1)
+                        / m_spec.tile_width;
+    const int nytiles = (yend - ybegin + m_spec.tile_height - 1)
+                        / m_spec.tile_height;
+    const int nztiles = (zend - zbegin + m_spec.tile_depth - 1)
+                        / m_spec.tile_depth;
+    size_t ntiles     = size_t(nxtiles) * size_t(nytiles) * size_t(nztiles);
     bool parallelize =
         // more than one tile, or no point parallelizing
         ntiles > 1
@@ -1602,14 +1721,14 @@ TIFFOutput::write_tiles(int xbegin, int xend, int ybegin, int yend, int zbegin,
         && (spec().format.size() * 8 == m_bitspersample)
         // contig planarconfig only
         && m_planarconfig == PLANARCONFIG_CONTIG
-        // only deflate/zip compression with horizontal predictor
+        // only deflate/zip compression, with a predictor we can apply
         && m_compression == COMPRESSION_ADOBE_DEFLATE
-        && m_predictor == PREDICTOR_HORIZONTAL
-        // only uint8, uint16
-        && (m_spec.format == TypeUInt8 || m_spec.format == TypeUInt16)
-        // only if we're threading and don't enter the thread pool recursively!
+        && (m_predictor == PREDICTOR_NONE
+            || m_predictor == PREDICTOR_FLOATINGPOINT
+            || (m_predictor == PREDICTOR_HORIZONTAL
+                && m_spec.format.size() <= 2))
+        // only if we're threading
         && pool->size() > 1
-        && !pool->is_worker()
         // and not if the feature is turned off
         && m_spec.get_int_attribute("tiff:multithread",
                                     OIIO::get_int_attribute("tiff:multithread"));
@@ -1625,105 +1744,88 @@ TIFFOutput::write_tiles(int xbegin, int xend, int ybegin, int yend, int zbegin,
 
     // From here on, we're only dealing with the parallelizeable case...
 
-    // Allocate various temporary space we need
-    stride_t tile_bytes = (stride_t)m_spec.tile_bytes(true);
-    std::vector<std::vector<unsigned char>> tilebuf(ntiles);
-    size_t cbound = compressBound((uLong)tile_bytes);
-    std::unique_ptr<char[]> compressed_scratch(new char[ntiles * cbound]);
-    unsigned long* compressed_len = OIIO_ALLOCA(unsigned long, ntiles);
-
     if (format == TypeDesc::UNKNOWN && xstride == AutoStride)
         xstride = m_spec.pixel_bytes(true);
     m_spec.auto_stride(xstride, ystride, zstride, format, m_spec.nchannels,
                        xend - xbegin, yend - ybegin);
 
-    // Compress all the tiles in parallel using the thread pool.
-    task_set tasks(pool);
-    bool ok = true;  // failed compression will stash a false here
-    for (int z = zbegin, tileno = 0; z < zend; z += m_spec.tile_depth) {
-        for (int y = ybegin; y < yend; y += m_spec.tile_height) {
-            for (int x = xbegin; ok && x < xend;
-                 x += m_spec.tile_width, ++tileno) {
-                tasks.push(pool->push([&, x, y, z, tileno](int /*id*/) {
-                    const unsigned char* tilestart
-                        = ((unsigned char*)data + (x - xbegin) * xstride
-                           + (z - zbegin) * zstride + (y - ybegin) * ystride);
-                    int xw = std::min(xend - x, m_spec.tile_width);
-                    int yh = std::min(yend - y, m_spec.tile_height);
-                    int zd = std::min(zend - z, m_spec.tile_depth);
-                    stride_t tile_xstride = xstride;
-                    stride_t tile_ystride = ystride;
-                    stride_t tile_zstride = zstride;
-                    // Partial tiles at the edge need to be padded to the
-                    // full tile size.
-                    std::unique_ptr<unsigned char[]> padded_tile;
-                    if (xw < m_spec.tile_width || yh < m_spec.tile_height
-                        || zd < m_spec.tile_depth) {
-                        stride_t pixelsize = format.size() * m_spec.nchannels;
-                        padded_tile.reset(
-                            new unsigned char[pixelsize * m_spec.tile_pixels()]);
-                        OIIO::copy_image(m_spec.nchannels, xw, yh, zd,
-                                         tilestart, pixelsize, xstride, ystride,
-                                         zstride, padded_tile.get(), pixelsize,
-                                         pixelsize * m_spec.tile_width,
-                                         pixelsize * m_spec.tile_pixels());
-                        tilestart    = padded_tile.get();
-                        tile_xstride = pixelsize;
-                        tile_ystride = tile_xstride * m_spec.tile_width;
-                        tile_zstride = tile_ystride * m_spec.tile_height;
-                    }
-                    const void* buf
-                        = to_native_tile(format, tilestart, tile_xstride,
-                                         tile_ystride, tile_zstride,
-                                         tilebuf[tileno], m_dither, x, y, z);
-                    if (buf == (const void*)tilestart) {
-                        // Ugly detail: if to_native_rectangle did not allocate
-                        // scratch space and copy to it, we need to do it now,
-                        // because the horizontal predictor is destructive.
-                        tilebuf[tileno].assign((char*)buf,
-                                               ((char*)buf)
-                                                   + m_spec.tile_bytes(true));
-                        buf = tilebuf[tileno].data();
-                    }
-                    char* cbuf = compressed_scratch.get() + tileno * cbound;
-                    compress_one_strip((void*)buf, tile_bytes, cbuf, cbound,
-                                       m_spec.nchannels, m_spec.tile_width,
-                                       m_spec.tile_height * m_spec.tile_depth,
-                                       compressed_len + tileno, &ok);
-                }));
-            }
+    // Each tile is converted, padded if it's partial, and compressed by its
+    // own task, and the tiles are written in order as they are done.
+    const stride_t tile_bytes = (stride_t)m_spec.tile_bytes(true);
+    const size_t cbound       = compressBound((uLong)tile_bytes);
+    auto tile_origin          = [&](int tileno, int& x, int& y, int& z) {
+        x = xbegin + (tileno % nxtiles) * m_spec.tile_width;
+        y = ybegin + (tileno / nxtiles % nytiles) * m_spec.tile_height;
+        z = zbegin + (tileno / (nxtiles * nytiles)) * m_spec.tile_depth;
+    };
+    auto compress = [&](int tileno, std::vector<unsigned char>& buf) {
+        int x, y, z;
+        tile_origin(tileno, x, y, z);
+        const unsigned char* tilestart
+            = ((unsigned char*)data + (x - xbegin) * xstride
+               + (z - zbegin) * zstride + (y - ybegin) * ystride);
+        int xw                = std::min(xend - x, m_spec.tile_width);
+        int yh                = std::min(yend - y, m_spec.tile_height);
+        int zd                = std::min(zend - z, m_spec.tile_depth);
+        stride_t tile_xstride = xstride;
+        stride_t tile_ystride = ystride;
+        stride_t tile_zstride = zstride;
+        // Partial tiles at the edge need to be padded to the full tile
+        // size.
+        std::unique_ptr<unsigned char[]> padded_tile;
+        if (xw < m_spec.tile_width || yh < m_spec.tile_height
+            || zd < m_spec.tile_depth) {
+            stride_t pixelsize = format.size() * m_spec.nchannels;
+            padded_tile.reset(
+                new unsigned char[pixelsize * m_spec.tile_pixels()]);
+            OIIO::copy_image(m_spec.nchannels, xw, yh, zd, tilestart,
+                             pixelsize, xstride, ystride, zstride,
+                             padded_tile.get(), pixelsize,
+                             pixelsize * m_spec.tile_width,
+                             pixelsize * m_spec.tile_pixels());
+            tilestart    = padded_tile.get();
+            tile_xstride = pixelsize;
+            tile_ystride = tile_xstride * m_spec.tile_width;
+            tile_zstride = tile_ystride * m_spec.tile_height;
         }
-    }
-    // tasks.wait(); DON'T WAIT -- start writing as tiles are done!
-
-    for (int z = zbegin, tileno = 0; z < zend; z += m_spec.tile_depth) {
-        for (int y = ybegin; y < yend; y += m_spec.tile_height) {
-            for (int x = xbegin; ok && x < xend;
-                 x += m_spec.tile_width, ++tileno) {
-                // Wait for THIS tile to be done before writing. But ok if
-                // others are still being compressed. And this is a non-
-                // blocking wait, it will steal tasks from the queue if the
-                // next tile it needs is not yet done.
-                tasks.wait_for_task(tileno);
-                char* cbuf = compressed_scratch.get() + tileno * cbound;
-                if (!ok) {
-                    errorfmt("Compression error");
-                    return false;
-                }
-                if (TIFFWriteRawTile(m_tif, uint32_t(tile_index(x, y, z)), cbuf,
-                                     compressed_len[tileno])
-                    < 0) {
-                    std::string err = oiio_tiff_last_error();
-                    errorfmt(
-                        "TIFFWriteRawTile failed writing tile {} (x={},y={},z={}): %s",
-                        tile_index(x, y, z), x, y, z,
-                        err.size() ? err.c_str() : "unknown error");
-                    return false;
-                }
-            }
+        std::vector<unsigned char> native;
+        const void* nd = to_native_tile(format, tilestart, tile_xstride,
+                                        tile_ystride, tile_zstride, native,
+                                        m_dither, x, y, z);
+        // The predictor is destructive, so it needs a copy of the caller's
+        // pixels if they were already native.
+        if (nd != native.data())
+            native.assign((const unsigned char*)nd,
+                          (const unsigned char*)nd + tile_bytes);
+        buf.resize(cbound);
+        unsigned long len = 0;
+        bool zok          = true;
+        compress_one_strip(native.data(), tile_bytes, buf.data(), cbound,
+                           m_spec.nchannels, m_spec.tile_width,
+                           m_spec.tile_height * m_spec.tile_depth, &len, &zok);
+        if (!zok) {
+            errorfmt("Compression error");
+            return false;
         }
-    }
-    return ok;
+        buf.resize(len);
+        return true;
+    };
+    auto write = [&](int tileno, cspan<unsigned char> buf) {
+        int x, y, z;
+        tile_origin(tileno, x, y, z);
+        if (TIFFWriteRawTile(m_tif, uint32_t(tile_index(x, y, z)),
+                             (void*)buf.data(), tmsize_t(buf.size()))
+            < 0) {
+            std::string err = oiio_tiff_last_error();
+            errorfmt(
+                "TIFFWriteRawTile failed writing tile {} (x={},y={},z={}): {}",
+                tile_index(x, y, z), x, y, z,
+                err.size() ? err.c_str() : "unknown error");
+            return false;
+        }
+        return true;
+    };
+    return compress_and_write_chunks(int(ntiles), compress, write);
 }
 
 
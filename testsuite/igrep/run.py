@@ -9,3 +9,12 @@ redirect = ' >> out.txt 2>&1 '
 
 command += run_app (oiio_app("igrep") + " -i -E wg ../oiio-images/tahoe-gps.jpg")
 
+
+# Search with an index, then again with a file added: the first file's
+# metadata comes from the index the second time.
+if not os.path.exists("meta") :
+    os.mkdir("meta")
+command += oiiotool("-pattern constant 4x4 3 --attrib ImageDescription \"a lake at dawn\" -o meta/a.tif")
+command += run_app (oiio_app("igrep") + " --index -r lake meta")
+command += oiiotool("-pattern constant 4x4 3 --attrib ImageDescription \"the lake shore\" -o meta/b.tif")
+command += run_app (oiio_app("igrep") + " --index -r lake meta")
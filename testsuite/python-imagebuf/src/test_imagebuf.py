@@ -184,6 +184,17 @@ try:
     print (" from 4D, shape is", b.spec().format, b.roi)
     print ("")
 
+    print ("Wrapping a numpy array without copying it:")
+    a = numpy.zeros((3, 2, 4), dtype="f")
+    b = oiio.ImageBuf(a, copy=False)
+    b.setpixel (1, 2, (0.5, 0.25, 0.125, 1.0))
+    print ("  array [2][1] =", a[2][1].tolist())
+    v = b.pixels_view()
+    v[0][0][1] = 0.75
+    print ("  pixel (0,0) =", b.getpixel(0,0))
+    print ("  asarray shares memory:", numpy.shares_memory(numpy.asarray(b), a))
+    print ("")
+
     # Test reading from disk
     print ("Testing read of ../common/textures/grid.tx:")
     b = oiio.ImageBuf ("../common/textures/grid.tx")